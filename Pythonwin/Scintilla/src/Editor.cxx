@@ -7593,6 +7593,14 @@ sptr_t Editor::WndProc(unsigned int iMessage, uptr_t wParam, sptr_t lParam) {
 	case SCI_GETCHARACTERPOINTER:
 		return reinterpret_cast<sptr_t>(pdoc->BufferPointer());
 
+	case SCI_GETRANGEPOINTER:
+		if (static_cast<int>(wParam) < 0 || lParam < 0 || static_cast<int>(wParam) + lParam > pdoc->Length())
+			return 0;
+		return reinterpret_cast<sptr_t>(pdoc->RangePointer(wParam, lParam));
+
+	case SCI_GETGAPPOSITION:
+		return pdoc->GapPosition();
+
 	default:
 		return DefWndProc(iMessage, wParam, lParam);
 	}
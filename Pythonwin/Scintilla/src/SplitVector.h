@@ -244,6 +244,26 @@ public:
 		body[lengthBody] = 0;
 		return body;
 	}
+
+	/// Return a pointer to a contiguous range of elements, only moving
+	/// the gap when the range spans it.
+	T* RangePointer(int position, int rangeLength) {
+		if (position < part1Length) {
+			if ((position + rangeLength) > part1Length) {
+				// Range overlaps gap, so move gap to start of range.
+				GapTo(position);
+				return body + position + gapLength;
+			} else {
+				return body + position;
+			}
+		} else {
+			return body + position + gapLength;
+		}
+	}
+
+	int GapPosition() const {
+		return part1Length;
+	}
 };
 
 #endif
@@ -131,13 +131,54 @@ PyObject *PyDDEServer_Shutdown(PyObject *self, PyObject *args)
     RETURN_NONE;
 }
 
+// @pymethod int|PyDDEServer|SetAdviseInterval|Coalesces advise notifications for a period.
+PyObject *PyDDEServer_SetAdviseInterval(PyObject *self, PyObject *args)
+{
+    UINT interval;
+    PythonDDEServer *pServer = PyDDEServer::GetServer(self);
+    if (!pServer)
+        return NULL;
+    // @pyparm int|milliseconds||How long changed items are collected before their advises are posted.
+    // 0 (the default) posts an advise as soon as an item changes.
+    if (!PyArg_ParseTuple(args, "I:SetAdviseInterval", &interval))
+        return NULL;
+    GUI_BGN_SAVE;
+    UINT old = pServer->GetAdviseInterval();
+    pServer->SetAdviseInterval(interval);
+    GUI_END_SAVE;
+    return PyLong_FromUnsignedLong(old);
+    // @rdesc The previous interval.
+    // @comm However often an item's data is set during the interval, clients are sent a single
+    // advise for it, and fetch only its latest value.  This lets a server publish thousands of
+    // updates a second without flooding slow clients.
+}
+
+// @pymethod int|PyDDEServer|FlushAdvises|Posts all queued advise notifications now.
+PyObject *PyDDEServer_FlushAdvises(PyObject *self, PyObject *args)
+{
+    PythonDDEServer *pServer = PyDDEServer::GetServer(self);
+    if (!pServer)
+        return NULL;
+    if (!PyArg_ParseTuple(args, ":FlushAdvises"))
+        return NULL;
+    GUI_BGN_SAVE;
+    int num = pServer->GetPendingAdviseCount();
+    pServer->FlushAdvises();
+    GUI_END_SAVE;
+    return PyInt_FromLong(num);
+    // @rdesc The number of items whose advises were posted.
+}
+
 // @object PyDDEServer|A DDE server.
 static struct PyMethodDef PyDDEServer_methods[] = {
     {"AddTopic", PyDDEServer_AddTopic, 1},          // @pymeth AddTopic|Adds a topic to the server.
     {"Create", PyDDEServer_Create, 1},              // @pymeth Create|Creates a DDE server
     {"Destroy", PyDDEServer_Destroy, 1},            // @pymeth Destroy|Destroys the underlying C++ object.
+    {"FlushAdvises", PyDDEServer_FlushAdvises, 1},  // @pymeth FlushAdvises|Posts all queued advise notifications now.
     {"GetLastError", PyDDEServer_GetLastError, 1},  // @pymeth GetLastError|Returns the last DDE error.
-    {"Shutdown", PyDDEServer_Shutdown, 1},          // @pymeth Shutdown|Shutsdown the server.
+    {"SetAdviseInterval", PyDDEServer_SetAdviseInterval,
+     1},  // @pymeth SetAdviseInterval|Coalesces advise notifications for a period.
+    {"Shutdown", PyDDEServer_Shutdown, 1},  // @pymeth Shutdown|Shutsdown the server.
     {NULL, NULL}                                    // sentinel
 };
 
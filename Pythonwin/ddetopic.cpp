@@ -42,10 +42,78 @@ PyObject *PyDDETopic_Destroy(PyObject *self, PyObject *args)
     RETURN_NONE;
 }
 
+// @pymethod |PyDDETopic|SetData|Sets the data of many string items, posting their advises as one batch.
+PyObject *PyDDETopic_SetData(PyObject *self, PyObject *args)
+{
+    PyObject *obValues;
+    PythonDDETopic *pTopic = PyDDETopic::GetTopic(self);
+    if (!pTopic)
+        return NULL;
+    // @pyparm dict|values||Dictionary of new values keyed by item name, or a sequence of (name, value) tuples.
+    if (!PyArg_ParseTuple(args, "O:SetData", &obValues))
+        return NULL;
+    if (pTopic->m_pServer == NULL)
+        RETURN_DDE_ERR("The topic has not been added to a server");
+    PyObject *items = PyDict_Check(obValues) ? PyDict_Items(obValues)
+                                             : PySequence_Fast(obValues, "values must be a dict or sequence");
+    if (items == NULL)
+        return NULL;
+    Py_ssize_t num = PySequence_Fast_GET_SIZE(items);
+    CDDEStringItem **pItems = new CDDEStringItem *[num ? num : 1];
+    TCHAR **vals = new TCHAR *[num ? num : 1];
+    Py_ssize_t got = 0;
+    BOOL ok = TRUE;
+    // Convert everything before changing anything, so an error leaves all the items alone.
+    for (; got < num && ok; got++) {
+        PyObject *obName, *obVal;
+        TCHAR *name = NULL;
+        vals[got] = NULL;
+        ok = PyArg_ParseTuple(PySequence_Fast_GET_ITEM(items, got), "OO:SetData", &obName, &obVal) &&
+             PyWinObject_AsTCHAR(obName, &name, FALSE) && PyWinObject_AsTCHAR(obVal, &vals[got], FALSE);
+        if (ok) {
+            // An exact match - FindItem also matches the wildcard (empty) item.
+            pItems[got] = NULL;
+            POSITION pos = pTopic->m_ItemList.GetHeadPosition();
+            while (pos) {
+                CDDEItem *pItem = pTopic->m_ItemList.GetNext(pos);
+                if (pItem->m_strName.CompareNoCase(name) == 0 && pItem->IsKindOf(RUNTIME_CLASS(CDDEStringItem))) {
+                    pItems[got] = (CDDEStringItem *)pItem;
+                    break;
+                }
+            }
+            if (pItems[got] == NULL) {
+                PyErr_SetObject(PyExc_KeyError, obName);
+                ok = FALSE;
+            }
+        }
+        PyWinObject_FreeTCHAR(name);
+    }
+    if (ok) {
+        GUI_BGN_SAVE;
+        CDDEServer *pServer = pTopic->m_pServer;
+        pServer->BeginAdviseBatch();
+        for (Py_ssize_t i = 0; i < num; i++) pItems[i]->SetData(vals[i]);
+        pServer->EndAdviseBatch();
+        GUI_END_SAVE;
+    }
+    for (Py_ssize_t i = 0; i < got; i++) PyWinObject_FreeTCHAR(vals[i]);
+    delete[] vals;
+    delete[] pItems;
+    Py_DECREF(items);
+    if (!ok)
+        return NULL;
+    RETURN_NONE;
+    // @comm Each changed item gets a single advise however many times it appears, and the
+    // advises are posted together once all the data has been set (or when the server's
+    // advise interval expires - see <om PyDDEServer.SetAdviseInterval>).
+}
+
 // @object PyDDETopic|A DDE topic.
 static struct PyMethodDef PyDDETopic_methods[] = {
     {"AddItem", PyDDETopic_AddItem, 1},  // @pymeth AddItem|Add an item to the topic.
     {"Destroy", PyDDETopic_Destroy, 1},  // @pymeth Destroy|Destroys an item
+    {"SetData", PyDDETopic_SetData,
+     1},  // @pymeth SetData|Sets the data of many string items, posting their advises as one batch.
     {NULL, NULL}                         // sentinel
 };
 
@@ -557,3 +557,69 @@ HANDLE WINAPI CopyHandle(HANDLE h)
 
     return hCopy;
 }
+
+//---------------------------------------------------------------------
+//
+// Function:   CreateTopDownDIBSection
+//
+// Purpose:    Creates an uncompressed DIB section whose first scan line
+//             is the top row of the image, so the pixel memory can be
+//             used as a (height, width, bytes per pixel) array.
+//
+// Parms:      hDC      == DC used for the DIB_RGB_COLORS conversion
+//             bitCount == 24 or 32
+//             ppBits   == receives the address of the pixel memory
+//
+// Returns:    The new bitmap, or NULL (see GetLastError).
+//
+//---------------------------------------------------------------------
+
+HBITMAP WINAPI CreateTopDownDIBSection(HDC hDC, int width, int height, WORD bitCount, void **ppBits)
+{
+    BITMAPINFO bmi;
+    memset(&bmi, 0, sizeof(bmi));
+    bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height;  // negative height == top-down
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = bitCount;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    *ppBits = NULL;
+    return ::CreateDIBSection(hDC, &bmi, DIB_RGB_COLORS, ppBits, NULL, 0);
+}
+
+//---------------------------------------------------------------------
+//
+// Function:   GetDIBSectionLayout
+//
+// Purpose:    Describes the pixel memory of a DIB section.
+//
+// Parms:      hbm        == The bitmap - FALSE is returned if it is not
+//                           an uncompressed DIB section.
+//             ppFirstRow == receives the address of the top row of the
+//                           image, which is the last scan line in memory
+//                           for bottom-up DIBs.
+//             pRowStride == receives the byte offset from one row to the
+//                           row below it; negative for bottom-up DIBs.
+//
+//---------------------------------------------------------------------
+
+BOOL WINAPI GetDIBSectionLayout(HBITMAP hbm, DIBSECTION *pds, BYTE **ppFirstRow, LONG *pRowStride)
+{
+    if (hbm == NULL || ::GetObject(hbm, sizeof(DIBSECTION), pds) != sizeof(DIBSECTION))
+        return FALSE;
+    if (pds->dsBm.bmBits == NULL || pds->dsBmih.biCompression != BI_RGB && pds->dsBmih.biCompression != BI_BITFIELDS)
+        return FALSE;
+    LONG stride = pds->dsBm.bmWidthBytes;
+    BYTE *bits = (BYTE *)pds->dsBm.bmBits;
+    if (pds->dsBmih.biHeight > 0) {
+        // bottom-up: memory starts with the bottom row.
+        *ppFirstRow = bits + (SIZE_T)stride * (pds->dsBm.bmHeight - 1);
+        *pRowStride = -stride;
+    }
+    else {
+        *ppFirstRow = bits;
+        *pRowStride = stride;
+    }
+    return TRUE;
+}
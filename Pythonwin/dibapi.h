@@ -40,5 +40,7 @@ DWORD WINAPI DIBHeight(LPSTR lpDIB);
 WORD WINAPI PaletteSize(LPSTR lpbi);
 WORD WINAPI DIBNumColors(LPSTR lpbi);
 HANDLE WINAPI CopyHandle(HANDLE h);
+HBITMAP WINAPI CreateTopDownDIBSection(HDC hDC, int width, int height, WORD bitCount, void **ppBits);
+BOOL WINAPI GetDIBSectionLayout(HBITMAP hbm, DIBSECTION *pds, BYTE **ppFirstRow, LONG *pRowStride);
 
 #endif  //!_INC_DIBAPI
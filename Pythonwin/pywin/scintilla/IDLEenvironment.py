@@ -8,7 +8,6 @@ import win32con
 import sys
 
 from pywin.mfc.dialog import GetSimpleInput
-from pywin import default_scintilla_encoding
 
 wordchars = string.ascii_uppercase + string.ascii_lowercase + string.digits
 
@@ -42,18 +41,17 @@ def GetIDLEModule(module):
 # without indents (and even small files with indents :-) it was pretty slow!
 def fast_readline(self):
 	if self.finished:
-		val = ""
-	else:
-		if "_scint_lines" not in self.__dict__:
-			# XXX - note - assumes this is only called once the file is loaded!
-			self._scint_lines = self.text.edit.GetTextRange().split("\n")
-		sl = self._scint_lines
-		i = self.i = self.i + 1
-		if i >= len(sl):
-			val = ""
-		else:
-			val = sl[i]+"\n"
-	return val.encode(default_scintilla_encoding)
+		return b""
+	edit = self.text.edit
+	i = self.i = self.i + 1
+	if i >= edit.GetLineCount():
+		return b""
+	# Only this line is copied out of Scintilla, rather than splitting a
+	# copy of the whole document.  Scintilla's text is already utf8.
+	val = bytes(edit.GetLineView(i))
+	if not val.endswith(b"\n"):
+		val = val + b"\n"
+	return val
 
 try:
 	GetIDLEModule("AutoIndent").IndentSearcher.readline = fast_readline
@@ -9,6 +9,7 @@ from pywin import default_scintilla_encoding
 import win32con
 import win32ui
 import win32api
+import win32gui
 import array
 import struct
 import string
@@ -362,6 +363,40 @@ class CScintillaEditInterface(ScintillaControlInterface):
 			ret = ret.decode(default_scintilla_encoding)
 		return ret
 
+	def GetTextRangeView(self, start = 0, end = -1):
+		"""Returns a memoryview of the raw (utf8) document bytes from start to end.
+		
+		Unlike GetTextRange() nothing is copied - the view refers to Scintilla's
+		own buffer, so it is only valid until the document is next changed.
+		"""
+		textlen = self.GetTextLength()
+		if end == -1: end = textlen
+		assert 0 <= start <= end <= textlen, "Invalid range requested (%d/%d)" % (start, end)
+		if end == start:
+			return memoryview(b'')
+		address = self.SendScintilla(scintillacon.SCI_GETRANGEPOINTER, start, end - start)
+		return win32gui.PyGetMemory(address, end - start)
+
+	def GetDocumentView(self):
+		"""Returns a memoryview of the whole document's raw (utf8) bytes.
+		
+		As for GetTextRangeView(), the view is only valid until the document is
+		next changed.  Byte-oriented tools, such as the re module, can search it
+		directly.
+		"""
+		textlen = self.GetTextLength()
+		if textlen == 0:
+			return memoryview(b'')
+		address = self.SendScintilla(scintillacon.SCI_GETCHARACTERPOINTER)
+		return win32gui.PyGetMemory(address, textlen)
+
+	def GetLineView(self, line):
+		"""Returns a memoryview of one line, including its line terminator"""
+		start = self.LineIndex(line)
+		end = self.LineIndex(line+1)
+		if end < 0: end = self.GetTextLength()
+		return self.GetTextRangeView(start, end)
+
 	def ReplaceSel(self, str):
 		buff = (str + "\0").encode(default_scintilla_encoding)
 		self.SendScintilla(scintillacon.SCI_REPLACESEL, 0, buff)
@@ -147,13 +147,15 @@ class CScintillaDocument(ParentScintillaDocument):
 			view.SendScintilla(scintillacon.SCI_SETEOLMODE, eol_mode)
 
 	def _SaveTextToFile(self, view, filename, encoding=None):
-		s = view.GetTextRange() # already decoded from scintilla's encoding
 		source_encoding = encoding
 		if source_encoding is None:
 			if self.bom:
 				source_encoding = self.source_encoding
 			else:
-				# no BOM - look for an encoding.
+				# no BOM - look for an encoding in the first lines.
+				headEnd = view.LineIndex(3)
+				if headEnd < 0: headEnd = view.GetTextLength()
+				s = view.GetTextRange(0, headEnd)
 				bits = re.split("[\r\n]+", s, 3)
 				for look in bits[:-1]:
 					match = re_encoding_text.search(look)
@@ -166,7 +168,11 @@ class CScintillaDocument(ParentScintillaDocument):
 				source_encoding = 'utf-8'
 
 		## encode data before opening file so script is not lost if encoding fails
-		file_contents = s.encode(source_encoding)
+		if codecs.lookup(source_encoding).name == codecs.lookup(default_scintilla_encoding).name:
+			# Scintilla already holds exactly these bytes - write them without a copy.
+			file_contents = view.GetDocumentView()
+		else:
+			file_contents = view.GetTextRange().encode(source_encoding) # decoded from scintilla's encoding
 		# Open in binary mode as scintilla itself ensures the
 		# line endings are already appropriate
 		f = open(filename, 'wb')
@@ -205,8 +205,11 @@ class FormatterBase:
 # For all formatters we actually implement here.
 # (as opposed to those formatters built in to Scintilla)
 class Formatter(FormatterBase):
+	# Roughly how many bytes are styled in each idle cycle while the rest of
+	# the document is colored in the background.
+	idleChunkSize = 16384
 	def __init__(self, scintilla):
-		self.bCompleteWhileIdle = 0
+		self.bCompleteWhileIdle = 1
 		self.bHaveIdleHandler = 0 # Dont currently have an idle handle
 		self.nextstylenum = 0
 		FormatterBase.__init__(self, scintilla)
@@ -226,10 +229,9 @@ class Formatter(FormatterBase):
 	def ColorSeg(self, start, end, styleName):
 		end = end+1
 #		assert end-start>=0, "Can't have negative styling"
-		stylenum = self.styles[styleName].stylenum
-		while start<end:
-			self.style_buffer[start]=stylenum
-			start = start+1
+		if end > start:
+			stylenum = self.styles[styleName].stylenum
+			self.style_buffer[start:end] = array.array("b", (stylenum,)) * (end-start)
 		#self.scintilla.SCISetStyling(end - start + 1, stylenum)
 
 	def RegisterStyle(self, style, stylenum = None):
@@ -246,8 +248,9 @@ class Formatter(FormatterBase):
 		# scintilla's formatting is all done in terms of utf, so
 		# we work with utf8 bytes instead of unicode.  This magically
 		# works as any extended chars found in the utf8 don't change
-		# the semantics.
-		stringVal = scintilla.GetTextRange(start, end, decode=False)
+		# the semantics.  The text is a view of scintilla's buffer rather
+		# than a copy; it is only used until styling is set below.
+		stringVal = scintilla.GetTextRangeView(start, end)
 		if start > 0:
 			stylenum = scintilla.SCIGetStyleAt(start - 1)
 			styleStart = self.GetStyleByNum(stylenum).name
@@ -255,8 +258,11 @@ class Formatter(FormatterBase):
 			styleStart = None
 #		trace("Coloring", start, end, end-start, len(stringVal), styleStart, self.scintilla.SCIGetCharAt(start))
 		scintilla.SCIStartStyling(start, 31)
-		self.style_buffer = array.array("b", (0,)*len(stringVal))
-		self.ColorizeString(stringVal, styleStart)
+		self.style_buffer = array.array("b", bytes(len(stringVal)))
+		try:
+			self.ColorizeString(stringVal, styleStart)
+		finally:
+			stringVal.release()
 		scintilla.SCISetStylingEx(self.style_buffer)
 		self.style_buffer = None
 #		trace("After styling, end styled is", self.scintilla.SCIGetEndStyled())
@@ -272,9 +278,12 @@ class Formatter(FormatterBase):
 			endStyled = scintilla.SCIGetEndStyled()
 			lineStartStyled = scintilla.LineFromChar(endStyled)
 			start = scintilla.LineIndex(lineStartStyled)
-			end = scintilla.LineIndex(lineStartStyled+1)
 			textlen = scintilla.GetTextLength()
-			if end < 0: end = textlen
+			# Style a bounded chunk of whole lines, so a huge document is
+			# colored over many idle cycles without freezing the UI.
+			lineEnd = scintilla.LineFromChar(min(start + self.idleChunkSize, textlen))
+			end = scintilla.LineIndex(lineEnd+1)
+			if end < 0 or end <= start: end = textlen
 
 			finished = end >= textlen
 			self.Colorize(start, end)
@@ -374,7 +383,7 @@ class PythonSourceFormatter(Formatter):
 			self.RegisterStyle( Style(name, format, bg), sc_id )
 
 	def ClassifyWord(self, cdoc, start, end, prevWord):
-		word = cdoc[start:end+1].decode('latin-1')
+		word = bytes(cdoc[start:end+1]).decode('latin-1')
 		attr = STYLE_IDENTIFIER
 		if prevWord == "class":
 			attr = STYLE_CLASS
@@ -398,14 +407,14 @@ class PythonSourceFormatter(Formatter):
 		prevWord = ""
 		state = styleStart
 		chPrev = chPrev2 = chPrev3 = ' '
-		chNext2 = chNext = cdoc[charStart:charStart+1].decode('latin-1')
+		chNext2 = chNext = chr(cdoc[charStart])
 		startSeg = i = charStart
 		while i < lengthDoc:
 			ch = chNext
 			chNext = ' '
-			if i+1 < lengthDoc: chNext = cdoc[i+1:i+2].decode('latin-1')
+			if i+1 < lengthDoc: chNext = chr(cdoc[i+1])
 			chNext2 = ' '
-			if i+2 < lengthDoc: chNext2 = cdoc[i+2:i+3].decode('latin-1')
+			if i+2 < lengthDoc: chNext2 = chr(cdoc[i+2])
 			if state == STYLE_DEFAULT:
 				if ch in wordstarts:
 					self.ColorSeg(startSeg, i - 1, STYLE_DEFAULT)
@@ -428,7 +437,7 @@ class PythonSourceFormatter(Formatter):
 						ch = ' '
 						chPrev = ' '
 						chNext = ' '
-						if i+1 < lengthDoc: chNext = cdoc[i+1]
+						if i+1 < lengthDoc: chNext = chr(cdoc[i+1])
 					else:
 						state = STYLE_STRING
 				elif ch == '\'':
@@ -441,7 +450,7 @@ class PythonSourceFormatter(Formatter):
 						ch = ' '
 						chPrev = ' '
 						chNext = ' '
-						if i+1 < lengthDoc: chNext = cdoc[i+1]
+						if i+1 < lengthDoc: chNext = chr(cdoc[i+1])
 					else:
 						state = STYLE_SQSTRING
 				elif ch in operators:
@@ -465,7 +474,7 @@ class PythonSourceFormatter(Formatter):
 							ch = ' '
 							chPrev = ' '
 							chNext = ' '
-							if i+1 < lengthDoc: chNext = cdoc[i+1]
+							if i+1 < lengthDoc: chNext = chr(cdoc[i+1])
 						else:
 							state = STYLE_STRING
 					elif ch == '\'':
@@ -475,7 +484,7 @@ class PythonSourceFormatter(Formatter):
 							ch = ' '
 							chPrev = ' '
 							chNext = ' '
-							if i+1 < lengthDoc: chNext = cdoc[i+1]
+							if i+1 < lengthDoc: chNext = chr(cdoc[i+1])
 						else:
 							state = STYLE_SQSTRING
 					elif ch in operators:
@@ -492,7 +501,7 @@ class PythonSourceFormatter(Formatter):
 						i = i + 1
 						ch = chNext
 						chNext = ' '
-						if i+1 < lengthDoc: chNext = cdoc[i+1]
+						if i+1 < lengthDoc: chNext = chr(cdoc[i+1])
 				elif ch == '\"':
 					self.ColorSeg(startSeg, i, STYLE_STRING)
 					state = STYLE_DEFAULT
@@ -503,7 +512,7 @@ class PythonSourceFormatter(Formatter):
 						i = i+1
 						ch = chNext
 						chNext = ' '
-						if i+1 < lengthDoc: chNext = cdoc[i+1]
+						if i+1 < lengthDoc: chNext = chr(cdoc[i+1])
 				elif ch == '\'':
 					self.ColorSeg(startSeg, i, STYLE_SQSTRING)
 					state = STYLE_DEFAULT
@@ -639,6 +639,8 @@ SCI_SETPOSITIONCACHE = 2514
 SCI_GETPOSITIONCACHE = 2515
 SCI_COPYALLOWLINE = 2519
 SCI_GETCHARACTERPOINTER = 2520
+SCI_GETRANGEPOINTER = 2643
+SCI_GETGAPPOSITION = 2644
 SCI_SETKEYSUNICODE = 2521
 SCI_GETKEYSUNICODE = 2522
 SCI_STARTRECORD = 3001
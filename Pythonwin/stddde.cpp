@@ -137,9 +137,17 @@ CHSZ::~CHSZ() { Destroy(); }
 
 IMPLEMENT_DYNCREATE(CDDEItem, CObject);
 
-CDDEItem::CDDEItem() { m_pTopic = NULL; }
+CDDEItem::CDDEItem()
+{
+    m_pTopic = NULL;
+    m_bAdvisePending = FALSE;
+}
 
-CDDEItem::~CDDEItem() {}
+CDDEItem::~CDDEItem()
+{
+    if (m_bAdvisePending && m_pTopic && m_pTopic->m_pServer)
+        m_pTopic->m_pServer->CancelAdvise(this);
+}
 
 void CDDEItem::Create(const TCHAR *pszName) { m_strName = pszName; }
 
@@ -744,12 +752,20 @@ CDDEServer::CDDEServer()
     m_strServiceName = AfxGetAppName();
     m_dwDDEInstance = 0;
     m_pSystemTopic = NULL;
+    m_nAdviseBatch = 0;
+    m_nAdviseInterval = 0;
+    m_idAdviseTimer = 0;
 }
 
 CDDEServer::~CDDEServer() { Shutdown(); }
 
 void CDDEServer::Shutdown()
 {
+    // Queued advises are dropped - there is no one left to tell.
+    while (!m_PendingAdvises.IsEmpty()) ((CDDEItem *)m_PendingAdvises.RemoveHead())->m_bAdvisePending = FALSE;
+    m_nAdviseBatch = 0;
+    SetAdviseInterval(0);
+
     if (m_bInitialized) {
         //
         // Terminate all conversations
@@ -1637,10 +1653,112 @@ void CDDEServer::PostAdvise(CDDETopic *pTopic, CDDEItem *pItem)
     ASSERT(pTopic);
     ASSERT(pItem);
 
-    ::DdePostAdvise(
-        m_dwDDEInstance,
-        ::DdeCreateStringHandle(m_dwDDEInstance, (TCHAR *)(const TCHAR *)pTopic->m_strName, DDE_STRING_CODEPAGE),
-        ::DdeCreateStringHandle(m_dwDDEInstance, (TCHAR *)(const TCHAR *)pItem->m_strName, DDE_STRING_CODEPAGE));
+    if (m_nAdviseBatch == 0 && m_nAdviseInterval == 0) {
+        PostAdviseNow(pTopic, pItem);
+        return;
+    }
+    //
+    // Coalesce - an item already in the queue will be fetched with
+    // its latest value when the queue is flushed.
+    //
+    if (!pItem->m_bAdvisePending) {
+        pItem->m_bAdvisePending = TRUE;
+        m_PendingAdvises.AddTail(pItem);
+    }
+    if (m_nAdviseBatch == 0)
+        ScheduleAdviseFlush();
+}
+
+void CDDEServer::PostAdviseNow(CDDETopic *pTopic, CDDEItem *pItem)
+{
+    HSZ hszTopic =
+        ::DdeCreateStringHandle(m_dwDDEInstance, (TCHAR *)(const TCHAR *)pTopic->m_strName, DDE_STRING_CODEPAGE);
+    HSZ hszItem =
+        ::DdeCreateStringHandle(m_dwDDEInstance, (TCHAR *)(const TCHAR *)pItem->m_strName, DDE_STRING_CODEPAGE);
+    ::DdePostAdvise(m_dwDDEInstance, hszTopic, hszItem);
+    ::DdeFreeStringHandle(m_dwDDEInstance, hszTopic);
+    ::DdeFreeStringHandle(m_dwDDEInstance, hszItem);
+}
+
+void CDDEServer::BeginAdviseBatch() { m_nAdviseBatch++; }
+
+void CDDEServer::EndAdviseBatch()
+{
+    ASSERT(m_nAdviseBatch > 0);
+    if (m_nAdviseBatch > 0 && --m_nAdviseBatch == 0) {
+        if (m_nAdviseInterval == 0)
+            FlushAdvises();
+        else
+            ScheduleAdviseFlush();
+    }
+}
+
+void CDDEServer::FlushAdvises()
+{
+    //
+    // Each item is removed before its advise is posted, so an item
+    // changed again by a client callback is queued afresh.
+    //
+    while (!m_PendingAdvises.IsEmpty()) {
+        CDDEItem *pItem = (CDDEItem *)m_PendingAdvises.RemoveHead();
+        pItem->m_bAdvisePending = FALSE;
+        if (pItem->m_pTopic && m_bInitialized)
+            PostAdviseNow(pItem->m_pTopic, pItem);
+    }
+}
+
+void CDDEServer::CancelAdvise(CDDEItem *pItem)
+{
+    POSITION pos = m_PendingAdvises.Find(pItem);
+    if (pos)
+        m_PendingAdvises.RemoveAt(pos);
+    pItem->m_bAdvisePending = FALSE;
+}
+
+//
+// Timers have no context, so map the timer ids back to their servers.
+//
+static CMapPtrToPtr s_AdviseTimers;
+
+void CDDEServer::SetAdviseInterval(UINT nMilliseconds)
+{
+    if (m_idAdviseTimer) {
+        ::KillTimer(NULL, m_idAdviseTimer);
+        s_AdviseTimers.RemoveKey((void *)m_idAdviseTimer);
+        m_idAdviseTimer = 0;
+    }
+    m_nAdviseInterval = nMilliseconds;
+    if (m_nAdviseBatch == 0) {
+        if (m_nAdviseInterval == 0)
+            FlushAdvises();
+        else
+            ScheduleAdviseFlush();
+    }
+}
+
+void CDDEServer::ScheduleAdviseFlush()
+{
+    if (m_idAdviseTimer || m_PendingAdvises.IsEmpty())
+        return;
+    m_idAdviseTimer = ::SetTimer(NULL, 0, m_nAdviseInterval, AdviseTimerProc);
+    if (m_idAdviseTimer)
+        s_AdviseTimers.SetAt((void *)m_idAdviseTimer, this);
+    else
+        FlushAdvises();  // no timer - don't hold on to the changes.
+}
+
+void CALLBACK CDDEServer::AdviseTimerProc(HWND hwnd, UINT uMsg, UINT_PTR idEvent, DWORD dwTime)
+{
+    // One shot - the timer is armed again when the next item changes.
+    ::KillTimer(NULL, idEvent);
+    void *pv;
+    if (!s_AdviseTimers.Lookup((void *)idEvent, pv))
+        return;
+    s_AdviseTimers.RemoveKey((void *)idEvent);
+    CDDEServer *pServer = (CDDEServer *)pv;
+    pServer->m_idAdviseTimer = 0;
+    if (pServer->m_nAdviseBatch == 0)
+        pServer->FlushAdvises();
 }
 
 CString GetFormatName(WORD wFmt)
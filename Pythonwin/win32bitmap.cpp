@@ -34,6 +34,8 @@ ui_bitmap::ui_bitmap()
 {
     pPal = NULL;
     sizeBitmap = CSize(0, 0);
+    memset(bufShape, 0, sizeof(bufShape));
+    memset(bufStrides, 0, sizeof(bufStrides));
 }
 ui_bitmap::~ui_bitmap() { ClearSupportData(); }
 void ui_bitmap::ClearSupportData()
@@ -138,6 +140,128 @@ static PyObject *ui_bitmap_create_compatible_bitmap(PyObject *self, PyObject *ar
     RETURN_NONE;
 }
 
+// @pymethod |PyCBitmap|CreateDIBSection|Creates a top-down DIB section whose pixels can be written directly.
+static PyObject *ui_bitmap_create_dib_section(PyObject *self, PyObject *args)
+{
+    int width, height, bitsPerPixel = 32;
+    PyObject *obDC;
+    if (!PyArg_ParseTuple(args, "Oii|i:CreateDIBSection",
+                          &obDC,           // @pyparm <o PyCDC>|dc||Specifies the device context.
+                          &width,          // @pyparm int|width||The width of the bitmap, in pixels.
+                          &height,         // @pyparm int|height||The height of the bitmap, in pixels.
+                          &bitsPerPixel))  // @pyparm int|bitsPerPixel|32|Either 24 or 32.
+        return NULL;
+    if (bitsPerPixel != 24 && bitsPerPixel != 32)
+        RETURN_VALUE_ERR("bitsPerPixel must be 24 or 32");
+    if (width <= 0 || height <= 0)
+        RETURN_VALUE_ERR("The width and height must be positive");
+    CDC *pDC = ui_dc_object::GetDC(obDC);
+    if (pDC == NULL)
+        return NULL;
+    CBitmap *pBitmap = ui_bitmap::GetBitmap(self);
+    if (!pBitmap)
+        return NULL;
+    if (pBitmap->GetSafeHandle() != NULL)
+        RETURN_ERR("The bitmap has already been created");
+
+    void *bits;
+    GUI_BGN_SAVE;
+    HBITMAP hbm = CreateTopDownDIBSection(pDC->m_hDC, width, height, (WORD)bitsPerPixel, &bits);
+    GUI_END_SAVE;
+    if (hbm == NULL)
+        RETURN_API_ERR("CreateDIBSection");
+    if (!pBitmap->Attach(hbm)) {
+        ::DeleteObject(hbm);
+        RETURN_ERR("Attach failed!");
+    }
+    ui_bitmap *pUIBitmap = (ui_bitmap *)self;
+    pUIBitmap->ClearSupportData();
+    pUIBitmap->sizeBitmap = CSize(width, height);
+    RETURN_NONE;
+    // @comm The bitmap object then supports the buffer protocol.  memoryview(bitmap) and
+    // numpy.asarray(bitmap) see a writable (height, width, bytesPerPixel) array of bytes in
+    // BGR(A) order whose row stride skips the padding at the end of each scan line, so a frame
+    // can be composed from Python or numpy and drawn with a single <om PyCDC.BitBlt>.  Selecting
+    // the bitmap into a memory DC and blitting the screen into it captures straight into the buffer.
+    // Consumers that do not ask for strides get the raw scan lines as a single run of bytes.
+    // <nl>The buffer is only valid until the bitmap is deleted.
+}
+
+// @pymethod dict|PyCBitmap|GetDIBSectionInfo|Describes the pixel memory of a DIB section.
+static PyObject *ui_bitmap_get_dib_section_info(PyObject *self, PyObject *args)
+{
+    CHECK_NO_ARGS2(args, GetDIBSectionInfo);
+    CBitmap *pBitmap = ui_bitmap::GetBitmap(self);
+    if (!pBitmap)
+        return NULL;
+    DIBSECTION ds;
+    BYTE *firstRow;
+    LONG rowStride;
+    if (!GetDIBSectionLayout((HBITMAP)pBitmap->GetSafeHandle(), &ds, &firstRow, &rowStride))
+        RETURN_ERR("The bitmap is not an uncompressed DIB section");
+    // @rdesc A dictionary with the following keys:<nl>
+    // width - width in pixels<nl>
+    // height - height in pixels<nl>
+    // bitsPerPixel - bits per pixel<nl>
+    // stride - bytes from one row of the image to the row below it; negative for bottom-up DIBs<nl>
+    // topDown - True if the first scan line in memory is the top row
+    return Py_BuildValue("{s:i,s:i,s:i,s:i,s:N}", "width", ds.dsBm.bmWidth, "height", ds.dsBm.bmHeight,
+                         "bitsPerPixel", (int)ds.dsBm.bmBitsPixel, "stride", (int)rowStride, "topDown",
+                         PyBool_FromLong(rowStride > 0));
+}
+
+// Buffer protocol - only DIB sections have memory we can hand out.
+static int ui_bitmap_getbuffer(PyObject *self, Py_buffer *view, int flags)
+{
+    CBitmap *pBitmap = ui_bitmap::GetBitmap(self);
+    if (!pBitmap)
+        return -1;
+    DIBSECTION ds;
+    BYTE *firstRow;
+    LONG rowStride;
+    if (!GetDIBSectionLayout((HBITMAP)pBitmap->GetSafeHandle(), &ds, &firstRow, &rowStride)) {
+        PyErr_SetString(PyExc_BufferError, "Only DIB section bitmaps support the buffer interface");
+        return -1;
+    }
+    // GDI may still be drawing into the section.
+    GdiFlush();
+    Py_ssize_t len = (Py_ssize_t)ds.dsBm.bmWidthBytes * ds.dsBm.bmHeight;
+    int bytesPerPixel = ds.dsBm.bmBitsPixel / 8;
+    int contiguous = flags & (PyBUF_C_CONTIGUOUS | PyBUF_F_CONTIGUOUS | PyBUF_ANY_CONTIGUOUS) & ~PyBUF_STRIDES;
+    if ((flags & PyBUF_STRIDES) != PyBUF_STRIDES || contiguous || bytesPerPixel < 3) {
+        // A single run of bytes, bottom-up DIBs in their memory order.
+        return PyBuffer_FillInfo(view, self, ds.dsBm.bmBits, len, 0, flags);
+    }
+
+    // The shape and strides arrays must outlive the view, so they live in the object;
+    // every export of the same bitmap describes the same layout.
+    ui_bitmap *pUIBitmap = (ui_bitmap *)self;
+    pUIBitmap->bufShape[0] = ds.dsBm.bmHeight;
+    pUIBitmap->bufShape[1] = ds.dsBm.bmWidth;
+    pUIBitmap->bufShape[2] = bytesPerPixel;
+    pUIBitmap->bufStrides[0] = rowStride;
+    pUIBitmap->bufStrides[1] = bytesPerPixel;
+    pUIBitmap->bufStrides[2] = 1;
+    view->obj = self;
+    Py_INCREF(self);
+    view->buf = firstRow;
+    view->len = (Py_ssize_t)ds.dsBm.bmWidth * ds.dsBm.bmHeight * bytesPerPixel;
+    view->readonly = 0;
+    view->itemsize = 1;
+    view->format = (flags & PyBUF_FORMAT) ? (char *)"B" : NULL;
+    view->ndim = 3;
+    view->shape = pUIBitmap->bufShape;
+    view->strides = pUIBitmap->bufStrides;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+static PyBufferProcs ui_bitmap_as_buffer = {
+    ui_bitmap_getbuffer,  // bf_getbuffer
+    NULL,                 // bf_releasebuffer
+};
+
 //////////////////////////////////////////////////////////////////////
 //
 // Load BMP format file
@@ -635,6 +759,10 @@ static PyObject *ui_bitmap_save_bitmap_file(PyObject *self, PyObject *args)
 static struct PyMethodDef ui_bitmap_methods[] = {
     {"CreateCompatibleBitmap", ui_bitmap_create_compatible_bitmap,
      1},  // @pymeth CreateCompatibleBitmap|Creates a bitmap compatible with the specified device context.
+    {"CreateDIBSection", ui_bitmap_create_dib_section,
+     1},  // @pymeth CreateDIBSection|Creates a top-down DIB section whose pixels can be written directly.
+    {"GetDIBSectionInfo", ui_bitmap_get_dib_section_info,
+     1},  // @pymeth GetDIBSectionInfo|Describes the pixel memory of a DIB section.
     {"GetSize", ui_bitmap_get_size, 1},        // @pymeth GetSize|Gets the size of the bitmap object, in pixels.
     {"GetHandle", ui_bitmap_get_handle, 1},    // @pymeth GetHandle|Returns the HBITMAP for a bitmap.
     {"LoadBitmap", ui_bitmap_load_bitmap, 1},  // @pymeth LoadBitmap|Loads a bitmap from a DLL object.
@@ -648,5 +776,12 @@ static struct PyMethodDef ui_bitmap_methods[] = {
     {NULL, NULL}                                        /* sentinel */
 };
 
-ui_type_CObject ui_bitmap::type("PyCBitmap", &PyCGdiObject::type, RUNTIME_CLASS(CBitmap), sizeof(ui_bitmap),
-                                PYOBJ_OFFSET(ui_bitmap), ui_bitmap_methods, GET_PY_CTOR(ui_bitmap));
+PyCBitmapType::PyCBitmapType(const char *name, ui_type *pBaseType, CRuntimeClass *pRT, int typeSize,
+                             int pyobjOffset, struct PyMethodDef *methodList, ui_base_class *(*thector)())
+    : ui_type_CObject(name, pBaseType, pRT, typeSize, pyobjOffset, methodList, thector)
+{
+    tp_as_buffer = &ui_bitmap_as_buffer;
+}
+
+PyCBitmapType ui_bitmap::type("PyCBitmap", &PyCGdiObject::type, RUNTIME_CLASS(CBitmap), sizeof(ui_bitmap),
+                              PYOBJ_OFFSET(ui_bitmap), ui_bitmap_methods, GET_PY_CTOR(ui_bitmap));
@@ -4,9 +4,16 @@
 /////////////////////////////////////////////////////////
 //
 //	ui_bitmap
+// The bitmap type also exposes the pixels of a DIB section via the buffer protocol.
+class PyCBitmapType : public ui_type_CObject {
+   public:
+    PyCBitmapType(const char *name, ui_type *pBaseType, CRuntimeClass *pRT, int typeSize, int pyobjOffset,
+                  struct PyMethodDef *methodList, ui_base_class *(*thector)());
+};
+
 class ui_bitmap : public PyCGdiObject {
    public:
-    static ui_type_CObject type;
+    static PyCBitmapType type;
     MAKE_PY_CTOR(ui_bitmap)
     static PyObject *create(PyObject *self, PyObject *args);
     static PyObject *create_from_handle(PyObject *self, PyObject *args);
@@ -15,6 +22,9 @@ class ui_bitmap : public PyCGdiObject {
 
     CPalette *pPal;
     CSize sizeBitmap;
+    // shape and strides of the (height, width, bytes per pixel) view of a DIB section.
+    Py_ssize_t bufShape[3];
+    Py_ssize_t bufStrides[3];
 
    protected:
     ui_bitmap();
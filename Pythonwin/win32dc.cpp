@@ -658,10 +658,26 @@ static PyObject *ui_dc_polygon(PyObject *self, PyObject *args)
     CDC *pDC = ui_dc_object::GetDC(self);
     if (!pDC)
         return NULL;
+    // @pyparm [(x, y), ...]|points||A list of points, or a buffer of 32 bit (x,y) pairs such as array.array('i')
     if (!PyArg_ParseTuple(args, "O:Polygon", &point_list)) {
         return NULL;
     }
-    else if (!PyList_Check(point_list)) {
+    Py_buffer view;
+    DWORD num_points;
+    int isbuf = PyWinObject_AsPOINTBuffer(point_list, &view, &num_points);
+    if (isbuf == -1)
+        return NULL;
+    if (isbuf == 1) {
+        // The buffer already has the layout of a POINT array - draw from it directly.
+        GUI_BGN_SAVE;
+        BOOL ret = pDC->Polygon((POINT *)view.buf, (int)num_points);
+        GUI_END_SAVE;
+        PyBuffer_Release(&view);
+        if (!ret)
+            RETURN_API_ERR("CDC::Polygon");
+        RETURN_NONE;
+    }
+    if (!PyList_Check(point_list)) {
         return NULL;
     }
     else {
@@ -716,10 +732,28 @@ static PyObject *ui_dc_poly_bezier(PyObject *self, PyObject *args)
     CDC *pDC = ui_dc_object::GetDC(self);
     if (!pDC)
         return NULL;
+    // @pyparm [((x, y), (x, y), (x, y)), ...]|points||A list of 3-tuples of points, or a buffer of 32 bit (x,y)
+    // pairs containing all the points.
+    // @pyparm int|doTo|0|If true, PolyBezierTo is called, which starts from the current position.
     if (!PyArg_ParseTuple(args, "O|i:PolyBezier[To]", &triple_list, &do_to)) {
         return NULL;
     }
-    else if (!PyList_Check(triple_list)) {
+    Py_buffer view;
+    DWORD num_points;
+    int isbuf = PyWinObject_AsPOINTBuffer(triple_list, &view, &num_points);
+    if (isbuf == -1)
+        return NULL;
+    if (isbuf == 1) {
+        GUI_BGN_SAVE;
+        BOOL ret = do_to ? pDC->PolyBezierTo((POINT *)view.buf, (int)num_points)
+                         : pDC->PolyBezier((POINT *)view.buf, (int)num_points);
+        GUI_END_SAVE;
+        PyBuffer_Release(&view);
+        if (!ret)
+            RETURN_API_ERR("CDC::PolyBezier[To]");
+        RETURN_NONE;
+    }
+    if (!PyList_Check(triple_list)) {
         return NULL;
     }
     else {
@@ -2031,11 +2065,25 @@ static PyObject *ui_dc_polyline(PyObject *self, PyObject *args)
     CDC *pDC = ui_dc_object::GetDC(self);
     if (!pDC)
         return NULL;
-    // @pyparm [(x, y), ...]|points||A sequence of points
+    // @pyparm [(x, y), ...]|points||A sequence of points, or a buffer of 32 bit (x,y) pairs such as array.array('i')
     if (!PyArg_ParseTuple(args, "O:Polyline", &point_list)) {
         return NULL;
     }
-    else if (!PySequence_Check(point_list)) {
+    Py_buffer view;
+    DWORD num_points;
+    int isbuf = PyWinObject_AsPOINTBuffer(point_list, &view, &num_points);
+    if (isbuf == -1)
+        return NULL;
+    if (isbuf == 1) {
+        GUI_BGN_SAVE;
+        BOOL ret = pDC->Polyline((POINT *)view.buf, (int)num_points);
+        GUI_END_SAVE;
+        PyBuffer_Release(&view);
+        if (!ret)
+            RETURN_API_ERR("CDC::Polyline");
+        RETURN_NONE;
+    }
+    if (!PySequence_Check(point_list)) {
         RETURN_TYPE_ERR("Argument must be a list of points");
     }
     else {
@@ -2082,6 +2130,74 @@ static PyObject *ui_dc_polyline(PyObject *self, PyObject *args)
     }
 }
 
+// @pymethod |PyCDC|PolyPolyline|Draws several series of connected line segments in a single call.
+static PyObject *ui_dc_poly_polyline(PyObject *self, PyObject *args)
+{
+    PyObject *obpoints, *obcounts;
+    CDC *pDC = ui_dc_object::GetDC(self);
+    if (!pDC)
+        return NULL;
+    if (!PyArg_ParseTuple(args, "OO:PolyPolyline",
+                          &obpoints,   // @pyparm [(x, y), ...]|points||The points of all the polylines, as a sequence
+                                       // of tuples or a buffer of 32 bit (x,y) pairs such as array.array('i')
+                          &obcounts))  // @pyparm [int, ...]|counts||The number of points in each polyline.
+        return NULL;
+    DWORD *counts = NULL;
+    DWORD num_counts, num_points, total = 0;
+    if (!PyWinObject_AsDWORDArray(obcounts, &counts, &num_counts, FALSE))
+        return NULL;
+    for (DWORD i = 0; i < num_counts; i++) total += counts[i];
+
+    Py_buffer view;
+    POINT *points = NULL;
+    PyObject *points_tuple = NULL;
+    int isbuf = PyWinObject_AsPOINTBuffer(obpoints, &view, &num_points);
+    if (isbuf == -1) {
+        free(counts);
+        return NULL;
+    }
+    if (isbuf == 1)
+        points = (POINT *)view.buf;
+    else {
+        points_tuple = PyWinSequence_Tuple(obpoints, &num_points);
+        if (points_tuple == NULL) {
+            free(counts);
+            return NULL;
+        }
+        points = new POINT[num_points ? num_points : 1];
+        for (DWORD i = 0; i < num_points; i++) {
+            if (!PyWinObject_AsPOINT(PyTuple_GET_ITEM(points_tuple, i), &points[i])) {
+                delete[] points;
+                Py_DECREF(points_tuple);
+                free(counts);
+                return NULL;
+            }
+        }
+    }
+    BOOL ok = FALSE;
+    if (total != num_points)
+        PyErr_Format(PyExc_ValueError, "The counts add up to %lu points, but %lu were supplied", total, num_points);
+    else {
+        GUI_BGN_SAVE;
+        ok = pDC->PolyPolyline(points, counts, (int)num_counts);  // @pyseemfc CDC|PolyPolyline
+        GUI_END_SAVE;
+        if (!ok)
+            ReturnAPIError("CDC::PolyPolyline");
+    }
+    if (isbuf == 1)
+        PyBuffer_Release(&view);
+    else {
+        delete[] points;
+        Py_DECREF(points_tuple);
+    }
+    free(counts);
+    if (!ok)
+        return NULL;
+    RETURN_NONE;
+    // @comm Drawing many short lines with one PolyPolyline call avoids the per-call overhead
+    // of <om PyCDC.Polyline>.
+}
+
 // @pymethod x, y|PyCDC|OffsetWindowOrg|Modifies the coordinates of the window origin relative to the coordinates of the
 // current window origin.
 // @rdesc The previous origin as a tuple (x,y)
@@ -2361,6 +2477,8 @@ static struct PyMethodDef ui_dc_methods[] = {
     {"PolyBezier", ui_dc_poly_bezier, 1},  // @pymeth PolyBezier|Draws one or more Bezier splines.
     {"Polygon", ui_dc_polygon, 1},         // @pymeth Polygon|Draws an Polygon.
     {"Polyline", ui_dc_polyline, 1},       // @pymeth Polyline|Draws a Polyline.
+    {"PolyPolyline", ui_dc_poly_polyline,
+     1},  // @pymeth PolyPolyline|Draws several series of connected line segments in a single call.
     {"RealizePalette", ui_dc_realize_palette,
      1},  // @pymeth RealizePalette|Maps palette entries in the current logical palette to the system palette.
     {"Rectangle", ui_dc_rectangle, 1},  // @pymeth Rectangle|Draws a rectangle using the current pen. The interior of
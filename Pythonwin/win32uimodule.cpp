@@ -1894,6 +1894,7 @@ extern PyObject *ui_create_frame(PyObject *self, PyObject *args);
 extern PyObject *ui_get_halftone_brush(PyObject *self, PyObject *args);
 extern PyObject *PyCTreeCtrl_create(PyObject *self, PyObject *args);
 extern PyObject *PyCListCtrl_create(PyObject *self, PyObject *args);
+extern PyObject *ui_get_message_hook_stats(PyObject *self, PyObject *args);
 
 /* List of functions exported by this module */
 
@@ -2005,6 +2006,8 @@ static struct PyMethodDef ui_functions[] = {
           // as the parameter available to <om PyCWnd.ShowWindow>
     {"GetMainFrame", ui_get_main_frame,
      1},                          // @pymeth GetMainFrame|Returns a window object for the main application frame.
+    {"GetMessageHookStats", ui_get_message_hook_stats,
+     1},  // @pymeth GetMessageHookStats|Returns how often message hooks have been called.
     {"GetName", ui_get_name, 1},  // @pymeth GetName|Returns the name of the current application.
     {"GetProfileFileName", ui_get_profile_filename,
      1},  // @pymeth GetProfileFileName|Returns the name of the INI file used by the application.
@@ -18,6 +18,82 @@
 
 extern BOOL bInFatalShutdown;
 
+// Most virtuals are not overridden, but looking for an override by name
+// (through the class, then usually a Python __getattr__ which raises an
+// exception) is slow, and done for OnDraw, OnIdle, PreTranslateMessage etc
+// many times a second.  So classes found to have no override for a name are
+// remembered, keyed on the type's version tag, which Python changes whenever
+// an attribute of the class or one of its bases is changed.  The names are
+// string literals, so are compared by address.  Only used with the Python lock held.
+#define VIRTUAL_CACHE_SIZE 512
+static struct {
+    PyTypeObject *type;  // no reference - the version tag is never reused.
+    unsigned int version;
+    const char *name;
+} g_noOverrideCache[VIRTUAL_CACHE_SIZE];
+
+static unsigned int VirtualCacheSlot(PyTypeObject *type, const char *name)
+{
+    return (unsigned int)((((ULONG_PTR)type >> 4) ^ ((ULONG_PTR)name >> 2)) % VIRTUAL_CACHE_SIZE);
+}
+
+// The interned Python names for the virtuals.
+#define VIRTUAL_NAMES_SIZE 256
+static struct {
+    const char *name;
+    PyObject *obName;
+} g_virtualNames[VIRTUAL_NAMES_SIZE];
+
+static PyObject *GetVirtualName(const char *name)
+{
+    unsigned int slot = (unsigned int)(((ULONG_PTR)name >> 2) % VIRTUAL_NAMES_SIZE);
+    if (g_virtualNames[slot].name == name)
+        return g_virtualNames[slot].obName;
+    PyObject *obName = PyUnicode_InternFromString(name);
+    if (obName == NULL)
+        return NULL;
+    Py_XDECREF(g_virtualNames[slot].obName);
+    g_virtualNames[slot].name = name;
+    g_virtualNames[slot].obName = obName;
+    return obName;
+}
+
+// Is the instance known to have no override?  An attribute of the
+// instance itself is always looked for.
+static BOOL HaveNoOverride(PyObject *inst, const char *name)
+{
+    PyTypeObject *type = Py_TYPE(inst);
+    unsigned int slot = VirtualCacheSlot(type, name);
+    if (g_noOverrideCache[slot].type != type || g_noOverrideCache[slot].name != name ||
+        g_noOverrideCache[slot].version != type->tp_version_tag ||
+        !PyType_HasFeature(type, Py_TPFLAGS_VALID_VERSION_TAG))
+        return FALSE;
+    PyObject *obName = GetVirtualName(name);
+    if (obName == NULL) {
+        PyErr_Clear();
+        return FALSE;
+    }
+    PyObject *dict = PyObject_GenericGetDict(inst, NULL);
+    if (dict == NULL) {
+        PyErr_Clear();
+        return TRUE;
+    }
+    BOOL ret = PyDict_Check(dict) && PyDict_GetItem(dict, obName) == NULL;
+    Py_DECREF(dict);
+    return ret;
+}
+
+static void RememberNoOverride(PyObject *inst, const char *name)
+{
+    PyTypeObject *type = Py_TYPE(inst);
+    if (!PyType_HasFeature(type, Py_TPFLAGS_VALID_VERSION_TAG))
+        return;
+    unsigned int slot = VirtualCacheSlot(type, name);
+    g_noOverrideCache[slot].type = type;
+    g_noOverrideCache[slot].version = type->tp_version_tag;
+    g_noOverrideCache[slot].name = name;
+}
+
 CVirtualHelper::CVirtualHelper(const char *iname, void *iassoc, EnumVirtualErrorHandling veh /* = VEH_PRINT_ERROR */)
 {
     handler = NULL;
@@ -37,10 +113,11 @@ CVirtualHelper::CVirtualHelper(const char *iname, void *iassoc, EnumVirtualError
         return;
     }
     // ok - have the python data type - now see if it has an override.
-    if (py_bob->virtualInst) {
+    if (py_bob->virtualInst && !HaveNoOverride(py_bob->virtualInst, iname)) {
         PyObject *t, *v, *tb;
         PyErr_Fetch(&t, &v, &tb);
-        handler = PyObject_GetAttrString(py_bob->virtualInst, (char *)iname);
+        PyObject *obName = GetVirtualName(iname);
+        handler = obName ? PyObject_GetAttr(py_bob->virtualInst, obName) : NULL;
         if (handler) {
             // explicitely check a method returned, else the classes
             // delegation may cause a circular call chain.
@@ -52,6 +129,8 @@ CVirtualHelper::CVirtualHelper(const char *iname, void *iassoc, EnumVirtualError
                 handler = NULL;
             }
         }
+        if (handler == NULL)
+            RememberNoOverride(py_bob->virtualInst, iname);
         PyErr_Restore(t, v, tb);
     }
     py_ob = py_bob;
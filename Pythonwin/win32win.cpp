@@ -61,8 +61,62 @@ class WndHack : public CWnd {
     BOOL OnQueryNewPalette() { return CWnd::OnQueryNewPalette(); }
 };
 
+// For each message ID (hooks are keyed on a WORD), the number of windows
+// with a hook for it, and the number of times a hook has been called.  The
+// hook count is changed with the Python lock held, but checked before taking
+// it, so messages no window hooks, such as floods of WM_MOUSEMOVE or WM_TIMER,
+// never wait for the lock.
+static struct {
+    LONG numHooks;
+    LONG numCalls;
+} g_messageHooks[0x10000];
+
+static void CountMessageHooks(CMapWordToPtr *pList, LONG delta)
+{
+    if (pList == NULL)
+        return;
+    POSITION pos = pList->GetStartPosition();
+    while (pos) {
+        WORD message;
+        void *method;
+        pList->GetNextAssoc(pos, message, method);
+        g_messageHooks[message].numHooks += delta;
+    }
+}
+
+// @pymethod dict|win32ui|GetMessageHookStats|Returns how often message hooks have been called.
+// @rdesc A dictionary keyed by message ID, for every message which is or was hooked by
+// <om PyCWnd.HookMessage>.  Each value is a tuple of the number of windows with a hook
+// for the message, and the number of times such a hook has been called.
+PyObject *ui_get_message_hook_stats(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":GetMessageHookStats"))
+        return NULL;
+    PyObject *ret = PyDict_New();
+    if (ret == NULL)
+        return NULL;
+    for (int i = 0; i < 0x10000; i++) {
+        if (g_messageHooks[i].numHooks == 0 && g_messageHooks[i].numCalls == 0)
+            continue;
+        PyObject *key = PyInt_FromLong(i);
+        PyObject *val = Py_BuildValue("ll", g_messageHooks[i].numHooks, g_messageHooks[i].numCalls);
+        if (key == NULL || val == NULL || PyDict_SetItem(ret, key, val) != 0) {
+            Py_XDECREF(key);
+            Py_XDECREF(val);
+            Py_DECREF(ret);
+            return NULL;
+        }
+        Py_DECREF(key);
+        Py_DECREF(val);
+    }
+    return ret;
+}
+
 BOOL Python_check_message(const MSG *msg)  // TRUE if fully processed.
 {
+    // No window hooks this message, so no need for the Python lock.
+    if (g_messageHooks[(WORD)msg->message].numHooks == 0)
+        return FALSE;
     BOOL ret;
     ui_assoc_object *pObj = NULL;
     PyObject *method;
@@ -76,6 +130,7 @@ BOOL Python_check_message(const MSG *msg)  // TRUE if fully processed.
         TRACE("Message callback: message %04X, object %s (hwnd %p) (%p)\n", msg->message,
               (const char *)GetReprText(pObj), pWnd, pWnd->GetSafeHwnd());
 #endif
+        g_messageHooks[(WORD)msg->message].numCalls++;
         // Our Python convention is TRUE means "pass it on"
         // CEnterLeavePython _celp;
         ret = Python_callback(method, msg) == 0;
@@ -584,6 +639,7 @@ PyCWnd::PyCWnd()
 }
 PyCWnd::~PyCWnd()
 {
+    CountMessageHooks(pMessageHookList, -1);
     free_hook_list(this, &pMessageHookList);
     free_hook_list(this, &pKeyHookList);
     Py_XDECREF(obKeyStrokeHandler);
@@ -1536,8 +1592,14 @@ static PyObject *ui_window_hook_message(PyObject *self, PyObject *args)
     // @pyparm object|obHandler||The handler for the message notification.  This must be a callable object.
     // @pyparm int|message||The ID of the message to be handled.
     // @rdesc The return value is the previous handler, or None.
+    // @comm Messages are only checked for hooks when some window has hooked them, and
+    // <om win32ui.GetMessageHookStats> reports how often the hooks are called.
     PyCWnd *s = (PyCWnd *)self;
-    return add_hook_list(s, args, &s->pMessageHookList);
+    // Keep the count of hooks for each message up to date.
+    CountMessageHooks(s->pMessageHookList, -1);
+    PyObject *ret = add_hook_list(s, args, &s->pMessageHookList);
+    CountMessageHooks(s->pMessageHookList, 1);
+    return ret;
 }
 // @pymethod int|PyCWnd|IsChild|Determines if a given window is a child of this window.
 PyObject *ui_window_is_child(PyObject *self, PyObject *args)
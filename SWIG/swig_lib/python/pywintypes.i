@@ -108,9 +108,13 @@ typedef unsigned long ULONG;
 	}
 }
 
-%typemap(python,in) TCHAR * {
-	if (!PyWinObject_AsTCHAR($source, &$target, FALSE))
+// The string typemaps convert into a TmpStackTCHAR/TmpStackWCHAR, so typical
+// paths and names don't need a heap allocation, and are freed automatically
+// however the wrapper returns - so there are no freearg typemaps.
+%typemap(python,in) TCHAR * (TmpStackTCHAR temp) {
+	if (!temp.init($source, FALSE))
 		return NULL;
+	$target = temp;
 }
 
 %typemap(python,arginit) TCHAR *,OLECHAR *, WCHAR *
@@ -118,47 +122,31 @@ typedef unsigned long ULONG;
 	$target = NULL;
 }
 
-%typemap(python,in) TCHAR *inNullString{
-	if (!PyWinObject_AsTCHAR($source, &$target, TRUE))
+%typemap(python,in) TCHAR *inNullString (TmpStackTCHAR temp) {
+	if (!temp.init($source, TRUE))
 		return NULL;
+	$target = temp;
 }
 %typemap(python,in) TCHAR *INPUT_NULLOK = TCHAR *inNullString;
 
-%typemap(python,freearg) TCHAR *{
-	PyWinObject_FreeTCHAR($source);
-}
-
-// Delete this!
-%typemap(python,freearg) TCHAR *inNullWideString {
-	PyWinObject_FreeTCHAR($source);
-}
-
-%typemap(python,freearg) TCHAR *inNullString {
-	PyWinObject_FreeTCHAR($source);
-}
-
-
-%typemap(python,in) OLECHAR *, WCHAR *{
+%typemap(python,in) WCHAR * (TmpStackWCHAR temp) {
 	// Wide string code!
-	if (!PyWinObject_AsWCHAR($source, &$target, FALSE))
+	if (!temp.init($source, FALSE))
 		return NULL;
+	$target = temp;
 }
+%typemap(python,in) OLECHAR * = WCHAR *;
 
-%typemap(python,in) OLECHAR *inNullWideString,
-                    WCHAR *inNullWideString {
+%typemap(python,in) OLECHAR *inNullWideString (TmpStackWCHAR temp) {
 	// Wide string code!
-	if (!PyWinObject_AsWCHAR($source, &$target, TRUE))
+	if (!temp.init($source, TRUE))
 		return NULL;
+	$target = temp;
 }
 
 %typemap(python,in) WCHAR *inNullWideString = OLECHAR *inNullWideString;
 %typemap(python,in) WCHAR *INPUT_NULLOK = WCHAR *inNullWideString;
 
-%typemap(python,freearg) OLECHAR *, WCHAR *{
-	// Wide string cleanup
-	PyWinObject_FreeWCHAR($source);
-}
-
 %typemap(python,ignore) BSTR *OUTPUT (BSTR temp) {
 	$target = &temp;
 }
@@ -54,6 +54,9 @@ adStateConnecting = 2
 adStateExecuting  = 4
 adStateFetching   = 8
 
+# GetRowsOptionEnum
+adGetRowsRest = -1
+
 # FieldAttributeEnum
 adFldMayBeNull = 0x40
 
@@ -897,6 +897,11 @@ class Cursor(object):
 
         if self.rs.State == adc.adStateClosed or self.rs.BOF or self.rs.EOF:
             return list()
+        if self.recordset_format == api.RS_WIN_32:
+            # pythoncom converts the GetRows array straight to a list of row tuples,
+            # which is indexed [row][column] just like the remote format.
+            ado_results = pythoncom.GetRecordsetRows(self.rs, limit or adc.adGetRowsRest)
+            return api.SQLrows(ado_results, len(ado_results), self, api.RS_REMOTE)
         if limit: # limit number of rows retrieved
             ado_results = self.rs.GetRows(limit)
         else:    # get all rows
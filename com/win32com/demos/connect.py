@@ -19,7 +19,7 @@ IID_IConnectDemoEvents = pythoncom.MakeIID("{A4988850-49C3-11d0-AE5D-52342E00000
 # 'DoIt', which echos to a single sink 'DoneIt'
 
 class ConnectableServer(win32com.server.connect.ConnectableServer):
-	_public_methods_ = ["DoIt"] + win32com.server.connect.ConnectableServer._public_methods_
+	_public_methods_ = ["DoIt", "DoItFast"] + win32com.server.connect.ConnectableServer._public_methods_
 	_connect_interfaces_ = [IID_IConnectDemoEvents]
 	# The single public method that the client can call on us
 	# (ie, as a normal COM server, this exposes just this single method.
@@ -30,6 +30,10 @@ class ConnectableServer(win32com.server.connect.ConnectableServer):
 	def NotifyDoneIt(self, interface, arg):
 		interface.Invoke(1000, 0, pythoncom.DISPATCH_METHOD, 1, arg)
 
+	# The same, but fired natively to all sinks.
+	def DoItFast(self,arg):
+		self._FireEvent(1000, (arg,))
+
 # Here is the client side of the connection world.
 # Define a COM object which implements the methods defined by the
 # IConnectDemoEvents interface.								
@@ -52,9 +56,12 @@ class ConnectableClient:
 	def OnDoneIt(self, arg):
 		self.last_event_arg = arg
 
-def CheckEvent(server, client, val, verbose):
+def CheckEvent(server, client, val, verbose, fast=False):
 	client.last_event_arg = None
-	server.DoIt(val)
+	if fast:
+		server.DoItFast(val)
+	else:
+		server.DoIt(val)
 	if client.last_event_arg != val:
 		raise RuntimeError("Sent %r, but got back %r" % (val, client.last_event_arg))
 	if verbose:
@@ -75,6 +82,7 @@ def test(verbose=0):
 	CheckEvent(server, client, "Here is a null>\x00<", verbose)
 	val = "test-\xe0\xf2" # 2 extended characters.
 	CheckEvent(server, client, val, verbose)
+	CheckEvent(server, client, val, verbose, fast=True)
 	if verbose:
 		print("Everything seemed to work!")
 	# Aggressive memory leak checking (ie, do nothing!) :-)  All should cleanup OK???
@@ -19,6 +19,8 @@ class ConnectableServer:
 	def __init__(self):
 		self.cookieNo = 0
 		self.connections = {}
+		# The same sinks, held natively for _FireEvent.
+		self.sinks = pythoncom.CreateConnectionSinks()
 	# IConnectionPoint interfaces
 	def EnumConnections(self):
 		raise Exception(winerror.E_NOTIMPL)
@@ -35,6 +37,7 @@ class ConnectableServer:
 			raise Exception(scode=olectl.CONNECT_E_NOCONNECTION)
 		self.cookieNo = self.cookieNo + 1
 		self.connections[self.cookieNo] = interface
+		self.sinks.Add(interface, self.cookieNo)
 		return self.cookieNo
 	def Unadvise(self, cookie):
 		# Destroy a connection - simply delete interface from the map.
@@ -42,6 +45,7 @@ class ConnectableServer:
 			del self.connections[cookie]
 		except KeyError:
 			raise Exception(scode=winerror.E_UNEXPECTED)
+		self.sinks.Remove(cookie)
 	# IConnectionPointContainer interfaces
 	def EnumConnectionPoints(self):
 		raise Exception(winerror.E_NOTIMPL)
@@ -59,6 +63,15 @@ class ConnectableServer:
 			except pythoncom.com_error as details:
 				self._OnNotifyFail(interface, details)
 
+	def _FireEvent(self, dispid, args=(), async_=False):
+		# Fires an event to all connections, converting the args only once,
+		# and without a Python call per connection.  With async_, each
+		# connection gets the event on its own thread, so a slow client
+		# can't hold up the others - see self.sinks.GetStats() for failures.
+		for cookie, hr in self.sinks.Fire(dispid, args, async_):
+			details = pythoncom.com_error(hr, None, None, None)
+			self._OnNotifyFail(self.connections.get(cookie), details)
+
 	def _OnNotifyFail(self, interface, details):
 		print("Ignoring COM error to connection - %s" % (repr(details)))
 		
@@ -94,18 +94,27 @@ regSpec = 'CLSID\\%s\\PythonCOM'
 regPolicy = 'CLSID\\%s\\PythonCOMPolicy'
 regDispatcher = 'CLSID\\%s\\PythonCOMDispatcher'
 regAddnPath = 'CLSID\\%s\\PythonCOMPath'
+regPoolSize = 'CLSID\\%s\\PythonCOMPoolSize'
 
-def CreateInstance(clsid, reqIID):
-  """Create a new instance of the specified IID
+# What has been read from the registry for each CLSID - COM objects are
+# often created many times, but the registration only needs reading once.
+_class_info = {} # clsid -> (policy, dispatcher)
+_class_specs = {} # clsid -> callable creating the wrapped object.
 
-  The COM framework **always** calls this function to create a new 
-  instance for the specified CLSID.  This function looks up the
-  registry for the name of a policy, creates the policy, and asks the
-  policy to create the specified object by calling the _CreateInstance_ method.
-  
-  Exactly how the policy creates the instance is up to the policy.  See the
-  specific policy documentation for more details.
+def ClearClassCache():
+  """Forgets the registration details cached for every CLSID.
+
+  Only needed when a COM object is re-registered in a process which has
+  already created it.
   """
+  _class_info.clear()
+  _class_specs.clear()
+
+def _GetClassInfo(clsid):
+  try:
+    return _class_info[clsid]
+  except KeyError:
+    pass
   # First see is sys.path should have something on it.
   try:
     addnPaths = win32api.RegQueryValue(win32con.HKEY_CLASSES_ROOT,
@@ -128,12 +137,66 @@ def CreateInstance(clsid, reqIID):
     if dispatcher: dispatcher = resolve_func(dispatcher)
   except win32api.error:
     dispatcher = None
+  info = _class_info[clsid] = policy, dispatcher
+  return info
 
+def _CreatePolicy(clsid):
+  policy, dispatcher = _GetClassInfo(clsid)
   if dispatcher:
-    retObj = dispatcher(policy, None)
-  else:
-    retObj = policy(None)
-  return retObj._CreateInstance_(clsid, reqIID)
+    return dispatcher(policy, None)
+  return policy(None)
+
+def CreateInstance(clsid, reqIID):
+  """Create a new instance of the specified IID
+
+  The COM framework **always** calls this function to create a new 
+  instance for the specified CLSID.  This function looks up the
+  registry for the name of a policy, creates the policy, and asks the
+  policy to create the specified object by calling the _CreateInstance_ method.
+  
+  Exactly how the policy creates the instance is up to the policy.  See the
+  specific policy documentation for more details.
+
+  The registry is only read the first time a CLSID is created - see
+  @ClearClassCache@.
+  """
+  return _CreatePolicy(clsid)._CreateInstance_(clsid, reqIID)
+
+def GetPoolSize(clsid):
+  """Returns how many instances of the CLSID the COM framework may pool.
+
+  This is the "@win32com.server.policy.regPoolSize@" % clsid entry, written
+  from the _reg_pool_size_ attribute when the class is registered.  The
+  instances of a pooled class are reused once COM has released every
+  reference to them, after their _Reset_ method (which they must provide)
+  has been called.  The COM framework only calls this once for each CLSID
+  in a process.
+  """
+  try:
+    return int(win32api.RegQueryValue(win32con.HKEY_CLASSES_ROOT,
+                                      regPoolSize % clsid))
+  except (win32api.error, ValueError):
+    return 0
+
+def CreatePooledInstance(clsid, reqIID):
+  """Create a new instance of a pooled CLSID
+
+  Returns the object @CreateInstance@ would, and the policy wrapping it,
+  which the COM framework keeps and passes to @ResetPooledInstance@.
+  """
+  retObj = _CreatePolicy(clsid)
+  return retObj._CreateInstance_(clsid, reqIID), retObj
+
+def ResetPooledInstance(retObj, reqIID):
+  """Reuse a pooled instance no longer referenced by COM
+
+  Calls the _Reset_ method of the wrapped object, and wraps the policy
+  returned by @CreatePooledInstance@ for COM again.
+  """
+  # Dispatchers delegate to the real policy.
+  policy = getattr(retObj, 'policy', retObj)
+  policy._obj_._Reset_()
+  return pythoncom.WrapObject(retObj, reqIID)
 
 class BasicWrapPolicy:
   """The base class of policies.
@@ -168,6 +231,11 @@ class BasicWrapPolicy:
          and only 1 property at a time can be fetched (which is all we support in getidsofnames anyway!)
          This is the new, prefered handler (the default _invoke_ handler simply called _invokeex_)
      _getnextdispid_- uses self._name_to_dispid_ to enumerate the DISPIDs
+
+     A policy may also provide a _dispid_to_callable_ dictionary, mapping DISPIDs to
+     callables.  When a COM client invokes a method with one of these DISPIDs, the
+     callable is called directly with the positional args (and returns the _real_ result),
+     without going through _Invoke_ at all.
   """
   def __init__(self, object):
     """Initialise the policy object
@@ -187,11 +255,15 @@ class BasicWrapPolicy:
        in the registry (using @DefaultPolicy@)
     """
     try:
-      classSpec = win32api.RegQueryValue(win32con.HKEY_CLASSES_ROOT,
-                                       regSpec % clsid)
-    except win32api.error:
-      raise error("The object is not correctly registered - %s key can not be read" % (regSpec % clsid))
-    myob = call_func(classSpec)
+      func = _class_specs[clsid]
+    except KeyError:
+      try:
+        classSpec = win32api.RegQueryValue(win32con.HKEY_CLASSES_ROOT,
+                                         regSpec % clsid)
+      except win32api.error:
+        raise error("The object is not correctly registered - %s key can not be read" % (regSpec % clsid))
+      func = _class_specs[clsid] = resolve_func(classSpec)
+    myob = func()
     self._wrap_(myob)
     try:
       return pythoncom.WrapObject(self, reqIID)
@@ -526,6 +598,20 @@ class DesignatedWrapPolicy(MappedWrapPolicy):
         next_dispid = self._allocnextdispid(next_dispid)
       self._dispid_to_func_[dispid] = name
     self._typeinfos_ = None # load these on demand.
+    self._build_dispid_to_callable_()
+
+  def _build_dispid_to_callable_(self):
+    # Let the gateway call public methods directly - but only if the object
+    # and policy use the standard Invoke handling, as the gateway will skip it.
+    self._dispid_to_callable_ = {}
+    for name in ('_Invoke_', '_invoke_', '_invokeex_'):
+      if name in self.__dict__ or \
+         getattr(type(self), name) is not getattr(DesignatedWrapPolicy, name):
+        return
+    for dispid, funcname in self._dispid_to_func_.items():
+      func = getattr(self._obj_, funcname, None)
+      if func is not None and callable(func):
+        self._dispid_to_callable_[dispid] = func
 
   def _build_typeinfos_(self):
     # Can only ever be one for now.
@@ -10,6 +10,7 @@ import sys
 import win32api
 import win32con
 import pythoncom
+import pywintypes
 import winerror
 import os
 
@@ -312,6 +313,9 @@ def RegisterServer(clsid,
         _set_string(verProgID, desc)
       _set_string(verProgID + '\\CLSID', str(clsid))
 
+  # The ProgID -> CLSID mapping may have changed.
+  pywintypes.ClearIIDCache()
+
 def GetUnregisterServerKeys(clsid, progID=None, verProgID=None, customKeys = None):
   """Given a server, return a list of of ("key", root), which are keys recursively
   and uncondtionally deleted at unregister or uninstall time.
@@ -340,6 +344,7 @@ def UnregisterServer(clsid, progID=None, verProgID=None, customKeys = None):
 
   for args in GetUnregisterServerKeys(clsid, progID, verProgID, customKeys ):
     recurse_delete_key(*args)
+  pywintypes.ClearIIDCache()
 
   ### it might be nice at some point to "roll back" the independent ProgID
   ### to an earlier version if one exists, and just blowing away the
@@ -390,6 +395,7 @@ def RegisterClasses(*classes, **flags):
     policySpec = _get(cls, '_reg_policy_spec_')
     clsctx = _get(cls, '_reg_clsctx_')
     tlb_filename = _get(cls, '_reg_typelib_filename_')
+    poolSize = _get(cls, '_reg_pool_size_')
     # default to being a COM category only when not frozen.
     addPyComCat = not _get(cls, '_reg_disable_pycomcat_', pythoncom.frozen!=0)
     addnPath = None
@@ -406,6 +412,9 @@ def RegisterClasses(*classes, **flags):
       dispatcherSpec = _get(cls, '_reg_dispatcher_spec_')
       debuggingDesc = ""
       options['Debugging'] = "0"
+    if poolSize:
+      # Read by win32com.server.policy.GetPoolSize()
+      options['PythonCOMPoolSize'] = str(poolSize)
 
     if spec is None:
       moduleName = cls.__module__
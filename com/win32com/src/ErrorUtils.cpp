@@ -13,6 +13,7 @@ static const WCHAR *szBadStringObject = L"<Bad String Object>";
 extern PyObject *PyCom_InternalError;
 
 void GetScodeString(SCODE sc, TCHAR *buf, int bufSize);
+static BOOL GetScodeStringEx(SCODE sc, TCHAR *buf, int bufSize);
 LPCTSTR GetScodeRangeString(SCODE sc);
 LPCTSTR GetSeverityString(SCODE sc);
 LPCTSTR GetFacilityString(SCODE sc);
@@ -567,32 +568,68 @@ void PyCom_LoggerNonServerException(PyObject *logProvider, const char *fmt, ...)
 // Client Side Errors - translate a COM failure to a Python exception
 //
 ////////////////////////////////////////////////////////////////////////
+// Messages for recently seen HRESULTs.  Some COM APIs fail as a matter of
+// course (DISP_E_MEMBERNOTFOUND probes, for example), and FormatMessage costs
+// far more than the rest of building the exception.  Only used with the
+// Python lock held.
+#define SCODE_CACHE_SIZE 64
+static struct {
+    HRESULT hr;
+    PyObject *obMessage;
+} g_scodeCache[SCODE_CACHE_SIZE];
+
+static PyObject *PyCom_ScodeStringObject(HRESULT hr)
+{
+    unsigned int slot = ((ULONG)hr ^ ((ULONG)hr >> 16)) % SCODE_CACHE_SIZE;
+    if (g_scodeCache[slot].obMessage != NULL && g_scodeCache[slot].hr == hr) {
+        Py_INCREF(g_scodeCache[slot].obMessage);
+        return g_scodeCache[slot].obMessage;
+    }
+    TCHAR buf[512];
+    BOOL bFound = GetScodeStringEx(hr, buf, sizeof(buf) / sizeof(buf[0]));
+    PyObject *ret = PyWinObject_FromTCHAR(buf);
+    // Made up messages aren't cached, as a module with the real one may be
+    // registered later.
+    if (ret != NULL && bFound) {
+        Py_XDECREF(g_scodeCache[slot].obMessage);
+        g_scodeCache[slot].hr = hr;
+        g_scodeCache[slot].obMessage = ret;
+        Py_INCREF(ret);
+    }
+    return ret;
+}
+
 PyObject *PyCom_BuildPyException(HRESULT errorhr, IUnknown *pUnk /* = NULL */, REFIID iid /* = IID_NULL */)
 {
     PyObject *obEI = NULL;
-    TCHAR scodeStringBuf[512];
-    GetScodeString(errorhr, scodeStringBuf, sizeof(scodeStringBuf) / sizeof(scodeStringBuf[0]));
 
 #ifndef MS_WINCE  // WINCE doesnt appear to have GetErrorInfo() - compiled, but doesnt link!
     if (pUnk != NULL) {
         assert(iid != IID_NULL);  // If you pass an IUnknown, you should pass the specific IID.
-        // See if it supports error info.
-        ISupportErrorInfo *pSEI;
+        // Most failures come without error info, and GetErrorInfo is much
+        // cheaper than asking the object if it supports error info, so check
+        // that first.  Error info the object doesn't claim is discarded.
+        IErrorInfo *pEI = NULL;
         HRESULT hr;
-        Py_BEGIN_ALLOW_THREADS hr = pUnk->QueryInterface(IID_ISupportErrorInfo, (void **)&pSEI);
-        if (SUCCEEDED(hr)) {
-            hr = pSEI->InterfaceSupportsErrorInfo(iid);
-            pSEI->Release();  // Finished with this object
+        Py_BEGIN_ALLOW_THREADS hr = GetErrorInfo(0, &pEI);
+        if (hr == S_OK) {
+            ISupportErrorInfo *pSEI;
+            hr = pUnk->QueryInterface(IID_ISupportErrorInfo, (void **)&pSEI);
+            if (SUCCEEDED(hr)) {
+                hr = pSEI->InterfaceSupportsErrorInfo(iid);
+                pSEI->Release();  // Finished with this object
+            }
+            if (FAILED(hr)) {
+                pEI->Release();
+                pEI = NULL;
+            }
         }
-        Py_END_ALLOW_THREADS if (SUCCEEDED(hr))
+        else
+            pEI = NULL;
+        Py_END_ALLOW_THREADS if (pEI != NULL)
         {
-            IErrorInfo *pEI;
-            Py_BEGIN_ALLOW_THREADS hr = GetErrorInfo(0, &pEI);
-            Py_END_ALLOW_THREADS if (hr == S_OK)
-            {
-                obEI = PyCom_PyObjectFromIErrorInfo(pEI, errorhr);
-                PYCOM_RELEASE(pEI);
-            }
+            obEI = PyCom_PyObjectFromIErrorInfo(pEI, errorhr);
+            PYCOM_RELEASE(pEI);
         }
     }
 #endif  // MS_WINCE
@@ -600,7 +637,7 @@ PyObject *PyCom_BuildPyException(HRESULT errorhr, IUnknown *pUnk /* = NULL */, R
         obEI = Py_None;
         Py_INCREF(Py_None);
     }
-    PyObject *evalue = Py_BuildValue("iNOO", errorhr, PyWinObject_FromTCHAR(scodeStringBuf), obEI, Py_None);
+    PyObject *evalue = Py_BuildValue("iNOO", errorhr, PyCom_ScodeStringObject(errorhr), obEI, Py_None);
     Py_DECREF(obEI);
 
     PyErr_SetObject(PyWinExc_COMError, evalue);
@@ -613,9 +650,7 @@ PyObject *PyCom_BuildPyException(HRESULT errorhr, IUnknown *pUnk /* = NULL */, R
 // Used rarely - currently by IDispatch and IActiveScriptParse* interfaces.
 PyObject *PyCom_BuildPyExceptionFromEXCEPINFO(HRESULT hr, EXCEPINFO *pexcepInfo /* = NULL */, UINT nArgErr /* = -1 */)
 {
-    TCHAR buf[512];
-    GetScodeString(hr, buf, sizeof(buf) / sizeof(TCHAR));
-    PyObject *obScodeString = PyWinObject_FromTCHAR(buf);
+    PyObject *obScodeString = PyCom_ScodeStringObject(hr);
     PyObject *evalue;
     PyObject *obArg;
 
@@ -680,17 +715,26 @@ PyObject *PyCom_PyObjectFromExcepInfo(const EXCEPINFO *pexcepInfo)
 // NOTE - This MUST return the same object format as the above function
 static PyObject *PyCom_PyObjectFromIErrorInfo(IErrorInfo *pEI, HRESULT errorhr)
 {
-    BSTR desc;
-    BSTR source;
-    BSTR helpfile;
+    BSTR desc = NULL;
+    BSTR source = NULL;
+    BSTR helpfile = NULL;
+    DWORD helpContext = 0;
     PyObject *obDesc;
     PyObject *obSource;
     PyObject *obHelpFile;
 
     HRESULT hr;
 
+    // Fetch everything in one go, rather than releasing the Python lock for each.
     Py_BEGIN_ALLOW_THREADS hr = pEI->GetDescription(&desc);
-    Py_END_ALLOW_THREADS if (hr != S_OK)
+    if (hr != S_OK)
+        desc = NULL;
+    if (pEI->GetSource(&source) != S_OK)
+        source = NULL;
+    if (pEI->GetHelpFile(&helpfile) != S_OK)
+        helpfile = NULL;
+    pEI->GetHelpContext(&helpContext);
+    Py_END_ALLOW_THREADS if (desc == NULL)
     {
         obDesc = Py_None;
         Py_INCREF(obDesc);
@@ -700,31 +744,22 @@ static PyObject *PyCom_PyObjectFromIErrorInfo(IErrorInfo *pEI, HRESULT errorhr)
         obDesc = MakeBstrToObj(desc);
         SysFreeString(desc);
     }
-
-    Py_BEGIN_ALLOW_THREADS hr = pEI->GetSource(&source);
-    Py_END_ALLOW_THREADS if (hr != S_OK)
-    {
+    if (source == NULL) {
         obSource = Py_None;
         Py_INCREF(obSource);
     }
-    else
-    {
+    else {
         obSource = MakeBstrToObj(source);
         SysFreeString(source);
     }
-    Py_BEGIN_ALLOW_THREADS hr = pEI->GetHelpFile(&helpfile);
-    Py_END_ALLOW_THREADS if (hr != S_OK)
-    {
+    if (helpfile == NULL) {
         obHelpFile = Py_None;
         Py_INCREF(obHelpFile);
     }
-    else
-    {
+    else {
         obHelpFile = MakeBstrToObj(helpfile);
         SysFreeString(helpfile);
     }
-    DWORD helpContext = 0;
-    pEI->GetHelpContext(&helpContext);
     PyObject *ret = Py_BuildValue("iOOOii",
                                   0,  // wCode remains zero, as scode holds our data.
                                   // ### should these by PyUnicode values?
@@ -744,7 +779,10 @@ static PyObject *PyCom_PyObjectFromIErrorInfo(IErrorInfo *pEI, HRESULT errorhr)
 #define _countof(array) (sizeof(array) / sizeof(array[0]))
 #endif
 
-void GetScodeString(HRESULT hr, LPTSTR buf, int bufSize)
+void GetScodeString(HRESULT hr, LPTSTR buf, int bufSize) { GetScodeStringEx(hr, buf, bufSize); }
+
+// As for GetScodeString, but returns FALSE if the message was made up.
+static BOOL GetScodeStringEx(HRESULT hr, LPTSTR buf, int bufSize)
 {
     struct HRESULT_ENTRY {
         HRESULT hr;
@@ -1067,7 +1105,7 @@ void GetScodeString(HRESULT hr, LPTSTR buf, int bufSize)
             if (numCopied > 2 && (buf[numCopied - 2] == '\n' || buf[numCopied - 2] == '\r'))
                 buf[numCopied - 2] = '\0';
         }
-        return;
+        return TRUE;
     }
     // Next see if this particular error code is registered as being supplied
     // by a specific DLL.
@@ -1080,7 +1118,7 @@ void GetScodeString(HRESULT hr, LPTSTR buf, int bufSize)
                 if (numCopied > 2 && (buf[numCopied - 2] == '\n' || buf[numCopied - 2] == '\r'))
                     buf[numCopied - 2] = '\0';
             }
-            return;
+            return TRUE;
         }
     }
 
@@ -1088,11 +1126,12 @@ void GetScodeString(HRESULT hr, LPTSTR buf, int bufSize)
     for (int i = 0; i < _countof(hrNameTable); i++) {
         if (hr == hrNameTable[i].hr) {
             _tcsncpy(buf, hrNameTable[i].lpszName, bufSize);
-            return;
+            return TRUE;
         }
     }
     // not found - make one up
     wsprintf(buf, _T("OLE error 0x%08x"), hr);
+    return FALSE;
 }
 
 LPCTSTR GetScodeRangeString(HRESULT hr)
@@ -122,7 +122,7 @@ PyObject *PyComEnumTypeObject::iter(PyObject *self)
 
 PyObject *PyComEnumTypeObject::iternext(PyObject *self)
 {
-    PyObject *ret = ((PyIBase *)self)->iter();
+    PyObject *ret = ((PyIBase *)self)->iternext();
     if (ret || PyErr_Occurred())
         return ret;
     PyObject *method = PyObject_GetAttrString(self, "Next");
@@ -0,0 +1,172 @@
+// PyComCallStats.cpp
+//
+// Call statistics for IDispatch calls - see PyComCallStats.h
+
+// @doc
+#include "stdafx.h"
+#include "PythonCOM.h"
+#include "PyComCallStats.h"
+
+// Phase durations are counted in power of 2 microsecond buckets - bucket 0
+// is less than 1us, bucket n is [2**(n-1), 2**n) us, and the last bucket
+// also holds everything longer.
+#define CALLSTATS_BUCKETS 24
+
+struct PyComCallStats {
+    ULONG count;
+    ULONG failures;
+    LONGLONG ticks[PYCOM_NUM_PHASES];
+    ULONG buckets[PYCOM_NUM_PHASES][CALLSTATS_BUCKETS];
+};
+
+BOOL g_bPyComCallStats = FALSE;
+// (direction, name, dispid) -> capsule of PyComCallStats.  Only used with
+// the Python lock held.
+static PyObject *g_obCallStats = NULL;
+static LONGLONG g_llTicksPerSecond = 0;
+
+static void FreeCallStats(PyObject *capsule) { delete (PyComCallStats *)PyCapsule_GetPointer(capsule, NULL); }
+
+static int CallStatsBucket(LONGLONG ticks)
+{
+    LONGLONG us = ticks * 1000000 / g_llTicksPerSecond;
+    int bucket = 0;
+    while (us > 0 && bucket < CALLSTATS_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void PyCom_RecordCallStats(BOOL bIncoming, PyObject *obName, DISPID dispid, const LONGLONG *ticks, BOOL bFailed)
+{
+    if (g_obCallStats == NULL)
+        return;
+    // Statistics must never change the outcome of the call.
+    PyObject *exc_type, *exc_value, *exc_tb;
+    PyErr_Fetch(&exc_type, &exc_value, &exc_tb);
+    PyComCallStats *stats = NULL;
+    PyObject *key = Py_BuildValue("sOl", bIncoming ? "in" : "out", obName, dispid);
+    if (key) {
+        PyObject *capsule = PyDict_GetItem(g_obCallStats, key);
+        if (capsule)
+            stats = (PyComCallStats *)PyCapsule_GetPointer(capsule, NULL);
+        else {
+            stats = new PyComCallStats;
+            memset(stats, 0, sizeof(*stats));
+            capsule = PyCapsule_New(stats, NULL, FreeCallStats);
+            if (!capsule) {
+                delete stats;
+                stats = NULL;
+            }
+            else {
+                if (PyDict_SetItem(g_obCallStats, key, capsule) != 0)
+                    stats = NULL;
+                Py_DECREF(capsule);
+            }
+        }
+        Py_DECREF(key);
+    }
+    if (stats) {
+        stats->count++;
+        if (bFailed)
+            stats->failures++;
+        for (int i = 0; i < PYCOM_NUM_PHASES; i++) {
+            stats->ticks[i] += ticks[i];
+            stats->buckets[i][CallStatsBucket(ticks[i])]++;
+        }
+    }
+    PyErr_Clear();
+    PyErr_Restore(exc_type, exc_value, exc_tb);
+}
+
+// @pymethod bool|pythoncom|EnableCallStats|Enables or disables the recording of call statistics.
+PyObject *pythoncom_EnableCallStats(PyObject *self, PyObject *args)
+{
+    BOOL bEnable = TRUE;
+    // @pyparm bool|bEnable|True|Should statistics be recorded?
+    if (!PyArg_ParseTuple(args, "|i:EnableCallStats", &bEnable))
+        return NULL;
+    // @comm Statistics are recorded for every IDispatch call made via a <o PyIDispatch>
+    // (Invoke and InvokeTypes), and for every call to a Python COM object through its
+    // IDispatch or IDispatchEx gateway.  See <om pythoncom.GetCallStats>.
+    // <nl>When disabled (the default) the only overhead is a test of a flag.
+    // @rdesc The previous setting.
+    if (bEnable && g_obCallStats == NULL) {
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        g_llTicksPerSecond = freq.QuadPart;
+        g_obCallStats = PyDict_New();
+        if (g_obCallStats == NULL)
+            return NULL;
+    }
+    BOOL bOld = g_bPyComCallStats;
+    g_bPyComCallStats = bEnable;
+    return PyBool_FromLong(bOld);
+}
+
+static PyObject *CallStatsPhase(PyComCallStats *stats, int phase)
+{
+    PyObject *obBuckets = PyTuple_New(CALLSTATS_BUCKETS);
+    if (!obBuckets)
+        return NULL;
+    for (int i = 0; i < CALLSTATS_BUCKETS; i++) {
+        PyObject *ob = PyLong_FromUnsignedLong(stats->buckets[phase][i]);
+        if (!ob) {
+            Py_DECREF(obBuckets);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(obBuckets, i, ob);
+    }
+    return Py_BuildValue("dN", (double)stats->ticks[phase] / g_llTicksPerSecond, obBuckets);
+}
+
+// @pymethod dict|pythoncom|GetCallStats|Returns the call statistics recorded since they were
+// enabled or last reset.
+PyObject *pythoncom_GetCallStats(PyObject *self, PyObject *args)
+{
+    BOOL bReset = FALSE;
+    // @pyparm bool|bReset|False|If true, the statistics are cleared once fetched.
+    if (!PyArg_ParseTuple(args, "|i:GetCallStats", &bReset))
+        return NULL;
+    // @rdesc A dictionary keyed by (direction, name, dispid) tuples.  direction is 'out'
+    // for calls made from Python and 'in' for calls to Python objects.  name is the
+    // name of the type information of the object called ('out'), or the class of the
+    // Python object ('in').
+    // <nl>Each value is a dictionary with 'count' and 'failures' items, and an item
+    // for each of 'marshal', 'call', 'unmarshal' and 'lock' (the time spent waiting
+    // for the Python lock).  These are tuples of (totalSeconds, histogram), where
+    // histogram is a tuple of counts - item 0 counts times under 1 microsecond, and
+    // item n those from 2**(n-1) to 2**n microseconds.
+    PyObject *ret = PyDict_New();
+    if (!ret || !g_obCallStats)
+        return ret;
+    static const char *phaseNames[PYCOM_NUM_PHASES] = {"marshal", "call", "unmarshal", "lock"};
+    Py_ssize_t pos = 0;
+    PyObject *key, *capsule;
+    while (PyDict_Next(g_obCallStats, &pos, &key, &capsule)) {
+        PyComCallStats *stats = (PyComCallStats *)PyCapsule_GetPointer(capsule, NULL);
+        PyObject *value = Py_BuildValue("{s:k,s:k}", "count", stats->count, "failures", stats->failures);
+        if (!value)
+            goto error;
+        for (int i = 0; i < PYCOM_NUM_PHASES; i++) {
+            PyObject *obPhase = CallStatsPhase(stats, i);
+            if (!obPhase || PyDict_SetItemString(value, phaseNames[i], obPhase) != 0) {
+                Py_XDECREF(obPhase);
+                Py_DECREF(value);
+                goto error;
+            }
+            Py_DECREF(obPhase);
+        }
+        int rc = PyDict_SetItem(ret, key, value);
+        Py_DECREF(value);
+        if (rc != 0)
+            goto error;
+    }
+    if (bReset)
+        PyDict_Clear(g_obCallStats);
+    return ret;
+error:
+    Py_DECREF(ret);
+    return NULL;
+}
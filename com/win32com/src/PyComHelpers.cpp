@@ -6,9 +6,25 @@
 #include "stdafx.h"
 #include "PythonCOM.h"
 #include "PythonCOMServer.h"
+#include "PyComObjectStats.h"
 #include "PyWinObjects.h"  // Until this is converted to the new API
 
 extern PyObject *g_obPyCom_MapIIDToType;
+extern BOOL g_bPyCom_InterfaceIdentity;
+extern PyIUnknown *PyCom_FindInIdentityMap(IUnknown *punk, PyTypeObject *type);
+extern int PyCom_RegisterPendingInterface(REFIID iid, const char *name);
+extern void PyCom_AddToIdentityMap(PyIUnknown *ob);
+
+// Recently used entries of the IID to type map, which avoids building an IID
+// object to look up the map for every interface object created.  Cleared by
+// PyCom_RegisterClientType.  Only used with the Python lock held.
+#define IIDTYPE_CACHE_SIZE 64
+static struct {
+    IID iid;
+    PyComTypeObject *type;
+} g_iidTypeCache[IIDTYPE_CACHE_SIZE];
+
+void PyCom_ClearIIDTypeCache() { memset(g_iidTypeCache, 0, sizeof(g_iidTypeCache)); }
 extern PyObject *g_obPyCom_MapServerIIDToGateway;
 
 // String conversions
@@ -51,27 +67,159 @@ PyObject *get_Decimal_class(void)
     return PyObject_GetAttrString(decimal_module, "Decimal");
 }
 
+// How VT_CY and VT_DECIMAL values are returned - see pythoncom.SetNumericConversion()
+static int numericConversion = 0;
+
+int PyCom_SetNumericConversion(int flags)
+{
+    int old = numericConversion;
+    numericConversion = flags;
+    return old;
+}
+
+int PyCom_GetNumericConversion(void) { return numericConversion; }
+
+// Writes the digits of a currency value, which is scaled by 10000, as Decimal(int64) / 10000
+// would give them - exactly, with no trailing zeros after the point.
+static void FormatCurrency(__int64 val, char *buf)
+{
+    unsigned __int64 mag = val < 0 ? (unsigned __int64)0 - (unsigned __int64)val : (unsigned __int64)val;
+    unsigned long frac = (unsigned long)(mag % 10000);
+    char *p = buf;
+    if (val < 0)
+        *p++ = '-';
+    p += sprintf(p, "%I64u", mag / 10000);
+    if (frac) {
+        int digits = 4;
+        while (frac % 10 == 0) {
+            frac /= 10;
+            digits--;
+        }
+        sprintf(p, ".%0*lu", digits, frac);
+    }
+}
+
 PyObject *PyObject_FromCurrency(CURRENCY &cy)
 {
-#if (PY_VERSION_HEX < 0x03000000)
-    static char *divname = "__div__";
-#else
-    static char *divname = "__truediv__";
-#endif
+    if (numericConversion & PYCOM_CY_AS_SCALED_INT)
+        return PyLong_FromLongLong(cy.int64);
     if (Decimal_class == NULL) {
         Decimal_class = get_Decimal_class();
         if (Decimal_class == NULL)
             return NULL;
     }
+    // Parsing the digits is one call into the decimal module, where
+    // Decimal(int64) / 10000 is two, plus the division itself.
+    char buf[32];
+    FormatCurrency(cy.int64, buf);
+    return PyObject_CallFunction(Decimal_class, "s", buf);
+}
 
-    TmpPyObject unscaled_result = PyObject_CallFunction(Decimal_class, "L", cy.int64);
-    if (unscaled_result == NULL)
+PYCOM_EXPORT PyObject *PyObject_FromDECIMAL(const DECIMAL &dec)
+{
+    if (dec.scale > 28) {
+        PyErr_Format(PyExc_ValueError, "The DECIMAL has an invalid scale (%d)", dec.scale);
         return NULL;
-    return PyObject_CallMethod(unscaled_result, divname, "l", 10000);
+    }
+    if (Decimal_class == NULL) {
+        Decimal_class = get_Decimal_class();
+        if (Decimal_class == NULL)
+            return NULL;
+    }
+    // The 96 bit integer, divided by 10 until nothing is left - digits are least significant first.
+    ULONG parts[3] = {dec.Lo32, dec.Mid32, dec.Hi32};
+    char digits[32];
+    int numDigits = 0;
+    do {
+        unsigned __int64 rem = 0;
+        for (int i = 2; i >= 0; i--) {
+            unsigned __int64 cur = (rem << 32) | parts[i];
+            parts[i] = (ULONG)(cur / 10);
+            rem = cur % 10;
+        }
+        digits[numDigits++] = (char)('0' + rem);
+    } while (parts[0] || parts[1] || parts[2]);
+
+    char buf[64];
+    char *p = buf;
+    int i;
+    if (dec.sign & DECIMAL_NEG)
+        *p++ = '-';
+    if (numDigits <= dec.scale) {
+        *p++ = '0';
+        *p++ = '.';
+        for (i = dec.scale; i > numDigits; i--) *p++ = '0';
+    }
+    for (i = numDigits - 1; i >= 0; i--) {
+        *p++ = digits[i];
+        if (i == dec.scale && i > 0)
+            *p++ = '.';
+    }
+    *p = '\0';
+    // The scale is kept, so trailing zeros are significant, as for any Decimal.
+    return PyObject_CallFunction(Decimal_class, "s", buf);
+}
+
+// Scales the text of a finite Decimal by 10000, truncating the same way as
+// int(ob * 10000).  Returns FALSE, with no exception set, for anything which
+// isn't a plain number that fits, which the slower route then deals with.
+static BOOL ScaleCurrencyString(const char *s, __int64 *pResult)
+{
+    BOOL neg = *s == '-';
+    if (*s == '-' || *s == '+')
+        s++;
+    const char *digits = s;
+    int numDigits = 0, fracDigits = 0;
+    BOOL point = FALSE;
+    for (; (*s >= '0' && *s <= '9') || *s == '.'; s++) {
+        if (*s == '.') {
+            if (point)
+                return FALSE;
+            point = TRUE;
+        }
+        else {
+            numDigits++;
+            if (point)
+                fracDigits++;
+        }
+    }
+    long exponent = 0;
+    if (*s == 'E' || *s == 'e') {
+        char *end;
+        exponent = strtol(s + 1, &end, 10);
+        s = end;
+    }
+    if (numDigits == 0 || *s != '\0' || exponent > 100 || exponent < -100)
+        return FALSE;
+    // The scaled value is the digits times 10 ** shift, with digits below the units dropped.
+    long shift = exponent - fracDigits + 4;
+    unsigned __int64 limit = neg ? (unsigned __int64)1 << 63 : ((unsigned __int64)1 << 63) - 1;
+    unsigned __int64 mag = 0;
+    int keep = numDigits + (shift < 0 ? shift : 0);
+    for (const char *c = digits; keep > 0; c++) {
+        if (*c == '.')
+            continue;
+        unsigned d = *c - '0';
+        if (mag > (limit - d) / 10)
+            return FALSE;
+        mag = mag * 10 + d;
+        keep--;
+    }
+    for (; shift > 0 && mag; shift--) {
+        if (mag > limit / 10)
+            return FALSE;
+        mag *= 10;
+    }
+    *pResult = neg ? (__int64)((unsigned __int64)0 - mag) : (__int64)mag;
+    return TRUE;
 }
 
 PYCOM_EXPORT BOOL PyObject_AsCurrency(PyObject *ob, CURRENCY *pcy)
 {
+    if ((numericConversion & PYCOM_CY_AS_SCALED_INT) && (PyLong_Check(ob) || PyInt_Check(ob))) {
+        pcy->int64 = PyLong_AsLongLong(ob);
+        return pcy->int64 != -1 || !PyErr_Occurred();
+    }
     if (Decimal_class == NULL) {
         Decimal_class = get_Decimal_class();
         if (Decimal_class == NULL)
@@ -86,6 +234,19 @@ PYCOM_EXPORT BOOL PyObject_AsCurrency(PyObject *ob, CURRENCY *pcy)
         return FALSE;
     }
 
+    TmpPyObject str = PyObject_Str(ob);
+    if (str == NULL)
+        return FALSE;
+#if (PY_VERSION_HEX < 0x03000000)
+    const char *sz = PyString_AsString(str);
+#else
+    const char *sz = PyUnicode_AsUTF8(str);
+#endif
+    if (sz == NULL)
+        return FALSE;
+    if (ScaleCurrencyString(sz, &pcy->int64))
+        return TRUE;
+
     TmpPyObject scaled = PyObject_CallMethod(ob, "__mul__", "l", 10000);
     if (scaled == NULL)
         return FALSE;
@@ -114,34 +275,62 @@ PyObject *PyCom_PyObjectFromIUnknown(IUnknown *punk, REFIID riid, BOOL bAddRef /
         return Py_None;
     }
 
-    // Look up the map, and create the object.
-    PyObject *obiid = PyWinObject_FromIID(riid);
-    if (!obiid) {
-        POFIU_RELEASE_ON_FAILURE
-        return NULL;
-    }
-    PyObject *createType = PyDict_GetItem(g_obPyCom_MapIIDToType, obiid);
-    Py_DECREF(obiid);
-    if (createType == NULL) {
-        PyErr_Clear();
-        PyErr_SetString(PyExc_TypeError, "There is no interface object registered that supports this IID");
-        POFIU_RELEASE_ON_FAILURE
-        return NULL;
-    }
+    unsigned int slot = riid.Data1 % IIDTYPE_CACHE_SIZE;
+    PyComTypeObject *myCreateType = g_iidTypeCache[slot].type;
+    if (myCreateType == NULL || g_iidTypeCache[slot].iid != riid) {
+        // Look up the map, and create the object.
+        PyObject *obiid = PyWinObject_FromIID(riid);
+        if (!obiid) {
+            POFIU_RELEASE_ON_FAILURE
+            return NULL;
+        }
+        PyObject *createType = PyDict_GetItem(g_obPyCom_MapIIDToType, obiid);
+        if (createType == NULL) {
+            int numFound = PyCom_RegisterPendingInterface(riid, NULL);
+            if (numFound < 0) {
+                Py_DECREF(obiid);
+                POFIU_RELEASE_ON_FAILURE
+                return NULL;
+            }
+            if (numFound > 0)
+                createType = PyDict_GetItem(g_obPyCom_MapIIDToType, obiid);
+        }
+        Py_DECREF(obiid);
+        if (createType == NULL) {
+            PyErr_Clear();
+            PyErr_SetString(PyExc_TypeError, "There is no interface object registered that supports this IID");
+            POFIU_RELEASE_ON_FAILURE
+            return NULL;
+        }
 
-    // ensure the object we fetched is actually one of our interface types
-    if (!PyComTypeObject::is_interface_type(createType)) {
-        PyErr_SetString(PyExc_TypeError, "The Python IID map is invalid - the value is not an interface type object");
-        POFIU_RELEASE_ON_FAILURE
-        return NULL;
+        // ensure the object we fetched is actually one of our interface types
+        if (!PyComTypeObject::is_interface_type(createType)) {
+            PyErr_SetString(PyExc_TypeError,
+                            "The Python IID map is invalid - the value is not an interface type object");
+            POFIU_RELEASE_ON_FAILURE
+            return NULL;
+        }
+
+        // we can now safely cast the thing to a PyComTypeObject and use it
+        myCreateType = (PyComTypeObject *)createType;
+        if (myCreateType->ctor == NULL) {
+            PyErr_SetString(PyExc_TypeError, "The type does not declare a PyCom constructor");
+            POFIU_RELEASE_ON_FAILURE
+            return NULL;
+        }
+        g_iidTypeCache[slot].iid = riid;
+        g_iidTypeCache[slot].type = myCreateType;
     }
 
-    // we can now safely cast the thing to a PyComTypeObject and use it
-    PyComTypeObject *myCreateType = (PyComTypeObject *)createType;
-    if (myCreateType->ctor == NULL) {
-        PyErr_SetString(PyExc_TypeError, "The type does not declare a PyCom constructor");
-        POFIU_RELEASE_ON_FAILURE
-        return NULL;
+    if (g_bPyCom_InterfaceIdentity) {
+        PyIUnknown *existing = PyCom_FindInIdentityMap(punk, myCreateType);
+        if (existing != NULL) {
+            // The existing object already holds a reference, so drop any we were given.
+            Py_INCREF(existing);
+            if (!bAddRef)
+                punk->Release();
+            return existing;
+        }
     }
 
     PyIUnknown *ret = (*myCreateType->ctor)(punk);
@@ -150,6 +339,10 @@ PyObject *PyCom_PyObjectFromIUnknown(IUnknown *punk, REFIID riid, BOOL bAddRef /
 #endif
     if (ret && bAddRef)
         punk->AddRef();
+    if (ret && g_bPyComObjectStats)
+        ret->m_pObjectStats = PyCom_ObjectStatsCreated(FALSE, riid, (PyObject *)ret->ob_type);
+    if (ret && g_bPyCom_InterfaceIdentity)
+        PyCom_AddToIdentityMap(ret);
     return ret;
 }
 
@@ -228,11 +421,28 @@ HRESULT PyCom_MakeRegisteredGatewayObject(REFIID iid, PyObject *instance, PyGate
         PyObject *keyObject = PyWinObject_FromIID(iid);
         if (keyObject) {
             PyObject *valueObject = PyDict_GetItem(g_obPyCom_MapServerIIDToGateway, keyObject);
+            if (valueObject == NULL) {
+                if (PyCom_RegisterPendingInterface(iid, NULL) > 0)
+                    valueObject = PyDict_GetItem(g_obPyCom_MapServerIIDToGateway, keyObject);
+                PyErr_Clear();
+            }
             Py_DECREF(keyObject);
             if (valueObject) {
                 pfnPyGatewayConstructor ctor = (pfnPyGatewayConstructor)PyLong_AsVoidPtr(valueObject);
                 // ctor takes reference count to instance.
                 hr = (*ctor)(instance, base, ppv, iid);
+                if (SUCCEEDED(hr) && g_bPyComObjectStats) {
+                    // Every gateway can be unwrapped, which finds the PyGatewayBase
+                    // behind whichever interface pointer the constructor returned.
+                    IInternalUnwrapPythonObject *pUnwrap;
+                    if (((IUnknown *)*ppv)->QueryInterface(IID_IInternalUnwrapPythonObject, (void **)&pUnwrap) ==
+                        S_OK) {
+                        PyGatewayBase *pGateway = static_cast<PyGatewayBase *>(pUnwrap);
+                        if (pGateway->m_pObjectStats == NULL)
+                            pGateway->m_pObjectStats = PyCom_ObjectStatsCreated(TRUE, iid, instance);
+                        pUnwrap->Release();
+                    }
+                }
             }
             else {
                 hr = E_NOINTERFACE;
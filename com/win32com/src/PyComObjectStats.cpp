@@ -0,0 +1,182 @@
+// PyComObjectStats.cpp
+//
+// Live interface object and gateway counts - see PyComObjectStats.h
+
+// @doc
+#include "stdafx.h"
+#include "PythonCOM.h"
+#include "PyComObjectStats.h"
+#include "frameobject.h"
+
+struct PyComObjectStatsEntry {
+    LONG live;     // changed with Interlocked functions - objects die without the Python lock.
+    LONG peak;     // the most live at once, as seen when an object is created.
+    ULONG created;
+};
+
+BOOL g_bPyComObjectStats = FALSE;
+// Also charge objects to the Python source line which created them?
+static BOOL g_bPyComObjectStatsSites = FALSE;
+// (kind, iid, class, site) -> capsule of PyComObjectStatsEntry.  Only used
+// with the Python lock held.  Entries are never removed, as the objects
+// counted point at them.
+static PyObject *g_obObjectStats = NULL;
+
+// The name objects are counted under - the module qualified name of the class
+// of a gateway's Python object (or of the object the policy wraps), or of the
+// interface type.
+static PyObject *ObjectStatsClassName(BOOL bGateway, PyObject *ob)
+{
+    PyObject *obWrapped = NULL;
+    if (bGateway) {
+        obWrapped = PyObject_GetAttrString(ob, "_obj_");
+        if (obWrapped && obWrapped != Py_None)
+            ob = obWrapped;
+        else
+            PyErr_Clear();
+    }
+    PyTypeObject *type = bGateway ? Py_TYPE(ob) : (PyTypeObject *)ob;
+    PyObject *ret;
+    PyObject *obModule =
+        (type->tp_flags & Py_TPFLAGS_HEAPTYPE) ? PyObject_GetAttrString((PyObject *)type, "__module__") : NULL;
+    if (obModule && PyUnicode_Check(obModule))
+        ret = PyUnicode_FromFormat("%U.%s", obModule, type->tp_name);
+    else {
+        PyErr_Clear();
+        ret = PyUnicode_FromString(type->tp_name);
+    }
+    Py_XDECREF(obModule);
+    Py_XDECREF(obWrapped);
+    return ret;
+}
+
+// "filename:line" of the Python code running, or None.
+static PyObject *ObjectStatsSite(void)
+{
+    PyFrameObject *frame = PyEval_GetFrame();
+    if (frame == NULL) {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+#if PY_VERSION_HEX >= 0x03090000
+    PyCodeObject *code = PyFrame_GetCode(frame);
+#else
+    PyCodeObject *code = frame->f_code;
+    Py_INCREF(code);
+#endif
+    PyObject *ret = PyUnicode_FromFormat("%U:%d", code->co_filename, PyFrame_GetLineNumber(frame));
+    Py_DECREF(code);
+    return ret;
+}
+
+PyComObjectStatsEntry *PyCom_ObjectStatsCreated(BOOL bGateway, REFIID iid, PyObject *obClass)
+{
+    if (g_obObjectStats == NULL)
+        return NULL;
+    // Accounting must never change the outcome of creating the object.
+    PyObject *exc_type, *exc_value, *exc_tb;
+    PyErr_Fetch(&exc_type, &exc_value, &exc_tb);
+    PyComObjectStatsEntry *entry = NULL;
+    PyObject *obSite = Py_None;
+    if (g_bPyComObjectStatsSites)
+        obSite = ObjectStatsSite();
+    else
+        Py_INCREF(Py_None);
+    PyObject *key = Py_BuildValue("sNNN", bGateway ? "gateway" : "interface", PyWinObject_FromIID(iid),
+                                  ObjectStatsClassName(bGateway, obClass), obSite);
+    if (key) {
+        PyObject *capsule = PyDict_GetItem(g_obObjectStats, key);
+        if (capsule)
+            entry = (PyComObjectStatsEntry *)PyCapsule_GetPointer(capsule, NULL);
+        else {
+            entry = new PyComObjectStatsEntry;
+            memset(entry, 0, sizeof(*entry));
+            capsule = PyCapsule_New(entry, NULL, NULL);
+            if (!capsule || PyDict_SetItem(g_obObjectStats, key, capsule) != 0) {
+                delete entry;
+                entry = NULL;
+            }
+            Py_XDECREF(capsule);
+        }
+        Py_DECREF(key);
+    }
+    if (entry) {
+        LONG live = InterlockedIncrement(&entry->live);
+        if (live > entry->peak)
+            entry->peak = live;
+        entry->created++;
+    }
+    PyErr_Clear();
+    PyErr_Restore(exc_type, exc_value, exc_tb);
+    return entry;
+}
+
+void PyCom_ObjectStatsDestroyed(PyComObjectStatsEntry *entry) { InterlockedDecrement(&entry->live); }
+
+// @pymethod bool|pythoncom|EnableObjectStats|Enables or disables counting the live interface
+// objects and gateways by IID and class.
+PyObject *pythoncom_EnableObjectStats(PyObject *self, PyObject *args)
+{
+    BOOL bEnable = TRUE;
+    BOOL bSites = FALSE;
+    // @pyparm bool|bEnable|True|Should objects be counted?
+    // @pyparm bool|bSites|False|Should objects also be counted by the Python source line which
+    // created them?  This makes creating each object noticeably more expensive.
+    if (!PyArg_ParseTuple(args, "|ii:EnableObjectStats", &bEnable, &bSites))
+        return NULL;
+    // @comm Only objects created while enabled are counted, so enable this as early as
+    // possible - see <om pythoncom.GetObjectStats>.  Objects already counted continue to
+    // be once it is disabled.
+    // <nl>When disabled (the default) the only overhead is a test of a flag.
+    // @rdesc The previous setting.
+    if (bEnable && g_obObjectStats == NULL) {
+        g_obObjectStats = PyDict_New();
+        if (g_obObjectStats == NULL)
+            return NULL;
+    }
+    BOOL bOld = g_bPyComObjectStats;
+    g_bPyComObjectStatsSites = bSites;
+    g_bPyComObjectStats = bEnable;
+    return PyBool_FromLong(bOld);
+}
+
+// @pymethod dict|pythoncom|GetObjectStats|Returns the counts of interface objects and gateways
+// recorded since they were enabled.
+PyObject *pythoncom_GetObjectStats(PyObject *self, PyObject *args)
+{
+    BOOL bReset = FALSE;
+    // @pyparm bool|bReset|False|If true, the created and peak counts are restarted once fetched.
+    // The live counts are never reset.
+    if (!PyArg_ParseTuple(args, "|i:GetObjectStats", &bReset))
+        return NULL;
+    // @rdesc A dictionary keyed by (kind, iid, class, site) tuples.  kind is 'interface'
+    // for the Python objects wrapping COM interfaces, such as <o PyIDispatch>, and 'gateway'
+    // for the COM objects implemented by Python objects.  class is the name of the interface
+    // type, or the class of the Python object a gateway wraps (the object behind its policy).
+    // site is 'filename:line' of the Python code which created the objects, or None if
+    // sites are not being recorded or no Python code was running.
+    // <nl>Each value is a dictionary with 'live', 'peak' and 'created' items.
+    // @comm Comparing the live counts over time shows which interfaces and classes are
+    // leaking references, without the overhead of a debug build.
+    PyObject *ret = PyDict_New();
+    if (!ret || !g_obObjectStats)
+        return ret;
+    Py_ssize_t pos = 0;
+    PyObject *key, *capsule;
+    while (PyDict_Next(g_obObjectStats, &pos, &key, &capsule)) {
+        PyComObjectStatsEntry *entry = (PyComObjectStatsEntry *)PyCapsule_GetPointer(capsule, NULL);
+        PyObject *value =
+            Py_BuildValue("{s:l,s:l,s:k}", "live", entry->live, "peak", entry->peak, "created", entry->created);
+        if (!value || PyDict_SetItem(ret, key, value) != 0) {
+            Py_XDECREF(value);
+            Py_DECREF(ret);
+            return NULL;
+        }
+        Py_DECREF(value);
+        if (bReset) {
+            entry->created = 0;
+            entry->peak = entry->live;
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,538 @@
+// PyConnectionSinks.cpp
+//
+// A native list of advised connection point sinks, so a Python server can
+// fire an event to every sink with the arguments converted to VARIANTs once -
+// see pythoncom.CreateConnectionSinks.
+
+// @doc
+#include "stdafx.h"
+#include "PythonCOM.h"
+
+// The arguments of one fired event, shared by every sink it is delivered to.
+struct SinkEvent {
+    LONG refs;
+    DISPID dispid;
+    DISPPARAMS dispparams;
+};
+
+static void ReleaseSinkEvent(SinkEvent *ev)
+{
+    if (InterlockedDecrement(&ev->refs) != 0)
+        return;
+    for (UINT i = 0; i < ev->dispparams.cArgs; i++) VariantClear(&ev->dispparams.rgvarg[i]);
+    delete[] ev->dispparams.rgvarg;
+    delete ev;
+}
+
+static HRESULT InvokeSink(IDispatch *pDisp, SinkEvent *ev)
+{
+    EXCEPINFO excepInfo;
+    memset(&excepInfo, 0, sizeof(excepInfo));
+    UINT argErr;
+    HRESULT hr =
+        pDisp->Invoke(ev->dispid, IID_NULL, 0, DISPATCH_METHOD, &ev->dispparams, NULL, &excepInfo, &argErr);
+    if (hr == DISP_E_EXCEPTION) {
+        if (excepInfo.pfnDeferredFillIn)
+            (*excepInfo.pfnDeferredFillIn)(&excepInfo);
+        if (FAILED(excepInfo.scode))
+            hr = excepInfo.scode;
+        SysFreeString(excepInfo.bstrSource);
+        SysFreeString(excepInfo.bstrDescription);
+        SysFreeString(excepInfo.bstrHelpFile);
+    }
+    return hr;
+}
+
+struct SinkQueueItem {
+    SinkEvent *ev;
+    SinkQueueItem *next;
+};
+
+// One advised sink.  Referenced by the owning list, by the worker thread
+// delivering its asynchronous events, and by any Fire call in progress.
+struct ConnectionSink {
+    LONG refs;
+    DWORD cookie;
+    IDispatch *pDisp;   // for synchronous events, in the apartment that added it.  NULL once stopped.
+    DWORD dwGITCookie;  // for the worker thread, registered when it is started.
+    // Asynchronous events waiting for the worker thread, protected by cs.
+    CRITICAL_SECTION cs;
+    SinkQueueItem *head;
+    SinkQueueItem *tail;
+    HANDLE hWake;
+    BOOL bStopping;
+    BOOL bStarted;
+    volatile LONG pending;
+    volatile LONG dropped;
+    volatile LONG failures;
+    volatile LONG lastError;
+};
+
+// Created by the first CreateConnectionSinks call, before any thread can need it.
+static IGlobalInterfaceTable *GetGIT()
+{
+    static IGlobalInterfaceTable *pGIT = NULL;
+    if (pGIT == NULL)
+        CoCreateInstance(CLSID_StdGlobalInterfaceTable, NULL, CLSCTX_INPROC_SERVER, IID_IGlobalInterfaceTable,
+                         (void **)&pGIT);
+    return pGIT;
+}
+
+static void ReleaseSink(ConnectionSink *sink)
+{
+    if (InterlockedDecrement(&sink->refs) != 0)
+        return;
+    while (sink->head) {
+        SinkQueueItem *item = sink->head;
+        sink->head = item->next;
+        ReleaseSinkEvent(item->ev);
+        delete item;
+    }
+    if (sink->dwGITCookie)
+        GetGIT()->RevokeInterfaceFromGlobal(sink->dwGITCookie);
+    // StopSink normally released this in the owning apartment already.
+    if (sink->pDisp)
+        sink->pDisp->Release();
+    if (sink->hWake)
+        CloseHandle(sink->hWake);
+    DeleteCriticalSection(&sink->cs);
+    delete sink;
+}
+
+static SinkQueueItem *TakeQueue(ConnectionSink *sink, BOOL *pbStopping)
+{
+    EnterCriticalSection(&sink->cs);
+    SinkQueueItem *ret = sink->head;
+    sink->head = sink->tail = NULL;
+    *pbStopping = sink->bStopping;
+    LeaveCriticalSection(&sink->cs);
+    return ret;
+}
+
+// Delivers the asynchronous events for one sink, so a sink which is slow to
+// respond only delays its own events.
+static DWORD WINAPI SinkThreadProc(LPVOID arg)
+{
+    ConnectionSink *sink = (ConnectionSink *)arg;
+    CoInitializeEx(NULL, COINIT_MULTITHREADED);
+    IDispatch *pDisp = NULL;
+    HRESULT hrGet = GetGIT()->GetInterfaceFromGlobal(sink->dwGITCookie, IID_IDispatch, (void **)&pDisp);
+    BOOL bStopping = FALSE;
+    while (!bStopping) {
+        WaitForSingleObject(sink->hWake, INFINITE);
+        SinkQueueItem *item = TakeQueue(sink, &bStopping);
+        while (item) {
+            SinkQueueItem *next = item->next;
+            if (!bStopping) {
+                HRESULT hr = FAILED(hrGet) ? hrGet : InvokeSink(pDisp, item->ev);
+                if (FAILED(hr)) {
+                    InterlockedIncrement(&sink->failures);
+                    InterlockedExchange(&sink->lastError, hr);
+                }
+            }
+            InterlockedDecrement(&sink->pending);
+            ReleaseSinkEvent(item->ev);
+            delete item;
+            item = next;
+        }
+    }
+    if (pDisp)
+        pDisp->Release();
+    ReleaseSink(sink);
+    CoUninitialize();
+    return 0;
+}
+
+// Called with sink->cs held.
+static HRESULT StartSinkThread(ConnectionSink *sink)
+{
+    if (sink->bStopping)
+        return CONNECT_E_NOCONNECTION;
+    IGlobalInterfaceTable *pGIT = GetGIT();
+    if (pGIT == NULL)
+        return E_NOINTERFACE;
+    if (sink->dwGITCookie == 0) {
+        HRESULT hr = pGIT->RegisterInterfaceInGlobal(sink->pDisp, IID_IDispatch, &sink->dwGITCookie);
+        if (FAILED(hr))
+            return hr;
+    }
+    if (sink->hWake == NULL)
+        sink->hWake = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (sink->hWake == NULL)
+        return HRESULT_FROM_WIN32(GetLastError());
+    InterlockedIncrement(&sink->refs);
+    HANDLE hThread = CreateThread(NULL, 0, SinkThreadProc, sink, 0, NULL);
+    if (hThread == NULL) {
+        InterlockedDecrement(&sink->refs);
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    // Nothing ever waits for the thread - it exits once the sink is removed.
+    CloseHandle(hThread);
+    sink->bStarted = TRUE;
+    return S_OK;
+}
+
+// Called in the apartment that added the sink, so the interface is released there.
+static void StopSink(ConnectionSink *sink)
+{
+    EnterCriticalSection(&sink->cs);
+    sink->bStopping = TRUE;
+    IDispatch *pDisp = sink->pDisp;
+    sink->pDisp = NULL;
+    BOOL bStarted = sink->bStarted;
+    LeaveCriticalSection(&sink->cs);
+    if (bStarted)
+        SetEvent(sink->hWake);
+    pDisp->Release();
+}
+
+// Returns a reference to the sink's interface for a synchronous call, or NULL if
+// it has been removed - perhaps by a sink unadvising from inside an earlier event.
+static IDispatch *GetSinkDispatch(ConnectionSink *sink)
+{
+    EnterCriticalSection(&sink->cs);
+    IDispatch *ret = sink->pDisp;
+    if (ret)
+        ret->AddRef();
+    LeaveCriticalSection(&sink->cs);
+    return ret;
+}
+
+// @object PyConnectionSinks|A list of connection point sinks, held natively.
+// @comm Created by <om pythoncom.CreateConnectionSinks>, and normally used via
+// <c win32com.server.connect.ConnectableServer>.  <om PyConnectionSinks.Fire> converts the
+// event arguments to VARIANTs once, and calls IDispatch::Invoke on every sink with the
+// Python lock released.
+// <nl>Asynchronous events are delivered by a thread per sink, in the multi-threaded
+// apartment, so a sink which is slow or hung only delays its own events.  Each sink queues at
+// most MaxPending events - further events for that sink are dropped and counted.
+class PyConnectionSinks : public PyObject {
+   public:
+    PyConnectionSinks(ULONG maxPending);
+    ~PyConnectionSinks();
+
+    ConnectionSink *Find(DWORD cookie, ULONG *pIndex);
+
+    static void tp_dealloc(PyObject *ob);
+    static Py_ssize_t sq_length(PyObject *self);
+    static PyObject *Add(PyObject *self, PyObject *args);
+    static PyObject *Remove(PyObject *self, PyObject *args);
+    static PyObject *Fire(PyObject *self, PyObject *args);
+    static PyObject *GetStats(PyObject *self, PyObject *args);
+    static struct PyMethodDef methods[];
+    static PySequenceMethods sequence;
+    static PyTypeObject Type;
+
+    ConnectionSink **m_sinks;
+    ULONG m_count;
+    ULONG m_allocated;
+    ULONG m_maxPending;
+    DWORD m_nextCookie;
+};
+
+PyConnectionSinks::PyConnectionSinks(ULONG maxPending)
+{
+    ob_type = &PyConnectionSinks::Type;
+    _Py_NewReference(this);
+    m_sinks = NULL;
+    m_count = m_allocated = 0;
+    m_maxPending = maxPending;
+    m_nextCookie = 1;
+}
+
+PyConnectionSinks::~PyConnectionSinks()
+{
+    for (ULONG i = 0; i < m_count; i++) {
+        StopSink(m_sinks[i]);
+        ReleaseSink(m_sinks[i]);
+    }
+    delete[] m_sinks;
+}
+
+/*static*/ void PyConnectionSinks::tp_dealloc(PyObject *ob)
+{
+    PY_INTERFACE_PRECALL;
+    delete (PyConnectionSinks *)ob;
+    PY_INTERFACE_POSTCALL;
+}
+
+/*static*/ Py_ssize_t PyConnectionSinks::sq_length(PyObject *self) { return ((PyConnectionSinks *)self)->m_count; }
+
+ConnectionSink *PyConnectionSinks::Find(DWORD cookie, ULONG *pIndex)
+{
+    for (ULONG i = 0; i < m_count; i++)
+        if (m_sinks[i]->cookie == cookie) {
+            if (pIndex)
+                *pIndex = i;
+            return m_sinks[i];
+        }
+    return NULL;
+}
+
+// @pymethod int|PyConnectionSinks|Add|Adds a sink, returning its cookie.
+PyObject *PyConnectionSinks::Add(PyObject *self, PyObject *args)
+{
+    PyConnectionSinks *This = (PyConnectionSinks *)self;
+    PyObject *obDisp;
+    DWORD cookie = 0;
+    // @pyparm <o PyIDispatch>|sink||The sink, as passed to IConnectionPoint::Advise.
+    // @pyparm int|cookie|0|The cookie to identify the sink by, or 0 to allocate one.
+    if (!PyArg_ParseTuple(args, "O|k:Add", &obDisp, &cookie))
+        return NULL;
+    if (cookie == 0)
+        cookie = This->m_nextCookie++;
+    else if (cookie >= This->m_nextCookie)
+        This->m_nextCookie = cookie + 1;
+    if (This->Find(cookie, NULL)) {
+        PyErr_SetString(PyExc_ValueError, "A sink with this cookie already exists");
+        return NULL;
+    }
+    IDispatch *pDisp;
+    if (!PyCom_InterfaceFromPyObject(obDisp, IID_IDispatch, (void **)&pDisp, FALSE))
+        return NULL;
+    if (This->m_count == This->m_allocated) {
+        ULONG allocated = This->m_allocated ? This->m_allocated * 2 : 16;
+        ConnectionSink **sinks = new ConnectionSink *[allocated];
+        if (This->m_count)
+            memcpy(sinks, This->m_sinks, This->m_count * sizeof(ConnectionSink *));
+        delete[] This->m_sinks;
+        This->m_sinks = sinks;
+        This->m_allocated = allocated;
+    }
+    ConnectionSink *sink = new ConnectionSink;
+    memset(sink, 0, sizeof(*sink));
+    sink->refs = 1;
+    sink->cookie = cookie;
+    sink->pDisp = pDisp;
+    InitializeCriticalSection(&sink->cs);
+    This->m_sinks[This->m_count++] = sink;
+    return PyLong_FromUnsignedLong(cookie);
+}
+
+// @pymethod |PyConnectionSinks|Remove|Removes a sink.
+// @comm Asynchronous events still queued for the sink are discarded.  One already being
+// delivered completes on the sink's thread, which then exits.
+PyObject *PyConnectionSinks::Remove(PyObject *self, PyObject *args)
+{
+    PyConnectionSinks *This = (PyConnectionSinks *)self;
+    DWORD cookie;
+    // @pyparm int|cookie||The cookie returned by <om PyConnectionSinks.Add>
+    if (!PyArg_ParseTuple(args, "k:Remove", &cookie))
+        return NULL;
+    ULONG index;
+    ConnectionSink *sink = This->Find(cookie, &index);
+    if (sink == NULL) {
+        PyErr_SetString(PyExc_KeyError, "No sink with this cookie");
+        return NULL;
+    }
+    memmove(This->m_sinks + index, This->m_sinks + index + 1, (This->m_count - index - 1) * sizeof(ConnectionSink *));
+    This->m_count--;
+    StopSink(sink);
+    PY_INTERFACE_PRECALL;
+    ReleaseSink(sink);
+    PY_INTERFACE_POSTCALL;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod [(int, int), ...]|PyConnectionSinks|Fire|Fires an event to every sink.
+// @rdesc For a synchronous event, returns a list of (cookie, hresult) for each sink that failed.
+// For an asynchronous event, returns a list of (cookie, hresult) for each sink the event could not
+// be queued for - delivery failures are counted by <om PyConnectionSinks.GetStats>.
+PyObject *PyConnectionSinks::Fire(PyObject *self, PyObject *args)
+{
+    PyConnectionSinks *This = (PyConnectionSinks *)self;
+    DISPID dispid;
+    PyObject *obArgs = Py_None;
+    int bAsync = FALSE;
+    // @pyparm int|dispid||The dispid of the event method.
+    // @pyparm tuple|args|()|The arguments of the event.  Each is converted to a VARIANT once, and the
+    // same VARIANTs are passed to every sink, so the sinks must not change them.
+    // @pyparm bool|Async|False|If True, the event is queued for each sink's own thread, and Fire returns
+    // without waiting for any sink.
+    if (!PyArg_ParseTuple(args, "l|Oi:Fire", &dispid, &obArgs, &bAsync))
+        return NULL;
+    PyObject *obSeq = obArgs == Py_None ? PyTuple_New(0) : PySequence_Fast(obArgs, "args must be a sequence");
+    if (obSeq == NULL)
+        return NULL;
+    UINT cArgs = (UINT)PySequence_Fast_GET_SIZE(obSeq);
+    SinkEvent *ev = new SinkEvent;
+    ev->refs = 1;
+    ev->dispid = dispid;
+    ev->dispparams.cArgs = 0;
+    ev->dispparams.cNamedArgs = 0;
+    ev->dispparams.rgdispidNamedArgs = NULL;
+    ev->dispparams.rgvarg = cArgs ? new VARIANTARG[cArgs] : NULL;
+    // Arguments are passed in reverse order.
+    for (UINT i = 0; i < cArgs; i++) {
+        VARIANTARG *pv = &ev->dispparams.rgvarg[cArgs - 1 - i];
+        VariantInit(pv);
+        if (!PyCom_VariantFromPyObject(PySequence_Fast_GET_ITEM(obSeq, i), pv)) {
+            // Clear the ones converted so far.
+            for (UINT j = 0; j < i; j++) VariantClear(&ev->dispparams.rgvarg[cArgs - 1 - j]);
+            delete[] ev->dispparams.rgvarg;
+            delete ev;
+            Py_DECREF(obSeq);
+            return NULL;
+        }
+    }
+    ev->dispparams.cArgs = cArgs;
+    Py_DECREF(obSeq);
+
+    // Take a snapshot, so sinks can be added or removed while the Python lock is released.
+    ULONG count = This->m_count;
+    ConnectionSink **sinks = new ConnectionSink *[count ? count : 1];
+    HRESULT *results = new HRESULT[count ? count : 1];
+    for (ULONG i = 0; i < count; i++) {
+        sinks[i] = This->m_sinks[i];
+        InterlockedIncrement(&sinks[i]->refs);
+    }
+    ULONG maxPending = This->m_maxPending;
+    PY_INTERFACE_PRECALL;
+    for (ULONG i = 0; i < count; i++) {
+        ConnectionSink *sink = sinks[i];
+        if (!bAsync) {
+            IDispatch *pDisp = GetSinkDispatch(sink);
+            if (pDisp == NULL) {
+                results[i] = S_OK;
+                continue;
+            }
+            results[i] = InvokeSink(pDisp, ev);
+            pDisp->Release();
+            if (FAILED(results[i])) {
+                InterlockedIncrement(&sink->failures);
+                InterlockedExchange(&sink->lastError, results[i]);
+            }
+            continue;
+        }
+        EnterCriticalSection(&sink->cs);
+        results[i] = sink->bStarted ? S_OK : StartSinkThread(sink);
+        LeaveCriticalSection(&sink->cs);
+        if (results[i] == CONNECT_E_NOCONNECTION)
+            // Removed since the snapshot was taken.
+            results[i] = S_OK;
+        if (FAILED(results[i]))
+            continue;
+        if ((ULONG)sink->pending >= maxPending) {
+            InterlockedIncrement(&sink->dropped);
+            continue;
+        }
+        SinkQueueItem *item = new SinkQueueItem;
+        item->ev = ev;
+        item->next = NULL;
+        InterlockedIncrement(&ev->refs);
+        InterlockedIncrement(&sink->pending);
+        EnterCriticalSection(&sink->cs);
+        if (sink->tail)
+            sink->tail->next = item;
+        else
+            sink->head = item;
+        sink->tail = item;
+        LeaveCriticalSection(&sink->cs);
+        SetEvent(sink->hWake);
+    }
+    ReleaseSinkEvent(ev);
+    PY_INTERFACE_POSTCALL;
+
+    PyObject *ret = PyList_New(0);
+    for (ULONG i = 0; i < count; i++) {
+        if (ret && FAILED(results[i])) {
+            PyObject *item = Py_BuildValue("kl", sinks[i]->cookie, results[i]);
+            if (item == NULL || PyList_Append(ret, item) == -1)
+                Py_CLEAR(ret);
+            Py_XDECREF(item);
+        }
+    }
+    PY_INTERFACE_PRECALL;
+    for (ULONG i = 0; i < count; i++) ReleaseSink(sinks[i]);
+    PY_INTERFACE_POSTCALL;
+    delete[] sinks;
+    delete[] results;
+    return ret;
+}
+
+// @pymethod [(int, int, int, int, int), ...]|PyConnectionSinks|GetStats|Returns the delivery counters
+// for each sink.
+// @rdesc Returns a list of (cookie, pending, dropped, failures, lastError), where pending is the
+// number of asynchronous events queued, dropped the number discarded because the queue was full,
+// and failures the number of events the sink returned an error for.
+PyObject *PyConnectionSinks::GetStats(PyObject *self, PyObject *args)
+{
+    PyConnectionSinks *This = (PyConnectionSinks *)self;
+    if (!PyArg_ParseTuple(args, ":GetStats"))
+        return NULL;
+    PyObject *ret = PyList_New(This->m_count);
+    if (ret == NULL)
+        return NULL;
+    for (ULONG i = 0; i < This->m_count; i++) {
+        ConnectionSink *sink = This->m_sinks[i];
+        PyObject *item =
+            Py_BuildValue("kllll", sink->cookie, sink->pending, sink->dropped, sink->failures, sink->lastError);
+        if (item == NULL) {
+            Py_DECREF(ret);
+            return NULL;
+        }
+        PyList_SET_ITEM(ret, i, item);
+    }
+    return ret;
+}
+
+struct PyMethodDef PyConnectionSinks::methods[] = {
+    {"Add", PyConnectionSinks::Add, 1},            // @pymeth Add|Adds a sink, returning its cookie.
+    {"Remove", PyConnectionSinks::Remove, 1},      // @pymeth Remove|Removes a sink.
+    {"Fire", PyConnectionSinks::Fire, 1},          // @pymeth Fire|Fires an event to every sink.
+    {"GetStats", PyConnectionSinks::GetStats, 1},  // @pymeth GetStats|Returns the delivery counters for each sink.
+    {NULL}};
+
+PySequenceMethods PyConnectionSinks::sequence = {
+    PyConnectionSinks::sq_length, /* sq_length */
+};
+
+PyTypeObject PyConnectionSinks::Type = {
+    PYWIN_OBJECT_HEAD "PyConnectionSinks",
+    sizeof(PyConnectionSinks),
+    0,
+    PyConnectionSinks::tp_dealloc, /* tp_dealloc */
+    0,                             /* tp_print */
+    0,                             /* tp_getattr */
+    0,                             /* tp_setattr */
+    0,                             /* tp_compare */
+    0,                             /* tp_repr */
+    0,                             /* tp_as_number */
+    &PyConnectionSinks::sequence,  /* tp_as_sequence */
+    0,                             /* tp_as_mapping */
+    0,                             /* tp_hash */
+    0,                             /* tp_call */
+    0,                             /* tp_str */
+    PyObject_GenericGetAttr,       /* tp_getattro */
+    0,                             /* tp_setattro */
+    0,                             /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,            /* tp_flags */
+    0,                             /* tp_doc */
+    0,                             /* tp_traverse */
+    0,                             /* tp_clear */
+    0,                             /* tp_richcompare */
+    0,                             /* tp_weaklistoffset */
+    0,                             /* tp_iter */
+    0,                             /* tp_iternext */
+    PyConnectionSinks::methods,    /* tp_methods */
+};
+
+PyTypeObject *PyCom_ConnectionSinksType = &PyConnectionSinks::Type;
+
+// @pymethod <o PyConnectionSinks>|pythoncom|CreateConnectionSinks|Creates an empty native list of
+// connection point sinks.
+PyObject *pythoncom_CreateConnectionSinks(PyObject *self, PyObject *args)
+{
+    ULONG maxPending = 1000;
+    // @pyparm int|MaxPending|1000|The most asynchronous events to queue for any one sink.
+    if (!PyArg_ParseTuple(args, "|k:CreateConnectionSinks", &maxPending))
+        return NULL;
+    if (maxPending == 0) {
+        PyErr_SetString(PyExc_ValueError, "MaxPending must be at least 1");
+        return NULL;
+    }
+    if (GetGIT() == NULL)
+        return PyCom_BuildPyException(CO_E_NOTINITIALIZED);
+    return new PyConnectionSinks(maxPending);
+}
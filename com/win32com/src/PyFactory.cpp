@@ -93,6 +93,96 @@ STDMETHODIMP CPyFactory::LockServer(BOOL fLock)
     return S_OK;
 }
 
+// Instance pooling (see win32com.server.policy.GetPoolSize).  For each CLSID
+// created, we remember its pool size and the policies of the pooled instances
+// we have handed out.  Once the list holds the only reference to a policy,
+// every gateway to it has been released, and it can be reset and reused.
+// Only used with the Python lock held.
+struct PYCOM_FACTORY_CLASS {
+    CLSID clsid;
+    Py_ssize_t cMaxPool;  // 0 if the class is not pooled.
+    PyObject *obPool;     // list of policies
+};
+
+static PYCOM_FACTORY_CLASS *g_pFactoryClasses = NULL;
+static int g_cFactoryClasses = 0;
+
+static PYCOM_FACTORY_CLASS *GetFactoryClass(REFCLSID rclsid, PyObject *pPyModule, PyObject *obiid)
+{
+    int i;
+    for (i = 0; i < g_cFactoryClasses; i++)
+        if (IsEqualCLSID(g_pFactoryClasses[i].clsid, rclsid))
+            return &g_pFactoryClasses[i];
+    PYCOM_FACTORY_CLASS *pNew = (PYCOM_FACTORY_CLASS *)realloc(
+        g_pFactoryClasses, (g_cFactoryClasses + 1) * sizeof(PYCOM_FACTORY_CLASS));
+    if (!pNew)
+        return NULL;
+    g_pFactoryClasses = pNew;
+    PYCOM_FACTORY_CLASS *pClass = &g_pFactoryClasses[g_cFactoryClasses];
+    pClass->clsid = rclsid;
+    pClass->cMaxPool = 0;
+    pClass->obPool = NULL;
+    PyObject *obSize = PyObject_CallMethod(pPyModule, "GetPoolSize", "O", obiid);
+    if (obSize) {
+        pClass->cMaxPool = PyInt_AsSsize_t(obSize);
+        Py_DECREF(obSize);
+    }
+    if (pClass->cMaxPool > 0)
+        pClass->obPool = PyList_New(0);
+    if (!pClass->obPool)
+        pClass->cMaxPool = 0;
+    if (PyErr_Occurred()) {
+        // Not fatal - the class just isn't pooled.
+        PyCom_LoggerException(NULL, "ERROR: server.policy could not get the pool size of the object.");
+        PyErr_Clear();
+    }
+    g_cFactoryClasses++;
+    return pClass;
+}
+
+static PyObject *CreatePooledInstance(PYCOM_FACTORY_CLASS *pClass, PyObject *pPyModule, PyObject *obiid,
+                                      PyObject *obReqiid)
+{
+    Py_ssize_t i;
+    for (i = 0; i < PyList_GET_SIZE(pClass->obPool); i++) {
+        PyObject *policy = PyList_GET_ITEM(pClass->obPool, i);
+        if (Py_REFCNT(policy) != 1)
+            continue;  // still in use.
+        Py_INCREF(policy);
+        PyObject *ret = PyObject_CallMethod(pPyModule, "ResetPooledInstance", "OO", policy, obReqiid);
+        if (!ret) {
+            // Drop it - a new instance is created in its place.
+            PyCom_LoggerException(NULL, "ERROR: server.policy could not reset a pooled instance.");
+            PyErr_Clear();
+            // _Reset_ may have released the lock, so look for it again.
+            for (i = 0; i < PyList_GET_SIZE(pClass->obPool); i++)
+                if (PyList_GET_ITEM(pClass->obPool, i) == policy) {
+                    PySequence_DelItem(pClass->obPool, i);
+                    break;
+                }
+        }
+        Py_DECREF(policy);
+        if (ret)
+            return ret;
+        break;
+    }
+    if (PyList_GET_SIZE(pClass->obPool) >= pClass->cMaxPool)
+        // All in use - this one is created as if the class wasn't pooled.
+        return PyObject_CallMethod(pPyModule, "CreateInstance", "OO", obiid, obReqiid);
+
+    PyObject *result = PyObject_CallMethod(pPyModule, "CreatePooledInstance", "OO", obiid, obReqiid);
+    if (!result)
+        return NULL;
+    PyObject *ret = NULL, *policy;
+    if (PyArg_ParseTuple(result, "OO:CreatePooledInstance", &ret, &policy) &&
+        PyList_Append(pClass->obPool, policy) == 0)
+        Py_INCREF(ret);
+    else
+        ret = NULL;
+    Py_DECREF(result);
+    return ret;
+}
+
 // NOTE NOTE: CreateNewPythonInstance assumes that you have the Python thread lock
 // already acquired.
 STDMETHODIMP CPyFactory::CreateNewPythonInstance(REFCLSID rclsid, REFCLSID rReqiid, PyObject **ppNewInstance)
@@ -119,7 +209,11 @@ STDMETHODIMP CPyFactory::CreateNewPythonInstance(REFCLSID rclsid, REFCLSID rReqi
         return E_OUTOFMEMORY;
     }
 
-    *ppNewInstance = PyObject_CallMethod(pPyModule, "CreateInstance", "OO", obiid, obReqiid);
+    PYCOM_FACTORY_CLASS *pClass = GetFactoryClass(rclsid, pPyModule, obiid);
+    if (pClass && pClass->cMaxPool)
+        *ppNewInstance = CreatePooledInstance(pClass, pPyModule, obiid, obReqiid);
+    else
+        *ppNewInstance = PyObject_CallMethod(pPyModule, "CreateInstance", "OO", obiid, obReqiid);
     // Check the error state before DECREFs, otherwise they may
     // change the error state.
     if (!*ppNewInstance)
@@ -160,4 +254,8 @@ void FreeGatewayModule(void)
             g_pPyModule = NULL;
         }
     *****/
+    for (int i = 0; i < g_cFactoryClasses; i++) Py_XDECREF(g_pFactoryClasses[i].obPool);
+    free(g_pFactoryClasses);
+    g_pFactoryClasses = NULL;
+    g_cFactoryClasses = 0;
 }
@@ -6,6 +6,8 @@
 #include "PyFactory.h"
 
 #include "PythonCOMServer.h"
+#include "PyComCallStats.h"
+#include "PyComObjectStats.h"
 
 // {25D29CD0-9B98-11d0-AE79-4CF1CF000000}
 extern const GUID IID_IInternalUnwrapPythonObject = {
@@ -87,6 +89,13 @@ PyGatewayBase::PyGatewayBase(PyObject *instance)
 {
     InterlockedIncrement(&cGateways);
     m_pBaseObject = NULL;
+    m_pNameCache = NULL;
+    m_obInvoke = NULL;
+    m_obDirectCallables = NULL;
+    m_bInvokeCached = FALSE;
+    m_obCallStatsName = NULL;
+    // Charged by PyCom_MakeRegisteredGatewayObject, once the IID is known.
+    m_pObjectStats = NULL;
     m_cRef = 1;
     m_pPyObject = instance;
     Py_XINCREF(instance);  // instance should never be NULL - but whats an X between friends!
@@ -101,6 +110,8 @@ PyGatewayBase::PyGatewayBase(PyObject *instance)
 PyGatewayBase::~PyGatewayBase()
 {
     InterlockedDecrement(&cGateways);
+    if (m_pObjectStats)
+        PyCom_ObjectStatsDestroyed(m_pObjectStats);
 #ifdef DEBUG_FULL
     PyCom_LogF("PyGatewayBase: deleted %s", m_pPyObject ? m_pPyObject->ob_type->tp_name : "<NULL>");
 #endif
@@ -108,12 +119,16 @@ PyGatewayBase::~PyGatewayBase()
     if (m_pPyObject) {
         {
             CEnterLeavePython celp;
+            Py_XDECREF(m_obInvoke);
+            Py_XDECREF(m_obDirectCallables);
+            Py_XDECREF(m_obCallStatsName);
             Py_DECREF(m_pPyObject);
         }
     }
     if (m_pBaseObject) {
         m_pBaseObject->Release();
     }
+    NameCacheFree(m_pNameCache);
     PyCom_DLLReleaseRef();
 }
 
@@ -260,6 +275,211 @@ STDMETHODIMP PyGatewayBase::GetTypeInfo(UINT itinfo, LCID lcid, ITypeInfo FAR *F
     return hr;
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// GetIDsOfNames name cache
+//
+// Late-bound clients (VBScript, JScript, ASP) call GetIDsOfNames before
+// nearly every Invoke.  The policy resolves the name in Python each time,
+// so we remember the DISPID of each name the policy has successfully
+// resolved.  Once a name is in the cache, a repeat lookup touches neither
+// the policy nor the GIL - it is kept in sync by a critical section.
+//
+// Only single-name lookups are cached (names after the first are argument
+// names, and the standard policies reject them anyway).  Names are compared
+// ignoring case, with only ASCII letters folded - names differing in the
+// case of other characters simply get separate entries.  The LCID is
+// ignored, as it is by the policies themselves.  Names which fail to
+// resolve are never cached.
+//
+// pythoncom.InvalidateDispIDCache() discards entries if the names a Python
+// object supports change after they have been looked up.
+#define NAMECACHE_INITIAL_SIZE 16
+#define NAMECACHE_MAX_ENTRIES 1024
+
+struct PyGatewayNameCacheEntry {
+    ULONG hash;
+    DISPID dispid;
+    WCHAR *name;  // NULL for an empty slot.
+};
+
+struct PyGatewayNameCache {
+    CRITICAL_SECTION cs;
+    LONG generation;
+    UINT numEntries;
+    UINT tableSize;  // always a power of 2.
+    PyGatewayNameCacheEntry *entries;
+};
+
+// Bumped to invalidate every cache at once.
+static volatile LONG g_nameCacheGeneration = 0;
+
+static inline WCHAR NameCacheFoldChar(WCHAR c) { return (c >= L'A' && c <= L'Z') ? (WCHAR)(c + (L'a' - L'A')) : c; }
+
+static ULONG NameCacheHash(const OLECHAR *name)
+{
+    // FNV-1a, over the folded characters.
+    ULONG hash = 2166136261u;
+    for (; *name; name++) {
+        hash ^= NameCacheFoldChar(*name);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static BOOL NameCacheNamesEqual(const WCHAR *a, const OLECHAR *b)
+{
+    for (; *a && *b; a++, b++)
+        if (NameCacheFoldChar(*a) != NameCacheFoldChar(*b))
+            return FALSE;
+    return *a == *b;
+}
+
+// Both of these must be called with the cache's critical section held.
+static void NameCacheEmpty(PyGatewayNameCache *cache)
+{
+    for (UINT i = 0; i < cache->tableSize; i++) {
+        delete[] cache->entries[i].name;
+        cache->entries[i].name = NULL;
+    }
+    cache->numEntries = 0;
+}
+
+static PyGatewayNameCacheEntry *NameCacheFindSlot(PyGatewayNameCacheEntry *entries, UINT tableSize, ULONG hash,
+                                                  const OLECHAR *name)
+{
+    // Linear probing - the table is never allowed to fill, so this terminates.
+    UINT mask = tableSize - 1;
+    for (UINT i = hash & mask;; i = (i + 1) & mask) {
+        PyGatewayNameCacheEntry *entry = entries + i;
+        if (entry->name == NULL || (entry->hash == hash && NameCacheNamesEqual(entry->name, name)))
+            return entry;
+    }
+}
+
+static PyGatewayNameCache *NameCacheNew(void)
+{
+    PyGatewayNameCache *cache = new PyGatewayNameCache;
+    if (cache == NULL)
+        return NULL;
+    cache->entries = new PyGatewayNameCacheEntry[NAMECACHE_INITIAL_SIZE];
+    if (cache->entries == NULL) {
+        delete cache;
+        return NULL;
+    }
+    memset(cache->entries, 0, sizeof(PyGatewayNameCacheEntry) * NAMECACHE_INITIAL_SIZE);
+    cache->tableSize = NAMECACHE_INITIAL_SIZE;
+    cache->numEntries = 0;
+    cache->generation = g_nameCacheGeneration;
+    InitializeCriticalSection(&cache->cs);
+    return cache;
+}
+
+static void NameCacheFree(PyGatewayNameCache *cache)
+{
+    if (cache == NULL)
+        return;
+    NameCacheEmpty(cache);
+    delete[] cache->entries;
+    DeleteCriticalSection(&cache->cs);
+    delete cache;
+}
+
+static BOOL NameCacheLookup(PyGatewayNameCache *cache, const OLECHAR *name, DISPID *pdispid)
+{
+    BOOL found = FALSE;
+    ULONG hash = NameCacheHash(name);
+    EnterCriticalSection(&cache->cs);
+    if (cache->generation != g_nameCacheGeneration) {
+        NameCacheEmpty(cache);
+        cache->generation = g_nameCacheGeneration;
+    }
+    else if (cache->numEntries) {
+        PyGatewayNameCacheEntry *entry = NameCacheFindSlot(cache->entries, cache->tableSize, hash, name);
+        if (entry->name != NULL) {
+            *pdispid = entry->dispid;
+            found = TRUE;
+        }
+    }
+    LeaveCriticalSection(&cache->cs);
+    return found;
+}
+
+// generation is the value of g_nameCacheGeneration before the policy was
+// asked - if it has changed since, the result may already be stale.
+static void NameCacheInsert(PyGatewayNameCache *cache, const OLECHAR *name, DISPID dispid, LONG generation)
+{
+    ULONG hash = NameCacheHash(name);
+    EnterCriticalSection(&cache->cs);
+    if (cache->generation != generation || generation != g_nameCacheGeneration ||
+        cache->numEntries >= NAMECACHE_MAX_ENTRIES)
+        goto done;
+    // Grow at 3/4 full.
+    if ((cache->numEntries + 1) * 4 > cache->tableSize * 3) {
+        UINT newSize = cache->tableSize * 2;
+        PyGatewayNameCacheEntry *newEntries = new PyGatewayNameCacheEntry[newSize];
+        if (newEntries == NULL)
+            goto done;
+        memset(newEntries, 0, sizeof(PyGatewayNameCacheEntry) * newSize);
+        for (UINT i = 0; i < cache->tableSize; i++) {
+            PyGatewayNameCacheEntry *old = cache->entries + i;
+            if (old->name != NULL)
+                *NameCacheFindSlot(newEntries, newSize, old->hash, old->name) = *old;
+        }
+        delete[] cache->entries;
+        cache->entries = newEntries;
+        cache->tableSize = newSize;
+    }
+    {
+        PyGatewayNameCacheEntry *entry = NameCacheFindSlot(cache->entries, cache->tableSize, hash, name);
+        if (entry->name == NULL) {
+            size_t len = wcslen(name);
+            entry->name = new WCHAR[len + 1];
+            if (entry->name == NULL)
+                goto done;
+            memcpy(entry->name, name, (len + 1) * sizeof(WCHAR));
+            entry->hash = hash;
+            cache->numEntries++;
+        }
+        entry->dispid = dispid;
+    }
+done:
+    LeaveCriticalSection(&cache->cs);
+}
+
+// All gateways made for a Python object (via QueryInterface) hang off the
+// first one, so they share its name cache.
+PyGatewayBase *PyGatewayBase::GetNameCacheOwner(void)
+{
+    PyGatewayBase *owner = this;
+    while (owner->m_pBaseObject != NULL && owner->m_pBaseObject->m_pPyObject == m_pPyObject)
+        owner = owner->m_pBaseObject;
+    return owner;
+}
+
+void PyGatewayBase::ClearNameCache(void)
+{
+    PyGatewayNameCache *cache = GetNameCacheOwner()->m_pNameCache;
+    if (cache == NULL)
+        return;
+    EnterCriticalSection(&cache->cs);
+    NameCacheEmpty(cache);
+    LeaveCriticalSection(&cache->cs);
+}
+
+void PyCom_InvalidateGatewayNameCache(IUnknown *pUnk)
+{
+    if (pUnk == NULL) {
+        InterlockedIncrement(&g_nameCacheGeneration);
+        return;
+    }
+    IInternalUnwrapPythonObject *pUnwrap = NULL;
+    if (pUnk->QueryInterface(IID_IInternalUnwrapPythonObject, (void **)&pUnwrap) != S_OK || pUnwrap == NULL)
+        return;  // Not one of ours - nothing to do.
+    // Only PyGatewayBase implements this interface.
+    ((PyGatewayBase *)pUnwrap)->ClearNameCache();
+    pUnwrap->Release();
+}
+
 static HRESULT getids_setup(UINT cNames, OLECHAR FAR *FAR *rgszNames, LCID lcid, PyObject **pPyArgList,
                             PyObject **pPyLCID)
 {
@@ -346,6 +566,14 @@ STDMETHODIMP PyGatewayBase::GetIDsOfNames(REFIID refiid, OLECHAR FAR *FAR *rgszN
     PyObject *argList;
     PyObject *py_lcid;
 
+    // A hit in the name cache is answered without the GIL.
+    PyGatewayBase *cacheOwner = GetNameCacheOwner();
+    BOOL bCacheable = cNames == 1 && rgszNames != NULL && rgszNames[0] != NULL && rgdispid != NULL;
+    if (bCacheable && cacheOwner->m_pNameCache != NULL &&
+        NameCacheLookup(cacheOwner->m_pNameCache, rgszNames[0], rgdispid))
+        return S_OK;
+    LONG generation = g_nameCacheGeneration;
+
     PY_GATEWAY_METHOD;
     hr = getids_setup(cNames, rgszNames, lcid, &argList, &py_lcid);
     if (SUCCEEDED(hr)) {
@@ -355,10 +583,63 @@ STDMETHODIMP PyGatewayBase::GetIDsOfNames(REFIID refiid, OLECHAR FAR *FAR *rgszN
 
         hr = getids_finish(result, cNames, rgdispid);
     }
+    if (hr == S_OK && bCacheable) {
+        if (cacheOwner->m_pNameCache == NULL) {
+            PyGatewayNameCache *cache = NameCacheNew();
+            // Another thread may have beaten us to it.
+            if (cache != NULL && InterlockedCompareExchangePointer((PVOID *)&cacheOwner->m_pNameCache, cache,
+                                                                   NULL) != NULL)
+                NameCacheFree(cache);
+        }
+        if (cacheOwner->m_pNameCache != NULL)
+            NameCacheInsert(cacheOwner->m_pNameCache, rgszNames[0], rgdispid[0], generation);
+    }
     return hr;
 }
 
-static HRESULT invoke_setup(DISPPARAMS FAR *params, LCID lcid, PyObject **pPyArgList, PyObject **pPyLCID)
+// The args passed to Invoke, with the COM work of converting them to Python
+// (see PyCom_PrepareVariantForPython) done before the gateway takes the
+// Python lock.  Declare it before PY_GATEWAY_METHOD, so the copies are also
+// cleared after the lock has been released.
+#define PREPARED_STACK_ARGS 8
+
+class CPreparedInvokeArgs {
+   public:
+    CPreparedInvokeArgs(DISPPARAMS *params) : m_cArgs(params ? params->cArgs : 0)
+    {
+        m_pvars = m_cArgs <= PREPARED_STACK_ARGS ? m_vars : new VARIANT[m_cArgs];
+        m_pbPrepared = m_cArgs <= PREPARED_STACK_ARGS ? m_bPrepared : new BOOL[m_cArgs];
+        for (UINT i = 0; i < m_cArgs; i++)
+            m_pbPrepared[i] = PyCom_PrepareVariantForPython(params->rgvarg + i, m_pvars + i);
+    }
+    ~CPreparedInvokeArgs()
+    {
+        for (UINT i = 0; i < m_cArgs; i++)
+            if (m_pbPrepared[i])
+                VariantClear(m_pvars + i);
+        if (m_pvars != m_vars)
+            delete[] m_pvars;
+        if (m_pbPrepared != m_bPrepared)
+            delete[] m_pbPrepared;
+    }
+    // Must hold the Python lock.
+    PyObject *GetPyObject(DISPPARAMS *params, UINT i)
+    {
+        if (i < m_cArgs && m_pbPrepared[i])
+            return PyCom_PyObjectFromPreparedVariant(m_pvars + i);
+        return PyCom_PyObjectFromVariant(params->rgvarg + i);
+    }
+
+   private:
+    UINT m_cArgs;
+    VARIANT *m_pvars;
+    BOOL *m_pbPrepared;
+    VARIANT m_vars[PREPARED_STACK_ARGS];
+    BOOL m_bPrepared[PREPARED_STACK_ARGS];
+};
+
+static HRESULT invoke_setup(DISPPARAMS FAR *params, LCID lcid, CPreparedInvokeArgs &prepared, PyObject **pPyArgList,
+                            PyObject **pPyLCID)
 {
     HRESULT hr = S_OK;
     PyObject *py_lcid = NULL;
@@ -394,7 +675,7 @@ static HRESULT invoke_setup(DISPPARAMS FAR *params, LCID lcid, PyObject **pPyArg
 
     // Fill the positional args - they start at the end.
     for (i = params->cArgs; i != numNamedArgs; --i) {
-        PyObject *ob = PyCom_PyObjectFromVariant(params->rgvarg + i - 1);
+        PyObject *ob = prepared.GetPyObject(params, i - 1);
         if (!ob) {
             hr = E_OUTOFMEMORY;
             goto failed;
@@ -410,7 +691,7 @@ static HRESULT invoke_setup(DISPPARAMS FAR *params, LCID lcid, PyObject **pPyArg
     for (i = 0; i < numNamedArgs; i++) {
         UINT ndx = params->rgdispidNamedArgs[i];
         assert(PyTuple_GET_ITEM(argList, ndx) == NULL);  // must not have seen it before
-        PyObject *ob = PyCom_PyObjectFromVariant(params->rgvarg + i);
+        PyObject *ob = prepared.GetPyObject(params, i);
         if (!ob) {
             hr = E_OUTOFMEMORY;
             goto failed;
@@ -666,6 +947,59 @@ done:
     return hr;
 }
 
+// Fetch the policy's _Invoke_ method once, rather than looking it up by
+// name on every call.  A policy may also provide a _dispid_to_callable_
+// dictionary, mapping the DISPID of a method to a callable which we invoke
+// directly with the positional args, bypassing _Invoke_ altogether.  The
+// dictionary is referenced rather than copied, so a policy can update it
+// at any time.  Must be called with the GIL held.
+BOOL PyGatewayBase::CacheInvokeCallables(void)
+{
+    if (m_bInvokeCached)
+        return TRUE;
+    PyObject *obInvoke = PyObject_GetAttrString(m_pPyObject, "_Invoke_");
+    if (obInvoke == NULL)
+        return FALSE;
+    PyObject *obCallables = PyObject_GetAttrString(m_pPyObject, "_dispid_to_callable_");
+    if (obCallables == NULL)
+        PyErr_Clear();
+    else if (!PyDict_Check(obCallables)) {
+        // Not something we understand - always use _Invoke_.
+        Py_DECREF(obCallables);
+        obCallables = NULL;
+    }
+    // Python code run by the lookups may have let another thread in first.
+    if (m_bInvokeCached) {
+        Py_DECREF(obInvoke);
+        Py_XDECREF(obCallables);
+        return TRUE;
+    }
+    m_obInvoke = obInvoke;
+    m_obDirectCallables = obCallables;
+    m_bInvokeCached = TRUE;
+    return TRUE;
+}
+
+// Calls are recorded under the type name of the object the policy wraps,
+// or of the policy itself if it doesn't wrap one.
+PyObject *PyGatewayBase::GetCallStatsName(void)
+{
+    if (m_obCallStatsName == NULL) {
+        PyObject *exc_typ, *exc_val, *exc_tb;
+        PyErr_Fetch(&exc_typ, &exc_val, &exc_tb);
+        PyObject *obWrapped = PyObject_GetAttrString(m_pPyObject, "_obj_");
+        if (obWrapped == NULL)
+            PyErr_Clear();
+        PyObject *ob = (obWrapped && obWrapped != Py_None) ? obWrapped : m_pPyObject;
+        m_obCallStatsName = PyString_FromString(ob->ob_type->tp_name);
+        if (m_obCallStatsName == NULL)
+            PyErr_Clear();
+        Py_XDECREF(obWrapped);
+        PyErr_Restore(exc_typ, exc_val, exc_tb);
+    }
+    return m_obCallStatsName;
+}
+
 STDMETHODIMP PyGatewayBase::Invoke(DISPID dispid, REFIID riid, LCID lcid, WORD wFlags, DISPPARAMS FAR *params,
                                    VARIANT FAR *pVarResult, EXCEPINFO FAR *pexcepinfo, UINT FAR *puArgErr)
 {
@@ -678,21 +1012,63 @@ STDMETHODIMP PyGatewayBase::Invoke(DISPID dispid, REFIID riid, LCID lcid, WORD w
     if (pVarResult)
         V_VT(pVarResult) = VT_EMPTY;
 
+    CPyComCallTimer timer;
+    CPreparedInvokeArgs prepared(params);
+    timer.EndPhase(PYCOM_PHASE_MARSHAL);
     PY_GATEWAY_METHOD;
+    timer.EndPhase(PYCOM_PHASE_LOCK);
+    if (!CacheInvokeCallables())
+        return GetIDispatchErrorResult(m_pPyObject, pexcepinfo);
+    PyObject *obDispid = PyInt_FromLong(dispid);
+    if (obDispid == NULL) {
+        PyErr_Clear();
+        return E_OUTOFMEMORY;
+    }
+    // A method call with a DISPID the policy registered a callable for
+    // goes directly to that callable, which returns only the user result.
+    PyObject *obDirect = NULL;
+    if (m_obDirectCallables != NULL && (wFlags & DISPATCH_METHOD)) {
+        obDirect = PyDict_GetItem(m_obDirectCallables, obDispid);
+        Py_XINCREF(obDirect);
+    }
     PyObject *argList;
     PyObject *py_lcid;
-    hr = invoke_setup(params, lcid, &argList, &py_lcid);
+    hr = invoke_setup(params, lcid, prepared, &argList, &py_lcid);
+    timer.EndPhase(PYCOM_PHASE_MARSHAL);
     if (SUCCEEDED(hr)) {
-        PyObject *result = PyObject_CallMethod(m_pPyObject, "_Invoke_", "iOiO", dispid, py_lcid, wFlags, argList);
+        PyObject *result;
+        if (obDirect != NULL)
+            result = PyObject_Call(obDirect, argList, NULL);
+        else {
+            PyObject *obFlags = PyInt_FromLong(wFlags);
+            if (obFlags == NULL)
+                result = NULL;
+            else {
+#if (PY_VERSION_HEX >= 0x03090000)
+                PyObject *callArgs[4] = {obDispid, py_lcid, obFlags, argList};
+                result = PyObject_Vectorcall(m_obInvoke, callArgs, 4, NULL);
+#else
+                result = PyObject_CallFunctionObjArgs(m_obInvoke, obDispid, py_lcid, obFlags, argList, NULL);
+#endif
+                Py_DECREF(obFlags);
+            }
+        }
+        timer.EndPhase(PYCOM_PHASE_CALL);
 
         Py_DECREF(argList);
         Py_DECREF(py_lcid);
 
         if (result == NULL)
-            return GetIDispatchErrorResult(m_pPyObject, pexcepinfo);
+            hr = GetIDispatchErrorResult(m_pPyObject, pexcepinfo);
         else
-            hr = invoke_finish(m_pPyObject, result, pVarResult, puArgErr, pexcepinfo, IID_IDispatch, params, true);
+            hr = invoke_finish(m_pPyObject, result, pVarResult, puArgErr, pexcepinfo, IID_IDispatch, params,
+                               obDirect == NULL);
+        timer.EndPhase(PYCOM_PHASE_UNMARSHAL);
     }
+    Py_XDECREF(obDirect);
+    Py_DECREF(obDispid);
+    if (timer.IsActive())
+        timer.Record(TRUE, GetCallStatsName(), dispid, FAILED(hr));
     return hr;
 }
 
@@ -736,17 +1112,23 @@ STDMETHODIMP PyGatewayBase::InvokeEx(DISPID id, LCID lcid, WORD wFlags, DISPPARA
     if (pVarResult)
         V_VT(pVarResult) = VT_EMPTY;
 
+    CPyComCallTimer timer;
+    CPreparedInvokeArgs prepared(params);
+    timer.EndPhase(PYCOM_PHASE_MARSHAL);
     PY_GATEWAY_METHOD;
+    timer.EndPhase(PYCOM_PHASE_LOCK);
     PyObject *obISP = PyCom_PyObjectFromIUnknown(pspCaller, IID_IServiceProvider, TRUE);
     if (obISP == NULL)
         return GetIDispatchErrorResult(m_pPyObject, pexcepinfo);
 
     PyObject *argList;
     PyObject *py_lcid;
-    hr = invoke_setup(params, lcid, &argList, &py_lcid);
+    hr = invoke_setup(params, lcid, prepared, &argList, &py_lcid);
+    timer.EndPhase(PYCOM_PHASE_MARSHAL);
     if (SUCCEEDED(hr)) {
         PyObject *result =
             PyObject_CallMethod(m_pPyObject, "_InvokeEx_", "iOiOOO", id, py_lcid, wFlags, argList, Py_None, obISP);
+        timer.EndPhase(PYCOM_PHASE_CALL);
 
         Py_DECREF(argList);
         Py_DECREF(py_lcid);
@@ -756,8 +1138,11 @@ STDMETHODIMP PyGatewayBase::InvokeEx(DISPID id, LCID lcid, WORD wFlags, DISPPARA
         else {
             hr = invoke_finish(m_pPyObject, result, pVarResult, NULL, pexcepinfo, IID_IDispatchEx, params, false);
         }
+        timer.EndPhase(PYCOM_PHASE_UNMARSHAL);
     }
     Py_DECREF(obISP);
+    if (timer.IsActive())
+        timer.Record(TRUE, GetCallStatsName(), id, FAILED(hr));
     return hr;
 }
 
@@ -13,6 +13,43 @@ PyIBase::PyIBase() {
 
 PyIBase::~PyIBase() {}
 
+// Freelists of interface objects in 8 byte size classes - code walking an
+// object model creates and destroys wrappers at a great rate.  Objects are
+// only ever created and destroyed with the Python lock held.
+#define PYIBASE_FREELIST_CLASSES 16  // so objects up to 128 bytes
+#define PYIBASE_FREELIST_MAX 128     // objects kept for each size
+static void *g_freelists[PYIBASE_FREELIST_CLASSES];
+static int g_freelistCounts[PYIBASE_FREELIST_CLASSES];
+
+/*static*/ void *PyIBase::operator new(size_t size)
+{
+    size_t sizeClass = (size + 7) / 8 - 1;
+    if (sizeClass >= PYIBASE_FREELIST_CLASSES)
+        return ::operator new(size);
+    void *ret = g_freelists[sizeClass];
+    if (ret != NULL) {
+        g_freelists[sizeClass] = *(void **)ret;
+        g_freelistCounts[sizeClass]--;
+        return ret;
+    }
+    // Allocate the whole size class, so the block can be reused for any object in it.
+    return ::operator new((sizeClass + 1) * 8);
+}
+
+/*static*/ void PyIBase::operator delete(void *p, size_t size)
+{
+    size_t sizeClass = (size + 7) / 8 - 1;
+    if (p == NULL)
+        return;
+    if (sizeClass >= PYIBASE_FREELIST_CLASSES || g_freelistCounts[sizeClass] >= PYIBASE_FREELIST_MAX) {
+        ::operator delete(p);
+        return;
+    }
+    *(void **)p = g_freelists[sizeClass];
+    g_freelists[sizeClass] = p;
+    g_freelistCounts[sizeClass]++;
+}
+
 /*static*/ BOOL PyIBase::is_object(PyObject *ob, PyComTypeObject *which)
 {
     return PyObject_IsInstance(ob, (PyObject *)which);
@@ -20,8 +57,14 @@ PyIBase::~PyIBase() {}
 
 BOOL PyIBase::is_object(PyComTypeObject *which) { return is_object(this, which); }
 
+extern int PyWinType_Ready(PyTypeObject *pT);
+
 /*static*/ PyObject *PyIBase::getattro(PyObject *self, PyObject *name)
 {
+    // Interface types are only readied when their interface is first looked
+    // up, but objects can be created directly before that.
+    if (!(self->ob_type->tp_flags & Py_TPFLAGS_READY) && PyWinType_Ready(self->ob_type) == -1)
+        return NULL;
     // Using PyObject_GenericGetAttr allows some special type magic
     // (ie,
     return PyObject_GenericGetAttr(self, name);
@@ -3,6 +3,7 @@
 // @doc
 #include "stdafx.h"
 #include "PythonCOM.h"
+#include "PyComCallStats.h"
 
 // Check if IDispatch implementation transports via IErrorInfo instead of
 // EXCEPINFO
@@ -93,9 +94,46 @@ static BOOL HandledDispatchFailure(HRESULT hr, EXCEPINFO *einfo, UINT nArgErr, U
     return FALSE;
 }
 
-PyIDispatch::PyIDispatch(IUnknown *pDisp) : PyIUnknown(pDisp) { ob_type = &type; }
+PyIDispatch::PyIDispatch(IUnknown *pDisp) : PyIUnknown(pDisp)
+{
+    ob_type = &type;
+    m_callPlans = NULL;
+    m_obCallStatsName = NULL;
+}
 
-PyIDispatch::~PyIDispatch() {}
+PyIDispatch::~PyIDispatch()
+{
+    PyDispatchCallPlan_FreeCache(m_callPlans);
+    Py_XDECREF(m_obCallStatsName);
+}
+
+// The name call statistics for this object are recorded under - the name of
+// its type information, fetched the first time a call is recorded.  Any
+// exception already set for the call being recorded is preserved.
+static PyObject *GetCallStatsName(PyObject *self, IDispatch *pDisp)
+{
+    PyIDispatch *pyDisp = (PyIDispatch *)self;
+    if (pyDisp->m_obCallStatsName == NULL) {
+        PyObject *exc_typ, *exc_val, *exc_tb;
+        PyErr_Fetch(&exc_typ, &exc_val, &exc_tb);
+        BSTR name = NULL;
+        ITypeInfo *pti = NULL;
+        {
+            PY_INTERFACE_PRECALL;
+            if (pDisp->GetTypeInfo(0, LOCALE_USER_DEFAULT, &pti) == S_OK && pti) {
+                pti->GetDocumentation(MEMBERID_NIL, &name, NULL, NULL, NULL);
+                pti->Release();
+            }
+            PY_INTERFACE_POSTCALL;
+        }
+        pyDisp->m_obCallStatsName =
+            name ? PyWinObject_FromBstr(name, /*takeOwnership*/ TRUE) : PyString_FromString("IDispatch");
+        if (pyDisp->m_obCallStatsName == NULL)
+            PyErr_Clear();
+        PyErr_Restore(exc_typ, exc_val, exc_tb);
+    }
+    return pyDisp->m_obCallStatsName;
+}
 
 /*static*/ IDispatch *PyIDispatch::GetI(PyObject *self) { return (IDispatch *)PyIUnknown::GetI(self); }
 
@@ -291,10 +329,12 @@ PyObject *PyIDispatch::Invoke(PyObject *self, PyObject *args)
     if (pMyDispatch == NULL)
         return NULL;
 
+    CPyComCallTimer timer;
     DISPPARAMS dispparams;
     PythonOleArgHelper *helpers;
     if (!PyCom_MakeUntypedDISPPARAMS(args, argc - 4, wFlags, &dispparams, &helpers))
         return NULL;
+    timer.EndPhase(PYCOM_PHASE_MARSHAL);
 
     VARIANT varResult;
     VARIANT *pVarResultUse;
@@ -312,28 +352,144 @@ PyObject *PyIDispatch::Invoke(PyObject *self, PyObject *args)
     UINT nArgErr = (UINT)-1;  // initialize to invalid arg
     PY_INTERFACE_PRECALL;
     HRESULT hr = pMyDispatch->Invoke(dispid, IID_NULL, lcid, wFlags, &dispparams, pVarResultUse, &excepInfo, &nArgErr);
+    timer.EndPhase(PYCOM_PHASE_CALL);
     PY_INTERFACE_POSTCALL;
+    timer.EndPhase(PYCOM_PHASE_LOCK);
 
     if (!PyCom_FinishUntypedDISPPARAMS(&dispparams, helpers) ||
         HandledDispatchFailure(hr, &excepInfo, nArgErr, dispparams.cArgs, pMyDispatch)) {
         if (pVarResultUse)
             VariantClear(pVarResultUse);
+        if (timer.IsActive()) {
+            timer.EndPhase(PYCOM_PHASE_UNMARSHAL);
+            timer.Record(FALSE, GetCallStatsName(self, pMyDispatch), dispid, TRUE);
+        }
         return NULL;
     }
     // @rdesc If the bResultWanted parameter is False, then the result will be None.
     // Otherwise, the result is determined by the COM object itself (and may still be None)
     PyObject *result;
     if (pVarResultUse) {
-        result = PyCom_PyObjectFromVariant(pVarResultUse);
+        result = PyCom_PyObjectFromOwnedVariant(pVarResultUse);
         VariantClear(pVarResultUse);
     }
     else {
         result = Py_None;
         Py_INCREF(result);
     }
+    if (timer.IsActive()) {
+        timer.EndPhase(PYCOM_PHASE_UNMARSHAL);
+        timer.Record(FALSE, GetCallStatsName(self, pMyDispatch), dispid, result == NULL);
+    }
     return result;
 }
 
+///////////////////////////////////////////////////////////////////
+//
+// InvokeTypes call plans.
+//
+// makepy generated code passes the same (literal) type description tuples
+// to InvokeTypes on every call, so rather than re-parsing them each time
+// we parse them once and remember the result, keyed on the dispid and the
+// identity of the tuples.  The plan holds references to the tuples, so
+// their identity can't be reused while the plan is alive.  The cache is a
+// small direct-mapped table hung off the PyIDispatch object, and all access
+// to it (including the plan reference counts) happens with the GIL held.
+#define CALLPLAN_CACHE_SIZE 32  // must be a power of 2
+#define CALLPLAN_STACK_ARGS 8   // calls with this many args or less don't use the heap
+
+struct PyDispatchCallPlan {
+    long refCount;
+    DISPID dispid;
+    PyObject *obResultDesc;
+    PyObject *obArgDescs;
+    VARTYPE resultType;
+    UINT numArgTypes;
+    VARTYPE *argTypes;
+    BOOL *argIsOut;
+};
+
+static void PyDispatchCallPlan_Release(PyDispatchCallPlan *plan)
+{
+    if (--plan->refCount == 0) {
+        Py_DECREF(plan->obResultDesc);
+        Py_DECREF(plan->obArgDescs);
+        delete[] plan->argTypes;
+        delete[] plan->argIsOut;
+        delete plan;
+    }
+}
+
+static void PyDispatchCallPlan_FreeCache(PyDispatchCallPlan **plans)
+{
+    if (plans == NULL)
+        return;
+    for (UINT i = 0; i < CALLPLAN_CACHE_SIZE; i++)
+        if (plans[i])
+            PyDispatchCallPlan_Release(plans[i]);
+    delete[] plans;
+}
+
+// Returns a new reference to the plan for the given type descriptions,
+// building (and caching) it if necessary.
+static PyDispatchCallPlan *PyDispatchCallPlan_Get(PyIDispatch *pyDisp, DISPID dispid, PyObject *obResultDesc,
+                                                  PyObject *obArgDescs)
+{
+    if (pyDisp->m_callPlans == NULL) {
+        pyDisp->m_callPlans = new PyDispatchCallPlan *[CALLPLAN_CACHE_SIZE];
+        memset(pyDisp->m_callPlans, 0, sizeof(PyDispatchCallPlan *) * CALLPLAN_CACHE_SIZE);
+    }
+    UINT slot = ((UINT)dispid ^ (UINT)((size_t)obArgDescs >> 4)) & (CALLPLAN_CACHE_SIZE - 1);
+    PyDispatchCallPlan *plan = pyDisp->m_callPlans[slot];
+    if (plan && plan->dispid == dispid && plan->obResultDesc == obResultDesc && plan->obArgDescs == obArgDescs) {
+        plan->refCount++;
+        return plan;
+    }
+
+    // Not cached - parse the type information.
+    PythonOleArgHelper resultHelper;
+    if (!resultHelper.ParseTypeInformation(obResultDesc)) {
+        PyCom_BuildInternalPyException("The return type information could not be parsed");
+        return NULL;
+    }
+    UINT numArgTypes = (UINT)PyTuple_GET_SIZE(obArgDescs);
+    VARTYPE *argTypes = NULL;
+    BOOL *argIsOut = NULL;
+    if (numArgTypes) {
+        argTypes = new VARTYPE[numArgTypes];
+        argIsOut = new BOOL[numArgTypes];
+        for (UINT i = 0; i < numArgTypes; i++) {
+            PythonOleArgHelper helper;
+            if (!helper.ParseTypeInformation(PyTuple_GET_ITEM(obArgDescs, i))) {
+                delete[] argTypes;
+                delete[] argIsOut;
+                return NULL;
+            }
+            argTypes[i] = helper.m_reqdType;
+            argIsOut[i] = helper.m_bIsOut;
+        }
+    }
+    plan = new PyDispatchCallPlan;
+    plan->refCount = 1;  // the reference held by the cache.
+    plan->dispid = dispid;
+    plan->obResultDesc = obResultDesc;
+    Py_INCREF(obResultDesc);
+    plan->obArgDescs = obArgDescs;
+    Py_INCREF(obArgDescs);
+    plan->resultType = resultHelper.m_reqdType;
+    plan->numArgTypes = numArgTypes;
+    plan->argTypes = argTypes;
+    plan->argIsOut = argIsOut;
+
+    // Replace whatever was in the slot - any thread still using the old plan
+    // holds its own reference.
+    if (pyDisp->m_callPlans[slot])
+        PyDispatchCallPlan_Release(pyDisp->m_callPlans[slot]);
+    pyDisp->m_callPlans[slot] = plan;
+    plan->refCount++;  // the reference for our caller.
+    return plan;
+}
+
 // @pymethod object|PyIDispatch|InvokeTypes|Invokes a DISPID, using the passed arguments and type descriptions.
 PyObject *PyIDispatch::InvokeTypes(PyObject *self, PyObject *args)
 {
@@ -374,12 +530,22 @@ PyObject *PyIDispatch::InvokeTypes(PyObject *self, PyObject *args)
         }
     }
 
+    CPyComCallTimer timer;
+    PyDispatchCallPlan *plan = PyDispatchCallPlan_Get((PyIDispatch *)self, dispid, resultElemDesc, argsElemDescArray);
+    if (plan == NULL)
+        return NULL;
+
     // these will all be cleared before returning
+    // Small calls use the stack buffers, so the only allocations made are
+    // those needed for the values themselves.
+    PythonOleArgHelper stackArgHelpers[CALLPLAN_STACK_ARGS];
+    VARIANTARG stackVariants[CALLPLAN_STACK_ARGS];
     PythonOleArgHelper *ArgHelpers = NULL;
     PyObject *result = NULL;
     DISPID dispidNamed = DISPID_PROPERTYPUT;
     DISPPARAMS dispparams = {NULL, NULL, 0, 0};
     PythonOleArgHelper resultArgHelper;
+    IDispatch *pTimedDispatch = NULL;  // set once the call has been made
 
     // This gets confusing.  If we have typeinfo for a byref arg, but the
     // arg is not specified by the user, then we _do_ present the arg to
@@ -395,14 +561,14 @@ PyObject *PyIDispatch::InvokeTypes(PyObject *self, PyObject *args)
     UINT i;
 
     if (argTypesLen > 0) {
-        ArgHelpers = new PythonOleArgHelper[argTypesLen];  // new may! except.
-        if (ArgHelpers == NULL) {
-            PyErr_SetString(PyExc_MemoryError, "Allocating ArgHelpers array");
-            return NULL;
-        }
+        if (argTypesLen <= CALLPLAN_STACK_ARGS)
+            ArgHelpers = stackArgHelpers;
+        else
+            ArgHelpers = new PythonOleArgHelper[argTypesLen];
         for (i = 0; i < (UINT)argTypesLen; i++) {
-            if (!ArgHelpers[i].ParseTypeInformation(PyTuple_GET_ITEM(argsElemDescArray, i)))
-                goto error;
+            ArgHelpers[i].m_reqdType = plan->argTypes[i];
+            ArgHelpers[i].m_bIsOut = plan->argIsOut[i];
+            ArgHelpers[i].m_bParsedTypeInfo = TRUE;
             // We ignore "in" params specified as "Missing", but
             // for byref (ie, "IsOut") args we still must process it.
             if (i < (UINT)numArgs || ArgHelpers[i].m_bIsOut)
@@ -412,11 +578,10 @@ PyObject *PyIDispatch::InvokeTypes(PyObject *self, PyObject *args)
 
     dispparams.cArgs = numArgArray;
     if (dispparams.cArgs) {
-        dispparams.rgvarg = new VARIANTARG[dispparams.cArgs];
-        if (dispparams.rgvarg == NULL) {
-            PyErr_SetString(PyExc_MemoryError, "Allocating dispparams.rgvarg array");
-            goto error;
-        }
+        if (dispparams.cArgs <= CALLPLAN_STACK_ARGS)
+            dispparams.rgvarg = stackVariants;
+        else
+            dispparams.rgvarg = new VARIANTARG[dispparams.cArgs];
 
         for (i = dispparams.cArgs; i--;) VariantInit(&dispparams.rgvarg[i]);
 
@@ -426,8 +591,7 @@ PyObject *PyIDispatch::InvokeTypes(PyObject *self, PyObject *args)
             UINT offset = dispparams.cArgs - i - 1;
             // See if the user actually specified this arg.
             PyObject *arg = i >= (UINT)numArgs ? Py_None : PyTuple_GET_ITEM(args, i + 5);
-            if (!ArgHelpers[i].MakeObjToVariant(arg, &dispparams.rgvarg[offset],
-                                                PyTuple_GET_ITEM(argsElemDescArray, i)))
+            if (!ArgHelpers[i].MakeObjToVariant(arg, &dispparams.rgvarg[offset]))
                 goto error;
         }
     }
@@ -438,10 +602,8 @@ PyObject *PyIDispatch::InvokeTypes(PyObject *self, PyObject *args)
         dispparams.cNamedArgs = 1;
     }
 
-    if (!resultArgHelper.ParseTypeInformation(resultElemDesc)) {
-        PyCom_BuildInternalPyException("The return type information could not be parsed");
-        goto error;
-    }
+    resultArgHelper.m_reqdType = plan->resultType;
+    resultArgHelper.m_bParsedTypeInfo = TRUE;
 
     BOOL bResultWanted;
     bResultWanted = (resultArgHelper.m_reqdType != VT_VOID && resultArgHelper.m_reqdType != VT_EMPTY);
@@ -467,11 +629,15 @@ PyObject *PyIDispatch::InvokeTypes(PyObject *self, PyObject *args)
     if (pMyDispatch == NULL)
         goto error;
     nArgErr = (UINT)-1;  // initialize to invalid arg
+    timer.EndPhase(PYCOM_PHASE_MARSHAL);
     {
         PY_INTERFACE_PRECALL;
         hr = pMyDispatch->Invoke(dispid, IID_NULL, lcid, wFlags, &dispparams, pVarResultUse, &excepInfo, &nArgErr);
+        timer.EndPhase(PYCOM_PHASE_CALL);
         PY_INTERFACE_POSTCALL;
     }
+    timer.EndPhase(PYCOM_PHASE_LOCK);
+    pTimedDispatch = pMyDispatch;
 
     if (!HandledDispatchFailure(hr, &excepInfo, nArgErr, dispparams.cArgs, pMyDispatch)) {
         // Now get fancy with the args.  Any args specified as BYREF get returned
@@ -488,7 +654,8 @@ PyObject *PyIDispatch::InvokeTypes(PyObject *self, PyObject *args)
         }
         else if (retSize == 1) {  // result is a simple object.
             if (pVarResultUse) {  // only retval is actual result.
-                result = resultArgHelper.MakeVariantToObj(pVarResultUse);
+                // The result variant is about to be cleared, so its value can be moved.
+                result = PyCom_PyObjectFromOwnedVariant(pVarResultUse);
             }
             else {  // only result in one of the params - seek it.
                 for (UINT arg = 0; arg < numArgArray; arg++) {
@@ -518,10 +685,18 @@ PyObject *PyIDispatch::InvokeTypes(PyObject *self, PyObject *args)
 error:
     if (dispparams.rgvarg) {
         for (i = dispparams.cArgs; i--;) VariantClear(&dispparams.rgvarg[i]);
-        delete[] dispparams.rgvarg;
+        if (dispparams.rgvarg != stackVariants)
+            delete[] dispparams.rgvarg;
+    }
+    if (ArgHelpers != stackArgHelpers)
+        delete[] ArgHelpers;
+    PyDispatchCallPlan_Release(plan);
+    if (timer.IsActive() && pTimedDispatch) {
+        timer.EndPhase(PYCOM_PHASE_UNMARSHAL);
+        timer.Record(FALSE, GetCallStatsName(self, pTimedDispatch), dispid, result == NULL);
     }
-    delete[] ArgHelpers;
     return result;
+
     // @comm The Microsoft documentation for IDispatch should be used for all
     // params except 'resultTypeDesc' and 'typeDescs'. 'resultTypeDesc' describes
     // the return value of the function, and is a tuple of (type_id, flags).
@@ -4,6 +4,7 @@
 #include "stdafx.h"
 #include "PythonCOM.h"
 #include "PythonCOMServer.h"
+#include "PyComObjectStats.h"
 
 char *PyIUnknown::szErrMsgObjectReleased = "The COM object has been released.";
 
@@ -15,6 +16,10 @@ PyIUnknown::PyIUnknown(IUnknown *punk)
 {
     ob_type = &type;
     m_obj = punk;
+    m_bInIdentityMap = FALSE;
+    m_nextIdentity = NULL;
+    // Charged by PyCom_PyObjectFromIUnknown, once the type is known.
+    m_pObjectStats = NULL;
     // refcnt of object managed by caller.
     InterlockedIncrement(&cUnknowns);
     PyCom_DLLAddRef();
@@ -24,6 +29,8 @@ PyIUnknown::~PyIUnknown()
 {
     SafeRelease(this);
     InterlockedDecrement(&cUnknowns);
+    if (m_pObjectStats)
+        PyCom_ObjectStatsDestroyed(m_pObjectStats);
     PyCom_DLLReleaseRef();
 }
 // @method string|PyIUnknown|__repr__|Called to create a representation of a PyIUnknown object
@@ -122,10 +129,67 @@ PyString_AsString(((PyInstanceObject *)ob)->in_class->cl_name));
     return pPyUnk->m_obj;
 }
 
+// The identity map - interface objects by interface pointer, chained through
+// m_nextIdentity, so the same interface pointer gives the same object.
+// Objects are removed before they release their interface, so the pointer
+// can't be reused by another COM object while it is in the map.  Only used
+// with the Python lock held.
+BOOL g_bPyCom_InterfaceIdentity = FALSE;
+#define IDENTITY_BUCKETS 1024
+static PyIUnknown *g_identityMap[IDENTITY_BUCKETS];
+
+static unsigned int IdentityBucket(IUnknown *punk) { return (unsigned int)(((ULONG_PTR)punk >> 4) % IDENTITY_BUCKETS); }
+
+PyIUnknown *PyCom_FindInIdentityMap(IUnknown *punk, PyTypeObject *type)
+{
+    for (PyIUnknown *ob = g_identityMap[IdentityBucket(punk)]; ob; ob = ob->m_nextIdentity)
+        if (ob->m_obj == punk && ob->ob_type == type)
+            return ob;
+    return NULL;
+}
+
+void PyCom_AddToIdentityMap(PyIUnknown *ob)
+{
+    unsigned int bucket = IdentityBucket(ob->m_obj);
+    ob->m_nextIdentity = g_identityMap[bucket];
+    g_identityMap[bucket] = ob;
+    ob->m_bInIdentityMap = TRUE;
+}
+
+static void RemoveFromIdentityMap(PyIUnknown *ob)
+{
+    PyIUnknown **pp = &g_identityMap[IdentityBucket(ob->m_obj)];
+    while (*pp != ob) pp = &(*pp)->m_nextIdentity;
+    *pp = ob->m_nextIdentity;
+    ob->m_nextIdentity = NULL;
+    ob->m_bInIdentityMap = FALSE;
+}
+
+// @pymethod bool|pythoncom|EnableInterfaceIdentity|Enables or disables reusing interface objects.
+// @comm When enabled, converting an interface pointer for which a Python interface object of the same type
+// already exists returns that object, rather than creating another.  Code that walks an object model,
+// such as an Excel Workbook's Sheets and Ranges, then doesn't create (and AddRef and Release) a new object
+// each time it reaches the same COM object through the same interface.
+// <nl>Identity is by interface pointer - the same COM object reached through different interfaces, or
+// through proxies from different apartments, still gives different objects, which compare equal as usual.
+// @rdesc Returns the previous setting.
+PyObject *pythoncom_EnableInterfaceIdentity(PyObject *self, PyObject *args)
+{
+    int enable = TRUE;
+    // @pyparm bool|enable|True|Whether to reuse interface objects
+    if (!PyArg_ParseTuple(args, "|i:EnableInterfaceIdentity", &enable))
+        return NULL;
+    BOOL old = g_bPyCom_InterfaceIdentity;
+    g_bPyCom_InterfaceIdentity = enable;
+    return PyBool_FromLong(old);
+}
+
 /*static*/ void PyIUnknown::SafeRelease(PyIUnknown *ob)
 {
     if (!ob)
         return;
+    if (ob->m_bInIdentityMap)
+        RemoveFromIdentityMap(ob);
     if (ob->m_obj) {
         // Safe for all objects which delete
         // itself ignoring a reference count.
@@ -31,6 +31,52 @@ class PyRecordBuffer {
     long ref;
 };
 
+// A field of a record which we can read and write directly in the record
+// buffer.  Fields of other types (strings, sub-records, arrays, etc) are
+// still in the table, but with a vt of VT_EMPTY, and are always accessed
+// via the IRecordInfo.
+struct PyRecordField {
+    PyObject *name;
+    Py_hash_t hash;
+    ULONG offset;
+    VARTYPE vt;
+    USHORT size;
+};
+
+// The fields of one record type, built from its type info the first time a
+// record of that type has an attribute accessed.  Saves IRecordInfo doing
+// string compares of the name for each field access.
+class PyRecordFieldTable {
+   public:
+    PyRecordFieldTable(IRecordInfo *ri)
+    {
+        ri->AddRef();
+        pri = ri;
+        numFields = 0;
+        fields = NULL;
+        ref = 1;
+    }
+    ~PyRecordFieldTable()
+    {
+        for (ULONG i = 0; i < numFields; i++) Py_XDECREF(fields[i].name);
+        delete[] fields;
+        pri->Release();
+    }
+    void AddRef() { ref++; }
+    void Release()
+    {
+        if (--ref == 0)
+            delete this;
+    }
+    // Returns NULL if the name is not a field of the record.
+    PyRecordField *Find(PyObject *obname);
+
+    IRecordInfo *pri;
+    ULONG numFields;
+    PyRecordField *fields;
+    long ref;
+};
+
 BOOL PyRecord_Check(PyObject *ob) { return ((ob)->ob_type == &PyRecord::Type); }
 
 BOOL PyObject_AsVARIANTRecordInfo(PyObject *ob, VARIANT *pv)
@@ -50,9 +96,37 @@ BOOL PyObject_AsVARIANTRecordInfo(PyObject *ob, VARIANT *pv)
     return TRUE;
 }
 
+// If TRUE, arrays of records are returned as PyRecordArray objects rather
+// than tuples of PyRecord objects.
+static BOOL bRecordArrays = FALSE;
+
+BOOL PyCom_EnableRecordArrays(BOOL bEnable)
+{
+    BOOL bOld = bRecordArrays;
+    bRecordArrays = bEnable;
+    return bOld;
+}
+
+// A sequence of records sharing memory owned by 'owner' - either a tuple of
+// PyRecord objects, or a PyRecordArray if enabled.
+static PyObject *PyObject_FromRecordArrayData(IRecordInfo *info, BYTE *data, long nelems, ULONG cb_elem,
+                                              PyRecordBuffer *owner)
+{
+    if (bRecordArrays)
+        return new PyRecordArray(info, data, nelems, cb_elem, owner);
+    PyObject *ret_tuple = PyTuple_New(nelems);
+    if (ret_tuple == NULL)
+        return NULL;
+    for (long i = 0; i < nelems; i++) {
+        PyTuple_SET_ITEM(ret_tuple, i, new PyRecord(info, data, owner));
+        data += cb_elem;
+    }
+    return ret_tuple;
+}
+
 PyObject *PyObject_FromSAFEARRAYRecordInfo(SAFEARRAY *psa)
 {
-    PyObject *ret = NULL, *ret_tuple = NULL;
+    PyObject *ret = NULL;
     IRecordInfo *info = NULL;
     BYTE *source_data = NULL, *this_dest_data = NULL;
     long lbound, ubound, nelems, i;
@@ -79,9 +153,6 @@ PyObject *PyObject_FromSAFEARRAYRecordInfo(SAFEARRAY *psa)
     if (PyErr_Occurred())
         goto exit;
     owner->AddRef();  // unref'd at end - for successful failure cleanup
-    ret_tuple = PyTuple_New(nelems);
-    if (ret_tuple == NULL)
-        goto exit;
     this_dest_data = (BYTE *)owner->data;
     for (i = 0; i < nelems; i++) {
         hr = info->RecordInit(this_dest_data);
@@ -91,12 +162,10 @@ PyObject *PyObject_FromSAFEARRAYRecordInfo(SAFEARRAY *psa)
         hr = info->RecordCopy(source_data, this_dest_data);
         if (FAILED(hr))
             goto exit;
-        PyTuple_SET_ITEM(ret_tuple, i, new PyRecord(info, this_dest_data, owner));
         this_dest_data += cb_elem;
         source_data += cb_elem;
     }
-    ret = ret_tuple;
-    Py_INCREF(ret);  // for decref on cleanup.
+    ret = PyObject_FromRecordArrayData(info, (BYTE *)owner->data, nelems, cb_elem, owner);
 exit:
     if (FAILED(hr)) {
         if (info)
@@ -108,7 +177,6 @@ exit:
     }
     if (owner != NULL)
         owner->Release();
-    Py_XDECREF(ret_tuple);
     if (info)
         info->Release();
     if (source_data != NULL)
@@ -209,10 +277,13 @@ PyRecord::PyRecord(IRecordInfo *ri, PVOID data, PyRecordBuffer *owner)
     pdata = data;
     this->owner = owner;
     owner->AddRef();
+    fields = NULL;
 };
 
 PyRecord::~PyRecord()
 {
+    if (fields)
+        fields->Release();
     owner->Release();
     pri->Release();
 }
@@ -436,6 +507,161 @@ done:
     return obrepr;
 }
 
+// The size of the simple types we read and write directly from the record
+// buffer, or zero if the type must go via IRecordInfo.
+static USHORT RecordFieldSize(VARTYPE vt)
+{
+    switch (vt) {
+        case VT_I1:
+        case VT_UI1:
+            return 1;
+        case VT_I2:
+        case VT_UI2:
+        case VT_BOOL:
+            return 2;
+        case VT_I4:
+        case VT_UI4:
+        case VT_INT:
+        case VT_UINT:
+        case VT_ERROR:
+        case VT_R4:
+            return 4;
+        case VT_I8:
+        case VT_UI8:
+        case VT_R8:
+        case VT_DATE:
+        case VT_CY:
+            return 8;
+    }
+    return 0;
+}
+
+// Build the table from the type info.  On any failure we return an empty
+// table, so everything is done via IRecordInfo, as it would have been anyway.
+static PyRecordFieldTable *BuildRecordFieldTable(IRecordInfo *pri)
+{
+    PyRecordFieldTable *table = new PyRecordFieldTable(pri);
+    if (table == NULL)
+        return NULL;
+    ITypeInfo *pti = NULL;
+    TYPEATTR *pta = NULL;
+    ULONG cbRecord = 0;
+    HRESULT hr = pri->GetSize(&cbRecord);
+    if (SUCCEEDED(hr))
+        hr = pri->GetTypeInfo(&pti);
+    if (SUCCEEDED(hr) && pti != NULL)
+        hr = pti->GetTypeAttr(&pta);
+    if (FAILED(hr) || pta == NULL || pta->typekind != TKIND_RECORD)
+        goto done;
+    table->fields = new PyRecordField[pta->cVars];
+    if (table->fields == NULL)
+        goto done;
+    for (WORD i = 0; i < pta->cVars; i++) {
+        VARDESC *pvd = NULL;
+        if (FAILED(pti->GetVarDesc(i, &pvd)))
+            continue;
+        BSTR name = NULL;
+        if (pvd->varkind == VAR_PERINSTANCE &&
+            SUCCEEDED(pti->GetDocumentation(pvd->memid, &name, NULL, NULL, NULL)) && name != NULL) {
+            PyRecordField *field = table->fields + table->numFields;
+            field->name = PyWinCoreString_FromString(name);
+            field->hash = field->name ? PyObject_Hash(field->name) : -1;
+            if (field->hash == -1) {
+                PyErr_Clear();
+                Py_XDECREF(field->name);
+            }
+            else {
+#if (PY_VERSION_HEX >= 0x03000000)
+                PyUnicode_InternInPlace(&field->name);
+#endif
+                field->offset = pvd->oInst;
+                field->vt = pvd->elemdescVar.tdesc.vt;
+                field->size = RecordFieldSize(field->vt);
+                if (field->size == 0 || field->offset + field->size > cbRecord) {
+                    field->vt = VT_EMPTY;
+                    field->size = 0;
+                }
+                table->numFields++;
+            }
+        }
+        SysFreeString(name);
+        pti->ReleaseVarDesc(pvd);
+    }
+done:
+    if (pta)
+        pti->ReleaseTypeAttr(pta);
+    if (pti)
+        pti->Release();
+    return table;
+}
+
+PyRecordField *PyRecordFieldTable::Find(PyObject *obname)
+{
+    Py_hash_t hash = PyObject_Hash(obname);
+    if (hash == -1) {
+        PyErr_Clear();
+        return NULL;
+    }
+    // Records rarely have more than a few dozen fields, and the common
+    // case is an interned attribute name, so a linear scan is fine.
+    for (ULONG i = 0; i < numFields; i++) {
+        PyRecordField *field = fields + i;
+        if (field->hash != hash)
+            continue;
+        if (field->name == obname)
+            return field;
+        int c = PyObject_RichCompareBool(field->name, obname, Py_EQ);
+        if (c == 1)
+            return field;
+        if (c == -1)
+            PyErr_Clear();
+    }
+    return NULL;
+}
+
+// A small cache of tables, so multiple records of the same type - such as
+// the elements of an array - share a table.  Protected by the GIL.
+#define RECORD_FIELD_CACHE_SIZE 32
+static PyRecordFieldTable *g_recordFieldCache[RECORD_FIELD_CACHE_SIZE];
+
+static PyRecordFieldTable *GetRecordFieldTable(PyRecord *pyrec)
+{
+    if (pyrec->fields == NULL) {
+        UINT slot = (UINT)(((ULONG_PTR)pyrec->pri >> 4) % RECORD_FIELD_CACHE_SIZE);
+        PyRecordFieldTable *table = g_recordFieldCache[slot];
+        if (table == NULL || table->pri != pyrec->pri) {
+            table = BuildRecordFieldTable(pyrec->pri);
+            if (table == NULL)
+                return NULL;
+            if (g_recordFieldCache[slot])
+                g_recordFieldCache[slot]->Release();
+            g_recordFieldCache[slot] = table;  // the cache takes the initial ref.
+        }
+        table->AddRef();
+        pyrec->fields = table;
+    }
+    return pyrec->fields;
+}
+
+// Locate a field we can access directly, or NULL (with no exception set).
+static PyRecordField *FindDirectField(PyRecord *pyrec, PyObject *obname)
+{
+    // Special attributes and methods (which must be __blah__ named) always
+    // take precedence over fields.
+    char *name = PYWIN_ATTR_CONVERT(obname);
+    if (name == NULL) {
+        PyErr_Clear();
+        return NULL;
+    }
+    if (name[0] == '_' && name[1] == '_')
+        return NULL;
+    PyRecordFieldTable *table = GetRecordFieldTable(pyrec);
+    if (table == NULL)
+        return NULL;
+    PyRecordField *field = table->Find(obname);
+    return (field != NULL && field->vt != VT_EMPTY) ? field : NULL;
+}
+
 PyObject *PyRecord::getattro(PyObject *self, PyObject *obname)
 {
     PyObject *res;
@@ -471,6 +697,16 @@ PyObject *PyRecord::getattro(PyObject *self, PyObject *obname)
         return res;
     }
 
+    // Simple fields are read straight from the buffer.
+    PyRecordField *field = FindDirectField(pyrec, obname);
+    if (field != NULL) {
+        VARIANT v;
+        VariantInit(&v);
+        V_VT(&v) = field->vt;
+        memcpy(&V_UI1(&v), (BYTE *)pyrec->pdata + field->offset, field->size);
+        return PyCom_PyObjectFromVariant(&v);
+    }
+
     res = PyObject_GenericGetAttr(self, obname);
     if (res != NULL)
         return res;
@@ -514,8 +750,6 @@ PyObject *PyRecord::getattro(PyObject *self, PyObject *obname)
             return PyErr_Format(PyExc_TypeError, "Only support single dimensional arrays of records");
         IRecordInfo *sub = NULL;
         long ubound, lbound, nelems;
-        int i;
-        BYTE *this_data;
         PyObject *ret_tuple = NULL;
         ULONG element_size = 0;
         hr = SafeArrayGetUBound(psa, 1, &ubound);
@@ -531,14 +765,7 @@ PyObject *PyRecord::getattro(PyObject *self, PyObject *obname)
         if (FAILED(hr))
             goto array_end;
         nelems = ubound - lbound;
-        ret_tuple = PyTuple_New(nelems);
-        if (ret_tuple == NULL)
-            goto array_end;
-        this_data = (BYTE *)sub_data;
-        for (i = 0; i < nelems; i++) {
-            PyTuple_SET_ITEM(ret_tuple, i, new PyRecord(sub, this_data, pyrec->owner));
-            this_data += element_size;
-        }
+        ret_tuple = PyObject_FromRecordArrayData(sub, (BYTE *)sub_data, nelems, element_size, pyrec->owner);
     array_end:
         if (sub)
             sub->Release();
@@ -567,6 +794,19 @@ int PyRecord::setattro(PyObject *self, PyObject *obname, PyObject *v)
     if (!PyCom_VariantFromPyObject(v, &val))
         return -1;
 
+    // Simple fields are coerced and written straight into the buffer.  If
+    // the coercion fails, let PutField report the error as it always has.
+    PyRecordField *field = FindDirectField(pyrec, obname);
+    if (field != NULL) {
+        VARIANT conv;
+        VariantInit(&conv);
+        if (SUCCEEDED(VariantChangeType(&conv, &val, 0, field->vt))) {
+            memcpy((BYTE *)pyrec->pdata + field->offset, &V_UI1(&conv), field->size);
+            VariantClear(&val);
+            return 0;
+        }
+    }
+
     WCHAR *wname;
     if (!PyWinObject_AsWCHAR(obname, &wname, FALSE))
         return -1;
@@ -651,3 +891,125 @@ done:
 }
 
 void PyRecord::tp_dealloc(PyObject *ob) { delete (PyRecord *)ob; }
+
+/////////////////////////////////////////////////////////////////////////////
+// PyRecordArray
+//
+PyRecordArray::PyRecordArray(IRecordInfo *ri, BYTE *data, Py_ssize_t nelems, ULONG cbElem, PyRecordBuffer *owner)
+{
+    ob_type = &PyRecordArray::Type;
+    _Py_NewReference(this);
+    ri->AddRef();
+    pri = ri;
+    pdata = data;
+    this->nelems = nelems;
+    this->cbElem = cbElem;
+    this->owner = owner;
+    owner->AddRef();
+}
+
+PyRecordArray::~PyRecordArray()
+{
+    owner->Release();
+    pri->Release();
+}
+
+void PyRecordArray::tp_dealloc(PyObject *ob) { delete (PyRecordArray *)ob; }
+
+Py_ssize_t PyRecordArray::sq_length(PyObject *self) { return ((PyRecordArray *)self)->nelems; }
+
+PyObject *PyRecordArray::sq_item(PyObject *self, Py_ssize_t index)
+{
+    PyRecordArray *pyarr = (PyRecordArray *)self;
+    if (index < 0 || index >= pyarr->nelems) {
+        PyErr_SetString(PyExc_IndexError, "com_record_array index out of range");
+        return NULL;
+    }
+    return new PyRecord(pyarr->pri, pyarr->pdata + index * pyarr->cbElem, pyarr->owner);
+}
+
+// @pymethod tuple|PyRecordArray|GetField|Returns the value of one field from every record in the array.
+PyObject *PyRecordArray::GetField(PyObject *self, PyObject *args)
+{
+    PyRecordArray *pyarr = (PyRecordArray *)self;
+    PyObject *obname;
+    // @pyparm str|name||The name of the field.
+    if (!PyArg_ParseTuple(args, "O:GetField", &obname))
+        return NULL;
+    PyObject *ret = PyTuple_New(pyarr->nelems);
+    if (ret == NULL || pyarr->nelems == 0)
+        return ret;
+    // Look the field up once, and if it is a simple field, read it from
+    // each record directly.
+    PyRecord *first = (PyRecord *)sq_item(self, 0);
+    if (first == NULL) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    PyRecordField *field = FindDirectField(first, obname);
+    Py_DECREF(first);
+    BYTE *data = pyarr->pdata;
+    for (Py_ssize_t i = 0; i < pyarr->nelems; i++, data += pyarr->cbElem) {
+        PyObject *item;
+        if (field != NULL) {
+            VARIANT v;
+            VariantInit(&v);
+            V_VT(&v) = field->vt;
+            memcpy(&V_UI1(&v), data + field->offset, field->size);
+            item = PyCom_PyObjectFromVariant(&v);
+        }
+        else {
+            PyObject *rec = new PyRecord(pyarr->pri, data, pyarr->owner);
+            item = PyRecord::getattro(rec, obname);
+            Py_DECREF(rec);
+        }
+        if (item == NULL) {
+            Py_DECREF(ret);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(ret, i, item);
+    }
+    return ret;
+    // @comm This is equivalent to, but much faster than, [r.name for r in array]
+}
+
+struct PyMethodDef PyRecordArray::methods[] = {
+    {"GetField", PyRecordArray::GetField, 1},  // @pymeth GetField|Returns the value of one field from every record.
+    {NULL}};
+
+PySequenceMethods PyRecordArray::sequence = {
+    PyRecordArray::sq_length, /* sq_length */
+    0,                        /* sq_concat */
+    0,                        /* sq_repeat */
+    PyRecordArray::sq_item,   /* sq_item */
+};
+
+PyTypeObject PyRecordArray::Type = {
+    PYWIN_OBJECT_HEAD "com_record_array",
+    sizeof(PyRecordArray),
+    0,
+    PyRecordArray::tp_dealloc, /* tp_dealloc */
+    0,                         /* tp_print */
+    0,                         /* tp_getattr */
+    0,                         /* tp_setattr */
+    0,                         /* tp_compare */
+    0,                         /* tp_repr */
+    0,                         /* tp_as_number */
+    &PyRecordArray::sequence,  /* tp_as_sequence */
+    0,                         /* tp_as_mapping */
+    0,                         /* tp_hash */
+    0,                         /* tp_call */
+    0,                         /* tp_str */
+    PyObject_GenericGetAttr,   /* tp_getattro */
+    0,                         /* tp_setattro */
+    0,                         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,        /* tp_flags */
+    0,                         /* tp_doc */
+    0,                         /* tp_traverse */
+    0,                         /* tp_clear */
+    0,                         /* tp_richcompare */
+    0,                         /* tp_weaklistoffset */
+    0,                         /* tp_iter */
+    0,                         /* tp_iternext */
+    PyRecordArray::methods,    /* tp_methods */
+};
@@ -127,6 +127,320 @@ PyObject *pythoncom_CreateStreamOnHGlobal(PyObject *self, PyObject *args)
     return PyCom_PyObjectFromIUnknown(pIStream, IID_IStream, FALSE);
 }
 
+// The memory or file underlying a CPyBufferStream, shared with its clones.
+struct PyBufferStreamData {
+    LONG cRef;
+    Py_buffer view;  // view.obj is NULL for file streams
+    HANDLE hfile;
+    BOOL bWritable;
+};
+
+static void ReleasePyBufferStreamData(PyBufferStreamData *data)
+{
+    if (InterlockedDecrement(&data->cRef) > 0)
+        return;
+    if (data->view.obj) {
+        CEnterLeavePython _celp;
+        PyBuffer_Release(&data->view);
+    }
+    if (data->hfile != INVALID_HANDLE_VALUE)
+        CloseHandle(data->hfile);
+    free(data);
+}
+
+// A native IStream over a Python buffer or a file handle.  Calls are served
+// without the Python lock, except for releasing the buffer when the last
+// reference goes away.
+class CPyBufferStream : public IStream {
+   public:
+    CPyBufferStream(PyBufferStreamData *data, ULONGLONG pos)
+    {
+        m_cRef = 1;
+        m_data = data;
+        InterlockedIncrement(&data->cRef);
+        m_pos = pos;
+        InitializeCriticalSection(&m_cs);
+    }
+    ~CPyBufferStream()
+    {
+        DeleteCriticalSection(&m_cs);
+        ReleasePyBufferStreamData(m_data);
+    }
+
+    // IUnknown
+    STDMETHOD(QueryInterface)(REFIID iid, void **ppv)
+    {
+        if (ppv == NULL)
+            return E_POINTER;
+        if (iid == IID_IUnknown || iid == IID_ISequentialStream || iid == IID_IStream) {
+            *ppv = (IStream *)this;
+            AddRef();
+            return S_OK;
+        }
+        *ppv = NULL;
+        return E_NOINTERFACE;
+    }
+    STDMETHOD_(ULONG, AddRef)(void) { return InterlockedIncrement(&m_cRef); }
+    STDMETHOD_(ULONG, Release)(void)
+    {
+        LONG cRef = InterlockedDecrement(&m_cRef);
+        if (cRef == 0)
+            delete this;
+        return cRef;
+    }
+
+    // ISequentialStream
+    STDMETHOD(Read)(void *pv, ULONG cb, ULONG *pcbRead)
+    {
+        ULONG read = 0;
+        HRESULT hr = S_OK;
+        EnterCriticalSection(&m_cs);
+        if (m_data->view.obj) {
+            ULONGLONG size = m_data->view.len;
+            if (m_pos < size) {
+                read = size - m_pos < cb ? (ULONG)(size - m_pos) : cb;
+                memcpy(pv, (BYTE *)m_data->view.buf + m_pos, read);
+            }
+        }
+        else {
+            OVERLAPPED ov = {0};
+            ov.Offset = (DWORD)m_pos;
+            ov.OffsetHigh = (DWORD)(m_pos >> 32);
+            if (!ReadFile(m_data->hfile, pv, cb, &read, &ov)) {
+                DWORD err = GetLastError();
+                read = 0;
+                if (err != ERROR_HANDLE_EOF)
+                    hr = HRESULT_FROM_WIN32(err);
+            }
+        }
+        m_pos += read;
+        LeaveCriticalSection(&m_cs);
+        if (pcbRead)
+            *pcbRead = read;
+        return hr;
+    }
+    STDMETHOD(Write)(const void *pv, ULONG cb, ULONG *pcbWritten)
+    {
+        ULONG written = 0;
+        HRESULT hr = S_OK;
+        if (!m_data->bWritable)
+            return STG_E_ACCESSDENIED;
+        EnterCriticalSection(&m_cs);
+        if (m_data->view.obj) {
+            // A buffer can't grow, so writes are truncated at its end
+            ULONGLONG size = m_data->view.len;
+            if (m_pos < size) {
+                written = size - m_pos < cb ? (ULONG)(size - m_pos) : cb;
+                memcpy((BYTE *)m_data->view.buf + m_pos, pv, written);
+            }
+            if (written < cb)
+                hr = STG_E_MEDIUMFULL;
+        }
+        else {
+            OVERLAPPED ov = {0};
+            ov.Offset = (DWORD)m_pos;
+            ov.OffsetHigh = (DWORD)(m_pos >> 32);
+            if (!WriteFile(m_data->hfile, pv, cb, &written, &ov))
+                hr = HRESULT_FROM_WIN32(GetLastError());
+        }
+        m_pos += written;
+        LeaveCriticalSection(&m_cs);
+        if (pcbWritten)
+            *pcbWritten = written;
+        return hr;
+    }
+
+    // IStream
+    STDMETHOD(Seek)(LARGE_INTEGER dlibMove, DWORD dwOrigin, ULARGE_INTEGER *plibNewPosition)
+    {
+        LONGLONG base;
+        EnterCriticalSection(&m_cs);
+        switch (dwOrigin) {
+            case STREAM_SEEK_SET:
+                base = 0;
+                break;
+            case STREAM_SEEK_CUR:
+                base = (LONGLONG)m_pos;
+                break;
+            case STREAM_SEEK_END: {
+                ULARGE_INTEGER size;
+                HRESULT hr = GetSize(&size);
+                if (FAILED(hr)) {
+                    LeaveCriticalSection(&m_cs);
+                    return hr;
+                }
+                base = (LONGLONG)size.QuadPart;
+                break;
+            }
+            default:
+                LeaveCriticalSection(&m_cs);
+                return STG_E_INVALIDFUNCTION;
+        }
+        if (base + dlibMove.QuadPart < 0) {
+            LeaveCriticalSection(&m_cs);
+            return STG_E_INVALIDFUNCTION;
+        }
+        m_pos = (ULONGLONG)(base + dlibMove.QuadPart);
+        if (plibNewPosition)
+            plibNewPosition->QuadPart = m_pos;
+        LeaveCriticalSection(&m_cs);
+        return S_OK;
+    }
+    STDMETHOD(SetSize)(ULARGE_INTEGER libNewSize)
+    {
+        if (!m_data->bWritable)
+            return STG_E_ACCESSDENIED;
+        if (m_data->view.obj)
+            return libNewSize.QuadPart == (ULONGLONG)m_data->view.len ? S_OK : STG_E_INVALIDFUNCTION;
+        // The file pointer itself is not used for reads and writes, so it can be moved freely
+        LARGE_INTEGER newsize;
+        newsize.QuadPart = (LONGLONG)libNewSize.QuadPart;
+        if (!SetFilePointerEx(m_data->hfile, newsize, NULL, FILE_BEGIN) || !SetEndOfFile(m_data->hfile))
+            return HRESULT_FROM_WIN32(GetLastError());
+        return S_OK;
+    }
+    STDMETHOD(CopyTo)(IStream *pstm, ULARGE_INTEGER cb, ULARGE_INTEGER *pcbRead, ULARGE_INTEGER *pcbWritten)
+    {
+        BYTE buf[0x4000];
+        ULARGE_INTEGER total_read, total_written;
+        HRESULT hr = S_OK;
+        total_read.QuadPart = total_written.QuadPart = 0;
+        while (total_read.QuadPart < cb.QuadPart) {
+            ULONG want = sizeof(buf), read = 0, written = 0;
+            if (cb.QuadPart - total_read.QuadPart < want)
+                want = (ULONG)(cb.QuadPart - total_read.QuadPart);
+            if (m_data->view.obj) {
+                // Write straight from the buffer rather than via the local one
+                EnterCriticalSection(&m_cs);
+                ULONGLONG size = m_data->view.len, pos = m_pos;
+                if (pos < size)
+                    read = size - pos < want ? (ULONG)(size - pos) : want;
+                m_pos += read;
+                LeaveCriticalSection(&m_cs);
+                if (read)
+                    hr = pstm->Write((BYTE *)m_data->view.buf + pos, read, &written);
+            }
+            else {
+                hr = Read(buf, want, &read);
+                if (SUCCEEDED(hr) && read)
+                    hr = pstm->Write(buf, read, &written);
+            }
+            total_read.QuadPart += read;
+            total_written.QuadPart += written;
+            if (FAILED(hr) || read == 0)
+                break;
+        }
+        if (pcbRead)
+            *pcbRead = total_read;
+        if (pcbWritten)
+            *pcbWritten = total_written;
+        return FAILED(hr) ? hr : S_OK;
+    }
+    STDMETHOD(Commit)(DWORD grfCommitFlags)
+    {
+        if (m_data->hfile != INVALID_HANDLE_VALUE && m_data->bWritable && !FlushFileBuffers(m_data->hfile))
+            return HRESULT_FROM_WIN32(GetLastError());
+        return S_OK;
+    }
+    STDMETHOD(Revert)(void) { return S_OK; }
+    STDMETHOD(LockRegion)(ULARGE_INTEGER libOffset, ULARGE_INTEGER cb, DWORD dwLockType)
+    {
+        return STG_E_INVALIDFUNCTION;
+    }
+    STDMETHOD(UnlockRegion)(ULARGE_INTEGER libOffset, ULARGE_INTEGER cb, DWORD dwLockType)
+    {
+        return STG_E_INVALIDFUNCTION;
+    }
+    STDMETHOD(Stat)(STATSTG *pstatstg, DWORD grfStatFlag)
+    {
+        if (pstatstg == NULL)
+            return STG_E_INVALIDPOINTER;
+        ZeroMemory(pstatstg, sizeof(STATSTG));
+        pstatstg->type = STGTY_STREAM;
+        pstatstg->grfMode = m_data->bWritable ? STGM_READWRITE : STGM_READ;
+        return GetSize(&pstatstg->cbSize);
+    }
+    STDMETHOD(Clone)(IStream **ppstm)
+    {
+        if (ppstm == NULL)
+            return STG_E_INVALIDPOINTER;
+        EnterCriticalSection(&m_cs);
+        ULONGLONG pos = m_pos;
+        LeaveCriticalSection(&m_cs);
+        *ppstm = new CPyBufferStream(m_data, pos);
+        return *ppstm ? S_OK : E_OUTOFMEMORY;
+    }
+
+   private:
+    HRESULT GetSize(ULARGE_INTEGER *psize)
+    {
+        if (m_data->view.obj) {
+            psize->QuadPart = m_data->view.len;
+            return S_OK;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_data->hfile, &size))
+            return HRESULT_FROM_WIN32(GetLastError());
+        psize->QuadPart = size.QuadPart;
+        return S_OK;
+    }
+
+    LONG m_cRef;
+    PyBufferStreamData *m_data;
+    ULONGLONG m_pos;  // Each clone has its own position, so file streams use explicit offsets
+    CRITICAL_SECTION m_cs;
+};
+
+// @pymethod <o PyIStream>|pythoncom|CreateStreamOnBuffer|Creates a native stream over a buffer object or file handle
+// @comm Unlike wrapping a Python object that implements IStream, the returned stream
+// serves Read, Write, Seek and Stat calls without calling back into Python or acquiring the
+// Python lock, so it is much faster to hand to components that read in small chunks.
+// @comm A buffer object is kept exported, and so can't be resized, until the stream and all
+// its clones are released.  A buffer stream can't grow - writes past the end fail with
+// STG_E_MEDIUMFULL.<nl>
+// A file handle is duplicated, so the original may be closed.  Reads and writes use explicit
+// offsets so each clone has its own position, which means the handle must be for a file
+// rather than a pipe or other device, and must not be opened for overlapped I/O.
+PyObject *pythoncom_CreateStreamOnBuffer(PyObject *self, PyObject *args)
+{
+    PyObject *ob;
+    BOOL bWritable = FALSE;
+    if (!PyArg_ParseTuple(args, "O|i:CreateStreamOnBuffer",
+                          &ob,          // @pyparm object|data||A bytes, bytearray, memoryview or other object supporting
+                                        // the buffer protocol, or a <o PyHANDLE> to an open file.
+                          &bWritable))  // @pyparm bool|writable|False|Allow the stream to be written to.  For a
+                                        // buffer, it must be writable.  For a file, the handle must have write access.
+        return NULL;
+    PyBufferStreamData *data = (PyBufferStreamData *)calloc(1, sizeof(PyBufferStreamData));
+    if (data == NULL)
+        return PyErr_NoMemory();
+    data->cRef = 1;
+    data->hfile = INVALID_HANDLE_VALUE;
+    data->bWritable = bWritable;
+    if (PyObject_CheckBuffer(ob)) {
+        if (PyObject_GetBuffer(ob, &data->view, bWritable ? PyBUF_WRITABLE : PyBUF_SIMPLE) == -1) {
+            free(data);
+            return NULL;
+        }
+    }
+    else {
+        HANDLE hfile;
+        if (!PyWinObject_AsHANDLE(ob, &hfile)) {
+            free(data);
+            return NULL;
+        }
+        if (!DuplicateHandle(GetCurrentProcess(), hfile, GetCurrentProcess(), &data->hfile, 0, FALSE,
+                             DUPLICATE_SAME_ACCESS)) {
+            free(data);
+            return PyWin_SetAPIError("DuplicateHandle");
+        }
+    }
+    IStream *pIStream = new CPyBufferStream(data, 0);
+    // The stream holds its own reference to the data
+    ReleasePyBufferStreamData(data);
+    return PyCom_PyObjectFromIUnknown(pIStream, IID_IStream, FALSE);
+}
+
 // @pymethod <o PyILockBytes>|pythoncom|CreateILockBytesOnHGlobal|Creates an ILockBytes interface based on global memory
 PyObject *pythoncom_CreateILockBytesOnHGlobal(PyObject *self, PyObject *args)
 {
@@ -17,6 +17,7 @@ generates Windows .hlp files.
 #include "PyFactory.h"
 #include "PyRecord.h"
 #include "PyComTypeObjects.h"
+#include "PyIMultiQI.h"
 #include "OleAcc.h"    // for ObjectFromLresult proto...
 #include "IAccess.h"   // for IAccessControl
 #include "pyerrors.h"  // for PyErr_Warn in 2.5 and earlier...
@@ -26,6 +27,14 @@ extern int PyCom_RegisterCoreIIDs(PyObject *dict);
 extern int PyCom_RegisterCoreSupport(void);
 
 extern PyObject *pythoncom_IsGatewayRegistered(PyObject *self, PyObject *args);
+extern PyObject *pythoncom_EnableCallStats(PyObject *self, PyObject *args);
+extern PyObject *pythoncom_GetCallStats(PyObject *self, PyObject *args);
+extern PyObject *pythoncom_EnableObjectStats(PyObject *self, PyObject *args);
+extern PyObject *pythoncom_GetObjectStats(PyObject *self, PyObject *args);
+extern PyObject *pythoncom_CreateConnectionSinks(PyObject *self, PyObject *args);
+extern PyObject *pythoncom_EnableInterfaceIdentity(PyObject *self, PyObject *args);
+extern void PyCom_GetRegistrationStats(int *pNumPending, int *pNumRegistered);
+extern PyTypeObject *PyCom_ConnectionSinksType;
 
 extern PyObject *g_obPyCom_MapIIDToType;
 extern PyObject *g_obPyCom_MapGatewayIIDToName;
@@ -55,6 +64,7 @@ extern PyObject *pythoncom_ReadClassStg(PyObject *self, PyObject *args);
 extern PyObject *pythoncom_WriteClassStm(PyObject *self, PyObject *args);
 extern PyObject *pythoncom_ReadClassStm(PyObject *self, PyObject *args);
 extern PyObject *pythoncom_CreateStreamOnHGlobal(PyObject *self, PyObject *args);
+extern PyObject *pythoncom_CreateStreamOnBuffer(PyObject *self, PyObject *args);
 extern PyObject *pythoncom_CreateILockBytesOnHGlobal(PyObject *self, PyObject *args);
 
 extern PyObject *pythoncom_GetRecordFromGuids(PyObject *self, PyObject *args);
@@ -85,6 +95,10 @@ LPCTSTR GetFacilityString(SCODE sc);
 /* Debug/Test helpers */
 extern LONG _PyCom_GetInterfaceCount(void);
 extern LONG _PyCom_GetGatewayCount(void);
+extern BOOL PyCom_VariantFromPyObjectGeneric(PyObject *obj, VARIANT *var);
+extern BOOL PyCom_EnableSafeArrayBuffers(BOOL bEnable);
+extern UINT PyCom_EnableBstrBuffers(UINT cchMin);
+extern BOOL PyCom_EnableRecordArrays(BOOL bEnable);
 
 // Function pointers we load at runtime.
 #define CHECK_PFN(fname)    \
@@ -260,26 +274,12 @@ static PyObject *pythoncom_CoCreateInstanceEx(PyObject *self, PyObject *args)
         }
     }  // end scoping
 
-    result = PyTuple_New(numIIDs);
-    if (result == NULL)
-        goto done;
-    for (i = 0; i < numIIDs; i++) {
-        PyObject *obNew;
-        if (mqi[i].hr == 0) {
-            obNew = PyCom_PyObjectFromIUnknown(mqi[i].pItf, *mqi[i].pIID, FALSE);
-            mqi[i].pItf = NULL;
-            if (!obNew) {
-                Py_DECREF(result);
-                result = NULL;
-                goto done;
-            }
-        }
-        else {
-            obNew = Py_None;
-            Py_INCREF(Py_None);
-        }
-        PyTuple_SET_ITEM(result, i, obNew);
-    }
+    // @rdesc The result is a tuple with an item for each IID, in the same order.  Items are None for
+    // interfaces the object does not support.
+    // @comm All the interfaces are obtained by the activation itself, so for a remote server this
+    // is a single round trip.  Use <om PyIMultiQI.QueryMultipleInterfaces> to batch further queries
+    // on an existing proxy.
+    result = PyCom_PyObjectFromMULTI_QI(mqi, numIIDs);
 done:
     PYCOM_RELEASE(punk);
     if (serverInfo.pwszName)
@@ -514,7 +514,8 @@ static PyObject *pythoncom_GetInterfaceCount(PyObject *self, PyObject *args)
     return PyInt_FromLong(_PyCom_GetInterfaceCount());
     // @comm If is occasionally a good idea to call this function before your Python program
     // terminates.  If this function returns non-zero, then you still have PythonCOM objects
-    // alive in your program (possibly in global variables).
+    // alive in your program (possibly in global variables).  <om pythoncom.GetObjectStats>
+    // can show which interfaces they are.
 }
 
 // @pymethod int|pythoncom|_GetGatewayCount|Retrieves the number of gateway objects currently in existance
@@ -528,6 +529,236 @@ static PyObject *pythoncom_GetGatewayCount(PyObject *self, PyObject *args)
     return PyInt_FromLong(_PyCom_GetGatewayCount());
 }
 
+// @pymethod int|pythoncom|EnableBstrBuffers|Controls how large strings are returned.
+static PyObject *pythoncom_EnableBstrBuffers(PyObject *self, PyObject *args)
+{
+    UINT cchMin = 65536;
+    // @pyparm int|minLength|65536|Strings of at least this many characters are returned as
+    // <o PyBSTRBuffer> objects.  0 restores the default behaviour.
+    if (!PyArg_ParseTuple(args, "|I:EnableBstrBuffers", &cchMin))
+        return NULL;
+    // @rdesc The previous setting, 0 if they were disabled.
+    return PyLong_FromUnsignedLong(PyCom_EnableBstrBuffers(cchMin));
+    // @comm By default, every BSTR returned by COM is copied into a new Python
+    // string.  When enabled, large values are instead returned as <o PyBSTRBuffer>
+    // objects, which keep the BSTR itself - results fetched via IDispatch are not
+    // copied at all.  Such an object can be written to a file, hashed or decoded
+    // (via the buffer interface, as UTF-16-LE) and passed back to COM without a
+    // Python string ever being created; use str(ob) when a string is needed.
+}
+
+#ifndef MS_WINCE
+// @pymethod bool|pythoncom|EnableProgIDCache|Controls the process wide cache of ProgID to CLSID conversions.
+static PyObject *pythoncom_EnableProgIDCache(PyObject *self, PyObject *args)
+{
+    BOOL bEnable = TRUE;
+    BOOL bWatch = FALSE;
+    // @pyparm bool|enable|True|If False, every ProgID is looked up in the registry.
+    // @pyparm bool|watchRegistry|False|If True, the class registrations are watched, and
+    // the cache flushed whenever they change.
+    if (!PyArg_ParseTuple(args, "|ii:EnableProgIDCache", &bEnable, &bWatch))
+        return NULL;
+    // @rdesc The previous enabled state.
+    return PyBool_FromLong(PyWin_EnableProgIDCache(bEnable, bWatch));
+    // @comm The cache is enabled (without the registry watch) by default.  Every ProgID
+    // converted to a CLSID (for example, by win32com.client.Dispatch("Excel.Application"))
+    // is remembered, so the registry is only read the first time.  Without the registry
+    // watch, <om pywintypes.ClearIIDCache> must be called after a ProgID is re-registered
+    // with a different CLSID by some other process.
+}
+
+// @pymethod dict|pythoncom|GetProgIDCacheStats|Returns the statistics of the ProgID cache.
+static PyObject *pythoncom_GetProgIDCacheStats(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":GetProgIDCacheStats"))
+        return NULL;
+    PyWinProgIDCacheStats stats;
+    PyWin_GetProgIDCacheStats(&stats);
+    // @rdesc A dictionary with the keys: hits, misses, entries (the ProgIDs now cached),
+    // invalidations (the number of times the cache has been flushed), enabled and watching
+    // (whether the registry is being watched).
+    return Py_BuildValue("{s:l,s:l,s:l,s:l,s:N,s:N}", "hits", stats.hits, "misses", stats.misses, "entries",
+                         stats.entries, "invalidations", stats.invalidations, "enabled",
+                         PyBool_FromLong(stats.enabled), "watching", PyBool_FromLong(stats.watching));
+}
+#endif  // MS_WINCE
+
+// @pymethod int|pythoncom|SetNumericConversion|Controls how currency and decimal values are returned.
+static PyObject *pythoncom_SetNumericConversion(PyObject *self, PyObject *args)
+{
+    int flags;
+    // @pyparm int|flags||A combination of pythoncom.CY_AS_SCALED_INT and pythoncom.DECIMAL_AS_DECIMAL,
+    // or 0 for the default behaviour.
+    if (!PyArg_ParseTuple(args, "i:SetNumericConversion", &flags))
+        return NULL;
+    // @rdesc The previous flags.
+    return PyInt_FromLong(PyCom_SetNumericConversion(flags));
+    // @comm By default, VT_CY values are returned as decimal.Decimal objects and
+    // VT_DECIMAL values as strings.  With CY_AS_SCALED_INT, currency values are
+    // instead returned as ints holding the value times 10000, which is how COM
+    // stores them, so no Decimal is created at all; such ints are then also accepted
+    // where a currency value is expected.  With DECIMAL_AS_DECIMAL, VT_DECIMAL values
+    // are returned as exact decimal.Decimal objects.  Both apply to SAFEARRAYs too.
+}
+
+// @pymethod [(object, ...), ...]|pythoncom|GetRecordsetRows|Fetches rows from an ADO Recordset as a list of tuples.
+static PyObject *pythoncom_GetRecordsetRows(PyObject *self, PyObject *args)
+{
+    PyObject *obRecordset;
+    long numRows = -1;
+    if (!PyArg_ParseTuple(args, "O|l:GetRecordsetRows",
+                          &obRecordset,  // @pyparm <o PyIDispatch>|recordset||The ADO Recordset object.
+                          &numRows))     // @pyparm int|rows|-1|The number of rows to fetch, or -1 (adGetRowsRest)
+                                         // for all remaining rows.
+        return NULL;
+    IDispatch *pDisp;
+    if (!PyCom_InterfaceFromPyInstanceOrObject(obRecordset, IID_IDispatch, (void **)&pDisp, FALSE))
+        return NULL;
+    OLECHAR name[] = L"GetRows";
+    OLECHAR *pName = name;
+    DISPID dispid;
+    VARIANT arg, result;
+    VariantInit(&arg);
+    V_VT(&arg) = VT_I4;
+    V_I4(&arg) = numRows;
+    VariantInit(&result);
+    DISPPARAMS params = {&arg, NULL, 1, 0};
+    EXCEPINFO excepInfo;
+    memset(&excepInfo, 0, sizeof(excepInfo));
+    UINT argErr = (UINT)-1;
+    HRESULT hr;
+    PY_INTERFACE_PRECALL;
+    hr = pDisp->GetIDsOfNames(IID_NULL, &pName, 1, LOCALE_USER_DEFAULT, &dispid);
+    if (SUCCEEDED(hr))
+        hr = pDisp->Invoke(dispid, IID_NULL, LOCALE_USER_DEFAULT, DISPATCH_METHOD, &params, &result, &excepInfo,
+                           &argErr);
+    PY_INTERFACE_POSTCALL;
+    PyObject *ret = NULL;
+    if (hr == DISP_E_EXCEPTION)
+        PyCom_BuildPyExceptionFromEXCEPINFO(hr, &excepInfo);
+    else if (FAILED(hr))
+        PyCom_BuildPyException(hr, pDisp, IID_IDispatch);
+    else if (V_VT(&result) != (VT_ARRAY | VT_VARIANT))
+        PyErr_SetString(PyExc_TypeError, "GetRows did not return an array of VARIANTs");
+    else
+        ret = PyCom_PyObjectRowsFromSAFEARRAY(V_ARRAY(&result));
+    VariantClear(&result);
+    pDisp->Release();
+    return ret;
+    // @comm This calls the Recordset's GetRows method, but the 2 dimensional array it returns
+    // (fields by rows) is converted directly to a list with a tuple for each row, rather than
+    // the tuple of field columns returned when GetRows is called via win32com.
+}
+
+// @pymethod bool|pythoncom|EnableSafeArrayBuffers|Controls how SAFEARRAYs of simple numeric types are returned.
+static PyObject *pythoncom_EnableSafeArrayBuffers(PyObject *self, PyObject *args)
+{
+    BOOL bEnable = TRUE;
+    // @pyparm bool|enable|True|If True, SAFEARRAYs of simple numeric types are returned as memoryview objects.
+    if (!PyArg_ParseTuple(args, "|i:EnableSafeArrayBuffers", &bEnable))
+        return NULL;
+    // @rdesc The previous setting.
+    return PyBool_FromLong(PyCom_EnableSafeArrayBuffers(bEnable));
+    // @comm By default, a SAFEARRAY is converted to a tuple (of tuples, for
+    // multi-dimensional arrays) with a Python object for each element.  When
+    // enabled, arrays of VT_I1, VT_I2, VT_I4, VT_I8, VT_INT, their unsigned
+    // equivalents, VT_R4 and VT_R8 are instead copied in one operation into a
+    // read-only memoryview object with the same shape, which can be passed
+    // directly to array or numpy functions.  Arrays of VT_UI1 continue to be
+    // returned as bytes, and VT_VARIANT arrays are not affected.
+    // <nl>Regardless of this setting, objects supporting the buffer interface
+    // with a simple numeric format (eg, array.array objects, numpy arrays or
+    // cast memoryview objects) are always copied directly into a SAFEARRAY of
+    // the matching type.
+    // <nl>Note this setting is global to the process, so libraries should
+    // restore the previous value once they are done.
+}
+
+// @pymethod bool|pythoncom|EnableRecordArrays|Controls how SAFEARRAYs of records are returned.
+static PyObject *pythoncom_EnableRecordArrays(PyObject *self, PyObject *args)
+{
+    BOOL bEnable = TRUE;
+    // @pyparm bool|enable|True|If True, arrays of records are returned as <o PyRecordArray> objects.
+    if (!PyArg_ParseTuple(args, "|i:EnableRecordArrays", &bEnable))
+        return NULL;
+    // @rdesc The previous setting.
+    return PyBool_FromLong(PyCom_EnableRecordArrays(bEnable));
+    // @comm By default, an array of records (whether a VT_RECORD SAFEARRAY, or an
+    // array inside another record) is returned as a tuple, with a <o PyRecord>
+    // object for each element.  When enabled, a <o PyRecordArray> sequence is
+    // returned instead, which only creates record objects as elements are accessed,
+    // and can fetch a single field from all elements via its GetField method.
+    // <nl>Note this setting is global to the process, so libraries should
+    // restore the previous value once they are done.
+}
+
+// @pymethod |pythoncom|InvalidateDispIDCache|Discards the names remembered by Python COM servers.
+static PyObject *pythoncom_InvalidateDispIDCache(PyObject *self, PyObject *args)
+{
+    PyObject *obUnk = Py_None;
+    IUnknown *punk = NULL;
+    // @pyparm <o PyIUnknown>|ob|None|An object previously returned by <om pythoncom.WrapObject>, or None to
+    // invalidate the cache of every Python COM object.
+    if (!PyArg_ParseTuple(args, "|O:InvalidateDispIDCache", &obUnk))
+        return NULL;
+    if (!PyCom_InterfaceFromPyInstanceOrObject(obUnk, IID_IUnknown, (void **)&punk, TRUE))
+        return NULL;
+    PY_INTERFACE_PRECALL;
+    PyCom_InvalidateGatewayNameCache(punk);
+    if (punk)
+        punk->Release();
+    PY_INTERFACE_POSTCALL;
+    Py_INCREF(Py_None);
+    return Py_None;
+    // @comm When a client calls IDispatch::GetIDsOfNames on a Python COM object, the
+    // DISPID returned by the policy is remembered, so later lookups of the same name
+    // (ignoring case) are answered without calling the policy or acquiring the
+    // Python thread lock.  Only names which were successfully resolved are remembered.
+    // <nl>If the names supported by an object, or the DISPIDs assigned to them, change
+    // once they have been looked up, call this function so the policy is consulted again.
+    // Passing an object which is not a Python COM object does nothing.
+}
+
+// @pymethod float|pythoncom|_TimeVariantConversion|Measures the cost of converting Python objects to VARIANTs.
+static PyObject *pythoncom_TimeVariantConversion(PyObject *self, PyObject *args)
+{
+    PyObject *obValues;
+    int iterations = 1000;
+    BOOL bFastPath = TRUE;
+    // @pyparm [object, ...]|values||The objects to convert.  Each object is converted once per iteration.
+    // @pyparm int|iterations|1000|The number of times to convert the values.
+    // @pyparm bool|fastPath|True|If False, the exact-type fast path is skipped, so the time reported is
+    // for the generic conversion code.
+    if (!PyArg_ParseTuple(args, "O|ii:_TimeVariantConversion", &obValues, &iterations, &bFastPath))
+        return NULL;
+    DWORD numValues;
+    TmpPyObject values = PyWinSequence_Tuple(obValues, &numValues);
+    if (values == NULL)
+        return NULL;
+    if (numValues == 0 || iterations <= 0)
+        return PyErr_Format(PyExc_ValueError, "At least one value and one iteration must be specified");
+    LARGE_INTEGER freq, start, end;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    for (int iter = 0; iter < iterations; iter++) {
+        for (DWORD i = 0; i < numValues; i++) {
+            VARIANT var;
+            VariantInit(&var);
+            PyObject *ob = PyTuple_GET_ITEM((PyObject *)values, i);
+            BOOL ok = bFastPath ? PyCom_VariantFromPyObject(ob, &var) : PyCom_VariantFromPyObjectGeneric(ob, &var);
+            VariantClear(&var);
+            if (!ok)
+                return NULL;
+        }
+    }
+    QueryPerformanceCounter(&end);
+    // @rdesc The result is the average time, in seconds, of a single conversion.
+    double elapsed = (double)(end.QuadPart - start.QuadPart) / (double)freq.QuadPart;
+    return PyFloat_FromDouble(elapsed / ((double)iterations * numValues));
+    // @comm This function is intended for benchmarking the COM marshalling code - see
+    // win32com\test\benchVariants.py
+}
+
 #ifndef MS_WINCE
 // @pymethod <o PyIUnknown>|pythoncom|GetActiveObject|Retrieves an object representing a running object registered with
 // OLE
@@ -1207,6 +1438,271 @@ static PyObject *pythoncom_CoGetInterfaceAndReleaseStream(PyObject *self, PyObje
     return PyCom_PyObjectFromIUnknown(pUnk, iid, /*BOOL bAddRef*/ FALSE);
 }
 
+// @object PyInterfaceHandle|An interface registered in the Global Interface Table, which
+// any apartment in the process can get a proxy for.
+// @comm Created by <om pythoncom.RegisterInterfaceHandle>.  The interface is registered
+// once, and the proxy unmarshalled for each apartment is cached - so only the first
+// <om PyInterfaceHandle.Get> in an apartment calls into the GIT, rather than needing a
+// new marshal stream for every handoff between threads.
+// <nl>Apartments are identified per thread for STA threads, while every thread in the
+// MTA shares one proxy.  A proxy must be released in the apartment it was created for,
+// so a thread which is about to call <om pythoncom.CoUninitialize> should call
+// <om PyInterfaceHandle.Forget> first.
+class PyInterfaceHandle : public PyObject {
+   public:
+    PyInterfaceHandle(IGlobalInterfaceTable *pGIT, DWORD dwCookie, REFIID riid);
+    ~PyInterfaceHandle();
+
+    static void tp_dealloc(PyObject *ob);
+    static PyObject *Get(PyObject *self, PyObject *args);
+    static PyObject *Forget(PyObject *self, PyObject *args);
+    static PyObject *Revoke(PyObject *self, PyObject *args);
+    static PyObject *get_cookie(PyObject *self, void *);
+    static PyObject *get_iid(PyObject *self, void *);
+    static struct PyMethodDef methods[];
+    static struct PyGetSetDef getset[];
+    static PyTypeObject Type;
+
+    IGlobalInterfaceTable *m_pGIT;
+    DWORD m_dwCookie;  // 0 once revoked.
+    IID m_iid;
+    PyObject *m_obProxies;  // apartment key -> interface object
+};
+
+// The key PyInterfaceHandle caches the calling apartment's proxy under -
+// each STA is keyed by its thread ID, and the MTA and NA have fixed keys
+// no thread ID can collide with.
+static HRESULT GetApartmentKey(DWORD *pKey)
+{
+    IComThreadingInfo *pInfo;
+    HRESULT hr = CoGetObjectContext(IID_IComThreadingInfo, (void **)&pInfo);
+    if (FAILED(hr))
+        return hr;
+    APTTYPE aptType;
+    hr = pInfo->GetCurrentApartmentType(&aptType);
+    pInfo->Release();
+    if (FAILED(hr))
+        return hr;
+    switch (aptType) {
+        case APTTYPE_STA:
+        case APTTYPE_MAINSTA:
+            *pKey = GetCurrentThreadId();
+            break;
+        case APTTYPE_NA:
+            *pKey = (DWORD)-1;
+            break;
+        default:
+            *pKey = 0;
+            break;
+    }
+    return S_OK;
+}
+
+PyInterfaceHandle::PyInterfaceHandle(IGlobalInterfaceTable *pGIT, DWORD dwCookie, REFIID riid)
+{
+    ob_type = &PyInterfaceHandle::Type;
+    _Py_NewReference(this);
+    pGIT->AddRef();
+    m_pGIT = pGIT;
+    m_dwCookie = dwCookie;
+    m_iid = riid;
+    m_obProxies = PyDict_New();
+}
+
+PyInterfaceHandle::~PyInterfaceHandle()
+{
+    Py_XDECREF(m_obProxies);
+    if (m_dwCookie) {
+        PY_INTERFACE_PRECALL;
+        m_pGIT->RevokeInterfaceFromGlobal(m_dwCookie);
+        PY_INTERFACE_POSTCALL;
+    }
+    m_pGIT->Release();
+}
+
+void PyInterfaceHandle::tp_dealloc(PyObject *ob) { delete (PyInterfaceHandle *)ob; }
+
+// @pymethod <o PyIUnknown>|PyInterfaceHandle|Get|Returns the interface, usable from the
+// calling thread's apartment.
+PyObject *PyInterfaceHandle::Get(PyObject *self, PyObject *args)
+{
+    PyInterfaceHandle *pih = (PyInterfaceHandle *)self;
+    if (!PyArg_ParseTuple(args, ":Get"))
+        return NULL;
+    if (!pih->m_dwCookie)
+        return PyCom_BuildPyException(E_HANDLE);
+    DWORD key;
+    HRESULT hr = GetApartmentKey(&key);
+    if (FAILED(hr))
+        return PyCom_BuildPyException(hr);
+    PyObject *obKey = PyLong_FromUnsignedLong(key);
+    if (!obKey)
+        return NULL;
+    PyObject *ret = PyDict_GetItem(pih->m_obProxies, obKey);
+    if (ret) {
+        Py_DECREF(obKey);
+        Py_INCREF(ret);
+        return ret;
+    }
+    IUnknown *pUnk;
+    PY_INTERFACE_PRECALL;
+    hr = pih->m_pGIT->GetInterfaceFromGlobal(pih->m_dwCookie, pih->m_iid, (void **)&pUnk);
+    PY_INTERFACE_POSTCALL;
+    if (FAILED(hr)) {
+        Py_DECREF(obKey);
+        return PyCom_BuildPyException(hr);
+    }
+    ret = PyCom_PyObjectFromIUnknown(pUnk, pih->m_iid, /*BOOL bAddRef*/ FALSE);
+    // Another thread in this apartment may have got here first - either is fine.
+    if (ret && PyDict_SetItem(pih->m_obProxies, obKey, ret) != 0)
+        Py_CLEAR(ret);
+    Py_DECREF(obKey);
+    return ret;
+}
+
+// @pymethod |PyInterfaceHandle|Forget|Releases the proxy cached for the calling thread's apartment.
+PyObject *PyInterfaceHandle::Forget(PyObject *self, PyObject *args)
+{
+    PyInterfaceHandle *pih = (PyInterfaceHandle *)self;
+    if (!PyArg_ParseTuple(args, ":Forget"))
+        return NULL;
+    DWORD key;
+    HRESULT hr = GetApartmentKey(&key);
+    if (FAILED(hr))
+        return PyCom_BuildPyException(hr);
+    PyObject *obKey = PyLong_FromUnsignedLong(key);
+    if (!obKey)
+        return NULL;
+    if (PyDict_DelItem(pih->m_obProxies, obKey) != 0)
+        PyErr_Clear();  // Nothing cached - nothing to do.
+    Py_DECREF(obKey);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod |PyInterfaceHandle|Revoke|Revokes the interface from the Global Interface Table,
+// and releases every cached proxy.
+// @comm This happens automatically when the object is destroyed.
+PyObject *PyInterfaceHandle::Revoke(PyObject *self, PyObject *args)
+{
+    PyInterfaceHandle *pih = (PyInterfaceHandle *)self;
+    if (!PyArg_ParseTuple(args, ":Revoke"))
+        return NULL;
+    PyDict_Clear(pih->m_obProxies);
+    if (pih->m_dwCookie) {
+        HRESULT hr;
+        DWORD dwCookie = pih->m_dwCookie;
+        pih->m_dwCookie = 0;
+        PY_INTERFACE_PRECALL;
+        hr = pih->m_pGIT->RevokeInterfaceFromGlobal(dwCookie);
+        PY_INTERFACE_POSTCALL;
+        if (FAILED(hr))
+            return PyCom_BuildPyException(hr);
+    }
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyObject *PyInterfaceHandle::get_cookie(PyObject *self, void *)
+{
+    return PyLong_FromUnsignedLong(((PyInterfaceHandle *)self)->m_dwCookie);
+}
+
+PyObject *PyInterfaceHandle::get_iid(PyObject *self, void *)
+{
+    return PyWinObject_FromIID(((PyInterfaceHandle *)self)->m_iid);
+}
+
+struct PyMethodDef PyInterfaceHandle::methods[] = {
+    {"Get", PyInterfaceHandle::Get, 1},  // @pymeth Get|Returns the interface, usable from the calling apartment.
+    {"Forget", PyInterfaceHandle::Forget,
+     1},  // @pymeth Forget|Releases the proxy cached for the calling apartment.
+    {"Revoke", PyInterfaceHandle::Revoke, 1},  // @pymeth Revoke|Revokes the interface from the GIT.
+    {NULL}};
+
+struct PyGetSetDef PyInterfaceHandle::getset[] = {
+    // @prop int|cookie|The GIT cookie, or 0 once revoked.
+    {"cookie", PyInterfaceHandle::get_cookie, NULL},
+    // @prop <o PyIID>|iid|The IID of the interface.
+    {"iid", PyInterfaceHandle::get_iid, NULL},
+    {NULL}};
+
+PyTypeObject PyInterfaceHandle::Type = {
+    PYWIN_OBJECT_HEAD "PyInterfaceHandle",
+    sizeof(PyInterfaceHandle),
+    0,
+    PyInterfaceHandle::tp_dealloc, /* tp_dealloc */
+    0,                             /* tp_print */
+    0,                             /* tp_getattr */
+    0,                             /* tp_setattr */
+    0,                             /* tp_compare */
+    0,                             /* tp_repr */
+    0,                             /* tp_as_number */
+    0,                             /* tp_as_sequence */
+    0,                             /* tp_as_mapping */
+    0,                             /* tp_hash */
+    0,                             /* tp_call */
+    0,                             /* tp_str */
+    PyObject_GenericGetAttr,       /* tp_getattro */
+    0,                             /* tp_setattro */
+    0,                             /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,            /* tp_flags */
+    0,                             /* tp_doc */
+    0,                             /* tp_traverse */
+    0,                             /* tp_clear */
+    0,                             /* tp_richcompare */
+    0,                             /* tp_weaklistoffset */
+    0,                             /* tp_iter */
+    0,                             /* tp_iternext */
+    PyInterfaceHandle::methods,    /* tp_methods */
+    0,                             /* tp_members */
+    PyInterfaceHandle::getset,     /* tp_getset */
+};
+
+// The process-wide Global Interface Table, created on first use.
+static IGlobalInterfaceTable *g_pGIT = NULL;
+
+// @pymethod <o PyInterfaceHandle>|pythoncom|RegisterInterfaceHandle|Registers an interface in
+// the Global Interface Table, returning a handle any thread can get a proxy from.
+static PyObject *pythoncom_RegisterInterfaceHandle(PyObject *self, PyObject *args)
+{
+    PyObject *obUnk, *obIID = NULL;
+    if (!PyArg_ParseTuple(args, "O|O:RegisterInterfaceHandle",
+                          &obUnk,   // @pyparm <o PyIUnknown>|unk||The interface to register.
+                          &obIID))  // @pyparm <o PyIID>|iid|IID_IDispatch|The IID of the interface.
+        return NULL;
+    IID iid = IID_IDispatch;
+    if (obIID && !PyWinObject_AsIID(obIID, &iid))
+        return NULL;
+    IUnknown *pUnk;
+    if (!PyCom_InterfaceFromPyInstanceOrObject(obUnk, iid, (void **)&pUnk, FALSE))
+        return NULL;
+    HRESULT hr = S_OK;
+    DWORD dwCookie = 0;
+    PY_INTERFACE_PRECALL;
+    if (g_pGIT == NULL) {
+        IGlobalInterfaceTable *pGIT;
+        hr = CoCreateInstance(CLSID_StdGlobalInterfaceTable, NULL, CLSCTX_INPROC_SERVER, IID_IGlobalInterfaceTable,
+                              (void **)&pGIT);
+        // The GIT is a singleton, so losing a race just costs a reference.
+        if (SUCCEEDED(hr) && InterlockedCompareExchangePointer((PVOID *)&g_pGIT, pGIT, NULL) != NULL)
+            pGIT->Release();
+    }
+    if (SUCCEEDED(hr))
+        hr = g_pGIT->RegisterInterfaceInGlobal(pUnk, iid, &dwCookie);
+    pUnk->Release();
+    PY_INTERFACE_POSTCALL;
+    if (FAILED(hr))
+        return PyCom_BuildPyException(hr);
+    PyInterfaceHandle *ret = new PyInterfaceHandle(g_pGIT, dwCookie, iid);
+    if (!ret->m_obProxies) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    // @comm See <o PyInterfaceHandle>.
+    return ret;
+}
+
 // @pymethod <o PyIUnknown>|pythoncom|CoCreateFreeThreadedMarshaler|Creates an aggregatable object capable of
 // context-dependent marshaling.
 static PyObject *pythoncom_CoCreateFreeThreadedMarshaler(PyObject *self, PyObject *args)
@@ -1969,6 +2465,8 @@ static struct PyMethodDef pythoncom_methods[] = {
      1},  // @pymeth _GetInterfaceCount|Retrieves the number of interface objects currently in existance
     {"_GetGatewayCount", pythoncom_GetGatewayCount,
      1},  // @pymeth _GetInterfaceCount|Retrieves the number of gateway objects currently in existance
+    {"_TimeVariantConversion", pythoncom_TimeVariantConversion,
+     1},  // @pymeth _TimeVariantConversion|Measures the cost of converting Python objects to VARIANTs.
 #ifndef MS_WINCE
     {"CoCreateFreeThreadedMarshaler", pythoncom_CoCreateFreeThreadedMarshaler,
      1},  // @pymeth CoCreateFreeThreadedMarshaler|Creates an aggregatable object capable of context-dependent
@@ -2025,6 +2523,8 @@ static struct PyMethodDef pythoncom_methods[] = {
     {"connect", pythoncom_connect, 1},
     {"CreateGuid", pythoncom_createguid, 1},        // @pymeth CreateGuid|Creates a new, unique GUIID.
     {"CreateBindCtx", pythoncom_CreateBindCtx, 1},  // @pymeth CreateBindCtx|Obtains a <o PyIBindCtx> object.
+    {"CreateConnectionSinks", pythoncom_CreateConnectionSinks,
+     1},  // @pymeth CreateConnectionSinks|Creates an empty native list of connection point sinks.
     {"CreateFileMoniker", pythoncom_CreateFileMoniker,
      1},  // @pymeth CreateFileMoniker|Creates a file moniker given a file name.
     {"CreateItemMoniker", pythoncom_CreateItemMoniker,
@@ -2043,9 +2543,38 @@ static struct PyMethodDef pythoncom_methods[] = {
 #endif                                                // MS_WINCE
     {"CreateStreamOnHGlobal", pythoncom_CreateStreamOnHGlobal,
      1},  // @pymeth CreateStreamOnHGlobal|Creates an in-memory stream storage object
+    {"CreateStreamOnBuffer", pythoncom_CreateStreamOnBuffer,
+     1},  // @pymeth CreateStreamOnBuffer|Creates a native stream over a buffer object or file handle
     {"CreateILockBytesOnHGlobal", pythoncom_CreateILockBytesOnHGlobal,
      1},  // @pymeth CreateILockBytesOnHGlobal|Creates an ILockBytes interface based on global memory
 
+    {"EnableCallStats", pythoncom_EnableCallStats,
+     1},  // @pymeth EnableCallStats|Enables or disables the recording of IDispatch call statistics.
+    {"EnableInterfaceIdentity", pythoncom_EnableInterfaceIdentity,
+     1},  // @pymeth EnableInterfaceIdentity|Enables or disables reusing interface objects.
+    {"EnableObjectStats", pythoncom_EnableObjectStats,
+     1},  // @pymeth EnableObjectStats|Enables or disables counting live interface objects and gateways.
+    {"GetStartupStats", pythoncom_GetStartupStats,
+     1},  // @pymeth GetStartupStats|Returns where the time went when pythoncom was imported.
+    {"EnableBstrBuffers", pythoncom_EnableBstrBuffers,
+     1},  // @pymeth EnableBstrBuffers|Controls how large strings are returned.
+    {"EnableSafeArrayBuffers", pythoncom_EnableSafeArrayBuffers,
+     1},  // @pymeth EnableSafeArrayBuffers|Controls how SAFEARRAYs of simple numeric types are returned.
+    {"SetNumericConversion", pythoncom_SetNumericConversion,
+     1},  // @pymeth SetNumericConversion|Controls how currency and decimal values are returned.
+    {"GetRecordsetRows", pythoncom_GetRecordsetRows,
+     1},  // @pymeth GetRecordsetRows|Fetches rows from an ADO Recordset as a list of tuples.
+#ifndef MS_WINCE
+    {"EnableProgIDCache", pythoncom_EnableProgIDCache,
+     1},  // @pymeth EnableProgIDCache|Controls the process wide cache of ProgID to CLSID conversions.
+#endif  // MS_WINCE
+    {"InvalidateDispIDCache", pythoncom_InvalidateDispIDCache,
+     1},  // @pymeth InvalidateDispIDCache|Discards the names remembered by Python COM servers.
+    {"RegisterInterfaceHandle", pythoncom_RegisterInterfaceHandle,
+     1},  // @pymeth RegisterInterfaceHandle|Registers an interface in the Global Interface Table, returning a handle
+          // any thread can get a proxy from.
+    {"EnableRecordArrays", pythoncom_EnableRecordArrays,
+     1},  // @pymeth EnableRecordArrays|Controls how SAFEARRAYs of records are returned.
     {"EnableQuitMessage", pythoncom_EnableQuitMessage,
      1},  // @pymeth EnableQuitMessage|Indicates the thread PythonCOM should post a WM_QUIT message to.
     {"FUNCDESC", Py_NewFUNCDESC, 1},  // @pymeth FUNCDESC|Returns a new <o FUNCDESC> object.
@@ -2055,8 +2584,16 @@ static struct PyMethodDef pythoncom_methods[] = {
     {"GetClassFile", pythoncom_GetClassFile,
      1},  // @pymeth GetClassFile|Supplies the CLSID associated with the given filename.
 #endif    // MS_WINCE
+    {"GetCallStats", pythoncom_GetCallStats,
+     1},  // @pymeth GetCallStats|Returns the IDispatch call statistics recorded so far.
     {"GetFacilityString", pythoncom_GetFacilityString,
      1},  // @pymeth GetFacilityString|Returns the facility string, given an OLE scode.
+    {"GetObjectStats", pythoncom_GetObjectStats,
+     1},  // @pymeth GetObjectStats|Returns the live interface object and gateway counts by IID and class.
+#ifndef MS_WINCE
+    {"GetProgIDCacheStats", pythoncom_GetProgIDCacheStats,
+     1},  // @pymeth GetProgIDCacheStats|Returns the statistics of the ProgID cache.
+#endif  // MS_WINCE
     {"GetRecordFromGuids", pythoncom_GetRecordFromGuids,
      1},  // @pymeth GetRecordFromGuids|Creates a new record object from the given GUIDs
     {"GetRecordFromTypeInfo", pythoncom_GetRecordFromTypeInfo,
@@ -2184,6 +2721,57 @@ static struct PyMethodDef pythoncom_methods[] = {
                     // thread
     {NULL, NULL}};
 
+// Times at the end of each part of the module initialisation, for GetStartupStats.
+static const char *g_startupPhaseNames[] = {"CoInitialize", "Registration", "IIDs", "Types", "Constants"};
+#define NUM_STARTUP_PHASES ((int)(sizeof(g_startupPhaseNames) / sizeof(g_startupPhaseNames[0])))
+static LARGE_INTEGER g_startupTimes[NUM_STARTUP_PHASES + 1];
+#define STARTUP_PHASE_DONE(n) QueryPerformanceCounter(&g_startupTimes[(n) + 1])
+
+// @pymethod dict|pythoncom|GetStartupStats|Returns where the time went when pythoncom was imported.
+// @comm Interface types and gateways, for pythoncom and for extension modules such as
+// win32com.shell, are registered the first time their IID or name is used rather than when
+// the module is imported, so short-lived processes only pay for the interfaces they use.
+// @rdesc The result is a dictionary with the time in seconds taken to initialize COM (CoInitialize),
+// to create the interface maps (Registration), to add the IIDs and exceptions (IIDs), to set up the other
+// types (Types) and to add constants (Constants), with the Total.  InterfacesPending is the number of
+// interfaces not yet registered, and InterfacesRegistered the number registered as they were needed.
+PyObject *pythoncom_GetStartupStats(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":GetStartupStats"))
+        return NULL;
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    PyObject *ret = PyDict_New();
+    if (ret == NULL)
+        return NULL;
+    for (int i = 0; i <= NUM_STARTUP_PHASES; i++) {
+        LONGLONG start = g_startupTimes[i == NUM_STARTUP_PHASES ? 0 : i].QuadPart;
+        LONGLONG end = g_startupTimes[i == NUM_STARTUP_PHASES ? i : i + 1].QuadPart;
+        PyObject *obTime = PyFloat_FromDouble(end > start ? (double)(end - start) / freq.QuadPart : 0.0);
+        if (obTime == NULL ||
+            PyDict_SetItemString(ret, i == NUM_STARTUP_PHASES ? "Total" : g_startupPhaseNames[i], obTime) != 0) {
+            Py_XDECREF(obTime);
+            Py_DECREF(ret);
+            return NULL;
+        }
+        Py_DECREF(obTime);
+    }
+    int numPending, numRegistered;
+    PyCom_GetRegistrationStats(&numPending, &numRegistered);
+    PyObject *obPending = PyInt_FromLong(numPending);
+    PyObject *obRegistered = PyInt_FromLong(numRegistered);
+    if (obPending == NULL || obRegistered == NULL || PyDict_SetItemString(ret, "InterfacesPending", obPending) != 0 ||
+        PyDict_SetItemString(ret, "InterfacesRegistered", obRegistered) != 0) {
+        Py_XDECREF(obPending);
+        Py_XDECREF(obRegistered);
+        Py_DECREF(ret);
+        return NULL;
+    }
+    Py_DECREF(obPending);
+    Py_DECREF(obRegistered);
+    return ret;
+}
+
 int AddConstant(PyObject *dict, const char *key, long value)
 {
     PyObject *oval = PyInt_FromLong(value);
@@ -2210,6 +2798,7 @@ PYWIN_MODULE_INIT_FUNC(pythoncom)
 
     // Support a special sys.coinit_flags attribute to control us.
     DWORD coinit_flags = COINIT_APARTMENTTHREADED;
+    QueryPerformanceCounter(&g_startupTimes[0]);
 
     PyObject *obFlags = PySys_GetObject("coinit_flags");
     // No reference added to obFlags.
@@ -2226,6 +2815,7 @@ PYWIN_MODULE_INIT_FUNC(pythoncom)
         hr = PyCom_CoInitialize(NULL);
     // If HR fails, we really dont care - the import should work.  User can
     // manually CoInit() to see!
+    STARTUP_PHASE_DONE(0);
 
     PYWIN_MODULE_INIT_PREPARE(pythoncom, pythoncom_methods, "A module, encapsulating the OLE automation API");
 
@@ -2238,6 +2828,7 @@ PYWIN_MODULE_INIT_FUNC(pythoncom)
     PyDict_SetItemString(dict, "TypeIIDs", g_obPyCom_MapIIDToType);
     PyDict_SetItemString(dict, "ServerInterfaces", g_obPyCom_MapGatewayIIDToName);
     PyDict_SetItemString(dict, "InterfaceNames", g_obPyCom_MapInterfaceNameToIID);
+    STARTUP_PHASE_DONE(1);
 
     if (PyType_Ready(&PyOleEmptyType) == -1 ||
         PyType_Ready(&PyOleMissingType) == -1 ||
@@ -2282,16 +2873,19 @@ PYWIN_MODULE_INIT_FUNC(pythoncom)
     // Add the IIDs
     if (PyCom_RegisterCoreIIDs(dict) != 0)
         PYWIN_MODULE_INIT_RETURN_ERROR;
+    STARTUP_PHASE_DONE(2);
 
     // Initialize various non-interface types
     if (PyType_Ready(&PyFUNCDESC::Type) == -1 || PyType_Ready(&PySTGMEDIUM::Type) == -1 ||
         PyType_Ready(&PyTYPEATTR::Type) == -1 || PyType_Ready(&PyVARDESC::Type) == -1 ||
-        PyType_Ready(&PyRecord::Type) == -1)
+        PyType_Ready(&PyRecord::Type) == -1 || PyType_Ready(&PyRecordArray::Type) == -1 ||
+        PyType_Ready(&PyInterfaceHandle::Type) == -1 || PyType_Ready(PyCom_ConnectionSinksType) == -1)
         PYWIN_MODULE_INIT_RETURN_ERROR;
 
     // Setup our sub-modules
     if (!initunivgw(dict))
         PYWIN_MODULE_INIT_RETURN_ERROR;
+    STARTUP_PHASE_DONE(3);
 
     // Load function pointers.
     HMODULE hModOle32 = GetModuleHandle(_T("ole32.dll"));
@@ -2670,6 +3264,9 @@ PYWIN_MODULE_INIT_FUNC(pythoncom)
 
     ADD_CONSTANT(DESCKIND_FUNCDESC);
     ADD_CONSTANT(DESCKIND_VARDESC);
+    // Flags for SetNumericConversion
+    AddConstant(dict, "CY_AS_SCALED_INT", PYCOM_CY_AS_SCALED_INT);
+    AddConstant(dict, "DECIMAL_AS_DECIMAL", PYCOM_DECIMAL_AS_DECIMAL);
     // Expose the frozen flag, as Python itself doesnt!!
     // @prop int|frozen|1 if the host is a frozen program, else 0
     AddConstant(dict, "frozen", Py_FrozenFlag);
@@ -2715,5 +3312,6 @@ PYWIN_MODULE_INIT_FUNC(pythoncom)
     // @property int|pythoncom|dcom|1 if the system is DCOM aware, else 0.  Only Win95 without DCOM extensions should
     // return 0
 
+    STARTUP_PHASE_DONE(4);
     PYWIN_MODULE_INIT_RETURN_SUCCESS;
 }
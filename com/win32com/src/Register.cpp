@@ -58,6 +58,7 @@ generates Windows .hlp files.
 #include "PyIContext.h"
 #include "PyIEnumContextProps.h"
 #include "PyICancelMethodCalls.h"
+#include "PyIMultiQI.h"
 
 // PyObject *CLSIDMapping;  // Maps CLSIDs onto PyClassObjects
 PyObject *g_obPyCom_MapIIDToType = NULL;           // map of IID's to client types.
@@ -65,11 +66,14 @@ PyObject *g_obPyCom_MapGatewayIIDToName = NULL;    // map of IID's to names
 PyObject *g_obPyCom_MapInterfaceNameToIID = NULL;  // map of names to IID
 PyObject *g_obPyCom_MapServerIIDToGateway = NULL;  // map of IID's to gateways.
 
+extern void PyCom_ClearIIDTypeCache();
+
 // Register a Python on both the UID and Name maps.
 int PyCom_RegisterClientType(PyTypeObject *typeOb, const GUID *guid)
 {
     if (guid == NULL || g_obPyCom_MapIIDToType == NULL)
         return 0;
+    PyCom_ClearIIDTypeCache();
 
     PyObject *obiid = PyWinObject_FromIID(*guid);
     if (!obiid)
@@ -158,26 +162,303 @@ int PyWinType_Ready(PyTypeObject *pT)
     return PyType_Ready(pT);
 }
 
-int PyCom_RegisterSupportedInterfaces(const PyCom_InterfaceSupportInfo *pInterfaces, int numEntries)
+static int RegisterSupportedInterface(const PyCom_InterfaceSupportInfo *pInterface)
 {
-    // Register all interfaces, IID's, etc
-    int i;
-    for (i = numEntries; i--;) {
-        if (pInterfaces[i].pTypeOb)
-            if (PyWinType_Ready(pInterfaces[i].pTypeOb) == -1)
-                return -1;
-        if (pInterfaces[i].pTypeOb && PyCom_RegisterClientType(pInterfaces[i].pTypeOb, pInterfaces[i].pGUID) != 0)
+    if (pInterface->pTypeOb)
+        if (PyWinType_Ready(pInterface->pTypeOb) == -1)
+            return -1;
+    if (pInterface->pTypeOb && PyCom_RegisterClientType(pInterface->pTypeOb, pInterface->pGUID) != 0)
+        return -1;
+    if (pInterface->ctor != NULL) {
+        HRESULT hr = PyCom_RegisterGatewayObject(*pInterface->pGUID, pInterface->ctor, pInterface->interfaceName);
+        if (FAILED(hr))
             return -1;
-        if (pInterfaces[i].ctor != NULL) {
-            HRESULT hr =
-                PyCom_RegisterGatewayObject(*pInterfaces[i].pGUID, pInterfaces[i].ctor, pInterfaces[i].interfaceName);
-            if (FAILED(hr))
+    }
+    return 0;
+}
+
+// Interface tables are not registered as they are supplied - readying every
+// type and filling the maps for all of them is most of the cost of importing
+// pythoncom and the extension modules, while most programs use only a few.
+// Instead each table is remembered, and its entries are registered the first
+// time their IID or name is looked up in one of the maps.  The tables are
+// processed in the order supplied, and each table from its end as before, so
+// the maps end up as they would have if everything was registered at once.
+// Only used with the Python lock held.
+struct PendingInterfaces {
+    const PyCom_InterfaceSupportInfo *pInterfaces;
+    int numEntries;
+    int numPending;
+    BYTE *registered;  // flag for each entry
+    PendingInterfaces *next;
+};
+static PendingInterfaces *g_pendingFirst = NULL;
+static PendingInterfaces *g_pendingLast = NULL;
+static int g_numPending = 0;
+static int g_numRegistered = 0;
+
+static int RegisterPendingEntry(PendingInterfaces *pending, int i)
+{
+    // Flag it first, so finding it again while registering doesn't recurse.
+    pending->registered[i] = TRUE;
+    pending->numPending--;
+    g_numPending--;
+    g_numRegistered++;
+    return RegisterSupportedInterface(pending->pInterfaces + i);
+}
+
+// Register any pending entries for the IID (or, if name is not NULL, the
+// interface with that name).  Returns the number registered, or -1 on error.
+int PyCom_RegisterPendingInterface(REFIID iid, const char *name)
+{
+    int numFound = 0;
+    for (PendingInterfaces *pending = g_pendingFirst; pending && g_numPending; pending = pending->next) {
+        for (int i = pending->numEntries; pending->numPending && i--;) {
+            const PyCom_InterfaceSupportInfo *pInterface = pending->pInterfaces + i;
+            if (pending->registered[i])
+                continue;
+            if (name ? strcmp(pInterface->interfaceName, name) != 0 : *pInterface->pGUID != iid)
+                continue;
+            if (RegisterPendingEntry(pending, i) != 0)
                 return -1;
+            numFound++;
         }
     }
+    return numFound;
+}
+
+// Register everything still pending - needed before the maps are iterated.
+int PyCom_RegisterAllPendingInterfaces(void)
+{
+    for (PendingInterfaces *pending = g_pendingFirst; pending && g_numPending; pending = pending->next)
+        for (int i = pending->numEntries; pending->numPending && i--;)
+            if (!pending->registered[i] && RegisterPendingEntry(pending, i) != 0)
+                return -1;
+    return 0;
+}
+
+void PyCom_GetRegistrationStats(int *pNumPending, int *pNumRegistered)
+{
+    *pNumPending = g_numPending;
+    *pNumRegistered = g_numRegistered;
+}
+
+static void FreePendingInterfaces(void)
+{
+    while (g_pendingFirst) {
+        PendingInterfaces *next = g_pendingFirst->next;
+        delete[] g_pendingFirst->registered;
+        delete g_pendingFirst;
+        g_pendingFirst = next;
+    }
+    g_pendingLast = NULL;
+    g_numPending = 0;
+}
+
+int PyCom_RegisterSupportedInterfaces(const PyCom_InterfaceSupportInfo *pInterfaces, int numEntries)
+{
+    // Remember the interfaces, IID's, etc, to register as they are needed.
+    if (numEntries <= 0)
+        return 0;
+    PendingInterfaces *pending = new PendingInterfaces;
+    if (pending == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    pending->registered = new BYTE[numEntries];
+    if (pending->registered == NULL) {
+        delete pending;
+        PyErr_NoMemory();
+        return -1;
+    }
+    memset(pending->registered, 0, numEntries);
+    pending->pInterfaces = pInterfaces;
+    pending->numEntries = numEntries;
+    pending->numPending = numEntries;
+    pending->next = NULL;
+    if (g_pendingLast)
+        g_pendingLast->next = pending;
+    else
+        g_pendingFirst = pending;
+    g_pendingLast = pending;
+    g_numPending += numEntries;
     return 0;
 }
 
+/////////////////////////////////////////////////////////////////////////////////
+//
+// The maps exposed to Python (pythoncom.TypeIIDs etc) are dicts which register
+// pending interfaces for keys they don't have, and register everything pending
+// before they are iterated, so Python code sees the same maps as before.
+//
+static int ResolvePendingKey(PyObject *self, PyObject *key)
+{
+    if (g_numPending == 0)
+        return 0;
+    int rc;
+    if (self == g_obPyCom_MapInterfaceNameToIID) {
+        char *name;
+        if (!PyWinObject_AsString(key, &name)) {
+            PyErr_Clear();
+            return 0;
+        }
+        rc = PyCom_RegisterPendingInterface(IID_NULL, name);
+        PyWinObject_FreeString(name);
+    }
+    else {
+        IID iid;
+        if (!PyWinObject_AsIID(key, &iid)) {
+            PyErr_Clear();
+            return 0;
+        }
+        rc = PyCom_RegisterPendingInterface(iid, NULL);
+    }
+    return rc;
+}
+
+static PyObject *PyInterfaceMap_missing(PyObject *self, PyObject *key)
+{
+    int rc = ResolvePendingKey(self, key);
+    if (rc < 0)
+        return NULL;
+    PyObject *ret = rc ? PyDict_GetItem(self, key) : NULL;
+    if (ret == NULL) {
+        PyErr_SetObject(PyExc_KeyError, key);
+        return NULL;
+    }
+    Py_INCREF(ret);
+    return ret;
+}
+
+static PyObject *PyInterfaceMap_get(PyObject *self, PyObject *args)
+{
+    PyObject *key, *def = Py_None;
+    if (!PyArg_ParseTuple(args, "O|O:get", &key, &def))
+        return NULL;
+    PyObject *ret = PyDict_GetItem(self, key);
+    if (ret == NULL) {
+        int rc = ResolvePendingKey(self, key);
+        if (rc < 0)
+            return NULL;
+        ret = rc ? PyDict_GetItem(self, key) : NULL;
+        if (ret == NULL)
+            ret = def;
+    }
+    Py_INCREF(ret);
+    return ret;
+}
+
+static int PyInterfaceMap_contains(PyObject *self, PyObject *key)
+{
+    int rc = PyDict_Contains(self, key);
+    if (rc != 0)
+        return rc;
+    rc = ResolvePendingKey(self, key);
+    if (rc <= 0)
+        return rc;
+    return PyDict_Contains(self, key);
+}
+
+// Everything else which sees all the items first registers them all, then
+// uses the dict implementation.
+static PyObject *CallDictMethod(PyObject *self, const char *name)
+{
+    if (PyCom_RegisterAllPendingInterfaces() != 0)
+        return NULL;
+    PyObject *method = PyObject_GetAttrString((PyObject *)&PyDict_Type, (char *)name);
+    if (method == NULL)
+        return NULL;
+    PyObject *ret = PyObject_CallFunctionObjArgs(method, self, NULL);
+    Py_DECREF(method);
+    return ret;
+}
+
+static PyObject *PyInterfaceMap_keys(PyObject *self, PyObject *args) { return CallDictMethod(self, "keys"); }
+static PyObject *PyInterfaceMap_values(PyObject *self, PyObject *args) { return CallDictMethod(self, "values"); }
+static PyObject *PyInterfaceMap_items(PyObject *self, PyObject *args) { return CallDictMethod(self, "items"); }
+
+static PyObject *PyInterfaceMap_iter(PyObject *self)
+{
+    if (PyCom_RegisterAllPendingInterfaces() != 0)
+        return NULL;
+    return PyDict_Type.tp_iter(self);
+}
+
+static Py_ssize_t PyInterfaceMap_length(PyObject *self)
+{
+    if (PyCom_RegisterAllPendingInterfaces() != 0)
+        return -1;
+    return PyDict_Size(self);
+}
+
+static struct PyMethodDef PyInterfaceMap_methods[] = {
+    {"__missing__", PyInterfaceMap_missing, METH_O},
+    {"get", PyInterfaceMap_get, METH_VARARGS},
+    {"keys", PyInterfaceMap_keys, METH_NOARGS},
+    {"values", PyInterfaceMap_values, METH_NOARGS},
+    {"items", PyInterfaceMap_items, METH_NOARGS},
+    {NULL}};
+
+static PySequenceMethods PyInterfaceMap_sequence = {
+    0,                        /* sq_length */
+    0,                        /* sq_concat */
+    0,                        /* sq_repeat */
+    0,                        /* sq_item */
+    0,                        /* sq_slice */
+    0,                        /* sq_ass_item */
+    0,                        /* sq_ass_slice */
+    PyInterfaceMap_contains,  /* sq_contains */
+};
+
+static PyMappingMethods PyInterfaceMap_mapping = {
+    PyInterfaceMap_length, /* mp_length */
+    0,                     /* mp_subscript - dict's calls __missing__ */
+    0,                     /* mp_ass_subscript */
+};
+
+static PyTypeObject PyInterfaceMapType = {
+    PYWIN_OBJECT_HEAD "pythoncom.InterfaceMap", /* tp_name */
+    0,                                          /* tp_basicsize - from dict */
+    0,                                          /* tp_itemsize */
+    0,                                          /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_compare */
+    0,                                          /* tp_repr */
+    0,                                          /* tp_as_number */
+    &PyInterfaceMap_sequence,                   /* tp_as_sequence */
+    &PyInterfaceMap_mapping,                    /* tp_as_mapping */
+    0,                                          /* tp_hash */
+    0,                                          /* tp_call */
+    0,                                          /* tp_str */
+    0,                                          /* tp_getattro */
+    0,                                          /* tp_setattro */
+    0,                                          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                         /* tp_flags */
+    0,                                          /* tp_doc */
+    0,                                          /* tp_traverse */
+    0,                                          /* tp_clear */
+    0,                                          /* tp_richcompare */
+    0,                                          /* tp_weaklistoffset */
+    PyInterfaceMap_iter,                        /* tp_iter */
+    0,                                          /* tp_iternext */
+    PyInterfaceMap_methods,                     /* tp_methods */
+    0,                                          /* tp_members */
+    0,                                          /* tp_getset */
+    0,                                          /* tp_base - set below */
+};
+
+static PyObject *NewInterfaceMap(void)
+{
+    if (PyInterfaceMapType.tp_base == NULL) {
+        PyInterfaceMapType.tp_base = &PyDict_Type;
+        if (PyType_Ready(&PyInterfaceMapType) == -1)
+            return NULL;
+    }
+    return PyObject_CallObject((PyObject *)&PyInterfaceMapType, NULL);
+}
+
 int PyCom_RegisterIIDs(PyObject *dict, const PyCom_InterfaceSupportInfo *pInterfaces, int numEntries)
 {
     int i;
@@ -209,6 +490,13 @@ int PyCom_IsGatewayRegistered(REFIID iid)
         return 0;
     }
     int rc = PyMapping_HasKey(g_obPyCom_MapServerIIDToGateway, keyObject);
+    if (!rc) {
+        int numFound = PyCom_RegisterPendingInterface(iid, NULL);
+        if (numFound > 0)
+            rc = PyMapping_HasKey(g_obPyCom_MapServerIIDToGateway, keyObject);
+        else if (numFound < 0)
+            PyErr_Clear();
+    }
     Py_DECREF(keyObject);
     return rc;
 }
@@ -217,21 +505,14 @@ int PyCom_IsGatewayRegistered(REFIID iid)
 PyObject *pythoncom_IsGatewayRegistered(PyObject *self, PyObject *args)
 {
     PyObject *obIID;
-    PyObject *v;
+    IID iid;
 
     // @pyparm <o PyIID>|iid||IID of the interface.
     if (!PyArg_ParseTuple(args, "O:IsGatewayRegistered", &obIID))
         return NULL;
-    v = PyDict_GetItem(g_obPyCom_MapServerIIDToGateway, obIID);
-    if (!v) {
-        PyErr_Clear();
-        v = PyInt_FromLong(0);
-    }
-    else {
-        Py_DECREF(v);
-        v = PyInt_FromLong(1);
-    }
-    return v;
+    if (!PyWinObject_AsIID(obIID, &iid))
+        return NULL;
+    return PyInt_FromLong(PyCom_IsGatewayRegistered(iid));
 }
 
 /////////////////////////////////////////////////////////////////////////////////
@@ -283,6 +564,7 @@ static const PyCom_InterfaceSupportInfo g_interfaceSupportData[] = {
     PYCOM_INTERFACE_FULL(LockBytes),
     PYCOM_INTERFACE_IID_ONLY(Marshal),
     PYCOM_INTERFACE_CLIENT_ONLY(Moniker),
+    PYCOM_INTERFACE_CLIENT_ONLY(MultiQI),
     PYCOM_INTERFACE_FULL(OleWindow),
     PYCOM_INTERFACE_FULL(Persist),
     PYCOM_INTERFACE_FULL(PersistFile),
@@ -337,15 +619,20 @@ int PyCom_RegisterCoreSupport(void)
     if (g_obPyCom_MapIIDToType)
         return 0;  // already done!
     // Create the name and type mappings.
-    g_obPyCom_MapIIDToType = PyDict_New();  // map of IID's to types.
+    g_obPyCom_MapIIDToType = NewInterfaceMap();  // map of IID's to types.
     if (g_obPyCom_MapIIDToType == NULL)
         return -1;
-    g_obPyCom_MapGatewayIIDToName = PyDict_New();
+    g_obPyCom_MapGatewayIIDToName = NewInterfaceMap();
     if (g_obPyCom_MapGatewayIIDToName == NULL)
         return -1;
-    g_obPyCom_MapInterfaceNameToIID = PyDict_New();
+    g_obPyCom_MapInterfaceNameToIID = NewInterfaceMap();
     if (g_obPyCom_MapInterfaceNameToIID == NULL)
         return -1;
+    if (g_obPyCom_MapServerIIDToGateway == NULL) {
+        g_obPyCom_MapServerIIDToGateway = PyDict_New();
+        if (g_obPyCom_MapServerIIDToGateway == NULL)
+            return -1;
+    }
 
     return PyCom_RegisterSupportedInterfaces(g_interfaceSupportData,
                                              sizeof(g_interfaceSupportData) / sizeof(PyCom_InterfaceSupportInfo));
@@ -367,5 +654,6 @@ int PyCom_UnregisterCoreSupport(void)
     g_obPyCom_MapGatewayIIDToName = NULL;
     Py_XDECREF(g_obPyCom_MapInterfaceNameToIID);
     g_obPyCom_MapInterfaceNameToIID = NULL;
+    FreePendingInterfaces();
     return 0;
 }
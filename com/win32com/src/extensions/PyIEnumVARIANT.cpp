@@ -122,6 +122,171 @@ PyObject *PyIEnumVARIANT::Clone(PyObject *self, PyObject *args)
     return PyCom_PyObjectFromIUnknown(pClone, IID_IEnumVARIANT, FALSE);
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// A Python iterator over an IEnumVARIANT which fetches many items per call
+// to Next - each of which may be a round-trip to another process - and
+// converts each batch with the GIL held once.
+#define ENUMVARIANT_DEFAULT_BATCH 256
+
+class PyIEnumVARIANTIter : public PyObject {
+   public:
+    PyIEnumVARIANTIter(IEnumVARIANT *pEnum, ULONG batchSize);
+    ~PyIEnumVARIANTIter();
+
+    static void tp_dealloc(PyObject *ob);
+    static PyObject *tp_iter(PyObject *self);
+    static PyObject *tp_iternext(PyObject *self);
+    static PyTypeObject Type;
+
+    IEnumVARIANT *pEnum;
+    ULONG batchSize;
+    VARIANT *rgVar;    // reused for each batch.
+    PyObject *batch;   // tuple of converted items.
+    Py_ssize_t pos;    // next item in batch to return.
+    BOOL bExhausted;   // Next has told us there is nothing more.
+};
+
+PyIEnumVARIANTIter::PyIEnumVARIANTIter(IEnumVARIANT *pEnum, ULONG batchSize)
+{
+    ob_type = &Type;
+    _Py_NewReference(this);
+    pEnum->AddRef();
+    this->pEnum = pEnum;
+    this->batchSize = batchSize;
+    rgVar = NULL;
+    batch = NULL;
+    pos = 0;
+    bExhausted = FALSE;
+}
+
+PyIEnumVARIANTIter::~PyIEnumVARIANTIter()
+{
+    Py_XDECREF(batch);
+    delete[] rgVar;
+    PY_INTERFACE_PRECALL;
+    pEnum->Release();
+    PY_INTERFACE_POSTCALL;
+}
+
+void PyIEnumVARIANTIter::tp_dealloc(PyObject *ob) { delete (PyIEnumVARIANTIter *)ob; }
+
+PyObject *PyIEnumVARIANTIter::tp_iter(PyObject *self)
+{
+    Py_INCREF(self);
+    return self;
+}
+
+PyObject *PyIEnumVARIANTIter::tp_iternext(PyObject *self)
+{
+    PyIEnumVARIANTIter *it = (PyIEnumVARIANTIter *)self;
+    if (it->batch != NULL && it->pos < PyTuple_GET_SIZE(it->batch)) {
+        PyObject *ret = PyTuple_GET_ITEM(it->batch, it->pos++);
+        Py_INCREF(ret);
+        return ret;
+    }
+    Py_CLEAR(it->batch);
+    if (it->bExhausted)
+        return NULL;  // StopIteration
+    if (it->rgVar == NULL) {
+        it->rgVar = new VARIANT[it->batchSize];
+        if (it->rgVar == NULL)
+            return PyErr_NoMemory();
+    }
+    ULONG i;
+    for (i = 0; i < it->batchSize; i++) VariantInit(&it->rgVar[i]);
+    ULONG celtFetched = 0;
+    PY_INTERFACE_PRECALL;
+    HRESULT hr = it->pEnum->Next(it->batchSize, it->rgVar, &celtFetched);
+    PY_INTERFACE_POSTCALL;
+    if (FAILED(hr))
+        return PyCom_BuildPyException(hr, it->pEnum, IID_IEnumVARIANT);
+    // S_FALSE means fewer items remained than we asked for, so there is no
+    // point asking again.
+    if (celtFetched > it->batchSize)  // defend against broken enumerators.
+        celtFetched = it->batchSize;
+    if (hr == S_FALSE || celtFetched < it->batchSize)
+        it->bExhausted = TRUE;
+    PyObject *batch = PyTuple_New(celtFetched);
+    for (i = 0; i < celtFetched && batch != NULL; i++) {
+        PyObject *ob = PyCom_PyObjectFromVariant(&it->rgVar[i]);
+        if (ob == NULL)
+            Py_CLEAR(batch);
+        else
+            PyTuple_SET_ITEM(batch, i, ob);
+    }
+    for (i = 0; i < celtFetched; i++) VariantClear(&it->rgVar[i]);
+    if (batch == NULL)
+        return NULL;
+    if (celtFetched == 0) {
+        Py_DECREF(batch);
+        it->bExhausted = TRUE;
+        return NULL;
+    }
+    it->batch = batch;
+    it->pos = 1;
+    PyObject *ret = PyTuple_GET_ITEM(batch, 0);
+    Py_INCREF(ret);
+    return ret;
+}
+
+PyTypeObject PyIEnumVARIANTIter::Type = {
+    PYWIN_OBJECT_HEAD "PyIEnumVARIANTIterator",
+    sizeof(PyIEnumVARIANTIter),
+    0,
+    PyIEnumVARIANTIter::tp_dealloc,  /* tp_dealloc */
+    0,                               /* tp_print */
+    0,                               /* tp_getattr */
+    0,                               /* tp_setattr */
+    0,                               /* tp_compare */
+    0,                               /* tp_repr */
+    0,                               /* tp_as_number */
+    0,                               /* tp_as_sequence */
+    0,                               /* tp_as_mapping */
+    0,                               /* tp_hash */
+    0,                               /* tp_call */
+    0,                               /* tp_str */
+    PyObject_GenericGetAttr,         /* tp_getattro */
+    0,                               /* tp_setattro */
+    0,                               /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,              /* tp_flags */
+    0,                               /* tp_doc */
+    0,                               /* tp_traverse */
+    0,                               /* tp_clear */
+    0,                               /* tp_richcompare */
+    0,                               /* tp_weaklistoffset */
+    PyIEnumVARIANTIter::tp_iter,     /* tp_iter */
+    PyIEnumVARIANTIter::tp_iternext, /* tp_iternext */
+};
+
+static PyObject *NewEnumVARIANTIter(PyObject *self, ULONG batchSize)
+{
+    IEnumVARIANT *pIEVARIANT = PyIEnumVARIANT::GetI(self);
+    if (pIEVARIANT == NULL)
+        return NULL;
+    if (!(PyIEnumVARIANTIter::Type.tp_flags & Py_TPFLAGS_READY) && PyType_Ready(&PyIEnumVARIANTIter::Type) == -1)
+        return NULL;
+    return new PyIEnumVARIANTIter(pIEVARIANT, batchSize);
+}
+
+PyObject *PyIEnumVARIANT::iter() { return NewEnumVARIANTIter(this, ENUMVARIANT_DEFAULT_BATCH); }
+
+// @pymethod iterator|PyIEnumVARIANT|Iterate|Returns an iterator which fetches items in batches.
+PyObject *PyIEnumVARIANT::Iterate(PyObject *self, PyObject *args)
+{
+    long batchSize = ENUMVARIANT_DEFAULT_BATCH;
+    // @pyparm int|batchSize|256|The number of items to request in each call to <om PyIEnumVARIANT.Next>
+    if (!PyArg_ParseTuple(args, "|l:Iterate", &batchSize))
+        return NULL;
+    if (batchSize < 1)
+        return PyErr_Format(PyExc_ValueError, "batchSize must be at least 1");
+    return NewEnumVARIANTIter(self, batchSize);
+    // @comm Iterating over the enumerator itself is the same as iterating
+    // over the result of this method with the default batch size.
+    // <nl>As items are fetched ahead of those returned by the iterator, calling
+    // the enumerator's Next, Skip or Reset methods while iterating may not have
+    // the effect you expect.
+}
+
 // @object PyIEnumVARIANT|A Python interface to IEnumVARIANT
 static struct PyMethodDef PyIEnumVARIANT_methods[] = {
     {"Next", PyIEnumVARIANT::Next,
@@ -130,6 +295,7 @@ static struct PyMethodDef PyIEnumVARIANT_methods[] = {
     {"Reset", PyIEnumVARIANT::Reset, 1},  // @pymeth Reset|Resets the enumeration sequence to the beginning.
     {"Clone", PyIEnumVARIANT::Clone,
      1},  // @pymeth Clone|Creates another enumerator that contains the same enumeration state as the current one.
+    {"Iterate", PyIEnumVARIANT::Iterate, 1},  // @pymeth Iterate|Returns an iterator which fetches items in batches.
     {NULL}};
 
 PyComEnumTypeObject PyIEnumVARIANT::type("PyIEnumVARIANT",
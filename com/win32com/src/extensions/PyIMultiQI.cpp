@@ -0,0 +1,98 @@
+// This file implements the IMultiQI Interface for Python.
+
+#include "stdafx.h"
+#include "PythonCOM.h"
+#include "PyIMultiQI.h"
+
+// @doc - This file contains autoduck documentation
+// ---------------------------------------------------
+//
+// Interface Implementation
+
+PyIMultiQI::PyIMultiQI(IUnknown *pdisp) : PyIUnknown(pdisp) { ob_type = &type; }
+
+PyIMultiQI::~PyIMultiQI() {}
+
+/* static */ IMultiQI *PyIMultiQI::GetI(PyObject *self) { return (IMultiQI *)PyIUnknown::GetI(self); }
+
+PyObject *PyCom_PyObjectFromMULTI_QI(MULTI_QI *mqi, ULONG numIIDs)
+{
+    PyObject *result = PyTuple_New(numIIDs);
+    if (result == NULL)
+        return NULL;
+    for (ULONG i = 0; i < numIIDs; i++) {
+        PyObject *obNew;
+        if (mqi[i].hr == 0) {
+            obNew = PyCom_PyObjectFromIUnknown(mqi[i].pItf, *mqi[i].pIID, FALSE);
+            mqi[i].pItf = NULL;
+            if (!obNew) {
+                Py_DECREF(result);
+                return NULL;
+            }
+        }
+        else {
+            obNew = Py_None;
+            Py_INCREF(Py_None);
+        }
+        PyTuple_SET_ITEM(result, i, obNew);
+    }
+    return result;
+}
+
+// @pymethod (<o PyIUnknown>, ...)|PyIMultiQI|QueryMultipleInterfaces|Queries for several interfaces in a single call
+PyObject *PyIMultiQI::QueryMultipleInterfaces(PyObject *self, PyObject *args)
+{
+    IMultiQI *pIMQI = GetI(self);
+    if (pIMQI == NULL)
+        return NULL;
+    PyObject *obiids;
+    // @pyparm [<o PyIID>, ...]|iids||A sequence of IIDs required from the object
+    if (!PyArg_ParseTuple(args, "O:QueryMultipleInterfaces", &obiids))
+        return NULL;
+    IID *iids = NULL;
+    ULONG numIIDs = 0;
+    if (!SeqToVector(obiids, &iids, &numIIDs, PyWinObject_AsIID))
+        return NULL;
+    MULTI_QI *mqi = new MULTI_QI[numIIDs];
+    if (mqi == NULL) {
+        CoTaskMemFree(iids);
+        PyErr_SetString(PyExc_MemoryError, "Allocating MULTIQI array");
+        return NULL;
+    }
+    ULONG i;
+    for (i = 0; i < numIIDs; i++) {
+        mqi[i].pIID = iids + i;
+        mqi[i].pItf = NULL;
+        mqi[i].hr = 0;
+    }
+    PyObject *result = NULL;
+    HRESULT hr;
+    PY_INTERFACE_PRECALL;
+    hr = pIMQI->QueryMultipleInterfaces(numIIDs, mqi);
+    PY_INTERFACE_POSTCALL;
+    // E_NOINTERFACE means none of the interfaces were available - still
+    // return a tuple of None rather than raising, as for partial success.
+    if (FAILED(hr) && hr != E_NOINTERFACE)
+        PyCom_BuildPyException(hr, pIMQI, IID_IMultiQI);
+    else
+        result = PyCom_PyObjectFromMULTI_QI(mqi, numIIDs);
+
+    for (i = 0; i < numIIDs; i++) PYCOM_RELEASE(mqi[i].pItf)
+    CoTaskMemFree(iids);
+    delete[] mqi;
+    return result;
+    // @rdesc The result is a tuple with an item for each IID, in the same order.  Items are None for
+    // interfaces the object does not support.
+    // @comm When the object is a proxy to a remote server, all interfaces are obtained with a single
+    // round trip, rather than one for each call to <om PyIUnknown.QueryInterface>.
+}
+
+// @object PyIMultiQI|Interface used to query for several interfaces at once, normally supported by DCOM proxies.
+static struct PyMethodDef PyIMultiQI_methods[] = {
+    {"QueryMultipleInterfaces", PyIMultiQI::QueryMultipleInterfaces,
+     1},  // @pymeth QueryMultipleInterfaces|Queries for several interfaces in a single call
+    {NULL}};
+
+PyComTypeObject PyIMultiQI::type("PyIMultiQI",
+                                 &PyIUnknown::type,  // @base PyIMultiQI|PyIUnknown
+                                 sizeof(PyIMultiQI), PyIMultiQI_methods, GET_PYCOM_CTOR(PyIMultiQI));
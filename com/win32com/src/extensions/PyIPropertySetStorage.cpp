@@ -7,6 +7,7 @@
 
 #ifndef NO_PYCOM_IPROPERTYSETSTORAGE
 #include "PyIPropertySetStorage.h"
+#include "PyIPropertyStorage.h"
 
 // @doc - This file contains autoduck documentation
 // ---------------------------------------------------
@@ -131,6 +132,80 @@ PyObject *PyIPropertySetStorage::Enum(PyObject *self, PyObject *args)
     return PyCom_PyObjectFromIUnknown(ppenum, IID_IEnumSTATPROPSETSTG, FALSE);
 }
 
+// @pymethod dict|PyIPropertySetStorage|ReadAll|Reads every property of every property set.
+// @comm Each property set is opened, and its properties read, with the Python lock released,
+// using the same arrays for every set.  The user defined properties, which are not listed
+// by <om PyIPropertySetStorage.Enum>, are included when there is a FMTID_DocSummaryInformation
+// set.  Property sets which can't be opened raise the error.
+// @rdesc A dictionary of FMTID to a dictionary of property ID to value, as
+// returned by <om PyIPropertyStorage.ReadAll>.
+PyObject *PyIPropertySetStorage::ReadAll(PyObject *self, PyObject *args)
+{
+    IPropertySetStorage *pIPSS = GetI(self);
+    if (pIPSS == NULL)
+        return NULL;
+    // @pyparm int|Mode|STGM_READ \| STGM_SHARE_EXCLUSIVE|Access mode to open the property sets with
+    DWORD grfMode = STGM_READ | STGM_SHARE_EXCLUSIVE;
+    if (!PyArg_ParseTuple(args, "|l:ReadAll", &grfMode))
+        return NULL;
+    IEnumSTATPROPSETSTG *pEnum;
+    HRESULT hr;
+    PY_INTERFACE_PRECALL;
+    hr = pIPSS->Enum(&pEnum);
+    PY_INTERFACE_POSTCALL;
+    if (FAILED(hr))
+        return PyCom_BuildPyException(hr, pIPSS, IID_IPropertySetStorage);
+
+    PyPropertyBuffers bufs;
+    ZeroMemory(&bufs, sizeof(bufs));
+    PyObject *ret = PyDict_New();
+    BOOL bUserDefined = FALSE;
+    while (ret) {
+        STATPROPSETSTG stat;
+        IPropertyStorage *pIPS = NULL;
+        FMTID fmtid;
+        PY_INTERFACE_PRECALL;
+        hr = pEnum->Next(1, &stat, NULL);
+        if (hr == S_OK)
+            fmtid = stat.fmtid;
+        else if (hr == S_FALSE && bUserDefined) {
+            // Do the user defined properties last.
+            fmtid = FMTID_UserDefinedProperties;
+            bUserDefined = FALSE;
+            hr = S_OK;
+        }
+        if (hr == S_OK) {
+            hr = pIPSS->Open(fmtid, grfMode, &pIPS);
+            if (hr == STG_E_FILENOTFOUND && fmtid == FMTID_UserDefinedProperties)
+                hr = S_FALSE;
+        }
+        PY_INTERFACE_POSTCALL;
+        if (FAILED(hr)) {
+            PyCom_BuildPyException(hr, pIPSS, IID_IPropertySetStorage);
+            Py_CLEAR(ret);
+            break;
+        }
+        if (pIPS == NULL)
+            break;
+        if (fmtid == FMTID_DocSummaryInformation)
+            bUserDefined = TRUE;
+        PyObject *props = PyCom_ReadAllProperties(pIPS, &bufs);
+        PY_INTERFACE_PRECALL;
+        pIPS->Release();
+        PY_INTERFACE_POSTCALL;
+        PyObject *key = props ? PyWinObject_FromIID(fmtid) : NULL;
+        if (key == NULL || PyDict_SetItem(ret, key, props) != 0)
+            Py_CLEAR(ret);
+        Py_XDECREF(key);
+        Py_XDECREF(props);
+    }
+    PY_INTERFACE_PRECALL;
+    pEnum->Release();
+    PY_INTERFACE_POSTCALL;
+    PyCom_FreePropertyBuffers(&bufs);
+    return ret;
+}
+
 // @object PyIPropertySetStorage|Container for a collection of property sets.
 //	Can be iterated over to enumerate property sets.
 static struct PyMethodDef PyIPropertySetStorage_methods[] = {
@@ -138,6 +213,8 @@ static struct PyMethodDef PyIPropertySetStorage_methods[] = {
     {"Open", PyIPropertySetStorage::Open, 1},      // @pymeth Open|Opens an existing property set
     {"Delete", PyIPropertySetStorage::Delete, 1},  // @pymeth Delete|Removes a property set from this storage object
     {"Enum", PyIPropertySetStorage::Enum, 1},  // @pymeth Enum|Creates an iterator to enumerate contained property sets
+    {"ReadAll", PyIPropertySetStorage::ReadAll,
+     1},  // @pymeth ReadAll|Reads every property of every property set.
     {NULL}};
 
 PyComEnumProviderTypeObject PyIPropertySetStorage::type("PyIPropertySetStorage", &PyIUnknown::type,
@@ -479,9 +479,115 @@ void PyObject_FreePROPIDs(PROPID *pFree, ULONG)
 //
 // Interface Implementation
 
-PyIPropertyStorage::PyIPropertyStorage(IUnknown *pdisp) : PyIUnknown(pdisp) { ob_type = &type; }
+PyIPropertyStorage::PyIPropertyStorage(IUnknown *pdisp) : PyIUnknown(pdisp)
+{
+    ob_type = &type;
+    m_obLastSpecs = NULL;
+    m_pLastSpecs = NULL;
+    m_cLastSpecs = 0;
+    ZeroMemory(&m_bufs, sizeof(m_bufs));
+    m_bInUse = FALSE;
+}
+
+PyIPropertyStorage::~PyIPropertyStorage()
+{
+    Py_XDECREF(m_obLastSpecs);
+    PyObject_FreePROPSPECs(m_pLastSpecs, m_cLastSpecs);
+    PyCom_FreePropertyBuffers(&m_bufs);
+}
+
+void PyCom_FreePropertyBuffers(PyPropertyBuffers *bufs)
+{
+    free(bufs->pSpecs);
+    delete[] bufs->pVars;
+    ZeroMemory(bufs, sizeof(*bufs));
+}
 
-PyIPropertyStorage::~PyIPropertyStorage() {}
+// Make room for at least num properties, keeping the specs already there.
+// The values are always empty between reads, so are not copied.
+static BOOL GrowPropertyBuffers(PyPropertyBuffers *bufs, ULONG num)
+{
+    if (num <= bufs->cAlloc)
+        return TRUE;
+    ULONG cAlloc = bufs->cAlloc < 8 ? 16 : bufs->cAlloc * 2;
+    if (cAlloc < num)
+        cAlloc = num;
+    PROPSPEC *pSpecs = (PROPSPEC *)realloc(bufs->pSpecs, sizeof(PROPSPEC) * cAlloc);
+    if (pSpecs == NULL)
+        return FALSE;
+    bufs->pSpecs = pSpecs;
+    PROPVARIANT *pVars = new PROPVARIANT[cAlloc];
+    if (pVars == NULL)
+        return FALSE;
+    for (ULONG i = 0; i < cAlloc; i++) PropVariantInit(pVars + i);
+    delete[] bufs->pVars;
+    bufs->pVars = pVars;
+    bufs->cAlloc = cAlloc;
+    return TRUE;
+}
+
+// Reads every property of the set without the Python lock.
+static HRESULT ReadAllPropertiesNoLock(IPropertyStorage *pIPS, PyPropertyBuffers *bufs, ULONG *pcRead)
+{
+    *pcRead = 0;
+    IEnumSTATPROPSTG *pEnum;
+    HRESULT hr = pIPS->Enum(&pEnum);
+    if (FAILED(hr))
+        return hr;
+    STATPROPSTG stats[32];
+    ULONG numFetched, num = 0;
+    do {
+        numFetched = 0;
+        hr = pEnum->Next(32, stats, &numFetched);
+        if (FAILED(hr))
+            break;
+        BOOL ok = GrowPropertyBuffers(bufs, num + numFetched);
+        for (ULONG i = 0; i < numFetched; i++) {
+            if (ok) {
+                bufs->pSpecs[num].ulKind = PRSPEC_PROPID;
+                bufs->pSpecs[num].propid = stats[i].propid;
+                num++;
+            }
+            CoTaskMemFree(stats[i].lpwstrName);
+        }
+        if (!ok)
+            hr = E_OUTOFMEMORY;
+    } while (hr == S_OK);
+    pEnum->Release();
+    if (FAILED(hr))
+        return hr;
+    if (num) {
+        hr = pIPS->ReadMultiple(num, bufs->pSpecs, bufs->pVars);
+        if (FAILED(hr))
+            return hr;
+    }
+    *pcRead = num;
+    return S_OK;
+}
+
+PyObject *PyCom_ReadAllProperties(IPropertyStorage *pIPS, PyPropertyBuffers *bufs)
+{
+    ULONG num;
+    HRESULT hr;
+    PY_INTERFACE_PRECALL;
+    hr = ReadAllPropertiesNoLock(pIPS, bufs, &num);
+    PY_INTERFACE_POSTCALL;
+    if (FAILED(hr))
+        return PyCom_BuildPyException(hr, pIPS, IID_IPropertyStorage);
+    PyObject *ret = PyDict_New();
+    for (ULONG i = 0; i < num; i++) {
+        if (ret) {
+            PyObject *key = PyLong_FromUnsignedLong(bufs->pSpecs[i].propid);
+            PyObject *val = key ? PyObject_FromPROPVARIANT(bufs->pVars + i) : NULL;
+            if (val == NULL || PyDict_SetItem(ret, key, val) != 0)
+                Py_CLEAR(ret);
+            Py_XDECREF(key);
+            Py_XDECREF(val);
+        }
+        PropVariantClear(bufs->pVars + i);
+    }
+    return ret;
+}
 
 /* static */ IPropertyStorage *PyIPropertyStorage::GetI(PyObject *self)
 {
@@ -495,27 +601,73 @@ PyObject *PyIPropertyStorage::ReadMultiple(PyObject *self, PyObject *args)
     IPropertyStorage *pIPS = GetI(self);
     if (pIPS == NULL)
         return NULL;
+    PyIPropertyStorage *pyself = (PyIPropertyStorage *)self;
     PyObject *props;
     // @pyparm (<o PROPSPEC>, ...)|props||Sequence of property IDs or names.
+    // @comm When props is a tuple equal to the one from the previous call, the PROPSPECs
+    // converted for that call are reused - so keep the tuple when reading the same properties
+    // from many objects.
     if (!PyArg_ParseTuple(args, "O:ReadMultiple", &props))
         return NULL;
+    // Another thread may be using the cached arrays while it has released the lock.
+    BOOL bUseCache = !pyself->m_bInUse;
+    BOOL bSpecsCached = FALSE;
+    if (bUseCache && pyself->m_obLastSpecs && PyTuple_Check(props)) {
+        bSpecsCached = props == pyself->m_obLastSpecs;
+        if (!bSpecsCached) {
+            int eq = PyObject_RichCompareBool(props, pyself->m_obLastSpecs, Py_EQ);
+            if (eq == -1)
+                PyErr_Clear();
+            bSpecsCached = eq == 1;
+        }
+    }
     ULONG cProps;
     PROPSPEC *pProps;
-    if (!PyWinObject_AsPROPSPECs(props, &pProps, &cProps))
-        return NULL;
-    PROPVARIANT *pPropVars = new PROPVARIANT[cProps];
-    if (pPropVars == NULL) {
-        PyObject_FreePROPSPECs(pProps, cProps);
-        PyErr_SetString(PyExc_MemoryError, "allocating PROPVARIANTs");
-        return NULL;
+    if (bSpecsCached) {
+        pProps = pyself->m_pLastSpecs;
+        cProps = pyself->m_cLastSpecs;
+    }
+    else {
+        if (!PyWinObject_AsPROPSPECs(props, &pProps, &cProps))
+            return NULL;
+        if (bUseCache && PyTuple_Check(props)) {
+            PyObject_FreePROPSPECs(pyself->m_pLastSpecs, pyself->m_cLastSpecs);
+            Py_XDECREF(pyself->m_obLastSpecs);
+            pyself->m_pLastSpecs = pProps;
+            pyself->m_cLastSpecs = cProps;
+            pyself->m_obLastSpecs = props;
+            Py_INCREF(props);
+            bSpecsCached = TRUE;
+        }
     }
+    PROPVARIANT *pPropVars;
     ULONG i;
-    for (i = 0; i < cProps; i++) PropVariantInit(pPropVars + i);
+    if (bUseCache) {
+        if (!GrowPropertyBuffers(&pyself->m_bufs, cProps)) {
+            if (!bSpecsCached)
+                PyObject_FreePROPSPECs(pProps, cProps);
+            PyErr_SetString(PyExc_MemoryError, "allocating PROPVARIANTs");
+            return NULL;
+        }
+        pPropVars = pyself->m_bufs.pVars;
+    }
+    else {
+        pPropVars = new PROPVARIANT[cProps];
+        if (pPropVars == NULL) {
+            PyObject_FreePROPSPECs(pProps, cProps);
+            PyErr_SetString(PyExc_MemoryError, "allocating PROPVARIANTs");
+            return NULL;
+        }
+        for (i = 0; i < cProps; i++) PropVariantInit(pPropVars + i);
+    }
 
     HRESULT hr;
+    pyself->m_bInUse = bUseCache;
     PY_INTERFACE_PRECALL;
     hr = pIPS->ReadMultiple(cProps, pProps, pPropVars);
     PY_INTERFACE_POSTCALL;
+    if (bUseCache)
+        pyself->m_bInUse = FALSE;
 
     PyObject *rc;
     if (FAILED(hr))
@@ -524,15 +676,42 @@ PyObject *PyIPropertyStorage::ReadMultiple(PyObject *self, PyObject *args)
         rc = PyObject_FromPROPVARIANTs(pPropVars, cProps);
 
     // Cleanup the property IDs.
-    PyObject_FreePROPSPECs(pProps, cProps);
+    if (!bSpecsCached)
+        PyObject_FreePROPSPECs(pProps, cProps);
     // Cleanup the prop variants.
     for (i = 0; i < cProps; i++) {
         PropVariantClear(pPropVars + i);
     }
-    delete[] pPropVars;
+    if (!bUseCache)
+        delete[] pPropVars;
     return rc;
 }
 
+// @pymethod dict|PyIPropertyStorage|ReadAll|Reads every property in the property set.
+// @comm The properties are enumerated and read in one call with the Python lock released.
+// @rdesc A dictionary of property ID to value.  Use <om PyIPropertyStorage.ReadPropertyNames>
+// for the names of named properties.
+PyObject *PyIPropertyStorage::ReadAll(PyObject *self, PyObject *args)
+{
+    IPropertyStorage *pIPS = GetI(self);
+    if (pIPS == NULL)
+        return NULL;
+    if (!PyArg_ParseTuple(args, ":ReadAll"))
+        return NULL;
+    PyIPropertyStorage *pyself = (PyIPropertyStorage *)self;
+    if (pyself->m_bInUse) {
+        PyPropertyBuffers bufs;
+        ZeroMemory(&bufs, sizeof(bufs));
+        PyObject *ret = PyCom_ReadAllProperties(pIPS, &bufs);
+        PyCom_FreePropertyBuffers(&bufs);
+        return ret;
+    }
+    pyself->m_bInUse = TRUE;
+    PyObject *ret = PyCom_ReadAllProperties(pIPS, &pyself->m_bufs);
+    pyself->m_bInUse = FALSE;
+    return ret;
+}
+
 // @pymethod |PyIPropertyStorage|WriteMultiple|Creates or modifies properties in the property set
 PyObject *PyIPropertyStorage::WriteMultiple(PyObject *self, PyObject *args)
 {
@@ -913,6 +1092,7 @@ static struct PyMethodDef PyIPropertyStorage_methods[] = {
      1},  // @pymeth SetTimes|Sets the creation, last access, and modification time
     {"SetClass", PyIPropertyStorage::SetClass, 1},  // @pymeth SetClass|Sets the GUID for the property set
     {"Stat", PyIPropertyStorage::Stat, 1},          // @pymeth Stat|Returns various infomation about the property set
+    {"ReadAll", PyIPropertyStorage::ReadAll, 1},    // @pymeth ReadAll|Reads every property in the property set.
     {NULL}};
 
 PyComEnumProviderTypeObject PyIPropertyStorage::type("PyIPropertyStorage", &PyIUnknown::type,
@@ -465,6 +465,295 @@ PyObject *PyIStorage::Stat(PyObject *self, PyObject *args)
     return obpstatstg;
 }
 
+// The tree of elements built by Walk, with the Python lock released.
+struct StorageWalkNode {
+    STATSTG stat;
+    StorageWalkNode *children;
+    StorageWalkNode *next;
+};
+
+static void FreeStorageWalkNodes(StorageWalkNode *node)
+{
+    while (node) {
+        StorageWalkNode *next = node->next;
+        FreeStorageWalkNodes(node->children);
+        CoTaskMemFree(node->stat.pwcsName);
+        delete node;
+        node = next;
+    }
+}
+
+#define STORAGE_WALK_BATCH 32
+
+static HRESULT WalkStorage(IStorage *pstg, int depth, StorageWalkNode **ppFirst)
+{
+    IEnumSTATSTG *pEnum;
+    HRESULT hr = pstg->EnumElements(0, NULL, 0, &pEnum);
+    if (FAILED(hr))
+        return hr;
+    StorageWalkNode **ppLast = ppFirst;
+    STATSTG stats[STORAGE_WALK_BATCH];
+    ULONG numFetched;
+    do {
+        numFetched = 0;
+        hr = pEnum->Next(STORAGE_WALK_BATCH, stats, &numFetched);
+        if (FAILED(hr))
+            break;
+        // Link all the batch in before opening any children, so it is freed on failure.
+        ULONG i;
+        for (i = 0; i < numFetched; i++) {
+            StorageWalkNode *node = new StorageWalkNode;
+            if (node == NULL)
+                break;
+            node->stat = stats[i];
+            node->children = NULL;
+            node->next = NULL;
+            *ppLast = node;
+            ppLast = &node->next;
+        }
+        if (i < numFetched) {
+            for (; i < numFetched; i++) CoTaskMemFree(stats[i].pwcsName);
+            hr = E_OUTOFMEMORY;
+            break;
+        }
+    } while (hr == S_OK);
+    pEnum->Release();
+    if (FAILED(hr))
+        return hr;
+    if (depth == 0)
+        return S_OK;
+    for (StorageWalkNode *node = *ppFirst; node; node = node->next) {
+        if (node->stat.type != STGTY_STORAGE)
+            continue;
+        IStorage *pChild;
+        hr = pstg->OpenStorage(node->stat.pwcsName, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, NULL, 0, &pChild);
+        if (FAILED(hr))
+            return hr;
+        hr = WalkStorage(pChild, depth - 1, &node->children);
+        pChild->Release();
+        if (FAILED(hr))
+            return hr;
+    }
+    return S_OK;
+}
+
+static PyObject *PyObjectFromStorageWalkNodes(StorageWalkNode *node, int depth)
+{
+    PyObject *ret = PyList_New(0);
+    if (ret == NULL)
+        return NULL;
+    for (; node; node = node->next) {
+        PyObject *obChildren;
+        if (node->stat.type == STGTY_STORAGE && depth != 0)
+            obChildren = PyObjectFromStorageWalkNodes(node->children, depth - 1);
+        else {
+            obChildren = Py_None;
+            Py_INCREF(Py_None);
+        }
+        PyObject *obName = PyWinObject_FromWCHAR(node->stat.pwcsName);
+        PyObject *item = NULL;
+        if (obChildren && obName)
+            item = Py_BuildValue("OkKO", obName, node->stat.type, node->stat.cbSize.QuadPart, obChildren);
+        Py_XDECREF(obChildren);
+        Py_XDECREF(obName);
+        if (item == NULL || PyList_Append(ret, item) != 0) {
+            Py_XDECREF(item);
+            Py_DECREF(ret);
+            return NULL;
+        }
+        Py_DECREF(item);
+    }
+    return ret;
+}
+
+// @pymethod [(name, type, size, children),...]|PyIStorage|Walk|Returns the tree of storages and streams
+// below this storage.
+// @comm The whole tree is read with the Python lock released, and without creating
+// a <o PyIStorage> or <o STATSTG> for each element.  Substorages are opened with
+// STGM_READ and STGM_SHARE_EXCLUSIVE.
+// @rdesc Each element is a tuple of its name, its type (storagecon.STGTY_*), its size, and for
+// a storage the list of its elements in the same form.  children is None for a stream,
+// and for a storage below maxDepth.
+PyObject *PyIStorage::Walk(PyObject *self, PyObject *args)
+{
+    IStorage *pIS = GetI(self);
+    if (pIS == NULL)
+        return NULL;
+    // @pyparm int|maxDepth|-1|How many levels of substorages to descend into, or -1 for all of them.
+    int maxDepth = -1;
+    if (!PyArg_ParseTuple(args, "|i:Walk", &maxDepth))
+        return NULL;
+    StorageWalkNode *nodes = NULL;
+    PY_INTERFACE_PRECALL;
+    HRESULT hr = WalkStorage(pIS, maxDepth, &nodes);
+    PY_INTERFACE_POSTCALL;
+    if (FAILED(hr)) {
+        FreeStorageWalkNodes(nodes);
+        return PyCom_BuildPyException(hr, pIS, IID_IStorage);
+    }
+    PyObject *ret = PyObjectFromStorageWalkNodes(nodes, maxDepth);
+    FreeStorageWalkNodes(nodes);
+    return ret;
+}
+
+struct StorageExtractState {
+    WCHAR path[MAX_PATH * 4];
+    BYTE *buf;
+    ULONG bufSize;
+    ULONG numStreams;
+    ULONG numStorages;
+    ULONGLONG numBytes;
+};
+
+// Append the element name to the path, escaping the characters that can't be
+// in a file name (such as the leading \005 of "\005SummaryInformation") as %XX.
+static BOOL AppendElementName(StorageExtractState *state, size_t pathLen, const WCHAR *name)
+{
+    static const WCHAR hex[] = L"0123456789ABCDEF";
+    WCHAR *p = state->path + pathLen;
+    WCHAR *end = state->path + sizeof(state->path) / sizeof(state->path[0]) - 4;
+    *p++ = L'\\';
+    for (; *name; name++) {
+        if (p >= end)
+            return FALSE;
+        if (*name < L' ' || wcschr(L"\\/:*?\"<>|%", *name)) {
+            *p++ = L'%';
+            *p++ = hex[(*name >> 4) & 0xF];
+            *p++ = hex[*name & 0xF];
+        }
+        else
+            *p++ = *name;
+    }
+    *p = L'\0';
+    return TRUE;
+}
+
+static HRESULT ExtractStream(IStorage *pstg, const WCHAR *name, StorageExtractState *state)
+{
+    IStream *pstm;
+    HRESULT hr = pstg->OpenStream(name, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, 0, &pstm);
+    if (FAILED(hr))
+        return hr;
+    HANDLE h = CreateFileW(state->path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (h == INVALID_HANDLE_VALUE) {
+        hr = HRESULT_FROM_WIN32(GetLastError());
+        pstm->Release();
+        return hr;
+    }
+    for (;;) {
+        ULONG cbRead = 0;
+        hr = pstm->Read(state->buf, state->bufSize, &cbRead);
+        if (FAILED(hr) || cbRead == 0)
+            break;
+        DWORD cbWritten;
+        if (!WriteFile(h, state->buf, cbRead, &cbWritten, NULL)) {
+            hr = HRESULT_FROM_WIN32(GetLastError());
+            break;
+        }
+        state->numBytes += cbRead;
+    }
+    CloseHandle(h);
+    pstm->Release();
+    if (FAILED(hr))
+        return hr;
+    state->numStreams++;
+    return S_OK;
+}
+
+static HRESULT ExtractStorage(IStorage *pstg, StorageExtractState *state)
+{
+    if (!CreateDirectoryW(state->path, NULL) && GetLastError() != ERROR_ALREADY_EXISTS)
+        return HRESULT_FROM_WIN32(GetLastError());
+    state->numStorages++;
+    IEnumSTATSTG *pEnum;
+    HRESULT hr = pstg->EnumElements(0, NULL, 0, &pEnum);
+    if (FAILED(hr))
+        return hr;
+    size_t pathLen = wcslen(state->path);
+    STATSTG stat;
+    while ((hr = pEnum->Next(1, &stat, NULL)) == S_OK) {
+        if (!AppendElementName(state, pathLen, stat.pwcsName))
+            hr = HRESULT_FROM_WIN32(ERROR_FILENAME_EXCED_RANGE);
+        else if (stat.type == STGTY_STREAM)
+            hr = ExtractStream(pstg, stat.pwcsName, state);
+        else if (stat.type == STGTY_STORAGE) {
+            IStorage *pChild;
+            hr = pstg->OpenStorage(stat.pwcsName, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, NULL, 0, &pChild);
+            if (SUCCEEDED(hr)) {
+                hr = ExtractStorage(pChild, state);
+                pChild->Release();
+            }
+        }
+        CoTaskMemFree(stat.pwcsName);
+        state->path[pathLen] = L'\0';
+        if (FAILED(hr))
+            break;
+    }
+    pEnum->Release();
+    return FAILED(hr) ? hr : S_OK;
+}
+
+// @pymethod (int, int, long)|PyIStorage|ExtractTo|Copies every stream below this storage to a file,
+// and every substorage to a directory.
+// @comm The data is copied natively, with the Python lock released for the whole operation.
+// Characters which can't be in a file name, and %, are written as %XX - so the
+// stream "\005SummaryInformation" becomes the file "%05SummaryInformation".  Existing files are replaced.
+// <nl>To copy to another storage use <om PyIStorage.CopyTo>, which is also done without the Python lock.
+// @rdesc The result is a tuple of the number of streams, the number of storages (including this one)
+// and the number of bytes written.
+PyObject *PyIStorage::ExtractTo(PyObject *self, PyObject *args)
+{
+    IStorage *pIS = GetI(self);
+    if (pIS == NULL)
+        return NULL;
+    // @pyparm str|directory||The directory to create for this storage.  It may already exist.
+    // @pyparm int|bufferSize|65536|The size of the buffer used to copy the data.
+    PyObject *obDirectory;
+    ULONG bufSize = 65536;
+    if (!PyArg_ParseTuple(args, "O|k:ExtractTo", &obDirectory, &bufSize))
+        return NULL;
+    if (bufSize == 0) {
+        PyErr_SetString(PyExc_ValueError, "bufferSize must not be zero");
+        return NULL;
+    }
+    TmpWCHAR directory;
+    DWORD directoryLen;
+    if (!PyWinObject_AsWCHAR(obDirectory, &directory, FALSE, &directoryLen))
+        return NULL;
+    StorageExtractState *state = new StorageExtractState;
+    if (state == NULL)
+        return PyErr_NoMemory();
+    if (directoryLen >= sizeof(state->path) / sizeof(state->path[0]) - 1) {
+        delete state;
+        PyErr_SetString(PyExc_ValueError, "The directory name is too long");
+        return NULL;
+    }
+    wcscpy(state->path, directory);
+    // Remove a trailing separator, as one is added before each name.
+    if (directoryLen > 0 && (state->path[directoryLen - 1] == L'\\' || state->path[directoryLen - 1] == L'/'))
+        state->path[directoryLen - 1] = L'\0';
+    state->buf = (BYTE *)malloc(bufSize);
+    if (state->buf == NULL) {
+        delete state;
+        return PyErr_NoMemory();
+    }
+    state->bufSize = bufSize;
+    state->numStreams = state->numStorages = 0;
+    state->numBytes = 0;
+    PY_INTERFACE_PRECALL;
+    HRESULT hr = ExtractStorage(pIS, state);
+    PY_INTERFACE_POSTCALL;
+    PyObject *ret = NULL;
+    if (FAILED(hr))
+        PyCom_BuildPyException(hr, pIS, IID_IStorage);
+    else
+        ret = Py_BuildValue("kkK", state->numStreams, state->numStorages, state->numBytes);
+    free(state->buf);
+    delete state;
+    return ret;
+}
+
 // @object PyIStorage|Structured storage compound storage object
 // @comm This object acts as an iterator through <om PyIStorage.EnumElements>
 static struct PyMethodDef PyIStorage_methods[] = {
@@ -497,6 +786,9 @@ static struct PyMethodDef PyIStorage_methods[] = {
     {"SetStateBits", PyIStorage::SetStateBits,
      1},  // @pymeth SetStateBits|Stores up to 32 bits of state information in this storage object.
     {"Stat", PyIStorage::Stat, 1},  // @pymeth Stat|Retrieves the STATSTG structure for this open storage object.
+    {"Walk", PyIStorage::Walk, 1},  // @pymeth Walk|Returns the tree of storages and streams below this storage.
+    {"ExtractTo", PyIStorage::ExtractTo,
+     1},  // @pymeth ExtractTo|Copies every stream below this storage to a file, and every substorage to a directory.
     {NULL}};
 
 PyComEnumProviderTypeObject PyIStorage::type("PyIStorage",
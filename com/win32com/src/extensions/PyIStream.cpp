@@ -23,32 +23,60 @@ PyObject *PyIStream::Read(PyObject *self, PyObject *args)
         PyErr_SetString(PyExc_TypeError, "The numBytes param must be greater than zero");
         return NULL;
     }
-    char *buffer = new char[numBytes];
-
     IStream *pMy = GetI(self);
     if (pMy == NULL)
         return NULL;
+    // Read directly into the result, which is shrunk if less is read.
+    PyObject *result = PyString_FromStringAndSize(NULL, numBytes);
+    if (result == NULL)
+        return NULL;
 
     ULONG read;
     PY_INTERFACE_PRECALL;
-    HRESULT hr = pMy->Read(buffer, numBytes, &read);
+    HRESULT hr = pMy->Read(PyString_AS_STRING(result), numBytes, &read);
     PY_INTERFACE_POSTCALL;
-    PyObject *result;
-    if (FAILED(hr))
-        result = PyCom_BuildPyException(hr, pMy, IID_IStream);
-    else
-        result = PyString_FromStringAndSize(buffer, read);
-    delete buffer;
+    if (FAILED(hr)) {
+        Py_DECREF(result);
+        return PyCom_BuildPyException(hr, pMy, IID_IStream);
+    }
+    if (read != numBytes)
+        _PyBytes_Resize(&result, read);
     // @rdesc The result is a string containing binary data.
     return result;
 }
 
+// @pymethod int|PyIStream|ReadInto|Reads from the stream directly into a writable buffer.
+PyObject *PyIStream::ReadInto(PyObject *self, PyObject *args)
+{
+    PyObject *obbuf;
+    // @pyparm buffer|buffer||A writable buffer object, such as a bytearray or memoryview.  Up to len(buffer)
+    // bytes are read.
+    if (!PyArg_ParseTuple(args, "O:ReadInto", &obbuf))
+        return NULL;
+    PyWinBufferView pybuf(obbuf, true);
+    if (!pybuf.ok())
+        return NULL;
+    IStream *pMy = GetI(self);
+    if (pMy == NULL)
+        return NULL;
+
+    ULONG read = 0;
+    PY_INTERFACE_PRECALL;
+    HRESULT hr = pMy->Read(pybuf.ptr(), pybuf.len(), &read);
+    PY_INTERFACE_POSTCALL;
+    if (FAILED(hr))
+        return PyCom_BuildPyException(hr, pMy, IID_IStream);
+    // @rdesc The number of bytes read, which is 0 at the end of the stream.
+    return PyLong_FromUnsignedLong(read);
+}
+
 // @pymethod |PyIStream|Write|Write data to a stream
 PyObject *PyIStream::Write(PyObject *self, PyObject *args)
 {
     PyObject *obstrValue;
     ULONG cbWritten;
-    // @pyparm string|data||The binary data to write.
+    // @pyparm buffer|data||The binary data to write.  Any object supporting the buffer protocol, such as a
+    // memoryview, is written without being copied.
     if (!PyArg_ParseTuple(args, "O:Write", &obstrValue))
         return NULL;
     PyWinBufferView pybuf(obstrValue);
@@ -146,6 +174,156 @@ PyObject *PyIStream::CopyTo(PyObject *self, PyObject *args)
     return PyWinObject_FromULARGE_INTEGER(written);
 }
 
+// Parses the common arguments of CopyToFile and CopyFromFile, and gets the transfer buffer.
+static BOOL PyIStream_ParseFileCopyArgs(PyObject *args, const char *fmt, HANDLE *phfile, ULARGE_INTEGER *pcb,
+                                        PyWinBufferView *pybuf, BYTE **ppbuf, ULONG *pbufsize)
+{
+    PyObject *obhfile, *obcb = Py_None, *obbuffer = Py_None;
+    ULONG bufsize = 0x10000;
+    if (!PyArg_ParseTuple(args, fmt, &obhfile, &obcb, &bufsize, &obbuffer))
+        return FALSE;
+    if (!PyWinObject_AsHANDLE(obhfile, phfile))
+        return FALSE;
+    if (obcb == Py_None)
+        pcb->QuadPart = (ULONGLONG)-1;
+    else if (!PyWinObject_AsULARGE_INTEGER(obcb, pcb))
+        return FALSE;
+    if (obbuffer != Py_None) {
+        if (!pybuf->init(obbuffer, true))
+            return FALSE;
+        if (pybuf->len() == 0) {
+            PyErr_SetString(PyExc_ValueError, "The buffer must not be empty");
+            return FALSE;
+        }
+        *ppbuf = (BYTE *)pybuf->ptr();
+        *pbufsize = pybuf->len() > MAXDWORD ? MAXDWORD : (ULONG)pybuf->len();
+        return TRUE;
+    }
+    if (bufsize == 0) {
+        PyErr_SetString(PyExc_ValueError, "The bufferSize param must be greater than zero");
+        return FALSE;
+    }
+    *ppbuf = (BYTE *)malloc(bufsize);
+    if (*ppbuf == NULL) {
+        PyErr_NoMemory();
+        return FALSE;
+    }
+    *pbufsize = bufsize;
+    return TRUE;
+}
+
+// @pymethod ULARGE_INTEGER|PyIStream|CopyToFile|Copies bytes from the current seek pointer in the stream to a file.
+// @comm The transfer is done without the Python lock, using a single buffer which is either allocated once
+// for the call or supplied by the caller so it can be reused across calls.
+PyObject *PyIStream::CopyToFile(PyObject *self, PyObject *args)
+{
+    HANDLE hfile;
+    ULARGE_INTEGER cb, total;
+    PyWinBufferView pybuf;
+    BYTE *buf = NULL;
+    ULONG bufsize;
+    // @pyparm <o PyHANDLE>|handle||Handle to a file opened for writing
+    // @pyparm ULARGE_INTEGER|cb|None|The maximum number of bytes to copy, or None to copy to the end of the stream.
+    // @pyparm int|bufferSize|65536|Size of the transfer buffer to allocate.
+    // @pyparm buffer|buffer|None|Writable buffer to use instead of allocating one
+    if (!PyIStream_ParseFileCopyArgs(args, "O|OkO:CopyToFile", &hfile, &cb, &pybuf, &buf, &bufsize))
+        return NULL;
+    IStream *pMy = GetI(self);
+    if (pMy == NULL) {
+        if (!pybuf.ok())
+            free(buf);
+        return NULL;
+    }
+
+    HRESULT hr = S_OK;
+    DWORD err = 0;
+    total.QuadPart = 0;
+    PY_INTERFACE_PRECALL;
+    while (total.QuadPart < cb.QuadPart) {
+        ULONG want = bufsize, read = 0;
+        if (cb.QuadPart - total.QuadPart < want)
+            want = (ULONG)(cb.QuadPart - total.QuadPart);
+        hr = pMy->Read(buf, want, &read);
+        if (FAILED(hr) || read == 0)
+            break;
+        DWORD written;
+        if (!WriteFile(hfile, buf, read, &written, NULL)) {
+            err = GetLastError();
+            break;
+        }
+        total.QuadPart += written;
+        if (written != read)
+            break;  // Disk full etc; the short count is returned
+    }
+    PY_INTERFACE_POSTCALL;
+    if (!pybuf.ok())
+        free(buf);
+    if (FAILED(hr))
+        return PyCom_BuildPyException(hr, pMy, IID_IStream);
+    if (err)
+        return PyWin_SetAPIError("WriteFile", err);
+    // @rdesc The return value is the number of bytes written to the file.
+    return PyWinObject_FromULARGE_INTEGER(total);
+}
+
+// @pymethod ULARGE_INTEGER|PyIStream|CopyFromFile|Copies bytes from the current position in a file to the stream.
+// @comm The transfer is done without the Python lock, using a single buffer which is either allocated once
+// for the call or supplied by the caller so it can be reused across calls.
+PyObject *PyIStream::CopyFromFile(PyObject *self, PyObject *args)
+{
+    HANDLE hfile;
+    ULARGE_INTEGER cb, total;
+    PyWinBufferView pybuf;
+    BYTE *buf = NULL;
+    ULONG bufsize;
+    // @pyparm <o PyHANDLE>|handle||Handle to a file opened for reading
+    // @pyparm ULARGE_INTEGER|cb|None|The maximum number of bytes to copy, or None to copy to the end of the file.
+    // @pyparm int|bufferSize|65536|Size of the transfer buffer to allocate.
+    // @pyparm buffer|buffer|None|Writable buffer to use instead of allocating one
+    if (!PyIStream_ParseFileCopyArgs(args, "O|OkO:CopyFromFile", &hfile, &cb, &pybuf, &buf, &bufsize))
+        return NULL;
+    IStream *pMy = GetI(self);
+    if (pMy == NULL) {
+        if (!pybuf.ok())
+            free(buf);
+        return NULL;
+    }
+
+    HRESULT hr = S_OK;
+    DWORD err = 0;
+    total.QuadPart = 0;
+    PY_INTERFACE_PRECALL;
+    while (total.QuadPart < cb.QuadPart) {
+        DWORD want = bufsize, read = 0;
+        if (cb.QuadPart - total.QuadPart < want)
+            want = (DWORD)(cb.QuadPart - total.QuadPart);
+        if (!ReadFile(hfile, buf, want, &read, NULL)) {
+            err = GetLastError();
+            if (err == ERROR_BROKEN_PIPE)
+                err = 0;  // end of a pipe
+            break;
+        }
+        if (read == 0)
+            break;
+        ULONG written = 0;
+        hr = pMy->Write(buf, read, &written);
+        if (FAILED(hr))
+            break;
+        total.QuadPart += written;
+        if (written != read)
+            break;
+    }
+    PY_INTERFACE_POSTCALL;
+    if (!pybuf.ok())
+        free(buf);
+    if (FAILED(hr))
+        return PyCom_BuildPyException(hr, pMy, IID_IStream);
+    if (err)
+        return PyWin_SetAPIError("ReadFile", err);
+    // @rdesc The return value is the number of bytes written to the stream.
+    return PyWinObject_FromULARGE_INTEGER(total);
+}
+
 // @pymethod |PyIStream|Commit|Ensures that any changes made to a stream object open in transacted mode are reflected in
 // the parent storage.
 PyObject *PyIStream::Commit(PyObject *self, PyObject *args)
@@ -293,12 +471,15 @@ PyObject *PyIStream::Stat(PyObject *self, PyObject *args)
 static struct PyMethodDef PyIStream_methods[] = {
     {"Read", PyIStream::Read, 1},        // @pymeth Read|Read the specified number of bytes from the string.
     {"read", PyIStream::Read, 1},        // @pymeth read|Alias for <om PyIStream.Read>
+    {"ReadInto", PyIStream::ReadInto, 1},  // @pymeth ReadInto|Reads from the stream directly into a writable buffer.
     {"Write", PyIStream::Write, 1},      // @pymeth Write|Write data from a stream.
     {"write", PyIStream::Write, 1},      // @pymeth write|Alias for <om PyIStream.Write>
     {"Seek", PyIStream::Seek, 1},        // @pymeth Seek|Changes the seek pointer to a new location.
     {"SetSize", PyIStream::SetSize, 1},  // @pymeth SetSize|Changes the size of the stream object.
     {"CopyTo", PyIStream::CopyTo, 1},    // @pymeth CopyTo|Copies a specified number of bytes from the current seek
                                          // pointer in the stream to the current seek pointer in another stream.
+    {"CopyToFile", PyIStream::CopyToFile, 1},  // @pymeth CopyToFile|Copies bytes from the stream to a file.
+    {"CopyFromFile", PyIStream::CopyFromFile, 1},  // @pymeth CopyFromFile|Copies bytes from a file to the stream.
     {"Commit", PyIStream::Commit, 1},    // @pymeth Commit|Ensures that any changes made to a stream object open in
                                          // transacted mode are reflected in the parent storage.
     {"Revert", PyIStream::Revert, 1},  // @pymeth Revert|Discards all changes that have been made to a transacted stream
@@ -0,0 +1,55 @@
+#ifndef __PYCOMCALLSTATS_H__
+#define __PYCOMCALLSTATS_H__
+
+// Optional statistics for IDispatch calls made from Python (via PyIDispatch)
+// and made to Python (via the gateways) - see pythoncom.EnableCallStats.
+
+// The phases of a call which are timed.
+#define PYCOM_PHASE_MARSHAL 0    // converting the arguments
+#define PYCOM_PHASE_CALL 1       // the call itself
+#define PYCOM_PHASE_UNMARSHAL 2  // converting the results
+#define PYCOM_PHASE_LOCK 3       // waiting for the Python lock
+#define PYCOM_NUM_PHASES 4
+
+extern BOOL g_bPyComCallStats;
+
+// Must be called with the Python lock held.
+void PyCom_RecordCallStats(BOOL bIncoming, PyObject *obName, DISPID dispid, const LONGLONG *ticks, BOOL bFailed);
+
+// Times the phases of one call.  When statistics are disabled the timer
+// is inactive, and costs nothing but the test of g_bPyComCallStats.
+class CPyComCallTimer {
+   public:
+    CPyComCallTimer() : m_bActive(g_bPyComCallStats)
+    {
+        if (m_bActive) {
+            memset(m_ticks, 0, sizeof(m_ticks));
+            QueryPerformanceCounter(&m_last);
+        }
+    }
+    BOOL IsActive() { return m_bActive; }
+    // Charges the time since the last phase ended to this one.  Doesn't need
+    // the Python lock.
+    void EndPhase(int phase)
+    {
+        if (m_bActive) {
+            LARGE_INTEGER now;
+            QueryPerformanceCounter(&now);
+            m_ticks[phase] += now.QuadPart - m_last.QuadPart;
+            m_last = now;
+        }
+    }
+    // Must be called with the Python lock held.
+    void Record(BOOL bIncoming, PyObject *obName, DISPID dispid, BOOL bFailed)
+    {
+        if (m_bActive && obName)
+            PyCom_RecordCallStats(bIncoming, obName, dispid, m_ticks, bFailed);
+    }
+
+   private:
+    BOOL m_bActive;
+    LARGE_INTEGER m_last;
+    LONGLONG m_ticks[PYCOM_NUM_PHASES];
+};
+
+#endif  // __PYCOMCALLSTATS_H__
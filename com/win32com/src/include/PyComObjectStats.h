@@ -0,0 +1,21 @@
+#ifndef __PYCOMOBJECTSTATS_H__
+#define __PYCOMOBJECTSTATS_H__
+
+// Optional counts of the live interface objects (PyIUnknown and friends) and
+// gateways, by IID and class - see pythoncom.EnableObjectStats.
+
+// The counters objects are charged to.  Entries are never freed, so an
+// object can hold on to its entry for its whole life.
+struct PyComObjectStatsEntry;
+
+extern BOOL g_bPyComObjectStats;
+
+// Returns the entry for a new interface object (bGateway FALSE, obClass its
+// type) or gateway (bGateway TRUE, obClass the Python object it wraps), with
+// the live count already incremented, or NULL.  Must be called with the
+// Python lock held, and only when g_bPyComObjectStats is set.
+PyComObjectStatsEntry *PyCom_ObjectStatsCreated(BOOL bGateway, REFIID iid, PyObject *obClass);
+// Doesn't need the Python lock.
+void PyCom_ObjectStatsDestroyed(PyComObjectStatsEntry *entry);
+
+#endif  // __PYCOMOBJECTSTATS_H__
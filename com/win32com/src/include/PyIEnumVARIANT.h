@@ -15,6 +15,10 @@ class PYCOM_EXPORT PyIEnumVARIANT : public PyIUnknown {
     static PyObject *Skip(PyObject *self, PyObject *args);
     static PyObject *Reset(PyObject *self, PyObject *args);
     static PyObject *Clone(PyObject *self, PyObject *args);
+    static PyObject *Iterate(PyObject *self, PyObject *args);
+
+    // Python iteration fetches items in batches.
+    virtual PyObject *iter();
 
    protected:
     PyIEnumVARIANT(IUnknown *pdisp);
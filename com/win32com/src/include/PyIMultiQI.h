@@ -0,0 +1,23 @@
+// This file declares the IMultiQI Interface for Python.
+// ---------------------------------------------------
+//
+// Interface Declaration
+
+class PyIMultiQI : public PyIUnknown {
+   public:
+    MAKE_PYCOM_CTOR(PyIMultiQI);
+    static IMultiQI *GetI(PyObject *self);
+    static PyComTypeObject type;
+
+    // The Python methods
+    static PyObject *QueryMultipleInterfaces(PyObject *self, PyObject *args);
+
+   protected:
+    PyIMultiQI(IUnknown *pdisp);
+    ~PyIMultiQI();
+};
+
+// Builds the result tuple for a filled MULTI_QI array, shared with
+// pythoncom.CoCreateInstanceEx.  Interfaces that are wrapped have their
+// pItf member cleared; the caller still releases any that remain.
+PyObject *PyCom_PyObjectFromMULTI_QI(MULTI_QI *mqi, ULONG numIIDs);
@@ -15,6 +15,7 @@ class PyIPropertySetStorage : public PyIUnknown {
     static PyObject *Open(PyObject *self, PyObject *args);
     static PyObject *Delete(PyObject *self, PyObject *args);
     static PyObject *Enum(PyObject *self, PyObject *args);
+    static PyObject *ReadAll(PyObject *self, PyObject *args);
 
    protected:
     PyIPropertySetStorage(IUnknown *pdisp);
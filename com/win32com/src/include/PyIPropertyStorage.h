@@ -4,6 +4,17 @@
 //
 // Interface Declaration
 
+// Arrays for reading properties, kept from one read to the next.
+struct PyPropertyBuffers {
+    PROPSPEC *pSpecs;  // property ids only
+    PROPVARIANT *pVars;
+    ULONG cAlloc;
+};
+void PyCom_FreePropertyBuffers(PyPropertyBuffers *bufs);
+// Reads every property of the set into bufs, and converts them to a dict of
+// property id to value.  Must hold the Python lock; it is released while reading.
+PyObject *PyCom_ReadAllProperties(IPropertyStorage *pIPS, PyPropertyBuffers *bufs);
+
 class PyIPropertyStorage : public PyIUnknown {
    public:
     MAKE_PYCOM_CTOR(PyIPropertyStorage);
@@ -23,10 +34,19 @@ class PyIPropertyStorage : public PyIUnknown {
     static PyObject *SetTimes(PyObject *self, PyObject *args);
     static PyObject *SetClass(PyObject *self, PyObject *args);
     static PyObject *Stat(PyObject *self, PyObject *args);
+    static PyObject *ReadAll(PyObject *self, PyObject *args);
 
    protected:
     PyIPropertyStorage(IUnknown *pdisp);
     ~PyIPropertyStorage();
+
+    // The PROPSPECs converted from the last tuple passed to ReadMultiple, and
+    // the arrays for reading.  Not used while another thread is reading.
+    PyObject *m_obLastSpecs;
+    PROPSPEC *m_pLastSpecs;
+    ULONG m_cLastSpecs;
+    PyPropertyBuffers m_bufs;
+    BOOL m_bInUse;
 };
 
 // ---------------------------------------------------
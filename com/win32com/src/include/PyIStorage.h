@@ -26,6 +26,8 @@ class PyIStorage : public PyIUnknown {
     static PyObject *SetClass(PyObject *self, PyObject *args);
     static PyObject *SetStateBits(PyObject *self, PyObject *args);
     static PyObject *Stat(PyObject *self, PyObject *args);
+    static PyObject *Walk(PyObject *self, PyObject *args);
+    static PyObject *ExtractTo(PyObject *self, PyObject *args);
 
    protected:
     PyIStorage(IUnknown *pdisp);
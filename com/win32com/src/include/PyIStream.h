@@ -14,10 +14,13 @@ class PYCOM_EXPORT PyIStream : public PyIUnknown {
     static IStream *GetI(PyObject *self);
 
     static PyObject *Read(PyObject *self, PyObject *args);
+    static PyObject *ReadInto(PyObject *self, PyObject *args);
     static PyObject *Write(PyObject *self, PyObject *args);
     static PyObject *Seek(PyObject *self, PyObject *args);
     static PyObject *SetSize(PyObject *self, PyObject *args);
     static PyObject *CopyTo(PyObject *self, PyObject *args);
+    static PyObject *CopyToFile(PyObject *self, PyObject *args);
+    static PyObject *CopyFromFile(PyObject *self, PyObject *args);
     static PyObject *Commit(PyObject *self, PyObject *args);
     static PyObject *Revert(PyObject *self, PyObject *args);
     static PyObject *LockRegion(PyObject *self, PyObject *args);
@@ -2,6 +2,7 @@
 #define __PYRECORD_H__
 
 class PyRecordBuffer;
+class PyRecordFieldTable;
 
 // @object PyRecord|An object that represents a COM User Defined Type.
 // @comm Once created or obtained from other methods, you can simply
@@ -22,6 +23,33 @@ class PyRecord : public PyObject {
     IRecordInfo *pri;
     void *pdata;
     PyRecordBuffer *owner;
+    PyRecordFieldTable *fields;  // loaded on first attribute access.
+};
+
+// @object PyRecordArray|A sequence of <o PyRecord> objects, sharing the memory of
+// the array they came from.
+// @comm Returned instead of a tuple of records when enabled via
+// <om pythoncom.EnableRecordArrays>.  Record objects are only created as
+// elements are accessed - but they share the memory of the array, so
+// changes made to them are reflected in the array.
+class PyRecordArray : public PyObject {
+   public:
+    PyRecordArray(IRecordInfo *ri, BYTE *data, Py_ssize_t nelems, ULONG cbElem, PyRecordBuffer *owner);
+    ~PyRecordArray();
+
+    static void tp_dealloc(PyObject *ob);
+    static Py_ssize_t sq_length(PyObject *self);
+    static PyObject *sq_item(PyObject *self, Py_ssize_t index);
+    static PyObject *GetField(PyObject *self, PyObject *args);
+    static struct PyMethodDef methods[];
+    static PySequenceMethods sequence;
+
+    static PyTypeObject Type;
+    IRecordInfo *pri;
+    BYTE *pdata;
+    Py_ssize_t nelems;
+    ULONG cbElem;
+    PyRecordBuffer *owner;
 };
 
 #endif  // __PYRECORD_H__
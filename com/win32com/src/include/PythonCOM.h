@@ -203,6 +203,10 @@ class PYCOM_EXPORT PyIBase : public PyObject {
     virtual PyObject *iter() { return NULL; }
     virtual PyObject *iternext() { return NULL; }
 
+    // Interface objects are allocated from freelists - only with the Python lock held.
+    static void *operator new(size_t size);
+    static void operator delete(void *p, size_t size);
+
    protected:
     PyIBase();
     virtual ~PyIBase();
@@ -264,6 +268,13 @@ PYCOM_EXPORT PyObject *PyCom_PyObjectFromIUnknown(IUnknown *punk, REFIID riid, B
 // VARIANT <-> PyObject conversion utilities.
 PYCOM_EXPORT BOOL PyCom_VariantFromPyObject(PyObject *obj, VARIANT *var);
 PYCOM_EXPORT PyObject *PyCom_PyObjectFromVariant(const VARIANT *var);
+// The same conversion in 2 steps - the first of which does not need the
+// Python lock.  See oleargs.cpp.
+PYCOM_EXPORT BOOL PyCom_PrepareVariantForPython(const VARIANT *var, VARIANT *pPrepared);
+PYCOM_EXPORT PyObject *PyCom_PyObjectFromPreparedVariant(VARIANT *pPrepared);
+// For a variant the caller is about to clear - its value may be moved into
+// the result rather than copied.
+PYCOM_EXPORT PyObject *PyCom_PyObjectFromOwnedVariant(VARIANT *var);
 
 // PROPVARIANT
 PYCOM_EXPORT PyObject *PyObject_FromPROPVARIANT(PROPVARIANT *pVar);
@@ -275,6 +286,8 @@ PYCOM_EXPORT PyObject *PyCom_PyObjectFromSTATSTG(STATSTG *pStat);
 PYCOM_EXPORT BOOL PyCom_PyObjectAsSTATSTG(PyObject *ob, STATSTG *pStat, DWORD flags = 0);
 PYCOM_EXPORT BOOL PyCom_SAFEARRAYFromPyObject(PyObject *obj, SAFEARRAY **ppSA, VARENUM vt = VT_VARIANT);
 PYCOM_EXPORT PyObject *PyCom_PyObjectFromSAFEARRAY(SAFEARRAY *psa, VARENUM vt = VT_VARIANT);
+// A 2 dimensional VT_VARIANT array as a list of tuples, one for each index of the second dimension.
+PYCOM_EXPORT PyObject *PyCom_PyObjectRowsFromSAFEARRAY(SAFEARRAY *psa);
 #ifndef NO_PYCOM_STGOPTIONS
 PYCOM_EXPORT BOOL PyCom_PyObjectAsSTGOPTIONS(PyObject *obstgoptions, STGOPTIONS **ppstgoptions);
 #endif
@@ -284,6 +297,14 @@ PYCOM_EXPORT BOOL PyCom_PyObjectAsSTATPROPSETSTG(PyObject *, STATPROPSETSTG *);
 // Currency support.
 PYCOM_EXPORT PyObject *PyObject_FromCurrency(CURRENCY &cy);
 PYCOM_EXPORT BOOL PyObject_AsCurrency(PyObject *ob, CURRENCY *pcy);
+// VT_DECIMAL values as decimal.Decimal objects.
+PYCOM_EXPORT PyObject *PyObject_FromDECIMAL(const DECIMAL &dec);
+
+// Flags for PyCom_SetNumericConversion
+#define PYCOM_CY_AS_SCALED_INT 1    // VT_CY values are returned as ints holding the value times 10000
+#define PYCOM_DECIMAL_AS_DECIMAL 2  // VT_DECIMAL values are returned as decimal.Decimal rather than strings
+PYCOM_EXPORT int PyCom_SetNumericConversion(int flags);
+PYCOM_EXPORT int PyCom_GetNumericConversion(void);
 
 // OLEMENUGROUPWIDTHS are used by axcontrol, shell, etc
 PYCOM_EXPORT BOOL PyObject_AsOLEMENUGROUPWIDTHS(PyObject *oblpMenuWidths, OLEMENUGROUPWIDTHS *pWidths);
@@ -444,6 +465,9 @@ class PYCOM_EXPORT PyOleNothing : public PyObject {
 
 /////////////////////////////////////////////////////////////////////////////
 // class PyIUnknown
+// The counters an object is charged to - see pythoncom.EnableObjectStats.
+struct PyComObjectStatsEntry;
+
 class PYCOM_EXPORT PyIUnknown : public PyIBase {
    public:
     MAKE_PYCOM_CTOR(PyIUnknown);
@@ -452,6 +476,11 @@ class PYCOM_EXPORT PyIUnknown : public PyIBase {
 
     static IUnknown *GetI(PyObject *self);
     IUnknown *m_obj;
+    // Set while this object is in the identity map (see pythoncom.EnableInterfaceIdentity)
+    BOOL m_bInIdentityMap;
+    PyIUnknown *m_nextIdentity;
+    // Set if the object is counted by pythoncom.GetObjectStats.
+    PyComObjectStatsEntry *m_pObjectStats;
     static char *szErrMsgObjectReleased;
     static void SafeRelease(PyIUnknown *ob);
     static PyComTypeObject type;
@@ -468,6 +497,9 @@ class PYCOM_EXPORT PyIUnknown : public PyIBase {
 /////////////////////////////////////////////////////////////////////////////
 // class PyIDispatch
 
+// A pre-parsed set of InvokeTypes() type descriptions - private to PyIDispatch.cpp
+struct PyDispatchCallPlan;
+
 class PYCOM_EXPORT PyIDispatch : public PyIUnknown {
    public:
     MAKE_PYCOM_CTOR(PyIDispatch);
@@ -481,6 +513,11 @@ class PYCOM_EXPORT PyIDispatch : public PyIUnknown {
     static PyObject *GetTypeInfo(PyObject *self, PyObject *args);
     static PyObject *GetTypeInfoCount(PyObject *self, PyObject *args);
 
+    // Cache of call plans used by InvokeTypes, allocated on first use.
+    PyDispatchCallPlan **m_callPlans;
+    // name call statistics are recorded under (see pythoncom.EnableCallStats)
+    PyObject *m_obCallStatsName;
+
    protected:
     PyIDispatch(IUnknown *pdisp);
     ~PyIDispatch();
@@ -15,6 +15,7 @@ void PYCOM_EXPORT PyCom_DLLReleaseRef(void);
 #define PY_GATEWAY_METHOD CEnterLeavePython _celp
 
 class PyGatewayBase;
+struct PyGatewayNameCache;
 // Gateway constructors.
 // Each gateway must be able to be created from a "gateway constructor".  This
 // is simply a function that takes a Python instance as as argument, and returns
@@ -154,11 +155,32 @@ class PYCOM_EXPORT PyGatewayBase :
     // End of PYGATEWAY_MAKE_SUPPORT
     PyObject *m_pPyObject;
     PyGatewayBase *m_pBaseObject;
+    // Set if the gateway is counted by pythoncom.GetObjectStats.
+    PyComObjectStatsEntry *m_pObjectStats;
+
+    // Discard the names remembered by GetIDsOfNames for this object.
+    void ClearNameCache(void);
 
    private:
     LONG m_cRef;
+    // name->DISPID map, shared by all gateways for the same Python object.
+    PyGatewayNameCache *m_pNameCache;
+    PyGatewayBase *GetNameCacheOwner(void);
+    // The policy's bound _Invoke_ method and its optional _dispid_to_callable_
+    // dictionary, fetched on the first Invoke.
+    PyObject *m_obInvoke;
+    PyObject *m_obDirectCallables;
+    BOOL m_bInvokeCached;
+    BOOL CacheInvokeCallables(void);
+    // Name call statistics are recorded under - see pythoncom.EnableCallStats.
+    PyObject *m_obCallStatsName;
+    PyObject *GetCallStatsName(void);
 };
 
+// Drop cached GetIDsOfNames results - for a single gateway object, or for
+// all gateways if pUnk is NULL.
+PYCOM_EXPORT void PyCom_InvalidateGatewayNameCache(IUnknown *pUnk);
+
 #ifdef _MSC_VER
 #pragma warning(default : 4275)
 #endif  // _MSC_VER
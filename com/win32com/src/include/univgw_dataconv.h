@@ -29,6 +29,24 @@ typedef va_list dataconv_t;
 
 #endif  // _M_ALPHA
 
+/*
+** A method's argument descriptions compiled by CompileArgLayout.
+*/
+typedef struct {
+    VARTYPE vt;         // The type from the description tuple
+    VARTYPE vtVariant;  // The VARIANT type used to convert an in arg
+    UINT cbVariant;     // and the number of bytes copied into the VARIANT
+    BOOL bIsByRef;
+    Py_ssize_t offset;  // Of the arg from the start of the arguments
+    IID iid;            // For out VT_DISPATCH and VT_UNKNOWN args
+} dataconv_arg;
+
+typedef struct {
+    Py_ssize_t cArgs;
+    BOOL bIn;  // Compiled for ReadFromInTuple rather than WriteFromOutTuple
+    dataconv_arg args[1];
+} dataconv_layout;
+
 PyObject *dataconv_L64(PyObject *self, PyObject *args);
 PyObject *dataconv_UL64(PyObject *self, PyObject *args);
 PyObject *dataconv_strL64(PyObject *self, PyObject *args);
@@ -37,5 +55,7 @@ PyObject *dataconv_interface(PyObject *self, PyObject *args);
 PyObject *dataconv_SizeOfVT(PyObject *self, PyObject *args);
 PyObject *dataconv_WriteFromOutTuple(PyObject *self, PyObject *args);
 PyObject *dataconv_ReadFromInTuple(PyObject *self, PyObject *args);
+PyObject *dataconv_CompileArgLayout(PyObject *self, PyObject *args);
+PyObject *dataconv_GetArgLayoutSize(PyObject *self, PyObject *args);
 
 #endif  // __DATACONV_H__
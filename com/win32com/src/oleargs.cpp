@@ -9,6 +9,8 @@ extern PyObject *PyObject_FromRecordInfo(IRecordInfo *, void *, ULONG);
 extern PyObject *PyObject_FromSAFEARRAYRecordInfo(SAFEARRAY *psa);
 extern BOOL PyObject_AsVARIANTRecordInfo(PyObject *ob, VARIANT *pv);
 extern BOOL PyRecord_Check(PyObject *ob);
+BOOL PyCom_VariantFromPyObjectGeneric(PyObject *obj, VARIANT *var);
+static VARTYPE SafeArrayVTFromBufferFormat(const char *fmt, Py_ssize_t itemsize);
 
 // Pointer to class defined in .py file.
 static PyObject *PyVariant_Type;
@@ -36,8 +38,21 @@ static PyObject *OleSetTypeError(TCHAR *msg)
     return NULL;
 }
 
+// Objects of these exact types can never be a win32com.client.VARIANT, so
+// we can avoid the (relatively expensive) isinstance check for them.
+static inline BOOL IsSimpleExactType(PyObject *obj)
+{
+    PyTypeObject *t = obj->ob_type;
+    return t == &PyLong_Type || t == &PyFloat_Type || t == &PyUnicode_Type || t == &PyBool_Type || obj == Py_None ||
+           t == &PyIDispatch::type || t == &PyWinDateTimeType;
+}
+
 BOOL MaybeExtractPyVariant(PyObject *obj, VARTYPE *vt, PyObject **pObjValue, BOOL *pConverted)
 {
+    if (IsSimpleExactType(obj)) {
+        *pConverted = FALSE;
+        return TRUE;
+    }
     // rely on the GIL to ensure there are no races.
     if (PyVariant_Type == NULL) {
         PyObject *mod = PyImport_ImportModule("win32com.client");
@@ -108,11 +123,87 @@ BOOL ConvertPyVariant(PyObject *obj, VARIANT *pResult, BOOL *pConverted)
 //
 //
 
+// The fast path for PyCom_VariantFromPyObject.  The most common argument
+// types are checked by their exact type, so the conversion needs no
+// win32com.client.VARIANT check, no attribute lookups and no temporary
+// objects.  Subclasses of these types (and anything else) are left for the
+// generic code, and the VARIANT produced is always identical to what the
+// generic code would produce.
+// Returns FALSE on error.  If returns TRUE, pConverted may be TRUE or FALSE.
+static BOOL VariantFromPyObjectFast(PyObject *obj, VARIANT *var, BOOL *pConverted)
+{
+    PyTypeObject *t = obj->ob_type;
+    *pConverted = TRUE;
+    if (t == &PyLong_Type) {
+        int overflow;
+        long val = PyLong_AsLongAndOverflow(obj, &overflow);
+        if (!overflow) {
+            if (val == -1 && PyErr_Occurred())
+                return FALSE;
+            V_VT(var) = VT_I4;
+            V_I4(var) = val;
+            return TRUE;
+        }
+        // Needs more than 32 bits - let the generic code choose the type.
+    }
+    else if (t == &PyFloat_Type) {
+        V_VT(var) = VT_R8;
+        V_R8(var) = PyFloat_AS_DOUBLE(obj);
+        return TRUE;
+    }
+    else if (t == &PyUnicode_Type || t == &PyBSTRBufferType) {
+        if (!PyWinObject_AsBstr(obj, &V_BSTR(var))) {
+            PyErr_SetString(PyExc_MemoryError, "Making BSTR for variant");
+            return FALSE;
+        }
+        V_VT(var) = VT_BSTR;
+        return TRUE;
+    }
+    else if (t == &PyBool_Type) {
+        V_VT(var) = VT_BOOL;
+        V_BOOL(var) = obj == Py_True ? VARIANT_TRUE : VARIANT_FALSE;
+        return TRUE;
+    }
+    else if (obj == Py_None) {
+        V_VT(var) = VT_NULL;
+        return TRUE;
+    }
+    else if (t == &PyIDispatch::type) {
+        IDispatch *pdisp = PyIDispatch::GetI(obj);
+        if (pdisp == NULL)
+            return FALSE;
+        pdisp->AddRef();
+        V_VT(var) = VT_DISPATCH;
+        V_DISPATCH(var) = pdisp;
+        return TRUE;
+    }
+    else if (t == &PyWinDateTimeType) {
+        if (!PyWinObject_AsDATE(obj, &V_DATE(var)))
+            return FALSE;
+        V_VT(var) = VT_DATE;
+        return TRUE;
+    }
+    *pConverted = FALSE;
+    return TRUE;
+}
+
 // Given a Python object, make the best (ie, most appropriate) VARIANT.
 // Should be used when the specific type of the variant is not known
 // NOTE that passing by reference is not supported using this function
 // you need to use the complicated ArgHelpers class for that!
 BOOL PyCom_VariantFromPyObject(PyObject *obj, VARIANT *var)
+{
+    BOOL didFast;
+    if (!VariantFromPyObjectFast(obj, var, &didFast))
+        return FALSE;
+    if (didFast)
+        return TRUE;
+    return PyCom_VariantFromPyObjectGeneric(obj, var);
+}
+
+// The generic conversion, used for anything the fast path doesn't handle.
+// Exposed (but not exported) so the pythoncom benchmark helpers can time it.
+BOOL PyCom_VariantFromPyObjectGeneric(PyObject *obj, VARIANT *var)
 {
     // First see if a special Python VARIANT object.
     BOOL didPyVariant;
@@ -127,7 +218,7 @@ BOOL PyCom_VariantFromPyObject(PyObject *obj, VARIANT *var)
 #if (PY_VERSION_HEX < 0x03000000)
         PyString_Check(obj) ||
 #endif
-        PyUnicode_Check(obj)) {
+        PyUnicode_Check(obj) || PyBSTRBuffer_Check(obj)) {
         if (!PyWinObject_AsBstr(obj, &V_BSTR(var))) {
             PyErr_SetString(PyExc_MemoryError, "Making BSTR for variant");
             return FALSE;
@@ -284,10 +375,18 @@ BOOL PyCom_VariantFromPyObject(PyObject *obj, VARIANT *var)
             return FALSE;
     }
     else if (PYWIN_BUFFER_CHECK(obj)) {
-        // We have a buffer object - convert to safe array of VT_UI1
-        if (!PyCom_SAFEARRAYFromPyObject(obj, &V_ARRAY(var), VT_UI1))
+        // We have a buffer object - convert to safe array of VT_UI1, or
+        // for a memoryview of a simple numeric type, an array of that type.
+        VARENUM vtElem = VT_UI1;
+        if (PyMemoryView_Check(obj)) {
+            Py_buffer *view = PyMemoryView_GET_BUFFER(obj);
+            VARTYPE vtView = SafeArrayVTFromBufferFormat(view->format, view->itemsize);
+            if (vtView != VT_EMPTY)
+                vtElem = (VARENUM)vtView;
+        }
+        if (!PyCom_SAFEARRAYFromPyObject(obj, &V_ARRAY(var), vtElem))
             return FALSE;
-        V_VT(var) = VT_ARRAY | VT_UI1;
+        V_VT(var) = VT_ARRAY | vtElem;
     }
     // NOTE: PySequence_Check may return true for instance objects,
     // or ANY object with a __len__ attribute.
@@ -330,11 +429,24 @@ BOOL PyCom_VariantFromPyObject(PyObject *obj, VARIANT *var)
     return TRUE;
 }
 
+static PyObject *PyObjectFromVariantValue(VARIANT *pvarValue, VARTYPE vtOrig);
+
+// BSTRs of at least this many characters are returned as PyBSTRBuffer
+// objects, which take over the BSTR rather than copying it into a Python
+// string.  0 (the default) disables them - see pythoncom.EnableBstrBuffers().
+static UINT cchBstrBufferMin = 0;
+
+UINT PyCom_EnableBstrBuffers(UINT cchMin)
+{
+    UINT cchOld = cchBstrBufferMin;
+    cchBstrBufferMin = cchMin;
+    return cchOld;
+}
+
 // Given a variant, turn it into a Python object of the closest type.
 // Note that ByRef params are not supported here.
 PyObject *PyCom_PyObjectFromVariant(const VARIANT *var)
 {
-    HRESULT hr;
     VARIANT varValue;
     PyObject *result = NULL;
 
@@ -370,7 +482,18 @@ PyObject *PyCom_PyObjectFromVariant(const VARIANT *var)
     /* ### we may want to optimize this sometime... avoid copying values */
     VariantInit(&varValue);
     VariantCopyInd(&varValue, (VARIANT *)var);
+    result = PyObjectFromVariantValue(&varValue, V_VT(var));
+    VariantClear(&varValue);
+    return result;
+}
 
+// Converts a dereferenced, non-array variant, which may be changed in place.
+// vtOrig is the type of the variant it was copied from, for error messages.
+static PyObject *PyObjectFromVariantValue(VARIANT *pvarValue, VARTYPE vtOrig)
+{
+    HRESULT hr;
+    VARIANT &varValue = *pvarValue;
+    PyObject *result = NULL;
     switch (V_VT(&varValue)) {
         case VT_BOOL:
             result = V_BOOL(&varValue) ? Py_True : Py_False;
@@ -466,7 +589,13 @@ PyObject *PyCom_PyObjectFromVariant(const VARIANT *var)
         }
 
         case VT_BSTR:
-            result = PyWinObject_FromBstr(V_BSTR(&varValue));
+            if (cchBstrBufferMin && V_BSTR(&varValue) && SysStringLen(V_BSTR(&varValue)) >= cchBstrBufferMin) {
+                // The variant is ours - move the BSTR into the result.
+                result = PyWinObject_FromBstrBuffer(V_BSTR(&varValue), TRUE);
+                V_VT(&varValue) = VT_EMPTY;
+            }
+            else
+                result = PyWinObject_FromBstr(V_BSTR(&varValue));
             break;
 
         case VT_NULL:
@@ -488,12 +617,18 @@ PyObject *PyCom_PyObjectFromVariant(const VARIANT *var)
             V_RECORDINFO(&varValue)->GetSize(&cb);
             result = PyObject_FromRecordInfo(V_RECORDINFO(&varValue), V_RECORD(&varValue), cb);
         } break;
+        case VT_DECIMAL:
+            if (PyCom_GetNumericConversion() & PYCOM_DECIMAL_AS_DECIMAL) {
+                result = PyObject_FromDECIMAL(V_DECIMAL(&varValue));
+                break;
+            }
+            // else it is returned as a string, like any other type - fall through.
         default: {
             HRESULT hr = VariantChangeType(&varValue, &varValue, 0, VT_BSTR);
             if (FAILED(hr)) {
                 TCHAR buf[200];
                 wsprintf(buf, _T("The Variant type (0x%x) is not supported, and it can not be converted to a string"),
-                         V_VT(var));
+                         vtOrig);
                 OleSetTypeError(buf);
                 break;
             }
@@ -501,16 +636,413 @@ PyObject *PyCom_PyObjectFromVariant(const VARIANT *var)
             break;
         }
     }
-
-    VariantClear(&varValue);
     return result;
 }
 
+// Does the COM half of PyCom_PyObjectFromVariant - the dereferencing copy
+// and any type change - so it can be done without the Python lock.  On
+// success pPrepared holds a value for PyCom_PyObjectFromPreparedVariant,
+// and the caller must VariantClear() it.  FALSE means the variant (eg, an
+// array, or one which can't be converted) should be given to
+// PyCom_PyObjectFromVariant as normal, and pPrepared is left empty.
+BOOL PyCom_PrepareVariantForPython(const VARIANT *var, VARIANT *pPrepared)
+{
+    VariantInit(pPrepared);
+    if (!var)
+        return FALSE;
+    while (V_VT(var) == (VT_BYREF | VT_VARIANT)) var = V_VARIANTREF(var);
+    if (V_ISVECTOR(var) || V_ISARRAY(var) || (V_VT(var) & VT_TYPEMASK) == VT_RECORD)
+        return FALSE;
+    if (FAILED(VariantCopyInd(pPrepared, (VARIANT *)var)))
+        return FALSE;
+    // Change to the types PyObjectFromVariantValue would.
+    VARTYPE vt;
+    switch (V_VT(pPrepared)) {
+        case VT_UI1:
+        case VT_UI2:
+        case VT_UINT:
+            vt = VT_UI4;
+            break;
+        case VT_I1:
+        case VT_I2:
+        case VT_INT:
+            vt = VT_I4;
+            break;
+        case VT_R4:
+            vt = VT_R8;
+            break;
+        case VT_BOOL:
+        case VT_UI4:
+        case VT_I4:
+        case VT_R8:
+        case VT_UI8:
+        case VT_I8:
+        case VT_HRESULT:
+        case VT_ERROR:
+        case VT_DISPATCH:
+        case VT_UNKNOWN:
+        case VT_BSTR:
+        case VT_NULL:
+        case VT_EMPTY:
+        case VT_DATE:
+        case VT_CY:
+            return TRUE;
+        default:
+            vt = VT_BSTR;
+            break;
+    }
+    if (FAILED(VariantChangeType(pPrepared, pPrepared, 0, vt))) {
+        // Leave it to PyCom_PyObjectFromVariant to report the error.
+        VariantClear(pPrepared);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Creates the object for a variant prepared by PyCom_PrepareVariantForPython,
+// without copying it again.  The variant may be changed, but still must be
+// cleared by the caller.
+PyObject *PyCom_PyObjectFromPreparedVariant(VARIANT *pPrepared)
+{
+    return PyObjectFromVariantValue(pPrepared, V_VT(pPrepared));
+}
+
+// As for PyCom_PyObjectFromVariant, but var belongs to the caller, who will
+// VariantClear() it - so a large BSTR can be moved into a PyBSTRBuffer
+// without ever being copied.
+PyObject *PyCom_PyObjectFromOwnedVariant(VARIANT *var)
+{
+    if (var && V_VT(var) == VT_BSTR)
+        return PyObjectFromVariantValue(var, VT_BSTR);
+    return PyCom_PyObjectFromVariant(var);
+}
+
 ///////////////////////////////////////////////////////////
 //
 // SAFEARRAY support - to/from SAFEARRAYS and Python sequences.
 //
 //
+// Bulk conversions between SAFEARRAYs of simple numeric types and objects
+// supporting the buffer interface.  These copy the data directly, without
+// creating (or examining) an object for each element.
+//
+// Objects supporting the buffer interface with a matching format are always
+// copied directly into a SAFEARRAY.  Converting a SAFEARRAY to a memoryview
+// (rather than nested tuples) must be explicitly enabled via
+// pythoncom.EnableSafeArrayBuffers(), as the result behaves differently to
+// a tuple (eg, it can't be compared to one).
+static BOOL bSafeArrayBuffers = FALSE;
+
+BOOL PyCom_EnableSafeArrayBuffers(BOOL bEnable)
+{
+    BOOL bOld = bSafeArrayBuffers;
+    bSafeArrayBuffers = bEnable;
+    return bOld;
+}
+
+// The struct module format for a SAFEARRAY element type, or NULL if
+// arrays of this type can't be treated as a simple buffer.
+static const char *SafeArrayBufferFormat(VARTYPE vt)
+{
+    switch (vt) {
+        case VT_I1:
+            return "b";
+        case VT_UI1:
+            return "B";
+        case VT_I2:
+            return "h";
+        case VT_UI2:
+            return "H";
+        case VT_I4:
+        case VT_INT:
+            return "i";
+        case VT_UI4:
+        case VT_UINT:
+            return "I";
+        case VT_I8:
+            return "q";
+        case VT_UI8:
+            return "Q";
+        case VT_R4:
+            return "f";
+        case VT_R8:
+            return "d";
+    }
+    return NULL;
+}
+
+// The reverse - the VARTYPE for a buffer format and item size, or VT_EMPTY if
+// the buffer can't be copied directly.
+static VARTYPE SafeArrayVTFromBufferFormat(const char *fmt, Py_ssize_t itemsize)
+{
+    if (fmt == NULL)  // NULL means unsigned bytes.
+        fmt = "B";
+    // We only support native (little-endian) byte order.
+    if (*fmt == '@' || *fmt == '=' || *fmt == '<')
+        fmt++;
+    if (fmt[0] == '\0' || fmt[1] != '\0')
+        return VT_EMPTY;
+    VARTYPE vt;
+    Py_ssize_t expected;
+    switch (fmt[0]) {
+        case 'b':
+            vt = VT_I1;
+            expected = 1;
+            break;
+        case 'B':
+            vt = VT_UI1;
+            expected = 1;
+            break;
+        case 'h':
+            vt = VT_I2;
+            expected = 2;
+            break;
+        case 'H':
+            vt = VT_UI2;
+            expected = 2;
+            break;
+        case 'i':
+        case 'l':
+            vt = VT_I4;
+            expected = 4;
+            break;
+        case 'I':
+        case 'L':
+            vt = VT_UI4;
+            expected = 4;
+            break;
+        case 'q':
+            vt = VT_I8;
+            expected = 8;
+            break;
+        case 'Q':
+            vt = VT_UI8;
+            expected = 8;
+            break;
+        case 'f':
+            vt = VT_R4;
+            expected = 4;
+            break;
+        case 'd':
+            vt = VT_R8;
+            expected = 8;
+            break;
+        default:
+            return VT_EMPTY;
+    }
+    return itemsize == expected ? vt : VT_EMPTY;
+}
+
+// Copy an array of nDims dimensions, each with shape[i] elements, between
+// buffers with arbitrary strides.  The SAFEARRAY layout has the first index
+// varying fastest, whereas Python buffers are normally C ordered (ie, the
+// last index varies fastest), so this is generally a transpose.
+static void StridedArrayCopy(BYTE *dest, const Py_ssize_t *destStrides, const BYTE *src, const Py_ssize_t *srcStrides,
+                             const Py_ssize_t *shape, UINT nDims, Py_ssize_t itemsize)
+{
+    Py_ssize_t total = 1;
+    BOOL bSameLayout = TRUE;
+    UINT d;
+    for (d = 0; d < nDims; d++) {
+        total *= shape[d];
+        if (destStrides[d] != srcStrides[d])
+            bSameLayout = FALSE;
+    }
+    if (total == 0)
+        return;
+    if (bSameLayout) {
+        // The destination is always contiguous, so the source is too - a
+        // single copy does it.
+        memcpy(dest, src, total * itemsize);
+        return;
+    }
+    Py_ssize_t *index = new Py_ssize_t[nDims];
+    memset(index, 0, sizeof(Py_ssize_t) * nDims);
+    Py_ssize_t destOffset = 0, srcOffset = 0;
+    for (Py_ssize_t n = 0; n < total; n++) {
+        memcpy(dest + destOffset, src + srcOffset, itemsize);
+        // Increment the index, last dimension fastest.
+        for (d = nDims; d-- > 0;) {
+            destOffset += destStrides[d];
+            srcOffset += srcStrides[d];
+            if (++index[d] < shape[d])
+                break;
+            destOffset -= destStrides[d] * shape[d];
+            srcOffset -= srcStrides[d] * shape[d];
+            index[d] = 0;
+        }
+    }
+    delete[] index;
+}
+
+// Fill in the shape and strides (in the order Python indexes the array) of a SAFEARRAY.
+static BOOL GetSafeArrayLayout(SAFEARRAY *psa, UINT nDims, Py_ssize_t *shape, Py_ssize_t *strides)
+{
+    Py_ssize_t stride = SafeArrayGetElemsize(psa);
+    for (UINT d = 0; d < nDims; d++) {
+        long lb, ub;
+        HRESULT hr = SafeArrayGetLBound(psa, d + 1, &lb);
+        if (SUCCEEDED(hr))
+            hr = SafeArrayGetUBound(psa, d + 1, &ub);
+        if (FAILED(hr)) {
+            PyCom_BuildPyException(hr);
+            return FALSE;
+        }
+        shape[d] = ub - lb + 1;
+        strides[d] = stride;
+        stride *= shape[d];
+    }
+    return TRUE;
+}
+
+// Convert a SAFEARRAY of a simple numeric type to a memoryview with the
+// same shape.  Returns NULL with no exception set if the array isn't
+// suitable, in which case the caller should use the normal conversion.
+static PyObject *PyCom_BufferFromSAFEARRAY(SAFEARRAY *psa, VARENUM vt)
+{
+    const char *fmt = SafeArrayBufferFormat(vt);
+    UINT nDims = SafeArrayGetDim(psa);
+    if (fmt == NULL || nDims == 0)
+        return NULL;
+    Py_ssize_t itemsize = SafeArrayGetElemsize(psa);
+    Py_ssize_t *shape = new Py_ssize_t[nDims];
+    Py_ssize_t *srcStrides = new Py_ssize_t[nDims];
+    Py_ssize_t *destStrides = new Py_ssize_t[nDims];
+    PyObject *ret = NULL;
+    PyObject *obBytes = NULL;
+    PyObject *obShape = NULL;
+    Py_ssize_t total = 1;
+    UINT d;
+    void *sa_buf;
+    HRESULT hr;
+    if (!GetSafeArrayLayout(psa, nDims, shape, srcStrides))
+        goto done;
+    for (d = 0; d < nDims; d++) {
+        if (shape[d] == 0) {
+            // memoryview can't represent an empty dimension.
+            goto done;
+        }
+        total *= shape[d];
+    }
+    // We return a C ordered view.
+    destStrides[nDims - 1] = itemsize;
+    for (d = nDims - 1; d > 0; d--) destStrides[d - 1] = destStrides[d] * shape[d];
+
+    obBytes = PyBytes_FromStringAndSize(NULL, total * itemsize);
+    if (obBytes == NULL)
+        goto done;
+    hr = SafeArrayAccessData(psa, &sa_buf);
+    if (FAILED(hr)) {
+        PyCom_BuildPyException(hr);
+        goto done;
+    }
+    StridedArrayCopy((BYTE *)PyBytes_AS_STRING(obBytes), destStrides, (BYTE *)sa_buf, srcStrides, shape, nDims,
+                     itemsize);
+    SafeArrayUnaccessData(psa);
+
+    obShape = PyTuple_New(nDims);
+    if (obShape == NULL)
+        goto done;
+    for (d = 0; d < nDims; d++) {
+        PyObject *obDim = PyInt_FromSsize_t(shape[d]);
+        if (obDim == NULL)
+            goto done;
+        PyTuple_SET_ITEM(obShape, d, obDim);
+    }
+    {
+        TmpPyObject view = PyMemoryView_FromObject(obBytes);
+        if (view == NULL)
+            goto done;
+        ret = PyObject_CallMethod(view, "cast", "sO", fmt, obShape);
+    }
+done:
+    Py_XDECREF(obShape);
+    Py_XDECREF(obBytes);
+    delete[] destStrides;
+    delete[] srcStrides;
+    delete[] shape;
+    return ret;
+}
+
+// Copy an object supporting the buffer interface directly into a SAFEARRAY,
+// creating or reusing the array as per PyCom_SAFEARRAYFromPyObjectEx.
+// Returns FALSE on error.  If returns TRUE, pConverted indicates if the
+// object was handled (it isn't if the format of the buffer doesn't match vt)
+static BOOL PyCom_SAFEARRAYFromBuffer(PyObject *obj, SAFEARRAY **ppSA, bool bAllocNewArray, VARENUM vt,
+                                      BOOL *pConverted)
+{
+    *pConverted = FALSE;
+    Py_buffer view;
+    if (PyObject_GetBuffer(obj, &view, PyBUF_RECORDS_RO) == -1) {
+        // Not a buffer we can use - let the normal conversion have a go.
+        PyErr_Clear();
+        return TRUE;
+    }
+    BOOL ok = TRUE;
+    UINT nDims = view.ndim;
+    if (nDims == 0 || SafeArrayVTFromBufferFormat(view.format, view.itemsize) != vt) {
+        PyBuffer_Release(&view);
+        return TRUE;
+    }
+    *pConverted = TRUE;
+    SAFEARRAYBOUND *pBounds = new SAFEARRAYBOUND[nDims];
+    Py_ssize_t *destStrides = new Py_ssize_t[nDims];
+    Py_ssize_t *shape = new Py_ssize_t[nDims];
+    UINT d;
+    for (d = 0; d < nDims; d++) {
+        pBounds[d].lLbound = 0;
+        pBounds[d].cElements = (ULONG)view.shape[d];
+    }
+    if (bAllocNewArray) {
+        *ppSA = SafeArrayCreate(vt, nDims, pBounds);
+        if (*ppSA == NULL) {
+            PyErr_SetString(PyExc_MemoryError, "CreatingSafeArray");
+            ok = FALSE;
+        }
+    }
+    else if (SafeArrayGetDim(*ppSA) != nDims) {
+        PyErr_SetString(PyExc_ValueError,
+                        "When refilling a safe array, the sequence must have the same number of dimensions as the "
+                        "existing array.");
+        ok = FALSE;
+    }
+    if (ok)
+        ok = GetSafeArrayLayout(*ppSA, nDims, shape, destStrides);
+    if (ok && !bAllocNewArray) {
+        for (d = 0; d < nDims; d++) {
+            if (shape[d] != view.shape[d]) {
+                PyErr_SetString(
+                    PyExc_ValueError,
+                    "When refilling a safe array, the sequences must be the same length as the existing array.");
+                ok = FALSE;
+                break;
+            }
+        }
+    }
+    if (ok) {
+        void *sa_buf;
+        HRESULT hr = SafeArrayAccessData(*ppSA, &sa_buf);
+        if (FAILED(hr)) {
+            PyCom_BuildPyException(hr);
+            ok = FALSE;
+        }
+        else {
+            StridedArrayCopy((BYTE *)sa_buf, destStrides, (BYTE *)view.buf, view.strides, shape, nDims,
+                             view.itemsize);
+            SafeArrayUnaccessData(*ppSA);
+        }
+    }
+    if (!ok && bAllocNewArray && *ppSA) {
+        SafeArrayDestroy(*ppSA);
+        *ppSA = NULL;
+    }
+    delete[] shape;
+    delete[] destStrides;
+    delete[] pBounds;
+    PyBuffer_Release(&view);
+    return ok;
+}
+
 // PyObject -> SafeArray
 static BOOL PyCom_SAFEARRAYFromPyObjectBuildDimension(PyObject *obj, SAFEARRAY *pSA, VARENUM vt, UINT dimNo, UINT nDims,
                                                       SAFEARRAYBOUND *pBounds, LONG *pIndices)
@@ -715,6 +1247,16 @@ static BOOL PyCom_SAFEARRAYFromPyObjectEx(PyObject *obj, SAFEARRAY **ppSA, bool
         // Otherwise we leave it alone!
         return TRUE;
     }
+    // Simple numeric buffers (eg, array.array or numpy arrays) are copied
+    // directly.  bytes and bytearray objects are handled as a sequence of
+    // bytes below, as they always have been.
+    if (vt != VT_VARIANT && !PyBytes_Check(obj) && !PyByteArray_Check(obj) && PyObject_CheckBuffer(obj)) {
+        BOOL bConverted;
+        if (!PyCom_SAFEARRAYFromBuffer(obj, ppSA, bAllocNewArray, vt, &bConverted))
+            return FALSE;
+        if (bConverted)
+            return TRUE;
+    }
     LONG cDims = 0;
     // Arbitrary-sized array dimensions contributed by Stefan Schukat Feb-2004
     // Allow arbitrary sized sequences to be transported to a COM server
@@ -1055,6 +1597,255 @@ PyObject *PyCom_PyObjectFromSAFEARRAYBuildDimension(SAFEARRAY *psa, VARENUM vt,
     return retTuple;
 }
 
+/* VT_VARIANT arrays (eg, an Excel Range.Value) are by far the most common,
+   so have their own converter.  The array is locked once and the VARIANTs
+   are read in place, rather than being copied out one at a time with
+   SafeArrayGetElement (which copies every BSTR, for example).  For 2
+   dimensional arrays, each column (which is contiguous in a SAFEARRAY) is
+   first scanned for its VARTYPEs - columns which are entirely VT_R8,
+   VT_BSTR or VT_EMPTY are then converted in a tight loop.
+*/
+
+// Convert an element of a VT_VARIANT array, handling the common simple types
+// inline.  The result is identical to PyCom_PyObjectFromVariant().
+static inline PyObject *PyObjectFromVariantArrayElement(VARIANT *var)
+{
+    switch (V_VT(var)) {
+        case VT_R8:
+            return PyFloat_FromDouble(V_R8(var));
+        case VT_BSTR:
+            return PyWinObject_FromBstr(V_BSTR(var));
+        case VT_EMPTY:
+        case VT_NULL:
+            Py_INCREF(Py_None);
+            return Py_None;
+        case VT_I4:
+            return PyInt_FromLong(V_I4(var));
+        case VT_BOOL: {
+            PyObject *ret = V_BOOL(var) ? Py_True : Py_False;
+            Py_INCREF(ret);
+            return ret;
+        }
+    }
+    return PyCom_PyObjectFromVariant(var);
+}
+
+// Build the tuple for dimension dimNo (zero based) from the VARIANTs
+// starting at pData.  strides are in elements, not bytes.
+static PyObject *PyObjectFromVariantArrayDimension(VARIANT *pData, UINT dimNo, UINT nDims, const Py_ssize_t *shape,
+                                                   const Py_ssize_t *strides)
+{
+    PyObject *ret = PyTuple_New(shape[dimNo]);
+    if (ret == NULL)
+        return NULL;
+    for (Py_ssize_t i = 0; i < shape[dimNo]; i++) {
+        VARIANT *pItem = pData + i * strides[dimNo];
+        PyObject *sub;
+        if (dimNo == nDims - 1)
+            sub = PyObjectFromVariantArrayElement(pItem);
+        else
+            sub = PyObjectFromVariantArrayDimension(pItem, dimNo + 1, nDims, shape, strides);
+        if (sub == NULL) {
+            Py_DECREF(ret);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(ret, i, sub);
+    }
+    return ret;
+}
+
+// The 2 dimensional case, converted a column at a time.
+static PyObject *PyObjectFromVariantArray2D(VARIANT *pData, Py_ssize_t numRows, Py_ssize_t numCols)
+{
+    PyObject *ret = PyTuple_New(numRows);
+    if (ret == NULL)
+        return NULL;
+    Py_ssize_t row, col;
+    for (row = 0; row < numRows; row++) {
+        PyObject *obRow = PyTuple_New(numCols);
+        if (obRow == NULL) {
+            Py_DECREF(ret);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(ret, row, obRow);
+    }
+    for (col = 0; col < numCols; col++) {
+        // The column is contiguous - see if it is all the same type.
+        VARIANT *pCol = pData + col * numRows;
+        VARTYPE vtCol = numRows ? V_VT(pCol) : VT_EMPTY;
+        for (row = 1; row < numRows; row++) {
+            if (V_VT(pCol + row) != vtCol) {
+                vtCol = VT_ILLEGAL;
+                break;
+            }
+        }
+        switch (vtCol) {
+            case VT_R8:
+                for (row = 0; row < numRows; row++) {
+                    PyObject *ob = PyFloat_FromDouble(V_R8(pCol + row));
+                    if (ob == NULL)
+                        goto error;
+                    PyTuple_SET_ITEM(PyTuple_GET_ITEM(ret, row), col, ob);
+                }
+                break;
+            case VT_BSTR:
+                for (row = 0; row < numRows; row++) {
+                    PyObject *ob = PyWinObject_FromBstr(V_BSTR(pCol + row));
+                    if (ob == NULL)
+                        goto error;
+                    PyTuple_SET_ITEM(PyTuple_GET_ITEM(ret, row), col, ob);
+                }
+                break;
+            case VT_EMPTY:
+                for (row = 0; row < numRows; row++) {
+                    Py_INCREF(Py_None);
+                    PyTuple_SET_ITEM(PyTuple_GET_ITEM(ret, row), col, Py_None);
+                }
+                break;
+            default:
+                for (row = 0; row < numRows; row++) {
+                    PyObject *ob = PyObjectFromVariantArrayElement(pCol + row);
+                    if (ob == NULL)
+                        goto error;
+                    PyTuple_SET_ITEM(PyTuple_GET_ITEM(ret, row), col, ob);
+                }
+                break;
+        }
+    }
+    return ret;
+error:
+    // The row tuples may be partially filled, but tuple dealloc handles NULL items.
+    Py_DECREF(ret);
+    return NULL;
+}
+
+/* VT_CY and VT_DECIMAL arrays (eg, money columns from ADO's GetRows) are also
+   read in place, rather than element by element with SafeArrayGetElement.
+   VT_DECIMAL elements are always returned as decimal.Decimal objects - such
+   arrays weren't supported at all before.
+*/
+static PyObject *PyObjectFromNumericArrayDimension(BYTE *pData, VARENUM vt, UINT dimNo, UINT nDims,
+                                                   const Py_ssize_t *shape, const Py_ssize_t *strides)
+{
+    PyObject *ret = PyTuple_New(shape[dimNo]);
+    if (ret == NULL)
+        return NULL;
+    for (Py_ssize_t i = 0; i < shape[dimNo]; i++) {
+        BYTE *pItem = pData + i * strides[dimNo];
+        PyObject *sub;
+        if (dimNo != nDims - 1)
+            sub = PyObjectFromNumericArrayDimension(pItem, vt, dimNo + 1, nDims, shape, strides);
+        else if (vt == VT_CY)
+            sub = PyObject_FromCurrency(*(CURRENCY *)pItem);
+        else
+            sub = PyObject_FromDECIMAL(*(DECIMAL *)pItem);
+        if (sub == NULL) {
+            Py_DECREF(ret);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(ret, i, sub);
+    }
+    return ret;
+}
+
+// Returns NULL with no exception set if the array can't be accessed directly.
+static PyObject *PyCom_PyObjectFromNumericSAFEARRAY(SAFEARRAY *psa, VARENUM vt)
+{
+    UINT nDims = SafeArrayGetDim(psa);
+    if (nDims == 0 || SafeArrayGetElemsize(psa) != (vt == VT_CY ? sizeof(CURRENCY) : sizeof(DECIMAL)))
+        return NULL;
+    Py_ssize_t *shape = new Py_ssize_t[nDims];
+    Py_ssize_t *strides = new Py_ssize_t[nDims];
+    PyObject *ret = NULL;
+    BYTE *pData;
+    if (GetSafeArrayLayout(psa, nDims, shape, strides)) {
+        HRESULT hr = SafeArrayAccessData(psa, (void **)&pData);
+        if (SUCCEEDED(hr)) {
+            ret = PyObjectFromNumericArrayDimension(pData, vt, 0, nDims, shape, strides);
+            SafeArrayUnaccessData(psa);
+        }
+    }
+    else
+        PyErr_Clear();  // let the normal conversion report the error.
+    delete[] strides;
+    delete[] shape;
+    return ret;
+}
+
+// Returns NULL with no exception set if the array can't be accessed
+// directly, in which case the caller should use the normal conversion.
+static PyObject *PyCom_PyObjectFromVariantSAFEARRAY(SAFEARRAY *psa)
+{
+    UINT nDims = SafeArrayGetDim(psa);
+    if (nDims == 0 || SafeArrayGetElemsize(psa) != sizeof(VARIANT))
+        return NULL;
+    Py_ssize_t *shape = new Py_ssize_t[nDims];
+    Py_ssize_t *strides = new Py_ssize_t[nDims];
+    PyObject *ret = NULL;
+    VARIANT *pData;
+    if (GetSafeArrayLayout(psa, nDims, shape, strides)) {
+        // GetSafeArrayLayout gives us byte strides.
+        for (UINT d = 0; d < nDims; d++) strides[d] /= sizeof(VARIANT);
+        HRESULT hr = SafeArrayAccessData(psa, (void **)&pData);
+        if (SUCCEEDED(hr)) {
+            if (nDims == 2)
+                ret = PyObjectFromVariantArray2D(pData, shape[0], shape[1]);
+            else
+                ret = PyObjectFromVariantArrayDimension(pData, 0, nDims, shape, strides);
+            SafeArrayUnaccessData(psa);
+        }
+    }
+    else
+        PyErr_Clear();  // let the normal conversion report the error.
+    delete[] strides;
+    delete[] shape;
+    return ret;
+}
+
+/* A 2 dimensional VT_VARIANT array as a list of tuples, one for each index
+   of the second dimension - ie, the transpose of what PyCom_PyObjectFromSAFEARRAY
+   returns.  This is the layout of ADO's Recordset.GetRows (fields by rows), and
+   as the fields of each row are contiguous, rows are built directly rather than
+   converting to columns which are then transposed in Python.
+*/
+PyObject *PyCom_PyObjectRowsFromSAFEARRAY(SAFEARRAY *psa)
+{
+    VARTYPE vt;
+    HRESULT hr = SafeArrayGetVartype(psa, &vt);
+    if (FAILED(hr))
+        return PyCom_BuildPyException(hr);
+    if (vt != VT_VARIANT || SafeArrayGetDim(psa) != 2 || SafeArrayGetElemsize(psa) != sizeof(VARIANT)) {
+        PyErr_SetString(PyExc_TypeError, "Only 2 dimensional arrays of VARIANTs can be converted to rows");
+        return NULL;
+    }
+    Py_ssize_t shape[2], strides[2];
+    if (!GetSafeArrayLayout(psa, 2, shape, strides))
+        return NULL;
+    Py_ssize_t numFields = shape[0], numRows = shape[1];
+    VARIANT *pData;
+    hr = SafeArrayAccessData(psa, (void **)&pData);
+    if (FAILED(hr))
+        return PyCom_BuildPyException(hr);
+    PyObject *ret = PyList_New(numRows);
+    for (Py_ssize_t row = 0; ret && row < numRows; row++) {
+        VARIANT *pRow = pData + row * numFields;
+        PyObject *obRow = PyTuple_New(numFields);
+        for (Py_ssize_t field = 0; obRow && field < numFields; field++) {
+            PyObject *ob = PyObjectFromVariantArrayElement(pRow + field);
+            if (ob == NULL)
+                Py_CLEAR(obRow);
+            else
+                PyTuple_SET_ITEM(obRow, field, ob);
+        }
+        if (obRow == NULL)
+            Py_CLEAR(ret);
+        else
+            PyList_SET_ITEM(ret, row, obRow);
+    }
+    SafeArrayUnaccessData(psa);
+    return ret;
+}
+
 /* Actual doer - Convert the specified safe array to a Python object - either a
    single tuple, or a tuples of tuples for each dimension
 */
@@ -1065,6 +1856,21 @@ PyObject *PyCom_PyObjectFromSAFEARRAY(SAFEARRAY *psa, VARENUM vt /* = VT_VARIANT
         OleSetTypeError(_T("Internal error - unexpected argument - only simple VARIANTTYPE expected"));
         return FALSE;
     }
+    if (bSafeArrayBuffers && vt != VT_UI1) {
+        PyObject *ret = PyCom_BufferFromSAFEARRAY(psa, vt);
+        if (ret || PyErr_Occurred())
+            return ret;
+    }
+    if (vt == VT_VARIANT) {
+        PyObject *ret = PyCom_PyObjectFromVariantSAFEARRAY(psa);
+        if (ret || PyErr_Occurred())
+            return ret;
+    }
+    if (vt == VT_CY || vt == VT_DECIMAL) {
+        PyObject *ret = PyCom_PyObjectFromNumericSAFEARRAY(psa, vt);
+        if (ret || PyErr_Occurred())
+            return ret;
+    }
     UINT nDim = SafeArrayGetDim(psa);
     LONG *pIndices = new LONG[nDim];
     PyObject *result = PyCom_PyObjectFromSAFEARRAYBuildDimension(psa, vt, 1, nDim, pIndices);
@@ -1272,7 +2078,7 @@ BOOL PythonOleArgHelper::MakeObjToVariant(PyObject *obj, VARIANT *var, PyObject
             break;
 
         case VT_BSTR:
-            if (PyString_Check(obj) || PyUnicode_Check(obj)) {
+            if (PyString_Check(obj) || PyUnicode_Check(obj) || PyBSTRBuffer_Check(obj)) {
                 if (!PyWinObject_AsBstr(obj, &V_BSTR(var)))
                     BREAK_FALSE
             }
@@ -1293,7 +2099,7 @@ BOOL PythonOleArgHelper::MakeObjToVariant(PyObject *obj, VARIANT *var, PyObject
             *V_BSTRREF(var) = NULL;
 
             if (!VALID_BYREF_MISSING(obj)) {
-                if (PyString_Check(obj) || PyUnicode_Check(obj)) {
+                if (PyString_Check(obj) || PyUnicode_Check(obj) || PyBSTRBuffer_Check(obj)) {
                     if (!PyWinObject_AsBstr(obj, V_BSTRREF(var)))
                         BREAK_FALSE
                 }
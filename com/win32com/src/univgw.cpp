@@ -11,6 +11,9 @@
 #include "univgw_dataconv.h"
 
 static PyObject *g_obRegisteredVTables = NULL;
+// IID -> vtable, so repeated CreateVTable calls for an interface share a
+// single vtable (and its thunks and dispatcher) rather than building new ones.
+static PyObject *g_obVTableCache = NULL;
 
 // ### copied from PyGatewayBase.cpp
 extern const GUID IID_IInternalUnwrapPythonObject;
@@ -27,6 +30,12 @@ typedef struct gw_vtbl {
     UINT cMethod;           // count of methods
     UINT cReservedMethods;  // number of reserved methods; 3 for IUnknown, 7 for IDispatch.
 
+    // One reference is owned by the Python object wrapping the vtable, and
+    // one by each tear-off using it - so a tear-off can be released without
+    // the Python object (and without the GIL).
+    LONG cRef;
+    unsigned char *thunks;  // executable code for all methods, in one block.
+
     // the vtable (the actual methods)
 #pragma warning(disable : 4200)
     pfnGWMethod methods[];
@@ -35,8 +44,7 @@ typedef struct gw_vtbl {
 } gw_vtbl;
 
 typedef struct gw_object {
-    pfnGWMethod *vtbl;
-    PyObject *obVTable;                 // reference to vtable
+    pfnGWMethod *vtbl;                  // a reference to the gw_vtbl is held.
     IInternalUnwrapPythonObject *punk;  // the identity interface
     LONG cRef;
 
@@ -157,94 +165,85 @@ STDMETHODIMP mockup(gw_object *_this)
 
 #endif  // COMPILE_MOCKUP
 
-static pfnGWMethod make_method(DWORD index, UINT argsize, UINT argc)
-{
-    unsigned char *code;
-
 #ifdef _M_IX86
 
-    static const unsigned char func_template[] = {
-        // ; 45   : STDMETHODIMP mockup(gw_object * _this)
-        // ; 46   : {
-        //  00000	55				push	 ebp
-        //  00001	8b ec			mov		 ebp, esp
-        //  00003	51				push	 ecx
-        0x55, 0x8b, 0xec, 0x51,
-
-        // ; 47   : 	va_list args;
-        // ; 48   : 	va_start(args, _this);
-        //  00004	8d 45 0c		lea		 eax, DWORD PTR __this$[ebp+4]
-        //  00007	89 45 fc		mov		 DWORD PTR _args$[ebp], eax
-        0x8d, 0x45, 0x0c, 0x89, 0x45, 0xfc,
-
-        // ; 49   : 	return univgw_dispatch(0x11223344, _this, args);
-        //  0000a	8b 4d fc		mov		 ecx, DWORD PTR _args$[ebp]
-        //  0000d	51				push	 ecx
-        //  0000e	8b 55 08		mov		 edx, DWORD PTR __this$[ebp]
-        //  00011	52				push	 edx
-        //  00012	68 44 33 22 11	push	 287454020		; 11223344H
-        //  00017	e8 00 00 00 00	call	 ?univgw_dispatch@@YAJKPAUgw_object@@PAD@Z ; univgw_dispatch
-        //  0001c	83 c4 0c	 	add		 esp, 12			; 0000000cH
-        0x8b, 0x4d, 0xfc, 0x51, 0x8b, 0x55, 0x08, 0x52, 0x68,
-        // offset = 19 (0x13)
-        0x44, 0x33, 0x22, 0x11,  // replace these with <index>
-        0xe8,
-        // offset = 24 (0x18)
-        0x00, 0x00, 0x00, 0x00,  // replace these with <univgw_dispatch>
-        0x83, 0xc4, 0x0c,
-
-        //; 50   : }
-        //  0001f	8b e5			mov		 esp, ebp
-        //  00021	5d				pop		 ebp
-        //  00022	c2 04 00		ret		 4
-        0x8b, 0xe5, 0x5d, 0xc2,
-        // offset = 35 (0x23)
-        0x04, 0x00,  // replace this with argsize
-    };
+static const unsigned char func_template[] = {
+    // ; 45   : STDMETHODIMP mockup(gw_object * _this)
+    // ; 46   : {
+    //  00000	55				push	 ebp
+    //  00001	8b ec			mov		 ebp, esp
+    //  00003	51				push	 ecx
+    0x55, 0x8b, 0xec, 0x51,
+
+    // ; 47   : 	va_list args;
+    // ; 48   : 	va_start(args, _this);
+    //  00004	8d 45 0c		lea		 eax, DWORD PTR __this$[ebp+4]
+    //  00007	89 45 fc		mov		 DWORD PTR _args$[ebp], eax
+    0x8d, 0x45, 0x0c, 0x89, 0x45, 0xfc,
+
+    // ; 49   : 	return univgw_dispatch(0x11223344, _this, args);
+    //  0000a	8b 4d fc		mov		 ecx, DWORD PTR _args$[ebp]
+    //  0000d	51				push	 ecx
+    //  0000e	8b 55 08		mov		 edx, DWORD PTR __this$[ebp]
+    //  00011	52				push	 edx
+    //  00012	68 44 33 22 11	push	 287454020		; 11223344H
+    //  00017	e8 00 00 00 00	call	 ?univgw_dispatch@@YAJKPAUgw_object@@PAD@Z ; univgw_dispatch
+    //  0001c	83 c4 0c	 	add		 esp, 12			; 0000000cH
+    0x8b, 0x4d, 0xfc, 0x51, 0x8b, 0x55, 0x08, 0x52, 0x68,
+    // offset = 19 (0x13)
+    0x44, 0x33, 0x22, 0x11,  // replace these with <index>
+    0xe8,
+    // offset = 24 (0x18)
+    0x00, 0x00, 0x00, 0x00,  // replace these with <univgw_dispatch>
+    0x83, 0xc4, 0x0c,
+
+    //; 50   : }
+    //  0001f	8b e5			mov		 esp, ebp
+    //  00021	5d				pop		 ebp
+    //  00022	c2 04 00		ret		 4
+    0x8b, 0xe5, 0x5d, 0xc2,
+    // offset = 35 (0x23)
+    0x04, 0x00,  // replace this with argsize
+};
+
+#elif _M_X64
+
+static const unsigned char func_template[] = {
+    0x48, 0x89, 0x54, 0x24, 0x10, /* mov [rsp + 16], rdx */
+    0x4c, 0x89, 0x44, 0x24, 0x18, /* mov [rsp + 24], r8  */
+    0x4c, 0x89, 0x4c, 0x24, 0x20, /* mov [rsp + 32], r9 */
+
+    0x48, 0x89, 0xca,                                           /* mov rdx, rcx */
+    0x4c, 0x8d, 0x44, 0x24, 0x10,                               /* lea r8, [rsp + 16] */
+    0x48, 0x83, 0xec, 0x28,                                     /* sub rsp, 40 - we have to keep stack 16-byte aligned */
+    0x48, 0xc7, 0xc1, 0x00, 0x00, 0x00, 0x00,                   /* mov rcx, imm32 */
+    0x48, 0xb8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* mov rax, imm64, target address */
+    0xff, 0xd0,                                                 /* call rax */
+    0x48, 0x83, 0xc4, 0x28,                                     /* add rsp, 40 */
+    0xc3                                                        /* ret */
+};
+
+#else  // other arches
+/* The MAINWIN toolkit allows us to build this on Linux!!! */
+#pragma message("XXXXXXXXX - win32com.universal wont work on this platform - need make_method")
+static const unsigned char func_template[] = {0};
+#endif
 
+// The thunks for all methods of a vtable are allocated in a single block,
+// each rounded up to 16 bytes.
+#define THUNK_SIZE ((sizeof(func_template) + 15) & ~15)
+
+// Fill in the thunk for method <index> at <code>, which must be writable.
+static pfnGWMethod make_method(unsigned char *code, DWORD index, UINT argsize, UINT argc)
+{
     // make a copy of code and plug in the appropriate values.
-    // NOTE: the call address is relative, and that the memory we allocate
-    // must be marked as 'executable' or DEP will kill us.  To be good
-    // citizens we leave the final page 'executable' but read-only.
-    code = (unsigned char *)VirtualAlloc(NULL, sizeof(func_template), MEM_COMMIT, PAGE_READWRITE);
-    if (code == NULL) {
-        PyErr_NoMemory();
-        return NULL;  // caller sets memory error
-    }
     memcpy(code, func_template, sizeof(func_template));
+#ifdef _M_IX86
+    // NOTE: the call address is relative.
     *(long *)&code[19] = index;
     *(long *)&code[24] = (long)&univgw_dispatch - (long)&code[28];
     *(short *)&code[35] = argsize;
-
-    DWORD oldprotect;
-    if (!VirtualProtect(code, sizeof(func_template), PAGE_EXECUTE, &oldprotect)) {
-        VirtualFree(code, 0, MEM_RELEASE);
-        PyErr_SetString(PyExc_RuntimeError, "failed to set memory attributes to executable");
-        return NULL;
-    }
 #elif _M_X64
-    static const unsigned char wrapper[] = {
-        0x48, 0x89, 0x54, 0x24, 0x10, /* mov [rsp + 16], rdx */
-        0x4c, 0x89, 0x44, 0x24, 0x18, /* mov [rsp + 24], r8  */
-        0x4c, 0x89, 0x4c, 0x24, 0x20, /* mov [rsp + 32], r9 */
-
-        0x48, 0x89, 0xca,                         /* mov rdx, rcx */
-        0x4c, 0x8d, 0x44, 0x24, 0x10,             /* lea r8, [rsp + 16] */
-        0x48, 0x83, 0xec, 0x28,                   /* sub rsp, 40 - we have to keep stack 16-byte aligned */
-        0x48, 0xc7, 0xc1, 0x00, 0x00, 0x00, 0x00, /* mov rcx, imm32 */
-        0x48, 0xb8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, /* mov rax, imm64, target address */
-        0xff, 0xd0,                                                 /* call rax */
-        0x48, 0x83, 0xc4, 0x28,                                     /* add rsp, 40 */
-        0xc3                                                        /* ret */
-    };
-
-    code = (unsigned char *)VirtualAlloc(NULL, sizeof(wrapper), MEM_COMMIT, PAGE_READWRITE);
-    if (code == NULL) {
-        PyErr_NoMemory();
-        return NULL;  // caller sets memory error
-    }
-    memcpy(code, &wrapper[0], sizeof(wrapper));
-
     for (int i = 0; i < 3; i++) {
         if (i < argc)
             continue;
@@ -253,18 +252,7 @@ static pfnGWMethod make_method(DWORD index, UINT argsize, UINT argc)
 
     *(int *)(code + 30) = index;
     *(void **)(code + 36) = &univgw_dispatch;
-
-    DWORD oldprotect;
-    if (!VirtualProtect(code, sizeof(wrapper), PAGE_EXECUTE, &oldprotect)) {
-        VirtualFree(code, 0, MEM_RELEASE);
-        PyErr_SetString(PyExc_RuntimeError, "failed to set memory attributes to executable");
-        return NULL;
-    }
-#else  // other arches
-    /* The MAINWIN toolkit allows us to build this on Linux!!! */
-#pragma message("XXXXXXXXX - win32com.universal wont work on this platform - need make_method")
 #endif
-
     return (pfnGWMethod)code;
 }
 
@@ -290,17 +278,18 @@ static STDMETHODIMP univgw_QueryInterface(gw_object *_this, REFIID riid, void **
 
 static STDMETHODIMP_(ULONG) univgw_AddRef(gw_object *_this) { return InterlockedIncrement(&_this->cRef); }
 
+static void release_vtbl(gw_vtbl *vtbl);
+
 static STDMETHODIMP_(ULONG) univgw_Release(gw_object *_this)
 {
     LONG cRef = InterlockedDecrement(&_this->cRef);
     if (cRef == 0) {
         _this->punk->Release();
-        CEnterLeavePython _celp;
-        Py_DECREF(_this->obVTable);
+        release_vtbl(GET_DEFN(_this));
         free(_this);
         return 0;
     }
-    return _this->cRef;
+    return cRef;
 }
 
 /* The IDispatch delegation when necessary */
@@ -330,7 +319,8 @@ static STDMETHODIMP univgw_Invoke(gw_object *_this, DISPID dispIdMember, REFIID
 
 /* End of IDispatch delegation */
 
-/* free the gw_vtbl object. also works on a partially constructed gw_vtbl. */
+/* free the gw_vtbl object. also works on a partially constructed gw_vtbl.
+   Must be called with the GIL held. */
 static void free_vtbl(gw_vtbl *vtbl)
 {
     assert(vtbl);
@@ -339,18 +329,28 @@ static void free_vtbl(gw_vtbl *vtbl)
     assert(vtbl->magic == GW_VTBL_MAGIC);
     Py_XDECREF(vtbl->dispatcher);
 
-    // free the methods. 0..2 are the constant IUnknown methods
-    for (int i = vtbl->cMethod; i-- > (int)vtbl->cReservedMethods;)
-        if (vtbl->methods[i] != NULL)
-            VirtualFree((void *)vtbl->methods[i], 0, MEM_RELEASE);
-    VirtualFree(vtbl, 0, MEM_RELEASE);
+    // free the methods. 0..2 are the constant IUnknown methods, and all the
+    // others live in the thunks block.
+    if (vtbl->thunks != NULL)
+        VirtualFree(vtbl->thunks, 0, MEM_RELEASE);
+    free(vtbl);
+}
+
+// Drop a reference to a vtable, freeing it if it was the last.
+// The GIL is acquired only if the vtable is actually freed.
+static void release_vtbl(gw_vtbl *vtbl)
+{
+    if (InterlockedDecrement(&vtbl->cRef) == 0) {
+        CEnterLeavePython _celp;
+        free_vtbl(vtbl);
+    }
 }
 
 #if PY_VERSION_HEX > 0x03010000
 // Use the new capsule API
 const char *capsule_name = "win32com universal gateway";
 
-static void __cdecl do_free_vtbl(PyObject *ob) { free_vtbl((gw_vtbl *)PyCapsule_GetPointer(ob, capsule_name)); }
+static void __cdecl do_free_vtbl(PyObject *ob) { release_vtbl((gw_vtbl *)PyCapsule_GetPointer(ob, capsule_name)); }
 
 static PyObject *PyVTable_Create(void *vtbl) { return PyCapsule_New(vtbl, capsule_name, do_free_vtbl); }
 static gw_vtbl *PyVTable_Get(PyObject *ob) { return (gw_vtbl *)PyCapsule_GetPointer(ob, capsule_name); }
@@ -361,7 +361,7 @@ static bool PyVTable_Check(PyObject *ob) { return PyCapsule_IsValid(ob, capsule_
 static void __cdecl do_free_vtbl(void *cobject)
 {
     gw_vtbl *vtbl = (gw_vtbl *)cobject;
-    free_vtbl(vtbl);
+    release_vtbl(vtbl);
 }
 
 static PyObject *PyVTable_Create(void *vtbl) { return PyCObject_FromVoidPtr(vtbl, do_free_vtbl); }
@@ -371,6 +371,29 @@ static gw_vtbl *PyVTable_Get(PyObject *ob) { return (gw_vtbl *)PyCObject_AsVoidP
 static bool PyVTable_Check(PyObject *ob) { return PyCObject_Check(ob) != 0; }
 #endif
 
+// Look up a cached vtable for an IID.  Returns a borrowed reference, or
+// NULL (without an exception) if there is no suitable cached vtable.
+static PyObject *GetCachedVTable(REFIID iid, int isDispatch)
+{
+    PyObject *obIID = PyWinObject_FromIID(iid);
+    if (obIID == NULL) {
+        PyErr_Clear();
+        return NULL;
+    }
+    PyObject *obVTable = PyDict_GetItem(g_obVTableCache, obIID);
+    Py_DECREF(obIID);
+    if (obVTable == NULL)
+        return NULL;
+    gw_vtbl *vtbl = PyVTable_Get(obVTable);
+    if (vtbl == NULL) {
+        PyErr_Clear();
+        return NULL;
+    }
+    if (vtbl->cReservedMethods != (isDispatch ? 7u : 3u))
+        return NULL;
+    return obVTable;
+}
+
 static PyObject *univgw_CreateVTable(PyObject *self, PyObject *args)
 {
     PyObject *obDef;
@@ -410,9 +433,6 @@ static PyObject *univgw_CreateVTable(PyObject *self, PyObject *args)
         Py_DECREF(methods);
         return NULL;
     }
-    PyObject *methodsArgc = PyObject_CallMethod(obDef, "vtbl_argcounts", NULL);
-    if (methodsArgc == NULL)
-        return NULL;
 
     int numReservedVtables = 3;  // the methods list should not specify IUnknown methods
 
@@ -421,23 +441,39 @@ static PyObject *univgw_CreateVTable(PyObject *self, PyObject *args)
 
     count += numReservedVtables;
 
-    // compute the size of the structure plus the method pointers
+    // An interface with a given IID has a fixed layout, so if we have
+    // already built a vtable for it, just share that one.
+    PyObject *obCached = GetCachedVTable(iid, isDispatch);
+    if (obCached != NULL && PyVTable_Get(obCached)->cMethod == (UINT)count) {
+        Py_DECREF(methods);
+        Py_INCREF(obCached);
+        return obCached;
+    }
+
+    PyObject *methodsArgc = PyObject_CallMethod(obDef, "vtbl_argcounts", NULL);
+    if (methodsArgc == NULL) {
+        Py_DECREF(methods);
+        return NULL;
+    }
+
+    // compute the size of the structure plus the method pointers.
+    // NOTE: the vtable itself is only data - it is the thunks the
+    // methods point to which must be in executable memory.
     size_t size = sizeof(gw_vtbl) + count * sizeof(pfnGWMethod);
-    // NOTE: we are allocating a function pointer, so the memory we
-    // allocate must be marked as 'executable' or DEP will kill us. To be
-    // good citizens we leave the final page 'executable' but read-only.
-    gw_vtbl *vtbl = (gw_vtbl *)VirtualAlloc(NULL, size, MEM_COMMIT, PAGE_READWRITE);
+    gw_vtbl *vtbl = (gw_vtbl *)malloc(size);
     if (vtbl == NULL) {
         Py_DECREF(methods);
+        Py_DECREF(methodsArgc);
         PyErr_NoMemory();
         return NULL;
     }
-    // memset(vtbl, 0, size); - reset by VirtualAlloc
+    memset(vtbl, 0, size);
 
     vtbl->magic = GW_VTBL_MAGIC;
     vtbl->iid = iid;
     vtbl->cMethod = count;
     vtbl->cReservedMethods = numReservedVtables;
+    vtbl->cRef = 1;  // owned by the PyObject we return.
 
     vtbl->dispatcher = PyObject_GetAttrString(obDef, "dispatch");
     if (vtbl->dispatcher == NULL)
@@ -454,6 +490,19 @@ static PyObject *univgw_CreateVTable(PyObject *self, PyObject *args)
         vtbl->methods[6] = (pfnGWMethod)univgw_Invoke;
     }
 
+    // All thunks go in one block, which must be marked as 'executable' or
+    // DEP will kill us.  To be good citizens we leave it 'executable' but
+    // read-only once the code is written.
+    size_t cbThunks;
+    cbThunks = (count - numReservedVtables) * THUNK_SIZE;
+    if (cbThunks) {
+        vtbl->thunks = (unsigned char *)VirtualAlloc(NULL, cbThunks, MEM_COMMIT, PAGE_READWRITE);
+        if (vtbl->thunks == NULL) {
+            PyErr_NoMemory();
+            goto error;
+        }
+    }
+
     // add the methods. NOTE: 0..2 are the constant IUnknown methods
     int i;
     for (i = vtbl->cMethod - numReservedVtables; i--;) {
@@ -462,13 +511,17 @@ static PyObject *univgw_CreateVTable(PyObject *self, PyObject *args)
             goto error;
 
         PyObject *obArgCount = PySequence_GetItem(methodsArgc, i);
-        if (obArgCount == NULL)
+        if (obArgCount == NULL) {
+            Py_DECREF(obArgSize);
             goto error;
+        }
 
         int argSize = PyInt_AsLong(obArgSize);
         Py_DECREF(obArgSize);
-        if (argSize == -1 && PyErr_Occurred())
+        if (argSize == -1 && PyErr_Occurred()) {
+            Py_DECREF(obArgCount);
             goto error;
+        }
 
         int argCount = PyInt_AsLong(obArgCount);
         Py_DECREF(obArgCount);
@@ -476,18 +529,16 @@ static PyObject *univgw_CreateVTable(PyObject *self, PyObject *args)
             goto error;
         // dynamically construct a function with the provided argument
         // size; reserve additional space for the _this argument.
-        pfnGWMethod meth = make_method(i, argSize + sizeof(void *), argCount + 1);
-        if (meth == NULL)
-            goto error;
-
-        vtbl->methods[i + numReservedVtables] = meth;
+        vtbl->methods[i + numReservedVtables] =
+            make_method(vtbl->thunks + i * THUNK_SIZE, i, argSize + sizeof(void *), argCount + 1);
     }
     Py_DECREF(methods);
+    methods = NULL;
     Py_DECREF(methodsArgc);
+    methodsArgc = NULL;
 
     DWORD oldprotect;
-    if (!VirtualProtect(vtbl, size, PAGE_EXECUTE, &oldprotect)) {
-        free_vtbl(vtbl);
+    if (cbThunks && !VirtualProtect(vtbl->thunks, cbThunks, PAGE_EXECUTE, &oldprotect)) {
         PyErr_SetString(PyExc_RuntimeError, "failed to set memory attributes to executable");
         goto error;
     }
@@ -498,14 +549,53 @@ static PyObject *univgw_CreateVTable(PyObject *self, PyObject *args)
         free_vtbl(vtbl);
         return NULL;
     }
+    // Remember it for next time - failure to do so is not fatal.
+    obIID = PyWinObject_FromIID(iid);
+    if (obIID == NULL || PyDict_SetItem(g_obVTableCache, obIID, result) != 0)
+        PyErr_Clear();
+    Py_XDECREF(obIID);
     return result;
 
 error:
-    Py_DECREF(methods);
+    Py_XDECREF(methods);
+    Py_XDECREF(methodsArgc);
     free_vtbl(vtbl);
     return NULL;
 }
 
+static PyObject *univgw_GetCachedVTable(PyObject *self, PyObject *args)
+{
+    PyObject *obIID;
+    int isDispatch = 0;
+    if (!PyArg_ParseTuple(args, "O|i:GetCachedVTable", &obIID, &isDispatch))
+        return NULL;
+    IID iid;
+    if (!PyWinObject_AsIID(obIID, &iid))
+        return NULL;
+    PyObject *ret = GetCachedVTable(iid, isDispatch);
+    if (ret == NULL)
+        ret = Py_None;
+    Py_INCREF(ret);
+    return ret;
+}
+
+static PyObject *univgw_GetVTableCacheSize(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":GetVTableCacheSize"))
+        return NULL;
+    return PyInt_FromLong(PyWin_SAFE_DOWNCAST(PyDict_Size(g_obVTableCache), Py_ssize_t, long));
+}
+
+static PyObject *univgw_ClearVTableCache(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":ClearVTableCache"))
+        return NULL;
+    // Any vtable still in use by a tear-off (or registered) stays alive.
+    PyDict_Clear(g_obVTableCache);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
 // Does all of the heavy lifting...
 // Returns the created vtable pointer.
 static IUnknown *CreateTearOff(PyObject *obInstance, PyGatewayBase *gatewayBase, PyObject *obVTable)
@@ -528,8 +618,7 @@ static IUnknown *CreateTearOff(PyObject *obInstance, PyGatewayBase *gatewayBase,
     punk->vtbl = vtbl->methods;
     punk->punk = (IInternalUnwrapPythonObject *)gatewayBase;
     punk->punk->AddRef();
-    punk->obVTable = obVTable;
-    Py_INCREF(obVTable);
+    InterlockedIncrement(&vtbl->cRef);
     // we start with one reference (the object we return)
     punk->cRef = 1;
     return (IUnknown *)punk;
@@ -709,6 +798,9 @@ static struct PyMethodDef univgw_functions[] = {
     {"ReadMemory", univgw_ReadMemory, 1},
     {"WriteMemory", univgw_WriteMemory, 1},
     {"RegisterVTable", univgw_RegisterVTable, 1},
+    {"GetCachedVTable", univgw_GetCachedVTable, 1},
+    {"GetVTableCacheSize", univgw_GetVTableCacheSize, 1},
+    {"ClearVTableCache", univgw_ClearVTableCache, 1},
 
     {"L64", dataconv_L64, 1},
     {"UL64", dataconv_UL64, 1},
@@ -718,6 +810,8 @@ static struct PyMethodDef univgw_functions[] = {
     {"SizeOfVT", dataconv_SizeOfVT, 1},
     {"WriteFromOutTuple", dataconv_WriteFromOutTuple, 1},
     {"ReadFromInTuple", dataconv_ReadFromInTuple, 1},
+    {"CompileArgLayout", dataconv_CompileArgLayout, 1},
+    {"GetArgLayoutSize", dataconv_GetArgLayoutSize, 1},
 
     {NULL} /* sentinel */
 };
@@ -742,6 +836,7 @@ BOOL initunivgw(PyObject *parentDict)
     //	if (!dict) return; /* Another serious error!*/
 
     g_obRegisteredVTables = PyDict_New();
+    g_obVTableCache = PyDict_New();
 
     PyDict_SetItemString(parentDict, "_univgw", module);
 
@@ -187,10 +187,199 @@ PyObject *dataconv_SizeOfVT(PyObject *self, PyObject *args)
 
 #define VALID_BYREF_MISSING(obUse) (obUse == Py_None || obUse->ob_type == &PyOleEmptyType)
 
+// Argument layouts
+//
+// The tuples describing a method's arguments are compiled into a
+// dataconv_layout once, when the vtable is defined, so that each call doesn't
+// have to re-read the tuples, work out the VARIANT type of each argument or
+// convert IIDs again.  ReadFromInTuple and WriteFromOutTuple accept either the
+// layout or the tuples they were compiled from.  Errors for unsupported types
+// are still only raised when that argument is converted.
+#if PY_VERSION_HEX > 0x03010000
+static const char *layout_capsule_name = "win32com universal gateway argument layout";
+
+static void __cdecl do_free_layout(PyObject *ob) { free(PyCapsule_GetPointer(ob, layout_capsule_name)); }
+
+static PyObject *PyArgLayout_Create(dataconv_layout *layout)
+{
+    return PyCapsule_New(layout, layout_capsule_name, do_free_layout);
+}
+static dataconv_layout *PyArgLayout_Get(PyObject *ob)
+{
+    if (!PyCapsule_IsValid(ob, layout_capsule_name))
+        return NULL;
+    return (dataconv_layout *)PyCapsule_GetPointer(ob, layout_capsule_name);
+}
+#else
+// The address of this identifies our CObjects, as the vtables are CObjects too.
+static char layout_cobject_desc[] = "win32com universal gateway argument layout";
+
+static void __cdecl do_free_layout(void *cobject, void *desc) { free(cobject); }
+
+static PyObject *PyArgLayout_Create(dataconv_layout *layout)
+{
+    return PyCObject_FromVoidPtrAndDesc(layout, layout_cobject_desc, do_free_layout);
+}
+static dataconv_layout *PyArgLayout_Get(PyObject *ob)
+{
+    if (!PyCObject_Check(ob) || PyCObject_GetDesc(ob) != layout_cobject_desc)
+        return NULL;
+    return (dataconv_layout *)PyCObject_AsVoidPtr(ob);
+}
+#endif
+
+// Builds a layout from a tuple of (vt, offset, size) tuples for in arguments,
+// or (vt, offset, size, iid) tuples for out arguments.  The result must be
+// freed with free().
+static dataconv_layout *CompileLayout(PyObject *obArgTypes, BOOL bIn)
+{
+    if (!PyTuple_Check(obArgTypes)) {
+        PyErr_SetString(PyExc_TypeError, "OLE type description - expecting a tuple");
+        return NULL;
+    }
+    Py_ssize_t cArgs = PyTuple_GET_SIZE(obArgTypes);
+    dataconv_layout *layout =
+        (dataconv_layout *)malloc(sizeof(dataconv_layout) + (cArgs ? cArgs - 1 : 0) * sizeof(dataconv_arg));
+    if (layout == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    layout->cArgs = cArgs;
+    layout->bIn = bIn;
+    for (Py_ssize_t i = 0; i < cArgs; i++) {
+        PyObject *obDesc = PyTuple_GET_ITEM(obArgTypes, i);
+        dataconv_arg *parg = layout->args + i;
+        // (<type tuple>, argPtr offset, arg size)
+        if (!PyTuple_Check(obDesc) || (bIn && PyTuple_GET_SIZE(obDesc) != 3) ||
+            (!bIn && PyTuple_GET_SIZE(obDesc) < 2)) {
+            PyErr_SetString(PyExc_TypeError, bIn ? "OLE type description - expecting an arg desc tuple of size 3"
+                                                 : "OLE type description - expecting an arg desc tuple");
+            free(layout);
+            return NULL;
+        }
+        parg->vt = (VARTYPE)PyInt_AsLong(PyTuple_GET_ITEM(obDesc, 0));
+        parg->offset = PyInt_AsLong(PyTuple_GET_ITEM(obDesc, 1));
+        if (PyErr_Occurred()) {
+            free(layout);
+            return NULL;
+        }
+#ifdef _M_IX86
+        parg->bIsByRef = (parg->vt & VT_BYREF) != 0;
+#elif _M_X64
+        // params > 64bits always passed by address - and the only
+        // arg we support > 64 bits is a VARIANT structure.
+        parg->bIsByRef = (parg->vt == VT_VARIANT) || (parg->vt & VT_BYREF);
+#else
+#error Unknown platform
+#endif
+        // The type and size used when ReadFromInTuple copies the arg into a VARIANT.
+        VARTYPE vtVariant = parg->vt;
+        VARTYPE vtConversionType = vtVariant & VT_TYPEMASK;
+        if (vtConversionType == VT_HRESULT || vtConversionType == VT_INT) {
+            // Preserve VT_BYREF or VT_ARRAY
+            vtVariant = VT_I4 | (vtVariant & VT_TYPEMASK);
+        }
+        if (vtVariant == VT_UINT) {
+            // Preserve VT_BYREF or VT_ARRAY
+            vtVariant = VT_UI4 | (vtVariant & VT_TYPEMASK);
+        }
+        parg->vtVariant = vtVariant;
+        int cb = 0;
+        parg->cbVariant = 0;
+        if (bIn && !(parg->vt & VT_ARRAY)) {
+            switch (vtConversionType) {
+                case VT_I2:
+                case VT_I4:
+                case VT_R4:
+                case VT_R8:
+                case VT_CY:
+                case VT_DATE:
+                case VT_BSTR:
+                case VT_ERROR:
+                case VT_BOOL:
+                case VT_I1:
+                case VT_UI1:
+                case VT_UI2:
+                case VT_UI4:
+                case VT_INT:
+                case VT_UINT:
+                case VT_UNKNOWN:
+                case VT_DISPATCH:
+                case VT_HRESULT:
+                    if (!SizeOfVT(vtVariant, &cb, NULL)) {
+                        free(layout);
+                        return NULL;
+                    }
+                    parg->cbVariant = cb;
+                    break;
+            }
+        }
+        // The interface an out VT_DISPATCH or VT_UNKNOWN is queried for.
+        parg->iid = (parg->vt & VT_TYPEMASK) == VT_DISPATCH ? IID_IDispatch : IID_IUnknown;
+        if (!bIn && PyTuple_GET_SIZE(obDesc) > 3) {
+            PyObject *obIID = PyTuple_GET_ITEM(obDesc, 3);
+            if (obIID != Py_None && !PyWinObject_AsIID(obIID, &parg->iid)) {
+                // As before layouts, a bad IID means the default is used.
+                PyErr_Clear();
+                parg->iid = (parg->vt & VT_TYPEMASK) == VT_DISPATCH ? IID_IDispatch : IID_IUnknown;
+            }
+        }
+    }
+    return layout;
+}
+
+// Gets the layout for arg types which are either a compiled layout or the tuple
+// it is compiled from.  *pbTemp is set if the result must be freed.
+static dataconv_layout *GetLayout(PyObject *obArgTypes, BOOL bIn, BOOL *pbTemp)
+{
+    dataconv_layout *layout = PyArgLayout_Get(obArgTypes);
+    if (layout) {
+        if (layout->bIn != bIn) {
+            PyErr_SetString(PyExc_TypeError, bIn ? "Expecting a layout compiled for in arguments"
+                                                 : "Expecting a layout compiled for out arguments");
+            return NULL;
+        }
+        *pbTemp = FALSE;
+        return layout;
+    }
+    *pbTemp = TRUE;
+    return CompileLayout(obArgTypes, bIn);
+}
+
+// CompileArgLayout(argTypes, bIn=True) - bIn is false for the out argument
+// tuples passed to WriteFromOutTuple.
+PyObject *dataconv_CompileArgLayout(PyObject *self, PyObject *args)
+{
+    PyObject *obArgTypes;
+    int bIn = TRUE;
+    if (!PyArg_ParseTuple(args, "O|i:CompileArgLayout", &obArgTypes, &bIn))
+        return NULL;
+    dataconv_layout *layout = CompileLayout(obArgTypes, bIn ? TRUE : FALSE);
+    if (layout == NULL)
+        return NULL;
+    PyObject *ret = PyArgLayout_Create(layout);
+    if (ret == NULL)
+        free(layout);
+    return ret;
+}
+
+// GetArgLayoutSize(layout) - the number of arguments in a compiled layout.
+PyObject *dataconv_GetArgLayoutSize(PyObject *self, PyObject *args)
+{
+    PyObject *obLayout;
+    if (!PyArg_ParseTuple(args, "O:GetArgLayoutSize", &obLayout))
+        return NULL;
+    dataconv_layout *layout = PyArgLayout_Get(obLayout);
+    if (layout == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Expecting an argument layout");
+        return NULL;
+    }
+    return PyInt_FromSsize_t(layout->cArgs);
+}
+
 PyObject *dataconv_WriteFromOutTuple(PyObject *self, PyObject *args)
 {
     PyObject *obArgTypes;
-    PyObject *obArgType;
     PyObject *obRetValues;
     PyObject *obPtr;
     PyObject *obOutValue;
@@ -200,6 +389,9 @@ PyObject *dataconv_WriteFromOutTuple(PyObject *self, PyObject *args)
     Py_ssize_t cArgs;
     UINT uiIndirectionLevel = 0;
     Py_ssize_t i;
+    dataconv_layout *layout;
+    dataconv_arg *parg;
+    BOOL bTempLayout;
 
     if (!PyArg_ParseTuple(args, "OOO:WriteFromOutTuple", &obRetValues, &obArgTypes, &obPtr))
         return NULL;
@@ -215,20 +407,19 @@ PyObject *dataconv_WriteFromOutTuple(PyObject *self, PyObject *args)
         return Py_None;
     }
 
-    if (!PyTuple_Check(obArgTypes)) {
-        PyErr_SetString(PyExc_TypeError, "OLE type description - expecting a tuple");
+    layout = GetLayout(obArgTypes, FALSE, &bTempLayout);
+    if (layout == NULL)
         return NULL;
-    }
 
-    cArgs = PyTuple_Size(obArgTypes);
+    cArgs = layout->cArgs;
     if (!PyTuple_Check(obRetValues) && (UINT)PyTuple_Size(obRetValues) != cArgs) {
         PyErr_Format(PyExc_TypeError, "Expecting a tuple of length %d or None.", cArgs);
-        return NULL;
+        goto Error;
     }
 
     for (i = 0; i < cArgs; i++) {
-        obArgType = PyTuple_GET_ITEM(PyTuple_GET_ITEM(obArgTypes, i), 0);
-        vtArgType = (VARTYPE)PyInt_AS_LONG(obArgType);
+        parg = layout->args + i;
+        vtArgType = parg->vt;
 
         // The following types aren't supported:
         // SAFEARRAY *: This requires support for SAFEARRAYs as a
@@ -242,7 +433,7 @@ PyObject *dataconv_WriteFromOutTuple(PyObject *self, PyObject *args)
         //              memory allocation policy.
 
         // Find the start of the argument.
-        pbArg = pbArgs + PyInt_AS_LONG(PyTuple_GET_ITEM(PyTuple_GET_ITEM(obArgTypes, i), 1));
+        pbArg = pbArgs + parg->offset;
         obOutValue = PyTuple_GET_ITEM(obRetValues, i);
 
         if (vtArgType & VT_ARRAY) {
@@ -273,7 +464,7 @@ PyObject *dataconv_WriteFromOutTuple(PyObject *self, PyObject *args)
                 // so we need to handle it very carefully....
                 SafeArrayDestroy(psa);
                 if (!PyCom_SAFEARRAYFromPyObject(obOutValue, &psa, rawVT))
-                    return NULL;
+                    goto Error;
             }
         }
 
@@ -480,24 +671,16 @@ PyObject *dataconv_WriteFromOutTuple(PyObject *self, PyObject *args)
                 break;
             }
             case VT_DISPATCH | VT_BYREF: {
-                PyObject *obIID = PyTuple_GET_ITEM(PyTuple_GET_ITEM(obArgTypes, i), 3);
-                IID iid = IID_IDispatch;
-                if (obIID != NULL && obIID != Py_None)
-                    PyWinObject_AsIID(obIID, &iid);
                 IDispatch **pdisp = *(IDispatch ***)pbArg;
-                if (!PyCom_InterfaceFromPyInstanceOrObject(obOutValue, iid, (void **)pdisp, TRUE)) {
+                if (!PyCom_InterfaceFromPyInstanceOrObject(obOutValue, parg->iid, (void **)pdisp, TRUE)) {
                     goto Error;
                 }
                 // COM Reference added by InterfaceFrom...
                 break;
             }
             case VT_UNKNOWN | VT_BYREF: {
-                PyObject *obIID = PyTuple_GET_ITEM(PyTuple_GET_ITEM(obArgTypes, i), 3);
-                IID iid = IID_IUnknown;
-                if (obIID != NULL && obIID != Py_None)
-                    PyWinObject_AsIID(obIID, &iid);
                 IUnknown **punk = *(IUnknown ***)pbArg;
-                if (!PyCom_InterfaceFromPyInstanceOrObject(obOutValue, iid, (void **)punk, TRUE)) {
+                if (!PyCom_InterfaceFromPyInstanceOrObject(obOutValue, parg->iid, (void **)punk, TRUE)) {
                     goto Error;
                 }
                 // COM Reference added by InterfaceFrom...
@@ -540,16 +723,19 @@ PyObject *dataconv_WriteFromOutTuple(PyObject *self, PyObject *args)
         Py_XDECREF(obUse);
     }
 
+    if (bTempLayout)
+        free(layout);
     Py_INCREF(Py_None);
     return Py_None;
 Error:
+    if (bTempLayout)
+        free(layout);
     return NULL;
 }
 
 PyObject *dataconv_ReadFromInTuple(PyObject *self, PyObject *args)
 {
     PyObject *obArgTypes;
-    PyObject *obArgType;
     PyObject *obPtr;
     BYTE *pb;
     BYTE *pbArg;
@@ -557,9 +743,11 @@ PyObject *dataconv_ReadFromInTuple(PyObject *self, PyObject *args)
     PyObject *obArgs = NULL;
     PyObject *obArg;
     VARTYPE vtArgType;
-    UINT cb;
     VARIANT var;
     BOOL bIsByRef;
+    dataconv_layout *layout;
+    dataconv_arg *parg;
+    BOOL bTempLayout;
 
     if (!PyArg_ParseTuple(args, "OO:ReadFromInTuple", &obArgTypes, &obPtr))
         return NULL;
@@ -571,37 +759,21 @@ PyObject *dataconv_ReadFromInTuple(PyObject *self, PyObject *args)
 
     pb = pbArg;
 
-    if (!PyTuple_Check(obArgTypes)) {
-        PyErr_SetString(PyExc_TypeError, "OLE type description - expecting a tuple");
+    layout = GetLayout(obArgTypes, TRUE, &bTempLayout);
+    if (layout == NULL)
         return NULL;
-    }
 
-    cArgs = PyTuple_Size(obArgTypes);
+    cArgs = layout->cArgs;
     obArgs = PyTuple_New(cArgs);
     if (!obArgs)
-        return NULL;
+        goto Error;
 
     for (i = 0; i < cArgs; i++) {
-        // (<type tuple>, argPtr offset, arg size)
-        if (PyTuple_Size(PyTuple_GET_ITEM(obArgTypes, i)) != 3) {
-            PyErr_SetString(PyExc_TypeError, "OLE type description - expecting an arg desc tuple of size 3");
-            goto Error;
-        }
-
-        obArgType = PyTuple_GET_ITEM(PyTuple_GET_ITEM(obArgTypes, i), 0);
-
+        parg = layout->args + i;
         // Position pb to point to the current argument.
-        pb = pbArg + PyInt_AS_LONG(PyTuple_GET_ITEM(PyTuple_GET_ITEM(obArgTypes, i), 1));
-        vtArgType = (VARTYPE)PyInt_AS_LONG(obArgType);
-#ifdef _M_IX86
-        bIsByRef = vtArgType & VT_BYREF;
-#elif _M_X64
-        // params > 64bits always passed by address - and the only
-        // arg we support > 64 bits is a VARIANT structure.
-        bIsByRef = (vtArgType == VT_VARIANT) || (vtArgType & VT_BYREF);
-#else
-#error Unknown platform
-#endif
+        pb = pbArg + parg->offset;
+        vtArgType = parg->vt;
+        bIsByRef = parg->bIsByRef;
         VARTYPE vtConversionType = vtArgType & VT_TYPEMASK;
         if (vtArgType & VT_ARRAY) {
             SAFEARRAY FAR *psa = *((SAFEARRAY **)pb);
@@ -642,19 +814,10 @@ PyObject *dataconv_ReadFromInTuple(PyObject *self, PyObject *args)
                 case VT_DISPATCH:
                 case VT_HRESULT:
                     VariantInit(&var);
-                    if (vtConversionType == VT_HRESULT || vtConversionType == VT_INT) {
-                        // Preserve VT_BYREF or VT_ARRAY
-                        vtArgType = VT_I4 | (vtArgType & VT_TYPEMASK);
-                    }
-                    if (vtArgType == VT_UINT) {
-                        // Preserve VT_BYREF or VT_ARRAY
-                        vtArgType = VT_UI4 | (vtArgType & VT_TYPEMASK);
-                    }
-                    V_VT(&var) = vtArgType;
+                    // The layout has the VARIANT type and size worked out.
+                    V_VT(&var) = parg->vtVariant;
                     // Copy the data into the variant...
-                    if (!SizeOfVT(V_VT(&var), (int *)&cb, NULL))
-                        goto Error;
-                    memcpy(&V_I4(&var), pb, cb);
+                    memcpy(&V_I4(&var), pb, parg->cbVariant);
                     // Convert it into a PyObject:
                     obArg = PyCom_PyObjectFromVariant(&var);
                     break;
@@ -712,9 +875,13 @@ PyObject *dataconv_ReadFromInTuple(PyObject *self, PyObject *args)
         PyTuple_SET_ITEM(obArgs, i, obArg);
     }
 
+    if (bTempLayout)
+        free(layout);
     return obArgs;
 
 Error:
+    if (bTempLayout)
+        free(layout);
     Py_XDECREF(obArgs);
     return NULL;
 }
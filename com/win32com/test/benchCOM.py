@@ -0,0 +1,194 @@
+# A benchmark for the COM marshalling hot paths.
+#
+# Calls an in-process Python COM server through pythoncom's native
+# PyIDispatch and PyIEnumVARIANT clients, so every round trip goes through
+# the C++ argument conversion (PyCom_VariantFromPyObject and friends, the
+# SAFEARRAY and record code), the gateway dispatch and back again.
+#
+# Usage: benchCOM.py [options]
+#   -n iterations   calls per timing run (default 20000)
+#   -r repeat       timing runs per benchmark, the best is reported (default 5)
+#   --json file     also write the results to file as JSON
+#   --compare file  compare against (JSON) results saved by an earlier run
+#   --filter text   only run benchmarks whose name contains text
+import sys
+import json
+import time
+import getopt
+import pythoncom
+import win32com.server.util
+import win32com.server.connect
+
+# The PyCOMTest type library, which supplies the record used by the record
+# benchmarks - they are skipped if it isn't registered.
+PyCOMTest_LIBID = "{6BCDCB60-5605-11D0-AE5F-CADD4C000000}"
+TestStruct1_GUID = "{7A4CE6A7-7959-4E85-A3C0-B41442FF0F67}"
+
+class BenchServer(win32com.server.connect.ConnectableServer):
+    _public_methods_ = ["Echo", "Echo2", "GetEnum", "Fire"] + \
+                       win32com.server.connect.ConnectableServer._public_methods_
+    _connect_interfaces_ = [pythoncom.IID_IDispatch]
+
+    def Echo(self, v):
+        return v
+
+    def Echo2(self, a, b):
+        return a, b
+
+    def GetEnum(self, n):
+        return win32com.server.util.NewEnum(list(range(n)))
+
+    def Fire(self, v):
+        self._BroadcastNotify(self._Notify, (v,))
+
+    def _Notify(self, interface, v):
+        interface.Invoke(1, 0, pythoncom.DISPATCH_METHOD, 0, v)
+
+class BenchSink:
+    _public_methods_ = ["OnEvent"]
+    _dispid_to_func_ = {1: "OnEvent"}
+
+    def OnEvent(self, v):
+        pass
+
+def _invoker(disp, name, *args):
+    dispid = disp.GetIDsOfNames(name)
+    invoke = disp.Invoke
+    def call():
+        return invoke(dispid, 0, pythoncom.DISPATCH_METHOD, 1, *args)
+    return call
+
+def _typed_invoker(disp, name, argTypes, *args):
+    # The same call via InvokeTypes, which is what makepy generated code uses.
+    dispid = disp.GetIDsOfNames(name)
+    invoke = disp.InvokeTypes
+    argTypes = tuple((t, pythoncom.PARAMFLAG_FIN) for t in argTypes)
+    resultType = (pythoncom.VT_VARIANT, 0)
+    def call():
+        return invoke(dispid, 0, pythoncom.DISPATCH_METHOD, resultType, argTypes, *args)
+    return call
+
+def _get_record():
+    try:
+        return pythoncom.GetRecordFromGuids(PyCOMTest_LIBID, 1, 1, 0, TestStruct1_GUID)
+    except pythoncom.com_error:
+        return None
+
+def get_benchmarks(disp):
+    """Returns a list of (name, callable) - each callable makes one round trip"""
+    row = list(range(100))
+    grid = [list(range(10)) for i in range(10)]
+    ret = [
+        ("scalar/int", _invoker(disp, "Echo", 12345)),
+        ("scalar/float", _invoker(disp, "Echo", 1.5)),
+        ("scalar/bool", _invoker(disp, "Echo", True)),
+        ("scalar/2 args", _invoker(disp, "Echo2", 1, 2.0)),
+        ("scalar/int typed", _typed_invoker(disp, "Echo", (pythoncom.VT_I4,), 12345)),
+        ("bstr/short", _invoker(disp, "Echo", "hello world")),
+        ("bstr/4k", _invoker(disp, "Echo", "x" * 4096)),
+        ("bstr/short typed", _typed_invoker(disp, "Echo", (pythoncom.VT_BSTR,), "hello world")),
+        ("safearray/1d 100 ints", _invoker(disp, "Echo", row)),
+        ("safearray/1d 100 strs", _invoker(disp, "Echo", [str(i) for i in row])),
+        ("safearray/2d 10x10 ints", _invoker(disp, "Echo", grid)),
+        ("safearray/1d 100 R8 typed",
+         _typed_invoker(disp, "Echo", (pythoncom.VT_ARRAY | pythoncom.VT_R8,), [float(i) for i in row])),
+    ]
+
+    rec = _get_record()
+    if rec is not None:
+        rec.int_value = 99
+        rec.str_value = "hello"
+        ret.append(("record/TestStruct1", _invoker(disp, "Echo", rec)))
+        ret.append(("record/10 TestStruct1", _invoker(disp, "Echo", [rec] * 10)))
+    else:
+        print("PyCOMTest is not registered - skipping the record benchmarks", file=sys.stderr)
+
+    enum = disp.Invoke(disp.GetIDsOfNames("GetEnum"), 0, pythoncom.DISPATCH_METHOD, 1, 100)
+    enum = enum.QueryInterface(pythoncom.IID_IEnumVARIANT)
+    def enum_all():
+        enum.Reset()
+        return enum.Next(100)
+    def enum_one():
+        enum.Reset()
+        return enum.Next(1)
+    ret.append(("enum/Next(1)", enum_one))
+    ret.append(("enum/Next(100)", enum_all))
+
+    sink = win32com.server.util.wrap(BenchSink())
+    cp = disp.QueryInterface(pythoncom.IID_IConnectionPointContainer).FindConnectionPoint(pythoncom.IID_IDispatch)
+    cp.Advise(sink)
+    ret.append(("event/int", _invoker(disp, "Fire", 12345)))
+    ret.append(("event/bstr", _invoker(disp, "Fire", "hello world")))
+    return ret
+
+def time_benchmark(fn, iterations, repeat):
+    # Returns the best average time of a call, in nanoseconds.
+    fn()  # warm up any caches.
+    best = None
+    for r in range(repeat):
+        start = time.perf_counter()
+        for i in range(iterations):
+            fn()
+        elapsed = time.perf_counter() - start
+        if best is None or elapsed < best:
+            best = elapsed
+    return best / iterations * 1e9
+
+def run(iterations, repeat, filter=None):
+    disp = win32com.server.util.wrap(BenchServer())
+    results = {}
+    for name, fn in get_benchmarks(disp):
+        if filter and filter not in name:
+            continue
+        results[name] = time_benchmark(fn, iterations, repeat)
+    return {
+        "python": sys.version.split()[0],
+        "platform": sys.platform,
+        "iterations": iterations,
+        "repeat": repeat,
+        "results": results,  # name -> nanoseconds per call
+    }
+
+def report(data, baseline=None):
+    if baseline is None:
+        print("%-30s %12s" % ("benchmark", "ns/call"))
+    else:
+        print("%-30s %12s %12s %8s" % ("benchmark", "ns/call", "baseline", "ratio"))
+    base_results = baseline["results"] if baseline else {}
+    for name in sorted(data["results"]):
+        ns = data["results"][name]
+        if baseline is None:
+            print("%-30s %12.0f" % (name, ns))
+        elif name in base_results:
+            print("%-30s %12.0f %12.0f %7.2fx" % (name, ns, base_results[name], ns / base_results[name]))
+        else:
+            print("%-30s %12.0f %12s %8s" % (name, ns, "-", "-"))
+
+def main():
+    iterations = 20000
+    repeat = 5
+    json_file = compare_file = filter = None
+    opts, args = getopt.getopt(sys.argv[1:], "n:r:", ["json=", "compare=", "filter="])
+    for o, a in opts:
+        if o == "-n":
+            iterations = int(a)
+        elif o == "-r":
+            repeat = int(a)
+        elif o == "--json":
+            json_file = a
+        elif o == "--compare":
+            compare_file = a
+        elif o == "--filter":
+            filter = a
+    baseline = None
+    if compare_file:
+        with open(compare_file) as f:
+            baseline = json.load(f)
+    data = run(iterations, repeat, filter)
+    report(data, baseline)
+    if json_file:
+        with open(json_file, "w") as f:
+            json.dump(data, f, indent=1, sort_keys=True)
+
+if __name__=='__main__':
+    main()
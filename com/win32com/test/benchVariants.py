@@ -0,0 +1,40 @@
+# A micro-benchmark for the conversion of Python objects to VARIANTs.
+#
+# For each type of value, reports the average cost of a single conversion
+# using both the generic conversion code and the exact-type fast path.
+# Usage: benchVariants.py [iterations]
+import sys
+import pythoncom
+import pywintypes
+import win32com.server.util
+
+class Tester:
+    _public_methods_ = [ 'Echo' ]
+    def Echo(self, v):
+        return v
+
+def get_values():
+    disp = win32com.server.util.wrap(Tester())
+    return [
+        ("int", 12345),
+        ("large int", 2**40),
+        ("float", 1.5),
+        ("str", "hello world"),
+        ("bool", True),
+        ("None", None),
+        ("PyIDispatch", disp),
+        ("pywintypes.datetime", pywintypes.Time(0)),
+    ]
+
+def main(iterations=100000):
+    print("%-20s %12s %12s %8s" % ("type", "generic (ns)", "fast (ns)", "speedup"))
+    for name, value in get_values():
+        generic = pythoncom._TimeVariantConversion([value], iterations, False)
+        fast = pythoncom._TimeVariantConversion([value], iterations, True)
+        print("%-20s %12.1f %12.1f %7.1fx" % (name, generic * 1e9, fast * 1e9, generic / fast))
+
+if __name__=='__main__':
+    if len(sys.argv) > 1:
+        main(int(sys.argv[1]))
+    else:
+        main()
@@ -47,6 +47,17 @@ def test():
             raise error("The scode element of the exception tuple did not yield the correct scode", com_exc)
         if exc[2] != "Not today":
             raise error("The description in the exception tuple did not yield the correct string", com_exc)
+    # Messages are cached per HRESULT - repeated failures must still get
+    # the same message, and their own error info.
+    for i in range(2):
+        try:
+            com_server.Clone()
+            raise error("Expecting this call to fail!")
+        except pythoncom.com_error as com_exc:
+            if com_exc.strerror != pythoncom.GetScodeString(winerror.E_UNEXPECTED):
+                raise error("The message for a repeated failure was not correct", com_exc)
+            if com_exc.excepinfo[2] != "Not today":
+                raise error("The description for a repeated failure was not correct", com_exc)
     cap = CaptureWriter()
     try:
         cap.capture()
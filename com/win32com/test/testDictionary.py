@@ -87,5 +87,27 @@ class TestCase(win32com.test.util.TestCase):
     def testDict(self):
         TestDict()
 
+    def testProgIDCache(self):
+        Register(True)
+        pywintypes.ClearIIDCache()
+        before = pythoncom.GetProgIDCacheStats()
+        self.failUnless(before['enabled'])
+        clsid = pywintypes.IID("Python.Dictionary")
+        # ProgIDs are not case sensitive, so this is a hit.
+        self.failUnlessEqual(pywintypes.IID("python.dictionary"), clsid)
+        after = pythoncom.GetProgIDCacheStats()
+        self.failUnlessEqual(after['misses'], before['misses'] + 1)
+        self.failUnlessEqual(after['hits'], before['hits'] + 1)
+        self.failUnlessEqual(after['entries'], 1)
+        pywintypes.ClearIIDCache()
+        self.failUnlessEqual(pythoncom.GetProgIDCacheStats()['entries'], 0)
+        pythoncom.EnableProgIDCache(True, True)
+        try:
+            self.failUnless(pythoncom.GetProgIDCacheStats()['watching'])
+            self.failUnlessEqual(pywintypes.IID("Python.Dictionary"), clsid)
+        finally:
+            pythoncom.EnableProgIDCache(True, False)
+        self.failIf(pythoncom.GetProgIDCacheStats()['watching'])
+
 if __name__=='__main__':
     unittest.main()
@@ -0,0 +1,120 @@
+# Tests for the name and Invoke caches kept by Python COM gateways.
+import unittest
+
+import pythoncom
+import winerror
+import win32com.test.util
+import win32com.client
+import win32com.server.util
+import win32com.server.policy
+from win32com.server.exception import COMException
+
+class Counter:
+    _public_methods_ = []
+    def __init__(self):
+        self.names = {"foo": 10, "bar": 11}
+        self.lookups = 0
+    def _getidsofnames_(self, names, lcid):
+        self.lookups += 1
+        try:
+            return (self.names[names[0].lower()],)
+        except KeyError:
+            raise COMException(scode=winerror.DISP_E_UNKNOWNNAME)
+
+class Methods:
+    _public_methods_ = ['Add', 'Fail']
+    _public_attrs_ = ['value']
+    def __init__(self):
+        self.value = 1
+    def Add(self, a, b):
+        return a + b
+    def Fail(self):
+        raise COMException(desc="failed", scode=winerror.E_UNEXPECTED)
+
+class CustomInvoke(Methods):
+    def _invokeex_(self, dispid, lcid, wFlags, args, kwargs, serviceProvider):
+        return "custom"
+
+class TestCase(win32com.test.util.TestCase):
+    def setUp(self):
+        self.ob = Counter()
+        self.disp = win32com.server.util.wrap(self.ob)
+
+    def tearDown(self):
+        self.disp = None
+        pythoncom.InvalidateDispIDCache()
+
+    def testRepeatedLookup(self):
+        self.assertEqual(self.disp.GetIDsOfNames("foo"), 10)
+        self.assertEqual(self.disp.GetIDsOfNames("foo"), 10)
+        # Case is ignored by the cache, just like by the policy.
+        self.assertEqual(self.disp.GetIDsOfNames("FOO"), 10)
+        self.assertEqual(self.ob.lookups, 1)
+        self.assertEqual(self.disp.GetIDsOfNames("bar"), 11)
+        self.assertEqual(self.ob.lookups, 2)
+
+    def testUnknownNotCached(self):
+        for i in range(2):
+            try:
+                self.disp.GetIDsOfNames("baz")
+                self.fail("expected a com_error")
+            except pythoncom.com_error as exc:
+                self.assertEqual(exc.hresult, winerror.DISP_E_UNKNOWNNAME)
+        self.assertEqual(self.ob.lookups, 2)
+
+    def testInvalidateObject(self):
+        self.assertEqual(self.disp.GetIDsOfNames("foo"), 10)
+        self.ob.names["foo"] = 20
+        self.assertEqual(self.disp.GetIDsOfNames("foo"), 10)
+        pythoncom.InvalidateDispIDCache(self.disp)
+        self.assertEqual(self.disp.GetIDsOfNames("foo"), 20)
+        self.assertEqual(self.ob.lookups, 2)
+
+    def testInvalidateAll(self):
+        self.assertEqual(self.disp.GetIDsOfNames("foo"), 10)
+        self.ob.names["foo"] = 20
+        pythoncom.InvalidateDispIDCache()
+        self.assertEqual(self.disp.GetIDsOfNames("foo"), 20)
+
+    def testInvalidateForeign(self):
+        # Not a Python gateway - silently ignored.
+        pythoncom.InvalidateDispIDCache(pythoncom.CreateBindCtx())
+
+class InvokeTestCase(win32com.test.util.TestCase):
+    def testDirectCallables(self):
+        ob = Methods()
+        policy = win32com.server.policy.DesignatedWrapPolicy(ob)
+        self.assertEqual(sorted(policy._dispid_to_callable_.values(), key=lambda f: f.__name__),
+                         [ob.Add, ob.Fail])
+        client = win32com.client.Dispatch(win32com.server.util.wrap(ob))
+        self.assertEqual(client.Add(2, 3), 5)
+        self.assertEqual(client.value, 1)
+        client.value = 2
+        self.assertEqual(ob.value, 2)
+        try:
+            client.Fail()
+            self.fail("expected a com_error")
+        except pythoncom.com_error as exc:
+            self.assertEqual(exc.excepinfo[2], "failed")
+
+    def testPolicyCanUpdate(self):
+        ob = Methods()
+        policy = win32com.server.policy.DesignatedWrapPolicy(ob)
+        disp = pythoncom.WrapObject(policy)
+        client = win32com.client.Dispatch(disp)
+        self.assertEqual(client.Add(2, 3), 5)
+        dispid = disp.GetIDsOfNames("Add")
+        policy._dispid_to_callable_[dispid] = lambda a, b: a * b
+        self.assertEqual(client.Add(2, 3), 6)
+        del policy._dispid_to_callable_[dispid]
+        self.assertEqual(client.Add(2, 3), 5)
+
+    def testCustomInvoke(self):
+        ob = CustomInvoke()
+        policy = win32com.server.policy.DesignatedWrapPolicy(ob)
+        self.assertEqual(policy._dispid_to_callable_, {})
+        client = win32com.client.Dispatch(win32com.server.util.wrap(ob))
+        self.assertEqual(client.Add(2, 3), "custom")
+
+if __name__=='__main__':
+    unittest.main()
@@ -27,6 +27,19 @@ class _BaseTestCase(win32com.test.util.TestCase):
             got.append(v)
         self.assertEquals(got, self.expected_data)
 
+    def test_batched(self):
+        # Batches smaller than, equal to and larger than the enumeration.
+        for size in (1, 2, len(self.expected_data), 256):
+            ob, i = self.iter_factory()
+            got = list(i.Iterate(size))
+            self.assertEquals(got, self.expected_data)
+        ob, i = self.iter_factory()
+        it = i.Iterate()
+        self.assertEquals(list(it), self.expected_data)
+        # An exhausted iterator stays exhausted.
+        self.assertEquals(list(it), [])
+        self.assertRaises(ValueError, i.Iterate, 0)
+
     def _do_test_nonenum(self, object):
         try:
             for i in object:
@@ -71,6 +71,43 @@ class ThreadInterpCase(InterpCase):
         interp = None
         return threads, events
 
+    def _testHandleInThread(self, stopEvent, handle):
+        try:
+            pythoncom.CoInitialize()
+            try:
+                interp = handle.Get()
+                # The proxy is cached for this apartment.
+                self.failUnless(handle.Get() is interp)
+                interp = win32com.client.Dispatch(interp)
+                interp.Exec("import win32api")
+                interp = None
+                handle.Forget()
+            finally:
+                pythoncom.CoUninitialize()
+        finally:
+            win32event.SetEvent(stopEvent)
+
+    def BeginThreadsInterfaceHandle(self, numThreads):
+        """Creates multiple threads sharing a single PyInterfaceHandle.
+
+        The interpreter is registered in the GIT once, rather than a
+        stream being created per thread.
+        """
+        interp = win32com.client.Dispatch("Python.Interpreter")
+        handle = pythoncom.RegisterInterfaceHandle(interp._oleobj_)
+        self.failUnlessEqual(handle.iid, pythoncom.IID_IDispatch)
+        events = []
+        threads = []
+        for i in range(numThreads):
+            hEvent = win32event.CreateEvent(None, 0, 0, None)
+            events.append(hEvent)
+            t = threading.Thread(target=self._testHandleInThread, args=(hEvent, handle))
+            t.setDaemon(1) # so errors dont cause shutdown hang
+            t.start()
+            threads.append(t)
+        interp = None
+        return threads, events
+
     #
     # NOTE - this doesnt quite work - Im not even sure it should, but Greg reckons
     # you should be able to avoid the marshal per thread!
@@ -133,6 +170,9 @@ class ThreadInterpCase(InterpCase):
     def testSimpleMarshalCoWait(self):
         self._DoTestMarshal(self.BeginThreadsSimpleMarshal, 1)
 
+    def testInterfaceHandle(self):
+        self._DoTestMarshal(self.BeginThreadsInterfaceHandle)
+
 #    def testFastMarshal(self):
 #        self._DoTestMarshal(self.BeginThreadsFastMarshal)
 
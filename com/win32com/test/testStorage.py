@@ -3,6 +3,7 @@ import pythoncom, os, win32api
 import win32com.test.util
 
 import unittest
+from pywin32_testutil import str2bytes
 
 class TestEnum(win32com.test.util.TestCase):
     def testit(self):
@@ -53,10 +54,56 @@ class TestEnum(win32com.test.util.TestCase):
                     found_summaries.append(p)
                 ps=None
         psread=None
+        # And all at once.
+        props = pssread.ReadAll()
+        self.assertEqual(props[pythoncom.FMTID_SummaryInformation][storagecon.PIDSI_AUTHOR], 'me')
+        self.assertEqual(props[pythoncom.FMTID_UserDefinedProperties][4], 'bubba')
+        ps = pssread.Open(pythoncom.FMTID_SummaryInformation)
+        self.assertEqual(ps.ReadAll()[storagecon.PIDSI_COMMENTS], 'comment')
+        # The same tuple again reuses the converted PROPSPECs.
+        ids = (storagecon.PIDSI_AUTHOR, storagecon.PIDSI_COMMENTS)
+        for i in range(3):
+            self.assertEqual(ps.ReadMultiple(ids), ('me', 'comment'))
+        self.assertEqual(ps.ReadMultiple([storagecon.PIDSI_COMMENTS]), ('comment',))
+        ps=None
+        pssread=None
         expected_summaries.sort()
         found_summaries.sort()
         self.assertEqual(expected_summaries, found_summaries)
 
+class TestWalk(win32com.test.util.TestCase):
+    def setUp(self):
+        self.fname = win32api.GetTempFileName(win32api.GetTempPath(),'stg')[0]
+        m = storagecon.STGM_READWRITE | storagecon.STGM_SHARE_EXCLUSIVE | storagecon.STGM_CREATE
+        self.stg = pythoncom.StgCreateDocfile(self.fname, m, 0)
+        stm = self.stg.CreateStream("\x05Summary", m, 0, 0)
+        stm.Write(str2bytes("x") * 100)
+        stm = None
+        sub = self.stg.CreateStorage("sub", m, 0, 0)
+        stm = sub.CreateStream("data", m, 0, 0)
+        stm.Write(str2bytes("y") * 100000)
+        stm = sub = None
+
+    def tearDown(self):
+        self.stg = None
+        os.unlink(self.fname)
+
+    def testWalk(self):
+        tree = sorted(self.stg.Walk())
+        self.assertEqual(tree, [("\x05Summary", storagecon.STGTY_STREAM, 100, None),
+                                ("sub", storagecon.STGTY_STORAGE, 0, [("data", storagecon.STGTY_STREAM, 100000, None)])])
+        self.assertEqual(sorted(self.stg.Walk(0))[1], ("sub", storagecon.STGTY_STORAGE, 0, None))
+
+    def testExtractTo(self):
+        import tempfile, shutil
+        dirname = tempfile.mkdtemp()
+        try:
+            self.assertEqual(self.stg.ExtractTo(os.path.join(dirname, "out"), 4096), (2, 2, 100100))
+            self.assertEqual(open(os.path.join(dirname, "out", "%05Summary"), "rb").read(), str2bytes("x") * 100)
+            self.assertEqual(os.path.getsize(os.path.join(dirname, "out", "sub", "data")), 100000)
+        finally:
+            shutil.rmtree(dirname)
+
 if __name__=='__main__':
     unittest.main()
    
\ No newline at end of file
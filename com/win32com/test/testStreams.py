@@ -127,5 +127,168 @@ class StreamTest(win32com.test.util.TestCase):
         self.failUnless(records[0].msg.startswith('pythoncom error'))
         self.failUnless(records[1].msg.startswith('pythoncom error'))
 
+class HGlobalStreamTest(win32com.test.util.TestCase):
+    def setUp(self):
+        self.stream = pythoncom.CreateStreamOnHGlobal()
+        self.data = str2bytes('abcdefghijklmnopqrstuvwxyz') * 100
+        self.stream.Write(memoryview(self.data))
+        self.stream.Seek(0, pythoncom.STREAM_SEEK_SET)
+
+    def testReadShort(self):
+        self.stream.Seek(-10, pythoncom.STREAM_SEEK_END)
+        self.assertEqual(self.stream.Read(100), self.data[-10:])
+
+    def testReadInto(self):
+        buf = bytearray(1000)
+        self.assertEqual(self.stream.ReadInto(buf), 1000)
+        self.assertEqual(bytes(buf), self.data[:1000])
+        self.assertEqual(self.stream.ReadInto(memoryview(buf)[:10]), 10)
+        self.assertEqual(bytes(buf[:10]), self.data[1000:1010])
+        self.assertRaises(TypeError, self.stream.ReadInto, str2bytes('read only'))
+
+    def testCopyFile(self):
+        import tempfile, os, win32file
+        fd, filename = tempfile.mkstemp()
+        os.close(fd)
+        try:
+            h = win32file.CreateFile(filename, win32file.GENERIC_READ | win32file.GENERIC_WRITE, 0, None,
+                                     win32file.CREATE_ALWAYS, 0, None)
+            try:
+                # A small buffer makes sure the loop runs more than once
+                self.assertEqual(self.stream.CopyToFile(h, None, 7), len(self.data))
+                self.stream.Seek(0, pythoncom.STREAM_SEEK_SET)
+                self.assertEqual(self.stream.CopyToFile(h, 5), 5)
+                win32file.SetFilePointer(h, 0, win32file.FILE_BEGIN)
+                other = pythoncom.CreateStreamOnHGlobal()
+                buf = bytearray(64)
+                self.assertEqual(other.CopyFromFile(h, None, 0, buf), len(self.data) + 5)
+                other.Seek(0, pythoncom.STREAM_SEEK_SET)
+                self.assertEqual(other.Read(len(self.data) + 5), self.data + self.data[:5])
+            finally:
+                h.Close()
+        finally:
+            os.unlink(filename)
+
+    def testIdentity(self):
+        old = pythoncom.EnableInterfaceIdentity()
+        try:
+            stream = pythoncom.CreateStreamOnHGlobal()
+            self.failUnless(stream.QueryInterface(pythoncom.IID_IStream) is stream)
+            # A different interface gives a different object, but still compares equal.
+            unk = stream.QueryInterface(pythoncom.IID_IUnknown)
+            self.failIf(unk is stream)
+            self.assertEqual(unk, stream)
+            del stream
+            # and the interface object goes when the last reference does
+            stream = unk.QueryInterface(pythoncom.IID_IStream)
+            stream.Write(self.data)
+        finally:
+            pythoncom.EnableInterfaceIdentity(old)
+        self.failIf(self.stream.QueryInterface(pythoncom.IID_IStream) is self.stream)
+
+class RegistrationTest(win32com.test.util.TestCase):
+    # Interfaces are registered as they are first looked up.
+    def testMaps(self):
+        self.assertEqual(pythoncom.InterfaceNames["IStream"], pythoncom.IID_IStream)
+        self.failUnless(pythoncom.IID_IStorage in pythoncom.TypeIIDs)
+        self.assertEqual(pythoncom.ServerInterfaces.get(pythoncom.IID_IStream), "IStream")
+        self.failUnless(pythoncom.IsGatewayRegistered(pythoncom.IID_IPersistStream))
+        self.assertRaises(KeyError, pythoncom.TypeIIDs.__getitem__, pythoncom.IID_NULL)
+        # Looking at all the items registers whatever is left.
+        self.failUnless(pythoncom.IID_IEnumVARIANT in list(pythoncom.TypeIIDs.keys()))
+        self.assertEqual(pythoncom.GetStartupStats()["InterfacesPending"], 0)
+
+    def testStartupStats(self):
+        stats = pythoncom.GetStartupStats()
+        for name in ("CoInitialize", "Registration", "IIDs", "Types", "Constants"):
+            self.failUnless(0 <= stats[name] <= stats["Total"], (name, stats))
+
+class BufferStreamTest(win32com.test.util.TestCase):
+    def testReadOnly(self):
+        data = str2bytes('abcdefghijklmnopqrstuvwxyz')
+        s = pythoncom.CreateStreamOnBuffer(data)
+        self.assertEqual(s.Read(5), data[:5])
+        self.assertEqual(s.Seek(-3, pythoncom.STREAM_SEEK_END), len(data) - 3)
+        self.assertEqual(s.Read(100), data[-3:])
+        self.assertEqual(s.Stat()[2], len(data))
+        self.assertRaises(pythoncom.com_error, s.Write, str2bytes('x'))
+        # A clone has its own position
+        s.Seek(0, pythoncom.STREAM_SEEK_SET)
+        c = s.Clone()
+        s.Read(10)
+        self.assertEqual(c.Read(3), data[:3])
+
+    def testWritable(self):
+        buf = bytearray(10)
+        s = pythoncom.CreateStreamOnBuffer(buf, True)
+        s.Write(str2bytes('hello'))
+        self.assertEqual(bytes(buf[:5]), str2bytes('hello'))
+        # The buffer can't grow
+        self.assertRaises(pythoncom.com_error, s.Write, str2bytes('0123456789'))
+        # and is exported while the stream exists
+        self.assertRaises(BufferError, buf.append, 0)
+        del s
+        buf.append(0)
+        self.assertRaises(TypeError, pythoncom.CreateStreamOnBuffer, str2bytes('ro'), True)
+
+    def testCopyTo(self):
+        data = str2bytes('0123456789') * 10000
+        s = pythoncom.CreateStreamOnBuffer(memoryview(data))
+        dest = pythoncom.CreateStreamOnHGlobal()
+        self.assertEqual(s.CopyTo(dest, len(data) * 2), len(data))
+        dest.Seek(0, pythoncom.STREAM_SEEK_SET)
+        self.assertEqual(dest.Read(len(data)), data)
+
+    def testFile(self):
+        import tempfile, os, win32file
+        fd, filename = tempfile.mkstemp()
+        os.write(fd, str2bytes('file contents'))
+        os.close(fd)
+        try:
+            h = win32file.CreateFile(filename, win32file.GENERIC_READ, 0, None,
+                                     win32file.OPEN_EXISTING, 0, None)
+            try:
+                s = pythoncom.CreateStreamOnBuffer(h)
+            finally:
+                h.Close()
+            # The stream has its own handle
+            self.assertEqual(s.Read(100), str2bytes('file contents'))
+            self.assertEqual(s.Stat()[2], 13)
+            del s
+        finally:
+            os.unlink(filename)
+
+class ObjectStatsTest(win32com.test.util.TestCase):
+    def _live(self, kind, iid, className):
+        return sum(v["live"] for (k, i, c, site), v in pythoncom.GetObjectStats().items()
+                   if k == kind and i == iid and c.endswith(className))
+
+    def testCounts(self):
+        old = pythoncom.EnableObjectStats(True)
+        try:
+            before = self._live("interface", pythoncom.IID_IStream, "PyIStream")
+            stream = pythoncom.CreateStreamOnHGlobal()
+            self.assertEqual(self._live("interface", pythoncom.IID_IStream, "PyIStream"), before + 1)
+            del stream
+            self.assertEqual(self._live("interface", pythoncom.IID_IStream, "PyIStream"), before)
+
+            ob = win32com.server.util.wrap(Persists(), pythoncom.IID_IPersistStreamInit)
+            self.assertEqual(self._live("gateway", pythoncom.IID_IPersistStreamInit, ".Persists"), 1)
+            del ob
+            self.assertEqual(self._live("gateway", pythoncom.IID_IPersistStreamInit, ".Persists"), 0)
+        finally:
+            pythoncom.EnableObjectStats(old)
+
+    def testSites(self):
+        old = pythoncom.EnableObjectStats(True, True)
+        try:
+            stream = pythoncom.CreateStreamOnHGlobal()
+            sites = [site for (k, i, c, site), v in pythoncom.GetObjectStats().items()
+                     if i == pythoncom.IID_IStream and v["live"]]
+            self.failUnless([site for site in sites if site and "testStreams" in site], sites)
+            del stream
+        finally:
+            pythoncom.EnableObjectStats(old)
+
 if __name__=='__main__':
     unittest.main()
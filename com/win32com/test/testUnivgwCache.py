@@ -0,0 +1,60 @@
+# Tests for the vtable cache used by the universal gateway.
+import unittest
+
+import pythoncom
+import win32com.test.util
+
+_univgw = pythoncom._univgw
+
+# Nothing should ever implement this IID.
+IID_Test = pythoncom.MakeIID("{0C3AD1B8-5C7A-4B58-9E0E-2B6F29A3C0D1}")
+
+class Definition:
+    def __init__(self, iid, nmethods):
+        self._iid = iid
+        self._nmethods = nmethods
+    def iid(self):
+        return self._iid
+    def vtbl_argsizes(self):
+        return [0] * self._nmethods
+    def vtbl_argcounts(self):
+        return [0] * self._nmethods
+    def dispatch(self, ob, index, argPtr):
+        return 0
+
+class TestCase(win32com.test.util.TestCase):
+    def setUp(self):
+        _univgw.ClearVTableCache()
+
+    def tearDown(self):
+        _univgw.ClearVTableCache()
+
+    def testShared(self):
+        self.assertEqual(_univgw.GetVTableCacheSize(), 0)
+        self.assertEqual(_univgw.GetCachedVTable(IID_Test), None)
+        v1 = _univgw.CreateVTable(Definition(IID_Test, 2))
+        self.assertEqual(_univgw.GetVTableCacheSize(), 1)
+        v2 = _univgw.CreateVTable(Definition(IID_Test, 2))
+        self.assertTrue(v1 is v2)
+        self.assertTrue(_univgw.GetCachedVTable(IID_Test) is v1)
+
+    def testDispatchDiffers(self):
+        v1 = _univgw.CreateVTable(Definition(IID_Test, 2))
+        self.assertEqual(_univgw.GetCachedVTable(IID_Test, 1), None)
+        v2 = _univgw.CreateVTable(Definition(IID_Test, 2), 1)
+        self.assertTrue(v1 is not v2)
+        self.assertTrue(_univgw.GetCachedVTable(IID_Test, 1) is v2)
+
+    def testClear(self):
+        v1 = _univgw.CreateVTable(Definition(IID_Test, 1))
+        _univgw.ClearVTableCache()
+        self.assertEqual(_univgw.GetVTableCacheSize(), 0)
+        # The vtable we hold is still usable, but no longer shared.
+        v2 = _univgw.CreateVTable(Definition(IID_Test, 1))
+        self.assertTrue(v1 is not v2)
+
+    def testUnknownNotAllowed(self):
+        self.assertRaises(ValueError, _univgw.CreateVTable, Definition(pythoncom.IID_IUnknown, 0))
+
+if __name__=='__main__':
+    unittest.main()
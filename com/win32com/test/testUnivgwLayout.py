@@ -0,0 +1,65 @@
+# Tests for the argument layouts compiled by the universal gateway.
+import ctypes
+import struct
+import unittest
+
+import pythoncom
+import win32com.test.util
+
+_univgw = pythoncom._univgw
+
+# The offsets are multiples of 8 so they suit both 32 and 64 bit stacks.
+IN_ARGS = ((pythoncom.VT_I4, 0, 4), (pythoncom.VT_R8, 8, 8), (pythoncom.VT_BOOL, 16, 2))
+OUT_ARGS = ((pythoncom.VT_I4 | pythoncom.VT_BYREF, 0, 8, None),
+            (pythoncom.VT_R8 | pythoncom.VT_BYREF, 8, 8, None))
+
+class TestCase(win32com.test.util.TestCase):
+    def _make_in_buffer(self):
+        buf = ctypes.create_string_buffer(24)
+        struct.pack_into("i", buf, 0, 42)
+        struct.pack_into("d", buf, 8, 1.5)
+        struct.pack_into("h", buf, 16, -1)
+        return buf
+
+    def testInLayout(self):
+        layout = _univgw.CompileArgLayout(IN_ARGS)
+        self.assertEqual(_univgw.GetArgLayoutSize(layout), 3)
+        buf = self._make_in_buffer()
+        expected = (42, 1.5, True)
+        self.assertEqual(_univgw.ReadFromInTuple(IN_ARGS, ctypes.addressof(buf)), expected)
+        self.assertEqual(_univgw.ReadFromInTuple(layout, ctypes.addressof(buf)), expected)
+        # The layout is reusable.
+        struct.pack_into("i", buf, 0, 7)
+        self.assertEqual(_univgw.ReadFromInTuple(layout, ctypes.addressof(buf))[0], 7)
+
+    def testOutLayout(self):
+        layout = _univgw.CompileArgLayout(OUT_ARGS, False)
+        self.assertEqual(_univgw.GetArgLayoutSize(layout), 2)
+        i = ctypes.c_int(0)
+        d = ctypes.c_double(0)
+        ptrs = (ctypes.c_void_p * 2)(ctypes.addressof(i), ctypes.addressof(d))
+        _univgw.WriteFromOutTuple((7, 2.5), layout, ctypes.addressof(ptrs))
+        self.assertEqual((i.value, d.value), (7, 2.5))
+        _univgw.WriteFromOutTuple((8, 3.5), OUT_ARGS, ctypes.addressof(ptrs))
+        self.assertEqual((i.value, d.value), (8, 3.5))
+
+    def testWrongDirection(self):
+        in_layout = _univgw.CompileArgLayout(IN_ARGS)
+        out_layout = _univgw.CompileArgLayout(OUT_ARGS, False)
+        buf = self._make_in_buffer()
+        self.assertRaises(TypeError, _univgw.ReadFromInTuple, out_layout, ctypes.addressof(buf))
+        self.assertRaises(TypeError, _univgw.WriteFromOutTuple, (1, 2.0), in_layout, ctypes.addressof(buf))
+
+    def testBadDescriptions(self):
+        self.assertRaises(TypeError, _univgw.CompileArgLayout, [])
+        self.assertRaises(TypeError, _univgw.CompileArgLayout, ((pythoncom.VT_I4, 0),))
+        self.assertRaises(TypeError, _univgw.GetArgLayoutSize, IN_ARGS)
+
+    def testUnsupportedTypeIsDeferred(self):
+        # Compiling succeeds, so a method that is never called doesn't matter.
+        layout = _univgw.CompileArgLayout(((pythoncom.VT_USERDEFINED, 0, 8),))
+        buf = self._make_in_buffer()
+        self.assertRaises(TypeError, _univgw.ReadFromInTuple, layout, ctypes.addressof(buf))
+
+if __name__=='__main__':
+    unittest.main()
@@ -0,0 +1,151 @@
+# Tests for the conversion of simple Python objects to and from VARIANTs.
+# Most of these values take the "fast path" in PyCom_VariantFromPyObject, so
+# we check they survive a trip through a COM server unchanged, and that the
+# values on the edges of the fast path get the same types as before.
+import unittest
+import array
+import decimal
+import enum
+from datetime import datetime
+
+import pythoncom
+import pywintypes
+import win32com.client
+import win32com.test.util
+import win32com.server.util
+
+class Tester:
+    _public_methods_ = [ 'Echo' ]
+    def Echo(self, v):
+        return v
+
+def test_ob():
+    return win32com.client.Dispatch(win32com.server.util.wrap(Tester()))
+
+class IntSubclass(enum.IntEnum):
+    one = 1
+
+class TestCase(win32com.test.util.TestCase):
+    def check(self, value, expected=None):
+        if expected is None:
+            expected = value
+        got = test_ob().Echo(value)
+        self.assertEqual(got, expected)
+        self.assertEqual(type(got), type(expected))
+
+    def testInts(self):
+        for v in (0, 1, -1, 2**31-1, -2**31, 2**31, 2**32-1, 2**40, -2**40):
+            self.check(v)
+
+    def testBigInt(self):
+        # too big for 64 bits - comes back as a float.
+        self.check(2**70, float(2**70))
+
+    def testFloat(self):
+        self.check(0.0)
+        self.check(-1.5)
+        self.check(1e300)
+
+    def testString(self):
+        self.check("")
+        self.check("hello")
+        self.check("embedded\0null")
+
+    def testBool(self):
+        self.check(True)
+        self.check(False)
+
+    def testNone(self):
+        self.check(None)
+
+    def testDate(self):
+        d = pywintypes.Time(datetime(2000, 1, 2, 3, 4, 5))
+        self.assertEqual(test_ob().Echo(d), d)
+
+    def testSubclass(self):
+        # Not an exact type, so takes the generic path.
+        self.check(IntSubclass.one, 1)
+
+    def testBufferToArray(self):
+        # typed buffers are copied straight into a SAFEARRAY of that type.
+        self.check(array.array('d', [1.0, 2.5, 3.0]), (1.0, 2.5, 3.0))
+        self.check(array.array('i', [1, -2, 3]), (1, -2, 3))
+        # A multi-dimensional (C ordered) buffer.
+        mv = memoryview(array.array('i', range(6))).cast('B').cast('i', (2, 3))
+        self.check(mv, ((0, 1, 2), (3, 4, 5)))
+
+    def testVariantArrays(self):
+        self.check([1, 2.0, "three", None, True], (1, 2.0, "three", None, True))
+        # 2 dimensional arrays are decoded a column at a time - check both the
+        # homogeneous and mixed column cases, and that we get the orientation right.
+        rows = [[1.0, "a", None, 1], [2.0, "b", None, "mixed"], [3.0, "c", None, 3.5]]
+        self.check(rows, tuple(tuple(row) for row in rows))
+        self.check([[], []], ((), ()))
+        cube = [[[1, 2], [3, 4]], [[5, 6], [7, 8]]]
+        self.check(cube, (((1, 2), (3, 4)), ((5, 6), (7, 8))))
+
+    def testArrayToBuffer(self):
+        old = pythoncom.EnableSafeArrayBuffers(True)
+        try:
+            got = test_ob().Echo(array.array('d', [1.0, 2.5, 3.0]))
+            self.assertTrue(isinstance(got, memoryview))
+            self.assertEqual(got.format, 'd')
+            self.assertEqual(got.tolist(), [1.0, 2.5, 3.0])
+            mv = memoryview(array.array('i', range(6))).cast('B').cast('i', (2, 3))
+            got = test_ob().Echo(mv)
+            self.assertEqual(got.shape, (2, 3))
+            self.assertEqual(got.tolist(), [[0, 1, 2], [3, 4, 5]])
+            # VARIANT arrays are unchanged.
+            self.check([1, "two"], (1, "two"))
+        finally:
+            pythoncom.EnableSafeArrayBuffers(old)
+        self.assertEqual(pythoncom.EnableSafeArrayBuffers(old), old)
+
+    def testBstrBuffers(self):
+        old = pythoncom.EnableBstrBuffers(10)
+        try:
+            value = "x" * 20 + "\u20ac\0end"
+            got = test_ob().Echo(value)
+            self.assertTrue(isinstance(got, pywintypes.BSTRBufferType))
+            self.assertEqual(len(got), len(value))
+            self.assertEqual(str(got), value)
+            self.assertEqual(got, value)
+            self.assertEqual(hash(got), hash(value))
+            self.assertEqual(bytes(memoryview(got)), value.encode("utf-16-le"))
+            # and it can be passed back to COM as it is.
+            self.assertEqual(test_ob().Echo(got), got)
+            # short strings are unchanged.
+            self.check("short")
+        finally:
+            pythoncom.EnableBstrBuffers(old)
+        self.assertEqual(pythoncom.EnableBstrBuffers(old), old)
+
+    def testCurrency(self):
+        D = decimal.Decimal
+        for text in ("1234.5678", "-0.5", "12", "0.0001", "-922337203685477.5808"):
+            got = test_ob().Echo(D(text))
+            self.assertEqual(got, D(text))
+            # The same digits as Decimal(int64) / 10000 gives.
+            self.assertEqual(str(got), str(D(int(D(text) * 10000)) / 10000))
+        # Extra digits are truncated, as before.
+        self.assertEqual(test_ob().Echo(D("1.23456")), D("1.2345"))
+        self.assertEqual(test_ob().Echo(D("-1.23456")), D("-1.2345"))
+        self.assertEqual(test_ob().Echo(D("1E+3")), 1000)
+        self.assertRaises(OverflowError, test_ob().Echo, D("1E+20"))
+
+    def testScaledCurrency(self):
+        old = pythoncom.SetNumericConversion(pythoncom.CY_AS_SCALED_INT)
+        try:
+            self.assertEqual(test_ob().Echo(decimal.Decimal("1.5")), 15000)
+        finally:
+            pythoncom.SetNumericConversion(old)
+        self.assertEqual(pythoncom.SetNumericConversion(old), old)
+
+    def testTimeVariantConversion(self):
+        values = [1, 1.0, "a", True, None]
+        self.assertTrue(pythoncom._TimeVariantConversion(values, 10) >= 0)
+        self.assertTrue(pythoncom._TimeVariantConversion(values, 10, False) >= 0)
+        self.assertRaises(TypeError, pythoncom._TimeVariantConversion, [object()], 1)
+
+if __name__=='__main__':
+    unittest.main()
@@ -90,7 +90,8 @@ unittest_modules = [
           testAXScript testxslt testDictionary testCollections
           testServers errorSemantics.test testvb testArrays
           testClipboard testMarshal
-          testConversionErrors
+          testConversionErrors testVariantConversion testGatewayNames
+          testUnivgwCache testUnivgwLayout
         """.split(),
         # Level 2 tests.
         """testMSOffice.TestAll testMSOfficeEvents.test testAccess.test
@@ -388,6 +388,16 @@ def TestStructs(vbtest):
     s.int_val = -1
     vbtest.SetStructSub(s)
     assert vbtest.GetStructFunc().int_val == -1, "new struct didnt make the round trip!"
+    # Simple fields are read and written directly in the record buffer -
+    # values must still be coerced to the type of the field.
+    s.int_val = 3.0
+    assert s.int_val == 3 and type(s.int_val) == int, s.int_val
+    try:
+        s.int_val = "not a number"
+        raise RuntimeError("Could set an int field to a string")
+    except pythoncom.com_error:
+        pass
+    assert s.int_val == 3, s.int_val
     # Finally, test stand-alone structure arrays.
     s_array = vbtest.StructArrayProperty
     assert s_array is None, "Expected None from the uninitialized VB array"
@@ -400,6 +410,23 @@ def TestStructs(vbtest):
         assert s_array[i].sub_val.array_val[0].int_val == i
         assert s_array[i].sub_val.array_val[1].int_val == i+1
         assert s_array[i].sub_val.array_val[2].int_val == i+2
+    # And again, as lazy record arrays.
+    old_setting = pythoncom.EnableRecordArrays(True)
+    try:
+        s_array = vbtest.StructArrayProperty
+        assert type(s_array) != tuple, s_array
+        assert len(s_array)==3
+        assert s_array.GetField("int_val") == (0, 1, 2), s_array.GetField("int_val")
+        assert [r.sub_val.int_val for r in s_array] == [0, 1, 2]
+        assert s_array[-1].int_val == 2
+        sub_array = s_array[1].sub_val.array_val
+        assert type(sub_array) != tuple, sub_array
+        assert sub_array.GetField("int_val")[:3] == (1, 2, 3)
+        # elements share the memory of the array.
+        s_array[0].int_val = 10
+        assert s_array[0].int_val == 10
+    finally:
+        pythoncom.EnableRecordArrays(old_setting)
 
     # Some error type checks.
     try:
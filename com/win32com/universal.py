@@ -8,7 +8,23 @@ from win32com.client import gencache
 com_error = pythoncom.com_error
 _univgw = pythoncom._univgw
 
+# (typelibGUID, lcid, major, minor, interface_names) -> RegisterInterfaces result.
+# As the layout of an interface can never change, policies wrapping many
+# objects with the same interfaces only need to do the work once.
+_registered_interfaces = {}
+
 def RegisterInterfaces(typelibGUID, lcid, major, minor, interface_names = None):
+    key = (str(typelibGUID), lcid, major, minor,
+           None if interface_names is None else tuple(interface_names))
+    try:
+        return list(_registered_interfaces[key])
+    except KeyError:
+        pass
+    ret = _RegisterInterfaces(typelibGUID, lcid, major, minor, interface_names)
+    _registered_interfaces[key] = tuple(ret)
+    return ret
+
+def _RegisterInterfaces(typelibGUID, lcid, major, minor, interface_names):
     ret = [] # return a list of (dispid, funcname for our policy's benefit
     # First see if we have makepy support.  If so, we can probably satisfy the request without loading the typelib.
     try:
@@ -72,8 +88,11 @@ def RegisterInterfaces(typelibGUID, lcid, major, minor, interface_names = None):
     return ret
 
 def _doCreateVTable(iid, interface_name, is_dispatch, method_defs):
-    defn = Definition(iid, is_dispatch, method_defs)
-    vtbl = _univgw.CreateVTable(defn, is_dispatch)
+    # Vtables are cached by IID, so only build a Definition the first time.
+    vtbl = _univgw.GetCachedVTable(iid, is_dispatch)
+    if vtbl is None:
+        defn = Definition(iid, is_dispatch, method_defs)
+        vtbl = _univgw.CreateVTable(defn, is_dispatch)
     _univgw.RegisterVTable(vtbl, iid, interface_name)
 
 def _CalcTypeSize(typeTuple):
@@ -130,6 +149,9 @@ class Method:
         self.cbArgs = cbArgs
         self._gw_in_args = self._GenerateInArgTuple()
         self._gw_out_args = self._GenerateOutArgTuple()
+        # Compiled once here so each call doesn't have to re-read the tuples.
+        self._gw_in_layout = _univgw.CompileArgLayout(self._gw_in_args, True)
+        self._gw_out_layout = _univgw.CompileArgLayout(self._gw_out_args, False)
 
     def _GenerateInArgTuple(self):
         # Given a method, generate the in argument tuple
@@ -171,7 +193,7 @@ class Definition:
         meth = self._methods[index]
         # Infer S_OK if they don't return anything bizarre.
         hr = 0 
-        args = ReadFromInTuple(meth._gw_in_args, argPtr)
+        args = ReadFromInTuple(meth._gw_in_layout, argPtr)
         # If ob is a dispatcher, ensure a policy
         ob = getattr(ob, "policy", ob)
         # Ensure the correct dispid is setup
@@ -192,5 +214,5 @@ class Definition:
             retVal = [retVal]
             retVal.extend([None] * (len(meth._gw_out_args)-1))
             retVal = tuple(retVal)
-        WriteFromOutTuple(retVal, meth._gw_out_args, argPtr)
+        WriteFromOutTuple(retVal, meth._gw_out_layout, argPtr)
         return hr
@@ -158,6 +158,45 @@ PyObject *PyADSIObject_FromADSVALUE(ADSVALUE &v)
     return ret;
 }
 
+// Converters used for bulk results, picked once per column from the ADSTYPE
+// of its values, and returning just the value.
+static PyObject *ConvertADSString(ADSVALUE &v) { return PyWinObject_FromWCHAR(v.CaseIgnoreString); }
+static PyObject *ConvertADSBoolean(ADSVALUE &v) { return PyBool_FromLong(v.Boolean); }
+static PyObject *ConvertADSInteger(ADSVALUE &v) { return PyInt_FromLong(v.Integer); }
+static PyObject *ConvertADSLargeInteger(ADSVALUE &v) { return PyWinObject_FromLARGE_INTEGER(v.LargeInteger); }
+
+PyObject *PyADSI_ConvertADSGeneric(ADSVALUE &v)
+{
+    PyObject *obTyped = PyADSIObject_FromADSVALUE(v);
+    if (obTyped == NULL)
+        return NULL;
+    PyObject *ret = PyTuple_GET_ITEM(obTyped, 0);
+    Py_INCREF(ret);
+    Py_DECREF(obTyped);
+    return ret;
+}
+
+PFNADSVALUECONVERTER PyADSI_GetADSValueConverter(ADSTYPE t)
+{
+    switch (t) {
+        // All string types are the same member of the union
+        case ADSTYPE_DN_STRING:
+        case ADSTYPE_CASE_EXACT_STRING:
+        case ADSTYPE_CASE_IGNORE_STRING:
+        case ADSTYPE_PRINTABLE_STRING:
+        case ADSTYPE_NUMERIC_STRING:
+        case ADSTYPE_OBJECT_CLASS:
+            return ConvertADSString;
+        case ADSTYPE_BOOLEAN:
+            return ConvertADSBoolean;
+        case ADSTYPE_INTEGER:
+            return ConvertADSInteger;
+        case ADSTYPE_LARGE_INTEGER:
+            return ConvertADSLargeInteger;
+    }
+    return PyADSI_ConvertADSGeneric;
+}
+
 BOOL PyADSIObject_AsTypedValue(PyObject *val, ADSVALUE &v)
 {
     BOOL ok = TRUE;
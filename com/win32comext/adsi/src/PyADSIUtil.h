@@ -16,3 +16,10 @@ BOOL PyADSIObject_AsADS_SEARCHPREF_INFOs(PyObject *ob, ADS_SEARCHPREF_INFO **ppr
 void PyADSIObject_FreeADS_SEARCHPREF_INFOs(ADS_SEARCHPREF_INFO *pattr, DWORD cattr);
 
 PyObject *PyADSIObject_FromADSVALUE(ADSVALUE &v);
+
+// Value converters for bulk results, which return just the value of an
+// ADSVALUE.  The converter for a type can be looked up once and reused for
+// every value of a column.
+typedef PyObject *(*PFNADSVALUECONVERTER)(ADSVALUE &v);
+PFNADSVALUECONVERTER PyADSI_GetADSValueConverter(ADSTYPE t);
+PyObject *PyADSI_ConvertADSGeneric(ADSVALUE &v);
@@ -310,3 +310,314 @@ PyObject *PyIDirectorySearch::GetNextColumnName(PyObject *self, PyObject *args)
 }
 %}
 %native(GetNextColumnName) GetNextColumnName;
+
+%{
+// @object PyADSSearchIter|An iterator over the rows of a search, as returned by <om PyIDirectorySearch.Search>
+// @comm Each row is a tuple with an item per requested column, in the order the columns were
+// requested.  Each item is None if the object has no value for the column, or a tuple of values.
+// Rows are read in batches, with all columns of every row in the batch fetched without the
+// Python lock.  The search handle is closed when the iterator is exhausted or destroyed.
+class PyADSSearchIter : public PyObject {
+   public:
+	PyADSSearchIter(IDirectorySearch *pSearch, ADS_SEARCH_HANDLE handle, WCHAR **names, DWORD cnames, DWORD batch);
+	~PyADSSearchIter();
+	static void deallocFunc(PyObject *ob);
+	static PyObject *iter(PyObject *self);
+	static PyObject *iternext(PyObject *self);
+	HRESULT FetchBatch(DWORD *prows);
+	PyObject *ConvertBatch(DWORD rows);
+	void FreeBatch(DWORD rows);
+	void Close();
+
+	IDirectorySearch *m_pSearch;
+	ADS_SEARCH_HANDLE m_handle;
+	WCHAR **m_names;
+	DWORD m_cnames, m_batch;
+	ADS_SEARCH_COLUMN *m_cols;  // m_batch rows of m_cnames columns
+	BOOL *m_colset;
+	PFNADSVALUECONVERTER *m_converters;  // NULL until a column's type is first seen
+	ADSTYPE *m_coltypes;
+	BOOL m_done;
+	PyObject *m_pending;
+	Py_ssize_t m_pending_pos;
+};
+
+PyTypeObject PyADSSearchIterType = {
+	PYWIN_OBJECT_HEAD "PyADSSearchIter",
+	sizeof(PyADSSearchIter),
+	0,
+	PyADSSearchIter::deallocFunc, /* tp_dealloc */
+	0,                            /* tp_print */
+	0,                            /* tp_getattr */
+	0,                            /* tp_setattr */
+	0,                            /* tp_compare */
+	0,                            /* tp_repr */
+	0,                            /* tp_as_number */
+	0,                            /* tp_as_sequence */
+	0,                            /* tp_as_mapping */
+	0,                            /* tp_hash */
+	0,                            /* tp_call */
+	0,                            /* tp_str */
+	PyObject_GenericGetAttr,      /* tp_getattro */
+	0,                            /* tp_setattro */
+	0,                            /* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,           /* tp_flags */
+	0,                            /* tp_doc */
+	0,                            /* tp_traverse */
+	0,                            /* tp_clear */
+	0,                            /* tp_richcompare */
+	0,                            /* tp_weaklistoffset */
+	PyADSSearchIter::iter,        /* tp_iter */
+	PyADSSearchIter::iternext,    /* tp_iternext */
+};
+
+PyADSSearchIter::PyADSSearchIter(IDirectorySearch *pSearch, ADS_SEARCH_HANDLE handle, WCHAR **names, DWORD cnames,
+								 DWORD batch)
+{
+	ob_type = &PyADSSearchIterType;
+	_Py_NewReference(this);
+	pSearch->AddRef();
+	m_pSearch = pSearch;
+	m_handle = handle;
+	m_names = names;
+	m_cnames = cnames;
+	m_batch = batch;
+	m_cols = (ADS_SEARCH_COLUMN *)calloc(cnames * batch + 1, sizeof(ADS_SEARCH_COLUMN));
+	m_colset = (BOOL *)calloc(cnames * batch + 1, sizeof(BOOL));
+	m_converters = (PFNADSVALUECONVERTER *)calloc(cnames + 1, sizeof(PFNADSVALUECONVERTER));
+	m_coltypes = (ADSTYPE *)calloc(cnames + 1, sizeof(ADSTYPE));
+	m_done = FALSE;
+	m_pending = NULL;
+	m_pending_pos = 0;
+}
+
+PyADSSearchIter::~PyADSSearchIter()
+{
+	Close();
+	PyADSI_FreeNames(m_names, m_cnames);
+	free(m_cols);
+	free(m_colset);
+	free(m_converters);
+	free(m_coltypes);
+	Py_XDECREF(m_pending);
+	m_pSearch->Release();
+}
+
+void PyADSSearchIter::Close()
+{
+	if (m_handle) {
+		Py_BEGIN_ALLOW_THREADS
+		m_pSearch->CloseSearchHandle(m_handle);
+		Py_END_ALLOW_THREADS
+		m_handle = NULL;
+	}
+	m_done = TRUE;
+}
+
+/*static*/ void PyADSSearchIter::deallocFunc(PyObject *ob) { delete (PyADSSearchIter *)ob; }
+
+/*static*/ PyObject *PyADSSearchIter::iter(PyObject *self)
+{
+	Py_INCREF(self);
+	return self;
+}
+
+// Reads up to m_batch rows, with all their columns.  Called without the Python lock.
+HRESULT PyADSSearchIter::FetchBatch(DWORD *prows)
+{
+	HRESULT hr = S_OK;
+	DWORD rows = 0;
+	while (rows < m_batch) {
+		hr = m_pSearch->GetNextRow(m_handle);
+		if (hr == S_ADS_NOMORE_ROWS) {
+			// With paged searches, this can mean the next page isn't here yet
+			DWORD err = 0;
+			WCHAR errbuf[1], namebuf[1];
+			ADsGetLastError(&err, errbuf, 0, namebuf, 0);
+			if (err == ERROR_MORE_DATA)
+				continue;
+			break;
+		}
+		if (FAILED(hr))
+			break;
+		ADS_SEARCH_COLUMN *cols = m_cols + rows * m_cnames;
+		BOOL *colset = m_colset + rows * m_cnames;
+		for (DWORD c = 0; c < m_cnames; c++) {
+			HRESULT hrcol = m_pSearch->GetColumn(m_handle, m_names[c], cols + c);
+			colset[c] = SUCCEEDED(hrcol);
+			if (FAILED(hrcol) && hrcol != E_ADS_COLUMN_NOT_SET) {
+				hr = hrcol;
+				// Free what was got for this row
+				for (DWORD j = 0; j < c; j++)
+					if (colset[j])
+						m_pSearch->FreeColumn(cols + j);
+				break;
+			}
+		}
+		if (FAILED(hr))
+			break;
+		rows++;
+	}
+	*prows = rows;
+	return FAILED(hr) ? hr : S_OK;
+}
+
+void PyADSSearchIter::FreeBatch(DWORD rows)
+{
+	for (DWORD i = 0; i < rows * m_cnames; i++)
+		if (m_colset[i]) {
+			m_pSearch->FreeColumn(m_cols + i);
+			m_colset[i] = FALSE;
+		}
+}
+
+PyObject *PyADSSearchIter::ConvertBatch(DWORD rows)
+{
+	PyObject *ret = PyTuple_New(rows);
+	if (ret == NULL)
+		return NULL;
+	for (DWORD r = 0; r < rows; r++) {
+		PyObject *obRow = PyTuple_New(m_cnames);
+		if (obRow == NULL) {
+			Py_DECREF(ret);
+			return NULL;
+		}
+		PyTuple_SET_ITEM(ret, r, obRow);
+		for (DWORD c = 0; c < m_cnames; c++) {
+			ADS_SEARCH_COLUMN *col = m_cols + r * m_cnames + c;
+			PyObject *obValues;
+			if (!m_colset[r * m_cnames + c] || col->dwNumValues == 0) {
+				Py_INCREF(Py_None);
+				obValues = Py_None;
+			}
+			else {
+				if (m_converters[c] == NULL || m_coltypes[c] != col->dwADsType) {
+					m_converters[c] = PyADSI_GetADSValueConverter(col->dwADsType);
+					m_coltypes[c] = col->dwADsType;
+				}
+				obValues = PyTuple_New(col->dwNumValues);
+				for (DWORD i = 0; obValues && i < col->dwNumValues; i++) {
+					// Values can in theory have a different type to the column
+					PyObject *val = col->pADsValues[i].dwType == m_coltypes[c]
+										? (*m_converters[c])(col->pADsValues[i])
+										: PyADSI_ConvertADSGeneric(col->pADsValues[i]);
+					if (val == NULL)
+						Py_CLEAR(obValues);
+					else
+						PyTuple_SET_ITEM(obValues, i, val);
+				}
+			}
+			if (obValues == NULL) {
+				Py_DECREF(ret);
+				return NULL;
+			}
+			PyTuple_SET_ITEM(obRow, c, obValues);
+		}
+	}
+	return ret;
+}
+
+/*static*/ PyObject *PyADSSearchIter::iternext(PyObject *self)
+{
+	PyADSSearchIter *This = (PyADSSearchIter *)self;
+	for (;;) {
+		if (This->m_pending) {
+			if (This->m_pending_pos < PyTuple_GET_SIZE(This->m_pending)) {
+				PyObject *ret = PyTuple_GET_ITEM(This->m_pending, This->m_pending_pos++);
+				Py_INCREF(ret);
+				return ret;
+			}
+			Py_CLEAR(This->m_pending);
+		}
+		if (This->m_done)
+			return NULL;
+		if (This->m_cols == NULL || This->m_colset == NULL || This->m_converters == NULL || This->m_coltypes == NULL)
+			return PyErr_NoMemory();
+		DWORD rows;
+		HRESULT hr;
+		Py_BEGIN_ALLOW_THREADS
+		hr = This->FetchBatch(&rows);
+		Py_END_ALLOW_THREADS
+		PyObject *ob = This->ConvertBatch(rows);
+		This->FreeBatch(rows);
+		if (ob == NULL)
+			return NULL;
+		if (FAILED(hr)) {
+			Py_DECREF(ob);
+			This->Close();
+			return OleSetADSIError(hr, This->m_pSearch, IID_IDirectorySearch);
+		}
+		if (rows < This->m_batch)
+			This->Close();
+		This->m_pending = ob;
+		This->m_pending_pos = 0;
+	}
+}
+%}
+
+%{
+// @pyswig <o PyADSSearchIter>|Search|Executes a search, returning an iterator over the rows with the requested columns.
+// @comm This sets the page size and search scope preferences, executes the search and iterates over the
+// results, much faster than calling <om PyIDirectorySearch.GetNextRow> and <om PyIDirectorySearch.GetColumn>
+// for every row and column.  Other preferences can be set first with <om PyIDirectorySearch.SetSearchPreference>.
+// @comm Caching of results is turned off, since rows are only read once.
+PyObject *PyIDirectorySearch::Search(PyObject *self, PyObject *args)
+{
+	PyObject *obNames, *obFilter;
+	DWORD pageSize = 1000, batchSize = 100;
+	int scope = ADS_SCOPE_SUBTREE;
+	IDirectorySearch *_swig_self;
+	if ((_swig_self=GetI(self))==NULL) return NULL;
+	// @pyparm <o PyUnicode>|filter||The search filter
+	// @pyparm [<o PyUnicode>, ...]|attrNames||The columns to return, in order
+	// @pyparm int|pageSize|1000|Page size given to the server.  0 requests a non-paged search.
+	// @pyparm int|searchScope|ADS_SCOPE_SUBTREE|One of the ADS_SCOPE_* values
+	// @pyparm int|batchSize|100|Number of rows read each time the Python lock is released
+	if (!PyArg_ParseTuple(args, "OO|kik:Search", &obFilter, &obNames, &pageSize, &scope, &batchSize))
+		return NULL;
+	if (batchSize == 0) {
+		PyErr_SetString(PyExc_ValueError, "batchSize must be greater than zero");
+		return NULL;
+	}
+	if (PyType_Ready(&PyADSSearchIterType) == -1)
+		return NULL;
+	WCHAR *szFilter = NULL;
+	if (!PyWinObject_AsWCHAR(obFilter, &szFilter, FALSE))
+		return NULL;
+	WCHAR **names = NULL;
+	DWORD cnames = 0;
+	if (!PyADSI_MakeNames(obNames, &names, &cnames)) {
+		PyWinObject_FreeWCHAR(szFilter);
+		return NULL;
+	}
+
+	ADS_SEARCHPREF_INFO prefs[3];
+	DWORD cprefs = 0;
+	prefs[cprefs].dwSearchPref = ADS_SEARCHPREF_SEARCH_SCOPE;
+	prefs[cprefs].vValue.dwType = ADSTYPE_INTEGER;
+	prefs[cprefs++].vValue.Integer = scope;
+	prefs[cprefs].dwSearchPref = ADS_SEARCHPREF_CACHE_RESULTS;
+	prefs[cprefs].vValue.dwType = ADSTYPE_BOOLEAN;
+	prefs[cprefs++].vValue.Boolean = FALSE;
+	if (pageSize) {
+		prefs[cprefs].dwSearchPref = ADS_SEARCHPREF_PAGESIZE;
+		prefs[cprefs].vValue.dwType = ADSTYPE_INTEGER;
+		prefs[cprefs++].vValue.Integer = pageSize;
+	}
+	HRESULT _result;
+	ADS_SEARCH_HANDLE handle = NULL;
+	Py_BEGIN_ALLOW_THREADS
+	_result = _swig_self->SetSearchPreference(prefs, cprefs);
+	if (SUCCEEDED(_result))
+		_result = _swig_self->ExecuteSearch(szFilter, names, cnames, &handle);
+	Py_END_ALLOW_THREADS
+	PyWinObject_FreeWCHAR(szFilter);
+	if (FAILED(_result)) {
+		PyADSI_FreeNames(names, cnames);
+		return OleSetADSIError(_result, _swig_self, SWIG_THIS_IID);
+	}
+	// The iterator owns the names and the handle
+	return new PyADSSearchIter(_swig_self, handle, names, cnames, batchSize);
+}
+%}
+%native(Search) Search;
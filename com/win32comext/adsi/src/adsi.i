@@ -250,6 +250,208 @@ static PyObject *PyADsGetLastError(PyObject *self, PyObject *args)
 %}
 %native (ADsGetLastError) PyADsGetLastError;
 
+%{
+// Work shared by the threads of ADsGetObjectAttributes
+struct ADS_ATTR_FETCH {
+	WCHAR *path;
+	HRESULT hr;
+	ADS_ATTR_INFO *attrs;
+	DWORD cattrs;
+};
+
+struct ADS_ATTR_FETCH_WORK {
+	ADS_ATTR_FETCH *items;
+	LONG cnt;
+	LONG next;
+	WCHAR *userName, *password;
+	DWORD flags;
+	WCHAR **names;
+	DWORD cnames;
+};
+
+// Binds and reads objects until the work runs out, called without the GIL
+static DWORD WINAPI ADsAttrFetchThread(LPVOID arg)
+{
+	ADS_ATTR_FETCH_WORK *work = (ADS_ATTR_FETCH_WORK *)arg;
+	HRESULT hrinit = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+	// The first object bound is kept until the thread is done, so ADSI keeps
+	// its connection for these credentials open for all the later binds.
+	IDirectoryObject *pKeep = NULL;
+	LONG ind;
+	while ((ind = InterlockedIncrement(&work->next) - 1) < work->cnt) {
+		ADS_ATTR_FETCH *item = work->items + ind;
+		if (FAILED(hrinit) && hrinit != RPC_E_CHANGED_MODE) {
+			item->hr = hrinit;
+			continue;
+		}
+		IDirectoryObject *pDO = NULL;
+		item->hr = ADsOpenObject(item->path, work->userName, work->password, work->flags, IID_IDirectoryObject,
+								 (void **)&pDO);
+		if (FAILED(item->hr))
+			continue;
+		item->hr = pDO->GetObjectAttributes(work->names, work->cnames, &item->attrs, &item->cattrs);
+		if (pKeep == NULL)
+			pKeep = pDO;
+		else
+			pDO->Release();
+	}
+	if (pKeep)
+		pKeep->Release();
+	if (SUCCEEDED(hrinit))
+		CoUninitialize();
+	return 0;
+}
+
+// @pyswig (tuple, tuple)|ADsGetObjectAttributes|Binds to many objects with the same credentials and reads
+// the same attributes of each.
+// @rdesc Returns (errors, rows), each with one item per path.  errors holds the HRESULT of binding to and
+// reading that object, and the matching row is None if it is a failure.  Otherwise the row is a tuple with
+// an item per attribute name, in the order requested; each item is None if the object has no value for the
+// attribute, or a tuple of values, as in the rows of <om PyIDirectorySearch.Search>.
+// @comm All the objects are bound and read with the Python lock released, by up to maxThreads threads, and
+// each thread keeps its first object bound so the connection is reused for the others.  This is much
+// faster than calling <om adsi.ADsOpenObject> and <om PyIDirectoryObject.GetObjectAttributes> for each object.
+static PyObject *PyADsGetObjectAttributes(PyObject *self, PyObject *args)
+{
+	PyObject *obPaths, *obNames, *obUserName = Py_None, *obPassword = Py_None;
+	DWORD flags = ADS_SECURE_AUTHENTICATION, maxThreads = 8;
+	if (!PyArg_ParseTuple(args, "OO|OOkk:ADsGetObjectAttributes",
+			&obPaths, // @pyparm [unicode, ...]|paths||The ADsPaths of the objects
+			&obNames, // @pyparm [unicode, ...]|attrNames||The attributes to read
+			&obUserName, // @pyparm unicode|username|None|
+			&obPassword, // @pyparm unicode|password|None|
+			&flags, // @pyparm int|flags|ADS_SECURE_AUTHENTICATION|The ADS_AUTHENTICATION_ENUM flags for each bind
+			&maxThreads)) // @pyparm int|maxThreads|8|The most objects bound at once
+		return NULL;
+	ADS_ATTR_FETCH_WORK work;
+	memset(&work, 0, sizeof(work));
+	work.flags = flags;
+	PyObject *ret = NULL, *obErrors = NULL, *obRows = NULL;
+	PFNADSVALUECONVERTER *converters = NULL;
+	ADSTYPE *coltypes = NULL;
+	LONG i;
+	DWORD c, a;
+	TmpPyObject seq = PySequence_Fast(obPaths, "paths must be a sequence of strings");
+	if (seq == NULL)
+		return NULL;
+	Py_ssize_t cnt = PySequence_Fast_GET_SIZE((PyObject *)seq);
+	work.items = (ADS_ATTR_FETCH *)calloc(cnt + 1, sizeof(ADS_ATTR_FETCH));
+	if (work.items == NULL)
+		return PyErr_NoMemory();
+	if (!PyADSI_MakeNames(obNames, &work.names, &work.cnames))
+		goto done;
+	converters = (PFNADSVALUECONVERTER *)calloc(work.cnames + 1, sizeof(PFNADSVALUECONVERTER));
+	coltypes = (ADSTYPE *)calloc(work.cnames + 1, sizeof(ADSTYPE));
+	if (converters == NULL || coltypes == NULL) {
+		PyErr_NoMemory();
+		goto done;
+	}
+	if (!PyWinObject_AsWCHAR(obUserName, &work.userName, TRUE))
+		goto done;
+	if (!PyWinObject_AsWCHAR(obPassword, &work.password, TRUE))
+		goto done;
+	for (; work.cnt < cnt; work.cnt++)
+		if (!PyWinObject_AsWCHAR(PySequence_Fast_GET_ITEM((PyObject *)seq, work.cnt), &work.items[work.cnt].path, FALSE))
+			goto done;
+	if (maxThreads == 0)
+		maxThreads = 1;
+	if (maxThreads > MAXIMUM_WAIT_OBJECTS)
+		maxThreads = MAXIMUM_WAIT_OBJECTS;
+	if (maxThreads > (DWORD)work.cnt)
+		maxThreads = work.cnt;
+
+	Py_BEGIN_ALLOW_THREADS
+	HANDLE threads[MAXIMUM_WAIT_OBJECTS];
+	DWORD nthreads = 0;
+	for (; nthreads < maxThreads; nthreads++) {
+		threads[nthreads] = CreateThread(NULL, 0, ADsAttrFetchThread, &work, 0, NULL);
+		if (threads[nthreads] == NULL)
+			break;
+	}
+	if (nthreads) {
+		WaitForMultipleObjects(nthreads, threads, TRUE, INFINITE);
+		for (DWORD t = 0; t < nthreads; t++)
+			CloseHandle(threads[t]);
+	}
+	else
+		// No threads could be created, so do it all here
+		ADsAttrFetchThread(&work);
+	Py_END_ALLOW_THREADS
+
+	obErrors = PyTuple_New(work.cnt);
+	obRows = PyTuple_New(work.cnt);
+	if (obErrors == NULL || obRows == NULL)
+		goto done;
+	for (i = 0; i < work.cnt; i++) {
+		ADS_ATTR_FETCH *item = work.items + i;
+		PyObject *obErr = PyInt_FromLong(item->hr);
+		if (obErr == NULL)
+			goto done;
+		PyTuple_SET_ITEM(obErrors, i, obErr);
+		if (FAILED(item->hr)) {
+			Py_INCREF(Py_None);
+			PyTuple_SET_ITEM(obRows, i, Py_None);
+			continue;
+		}
+		PyObject *obRow = PyTuple_New(work.cnames);
+		if (obRow == NULL)
+			goto done;
+		PyTuple_SET_ITEM(obRows, i, obRow);
+		for (c = 0; c < work.cnames; c++) {
+			// The attributes come back in no particular order, and only if set
+			ADS_ATTR_INFO *attr = NULL;
+			for (a = 0; a < item->cattrs; a++)
+				if (_wcsicmp(item->attrs[a].pszAttrName, work.names[c]) == 0) {
+					attr = item->attrs + a;
+					break;
+				}
+			PyObject *obValues;
+			if (attr == NULL || attr->dwNumValues == 0) {
+				Py_INCREF(Py_None);
+				obValues = Py_None;
+			}
+			else {
+				if (converters[c] == NULL || coltypes[c] != attr->dwADsType) {
+					converters[c] = PyADSI_GetADSValueConverter(attr->dwADsType);
+					coltypes[c] = attr->dwADsType;
+				}
+				obValues = PyTuple_New(attr->dwNumValues);
+				for (DWORD v = 0; obValues && v < attr->dwNumValues; v++) {
+					PyObject *val = attr->pADsValues[v].dwType == coltypes[c]
+										? (*converters[c])(attr->pADsValues[v])
+										: PyADSI_ConvertADSGeneric(attr->pADsValues[v]);
+					if (val == NULL)
+						Py_CLEAR(obValues);
+					else
+						PyTuple_SET_ITEM(obValues, v, val);
+				}
+			}
+			if (obValues == NULL)
+				goto done;
+			PyTuple_SET_ITEM(obRow, c, obValues);
+		}
+	}
+	ret = Py_BuildValue("OO", obErrors, obRows);
+done:
+	Py_XDECREF(obErrors);
+	Py_XDECREF(obRows);
+	for (i = 0; i < cnt; i++) {
+		PyWinObject_FreeWCHAR(work.items[i].path);
+		if (work.items[i].attrs)
+			FreeADsMem(work.items[i].attrs);
+	}
+	free(work.items);
+	if (work.names)
+		PyADSI_FreeNames(work.names, work.cnames);
+	PyWinObject_FreeWCHAR(work.userName);
+	PyWinObject_FreeWCHAR(work.password);
+	free(converters);
+	free(coltypes);
+	return ret;
+}
+%}
+%native (ADsGetObjectAttributes) PyADsGetObjectAttributes;
+
 %{
 // @pyswig <o PyDS_SELECTION_LIST>|StringAsDS_SELECTION_LIST|Unpacks a string (generally fetched via <om PyIDataObject.GetData>) into a <o PyDS_SELECTION_LIST> list.
 // @pyparm str|buf||The raw buffer
@@ -16,6 +16,8 @@ import win32api, winerror
 import pythoncom
 import types
 import re
+import threading
+import collections
 
 def RemoveCR(text):
 # No longer just "RemoveCR" - should be renamed to
@@ -23,6 +25,42 @@ def RemoveCR(text):
 # something Python can compile...
 	return re.sub('(\r\n)|\r|(\n\r)','\n',text)
 
+# Code objects for script blocks, shared by all engines in the process, so
+# hosts such as ASP which parse the same blocks for every page don't
+# compile them each time.  Keyed by (file name, compile type, code),
+# and limited to the most recently used compileCacheSize entries.
+compileCacheSize = 256
+_compileCache = collections.OrderedDict()
+_compileCacheLock = threading.Lock()
+_compileCacheHits = _compileCacheMisses = 0
+
+def _LookupCompiledCode(key):
+	global _compileCacheHits, _compileCacheMisses
+	with _compileCacheLock:
+		try:
+			codeObject = _compileCache[key]
+		except KeyError:
+			_compileCacheMisses = _compileCacheMisses + 1
+			return None
+		_compileCache.move_to_end(key)
+		_compileCacheHits = _compileCacheHits + 1
+		return codeObject
+
+def _StoreCompiledCode(key, codeObject):
+	with _compileCacheLock:
+		_compileCache[key] = codeObject
+		while len(_compileCache) > compileCacheSize:
+			_compileCache.popitem(last=False)
+
+def GetCompileCacheStats():
+	"""Returns (hits, misses, entries) for the script compile cache."""
+	with _compileCacheLock:
+		return _compileCacheHits, _compileCacheMisses, len(_compileCache)
+
+def ClearCompileCache():
+	with _compileCacheLock:
+		_compileCache.clear()
+
 SCRIPTTEXT_FORCEEXECUTION = -2147483648 # 0x80000000
 SCRIPTTEXT_ISEXPRESSION   = 0x00000020
 SCRIPTTEXT_ISPERSISTENT = 0x00000040
@@ -112,6 +150,7 @@ class AXScriptCodeBlock:
 		self.startLineNumber = startLineNumber
 		self.flags = flags
 		self.beenExecuted = 0
+		self.blockNumber = 0
 	def GetFileName(self):
 		# Gets the "file name" for Python - uses <...> so Python doesnt think
 		# it is a real file.
@@ -597,6 +636,8 @@ class COMScript:
 			# Re-initialize - shutdown then reset.
 			if self.scriptState in [axscript.SCRIPTSTATE_CONNECTED, axscript.SCRIPTSTATE_STARTED]:
 				self.Stop()
+			elif self.scriptState == axscript.SCRIPTSTATE_UNINITIALIZED:
+				self.ChangeScriptState(state)
 		elif state==axscript.SCRIPTSTATE_STARTED:
 			if self.scriptState == axscript.SCRIPTSTATE_CONNECTED:
 				self.Disconnect()
@@ -623,6 +664,7 @@ class COMScript:
 				self.Disconnect()
 			if self.scriptState == axscript.SCRIPTSTATE_DISCONNECTED:
 				self.Reset()
+			self.ResetForReuse()
 			self.ChangeScriptState(state)
 		else:
 			raise Exception(scode=winerror.E_INVALIDARG)
@@ -821,6 +863,13 @@ class COMScript:
 		self.ResetNamedItems()
 		self.ChangeScriptState(axscript.SCRIPTSTATE_INITIALIZED)
 
+	def ResetForReuse(self):
+		# Called on the way back to uninitialized, which is how hosts such
+		# as IIS return an engine to their cache.  Derived classes discard
+		# what was left by the last use, but may keep anything persistent
+		# which is expensive to recreate.
+		pass
+
 	def ChangeScriptState(self, state):
 		#print "  ChangeScriptState with %s - currentstate = %s" % (state_map.get(state),state_map.get(self.scriptState))
 		self.DisableInterrupts()
@@ -870,11 +919,20 @@ class COMScript:
 		else:
 			code = realCode
 		name = codeBlock.GetFileName()
+		code = RemoveCR(code)
+		# Skip the cache when debugging, so the debugger sees the compile.
+		key = (name, type, code)
+		if not self.debugManager:
+			codeObject = _LookupCompiledCode(key)
+			if codeObject is not None:
+				codeBlock.codeObject = codeObject
+				return 1
 		self.BeginScriptedSection()
 		try:
 			try:
-				codeObject = self._CompileInScriptedSection(RemoveCR(code), name, type)
+				codeObject = self._CompileInScriptedSection(code, name, type)
 				codeBlock.codeObject = codeObject
+				_StoreCompiledCode(key, codeObject)
 				return 1
 			finally:
 				if self.debugManager: self.debugManager.OnLeaveScript()
@@ -27,6 +27,11 @@ PyScript_CLSID = "{DF630910-1C1D-11d0-AE36-8C0F5E000000}"
 
 debugging_attr = 0
 
+# Map of known CLSID to typereprs, shared by all engines in the process, so
+# the type info for common named items (such as the ASP intrinsics) is only
+# read once.
+mapKnownCOMTypes = {}
+
 def debug_attr_print(*args):
 	if debugging_attr:
 		trace(*args)
@@ -75,11 +80,20 @@ class AXScriptAttribute:
 		raise AttributeError(attr)
 
 	def _FindAttribute_(self, attr):
-		for item in self._scriptEngine_.subItems.values():
+		engine = self._scriptEngine_
+		try:
+			return engine.axAttributeCache[attr]
+		except KeyError:
+			pass
+		for item in engine.subItems.values():
 			try:
-				return self._DoFindAttribute_(item, attr)
+				rc = self._DoFindAttribute_(item, attr)
 			except AttributeError:
-				pass
+				continue
+			# Only cache items - they are cleared as items are (re)registered.
+			if rc is not None:
+				engine.axAttributeCache[attr] = rc
+			return rc
 		# All else fails, see if it is a global
 		# (mainly b/w compat)
 		return getattr(self._scriptEngine_.globalNameSpaceModule, attr)
@@ -179,19 +193,44 @@ class PyScript(framework.COMScript):
 		self.globalNameSpaceModule = None
 		self.codeBlocks = []
 		self.scriptDispatch = None
+		self.axAttributeCache = {}
 
 	def InitNew(self):
 		framework.COMScript.InitNew(self)
-		import imp
-		self.scriptDispatch = None
-		self.globalNameSpaceModule = imp.new_module("__ax_main__")
-		self.globalNameSpaceModule.__dict__['ax'] = AXScriptAttribute(self)
+		self._InitNamespace()
 		
 		self.codeBlocks = []
 		self.persistedCodeBlocks = []
-		self.mapKnownCOMTypes = {} # Map of known CLSID to typereprs
+		self.mapKnownCOMTypes = mapKnownCOMTypes
 		self.codeBlockCounter = 0
 
+	def _InitNamespace(self):
+		import imp
+		self.scriptDispatch = None
+		self.axAttributeCache = {}
+		self.globalNameSpaceModule = imp.new_module("__ax_main__")
+		self.globalNameSpaceModule.__dict__['ax'] = AXScriptAttribute(self)
+
+	def ResetForReuse(self):
+		# Start again with empty globals and only the persistent code
+		# blocks and named items.  The code blocks are (re)compiled from the
+		# compile cache, and the items registered from mapKnownCOMTypes.
+		self.ResetNamespace()
+		self._InitNamespace()
+		for name, item in list(self.subItems.items()):
+			if item.flags & axscript.SCRIPTITEM_ISPERSISTENT:
+				item.Reset()
+			else:
+				item.Close()
+				del self.subItems[name]
+		self.codeBlocks = [b for b in self.codeBlocks if b.flags & SCRIPTTEXT_ISPERSISTENT]
+		for b in self.codeBlocks:
+			b.beenExecuted = 0
+		self.scriptCodeBlocks = dict([(b.GetFileName(), b) for b in self.codeBlocks])
+		# Number new blocks as the last use did, so their names - and so
+		# their compile cache keys - are the same.
+		self.codeBlockCounter = max([b.blockNumber for b in self.codeBlocks] + [0])
+
 	def Stop(self):
 		# Flag every pending script as already done
 		for b in self.codeBlocks:
@@ -206,6 +245,7 @@ class PyScript(framework.COMScript):
 			if b.flags & SCRIPTTEXT_ISPERSISTENT:
 				b.beenExecuted = 0
 				self.codeBlocks.append(b)
+		self.axAttributeCache = {}
 		return framework.COMScript.Reset(self)
 
 	def _GetNextCodeBlockNumber(self):
@@ -216,6 +256,7 @@ class PyScript(framework.COMScript):
 		wasReg = item.isRegistered
 		framework.COMScript.RegisterNamedItem(self, item)
 		if not wasReg:
+			self.axAttributeCache = {}
 			# Insert into our namespace.
 			# Add every item by name
 			if item.IsVisible():
@@ -324,6 +365,7 @@ class PyScript(framework.COMScript):
 		if num==1: num=""
 		name = "%s %s" % (name, num)
 		codeBlock = AXScriptCodeBlock(name, code, sourceContextCookie, startLineNumber, flags)
+		codeBlock.blockNumber = self.codeBlockCounter
 		self._AddScriptCodeBlock(codeBlock)
 		globs = self.globalNameSpaceModule.__dict__
 		if bWantResult: # always immediate.
@@ -219,6 +219,32 @@ class EngineTester(win32com.test.util.TestCase):
   def testVBExceptions(self):
     self.assertRaises(pythoncom.com_error,
                       self._TestEngine, "VBScript", ErrScript)
+  def testPythonCompileCache(self):
+    from win32com.axscript.client import framework
+    self._TestEngine("Python", PyScript)
+    hits = framework.GetCompileCacheStats()[0]
+    # A new engine parsing the same blocks gets them from the cache.
+    self._TestEngine("Python", PyScript)
+    self.failUnless(framework.GetCompileCacheStats()[0] > hits,
+                    "Expected the script blocks to be found in the cache")
+  def testPythonReuse(self):
+    site = MySite({'test' : util.wrap(Test())})
+    engine = site._AddEngine("Python")
+    try:
+      engine.AddCode("persisted = 1\n", axscript.SCRIPTTEXT_ISPERSISTENT)
+      engine.AddCode("per_request = 1\n")
+      engine.Start()
+      self.assertEqual(engine.EvalCode("per_request"), 1)
+      # Back to uninitialized, as the IIS engine cache does between requests.
+      engine.SetScriptState(axscript.SCRIPTSTATE_UNINITIALIZED)
+      _CheckEngineState(site, "Python", axscript.SCRIPTSTATE_UNINITIALIZED)
+      engine.SetScriptState(axscript.SCRIPTSTATE_INITIALIZED)
+      engine.Start()
+      self.assertEqual(engine.EvalCode("persisted"), 1)
+      self.assertEqual(engine.EvalCode("'per_request' in globals()"), False)
+      self.assertEqual(engine.EvalCode("ax.test is test"), True)
+    finally:
+      engine.Close()
   def testPythonExceptions(self):
     expected = "RuntimeError: exc with extended \xa9har"
     self._TestEngine("Python", PyScript_Exc, expected)
@@ -127,11 +127,91 @@ PyObject *PyIBackgroundCopyManager::GetErrorDescription(PyObject *self, PyObject
     return obpErrorDescription;
 }
 
+// @pymethod [(<o PyIID>, str, int, int, <o PyObject_FromBG_JOB_PROGRESS>, int), ...]|PyIBackgroundCopyManager|
+// EnumJobsSnapshot|Returns the id, name, state and progress of all jobs in one call
+// @rdesc Returns a list of (jobId, displayName, type, state, progress, errorCount) tuples, one for each job.
+// @comm Jobs are fetched from the enumerator in batches, and all the information for a batch is retrieved
+// with the Python lock released.  This is much faster than calling <om PyIBackgroundCopyManager.EnumJobs>,
+// and then methods on each <o PyIBackgroundCopyJob>, when there are many jobs.
+PyObject *PyIBackgroundCopyManager::EnumJobsSnapshot(PyObject *self, PyObject *args)
+{
+    IBackgroundCopyManager *pIBCM = GetI(self);
+    if (pIBCM == NULL)
+        return NULL;
+    // @pyparm int|dwFlags|0|0 or BG_JOB_ENUM_ALL_USERS
+    DWORD dwFlags = 0;
+    if (!PyArg_ParseTuple(args, "|k:EnumJobsSnapshot", &dwFlags))
+        return NULL;
+
+#define SNAPSHOT_BATCH 64
+    struct {
+        GUID id;
+        WCHAR *name;
+        BG_JOB_TYPE type;
+        BG_JOB_STATE state;
+        BG_JOB_PROGRESS progress;
+        ULONG errors;
+    } info[SNAPSHOT_BATCH];
+    IBackgroundCopyJob *jobs[SNAPSHOT_BATCH];
+    IEnumBackgroundCopyJobs *pEnum = NULL;
+    HRESULT hr;
+    PY_INTERFACE_PRECALL;
+    hr = pIBCM->EnumJobs(dwFlags, &pEnum);
+    PY_INTERFACE_POSTCALL;
+    if (FAILED(hr))
+        return PyCom_BuildPyException(hr, pIBCM, IID_IBackgroundCopyManager);
+
+    PyObject *ret = PyList_New(0);
+    while (ret) {
+        ULONG fetched = 0;
+        {
+            PY_INTERFACE_PRECALL;
+            hr = pEnum->Next(SNAPSHOT_BATCH, jobs, &fetched);
+            for (ULONG i = 0; SUCCEEDED(hr) && i < fetched; i++) {
+                ZeroMemory(&info[i], sizeof(info[i]));
+                // A job may be removed while we look at it, so failures leave the defaults.
+                jobs[i]->GetId(&info[i].id);
+                if (FAILED(jobs[i]->GetDisplayName(&info[i].name)))
+                    info[i].name = NULL;
+                jobs[i]->GetType(&info[i].type);
+                jobs[i]->GetState(&info[i].state);
+                jobs[i]->GetProgress(&info[i].progress);
+                jobs[i]->GetErrorCount(&info[i].errors);
+                jobs[i]->Release();
+            }
+            PY_INTERFACE_POSTCALL;
+        }
+        if (FAILED(hr)) {
+            PyCom_BuildPyException(hr, pEnum, IID_IEnumBackgroundCopyJobs);
+            Py_CLEAR(ret);
+            break;
+        }
+        for (ULONG i = 0; i < fetched; i++) {
+            if (ret) {
+                PyObject *item = Py_BuildValue("NNkkNk", PyWinObject_FromIID(info[i].id),
+                                               PyWinObject_FromWCHAR(info[i].name ? info[i].name : L""),
+                                               info[i].type, info[i].state,
+                                               PyObject_FromBG_JOB_PROGRESS(&info[i].progress), info[i].errors);
+                if (item == NULL || PyList_Append(ret, item) == -1)
+                    Py_CLEAR(ret);
+                Py_XDECREF(item);
+            }
+            CoTaskMemFree(info[i].name);
+        }
+        if (hr != S_OK || fetched < SNAPSHOT_BATCH)
+            break;
+    }
+    pEnum->Release();
+    return ret;
+}
+
 // @object PyIBackgroundCopyManager|Description of the interface
 static struct PyMethodDef PyIBackgroundCopyManager_methods[] = {
     {"CreateJob", PyIBackgroundCopyManager::CreateJob, 1},  // @pymeth CreateJob|Description of CreateJob
     {"GetJob", PyIBackgroundCopyManager::GetJob, 1},        // @pymeth GetJob|Description of GetJob
     {"EnumJobs", PyIBackgroundCopyManager::EnumJobs, 1},    // @pymeth EnumJobs|Description of EnumJobs
+    {"EnumJobsSnapshot", PyIBackgroundCopyManager::EnumJobsSnapshot,
+     1},  // @pymeth EnumJobsSnapshot|Returns the id, name, state and progress of all jobs in one call
     {"GetErrorDescription", PyIBackgroundCopyManager::GetErrorDescription,
      1},  // @pymeth GetErrorDescription|Description of GetErrorDescription
     {NULL}};
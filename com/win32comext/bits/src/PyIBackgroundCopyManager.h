@@ -14,6 +14,7 @@ class PyIBackgroundCopyManager : public PyIUnknown {
     static PyObject *CreateJob(PyObject *self, PyObject *args);
     static PyObject *GetJob(PyObject *self, PyObject *args);
     static PyObject *EnumJobs(PyObject *self, PyObject *args);
+    static PyObject *EnumJobsSnapshot(PyObject *self, PyObject *args);
     static PyObject *GetErrorDescription(PyObject *self, PyObject *args);
 
    protected:
@@ -73,7 +73,342 @@ BOOL PyObject_AsBG_AUTH_CREDENTIALS(PyObject *ob, BG_AUTH_CREDENTIALS *pRet)
     return FALSE;
 }
 
-static struct PyMethodDef bits_methods[] = {NULL};
+// A native IBackgroundCopyCallback that records notifications on a lock-free SList,
+// so BITS threads never need the Python lock.  Python drains the queue with
+// <om PyBITSNotifyQueue.Get>.
+typedef struct {
+    SLIST_ENTRY entry;  // must be first, and aligned to MEMORY_ALLOCATION_ALIGNMENT.
+    DWORD event;        // BG_NOTIFY_JOB_TRANSFERRED, BG_NOTIFY_JOB_ERROR or BG_NOTIFY_JOB_MODIFICATION
+    GUID jobId;
+    BG_JOB_STATE state;
+    BG_JOB_PROGRESS progress;
+    BOOL haveError;
+    BG_ERROR_CONTEXT errorContext;
+    HRESULT errorCode;
+    WCHAR *errorDescription;  // CoTaskMemAlloc'ed, may be NULL
+} BITS_NOTIFY_RECORD;
+
+class CBITSNotifyQueue : public IBackgroundCopyCallback {
+   public:
+    CBITSNotifyQueue(LONG maxQueued);
+    ~CBITSNotifyQueue();
+    BOOL ok() { return m_list != NULL && m_event != NULL; }
+    // Takes everything queued so far, in the order it was queued.
+    BITS_NOTIFY_RECORD *Flush();
+    static void FreeRecord(BITS_NOTIFY_RECORD *pr);
+
+    STDMETHOD(QueryInterface)(REFIID iid, void **ppv);
+    STDMETHOD_(ULONG, AddRef)();
+    STDMETHOD_(ULONG, Release)();
+    STDMETHOD(JobTransferred)(IBackgroundCopyJob *pJob);
+    STDMETHOD(JobError)(IBackgroundCopyJob *pJob, IBackgroundCopyError *pError);
+    STDMETHOD(JobModification)(IBackgroundCopyJob *pJob, DWORD dwReserved);
+
+    HANDLE m_event;  // Set when a record is queued
+    volatile LONG m_queued, m_dropped;
+
+   protected:
+    void Push(DWORD event, IBackgroundCopyJob *pJob, IBackgroundCopyError *pError);
+    SLIST_HEADER *m_list;
+    LONG m_maxQueued;
+    LONG m_refs;
+};
+
+CBITSNotifyQueue::CBITSNotifyQueue(LONG maxQueued)
+{
+    m_refs = 1;
+    m_maxQueued = maxQueued;
+    m_queued = m_dropped = 0;
+    m_list = (SLIST_HEADER *)_aligned_malloc(sizeof(SLIST_HEADER), MEMORY_ALLOCATION_ALIGNMENT);
+    if (m_list)
+        InitializeSListHead(m_list);
+    m_event = CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+CBITSNotifyQueue::~CBITSNotifyQueue()
+{
+    if (m_list) {
+        BITS_NOTIFY_RECORD *pr = Flush();
+        while (pr) {
+            BITS_NOTIFY_RECORD *pNext = (BITS_NOTIFY_RECORD *)pr->entry.Next;
+            FreeRecord(pr);
+            pr = pNext;
+        }
+        _aligned_free(m_list);
+    }
+    if (m_event)
+        CloseHandle(m_event);
+}
+
+STDMETHODIMP CBITSNotifyQueue::QueryInterface(REFIID iid, void **ppv)
+{
+    if (iid == IID_IUnknown || iid == IID_IBackgroundCopyCallback) {
+        *ppv = (IBackgroundCopyCallback *)this;
+        AddRef();
+        return S_OK;
+    }
+    *ppv = NULL;
+    return E_NOINTERFACE;
+}
+
+STDMETHODIMP_(ULONG) CBITSNotifyQueue::AddRef() { return InterlockedIncrement(&m_refs); }
+
+STDMETHODIMP_(ULONG) CBITSNotifyQueue::Release()
+{
+    LONG refs = InterlockedDecrement(&m_refs);
+    if (refs == 0)
+        delete this;
+    return refs;
+}
+
+STDMETHODIMP CBITSNotifyQueue::JobTransferred(IBackgroundCopyJob *pJob)
+{
+    Push(BG_NOTIFY_JOB_TRANSFERRED, pJob, NULL);
+    return S_OK;
+}
+
+STDMETHODIMP CBITSNotifyQueue::JobError(IBackgroundCopyJob *pJob, IBackgroundCopyError *pError)
+{
+    Push(BG_NOTIFY_JOB_ERROR, pJob, pError);
+    return S_OK;
+}
+
+STDMETHODIMP CBITSNotifyQueue::JobModification(IBackgroundCopyJob *pJob, DWORD dwReserved)
+{
+    Push(BG_NOTIFY_JOB_MODIFICATION, pJob, NULL);
+    return S_OK;
+}
+
+void CBITSNotifyQueue::Push(DWORD event, IBackgroundCopyJob *pJob, IBackgroundCopyError *pError)
+{
+    if (InterlockedIncrement(&m_queued) > m_maxQueued) {
+        InterlockedDecrement(&m_queued);
+        InterlockedIncrement(&m_dropped);
+        return;
+    }
+    BITS_NOTIFY_RECORD *pr =
+        (BITS_NOTIFY_RECORD *)_aligned_malloc(sizeof(BITS_NOTIFY_RECORD), MEMORY_ALLOCATION_ALIGNMENT);
+    if (pr == NULL) {
+        InterlockedDecrement(&m_queued);
+        InterlockedIncrement(&m_dropped);
+        return;
+    }
+    ZeroMemory(pr, sizeof(*pr));
+    pr->event = event;
+    pJob->GetId(&pr->jobId);
+    pJob->GetState(&pr->state);
+    pJob->GetProgress(&pr->progress);
+    // JobError isn't called for transient errors, so pick those up from the job.
+    IBackgroundCopyError *pJobError = NULL;
+    if (pError == NULL && (pr->state == BG_JOB_STATE_ERROR || pr->state == BG_JOB_STATE_TRANSIENT_ERROR) &&
+        SUCCEEDED(pJob->GetError(&pJobError)))
+        pError = pJobError;
+    if (pError && SUCCEEDED(pError->GetError(&pr->errorContext, &pr->errorCode))) {
+        pr->haveError = TRUE;
+        if (FAILED(pError->GetErrorDescription(LANGIDFROMLCID(GetThreadLocale()), &pr->errorDescription)))
+            pr->errorDescription = NULL;
+    }
+    if (pJobError)
+        pJobError->Release();
+    InterlockedPushEntrySList(m_list, &pr->entry);
+    SetEvent(m_event);
+}
+
+BITS_NOTIFY_RECORD *CBITSNotifyQueue::Flush()
+{
+    // The SList is LIFO - reverse what we took to restore the order it was queued in.
+    SLIST_ENTRY *pe = InterlockedFlushSList(m_list), *pFifo = NULL;
+    while (pe) {
+        SLIST_ENTRY *pNext = pe->Next;
+        pe->Next = pFifo;
+        pFifo = pe;
+        pe = pNext;
+    }
+    return (BITS_NOTIFY_RECORD *)pFifo;
+}
+
+void CBITSNotifyQueue::FreeRecord(BITS_NOTIFY_RECORD *pr)
+{
+    if (pr->errorDescription)
+        CoTaskMemFree(pr->errorDescription);
+    _aligned_free(pr);
+}
+
+// @object PyBITSNotifyQueue|Collects BITS job notifications natively, to be read in batches from Python.
+// @comm Created by <om bits.CreateNotifyQueue>.  Pass the <o PyBITSNotifyQueue>.Interface attribute to
+// <om PyIBackgroundCopyJob.SetNotifyInterface> for each job to be monitored.  Notifications arrive on
+// BITS threads and are queued without acquiring the Python lock, so many concurrent jobs can be monitored
+// cheaply.
+class PyBITSNotifyQueue : public PyObject {
+   public:
+    PyBITSNotifyQueue(CBITSNotifyQueue *pQueue);
+    ~PyBITSNotifyQueue();
+    static void deallocFunc(PyObject *ob);
+    static PyObject *Get(PyObject *self, PyObject *args);
+    static PyObject *get_Interface(PyObject *self, void *unused);
+    static PyObject *get_Dropped(PyObject *self, void *unused);
+    static PyObject *get_Pending(PyObject *self, void *unused);
+    static struct PyMethodDef methods[];
+    static PyGetSetDef getset[];
+    CBITSNotifyQueue *m_pQueue;
+};
+
+struct PyMethodDef PyBITSNotifyQueue::methods[] = {
+    {"Get", PyBITSNotifyQueue::Get, METH_VARARGS},  // @pymeth Get|Returns the notifications queued so far
+    {NULL}};
+
+PyGetSetDef PyBITSNotifyQueue::getset[] = {
+    // @prop <o PyIUnknown>|Interface|The IBackgroundCopyCallback interface of the queue
+    {"Interface", PyBITSNotifyQueue::get_Interface, NULL},
+    // @prop int|Dropped|Number of notifications discarded because the queue was full
+    {"Dropped", PyBITSNotifyQueue::get_Dropped, NULL},
+    // @prop int|Pending|Number of notifications waiting to be read
+    {"Pending", PyBITSNotifyQueue::get_Pending, NULL},
+    {NULL}};
+
+PyTypeObject PyBITSNotifyQueueType = {
+    PYWIN_OBJECT_HEAD "PyBITSNotifyQueue",
+    sizeof(PyBITSNotifyQueue),
+    0,
+    PyBITSNotifyQueue::deallocFunc, /* tp_dealloc */
+    0,                              /* tp_print */
+    0,                              /* tp_getattr */
+    0,                              /* tp_setattr */
+    0,                              /* tp_compare */
+    0,                              /* tp_repr */
+    0,                              /* tp_as_number */
+    0,                              /* tp_as_sequence */
+    0,                              /* tp_as_mapping */
+    0,                              /* tp_hash */
+    0,                              /* tp_call */
+    0,                              /* tp_str */
+    PyObject_GenericGetAttr,        /* tp_getattro */
+    0,                              /* tp_setattro */
+    0,                              /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,             /* tp_flags */
+    0,                              /* tp_doc */
+    0,                              /* tp_traverse */
+    0,                              /* tp_clear */
+    0,                              /* tp_richcompare */
+    0,                              /* tp_weaklistoffset */
+    0,                              /* tp_iter */
+    0,                              /* tp_iternext */
+    PyBITSNotifyQueue::methods,     /* tp_methods */
+    0,                              /* tp_members */
+    PyBITSNotifyQueue::getset,      /* tp_getset */
+};
+
+PyBITSNotifyQueue::PyBITSNotifyQueue(CBITSNotifyQueue *pQueue)
+{
+    ob_type = &PyBITSNotifyQueueType;
+    _Py_NewReference(this);
+    m_pQueue = pQueue;
+}
+
+PyBITSNotifyQueue::~PyBITSNotifyQueue()
+{
+    // BITS may still hold references, so the queue lives on until they are released.
+    m_pQueue->Release();
+}
+
+/*static*/ void PyBITSNotifyQueue::deallocFunc(PyObject *ob) { delete (PyBITSNotifyQueue *)ob; }
+
+PyObject *PyBITSNotifyQueue::get_Interface(PyObject *self, void *unused)
+{
+    return PyCom_PyObjectFromIUnknown(((PyBITSNotifyQueue *)self)->m_pQueue, IID_IUnknown, TRUE);
+}
+
+PyObject *PyBITSNotifyQueue::get_Dropped(PyObject *self, void *unused)
+{
+    return PyInt_FromLong(((PyBITSNotifyQueue *)self)->m_pQueue->m_dropped);
+}
+
+PyObject *PyBITSNotifyQueue::get_Pending(PyObject *self, void *unused)
+{
+    return PyInt_FromLong(((PyBITSNotifyQueue *)self)->m_pQueue->m_queued);
+}
+
+static PyObject *PyObject_FromBITS_NOTIFY_RECORD(BITS_NOTIFY_RECORD *pr)
+{
+    PyObject *obError;
+    if (pr->haveError)
+        obError = Py_BuildValue("lkN", pr->errorCode, pr->errorContext,
+                                PyWinObject_FromWCHAR(pr->errorDescription ? pr->errorDescription : L""));
+    else {
+        Py_INCREF(Py_None);
+        obError = Py_None;
+    }
+    if (obError == NULL)
+        return NULL;
+    return Py_BuildValue("kNkNN", pr->event, PyWinObject_FromIID(pr->jobId), pr->state,
+                         PyObject_FromBG_JOB_PROGRESS(&pr->progress), obError);
+}
+
+// @pymethod [(int, <o PyIID>, int, <o PyObject_FromBG_JOB_PROGRESS>, tuple), ...]|PyBITSNotifyQueue|Get|Returns the
+// notifications queued so far
+// @rdesc Returns a list of (event, jobId, state, progress, error) tuples in the order the notifications were received.
+// Event is one of the BG_NOTIFY_JOB_* flags, and state and progress are those of the job at the time of the
+// notification.  Error is None, or a tuple of (hresult, context, description) when the job is in an error state.
+// An empty list is returned if the timeout expires.
+PyObject *PyBITSNotifyQueue::Get(PyObject *self, PyObject *args)
+{
+    CBITSNotifyQueue *pQueue = ((PyBITSNotifyQueue *)self)->m_pQueue;
+    DWORD timeout = 0;
+    // @pyparm int|Timeout|0|Milliseconds to wait for a notification if there are none queued, or
+    // win32event.INFINITE
+    if (!PyArg_ParseTuple(args, "|k:Get", &timeout))
+        return NULL;
+    BITS_NOTIFY_RECORD *pr = pQueue->Flush();
+    if (pr == NULL && timeout != 0) {
+        Py_BEGIN_ALLOW_THREADS;
+        if (WaitForSingleObject(pQueue->m_event, timeout) == WAIT_OBJECT_0)
+            pr = pQueue->Flush();
+        Py_END_ALLOW_THREADS;
+    }
+    PyObject *ret = PyList_New(0);
+    while (pr) {
+        BITS_NOTIFY_RECORD *pNext = (BITS_NOTIFY_RECORD *)pr->entry.Next;
+        InterlockedDecrement(&pQueue->m_queued);
+        if (ret) {
+            PyObject *item = PyObject_FromBITS_NOTIFY_RECORD(pr);
+            if (item == NULL || PyList_Append(ret, item) == -1)
+                Py_CLEAR(ret);
+            Py_XDECREF(item);
+        }
+        CBITSNotifyQueue::FreeRecord(pr);
+        pr = pNext;
+    }
+    return ret;
+}
+
+// @pymethod <o PyBITSNotifyQueue>|bits|CreateNotifyQueue|Creates a native callback object that queues job
+// notifications
+static PyObject *PyCreateNotifyQueue(PyObject *self, PyObject *args)
+{
+    LONG maxQueued = 65536;
+    // @pyparm int|MaxQueued|65536|Maximum number of notifications held.  Further notifications are counted
+    // in the Dropped attribute and discarded until the queue is read.
+    if (!PyArg_ParseTuple(args, "|l:CreateNotifyQueue", &maxQueued))
+        return NULL;
+    if (maxQueued < 1) {
+        PyErr_SetString(PyExc_ValueError, "MaxQueued must be greater than zero");
+        return NULL;
+    }
+    CBITSNotifyQueue *pQueue = new CBITSNotifyQueue(maxQueued);
+    if (pQueue == NULL)
+        return PyErr_NoMemory();
+    if (!pQueue->ok()) {
+        pQueue->Release();
+        return PyErr_NoMemory();
+    }
+    return new PyBITSNotifyQueue(pQueue);
+}
+
+// @module bits|A module, encapsulating the Background Intelligent Transfer Service (bits)
+static struct PyMethodDef bits_methods[] = {
+    {"CreateNotifyQueue", PyCreateNotifyQueue,
+     1},  // @pymeth CreateNotifyQueue|Creates a native callback object that queues job notifications
+    {NULL}};
 
 static const PyCom_InterfaceSupportInfo register_data[] = {
     PYCOM_INTERFACE_CLSID_ONLY(BackgroundCopyManager),   PYCOM_INTERFACE_CLIENT_ONLY(BackgroundCopyManager),
@@ -90,6 +425,9 @@ PYWIN_MODULE_INIT_FUNC(bits)
     PYWIN_MODULE_INIT_PREPARE(bits, bits_methods,
                               "A module, encapsulating the Background Intelligent Transfer Service (bits)");
 
+    if (PyType_Ready(&PyBITSNotifyQueueType) == -1)
+        PYWIN_MODULE_INIT_RETURN_ERROR;
+
     // Register all of our interfaces, gateways and IIDs.
     PyCom_RegisterExtensionSupport(dict, register_data, sizeof(register_data) / sizeof(PyCom_InterfaceSupportInfo));
 
@@ -0,0 +1,615 @@
+//
+// @doc
+
+#include "PyWinTypes.h"
+#include "PyWinObjects.h"
+#include "structmember.h"
+#include "directsound_pch.h"
+
+// The ring has a single producer and a single consumer - Python and the worker thread,
+// in one order or the other depending on the direction of the stream.  m_head and m_tail
+// count all bytes ever written and read, so their difference is the fill level even
+// after they wrap.
+
+ULONG PyDSStream::RingReadable()
+{
+    ULONG ret = m_head - m_tail;
+    MemoryBarrier();
+    return ret;
+}
+
+ULONG PyDSStream::RingWritable() { return m_ringBytes - RingReadable(); }
+
+void PyDSStream::RingPut(const BYTE *p, ULONG cb)
+{
+    ULONG pos = m_head % m_ringBytes;
+    ULONG first = min(cb, m_ringBytes - pos);
+    memcpy(m_ring + pos, p, first);
+    memcpy(m_ring, p + first, cb - first);
+    // The data must be visible before the consumer sees the new head.
+    MemoryBarrier();
+    m_head += cb;
+}
+
+void PyDSStream::RingGet(BYTE *p, ULONG cb)
+{
+    ULONG pos = m_tail % m_ringBytes;
+    ULONG first = min(cb, m_ringBytes - pos);
+    memcpy(p, m_ring + pos, first);
+    memcpy(p + first, m_ring, cb - first);
+    MemoryBarrier();
+    m_tail += cb;
+}
+
+// Fills part of the playback buffer from the ring, padding with silence.  Returns FALSE if
+// the ring ran dry.
+BOOL PyDSStream::FillPart(BYTE *p, DWORD cb)
+{
+    if (p == NULL || cb == 0)
+        return TRUE;
+    ULONG n = min(cb, RingReadable());
+    RingGet(p, n);
+    memset(p + n, m_silence, cb - n);
+    return n == cb;
+}
+
+// Empties part of the capture buffer into the ring.  Returns FALSE if the ring was full,
+// and some data was discarded.
+BOOL PyDSStream::DrainPart(const BYTE *p, DWORD cb)
+{
+    if (p == NULL || cb == 0)
+        return TRUE;
+    ULONG n = min(cb, RingWritable());
+    RingPut(p, n);
+    return n == cb;
+}
+
+// Moves whatever audio can be moved between the DirectSound buffer and the ring.
+// Called on the worker thread, or by Start and Stop when there is no worker thread.
+void PyDSStream::Pump(BOOL bPrefill)
+{
+    DWORD pos1, pos2;
+    HRESULT hr = m_pPlay ? m_pPlay->GetCurrentPosition(&pos1, &pos2) : m_pCapture->GetCurrentPosition(&pos1, &pos2);
+    if (FAILED(hr))
+        return;
+    // For playback, everything from our position up to the play cursor has been played and
+    // can be refilled.  For capture, everything up to the read cursor is ready.
+    DWORD cursor = m_pPlay ? pos1 : pos2;
+    DWORD cb = bPrefill ? m_dsBytes : (cursor + m_dsBytes - m_dsPos) % m_dsBytes;
+    cb -= cb % m_blockAlign;
+    if (cb == 0)
+        return;
+    void *p1, *p2;
+    DWORD cb1, cb2;
+    BOOL ok;
+    if (m_pPlay) {
+        hr = m_pPlay->Lock(m_dsPos, cb, &p1, &cb1, &p2, &cb2, 0);
+        if (hr == DSERR_BUFFERLOST && SUCCEEDED(m_pPlay->Restore()))
+            hr = m_pPlay->Lock(m_dsPos, cb, &p1, &cb1, &p2, &cb2, 0);
+        if (FAILED(hr))
+            return;
+        ok = FillPart((BYTE *)p1, cb1);
+        ok = FillPart((BYTE *)p2, cb2) && ok;
+        m_pPlay->Unlock(p1, cb1, p2, cb2);
+        // Silence before the first data isn't an underrun.
+        if (!ok && !bPrefill)
+            InterlockedIncrement(&m_underruns);
+    }
+    else {
+        hr = m_pCapture->Lock(m_dsPos, cb, &p1, &cb1, &p2, &cb2, 0);
+        if (FAILED(hr))
+            return;
+        ok = DrainPart((const BYTE *)p1, cb1);
+        ok = DrainPart((const BYTE *)p2, cb2) && ok;
+        m_pCapture->Unlock(p1, cb1, p2, cb2);
+        if (!ok)
+            InterlockedIncrement(&m_overruns);
+    }
+    m_dsPos = (m_dsPos + cb) % m_dsBytes;
+    SetEvent(m_dataEvent);
+}
+
+/*static*/ DWORD WINAPI PyDSStream::ThreadProc(LPVOID arg)
+{
+    PyDSStream *This = (PyDSStream *)arg;
+    HANDLE handles[2] = {This->m_stopEvent, This->m_notifyEvent};
+    for (;;) {
+        // Notifications may not be delivered for buffers created without DSBCAPS_CTRLPOSITIONNOTIFY,
+        // so also wake up every period.
+        DWORD rc = WaitForMultipleObjects(This->m_notifyEvent ? 2 : 1, handles, FALSE, This->m_periodMs);
+        if (rc == WAIT_OBJECT_0 || rc == WAIT_FAILED)
+            break;
+        This->Pump(FALSE);
+    }
+    return 0;
+}
+
+PyDSStream::PyDSStream(IDirectSoundBuffer *pPlay, IDirectSoundCaptureBuffer *pCapture, DWORD dsBytes,
+                       const WAVEFORMATEX &wfx, ULONG ringBytes)
+{
+    ob_type = &PyDSStreamType;
+    _Py_NewReference(this);
+    m_pPlay = pPlay;
+    m_pCapture = pCapture;
+    m_dsBytes = dsBytes;
+    m_dsPos = 0;
+    m_blockAlign = wfx.nBlockAlign ? wfx.nBlockAlign : 1;
+    // 8 bit PCM is unsigned
+    m_silence = wfx.wBitsPerSample == 8 ? 0x80 : 0;
+    m_ringBytes = ringBytes;
+    m_ring = (BYTE *)malloc(ringBytes);
+    m_head = m_tail = 0;
+    m_underruns = m_overruns = 0;
+    m_periodMs = 0;
+    m_notifyEvent = NULL;
+    m_stopEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    m_dataEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    m_thread = NULL;
+}
+
+PyDSStream::~PyDSStream()
+{
+    if (m_thread) {
+        Py_BEGIN_ALLOW_THREADS;
+        StopStream();
+        Py_END_ALLOW_THREADS;
+    }
+    if (m_pPlay)
+        m_pPlay->Release();
+    if (m_pCapture)
+        m_pCapture->Release();
+    if (m_notifyEvent)
+        CloseHandle(m_notifyEvent);
+    if (m_stopEvent)
+        CloseHandle(m_stopEvent);
+    if (m_dataEvent)
+        CloseHandle(m_dataEvent);
+    free(m_ring);
+}
+
+/*static*/ void PyDSStream::deallocFunc(PyObject *ob) { delete (PyDSStream *)ob; }
+
+// Sets up position notifications, evenly spaced through the DirectSound buffer.
+HRESULT PyDSStream::SetupNotify(DWORD periods, DWORD avgBytesPerSec)
+{
+    DWORD periodBytes = m_dsBytes / periods;
+    m_periodMs = avgBytesPerSec ? max(1, MulDiv(periodBytes, 1000, avgBytesPerSec)) : 10;
+    IDirectSoundNotify *pNotify = NULL;
+    HRESULT hr = m_pPlay ? m_pPlay->QueryInterface(IID_IDirectSoundNotify, (void **)&pNotify)
+                         : m_pCapture->QueryInterface(IID_IDirectSoundNotify, (void **)&pNotify);
+    if (FAILED(hr))
+        // Just poll once per period.
+        return S_OK;
+    m_notifyEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (m_notifyEvent == NULL) {
+        pNotify->Release();
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+    DSBPOSITIONNOTIFY *notify = new DSBPOSITIONNOTIFY[periods];
+    for (DWORD i = 0; i < periods; i++) {
+        notify[i].dwOffset = (i + 1) * periodBytes - 1;
+        notify[i].hEventNotify = m_notifyEvent;
+    }
+    hr = pNotify->SetNotificationPositions(periods, notify);
+    delete[] notify;
+    pNotify->Release();
+    if (SUCCEEDED(hr))
+        // Notifications are only a hint - this catches any that get missed.
+        m_periodMs *= 2;
+    else {
+        CloseHandle(m_notifyEvent);
+        m_notifyEvent = NULL;
+    }
+    return S_OK;
+}
+
+HRESULT PyDSStream::StartStream()
+{
+    HRESULT hr;
+    if (m_pPlay) {
+        hr = m_pPlay->SetCurrentPosition(0);
+        if (FAILED(hr))
+            return hr;
+        m_dsPos = 0;
+        Pump(TRUE);
+    }
+    else {
+        DWORD capture, read;
+        hr = m_pCapture->GetCurrentPosition(&capture, &read);
+        if (FAILED(hr))
+            return hr;
+        m_dsPos = read;
+    }
+    ResetEvent(m_stopEvent);
+    m_thread = CreateThread(NULL, 0, ThreadProc, this, 0, NULL);
+    if (m_thread == NULL)
+        return HRESULT_FROM_WIN32(GetLastError());
+    SetThreadPriority(m_thread, THREAD_PRIORITY_TIME_CRITICAL);
+    hr = m_pPlay ? m_pPlay->Play(0, 0, DSBPLAY_LOOPING) : m_pCapture->Start(DSCBSTART_LOOPING);
+    if (FAILED(hr))
+        StopStream();
+    return hr;
+}
+
+void PyDSStream::StopStream()
+{
+    SetEvent(m_stopEvent);
+    WaitForSingleObject(m_thread, INFINITE);
+    CloseHandle(m_thread);
+    m_thread = NULL;
+    if (m_pPlay)
+        m_pPlay->Stop();
+    else {
+        m_pCapture->Stop();
+        // Collect what was captured since the last notification
+        Pump(FALSE);
+    }
+}
+
+// Waits for the worker to move data, with the Python lock released.  Returns FALSE if the
+// timeout expired.
+static BOOL WaitForData(PyDSStream *This, DWORD start, DWORD timeout)
+{
+    DWORD wait = INFINITE;
+    if (timeout != INFINITE) {
+        DWORD elapsed = GetTickCount() - start;
+        if (elapsed >= timeout)
+            return FALSE;
+        wait = timeout - elapsed;
+    }
+    DWORD rc;
+    Py_BEGIN_ALLOW_THREADS;
+    rc = WaitForSingleObject(This->m_dataEvent, wait);
+    Py_END_ALLOW_THREADS;
+    return rc == WAIT_OBJECT_0;
+}
+
+// @pymethod |PyDSStream|Start|Starts the DirectSound buffer and the worker thread.
+// @comm For playback, the DirectSound buffer is first filled from the ring, so data should be written
+// before starting to avoid initial silence.
+PyObject *PyDSStream::Start(PyObject *self, PyObject *args)
+{
+    PyDSStream *This = (PyDSStream *)self;
+    if (!PyArg_ParseTuple(args, ":Start"))
+        return NULL;
+    if (This->m_thread) {
+        PyErr_SetString(PyExc_RuntimeError, "The stream is already running");
+        return NULL;
+    }
+    HRESULT hr;
+    Py_BEGIN_ALLOW_THREADS;
+    hr = This->StartStream();
+    Py_END_ALLOW_THREADS;
+    if (FAILED(hr))
+        return PyCom_BuildPyException(hr);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod |PyDSStream|Stop|Stops the DirectSound buffer and the worker thread.
+// @comm Audio already in the ring is kept, and will be used if the stream is started again.
+PyObject *PyDSStream::Stop(PyObject *self, PyObject *args)
+{
+    PyDSStream *This = (PyDSStream *)self;
+    if (!PyArg_ParseTuple(args, ":Stop"))
+        return NULL;
+    if (This->m_thread) {
+        Py_BEGIN_ALLOW_THREADS;
+        This->StopStream();
+        Py_END_ALLOW_THREADS;
+    }
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod int|PyDSStream|Write|Queues audio for playback.
+// @rdesc Returns the number of bytes queued, which is less than the size of the data if the ring
+// filled up before the timeout expired.
+PyObject *PyDSStream::Write(PyObject *self, PyObject *args)
+{
+    PyDSStream *This = (PyDSStream *)self;
+    PyObject *obData;
+    DWORD timeout = 0;
+    // @pyparm buffer|data||Audio data in the format of the DirectSound buffer
+    // @pyparm int|timeout|0|Milliseconds to wait for space in the ring, or win32event.INFINITE
+    if (!PyArg_ParseTuple(args, "O|k:Write", &obData, &timeout))
+        return NULL;
+    if (This->m_pPlay == NULL) {
+        PyErr_SetString(PyExc_TypeError, "This is a capture stream");
+        return NULL;
+    }
+    PyWinBufferView pybuf(obData);
+    if (!pybuf.ok())
+        return NULL;
+    const BYTE *p = (const BYTE *)pybuf.ptr();
+    DWORD cbTotal = pybuf.len(), done = 0, start = GetTickCount();
+    for (;;) {
+        ULONG n = min(cbTotal - done, This->RingWritable());
+        This->RingPut(p + done, n);
+        done += n;
+        if (done == cbTotal || timeout == 0 || !WaitForData(This, start, timeout))
+            break;
+    }
+    return PyLong_FromUnsignedLong(done);
+}
+
+// Reads captured audio into a buffer, returning the bytes read or -1 on error.
+static Py_ssize_t ReadIntoBuffer(PyDSStream *This, BYTE *p, DWORD cbTotal, DWORD timeout)
+{
+    if (This->m_pCapture == NULL) {
+        PyErr_SetString(PyExc_TypeError, "This is a playback stream");
+        return -1;
+    }
+    DWORD done = 0, start = GetTickCount();
+    for (;;) {
+        ULONG n = min(cbTotal - done, This->RingReadable());
+        This->RingGet(p + done, n);
+        done += n;
+        if (done == cbTotal || timeout == 0 || !WaitForData(This, start, timeout))
+            break;
+    }
+    return done;
+}
+
+// @pymethod int|PyDSStream|ReadInto|Reads captured audio into a writable buffer.
+// @rdesc Returns the number of bytes read, which is less than the size of the buffer if the timeout expired.
+PyObject *PyDSStream::ReadInto(PyObject *self, PyObject *args)
+{
+    PyObject *obBuffer;
+    DWORD timeout = 0;
+    // @pyparm buffer|buffer||A writable buffer, such as a bytearray or numpy array
+    // @pyparm int|timeout|0|Milliseconds to wait for the buffer to be filled, or win32event.INFINITE
+    if (!PyArg_ParseTuple(args, "O|k:ReadInto", &obBuffer, &timeout))
+        return NULL;
+    PyWinBufferView pybuf(obBuffer, true);
+    if (!pybuf.ok())
+        return NULL;
+    Py_ssize_t n = ReadIntoBuffer((PyDSStream *)self, (BYTE *)pybuf.ptr(), pybuf.len(), timeout);
+    if (n == -1)
+        return NULL;
+    return PyInt_FromSsize_t(n);
+}
+
+// @pymethod bytes|PyDSStream|Read|Reads captured audio.
+PyObject *PyDSStream::Read(PyObject *self, PyObject *args)
+{
+    DWORD cb, timeout = 0;
+    // @pyparm int|size||Maximum number of bytes to read
+    // @pyparm int|timeout|0|Milliseconds to wait for size bytes, or win32event.INFINITE
+    if (!PyArg_ParseTuple(args, "k|k:Read", &cb, &timeout))
+        return NULL;
+    PyObject *ret = PyBytes_FromStringAndSize(NULL, cb);
+    if (ret == NULL)
+        return NULL;
+    Py_ssize_t n = ReadIntoBuffer((PyDSStream *)self, (BYTE *)PyBytes_AS_STRING(ret), cb, timeout);
+    if (n == -1 || (n != (Py_ssize_t)cb && _PyBytes_Resize(&ret, n) == -1)) {
+        Py_XDECREF(ret);
+        return NULL;
+    }
+    return ret;
+}
+
+// @pymethod (int, int)|PyDSStream|GetRegion|Returns the part of the ring Python can access without copying.
+// @rdesc Returns (offset, length) into the stream's buffer interface.  For playback, this is free space that
+// can be filled with audio.  For capture, it is captured audio that can be processed.  Once done, call
+// <om PyDSStream.Advance>.  The region is contiguous, so there may be more once the ring wraps around.
+PyObject *PyDSStream::GetRegion(PyObject *self, PyObject *args)
+{
+    PyDSStream *This = (PyDSStream *)self;
+    if (!PyArg_ParseTuple(args, ":GetRegion"))
+        return NULL;
+    ULONG pos, cb;
+    if (This->m_pPlay) {
+        pos = This->m_head % This->m_ringBytes;
+        cb = This->RingWritable();
+    }
+    else {
+        pos = This->m_tail % This->m_ringBytes;
+        cb = This->RingReadable();
+    }
+    return Py_BuildValue("kk", pos, min(cb, This->m_ringBytes - pos));
+}
+
+// @pymethod |PyDSStream|Advance|Commits bytes of the region returned by <om PyDSStream.GetRegion>.
+PyObject *PyDSStream::Advance(PyObject *self, PyObject *args)
+{
+    PyDSStream *This = (PyDSStream *)self;
+    ULONG cb;
+    // @pyparm int|size||The number of bytes written to (for playback) or processed (for capture)
+    if (!PyArg_ParseTuple(args, "k:Advance", &cb))
+        return NULL;
+    ULONG pos = This->m_pPlay ? This->m_head % This->m_ringBytes : This->m_tail % This->m_ringBytes;
+    ULONG avail = This->m_pPlay ? This->RingWritable() : This->RingReadable();
+    if (cb > avail || cb > This->m_ringBytes - pos) {
+        PyErr_SetString(PyExc_ValueError, "size is larger than the region");
+        return NULL;
+    }
+    MemoryBarrier();
+    if (This->m_pPlay)
+        This->m_head += cb;
+    else
+        This->m_tail += cb;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+int PyDSStream::getbufferinfo(PyObject *self, Py_buffer *view, int flags)
+{
+    PyDSStream *This = (PyDSStream *)self;
+    return PyBuffer_FillInfo(view, self, This->m_ring, This->m_ringBytes, 0, flags);
+}
+
+PyObject *PyDSStream::get_Readable(PyObject *self, void *unused)
+{
+    return PyLong_FromUnsignedLong(((PyDSStream *)self)->RingReadable());
+}
+
+PyObject *PyDSStream::get_Writable(PyObject *self, void *unused)
+{
+    return PyLong_FromUnsignedLong(((PyDSStream *)self)->RingWritable());
+}
+
+PyObject *PyDSStream::get_Running(PyObject *self, void *unused)
+{
+    return PyBool_FromLong(((PyDSStream *)self)->m_thread != NULL);
+}
+
+PyObject *PyDSStream::get_DataEvent(PyObject *self, void *unused)
+{
+    return PyWinLong_FromHANDLE(((PyDSStream *)self)->m_dataEvent);
+}
+
+// @object PyDSStream|Streams audio between a DirectSound buffer and a ring buffer, using a worker thread.
+// @comm Created by <om directsound.CreateStream>.  The worker thread wakes on DirectSound position
+// notifications, and moves audio between the DirectSound buffer and the ring, which Python reads or
+// writes with <om PyDSStream.Write>, <om PyDSStream.Read> or <om PyDSStream.ReadInto>.  The ring is
+// lock-free, so the worker thread never waits for the Python lock.
+// @comm The object also supports the buffer interface, exposing the ring's memory.  Together with
+// <om PyDSStream.GetRegion> and <om PyDSStream.Advance> this lets audio be produced or consumed in place,
+// for example with numpy.frombuffer.
+// @comm For playback, if the ring runs dry silence is played and Underruns is incremented.  For capture,
+// if the ring is full audio is discarded and Overruns is incremented.
+struct PyMethodDef PyDSStream::methods[] = {
+    {"Start", PyDSStream::Start, 1},          // @pymeth Start|Starts the DirectSound buffer and the worker thread.
+    {"Stop", PyDSStream::Stop, 1},            // @pymeth Stop|Stops the DirectSound buffer and the worker thread.
+    {"Write", PyDSStream::Write, 1},          // @pymeth Write|Queues audio for playback.
+    {"Read", PyDSStream::Read, 1},            // @pymeth Read|Reads captured audio.
+    {"ReadInto", PyDSStream::ReadInto, 1},    // @pymeth ReadInto|Reads captured audio into a writable buffer.
+    {"GetRegion", PyDSStream::GetRegion, 1},  // @pymeth GetRegion|Returns the part of the ring Python can access
+                                              // without copying.
+    {"Advance", PyDSStream::Advance, 1},      // @pymeth Advance|Commits bytes of the region returned by GetRegion.
+    {NULL}};
+
+#define OFF(e) offsetof(PyDSStream, e)
+
+struct PyMemberDef PyDSStream::members[] = {
+    // @prop int|Underruns|Number of times playback ran out of queued audio
+    {"Underruns", T_LONG, OFF(m_underruns), READONLY},
+    // @prop int|Overruns|Number of times captured audio was discarded because the ring was full
+    {"Overruns", T_LONG, OFF(m_overruns), READONLY},
+    // @prop int|RingBytes|The size of the ring
+    {"RingBytes", T_ULONG, OFF(m_ringBytes), READONLY},
+    {NULL}};
+
+PyGetSetDef PyDSStream::getset[] = {
+    // @prop int|Readable|Bytes in the ring waiting to be played or read
+    {"Readable", PyDSStream::get_Readable, NULL},
+    // @prop int|Writable|Free space in the ring
+    {"Writable", PyDSStream::get_Writable, NULL},
+    // @prop bool|Running|True if the stream has been started
+    {"Running", PyDSStream::get_Running, NULL},
+    // @prop int|DataEvent|Handle to an event set each time the worker thread moves audio, which can be
+    // used with win32event.WaitForMultipleObjects.  The handle is owned by the stream.
+    {"DataEvent", PyDSStream::get_DataEvent, NULL},
+    {NULL}};
+
+static PyBufferProcs PyDSStream_as_buffer = {
+    PyDSStream::getbufferinfo,
+    NULL,
+};
+
+PyTypeObject PyDSStreamType = {
+    PYWIN_OBJECT_HEAD "PyDSStream",
+    sizeof(PyDSStream),
+    0,
+    PyDSStream::deallocFunc,
+    0,  // tp_print;
+    0,  // tp_getattr
+    0,  // tp_setattr
+    0,  // tp_compare
+    0,  // tp_repr
+    0,  // tp_as_number
+    0,  // tp_as_sequence
+    0,  // tp_as_mapping
+    0,
+    0, /* tp_call */
+    0, /* tp_str */
+    PyObject_GenericGetAttr,
+    0,
+    &PyDSStream_as_buffer,  // tp_as_buffer;
+    Py_TPFLAGS_DEFAULT,     // tp_flags;
+    0,                      // tp_doc; /* Documentation string */
+    0,                      // traverseproc tp_traverse;
+    0,                      // tp_clear;
+    0,                      // tp_richcompare;
+    0,                      // tp_weaklistoffset;
+    0,                      // tp_iter
+    0,                      // iternextfunc tp_iternext
+    PyDSStream::methods,
+    PyDSStream::members,
+    PyDSStream::getset,  // tp_getset;
+};
+
+// @pymethod <o PyDSStream>|directsound|CreateStream|Creates a streaming object for a playback or capture buffer.
+PyObject *PyWinMethod_NewDSStream(PyObject *self, PyObject *args)
+{
+    PyObject *obBuffer;
+    DWORD periods = 4;
+    ULONG ringBytes = 0;
+    // @pyparm <o PyIDirectSoundBuffer>\|<o PyIDirectSoundCaptureBuffer>|buffer||The buffer to stream.  It should be
+    // created with DSBCAPS_CTRLPOSITIONNOTIFY (for playback) or support <o PyIDirectSoundNotify>, otherwise the
+    // worker thread polls once per period.  The buffer must be stopped.
+    // @pyparm int|ringBytes|0|Size of the ring.  The default is twice the size of the DirectSound buffer.
+    // @pyparm int|periods|4|Number of notification positions in the DirectSound buffer.
+    if (!PyArg_ParseTuple(args, "O|kk:CreateStream", &obBuffer, &ringBytes, &periods))
+        return NULL;
+    if (periods < 1 || periods > 64) {
+        PyErr_SetString(PyExc_ValueError, "periods must be between 1 and 64");
+        return NULL;
+    }
+    IDirectSoundBuffer *pPlay = NULL;
+    IDirectSoundCaptureBuffer *pCapture = NULL;
+    if (!PyCom_InterfaceFromPyObject(obBuffer, IID_IDirectSoundBuffer, (void **)&pPlay, FALSE)) {
+        PyErr_Clear();
+        if (!PyCom_InterfaceFromPyObject(obBuffer, IID_IDirectSoundCaptureBuffer, (void **)&pCapture, FALSE)) {
+            PyErr_Clear();
+            PyErr_SetString(PyExc_TypeError, "buffer must be a PyIDirectSoundBuffer or PyIDirectSoundCaptureBuffer");
+            return NULL;
+        }
+    }
+    // Room for a WAVEFORMATEXTENSIBLE.
+    BYTE wfxbuf[64];
+    WAVEFORMATEX *pwfx = (WAVEFORMATEX *)wfxbuf;
+    DWORD dsBytes = 0;
+    HRESULT hr;
+    Py_BEGIN_ALLOW_THREADS;
+    if (pPlay) {
+        DSBCAPS caps = {sizeof(caps)};
+        hr = pPlay->GetCaps(&caps);
+        dsBytes = caps.dwBufferBytes;
+        if (SUCCEEDED(hr))
+            hr = pPlay->GetFormat(pwfx, sizeof(wfxbuf), NULL);
+    }
+    else {
+        DSCBCAPS caps = {sizeof(caps)};
+        hr = pCapture->GetCaps(&caps);
+        dsBytes = caps.dwBufferBytes;
+        if (SUCCEEDED(hr))
+            hr = pCapture->GetFormat(pwfx, sizeof(wfxbuf), NULL);
+    }
+    Py_END_ALLOW_THREADS;
+    if (SUCCEEDED(hr) && dsBytes / periods < pwfx->nBlockAlign)
+        hr = E_INVALIDARG;
+    if (FAILED(hr)) {
+        if (pPlay)
+            pPlay->Release();
+        if (pCapture)
+            pCapture->Release();
+        return PyCom_BuildPyException(hr);
+    }
+    if (ringBytes == 0)
+        ringBytes = dsBytes * 2;
+    PyDSStream *ret = new PyDSStream(pPlay, pCapture, dsBytes, *pwfx, ringBytes);
+    if (ret->m_ring == NULL || ret->m_stopEvent == NULL || ret->m_dataEvent == NULL) {
+        Py_DECREF(ret);
+        return PyErr_NoMemory();
+    }
+    Py_BEGIN_ALLOW_THREADS;
+    hr = ret->SetupNotify(periods, pwfx->nAvgBytesPerSec);
+    Py_END_ALLOW_THREADS;
+    if (FAILED(hr)) {
+        Py_DECREF(ret);
+        return PyCom_BuildPyException(hr);
+    }
+    return ret;
+}
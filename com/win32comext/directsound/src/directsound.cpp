@@ -233,6 +233,8 @@ static struct PyMethodDef directsound_methods[] = {
     {"DSBUFFERDESC", PyWinMethod_NewDSBUFFERDESC, 1},  // @pymeth DSBUFFERDESC|Creates a new <o PyDSBUFFERDESC> object.
     {"DSCBUFFERDESC", PyWinMethod_NewDSCBUFFERDESC,
      1},  // @pymeth DSCBUFFERDESC|Creates a new <o PyDSCBUFFERDESC> object.
+    {"CreateStream", PyWinMethod_NewDSStream,
+     1},  // @pymeth CreateStream|Creates a <o PyDSStream> for a playback or capture buffer.
     {NULL, NULL},
 };
 
@@ -450,12 +452,14 @@ PYWIN_MODULE_INIT_FUNC(directsound)
     if (PyType_Ready(&PyDSCAPSType) == -1 || PyType_Ready(&PyDSBCAPSType) == -1 ||
         PyType_Ready(&PyDSBUFFERDESCType) == -1 || PyType_Ready(&PyDSCCAPSType) == -1 ||
         PyType_Ready(&PyDSCBCAPSType) == -1 || PyType_Ready(&PyDSCBUFFERDESCType) == -1 ||
+        PyType_Ready(&PyDSStreamType) == -1 ||
         PyDict_SetItemString(dict, "DSCAPSType", (PyObject *)&PyDSCAPSType) == -1 ||
         PyDict_SetItemString(dict, "DSBCAPSType", (PyObject *)&PyDSBCAPSType) == -1 ||
         PyDict_SetItemString(dict, "DSBUFFERDESCType", (PyObject *)&PyDSBUFFERDESCType) == -1 ||
         PyDict_SetItemString(dict, "DSCCAPSType", (PyObject *)&PyDSCCAPSType) == -1 ||
         PyDict_SetItemString(dict, "DSCBCAPSType", (PyObject *)&PyDSCBCAPSType) == -1 ||
-        PyDict_SetItemString(dict, "DSCBUFFERDESCType", (PyObject *)&PyDSCBUFFERDESCType) == -1)
+        PyDict_SetItemString(dict, "DSCBUFFERDESCType", (PyObject *)&PyDSCBUFFERDESCType) == -1 ||
+        PyDict_SetItemString(dict, "DSStreamType", (PyObject *)&PyDSStreamType) == -1)
         PYWIN_MODULE_INIT_RETURN_ERROR;
 
     PYWIN_MODULE_INIT_RETURN_SUCCESS;
@@ -63,6 +63,14 @@ BOOL PyWinObject_AsDSCBCAPS(PyObject *ob, DSCBCAPS **ppDSCBCAPS, BOOL bNoneOK =
 extern PyTypeObject PyDSCBCAPSType;
 #define PyDSCBCAPS_Check(ob) ((ob)->ob_type == &PyDSCBCAPSType)
 
+/*
+** DSStream support
+*/
+
+PyObject *PyWinMethod_NewDSStream(PyObject *self, PyObject *args);
+extern PyTypeObject PyDSStreamType;
+#define PyDSStream_Check(ob) ((ob)->ob_type == &PyDSStreamType)
+
 class PyDSBUFFERDESC : public PyObject {
    public:
     PyDSBUFFERDESC(void);
@@ -192,3 +200,65 @@ class PyDSBCAPS : public PyObject {
 #endif  // _MSC_VER
     DSBCAPS m_caps;
 };
+
+class PyDSStream : public PyObject {
+   public:
+    PyDSStream(IDirectSoundBuffer *pPlay, IDirectSoundCaptureBuffer *pCapture, DWORD dsBytes,
+               const WAVEFORMATEX &wfx, ULONG ringBytes);
+    ~PyDSStream();
+
+    HRESULT SetupNotify(DWORD periods, DWORD avgBytesPerSec);
+    HRESULT StartStream();
+    void StopStream();
+    void Pump(BOOL bPrefill);
+    ULONG RingReadable();
+    ULONG RingWritable();
+    void RingPut(const BYTE *p, ULONG cb);
+    void RingGet(BYTE *p, ULONG cb);
+    BOOL FillPart(BYTE *p, DWORD cb);
+    BOOL DrainPart(const BYTE *p, DWORD cb);
+    static DWORD WINAPI ThreadProc(LPVOID arg);
+
+    /* Python support */
+    static void deallocFunc(PyObject *ob);
+    static int getbufferinfo(PyObject *self, Py_buffer *view, int flags);
+    static PyObject *Start(PyObject *self, PyObject *args);
+    static PyObject *Stop(PyObject *self, PyObject *args);
+    static PyObject *Write(PyObject *self, PyObject *args);
+    static PyObject *Read(PyObject *self, PyObject *args);
+    static PyObject *ReadInto(PyObject *self, PyObject *args);
+    static PyObject *GetRegion(PyObject *self, PyObject *args);
+    static PyObject *Advance(PyObject *self, PyObject *args);
+    static PyObject *get_Readable(PyObject *self, void *unused);
+    static PyObject *get_Writable(PyObject *self, void *unused);
+    static PyObject *get_Running(PyObject *self, void *unused);
+    static PyObject *get_DataEvent(PyObject *self, void *unused);
+
+#ifdef _MSC_VER
+#pragma warning(disable : 4251)
+#endif  // _MSC_VER
+    static struct PyMethodDef methods[];
+    static struct PyMemberDef members[];
+    static PyGetSetDef getset[];
+#ifdef _MSC_VER
+#pragma warning(default : 4251)
+#endif  // _MSC_VER
+    // Exactly one of these is set.
+    IDirectSoundBuffer *m_pPlay;
+    IDirectSoundCaptureBuffer *m_pCapture;
+    DWORD m_dsBytes;
+    DWORD m_dsPos;  // Next offset in the DirectSound buffer to be filled or read.
+    DWORD m_blockAlign;
+    DWORD m_periodMs;
+    BYTE m_silence;
+    BYTE *m_ring;
+    ULONG m_ringBytes;
+    volatile ULONG m_head;
+    volatile ULONG m_tail;
+    volatile LONG m_underruns;
+    volatile LONG m_overruns;
+    HANDLE m_notifyEvent;
+    HANDLE m_stopEvent;
+    HANDLE m_dataEvent;
+    HANDLE m_thread;
+};
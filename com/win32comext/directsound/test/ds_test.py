@@ -365,5 +365,37 @@ class DirectSoundCaptureTest(unittest.TestCase):
         f.write(data)
         f.close()
 
+    def testStream(self):
+        try:
+            d = ds.DirectSoundCaptureCreate(None, None)
+        except pythoncom.com_error as exc:
+            if exc.hresult != ds.DSERR_NODRIVER:
+                raise
+            raise TestSkipped(exc)
+
+        sdesc = ds.DSCBUFFERDESC()
+        sdesc.dwBufferBytes = 17640 # 100ms
+        sdesc.lpwfxFormat = pywintypes.WAVEFORMATEX()
+        sdesc.lpwfxFormat.wFormatTag = pywintypes.WAVE_FORMAT_PCM
+        sdesc.lpwfxFormat.nChannels = 2
+        sdesc.lpwfxFormat.nSamplesPerSec = 44100
+        sdesc.lpwfxFormat.nAvgBytesPerSec = 176400
+        sdesc.lpwfxFormat.nBlockAlign = 4
+        sdesc.lpwfxFormat.wBitsPerSample = 16
+
+        buffer = d.CreateCaptureBuffer(sdesc)
+        stream = ds.CreateStream(buffer, 176400)
+        self.assertEqual(stream.RingBytes, 176400)
+        self.assertEqual(len(memoryview(stream)), 176400)
+        self.assertRaises(TypeError, stream.Write, b"\0" * 4)
+
+        stream.Start()
+        self.assertTrue(stream.Running)
+        # half a second, so the ring wraps around the DirectSound buffer
+        data = stream.Read(88200, 2000)
+        stream.Stop()
+        self.assertEqual(len(data), 88200)
+        self.assertEqual(stream.Overruns, 0)
+
 if __name__ == '__main__':
     unittest.main()
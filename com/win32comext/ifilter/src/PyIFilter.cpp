@@ -238,6 +238,361 @@ static PyObject *pyBindIFilterFromStream(PyObject *self, PyObject *args)
     return ret;
 }
 
+// Bulk extraction support.  Everything is collected into these structures
+// without the Python lock, and converted to Python objects afterwards.
+struct FILTER_CHUNK {
+    STAT_CHUNK stat;     // attribute.psProperty.lpwstr is a copy owned by us
+    ULONG start, len;    // Position of the chunk's text in FILTER_EXTRACT.text
+};
+
+struct FILTER_VALUE {
+    FULLPROPSPEC attribute;  // psProperty.lpwstr is a copy owned by us
+    PROPVARIANT *value;
+};
+
+struct FILTER_EXTRACT {
+    WCHAR *text;
+    ULONG text_len, text_size;
+    FILTER_CHUNK *chunks;
+    ULONG chunk_cnt, chunk_size;
+    FILTER_VALUE *values;
+    ULONG value_cnt, value_size;
+};
+
+// Grows an array so at least one more element of elsize fits.
+static BOOL GrowFilterArray(void **parray, ULONG *psize, ULONG cnt, size_t elsize, ULONG initial)
+{
+    if (cnt < *psize)
+        return TRUE;
+    ULONG newsize = *psize ? *psize * 2 : initial;
+    void *p = realloc(*parray, newsize * elsize);
+    if (p == NULL)
+        return FALSE;
+    *parray = p;
+    *psize = newsize;
+    return TRUE;
+}
+
+static BOOL CopyFULLPROPSPEC(const FULLPROPSPEC *src, FULLPROPSPEC *dst)
+{
+    *dst = *src;
+    if (src->psProperty.ulKind == PRSPEC_LPWSTR) {
+        dst->psProperty.lpwstr = _wcsdup(src->psProperty.lpwstr);
+        if (dst->psProperty.lpwstr == NULL)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static void FreeFilterExtract(FILTER_EXTRACT *fe)
+{
+    ULONG i;
+    for (i = 0; i < fe->chunk_cnt; i++)
+        if (fe->chunks[i].stat.attribute.psProperty.ulKind == PRSPEC_LPWSTR)
+            free(fe->chunks[i].stat.attribute.psProperty.lpwstr);
+    for (i = 0; i < fe->value_cnt; i++) {
+        if (fe->values[i].attribute.psProperty.ulKind == PRSPEC_LPWSTR)
+            free(fe->values[i].attribute.psProperty.lpwstr);
+        PropVariantClear(fe->values[i].value);
+        CoTaskMemFree(fe->values[i].value);
+    }
+    free(fe->text);
+    free(fe->chunks);
+    free(fe->values);
+    ZeroMemory(fe, sizeof(*fe));
+}
+
+// Pulls all chunks, text and values from an initialized filter.  Called without the Python lock.
+static HRESULT ExtractFromFilter(IFilter *pIF, FILTER_EXTRACT *fe)
+{
+    const ULONG text_block = 8192;
+    HRESULT hr;
+    STAT_CHUNK stat;
+    for (;;) {
+        hr = pIF->GetChunk(&stat);
+        if (hr == FILTER_E_END_OF_CHUNKS)
+            return S_OK;
+        if (hr == FILTER_E_EMBEDDING_UNAVAILABLE || hr == FILTER_E_LINK_UNAVAILABLE)
+            continue;
+        if (FAILED(hr))
+            return hr;
+        if (!GrowFilterArray((void **)&fe->chunks, &fe->chunk_size, fe->chunk_cnt, sizeof(FILTER_CHUNK), 64))
+            return E_OUTOFMEMORY;
+        FILTER_CHUNK *chunk = &fe->chunks[fe->chunk_cnt];
+        chunk->stat = stat;
+        if (!CopyFULLPROPSPEC(&stat.attribute, &chunk->stat.attribute))
+            return E_OUTOFMEMORY;
+        fe->chunk_cnt++;
+        chunk->start = fe->text_len;
+        chunk->len = 0;
+
+        if (stat.flags & CHUNK_TEXT) {
+            for (;;) {
+                // Text is read straight into the end of the combined buffer
+                if (fe->text_size - fe->text_len < text_block) {
+                    ULONG newsize = fe->text_size ? fe->text_size * 2 : text_block * 8;
+                    while (newsize - fe->text_len < text_block) newsize *= 2;
+                    WCHAR *p = (WCHAR *)realloc(fe->text, newsize * sizeof(WCHAR));
+                    if (p == NULL)
+                        return E_OUTOFMEMORY;
+                    fe->text = p;
+                    fe->text_size = newsize;
+                }
+                ULONG cwc = text_block;
+                hr = pIF->GetText(&cwc, fe->text + fe->text_len);
+                if (hr == FILTER_E_NO_MORE_TEXT || hr == FILTER_E_NO_TEXT)
+                    break;
+                if (FAILED(hr))
+                    return hr;
+                fe->text_len += cwc;
+                chunk->len += cwc;
+                if (hr == FILTER_S_LAST_TEXT)
+                    break;
+            }
+        }
+        if (stat.flags & CHUNK_VALUE) {
+            for (;;) {
+                PROPVARIANT *value = NULL;
+                hr = pIF->GetValue(&value);
+                if (hr == FILTER_E_NO_MORE_VALUES || hr == FILTER_E_NO_VALUES)
+                    break;
+                if (FAILED(hr))
+                    return hr;
+                if (value == NULL)
+                    continue;
+                if (!GrowFilterArray((void **)&fe->values, &fe->value_size, fe->value_cnt, sizeof(FILTER_VALUE), 16) ||
+                    !CopyFULLPROPSPEC(&stat.attribute, &fe->values[fe->value_cnt].attribute)) {
+                    PropVariantClear(value);
+                    CoTaskMemFree(value);
+                    return E_OUTOFMEMORY;
+                }
+                fe->values[fe->value_cnt++].value = value;
+            }
+        }
+    }
+}
+
+static PyObject *PyObject_FromFULLPROPSPEC(const FULLPROPSPEC *spec)
+{
+    PyObject *obProp;
+    if (spec->psProperty.ulKind == PRSPEC_LPWSTR)
+        obProp = PyWinObject_FromWCHAR(spec->psProperty.lpwstr);
+    else
+        obProp = PyInt_FromLong(spec->psProperty.propid);
+    return Py_BuildValue("NN", PyWinObject_FromIID(spec->guidPropSet), obProp);
+}
+
+// Builds the dict returned by ExtractAll.  Frees the extract whether or not it succeeds.
+static PyObject *PyObject_FromFilterExtract(FILTER_EXTRACT *fe)
+{
+    PyObject *chunks = NULL, *values = NULL, *ret = NULL;
+    ULONG i;
+    chunks = PyList_New(fe->chunk_cnt);
+    if (chunks == NULL)
+        goto done;
+    for (i = 0; i < fe->chunk_cnt; i++) {
+        STAT_CHUNK *stat = &fe->chunks[i].stat;
+        PyObject *item = Py_BuildValue("iiiiNiiikk", stat->idChunk, stat->breakType, stat->flags, stat->locale,
+                                       PyObject_FromFULLPROPSPEC(&stat->attribute), stat->idChunkSource,
+                                       stat->cwcStartSource, stat->cwcLenSource, fe->chunks[i].start, fe->chunks[i].len);
+        if (item == NULL)
+            goto done;
+        PyList_SET_ITEM(chunks, i, item);
+    }
+    values = PyList_New(fe->value_cnt);
+    if (values == NULL)
+        goto done;
+    for (i = 0; i < fe->value_cnt; i++) {
+        PyObject *item = Py_BuildValue("NN", PyObject_FromFULLPROPSPEC(&fe->values[i].attribute),
+                                       PyObject_FromPROPVARIANT(fe->values[i].value));
+        if (item == NULL)
+            goto done;
+        PyList_SET_ITEM(values, i, item);
+    }
+    ret = Py_BuildValue("{s:N,s:O,s:O}", "Text", PyWinObject_FromWCHAR(fe->text ? fe->text : L"", fe->text_len),
+                        "Chunks", chunks, "Values", values);
+done:
+    Py_XDECREF(chunks);
+    Py_XDECREF(values);
+    FreeFilterExtract(fe);
+    return ret;
+}
+
+#define DEFAULT_EXTRACT_INIT_FLAGS                                                                          \
+    (IFILTER_INIT_CANON_PARAGRAPHS | IFILTER_INIT_HARD_LINE_BREAKS | IFILTER_INIT_APPLY_INDEX_ATTRIBUTES | \
+     IFILTER_INIT_APPLY_OTHER_ATTRIBUTES)
+
+// @pymethod dict|ifilter|ExtractAll|Extracts all text and property values from a filter in one call
+// @rdesc Returns a dict with keys:
+// @flagh Key|Value
+// @flag Text|A single string containing the text of all chunks, concatenated
+// @flag Chunks|List of tuples in the same form returned by <om PyIFilter.GetChunk>, with two extra items giving
+// the offset and length of the chunk's text within Text, in UTF-16 code units.
+// @flag Values|List of (attribute, value) tuples for the property values of all value chunks
+// @comm The chunk loop runs without the Python lock, reading text directly into one growing buffer, so
+// it is much faster than calling GetChunk/GetText/GetValue from Python.  Embedded objects and links that
+// can't be opened are skipped, as they are by the indexer.
+static PyObject *pyExtractAll(PyObject *self, PyObject *args)
+{
+    PyObject *obFilter, *obFlags = Py_None;
+    // @pyparm <o PyIFilter>|filter||The filter to read
+    // @pyparm int|flags|None|IFILTER_INIT_* flags to initialize the filter with, or None if <om PyIFilter.Init>
+    // has already been called
+    if (!PyArg_ParseTuple(args, "O|O:ExtractAll", &obFilter, &obFlags))
+        return NULL;
+    ULONG grfFlags = 0;
+    if (obFlags != Py_None) {
+        grfFlags = PyLong_AsUnsignedLong(obFlags);
+        if (grfFlags == (ULONG)-1 && PyErr_Occurred())
+            return NULL;
+    }
+    IFilter *pIF;
+    if (!PyCom_InterfaceFromPyObject(obFilter, IID_IFilter, (void **)&pIF, FALSE))
+        return NULL;
+
+    FILTER_EXTRACT fe;
+    ZeroMemory(&fe, sizeof(fe));
+    HRESULT hr = S_OK;
+    Py_BEGIN_ALLOW_THREADS;
+    if (obFlags != Py_None) {
+        ULONG flags;
+        hr = pIF->Init(grfFlags, 0, NULL, &flags);
+    }
+    if (SUCCEEDED(hr))
+        hr = ExtractFromFilter(pIF, &fe);
+    Py_END_ALLOW_THREADS;
+    if (FAILED(hr)) {
+        FreeFilterExtract(&fe);
+        PyObject *ret = PyCom_BuildPyException(hr, pIF, IID_IFilter);
+        pIF->Release();
+        return ret;
+    }
+    pIF->Release();
+    return PyObject_FromFilterExtract(&fe);
+}
+
+struct FILTER_FILE_WORK {
+    WCHAR **paths;
+    FILTER_EXTRACT *results;
+    HRESULT *hrs;
+    LONG cnt;
+    LONG next;
+    ULONG grfFlags;
+};
+
+static DWORD WINAPI ExtractFilesThread(LPVOID arg)
+{
+    FILTER_FILE_WORK *work = (FILTER_FILE_WORK *)arg;
+    HRESULT hrinit = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+    LONG i;
+    while ((i = InterlockedIncrement(&work->next) - 1) < work->cnt) {
+        if (FAILED(hrinit)) {
+            work->hrs[i] = hrinit;
+            continue;
+        }
+        IFilter *pIF = NULL;
+        HRESULT hr = LoadIFilter(work->paths[i], NULL, (void **)&pIF);
+        if (SUCCEEDED(hr)) {
+            ULONG flags;
+            hr = pIF->Init(work->grfFlags, 0, NULL, &flags);
+            if (SUCCEEDED(hr))
+                hr = ExtractFromFilter(pIF, &work->results[i]);
+            pIF->Release();
+        }
+        work->hrs[i] = hr;
+    }
+    if (SUCCEEDED(hrinit))
+        CoUninitialize();
+    return 0;
+}
+
+// @pymethod [(int, dict),...]|ifilter|ExtractFiles|Extracts text and property values from many files in parallel
+// @rdesc Returns a list with an (hresult, result) tuple for each path, in the same order.  result is a dict
+// as returned by <om ifilter.ExtractAll>, or None if the file could not be filtered.
+// @comm Each file is loaded with LoadIFilter and read on one of a pool of worker threads, which join the
+// multi-threaded apartment.  No Python lock is held until all files are done.
+static PyObject *pyExtractFiles(PyObject *self, PyObject *args)
+{
+    PyObject *obPaths, *ret = NULL;
+    ULONG grfFlags = DEFAULT_EXTRACT_INIT_FLAGS;
+    DWORD max_threads = 4;
+    // @pyparm [<o PyUnicode>,...]|paths||Files to filter
+    // @pyparm int|flags|IFILTER_INIT_CANON_PARAGRAPHS \| IFILTER_INIT_HARD_LINE_BREAKS \|
+    // IFILTER_INIT_APPLY_INDEX_ATTRIBUTES \| IFILTER_INIT_APPLY_OTHER_ATTRIBUTES|Flags passed to <om PyIFilter.Init>
+    // @pyparm int|maxThreads|4|Number of worker threads, at most 64
+    if (!PyArg_ParseTuple(args, "O|kk:ExtractFiles", &obPaths, &grfFlags, &max_threads))
+        return NULL;
+    if (max_threads < 1 || max_threads > MAXIMUM_WAIT_OBJECTS)
+        return PyErr_Format(PyExc_ValueError, "maxThreads must be between 1 and %d", MAXIMUM_WAIT_OBJECTS);
+    PyObject *paths_seq = PySequence_Fast(obPaths, "paths must be a sequence of strings");
+    if (paths_seq == NULL)
+        return NULL;
+    FILTER_FILE_WORK work;
+    ZeroMemory(&work, sizeof(work));
+    work.cnt = (LONG)PySequence_Fast_GET_SIZE(paths_seq);
+    work.grfFlags = grfFlags;
+    LONG i;
+    HANDLE threads[MAXIMUM_WAIT_OBJECTS];
+    DWORD thread_cnt = 0;
+    work.paths = (WCHAR **)calloc(work.cnt + 1, sizeof(WCHAR *));
+    work.results = (FILTER_EXTRACT *)calloc(work.cnt + 1, sizeof(FILTER_EXTRACT));
+    work.hrs = (HRESULT *)calloc(work.cnt + 1, sizeof(HRESULT));
+    if (work.paths == NULL || work.results == NULL || work.hrs == NULL) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    for (i = 0; i < work.cnt; i++)
+        if (!PyWinObject_AsWCHAR(PySequence_Fast_GET_ITEM(paths_seq, i), &work.paths[i], FALSE))
+            goto done;
+
+    Py_BEGIN_ALLOW_THREADS;
+    if (max_threads > (DWORD)work.cnt)
+        max_threads = work.cnt;
+    for (; thread_cnt < max_threads; thread_cnt++) {
+        threads[thread_cnt] = CreateThread(NULL, 0, ExtractFilesThread, &work, 0, NULL);
+        if (threads[thread_cnt] == NULL)
+            break;
+    }
+    if (thread_cnt) {
+        WaitForMultipleObjects(thread_cnt, threads, TRUE, INFINITE);
+        for (DWORD t = 0; t < thread_cnt; t++) CloseHandle(threads[t]);
+    }
+    else
+        // Couldn't start any threads - do the work here.
+        ExtractFilesThread(&work);
+    Py_END_ALLOW_THREADS;
+
+    ret = PyList_New(work.cnt);
+    if (ret == NULL)
+        goto done;
+    for (i = 0; i < work.cnt; i++) {
+        PyObject *obresult;
+        if (SUCCEEDED(work.hrs[i]))
+            obresult = PyObject_FromFilterExtract(&work.results[i]);
+        else {
+            FreeFilterExtract(&work.results[i]);
+            Py_INCREF(Py_None);
+            obresult = Py_None;
+        }
+        PyObject *item = obresult ? Py_BuildValue("lN", work.hrs[i], obresult) : NULL;
+        if (item == NULL) {
+            Py_CLEAR(ret);
+            goto done;
+        }
+        PyList_SET_ITEM(ret, i, item);
+    }
+done:
+    if (work.results)
+        for (i = 0; i < work.cnt; i++) FreeFilterExtract(&work.results[i]);
+    if (work.paths)
+        for (i = 0; i < work.cnt; i++) PyWinObject_FreeWCHAR(work.paths[i]);
+    free(work.paths);
+    free(work.results);
+    free(work.hrs);
+    Py_DECREF(paths_seq);
+    return ret;
+}
+
 static int AddConstant(PyObject *dict, const char *key, long value)
 {
     PyObject *oval = PyInt_FromLong(value);
@@ -280,6 +635,8 @@ static struct PyMethodDef ifilter_functions[] = {
     {"LoadIFilter", pyLoadIFilter, 1},                        // @pymeth Init|Description of Init
     {"BindIFilterFromStorage", pyBindIFilterFromStorage, 1},  // @pymeth BindIFilterFromStorage|
     {"BindIFilterFromStream", pyBindIFilterFromStream, 1},    // @pymeth BindIFilterFromStream|
+    {"ExtractAll", pyExtractAll, 1},      // @pymeth ExtractAll|Extracts all text and property values from a filter
+    {"ExtractFiles", pyExtractFiles, 1},  // @pymeth ExtractFiles|Extracts text and property values from many files
     {NULL}};
 
 static const PyCom_InterfaceSupportInfo g_interfaceSupportData[] = {
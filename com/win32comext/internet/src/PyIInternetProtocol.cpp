@@ -19,30 +19,51 @@ PyIInternetProtocol::~PyIInternetProtocol() {}
     return (IInternetProtocol *)PyIInternetProtocolRoot::GetI(self);
 }
 
-// @pymethod |PyIInternetProtocol|Read|Description of Read.
+// @pymethod string/int|PyIInternetProtocol|Read|Reads data from the protocol.
+// @rdesc If cb is an integer, the result is a string of at most cb bytes.  If a
+// writable buffer is passed, the data is read directly into it and the number of
+// bytes read is returned.
 PyObject *PyIInternetProtocol::Read(PyObject *self, PyObject *args)
 {
     IInternetProtocol *pIIP = GetI(self);
     if (pIIP == NULL)
         return NULL;
-    // @pyparm int|cb||Description for cb
+    // @pyparm int/buffer|cb||The number of bytes to read, or a writable buffer to read into.
+    PyObject *obcb;
     ULONG cb;
-    ULONG pcbRead;
-    if (!PyArg_ParseTuple(args, "i:Read", &cb))
+    ULONG pcbRead = 0;
+    if (!PyArg_ParseTuple(args, "O:Read", &obcb))
         return NULL;
     HRESULT hr;
-    void *pv = malloc(cb);
+    if (!PyInt_Check(obcb) && !PyLong_Check(obcb)) {
+        PyWinBufferView pybuf(obcb, true);
+        if (!pybuf.ok())
+            return NULL;
+        PY_INTERFACE_PRECALL;
+        hr = pIIP->Read(pybuf.ptr(), pybuf.len(), &pcbRead);
+        PY_INTERFACE_POSTCALL;
+        if (FAILED(hr))
+            return OleSetOleError(hr);
+        return PyLong_FromUnsignedLong(pcbRead);
+    }
+    cb = PyLong_AsUnsignedLong(obcb);
+    if (cb == (ULONG)-1 && PyErr_Occurred())
+        return NULL;
+    // Read straight into the result string, so the data is only copied once.
+    PyObject *pyretval = PyString_FromStringAndSize(NULL, cb);
+    if (pyretval == NULL)
+        return NULL;
+    char *pv = PyString_AS_STRING(pyretval);
     PY_INTERFACE_PRECALL;
     hr = pIIP->Read(pv, cb, &pcbRead);
     PY_INTERFACE_POSTCALL;
 
     if (FAILED(hr)) {
-        free(pv);
+        Py_DECREF(pyretval);
         return OleSetOleError(hr);
     }
-
-    PyObject *pyretval = PyString_FromStringAndSize((char *)pv, pcbRead);
-    free(pv);
+    if (pcbRead != cb && _PyString_Resize(&pyretval, pcbRead) == -1)
+        return NULL;
     return pyretval;
 }
 
@@ -171,16 +192,17 @@ STDMETHODIMP PyGInternetProtocol::Read(
     HRESULT hr = InvokeViaPolicy("Read", &result, "l", cb);
     if (FAILED(hr))
         return hr;
-    // Process the Python results, and convert back to the real params
-    if (!PyString_Check(result)) {
-        PyErr_SetString(PyExc_TypeError, "IInternetProtocol::Read must return a string object");
+    // Process the Python results, and convert back to the real params.  Any
+    // object supporting the buffer interface is accepted.
+    PyWinBufferView pybuf(result);
+    if (!pybuf.ok())
         hr = PyCom_HandlePythonFailureToCOM();
-    }
     else {
-        char *buf = PyString_AsString(result);
-        *pcbRead = min(cb, (ULONG)PyString_Size(result));
-        memcpy(pv, buf, *pcbRead);
+        *pcbRead = min(cb, pybuf.len());
+        memcpy(pv, pybuf.ptr(), *pcbRead);
     }
+    pybuf.release();
+    Py_DECREF(result);
     return hr;
 }
 
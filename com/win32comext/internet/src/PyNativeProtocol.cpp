@@ -0,0 +1,313 @@
+// A native asynchronous pluggable protocol that serves a fixed block of data,
+// either from a Python buffer or from a file handle.  URL monikers call Read
+// on their own threads; none of the protocol methods need the GIL, so a page
+// is delivered without a Python callback per chunk.
+
+#include "internet_pch.h"
+
+// The data shared by a protocol object and all the protocols its class
+// factory creates.
+class CProtocolSource {
+   public:
+    CProtocolSource() : m_cRef(1), m_hFile(NULL), m_size(0), m_mimeType(NULL) { memset(&m_view, 0, sizeof(m_view)); }
+    void AddRef() { InterlockedIncrement(&m_cRef); }
+    void Release()
+    {
+        if (InterlockedDecrement(&m_cRef) == 0)
+            delete this;
+    }
+    // Fills pv with up to cb bytes starting at pos.
+    HRESULT ReadAt(ULONGLONG pos, void *pv, ULONG cb, ULONG *pcbRead)
+    {
+        *pcbRead = 0;
+        if (pos >= m_size)
+            return S_OK;
+        if (cb > m_size - pos)
+            cb = (ULONG)(m_size - pos);
+        if (m_hFile == NULL) {
+            memcpy(pv, (char *)m_view.buf + pos, cb);
+            *pcbRead = cb;
+            return S_OK;
+        }
+        // A positional read, so protocols sharing the handle don't disturb
+        // each other's file pointer.
+        OVERLAPPED ov;
+        memset(&ov, 0, sizeof(ov));
+        ov.Offset = (DWORD)pos;
+        ov.OffsetHigh = (DWORD)(pos >> 32);
+        DWORD got = 0;
+        if (!ReadFile(m_hFile, pv, cb, &got, &ov)) {
+            DWORD err = GetLastError();
+            if (err == ERROR_IO_PENDING) {
+                if (!GetOverlappedResult(m_hFile, &ov, &got, TRUE))
+                    err = GetLastError();
+                else
+                    err = 0;
+            }
+            if (err == ERROR_HANDLE_EOF)
+                err = 0;
+            if (err)
+                return HRESULT_FROM_WIN32(err);
+        }
+        *pcbRead = got;
+        return S_OK;
+    }
+
+    HANDLE m_hFile;
+    Py_buffer m_view;
+    ULONGLONG m_size;
+    WCHAR *m_mimeType;
+
+   private:
+    ~CProtocolSource()
+    {
+        if (m_hFile)
+            CloseHandle(m_hFile);
+        if (m_view.obj) {
+            CEnterLeavePython _celp;
+            PyBuffer_Release(&m_view);
+        }
+        PyWinObject_FreeWCHAR(m_mimeType);
+    }
+    LONG m_cRef;
+};
+
+class CNativeProtocol : public IInternetProtocol, public IClassFactory {
+   public:
+    CNativeProtocol(CProtocolSource *src) : m_cRef(1), m_src(src), m_pos(0) { m_src->AddRef(); }
+
+    // IUnknown
+    STDMETHOD(QueryInterface)(REFIID riid, void **ppv)
+    {
+        if (ppv == NULL)
+            return E_POINTER;
+        if (riid == IID_IUnknown || riid == IID_IInternetProtocolRoot || riid == IID_IInternetProtocol)
+            *ppv = (IInternetProtocol *)this;
+        else if (riid == IID_IClassFactory)
+            *ppv = (IClassFactory *)this;
+        else {
+            *ppv = NULL;
+            return E_NOINTERFACE;
+        }
+        AddRef();
+        return S_OK;
+    }
+    STDMETHOD_(ULONG, AddRef)(void) { return InterlockedIncrement(&m_cRef); }
+    STDMETHOD_(ULONG, Release)(void)
+    {
+        LONG cRef = InterlockedDecrement(&m_cRef);
+        if (cRef == 0)
+            delete this;
+        return cRef;
+    }
+
+    // IInternetProtocolRoot
+    STDMETHOD(Start)
+    (LPCWSTR szUrl, IInternetProtocolSink *pOIProtSink, IInternetBindInfo *pOIBindInfo, DWORD grfPI,
+     HANDLE_PTR dwReserved)
+    {
+        if (grfPI & PI_PARSE_URL)
+            return S_OK;
+        if (pOIProtSink == NULL)
+            return E_POINTER;
+        m_pos = 0;
+        // All the data is available up front, so it is reported in a single
+        // notification and the result follows immediately.
+        if (m_src->m_mimeType)
+            pOIProtSink->ReportProgress(BINDSTATUS_VERIFIEDMIMETYPEAVAILABLE, m_src->m_mimeType);
+        ULONG size = m_src->m_size > MAXULONG ? MAXULONG : (ULONG)m_src->m_size;
+        pOIProtSink->ReportData(BSCF_FIRSTDATANOTIFICATION | BSCF_LASTDATANOTIFICATION | BSCF_DATAFULLYAVAILABLE,
+                                size, size);
+        pOIProtSink->ReportResult(S_OK, 0, NULL);
+        return S_OK;
+    }
+    STDMETHOD(Continue)(PROTOCOLDATA *pProtocolData) { return S_OK; }
+    STDMETHOD(Abort)(HRESULT hrReason, DWORD dwOptions) { return S_OK; }
+    STDMETHOD(Terminate)(DWORD dwOptions) { return S_OK; }
+    STDMETHOD(Suspend)(void) { return E_NOTIMPL; }
+    STDMETHOD(Resume)(void) { return E_NOTIMPL; }
+
+    // IInternetProtocol
+    STDMETHOD(Read)(void *pv, ULONG cb, ULONG *pcbRead)
+    {
+        if (pcbRead == NULL)
+            return E_POINTER;
+        HRESULT hr = m_src->ReadAt(m_pos, pv, cb, pcbRead);
+        if (FAILED(hr))
+            return hr;
+        m_pos += *pcbRead;
+        return m_pos >= m_src->m_size ? S_FALSE : S_OK;
+    }
+    STDMETHOD(Seek)(LARGE_INTEGER dlibMove, DWORD dwOrigin, ULARGE_INTEGER *plibNewPosition)
+    {
+        LONGLONG base;
+        switch (dwOrigin) {
+            case STREAM_SEEK_SET:
+                base = 0;
+                break;
+            case STREAM_SEEK_CUR:
+                base = (LONGLONG)m_pos;
+                break;
+            case STREAM_SEEK_END:
+                base = (LONGLONG)m_src->m_size;
+                break;
+            default:
+                return STG_E_INVALIDFUNCTION;
+        }
+        if (base + dlibMove.QuadPart < 0)
+            return STG_E_INVALIDFUNCTION;
+        m_pos = (ULONGLONG)(base + dlibMove.QuadPart);
+        if (plibNewPosition)
+            plibNewPosition->QuadPart = m_pos;
+        return S_OK;
+    }
+    STDMETHOD(LockRequest)(DWORD dwOptions) { return S_OK; }
+    STDMETHOD(UnlockRequest)(void) { return S_OK; }
+
+    // IClassFactory - each instance serves the same data from the start.
+    STDMETHOD(CreateInstance)(IUnknown *pUnkOuter, REFIID riid, void **ppv)
+    {
+        if (ppv == NULL)
+            return E_POINTER;
+        *ppv = NULL;
+        if (pUnkOuter != NULL)
+            return CLASS_E_NOAGGREGATION;
+        CNativeProtocol *p = new CNativeProtocol(m_src);
+        if (p == NULL)
+            return E_OUTOFMEMORY;
+        HRESULT hr = p->QueryInterface(riid, ppv);
+        p->Release();
+        return hr;
+    }
+    STDMETHOD(LockServer)(BOOL fLock) { return S_OK; }
+
+   private:
+    ~CNativeProtocol() { m_src->Release(); }
+    LONG m_cRef;
+    CProtocolSource *m_src;
+    ULONGLONG m_pos;
+};
+
+static PyObject *PyObject_FromProtocolSource(CProtocolSource *src, PyObject *obMimeType)
+{
+    if (!PyWinObject_AsWCHAR(obMimeType, &src->m_mimeType, TRUE)) {
+        src->Release();
+        return NULL;
+    }
+    CNativeProtocol *p = new CNativeProtocol(src);
+    src->Release();
+    if (p == NULL)
+        return PyErr_NoMemory();
+    return PyCom_PyObjectFromIUnknown((IInternetProtocol *)p, IID_IInternetProtocol, FALSE);
+}
+
+// @pymethod <o PyIInternetProtocol>|internet|CreateBufferProtocol|Creates a native
+// protocol that serves the contents of a buffer.
+// @comm The buffer is referenced, not copied, until the protocol and all
+// the protocols created by its class factory are released.  The result also
+// supports IClassFactory, so it can be passed to <om internet.RegisterNameSpaceProtocol>.
+PyObject *PyCreateBufferProtocol(PyObject *self, PyObject *args)
+{
+    PyObject *obData, *obMimeType = Py_None;
+    if (!PyArg_ParseTuple(args, "O|O:CreateBufferProtocol",
+                          &obData,       // @pyparm buffer|data||The data to serve.
+                          &obMimeType))  // @pyparm str|mimeType|None|The MIME type reported to the sink.
+        return NULL;
+    CProtocolSource *src = new CProtocolSource();
+    if (src == NULL)
+        return PyErr_NoMemory();
+    if (PyObject_GetBuffer(obData, &src->m_view, PyBUF_SIMPLE) == -1) {
+        src->Release();
+        return NULL;
+    }
+    src->m_size = src->m_view.len;
+    return PyObject_FromProtocolSource(src, obMimeType);
+}
+
+// @pymethod <o PyIInternetProtocol>|internet|CreateFileProtocol|Creates a native
+// protocol that serves the contents of a file.
+// @comm The handle is duplicated, and the file is read with positional reads,
+// so several protocols created by the class factory can serve it at once.
+// The size of the file is taken when the protocol is created.
+PyObject *PyCreateFileProtocol(PyObject *self, PyObject *args)
+{
+    PyObject *obHandle, *obMimeType = Py_None;
+    if (!PyArg_ParseTuple(args, "O|O:CreateFileProtocol",
+                          &obHandle,     // @pyparm <o PyHANDLE>|handle||A handle to the file, opened for reading.
+                          &obMimeType))  // @pyparm str|mimeType|None|The MIME type reported to the sink.
+        return NULL;
+    HANDLE h;
+    if (!PyWinObject_AsHANDLE(obHandle, &h))
+        return NULL;
+    CProtocolSource *src = new CProtocolSource();
+    if (src == NULL)
+        return PyErr_NoMemory();
+    LARGE_INTEGER size;
+    if (!DuplicateHandle(GetCurrentProcess(), h, GetCurrentProcess(), &src->m_hFile, 0, FALSE,
+                         DUPLICATE_SAME_ACCESS) ||
+        !GetFileSizeEx(src->m_hFile, &size)) {
+        HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+        src->Release();
+        return PyCom_BuildPyException(hr);
+    }
+    src->m_size = size.QuadPart;
+    return PyObject_FromProtocolSource(src, obMimeType);
+}
+
+static PyObject *DoNameSpaceProtocol(PyObject *obFactory, PyObject *obScheme, BOOL bRegister)
+{
+    IClassFactory *pcf;
+    if (!PyCom_InterfaceFromPyInstanceOrObject(obFactory, IID_IClassFactory, (void **)&pcf, FALSE))
+        return NULL;
+    TmpWCHAR scheme;
+    if (!PyWinObject_AsWCHAR(obScheme, &scheme, FALSE)) {
+        PY_INTERFACE_PRECALL;
+        pcf->Release();
+        PY_INTERFACE_POSTCALL;
+        return NULL;
+    }
+    HRESULT hr;
+    IInternetSession *pSession = NULL;
+    PY_INTERFACE_PRECALL;
+    hr = CoInternetGetSession(0, &pSession, 0);
+    if (SUCCEEDED(hr)) {
+        if (bRegister)
+            hr = pSession->RegisterNameSpace(pcf, CLSID_NULL, scheme, 0, NULL, 0);
+        else
+            hr = pSession->UnregisterNameSpace(pcf, scheme);
+        pSession->Release();
+    }
+    pcf->Release();
+    PY_INTERFACE_POSTCALL;
+    if (FAILED(hr))
+        return PyCom_BuildPyException(hr);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod |internet|RegisterNameSpaceProtocol|Registers a temporary pluggable
+// namespace handler for the current process.
+// @comm Uses IInternetSession::RegisterNameSpace, so every URL with the given
+// scheme is served by a protocol created by the factory.
+PyObject *PyRegisterNameSpaceProtocol(PyObject *self, PyObject *args)
+{
+    PyObject *obFactory, *obScheme;
+    if (!PyArg_ParseTuple(args, "OO:RegisterNameSpaceProtocol",
+                          &obFactory,  // @pyparm <o PyIClassFactory>|factory||The class factory, such as the result
+                                       // of <om internet.CreateBufferProtocol>.
+                          &obScheme))  // @pyparm str|scheme||The URL scheme to handle.
+        return NULL;
+    return DoNameSpaceProtocol(obFactory, obScheme, TRUE);
+}
+
+// @pymethod |internet|UnregisterNameSpaceProtocol|Removes a handler registered
+// with <om internet.RegisterNameSpaceProtocol>.
+PyObject *PyUnregisterNameSpaceProtocol(PyObject *self, PyObject *args)
+{
+    PyObject *obFactory, *obScheme;
+    if (!PyArg_ParseTuple(args, "OO:UnregisterNameSpaceProtocol",
+                          &obFactory,  // @pyparm <o PyIClassFactory>|factory||The registered class factory.
+                          &obScheme))  // @pyparm str|scheme||The URL scheme.
+        return NULL;
+    return DoNameSpaceProtocol(obFactory, obScheme, FALSE);
+}
@@ -211,12 +211,22 @@ static PyObject *PyCoInternetCreateSecurityManager(PyObject *self, PyObject *arg
     return PyCom_PyObjectFromIUnknown(sm, IID_IInternetSecurityManager, FALSE);
 }
 
+// Native protocols, from PyNativeProtocol.cpp
+extern PyObject *PyCreateBufferProtocol(PyObject *self, PyObject *args);
+extern PyObject *PyCreateFileProtocol(PyObject *self, PyObject *args);
+extern PyObject *PyRegisterNameSpaceProtocol(PyObject *self, PyObject *args);
+extern PyObject *PyUnregisterNameSpaceProtocol(PyObject *self, PyObject *args);
+
 /* List of module functions */
 // @module internet|A module, encapsulating the ActiveX Internet interfaces
 static struct PyMethodDef internet_functions[] = {
     {"CoInternetCreateSecurityManager", PyCoInternetCreateSecurityManager},  // @pymeth CoInternetCreateSecurityManager|
     {"CoInternetIsFeatureEnabled", PyCoInternetIsFeatureEnabled},            // @pymeth CoInternetIsFeatureEnabled|
     {"CoInternetSetFeatureEnabled", PyCoInternetSetFeatureEnabled},          // @pymeth CoInternetSetFeatureEnabled|
+    {"CreateBufferProtocol", PyCreateBufferProtocol},                        // @pymeth CreateBufferProtocol|
+    {"CreateFileProtocol", PyCreateFileProtocol},                            // @pymeth CreateFileProtocol|
+    {"RegisterNameSpaceProtocol", PyRegisterNameSpaceProtocol},              // @pymeth RegisterNameSpaceProtocol|
+    {"UnregisterNameSpaceProtocol", PyUnregisterNameSpaceProtocol},          // @pymeth UnregisterNameSpaceProtocol|
     {NULL, NULL},
 };
 
@@ -62,6 +62,314 @@ PyObject *PyIMAPITable::GetLastError(PyObject *self, PyObject *args)
 }
 %}
 
+%{
+// Converters used by <o PyMAPITableRowIter>, chosen once per column from the
+// column's property type, and returning just the value.
+typedef PyObject *(*PFNPROPVALUECONVERTER)(SPropValue *pv);
+
+static PyObject *ConvertPropI2(SPropValue *pv) { return PyInt_FromLong(pv->Value.i); }
+static PyObject *ConvertPropI4(SPropValue *pv) { return PyInt_FromLong(pv->Value.l); }
+static PyObject *ConvertPropR8(SPropValue *pv) { return PyFloat_FromDouble(pv->Value.dbl); }
+static PyObject *ConvertPropBoolean(SPropValue *pv) { return PyBool_FromLong(pv->Value.b); }
+static PyObject *ConvertPropSysTime(SPropValue *pv) { return PyWinObject_FromFILETIME(pv->Value.ft); }
+static PyObject *ConvertPropString8(SPropValue *pv) { return PyString_FromString(pv->Value.lpszA); }
+static PyObject *ConvertPropUnicode(SPropValue *pv) { return PyWinObject_FromWCHAR(pv->Value.lpszW); }
+static PyObject *ConvertPropBinary(SPropValue *pv) { return PyString_FromStringAndSize((char *)pv->Value.bin.lpb, pv->Value.bin.cb); }
+static PyObject *ConvertPropI8(SPropValue *pv) { return PyWinObject_FromLARGE_INTEGER(pv->Value.li); }
+static PyObject *ConvertPropGeneric(SPropValue *pv)
+{
+	PyObject *obProp = PyMAPIObject_FromSPropValue(pv);
+	if (obProp == NULL)
+		return NULL;
+	PyObject *ret = PyTuple_GET_ITEM(obProp, 1);
+	Py_INCREF(ret);
+	Py_DECREF(obProp);
+	return ret;
+}
+
+static PFNPROPVALUECONVERTER GetPropValueConverter(ULONG ulPropTag)
+{
+	switch (PROP_TYPE(ulPropTag)) {
+		case PT_I2: return ConvertPropI2;
+		case PT_I4: return ConvertPropI4;
+		case PT_R8: return ConvertPropR8;
+		case PT_BOOLEAN: return ConvertPropBoolean;
+		case PT_SYSTIME: return ConvertPropSysTime;
+		case PT_STRING8: return ConvertPropString8;
+		case PT_UNICODE: return ConvertPropUnicode;
+		case PT_BINARY: return ConvertPropBinary;
+		case PT_I8: return ConvertPropI8;
+	}
+	return ConvertPropGeneric;
+}
+
+// @object PyMAPITableRowIter|An iterator over the rows of a table, as returned by <om PyIMAPITable.IterRows>
+// @comm Rows are fetched with QueryRows in batches, and each SRowSet is freed as soon as it
+// has been converted, so only one batch is held in memory at a time.
+class PyMAPITableRowIter : public PyObject {
+   public:
+	PyMAPITableRowIter(IMAPITable *pTable, SPropTagArray *pCols, ULONG batch, ULONG flags, BOOL columnar);
+	~PyMAPITableRowIter();
+	static void deallocFunc(PyObject *ob);
+	static PyObject *iter(PyObject *self);
+	static PyObject *iternext(PyObject *self);
+	PyObject *ConvertRows(SRowSet *prs);
+	PyObject *ConvertColumns(SRowSet *prs);
+
+	IMAPITable *m_pTable;
+	SPropTagArray *m_pCols;
+	PFNPROPVALUECONVERTER *m_converters;
+	PyObject **m_tagobs;
+	ULONG m_batch, m_flags;
+	BOOL m_columnar, m_done;
+	PyObject *m_pending;  // rows from the current batch not yet returned
+	Py_ssize_t m_pending_pos;
+};
+
+PyTypeObject PyMAPITableRowIterType = {
+	PYWIN_OBJECT_HEAD "PyMAPITableRowIter",
+	sizeof(PyMAPITableRowIter),
+	0,
+	PyMAPITableRowIter::deallocFunc, /* tp_dealloc */
+	0,                               /* tp_print */
+	0,                               /* tp_getattr */
+	0,                               /* tp_setattr */
+	0,                               /* tp_compare */
+	0,                               /* tp_repr */
+	0,                               /* tp_as_number */
+	0,                               /* tp_as_sequence */
+	0,                               /* tp_as_mapping */
+	0,                               /* tp_hash */
+	0,                               /* tp_call */
+	0,                               /* tp_str */
+	PyObject_GenericGetAttr,         /* tp_getattro */
+	0,                               /* tp_setattro */
+	0,                               /* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,              /* tp_flags */
+	0,                               /* tp_doc */
+	0,                               /* tp_traverse */
+	0,                               /* tp_clear */
+	0,                               /* tp_richcompare */
+	0,                               /* tp_weaklistoffset */
+	PyMAPITableRowIter::iter,        /* tp_iter */
+	PyMAPITableRowIter::iternext,    /* tp_iternext */
+};
+
+PyMAPITableRowIter::PyMAPITableRowIter(IMAPITable *pTable, SPropTagArray *pCols, ULONG batch, ULONG flags,
+									   BOOL columnar)
+{
+	ob_type = &PyMAPITableRowIterType;
+	_Py_NewReference(this);
+	m_pTable = pTable;
+	m_pCols = pCols;
+	m_converters = NULL;
+	m_tagobs = NULL;
+	m_batch = batch;
+	m_flags = flags;
+	m_columnar = columnar;
+	m_done = FALSE;
+	m_pending = NULL;
+	m_pending_pos = 0;
+}
+
+PyMAPITableRowIter::~PyMAPITableRowIter()
+{
+	if (m_tagobs) {
+		for (ULONG i = 0; i < m_pCols->cValues; i++) Py_XDECREF(m_tagobs[i]);
+		free(m_tagobs);
+	}
+	free(m_converters);
+	Py_XDECREF(m_pending);
+	MAPIFreeBuffer(m_pCols);
+	m_pTable->Release();
+}
+
+/*static*/ void PyMAPITableRowIter::deallocFunc(PyObject *ob) { delete (PyMAPITableRowIter *)ob; }
+
+/*static*/ PyObject *PyMAPITableRowIter::iter(PyObject *self)
+{
+	Py_INCREF(self);
+	return self;
+}
+
+// Each row is a tuple of (propTag, value) like the rows returned by QueryRows.  Values in
+// their column's declared type are converted directly; others, such as PT_ERROR for a
+// missing property, go through the generic conversion.
+PyObject *PyMAPITableRowIter::ConvertRows(SRowSet *prs)
+{
+	PyObject *ret = PyTuple_New(prs->cRows);
+	if (ret == NULL)
+		return NULL;
+	for (ULONG r = 0; r < prs->cRows; r++) {
+		SRow *row = prs->aRow + r;
+		PyObject *obRow = PyTuple_New(row->cValues);
+		if (obRow == NULL) {
+			Py_DECREF(ret);
+			return NULL;
+		}
+		PyTuple_SET_ITEM(ret, r, obRow);
+		for (ULONG c = 0; c < row->cValues; c++) {
+			SPropValue *pv = row->lpProps + c;
+			PyObject *obProp;
+			if (c < m_pCols->cValues && pv->ulPropTag == m_pCols->aulPropTag[c]) {
+				PyObject *val = (*m_converters[c])(pv);
+				obProp = val ? PyTuple_Pack(2, m_tagobs[c], val) : NULL;
+				Py_XDECREF(val);
+			}
+			else
+				obProp = PyMAPIObject_FromSPropValue(pv);
+			if (obProp == NULL) {
+				Py_DECREF(ret);
+				return NULL;
+			}
+			PyTuple_SET_ITEM(obRow, c, obProp);
+		}
+	}
+	return ret;
+}
+
+// A dict mapping each column's property tag to a list of values, with None where
+// a row doesn't have the property in the column's type.
+PyObject *PyMAPITableRowIter::ConvertColumns(SRowSet *prs)
+{
+	PyObject *ret = PyDict_New();
+	if (ret == NULL)
+		return NULL;
+	for (ULONG c = 0; c < m_pCols->cValues; c++) {
+		PyObject *obCol = PyList_New(prs->cRows);
+		if (obCol == NULL || PyDict_SetItem(ret, m_tagobs[c], obCol) == -1) {
+			Py_XDECREF(obCol);
+			Py_DECREF(ret);
+			return NULL;
+		}
+		Py_DECREF(obCol);  // the dict holds a reference
+		for (ULONG r = 0; r < prs->cRows; r++) {
+			SRow *row = prs->aRow + r;
+			PyObject *val;
+			if (c < row->cValues && row->lpProps[c].ulPropTag == m_pCols->aulPropTag[c])
+				val = (*m_converters[c])(row->lpProps + c);
+			else {
+				Py_INCREF(Py_None);
+				val = Py_None;
+			}
+			if (val == NULL) {
+				Py_DECREF(ret);
+				return NULL;
+			}
+			PyList_SET_ITEM(obCol, r, val);
+		}
+	}
+	return ret;
+}
+
+/*static*/ PyObject *PyMAPITableRowIter::iternext(PyObject *self)
+{
+	PyMAPITableRowIter *This = (PyMAPITableRowIter *)self;
+	for (;;) {
+		if (This->m_pending) {
+			if (This->m_pending_pos < PyTuple_GET_SIZE(This->m_pending)) {
+				PyObject *ret = PyTuple_GET_ITEM(This->m_pending, This->m_pending_pos++);
+				Py_INCREF(ret);
+				return ret;
+			}
+			Py_CLEAR(This->m_pending);
+		}
+		if (This->m_done)
+			return NULL;
+		SRowSet *prs = NULL;
+		HRESULT hr;
+		Py_BEGIN_ALLOW_THREADS
+		hr = This->m_pTable->QueryRows(This->m_batch, This->m_flags, &prs);
+		Py_END_ALLOW_THREADS
+		if (FAILED(hr)) {
+			This->m_done = TRUE;
+			return OleSetOleError(hr);
+		}
+		if (prs == NULL || prs->cRows == 0) {
+			This->m_done = TRUE;
+			PyMAPIObject_FreeSRowSet(prs);
+			return NULL;
+		}
+		PyObject *ob = This->m_columnar ? This->ConvertColumns(prs) : This->ConvertRows(prs);
+		PyMAPIObject_FreeSRowSet(prs);
+		if (ob == NULL)
+			return NULL;
+		if (This->m_columnar)
+			return ob;
+		This->m_pending = ob;
+		This->m_pending_pos = 0;
+	}
+}
+%}
+
+%native(IterRows) IterRows;
+%{
+// @pyswig <o PyMAPITableRowIter>|IterRows|Returns an iterator over the rows of the table, starting at the current cursor position.
+// @comm Unlike <om PyIMAPITable.QueryRows> or <om mapi.HrQueryAllRows>, only batchSize rows are held
+// in memory at once, and values are converted with a converter picked in advance from each column's
+// property type.
+// @comm If columnar is False, each item is a row in the same form returned by <om PyIMAPITable.QueryRows>.
+// If True, each item is a dict representing a batch, mapping the property tag of each column to a list of
+// values, with None for rows where the property is missing.
+PyObject *PyIMAPITable::IterRows(PyObject *self, PyObject *args)
+{
+	HRESULT hr;
+	PyObject *obCols = Py_None;
+	ULONG batch = 100, flags = 0;
+	BOOL columnar = FALSE;
+	IMAPITable *_swig_self;
+	if ((_swig_self=GetI(self))==NULL) return NULL;
+	if(!PyArg_ParseTuple(args,"|Okki:IterRows",
+		&obCols, // @pyparm <o PySPropTagArray>|columns|None|If not None, the columns are first set with <om PyIMAPITable.SetColumns>
+		&batch, // @pyparm int|batchSize|100|The number of rows to request in each call to QueryRows
+		&flags, // @pyparm int|flags|0|Flags passed to QueryRows
+		&columnar)) // @pyparm bool|columnar|False|Return each batch as a dict of column values
+		return NULL;
+	if (batch == 0) {
+		PyErr_SetString(PyExc_ValueError, "batchSize must be greater than zero");
+		return NULL;
+	}
+	if (PyType_Ready(&PyMAPITableRowIterType) == -1)
+		return NULL;
+	SPropTagArray *pCols = NULL;
+	if (obCols != Py_None) {
+		if (!PyMAPIObject_AsSPropTagArray(obCols, &pCols))
+			return NULL;
+		Py_BEGIN_ALLOW_THREADS
+		hr = _swig_self->SetColumns(pCols, TBL_BATCH);
+		Py_END_ALLOW_THREADS
+		PyMAPIObject_FreeSPropTagArray(pCols);
+		pCols = NULL;
+		if (FAILED(hr))
+			return OleSetOleError(hr);
+	}
+	// The columns actually in effect, which determine the converters
+	Py_BEGIN_ALLOW_THREADS
+	hr = _swig_self->QueryColumns(0, &pCols);
+	Py_END_ALLOW_THREADS
+	if (FAILED(hr))
+		return OleSetOleError(hr);
+
+	_swig_self->AddRef();
+	PyMAPITableRowIter *ret = new PyMAPITableRowIter(_swig_self, pCols, batch, flags, columnar);
+	ULONG ncols = pCols->cValues;
+	ret->m_converters = (PFNPROPVALUECONVERTER *)malloc((ncols + 1) * sizeof(PFNPROPVALUECONVERTER));
+	ret->m_tagobs = (PyObject **)calloc(ncols + 1, sizeof(PyObject *));
+	if (ret->m_converters == NULL || ret->m_tagobs == NULL) {
+		Py_DECREF(ret);
+		return PyErr_NoMemory();
+	}
+	for (ULONG i = 0; i < ncols; i++) {
+		ret->m_converters[i] = GetPropValueConverter(pCols->aulPropTag[i]);
+		if ((ret->m_tagobs[i] = PyLong_FromUnsignedLong(pCols->aulPropTag[i])) == NULL) {
+			Py_DECREF(ret);
+			return NULL;
+		}
+	}
+	return ret;
+}
+%}
+
 // @pyswig int|Advise|Registers to receive notification of specified events affecting the table. 
 HRESULT Advise(
 	unsigned long ulEventMask, // @pyparm int|eventMask||
@@ -63,3 +63,6 @@ PyObject *PyMAPIObject_FromSPropProblemArray(SPropProblemArray *ppa);
 PyObject *PyWinObject_FromMAPIStr(LPTSTR str, BOOL isUnicode);
 BOOL PyWinObject_AsMAPIStr(PyObject *stringObject, LPTSTR *pResult, BOOL asUnicode, BOOL bNoneOK = FALSE,
                            DWORD *pResultLen = NULL);
+
+/* Copy a stream to a file handle or a callable, using the given buffer */
+BOOL PyMAPI_CopyStream(IStream *pStream, PyObject *obDest, BYTE *buf, ULONG cbBuf, ULONGLONG *pcbCopied);
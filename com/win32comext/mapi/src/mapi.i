@@ -1214,6 +1214,183 @@ done:
 	
 %}
 
+// @pyswig long|CopyStream|Copies the rest of a stream to a file handle or a callable.
+// @rdesc The number of bytes copied.
+// @comm When dest is a handle, the whole copy is done without the Python lock, through one
+// buffer of bufferSize bytes.  When dest is callable, it is called with a memoryview of each
+// chunk, which is only valid during the call as the buffer is reused.
+%native(CopyStream) PyCopyStream;
+// @pyswig long|CopyPropertyStream|Opens a property as a stream and copies it to a file handle or a callable.
+// @rdesc The number of bytes copied.
+// @comm This reads large properties such as PR_BODY, PR_RTF_COMPRESSED and PR_ATTACH_DATA_BIN,
+// which <om PyIMAPIProp.GetProps> can't return, without creating a string for each chunk.
+// dest is handled as for <om mapi.CopyStream>.
+%native(CopyPropertyStream) PyCopyPropertyStream;
+%{
+#define MAPI_COPY_DEFAULT_BUFFER 65536
+
+static PyObject *DoCopyStream(IStream *pStream, PyObject *obDest, ULONG cbBuf)
+{
+	if (cbBuf == 0) {
+		PyErr_SetString(PyExc_ValueError, "bufferSize must be greater than zero");
+		return NULL;
+	}
+	BYTE *buf = (BYTE *)malloc(cbBuf);
+	if (buf == NULL)
+		return PyErr_NoMemory();
+	ULONGLONG copied;
+	BOOL ok = PyMAPI_CopyStream(pStream, obDest, buf, cbBuf, &copied);
+	free(buf);
+	if (!ok)
+		return NULL;
+	return PyLong_FromUnsignedLongLong(copied);
+}
+
+PyObject *PyCopyStream(PyObject *self, PyObject *args)
+{
+	PyObject *obStream, *obDest;
+	ULONG cbBuf = MAPI_COPY_DEFAULT_BUFFER;
+	IStream *pStream = NULL;
+	if (!PyArg_ParseTuple(args, "OO|k:CopyStream",
+		&obStream, // @pyparm <o PyIStream>|stream||The stream to read from its current position.
+		&obDest, // @pyparm <o PyHANDLE>/callable|dest||A file handle to write to, or a callable taking a memoryview.
+		&cbBuf)) // @pyparm int|bufferSize|65536|The size of the buffer used for each read.
+		return NULL;
+	if (!PyCom_InterfaceFromPyObject(obStream, IID_IStream, (void **)&pStream, FALSE))
+		return NULL;
+	PyObject *ret = DoCopyStream(pStream, obDest, cbBuf);
+	PY_INTERFACE_PRECALL;
+	pStream->Release();
+	PY_INTERFACE_POSTCALL;
+	return ret;
+}
+
+PyObject *PyCopyPropertyStream(PyObject *self, PyObject *args)
+{
+	HRESULT hRes;
+	PyObject *obProp, *obDest;
+	ULONG propTag, cbBuf = MAPI_COPY_DEFAULT_BUFFER, flags = 0;
+	IMAPIProp *pProp = NULL;
+	IStream *pStream = NULL;
+	PyObject *ret = NULL;
+	if (!PyArg_ParseTuple(args, "OkO|kk:CopyPropertyStream",
+		&obProp, // @pyparm <o PyIMAPIProp>|prop||The message, attachment or other object holding the property.
+		&propTag, // @pyparm ULONG|propTag||The property tag, such as PR_ATTACH_DATA_BIN.
+		&obDest, // @pyparm <o PyHANDLE>/callable|dest||A file handle to write to, or a callable taking a memoryview.
+		&cbBuf, // @pyparm int|bufferSize|65536|The size of the buffer used for each read.
+		&flags)) // @pyparm int|flags|0|Flags for OpenProperty, such as MAPI_DEFERRED_ERRORS.
+		return NULL;
+	if (!PyCom_InterfaceFromPyObject(obProp, IID_IMAPIProp, (void **)&pProp, FALSE))
+		return NULL;
+	{
+		PY_INTERFACE_PRECALL;
+		hRes = pProp->OpenProperty(propTag, &IID_IStream, STGM_READ, flags, (IUnknown **)&pStream);
+		PY_INTERFACE_POSTCALL;
+	}
+	if (FAILED(hRes))
+		OleSetOleError(hRes);
+	else
+		ret = DoCopyStream(pStream, obDest, cbBuf);
+	{
+		PY_INTERFACE_PRECALL;
+		if (pStream) pStream->Release();
+		pProp->Release();
+		PY_INTERFACE_POSTCALL;
+	}
+	return ret;
+}
+%}
+
+// @pyswig [(int, [items, ]), ...]|GetPropsMany|Reads the same properties of many objects.
+// @rdesc A list with an item for each object, each in the form returned by <om PyIMAPIProp.GetProps>.
+// The item for an object whose GetProps fails is (hresult, None).
+// @comm The property tags are converted once, and all the objects are read without the Python lock
+// before any values are converted.
+%native(GetPropsMany) PyGetPropsMany;
+%{
+PyObject *PyGetPropsMany(PyObject *self, PyObject *args)
+{
+	PyObject *obProps, *obTags;
+	ULONG flags = 0;
+	if (!PyArg_ParseTuple(args, "OO|k:GetPropsMany",
+		&obProps, // @pyparm [<o PyIMAPIProp>, ...]|props||The objects, typically messages.
+		&obTags, // @pyparm <o PySPropTagArray>|propList||The properties to read from each.
+		&flags)) // @pyparm int|flags|0|Flags for GetProps.
+		return NULL;
+	TmpPyObject seq = PySequence_Fast(obProps, "props must be a sequence of PyIMAPIProp objects");
+	if (seq == NULL)
+		return NULL;
+	Py_ssize_t cnt = PySequence_Fast_GET_SIZE((PyObject *)seq), i, nprops = 0;
+	SPropTagArray *pta = NULL;
+	PyObject *ret = NULL;
+	IMAPIProp **props = (IMAPIProp **)calloc(cnt + 1, sizeof(IMAPIProp *));
+	HRESULT *results = (HRESULT *)calloc(cnt + 1, sizeof(HRESULT));
+	ULONG *counts = (ULONG *)calloc(cnt + 1, sizeof(ULONG));
+	SPropValue **values = (SPropValue **)calloc(cnt + 1, sizeof(SPropValue *));
+	if (props == NULL || results == NULL || counts == NULL || values == NULL) {
+		PyErr_NoMemory();
+		goto done;
+	}
+	if (!PyMAPIObject_AsSPropTagArray(obTags, &pta))
+		goto done;
+	for (; nprops < cnt; nprops++)
+		if (!PyCom_InterfaceFromPyObject(PySequence_Fast_GET_ITEM((PyObject *)seq, nprops), IID_IMAPIProp,
+										 (void **)&props[nprops], FALSE))
+			goto done;
+	Py_BEGIN_ALLOW_THREADS
+	for (i = 0; i < cnt; i++)
+		results[i] = props[i]->GetProps(pta, flags, &counts[i], &values[i]);
+	Py_END_ALLOW_THREADS
+	ret = PyList_New(cnt);
+	if (ret == NULL)
+		goto done;
+	for (i = 0; i < cnt; i++) {
+		PyObject *obValues;
+		if (FAILED(results[i])) {
+			Py_INCREF(Py_None);
+			obValues = Py_None;
+		}
+		else {
+			obValues = PyTuple_New(counts[i]);
+			for (ULONG v = 0; obValues && v < counts[i]; v++) {
+				PyObject *newOb = PyMAPIObject_FromSPropValue(values[i] + v);
+				if (newOb == NULL)
+					Py_CLEAR(obValues);
+				else
+					PyTuple_SET_ITEM(obValues, v, newOb);
+			}
+			if (obValues == NULL) {
+				Py_CLEAR(ret);
+				goto done;
+			}
+		}
+		PyObject *item = Py_BuildValue("iN", results[i], obValues);
+		if (item == NULL) {
+			Py_CLEAR(ret);
+			goto done;
+		}
+		PyList_SET_ITEM(ret, i, item);
+	}
+done:
+	if (props || values) {
+		PY_INTERFACE_PRECALL;
+		for (i = 0; i < nprops; i++)
+			props[i]->Release();
+		if (values)
+			for (i = 0; i < cnt; i++)
+				MAPIFreeBuffer(values[i]);
+		PY_INTERFACE_POSTCALL;
+	}
+	if (pta)
+		PyMAPIObject_FreeSPropTagArray(pta);
+	free(props);
+	free(results);
+	free(counts);
+	free(values);
+	return ret;
+}
+%}
+
 // @pyswig <o PyIMAPIAdviseSink>|HrAllocAdviseSink|Creates an advise sink object, given a context specified by the calling implementation and a callback function to be triggered by an event notification.
 %native(HrAllocAdviseSink) PyHrAllocAdviseSink;
 %{
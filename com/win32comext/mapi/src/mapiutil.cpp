@@ -1285,3 +1285,72 @@ BOOL PyWinObject_AsMAPIStr(PyObject *stringObject, LPTSTR *pResult, BOOL asUnico
     return PyWinObject_AsString(stringObject, (LPSTR *)pResult, bNoneOK, pResultLen);
 #endif
 }
+
+// Copies the rest of a stream to a handle or a Python callable through a
+// caller supplied buffer.  For a handle, the GIL is released for the whole
+// copy.  For a callable, it is only held while the callable is given a
+// memoryview of each chunk; the view is released after the call, since the
+// buffer is reused.  Must be called with the GIL held.
+BOOL PyMAPI_CopyStream(IStream *pStream, PyObject *obDest, BYTE *buf, ULONG cbBuf, ULONGLONG *pcbCopied)
+{
+    HRESULT hr = S_OK;
+    DWORD err = 0;
+    ULONGLONG copied = 0;
+    *pcbCopied = 0;
+    if (!PyCallable_Check(obDest)) {
+        HANDLE h;
+        if (!PyWinObject_AsHANDLE(obDest, &h))
+            return FALSE;
+        Py_BEGIN_ALLOW_THREADS;
+        for (;;) {
+            ULONG got = 0;
+            hr = pStream->Read(buf, cbBuf, &got);
+            if (FAILED(hr) || got == 0)
+                break;
+            DWORD written;
+            if (!WriteFile(h, buf, got, &written, NULL)) {
+                err = GetLastError();
+                break;
+            }
+            copied += got;
+        }
+        Py_END_ALLOW_THREADS;
+        *pcbCopied = copied;
+        if (err) {
+            PyWin_SetAPIError("WriteFile", err);
+            return FALSE;
+        }
+        if (FAILED(hr)) {
+            OleSetOleError(hr);
+            return FALSE;
+        }
+        return TRUE;
+    }
+    for (;;) {
+        ULONG got = 0;
+        Py_BEGIN_ALLOW_THREADS;
+        hr = pStream->Read(buf, cbBuf, &got);
+        Py_END_ALLOW_THREADS;
+        if (FAILED(hr)) {
+            OleSetOleError(hr);
+            return FALSE;
+        }
+        if (got == 0)
+            break;
+        PyObject *view = PyMemoryView_FromMemory((char *)buf, got, PyBUF_READ);
+        if (view == NULL)
+            return FALSE;
+        PyObject *rc = PyObject_CallFunctionObjArgs(obDest, view, NULL);
+        if (rc != NULL) {
+            Py_DECREF(rc);
+            rc = PyObject_CallMethod(view, "release", NULL);
+        }
+        Py_DECREF(view);
+        if (rc == NULL)
+            return FALSE;
+        Py_DECREF(rc);
+        copied += got;
+        *pcbCopied = copied;
+    }
+    return TRUE;
+}
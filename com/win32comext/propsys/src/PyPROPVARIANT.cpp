@@ -15,8 +15,20 @@
 // Type should be a combination of VARENUM values (pythoncom.VT_*).
 // VT_ILLEGAL indicates that an appropriate variant type should be inferred from the Value.
 // If the requested Type includes VT_VECTOR, Value should be a sequence of compatible objects.
+// For vectors of integer and floating point types, Value can also be a contiguous buffer
+// object (eg an array.array or numpy array) with elements of the same kind and size, which
+// is copied directly.
+// @comm A PyPROPVARIANT holding a vector of an integer or floating point type (VT_I1, VT_UI1,
+// VT_I2, VT_UI2, VT_I4, VT_UI4, VT_ERROR, VT_I8, VT_UI8, VT_R4, VT_R8 or VT_BOOL, combined with
+// VT_VECTOR) supports the buffer protocol, exposing the elements as a one dimensional array,
+// so it can be passed to memoryview() or numpy.frombuffer() without converting each element.
 // Currently VT_ARRAY and VT_BYREF are not supported, although some types can be coerced
 // into a safearray using <om PyPROPVARIANT.ChangeType>.
+static PyBufferProcs PyPROPVARIANT_as_buffer = {
+    PyPROPVARIANT::getbufferinfo,
+    NULL,
+};
+
 PyTypeObject PyPROPVARIANTType = {PYWIN_OBJECT_HEAD "PyPROPVARIANT",
                                   sizeof(PyPROPVARIANT),
                                   0,
@@ -34,7 +46,7 @@ PyTypeObject PyPROPVARIANTType = {PYWIN_OBJECT_HEAD "PyPROPVARIANT",
                                   0,                        /* tp_str */
                                   PyObject_GenericGetAttr,  // PyPROPVARIANT::getattro,
                                   PyObject_GenericSetAttr,  // PyPROPVARIANT::setattro,
-                                  0,                        // tp_as_buffer;
+                                  &PyPROPVARIANT_as_buffer, // tp_as_buffer;
                                   Py_TPFLAGS_DEFAULT,       // tp_flags;
                                   0,                        // tp_doc; /* Documentation string */
                                   0,                        // traverseproc tp_traverse;
@@ -138,6 +150,131 @@ PyObject *PyWinObject_FromPROPVARIANT(REFPROPVARIANT rpv)
 
 void PyPROPVARIANT::deallocFunc(PyObject *ob) { delete (PyPROPVARIANT *)ob; }
 
+// Returns the struct module format of elements for vector types that can be exposed
+// as a buffer, or NULL.  All CA* structures have the same layout, so elements can be
+// accessed through any of them.
+static const char *GetVectorFormat(VARTYPE vt, Py_ssize_t *itemsize)
+{
+    switch (vt) {
+        case VT_I1 | VT_VECTOR:
+            *itemsize = sizeof(CHAR);
+            return "b";
+        case VT_UI1 | VT_VECTOR:
+            *itemsize = sizeof(UCHAR);
+            return "B";
+        case VT_I2 | VT_VECTOR:
+        case VT_BOOL | VT_VECTOR:
+            *itemsize = sizeof(SHORT);
+            return "h";
+        case VT_UI2 | VT_VECTOR:
+            *itemsize = sizeof(USHORT);
+            return "H";
+        case VT_I4 | VT_VECTOR:
+        case VT_ERROR | VT_VECTOR:
+            *itemsize = sizeof(LONG);
+            return "i";
+        case VT_UI4 | VT_VECTOR:
+            *itemsize = sizeof(ULONG);
+            return "I";
+        case VT_I8 | VT_VECTOR:
+            *itemsize = sizeof(LONGLONG);
+            return "q";
+        case VT_UI8 | VT_VECTOR:
+            *itemsize = sizeof(ULONGLONG);
+            return "Q";
+        case VT_R4 | VT_VECTOR:
+            *itemsize = sizeof(FLOAT);
+            return "f";
+        case VT_R8 | VT_VECTOR:
+            *itemsize = sizeof(DOUBLE);
+            return "d";
+    }
+    return NULL;
+}
+
+// Classifies a struct module format character as signed, unsigned or floating point
+static char GetFormatKind(const char *format)
+{
+    if (format == NULL)
+        return 'u';  // plain bytes
+    if (*format == '@' || *format == '=' || *format == '<')
+        format++;
+    if (format[0] == 0 || format[1] != 0)
+        return 0;
+    if (strchr("bhilq", *format))
+        return 'i';
+    if (strchr("BHILQ", *format))
+        return 'u';
+    if (strchr("fd", *format))
+        return 'f';
+    return 0;
+}
+
+// Fills a numeric vector directly from an object supporting the buffer protocol.
+// Returns -1 if ob is not a suitable buffer, in which case no exception is set and
+// the caller should fall back to converting the elements of a sequence.
+static int BufferToVector(PyObject *ob, VARTYPE vt, PROPVARIANT *ppv)
+{
+    Py_ssize_t itemsize;
+    const char *format = GetVectorFormat(vt, &itemsize);
+    // VARIANT_BOOLs need to be normalized, and element type of strings is ambiguous
+    if (format == NULL || vt == (VT_BOOL | VT_VECTOR) || PyUnicode_Check(ob) || !PyObject_CheckBuffer(ob))
+        return -1;
+    Py_buffer view;
+    if (PyObject_GetBuffer(ob, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) == -1) {
+        PyErr_Clear();
+        return -1;
+    }
+    int ret = -1;
+    if (view.itemsize == itemsize && GetFormatKind(view.format) == GetFormatKind(format) &&
+        view.len / itemsize <= ULONG_MAX) {
+        ppv->caub.cElems = (ULONG)(view.len / itemsize);
+        ppv->caub.pElems = (UCHAR *)CoTaskMemAlloc(view.len);
+        if (ppv->caub.pElems == NULL) {
+            PyErr_NoMemory();
+            ret = FALSE;
+        }
+        else {
+            memcpy(ppv->caub.pElems, view.buf, view.len);
+            ret = TRUE;
+        }
+    }
+    PyBuffer_Release(&view);
+    return ret;
+}
+
+int PyPROPVARIANT::getbufferinfo(PyObject *self, Py_buffer *view, int flags)
+{
+    PyPROPVARIANT *This = (PyPROPVARIANT *)self;
+    Py_ssize_t itemsize;
+    const char *format = GetVectorFormat(This->Py_propvariant.vt, &itemsize);
+    if (format == NULL) {
+        PyErr_Format(PyExc_BufferError, "PROPVARIANT of type 0x%x does not support the buffer interface",
+                     This->Py_propvariant.vt);
+        return -1;
+    }
+    // Values that are not owned by this object (eg passed to a COM server) must not be changed
+    BOOL readonly = !This->ClearOnDestruction;
+    if ((flags & PyBUF_WRITABLE) && readonly) {
+        PyErr_SetString(PyExc_BufferError, "PROPVARIANT is read-only");
+        return -1;
+    }
+    This->vector_shape = This->Py_propvariant.caub.cElems;
+    view->obj = self;
+    Py_INCREF(self);
+    view->buf = This->Py_propvariant.caub.pElems;
+    view->len = This->vector_shape * itemsize;
+    view->readonly = readonly;
+    view->itemsize = itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? (char *)format : NULL;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? &This->vector_shape : NULL;
+    view->strides = (flags & PyBUF_STRIDES) ? &view->itemsize : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
 PyObject *PyPROPVARIANT::tp_new(PyTypeObject *tp, PyObject *args, PyObject *kwargs)
 {
     VARTYPE vt = VT_ILLEGAL;
@@ -318,6 +455,13 @@ BOOL PyWin_NewPROPVARIANT(PyObject *ob, VARTYPE vt, PROPVARIANT *ppv)
     }
 
     ppv->vt = vt;
+    // Numeric vectors can be copied straight from a buffer with the same element type
+    int bufret = BufferToVector(ob, vt, ppv);
+    if (bufret != -1) {
+        if (!bufret)
+            ppv->vt = VT_EMPTY;
+        return bufret;
+    }
     switch (vt) {
         case VT_EMPTY:
         case VT_NULL:
@@ -30,6 +30,8 @@ class __declspec(dllexport) PyPROPVARIANT : public PyObject {
     static PyObject *GetValue(PyObject *, PyObject *);
     static PyObject *ToString(PyObject *, PyObject *);
     static PyObject *ChangeType(PyObject *, PyObject *);
+    static int getbufferinfo(PyObject *self, Py_buffer *view, int flags);
+    Py_ssize_t vector_shape;  // Element count exposed through the buffer interface
 
    protected:
     ~PyPROPVARIANT();
@@ -215,6 +215,170 @@ static PyObject *PySHGetPropertyStoreFromParsingName(PyObject *self, PyObject *a
     return PyCom_PyObjectFromIUnknown((IUnknown *)ret, riid);
 }
 
+struct PROPERTY_FILE_WORK {
+    WCHAR **paths;
+    PROPERTYKEY *keys;
+    ULONG ckeys;
+    GETPROPERTYSTOREFLAGS flags;
+    PROPVARIANT *values;  // ckeys values for each file in the current chunk
+    HRESULT *hrs;
+    LONG start, cnt;
+    LONG next;
+};
+
+static DWORD WINAPI GetPropertiesThread(LPVOID arg)
+{
+    PROPERTY_FILE_WORK *work = (PROPERTY_FILE_WORK *)arg;
+    HRESULT hrinit = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+    LONG i;
+    while ((i = InterlockedIncrement(&work->next) - 1) < work->cnt) {
+        if (FAILED(hrinit)) {
+            work->hrs[i] = hrinit;
+            continue;
+        }
+        IPropertyStore *pstore = NULL;
+        HRESULT hr = SHGetPropertyStoreFromParsingName(work->paths[work->start + i], NULL, work->flags,
+                                                       IID_IPropertyStore, (void **)&pstore);
+        if (SUCCEEDED(hr)) {
+            PROPVARIANT *vals = work->values + i * work->ckeys;
+            for (ULONG k = 0; k < work->ckeys; k++)
+                // Properties the store can't supply are left as VT_EMPTY
+                if (FAILED(pstore->GetValue(work->keys[k], &vals[k])))
+                    PropVariantInit(&vals[k]);
+            pstore->Release();
+        }
+        work->hrs[i] = hr;
+    }
+    if (SUCCEEDED(hrinit))
+        CoUninitialize();
+    return 0;
+}
+
+// @pymethod [(int, tuple),...]|propsys|GetPropertiesFromFiles|Reads a set of properties from many files in parallel
+// @rdesc Returns a list with an (hresult, values) tuple for each path, in the same order.  values is a tuple with
+// the value of each requested property, converted to a Python object, or None if the property store for the file
+// could not be opened.  Properties that a file does not have are returned as None.
+// @comm Property stores are opened with <om propsys.SHGetPropertyStoreFromParsingName> on a pool of worker
+// threads, which join the multi-threaded apartment.  Files are processed in chunks, and the Python lock is only
+// held while the values for a finished chunk are converted.
+static PyObject *PyGetPropertiesFromFiles(PyObject *self, PyObject *args)
+{
+    PyObject *obPaths, *obKeys, *ret = NULL;
+    GETPROPERTYSTOREFLAGS flags = GPS_DEFAULT;
+    DWORD max_threads = 4;
+    LONG chunk_size = 1024;
+    // @pyparm [str,...]|Paths||Paths of the files to read
+    // @pyparm [<o PyPROPERTYKEY>,...]|Keys||The properties to read from each file
+    // @pyparm int|Flags|GPS_DEFAULT|Combination of GETPROPERTYSTOREFLAGS values (shellcon.GPS_*),
+    // eg GPS_FASTPROPERTIESONLY or GPS_OPENSLOWITEM
+    // @pyparm int|MaxThreads|4|Number of worker threads, at most 64
+    // @pyparm int|ChunkSize|1024|Number of files read before their values are converted
+    if (!PyArg_ParseTuple(args, "OO|kkl:GetPropertiesFromFiles", &obPaths, &obKeys, &flags, &max_threads,
+                          &chunk_size))
+        return NULL;
+    if (max_threads < 1 || max_threads > MAXIMUM_WAIT_OBJECTS)
+        return PyErr_Format(PyExc_ValueError, "MaxThreads must be between 1 and %d", MAXIMUM_WAIT_OBJECTS);
+    if (chunk_size < 1)
+        return PyErr_Format(PyExc_ValueError, "ChunkSize must be greater than zero");
+    PyObject *paths_seq = PySequence_Fast(obPaths, "Paths must be a sequence of strings");
+    if (paths_seq == NULL)
+        return NULL;
+    PyObject *keys_seq = PySequence_Fast(obKeys, "Keys must be a sequence of PROPERTYKEYs");
+    if (keys_seq == NULL) {
+        Py_DECREF(paths_seq);
+        return NULL;
+    }
+    PROPERTY_FILE_WORK work;
+    ZeroMemory(&work, sizeof(work));
+    LONG cpaths = (LONG)PySequence_Fast_GET_SIZE(paths_seq);
+    work.ckeys = (ULONG)PySequence_Fast_GET_SIZE(keys_seq);
+    work.flags = flags;
+    if (chunk_size > cpaths)
+        chunk_size = cpaths;
+    LONG i;
+    ULONG k;
+    work.paths = (WCHAR **)calloc(cpaths + 1, sizeof(WCHAR *));
+    work.keys = (PROPERTYKEY *)calloc(work.ckeys + 1, sizeof(PROPERTYKEY));
+    work.values = (PROPVARIANT *)calloc(chunk_size * work.ckeys + 1, sizeof(PROPVARIANT));
+    work.hrs = (HRESULT *)calloc(chunk_size + 1, sizeof(HRESULT));
+    if (work.paths == NULL || work.keys == NULL || work.values == NULL || work.hrs == NULL) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    for (k = 0; k < work.ckeys; k++)
+        if (!PyWinObject_AsPROPERTYKEY(PySequence_Fast_GET_ITEM(keys_seq, k), &work.keys[k]))
+            goto done;
+    for (i = 0; i < cpaths; i++)
+        if (!PyWinObject_AsWCHAR(PySequence_Fast_GET_ITEM(paths_seq, i), &work.paths[i], FALSE))
+            goto done;
+    ret = PyList_New(cpaths);
+    if (ret == NULL)
+        goto done;
+
+    for (work.start = 0; work.start < cpaths; work.start += work.cnt) {
+        work.cnt = min(chunk_size, cpaths - work.start);
+        work.next = 0;
+        HANDLE threads[MAXIMUM_WAIT_OBJECTS];
+        DWORD thread_cnt = 0, nthreads = min(max_threads, (DWORD)work.cnt);
+        Py_BEGIN_ALLOW_THREADS;
+        for (; thread_cnt < nthreads; thread_cnt++) {
+            threads[thread_cnt] = CreateThread(NULL, 0, GetPropertiesThread, &work, 0, NULL);
+            if (threads[thread_cnt] == NULL)
+                break;
+        }
+        if (thread_cnt) {
+            WaitForMultipleObjects(thread_cnt, threads, TRUE, INFINITE);
+            for (DWORD t = 0; t < thread_cnt; t++) CloseHandle(threads[t]);
+        }
+        else
+            // Couldn't start any threads - do the work here.
+            GetPropertiesThread(&work);
+        Py_END_ALLOW_THREADS;
+
+        for (i = 0; i < work.cnt; i++) {
+            PROPVARIANT *vals = work.values + i * work.ckeys;
+            PyObject *obvals = NULL;
+            if (ret == NULL)
+                ;  // conversion already failed, just clean up
+            else if (FAILED(work.hrs[i])) {
+                Py_INCREF(Py_None);
+                obvals = Py_None;
+            }
+            else {
+                obvals = PyTuple_New(work.ckeys);
+                for (k = 0; obvals && k < work.ckeys; k++) {
+                    PyObject *val = PyObject_FromPROPVARIANT(&vals[k]);
+                    if (val == NULL)
+                        Py_CLEAR(obvals);
+                    else
+                        PyTuple_SET_ITEM(obvals, k, val);
+                }
+            }
+            if (SUCCEEDED(work.hrs[i]))
+                for (k = 0; k < work.ckeys; k++) PropVariantClear(&vals[k]);
+            if (ret == NULL)
+                continue;
+            PyObject *item = obvals ? Py_BuildValue("lN", work.hrs[i], obvals) : NULL;
+            if (item == NULL)
+                Py_CLEAR(ret);
+            else
+                PyList_SET_ITEM(ret, work.start + i, item);
+        }
+        if (ret == NULL)
+            break;
+    }
+done:
+    if (work.paths)
+        for (i = 0; i < cpaths; i++) PyWinObject_FreeWCHAR(work.paths[i]);
+    free(work.paths);
+    free(work.keys);
+    free(work.values);
+    free(work.hrs);
+    Py_DECREF(paths_seq);
+    Py_DECREF(keys_seq);
+    return ret;
+}
+
 // ??? needs PyObject_AsPIDL from shell module, or maybe move this function into shell itself ???
 /*
 #include "..//..//shell//src//shell_pch.h"
@@ -566,6 +730,8 @@ static struct PyMethodDef propsys_methods[] = {
      1},  // @pymeth PSUnregisterPropertySchema|Removes a property schema definition
     {"SHGetPropertyStoreFromParsingName", PySHGetPropertyStoreFromParsingName,
      1},  // @pymeth SHGetPropertyStoreFromParsingName|Retrieves the property store for an item by path
+    {"GetPropertiesFromFiles", PyGetPropertiesFromFiles,
+     1},  // @pymeth GetPropertiesFromFiles|Reads a set of properties from many files in parallel
     {"StgSerializePropVariant", PyStgSerializePropVariant,
      1},  // @pymeth StgSerializePropVariant|Serializes a <o PyPROPVARIANT>
     {"StgDeserializePropVariant", PyStgDeserializePropVariant,
@@ -1,4 +1,20 @@
 from win32com.propsys import propsys, pscon
-print("propsys was imported (sorry - that is the extent of the tests,")
+import os
+here = os.path.abspath(__file__)
+(hr, (name,)), (hr_missing, missing) = propsys.GetPropertiesFromFiles(
+    [here, here + ".missing"], [pscon.PKEY_FileName])
+assert hr == 0 and name == os.path.basename(here), (hr, name)
+assert hr_missing != 0 and missing is None, (hr_missing, missing)
+import array, pythoncom
+nums = array.array("i", range(1000))
+pv = propsys.PROPVARIANTType(nums, pythoncom.VT_VECTOR | pythoncom.VT_I4)
+assert pv.GetValue() == list(range(1000)), pv.GetValue()
+view = memoryview(pv)
+assert view.format == "i" and view.tolist() == nums.tolist(), view.format
+# doubles are copied directly too
+pv = propsys.PROPVARIANTType(array.array("d", [1.0, 2.0]), pythoncom.VT_VECTOR | pythoncom.VT_R8)
+assert memoryview(pv).tolist() == [1.0, 2.0]
+
+print("propsys was imported and read a property (sorry - that is the extent of the tests,")
 print("but see the shell folder_view demo, which uses this module)")
-# that's all folks!
\ No newline at end of file
+# that's all folks!
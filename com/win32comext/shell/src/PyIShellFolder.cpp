@@ -96,6 +96,126 @@ PyObject *PyIShellFolder::EnumObjects(PyObject *self, PyObject *args)
     return PyCom_PyObjectFromIUnknown(ppeidl, IID_IEnumIDList, FALSE);
 }
 
+// @pymethod [(<o PyIDL>, str, int), ...]|PyIShellFolder|EnumItems|Lists the contents of the shell folder, with the
+// display name and attributes of each item
+// @comm This is equivalent to calling <om PyIShellFolder.EnumObjects>, then <om PyIShellFolder.GetDisplayNameOf> and
+// <om PyIShellFolder.GetAttributesOf> for every item, but items are fetched from the enumerator in batches and
+// everything for a batch is done in a single call with the Python lock released.
+// @rdesc Returns a list of (pidl, displayName, attributes) tuples.  displayName is None if the folder could not
+// provide a name for the item, and attributes is 0 if the folder did not return any.
+PyObject *PyIShellFolder::EnumItems(PyObject *self, PyObject *args)
+{
+    IShellFolder *pISF = GetI(self);
+    if (pISF == NULL)
+        return NULL;
+    // @pyparm <o PyHANDLE>|hwndOwner|None|Window to use if any user interaction is required
+    // @pyparm int|grfFlags|SHCONTF_FOLDERS\|SHCONTF_NONFOLDERS\|SHCONTF_INCLUDEHIDDEN|Combination of shellcon.SHCONTF_*
+    // constants
+    // @pyparm int|NameFlags|SHGDN_NORMAL|Combination of shellcon.SHGDN_* flags used to retrieve display names
+    // @pyparm int|Attributes|0|Combination of shellcon.SFGAO_* constants to query for each item.  If 0, no attributes
+    // are retrieved.
+    // @pyparm int|BatchSize|64|Number of items requested from the enumerator at a time
+    HWND hwndOwner = 0;
+    PyObject *obhwndOwner = Py_None;
+    DWORD grfFlags = SHCONTF_FOLDERS | SHCONTF_NONFOLDERS | SHCONTF_INCLUDEHIDDEN;
+    DWORD nameFlags = SHGDN_NORMAL;
+    ULONG attrMask = 0;
+    ULONG batchSize = 64;
+    if (!PyArg_ParseTuple(args, "|Olkkk:EnumItems", &obhwndOwner, &grfFlags, &nameFlags, &attrMask, &batchSize))
+        return NULL;
+    if (!PyWinObject_AsHANDLE(obhwndOwner, (HANDLE *)&hwndOwner))
+        return NULL;
+    if (batchSize == 0) {
+        PyErr_SetString(PyExc_ValueError, "BatchSize must be greater than zero");
+        return NULL;
+    }
+
+    IEnumIDList *pEnum = NULL;
+    HRESULT hr;
+    PY_INTERFACE_PRECALL;
+    hr = pISF->EnumObjects(hwndOwner, grfFlags, &pEnum);
+    PY_INTERFACE_POSTCALL;
+    if (FAILED(hr))
+        return PyCom_BuildPyException(hr, pISF, IID_IShellFolder);
+    PyObject *ret = PyList_New(0);
+    // S_FALSE with no enumerator means there are no items.
+    if (ret == NULL || pEnum == NULL) {
+        if (pEnum)
+            pEnum->Release();
+        return ret;
+    }
+
+    LPITEMIDLIST *pidls = (LPITEMIDLIST *)malloc(batchSize * sizeof(LPITEMIDLIST));
+    STRRET *names = (STRRET *)malloc(batchSize * sizeof(STRRET));
+    BOOL *gotnames = (BOOL *)malloc(batchSize * sizeof(BOOL));
+    ULONG *attrs = (ULONG *)malloc(batchSize * sizeof(ULONG));
+    if (pidls == NULL || names == NULL || gotnames == NULL || attrs == NULL) {
+        PyErr_NoMemory();
+        Py_CLEAR(ret);
+        goto done;
+    }
+    for (;;) {
+        ULONG fetched = 0;
+        PY_INTERFACE_PRECALL;
+        hr = pEnum->Next(batchSize, pidls, &fetched);
+        if (SUCCEEDED(hr)) {
+            for (ULONG i = 0; i < fetched; i++) {
+                gotnames[i] = SUCCEEDED(pISF->GetDisplayNameOf(pidls[i], nameFlags, &names[i]));
+                attrs[i] = attrMask;
+                if (attrMask && FAILED(pISF->GetAttributesOf(1, (LPCITEMIDLIST *)&pidls[i], &attrs[i])))
+                    attrs[i] = 0;
+            }
+        }
+        PY_INTERFACE_POSTCALL;
+        if (FAILED(hr)) {
+            PyCom_BuildPyException(hr, pEnum, IID_IEnumIDList);
+            Py_CLEAR(ret);
+            break;
+        }
+        for (ULONG i = 0; i < fetched; i++) {
+            PyObject *item = NULL;
+            if (ret) {
+                // The name must be converted first, as it may point into the PIDL
+                PyObject *obName;
+                if (gotnames[i])
+                    obName = PyObject_FromSTRRET(&names[i], pidls[i], TRUE);
+                else {
+                    Py_INCREF(Py_None);
+                    obName = Py_None;
+                }
+                PyObject *obpidl = PyObject_FromPIDL(pidls[i], TRUE);
+                pidls[i] = NULL;
+                if (obName && obpidl)
+                    item = Py_BuildValue("OOk", obpidl, obName, attrs[i]);
+                Py_XDECREF(obName);
+                Py_XDECREF(obpidl);
+                if (item == NULL || PyList_Append(ret, item) == -1)
+                    Py_CLEAR(ret);
+                Py_XDECREF(item);
+            }
+            else {
+                // Conversion of an earlier item failed - just free the rest of the batch.
+                if (gotnames[i])
+                    PyObject_FreeSTRRET(names[i]);
+                CoTaskMemFree(pidls[i]);
+            }
+        }
+        if (ret == NULL || hr != S_OK || fetched < batchSize)
+            break;
+    }
+done:
+    free(pidls);
+    free(names);
+    free(gotnames);
+    free(attrs);
+    {
+        PY_INTERFACE_PRECALL;
+        pEnum->Release();
+        PY_INTERFACE_POSTCALL;
+    }
+    return ret;
+}
+
 // @pymethod <o PyIShellFolder>|PyIShellFolder|BindToObject|Returns an IShellFolder interface for a subfolder
 PyObject *PyIShellFolder::BindToObject(PyObject *self, PyObject *args)
 {
@@ -418,6 +538,8 @@ static struct PyMethodDef PyIShellFolder_methods[] = {
      1},  // @pymeth ParseDisplayName|Returns the PIDL of an item in a shell folder
     {"EnumObjects", PyIShellFolder::EnumObjects,
      1},  // @pymeth EnumObjects|Creates an enumerator to list the contents of the shell folder
+    {"EnumItems", PyIShellFolder::EnumItems,
+     1},  // @pymeth EnumItems|Lists the contents of the shell folder, with the display name and attributes of each item
     {"BindToObject", PyIShellFolder::BindToObject,
      1},  // @pymeth BindToObject|Returns an IShellFolder interface for a subfolder
     {"BindToStorage", PyIShellFolder::BindToStorage,
@@ -13,6 +13,7 @@ class PyIShellFolder : public PyIUnknown {
     // The Python methods
     static PyObject *ParseDisplayName(PyObject *self, PyObject *args);
     static PyObject *EnumObjects(PyObject *self, PyObject *args);
+    static PyObject *EnumItems(PyObject *self, PyObject *args);
     static PyObject *BindToObject(PyObject *self, PyObject *args);
     static PyObject *BindToStorage(PyObject *self, PyObject *args);
     static PyObject *CompareIDs(PyObject *self, PyObject *args);
@@ -25,6 +25,18 @@ class TestShellItem(unittest.TestCase):
         # test the name we get from the item is the same as from the folder.
         self.assertEqual(name, item.GetDisplayName(shellcon.SHGDN_FORPARSING))
 
+    def test_enum_items(self):
+        sf = shell.SHGetDesktopFolder()
+        flags = shellcon.SHCONTF_FOLDERS | shellcon.SHCONTF_NONFOLDERS
+        items = sf.EnumItems(0, flags, shellcon.SHGDN_FORPARSING,
+                             shellcon.SFGAO_FOLDER, 3)
+        pidls = list(sf.EnumObjects(0, flags))
+        self.assertEqual([i[0] for i in items], pidls)
+        for pidl, name, attrs in items:
+            self.assertEqual(name, sf.GetDisplayNameOf(pidl, shellcon.SHGDN_FORPARSING))
+            self.assertEqual(attrs, sf.GetAttributesOf([pidl], shellcon.SFGAO_FOLDER))
+        self.assertRaises(ValueError, sf.EnumItems, 0, flags, 0, 0, 0)
+
     def test_parsing_relative(self):
         desktop_pidl = shell.SHGetSpecialFolderLocation(0, shellcon.CSIDL_DESKTOP)
         desktop_item = shell.SHCreateItemFromIDList(desktop_pidl, shell.IID_IShellItem)
@@ -0,0 +1,419 @@
+// Bulk enumeration of scheduled work items.  Every task of a host is
+// activated and read in C++ without the GIL, and the results are converted
+// to columns at the end, so an audit costs one Python call per host instead
+// of a dozen per task.
+
+#include "PythonCOM.h"
+#include "mstask.h"
+#include "PyITaskTrigger.h"
+
+struct TASK_SNAPSHOT_ITEM {
+    LPWSTR name;
+    HRESULT err;  // from Activate, in which case nothing else was read
+    LPWSTR application, parameters, working_directory, comment, creator, account;
+    DWORD flags, priority, max_run_time, exit_code;
+    HRESULT status, exit_code_hr;
+    SYSTEMTIME most_recent_run, next_run;
+    BOOL has_most_recent_run, has_next_run;
+    WORD trigger_cnt;
+    TASK_TRIGGER *triggers;
+    LPWSTR *trigger_strings;
+};
+
+struct TASK_HOST_SNAPSHOT {
+    WCHAR *host;  // NULL for the local machine
+    HRESULT hr;
+    TASK_SNAPSHOT_ITEM *items;
+    ULONG item_cnt;
+};
+
+struct TASK_SNAPSHOT_WORK {
+    TASK_HOST_SNAPSHOT *hosts;
+    LONG host_cnt;
+    LONG next;
+};
+
+// Reads everything about one task, called without the GIL
+static void TaskSnapshotItem(ITaskScheduler *pITS, TASK_SNAPSHOT_ITEM *item)
+{
+    ITask *pIT = NULL;
+    item->err = pITS->Activate(item->name, IID_ITask, (IUnknown **)&pIT);
+    if (FAILED(item->err))
+        return;
+    // Getters for unset properties fail; the column item is then None.
+    pIT->GetApplicationName(&item->application);
+    pIT->GetParameters(&item->parameters);
+    pIT->GetWorkingDirectory(&item->working_directory);
+    pIT->GetComment(&item->comment);
+    pIT->GetCreator(&item->creator);
+    pIT->GetAccountInformation(&item->account);
+    pIT->GetFlags(&item->flags);
+    pIT->GetPriority(&item->priority);
+    pIT->GetMaxRunTime(&item->max_run_time);
+    pIT->GetStatus(&item->status);
+    item->exit_code_hr = pIT->GetExitCode(&item->exit_code);
+    item->has_most_recent_run = pIT->GetMostRecentRunTime(&item->most_recent_run) == S_OK;
+    item->has_next_run = pIT->GetNextRunTime(&item->next_run) == S_OK;
+    WORD trigger_cnt = 0;
+    if (SUCCEEDED(pIT->GetTriggerCount(&trigger_cnt)) && trigger_cnt) {
+        item->triggers = (TASK_TRIGGER *)calloc(trigger_cnt, sizeof(TASK_TRIGGER));
+        item->trigger_strings = (LPWSTR *)calloc(trigger_cnt, sizeof(LPWSTR));
+        if (item->triggers && item->trigger_strings) {
+            for (WORD i = 0; i < trigger_cnt; i++) {
+                ITaskTrigger *pITT = NULL;
+                item->triggers[i].cbTriggerSize = sizeof(TASK_TRIGGER);
+                if (SUCCEEDED(pIT->GetTrigger(i, &pITT))) {
+                    pITT->GetTrigger(&item->triggers[i]);
+                    pITT->Release();
+                }
+                pIT->GetTriggerString(i, &item->trigger_strings[i]);
+            }
+            item->trigger_cnt = trigger_cnt;
+        }
+    }
+    pIT->Release();
+}
+
+// Enumerates and reads all work items of one host, called without the GIL
+static void TaskSnapshotHost(TASK_HOST_SNAPSHOT *s)
+{
+    ITaskScheduler *pITS = NULL;
+    IEnumWorkItems *pIEWI = NULL;
+    ULONG item_alloc = 0;
+    s->hr = CoCreateInstance(CLSID_CTaskScheduler, NULL, CLSCTX_INPROC_SERVER, IID_ITaskScheduler, (void **)&pITS);
+    if (FAILED(s->hr))
+        return;
+    if (s->host)
+        s->hr = pITS->SetTargetComputer(s->host);
+    if (SUCCEEDED(s->hr))
+        s->hr = pITS->Enum(&pIEWI);
+    while (SUCCEEDED(s->hr)) {
+        LPWSTR *names = NULL;
+        ULONG fetched = 0;
+        HRESULT hr = pIEWI->Next(256, &names, &fetched);
+        if (FAILED(hr)) {
+            s->hr = hr;
+            break;
+        }
+        if (s->item_cnt + fetched > item_alloc) {
+            ULONG new_alloc = item_alloc ? item_alloc * 2 : 256;
+            while (new_alloc < s->item_cnt + fetched) new_alloc *= 2;
+            TASK_SNAPSHOT_ITEM *new_items =
+                (TASK_SNAPSHOT_ITEM *)realloc(s->items, new_alloc * sizeof(TASK_SNAPSHOT_ITEM));
+            if (new_items == NULL) {
+                for (ULONG i = 0; i < fetched; i++) CoTaskMemFree(names[i]);
+                CoTaskMemFree(names);
+                s->hr = E_OUTOFMEMORY;
+                break;
+            }
+            s->items = new_items;
+            item_alloc = new_alloc;
+        }
+        for (ULONG i = 0; i < fetched; i++) {
+            TASK_SNAPSHOT_ITEM *item = s->items + s->item_cnt++;
+            memset(item, 0, sizeof(*item));
+            item->name = names[i];
+            TaskSnapshotItem(pITS, item);
+        }
+        CoTaskMemFree(names);
+        if (hr == S_FALSE)
+            break;
+    }
+    if (pIEWI)
+        pIEWI->Release();
+    pITS->Release();
+}
+
+static DWORD WINAPI TaskSnapshotThread(LPVOID arg)
+{
+    TASK_SNAPSHOT_WORK *work = (TASK_SNAPSHOT_WORK *)arg;
+    LONG host_ind;
+    HRESULT hrinit = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+    while ((host_ind = InterlockedIncrement(&work->next) - 1) < work->host_cnt) {
+        if (FAILED(hrinit) && hrinit != RPC_E_CHANGED_MODE)
+            work->hosts[host_ind].hr = hrinit;
+        else
+            TaskSnapshotHost(&work->hosts[host_ind]);
+    }
+    if (SUCCEEDED(hrinit))
+        CoUninitialize();
+    return 0;
+}
+
+// Snapshots all hosts in the work list, using up to max_threads threads
+static void TaskRunSnapshot(TASK_SNAPSHOT_WORK *work, DWORD max_threads)
+{
+    HANDLE threads[MAXIMUM_WAIT_OBJECTS];
+    DWORD thread_cnt = 0;
+    if (work->host_cnt > 1) {
+        if (max_threads > (DWORD)work->host_cnt)
+            max_threads = work->host_cnt;
+        if (max_threads > MAXIMUM_WAIT_OBJECTS)
+            max_threads = MAXIMUM_WAIT_OBJECTS;
+        for (; thread_cnt < max_threads; thread_cnt++) {
+            threads[thread_cnt] = CreateThread(NULL, 0, TaskSnapshotThread, work, 0, NULL);
+            if (threads[thread_cnt] == NULL)
+                break;
+        }
+        if (thread_cnt) {
+            WaitForMultipleObjects(thread_cnt, threads, TRUE, INFINITE);
+            for (DWORD i = 0; i < thread_cnt; i++) CloseHandle(threads[i]);
+        }
+    }
+    // The calling thread is already in an apartment, so a single host is read
+    // here directly.  This also picks up hosts left over if threads could not
+    // be created.
+    LONG host_ind;
+    while ((host_ind = InterlockedIncrement(&work->next) - 1) < work->host_cnt)
+        TaskSnapshotHost(&work->hosts[host_ind]);
+}
+
+static void TaskFreeSnapshot(TASK_HOST_SNAPSHOT *s)
+{
+    for (ULONG i = 0; i < s->item_cnt; i++) {
+        TASK_SNAPSHOT_ITEM *item = s->items + i;
+        CoTaskMemFree(item->name);
+        CoTaskMemFree(item->application);
+        CoTaskMemFree(item->parameters);
+        CoTaskMemFree(item->working_directory);
+        CoTaskMemFree(item->comment);
+        CoTaskMemFree(item->creator);
+        CoTaskMemFree(item->account);
+        if (item->trigger_strings)
+            for (WORD t = 0; t < item->trigger_cnt; t++) CoTaskMemFree(item->trigger_strings[t]);
+        free(item->trigger_strings);
+        free(item->triggers);
+    }
+    free(s->items);
+    PyWinObject_FreeWCHAR(s->host);
+}
+
+static const char *task_snapshot_columns[] = {"Name",
+                                              "ApplicationName",
+                                              "Parameters",
+                                              "WorkingDirectory",
+                                              "Comment",
+                                              "Creator",
+                                              "AccountName",
+                                              "Flags",
+                                              "Priority",
+                                              "MaxRunTime",
+                                              "Status",
+                                              "ExitCode",
+                                              "ExitCodeError",
+                                              "MostRecentRunTime",
+                                              "NextRunTime",
+                                              "Triggers",
+                                              "TriggerStrings",
+                                              "Error",
+                                              NULL};
+enum {
+    TASKCOL_NAME,
+    TASKCOL_APPLICATIONNAME,
+    TASKCOL_PARAMETERS,
+    TASKCOL_WORKINGDIRECTORY,
+    TASKCOL_COMMENT,
+    TASKCOL_CREATOR,
+    TASKCOL_ACCOUNTNAME,
+    TASKCOL_FLAGS,
+    TASKCOL_PRIORITY,
+    TASKCOL_MAXRUNTIME,
+    TASKCOL_STATUS,
+    TASKCOL_EXITCODE,
+    TASKCOL_EXITCODEERROR,
+    TASKCOL_MOSTRECENTRUNTIME,
+    TASKCOL_NEXTRUNTIME,
+    TASKCOL_TRIGGERS,
+    TASKCOL_TRIGGERSTRINGS,
+    TASKCOL_ERROR,
+    TASKCOL_COUNT
+};
+
+static PyObject *TaskSnapshotValue(TASK_SNAPSHOT_ITEM *item, int col)
+{
+    if (col == TASKCOL_NAME)
+        return PyWinObject_FromWCHAR(item->name);
+    if (col == TASKCOL_ERROR)
+        return PyLong_FromLong(item->err);
+    if (FAILED(item->err)) {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+    switch (col) {
+        case TASKCOL_APPLICATIONNAME:
+            return PyWinObject_FromWCHAR(item->application);
+        case TASKCOL_PARAMETERS:
+            return PyWinObject_FromWCHAR(item->parameters);
+        case TASKCOL_WORKINGDIRECTORY:
+            return PyWinObject_FromWCHAR(item->working_directory);
+        case TASKCOL_COMMENT:
+            return PyWinObject_FromWCHAR(item->comment);
+        case TASKCOL_CREATOR:
+            return PyWinObject_FromWCHAR(item->creator);
+        case TASKCOL_ACCOUNTNAME:
+            return PyWinObject_FromWCHAR(item->account);
+        case TASKCOL_FLAGS:
+            return PyLong_FromUnsignedLong(item->flags);
+        case TASKCOL_PRIORITY:
+            return PyLong_FromUnsignedLong(item->priority);
+        case TASKCOL_MAXRUNTIME:
+            return PyLong_FromUnsignedLong(item->max_run_time);
+        case TASKCOL_STATUS:
+            return PyLong_FromLong(item->status);
+        case TASKCOL_EXITCODE:
+            return PyLong_FromUnsignedLong(item->exit_code);
+        case TASKCOL_EXITCODEERROR:
+            return PyLong_FromLong(item->exit_code_hr);
+        case TASKCOL_MOSTRECENTRUNTIME:
+            if (item->has_most_recent_run)
+                return PyWinObject_FromSYSTEMTIME(item->most_recent_run);
+            break;
+        case TASKCOL_NEXTRUNTIME:
+            if (item->has_next_run)
+                return PyWinObject_FromSYSTEMTIME(item->next_run);
+            break;
+        case TASKCOL_TRIGGERS:
+        case TASKCOL_TRIGGERSTRINGS: {
+            PyObject *ret = PyTuple_New(item->trigger_cnt);
+            if (ret == NULL)
+                return NULL;
+            for (WORD t = 0; t < item->trigger_cnt; t++) {
+                PyObject *ob;
+                if (col == TASKCOL_TRIGGERS)
+                    ob = new PyTASK_TRIGGER(&item->triggers[t]);
+                else
+                    ob = PyWinObject_FromWCHAR(item->trigger_strings[t]);
+                if (ob == NULL) {
+                    Py_DECREF(ret);
+                    return NULL;
+                }
+                PyTuple_SET_ITEM(ret, t, ob);
+            }
+            return ret;
+        }
+    }
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// Builds the table for one host.
+static PyObject *TaskSnapshotTable(TASK_HOST_SNAPSHOT *s)
+{
+    PyObject *ret = PyDict_New();
+    if (ret == NULL)
+        return NULL;
+    for (int c = 0; c < TASKCOL_COUNT; c++) {
+        PyObject *col = PyTuple_New(s->item_cnt);
+        if (col == NULL) {
+            Py_DECREF(ret);
+            return NULL;
+        }
+        for (ULONG i = 0; i < s->item_cnt; i++) {
+            PyObject *item = TaskSnapshotValue(s->items + i, c);
+            if (item == NULL) {
+                Py_DECREF(col);
+                Py_DECREF(ret);
+                return NULL;
+            }
+            PyTuple_SET_ITEM(col, i, item);
+        }
+        int rc = PyDict_SetItemString(ret, task_snapshot_columns[c], col);
+        Py_DECREF(col);
+        if (rc == -1) {
+            Py_DECREF(ret);
+            return NULL;
+        }
+    }
+    return ret;
+}
+
+// @pymethod dict/list|taskscheduler|EnumTasksSnapshot|Reads all scheduled work items of one or more
+// hosts in a single call.
+// @rdesc If Hosts is None or a string, returns a dict mapping each column name to a tuple with one
+// item per task.  The columns are Name, ApplicationName, Parameters, WorkingDirectory, Comment, Creator,
+// AccountName, Flags, Priority, MaxRunTime, Status, ExitCode, ExitCodeError, MostRecentRunTime,
+// NextRunTime, Triggers (a tuple of <o PyTASK_TRIGGER> objects), TriggerStrings and Error.  Error is
+// the HRESULT of activating the task; when it is a failure all other columns except Name are None.
+// Properties that are not set are also None, as are the run times of tasks that have not run or are
+// not scheduled.<nl>
+// If Hosts is a sequence, returns a list of (host, hresult, table) tuples in the same order, where
+// table is None if the host could not be enumerated.
+// @comm The tasks are activated and read with the GIL released.  Multiple hosts are read
+// concurrently, each on its own thread in the multi-threaded apartment.
+// A failure on a single host raises com_error.
+PyObject *PyEnumTasksSnapshot(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Hosts", "MaxThreads", NULL};
+    PyObject *obhosts = Py_None;
+    DWORD max_threads = 16;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|Ok:EnumTasksSnapshot", keywords,
+                                     &obhosts,       // @pyparm str/[str, ...]|Hosts|None|The computer to read, or a
+                                                     // sequence of computers.  None is the local machine.
+                                     &max_threads))  // @pyparm int|MaxThreads|16|The most hosts read at once.
+        return NULL;
+    BOOL bsingle = obhosts == Py_None || PyUnicode_Check(obhosts);
+    TASK_SNAPSHOT_WORK work = {NULL, 0, 0};
+    PyObject *ret = NULL;
+    LONG i;
+    if (bsingle) {
+        work.hosts = (TASK_HOST_SNAPSHOT *)calloc(1, sizeof(TASK_HOST_SNAPSHOT));
+        if (work.hosts == NULL)
+            return PyErr_NoMemory();
+        work.host_cnt = 1;
+        if (!PyWinObject_AsWCHAR(obhosts, &work.hosts[0].host, TRUE))
+            goto done;
+    }
+    else {
+        TmpPyObject seq = PySequence_Fast(obhosts, "Hosts must be None, a string or a sequence of strings");
+        if (seq == NULL)
+            return NULL;
+        Py_ssize_t cnt = PySequence_Fast_GET_SIZE((PyObject *)seq);
+        work.hosts = (TASK_HOST_SNAPSHOT *)calloc(cnt ? cnt : 1, sizeof(TASK_HOST_SNAPSHOT));
+        if (work.hosts == NULL)
+            return PyErr_NoMemory();
+        for (; work.host_cnt < cnt; work.host_cnt++)
+            if (!PyWinObject_AsWCHAR(PySequence_Fast_GET_ITEM((PyObject *)seq, work.host_cnt),
+                                     &work.hosts[work.host_cnt].host, TRUE))
+                goto done;
+    }
+    if (max_threads == 0)
+        max_threads = 1;
+
+    Py_BEGIN_ALLOW_THREADS;
+    TaskRunSnapshot(&work, max_threads);
+    Py_END_ALLOW_THREADS;
+
+    if (bsingle) {
+        if (FAILED(work.hosts[0].hr))
+            PyCom_BuildPyException(work.hosts[0].hr);
+        else
+            ret = TaskSnapshotTable(&work.hosts[0]);
+        goto done;
+    }
+    ret = PyList_New(work.host_cnt);
+    if (ret == NULL)
+        goto done;
+    for (i = 0; i < work.host_cnt; i++) {
+        TASK_HOST_SNAPSHOT *s = work.hosts + i;
+        PyObject *table;
+        if (FAILED(s->hr)) {
+            Py_INCREF(Py_None);
+            table = Py_None;
+        }
+        else if ((table = TaskSnapshotTable(s)) == NULL) {
+            Py_CLEAR(ret);
+            goto done;
+        }
+        PyObject *item = Py_BuildValue("NlN", PyWinObject_FromWCHAR(s->host), s->hr, table);
+        if (item == NULL) {
+            Py_CLEAR(ret);
+            goto done;
+        }
+        PyList_SET_ITEM(ret, i, item);
+    }
+
+done:
+    for (i = 0; i < work.host_cnt; i++) TaskFreeSnapshot(work.hosts + i);
+    free(work.hosts);
+    return ret;
+}
@@ -7,7 +7,14 @@
 #include "PyITaskTrigger.h"
 #include "PyIProvideTaskPage.h"
 
-static struct PyMethodDef taskscheduler_methods[] = {NULL};
+// From TaskSnapshot.cpp
+extern PyObject *PyEnumTasksSnapshot(PyObject *self, PyObject *args, PyObject *kwargs);
+
+// @module taskscheduler|Supports the Scheduled Tasks COM interfaces
+static struct PyMethodDef taskscheduler_methods[] = {
+    // @pymeth EnumTasksSnapshot|Reads all work items of one or more hosts
+    {"EnumTasksSnapshot", (PyCFunction)PyEnumTasksSnapshot, METH_VARARGS | METH_KEYWORDS},
+    {NULL}};
 
 static const PyCom_InterfaceSupportInfo register_data[] = {
     PYCOM_INTERFACE_CLSID_ONLY(CTaskScheduler),  PYCOM_INTERFACE_CLIENT_ONLY(TaskScheduler),
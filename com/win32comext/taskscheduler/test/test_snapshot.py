@@ -0,0 +1,27 @@
+import time
+from win32com.taskscheduler import taskscheduler
+
+start = time.perf_counter()
+table = taskscheduler.EnumTasksSnapshot()
+print(
+    "Read %d tasks in %.3f seconds"
+    % (len(table["Name"]), time.perf_counter() - start)
+)
+for name, app, params, status, next_run, triggers in zip(
+    table["Name"],
+    table["ApplicationName"],
+    table["Parameters"],
+    table["Status"],
+    table["NextRunTime"],
+    table["TriggerStrings"],
+):
+    print(name, app, params, hex(status & 0xFFFFFFFF), next_run)
+    for trigger in triggers:
+        print("   ", trigger)
+
+## several hosts are read concurrently, one table per host
+for host, hr, table in taskscheduler.EnumTasksSnapshot([None, "localhost"]):
+    if table is None:
+        print(host, "failed with", hex(hr & 0xFFFFFFFF))
+    else:
+        print(host, len(table["Name"]), "tasks")
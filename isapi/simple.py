@@ -37,6 +37,10 @@ class SimpleExtension:
 class SimpleFilter:
     "Base class for a a simple ISAPI filter"
     filter_flags = None
+    # A sequence of (notifications, urlPrefix, header, headerValue) tuples,
+    # passed to HTTP_FILTER_VERSION.AddRouteRule - trailing items may be
+    # omitted.  Notifications no route matches never reach HttpFilterProc.
+    filter_routes = None
     def __init__(self):
         pass
 
@@ -46,7 +50,8 @@ class SimpleFilter:
         The default implementation uses the classes docstring to
         set the extension description, and uses the classes
         filter_flags attribute to set the ISAPI filter flags - you
-        must specify filter_flags in your class.
+        must specify filter_flags in your class.  Any filter_routes
+        are added too.
         """
         if self.filter_flags is None:
             raise RuntimeError("You must specify the filter flags")
@@ -54,6 +59,8 @@ class SimpleFilter:
         if fv is not None:
             fv.Flags = self.filter_flags
             fv.FilterDesc = self.__doc__
+            for route in self.filter_routes or ():
+                fv.AddRouteRule(*route)
 
     def HttpFilterProc(self, fc):
         """Called by the ISAPI framework for each filter request.
@@ -70,6 +70,11 @@ class CControlBlock {
         return (m_pECB->ServerSupportFunction)(m_pECB->ConnID, DWORD HSE_REQ_TRANSMIT_FILE, info, 0, 0) ? true : false;
     }
 
+    bool VectorSend(HSE_RESPONSE_VECTOR *vec)
+    {
+        return (m_pECB->ServerSupportFunction)(m_pECB->ConnID, HSE_REQ_VECTOR_SEND, vec, 0, 0) ? true : false;
+    }
+
     BOOL Redirect(char *url)
     {
         DWORD buffSize = (DWORD)strlen(url);
@@ -27,6 +27,7 @@
 #include "Utils.h"
 #include "PyExtensionObjects.h"
 #include "PythonEng.h"
+#include "pyISAPI.h"
 
 // Asynch IO callbacks are a little tricky, as we never know how many
 // callbacks a single connection might make (often each callback will trigger
@@ -56,8 +57,80 @@ BOOL SetupIOCallback(EXTENSION_CONTROL_BLOCK *ecb, PyObject *ob)
     return TRUE;
 }
 
+// The buffer of an outstanding asynchronous read or write must live until
+// IIS has finished with it - so we hold a view of it in another map, keyed
+// the same way, until the IO callback for it has been made.
+static PyObject *g_ioBufferMap = NULL;
+
+static void ReleaseIOBuffer(PyObject *capsule)
+{
+    Py_buffer *pybuf = (Py_buffer *)PyCapsule_GetPointer(capsule, "isapi.iobuffer");
+    PyBuffer_Release(pybuf);
+    delete pybuf;
+}
+
+// Holds ob (typically a capsule owning the buffers) until the IO callback.
+static BOOL HoldIOObject(EXTENSION_CONTROL_BLOCK *ecb, PyObject *ob)
+{
+    BOOL ok = FALSE;
+    PyObject *key = NULL;
+    if ((g_ioBufferMap || (g_ioBufferMap = PyDict_New()) != NULL) && (key = PyLong_FromVoidPtr(ecb->ConnID)) != NULL)
+        ok = PyDict_SetItem(g_ioBufferMap, key, ob) == 0;
+    Py_XDECREF(key);
+    return ok;
+}
+
+// Takes over the view in *pybuf, releasing it on failure.
+static BOOL HoldIOBuffer(EXTENSION_CONTROL_BLOCK *ecb, Py_buffer *pybuf)
+{
+    Py_buffer *pheld = new Py_buffer(*pybuf);
+    PyObject *capsule = PyCapsule_New(pheld, "isapi.iobuffer", ReleaseIOBuffer);
+    if (!capsule) {
+        PyBuffer_Release(pheld);
+        delete pheld;
+        return FALSE;
+    }
+    BOOL ok = HoldIOObject(ecb, capsule);
+    Py_DECREF(capsule);
+    return ok;
+}
+
+// Returns the held buffer (or NULL) - the caller releases it by dropping the reference.
+static PyObject *TakeIOBuffer(EXTENSION_CONTROL_BLOCK *ecb)
+{
+    if (!g_ioBufferMap)
+        return NULL;
+    PyObject *key = PyLong_FromVoidPtr(ecb->ConnID);
+    if (!key) {
+        PyErr_Clear();
+        return NULL;
+    }
+    PyObject *ret = PyDict_GetItem(g_ioBufferMap, key);
+    if (ret) {
+        Py_INCREF(ret);
+        PyDict_DelItem(g_ioBufferMap, key);
+    }
+    Py_DECREF(key);
+    return ret;
+}
+
+static BOOL HaveIOCallback(EXTENSION_CONTROL_BLOCK *ecb)
+{
+    if (!g_callbackMap)
+        return FALSE;
+    PyObject *key = PyLong_FromVoidPtr(ecb->ConnID);
+    if (!key) {
+        PyErr_Clear();
+        return FALSE;
+    }
+    BOOL ret = PyDict_GetItem(g_callbackMap, key) != NULL;
+    Py_DECREF(key);
+    return ret;
+}
+
 void CleanupIOCallback(EXTENSION_CONTROL_BLOCK *ecb)
 {
+    Py_XDECREF(TakeIOBuffer(ecb));
     if (!g_callbackMap)
         return;
     PyObject *key = PyLong_FromVoidPtr(ecb->ConnID);
@@ -87,6 +160,8 @@ extern "C" void WINAPI DoIOCallback(EXTENSION_CONTROL_BLOCK *ecb, PVOID pContext
     PyObject *key = NULL;
     PyObject *ob = NULL;
     PyObject *result = NULL;
+    // The operation is complete, but the callback may want to see the buffer.
+    PyObject *iobuffer = TakeIOBuffer(ecb);
 
     if (!g_callbackMap)
         CALLBACK_ERROR("Callback when no callback map exists");
@@ -124,6 +199,8 @@ done:
     // call DoneWithSession.  We still hold the GIL, so we should be
     // safe from races...
     Py_XDECREF(pyECB);
+    Py_XDECREF(key);
+    Py_XDECREF(iobuffer);
     if (!worked) {
         // free the item from the map.
         CleanupIOCallback(ecb);
@@ -177,6 +254,10 @@ PyObject *PyVERSION_INFO::getattro(PyObject *self, PyObject *obname)
     if (_tcscmp(name, _T("ExtensionDesc")) == 0) {
         return PyString_FromString(me->m_pvi->lpszExtensionDesc);
     }
+    if (_tcscmp(name, _T("WorkerThreads")) == 0)
+        return PyLong_FromUnsignedLong(g_dwWorkerThreads);
+    if (_tcscmp(name, _T("MaxQueuedRequests")) == 0)
+        return PyLong_FromUnsignedLong(g_dwMaxQueuedRequests);
     return PyObject_GenericGetAttr(self, obname);
 }
 
@@ -205,6 +286,23 @@ int PyVERSION_INFO::setattro(PyObject *self, PyObject *obname, PyObject *v)
         strcpy(me->m_pvi->lpszExtensionDesc, bytes);
         return 0;
     }
+    // @prop int|WorkerThreads|The number of native threads which run HttpExtensionProc.  When
+    // zero (the default) it runs on the IIS thread which received the request.  Otherwise
+    // requests are queued for the workers, HSE_STATUS_PENDING being returned to IIS, and
+    // once the handler returns anything other than HSE_STATUS_PENDING the session is ended
+    // with that status.  Each worker runs as the user IIS would have for the request.
+    // @prop int|MaxQueuedRequests|The most requests which may wait for a worker thread
+    // (default 1000) - beyond this, requests are refused with '503 Service Unavailable'.
+    else if (_tcscmp(name, _T("WorkerThreads")) == 0 || _tcscmp(name, _T("MaxQueuedRequests")) == 0) {
+        DWORD val = PyLong_AsUnsignedLong(v);
+        if (val == (DWORD)-1 && PyErr_Occurred())
+            return -1;
+        if (_tcscmp(name, _T("WorkerThreads")) == 0)
+            g_dwWorkerThreads = val;
+        else
+            g_dwMaxQueuedRequests = val;
+        return 0;
+    }
     else {
         return PyObject_GenericSetAttr(self, obname, v);
     }
@@ -229,16 +327,23 @@ struct PyMemberDef PyECB::members[] = {{"Version", T_INT, ECBOFF(m_version), REA
                                        {"TotalBytes", T_INT, ECBOFF(m_totalBytes), READONLY},
                                        {"AvailableBytes", T_INT, ECBOFF(m_available), READONLY},
                                        {"HttpStatusCode", T_INT, ECBOFF(m_HttpStatusCode)},
+                                       {"QueueTime", T_INT, ECBOFF(m_queueTime), READONLY},
                                        {NULL}};
 
 static struct PyMethodDef PyECB_methods[] = {
     {"write", PyECB::WriteClient, 1},  // @pymeth write|A synonym for WriteClient, this allows you to 'print >> ecb'
     {"WriteClient", PyECB::WriteClient, 1},                  // @pymeth WriteClient|
     {"GetServerVariable", PyECB::GetServerVariable, 1},      // @pymeth GetServerVariable|
+    {"GetServerVariables", PyECB::GetServerVariables,
+     1},  // @pymeth GetServerVariables|Fetches many server variables into a dictionary in one call.
     {"ReadClient", PyECB::ReadClient, 1},                    // @pymeth ReadClient|
+    {"ReadClientInto", PyECB::ReadClientInto,
+     1},  // @pymeth ReadClientInto|Reads request data into an existing buffer.
+    {"readinto", PyECB::ReadClientInto, 1},  // @pymeth readinto|A synonym for ReadClientInto, for file-like use.
     {"SendResponseHeaders", PyECB::SendResponseHeaders, 1},  // @pymeth SendResponseHeaders|
     {"SetFlushFlag", PyECB::SetFlushFlag, 1},                // @pymeth SetFlushFlag|
     {"TransmitFile", PyECB::TransmitFile, 1},                // @pymeth TransmitFile|
+    {"VectorSend", PyECB::VectorSend, 1},                    // @pymeth VectorSend|
     {"MapURLToPath", PyECB::MapURLToPath, 1},                // @pymeth MapURLToPath|
 
     {"DoneWithSession", PyECB::DoneWithSession, 1},  // @pymeth DoneWithSession|
@@ -257,6 +362,8 @@ static struct PyMethodDef PyECB_methods[] = {
      1},  // @pymeth IOCompletion|Calls ServerSupportFunction with HSE_REQ_IO_COMPLETION
     {"ReportUnhealthy", PyECB::ReportUnhealthy,
      1},  // @pymeth ReportUnhealthy|Calls ServerSupportFunction with HSE_REQ_REPORT_UNHEALTHY
+    {"GetPoolStatistics", PyECB::GetPoolStatistics,
+     1},  // @pymeth GetPoolStatistics|Returns the counters of the native worker pool.
     {NULL}};
 // @pymeth IOCallback|A placeholder for a user-supplied callback function.
 
@@ -307,7 +414,8 @@ PyECB::PyECB(CControlBlock *pcb)
       m_totalBytes(0),  // @prop int|TotalBytes|Total bytes indicated from client
       m_available(0),   // @prop int|AvailableBytes|Available number of bytes
       m_HttpStatusCode(
-          0)  // @prop int|HttpStatusCode|The status of the current transaction when the request is completed.
+          0),  // @prop int|HttpStatusCode|The status of the current transaction when the request is completed.
+      m_queueTime(0)  // @prop int|QueueTime|The milliseconds the request waited for a worker thread (read-only)
 
 // <keep a blank line above this for autoduck!> these props are managed manually...
 // @prop bytes|Method|REQUEST_METHOD
@@ -414,27 +522,100 @@ void PyECB::deallocFunc(PyObject *ob) { delete (PyECB *)ob; }
 PyObject *PyECB::WriteClient(PyObject *self, PyObject *args)
 {
     BOOL bRes = FALSE;
-    char *buffer = NULL;
-    Py_ssize_t buffLenIn = 0;
+    Py_buffer pybuf;
     DWORD buffLenOut = 0;
-    int reserved = 0;
+    DWORD flags = 0;
 
     PyECB *pecb = (PyECB *)self;
-    // @pyparm string/buffer|data||The data to write
-    // @pyparm int|reserved|0|
-    if (!PyArg_ParseTuple(args, "s#|l:WriteClient", &buffer, &buffLenIn, &reserved))
+    // @pyparm string/buffer|data||The data to write - any object supporting the buffer
+    // interface, which is written without being copied.
+    // @pyparm int|reserved|0|Flags for the write - HSE_IO_SYNC or HSE_IO_ASYNC.
+    if (!PyArg_ParseTuple(args, "s*|k:WriteClient", &pybuf, &flags))
         return NULL;
-
-    DWORD bytesWritten = 0;
-    buffLenOut = Py_SAFE_DOWNCAST(buffLenIn, Py_ssize_t, DWORD);
-    if (pecb->m_pcb) {
-        Py_BEGIN_ALLOW_THREADS bRes = pecb->m_pcb->WriteClient(buffer, &buffLenOut, reserved);
-        Py_END_ALLOW_THREADS if (!bRes) return SetPyECBError("WriteClient");
+    // @comm With HSE_IO_ASYNC the write is only started, and completes by calling the
+    // function set by <om EXTENSION_CONTROL_BLOCK.IOCompletion>, which must be called first.
+    // The data object is referenced until then, and must not be changed.
+    // Only one asynchronous operation may be outstanding for a request.
+
+    buffLenOut = Py_SAFE_DOWNCAST(pybuf.len, Py_ssize_t, DWORD);
+    if (!pecb->m_pcb) {
+        PyBuffer_Release(&pybuf);
+        return PyInt_FromLong(buffLenOut);
+    }
+    char *buffer = (char *)pybuf.buf;
+    if (flags & HSE_IO_ASYNC) {
+        EXTENSION_CONTROL_BLOCK *ecb = pecb->m_pcb->GetECB();
+        if (!HaveIOCallback(ecb)) {
+            PyBuffer_Release(&pybuf);
+            PyErr_SetString(PyExc_RuntimeError, "IOCompletion must be called before an asynchronous write");
+            return NULL;
+        }
+        if (!HoldIOBuffer(ecb, &pybuf))
+            return NULL;
+        Py_BEGIN_ALLOW_THREADS bRes = pecb->m_pcb->WriteClient(buffer, &buffLenOut, flags);
+        Py_END_ALLOW_THREADS if (!bRes)
+        {
+            // No callback will be made for a write which failed to start.
+            DWORD err = GetLastError();
+            Py_XDECREF(TakeIOBuffer(ecb));
+            return SetPyECBError("WriteClient", err);
+        }
+        return PyInt_FromLong(buffLenOut);
     }
+    Py_BEGIN_ALLOW_THREADS bRes = pecb->m_pcb->WriteClient(buffer, &buffLenOut, flags);
+    Py_END_ALLOW_THREADS PyBuffer_Release(&pybuf);
+    if (!bRes)
+        return SetPyECBError("WriteClient");
     return PyInt_FromLong(buffLenOut);
     // @rdesc the result is the number of bytes written.
 }
 
+// Fetches a server variable into buf, or if it won't fit, a larger buffer which
+// the caller must free.  Returns NULL only if out of memory.  On return *pbufsize
+// is the size of the value and *pbRes whether it was fetched.
+static char *FetchServerVariable(CControlBlock *pcb, char *variable, char *buf, DWORD *pbufsize, BOOL *pbRes)
+{
+    DWORD bufsize = *pbufsize;
+    char *bufUse = buf;
+    BOOL bRes = pcb->GetServerVariable(variable, buf, pbufsize);
+    if (!bRes && GetLastError() == ERROR_INSUFFICIENT_BUFFER) {
+        // Although the IIS docs say it should be good, IIS5
+        // returns -1 for 'bufsize' and MS samples show not
+        // to trust it too.  Like the MS sample, we max out
+        // at some value - we choose 64k.  We double each
+        // time, meaning we get 3 goes around the loop
+        bufUse = NULL;
+        for (int i = 0; i < 3; i++) {
+            bufsize *= 2;
+            char *bufNew = (char *)realloc(bufUse, bufsize);
+            if (!bufNew) {
+                free(bufUse);
+                return NULL;
+            }
+            bufUse = bufNew;
+            *pbufsize = bufsize;
+            bRes = pcb->GetServerVariable(variable, bufUse, pbufsize);
+            if (bRes || GetLastError() != ERROR_INSUFFICIENT_BUFFER)
+                break;
+        }
+        if (!bRes) {
+            // Keep the error for our caller.
+            DWORD err = GetLastError();
+            free(bufUse);
+            bufUse = buf;
+            SetLastError(err);
+        }
+    }
+    *pbRes = bRes;
+    return bufUse;
+}
+
+static PyObject *ServerVariableValue(const char *variable, const char *buf, DWORD bufsize)
+{
+    return strncmp("UNICODE_", variable, 8) == 0 ? PyUnicode_FromWideChar((WCHAR *)buf, bufsize / sizeof(WCHAR))
+                                                 : PyString_FromStringAndSize(buf, bufsize);
+}
+
 // @pymethod string|EXTENSION_CONTROL_BLOCK|GetServerVariable|
 // @rdesc The result is a string object, unless the server variable name
 // begins with 'UNICODE_', in which case it is a unicode object - see the
@@ -457,30 +638,10 @@ PyObject *PyECB::GetServerVariable(PyObject *self, PyObject *args)
     char *bufUse = buf;
 
     if (pecb->m_pcb) {
-        bRes = pecb->m_pcb->GetServerVariable(variable, buf, &bufsize);
-        if (!bRes && GetLastError() == ERROR_INSUFFICIENT_BUFFER) {
-            // Although the IIS docs say it should be good, IIS5
-            // returns -1 for 'bufsize' and MS samples show not
-            // to trust it too.  Like the MS sample, we max out
-            // at some value - we choose 64k.  We double each
-            // time, meaning we get 3 goes around the loop
-            bufUse = NULL;
-            bufsize = sizeof(buf);
-            for (int i = 0; i < 3; i++) {
-                bufsize *= 2;
-                bufUse = (char *)realloc(bufUse, bufsize);
-                if (!bufUse)
-                    break;
-                bRes = pecb->m_pcb->GetServerVariable(variable, bufUse, &bufsize);
-                if (bRes || GetLastError() != ERROR_INSUFFICIENT_BUFFER)
-                    break;
-            }
-        }
+        bufUse = FetchServerVariable(pecb->m_pcb, variable, buf, &bufsize, &bRes);
         if (!bufUse)
             return PyErr_NoMemory();
         if (!bRes) {
-            if (bufUse != buf)
-                free(bufUse);
             if (def) {
                 Py_INCREF(def);
                 return def;
@@ -488,14 +649,129 @@ PyObject *PyECB::GetServerVariable(PyObject *self, PyObject *args)
             return SetPyECBError("GetServerVariable");
         }
     }
-    PyObject *ret = strncmp("UNICODE_", variable, 8) == 0
-                        ? PyUnicode_FromWideChar((WCHAR *)bufUse, bufsize / sizeof(WCHAR))
-                        : PyString_FromStringAndSize(bufUse, bufsize);
+    PyObject *ret = ServerVariableValue(variable, bufUse, bufsize);
     if (bufUse != buf)
         free(bufUse);
     return ret;
 }
 
+// Adds each "HTTP_NAME:value\n" line of an ALL_HTTP value to dict.
+static bool AddAllHttpVariables(PyObject *dict, char *buf, DWORD bufsize)
+{
+    char *end = buf + bufsize;
+    char *line = buf;
+    while (line < end) {
+        char *eol = (char *)memchr(line, '\n', end - line);
+        if (eol == NULL)
+            eol = end;
+        char *colon = (char *)memchr(line, ':', eol - line);
+        if (colon && colon > line) {
+            *colon = '\0';
+            char *valEnd = eol;
+            if (valEnd > colon + 1 && valEnd[-1] == '\r')
+                valEnd--;
+            PyObject *key = PyISAPIString_InternFromString(line);
+            PyObject *val = PyString_FromStringAndSize(colon + 1, valEnd - (colon + 1));
+            bool ok = key && val && PyDict_SetItem(dict, key, val) == 0;
+            Py_XDECREF(key);
+            Py_XDECREF(val);
+            if (!ok)
+                return false;
+        }
+        line = eol + 1;
+    }
+    return true;
+}
+
+// @pymethod dict|EXTENSION_CONTROL_BLOCK|GetServerVariables|Fetches many server variables into a
+// dictionary in one call.
+PyObject *PyECB::GetServerVariables(PyObject *self, PyObject *args)
+{
+    PyObject *obNames = Py_None;
+    PyObject *obAllHttp = Py_None;
+    PyECB *pecb = (PyECB *)self;
+    // @pyparm [string, ...]|names|None|The names of the variables to fetch.  Variables which
+    // can't be fetched are left out of the result.
+    // @pyparm bool|allHttp|None|If true, the ALL_HTTP variable is fetched, and each request header
+    // it holds added under its CGI name (eg, HTTP_USER_AGENT).  The default is true only if names
+    // is None.
+    if (!PyArg_ParseTuple(args, "|OO:GetServerVariables", &obNames, &obAllHttp))
+        return NULL;
+    // @comm The values are as returned by <om EXTENSION_CONTROL_BLOCK.GetServerVariable>.  The
+    // keys are interned strings, so a WSGI environ, for example, can be built with a single call.
+    int bAllHttp = obAllHttp == Py_None ? obNames == Py_None : PyObject_IsTrue(obAllHttp);
+    if (bAllHttp == -1)
+        return NULL;
+    if (!pecb->Check())
+        return NULL;
+    PyObject *obFast = NULL;
+    if (obNames != Py_None && (obFast = PySequence_Fast(obNames, "names must be a sequence of strings")) == NULL)
+        return NULL;
+    PyObject *ret = PyDict_New();
+    if (ret == NULL)
+        goto error;
+    char buf[8192];
+    if (bAllHttp) {
+        DWORD bufsize = sizeof(buf);
+        BOOL bRes;
+        char *bufUse = FetchServerVariable(pecb->m_pcb, "ALL_HTTP", buf, &bufsize, &bRes);
+        if (!bufUse) {
+            PyErr_NoMemory();
+            goto error;
+        }
+        bool ok = !bRes || AddAllHttpVariables(ret, bufUse, bufsize);
+        if (bufUse != buf)
+            free(bufUse);
+        if (!ok)
+            goto error;
+    }
+    if (obFast) {
+        Py_ssize_t n = PySequence_Fast_GET_SIZE(obFast);
+        for (Py_ssize_t i = 0; i < n; i++) {
+            PyObject *obName = PySequence_Fast_GET_ITEM(obFast, i);
+            const char *name;
+#if (PY_VERSION_HEX >= 0x03000000)
+            if (PyUnicode_Check(obName))
+                name = PyUnicode_AsUTF8(obName);
+            else
+#endif
+                if (PyString_Check(obName))
+                name = PyString_AsString(obName);
+            else {
+                PyErr_Format(PyExc_TypeError, "names must be strings (got %s)", obName->ob_type->tp_name);
+                goto error;
+            }
+            if (name == NULL)
+                goto error;
+            DWORD bufsize = sizeof(buf);
+            BOOL bRes;
+            char *bufUse = FetchServerVariable(pecb->m_pcb, (char *)name, buf, &bufsize, &bRes);
+            if (!bufUse) {
+                PyErr_NoMemory();
+                goto error;
+            }
+            bool ok = true;
+            if (bRes) {
+                PyObject *key = PyISAPIString_InternFromString(name);
+                PyObject *val = ServerVariableValue(name, bufUse, bufsize);
+                ok = key && val && PyDict_SetItem(ret, key, val) == 0;
+                Py_XDECREF(key);
+                Py_XDECREF(val);
+            }
+            if (bufUse != buf)
+                free(bufUse);
+            if (!ok)
+                goto error;
+        }
+        Py_DECREF(obFast);
+    }
+    return ret;
+error:
+    Py_XDECREF(obFast);
+    Py_XDECREF(ret);
+    return NULL;
+}
+
 // @pymethod string|EXTENSION_CONTROL_BLOCK|ReadClient|
 PyObject *PyECB::ReadClient(PyObject *self, PyObject *args)
 {
@@ -770,6 +1046,58 @@ PyObject *PyECB::GetExecURLStatus(PyObject *self, PyObject *args)
 // @pyparm int|dwError||The error code returned.
 // @rdesc The result of this function is ignored.
 
+// @pymethod int|EXTENSION_CONTROL_BLOCK|ReadClientInto|Reads request data into an existing buffer.
+PyObject *PyECB::ReadClientInto(PyObject *self, PyObject *args)
+{
+    PyECB *pecb = (PyECB *)self;
+    Py_buffer pybuf;
+    DWORD flags = 0;
+    // @pyparm buffer|buffer||A writable object supporting the buffer interface, such as a
+    // bytearray or memoryview.
+    // @pyparm int|flags|0|HSE_IO_ASYNC to start an asynchronous read.
+    if (!PyArg_ParseTuple(args, "w*|k:ReadClientInto", &pybuf, &flags))
+        return NULL;
+    if (!pecb->Check()) {
+        PyBuffer_Release(&pybuf);
+        return NULL;
+    }
+    // @comm Reads data which has not already been read by IIS (see the AvailableData attribute),
+    // as for <om EXTENSION_CONTROL_BLOCK.ReadClient>, but without allocating a new string for it,
+    // so a large request body can be processed in chunks.
+    // <nl>With HSE_IO_ASYNC the read is only started, and completes by calling the function set
+    // by <om EXTENSION_CONTROL_BLOCK.IOCompletion> with the number of bytes read.  The buffer is
+    // referenced until then.
+    EXTENSION_CONTROL_BLOCK *ecb = pecb->m_pcb->GetECB();
+    DWORD size = Py_SAFE_DOWNCAST(pybuf.len, Py_ssize_t, DWORD);
+    void *buffer = pybuf.buf;
+    BOOL bRes;
+    if (flags & HSE_IO_ASYNC) {
+        if (!HaveIOCallback(ecb)) {
+            PyBuffer_Release(&pybuf);
+            PyErr_SetString(PyExc_RuntimeError, "IOCompletion must be called before an asynchronous read");
+            return NULL;
+        }
+        if (!HoldIOBuffer(ecb, &pybuf))
+            return NULL;
+        Py_BEGIN_ALLOW_THREADS bRes =
+            ecb->ServerSupportFunction(ecb->ConnID, HSE_REQ_ASYNC_READ_CLIENT, buffer, &size, &flags);
+        Py_END_ALLOW_THREADS if (!bRes)
+        {
+            DWORD err = GetLastError();
+            Py_XDECREF(TakeIOBuffer(ecb));
+            return SetPyECBError("ServerSupportFunction(HSE_REQ_ASYNC_READ_CLIENT)", err);
+        }
+        return PyInt_FromLong(0);
+    }
+    Py_BEGIN_ALLOW_THREADS bRes = pecb->m_pcb->ReadClient(buffer, &size);
+    Py_END_ALLOW_THREADS PyBuffer_Release(&pybuf);
+    if (!bRes)
+        return SetPyECBError("ReadClient");
+    return PyInt_FromLong(size);
+    // @rdesc The number of bytes read, zero once all the data has been read.  Always zero for an
+    // asynchronous read.
+}
+
 // @pymethod int|EXTENSION_CONTROL_BLOCK|IOCompletion|Set a callback that will be used for handling asynchronous I/O
 // operations.
 // @comm If you call this multiple times, the previous callback will be discarded.
@@ -918,6 +1246,153 @@ PyObject *PyECB::TransmitFile(PyObject *self, PyObject *args)
     return Py_None;
 }
 
+// Everything a vector send refers to, which must outlive an asynchronous send.
+struct VECTOR_SEND_STATE {
+    HSE_RESPONSE_VECTOR vec;
+    HSE_VECTOR_ELEMENT *elts;
+    Py_buffer *views;
+    Py_ssize_t n;
+    PyObject *obTuple;  // the elements
+    PyObject *obArgs;   // owns the header and status strings.
+};
+
+static void FreeVectorSendState(VECTOR_SEND_STATE *state)
+{
+    if (state->views) {
+        for (Py_ssize_t i = 0; i < state->n; i++)
+            if (state->views[i].obj)
+                PyBuffer_Release(&state->views[i]);
+        delete[] state->views;
+    }
+    delete[] state->elts;
+    Py_XDECREF(state->obTuple);
+    Py_XDECREF(state->obArgs);
+    delete state;
+}
+
+static void ReleaseVectorSendState(PyObject *capsule)
+{
+    FreeVectorSendState((VECTOR_SEND_STATE *)PyCapsule_GetPointer(capsule, "isapi.vectorsend"));
+}
+
+// @pymethod |EXTENSION_CONTROL_BLOCK|VectorSend|Calls ServerSupportFunction with HSE_REQ_VECTOR_SEND
+// @comm The response is sent directly from the buffers passed - no copy of the data is made.
+PyObject *PyECB::VectorSend(PyObject *self, PyObject *args)
+{
+    PyObject *obElements;
+    char *headers = NULL, *status = NULL;
+    DWORD flags = 0;
+    BOOL bFinal = FALSE, bKeepAlive = TRUE;
+    if (!PyArg_ParseTuple(args, "O|zzkii:VectorSend",
+                          &obElements,  // @pyparm [buffer\|(int, int, int), ...]|elements||The response body.  Each item is
+                                        // either a buffer to send, or a tuple of (hFile, offset, length) to send part of a
+                                        // file.  A length of 0 sends the file from offset to its end.
+                          &headers,     // @pyparm string|headers|None|If specified, the response headers are sent first.
+                          &status,      // @pyparm string|status|None|The status line, for example "200 OK".
+                          &flags,       // @pyparm int|flags|0|Additional HSE_IO_* flags.  Unless HSE_IO_ASYNC is
+                                        // given, HSE_IO_SYNC is added.
+                          &bFinal,      // @pyparm bool|final|False|If true, this is the last send of the response
+                                        // (HSE_IO_FINAL_SEND).
+                          &bKeepAlive   // @pyparm bool|keepAlive|True|If false, the connection is closed once the
+                                        // data is sent (HSE_IO_DISCONNECT_AFTER_SEND).
+                          ))
+        return NULL;
+    // @comm The headers and every element are sent by a single call into IIS, so a complete
+    // response costs one transition however many pieces it is built from.
+    // <nl>With HSE_IO_ASYNC the send is only started, and completes by calling the function set by
+    // <om EXTENSION_CONTROL_BLOCK.IOCompletion>, which must be called first.  The elements are
+    // referenced until then, and must not be changed.
+
+    PyECB *pecb = (PyECB *)self;
+    if (!pecb || !pecb->Check())
+        return NULL;
+    EXTENSION_CONTROL_BLOCK *ecb = pecb->m_pcb->GetECB();
+    BOOL bAsync = (flags & HSE_IO_ASYNC) != 0;
+    if (bAsync && !HaveIOCallback(ecb)) {
+        PyErr_SetString(PyExc_RuntimeError, "IOCompletion must be called before an asynchronous send");
+        return NULL;
+    }
+
+    PyObject *obTuple = PySequence_Tuple(obElements);
+    if (!obTuple)
+        return NULL;
+    Py_ssize_t i, n = PyTuple_GET_SIZE(obTuple);
+    PyObject *ret = NULL;
+    BOOL bRes;
+    VECTOR_SEND_STATE *state = new VECTOR_SEND_STATE;
+    memset(state, 0, sizeof(*state));
+    state->obTuple = obTuple;
+    state->obArgs = args;
+    Py_INCREF(args);
+    state->n = n;
+    state->elts = new HSE_VECTOR_ELEMENT[n ? n : 1];
+    state->views = new Py_buffer[n ? n : 1];
+    HSE_RESPONSE_VECTOR *vec = &state->vec;
+    HSE_VECTOR_ELEMENT *elts = state->elts;
+    Py_buffer *views = state->views;
+    memset(elts, 0, (n ? n : 1) * sizeof(HSE_VECTOR_ELEMENT));
+    memset(views, 0, (n ? n : 1) * sizeof(Py_buffer));
+    for (i = 0; i < n; i++) {
+        PyObject *ob = PyTuple_GET_ITEM(obTuple, i);
+        if (PyTuple_Check(ob)) {
+            PY_LONG_LONG hFile;  // as for TransmitFile
+            if (!PyArg_ParseTuple(ob, "LKK:VectorSend element", &hFile, &elts[i].cbOffset, &elts[i].cbSize))
+                goto done;
+            elts[i].ElementType = HSE_VECTOR_ELEMENT_TYPE_FILE_HANDLE;
+            elts[i].pvContext = (PVOID)hFile;
+        }
+        else {
+            if (PyObject_GetBuffer(ob, &views[i], PyBUF_SIMPLE) == -1) {
+                views[i].obj = NULL;
+                goto done;
+            }
+            elts[i].ElementType = HSE_VECTOR_ELEMENT_TYPE_MEMORY_BUFFER;
+            elts[i].pvContext = views[i].buf;
+            elts[i].cbSize = views[i].len;
+        }
+    }
+    vec->dwFlags = bAsync ? flags : flags | HSE_IO_SYNC;
+    if (bFinal)
+        vec->dwFlags |= HSE_IO_FINAL_SEND;
+    if (!bKeepAlive)
+        vec->dwFlags |= HSE_IO_DISCONNECT_AFTER_SEND;
+    if (headers) {
+        vec->dwFlags |= HSE_IO_SEND_HEADERS;
+        vec->pszHeaders = headers;
+        vec->pszStatus = status ? status : (char *)"200 OK";
+    }
+    vec->nElementCount = (DWORD)n;
+    vec->lpElementArray = elts;
+
+    if (bAsync) {
+        PyObject *capsule = PyCapsule_New(state, "isapi.vectorsend", ReleaseVectorSendState);
+        if (!capsule)
+            goto done;
+        // The capsule owns the state now.
+        state = NULL;
+        BOOL bHeld = HoldIOObject(ecb, capsule);
+        Py_DECREF(capsule);
+        if (!bHeld)
+            goto done;
+    }
+    Py_BEGIN_ALLOW_THREADS bRes = pecb->m_pcb->VectorSend(vec);
+    Py_END_ALLOW_THREADS if (!bRes)
+    {
+        DWORD err = GetLastError();
+        // No callback will be made for a send which failed to start.
+        if (bAsync)
+            Py_XDECREF(TakeIOBuffer(ecb));
+        SetPyECBError("ServerSupportFunction(HSE_REQ_VECTOR_SEND)", err);
+        goto done;
+    }
+    Py_INCREF(Py_None);
+    ret = Py_None;
+done:
+    if (state)
+        FreeVectorSendState(state);
+    return ret;
+}
+
 // @pymethod |EXTENSION_CONTROL_BLOCK|IsKeepAlive|
 // @comm This method simply checks a HTTP_CONNECTION header for 'keep-alive',
 // making it fairly useless.  See <om EXTENSION_CONTROL_BLOCK.IsKeepCon>
@@ -986,6 +1461,28 @@ PyObject *PyECB::DoneWithSession(PyObject *self, PyObject *args)
     return Py_None;
 }
 
+// Ends the session of a pooled request the handler has finished with.
+void PyECB::EndSession(DWORD status)
+{
+    CleanupIOCallback(m_pcb->GetECB());
+    Py_BEGIN_ALLOW_THREADS m_pcb->DoneWithSession(status);
+    Py_END_ALLOW_THREADS m_pcb->Done();
+    delete m_pcb;
+    m_pcb = NULL;
+}
+
+// @pymethod dict|EXTENSION_CONTROL_BLOCK|GetPoolStatistics|Returns the counters of the native worker pool.
+PyObject *PyECB::GetPoolStatistics(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":GetPoolStatistics"))
+        return NULL;
+    // @rdesc A dictionary with keys WorkerThreads, QueueDepth (requests now waiting), MaxQueueDepth,
+    // ActiveWorkers, Queued (requests queued in all), Rejected (refused as the queue was full),
+    // TotalQueueTime and MaxQueueTime (milliseconds requests waited for a worker).
+    // <nl>All are zero unless the <o HSE_VERSION_INFO> WorkerThreads attribute was set.
+    return GetWorkerPoolStatistics();
+}
+
 // Setup an exception
 
 PyObject *SetPyECBError(char *fnName, long err /*= 0*/)
@@ -49,11 +49,16 @@ class PyECB : public PyObject {
     DWORD m_totalBytes;      // Total bytes indicated from client
     DWORD m_available;       // Available number of bytes
     DWORD m_HttpStatusCode;  // The status of the current transaction when the request is completed.
+    DWORD m_queueTime;       // ms the request waited for a worker thread.
 
    public:
     PyECB(CControlBlock *pcb = NULL);
     ~PyECB();
 
+    void SetQueueTime(DWORD ms) { m_queueTime = ms; }
+    bool IsSessionOpen() { return m_pcb != NULL; }
+    void EndSession(DWORD status);
+
     BOOL Check()
     {
         if (!m_pcb || !m_pcb->GetECB()) {
@@ -71,7 +76,9 @@ class PyECB : public PyObject {
     // class methods
     static PyObject *WriteClient(PyObject *self, PyObject *args);
     static PyObject *GetServerVariable(PyObject *self, PyObject *args);
+    static PyObject *GetServerVariables(PyObject *self, PyObject *args);
     static PyObject *ReadClient(PyObject *self, PyObject *args);
+    static PyObject *ReadClientInto(PyObject *self, PyObject *args);
 
     // Server support function wrappers
 
@@ -85,6 +92,7 @@ class PyECB : public PyObject {
     static PyObject *GetImpersonationToken(PyObject *self, PyObject *args);  // HSE_REQ_GET_IMPERSONATION_TOKEN
     static PyObject *GetAnonymousToken(PyObject *self, PyObject *args);      // HSE_REQ_GET_ANONYMOUS_TOKEN
     static PyObject *TransmitFile(PyObject *self, PyObject *args);           // HSE_REQ_TRANSMIT_FILE
+    static PyObject *VectorSend(PyObject *self, PyObject *args);             // HSE_REQ_VECTOR_SEND
     static PyObject *MapURLToPath(PyObject *self, PyObject *args);           // HSE_REQ_MAP_URL_TO_PATH
     static PyObject *IsKeepConn(PyObject *self, PyObject *args);             // HSE_REQ_IS_KEEP_CONN
     static PyObject *SetFlushFlag(PyObject *self, PyObject *args);           // HSE_REQ_SET_FLUSH_FLAG
@@ -94,6 +102,7 @@ class PyECB : public PyObject {
     static PyObject *ReportUnhealthy(PyObject *self, PyObject *args);        // HSE_REQ_REPORT_UNHEALTHY
 
     static PyObject *IsSessionActive(PyObject *self, PyObject *args);
+    static PyObject *GetPoolStatistics(PyObject *self, PyObject *args);
     static struct PyMemberDef members[];
 };
 
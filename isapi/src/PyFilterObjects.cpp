@@ -26,11 +26,52 @@
 #include "stdafx.h"
 #include "Utils.h"
 #include "pyFilterObjects.h"
+#include "pyISAPI.h"
 
 // @doc
 
+// @pymethod |HTTP_FILTER_VERSION|AddRouteRule|Adds a rule deciding, before Python is
+// entered, which notifications are passed to HttpFilterProc.
+PyObject *PyFILTER_VERSION::AddRouteRule(PyObject *self, PyObject *args)
+{
+    DWORD notifications;
+    char *prefix = NULL, *header = NULL, *value = NULL;
+    if (!PyArg_ParseTuple(args, "k|zzz:AddRouteRule",
+                          &notifications,  // @pyparm int|notifications||The SF_NOTIFY_* flags the rule applies to.
+                          &prefix,  // @pyparm string|urlPrefix|None|If specified, the URL must start with this string.
+                          &header,  // @pyparm string|header|None|If specified, the request must have this header, for
+                                    // example "Content-Type".
+                          &value    // @pyparm string|headerValue|None|If specified, the header's value must contain
+                                    // this string.
+                          ))
+        return NULL;
+    // @comm Once any rule names a notification type, that notification is only
+    // passed to Python for requests matched by one of its rules - all others get
+    // SF_STATUS_REQ_NEXT_NOTIFICATION without the GIL being acquired.  Notification
+    // types no rule names are always passed on, as is anything which can't be
+    // decided natively, such as the URL of SF_NOTIFY_READ_RAW_DATA.
+    // <nl>Matching ignores case.  Rules can only be added in GetFilterVersion.
+    PyFILTER_VERSION *me = (PyFILTER_VERSION *)self;
+    if (!me->m_pfv)
+        return PyErr_Format(PyExc_RuntimeError, "FILTER_VERSION structure no longer exists");
+    if (!prefix && !header)
+        return PyErr_Format(PyExc_ValueError, "A rule needs a urlPrefix or a header");
+    if (value && !header)
+        return PyErr_Format(PyExc_ValueError, "headerValue can only be used with a header");
+    // We always see this notification for cleanup - it can't be routed.
+    notifications &= ~SF_NOTIFY_END_OF_NET_SESSION;
+    if (!AddFilterRouteRule(notifications, prefix, header, value))
+        return NULL;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
 // @object HTTP_FILTER_VERSION|A Python interface to the ISAPI HTTP_FILTER_VERSION
 // structure.
+static struct PyMethodDef PyFILTER_VERSION_methods[] = {
+    {"AddRouteRule", PyFILTER_VERSION::AddRouteRule, 1},  // @pymeth AddRouteRule|Adds a native notification route.
+    {NULL}};
+
 PyTypeObject PyFILTER_VERSIONType = {
     PYISAPI_OBJECT_HEAD "HTTP_FILTER_VERSION",
     sizeof(PyFILTER_VERSION),
@@ -51,6 +92,14 @@ PyTypeObject PyFILTER_VERSIONType = {
     PyFILTER_VERSION::setattro, /* tp_setattro */
     0,                          /*tp_as_buffer*/
     Py_TPFLAGS_DEFAULT,         /* tp_flags */
+    0,                          /* tp_doc */
+    0,                          /* tp_traverse */
+    0,                          /* tp_clear */
+    0,                          /* tp_richcompare */
+    0,                          /* tp_weaklistoffset */
+    0,                          /* tp_iter */
+    0,                          /* tp_iternext */
+    PyFILTER_VERSION_methods,   /* tp_methods */
 };
 
 PyFILTER_VERSION::PyFILTER_VERSION(HTTP_FILTER_VERSION *pfv)
@@ -84,7 +133,7 @@ PyObject *PyFILTER_VERSION::getattro(PyObject *self, PyObject *obname)
     if (_tcscmp(name, _T("FilterDesc")) == 0) {
         return PyString_FromString(me->m_pfv->lpszFilterDesc);
     }
-    return PyErr_Format(PyExc_AttributeError, "PyFILTER_VERSION has no attribute '%s'", name);
+    return PyObject_GenericGetAttr(self, obname);
 }
 
 int PyFILTER_VERSION::setattro(PyObject *self, PyObject *obname, PyObject *v)
@@ -397,6 +446,7 @@ PyHFC::PyHFC(CFilterContext *pfc)
     _Py_NewReference(this);
 
     m_pfc = pfc;
+    m_views = NULL;
 
     HTTP_FILTER_CONTEXT *phfc;
     VOID *pData;
@@ -410,6 +460,32 @@ PyHFC::~PyHFC()
 {
     if (m_pfc)
         delete m_pfc;
+    Py_XDECREF(m_views);
+}
+
+void PyHFC::Reset()
+{
+    m_pfc = NULL;
+    if (m_views) {
+        // The memory is IIS's, and is about to be reused or freed.  A view
+        // still exported to something else can't be released, but it is
+        // documented as only valid during the notification.
+        for (Py_ssize_t i = 0; i < PyList_GET_SIZE(m_views); i++) {
+            PyObject *ret = PyObject_CallMethod(PyList_GET_ITEM(m_views, i), "release", NULL);
+            if (ret)
+                Py_DECREF(ret);
+            else
+                PyErr_Clear();
+        }
+        Py_CLEAR(m_views);
+    }
+}
+
+BOOL PyHFC::TrackView(PyObject *view)
+{
+    if (!m_views && !(m_views = PyList_New(0)))
+        return FALSE;
+    return PyList_Append(m_views, view) == 0;
 }
 
 PyObject *PyHFC::getattro(PyObject *self, PyObject *obname)
@@ -721,6 +797,9 @@ void PyPREPROC_HEADERS::deallocFunc(PyObject *ob) { delete (PyPREPROC_HEADERS *)
 
 // @object HTTP_FILTER_RAW_DATA|A Python representation of an ISAPI
 // HTTP_FILTER_RAW_DATA structure.
+static struct PyMethodDef PyRAW_DATA_methods[] = {
+    {"ReplaceInData", PyRAW_DATA::ReplaceInData, 1},  // @pymeth ReplaceInData|Replaces the data seen by IIS.
+    {NULL}};
 
 PyTypeObject PyRAW_DATAType = {
     PYISAPI_OBJECT_HEAD "HTTP_FILTER_RAW_DATA",
@@ -742,6 +821,14 @@ PyTypeObject PyRAW_DATAType = {
     PyRAW_DATA::setattro, /* tp_setattro */
     0,                    /*tp_as_buffer*/
     Py_TPFLAGS_DEFAULT,   /* tp_flags */
+    0,                    /* tp_doc */
+    0,                    /* tp_traverse */
+    0,                    /* tp_clear */
+    0,                    /* tp_richcompare */
+    0,                    /* tp_weaklistoffset */
+    0,                    /* tp_iter */
+    0,                    /* tp_iternext */
+    PyRAW_DATA_methods,   /* tp_methods */
 };
 
 PyRAW_DATA::PyRAW_DATA(PyHFC *pParent)
@@ -767,6 +854,10 @@ HTTP_FILTER_RAW_DATA *PyRAW_DATA::GetRAW_DATA()
     HTTP_FILTER_CONTEXT *pFC;
     void *vdata;
     DWORD requestType;
+    if (!m_parent->GetFilterContext()) {
+        PyErr_SetString(PyExc_RuntimeError, "The notification has completed - its data no longer exists");
+        return NULL;
+    }
     m_parent->GetFilterContext()->GetFilterData(&pFC, &requestType, &vdata);
     assert(requestType == SF_NOTIFY_SEND_RAW_DATA || requestType == SF_NOTIFY_READ_RAW_DATA);
     return (HTTP_FILTER_RAW_DATA *)vdata;
@@ -786,36 +877,104 @@ PyObject *PyRAW_DATA::getattro(PyObject *self, PyObject *obname)
         }
         return PyString_FromStringAndSize((const char *)pRD->pvInData, pRD->cbInData);
     }
+    // @prop memoryview|InDataView|A writable view of the data itself, avoiding
+    // the copy made by InData.  The view is released when the notification
+    // completes, and must not be used after that.
+    if (_tcscmp(name, _T("InDataView")) == 0) {
+        if (pRD->pvInData == NULL) {
+            Py_INCREF(Py_None);
+            return Py_None;
+        }
+        PyObject *view = PyMemoryView_FromMemory((char *)pRD->pvInData, pRD->cbInData, PyBUF_WRITE);
+        if (view && !((PyRAW_DATA *)self)->m_parent->TrackView(view)) {
+            Py_DECREF(view);
+            return NULL;
+        }
+        return view;
+    }
+    // @prop int|InBufferSize|The size of the buffer holding the data, which
+    // <om HTTP_FILTER_RAW_DATA.ReplaceInData> can fill without allocating.
+    if (_tcscmp(name, _T("InBufferSize")) == 0)
+        return PyInt_FromLong(pRD->cbInBuffer);
 
     return PyObject_GenericGetAttr(self, obname);
 }
 
-int PyRAW_DATA::setattro(PyObject *self, PyObject *obname, PyObject *v)
+// Replaces the data, reusing the current buffer when it is big enough and
+// otherwise allocating with AllocMem so IIS frees it with the request.
+BOOL PyRAW_DATA::SetInData(const void *buf, DWORD cb, DWORD cbExtra)
 {
-    HTTP_FILTER_RAW_DATA *pRD = ((PyRAW_DATA *)self)->GetRAW_DATA();
-    HTTP_FILTER_CONTEXT *pFC = NULL;
-    ((PyRAW_DATA *)self)->m_parent->GetFilterContext()->GetFilterData(&pFC, NULL, NULL);
-    if (!pRD || !pFC)
+    HTTP_FILTER_RAW_DATA *pRD = GetRAW_DATA();
+    if (!pRD)
+        return FALSE;
+    HTTP_FILTER_CONTEXT *pFC = GetFILTER_CONTEXT();
+    if (pRD->pvInData == NULL || cb > pRD->cbInBuffer) {
+        DWORD cbAlloc = cb + cbExtra;
+        if (cbAlloc < cb) {
+            PyErr_SetString(PyExc_OverflowError, "The data is too large");
+            return FALSE;
+        }
+        void *nb = pFC->AllocMem(pFC, cbAlloc ? cbAlloc : 1, 0);
+        if (!nb) {
+            PyErr_NoMemory();
+            return FALSE;
+        }
+        pRD->pvInData = nb;
+        pRD->cbInBuffer = cbAlloc;
+    }
+    // memmove, as the source may be a view of the data itself.
+    memmove(pRD->pvInData, buf, cb);
+    pRD->cbInData = cb;
+    return TRUE;
+}
+
+// @pymethod |HTTP_FILTER_RAW_DATA|ReplaceInData|Replaces the data seen by IIS.
+// @comm The data is copied into the existing buffer when it fits, so a filter
+// which transforms the data in place or shrinks it makes no allocation at all.
+// Otherwise a buffer is allocated with the filter context's AllocMem, and
+// freed by IIS when the request completes.
+PyObject *PyRAW_DATA::ReplaceInData(PyObject *self, PyObject *args)
+{
+    PyObject *obdata;
+    DWORD cbExtra = 0;
+    // @pyparm buffer|data||The new data - any object supporting the buffer interface.
+    // @pyparm int|extra|0|Extra space to allocate if a new buffer is needed, so
+    // later, larger replacements can reuse it.
+    if (!PyArg_ParseTuple(args, "O|k:ReplaceInData", &obdata, &cbExtra))
+        return NULL;
+    Py_buffer pybuf;
+    if (PyObject_GetBuffer(obdata, &pybuf, PyBUF_SIMPLE) == -1)
         return NULL;
+    BOOL ok;
+    if (pybuf.len > MAXDWORD) {
+        PyErr_SetString(PyExc_OverflowError, "The data is too large");
+        ok = FALSE;
+    }
+    else
+        ok = ((PyRAW_DATA *)self)->SetInData(pybuf.buf, (DWORD)pybuf.len, cbExtra);
+    PyBuffer_Release(&pybuf);
+    if (!ok)
+        return NULL;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
 
+int PyRAW_DATA::setattro(PyObject *self, PyObject *obname, PyObject *v)
+{
     TCHAR *name = PYISAPI_ATTR_CONVERT(obname);
     if (_tcscmp(name, _T("InData")) == 0) {
-        if (!PyString_Check(v)) {
-            PyErr_Format(PyExc_TypeError, "InData must be a string (got %s)", v->ob_type->tp_name);
+        if (v == NULL || PyUnicode_Check(v)) {
+            PyErr_Format(PyExc_TypeError, "InData must be bytes (got %s)", v ? v->ob_type->tp_name : "NULL");
             return -1;
         }
-        int cch = PyString_Size(v);
-        void *nb = pFC->AllocMem(pFC, cch + sizeof(char), 0);
-        if (nb) {
-            pRD->cbInData = cch;
-            pRD->cbInBuffer = cch + 1;
-            pRD->pvInData = nb;
-        }
-        else {
-            PyErr_NoMemory();
+        Py_buffer pybuf;
+        if (PyObject_GetBuffer(v, &pybuf, PyBUF_SIMPLE) == -1)
             return -1;
-        }
-        return 0;
+        BOOL ok = pybuf.len <= MAXDWORD && ((PyRAW_DATA *)self)->SetInData(pybuf.buf, (DWORD)pybuf.len, 0);
+        if (!ok && !PyErr_Occurred())
+            PyErr_SetString(PyExc_OverflowError, "The data is too large");
+        PyBuffer_Release(&pybuf);
+        return ok ? 0 : -1;
     }
     return PyObject_GenericSetAttr(self, obname, v);
 }
@@ -41,6 +41,8 @@ class PyFILTER_VERSION : public PyObject {
     static void deallocFunc(PyObject *ob);
     static PyObject *getattro(PyObject *self, PyObject *ob);
     static int setattro(PyObject *self, PyObject *obname, PyObject *v);
+    // class methods
+    static PyObject *AddRouteRule(PyObject *self, PyObject *args);
 };
 
 class PyHFC : public PyObject {
@@ -49,8 +51,10 @@ class PyHFC : public PyObject {
    public:
     PyHFC(CFilterContext *pfc = NULL);
     ~PyHFC();
-    void Reset() { m_pfc = NULL; }
+    void Reset();
     CFilterContext *GetFilterContext() { return m_pfc; }
+    // Views of notification data are released by Reset, when the data goes away.
+    BOOL TrackView(PyObject *view);
 
    public:
     // Python support
@@ -72,6 +76,7 @@ class PyHFC : public PyObject {
     DWORD m_notificationType;
     DWORD m_revision;
     BOOL m_isSecurePort;
+    PyObject *m_views;
 };
 
 class PyURL_MAP : public PyObject {
@@ -114,12 +119,15 @@ class PyRAW_DATA : public PyObject {
     ~PyRAW_DATA();
     HTTP_FILTER_CONTEXT *GetFILTER_CONTEXT();
     HTTP_FILTER_RAW_DATA *GetRAW_DATA();
+    BOOL SetInData(const void *buf, DWORD cb, DWORD cbExtra);
 
    public:
     // Python support
     static void deallocFunc(PyObject *ob);
     static PyObject *getattro(PyObject *self, PyObject *obname);
     static int setattro(PyObject *self, PyObject *obname, PyObject *v);
+    // class methods
+    static PyObject *ReplaceInData(PyObject *self, PyObject *args);
 };
 
 class PyAUTHENT : public PyObject {
@@ -0,0 +1,796 @@
+// PyISAPI_loadtest.cpp - a load test host for ISAPI extensions.
+//
+// Loads an ISAPI extension DLL and drives HttpExtensionProc from a number of
+// threads with synthetic EXTENSION_CONTROL_BLOCKs, so the overhead of pyISAPI
+// (and of the Python extension behind it) can be measured without IIS.  The
+// control block callbacks are implemented here, and each is counted and timed.
+// The time each request takes is broken down into:
+//   dispatch  - from calling HttpExtensionProc to the first callback.  For
+//               pyISAPI, this is taking the GIL, creating the PyECB and
+//               calling into Python - or with its worker pool, the wait for a
+//               worker, as the worker's first callback fetches the token.
+//   handler   - from the first callback to the last, less the callbacks.
+//   callbacks - in the callbacks themselves, ie, this fake server.
+//   finish    - from the last callback until the request is complete.
+// With -g, another thread repeatedly times taking the GIL while the load runs,
+// as a measure of how contended it is.
+//
+// Usage: PyISAPI_loadtest [options] extension
+// where extension is either an ISAPI DLL, or a Python module (.py) - which is
+// loaded by a copy of the PyISAPI_loader.dll beside this program, named the
+// way isapi.install names it (ie, _module.dll).
+// Options:
+//   -t threads   Threads calling HttpExtensionProc (default 4)
+//   -n requests  Requests per thread (default 1000)
+//   -d seconds   Run for this long instead of a number of requests
+//   -u url       The URL requested - the query string follows any '?'
+//                (default /loadtest/hello)
+//   -b bytes     Send a POST with a body this size
+//   -H header    Add a request header, as "Name: value".  May be repeated.
+//   -g           Sample the time taken to acquire the GIL
+//   -j file      Also write the results to file, as JSON
+
+#include "windows.h"
+#include "tchar.h"
+#include <httpext.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define PY_SSIZE_T_CLEAN
+// windows defines "small" as "char" which breaks Python's accu.h
+#undef small
+#include "Python.h"
+
+#define MAX_HEADERS 32
+#define PENDING_TIMEOUT 30000  // ms we wait for a pending request to finish.
+#define GIL_SAMPLE_INTERVAL 1  // ms between samples of the GIL.
+#define MAX_GIL_SAMPLES 1000000
+
+typedef BOOL(WINAPI *PFN_GETEXTENSIONVERSION)(HSE_VERSION_INFO *);
+typedef DWORD(WINAPI *PFN_HTTPEXTENSIONPROC)(EXTENSION_CONTROL_BLOCK *);
+typedef BOOL(WINAPI *PFN_TERMINATEEXTENSION)(DWORD);
+
+// What a request looks like - fixed for the run.
+struct LOADTEST_CONFIG {
+    DWORD dwThreads;
+    DWORD dwRequests;
+    DWORD dwSeconds;
+    char szMethod[16];
+    char szURL[2048];
+    char *szQuery;     // points into szURL, after the '?'
+    char *szPathInfo;  // the whole URL, as IIS gives wildcard mapped extensions
+    char szScriptName[2048];
+    char *pBody;
+    DWORD cbBody;
+    char *aszHeaderVars[MAX_HEADERS];  // "HTTP_NAME"
+    char *aszHeaderValues[MAX_HEADERS];
+    DWORD cHeaders;
+    char szAllHttp[8192];
+    BOOL bSampleGIL;
+    TCHAR *szJSON;
+};
+
+static LOADTEST_CONFIG g_config;
+static double g_dTicksPerSec;
+static volatile LONG g_bStop = FALSE;
+
+// The callbacks we count.
+enum {
+    CB_GETSERVERVARIABLE,
+    CB_WRITECLIENT,
+    CB_READCLIENT,
+    CB_SEND_HEADERS,
+    CB_VECTOR_SEND,
+    CB_TRANSMIT_FILE,
+    CB_ASYNC_READ,
+    CB_IO_COMPLETION,
+    CB_DONE_WITH_SESSION,
+    CB_OTHER,
+    CB_UNSUPPORTED,
+    NUM_CALLBACKS
+};
+static const char *g_aszCallbackNames[NUM_CALLBACKS] = {
+    "GetServerVariable", "WriteClient",  "ReadClient",      "SendResponseHeader",   "VectorSend", "TransmitFile",
+    "AsyncReadClient",   "IOCompletion", "DoneWithSession", "OtherSupportFunction", "Unsupported"};
+
+struct LOADTEST_STATS {
+    LONGLONG llRequests;
+    LONGLONG llErrors;
+    LONGLONG llPending;
+    LONGLONG llTimeouts;
+    LONGLONG llBytesSent;
+    LONGLONG llBytesRead;
+    LONGLONG llCalls[NUM_CALLBACKS];
+    LONGLONG llCallTicks[NUM_CALLBACKS];
+    LONGLONG llDispatchTicks;
+    LONGLONG llHandlerTicks;
+    LONGLONG llFinishTicks;
+    LONGLONG *pllLatencies;  // ticks for each request
+    DWORD cLatencies;
+    DWORD cMaxLatencies;
+};
+
+// A fake request.  Its ConnID is the request itself - IIS's are just as opaque.
+struct LOADTEST_REQUEST {
+    EXTENSION_CONTROL_BLOCK ecb;
+    HANDLE hDone;  // set by HSE_REQ_DONE_WITH_SESSION
+    DWORD dwDoneStatus;
+    PFN_HSE_IO_COMPLETION pfnIOCompletion;
+    void *pIOContext;
+    DWORD cbBodyRead;  // including the cbAvailable bytes in the ECB
+    volatile LONG lCallbacks;
+    LONGLONG llFirstCallback;
+    LONGLONG llLastCallback;
+    LONGLONG llCalls[NUM_CALLBACKS];
+    LONGLONG llCallTicks[NUM_CALLBACKS];
+    LONGLONG llBytesSent;
+    LONGLONG llBytesRead;
+};
+
+static LONGLONG Now()
+{
+    LARGE_INTEGER li;
+    QueryPerformanceCounter(&li);
+    return li.QuadPart;
+}
+
+static double TicksToUs(LONGLONG ticks) { return ticks * 1e6 / g_dTicksPerSec; }
+
+static LOADTEST_REQUEST *RequestFromConnID(HCONN ConnID) { return (LOADTEST_REQUEST *)ConnID; }
+
+// Times a callback, and remembers when the first and last were made.  Stop
+// must be called before anything which may complete the request, as the load
+// thread then reads the times.
+class CCallbackTimer {
+   public:
+    CCallbackTimer(LOADTEST_REQUEST *req, int cb) : m_req(req), m_cb(cb), m_start(Now()), m_bStopped(false)
+    {
+        if (InterlockedIncrement(&req->lCallbacks) == 1)
+            req->llFirstCallback = m_start;
+    }
+    ~CCallbackTimer() { Stop(); }
+    void SetKind(int cb) { m_cb = cb; }
+    void Stop()
+    {
+        if (m_bStopped)
+            return;
+        m_bStopped = true;
+        LONGLONG end = Now();
+        m_req->llCalls[m_cb]++;
+        m_req->llCallTicks[m_cb] += end - m_start;
+        m_req->llLastCallback = end;
+    }
+
+   private:
+    LOADTEST_REQUEST *m_req;
+    int m_cb;
+    LONGLONG m_start;
+    bool m_bStopped;
+};
+
+static BOOL CopyVariable(const char *value, LPVOID lpvBuffer, LPDWORD lpdwSize)
+{
+    DWORD cb = (DWORD)strlen(value) + 1;
+    if (*lpdwSize < cb) {
+        *lpdwSize = cb;
+        SetLastError(ERROR_INSUFFICIENT_BUFFER);
+        return FALSE;
+    }
+    memcpy(lpvBuffer, value, cb);
+    *lpdwSize = cb;
+    return TRUE;
+}
+
+static BOOL WINAPI FakeGetServerVariable(HCONN hConn, LPSTR lpszVariableName, LPVOID lpvBuffer, LPDWORD lpdwSize)
+{
+    LOADTEST_REQUEST *req = RequestFromConnID(hConn);
+    CCallbackTimer timer(req, CB_GETSERVERVARIABLE);
+    char szNum[16];
+    const char *value = NULL;
+    const char *name = lpszVariableName;
+    if (strcmp(name, "REQUEST_METHOD") == 0)
+        value = req->ecb.lpszMethod;
+    else if (strcmp(name, "QUERY_STRING") == 0)
+        value = req->ecb.lpszQueryString;
+    else if (strcmp(name, "PATH_INFO") == 0)
+        value = req->ecb.lpszPathInfo;
+    else if (strcmp(name, "PATH_TRANSLATED") == 0)
+        value = req->ecb.lpszPathTranslated;
+    else if (strcmp(name, "CONTENT_TYPE") == 0)
+        value = req->ecb.lpszContentType;
+    else if (strcmp(name, "CONTENT_LENGTH") == 0) {
+        sprintf(szNum, "%lu", req->ecb.cbTotalBytes);
+        value = szNum;
+    }
+    else if (strcmp(name, "URL") == 0)
+        value = g_config.szURL;
+    else if (strcmp(name, "SCRIPT_NAME") == 0)
+        value = g_config.szScriptName;
+    else if (strcmp(name, "ALL_HTTP") == 0)
+        value = g_config.szAllHttp;
+    else if (strcmp(name, "SERVER_NAME") == 0 || strcmp(name, "REMOTE_HOST") == 0)
+        value = "localhost";
+    else if (strcmp(name, "REMOTE_ADDR") == 0 || strcmp(name, "LOCAL_ADDR") == 0)
+        value = "127.0.0.1";
+    else if (strcmp(name, "SERVER_PORT") == 0)
+        value = "80";
+    else if (strcmp(name, "SERVER_PROTOCOL") == 0)
+        value = "HTTP/1.1";
+    else if (strcmp(name, "SERVER_SOFTWARE") == 0)
+        value = "Microsoft-IIS/10.0";
+    else if (strcmp(name, "HTTPS") == 0)
+        value = "off";
+    else if (strcmp(name, "AUTH_TYPE") == 0 || strcmp(name, "REMOTE_USER") == 0)
+        value = "";
+    else
+        for (DWORD i = 0; i < g_config.cHeaders; i++)
+            if (_stricmp(name, g_config.aszHeaderVars[i]) == 0)
+                value = g_config.aszHeaderValues[i];
+    if (value == NULL) {
+        SetLastError(ERROR_INVALID_INDEX);
+        return FALSE;
+    }
+    return CopyVariable(value, lpvBuffer, lpdwSize);
+}
+
+static BOOL WINAPI FakeReadClient(HCONN ConnID, LPVOID lpvBuffer, LPDWORD lpdwSize)
+{
+    LOADTEST_REQUEST *req = RequestFromConnID(ConnID);
+    CCallbackTimer timer(req, CB_READCLIENT);
+    DWORD cb = req->ecb.cbTotalBytes - req->cbBodyRead;
+    if (cb > *lpdwSize)
+        cb = *lpdwSize;
+    memcpy(lpvBuffer, g_config.pBody + req->cbBodyRead, cb);
+    req->cbBodyRead += cb;
+    req->llBytesRead += cb;
+    *lpdwSize = cb;
+    return TRUE;
+}
+
+struct ASYNC_COMPLETION {
+    LOADTEST_REQUEST *req;
+    PFN_HSE_IO_COMPLETION pfn;
+    void *pContext;
+    DWORD cbIO;
+};
+
+static DWORD WINAPI AsyncCompletionThread(LPVOID param)
+{
+    ASYNC_COMPLETION *ac = (ASYNC_COMPLETION *)param;
+    ac->pfn(&ac->req->ecb, ac->pContext, ac->cbIO, 0);
+    delete ac;
+    return 0;
+}
+
+// Completes an asynchronous operation, as IIS would, on another thread.
+static BOOL CompleteAsync(LOADTEST_REQUEST *req, PFN_HSE_IO_COMPLETION pfn, void *pContext, DWORD cbIO)
+{
+    if (pfn == NULL) {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return FALSE;
+    }
+    ASYNC_COMPLETION *ac = new ASYNC_COMPLETION;
+    ac->req = req;
+    ac->pfn = pfn;
+    ac->pContext = pContext;
+    ac->cbIO = cbIO;
+    if (!QueueUserWorkItem(AsyncCompletionThread, ac, WT_EXECUTEDEFAULT)) {
+        delete ac;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static BOOL WINAPI FakeWriteClient(HCONN ConnID, LPVOID Buffer, LPDWORD lpdwBytes, DWORD dwReserved)
+{
+    LOADTEST_REQUEST *req = RequestFromConnID(ConnID);
+    CCallbackTimer timer(req, CB_WRITECLIENT);
+    req->llBytesSent += *lpdwBytes;
+    timer.Stop();
+    if (dwReserved & HSE_IO_ASYNC)
+        return CompleteAsync(req, req->pfnIOCompletion, req->pIOContext, *lpdwBytes);
+    return TRUE;
+}
+
+static BOOL WINAPI FakeServerSupportFunction(HCONN hConn, DWORD dwHSERequest, LPVOID lpvBuffer, LPDWORD lpdwSize,
+                                             LPDWORD lpdwDataType)
+{
+    LOADTEST_REQUEST *req = RequestFromConnID(hConn);
+    CCallbackTimer timer(req, CB_OTHER);
+    switch (dwHSERequest) {
+        case HSE_REQ_SEND_RESPONSE_HEADER:
+            timer.SetKind(CB_SEND_HEADERS);
+            req->llBytesSent += (lpvBuffer ? strlen((char *)lpvBuffer) : 0) +
+                                (lpdwDataType ? strlen((char *)lpdwDataType) : 0);
+            return TRUE;
+        case HSE_REQ_SEND_RESPONSE_HEADER_EX: {
+            timer.SetKind(CB_SEND_HEADERS);
+            HSE_SEND_HEADER_EX_INFO *info = (HSE_SEND_HEADER_EX_INFO *)lpvBuffer;
+            req->llBytesSent += info->cchStatus + info->cchHeader;
+            return TRUE;
+        }
+        case HSE_REQ_VECTOR_SEND: {
+            timer.SetKind(CB_VECTOR_SEND);
+            HSE_RESPONSE_VECTOR *vec = (HSE_RESPONSE_VECTOR *)lpvBuffer;
+            DWORD cb = 0;
+            if (vec->pszStatus)
+                cb += (DWORD)strlen(vec->pszStatus);
+            if (vec->pszHeaders)
+                cb += (DWORD)strlen(vec->pszHeaders);
+            for (DWORD i = 0; i < vec->nElementCount; i++) cb += (DWORD)vec->lpElementArray[i].cbSize;
+            req->llBytesSent += cb;
+            timer.Stop();
+            if (vec->dwFlags & HSE_IO_ASYNC)
+                return CompleteAsync(req, req->pfnIOCompletion, req->pIOContext, cb);
+            return TRUE;
+        }
+        case HSE_REQ_TRANSMIT_FILE: {
+            timer.SetKind(CB_TRANSMIT_FILE);
+            HSE_TF_INFO *info = (HSE_TF_INFO *)lpvBuffer;
+            DWORD cb = info->HeadLength + info->TailLength + info->BytesToWrite;
+            req->llBytesSent += cb;
+            timer.Stop();
+            // Always asynchronous.
+            return CompleteAsync(req, info->pfnHseIO ? info->pfnHseIO : req->pfnIOCompletion,
+                                 info->pfnHseIO ? info->pContext : req->pIOContext, cb);
+        }
+        case HSE_REQ_ASYNC_READ_CLIENT: {
+            timer.SetKind(CB_ASYNC_READ);
+            DWORD cb = req->ecb.cbTotalBytes - req->cbBodyRead;
+            if (cb > *lpdwSize)
+                cb = *lpdwSize;
+            memcpy(lpvBuffer, g_config.pBody + req->cbBodyRead, cb);
+            req->cbBodyRead += cb;
+            req->llBytesRead += cb;
+            timer.Stop();
+            return CompleteAsync(req, req->pfnIOCompletion, req->pIOContext, cb);
+        }
+        case HSE_REQ_IO_COMPLETION:
+            timer.SetKind(CB_IO_COMPLETION);
+            req->pfnIOCompletion = (PFN_HSE_IO_COMPLETION)lpvBuffer;
+            req->pIOContext = lpdwSize;
+            return TRUE;
+        case HSE_REQ_DONE_WITH_SESSION:
+            timer.SetKind(CB_DONE_WITH_SESSION);
+            req->dwDoneStatus = lpvBuffer ? *(DWORD *)lpvBuffer : HSE_STATUS_SUCCESS;
+            timer.Stop();
+            SetEvent(req->hDone);
+            return TRUE;
+        case HSE_REQ_IS_KEEP_CONN:
+            *(BOOL *)lpvBuffer = TRUE;
+            return TRUE;
+        case HSE_REQ_SEND_URL_REDIRECT_RESP:
+        case HSE_REQ_SEND_URL:
+            req->llBytesSent += strlen((char *)lpvBuffer);
+            return TRUE;
+        case HSE_REQ_GET_IMPERSONATION_TOKEN:
+            // Requests run as us.
+            *(HANDLE *)lpvBuffer = NULL;
+            return TRUE;
+        default:
+            timer.SetKind(CB_UNSUPPORTED);
+            SetLastError(ERROR_INVALID_PARAMETER);
+            return FALSE;
+    }
+}
+
+static LOADTEST_REQUEST *NewRequest()
+{
+    LOADTEST_REQUEST *req = new LOADTEST_REQUEST;
+    memset(req, 0, sizeof(*req));
+    req->hDone = CreateEvent(NULL, TRUE, FALSE, NULL);
+    EXTENSION_CONTROL_BLOCK *ecb = &req->ecb;
+    ecb->cbSize = sizeof(*ecb);
+    ecb->dwVersion = MAKELONG(HSE_VERSION_MINOR, HSE_VERSION_MAJOR);
+    ecb->ConnID = (HCONN)req;
+    ecb->lpszMethod = g_config.szMethod;
+    ecb->lpszQueryString = g_config.szQuery;
+    ecb->lpszPathInfo = g_config.szPathInfo;
+    ecb->lpszPathTranslated = g_config.szPathInfo;
+    ecb->lpszContentType = g_config.cbBody ? (LPSTR) "application/octet-stream" : (LPSTR) "";
+    ecb->GetServerVariable = FakeGetServerVariable;
+    ecb->WriteClient = FakeWriteClient;
+    ecb->ReadClient = FakeReadClient;
+    ecb->ServerSupportFunction = FakeServerSupportFunction;
+    return req;
+}
+
+// Readies a request for reuse.
+static void ResetRequest(LOADTEST_REQUEST *req)
+{
+    HANDLE hDone = req->hDone;
+    memset((char *)req + sizeof(req->ecb), 0, sizeof(*req) - sizeof(req->ecb));
+    req->hDone = hDone;
+    ResetEvent(hDone);
+    EXTENSION_CONTROL_BLOCK *ecb = &req->ecb;
+    ecb->dwHttpStatusCode = 0;
+    ecb->lpszLogData[0] = '\0';
+    ecb->cbTotalBytes = g_config.cbBody;
+    // IIS reads the first 48k of the body before calling the extension.
+    ecb->cbAvailable = g_config.cbBody < 49152 ? g_config.cbBody : 49152;
+    ecb->lpbData = (LPBYTE)g_config.pBody;
+    req->cbBodyRead = ecb->cbAvailable;
+}
+
+static PFN_HTTPEXTENSIONPROC g_pfnHttpExtensionProc;
+
+static void AddLatency(LOADTEST_STATS *stats, LONGLONG ticks)
+{
+    if (stats->cLatencies == stats->cMaxLatencies) {
+        DWORD cNew = stats->cMaxLatencies ? stats->cMaxLatencies * 2 : 4096;
+        LONGLONG *pNew = (LONGLONG *)realloc(stats->pllLatencies, cNew * sizeof(LONGLONG));
+        if (pNew == NULL)
+            return;
+        stats->pllLatencies = pNew;
+        stats->cMaxLatencies = cNew;
+    }
+    stats->pllLatencies[stats->cLatencies++] = ticks;
+}
+
+static DWORD WINAPI LoadThread(LPVOID param)
+{
+    LOADTEST_STATS *stats = (LOADTEST_STATS *)param;
+    LOADTEST_REQUEST *req = NewRequest();
+    for (DWORD i = 0; g_config.dwSeconds ? !g_bStop : i < g_config.dwRequests; i++) {
+        ResetRequest(req);
+        LONGLONG start = Now();
+        DWORD rc = g_pfnHttpExtensionProc(&req->ecb);
+        if (rc == HSE_STATUS_PENDING) {
+            stats->llPending++;
+            if (WaitForSingleObject(req->hDone, PENDING_TIMEOUT) != WAIT_OBJECT_0) {
+                // The extension may still use it - abandon it.
+                stats->llTimeouts++;
+                req = NewRequest();
+                continue;
+            }
+            if (req->dwDoneStatus == HSE_STATUS_ERROR)
+                stats->llErrors++;
+        }
+        else if (rc == HSE_STATUS_ERROR)
+            stats->llErrors++;
+        LONGLONG end = Now();
+        stats->llRequests++;
+        AddLatency(stats, end - start);
+        LONGLONG llCallTicks = 0;
+        for (int cb = 0; cb < NUM_CALLBACKS; cb++) {
+            stats->llCalls[cb] += req->llCalls[cb];
+            stats->llCallTicks[cb] += req->llCallTicks[cb];
+            llCallTicks += req->llCallTicks[cb];
+        }
+        if (req->lCallbacks) {
+            stats->llDispatchTicks += req->llFirstCallback - start;
+            stats->llHandlerTicks += req->llLastCallback - req->llFirstCallback - llCallTicks;
+            stats->llFinishTicks += end - req->llLastCallback;
+        }
+        else
+            stats->llDispatchTicks += end - start;
+        stats->llBytesSent += req->llBytesSent;
+        stats->llBytesRead += req->llBytesRead;
+    }
+    CloseHandle(req->hDone);
+    delete req;
+    return 0;
+}
+
+// Repeatedly times acquiring the GIL, until told to stop.
+struct GIL_SAMPLES {
+    LONGLONG *pllTicks;
+    DWORD cSamples;
+};
+
+static DWORD WINAPI GILSampleThread(LPVOID param)
+{
+    GIL_SAMPLES *samples = (GIL_SAMPLES *)param;
+    while (!g_bStop && samples->cSamples < MAX_GIL_SAMPLES) {
+        LONGLONG start = Now();
+        PyGILState_STATE state = PyGILState_Ensure();
+        samples->pllTicks[samples->cSamples++] = Now() - start;
+        PyGILState_Release(state);
+        Sleep(GIL_SAMPLE_INTERVAL);
+    }
+    return 0;
+}
+
+static int CompareTicks(const void *a, const void *b)
+{
+    LONGLONG d = *(LONGLONG *)a - *(LONGLONG *)b;
+    return d < 0 ? -1 : d > 0;
+}
+
+static double Percentile(const LONGLONG *sorted, DWORD n, int pct)
+{
+    return n ? TicksToUs(sorted[(DWORD)((double)(n - 1) * pct / 100)]) : 0.0;
+}
+
+// Writes to the console, and as JSON to fp if not NULL.
+static void Report(LOADTEST_STATS *total, double seconds, GIL_SAMPLES *gil, FILE *fp)
+{
+    qsort(total->pllLatencies, total->cLatencies, sizeof(LONGLONG), CompareTicks);
+    double rps = total->llRequests / seconds;
+    LONGLONG n = total->llRequests ? total->llRequests : 1;
+    LONGLONG llCallTicks = 0;
+    for (int cb = 0; cb < NUM_CALLBACKS; cb++) llCallTicks += total->llCallTicks[cb];
+    printf("%lu threads, %I64d requests in %.2f seconds - %.0f requests/sec\n", g_config.dwThreads,
+           total->llRequests, seconds, rps);
+    printf("%I64d errors, %I64d pending, %I64d timed out\n", total->llErrors, total->llPending, total->llTimeouts);
+    printf("%I64d bytes sent, %I64d bytes read\n", total->llBytesSent, total->llBytesRead);
+    printf("\nLatency (us): p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n", Percentile(total->pllLatencies, total->cLatencies, 50),
+           Percentile(total->pllLatencies, total->cLatencies, 90), Percentile(total->pllLatencies, total->cLatencies, 99),
+           Percentile(total->pllLatencies, total->cLatencies, 100));
+    printf("\nMean per request (us): dispatch %.1f  handler %.1f  callbacks %.1f  finish %.1f\n",
+           TicksToUs(total->llDispatchTicks) / n, TicksToUs(total->llHandlerTicks) / n, TicksToUs(llCallTicks) / n,
+           TicksToUs(total->llFinishTicks) / n);
+    printf("\n%-22s %12s %12s %12s\n", "callback", "calls", "per request", "us each");
+    for (int cb = 0; cb < NUM_CALLBACKS; cb++) {
+        if (total->llCalls[cb] == 0)
+            continue;
+        printf("%-22s %12I64d %12.2f %12.2f\n", g_aszCallbackNames[cb], total->llCalls[cb],
+               (double)total->llCalls[cb] / n, TicksToUs(total->llCallTicks[cb]) / total->llCalls[cb]);
+    }
+    if (gil) {
+        qsort(gil->pllTicks, gil->cSamples, sizeof(LONGLONG), CompareTicks);
+        printf("\nGIL acquisition (us, %lu samples): p50 %.1f  p90 %.1f  p99 %.1f  max %.1f\n", gil->cSamples,
+               Percentile(gil->pllTicks, gil->cSamples, 50), Percentile(gil->pllTicks, gil->cSamples, 90),
+               Percentile(gil->pllTicks, gil->cSamples, 99), Percentile(gil->pllTicks, gil->cSamples, 100));
+    }
+    if (fp == NULL)
+        return;
+    fprintf(fp, "{\n \"threads\": %lu,\n \"requests\": %I64d,\n \"seconds\": %f,\n \"requests_per_sec\": %f,\n",
+            g_config.dwThreads, total->llRequests, seconds, rps);
+    fprintf(fp, " \"errors\": %I64d,\n \"pending\": %I64d,\n \"timeouts\": %I64d,\n", total->llErrors,
+            total->llPending, total->llTimeouts);
+    fprintf(fp, " \"bytes_sent\": %I64d,\n \"bytes_read\": %I64d,\n", total->llBytesSent, total->llBytesRead);
+    fprintf(fp, " \"latency_us\": {\"p50\": %f, \"p90\": %f, \"p99\": %f, \"max\": %f},\n",
+            Percentile(total->pllLatencies, total->cLatencies, 50), Percentile(total->pllLatencies, total->cLatencies, 90),
+            Percentile(total->pllLatencies, total->cLatencies, 99),
+            Percentile(total->pllLatencies, total->cLatencies, 100));
+    fprintf(fp, " \"mean_us\": {\"dispatch\": %f, \"handler\": %f, \"callbacks\": %f, \"finish\": %f},\n",
+            TicksToUs(total->llDispatchTicks) / n, TicksToUs(total->llHandlerTicks) / n, TicksToUs(llCallTicks) / n,
+            TicksToUs(total->llFinishTicks) / n);
+    fprintf(fp, " \"callbacks\": {");
+    const char *sep = "";
+    for (int cb = 0; cb < NUM_CALLBACKS; cb++) {
+        if (total->llCalls[cb] == 0)
+            continue;
+        fprintf(fp, "%s\n  \"%s\": {\"calls\": %I64d, \"us\": %f}", sep, g_aszCallbackNames[cb], total->llCalls[cb],
+                TicksToUs(total->llCallTicks[cb]));
+        sep = ",";
+    }
+    fprintf(fp, "\n }");
+    if (gil)
+        fprintf(fp, ",\n \"gil_us\": {\"samples\": %lu, \"p50\": %f, \"p90\": %f, \"p99\": %f, \"max\": %f}",
+                gil->cSamples, Percentile(gil->pllTicks, gil->cSamples, 50),
+                Percentile(gil->pllTicks, gil->cSamples, 90), Percentile(gil->pllTicks, gil->cSamples, 99),
+                Percentile(gil->pllTicks, gil->cSamples, 100));
+    fprintf(fp, "\n}\n");
+}
+
+static char *ToAnsi(const TCHAR *s)
+{
+#ifdef UNICODE
+    int cch = WideCharToMultiByte(CP_ACP, 0, s, -1, NULL, 0, NULL, NULL);
+    char *ret = (char *)malloc(cch);
+    WideCharToMultiByte(CP_ACP, 0, s, -1, ret, cch, NULL, NULL);
+    return ret;
+#else
+    return _strdup(s);
+#endif
+}
+
+static void AddHeader(const TCHAR *szHeader)
+{
+    char *header = ToAnsi(szHeader);
+    char *colon = strchr(header, ':');
+    if (colon == NULL || g_config.cHeaders == MAX_HEADERS) {
+        fprintf(stderr, "Ignoring header '%s'\n", header);
+        free(header);
+        return;
+    }
+    *colon = '\0';
+    char *value = colon + 1;
+    while (*value == ' ') value++;
+    char *var = (char *)malloc(strlen(header) + 6);
+    strcpy(var, "HTTP_");
+    for (char *p = header, *q = var + 5; (*q = *p) != '\0'; p++, q++)
+        *q = *p == '-' ? '_' : (char)toupper((unsigned char)*p);
+    g_config.aszHeaderVars[g_config.cHeaders] = var;
+    g_config.aszHeaderValues[g_config.cHeaders++] = value;
+    size_t cch = strlen(g_config.szAllHttp);
+    _snprintf(g_config.szAllHttp + cch, sizeof(g_config.szAllHttp) - cch - 1, "%s:%s\n", var, value);
+}
+
+// Splits the URL into the script name, path info and query string.
+static void SetURL(const TCHAR *szURL)
+{
+    char *url = ToAnsi(szURL);
+    strncpy(g_config.szURL, url, sizeof(g_config.szURL) - 1);
+    free(url);
+    char *query = strchr(g_config.szURL, '?');
+    if (query)
+        *query++ = '\0';
+    g_config.szQuery = query ? query : (char *)"";
+    char *path = strchr(g_config.szURL + 1, '/');
+    size_t cchScript = path ? path - g_config.szURL : strlen(g_config.szURL);
+    memcpy(g_config.szScriptName, g_config.szURL, cchScript);
+    g_config.szScriptName[cchScript] = '\0';
+    g_config.szPathInfo = g_config.szURL;
+}
+
+// A Python module is loaded by a copy of the loader named _module.dll beside it.
+static HMODULE LoadExtension(const TCHAR *szExtension)
+{
+    size_t cch = _tcslen(szExtension);
+    if (cch < 3 || _tcsicmp(szExtension + cch - 3, _T(".py")) != 0)
+        return LoadLibrary(szExtension);
+    TCHAR szLoader[MAX_PATH], szDLL[MAX_PATH], szDrive[_MAX_DRIVE], szDir[_MAX_DIR], szBase[_MAX_FNAME];
+    GetModuleFileName(NULL, szLoader, MAX_PATH);
+    _tsplitpath(szLoader, szDrive, szDir, NULL, NULL);
+    _tmakepath(szLoader, szDrive, szDir, _T("PyISAPI_loader"), _T(".dll"));
+    _tsplitpath(szExtension, szDrive, szDir, szBase, NULL);
+    TCHAR szName[_MAX_FNAME + 1] = _T("_");
+    _tcscat(szName, szBase);
+    _tmakepath(szDLL, szDrive, szDir, szName, _T(".dll"));
+    if (!CopyFile(szLoader, szDLL, FALSE)) {
+        _ftprintf(stderr, _T("Failed to copy %s to %s: %lu\n"), szLoader, szDLL, GetLastError());
+        return NULL;
+    }
+    return LoadLibrary(szDLL);
+}
+
+static int Usage()
+{
+    fprintf(stderr,
+            "Usage: PyISAPI_loadtest [-t threads] [-n requests | -d seconds] [-u url] [-b bytes]\n"
+            "                        [-H \"Name: value\"] ... [-g] [-j file] extension\n"
+            "where extension is an ISAPI DLL, or a Python module to load with PyISAPI_loader.dll\n");
+    return 2;
+}
+
+int _tmain(int argc, TCHAR **argv)
+{
+    g_config.dwThreads = 4;
+    g_config.dwRequests = 1000;
+    strcpy(g_config.szMethod, "GET");
+    SetURL(_T("/loadtest/hello"));
+    int i;
+    for (i = 1; i < argc && argv[i][0] == _T('-'); i++) {
+        TCHAR opt = argv[i][1];
+        if (opt == _T('g')) {
+            g_config.bSampleGIL = TRUE;
+            continue;
+        }
+        if (i + 1 == argc)
+            return Usage();
+        TCHAR *val = argv[++i];
+        switch (opt) {
+            case _T('t'):
+                g_config.dwThreads = _tcstoul(val, NULL, 10);
+                break;
+            case _T('n'):
+                g_config.dwRequests = _tcstoul(val, NULL, 10);
+                break;
+            case _T('d'):
+                g_config.dwSeconds = _tcstoul(val, NULL, 10);
+                break;
+            case _T('u'):
+                SetURL(val);
+                break;
+            case _T('b'):
+                g_config.cbBody = _tcstoul(val, NULL, 10);
+                break;
+            case _T('H'):
+                AddHeader(val);
+                break;
+            case _T('j'):
+                g_config.szJSON = val;
+                break;
+            default:
+                return Usage();
+        }
+    }
+    if (i + 1 != argc || g_config.dwThreads == 0)
+        return Usage();
+    if (g_config.cbBody) {
+        strcpy(g_config.szMethod, "POST");
+        g_config.pBody = (char *)malloc(g_config.cbBody);
+        if (g_config.pBody == NULL) {
+            fprintf(stderr, "Out of memory for the request body\n");
+            return 1;
+        }
+        for (DWORD b = 0; b < g_config.cbBody; b++) g_config.pBody[b] = (char)('a' + b % 26);
+    }
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    g_dTicksPerSec = (double)freq.QuadPart;
+
+    HMODULE hExtension = LoadExtension(argv[i]);
+    if (hExtension == NULL) {
+        _ftprintf(stderr, _T("Failed to load %s: %lu\n"), argv[i], GetLastError());
+        return 1;
+    }
+    PFN_GETEXTENSIONVERSION pfnGetExtensionVersion =
+        (PFN_GETEXTENSIONVERSION)GetProcAddress(hExtension, "GetExtensionVersion");
+    g_pfnHttpExtensionProc = (PFN_HTTPEXTENSIONPROC)GetProcAddress(hExtension, "HttpExtensionProc");
+    PFN_TERMINATEEXTENSION pfnTerminateExtension =
+        (PFN_TERMINATEEXTENSION)GetProcAddress(hExtension, "TerminateExtension");
+    if (!pfnGetExtensionVersion || !g_pfnHttpExtensionProc) {
+        fprintf(stderr, "Not an ISAPI extension - GetExtensionVersion or HttpExtensionProc is missing\n");
+        return 1;
+    }
+    HSE_VERSION_INFO version;
+    memset(&version, 0, sizeof(version));
+    if (!pfnGetExtensionVersion(&version)) {
+        fprintf(stderr, "GetExtensionVersion failed\n");
+        return 1;
+    }
+    printf("Loaded '%s'\n", version.lpszExtensionDesc);
+
+    GIL_SAMPLES gil = {NULL, 0};
+    HANDLE hGILThread = NULL;
+    if (g_config.bSampleGIL) {
+        if (!Py_IsInitialized())
+            fprintf(stderr, "Python isn't initialized - the GIL won't be sampled\n");
+        else if ((gil.pllTicks = (LONGLONG *)malloc(MAX_GIL_SAMPLES * sizeof(LONGLONG))) != NULL)
+            hGILThread = CreateThread(NULL, 0, GILSampleThread, &gil, 0, NULL);
+    }
+
+    LOADTEST_STATS *stats = new LOADTEST_STATS[g_config.dwThreads];
+    memset(stats, 0, g_config.dwThreads * sizeof(LOADTEST_STATS));
+    HANDLE *threads = new HANDLE[g_config.dwThreads];
+    LONGLONG start = Now();
+    DWORD t;
+    for (t = 0; t < g_config.dwThreads; t++) {
+        threads[t] = CreateThread(NULL, 0, LoadThread, &stats[t], 0, NULL);
+        if (threads[t] == NULL) {
+            fprintf(stderr, "Failed to start load thread: %lu\n", GetLastError());
+            return 1;
+        }
+    }
+    if (g_config.dwSeconds) {
+        Sleep(g_config.dwSeconds * 1000);
+        InterlockedExchange(&g_bStop, TRUE);
+    }
+    // WaitForMultipleObjects can't wait for more than 64.
+    for (t = 0; t < g_config.dwThreads; t++) {
+        WaitForSingleObject(threads[t], INFINITE);
+        CloseHandle(threads[t]);
+    }
+    double seconds = (Now() - start) / g_dTicksPerSec;
+    InterlockedExchange(&g_bStop, TRUE);
+    if (hGILThread) {
+        WaitForSingleObject(hGILThread, INFINITE);
+        CloseHandle(hGILThread);
+    }
+
+    LOADTEST_STATS total;
+    memset(&total, 0, sizeof(total));
+    for (t = 0; t < g_config.dwThreads; t++) {
+        LOADTEST_STATS *s = &stats[t];
+        total.llRequests += s->llRequests;
+        total.llErrors += s->llErrors;
+        total.llPending += s->llPending;
+        total.llTimeouts += s->llTimeouts;
+        total.llBytesSent += s->llBytesSent;
+        total.llBytesRead += s->llBytesRead;
+        total.llDispatchTicks += s->llDispatchTicks;
+        total.llHandlerTicks += s->llHandlerTicks;
+        total.llFinishTicks += s->llFinishTicks;
+        for (int cb = 0; cb < NUM_CALLBACKS; cb++) {
+            total.llCalls[cb] += s->llCalls[cb];
+            total.llCallTicks[cb] += s->llCallTicks[cb];
+        }
+        for (DWORD l = 0; l < s->cLatencies; l++) AddLatency(&total, s->pllLatencies[l]);
+        free(s->pllLatencies);
+    }
+    FILE *fp = NULL;
+    if (g_config.szJSON && (fp = _tfopen(g_config.szJSON, _T("w"))) == NULL)
+        _ftprintf(stderr, _T("Failed to open %s\n"), g_config.szJSON);
+    Report(&total, seconds, hGILThread ? &gil : NULL, fp);
+    if (fp)
+        fclose(fp);
+
+    if (pfnTerminateExtension)
+        pfnTerminateExtension(HSE_TERM_MUST_UNLOAD);
+    return total.llTimeouts ? 1 : 0;
+}
@@ -64,12 +64,14 @@ typedef int Py_ssize_t;
 // Macros to handle PyObject layout changes in Py3k
 #define PYISAPI_OBJECT_HEAD PyObject_HEAD_INIT(&PyType_Type) 0,
 #define PYISAPI_ATTR_CONVERT PyString_AsString
+#define PyISAPIString_InternFromString PyString_InternFromString
 
 #else  // Py3k definitions
 
 // Macros to handle PyObject layout changes in Py3k
 #define PYISAPI_OBJECT_HEAD PyVarObject_HEAD_INIT(NULL, 0)
 #define PYISAPI_ATTR_CONVERT PyUnicode_AsUnicode
+#define PyISAPIString_InternFromString PyUnicode_InternFromString
 
 // And some old py2k functions we can map to their new names...
 #define PyString_Check PyBytes_Check
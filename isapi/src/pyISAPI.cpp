@@ -50,6 +50,49 @@ char g_CallbackModuleName[_MAX_PATH + _MAX_FNAME] = "";
 
 #define TRACE(x) OutputDebugString(_T(x))
 
+// The native worker pool.  IIS threads only queue the ECB on a completion
+// port and return HSE_STATUS_PENDING; the workers each keep their own thread
+// state, so calling the handler costs no more than taking the GIL.
+DWORD g_dwWorkerThreads = 0;
+DWORD g_dwMaxQueuedRequests = 1000;
+
+#define POOL_REQUEST 1
+#define POOL_SHUTDOWN 2
+#define POOL_SHUTDOWN_WAIT 15000  // ms we wait for the workers to finish.
+
+static HANDLE g_hPoolPort = NULL;
+static HANDLE *g_phPoolThreads = NULL;
+static DWORD g_dwPoolThreads = 0;
+// Statistics - see EXTENSION_CONTROL_BLOCK::GetPoolStatistics.
+static volatile LONG g_lPoolDepth = 0;
+static volatile LONG g_lPoolMaxDepth = 0;
+static volatile LONG g_lPoolActive = 0;
+static volatile LONGLONG g_llPoolQueued = 0;
+static volatile LONGLONG g_llPoolRejected = 0;
+static volatile LONGLONG g_llPoolQueueTime = 0;
+static volatile LONG g_lPoolMaxQueueTime = 0;
+
+// A request waiting for a worker.
+struct POOL_REQUEST_ITEM {
+    OVERLAPPED overlapped;  // must be first - it's what the port gives back.
+    EXTENSION_CONTROL_BLOCK *pECB;
+    DWORD dwQueued;  // tick count when queued.
+};
+
+static bool StartWorkerPool();
+static void StopWorkerPool();
+
+static void InterlockedMax(volatile LONG *target, LONG value)
+{
+    LONG cur = *target;
+    while (value > cur) {
+        LONG prev = InterlockedCompareExchange(target, value, cur);
+        if (prev == cur)
+            break;
+        cur = prev;
+    }
+}
+
 // This is an entry point for py2exe.
 extern "C" void WINAPI PyISAPISetOptions(const char *modname, BOOL is_frozen)
 {
@@ -89,13 +132,24 @@ BOOL WINAPI GetExtensionVersion(HSE_VERSION_INFO *pVer)
         }
     }
     Py_XDECREF(resultobject);
+    if (bRetStatus && g_dwWorkerThreads) {
+        bool bStarted;
+        Py_BEGIN_ALLOW_THREADS bStarted = StartWorkerPool();
+        Py_END_ALLOW_THREADS if (!bStarted)
+        {
+            ExtensionError(NULL, "Unable to start the worker threads");
+            bRetStatus = false;
+        }
+    }
     return bRetStatus;
 }
 
-DWORD WINAPI HttpExtensionProc(EXTENSION_CONTROL_BLOCK *pECB)
+// Calls the Python handler for a request - must hold the GIL.  A pooled
+// request always ends its session here, unless the handler keeps it by
+// returning HSE_STATUS_PENDING.
+static DWORD CallExtensionProc(EXTENSION_CONTROL_BLOCK *pECB, DWORD dwQueueTime, bool bPooled)
 {
     DWORD result;
-    CEnterLeavePython celp;
     CControlBlock *pcb = new CControlBlock(pECB);
     // PyECB takes ownership of pcb - so when it dies, so does pcb.
     // As this may die inside Callback, we need to keep our own
@@ -104,6 +158,7 @@ DWORD WINAPI HttpExtensionProc(EXTENSION_CONTROL_BLOCK *pECB)
     if (!pyECB || !pcb)
         // This is pretty fatal!
         return HSE_STATUS_ERROR;
+    pyECB->SetQueueTime(dwQueueTime);
     Py_INCREF(pyECB);
     PyObject *resultobject = extensionHandler.Callback(HANDLER_DO, "(N)", pyECB);
     if (!resultobject) {
@@ -118,15 +173,156 @@ DWORD WINAPI HttpExtensionProc(EXTENSION_CONTROL_BLOCK *pECB)
             result = HSE_STATUS_ERROR;
         }
     }
+    if (bPooled && result != HSE_STATUS_PENDING && pyECB->IsSessionOpen())
+        pyECB->EndSession(result);
     Py_DECREF(pyECB);
     Py_XDECREF(resultobject);
     return result;
 }
 
+static DWORD WINAPI PoolWorkerThread(LPVOID param)
+{
+    HANDLE hPort = (HANDLE)param;
+    // A thread state for the life of the worker, rather than one per request.
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    PyThreadState *tstate = PyEval_SaveThread();
+    for (;;) {
+        DWORD cb;
+        ULONG_PTR key;
+        OVERLAPPED *pOverlapped;
+        if (!GetQueuedCompletionStatus(hPort, &cb, &key, &pOverlapped, INFINITE) && pOverlapped == NULL)
+            break;  // the port has gone.
+        if (key == POOL_SHUTDOWN)
+            break;
+        POOL_REQUEST_ITEM *pItem = (POOL_REQUEST_ITEM *)pOverlapped;
+        EXTENSION_CONTROL_BLOCK *pECB = pItem->pECB;
+        DWORD dwQueueTime = GetTickCount() - pItem->dwQueued;
+        delete pItem;
+        InterlockedDecrement(&g_lPoolDepth);
+        InterlockedIncrement(&g_lPoolActive);
+        InterlockedExchangeAdd64(&g_llPoolQueueTime, dwQueueTime);
+        InterlockedMax(&g_lPoolMaxQueueTime, (LONG)dwQueueTime);
+        // Run as the user IIS would have for this request.
+        HANDLE hToken = NULL;
+        if (pECB->ServerSupportFunction(pECB->ConnID, HSE_REQ_GET_IMPERSONATION_TOKEN, &hToken, 0, 0) && hToken)
+            SetThreadToken(NULL, hToken);
+        PyEval_RestoreThread(tstate);
+        CallExtensionProc(pECB, dwQueueTime, true);
+        tstate = PyEval_SaveThread();
+        if (hToken)
+            SetThreadToken(NULL, NULL);
+        InterlockedDecrement(&g_lPoolActive);
+    }
+    PyEval_RestoreThread(tstate);
+    PyGILState_Release(gstate);
+    return 0;
+}
+
+// Called without the GIL.
+static bool StartWorkerPool()
+{
+    g_hPoolPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 0);
+    if (g_hPoolPort == NULL)
+        return false;
+    g_phPoolThreads = new HANDLE[g_dwWorkerThreads];
+    for (g_dwPoolThreads = 0; g_dwPoolThreads < g_dwWorkerThreads; g_dwPoolThreads++) {
+        DWORD tid;
+        HANDLE h = CreateThread(NULL, 0, PoolWorkerThread, g_hPoolPort, 0, &tid);
+        if (h == NULL)
+            break;
+        g_phPoolThreads[g_dwPoolThreads] = h;
+    }
+    if (g_dwPoolThreads == 0) {
+        delete[] g_phPoolThreads;
+        g_phPoolThreads = NULL;
+        CloseHandle(g_hPoolPort);
+        g_hPoolPort = NULL;
+        return false;
+    }
+    return true;
+}
+
+// Lets the workers finish the requests already queued, then stops them.
+// Called without the GIL.
+static void StopWorkerPool()
+{
+    HANDLE hPort = g_hPoolPort;
+    if (hPort == NULL)
+        return;
+    g_hPoolPort = NULL;
+    DWORD i;
+    for (i = 0; i < g_dwPoolThreads; i++) PostQueuedCompletionStatus(hPort, 0, POOL_SHUTDOWN, NULL);
+    DWORD dwEnd = GetTickCount() + POOL_SHUTDOWN_WAIT;
+    bool bAllStopped = true;
+    for (i = 0; i < g_dwPoolThreads; i++) {
+        DWORD dwNow = GetTickCount();
+        DWORD dwWait = (LONG)(dwEnd - dwNow) > 0 ? dwEnd - dwNow : 0;
+        if (WaitForSingleObject(g_phPoolThreads[i], dwWait) != WAIT_OBJECT_0)
+            bAllStopped = false;
+        CloseHandle(g_phPoolThreads[i]);
+    }
+    delete[] g_phPoolThreads;
+    g_phPoolThreads = NULL;
+    g_dwPoolThreads = 0;
+    // A worker still running a request needs the port when it finishes.
+    if (bAllStopped)
+        CloseHandle(hPort);
+}
+
+// Tells the client we are too busy, when the queue is full.
+static DWORD RejectRequest(EXTENSION_CONTROL_BLOCK *pECB)
+{
+    HSE_SEND_HEADER_EX_INFO SendHeaderExInfo;
+    SendHeaderExInfo.pszStatus = "503 Service Unavailable";
+    SendHeaderExInfo.cchStatus = strlen(SendHeaderExInfo.pszStatus);
+    SendHeaderExInfo.pszHeader = "Content-type: text/plain\r\nRetry-After: 1\r\n\r\n";
+    SendHeaderExInfo.cchHeader = strlen(SendHeaderExInfo.pszHeader);
+    SendHeaderExInfo.fKeepConn = FALSE;
+    pECB->dwHttpStatusCode = 503;
+    pECB->ServerSupportFunction(pECB->ConnID, HSE_REQ_SEND_RESPONSE_HEADER_EX, &SendHeaderExInfo, NULL, NULL);
+    return HSE_STATUS_SUCCESS;
+}
+
+DWORD WINAPI HttpExtensionProc(EXTENSION_CONTROL_BLOCK *pECB)
+{
+    if (g_hPoolPort) {
+        LONG depth = InterlockedIncrement(&g_lPoolDepth);
+        if ((DWORD)depth > g_dwMaxQueuedRequests) {
+            InterlockedDecrement(&g_lPoolDepth);
+            InterlockedIncrement64(&g_llPoolRejected);
+            return RejectRequest(pECB);
+        }
+        InterlockedMax(&g_lPoolMaxDepth, depth);
+        POOL_REQUEST_ITEM *pItem = new POOL_REQUEST_ITEM;
+        ZeroMemory(&pItem->overlapped, sizeof(pItem->overlapped));
+        pItem->pECB = pECB;
+        pItem->dwQueued = GetTickCount();
+        if (!PostQueuedCompletionStatus(g_hPoolPort, 0, POOL_REQUEST, &pItem->overlapped)) {
+            delete pItem;
+            InterlockedDecrement(&g_lPoolDepth);
+            return HSE_STATUS_ERROR;
+        }
+        InterlockedIncrement64(&g_llPoolQueued);
+        return HSE_STATUS_PENDING;
+    }
+    CEnterLeavePython celp;
+    return CallExtensionProc(pECB, 0, false);
+}
+
+PyObject *GetWorkerPoolStatistics()
+{
+    return Py_BuildValue("{s:k,s:l,s:l,s:l,s:L,s:L,s:L,s:l}", "WorkerThreads", g_dwPoolThreads, "QueueDepth",
+                         g_lPoolDepth, "MaxQueueDepth", g_lPoolMaxDepth, "ActiveWorkers", g_lPoolActive, "Queued",
+                         g_llPoolQueued, "Rejected", g_llPoolRejected, "TotalQueueTime", g_llPoolQueueTime,
+                         "MaxQueueTime", g_lPoolMaxQueueTime);
+}
+
 BOOL WINAPI TerminateExtension(DWORD dwFlags)
 {
     // extension is being terminated
     BOOL bRetStatus;
+    // Any requests already queued are handled before the handler is told.
+    StopWorkerPool();
     CEnterLeavePython celp;
     PyObject *resultobject = extensionHandler.Callback(HANDLER_TERM, "(i)", dwFlags);
     if (!resultobject) {
@@ -148,6 +344,177 @@ BOOL WINAPI TerminateExtension(DWORD dwFlags)
     return bRetStatus;
 }
 
+// Native routing of filter notifications.  Rules are only added while
+// GetFilterVersion runs, so HttpFilterProc reads them without a lock - and
+// without the GIL, which notifications no rule wants never take.
+struct FILTER_ROUTE_RULE {
+    DWORD dwNotifications;
+    char *szPrefix;  // URL prefix, or NULL
+    size_t cchPrefix;
+    char *szHeaderName;  // "Name:", as GetHeader wants it, or NULL
+    char *szHeaderVar;   // "HTTP_NAME", as GetServerVariable wants it
+    char *szValue;       // a substring the header value must contain, or NULL
+};
+
+#define ROUTE_NO_MATCH 0
+#define ROUTE_MATCH 1
+#define ROUTE_UNKNOWN 2  // can't be decided natively - let Python see it.
+#define ROUTE_BUFFER_SIZE 2048
+
+static FILTER_ROUTE_RULE *g_pRouteRules = NULL;
+static DWORD g_cRouteRules = 0;
+static DWORD g_dwRoutedNotifications = 0;  // notifications with at least one rule
+static DWORD g_dwPythonFilterFlags = 0;    // the notifications the filter asked for
+static BOOL g_bInFilterVersion = FALSE;
+
+static void FreeRouteRule(FILTER_ROUTE_RULE *rule)
+{
+    free(rule->szPrefix);
+    free(rule->szHeaderName);
+    free(rule->szHeaderVar);
+    free(rule->szValue);
+}
+
+static void FreeRouteRules()
+{
+    for (DWORD i = 0; i < g_cRouteRules; i++) FreeRouteRule(&g_pRouteRules[i]);
+    free(g_pRouteRules);
+    g_pRouteRules = NULL;
+    g_cRouteRules = 0;
+    g_dwRoutedNotifications = 0;
+}
+
+BOOL AddFilterRouteRule(DWORD dwNotifications, const char *szPrefix, const char *szHeader, const char *szValue)
+{
+    if (!g_bInFilterVersion) {
+        PyErr_SetString(PyExc_RuntimeError, "Route rules can only be added by GetFilterVersion");
+        return FALSE;
+    }
+    FILTER_ROUTE_RULE *pNew =
+        (FILTER_ROUTE_RULE *)realloc(g_pRouteRules, (g_cRouteRules + 1) * sizeof(FILTER_ROUTE_RULE));
+    if (!pNew) {
+        PyErr_NoMemory();
+        return FALSE;
+    }
+    g_pRouteRules = pNew;
+    FILTER_ROUTE_RULE *rule = &g_pRouteRules[g_cRouteRules];
+    memset(rule, 0, sizeof(*rule));
+    rule->dwNotifications = dwNotifications;
+    BOOL ok = TRUE;
+    if (szPrefix) {
+        rule->szPrefix = _strdup(szPrefix);
+        rule->cchPrefix = strlen(szPrefix);
+        ok = rule->szPrefix != NULL;
+    }
+    if (ok && szHeader) {
+        size_t cch = strlen(szHeader);
+        rule->szHeaderName = (char *)malloc(cch + 2);
+        rule->szHeaderVar = (char *)malloc(cch + 6);
+        ok = rule->szHeaderName && rule->szHeaderVar;
+        if (ok) {
+            memcpy(rule->szHeaderName, szHeader, cch);
+            strcpy(rule->szHeaderName + cch, ":");
+            strcpy(rule->szHeaderVar, "HTTP_");
+            for (size_t i = 0; i < cch; i++)
+                rule->szHeaderVar[5 + i] = szHeader[i] == '-' ? '_' : (char)toupper((unsigned char)szHeader[i]);
+            rule->szHeaderVar[5 + cch] = '\0';
+        }
+    }
+    if (ok && szValue) {
+        rule->szValue = _strdup(szValue);
+        ok = rule->szValue != NULL;
+    }
+    if (!ok) {
+        FreeRouteRule(rule);
+        PyErr_NoMemory();
+        return FALSE;
+    }
+    g_cRouteRules++;
+    g_dwRoutedNotifications |= dwNotifications;
+    return TRUE;
+}
+
+static BOOL ContainsNoCase(const char *haystack, const char *needle)
+{
+    size_t cch = strlen(needle);
+    for (; *haystack; haystack++)
+        if (_strnicmp(haystack, needle, cch) == 0)
+            return TRUE;
+    return cch == 0;
+}
+
+// Fetches the URL, or the rule's header if bHeader, into buf.
+static int GetRouteValue(HTTP_FILTER_CONTEXT *phfc, DWORD NotificationType, VOID *pvData,
+                         const FILTER_ROUTE_RULE *rule, BOOL bHeader, char *buf, DWORD cb)
+{
+    BOOL ok;
+    switch (NotificationType) {
+        case SF_NOTIFY_PREPROC_HEADERS:
+            ok = ((HTTP_FILTER_PREPROC_HEADERS *)pvData)
+                     ->GetHeader(phfc, bHeader ? rule->szHeaderName : (char *)"url", buf, &cb);
+            break;
+        case SF_NOTIFY_URL_MAP:
+            if (!bHeader) {
+                const char *url = ((HTTP_FILTER_URL_MAP *)pvData)->pszURL;
+                if (!url || strlen(url) >= cb)
+                    return ROUTE_UNKNOWN;
+                strcpy(buf, url);
+                return ROUTE_MATCH;
+            }
+            // fall through
+        default:
+            ok = phfc->GetServerVariable(phfc, bHeader ? rule->szHeaderVar : (char *)"URL", buf, &cb);
+            break;
+    }
+    if (ok)
+        return ROUTE_MATCH;
+    // A header which isn't there is a definite answer; anything else
+    // (eg, the URL isn't known yet for raw data) is not.
+    return bHeader && GetLastError() == ERROR_INVALID_INDEX ? ROUTE_NO_MATCH : ROUTE_UNKNOWN;
+}
+
+static int MatchRouteRule(HTTP_FILTER_CONTEXT *phfc, DWORD NotificationType, VOID *pvData,
+                          const FILTER_ROUTE_RULE *rule)
+{
+    char buf[ROUTE_BUFFER_SIZE];
+    int result;
+    if (rule->szPrefix) {
+        result = GetRouteValue(phfc, NotificationType, pvData, rule, FALSE, buf, sizeof(buf));
+        if (result != ROUTE_MATCH)
+            return result;
+        if (_strnicmp(buf, rule->szPrefix, rule->cchPrefix) != 0)
+            return ROUTE_NO_MATCH;
+    }
+    if (rule->szHeaderName) {
+        result = GetRouteValue(phfc, NotificationType, pvData, rule, TRUE, buf, sizeof(buf));
+        if (result != ROUTE_MATCH)
+            return result;
+        if (rule->szValue && !ContainsNoCase(buf, rule->szValue))
+            return ROUTE_NO_MATCH;
+    }
+    return ROUTE_MATCH;
+}
+
+// Called without the GIL - TRUE if Python needs to see this notification.
+static BOOL FilterRouteWanted(HTTP_FILTER_CONTEXT *phfc, DWORD NotificationType, VOID *pvData)
+{
+    if (g_cRouteRules == 0)
+        return TRUE;
+    if (NotificationType == SF_NOTIFY_END_OF_NET_SESSION)
+        // We always ask for this to free the FilterContext - skip it
+        // unless the filter asked for it too, or there is one to free.
+        return (g_dwPythonFilterFlags & SF_NOTIFY_END_OF_NET_SESSION) || phfc->pFilterContext != NULL;
+    if ((g_dwRoutedNotifications & NotificationType) == 0)
+        return TRUE;
+    for (DWORD i = 0; i < g_cRouteRules; i++) {
+        const FILTER_ROUTE_RULE *rule = &g_pRouteRules[i];
+        if ((rule->dwNotifications & NotificationType) &&
+            MatchRouteRule(phfc, NotificationType, pvData, rule) != ROUTE_NO_MATCH)
+            return TRUE;
+    }
+    return FALSE;
+}
+
 BOOL WINAPI GetFilterVersion(HTTP_FILTER_VERSION *pVer)
 {
     pVer->dwFilterVersion = HTTP_FILTER_REVISION;
@@ -158,7 +525,10 @@ BOOL WINAPI GetFilterVersion(HTTP_FILTER_VERSION *pVer)
 
     CEnterLeavePython celp;
     PyFILTER_VERSION *pyFV = new PyFILTER_VERSION(pVer);
+    FreeRouteRules();
+    g_bInFilterVersion = TRUE;
     PyObject *resultobject = filterHandler.Callback(HANDLER_INIT, "(N)", pyFV);
+    g_bInFilterVersion = FALSE;
     BOOL bRetStatus;
     if (!resultobject) {
         FilterError(NULL, "Filter version function failed!");
@@ -174,15 +544,21 @@ BOOL WINAPI GetFilterVersion(HTTP_FILTER_VERSION *pVer)
             bRetStatus = FALSE;
         }
     }
-    if (bRetStatus)
+    if (bRetStatus) {
+        g_dwPythonFilterFlags = pVer->dwFlags;
         // We need the SF_NOTIFY_END_OF_NET_SESSION notification for cleanup
         pVer->dwFlags |= SF_NOTIFY_END_OF_NET_SESSION;
+    }
     Py_XDECREF(resultobject);
     return bRetStatus;
 }
 
 DWORD WINAPI HttpFilterProc(HTTP_FILTER_CONTEXT *phfc, DWORD NotificationType, VOID *pvData)
 {
+    // Decided before we go anywhere near the GIL.
+    if (!FilterRouteWanted(phfc, NotificationType, pvData))
+        return SF_STATUS_REQ_NEXT_NOTIFICATION;
+
     DWORD action;
     CEnterLeavePython celp;
 
@@ -244,6 +620,7 @@ BOOL WINAPI TerminateFilter(DWORD status)
     Py_XDECREF(resultobject);
     // filter is being terminated
     filterHandler.Term();
+    FreeRouteRules();
     return bRetStatus;
 }
 
@@ -34,4 +34,14 @@ BOOL WINAPI GetExtensionVersion(HSE_VERSION_INFO *pVer);
 DWORD WINAPI HttpExtensionProc(EXTENSION_CONTROL_BLOCK *pECB);
 BOOL WINAPI TerminateExtension(DWORD dwFlags);
 
+// The native worker pool - enabled by setting WorkerThreads on the
+// HSE_VERSION_INFO object passed to GetExtensionVersion.
+extern DWORD g_dwWorkerThreads;
+extern DWORD g_dwMaxQueuedRequests;
+PyObject *GetWorkerPoolStatistics();
+
+// Native routing of filter notifications - see HTTP_FILTER_VERSION::AddRouteRule.
+// Sets a Python exception and returns FALSE on failure.
+BOOL AddFilterRouteRule(DWORD dwNotifications, const char *szPrefix, const char *szHeader, const char *szValue);
+
 #endif  // __PYISAPI_H__
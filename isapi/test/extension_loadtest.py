@@ -0,0 +1,63 @@
+# An ISAPI extension to be driven by PyISAPI_loadtest.exe, the load test host
+# which fakes IIS.  It is NOT a demo.
+#
+# The last part of the URL selects what each request does, eg:
+#   PyISAPI_loadtest -t 8 -d 10 -u /loadtest/vars extension_loadtest.py
+# will have 8 threads fetch server variables for 10 seconds.  Set the
+# PYISAPI_LOADTEST_WORKERS environment variable to a number of threads to
+# have requests run by pyISAPI's native worker pool.
+import os
+from isapi import isapicon
+from isapi.simple import SimpleExtension
+
+BODY = b"x" * 1024
+
+class Extension(SimpleExtension):
+    "Python ISAPI load test"
+    def GetExtensionVersion(self, vi):
+        SimpleExtension.GetExtensionVersion(self, vi)
+        workers = int(os.environ.get("PYISAPI_LOADTEST_WORKERS", "0"))
+        if workers:
+            vi.WorkerThreads = workers
+
+    def HttpExtensionProc(self, ecb):
+        test_name = ecb.GetServerVariable("URL").split("/")[-1]
+        getattr(self, test_name, self.hello)(ecb)
+        return isapicon.HSE_STATUS_SUCCESS
+
+    def hello(self, ecb):
+        # The least a response can be.
+        ecb.SendResponseHeaders("200 OK", "Content-Type: text/plain\r\n\r\n", False)
+        ecb.WriteClient(BODY)
+
+    def vars(self, ecb):
+        # A variable at a time, as a CGI-style framework might.
+        for name in ("REQUEST_METHOD", "QUERY_STRING", "PATH_INFO", "SCRIPT_NAME",
+                     "SERVER_NAME", "SERVER_PORT", "REMOTE_ADDR", "CONTENT_LENGTH",
+                     "HTTPS", "ALL_HTTP"):
+            ecb.GetServerVariable(name, "")
+        self.hello(ecb)
+
+    def environ(self, ecb):
+        # The same variables in one call, as a WSGI gateway would.
+        ecb.GetServerVariables(["REQUEST_METHOD", "QUERY_STRING", "PATH_INFO", "SCRIPT_NAME",
+                                "SERVER_NAME", "SERVER_PORT", "REMOTE_ADDR", "CONTENT_LENGTH",
+                                "HTTPS"], True)
+        self.hello(ecb)
+
+    def vector(self, ecb):
+        # The whole response in a single VectorSend.
+        ecb.VectorSend([BODY, BODY], "Content-Type: text/plain\r\n\r\n", "200 OK")
+
+    def read(self, ecb):
+        # Reads the request body - use the -b option.
+        remaining = ecb.TotalBytes - ecb.AvailableBytes
+        while remaining > 0:
+            data = ecb.ReadClient(min(remaining, 65536))
+            if not data:
+                break
+            remaining -= len(data)
+        self.hello(ecb)
+
+def __ExtensionFactory__():
+    return Extension()
@@ -87,6 +87,19 @@ class Extension(threaded_extension.ThreadPoolExtension):
             raise RuntimeError("Unicode and non-unicode values were not the same")
         return "worked!"
 
+    def test_server_variables(self, ecb):
+        names = ["URL", "SERVER_NAME", "UNICODE_SERVER_NAME", "foo bar"]
+        vars = ecb.GetServerVariables(names)
+        if "foo bar" in vars:
+            raise RuntimeError("an invalid variable was returned")
+        for name in names[:-1]:
+            if vars[name] != ecb.GetServerVariable(name):
+                raise RuntimeError("%s was not the same via GetServerVariables" % (name,))
+        headers = ecb.GetServerVariables()
+        if headers.get("HTTP_HOST") != ecb.GetServerVariable("HTTP_HOST"):
+            raise RuntimeError("HTTP_HOST was not the same via ALL_HTTP")
+        return "worked!"
+
 # The entry points for the ISAPI extension.
 def __ExtensionFactory__():
     return Extension()
@@ -169,3 +169,38 @@ class ThreadPoolExtension(isapi.simple.SimpleExtension):
             # part of a traceback used to be evil and cause leaks!
             exc_tb = None
             ecb.DoneWithSession()
+
+# The same thread-pool, but run by pyISAPI itself - requests are queued by
+# native code, and the worker threads are native, so no Python code runs on
+# the IIS thread at all.
+class NativeThreadPoolExtension(ThreadPoolExtension):
+    """Base class for an ISAPI extension using pyISAPI's native thread-pool
+
+    Sub-classes implement Dispatch exactly as for a ThreadPoolExtension.  The
+    max_workers attribute sets the number of worker threads, while
+    max_queued_requests sets how many requests may wait for one before
+    further requests are refused with '503 Service Unavailable'.  The
+    'GetPoolStatistics' method of the control block returns the queue depth
+    and latency counters of the pool.
+    """
+    max_queued_requests = 1000
+    def GetExtensionVersion(self, vi):
+        isapi.simple.SimpleExtension.GetExtensionVersion(self, vi)
+        # nod to our reload capability - vi is None when we are reloaded,
+        # and the pool started on our first load is still running.
+        if vi is not None:
+            vi.WorkerThreads = self.max_workers
+            vi.MaxQueuedRequests = self.max_queued_requests
+
+    def HttpExtensionProc(self, control_block):
+        # We are already on a worker thread, running as the request's user.
+        try:
+            self.Dispatch(control_block)
+        except:
+            self.HandleDispatchError(control_block)
+        # As for ThreadPoolExtension, Dispatch ends the session itself.
+        return isapicon.HSE_STATUS_PENDING
+
+    def TerminateExtension(self, status):
+        # The native pool has already stopped by the time we are called.
+        self.dispatch_map = {} # break circles
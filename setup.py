@@ -428,6 +428,16 @@ class WinExt_ISAPI(WinExt):
     def get_pywin32_dir(self):
         return "isapi"
 
+class WinExt_ISAPI_subsys_con(WinExt_ISAPI):
+    def finalize_options(self, build_ext):
+        WinExt_ISAPI.finalize_options(self, build_ext)
+
+        if build_ext.mingw32:
+            self.extra_link_args.append('-mconsole')
+            self.extra_link_args.append('-municode')
+        else:
+            self.extra_link_args.append('/SUBSYSTEM:CONSOLE')
+
 # Note this is used only for "win32com extensions", not pythoncom
 # itself - thus, output is "win32comext"
 class WinExt_win32com(WinExt):
@@ -1367,14 +1377,16 @@ for info in (
             win32/src/PerfMon/MappingManager.cpp
             win32/src/PerfMon/PerfCounterDefn.cpp
             win32/src/PerfMon/PerfObjectType.cpp
+            win32/src/PerfMon/PerfProvider.cpp
             win32/src/PerfMon/PyPerfMon.cpp
             """),
         ("timer", "user32", None, "win32/src/timermodule.cpp"),
         ("win2kras", "rasapi32", 0x0500, "win32/src/win2krasmodule.cpp"),
         ("win32cred", "AdvAPI32 credui", 0x0501, 'win32/src/win32credmodule.cpp'),
-        ("win32crypt", "Crypt32 Advapi32", 0x0500, """
+        ("win32crypt", "Crypt32 Advapi32 bcrypt", 0x0500, """
             win32/src/win32crypt/win32cryptmodule.cpp
             win32/src/win32crypt/win32crypt_structs.cpp
+            win32/src/win32crypt/PyBCRYPT.cpp
             win32/src/win32crypt/PyCERTSTORE.cpp
             win32/src/win32crypt/PyCERT_CONTEXT.cpp
             win32/src/win32crypt/PyCRYPTHASH.cpp
@@ -1397,19 +1409,23 @@ for info in (
               win32/src/win32net/win32netfile.cpp    win32/src/win32net/win32netgroup.cpp
               win32/src/win32net/win32netmisc.cpp    win32/src/win32net/win32netmodule.cpp
               win32/src/win32net/win32netsession.cpp win32/src/win32net/win32netuse.cpp
-              win32/src/win32net/win32netuser.cpp
+              win32/src/win32net/win32netuser.cpp    win32/src/win32net/win32netbatch.cpp
               """),
         ("win32pdh", "", None, "win32/src/win32pdhmodule.cpp"),
         ("win32pipe", "", None, 'win32/src/win32pipe.i win32/src/win32popen.cpp'),
         ("win32print", "winspool user32 gdi32", 0x0500, "win32/src/win32print/win32print.cpp"),
-        ("win32process", "advapi32 user32", 0x0500, "win32/src/win32process.i"),
+        ("win32process", "advapi32 user32", 0x0500, """
+              win32/src/win32process.i
+              win32/src/win32process_threadpool.cpp
+              """),
         ("win32profile", "Userenv", None, 'win32/src/win32profilemodule.cpp'),
         ("win32ras", "rasapi32 user32", 0x0500, "win32/src/win32rasmodule.cpp"),
-        ("win32security", "advapi32 user32 netapi32", 0x0500, """
+        ("win32security", "advapi32 user32 netapi32 ws2_32", 0x0500, """
             win32/src/win32security.i
             win32/src/win32security_sspi.cpp win32/src/win32security_ds.cpp
+            win32/src/win32security_scan.cpp
             """),
-        ("win32service", "advapi32 oleaut32 user32", 0x0501, """
+        ("win32service", "advapi32 oleaut32 user32", 0x0600, """
             win32/src/win32service_messages.mc
             win32/src/win32service.i
             """),
@@ -1449,9 +1465,10 @@ win32_extensions += [
     WinExt_win32("win32evtlog",
             sources = """
                 win32\\src\\win32evtlog_messages.mc win32\\src\\win32evtlog.i
+                win32\\src\\win32evtlog_etw.cpp
                 """.split(),
                 libraries="advapi32 oleaut32",
-                delay_load_libraries="wevtapi",
+                delay_load_libraries="wevtapi tdh",
                 windows_h_version=0x0600
         ),
     WinExt_win32("win32api",
@@ -1465,6 +1482,7 @@ win32_extensions += [
     WinExt_win32("win32gui",
            sources = """
                 win32/src/win32dynamicdialog.cpp
+                win32/src/win32screencapture.cpp win32/src/win32rawinput.cpp
                 win32/src/win32gui.i
                """.split(),
            windows_h_version=0x0500,
@@ -1476,6 +1494,7 @@ win32_extensions += [
     WinExt_win32("winxpgui",
            sources = """
                 win32/src/winxpgui.rc win32/src/win32dynamicdialog.cpp
+                win32/src/win32screencapture.cpp win32/src/win32rawinput.cpp
                 win32/src/win32gui.i
                """.split(),
            libraries="gdi32 user32 comdlg32 comctl32 shell32",
@@ -1527,7 +1546,10 @@ pythoncom = WinExt_system32('pythoncom',
                    sources=("""
                         %(win32com)s/dllmain.cpp            %(win32com)s/ErrorUtils.cpp
                         %(win32com)s/MiscTypes.cpp          %(win32com)s/oleargs.cpp
-                        %(win32com)s/PyComHelpers.cpp       %(win32com)s/PyFactory.cpp
+                        %(win32com)s/PyComCallStats.cpp     %(win32com)s/PyComHelpers.cpp
+                        %(win32com)s/PyComObjectStats.cpp
+                        %(win32com)s/PyConnectionSinks.cpp
+                        %(win32com)s/PyFactory.cpp
                         %(win32com)s/PyGatewayBase.cpp      %(win32com)s/PyIBase.cpp
                         %(win32com)s/PyIClassFactory.cpp    %(win32com)s/PyIDispatch.cpp
                         %(win32com)s/PyIUnknown.cpp         %(win32com)s/PyRecord.cpp
@@ -1565,10 +1587,11 @@ pythoncom = WinExt_system32('pythoncom',
                         %(win32com)s/extensions/PyTYPEATTR.cpp              %(win32com)s/extensions/PyVARDESC.cpp
                         %(win32com)s/extensions/PyICancelMethodCalls.cpp    %(win32com)s/extensions/PyIContext.cpp
                         %(win32com)s/extensions/PyIEnumContextProps.cpp     %(win32com)s/extensions/PyIClientSecurity.cpp
-                        %(win32com)s/extensions/PyIServerSecurity.cpp
+                        %(win32com)s/extensions/PyIServerSecurity.cpp       %(win32com)s/extensions/PyIMultiQI.cpp
                         """ % dirs).split(),
                    depends=("""
                         %(win32com)s/include\\propbag.h          %(win32com)s/include\\PyComTypeObjects.h
+                        %(win32com)s/include\\PyComCallStats.h %(win32com)s/include\\PyComObjectStats.h
                         %(win32com)s/include\\PyFactory.h        %(win32com)s/include\\PyGConnectionPoint.h
                         %(win32com)s/include\\PyGConnectionPointContainer.h
                         %(win32com)s/include\\PyGPersistStorage.h %(win32com)s/include\\PyIBindCtx.h
@@ -1590,7 +1613,7 @@ pythoncom = WinExt_system32('pythoncom',
                         %(win32com)s/include\\univgw_dataconv.h
                         %(win32com)s/include\\PyICancelMethodCalls.h    %(win32com)s/include\\PyIContext.h
                         %(win32com)s/include\\PyIEnumContextProps.h     %(win32com)s/include\\PyIClientSecurity.h
-                        %(win32com)s/include\\PyIServerSecurity.h
+                        %(win32com)s/include\\PyIServerSecurity.h      %(win32com)s/include\\PyIMultiQI.h
                         """ % dirs).split(),
                    libraries = "oleaut32 ole32 user32 urlmon",
                    export_symbol_file = 'com/win32com/src/PythonCOM.def',
@@ -1708,6 +1731,7 @@ com_extensions += [
                         %(internet)s/PyIInternetPriority.cpp        %(internet)s/PyIInternetProtocol.cpp
                         %(internet)s/PyIInternetProtocolInfo.cpp    %(internet)s/PyIInternetProtocolRoot.cpp
                         %(internet)s/PyIInternetProtocolSink.cpp    %(internet)s/PyIInternetSecurityManager.cpp
+                        %(internet)s/PyNativeProtocol.cpp
                     """ % dirs).split(),
                     depends=["%(internet)s/internet_pch.h" % dirs]),
     WinExt_win32com('mapi', libraries="advapi32", pch_header="PythonCOM.h",
@@ -1867,6 +1891,7 @@ com_extensions += [
                         %(taskscheduler)s/PyITask.cpp
                         %(taskscheduler)s/PyITaskScheduler.cpp
                         %(taskscheduler)s/PyITaskTrigger.cpp
+                        %(taskscheduler)s/TaskSnapshot.cpp
 
                         """ % dirs).split()),
     WinExt_win32com('bits', libraries='Bits', pch_header="bits_pch.h",
@@ -1896,7 +1921,7 @@ com_extensions += [
                         %(directsound)s/PyDSCCAPS.cpp       %(directsound)s/PyIDirectSound.cpp
                         %(directsound)s/PyIDirectSoundBuffer.cpp %(directsound)s/PyIDirectSoundCapture.cpp
                         %(directsound)s/PyIDirectSoundCaptureBuffer.cpp
-                        %(directsound)s/PyIDirectSoundNotify.cpp
+                        %(directsound)s/PyIDirectSoundNotify.cpp   %(directsound)s/PyDSStream.cpp
                         """ % dirs).split(),
                     depends=("""
                         %(directsound)s/directsound_pch.h   %(directsound)s/PyIDirectSound.h
@@ -2082,6 +2107,10 @@ W32_exe_files = [
          sources=[os.path.join("win32", "src", s) for s in
                   "PythonService.cpp PythonService.rc".split()],
          libraries = "user32 advapi32 ole32 shell32"),
+    # A host which fakes IIS, for load testing ISAPI extensions.
+    WinExt_ISAPI_subsys_con("PyISAPI_loadtest",
+         sources=[os.path.join("isapi", "src", "PyISAPI_loadtest.cpp")],
+         libraries = "advapi32"),
     WinExt_pythonwin_subsys_win("Pythonwin",
         sources = [
             "Pythonwin/pythonwin.cpp",
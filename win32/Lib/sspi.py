@@ -13,10 +13,63 @@ functions directly.
 """
 # Based on Roger Upole's sspi demos.
 # $Id$
+import threading
+import time
 import win32security, sspicon
 
 error = win32security.error
 
+# Credentials handles and package info are cached, so a server authenticating
+# many clients doesn't make a round trip to the LSA for each of them.  Cached
+# credentials are dropped this many seconds before they expire.
+credentials_expiry_margin = 300
+
+_cache_lock = threading.Lock()
+_credentials_cache = {} # (package, principal, use) -> (credentials, expiry)
+_package_info_cache = {}
+
+def _expires_soon(expiry):
+    try:
+        return expiry.timestamp() - credentials_expiry_margin < time.time()
+    except (AttributeError, ValueError, OverflowError, OSError):
+        # Credentials that never expire can have a timestamp past what
+        # datetime can represent.
+        return False
+
+def query_package_info(pkg_name):
+    """Returns the result of win32security.QuerySecurityPackageInfo for
+    the package, which is only looked up once per process."""
+    with _cache_lock:
+        info = _package_info_cache.get(pkg_name)
+        if info is None:
+            info = win32security.QuerySecurityPackageInfo(pkg_name)
+            _package_info_cache[pkg_name] = info
+        return info
+
+def acquire_credentials(pkg_name, principal, use, auth_info=None):
+    """Returns (credentials, expiry) as win32security.AcquireCredentialsHandle
+    does, reusing a handle acquired earlier for the same package, principal
+    and use until it is about to expire.  Credentials for an explicit
+    auth_info are never cached, so passwords aren't kept in memory.
+    """
+    if auth_info is not None:
+        return win32security.AcquireCredentialsHandle(principal, pkg_name,
+                                                      use, None, auth_info)
+    key = pkg_name, principal, use
+    with _cache_lock:
+        entry = _credentials_cache.get(key)
+        if entry is None or _expires_soon(entry[1]):
+            entry = win32security.AcquireCredentialsHandle(principal, pkg_name,
+                                                           use, None, None)
+            _credentials_cache[key] = entry
+        return entry
+
+def clear_credentials_cache():
+    """Forgets all cached credentials, eg after the process has changed the
+    user it runs as.  Handles already in use stay valid."""
+    with _cache_lock:
+        _credentials_cache.clear()
+
 class _BaseAuth(object):
     def __init__(self):
         self.reset()
@@ -31,6 +84,20 @@ class _BaseAuth(object):
         # The next seq_num for an encrypt/sign operation
         self.next_seq_num = 0
 
+    def _get_out_buffer(self):
+        """Returns the buffer for the next output token.  It is allocated
+        once, at the package's maximum token size, and reused for each step,
+        so the token returned by authorize is only valid until the next call.
+        """
+        max_token = self.pkg_info['MaxToken']
+        if self._out_buffer is None:
+            self._out_buffer = win32security.PySecBufferDescType()
+            self._out_buffer.append(
+                win32security.PySecBufferType(max_token, sspicon.SECBUFFER_TOKEN))
+        else:
+            self._out_buffer[0].SetRegion(0, max_token)
+        return self._out_buffer
+
     def _get_next_seq_num(self):
         """Get the next sequence number for a transmission.  Default
         implementation is to increment a counter
@@ -169,19 +236,27 @@ class ClientAuth(_BaseAuth):
                  auth_info = None, # or a tuple of (username, domain, password)
                  targetspn = None, # Target security context provider name.
                  scflags=None, # security context flags
-                 datarep=sspicon.SECURITY_NETWORK_DREP):
+                 datarep=sspicon.SECURITY_NETWORK_DREP,
+                 cache_credentials=True): # share credentials with other instances
         if scflags is None:
             scflags = sspicon.ISC_REQ_INTEGRITY|sspicon.ISC_REQ_SEQUENCE_DETECT|\
                       sspicon.ISC_REQ_REPLAY_DETECT|sspicon.ISC_REQ_CONFIDENTIALITY
         self.scflags=scflags
         self.datarep=datarep
         self.targetspn=targetspn
-        self.pkg_info=win32security.QuerySecurityPackageInfo(pkg_name)
-        self.credentials, \
-        self.credentials_expiry=win32security.AcquireCredentialsHandle(
-                client_name, self.pkg_info['Name'],
-                sspicon.SECPKG_CRED_OUTBOUND,
-                None, auth_info)
+        self.pkg_info=query_package_info(pkg_name)
+        if cache_credentials:
+            self.credentials, \
+            self.credentials_expiry=acquire_credentials(
+                    self.pkg_info['Name'], client_name,
+                    sspicon.SECPKG_CRED_OUTBOUND, auth_info)
+        else:
+            self.credentials, \
+            self.credentials_expiry=win32security.AcquireCredentialsHandle(
+                    client_name, self.pkg_info['Name'],
+                    sspicon.SECPKG_CRED_OUTBOUND,
+                    None, auth_info)
+        self._out_buffer = None
         _BaseAuth.__init__(self)
 
 
@@ -195,9 +270,7 @@ class ClientAuth(_BaseAuth):
             tokenbuf.Buffer=sec_buffer_in
             sec_buffer_new.append(tokenbuf)
             sec_buffer_in = sec_buffer_new
-        sec_buffer_out=win32security.PySecBufferDescType()
-        tokenbuf=win32security.PySecBufferType(self.pkg_info['MaxToken'], sspicon.SECBUFFER_TOKEN)
-        sec_buffer_out.append(tokenbuf)
+        sec_buffer_out=self._get_out_buffer()
         ## input context handle should be NULL on first call
         ctxtin=self.ctxt
         if self.ctxt is None:
@@ -232,7 +305,8 @@ class ServerAuth(_BaseAuth):
                  pkg_name,
                  spn = None,
                  scflags=None,
-                 datarep=sspicon.SECURITY_NETWORK_DREP):
+                 datarep=sspicon.SECURITY_NETWORK_DREP,
+                 cache_credentials=True): # share credentials with other instances
         self.spn=spn
         self.datarep=datarep
         
@@ -243,11 +317,17 @@ class ServerAuth(_BaseAuth):
         # if pkg_name=='Kerberos'?
         self.scflags=scflags
 
-        self.pkg_info=win32security.QuerySecurityPackageInfo(pkg_name)
+        self.pkg_info=query_package_info(pkg_name)
 
-        self.credentials, \
-        self.credentials_expiry=win32security.AcquireCredentialsHandle(spn,
-                self.pkg_info['Name'], sspicon.SECPKG_CRED_INBOUND, None, None)
+        if cache_credentials:
+            self.credentials, \
+            self.credentials_expiry=acquire_credentials(self.pkg_info['Name'],
+                    spn, sspicon.SECPKG_CRED_INBOUND)
+        else:
+            self.credentials, \
+            self.credentials_expiry=win32security.AcquireCredentialsHandle(spn,
+                    self.pkg_info['Name'], sspicon.SECPKG_CRED_INBOUND, None, None)
+        self._out_buffer = None
         _BaseAuth.__init__(self)
 
     def authorize(self, sec_buffer_in):
@@ -261,9 +341,7 @@ class ServerAuth(_BaseAuth):
             sec_buffer_new.append(tokenbuf)
             sec_buffer_in = sec_buffer_new
 
-        sec_buffer_out=win32security.PySecBufferDescType()
-        tokenbuf=win32security.PySecBufferType(self.pkg_info['MaxToken'], sspicon.SECBUFFER_TOKEN)
-        sec_buffer_out.append(tokenbuf)
+        sec_buffer_out=self._get_out_buffer()
         ## input context handle is None initially, then handle returned from last call thereafter
         ctxtin=self.ctxt
         if self.ctxt is None:
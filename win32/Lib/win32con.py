@@ -5069,3 +5069,43 @@ DBTF_XPORT = 0x00000002
 DBTF_SLOWNET = 0x00000004
 DBT_VPOWERDAPI = 0x8100
 DBT_USERDEFINED = 0xFFFF
+
+# Raw input, from winuser.h
+WM_INPUT_DEVICE_CHANGE = 0x00FE
+WM_INPUT = 0x00FF
+RIM_INPUT = 0
+RIM_INPUTSINK = 1
+RIM_TYPEMOUSE = 0
+RIM_TYPEKEYBOARD = 1
+RIM_TYPEHID = 2
+RIDEV_REMOVE = 0x00000001
+RIDEV_EXCLUDE = 0x00000010
+RIDEV_PAGEONLY = 0x00000020
+RIDEV_NOLEGACY = 0x00000030
+RIDEV_INPUTSINK = 0x00000100
+RIDEV_CAPTUREMOUSE = 0x00000200
+RIDEV_NOHOTKEYS = 0x00000200
+RIDEV_APPKEYS = 0x00000400
+RIDEV_EXINPUTSINK = 0x00001000
+RIDEV_DEVNOTIFY = 0x00002000
+MOUSE_MOVE_RELATIVE = 0
+MOUSE_MOVE_ABSOLUTE = 1
+MOUSE_VIRTUAL_DESKTOP = 0x02
+MOUSE_ATTRIBUTES_CHANGED = 0x04
+MOUSE_MOVE_NOCOALESCE = 0x08
+RI_MOUSE_LEFT_BUTTON_DOWN = 0x0001
+RI_MOUSE_LEFT_BUTTON_UP = 0x0002
+RI_MOUSE_RIGHT_BUTTON_DOWN = 0x0004
+RI_MOUSE_RIGHT_BUTTON_UP = 0x0008
+RI_MOUSE_MIDDLE_BUTTON_DOWN = 0x0010
+RI_MOUSE_MIDDLE_BUTTON_UP = 0x0020
+RI_MOUSE_BUTTON_4_DOWN = 0x0040
+RI_MOUSE_BUTTON_4_UP = 0x0080
+RI_MOUSE_BUTTON_5_DOWN = 0x0100
+RI_MOUSE_BUTTON_5_UP = 0x0200
+RI_MOUSE_WHEEL = 0x0400
+RI_MOUSE_HWHEEL = 0x0800
+RI_KEY_MAKE = 0
+RI_KEY_BREAK = 1
+RI_KEY_E0 = 2
+RI_KEY_E1 = 4
@@ -1862,6 +1862,8 @@ CRYPT_STRING_HEX_ANY = 0x00000008
 CRYPT_STRING_BASE64X509CRLHEADER = 0x00000009
 CRYPT_STRING_HEXADDR = 0x0000000a
 CRYPT_STRING_HEXASCIIADDR = 0x0000000b
+CRYPT_STRING_HEXRAW = 0x0000000c
+CRYPT_STRING_NOCRLF = 0x40000000
 CRYPT_STRING_NOCR = (-2147483648)
 CRYPT_USER_KEYSET = 0x00001000
 PKCS12_IMPORT_RESERVED_MASK = (-65536)
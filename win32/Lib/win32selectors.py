@@ -0,0 +1,63 @@
+"""Selectors for Windows sockets - helper for win32file.CreateSocketSelector
+
+SocketSelector is a selectors.BaseSelector which is not limited to the 512
+sockets select() can handle, and which only looks at the sockets whose
+network events fired.  For example:
+
+    import selectors, win32selectors
+    sel = win32selectors.SocketSelector()
+    sel.register(sock, selectors.EVENT_READ, callback)
+    for key, events in sel.select(timeout):
+        key.data(key.fileobj, events)
+
+Note that registering a socket makes it non-blocking, and it stays
+non-blocking after it is unregistered.
+"""
+
+import math
+import selectors
+import win32event
+import win32file
+
+class SocketSelector(selectors._BaseSelectorImpl):
+    """A selector built on WSAEventSelect.  Only sockets can be registered."""
+
+    def __init__(self):
+        super().__init__()
+        self._selector = win32file.CreateSocketSelector()
+
+    def register(self, fileobj, events, data=None):
+        key = super().register(fileobj, events, data)
+        try:
+            self._selector.Register(key.fd, events, key)
+        except:
+            super().unregister(fileobj)
+            raise
+        return key
+
+    def unregister(self, fileobj):
+        key = super().unregister(fileobj)
+        self._selector.Unregister(key.fd)
+        return key
+
+    def modify(self, fileobj, events, data=None):
+        try:
+            key = self._fd_to_key[self._fileobj_lookup(fileobj)]
+        except KeyError:
+            raise KeyError("{!r} is not registered".format(fileobj)) from None
+        if events != key.events or data != key.data:
+            key = key._replace(events=events, data=data)
+            self._selector.Modify(key.fd, events, key)
+            self._fd_to_key[key.fd] = key
+        return key
+
+    def select(self, timeout=None):
+        if timeout is None:
+            ms = win32event.INFINITE
+        else:
+            ms = max(0, math.ceil(timeout * 1000))
+        return [(key, events) for key, events, networkEvents in self._selector.Select(ms)]
+
+    def close(self):
+        self._selector.Close()
+        super().close()
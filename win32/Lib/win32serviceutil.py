@@ -258,6 +258,109 @@ def InstallPythonClassString(pythonClassString, serviceName):
         finally:
             win32api.RegCloseKey(key)
 
+def BuildServiceBundle(pythonClassString, bundleFileName, excludes = None):
+    """Writes the compiled code of the service's module, and of every pure
+    Python module it imports, to a zip file.
+
+    Once registered via InstallServiceBundle, PythonService.exe puts the bundle
+    first on sys.path when loading the service, so the modules load from a
+    single file without searching sys.path or compiling source.  The bundle
+    must be rebuilt whenever the service or the modules it uses change.
+    Returns the number of modules written.
+    """
+    import modulefinder, zipfile, marshal, struct, time, importlib.util
+    path, sep, classString = pythonClassString.rpartition("\\")
+    moduleName = classString.rsplit(".", 1)[0]
+    searchPath = ([path] if path else []) + sys.path
+    finder = modulefinder.ModuleFinder(searchPath, excludes=excludes or [])
+    finder.import_hook(moduleName)
+    count = 0
+    with zipfile.ZipFile(bundleFileName, "w", zipfile.ZIP_STORED) as bundle:
+        for name, mod in sorted(finder.modules.items()):
+            fileName = mod.__file__
+            if not fileName or not fileName.endswith(".py"):
+                continue # builtin, extension or namespace module.
+            with open(fileName, "rb") as f:
+                source = f.read()
+            code = compile(source, fileName, "exec", dont_inherit=True)
+            header = importlib.util.MAGIC_NUMBER + struct.pack("<III", 0, int(os.path.getmtime(fileName)) & 0xFFFFFFFF, len(source) & 0xFFFFFFFF)
+            if mod.__path__:
+                arcName = name.replace(".", "/") + "/__init__.pyc"
+            else:
+                arcName = name.replace(".", "/") + ".pyc"
+            info = zipfile.ZipInfo(arcName, time.localtime(os.path.getmtime(fileName))[:6])
+            bundle.writestr(info, header + marshal.dumps(code))
+            count = count + 1
+    return count
+
+def InstallServiceBundle(serviceName, bundleFileName):
+    """Nominates the bundle built by BuildServiceBundle the service loads its
+    code from, or with None, removes it."""
+    key = win32api.RegCreateKey(win32con.HKEY_LOCAL_MACHINE, "System\\CurrentControlSet\\Services\\%s\\PythonClass" % serviceName)
+    try:
+        if bundleFileName:
+            win32api.RegSetValueEx(key, "Bundle", 0, win32con.REG_SZ, os.path.abspath(bundleFileName))
+        else:
+            try:
+                win32api.RegDeleteValue(key, "Bundle")
+            except win32api.error as exc:
+                if exc.winerror != winerror.ERROR_FILE_NOT_FOUND:
+                    raise
+    finally:
+        win32api.RegCloseKey(key)
+
+# The counters of the perfmon object pythonservice publishes for a service
+# installed with InstallServiceMetrics, in the order of the title offsets in
+# PythonService.cpp.
+_serviceMetricsCounters = [
+    ("SERVICE", "Python Service", "Runtime metrics of a service hosted by pythonservice."),
+    ("CONTROL_REQUESTS", "Control requests/sec", "The rate service control requests are delivered to the service's control handler."),
+    ("CONTROL_TIME", "Avg. control time", "The average time from the service control manager sending a control request to the service's handler returning, including the wait for the GIL."),
+    ("CONTROL_TIME_BASE", "Avg. control time base", "The base of Avg. control time."),
+    ("GIL_WAIT", "GIL wait (microseconds)", "How long the host's sampler, once a second, last waited to acquire the GIL - a measure of how long the service's threads hold it."),
+    ("ALLOCATED_BLOCKS", "Python allocated blocks", "The number of memory blocks allocated by the Python interpreter, as returned by sys.getallocatedblocks()."),
+    ("THREADS", "Python threads", "The number of threads with a Python thread state."),
+    ("REQUESTS", "Requests/sec", "The rate of requests reported by the service with servicemanager.CountRequests."),
+]
+
+def InstallServiceMetrics(serviceName, dllName = None):
+    """Publishes pythonservice's standard perfmon object for the service.
+
+    A copy of perfmondata.dll named after the service is registered as its
+    performance DLL, the counter names are loaded, and the service's
+    PythonClass key names the mapping the host fills.  This replaces any
+    perfmon data installed with perfMonIni."""
+    import shutil, tempfile
+    if not dllName:
+        dllName = os.path.join(os.path.split(win32service.__file__)[0], "perfmondata.dll")
+    mappingName = serviceName + "_metrics"
+    metricsDll = os.path.join(os.path.split(win32api.GetFullPathName(dllName))[0], mappingName + ".dll")
+    shutil.copyfile(dllName, metricsDll)
+    tempDir = tempfile.mkdtemp()
+    try:
+        with open(os.path.join(tempDir, "pyservice_metrics.h"), "w") as f:
+            for i, (symbol, name, help) in enumerate(_serviceMetricsCounters):
+                f.write("#define %s %d\n" % (symbol, i*2))
+        iniName = os.path.join(tempDir, "pyservice_metrics.ini")
+        with open(iniName, "w") as f:
+            f.write("[info]\ndrivername=%s\nsymbolfile=pyservice_metrics.h\n\n" % serviceName)
+            f.write("[languages]\n009=English\n\n[text]\n")
+            for symbol, name, help in _serviceMetricsCounters:
+                f.write("%s_009_NAME=%s\n%s_009_HELP=%s\n" % (symbol, name, symbol, help))
+        try:
+            import perfmon
+            perfmon.UnloadPerfCounterTextStrings("python.exe "+serviceName)
+        except (ImportError, win32api.error):
+            pass
+        InstallPerfmonForService(serviceName, iniName, metricsDll)
+    finally:
+        shutil.rmtree(tempDir, ignore_errors = True)
+    key = win32api.RegCreateKey(win32con.HKEY_LOCAL_MACHINE, "System\\CurrentControlSet\\Services\\%s\\PythonClass" % serviceName)
+    try:
+        win32api.RegSetValueEx(key, "Metrics", 0, win32con.REG_SZ, mappingName)
+    finally:
+        win32api.RegCloseKey(key)
+
 # Utility functions for Services, to allow persistant properties.
 def SetServiceCustomOption(serviceName, option, value):
     try:
@@ -519,6 +622,10 @@ def usage():
     print(" --perfmonini file: .ini file to use for registering performance monitor data")
     print(" --perfmondll file: .dll file to use when querying the service for")
     print("   performance data, default = perfmondata.dll")
+    print(" --bundle file: compile the service and the modules it imports into a")
+    print("   zip file the service loads them from, for faster starts")
+    print(" --metrics : publish the host's standard performance counters (control")
+    print("   requests, GIL wait, interpreter threads and allocations) for the service")
     print("Options for 'start' and 'stop' commands only:")
     print(" --wait seconds: Wait for the service to actually start or stop.")
     print("                 If you specify --wait with the 'stop' option, the service")
@@ -550,7 +657,7 @@ def HandleCommandLine(cls, serviceClassString = None, argv = None, customInstall
     # Pull apart the command line
     import getopt
     try:
-        opts, args = getopt.getopt(argv[1:], customInstallOptions,["password=","username=","startup=","perfmonini=", "perfmondll=", "interactive", "wait="])
+        opts, args = getopt.getopt(argv[1:], customInstallOptions,["password=","username=","startup=","perfmonini=", "perfmondll=", "interactive", "wait=", "bundle=", "metrics"])
     except getopt.error as details:
         print(details)
         usage()
@@ -561,6 +668,8 @@ def HandleCommandLine(cls, serviceClassString = None, argv = None, customInstall
     delayedstart = None
     interactive = None
     waitSecs = 0
+    bundleFileName = None
+    metrics = 0
     for opt, val in opts:
         if opt=='--username':
             userName = val
@@ -572,6 +681,10 @@ def HandleCommandLine(cls, serviceClassString = None, argv = None, customInstall
             perfMonDll = val
         elif opt=='--interactive':
             interactive = 1
+        elif opt=='--bundle':
+            bundleFileName = val
+        elif opt=='--metrics':
+            metrics = 1
         elif opt=='--startup':
             map = {"manual": win32service.SERVICE_DEMAND_START,
                    "auto" : win32service.SERVICE_AUTO_START,
@@ -739,6 +852,21 @@ def HandleCommandLine(cls, serviceClassString = None, argv = None, customInstall
         except win32service.error as exc:
             print("Error stopping service: %s (%d)" % (exc.strerror,exc.winerror))
             err = exc.winerror
+    if bundleFileName and arg in ("install", "update") and not err:
+        try:
+            count = BuildServiceBundle(serviceClassString, bundleFileName)
+            InstallServiceBundle(serviceName, bundleFileName)
+            print("Bundled %d modules into %s" % (count, bundleFileName))
+        except (ImportError, SyntaxError, OSError, win32api.error) as exc:
+            print("Error building the service bundle: %s" % (exc,))
+            err = -1
+    if metrics and arg in ("install", "update") and not err:
+        try:
+            InstallServiceMetrics(serviceName, perfMonDll)
+            print("Installed performance counters for the service")
+        except (OSError, win32api.error) as exc:
+            print("Error installing the service performance counters: %s" % (exc,))
+            err = -1
     if not knownArg:
         err = -1
         print("Unknown command - '%s'" % arg)
@@ -758,13 +886,41 @@ class ServiceFramework:
     _exe_name_ = None        # Default to PythonService.exe
     _exe_args_ = None        # Default to no arguments
     _svc_description_ = None # Only exists on Windows 2000 or later, ignored on windows NT
+    _svc_queue_controls_ = False # If True, controls are handled on a thread of our own, and
+                                 # the SCM is answered (and told of stop progress) natively.
 
     def __init__(self, args):
         import servicemanager
-        self.ssh = servicemanager.RegisterServiceCtrlHandler(args[0], self.ServiceCtrlHandlerEx, True)
+        self._ctrlThread = None
+        # Services in a subinterpreter can only have their controls queued.
+        inMain = servicemanager.GetServiceInterpreter(args[0]) == servicemanager.PYS_INTERPRETER_MAIN
+        if self._svc_queue_controls_ or not inMain:
+            self.ssh = servicemanager.RegisterServiceCtrlHandler(args[0], self.ServiceCtrlHandlerEx, True, True)
+            import threading, win32event
+            self._ctrlThreadStop = win32event.CreateEvent(None, True, False, None)
+            self._ctrlThread = threading.Thread(target=self._DispatchQueuedControls, args=(args[0],))
+            # Subinterpreters may not allow daemon threads, but SvcRun stops the thread anyway.
+            self._ctrlThread.daemon = inMain
+            self._ctrlThread.start()
+        else:
+            self.ssh = servicemanager.RegisterServiceCtrlHandler(args[0], self.ServiceCtrlHandlerEx, True)
         servicemanager.SetEventSourceName(self._svc_name_)
         self.checkPoint = 0
 
+    def _DispatchQueuedControls(self, serviceName):
+        import servicemanager, win32event
+        handles = servicemanager.GetQueuedControlEvent(serviceName), self._ctrlThreadStop
+        while win32event.WaitForMultipleObjects(handles, False, win32event.INFINITE) == win32event.WAIT_OBJECT_0:
+            servicemanager.DispatchQueuedControls(serviceName)
+
+    def _StopQueuedControls(self):
+        # The thread must finish before the service does, as the interpreter may end with it.
+        if self._ctrlThread is not None:
+            import win32event
+            win32event.SetEvent(self._ctrlThreadStop)
+            self._ctrlThread.join()
+            self._ctrlThread = None
+
     def GetAcceptedControls(self):
         # Setup the service controls we accept based on our attributes. Note
         # that if you need to handle controls via SvcOther[Ex](), you must
@@ -843,9 +999,12 @@ class ServiceFramework:
         # If this method raises an exception, the C framework will detect this
         # and report a SERVICE_STOPPED status with a non-zero error code.
 
-        self.ReportServiceStatus(win32service.SERVICE_RUNNING)
-        self.SvcDoRun()
-        # Once SvcDoRun terminates, the service has stopped.
-        # We tell the SCM the service is still stopping - the C framework
-        # will automatically tell the SCM it has stopped when this returns.
-        self.ReportServiceStatus(win32service.SERVICE_STOP_PENDING)
+        try:
+            self.ReportServiceStatus(win32service.SERVICE_RUNNING)
+            self.SvcDoRun()
+            # Once SvcDoRun terminates, the service has stopped.
+            # We tell the SCM the service is still stopping - the C framework
+            # will automatically tell the SCM it has stopped when this returns.
+            self.ReportServiceStatus(win32service.SERVICE_STOP_PENDING)
+        finally:
+            self._StopQueuedControls()
@@ -138,3 +138,11 @@ PERF_DETAIL_ADVANCED = 200
 PERF_DETAIL_EXPERT = 300
 PERF_DETAIL_WIZARD = 400
 PERF_NO_UNIQUE_ID = -1
+
+# Instance types of PerfLib v2 counter sets (perflib.h)
+PERF_COUNTERSET_SINGLE_INSTANCE = 0
+PERF_COUNTERSET_MULTI_INSTANCES = 2
+PERF_COUNTERSET_SINGLE_AGGREGATE = 4
+PERF_COUNTERSET_MULTI_AGGREGATE = 6
+PERF_COUNTERSET_SINGLE_AGGREGATE_HISTORY = 0x0E
+PERF_COUNTERSET_INSTANCE_AGGREGATE = 0x16
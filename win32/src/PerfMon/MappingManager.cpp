@@ -36,7 +36,7 @@ BOOL MappingManager::CheckStatus()
 }
 
 BOOL MappingManager::Init(const TCHAR *szServiceName, const TCHAR *szMappingName /* = NULL */,
-                          const TCHAR *szEventSourceName /* = NULL */)
+                          const TCHAR *szEventSourceName /* = NULL */, DWORD mapSize /* = 4096 */)
 {
     TCHAR szGlobalMapping[MAX_PATH + 10] = _T("");
 
@@ -50,7 +50,8 @@ BOOL MappingManager::Init(const TCHAR *szServiceName, const TCHAR *szMappingName
     _tcscpy(szGlobalMapping, _T("Global\\"));
     _tcscat(szGlobalMapping, szMappingName);
 
-    m_hMappedObject = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, 4096, szGlobalMapping);
+    m_MapSize = mapSize;
+    m_hMappedObject = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, m_MapSize, szGlobalMapping);
     if (m_hMappedObject == NULL) {
         PyWin_SetAPIError("CreateFileMapping");
         return FALSE;
@@ -73,6 +74,10 @@ BOOL MappingManager::Init(const TCHAR *szServiceName, const TCHAR *szMappingName
 
     _tcsncpy(m_pControl->EventSourceName, szEventSourceName, MMCD_EVENTSOURCE_SIZE);
     m_pControl->EventSourceName[MMCD_EVENTSOURCE_SIZE] = _T('\0');
+    m_pControl->MaxInstances = 0;
+    m_pControl->InstanceSlotSize = 0;
+    m_pControl->InstanceSlotsOffset = 0;
+    m_pControl->InstanceSequence = 0;
     m_pControl->supplierStatus = SupplierStatusRunning;
     return TRUE;
 }
@@ -81,6 +86,10 @@ void *MappingManager::AllocChunk(DWORD numBytes)
 {
     if (!CheckStatus())
         return NULL;
+    if (m_pControl->TotalSize + numBytes > m_MapSize) {
+        PyErr_SetString(PyExc_MemoryError, "The performance data does not fit in the file mapping");
+        return NULL;
+    }
     void *result = ((BYTE *)m_pMapBlock) + (m_pControl->TotalSize);
     m_pControl->TotalSize += numBytes;
     return result;
@@ -99,6 +108,8 @@ PyObject *PerfmonMethod_NewPerfMonManager(PyObject *self, PyObject *args)
     TCHAR *szServiceName = NULL;
     MappingManager *m_pmm = NULL;
     PyPerfMonManager *pPOT = NULL;
+    PyPERF_OBJECT_TYPE *pPerfOb;
+    DWORD mapSize = 4096;
 
     if (!PyArg_ParseTuple(
             args, "OO|OO:PerfMonManager",
@@ -124,12 +135,23 @@ PyObject *PerfmonMethod_NewPerfMonManager(PyObject *self, PyObject *args)
     if (!PyWinObject_AsTCHAR(obMappingName, &szMappingName, TRUE))
         goto done;
 
+    // Objects with instances may need more than the default mapping size.
+    if (PySequence_Check(obPerfObTypes) && PySequence_Length(obPerfObTypes) == 1) {
+        PyObject *obType = PySequence_GetItem(obPerfObTypes, 0);
+        if (obType && PyPERF_OBJECT_TYPE_Check(obType)) {
+            pPerfOb = (PyPERF_OBJECT_TYPE *)obType;
+            mapSize = max(mapSize, (DWORD)sizeof(MappingManagerControlData) + pPerfOb->GetMemoryLayoutSize());
+        }
+        Py_XDECREF(obType);
+    }
+    PyErr_Clear();  // Any problem with the sequence is reported by PyPerfMonManager::Init
+
     m_pmm = new MappingManager();
     if (m_pmm == NULL) {
         PyErr_SetString(PyExc_MemoryError, "Allocating memory for MappingManager");
         goto done;
     }
-    if (!m_pmm->Init(szServiceName, szMappingName, szEventSourceName))
+    if (!m_pmm->Init(szServiceName, szMappingName, szEventSourceName, mapSize))
         // Init has set Python error
         goto done;
 
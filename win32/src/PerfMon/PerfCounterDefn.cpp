@@ -40,7 +40,7 @@ PyObject *PyPERF_COUNTER_DEFINITION::Increment(PyObject *self, PyObject *args)
 
     DWORD *pVal = (DWORD *)(This->m_pCounterValue);
     if (pVal)
-        *pVal += incrBy;
+        PerfCounterAdd(pVal, incrBy);
     Py_INCREF(Py_None);
     return Py_None;
 }
@@ -55,7 +55,7 @@ PyObject *PyPERF_COUNTER_DEFINITION::Decrement(PyObject *self, PyObject *args)
 
     DWORD *pVal = (DWORD *)(This->m_pCounterValue);
     if (pVal)
-        *pVal -= incrBy;
+        PerfCounterAdd(pVal, -incrBy);
     Py_INCREF(Py_None);
     return Py_None;
 }
@@ -70,7 +70,7 @@ PyObject *PyPERF_COUNTER_DEFINITION::Set(PyObject *self, PyObject *args)
 
     DWORD *pVal = (DWORD *)(This->m_pCounterValue);
     if (pVal)
-        *pVal = setTo;
+        PerfCounterSet(pVal, setTo);
     Py_INCREF(Py_None);
     return Py_None;
 }
@@ -90,6 +90,66 @@ PyObject *PyPERF_COUNTER_DEFINITION::Get(PyObject *self, PyObject *args)
     return PyInt_FromLong(*pVal);
 }
 
+// @pymethod <o PyPERF_COUNTER_CELL>|PyPERF_COUNTER_DEFINITION|CreateCell|Creates a cell which accumulates increments
+// of the counter
+// @comm Increments of a cell only touch the counter when the cell is flushed, so a cell
+// per thread (for example in a threading.local) makes frequent increments very cheap.
+PyObject *PyPERF_COUNTER_DEFINITION::CreateCell(PyObject *self, PyObject *args)
+{
+    DWORD flushEvery = 0;
+    // @pyparm int|flushEvery|0|If not zero, the cell flushes itself after this many increments.
+    if (!PyArg_ParseTuple(args, "|k:CreateCell", &flushEvery))
+        return NULL;
+    return new PyPERF_COUNTER_CELL((PyPERF_COUNTER_DEFINITION *)self, NULL, flushEvery);
+}
+
+// @pymethod |perfmon|UpdateCounters|Applies a number of counter increments in one call
+// @comm Each item is either (counter, delta) for a counter of an object without instances,
+// or (instance, counter, delta) for a counter of a <o PyPERF_INSTANCE>.  As with
+// <om PyPERF_COUNTER_DEFINITION.Increment>, counters not in a block are silently ignored.
+PyObject *PerfmonMethod_UpdateCounters(PyObject *self, PyObject *args)
+{
+    PyObject *obUpdates;
+    // @pyparm [(<o PyPERF_COUNTER_DEFINITION>, int)\|(<o PyPERF_INSTANCE>, <o PyPERF_COUNTER_DEFINITION>, int), ...]|updates||
+    if (!PyArg_ParseTuple(args, "O:UpdateCounters", &obUpdates))
+        return NULL;
+    TmpPyObject updates = PySequence_Fast(obUpdates, "updates must be a sequence");
+    if (updates == NULL)
+        return NULL;
+    Py_ssize_t n = PySequence_Fast_GET_SIZE((PyObject *)updates);
+    for (Py_ssize_t i = 0; i < n; i++) {
+        PyObject *item = PySequence_Fast_GET_ITEM((PyObject *)updates, i);
+        PyObject *obInstance = NULL, *obCounter;
+        long delta;
+        if (PyTuple_Check(item) && PyTuple_GET_SIZE(item) == 3) {
+            if (!PyArg_ParseTuple(item, "OOl:UpdateCounters", &obInstance, &obCounter, &delta))
+                return NULL;
+        }
+        else if (!PyArg_ParseTuple(item, "Ol:UpdateCounters", &obCounter, &delta))
+            return NULL;
+        DWORD *pVal;
+        if (obInstance) {
+            if (!PyPERF_INSTANCE_Check(obInstance)) {
+                PyErr_SetString(PyExc_TypeError, "The object is not a PyPERF_INSTANCE object");
+                return NULL;
+            }
+            pVal = ((PyPERF_INSTANCE *)obInstance)->GetCounterValue(obCounter);
+        }
+        else {
+            PyPERF_COUNTER_DEFINITION *pCounter;
+            if (!PyWinObject_AsPyPERF_COUNTER_DEFINITION(obCounter, &pCounter, FALSE))
+                return NULL;
+            pVal = pCounter->GetCounterValue();
+        }
+        if (pVal)
+            PerfCounterAdd(pVal, delta);
+        else if (PyErr_Occurred())
+            return NULL;
+    }
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
 // @object PyPERF_COUNTER_DEFINITION|An object encapsulating a Windows NT Performance Monitor counter definition
 // (PERF_COUNTER_DEFINITION).
 // @comm Note that all the counter "set" functions will silently do nothing
@@ -103,6 +163,8 @@ struct PyMethodDef PyPERF_COUNTER_DEFINITION::methods[] = {
      1},                                         // @pymeth Decrement|Decrements the value of the performance counter
     {"Set", PyPERF_COUNTER_DEFINITION::Set, 1},  // @pymeth Set|Sets the counter to a specific value
     {"Get", PyPERF_COUNTER_DEFINITION::Get, 1},  // @pymeth Get|Gets the current value of the counter
+    {"CreateCell", PyPERF_COUNTER_DEFINITION::CreateCell,
+     1},  // @pymeth CreateCell|Creates a cell which accumulates increments of the counter
     {NULL}};
 
 PyTypeObject PyPERF_COUNTER_DEFINITION::type = {
@@ -206,4 +268,124 @@ void PyPERF_COUNTER_DEFINITION::AcceptRawCounterBuffer(void *pBuffer, DWORD offs
     memset(pBuffer, 0, m_CounterSize);
 }
 
+// For objects with instances - each instance has its own counter block, so the definition has no value.
+void PyPERF_COUNTER_DEFINITION::AcceptInstanceCounterOffset(DWORD offset)
+{
+    if (m_pPCD == NULL)
+        return;
+    m_pPCD->CounterOffset = offset;
+    m_pCounterValue = NULL;
+}
+
 /*static*/ void PyPERF_COUNTER_DEFINITION::deallocFunc(PyObject *ob) { delete (PyPERF_COUNTER_DEFINITION *)ob; }
+
+PyPERF_COUNTER_CELL::PyPERF_COUNTER_CELL(PyPERF_COUNTER_DEFINITION *obCounter, PyPERF_INSTANCE *obInstance,
+                                         DWORD flushEvery)
+{
+    ob_type = &type;
+    _Py_NewReference(this);
+    m_obCounter = obCounter;
+    Py_INCREF(m_obCounter);
+    m_obInstance = obInstance;
+    Py_XINCREF(m_obInstance);
+    m_Pending = 0;
+    m_PendingCount = 0;
+    m_FlushEvery = flushEvery;
+}
+
+PyPERF_COUNTER_CELL::~PyPERF_COUNTER_CELL()
+{
+    FoldPending();
+    Py_DECREF(m_obCounter);
+    Py_XDECREF(m_obInstance);
+}
+
+// Adds the pending increments to the counter.  They are dropped if the counter no longer exists.
+void PyPERF_COUNTER_CELL::FoldPending()
+{
+    if (m_PendingCount == 0)
+        return;
+    DWORD *pVal = m_obInstance ? m_obInstance->GetCounterValue(m_obCounter) : m_obCounter->GetCounterValue();
+    if (pVal && m_Pending)
+        PerfCounterAdd(pVal, m_Pending);
+    m_Pending = 0;
+    m_PendingCount = 0;
+}
+
+// @pymethod |PyPERF_COUNTER_CELL|Increment|Adds to the cell
+PyObject *PyPERF_COUNTER_CELL::Increment(PyObject *self, PyObject *args)
+{
+    PyPERF_COUNTER_CELL *This = (PyPERF_COUNTER_CELL *)self;
+    int incrBy = 1;
+    // @pyparm int|incrBy|1|Amount to add, which may be negative
+    if (!PyArg_ParseTuple(args, "|i:Increment", &incrBy))
+        return NULL;
+    This->m_Pending += incrBy;
+    if (++This->m_PendingCount == This->m_FlushEvery)
+        This->FoldPending();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod |PyPERF_COUNTER_CELL|Flush|Adds the increments accumulated since the last flush to the counter
+// @comm The cell is also flushed when it is destroyed.
+PyObject *PyPERF_COUNTER_CELL::Flush(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":Flush"))
+        return NULL;
+    ((PyPERF_COUNTER_CELL *)self)->FoldPending();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @object PyPERF_COUNTER_CELL|Accumulates increments of a counter, created by
+// <om PyPERF_COUNTER_DEFINITION.CreateCell> or <om PyPERF_INSTANCE.CreateCell>.
+// @comm A cell is not shared with the collector until it is flushed, and is meant to be
+// used by a single thread.
+struct PyMethodDef PyPERF_COUNTER_CELL::methods[] = {
+    {"Increment", PyPERF_COUNTER_CELL::Increment, 1},  // @pymeth Increment|Adds to the cell
+    {"Flush", PyPERF_COUNTER_CELL::Flush,
+     1},  // @pymeth Flush|Adds the increments accumulated since the last flush to the counter
+    {NULL}};
+
+#undef OFF
+#define OFF(e) offsetof(PyPERF_COUNTER_CELL, e)
+
+/*static*/ struct PyMemberDef PyPERF_COUNTER_CELL::members[] = {
+    {"Pending", T_LONG, OFF(m_Pending), READONLY},  // @prop integer|Pending|The total not yet added to the counter.
+    {"FlushEvery", T_ULONG, OFF(m_FlushEvery)},     // @prop integer|FlushEvery|Increments between automatic flushes, or 0.
+    {NULL}                                          /* Sentinel */
+};
+
+PyTypeObject PyPERF_COUNTER_CELL::type = {
+    PYWIN_OBJECT_HEAD "PyPERF_COUNTER_CELL",
+    sizeof(PyPERF_COUNTER_CELL),
+    0,
+    PyPERF_COUNTER_CELL::deallocFunc, /* tp_dealloc */
+    0,                                /* tp_print */
+    0,                                /* tp_getattr */
+    0,                                /* tp_setattr */
+    0,                                /* tp_compare */
+    0,                                /* tp_repr */
+    0,                                /* tp_as_number */
+    0,                                /* tp_as_sequence */
+    0,                                /* tp_as_mapping */
+    0,                                /* tp_hash */
+    0,                                /* tp_call */
+    0,                                /* tp_str */
+    PyObject_GenericGetAttr,          /* tp_getattro */
+    PyObject_GenericSetAttr,          /* tp_setattro */
+    0,                                /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,               /* tp_flags */
+    0,                                /* tp_doc */
+    0,                                /* tp_traverse */
+    0,                                /* tp_clear */
+    0,                                /* tp_richcompare */
+    0,                                /* tp_weaklistoffset */
+    0,                                /* tp_iter */
+    0,                                /* tp_iternext */
+    PyPERF_COUNTER_CELL::methods,     /* tp_methods */
+    PyPERF_COUNTER_CELL::members,     /* tp_members */
+};
+
+/*static*/ void PyPERF_COUNTER_CELL::deallocFunc(PyObject *ob) { delete (PyPERF_COUNTER_CELL *)ob; }
@@ -26,8 +26,12 @@ BOOL PyWinObject_AsPyPERF_OBJECT_TYPE(PyObject *ob, PyPERF_OBJECT_TYPE **ppPyPER
 PyObject *PerfmonMethod_NewPERF_OBJECT_TYPE(PyObject *self, PyObject *args)
 {
     PyObject *obCounters;
+    DWORD maxInstances = 0;
 
-    if (!PyArg_ParseTuple(args, "O:ObjectType", &obCounters))
+    if (!PyArg_ParseTuple(args, "O|k:ObjectType",
+                          &obCounters,     // @pyparm [<o PyPERF_COUNTER_DEFINITION>, ...]|counters||The counters
+                          &maxInstances))  // @pyparm int|maxInstances|0|If not zero, the object has instances, up to
+                                           // this many of which can exist at once (see <om PyPERF_OBJECT_TYPE.AddInstance>).
         return NULL;
 
     PyPERF_OBJECT_TYPE *pPOT = new (PyPERF_OBJECT_TYPE);
@@ -35,7 +39,7 @@ PyObject *PerfmonMethod_NewPERF_OBJECT_TYPE(PyObject *self, PyObject *args)
         PyErr_SetString(PyExc_MemoryError, "Allocating MappingManager or PERF_OBJECT_TYPE");
         return NULL;
     }
-    if (!pPOT->InitPythonObjects(obCounters)) {
+    if (!pPOT->InitPythonObjects(obCounters, maxInstances)) {
         delete pPOT;
         return NULL;
     }
@@ -56,6 +60,7 @@ PyObject *PyPERF_OBJECT_TYPE::Close(PyObject *self, PyObject *args)
 // @object PyPERF_OBJECT_TYPE|A Python object, representing a PERF_OBJECT_TYPE structure
 struct PyMethodDef PyPERF_OBJECT_TYPE::methods[] = {
     {"Close", PyPERF_OBJECT_TYPE::Close, 1},  // @pymeth Close|Closes all counters.
+    {"AddInstance", PyPERF_OBJECT_TYPE::AddInstance, 1},  // @pymeth AddInstance|Adds an instance of the object.
     {NULL}};
 
 PyTypeObject PyPERF_OBJECT_TYPE::type = {
@@ -104,6 +109,8 @@ PyTypeObject PyPERF_OBJECT_TYPE::type = {
     {"ObjectNameTitleIndex", T_LONG, OFF(m_ObjectNameTitleIndex)},  // @prop integer|ObjectNameTitleIndex|
     {"ObjectHelpTitleIndex", T_LONG, OFF(m_ObjectHelpTitleIndex)},  // @prop integer|ObjectHelpTitleIndex|
     {"DefaultCounterIndex", T_LONG, OFF(m_DefaultCounter)},         // @prop integer|DefaultCounterIndex|
+    {"MaxInstances", T_ULONG, OFF(m_MaxInstances), READONLY},       // @prop integer|MaxInstances|
+    {"NumInstances", T_ULONG, OFF(m_NumInstances), READONLY},       // @prop integer|NumInstances|
     {NULL}};
 
 PyPERF_OBJECT_TYPE::PyPERF_OBJECT_TYPE(void)
@@ -116,6 +123,12 @@ PyPERF_OBJECT_TYPE::PyPERF_OBJECT_TYPE(void)
     m_ObjectNameTitleIndex = 0;
     m_ObjectHelpTitleIndex = 0;
     m_DefaultCounter = 0;
+    m_MaxInstances = 0;
+    m_NumInstances = 0;
+    m_InstanceSlotSize = 0;
+    m_InstanceCounterBlockSize = 0;
+    m_pInstanceSlots = NULL;
+    m_pControl = NULL;
 }
 
 PyPERF_OBJECT_TYPE::~PyPERF_OBJECT_TYPE() { Term(); }
@@ -123,6 +136,9 @@ PyPERF_OBJECT_TYPE::~PyPERF_OBJECT_TYPE() { Term(); }
 void PyPERF_OBJECT_TYPE::Term()
 {
     m_pPOT = NULL;
+    m_pInstanceSlots = NULL;
+    m_pControl = NULL;
+    m_NumInstances = 0;
     Py_XDECREF(m_obCounters);
     m_obCounters = NULL;
     Py_XDECREF(m_obPerfMonManager);
@@ -130,13 +146,126 @@ void PyPERF_OBJECT_TYPE::Term()
 }
 
 // Get the counter objects that Im gunna use.
-BOOL PyPERF_OBJECT_TYPE::InitPythonObjects(PyObject *obCounters)
+BOOL PyPERF_OBJECT_TYPE::InitPythonObjects(PyObject *obCounters, DWORD maxInstances /* = 0 */)
 {
     m_obCounters = obCounters;
     Py_XINCREF(obCounters);
+    m_MaxInstances = maxInstances;
     return TRUE;
 }
 
+// The size of the counter block of each instance, or of the object if it has no instances.
+static DWORD CounterBlockSize(PyObject *obCounters)
+{
+    DWORD size = sizeof(DWORD);
+    Py_ssize_t numCounters = PySequence_Length(obCounters);
+    for (Py_ssize_t i = 0; i < numCounters; i++) {
+        PyObject *obCounter = PySequence_GetItem(obCounters, i);
+        PyPERF_COUNTER_DEFINITION *pCounter;
+        if (obCounter && PyWinObject_AsPyPERF_COUNTER_DEFINITION(obCounter, &pCounter, FALSE))
+            size += pCounter->GetCounterDataSize();
+        Py_XDECREF(obCounter);
+    }
+    PyErr_Clear();
+    return size;
+}
+
+// Returns the number of bytes InitMemoryLayout allocates from the mapping - an estimate if the
+// counters are not valid, which InitMemoryLayout then reports.
+DWORD PyPERF_OBJECT_TYPE::GetMemoryLayoutSize()
+{
+    if (m_obCounters == NULL || !PySequence_Check(m_obCounters))
+        return 0;
+    DWORD numCounters = (DWORD)PySequence_Length(m_obCounters);
+    DWORD size = sizeof(PERF_OBJECT_TYPE) + numCounters * sizeof(PERF_COUNTER_DEFINITION);
+    DWORD blockSize = CounterBlockSize(m_obCounters);
+    if (m_MaxInstances == 0)
+        return size + blockSize;
+    // Counter blocks are 8 byte aligned in instance slots
+    DWORD slotSize = sizeof(MappingManagerInstanceHeader) + sizeof(PERF_INSTANCE_DEFINITION) +
+                     MMCD_INSTANCE_NAME_SIZE * sizeof(WCHAR) + ((blockSize + 7) & ~7);
+    return size + m_MaxInstances * slotSize;
+}
+
+BYTE *PyPERF_OBJECT_TYPE::GetInstanceCounterBlock(DWORD slot)
+{
+    if (m_pInstanceSlots == NULL || slot >= m_MaxInstances)
+        return NULL;
+    return m_pInstanceSlots + slot * m_InstanceSlotSize + sizeof(MappingManagerInstanceHeader) +
+           sizeof(PERF_INSTANCE_DEFINITION) + MMCD_INSTANCE_NAME_SIZE * sizeof(WCHAR);
+}
+
+void PyPERF_OBJECT_TYPE::FreeInstance(DWORD slot)
+{
+    if (m_pInstanceSlots == NULL || slot >= m_MaxInstances)
+        return;
+    MappingManagerInstanceHeader *pHeader = (MappingManagerInstanceHeader *)(m_pInstanceSlots + slot * m_InstanceSlotSize);
+    InterlockedIncrement(&m_pControl->InstanceSequence);
+    pHeader->InUse = FALSE;
+    InterlockedIncrement(&m_pControl->InstanceSequence);
+    m_NumInstances--;
+}
+
+// @pymethod <o PyPERF_INSTANCE>|PyPERF_OBJECT_TYPE|AddInstance|Adds an instance of the object.
+// @comm The object must have been created with maxInstances, and be part of a <o PyPerfMonManager>.
+// The instance is removed by <om PyPERF_INSTANCE.Remove>, or when the object is destroyed.
+PyObject *PyPERF_OBJECT_TYPE::AddInstance(PyObject *self, PyObject *args)
+{
+    PyPERF_OBJECT_TYPE *This = (PyPERF_OBJECT_TYPE *)self;
+    PyObject *obName;
+    if (!PyArg_ParseTuple(args, "O:AddInstance",
+                          &obName))  // @pyparm <o PyUnicode>|name||Name of the instance, which is truncated to 63
+                                     // characters.
+        return NULL;
+    if (This->m_pInstanceSlots == NULL) {
+        PyErr_SetString(PyExc_ValueError,
+                        "The object was not created with instances, or is not part of a PyPerfMonManager");
+        return NULL;
+    }
+    WCHAR *szName;
+    if (!PyWinObject_AsWCHAR(obName, &szName, FALSE))
+        return NULL;
+    MappingManagerInstanceHeader *pHeader = NULL;
+    DWORD slot;
+    for (slot = 0; slot < This->m_MaxInstances; slot++) {
+        pHeader = (MappingManagerInstanceHeader *)(This->m_pInstanceSlots + slot * This->m_InstanceSlotSize);
+        if (!pHeader->InUse)
+            break;
+    }
+    if (slot == This->m_MaxInstances) {
+        PyWinObject_FreeWCHAR(szName);
+        PyErr_SetString(PyExc_ValueError, "The object already has its maximum number of instances");
+        return NULL;
+    }
+    PyPERF_INSTANCE *ret = new PyPERF_INSTANCE(This, slot);
+    if (ret == NULL) {
+        PyWinObject_FreeWCHAR(szName);
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    PERF_INSTANCE_DEFINITION *pPID = (PERF_INSTANCE_DEFINITION *)(pHeader + 1);
+    WCHAR *pName = (WCHAR *)(pPID + 1);
+    PERF_COUNTER_BLOCK *pPCB = (PERF_COUNTER_BLOCK *)(pName + MMCD_INSTANCE_NAME_SIZE);
+    // The DLL ignores the slot until its sequence is even and unchanged again.
+    InterlockedIncrement(&This->m_pControl->InstanceSequence);
+    pPID->ByteLength = sizeof(PERF_INSTANCE_DEFINITION) + MMCD_INSTANCE_NAME_SIZE * sizeof(WCHAR);
+    pPID->ParentObjectTitleIndex = 0;
+    pPID->ParentObjectInstance = 0;
+    pPID->UniqueID = PERF_NO_UNIQUE_ID;
+    pPID->NameOffset = sizeof(PERF_INSTANCE_DEFINITION);
+    wcsncpy(pName, szName, MMCD_INSTANCE_NAME_SIZE - 1);
+    pName[MMCD_INSTANCE_NAME_SIZE - 1] = L'\0';
+    pPID->NameLength = (DWORD)(wcslen(pName) + 1) * sizeof(WCHAR);
+    memset(pPCB, 0, This->m_InstanceCounterBlockSize);
+    pPCB->ByteLength = This->m_InstanceCounterBlockSize;
+    pHeader->InUse = TRUE;
+    InterlockedIncrement(&This->m_pControl->InstanceSequence);
+    This->m_NumInstances++;
+    PyWinObject_FreeWCHAR(szName);
+    return ret;
+}
+
 // Init the memory layout of the win32 perfmon structures from the mapping manager.
 // Doesnt keep a reference to the mapping manager, but assumes it will stay alive
 // until Im term'd!
@@ -194,34 +323,68 @@ BOOL PyPERF_OBJECT_TYPE::InitMemoryLayout(MappingManager *pmm, PyPerfMonManager
         pCounter->AcceptBuffer(this, pBuffer);
         pCounter->SetupBuffer();
     }
-    // Now loop allocating the actual buffer for the raw counter data.
-    counterOffset = sizeof(DWORD);
-    totalCounterSize = sizeof(DWORD);
-    // Allocate 2 bytes which forms the header of the PERF_COUNTER_BLOCK
-    // structure.  Then each counter has its slot allocated.
-    pPCB = (PERF_COUNTER_BLOCK *)pmm->AllocChunk(sizeof(DWORD));
-    for (counterNum = 0; counterNum < numCounters; counterNum++) {
-        // Cleanup from last time round the loop (done: cleans last loop!)
-        if (obCounter) {
-            Py_DECREF(obCounter);
-            obCounter = NULL;
+    if (m_MaxInstances) {
+        // Each instance has its own counter block, in a slot which AddInstance fills in.
+        counterOffset = sizeof(DWORD);
+        for (counterNum = 0; counterNum < numCounters; counterNum++) {
+            if (obCounter) {
+                Py_DECREF(obCounter);
+                obCounter = NULL;
+            }
+            obCounter = PySequence_GetItem(obCounters, counterNum);
+            if (obCounter == NULL)
+                goto done;
+            if (!PyWinObject_AsPyPERF_COUNTER_DEFINITION(obCounter, &pCounter, FALSE))
+                goto done;
+            pCounter->AcceptInstanceCounterOffset(counterOffset);
+            counterOffset += pCounter->GetCounterDataSize();
         }
-        obCounter = PySequence_GetItem(obCounters, counterNum);
-        if (obCounter == NULL)
-            goto done;
-
-        if (!PyWinObject_AsPyPERF_COUNTER_DEFINITION(obCounter, &pCounter, FALSE))
+        m_InstanceCounterBlockSize = (counterOffset + 7) & ~7;
+        m_InstanceSlotSize = sizeof(MappingManagerInstanceHeader) + sizeof(PERF_INSTANCE_DEFINITION) +
+                             MMCD_INSTANCE_NAME_SIZE * sizeof(WCHAR) + m_InstanceCounterBlockSize;
+        m_pInstanceSlots = (BYTE *)pmm->AllocChunk(m_MaxInstances * m_InstanceSlotSize);
+        if (m_pInstanceSlots == NULL)
             goto done;
-        // Allocate memory for the raw counter data object.
-        thisCounterSize = pCounter->GetCounterDataSize();
-        totalCounterSize += thisCounterSize;
-        pBuffer = pmm->AllocChunk(thisCounterSize);
-        if (pCounter == NULL)
+        memset(m_pInstanceSlots, 0, m_MaxInstances * m_InstanceSlotSize);
+        m_pControl = pmm->GetControlData();
+        m_pControl->InstanceSlotSize = m_InstanceSlotSize;
+        m_pControl->InstanceSlotsOffset = pmm->GetOffset(m_pInstanceSlots);
+        m_pControl->MaxInstances = m_MaxInstances;
+        // The DLL fills in the lengths and NumInstances from the slots in use.
+        totalCounterSize = 0;
+    }
+    else {
+        // Now loop allocating the actual buffer for the raw counter data.
+        counterOffset = sizeof(DWORD);
+        totalCounterSize = sizeof(DWORD);
+        // Allocate 2 bytes which forms the header of the PERF_COUNTER_BLOCK
+        // structure.  Then each counter has its slot allocated.
+        pPCB = (PERF_COUNTER_BLOCK *)pmm->AllocChunk(sizeof(DWORD));
+        if (pPCB == NULL)
             goto done;
-        pCounter->AcceptRawCounterBuffer(pBuffer, counterOffset);
-        counterOffset += thisCounterSize;
+        for (counterNum = 0; counterNum < numCounters; counterNum++) {
+            // Cleanup from last time round the loop (done: cleans last loop!)
+            if (obCounter) {
+                Py_DECREF(obCounter);
+                obCounter = NULL;
+            }
+            obCounter = PySequence_GetItem(obCounters, counterNum);
+            if (obCounter == NULL)
+                goto done;
+
+            if (!PyWinObject_AsPyPERF_COUNTER_DEFINITION(obCounter, &pCounter, FALSE))
+                goto done;
+            // Allocate memory for the raw counter data object.
+            thisCounterSize = pCounter->GetCounterDataSize();
+            totalCounterSize += thisCounterSize;
+            pBuffer = pmm->AllocChunk(thisCounterSize);
+            if (pBuffer == NULL)
+                goto done;
+            pCounter->AcceptRawCounterBuffer(pBuffer, counterOffset);
+            counterOffset += thisCounterSize;
+        }
+        pPCB->ByteLength = totalCounterSize;
     }
-    pPCB->ByteLength = totalCounterSize;
     // Now back-fill the PERF_OBJECT_TYPE buffer.
     m_pPOT->TotalByteLength =
         sizeof(PERF_OBJECT_TYPE) + (numCounters * sizeof(PERF_COUNTER_DEFINITION)) + totalCounterSize;
@@ -234,7 +397,7 @@ BOOL PyPERF_OBJECT_TYPE::InitMemoryLayout(MappingManager *pmm, PyPerfMonManager
     m_pPOT->DetailLevel = minDetail;
     m_pPOT->NumCounters = numCounters;
     m_pPOT->DefaultCounter = m_DefaultCounter;
-    m_pPOT->NumInstances = -1;
+    m_pPOT->NumInstances = m_MaxInstances ? 0 : PERF_NO_INSTANCES;
     m_pPOT->CodePage = 0;
     m_pPOT->PerfTime.QuadPart = 0;
     m_pPOT->PerfFreq.QuadPart = 0;
@@ -249,3 +412,181 @@ done:
 }
 
 /*static*/ void PyPERF_OBJECT_TYPE::deallocFunc(PyObject *ob) { delete (PyPERF_OBJECT_TYPE *)ob; }
+
+PyPERF_INSTANCE::PyPERF_INSTANCE(PyPERF_OBJECT_TYPE *obType, DWORD slot)
+{
+    ob_type = &type;
+    _Py_NewReference(this);
+    m_obType = obType;
+    Py_INCREF(m_obType);
+    m_Slot = slot;
+}
+
+PyPERF_INSTANCE::~PyPERF_INSTANCE() { Release(); }
+
+void PyPERF_INSTANCE::Release()
+{
+    if (m_obType == NULL)
+        return;
+    m_obType->FreeInstance(m_Slot);
+    Py_DECREF(m_obType);
+    m_obType = NULL;
+}
+
+// Returns the value of one of the object type's counters in this instance, or NULL if the
+// instance has been removed (or its object closed).
+DWORD *PyPERF_INSTANCE::GetCounterValue(PyObject *obCounter)
+{
+    PyPERF_COUNTER_DEFINITION *pCounter;
+    if (!PyWinObject_AsPyPERF_COUNTER_DEFINITION(obCounter, &pCounter, FALSE))
+        return NULL;
+    BYTE *pBlock = m_obType ? m_obType->GetInstanceCounterBlock(m_Slot) : NULL;
+    DWORD offset = pCounter->GetCounterOffset();
+    if (pBlock == NULL || offset == 0 || pCounter->GetPCD() == NULL)
+        return NULL;
+    return (DWORD *)(pBlock + offset);
+}
+
+// @pymethod |PyPERF_INSTANCE|Increment|Increments the value of one of the instance's counters
+PyObject *PyPERF_INSTANCE::Increment(PyObject *self, PyObject *args)
+{
+    PyObject *obCounter;
+    int incrBy = 1;
+    if (!PyArg_ParseTuple(args, "O|i:Increment",
+                          &obCounter,  // @pyparm <o PyPERF_COUNTER_DEFINITION>|counter||One of the object's counters
+                          &incrBy))    // @pyparm int|incrBy|1|
+        return NULL;
+    DWORD *pVal = ((PyPERF_INSTANCE *)self)->GetCounterValue(obCounter);
+    if (pVal)
+        PerfCounterAdd(pVal, incrBy);
+    else if (PyErr_Occurred())
+        return NULL;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod |PyPERF_INSTANCE|Decrement|Decrements the value of one of the instance's counters
+PyObject *PyPERF_INSTANCE::Decrement(PyObject *self, PyObject *args)
+{
+    PyObject *obCounter;
+    int incrBy = 1;
+    if (!PyArg_ParseTuple(args, "O|i:Decrement",
+                          &obCounter,  // @pyparm <o PyPERF_COUNTER_DEFINITION>|counter||One of the object's counters
+                          &incrBy))    // @pyparm int|decrBy|1|
+        return NULL;
+    DWORD *pVal = ((PyPERF_INSTANCE *)self)->GetCounterValue(obCounter);
+    if (pVal)
+        PerfCounterAdd(pVal, -incrBy);
+    else if (PyErr_Occurred())
+        return NULL;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod |PyPERF_INSTANCE|Set|Sets one of the instance's counters to a specific value
+PyObject *PyPERF_INSTANCE::Set(PyObject *self, PyObject *args)
+{
+    PyObject *obCounter;
+    int setTo;
+    if (!PyArg_ParseTuple(args, "Oi:Set",
+                          &obCounter,  // @pyparm <o PyPERF_COUNTER_DEFINITION>|counter||One of the object's counters
+                          &setTo))     // @pyparm int|value||
+        return NULL;
+    DWORD *pVal = ((PyPERF_INSTANCE *)self)->GetCounterValue(obCounter);
+    if (pVal)
+        PerfCounterSet(pVal, setTo);
+    else if (PyErr_Occurred())
+        return NULL;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod int|PyPERF_INSTANCE|Get|Gets the current value of one of the instance's counters
+PyObject *PyPERF_INSTANCE::Get(PyObject *self, PyObject *args)
+{
+    PyObject *obCounter;
+    if (!PyArg_ParseTuple(args, "O:Get",
+                          &obCounter))  // @pyparm <o PyPERF_COUNTER_DEFINITION>|counter||One of the object's counters
+        return NULL;
+    DWORD *pVal = ((PyPERF_INSTANCE *)self)->GetCounterValue(obCounter);
+    if (pVal == NULL) {
+        if (!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError, "The instance has been removed, or the counter is not in its object");
+        return NULL;
+    }
+    return PyLong_FromUnsignedLong(*pVal);
+}
+
+// @pymethod |PyPERF_INSTANCE|Remove|Removes the instance from its object
+PyObject *PyPERF_INSTANCE::Remove(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":Remove"))
+        return NULL;
+    ((PyPERF_INSTANCE *)self)->Release();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod <o PyPERF_COUNTER_CELL>|PyPERF_INSTANCE|CreateCell|Creates a cell which accumulates increments of one of
+// the instance's counters
+PyObject *PyPERF_INSTANCE::CreateCell(PyObject *self, PyObject *args)
+{
+    PyObject *obCounter;
+    DWORD flushEvery = 0;
+    if (!PyArg_ParseTuple(args, "O|k:CreateCell",
+                          &obCounter,    // @pyparm <o PyPERF_COUNTER_DEFINITION>|counter||One of the object's counters
+                          &flushEvery))  // @pyparm int|flushEvery|0|If not zero, the cell flushes itself after this
+                                         // many increments.
+        return NULL;
+    PyPERF_COUNTER_DEFINITION *pCounter;
+    if (!PyWinObject_AsPyPERF_COUNTER_DEFINITION(obCounter, &pCounter, FALSE))
+        return NULL;
+    return new PyPERF_COUNTER_CELL(pCounter, (PyPERF_INSTANCE *)self, flushEvery);
+}
+
+// @object PyPERF_INSTANCE|An instance of a <o PyPERF_OBJECT_TYPE>, created by <om PyPERF_OBJECT_TYPE.AddInstance>
+// @comm As with <o PyPERF_COUNTER_DEFINITION>, the "set" functions silently do nothing once the
+// instance has been removed.
+struct PyMethodDef PyPERF_INSTANCE::methods[] = {
+    {"Increment", PyPERF_INSTANCE::Increment,
+     1},  // @pymeth Increment|Increments the value of one of the instance's counters
+    {"Decrement", PyPERF_INSTANCE::Decrement,
+     1},  // @pymeth Decrement|Decrements the value of one of the instance's counters
+    {"Set", PyPERF_INSTANCE::Set, 1},        // @pymeth Set|Sets one of the instance's counters to a specific value
+    {"Get", PyPERF_INSTANCE::Get, 1},        // @pymeth Get|Gets the current value of one of the instance's counters
+    {"Remove", PyPERF_INSTANCE::Remove, 1},  // @pymeth Remove|Removes the instance from its object
+    {"CreateCell", PyPERF_INSTANCE::CreateCell,
+     1},  // @pymeth CreateCell|Creates a cell which accumulates increments of one of the instance's counters
+    {NULL}};
+
+PyTypeObject PyPERF_INSTANCE::type = {
+    PYWIN_OBJECT_HEAD "PyPERF_INSTANCE",
+    sizeof(PyPERF_INSTANCE),
+    0,
+    PyPERF_INSTANCE::deallocFunc, /* tp_dealloc */
+    0,                            /* tp_print */
+    0,                            /* tp_getattr */
+    0,                            /* tp_setattr */
+    0,                            /* tp_compare */
+    0,                            /* tp_repr */
+    0,                            /* tp_as_number */
+    0,                            /* tp_as_sequence */
+    0,                            /* tp_as_mapping */
+    0,                            /* tp_hash */
+    0,                            /* tp_call */
+    0,                            /* tp_str */
+    PyObject_GenericGetAttr,      /* tp_getattro */
+    0,                            /* tp_setattro */
+    0,                            /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,           /* tp_flags */
+    0,                            /* tp_doc */
+    0,                            /* tp_traverse */
+    0,                            /* tp_clear */
+    0,                            /* tp_richcompare */
+    0,                            /* tp_weaklistoffset */
+    0,                            /* tp_iter */
+    0,                            /* tp_iternext */
+    PyPERF_INSTANCE::methods,     /* tp_methods */
+};
+
+/*static*/ void PyPERF_INSTANCE::deallocFunc(PyObject *ob) { delete (PyPERF_INSTANCE *)ob; }
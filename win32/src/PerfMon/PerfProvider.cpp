@@ -0,0 +1,557 @@
+/*
+    PerfProvider.cpp
+
+    PerfLib v2 ("counter set") providers.
+
+    Unlike the objects served by perfmondata.dll, the counters of a v2 provider
+    are registered with perflib by reference: perflib reads the values straight
+    from the memory of this process, so no collection DLL is loaded into the
+    consumers and nothing is copied when they collect.
+
+    The counter sets must also be described by a manifest installed with
+    "lodctr /m:<manifest>", using the same GUIDs and counter IDs as passed here.
+*/
+// @doc
+
+#include "PyWinTypes.h"
+#include "winperf.h"
+#include "perflib.h"
+#include "pyperfmon.h"
+#include "tchar.h"
+
+// The functions only exist on Vista and later, so they are located at runtime.
+typedef ULONG(WINAPI *PerfStartProviderExfunc)(LPGUID, PPERF_PROVIDER_CONTEXT, PHANDLE);
+typedef ULONG(WINAPI *PerfStopProviderfunc)(HANDLE);
+typedef ULONG(WINAPI *PerfSetCounterSetInfofunc)(HANDLE, PPERF_COUNTERSET_INFO, ULONG);
+typedef PPERF_COUNTERSET_INSTANCE(WINAPI *PerfCreateInstancefunc)(HANDLE, LPCGUID, PCWSTR, ULONG);
+typedef ULONG(WINAPI *PerfDeleteInstancefunc)(HANDLE, PPERF_COUNTERSET_INSTANCE);
+typedef ULONG(WINAPI *PerfSetCounterRefValuefunc)(HANDLE, PPERF_COUNTERSET_INSTANCE, ULONG, PVOID);
+
+static PerfStartProviderExfunc pfnPerfStartProviderEx = NULL;
+static PerfStopProviderfunc pfnPerfStopProvider = NULL;
+static PerfSetCounterSetInfofunc pfnPerfSetCounterSetInfo = NULL;
+static PerfCreateInstancefunc pfnPerfCreateInstance = NULL;
+static PerfDeleteInstancefunc pfnPerfDeleteInstance = NULL;
+static PerfSetCounterRefValuefunc pfnPerfSetCounterRefValue = NULL;
+
+static BOOL LoadPerfLibPointers()
+{
+    if (pfnPerfStartProviderEx)
+        return TRUE;
+    HMODULE hmod = GetModuleHandle(_T("advapi32.dll"));
+    if (hmod) {
+        pfnPerfStopProvider = (PerfStopProviderfunc)GetProcAddress(hmod, "PerfStopProvider");
+        pfnPerfSetCounterSetInfo = (PerfSetCounterSetInfofunc)GetProcAddress(hmod, "PerfSetCounterSetInfo");
+        pfnPerfCreateInstance = (PerfCreateInstancefunc)GetProcAddress(hmod, "PerfCreateInstance");
+        pfnPerfDeleteInstance = (PerfDeleteInstancefunc)GetProcAddress(hmod, "PerfDeleteInstance");
+        pfnPerfSetCounterRefValue = (PerfSetCounterRefValuefunc)GetProcAddress(hmod, "PerfSetCounterRefValue");
+        if (pfnPerfStopProvider && pfnPerfSetCounterSetInfo && pfnPerfCreateInstance && pfnPerfDeleteInstance &&
+            pfnPerfSetCounterRefValue)
+            pfnPerfStartProviderEx = (PerfStartProviderExfunc)GetProcAddress(hmod, "PerfStartProviderEx");
+    }
+    if (pfnPerfStartProviderEx == NULL) {
+        PyErr_SetString(PyExc_NotImplementedError, "PerfLib v2 providers are not supported by this version of Windows");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// @pymethod <o PyPerfProvider>|perfmon|StartProvider|Registers a PerfLib v2 provider
+// @comm Counter sets are then added with <om PyPerfProvider.AddCounterSet>.  The provider
+// and its counter sets must be described by an installed manifest (see lodctr /m).
+PyObject *PerfmonMethod_StartProvider(PyObject *self, PyObject *args)
+{
+    PyObject *obGuid;
+    // @pyparm <o PyIID>|providerGuid||The GUID of the provider, as given in its manifest.
+    if (!PyArg_ParseTuple(args, "O:StartProvider", &obGuid))
+        return NULL;
+    GUID guid;
+    if (!PyWinObject_AsIID(obGuid, &guid))
+        return NULL;
+    if (!LoadPerfLibPointers())
+        return NULL;
+
+    PERF_PROVIDER_CONTEXT context;
+    ZeroMemory(&context, sizeof(context));
+    context.ContextSize = sizeof(context);
+    HANDLE hProvider = NULL;
+    ULONG rc = (*pfnPerfStartProviderEx)(&guid, &context, &hProvider);
+    if (rc != ERROR_SUCCESS)
+        return PyWin_SetAPIError("PerfStartProviderEx", rc);
+    PyPerfProvider *ret = new PyPerfProvider(hProvider, guid);
+    if (ret == NULL) {
+        (*pfnPerfStopProvider)(hProvider);
+        PyErr_SetString(PyExc_MemoryError, "Allocating PyPerfProvider");
+    }
+    return ret;
+}
+
+PyPerfProvider::PyPerfProvider(HANDLE hProvider, const GUID &guid)
+{
+    ob_type = &type;
+    _Py_NewReference(this);
+    m_hProvider = hProvider;
+    m_Guid = guid;
+}
+
+PyPerfProvider::~PyPerfProvider() { Term(); }
+
+void PyPerfProvider::Term()
+{
+    // Stopping the provider deletes any instances perflib still knows about.
+    if (m_hProvider) {
+        (*pfnPerfStopProvider)(m_hProvider);
+        m_hProvider = NULL;
+    }
+}
+
+// @pymethod <o PyPERF_COUNTERSET>|PyPerfProvider|AddCounterSet|Registers a counter set with perflib
+PyObject *PyPerfProvider::AddCounterSet(PyObject *self, PyObject *args)
+{
+    PyPerfProvider *This = (PyPerfProvider *)self;
+    PyObject *obGuid, *obCounters;
+    ULONG instanceType = PERF_COUNTERSET_MULTI_INSTANCES;
+    if (!PyArg_ParseTuple(args, "OO|k:AddCounterSet",
+                          &obGuid,         // @pyparm <o PyIID>|counterSetGuid||The GUID of the counter set, as given
+                                           // in the manifest.
+                          &obCounters,     // @pyparm [(int, int), ...]|counters||A sequence of (counterId,
+                                           // counterType) tuples, with the IDs and types given in the manifest.
+                          &instanceType))  // @pyparm int|instanceType|PERF_COUNTERSET_MULTI_INSTANCES|The instance
+                                           // type of the counter set, eg PERF_COUNTERSET_SINGLE_INSTANCE
+        return NULL;
+    // @comm Every counter is registered with PERF_ATTRIB_BY_REFERENCE, and values for counter
+    // types with PERF_SIZE_LARGE are 64 bits, otherwise 32 bits.
+    if (This->m_hProvider == NULL) {
+        PyErr_SetString(PyExc_ValueError, "The provider has been stopped");
+        return NULL;
+    }
+    GUID guid;
+    if (!PyWinObject_AsIID(obGuid, &guid))
+        return NULL;
+    TmpPyObject counters = PySequence_Fast(obCounters, "counters must be a sequence");
+    if (counters == NULL)
+        return NULL;
+    ULONG numCounters = (ULONG)PySequence_Fast_GET_SIZE((PyObject *)counters);
+
+    PyObject *ret = NULL;
+    ULONG templateSize = sizeof(PERF_COUNTERSET_INFO) + numCounters * sizeof(PERF_COUNTER_INFO);
+    PERF_COUNTERSET_INFO *pTemplate = (PERF_COUNTERSET_INFO *)malloc(templateSize);
+    ULONG *counterIds = (ULONG *)malloc(numCounters * sizeof(ULONG) + 1);
+    BYTE *counterLarge = (BYTE *)malloc(numCounters + 1);
+    if (pTemplate == NULL || counterIds == NULL || counterLarge == NULL) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    ZeroMemory(pTemplate, templateSize);
+    pTemplate->CounterSetGuid = guid;
+    pTemplate->ProviderGuid = This->m_Guid;
+    pTemplate->NumCounters = numCounters;
+    pTemplate->InstanceType = instanceType;
+    {
+        PERF_COUNTER_INFO *pCounters = (PERF_COUNTER_INFO *)(pTemplate + 1);
+        for (ULONG i = 0; i < numCounters; i++) {
+            PyObject *item = PySequence_Fast_GET_ITEM((PyObject *)counters, i);
+            ULONG counterId, counterType;
+            if (!PyArg_ParseTuple(item, "kk:AddCounterSet", &counterId, &counterType))
+                goto done;
+            if (counterType & PERF_SIZE_VARIABLE_LEN) {
+                PyErr_SetString(PyExc_ValueError, "Variable length counters are not supported");
+                goto done;
+            }
+            counterIds[i] = counterId;
+            counterLarge[i] = (counterType & PERF_SIZE_LARGE) != 0;
+            pCounters[i].CounterId = counterId;
+            pCounters[i].Type = counterType;
+            pCounters[i].Attrib = PERF_ATTRIB_BY_REFERENCE;
+            pCounters[i].Size = counterLarge[i] ? sizeof(ULONGLONG) : sizeof(ULONG);
+            pCounters[i].DetailLevel = PERF_DETAIL_NOVICE;
+            pCounters[i].Offset = i * sizeof(ULONGLONG);
+        }
+    }
+    {
+        ULONG rc = (*pfnPerfSetCounterSetInfo)(This->m_hProvider, pTemplate, templateSize);
+        if (rc != ERROR_SUCCESS) {
+            PyWin_SetAPIError("PerfSetCounterSetInfo", rc);
+            goto done;
+        }
+    }
+    ret = new PyPERF_COUNTERSET(This, guid, numCounters, counterIds, counterLarge);
+    if (ret == NULL)
+        PyErr_SetString(PyExc_MemoryError, "Allocating PyPERF_COUNTERSET");
+    else {
+        // now owned by the counter set
+        counterIds = NULL;
+        counterLarge = NULL;
+    }
+done:
+    free(pTemplate);
+    free(counterIds);
+    free(counterLarge);
+    return ret;
+}
+
+// @pymethod |PyPerfProvider|Stop|Stops the provider
+// @comm Any instances of its counter sets are deleted.
+PyObject *PyPerfProvider::Stop(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":Stop"))
+        return NULL;
+    ((PyPerfProvider *)self)->Term();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @object PyPerfProvider|A PerfLib v2 provider, created by <om perfmon.StartProvider>
+struct PyMethodDef PyPerfProvider::methods[] = {
+    {"AddCounterSet", PyPerfProvider::AddCounterSet, 1},  // @pymeth AddCounterSet|Registers a counter set with perflib
+    {"Stop", PyPerfProvider::Stop, 1},                    // @pymeth Stop|Stops the provider
+    {NULL}};
+
+/*static*/ struct PyMemberDef PyPerfProvider::members[] = {
+    {NULL} /* Sentinel */
+};
+
+PyTypeObject PyPerfProvider::type = {
+    PYWIN_OBJECT_HEAD "PyPerfProvider",
+    sizeof(PyPerfProvider),
+    0,
+    PyPerfProvider::deallocFunc, /* tp_dealloc */
+    0,                           /* tp_print */
+    0,                           /* tp_getattr */
+    0,                           /* tp_setattr */
+    0,                           /* tp_compare */
+    0,                           /* tp_repr */
+    0,                           /* tp_as_number */
+    0,                           /* tp_as_sequence */
+    0,                           /* tp_as_mapping */
+    0,                           /* tp_hash */
+    0,                           /* tp_call */
+    0,                           /* tp_str */
+    PyObject_GenericGetAttr,     /* tp_getattro */
+    PyObject_GenericSetAttr,     /* tp_setattro */
+    0,                           /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,          /* tp_flags */
+    0,                           /* tp_doc */
+    0,                           /* tp_traverse */
+    0,                           /* tp_clear */
+    0,                           /* tp_richcompare */
+    0,                           /* tp_weaklistoffset */
+    0,                           /* tp_iter */
+    0,                           /* tp_iternext */
+    PyPerfProvider::methods,     /* tp_methods */
+    PyPerfProvider::members,     /* tp_members */
+};
+
+/*static*/ void PyPerfProvider::deallocFunc(PyObject *ob) { delete (PyPerfProvider *)ob; }
+
+PyPERF_COUNTERSET::PyPERF_COUNTERSET(PyPerfProvider *obProvider, const GUID &guid, ULONG numCounters,
+                                     ULONG *counterIds, BYTE *counterLarge)
+{
+    ob_type = &type;
+    _Py_NewReference(this);
+    m_obProvider = obProvider;
+    Py_INCREF(m_obProvider);
+    m_Guid = guid;
+    m_NumCounters = numCounters;
+    m_CounterIds = counterIds;
+    m_CounterLarge = counterLarge;
+}
+
+PyPERF_COUNTERSET::~PyPERF_COUNTERSET()
+{
+    free(m_CounterIds);
+    free(m_CounterLarge);
+    Py_DECREF(m_obProvider);
+}
+
+int PyPERF_COUNTERSET::FindCounter(ULONG counterId)
+{
+    for (ULONG i = 0; i < m_NumCounters; i++)
+        if (m_CounterIds[i] == counterId)
+            return (int)i;
+    PyErr_Format(PyExc_ValueError, "Counter %lu is not in the counter set", counterId);
+    return -1;
+}
+
+// @pymethod <o PyPERF_COUNTERSET_INSTANCE>|PyPERF_COUNTERSET|CreateInstance|Creates an instance of the counter set
+PyObject *PyPERF_COUNTERSET::CreateInstance(PyObject *self, PyObject *args)
+{
+    PyPERF_COUNTERSET *This = (PyPERF_COUNTERSET *)self;
+    PyObject *obName;
+    ULONG id = 0;
+    if (!PyArg_ParseTuple(args, "O|k:CreateInstance",
+                          &obName,  // @pyparm <o PyUnicode>|name||The name of the instance.
+                          &id))     // @pyparm int|id|0|The ID of the instance.  The name and ID together must be
+                                    // unique within the counter set.
+        return NULL;
+    HANDLE hProvider = This->m_obProvider->GetHandle();
+    if (hProvider == NULL) {
+        PyErr_SetString(PyExc_ValueError, "The provider has been stopped");
+        return NULL;
+    }
+    TmpWCHAR name;
+    if (!PyWinObject_AsWCHAR(obName, &name, FALSE))
+        return NULL;
+    // Every counter gets an aligned 64 bit slot, whatever the size of its value, so
+    // 64 bit values can be updated with the interlocked functions.
+    ULONGLONG *pValues = (ULONGLONG *)_aligned_malloc((This->m_NumCounters + 1) * sizeof(ULONGLONG), sizeof(ULONGLONG));
+    if (pValues == NULL)
+        return PyErr_NoMemory();
+    ZeroMemory(pValues, (This->m_NumCounters + 1) * sizeof(ULONGLONG));
+
+    PPERF_COUNTERSET_INSTANCE pInstance = (*pfnPerfCreateInstance)(hProvider, &This->m_Guid, name, id);
+    if (pInstance == NULL) {
+        PyWin_SetAPIError("PerfCreateInstance");
+        _aligned_free(pValues);
+        return NULL;
+    }
+    for (ULONG i = 0; i < This->m_NumCounters; i++) {
+        ULONG rc = (*pfnPerfSetCounterRefValue)(hProvider, pInstance, This->m_CounterIds[i], pValues + i);
+        if (rc != ERROR_SUCCESS) {
+            PyWin_SetAPIError("PerfSetCounterRefValue", rc);
+            (*pfnPerfDeleteInstance)(hProvider, pInstance);
+            _aligned_free(pValues);
+            return NULL;
+        }
+    }
+    PyObject *ret = new PyPERF_COUNTERSET_INSTANCE(This, pInstance, pValues, id);
+    if (ret == NULL) {
+        (*pfnPerfDeleteInstance)(hProvider, pInstance);
+        _aligned_free(pValues);
+        PyErr_SetString(PyExc_MemoryError, "Allocating PyPERF_COUNTERSET_INSTANCE");
+    }
+    return ret;
+}
+
+// @object PyPERF_COUNTERSET|A counter set of a <o PyPerfProvider>, created by <om PyPerfProvider.AddCounterSet>
+struct PyMethodDef PyPERF_COUNTERSET::methods[] = {
+    {"CreateInstance", PyPERF_COUNTERSET::CreateInstance,
+     1},  // @pymeth CreateInstance|Creates an instance of the counter set
+    {NULL}};
+
+#define OFF(e) offsetof(PyPERF_COUNTERSET, e)
+
+/*static*/ struct PyMemberDef PyPERF_COUNTERSET::members[] = {
+    {"NumCounters", T_ULONG, OFF(m_NumCounters), READONLY},  // @prop integer|NumCounters|The number of counters in the set.
+    {NULL}                                                   /* Sentinel */
+};
+
+PyTypeObject PyPERF_COUNTERSET::type = {
+    PYWIN_OBJECT_HEAD "PyPERF_COUNTERSET",
+    sizeof(PyPERF_COUNTERSET),
+    0,
+    PyPERF_COUNTERSET::deallocFunc, /* tp_dealloc */
+    0,                              /* tp_print */
+    0,                              /* tp_getattr */
+    0,                              /* tp_setattr */
+    0,                              /* tp_compare */
+    0,                              /* tp_repr */
+    0,                              /* tp_as_number */
+    0,                              /* tp_as_sequence */
+    0,                              /* tp_as_mapping */
+    0,                              /* tp_hash */
+    0,                              /* tp_call */
+    0,                              /* tp_str */
+    PyObject_GenericGetAttr,        /* tp_getattro */
+    PyObject_GenericSetAttr,        /* tp_setattro */
+    0,                              /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,             /* tp_flags */
+    0,                              /* tp_doc */
+    0,                              /* tp_traverse */
+    0,                              /* tp_clear */
+    0,                              /* tp_richcompare */
+    0,                              /* tp_weaklistoffset */
+    0,                              /* tp_iter */
+    0,                              /* tp_iternext */
+    PyPERF_COUNTERSET::methods,     /* tp_methods */
+    PyPERF_COUNTERSET::members,     /* tp_members */
+};
+
+/*static*/ void PyPERF_COUNTERSET::deallocFunc(PyObject *ob) { delete (PyPERF_COUNTERSET *)ob; }
+
+PyPERF_COUNTERSET_INSTANCE::PyPERF_COUNTERSET_INSTANCE(PyPERF_COUNTERSET *obCounterSet,
+                                                       PPERF_COUNTERSET_INSTANCE pInstance, ULONGLONG *pValues,
+                                                       ULONG id)
+{
+    ob_type = &type;
+    _Py_NewReference(this);
+    m_obCounterSet = obCounterSet;
+    Py_INCREF(m_obCounterSet);
+    m_pInstance = pInstance;
+    m_pValues = pValues;
+    m_Id = id;
+}
+
+PyPERF_COUNTERSET_INSTANCE::~PyPERF_COUNTERSET_INSTANCE()
+{
+    Release();
+    Py_DECREF(m_obCounterSet);
+}
+
+void PyPERF_COUNTERSET_INSTANCE::Release()
+{
+    if (m_pInstance == NULL)
+        return;
+    // perflib stops referencing the values once the instance is deleted; if the provider
+    // has already been stopped, the instance went with it.
+    HANDLE hProvider = m_obCounterSet->GetProvider()->GetHandle();
+    if (hProvider)
+        (*pfnPerfDeleteInstance)(hProvider, m_pInstance);
+    m_pInstance = NULL;
+    _aligned_free(m_pValues);
+    m_pValues = NULL;
+}
+
+void *PyPERF_COUNTERSET_INSTANCE::GetCounterValue(ULONG counterId, BOOL *pbLarge)
+{
+    if (m_pInstance == NULL || m_obCounterSet->GetProvider()->GetHandle() == NULL) {
+        PyErr_SetString(PyExc_ValueError, "The instance has been deleted");
+        return NULL;
+    }
+    int index = m_obCounterSet->FindCounter(counterId);
+    if (index < 0)
+        return NULL;
+    *pbLarge = m_obCounterSet->IsCounterLarge(index);
+    return m_pValues + index;
+}
+
+// Values are read by perflib from other threads, so all updates are interlocked.
+static PyObject *AddToCounter(PyObject *self, ULONG counterId, LONGLONG delta)
+{
+    BOOL bLarge;
+    void *pVal = ((PyPERF_COUNTERSET_INSTANCE *)self)->GetCounterValue(counterId, &bLarge);
+    if (pVal == NULL)
+        return NULL;
+    if (bLarge)
+        InterlockedExchangeAdd64((LONGLONG volatile *)pVal, delta);
+    else
+        InterlockedExchangeAdd((LONG volatile *)pVal, (LONG)delta);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod |PyPERF_COUNTERSET_INSTANCE|Increment|Increments the value of one of the instance's counters
+PyObject *PyPERF_COUNTERSET_INSTANCE::Increment(PyObject *self, PyObject *args)
+{
+    ULONG counterId;
+    LONGLONG incrBy = 1;
+    if (!PyArg_ParseTuple(args, "k|L:Increment",
+                          &counterId,  // @pyparm int|counterId||The ID of the counter
+                          &incrBy))    // @pyparm int|incrBy|1|Amount to increment by
+        return NULL;
+    return AddToCounter(self, counterId, incrBy);
+}
+
+// @pymethod |PyPERF_COUNTERSET_INSTANCE|Decrement|Decrements the value of one of the instance's counters
+PyObject *PyPERF_COUNTERSET_INSTANCE::Decrement(PyObject *self, PyObject *args)
+{
+    ULONG counterId;
+    LONGLONG decrBy = 1;
+    if (!PyArg_ParseTuple(args, "k|L:Decrement",
+                          &counterId,  // @pyparm int|counterId||The ID of the counter
+                          &decrBy))    // @pyparm int|decrBy|1|Amount to decrement by
+        return NULL;
+    return AddToCounter(self, counterId, -decrBy);
+}
+
+// @pymethod |PyPERF_COUNTERSET_INSTANCE|Set|Sets the value of one of the instance's counters
+PyObject *PyPERF_COUNTERSET_INSTANCE::Set(PyObject *self, PyObject *args)
+{
+    ULONG counterId;
+    LONGLONG setTo;
+    if (!PyArg_ParseTuple(args, "kL:Set",
+                          &counterId,  // @pyparm int|counterId||The ID of the counter
+                          &setTo))     // @pyparm int|val||The new value
+        return NULL;
+    BOOL bLarge;
+    void *pVal = ((PyPERF_COUNTERSET_INSTANCE *)self)->GetCounterValue(counterId, &bLarge);
+    if (pVal == NULL)
+        return NULL;
+    if (bLarge)
+        InterlockedExchange64((LONGLONG volatile *)pVal, setTo);
+    else
+        InterlockedExchange((LONG volatile *)pVal, (LONG)setTo);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod int|PyPERF_COUNTERSET_INSTANCE|Get|Gets the value of one of the instance's counters
+PyObject *PyPERF_COUNTERSET_INSTANCE::Get(PyObject *self, PyObject *args)
+{
+    ULONG counterId;
+    // @pyparm int|counterId||The ID of the counter
+    if (!PyArg_ParseTuple(args, "k:Get", &counterId))
+        return NULL;
+    BOOL bLarge;
+    void *pVal = ((PyPERF_COUNTERSET_INSTANCE *)self)->GetCounterValue(counterId, &bLarge);
+    if (pVal == NULL)
+        return NULL;
+    if (bLarge)
+        return PyLong_FromUnsignedLongLong(*(ULONGLONG volatile *)pVal);
+    return PyLong_FromUnsignedLong(*(ULONG volatile *)pVal);
+}
+
+// @pymethod |PyPERF_COUNTERSET_INSTANCE|Delete|Deletes the instance
+// @comm The instance is also deleted when the object is destroyed.
+PyObject *PyPERF_COUNTERSET_INSTANCE::Delete(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":Delete"))
+        return NULL;
+    ((PyPERF_COUNTERSET_INSTANCE *)self)->Release();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @object PyPERF_COUNTERSET_INSTANCE|An instance of a <o PyPERF_COUNTERSET>, created by
+// <om PyPERF_COUNTERSET.CreateInstance>.  Counters are identified by the IDs given to
+// <om PyPerfProvider.AddCounterSet>.
+struct PyMethodDef PyPERF_COUNTERSET_INSTANCE::methods[] = {
+    {"Increment", PyPERF_COUNTERSET_INSTANCE::Increment,
+     1},  // @pymeth Increment|Increments the value of one of the instance's counters
+    {"Decrement", PyPERF_COUNTERSET_INSTANCE::Decrement,
+     1},  // @pymeth Decrement|Decrements the value of one of the instance's counters
+    {"Set", PyPERF_COUNTERSET_INSTANCE::Set, 1},  // @pymeth Set|Sets the value of one of the instance's counters
+    {"Get", PyPERF_COUNTERSET_INSTANCE::Get, 1},  // @pymeth Get|Gets the value of one of the instance's counters
+    {"Delete", PyPERF_COUNTERSET_INSTANCE::Delete, 1},  // @pymeth Delete|Deletes the instance
+    {NULL}};
+
+#undef OFF
+#define OFF(e) offsetof(PyPERF_COUNTERSET_INSTANCE, e)
+
+/*static*/ struct PyMemberDef PyPERF_COUNTERSET_INSTANCE::members[] = {
+    {"Id", T_ULONG, OFF(m_Id), READONLY},  // @prop integer|Id|The ID of the instance.
+    {NULL}                                 /* Sentinel */
+};
+
+PyTypeObject PyPERF_COUNTERSET_INSTANCE::type = {
+    PYWIN_OBJECT_HEAD "PyPERF_COUNTERSET_INSTANCE",
+    sizeof(PyPERF_COUNTERSET_INSTANCE),
+    0,
+    PyPERF_COUNTERSET_INSTANCE::deallocFunc, /* tp_dealloc */
+    0,                                       /* tp_print */
+    0,                                       /* tp_getattr */
+    0,                                       /* tp_setattr */
+    0,                                       /* tp_compare */
+    0,                                       /* tp_repr */
+    0,                                       /* tp_as_number */
+    0,                                       /* tp_as_sequence */
+    0,                                       /* tp_as_mapping */
+    0,                                       /* tp_hash */
+    0,                                       /* tp_call */
+    0,                                       /* tp_str */
+    PyObject_GenericGetAttr,                 /* tp_getattro */
+    PyObject_GenericSetAttr,                 /* tp_setattro */
+    0,                                       /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                      /* tp_flags */
+    0,                                       /* tp_doc */
+    0,                                       /* tp_traverse */
+    0,                                       /* tp_clear */
+    0,                                       /* tp_richcompare */
+    0,                                       /* tp_weaklistoffset */
+    0,                                       /* tp_iter */
+    0,                                       /* tp_iternext */
+    PyPERF_COUNTERSET_INSTANCE::methods,     /* tp_methods */
+    PyPERF_COUNTERSET_INSTANCE::members,     /* tp_members */
+};
+
+/*static*/ void PyPERF_COUNTERSET_INSTANCE::deallocFunc(PyObject *ob) { delete (PyPERF_COUNTERSET_INSTANCE *)ob; }
@@ -19,6 +19,8 @@ generates Windows .hlp files.
 extern PyObject *PerfmonMethod_NewPERF_COUNTER_DEFINITION(PyObject *self, PyObject *args);
 extern PyObject *PerfmonMethod_NewPERF_OBJECT_TYPE(PyObject *self, PyObject *args);
 extern PyObject *PerfmonMethod_NewPerfMonManager(PyObject *self, PyObject *args);
+extern PyObject *PerfmonMethod_UpdateCounters(PyObject *self, PyObject *args);
+extern PyObject *PerfmonMethod_StartProvider(PyObject *self, PyObject *args);
 
 // Note we avoid the import of loadperf.dll each time we are used.
 
@@ -91,6 +93,10 @@ static struct PyMethodDef perfmon_functions[] = {
      1},  // @pymeth ObjectType|Creates a new <o PyPERF_OBJECT_TYPE> object
     {"PerfMonManager", PerfmonMethod_NewPerfMonManager,
      1},  // @pymeth PerfMonManager|Creates a new <o PyPerfMonManager> objects>
+    {"UpdateCounters", PerfmonMethod_UpdateCounters,
+     1},  // @pymeth UpdateCounters|Applies a number of counter increments in one call
+    {"StartProvider", PerfmonMethod_StartProvider,
+     1},  // @pymeth StartProvider|Registers a PerfLib v2 provider, returning a <o PyPerfProvider>
     {NULL, NULL}};
 
 PYWIN_MODULE_INIT_FUNC(perfmon)
@@ -98,7 +104,9 @@ PYWIN_MODULE_INIT_FUNC(perfmon)
     PYWIN_MODULE_INIT_PREPARE(perfmon, perfmon_functions,
                               "Contains functions and objects wrapping the Performance Monitor APIs");
     if (PyType_Ready(&PyPerfMonManager::type) == -1 || PyType_Ready(&PyPERF_COUNTER_DEFINITION::type) == -1 ||
-        PyType_Ready(&PyPERF_OBJECT_TYPE::type) == -1)
+        PyType_Ready(&PyPERF_OBJECT_TYPE::type) == -1 || PyType_Ready(&PyPERF_INSTANCE::type) == -1 ||
+        PyType_Ready(&PyPERF_COUNTER_CELL::type) == -1 || PyType_Ready(&PyPerfProvider::type) == -1 ||
+        PyType_Ready(&PyPERF_COUNTERSET::type) == -1 || PyType_Ready(&PyPERF_COUNTERSET_INSTANCE::type) == -1)
         PYWIN_MODULE_INIT_RETURN_ERROR;
     PYWIN_MODULE_INIT_RETURN_SUCCESS;
 }
@@ -8,6 +8,7 @@
 // dont manage these size better cos I cant be bothered!
 const int MMCD_SERVICE_SIZE = 25;
 const int MMCD_EVENTSOURCE_SIZE = 25;
+const int MMCD_INSTANCE_NAME_SIZE = 64;  // In WCHARs, including the terminating NULL.
 
 enum SupplierStatus {
     SupplierStatusStopped = 0,
@@ -20,4 +21,19 @@ struct MappingManagerControlData {
     SupplierStatus supplierStatus;
     WCHAR ServiceName[MMCD_SERVICE_SIZE];          // The name of the service or application.
     WCHAR EventSourceName[MMCD_EVENTSOURCE_SIZE];  // Source Name that appears in Event Log for errors.
+    // For an object with instances, the counter definitions are followed by MaxInstances
+    // fixed size slots instead of a single PERF_COUNTER_BLOCK.  Each slot is a
+    // MappingManagerInstanceHeader, a PERF_INSTANCE_DEFINITION, the instance name and the
+    // instance's PERF_COUNTER_BLOCK.
+    DWORD MaxInstances;  // 0 for an object without instances.
+    DWORD InstanceSlotSize;
+    DWORD InstanceSlotsOffset;  // From the start of the mapping.
+    // Incremented before and after instances are added or removed (so odd while that is
+    // happening) - the DLL retries a collection that saw it change, and never blocks the writer.
+    volatile LONG InstanceSequence;
+};
+
+struct MappingManagerInstanceHeader {
+    DWORD InUse;
+    DWORD Reserved;  // Keeps the PERF_INSTANCE_DEFINITION 8 byte aligned.
 };
@@ -260,6 +260,80 @@ OpenExitPoint:
     return status;
 }
 
+// Adjusts the title indexes of a copy of the object and counter definitions.
+static void AdjustTitleIndexes(PERF_OBJECT_TYPE *pPOTResult)
+{
+    pPOTResult->ObjectNameTitleIndex += dwModuleFirstCounter;
+    pPOTResult->ObjectHelpTitleIndex += dwModuleFirstHelp;
+
+    PERF_COUNTER_DEFINITION *pPCD = (PERF_COUNTER_DEFINITION *)(pPOTResult + 1);
+    for (DWORD i = 0; i < pPOTResult->NumCounters; i++) {
+        pPCD[i].CounterNameTitleIndex += dwModuleFirstCounter;
+        pPCD[i].CounterHelpTitleIndex += dwModuleFirstHelp;
+    }
+}
+
+// The number of times a collection is retried when instances change while being copied.
+#define MAX_INSTANCE_COLLECT_ATTEMPTS 10
+
+// Collects an object with instances - the definitions followed by each instance in use.
+// The supplier never waits for us, so the copy is simply retried if InstanceSequence shows
+// that instances were added or removed while it was being made.
+static DWORD CollectInstanceData(PERF_OBJECT_TYPE *pPOT, LPVOID *lppData, LPDWORD lpcbTotalBytes,
+                                 LPDWORD lpNumObjectTypes)
+{
+    BYTE *pSlots = ((BYTE *)pControlData) + pControlData->InstanceSlotsOffset;
+    DWORD slotSize = pControlData->InstanceSlotSize;
+    DWORD instanceSize = slotSize - sizeof(MappingManagerInstanceHeader);
+    for (int attempt = 0; attempt < MAX_INSTANCE_COLLECT_ATTEMPTS; attempt++) {
+        LONG sequence = pControlData->InstanceSequence;
+        if (sequence & 1) {
+            Sleep(0);  // An instance is being added or removed.
+            continue;
+        }
+        MemoryBarrier();
+        DWORD numInstances = 0;
+        for (DWORD i = 0; i < pControlData->MaxInstances; i++)
+            if (((MappingManagerInstanceHeader *)(pSlots + i * slotSize))->InUse)
+                numInstances++;
+        DWORD SpaceNeeded = pPOT->DefinitionLength + numInstances * instanceSize;
+        if (*lpcbTotalBytes < SpaceNeeded) {
+            *lpcbTotalBytes = (DWORD)0;
+            *lpNumObjectTypes = (DWORD)0;
+            return ERROR_MORE_DATA;
+        }
+        BYTE *pResult = (BYTE *)(*lppData);
+        memmove(pResult, pPOT, pPOT->DefinitionLength);
+        BYTE *pNext = pResult + pPOT->DefinitionLength;
+        DWORD numCopied = 0;
+        for (DWORD i = 0; i < pControlData->MaxInstances && numCopied < numInstances; i++) {
+            MappingManagerInstanceHeader *pHeader = (MappingManagerInstanceHeader *)(pSlots + i * slotSize);
+            if (!pHeader->InUse)
+                continue;
+            memmove(pNext, pHeader + 1, instanceSize);
+            pNext += instanceSize;
+            numCopied++;
+        }
+        MemoryBarrier();
+        if (pControlData->InstanceSequence != sequence || numCopied != numInstances)
+            continue;
+
+        PERF_OBJECT_TYPE *pPOTResult = (PERF_OBJECT_TYPE *)pResult;
+        SpaceNeeded = pPOT->DefinitionLength + numCopied * instanceSize;
+        pPOTResult->NumInstances = numCopied;
+        pPOTResult->TotalByteLength = SpaceNeeded;
+        AdjustTitleIndexes(pPOTResult);
+        *lppData = pResult + SpaceNeeded;
+        *lpNumObjectTypes = 1;
+        *lpcbTotalBytes = SpaceNeeded;
+        return ERROR_SUCCESS;
+    }
+    // The instances kept changing - report nothing this time rather than a torn copy.
+    *lpcbTotalBytes = (DWORD)0;
+    *lpNumObjectTypes = (DWORD)0;
+    return ERROR_SUCCESS;
+}
+
 DWORD APIENTRY CollectPerformanceData(IN LPWSTR lpValueName, IN OUT LPVOID *lppData, IN OUT LPDWORD lpcbTotalBytes,
                                       IN OUT LPDWORD lpNumObjectTypes)
 /*++
@@ -324,6 +398,8 @@ Arguments:   IN       LPWSTR   lpValueName
             return ERROR_SUCCESS;
         }
     }
+    if (pControlData->MaxInstances)
+        return CollectInstanceData(pPOT, lppData, lpcbTotalBytes, lpNumObjectTypes);
     SpaceNeeded = pControlData->TotalSize - sizeof(*pControlData);
     if (*lpcbTotalBytes < SpaceNeeded) {
         *lpcbTotalBytes = (DWORD)0;
@@ -337,14 +413,7 @@ Arguments:   IN       LPWSTR   lpValueName
     memmove(pPOTResult, pPOT, SpaceNeeded);
 
     // Update all the counter and help values with the new offset
-    pPOTResult->ObjectNameTitleIndex += dwModuleFirstCounter;
-    pPOTResult->ObjectHelpTitleIndex += dwModuleFirstHelp;
-
-    PERF_COUNTER_DEFINITION *pPCD = (PERF_COUNTER_DEFINITION *)(pPOTResult + 1);
-    for (DWORD i = 0; i < pPOT->NumCounters; i++) {
-        pPCD[i].CounterNameTitleIndex += dwModuleFirstCounter;
-        pPCD[i].CounterHelpTitleIndex += dwModuleFirstHelp;
-    }
+    AdjustTitleIndexes(pPOTResult);
     // debug !!
     PERF_COUNTER_BLOCK *pPerfCounterBlock =
         (PERF_COUNTER_BLOCK *)(((LPBYTE)pPOTResult) + (pPOT->NumCounters * sizeof(PERF_COUNTER_DEFINITION)) +
@@ -15,12 +15,16 @@ class MappingManager {
    public:
     MappingManager();
     ~MappingManager();
-    BOOL Init(const TCHAR *szServiceName, const TCHAR *mapName = NULL, const TCHAR *szEventSourceName = NULL);
+    BOOL Init(const TCHAR *szServiceName, const TCHAR *mapName = NULL, const TCHAR *szEventSourceName = NULL,
+              DWORD mapSize = 4096);
     BOOL CheckStatus();
     void *AllocChunk(DWORD size);
+    MappingManagerControlData *GetControlData() { return m_pControl; }
+    DWORD GetOffset(void *p) { return (DWORD)((BYTE *)p - (BYTE *)m_pMapBlock); }
 
    private:
     DWORD *m_pBytesUsed;  // Pointer to first few bytes in the mmapped file.
+    DWORD m_MapSize;
     HANDLE m_hMappedObject;
     void *m_pMapBlock;
     MappingManagerControlData *m_pControl;
@@ -60,6 +64,11 @@ class PyPERF_COUNTER_DEFINITION : public PyObject {
     void AcceptBuffer(PyObject *obOwner, void *buffer);
     void SetupBuffer(void);
     void AcceptRawCounterBuffer(void *pBuffer, DWORD offset);
+    void AcceptInstanceCounterOffset(DWORD offset);
+    // Offset of the counter in a PERF_COUNTER_BLOCK, or 0 if not yet setup.
+    DWORD GetCounterOffset() { return m_pPCD ? m_pPCD->CounterOffset : 0; }
+    // The counter in its block, or NULL if the counter does not appear in a block.
+    DWORD *GetCounterValue() { return (DWORD *)m_pCounterValue; }
 
     /* Python support */
     static void deallocFunc(PyObject *ob);
@@ -71,6 +80,7 @@ class PyPERF_COUNTER_DEFINITION : public PyObject {
     static PyObject *Decrement(PyObject *self, PyObject *args);
     static PyObject *Set(PyObject *self, PyObject *args);
     static PyObject *Get(PyObject *self, PyObject *args);
+    static PyObject *CreateCell(PyObject *self, PyObject *args);
 
     static struct PyMemberDef members[];
     static struct PyMethodDef methods[];
@@ -101,13 +111,19 @@ class PyPERF_OBJECT_TYPE : public PyObject {
 
     PERF_OBJECT_TYPE *GetPCD() { return m_pPOT; }
 
-    BOOL InitPythonObjects(PyObject *obCounters);
+    BOOL InitPythonObjects(PyObject *obCounters, DWORD maxInstances = 0);
+    DWORD GetMemoryLayoutSize();
     BOOL InitMemoryLayout(MappingManager *mm, PyPerfMonManager *obPMM);
     void Term();
 
+    // Instance slots, for an object created with maxInstances.
+    BYTE *GetInstanceCounterBlock(DWORD slot);
+    void FreeInstance(DWORD slot);
+
     /* Python support */
     static void deallocFunc(PyObject *ob);
     static PyObject *Close(PyObject *self, PyObject *args);
+    static PyObject *AddInstance(PyObject *self, PyObject *args);
     static struct PyMemberDef members[];
     static struct PyMethodDef methods[];
     static PyTypeObject type;
@@ -119,7 +135,161 @@ class PyPERF_OBJECT_TYPE : public PyObject {
     DWORD m_DefaultCounter;
     PyObject *m_obCounters;
     PyObject *m_obPerfMonManager;
+    DWORD m_MaxInstances;
+    DWORD m_NumInstances;
+    DWORD m_InstanceSlotSize;
+    DWORD m_InstanceCounterBlockSize;
+    BYTE *m_pInstanceSlots;  // NULL for an object without instances.
+    MappingManagerControlData *m_pControl;
 };
 
 #define PyPERF_OBJECT_TYPE_Check(ob) ((ob)->ob_type == &PyPERF_OBJECT_TYPE::type)
 BOOL PyWinObject_AsPyPERF_OBJECT_TYPE(PyObject *ob, PyPERF_OBJECT_TYPE **ppPyPERF_OBJECT_TYPE, BOOL bNoneOK /*= TRUE*/);
+
+// One instance of a PyPERF_OBJECT_TYPE created with instances.  Keeps the object type
+// alive, and gives its slot back when removed or destroyed.
+class PyPERF_INSTANCE : public PyObject {
+   public:
+    PyPERF_INSTANCE(PyPERF_OBJECT_TYPE *obType, DWORD slot);
+    ~PyPERF_INSTANCE();
+
+    DWORD *GetCounterValue(PyObject *obCounter);
+    void Release();
+
+    /* Python support */
+    static void deallocFunc(PyObject *ob);
+
+    static PyObject *Increment(PyObject *self, PyObject *args);
+    static PyObject *Decrement(PyObject *self, PyObject *args);
+    static PyObject *Set(PyObject *self, PyObject *args);
+    static PyObject *Get(PyObject *self, PyObject *args);
+    static PyObject *Remove(PyObject *self, PyObject *args);
+    static PyObject *CreateCell(PyObject *self, PyObject *args);
+
+    static struct PyMethodDef methods[];
+    static PyTypeObject type;
+
+   protected:
+    PyPERF_OBJECT_TYPE *m_obType;  // NULL once removed.
+    DWORD m_Slot;
+};
+
+#define PyPERF_INSTANCE_Check(ob) ((ob)->ob_type == &PyPERF_INSTANCE::type)
+
+// Counters in the mapping may also be updated by other threads (and processes), so
+// all updates from Python are interlocked.
+inline void PerfCounterAdd(DWORD *pVal, LONG delta) { InterlockedExchangeAdd((LONG volatile *)pVal, delta); }
+inline void PerfCounterSet(DWORD *pVal, LONG value) { InterlockedExchange((LONG volatile *)pVal, value); }
+
+// Accumulates increments of one counter (of an object, or of an instance) without touching
+// the mapping, and adds them to the counter when flushed.
+class PyPERF_COUNTER_CELL : public PyObject {
+   public:
+    PyPERF_COUNTER_CELL(PyPERF_COUNTER_DEFINITION *obCounter, PyPERF_INSTANCE *obInstance, DWORD flushEvery);
+    ~PyPERF_COUNTER_CELL();
+
+    void FoldPending();
+
+    /* Python support */
+    static void deallocFunc(PyObject *ob);
+
+    static PyObject *Increment(PyObject *self, PyObject *args);
+    static PyObject *Flush(PyObject *self, PyObject *args);
+
+    static struct PyMemberDef members[];
+    static struct PyMethodDef methods[];
+    static PyTypeObject type;
+
+   protected:
+    PyPERF_COUNTER_DEFINITION *m_obCounter;
+    PyPERF_INSTANCE *m_obInstance;  // NULL for the object's own counter.
+    LONG m_Pending;
+    DWORD m_PendingCount;  // increments since the last flush
+    DWORD m_FlushEvery;
+};
+
+// PerfLib v2 providers.  Counter values live in memory owned by this process and
+// are read in place by perflib, so no collection DLL is involved.
+struct _PERF_COUNTERSET_INSTANCE;
+
+class PyPerfProvider : public PyObject {
+   public:
+    PyPerfProvider(HANDLE hProvider, const GUID &guid);
+    ~PyPerfProvider();
+
+    HANDLE GetHandle() { return m_hProvider; }
+    const GUID &GetGuid() { return m_Guid; }
+    void Term();
+
+    /* Python support */
+    static PyObject *AddCounterSet(PyObject *self, PyObject *args);
+    static PyObject *Stop(PyObject *self, PyObject *args);
+    static void deallocFunc(PyObject *ob);
+
+    static struct PyMemberDef members[];
+    static struct PyMethodDef methods[];
+    static PyTypeObject type;
+
+   protected:
+    HANDLE m_hProvider;  // NULL once stopped.
+    GUID m_Guid;
+};
+
+class PyPERF_COUNTERSET : public PyObject {
+   public:
+    PyPERF_COUNTERSET(PyPerfProvider *obProvider, const GUID &guid, ULONG numCounters, ULONG *counterIds,
+                      BYTE *counterLarge);
+    ~PyPERF_COUNTERSET();
+
+    PyPerfProvider *GetProvider() { return m_obProvider; }
+    const GUID &GetGuid() { return m_Guid; }
+    ULONG GetNumCounters() { return m_NumCounters; }
+    ULONG GetCounterId(ULONG index) { return m_CounterIds[index]; }
+    BOOL IsCounterLarge(ULONG index) { return m_CounterLarge[index]; }
+    // Index of the counter, or -1 (with a Python exception set) if it is not in the set.
+    int FindCounter(ULONG counterId);
+
+    /* Python support */
+    static PyObject *CreateInstance(PyObject *self, PyObject *args);
+    static void deallocFunc(PyObject *ob);
+
+    static struct PyMemberDef members[];
+    static struct PyMethodDef methods[];
+    static PyTypeObject type;
+
+   protected:
+    PyPerfProvider *m_obProvider;
+    GUID m_Guid;
+    ULONG m_NumCounters;
+    ULONG *m_CounterIds;
+    BYTE *m_CounterLarge;  // TRUE for counters with PERF_SIZE_LARGE values.
+};
+
+class PyPERF_COUNTERSET_INSTANCE : public PyObject {
+   public:
+    PyPERF_COUNTERSET_INSTANCE(PyPERF_COUNTERSET *obCounterSet, struct _PERF_COUNTERSET_INSTANCE *pInstance,
+                               ULONGLONG *pValues, ULONG id);
+    ~PyPERF_COUNTERSET_INSTANCE();
+
+    void Release();
+    // The value of the counter, or NULL (with a Python exception set) if it can't be used.
+    void *GetCounterValue(ULONG counterId, BOOL *pbLarge);
+
+    /* Python support */
+    static PyObject *Increment(PyObject *self, PyObject *args);
+    static PyObject *Decrement(PyObject *self, PyObject *args);
+    static PyObject *Set(PyObject *self, PyObject *args);
+    static PyObject *Get(PyObject *self, PyObject *args);
+    static PyObject *Delete(PyObject *self, PyObject *args);
+    static void deallocFunc(PyObject *ob);
+
+    static struct PyMemberDef members[];
+    static struct PyMethodDef methods[];
+    static PyTypeObject type;
+
+   protected:
+    PyPERF_COUNTERSET *m_obCounterSet;
+    struct _PERF_COUNTERSET_INSTANCE *m_pInstance;  // NULL once deleted.
+    ULONGLONG *m_pValues;                           // One slot per counter, referenced by perflib.
+    ULONG m_Id;
+};
@@ -5,6 +5,7 @@
 
 #include "PyWinObjects.h"
 #include "PySecurityObjects.h"
+#include "structmember.h"
 
 #ifndef NO_PYWINTYPES_SECURITY
 
@@ -1129,6 +1130,368 @@ PyObject *PyACL::PyGetAuditedPermissionsFromAcl(PyObject *self, PyObject *args)
     return ret;
 }
 
+// Finds the SID (and the GUIDs of object ACEs) in an ACE, or returns NULL for unknown ACE types.
+static PSID AceSid(ACE_HEADER *pAceHeader, GUID **ppObjectType, GUID **ppInheritedObjectType)
+{
+    *ppObjectType = *ppInheritedObjectType = NULL;
+    switch (pAceHeader->AceType) {
+        case ACCESS_ALLOWED_ACE_TYPE:
+        case ACCESS_DENIED_ACE_TYPE:
+        case SYSTEM_AUDIT_ACE_TYPE:
+#ifdef _WIN32_WINNT_LONGHORN
+        case SYSTEM_MANDATORY_LABEL_ACE_TYPE:
+#endif
+            return (PSID) & ((ACCESS_ALLOWED_ACE *)pAceHeader)->SidStart;
+        case ACCESS_ALLOWED_OBJECT_ACE_TYPE:
+        case ACCESS_DENIED_OBJECT_ACE_TYPE:
+        case SYSTEM_AUDIT_OBJECT_ACE_TYPE: {
+            // As in GetAce, the SID moves up when either GUID is absent
+            ACCESS_ALLOWED_OBJECT_ACE *pObjectAce = (ACCESS_ALLOWED_OBJECT_ACE *)pAceHeader;
+            GUID *next = &pObjectAce->ObjectType;
+            if (pObjectAce->Flags & ACE_OBJECT_TYPE_PRESENT)
+                *ppObjectType = next++;
+            if (pObjectAce->Flags & ACE_INHERITED_OBJECT_TYPE_PRESENT)
+                *ppInheritedObjectType = next++;
+            return (PSID)next;
+        }
+    }
+    return NULL;
+}
+
+// @object PyACE|A lightweight view of a single ACE, returned by <om PyACL.IterAces>
+// @comm Unlike the tuples returned by <om PyACL.GetAce>, nothing is allocated for the SID or GUIDs
+// unless they are asked for.  All the ACEs from one iteration share a single copy of the ACL,
+// taken when the iteration started, so they aren't affected by later changes to the ACL.
+// @comm The object supports the buffer interface, giving the raw bytes of the ACE's SID.
+class PyACE : public PyObject {
+   public:
+    PyACE(PyObject *obsnapshot, ACE_HEADER *pAceHeader);
+    ~PyACE();
+    static void deallocFunc(PyObject *ob);
+    static int getbufferinfo(PyObject *self, Py_buffer *view, int flags);
+    static PyObject *get_Sid(PyObject *self, void *unused);
+    static PyObject *get_ObjectType(PyObject *self, void *unused);
+    static PyObject *get_InheritedObjectType(PyObject *self, void *unused);
+    static PyObject *IsSid(PyObject *self, PyObject *args);
+    static struct PyMethodDef methods[];
+    static struct PyMemberDef members[];
+    static PyGetSetDef getset[];
+
+    BYTE AceType, AceFlags;
+    DWORD Mask;
+
+   protected:
+    PyObject *m_obsnapshot;  // Keeps the copy of the ACL alive
+    PSID m_psid;
+    GUID *m_pObjectType, *m_pInheritedObjectType;
+};
+
+// @pymethod boolean|PyACE|IsSid|Compares the ACE's SID with another, without creating a <o PySID> for it
+PyObject *PyACE::IsSid(PyObject *self, PyObject *args)
+{
+    PyACE *This = (PyACE *)self;
+    PyObject *obsid;
+    PSID psid;
+    // @pyparm <o PySID>|sid||The SID to compare with
+    if (!PyArg_ParseTuple(args, "O:IsSid", &obsid))
+        return NULL;
+    if (!PyWinObject_AsSID(obsid, &psid, FALSE))
+        return NULL;
+    return PyBool_FromLong(This->m_psid && EqualSid(This->m_psid, psid));
+}
+
+struct PyMethodDef PyACE::methods[] = {
+    {"IsSid", PyACE::IsSid, METH_VARARGS},  // @pymeth IsSid|Compares the ACE's SID with another
+    {NULL}};
+
+struct PyMemberDef PyACE::members[] = {
+    // @prop int|AceType|One of the ACE type constants, eg ACCESS_ALLOWED_ACE_TYPE
+    {"AceType", T_UBYTE, offsetof(PyACE, AceType), READONLY},
+    // @prop int|AceFlags|Combination of the ACE flags, eg INHERITED_ACE
+    {"AceFlags", T_UBYTE, offsetof(PyACE, AceFlags), READONLY},
+    // @prop int|Mask|The access mask
+    {"Mask", T_ULONG, offsetof(PyACE, Mask), READONLY},
+    {NULL}};
+
+PyGetSetDef PyACE::getset[] = {
+    // @prop <o PySID>|Sid|The trustee of the ACE, or None for ACE types that aren't understood
+    {"Sid", PyACE::get_Sid, NULL},
+    // @prop <o PyIID>|ObjectType|For object ACEs, the object type GUID if present, otherwise None
+    {"ObjectType", PyACE::get_ObjectType, NULL},
+    // @prop <o PyIID>|InheritedObjectType|For object ACEs, the inherited object type GUID if present, otherwise None
+    {"InheritedObjectType", PyACE::get_InheritedObjectType, NULL},
+    {NULL}};
+
+static PyBufferProcs PyACE_as_buffer = {
+    PyACE::getbufferinfo,
+    NULL,
+};
+
+PYWINTYPES_EXPORT PyTypeObject PyACEType = {
+    PYWIN_OBJECT_HEAD "PyACE",
+    sizeof(PyACE),
+    0,
+    PyACE::deallocFunc,       /* tp_dealloc */
+    0,                        /* tp_print */
+    0,                        /* tp_getattr */
+    0,                        /* tp_setattr */
+    0,                        /* tp_compare */
+    0,                        /* tp_repr */
+    0,                        /* tp_as_number */
+    0,                        /* tp_as_sequence */
+    0,                        /* tp_as_mapping */
+    0,                        /* tp_hash */
+    0,                        /* tp_call */
+    0,                        /* tp_str */
+    PyObject_GenericGetAttr,  /* tp_getattro */
+    0,                        /* tp_setattro */
+    &PyACE_as_buffer,         /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,       /* tp_flags */
+    0,                        /* tp_doc */
+    0,                        /* tp_traverse */
+    0,                        /* tp_clear */
+    0,                        /* tp_richcompare */
+    0,                        /* tp_weaklistoffset */
+    0,                        /* tp_iter */
+    0,                        /* tp_iternext */
+    PyACE::methods,           /* tp_methods */
+    PyACE::members,           /* tp_members */
+    PyACE::getset,            /* tp_getset */
+};
+
+PyACE::PyACE(PyObject *obsnapshot, ACE_HEADER *pAceHeader)
+{
+    ob_type = &PyACEType;
+    _Py_NewReference(this);
+    Py_INCREF(obsnapshot);
+    m_obsnapshot = obsnapshot;
+    AceType = pAceHeader->AceType;
+    AceFlags = pAceHeader->AceFlags;
+    // The mask is in the same place for every ACE type
+    Mask = ((ACCESS_ALLOWED_ACE *)pAceHeader)->Mask;
+    m_psid = AceSid(pAceHeader, &m_pObjectType, &m_pInheritedObjectType);
+}
+
+PyACE::~PyACE() { Py_DECREF(m_obsnapshot); }
+
+/*static*/ void PyACE::deallocFunc(PyObject *ob) { delete (PyACE *)ob; }
+
+/*static*/ int PyACE::getbufferinfo(PyObject *self, Py_buffer *view, int flags)
+{
+    PyACE *This = (PyACE *)self;
+    if (This->m_psid == NULL) {
+        PyErr_SetString(PyExc_BufferError, "This type of ACE has no SID");
+        return -1;
+    }
+    return PyBuffer_FillInfo(view, self, This->m_psid, GetLengthSid(This->m_psid), 1, flags);
+}
+
+/*static*/ PyObject *PyACE::get_Sid(PyObject *self, void *unused)
+{
+    // Interned here for well-known SIDs, see PyWinObject_FromSID
+    return PyWinObject_FromSID(((PyACE *)self)->m_psid);
+}
+
+/*static*/ PyObject *PyACE::get_ObjectType(PyObject *self, void *unused)
+{
+    PyACE *This = (PyACE *)self;
+    if (This->m_pObjectType == NULL) {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+    return PyWinObject_FromIID(*This->m_pObjectType);
+}
+
+/*static*/ PyObject *PyACE::get_InheritedObjectType(PyObject *self, void *unused)
+{
+    PyACE *This = (PyACE *)self;
+    if (This->m_pInheritedObjectType == NULL) {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+    return PyWinObject_FromIID(*This->m_pInheritedObjectType);
+}
+
+// Iterator returned by PyACL.IterAces
+class PyACE_ITER : public PyObject {
+   public:
+    PyACE_ITER(PyObject *obsnapshot);
+    ~PyACE_ITER();
+    static void deallocFunc(PyObject *ob);
+    static PyObject *iternext(PyObject *self);
+
+   protected:
+    PyObject *m_obsnapshot;  // bytes holding a copy of the ACL
+    DWORD m_offset, m_remaining;
+};
+
+PYWINTYPES_EXPORT PyTypeObject PyACE_ITERType = {
+    PYWIN_OBJECT_HEAD "PyACE_ITER",
+    sizeof(PyACE_ITER),
+    0,
+    PyACE_ITER::deallocFunc,  /* tp_dealloc */
+    0,                        /* tp_print */
+    0,                        /* tp_getattr */
+    0,                        /* tp_setattr */
+    0,                        /* tp_compare */
+    0,                        /* tp_repr */
+    0,                        /* tp_as_number */
+    0,                        /* tp_as_sequence */
+    0,                        /* tp_as_mapping */
+    0,                        /* tp_hash */
+    0,                        /* tp_call */
+    0,                        /* tp_str */
+    PyObject_GenericGetAttr,  /* tp_getattro */
+    0,                        /* tp_setattro */
+    0,                        /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,       /* tp_flags */
+    0,                        /* tp_doc */
+    0,                        /* tp_traverse */
+    0,                        /* tp_clear */
+    0,                        /* tp_richcompare */
+    0,                        /* tp_weaklistoffset */
+    PyObject_SelfIter,        /* tp_iter */
+    PyACE_ITER::iternext,     /* tp_iternext */
+};
+
+PyACE_ITER::PyACE_ITER(PyObject *obsnapshot)
+{
+    ob_type = &PyACE_ITERType;
+    _Py_NewReference(this);
+    Py_INCREF(obsnapshot);
+    m_obsnapshot = obsnapshot;
+    m_offset = sizeof(ACL);
+    m_remaining = ((ACL *)PyBytes_AS_STRING(obsnapshot))->AceCount;
+}
+
+PyACE_ITER::~PyACE_ITER() { Py_DECREF(m_obsnapshot); }
+
+/*static*/ void PyACE_ITER::deallocFunc(PyObject *ob) { delete (PyACE_ITER *)ob; }
+
+/*static*/ PyObject *PyACE_ITER::iternext(PyObject *self)
+{
+    PyACE_ITER *This = (PyACE_ITER *)self;
+    if (This->m_remaining == 0)
+        return NULL;
+    BYTE *aclbuf = (BYTE *)PyBytes_AS_STRING(This->m_obsnapshot);
+    DWORD aclsize = (DWORD)PyBytes_GET_SIZE(This->m_obsnapshot);
+    ACE_HEADER *pAceHeader = (ACE_HEADER *)(aclbuf + This->m_offset);
+    if (This->m_offset + sizeof(ACE_HEADER) > aclsize || pAceHeader->AceSize < sizeof(ACE_HEADER) ||
+        This->m_offset + pAceHeader->AceSize > aclsize) {
+        This->m_remaining = 0;
+        PyErr_SetString(PyExc_ValueError, "The ACL is corrupt");
+        return NULL;
+    }
+    This->m_offset += pAceHeader->AceSize;
+    This->m_remaining--;
+    return new PyACE(This->m_obsnapshot, pAceHeader);
+}
+
+// @pymethod iterator|PyACL|IterAces|Iterates over the ACEs in the ACL, yielding a <o PyACE> for each.
+// @comm The ACL is copied once when this is called, and the ACE objects refer to that copy
+// rather than allocating a tuple and a <o PySID> for each one as <om PyACL.GetAce> does.
+PyObject *PyACL::IterAces(PyObject *self, PyObject *args)
+{
+    PyACL *This = (PyACL *)self;
+    if (!PyArg_ParseTuple(args, ":IterAces"))
+        return NULL;
+    ACL *pacl = This->GetACL();
+    PyObject *obsnapshot = PyBytes_FromStringAndSize((char *)pacl, pacl->AclSize);
+    if (obsnapshot == NULL)
+        return NULL;
+    PyObject *ret = new PyACE_ITER(obsnapshot);
+    Py_DECREF(obsnapshot);
+    return ret;
+}
+
+// @pymethod [int, ...]|PyACL|GetEffectiveRightsForSids|Returns the access mask the ACL grants to each of a set of trustees
+// @comm The ACL is evaluated directly, in ACE order: each access-allowed ACE grants the bits that haven't already
+// been denied, and each access-denied ACE denies the bits that haven't already been granted.  Inherit-only ACEs are
+// ignored, as are object ACEs with an object type.  Unlike <om PyACL.GetEffectiveRightsFromAcl>, no group membership
+// is looked up, so a trustee's groups (including Everyone and Authenticated Users where appropriate) must be passed
+// along with it, eg from <om win32security.GetTokenInformation> with TokenGroups.
+// @rdesc Returns a list of access masks, one for each trustee.
+PyObject *PyACL::GetEffectiveRightsForSids(PyObject *self, PyObject *args)
+{
+    PyACL *This = (PyACL *)self;
+    PyObject *obtrustees, *obtrustees_tuple, *ret = NULL;
+    DWORD numtrustees, i;
+    // @pyparm [<o PySID>\|[<o PySID>, ...], ...]|Trustees||Sequence where each item is either a single SID, or a
+    // sequence of the SIDs (user and groups) that make up one trustee
+    if (!PyArg_ParseTuple(args, "O:GetEffectiveRightsForSids", &obtrustees))
+        return NULL;
+    obtrustees_tuple = PyWinSequence_Tuple(obtrustees, &numtrustees);
+    if (obtrustees_tuple == NULL)
+        return NULL;
+    ACL *pacl = This->GetACL();
+    ret = PyList_New(numtrustees);
+    if (ret == NULL)
+        goto done;
+    for (i = 0; i < numtrustees; i++) {
+        PyObject *obtrustee = PyTuple_GET_ITEM(obtrustees_tuple, i);
+        PyObject *obsids_tuple;
+        DWORD numsids;
+        if (PySID_Check(obtrustee)) {
+            obsids_tuple = PyTuple_Pack(1, obtrustee);
+            numsids = 1;
+        }
+        else
+            obsids_tuple = PyWinSequence_Tuple(obtrustee, &numsids);
+        if (obsids_tuple == NULL) {
+            Py_CLEAR(ret);
+            goto done;
+        }
+        for (DWORD j = 0; j < numsids; j++)
+            if (!PySID_Check(PyTuple_GET_ITEM(obsids_tuple, j))) {
+                PyErr_SetString(PyExc_TypeError, "Trustees must be SIDs or sequences of SIDs");
+                Py_DECREF(obsids_tuple);
+                Py_CLEAR(ret);
+                goto done;
+            }
+
+        ACCESS_MASK allowed = 0, denied = 0;
+        BYTE *pace = (BYTE *)pacl + sizeof(ACL);
+        for (WORD acenum = 0; acenum < pacl->AceCount; acenum++, pace += ((ACE_HEADER *)pace)->AceSize) {
+            ACE_HEADER *pAceHeader = (ACE_HEADER *)pace;
+            if (pAceHeader->AceFlags & INHERIT_ONLY_ACE)
+                continue;
+            BOOL ballow;
+            if (pAceHeader->AceType == ACCESS_ALLOWED_ACE_TYPE || pAceHeader->AceType == ACCESS_ALLOWED_OBJECT_ACE_TYPE)
+                ballow = TRUE;
+            else if (pAceHeader->AceType == ACCESS_DENIED_ACE_TYPE ||
+                     pAceHeader->AceType == ACCESS_DENIED_OBJECT_ACE_TYPE)
+                ballow = FALSE;
+            else
+                continue;
+            GUID *pObjectType, *pInheritedObjectType;
+            PSID psid = AceSid(pAceHeader, &pObjectType, &pInheritedObjectType);
+            if (pObjectType)
+                continue;
+            DWORD j;
+            for (j = 0; j < numsids; j++)
+                if (EqualSid(psid, ((PySID *)PyTuple_GET_ITEM(obsids_tuple, j))->GetSID()))
+                    break;
+            if (j == numsids)
+                continue;
+            ACCESS_MASK mask = ((ACCESS_ALLOWED_ACE *)pAceHeader)->Mask;
+            if (ballow)
+                allowed |= mask & ~denied;
+            else
+                denied |= mask & ~allowed;
+        }
+        Py_DECREF(obsids_tuple);
+        PyObject *obmask = PyLong_FromUnsignedLong(allowed);
+        if (obmask == NULL) {
+            Py_CLEAR(ret);
+            goto done;
+        }
+        PyList_SET_ITEM(ret, i, obmask);
+    }
+done:
+    Py_DECREF(obtrustees_tuple);
+    return ret;
+}
+
 // @object PyACL|A Python object, representing a ACL structure
 struct PyMethodDef PyACL::methods[] = {
     {"Initialize", PyACL::Initialize, 1},  // @pymeth Initialize|Initialize the ACL.
@@ -1168,6 +1531,9 @@ struct PyMethodDef PyACL::methods[] = {
     {"GetAuditedPermissionsFromAcl", PyACL::PyGetAuditedPermissionsFromAcl,
      1},  //@pymeth GetAuditedPermissionsFromAcl|Return types of access for which ACL will generate an audit event for
           // specified trustee
+    {"IterAces", PyACL::IterAces, 1},  // @pymeth IterAces|Iterates over the ACEs, without a tuple and SID for each
+    {"GetEffectiveRightsForSids", PyACL::GetEffectiveRightsForSids,
+     1},  // @pymeth GetEffectiveRightsForSids|Evaluates the ACL natively for a set of trustees
     {NULL}};
 
 PYWINTYPES_EXPORT PyTypeObject PyACLType = {
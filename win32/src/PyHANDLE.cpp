@@ -19,13 +19,15 @@ PyObject *PyWinMethod_NewHANDLE(PyObject *self, PyObject *args)
 
 BOOL PyWinObject_AsHANDLE(PyObject *ob, HANDLE *pHANDLE)
 {
-    if (ob == Py_None) {
-        *pHANDLE = (HANDLE)0;
-    }
-    else if (PyHANDLE_Check(ob)) {
+    // Checks are ordered by how often each type is passed - this is called for
+    // nearly every handle argument of every wrapped function.
+    if (PyHANDLE_Check(ob)) {
         PyHANDLE *pH = (PyHANDLE *)ob;
         *pHANDLE = (HANDLE)(*pH);
     }
+    else if (ob == Py_None) {
+        *pHANDLE = (HANDLE)0;
+    }
     else {  // Support integer objects for b/w compat.
         // treat int handles same a void pointers
         if (!PyWinLong_AsVoidPtr(ob, (void **)pHANDLE)) {
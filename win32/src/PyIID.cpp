@@ -7,6 +7,291 @@
 #include "PyWinObjects.h"
 
 #ifndef NO_PYWINTYPES_IID
+// A cache of IID strings already parsed into IID objects, so code which passes
+// the same IID string over and over again gets the same object back.  ProgIDs
+// are not kept here - they are resolved via the ProgID cache below, which is
+// shared by all threads and can watch the registry.  Only exact str objects
+// are cached, and the dict is simply thrown away when it gets too big.
+#define IID_STRING_CACHE_MAX 1024
+static PyObject *obIIDStringCache = NULL;
+
+static BOOL CanCacheIIDString(PyObject *ob) { return PyUnicode_CheckExact(ob) || PyBytes_CheckExact(ob); }
+
+// Returns a borrowed reference to the cached PyIID for the string, or NULL
+// (with no exception set) if it isn't cached.
+static PyIID *LookupIIDString(PyObject *ob)
+{
+    if (obIIDStringCache == NULL || !CanCacheIIDString(ob))
+        return NULL;
+    PyObject *ret = PyDict_GetItem(obIIDStringCache, ob);
+    if (ret == NULL)
+        PyErr_Clear();
+    return (PyIID *)ret;
+}
+
+static void CacheIIDString(PyObject *ob, PyObject *obIID)
+{
+    if (!CanCacheIIDString(ob))
+        return;
+    if (obIIDStringCache == NULL)
+        obIIDStringCache = PyDict_New();
+    else if (PyDict_Size(obIIDStringCache) >= IID_STRING_CACHE_MAX)
+        PyDict_Clear(obIIDStringCache);
+    if (obIIDStringCache == NULL || PyDict_SetItem(obIIDStringCache, ob, obIID) != 0)
+        PyErr_Clear();
+}
+
+// The intern table - a direct mapped table of recently created IID objects, so
+// the IIDs a program uses most (IID_IUnknown, IID_IDispatch etc) are only
+// created once.  IID objects are immutable, so sharing them is safe.
+#define IID_INTERN_SIZE 256
+static PyIID *internedIIDs[IID_INTERN_SIZE];
+
+static unsigned int InternSlot(REFIID riid)
+{
+    DWORD n[4];
+    memcpy(n, &riid, sizeof(n));
+    DWORD h = n[0] ^ n[1] ^ n[2] ^ n[3];
+    h ^= h >> 16;
+    h ^= h >> 8;
+    return h % IID_INTERN_SIZE;
+}
+
+#ifndef MS_WINCE
+// The ProgID cache - a process wide table of ProgIDs already resolved by
+// CLSIDFromProgID, which otherwise reads the registry on every call.  It is
+// used without the GIL, so is protected by its own critical section.  Only
+// successful lookups are cached, and the table is flushed when it fills up.
+// Optionally (see PyWin_EnableProgIDCache) the class registrations are watched
+// with RegNotifyChangeKeyValue, and the table is flushed when they change.
+#define PROGID_CACHE_SIZE 256  // must be a power of 2
+struct PROGID_CACHE_ENTRY {
+    WCHAR *progID;
+    CLSID clsid;
+};
+static PROGID_CACHE_ENTRY progIDCache[PROGID_CACHE_SIZE];
+static LONG progIDCacheEntries = 0;
+static LONG progIDCacheHits = 0;
+static LONG progIDCacheMisses = 0;
+static LONG progIDCacheInvalidations = 0;
+static BOOL progIDCacheEnabled = TRUE;
+static CRITICAL_SECTION csProgIDCache;
+// The watch is on both halves of the merged HKEY_CLASSES_ROOT view.
+static HANDLE hProgIDWatchEvent = NULL;
+static HKEY hProgIDWatchKeys[2] = {NULL, NULL};
+
+void PyWinProgIDCache_Init(void) { InitializeCriticalSection(&csProgIDCache); }
+
+static void FlushProgIDCache(void)
+{
+    for (int i = 0; i < PROGID_CACHE_SIZE; i++) {
+        free(progIDCache[i].progID);
+        progIDCache[i].progID = NULL;
+    }
+    progIDCacheEntries = 0;
+    progIDCacheInvalidations++;
+}
+
+// All these ProgID cache helpers are called with csProgIDCache held.
+static void StopProgIDWatch(void)
+{
+    for (int i = 0; i < 2; i++) {
+        if (hProgIDWatchKeys[i])
+            RegCloseKey(hProgIDWatchKeys[i]);
+        hProgIDWatchKeys[i] = NULL;
+    }
+    if (hProgIDWatchEvent)
+        CloseHandle(hProgIDWatchEvent);
+    hProgIDWatchEvent = NULL;
+}
+
+static void ArmProgIDWatch(void)
+{
+    for (int i = 0; i < 2; i++)
+        if (hProgIDWatchKeys[i])
+            RegNotifyChangeKeyValue(hProgIDWatchKeys[i], TRUE, REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET,
+                                    hProgIDWatchEvent, TRUE);
+}
+
+static BOOL StartProgIDWatch(void)
+{
+    // An auto-reset event, so noticing the change also resets it.
+    hProgIDWatchEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (hProgIDWatchEvent == NULL)
+        return FALSE;
+    if (RegOpenKeyExW(HKEY_LOCAL_MACHINE, L"Software\\Classes", 0, KEY_NOTIFY, &hProgIDWatchKeys[0]) != ERROR_SUCCESS)
+        hProgIDWatchKeys[0] = NULL;
+    if (RegOpenKeyExW(HKEY_CURRENT_USER, L"Software\\Classes", 0, KEY_NOTIFY, &hProgIDWatchKeys[1]) != ERROR_SUCCESS)
+        hProgIDWatchKeys[1] = NULL;
+    if (hProgIDWatchKeys[0] == NULL && hProgIDWatchKeys[1] == NULL) {
+        StopProgIDWatch();
+        return FALSE;
+    }
+    ArmProgIDWatch();
+    return TRUE;
+}
+
+static void CheckProgIDWatch(void)
+{
+    // The event is also signalled if the thread which armed the watch exits -
+    // that only costs a needless flush.
+    if (hProgIDWatchEvent && WaitForSingleObject(hProgIDWatchEvent, 0) == WAIT_OBJECT_0) {
+        FlushProgIDCache();
+        ArmProgIDWatch();
+    }
+}
+
+static unsigned int HashProgID(const WCHAR *progID)
+{
+    // FNV-1a, ignoring case as ProgIDs do.
+    unsigned int h = 2166136261u;
+    for (; *progID; progID++) {
+        h ^= towlower(*progID);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Returns the slot holding progID, or the empty slot it belongs in.
+static PROGID_CACHE_ENTRY *FindProgIDSlot(const WCHAR *progID)
+{
+    unsigned int i = HashProgID(progID) & (PROGID_CACHE_SIZE - 1);
+    while (progIDCache[i].progID && _wcsicmp(progIDCache[i].progID, progID) != 0) i = (i + 1) & (PROGID_CACHE_SIZE - 1);
+    return &progIDCache[i];
+}
+
+void PyWinProgIDCache_Free(void)
+{
+    FlushProgIDCache();
+    StopProgIDWatch();
+    DeleteCriticalSection(&csProgIDCache);
+}
+
+// Resolves a ProgID (or CLSID string) to a CLSID via the ProgID cache.  May be
+// called without the GIL.
+HRESULT PyWin_CLSIDFromProgID(const OLECHAR *progID, CLSID *clsid)
+{
+    LONG generation = 0;
+    BOOL enabled;
+    EnterCriticalSection(&csProgIDCache);
+    enabled = progIDCacheEnabled;
+    if (enabled) {
+        CheckProgIDWatch();
+        PROGID_CACHE_ENTRY *entry = FindProgIDSlot(progID);
+        if (entry->progID) {
+            *clsid = entry->clsid;
+            progIDCacheHits++;
+            LeaveCriticalSection(&csProgIDCache);
+            return S_OK;
+        }
+        progIDCacheMisses++;
+        generation = progIDCacheInvalidations;
+    }
+    LeaveCriticalSection(&csProgIDCache);
+
+    HRESULT hr = CLSIDFromString((LPOLESTR)progID, clsid);
+    if (FAILED(hr))
+        hr = CLSIDFromProgID(progID, clsid);
+    if (FAILED(hr) || !enabled)
+        return hr;
+
+    WCHAR *copy = _wcsdup(progID);
+    if (copy == NULL)
+        return hr;
+    EnterCriticalSection(&csProgIDCache);
+    // Don't add a result the registry watch may have invalidated meanwhile.
+    if (progIDCacheEnabled && generation == progIDCacheInvalidations) {
+        if (progIDCacheEntries >= PROGID_CACHE_SIZE * 3 / 4)
+            FlushProgIDCache();
+        PROGID_CACHE_ENTRY *entry = FindProgIDSlot(progID);
+        if (entry->progID == NULL) {
+            entry->progID = copy;
+            entry->clsid = *clsid;
+            progIDCacheEntries++;
+            copy = NULL;
+        }
+    }
+    LeaveCriticalSection(&csProgIDCache);
+    free(copy);
+    return hr;
+}
+
+// Enables or disables the ProgID cache, and the registry watch which keeps it
+// up to date.  Returns the previous enabled state.
+BOOL PyWin_EnableProgIDCache(BOOL enable, BOOL watchRegistry)
+{
+    EnterCriticalSection(&csProgIDCache);
+    BOOL ret = progIDCacheEnabled;
+    progIDCacheEnabled = enable;
+    if (!enable || !watchRegistry)
+        StopProgIDWatch();
+    else if (hProgIDWatchEvent == NULL)
+        StartProgIDWatch();
+    if (!enable)
+        FlushProgIDCache();
+    LeaveCriticalSection(&csProgIDCache);
+    return ret;
+}
+
+void PyWin_ClearProgIDCache(void)
+{
+    EnterCriticalSection(&csProgIDCache);
+    FlushProgIDCache();
+    LeaveCriticalSection(&csProgIDCache);
+}
+
+void PyWin_GetProgIDCacheStats(PyWinProgIDCacheStats *stats)
+{
+    EnterCriticalSection(&csProgIDCache);
+    stats->hits = progIDCacheHits;
+    stats->misses = progIDCacheMisses;
+    stats->entries = progIDCacheEntries;
+    stats->invalidations = progIDCacheInvalidations;
+    stats->enabled = progIDCacheEnabled;
+    stats->watching = hProgIDWatchEvent != NULL;
+    LeaveCriticalSection(&csProgIDCache);
+}
+#endif  // MS_WINCE
+
+// *pIsProgID is set if the string wasn't an IID string, and so was resolved
+// as a ProgID.
+static HRESULT myCLSIDFromString(OLECHAR *str, CLSID *clsid, BOOL *pIsProgID)
+{
+    *pIsProgID = FALSE;
+#ifdef MS_WINCE
+    return CLSIDFromString(str, clsid);
+#else
+    // Only something that looks like "{...}" can be parsed without a trip to
+    // the registry.
+    if (str[0] == L'{') {
+        HRESULT hr = CLSIDFromString(str, clsid);
+        if (SUCCEEDED(hr))
+            return hr;
+    }
+    *pIsProgID = TRUE;
+    return PyWin_CLSIDFromProgID(str, clsid);
+#endif
+}
+
+// @pymethod |pywintypes|ClearIIDCache|Discards the cached IID objects, the cache of
+// strings already converted to IIDs and the ProgID cache.
+// @comm Unless the ProgID cache was told to watch the registry (see
+// <om pythoncom.EnableProgIDCache>) it is not aware of changes to ProgID registrations.
+// The COM server registration functions in win32com.server.register call this, but
+// code which otherwise changes ProgID registrations should call it too.
+PyObject *PyWinMethod_ClearIIDCache(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":ClearIIDCache"))
+        return NULL;
+    Py_CLEAR(obIIDStringCache);
+    for (int i = 0; i < IID_INTERN_SIZE; i++) Py_CLEAR(internedIIDs[i]);
+#ifndef MS_WINCE
+    PyWin_ClearProgIDCache();
+#endif
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
 // @pymethod <o PyIID>|pywintypes|IID|Creates a new IID object
 PyObject *PyWinMethod_NewIID(PyObject *self, PyObject *args)
 {
@@ -34,52 +319,55 @@ PyObject *PyWinMethod_NewIID(PyObject *self, PyObject *args)
         Py_INCREF(obIID);
         return obIID;
     }
+    PyIID *cached = LookupIIDString(obIID);
+    if (cached) {
+        Py_INCREF(cached);
+        return cached;
+    }
     if (!PyWinObject_AsWCHAR(obIID, &bstrIID))
         return NULL;
 
-    HRESULT hr = CLSIDFromString(bstrIID, &iid);
+    BOOL isProgID;
+    HRESULT hr = myCLSIDFromString(bstrIID, &iid, &isProgID);
+    PyWinObject_FreeWCHAR(bstrIID);
     if (FAILED(hr)) {
-#ifndef MS_WINCE
-        hr = CLSIDFromProgID(bstrIID, &iid);
-        if (FAILED(hr)) {
-#endif
-            PyWinObject_FreeWCHAR(bstrIID);
-            PyWin_SetBasicCOMError(hr);
-            return NULL;
-#ifndef MS_WINCE
-        }
-#endif
+        PyWin_SetBasicCOMError(hr);
+        return NULL;
     }
-    PyWinObject_FreeWCHAR(bstrIID);
     /* iid -> PyObject */
-    return PyWinObject_FromIID(iid);
-}
-
-static HRESULT myCLSIDFromString(OLECHAR *str, CLSID *clsid)
-{
-    HRESULT hr = CLSIDFromString(str, clsid);
-#ifdef MS_WINCE
-    return hr;
-#else
-    if (SUCCEEDED(hr))
-        return hr;
-    return CLSIDFromProgID(str, clsid);
-#endif
+    PyObject *ret = PyWinObject_FromIID(iid);
+    if (ret && !isProgID)
+        CacheIIDString(obIID, ret);
+    return ret;
 }
 
 BOOL PyWinObject_AsIID(PyObject *obCLSID, CLSID *clsid)
 {
     BSTR bstrCLSID;
+    PyIID *cached;
     if (PyIID_Check(obCLSID)) {
         *clsid = ((PyIID *)obCLSID)->m_iid;
     }
+    else if ((cached = LookupIIDString(obCLSID)) != NULL) {
+        *clsid = cached->m_iid;
+    }
     else if (PyWinObject_AsBstr(obCLSID, &bstrCLSID, FALSE)) {
-        HRESULT hr = myCLSIDFromString(bstrCLSID, clsid);
+        BOOL isProgID;
+        HRESULT hr = myCLSIDFromString(bstrCLSID, clsid, &isProgID);
         PyWinObject_FreeBstr(bstrCLSID);
         if (FAILED(hr)) {
             PyWin_SetBasicCOMError(hr);
             return FALSE;
         }
+        if (!isProgID && CanCacheIIDString(obCLSID)) {
+            PyObject *obIID = PyWinObject_FromIID(*clsid);
+            if (obIID == NULL)
+                PyErr_Clear();
+            else {
+                CacheIIDString(obCLSID, obIID);
+                Py_DECREF(obIID);
+            }
+        }
     }
     else {
         PyErr_Clear();
@@ -91,10 +379,21 @@ BOOL PyWinObject_AsIID(PyObject *obCLSID, CLSID *clsid)
 
 PyObject *PyWinObject_FromIID(const IID &riid)
 {
-    // Later we could cache common IIDs - say IUnknown, IDispatch and NULL?
-    PyObject *rc = new PyIID(riid);
-    if (rc == NULL)
+    unsigned int slot = InternSlot(riid);
+    PyIID *rc = internedIIDs[slot];
+    if (rc && rc->IsEqual(riid)) {
+        Py_INCREF(rc);
+        return rc;
+    }
+    rc = new PyIID(riid);
+    if (rc == NULL) {
         PyErr_SetString(PyExc_MemoryError, "allocating new PyIID object");
+        return NULL;
+    }
+    // The most recent IID to use a slot wins it.
+    Py_XDECREF(internedIIDs[slot]);
+    Py_INCREF(rc);
+    internedIIDs[slot] = rc;
     return rc;
 }
 
@@ -256,6 +555,36 @@ PyObject *PyIID::repr(void)
 
 /*static*/ void PyIID::deallocFunc(PyObject *ob) { delete (PyIID *)ob; }
 
+// A freelist of PyIID sized blocks - IIDs are created and destroyed at a great
+// rate by QueryInterface heavy code.  Protected by the GIL.
+#define PYIID_FREELIST_MAX 64
+static void *iidFreeList = NULL;
+static int numFreeIIDs = 0;
+
+/*static*/ void *PyIID::operator new(size_t size) throw()
+{
+    if (size == sizeof(PyIID) && iidFreeList != NULL) {
+        void *ret = iidFreeList;
+        iidFreeList = *(void **)ret;
+        numFreeIIDs--;
+        return ret;
+    }
+    return malloc(size);
+}
+
+/*static*/ void PyIID::operator delete(void *p, size_t size)
+{
+    if (p == NULL)
+        return;
+    if (size == sizeof(PyIID) && numFreeIIDs < PYIID_FREELIST_MAX) {
+        *(void **)p = iidFreeList;
+        iidFreeList = p;
+        numFreeIIDs++;
+        return;
+    }
+    free(p);
+}
+
 // Py3k requires that objects implement richcompare to be used as dict keys
 PyObject *PyIID::richcompareFunc(PyObject *self, PyObject *other, int op)
 {
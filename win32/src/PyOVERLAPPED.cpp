@@ -5,6 +5,7 @@
 #include "PyWinObjects.h"
 #include "assert.h"
 #include "structmember.h"
+#include <new>
 
 // @pymethod <o PyOVERLAPPED>|pywintypes|OVERLAPPED|Creates a new OVERLAPPED object
 PyObject *PyWinMethod_NewOVERLAPPED(PyObject *self, PyObject *args)
@@ -128,6 +129,11 @@ PYWINTYPES_EXPORT PyTypeObject PyOVERLAPPEDType = {
      OFF(obDummy)},  // @prop integer|Internal|Reserved for operating system use. (pointer-sized value)
     {"InternalHigh", T_OBJECT,
      OFF(obDummy)},  // @prop integer|InternalHigh|Reserved for operating system use. (pointer-sized value)
+    {"buffer", T_OBJECT, OFF(m_obBuffer),
+     READONLY},  // @prop buffer|buffer|The buffer leased from a <o PyReadBufferPool> by the last read operation
+                 // using this object, or None.  The buffer is returned to its pool when it is no longer referenced.
+                 // <nl>For <om win32file.ReadFileScatter> and <om win32file.WriteFileGather>, this is a tuple
+                 // of the buffers used.
     {NULL}};
 
 PyOVERLAPPED::PyOVERLAPPED(void)
@@ -137,6 +143,8 @@ PyOVERLAPPED::PyOVERLAPPED(void)
     memset(&m_overlapped, 0, sizeof(m_overlapped));
     obDummy = NULL;
     m_obhEvent = NULL;
+    m_obBuffer = NULL;
+    m_pool = NULL;
 }
 
 PyOVERLAPPED::PyOVERLAPPED(const sMyOverlapped *pO)
@@ -146,11 +154,14 @@ PyOVERLAPPED::PyOVERLAPPED(const sMyOverlapped *pO)
     m_overlapped = *pO;
     Py_XINCREF(m_overlapped.obState);
     m_obhEvent = NULL;
+    m_obBuffer = NULL;
+    m_pool = NULL;
 }
 
 PyOVERLAPPED::~PyOVERLAPPED(void)
 {
     Py_XDECREF(m_obhEvent);
+    Py_XDECREF(m_obBuffer);
     Py_XDECREF(m_overlapped.obState);
     // set our memory to zero, so our clunky check for an invalid
     // object in win32file has more chance of success.
@@ -254,4 +265,192 @@ int PyOVERLAPPED::setattro(PyObject *self, PyObject *obname, PyObject *v)
     return _Py_HashPointer(ob);
 }
 
-/*static*/ void PyOVERLAPPED::deallocFunc(PyObject *ob) { delete (PyOVERLAPPED *)ob; }
+// A freelist of PyOVERLAPPED sized blocks, for overlapped objects made one at a
+// time by servers issuing I/O at a high rate.  Protected by the GIL.
+#define PYOVERLAPPED_FREELIST_MAX 256
+static void *overlappedFreeList = NULL;
+static int numFreeOverlappeds = 0;
+
+/*static*/ void *PyOVERLAPPED::operator new(size_t size) throw()
+{
+    if (size == sizeof(PyOVERLAPPED) && overlappedFreeList != NULL) {
+        void *ret = overlappedFreeList;
+        overlappedFreeList = *(void **)ret;
+        numFreeOverlappeds--;
+        return ret;
+    }
+    return malloc(size);
+}
+
+/*static*/ void PyOVERLAPPED::operator delete(void *p, size_t size)
+{
+    if (p == NULL)
+        return;
+    if (size == sizeof(PyOVERLAPPED) && numFreeOverlappeds < PYOVERLAPPED_FREELIST_MAX) {
+        *(void **)p = overlappedFreeList;
+        overlappedFreeList = p;
+        numFreeOverlappeds++;
+        return;
+    }
+    free(p);
+}
+
+// @object PyOVERLAPPEDPool|A fixed number of <o PyOVERLAPPED> objects, preallocated in one block of memory.
+// @comm Objects are handed out by <om PyOVERLAPPEDPool.acquire>, and go straight back to the pool
+// when the last reference to them goes away, so no memory is allocated or freed for each
+// I/O operation.  Each outstanding object keeps the pool alive.
+// <nl>When all the pool's objects are in use, acquire allocates a new object rather than failing,
+// and counts it in the exhausted attribute - a pool which is often exhausted is too small.
+struct PyOVERLAPPEDPool {
+    PyObject_HEAD PyOVERLAPPED *slab;  // size objects' worth of memory
+    void *freeList;      // slots not handed out, linked through their first bytes
+    long size;
+    long outstanding;
+    __int64 acquired;
+    __int64 exhausted;
+};
+
+// @pymethod <o PyOVERLAPPEDPool>|pywintypes|OVERLAPPEDPool|Creates a pool of preallocated <o PyOVERLAPPED> objects
+PyObject *PyWinMethod_NewOVERLAPPEDPool(PyObject *self, PyObject *args)
+{
+    long size;
+    // @pyparm int|size||Number of objects in the pool
+    if (!PyArg_ParseTuple(args, "l:OVERLAPPEDPool", &size))
+        return NULL;
+    if (size <= 0 || (size_t)size > ((size_t)-1) / sizeof(PyOVERLAPPED)) {
+        PyErr_SetString(PyExc_ValueError, "The size of the pool must be positive");
+        return NULL;
+    }
+    PyOVERLAPPEDPool *pool = PyObject_New(PyOVERLAPPEDPool, &PyOVERLAPPEDPoolType);
+    if (pool == NULL)
+        return NULL;
+    memset((char *)pool + sizeof(PyObject), 0, sizeof(PyOVERLAPPEDPool) - sizeof(PyObject));
+    pool->slab = (PyOVERLAPPED *)malloc(size * sizeof(PyOVERLAPPED));
+    if (pool->slab == NULL) {
+        Py_DECREF(pool);
+        return PyErr_NoMemory();
+    }
+    pool->size = size;
+    // Linked so the slots are handed out in address order
+    for (long i = size - 1; i >= 0; i--) {
+        *(void **)&pool->slab[i] = pool->freeList;
+        pool->freeList = &pool->slab[i];
+    }
+    return (PyObject *)pool;
+}
+
+// Returns a released slot to its pool - called after the object's destructor has run.
+static void ReleaseToPool(PyOVERLAPPEDPool *pool, PyOVERLAPPED *po)
+{
+    *(void **)po = pool->freeList;
+    pool->freeList = po;
+    pool->outstanding--;
+    Py_DECREF(pool);
+}
+
+// @pymethod <o PyOVERLAPPED>|PyOVERLAPPEDPool|acquire|Hands out one of the pool's objects
+// @rdesc A <o PyOVERLAPPED> with all its fields reset, as if made by <om pywintypes.OVERLAPPED>.
+static PyObject *PyOVERLAPPEDPool_acquire(PyObject *self, PyObject *args)
+{
+    PyOVERLAPPEDPool *pool = (PyOVERLAPPEDPool *)self;
+    PyObject *obState = Py_None;
+    // @pyparm object|object|None|Sets the object attribute of the <o PyOVERLAPPED>
+    if (!PyArg_ParseTuple(args, "|O:acquire", &obState))
+        return NULL;
+    PyOVERLAPPED *po;
+    if (pool->freeList == NULL) {
+        pool->exhausted++;
+        po = new PyOVERLAPPED();
+        if (po == NULL)
+            return PyErr_NoMemory();
+    }
+    else {
+        void *slot = pool->freeList;
+        pool->freeList = *(void **)slot;
+        po = ::new (slot) PyOVERLAPPED();
+        po->m_pool = pool;
+        pool->outstanding++;
+        Py_INCREF(pool);
+    }
+    pool->acquired++;
+    if (obState != Py_None) {
+        Py_INCREF(obState);
+        po->m_overlapped.obState = obState;
+    }
+    return po;
+}
+
+static void PyOVERLAPPEDPool_dealloc(PyObject *ob)
+{
+    // Outstanding objects hold a reference, so none can be using the slab.
+    free(((PyOVERLAPPEDPool *)ob)->slab);
+    PyObject_Del(ob);
+}
+
+static struct PyMethodDef PyOVERLAPPEDPool_methods[] = {
+    {"acquire", PyOVERLAPPEDPool_acquire, 1},  // @pymeth acquire|Hands out one of the pool's objects
+    {NULL}};
+
+#undef OFF
+#define OFF(e) offsetof(PyOVERLAPPEDPool, e)
+
+static struct PyMemberDef PyOVERLAPPEDPool_members[] = {
+    {"size", T_LONG, OFF(size), READONLY},  // @prop int|size|Number of objects in the pool
+    {"outstanding", T_LONG, OFF(outstanding),
+     READONLY},  // @prop int|outstanding|Number of the pool's objects currently handed out
+    {"acquired", T_LONGLONG, OFF(acquired), READONLY},  // @prop int|acquired|Number of calls to acquire
+    {"exhausted", T_LONGLONG, OFF(exhausted),
+     READONLY},  // @prop int|exhausted|Number of objects allocated by acquire because the pool was empty
+    {NULL}};
+
+PYWINTYPES_EXPORT PyTypeObject PyOVERLAPPEDPoolType = {
+    PYWIN_OBJECT_HEAD "PyOVERLAPPEDPool",
+    sizeof(PyOVERLAPPEDPool),
+    0,
+    PyOVERLAPPEDPool_dealloc, /* tp_dealloc */
+    0,                        /* tp_print */
+    0,                        /* tp_getattr */
+    0,                        /* tp_setattr */
+    0,                        /* tp_compare */
+    0,                        /* tp_repr */
+    0,                        /* tp_as_number */
+    0,                        /* tp_as_sequence */
+    0,                        /* tp_as_mapping */
+    0,                        /* tp_hash */
+    0,                        /* tp_call */
+    0,                        /* tp_str */
+    PyObject_GenericGetAttr,  /* tp_getattro */
+    0,                        /* tp_setattro */
+    0,                        /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,       /* tp_flags */
+    0,                        /* tp_doc */
+    0,                        /* tp_traverse */
+    0,                        /* tp_clear */
+    0,                        /* tp_richcompare */
+    0,                        /* tp_weaklistoffset */
+    0,                        /* tp_iter */
+    0,                        /* tp_iternext */
+    PyOVERLAPPEDPool_methods, /* tp_methods */
+    PyOVERLAPPEDPool_members, /* tp_members */
+    0,                        /* tp_getset */
+    0,                        /* tp_base */
+    0,                        /* tp_dict */
+    0,                        /* tp_descr_get */
+    0,                        /* tp_descr_set */
+    0,                        /* tp_dictoffset */
+    0,                        /* tp_init */
+    0,                        /* tp_alloc */
+    0,                        /* tp_new */
+};
+
+/*static*/ void PyOVERLAPPED::deallocFunc(PyObject *ob)
+{
+    PyOVERLAPPED *po = (PyOVERLAPPED *)ob;
+    PyOVERLAPPEDPool *pool = po->m_pool;
+    if (pool == NULL) {
+        delete po;
+        return;
+    }
+    po->~PyOVERLAPPED();
+    ReleaseToPool(pool, po);
+}
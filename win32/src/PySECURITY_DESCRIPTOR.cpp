@@ -445,7 +445,7 @@ PyObject *PySECURITY_DESCRIPTOR::GetSecurityDescriptorOwner(PyObject *self, PyOb
         return Py_None;
     }
     // create and return pySID object
-    return new PySID(psd_sid);
+    return PyWinObject_FromSID(psd_sid);
 }
 
 // @pymethod |PySECURITY_DESCRIPTOR|SetSecurityDescriptorOwner|Set owner SID.
@@ -561,7 +561,7 @@ PyObject *PySECURITY_DESCRIPTOR::GetSecurityDescriptorGroup(PyObject *self, PyOb
         return Py_None;
     }
     // create and return pySID object
-    return new PySID(psd_sid);
+    return PyWinObject_FromSID(psd_sid);
 }
 
 // @pymethod <o PyACL>|PySECURITY_DESCRIPTOR|GetSecurityDescriptorDacl|Return the discretionary ACL of the security
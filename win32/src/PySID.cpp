@@ -83,7 +83,45 @@ PyObject *PyWinObject_FromSID(PSID pSID)
         Py_INCREF(Py_None);
         return Py_None;
     }
-    return new PySID(pSID);
+    return PySID::Intern(pSID);
+}
+
+// Well-known SIDs such as Everyone, SYSTEM and the BUILTIN groups appear in
+// nearly every ACL, so they are handed out as shared read-only objects rather
+// than a new copy every time.
+#define MAX_INTERNED_SIDS 64
+static PySID *interned_sids[MAX_INTERNED_SIDS];
+static int num_interned_sids = 0;
+
+/*static*/ PyObject *PySID::Intern(PSID psid)
+{
+    // Account SIDs have a domain part (S-1-5-21-a-b-c-rid), anything
+    // with 2 or fewer sub authorities is well-known
+    if (!IsValidSid(psid) || *::GetSidSubAuthorityCount(psid) > 2)
+        return new PySID(psid);
+    for (int i = 0; i < num_interned_sids; i++)
+        if (EqualSid(interned_sids[i]->m_psid, psid)) {
+            Py_INCREF(interned_sids[i]);
+            return interned_sids[i];
+        }
+    PySID *ret = new PySID(psid);
+    if (num_interned_sids < MAX_INTERNED_SIDS) {
+        ret->m_bReadOnly = TRUE;
+        Py_INCREF(ret);
+        interned_sids[num_interned_sids++] = ret;
+    }
+    return ret;
+}
+
+BOOL PySID::CanModify(void)
+{
+    if (m_bReadOnly) {
+        PyErr_SetString(PyExc_TypeError, "This SID is shared and can not be modified - create a new SID instead");
+        return FALSE;
+    }
+    m_hash = -1;
+    Py_CLEAR(m_obtext);
+    return TRUE;
 }
 
 // @pymethod |PySID|Initialize|Initialize the SID.
@@ -97,6 +135,8 @@ PyObject *PySID::Initialize(PyObject *self, PyObject *args)
     if (!PyArg_ParseTuple(args, "(bbbbbb)b:Initialize", &sid_ia.Value[0], &sid_ia.Value[1], &sid_ia.Value[2],
                           &sid_ia.Value[3], &sid_ia.Value[4], &sid_ia.Value[5], &cnt))
         return NULL;
+    if (!This->CanModify())
+        return NULL;
     if (!InitializeSid(This->GetSID(), &sid_ia, cnt))
         return PyWin_SetAPIError("InitializeSid");
     Py_INCREF(Py_None);
@@ -158,6 +198,8 @@ PyObject *PySID::SetSubAuthority(PyObject *self, PyObject *args)
     // @pyparm int|val||The value for the sub authority
     if (!PyArg_ParseTuple(args, "il", &num, &val))
         return NULL;
+    if (!This->CanModify())
+        return NULL;
     if (num < 0 || num >= *::GetSidSubAuthorityCount(This->GetSID())) {
         PyErr_SetString(PyExc_ValueError, "The index is out of range");
         return NULL;
@@ -218,7 +260,10 @@ PYWINTYPES_EXPORT PyTypeObject PySIDType = {
     0,                                                               /* tp_as_number */
     0,                                                               /* tp_as_sequence */
     0,                                                               /* tp_as_mapping */
-    0, 0,                                                            /* tp_call */
+    // @comm PySID objects hash on the raw bytes of the SID, so can be used as dictionary
+    // keys and set members.  Don't modify a SID after using it as a key.
+    PySID::hashFunc,                                                 /* tp_hash */
+    0,                                                               /* tp_call */
     PySID::strFunc,                                                  /* tp_str */
     PyObject_GenericGetAttr,                                         /*tp_getattro*/
     0,                                                               /*tp_setattro*/
@@ -249,6 +294,9 @@ PySID::PySID(int bufSize, void *buf /* = NULL */)
 {
     ob_type = &PySIDType;
     _Py_NewReference(this);
+    m_hash = -1;
+    m_obtext = NULL;
+    m_bReadOnly = FALSE;
     m_psid = (PSID)malloc(bufSize);
     if (buf == NULL)
         memset(m_psid, 0, bufSize);
@@ -260,6 +308,9 @@ PySID::PySID(PSID pOther)
 {
     ob_type = &PySIDType;
     _Py_NewReference(this);
+    m_hash = -1;
+    m_obtext = NULL;
+    m_bReadOnly = FALSE;
     /* always Take my own copy */
     DWORD size = GetLengthSid(pOther);
     m_psid = (PSID)malloc(size);
@@ -270,6 +321,7 @@ PySID::~PySID()
 {
     if (m_psid)
         free(m_psid);
+    Py_XDECREF(m_obtext);
 }
 
 PyObject *PySID::richcompare(PyObject *other, int op)
@@ -278,10 +330,16 @@ PyObject *PySID::richcompare(PyObject *other, int op)
         Py_INCREF(Py_NotImplemented);
         return Py_NotImplemented;
     }
-    PSID p2;
-    if (!PyWinObject_AsSID(other, &p2, FALSE))
-        return NULL;
-    BOOL e = EqualSid(GetSID(), p2);
+    // Interned SIDs are often the same object, and differing hashes (when
+    // we have both) mean the bytes differ without looking at them.
+    PySID *pyother = (PySID *)other;
+    BOOL e;
+    if (pyother == this)
+        e = IsValidSid(m_psid);
+    else if (m_hash != -1 && pyother->m_hash != -1 && m_hash != pyother->m_hash)
+        e = FALSE;
+    else
+        e = EqualSid(m_psid, pyother->m_psid);
     PyObject *ret;
     if (op == Py_EQ)
         ret = e ? Py_True : Py_False;
@@ -297,6 +355,21 @@ PyObject *PySID::richcompareFunc(PyObject *ob1, PyObject *ob2, int op) { return
 
 /*static*/ void PySID::deallocFunc(PyObject *ob) { delete (PySID *)ob; }
 
+/*static*/ Py_hash_t PySID::hashFunc(PyObject *ob)
+{
+    PySID *This = (PySID *)ob;
+    if (This->m_hash == -1) {
+        PSID psid = This->m_psid;
+        Py_ssize_t len = IsValidSid(psid) ? GetLengthSid(psid) : 0;
+#if (PY_VERSION_HEX >= 0x030E0000)
+        This->m_hash = Py_HashBuffer(psid, len);
+#else
+        This->m_hash = _Py_HashBytes(psid, len);
+#endif
+    }
+    return This->m_hash;
+}
+
 // NOTE:  This function taken from KB Q131320.
 BOOL GetTextualSid(
 
@@ -371,6 +444,10 @@ BOOL GetTextualSid(
 /* static */ PyObject *PySID::strFunc(PyObject *ob)
 {
     PySID *pySid = (PySID *)ob;
+    if (pySid->m_obtext) {
+        Py_INCREF(pySid->m_obtext);
+        return pySid->m_obtext;
+    }
     PSID psid = pySid->m_psid;
     DWORD bufSize = 0;
     GetTextualSid(psid, NULL, &bufSize);  // max size, NOT actual size!
@@ -386,6 +463,10 @@ BOOL GetTextualSid(
     GetTextualSid(psid, buf + _tcslen(prefix), &bufSize);
     PyObject *ret = PyWinObject_FromTCHAR(buf);
     free(buf);
+    if (ret) {
+        Py_INCREF(ret);
+        pySid->m_obtext = ret;
+    }
     return ret;
 }
 #else /* NO_PYWINTYPES_SECURITY */
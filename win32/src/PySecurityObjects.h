@@ -102,6 +102,8 @@ class PYWINTYPES_EXPORT PySID : public PyObject {
     static void deallocFunc(PyObject *ob);
     static PyObject *richcompareFunc(PyObject *ob1, PyObject *ob2, int op);
     static PyObject *strFunc(PyObject *ob);
+    static Py_hash_t hashFunc(PyObject *ob);
+    static PyObject *Intern(PSID psid);
 
     // Buffer interface changed in 3.0
 #if (PY_VERSION_HEX < 0x03000000)
@@ -121,7 +123,12 @@ class PYWINTYPES_EXPORT PySID : public PyObject {
     static struct PyMethodDef PySID::methods[];
 
    protected:
+    BOOL CanModify(void);
     PSID m_psid;
+    // Cached, and reset by anything that modifies the SID
+    Py_hash_t m_hash;
+    PyObject *m_obtext;
+    BOOL m_bReadOnly;  // Interned SIDs are shared, so can't be changed
 };
 
 class PYWINTYPES_EXPORT PyACL : public PyObject {
@@ -178,6 +185,8 @@ class PYWINTYPES_EXPORT PyACL : public PyObject {
     static PyObject *PySetEntriesInAcl(PyObject *self, PyObject *args);
     static PyObject *PyGetEffectiveRightsFromAcl(PyObject *self, PyObject *args);
     static PyObject *PyGetAuditedPermissionsFromAcl(PyObject *self, PyObject *args);
+    static PyObject *IterAces(PyObject *self, PyObject *args);
+    static PyObject *GetEffectiveRightsForSids(PyObject *self, PyObject *args);
 
    protected:
     void *buf;
@@ -52,6 +52,67 @@ static PyObject *GetTZUTC()
     return got;
 }
 
+// Integer date arithmetic, so the common conversions don't need a round trip
+// through the Win32 API or the datetime module's timezone support.
+// Days are counted from 1970-01-01 (using the proleptic Gregorian calendar, as
+// both Windows and datetime do), and "ticks" are FILETIME's 100ns units.
+#define TICKS_PER_MS 10000
+#define TICKS_PER_SECOND 10000000
+#define TICKS_PER_DAY 864000000000LL
+#define MS_PER_DAY 86400000
+#define FILETIME_EPOCH_DAYS (-134774)  // 1601-01-01
+#define DATE_EPOCH_DAYS (-25569)       // 1899-12-30
+// The range of DATE values VariantTimeToSystemTime accepts - 100-01-01 to 9999-12-31.
+#define DATE_MIN -657434.0
+#define DATE_MAX 2958466.0
+
+static LONGLONG DaysFromCivil(int y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+    LONGLONG era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static void CivilFromDays(LONGLONG z, SYSTEMTIME *st)
+{
+    z += 719468;
+    LONGLONG era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    st->wDay = (WORD)(doy - (153 * mp + 2) / 5 + 1);
+    st->wMonth = (WORD)(mp < 10 ? mp + 3 : mp - 9);
+    st->wYear = (WORD)(yoe + era * 400 + (st->wMonth <= 2));
+}
+
+// Fills a SYSTEMTIME from milliseconds into the day.
+static void SetTimeOfDay(LONGLONG days, LONGLONG ms, SYSTEMTIME *st)
+{
+    CivilFromDays(days, st);
+    // 1970-01-01 was a Thursday.
+    st->wDayOfWeek = (WORD)(((days % 7) + 11) % 7);
+    st->wHour = (WORD)(ms / 3600000);
+    st->wMinute = (WORD)(ms / 60000 % 60);
+    st->wSecond = (WORD)(ms / 1000 % 60);
+    st->wMilliseconds = (WORD)(ms % 1000);
+}
+
+static void TicksToSYSTEMTIME(LONGLONG ticks, SYSTEMTIME *st)
+{
+    SetTimeOfDay(ticks / TICKS_PER_DAY + FILETIME_EPOCH_DAYS, ticks % TICKS_PER_DAY / TICKS_PER_MS, st);
+}
+
+static LONGLONG SYSTEMTIMEToTicks(const SYSTEMTIME *st)
+{
+    LONGLONG days = DaysFromCivil(st->wYear, st->wMonth, st->wDay) - FILETIME_EPOCH_DAYS;
+    LONGLONG ms = ((st->wHour * 60 + st->wMinute) * 60 + st->wSecond) * 1000 + st->wMilliseconds;
+    return days * TICKS_PER_DAY + ms * TICKS_PER_MS;
+}
+
 // @pymethod <o PyDateTime>|pywintypes|Time|Creates a new time object.
 PyObject *PyWinMethod_NewTime(PyObject *self, PyObject *args)
 {
@@ -172,6 +233,16 @@ BOOL PyWinObject_AsDATE(PyObject *ob, DATE *pDate)
     SYSTEMTIME st;
     if (!PyWinObject_AsSYSTEMTIME(ob, &st))
         return FALSE;
+    if (st.wYear >= 100) {
+        // A DATE is days since 1899-12-30, with the time of day as the
+        // fraction - which, for dates before then, is subtracted.
+        LONGLONG days = DaysFromCivil(st.wYear, st.wMonth, st.wDay) - DATE_EPOCH_DAYS;
+        LONG ms = ((st.wHour * 60 + st.wMinute) * 60 + st.wSecond) * 1000 + st.wMilliseconds;
+        double fraction = (double)ms / MS_PER_DAY;
+        *pDate = days >= 0 ? days + fraction : days - fraction;
+        return TRUE;
+    }
+    // Out of range for a DATE - let the API report the error.
     // Extra work to get milliseconds, via
     // https://www.codeproject.com/Articles/17576/SystemTime-to-VariantTime-with-Milliseconds
     WORD wMilliseconds = st.wMilliseconds;
@@ -196,7 +267,14 @@ BOOL PyWinObject_AsFILETIME(PyObject *ob, FILETIME *ft)
     SYSTEMTIME st;
     if (!PyWinObject_AsSYSTEMTIME(ob, &st))
         return FALSE;
-    // and to the FILETIME
+    if (st.wYear >= 1601) {
+        ULARGE_INTEGER ticks;
+        ticks.QuadPart = SYSTEMTIMEToTicks(&st);
+        ft->dwLowDateTime = ticks.LowPart;
+        ft->dwHighDateTime = ticks.HighPart;
+        return TRUE;
+    }
+    // Before FILETIME begins - let the API report the error.
     if (!SystemTimeToFileTime(&st, ft)) {
         PyWin_SetAPIError("SystemTimeToFileTime");
         return FALSE;
@@ -204,12 +282,69 @@ BOOL PyWinObject_AsFILETIME(PyObject *ob, FILETIME *ft)
     return TRUE;
 }
 
+// Gets the UTC offset of an aware datetime, in microseconds.  Returns FALSE if
+// it isn't aware (the error, if any, is cleared).
+static BOOL GetUTCOffset(PyObject *ob, LONGLONG *offset)
+{
+    PyDateTime_DateTime *dt = (PyDateTime_DateTime *)ob;
+    if (!dt->hastzinfo || dt->tzinfo == Py_None)
+        return FALSE;
+    // The objects we create use the UTC timezone - no need to ask it.
+    PyObject *utc = GetTZUTC();
+    BOOL isUTC = utc == dt->tzinfo;
+    Py_XDECREF(utc);
+#if (PY_VERSION_HEX >= 0x03070000)
+    isUTC = isUTC || dt->tzinfo == PyDateTime_TimeZone_UTC;
+#endif
+    if (isUTC) {
+        *offset = 0;
+        return TRUE;
+    }
+    PyObject *delta = PyObject_CallMethod(ob, "utcoffset", NULL);
+    if (delta == NULL || !PyDelta_Check(delta)) {
+        PyErr_Clear();
+        Py_XDECREF(delta);
+        return FALSE;
+    }
+    *offset = ((LONGLONG)PyDateTime_DELTA_GET_DAYS(delta) * 86400 + PyDateTime_DELTA_GET_SECONDS(delta)) * 1000000 +
+              PyDateTime_DELTA_GET_MICROSECONDS(delta);
+    Py_DECREF(delta);
+    return TRUE;
+}
+
 BOOL PyWinObject_AsSYSTEMTIME(PyObject *ob, SYSTEMTIME *st)
 {
     if (!PyDateTime_Check(ob)) {
         PyErr_Format(PyExc_TypeError, "must be a pywintypes time object (got %s)", ob->ob_type->tp_name);
         return NULL;
     }
+    // For an aware datetime, apply the UTC offset ourselves rather than
+    // building a new datetime via astimezone.
+    LONGLONG offset;
+    if (GetUTCOffset(ob, &offset)) {
+        SYSTEMTIME local;
+        local.wYear = PyDateTime_GET_YEAR(ob);
+        local.wMonth = PyDateTime_GET_MONTH(ob);
+        local.wDay = PyDateTime_GET_DAY(ob);
+        local.wHour = PyDateTime_DATE_GET_HOUR(ob);
+        local.wMinute = PyDateTime_DATE_GET_MINUTE(ob);
+        local.wSecond = PyDateTime_DATE_GET_SECOND(ob);
+        local.wMilliseconds = 0;
+        LONGLONG ticks =
+            SYSTEMTIMEToTicks(&local) + (PyDateTime_DATE_GET_MICROSECOND(ob) - offset) * (TICKS_PER_MS / 1000);
+        // Near the ends of the datetime range, let astimezone raise the error.
+        if (offset == 0 || (ticks >= 0 && ticks < (DaysFromCivil(10000, 1, 1) - FILETIME_EPOCH_DAYS) * TICKS_PER_DAY)) {
+            if (ticks >= 0)
+                TicksToSYSTEMTIME(ticks, st);
+            else {
+                // Only possible with offset == 0, before 1601.
+                *st = local;
+                st->wDayOfWeek = (WORD)(((DaysFromCivil(local.wYear, local.wMonth, local.wDay) % 7) + 11) % 7);
+                st->wMilliseconds = PyDateTime_DATE_GET_MICROSECOND(ob) / 1000;
+            }
+            return TRUE;
+        }
+    }
     // convert the date to a UTC date.
     PyObject *utc = PyObject_CallMethod(ob, "astimezone", "O", GetTZUTC());
     // likely error is "ValueError: astimezone() cannot be applied to a naive datetime"
@@ -358,8 +493,16 @@ PyObject *PyWin_NewTime(PyObject *timeOb)
         // but for now we only have a utc tz available, so convert to a
         // systemtime and go from there.
         SYSTEMTIME st;
-        if (!FileTimeToSystemTime(&t, &st))
-            return PyWin_SetAPIError("FileTimeToSystemTime");
+        ULARGE_INTEGER ticks;
+        ticks.LowPart = t.dwLowDateTime;
+        ticks.HighPart = t.dwHighDateTime;
+        // FileTimeToSystemTime rejects values with the high bit set.
+        if (ticks.QuadPart & 0x8000000000000000ULL) {
+            if (!FileTimeToSystemTime(&t, &st))
+                return PyWin_SetAPIError("FileTimeToSystemTime");
+        }
+        else
+            TicksToSYSTEMTIME((LONGLONG)ticks.QuadPart, &st);
         return PyWinObject_FromSYSTEMTIME(st);
     }
 
@@ -373,6 +516,21 @@ PyObject *PyWin_NewTime(PyObject *timeOb)
 
     PyObject *PyWinObject_FromDATE(DATE t)
     {
+        if (t > DATE_MIN && t < DATE_MAX) {
+            // The whole days and the time of day (which is subtracted for
+            // dates before 1899-12-30), rounded to the millisecond.
+            double whole = t >= 0 ? floor(t) : ceil(t);
+            LONGLONG days = (LONGLONG)whole + DATE_EPOCH_DAYS;
+            LONGLONG ms = (LONGLONG)floor(fabs(t - whole) * MS_PER_DAY + 0.5);
+            if (ms >= MS_PER_DAY) {
+                ms -= MS_PER_DAY;
+                days++;
+            }
+            SYSTEMTIME st;
+            SetTimeOfDay(days, ms, &st);
+            if (st.wYear <= 9999)
+                return PyWinObject_FromSYSTEMTIME(st);
+        }
         // via https://www.codeproject.com/Articles/17576/SystemTime-to-VariantTime-with-Milliseconds
         // (in particular, see the comments)
         double fraction = t - (int)t;  // extracts the fraction part
@@ -428,6 +586,52 @@ PyObject *PyWin_NewTime(PyObject *timeOb)
         return PyWinObject_FromFILETIME(ft);
     }
 
+    // @pymethod memoryview|pywintypes|FileTimesToEpoch|Converts an array of FILETIME values
+    // to seconds since 1970-01-01 (UTC) in one call.
+    PyObject *PyWinMethod_FileTimesToEpoch(PyObject * self, PyObject * args)
+    {
+        PyObject *obData;
+        Py_ssize_t stride = sizeof(FILETIME), offset = 0;
+        // @pyparm buffer|data||An object supporting the buffer interface, holding the FILETIME values
+        // - for example, an array.array('Q'), or a buffer of filled in structures.
+        // @pyparm int|stride|8|The distance in bytes from one FILETIME to the next, so the times can
+        // be picked out of an array of structures.
+        // @pyparm int|offset|0|The offset of the first FILETIME in the buffer.
+        if (!PyArg_ParseTuple(args, "O|nn:FileTimesToEpoch", &obData, &stride, &offset))
+            return NULL;
+        if (stride < (Py_ssize_t)sizeof(FILETIME) || offset < 0)
+            return PyErr_Format(PyExc_ValueError, "stride must be at least %d, and offset can't be negative",
+                                (int)sizeof(FILETIME));
+        PyWinBufferView pybuf(obData);
+        if (!pybuf.ok())
+            return NULL;
+        Py_ssize_t count = 0;
+        if (pybuf.len() >= offset + (Py_ssize_t)sizeof(FILETIME))
+            count = (pybuf.len() - offset - sizeof(FILETIME)) / stride + 1;
+        PyObject *obBytes = PyBytes_FromStringAndSize(NULL, count * sizeof(double));
+        if (obBytes == NULL)
+            return NULL;
+        double *result = (double *)PyBytes_AS_STRING(obBytes);
+        const BYTE *src = (const BYTE *)pybuf.ptr() + offset;
+        const LONGLONG epoch = -FILETIME_EPOCH_DAYS * TICKS_PER_DAY;
+        for (Py_ssize_t i = 0; i < count; i++, src += stride) {
+            // The values may well not be aligned.
+            LONGLONG ticks;
+            memcpy(&ticks, src, sizeof(ticks));
+            result[i] = (double)(ticks - epoch) / TICKS_PER_SECOND;
+        }
+        PyObject *view = PyMemoryView_FromObject(obBytes);
+        Py_DECREF(obBytes);
+        if (view == NULL)
+            return NULL;
+        PyObject *ret = PyObject_CallMethod(view, "cast", "s", "d");
+        Py_DECREF(view);
+        // @rdesc A memoryview of doubles (format 'd'), one for each FILETIME.
+        // @comm This avoids creating a datetime object for each value, which matters when
+        // processing the results of a large directory enumeration.
+        return ret;
+    }
+
     // A couple of public functions used by the module init
     BOOL _PyWinDateTime_Init()
     {
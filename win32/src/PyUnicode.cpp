@@ -17,6 +17,45 @@
 // Note that the reverse is generally *not* true - a function documented as accepting
 // a string must be passed a string.
 
+#if (PY_VERSION_HEX < 0x03020000)
+#define PUAWC_TYPE PyUnicodeObject *
+#else
+#define PUAWC_TYPE PyObject *
+#endif
+
+// The number of WCHARs needed to hold a unicode object, not including the
+// terminator.  Unlike PyUnicode_GET_SIZE, this doesn't need the object to
+// build (and keep) a wchar_t copy of itself.  Returns -1 on error.
+static Py_ssize_t PyWinUnicode_WideLength(PyObject *ob)
+{
+#if (PY_VERSION_HEX >= 0x03030000)
+    if (PyUnicode_READY(ob) == -1)
+        return -1;
+    Py_ssize_t len = PyUnicode_GET_LENGTH(ob);
+    if (PyUnicode_KIND(ob) != PyUnicode_4BYTE_KIND)
+        return len;
+    // Characters outside the BMP need a surrogate pair.
+    Py_ssize_t ret = len;
+    Py_UCS4 *data = PyUnicode_4BYTE_DATA(ob);
+    for (Py_ssize_t i = 0; i < len; i++)
+        if (data[i] > 0xFFFF)
+            ret++;
+    return ret;
+#else
+    return PyUnicode_GET_SIZE(ob);
+#endif
+}
+
+// Copies exactly len WCHARs (as returned by PyWinUnicode_WideLength) of a
+// unicode object, including embedded NULLs, then adds a terminator.
+static BOOL PyWinUnicode_CopyWide(PyObject *ob, WCHAR *dest, Py_ssize_t len)
+{
+    if (PyUnicode_AsWideChar((PUAWC_TYPE)ob, dest, len) == -1)
+        return FALSE;
+    dest[len] = L'\0';
+    return TRUE;
+}
+
 BOOL PyWinObject_AsPfnAllocatedWCHAR(PyObject *stringObject, void *(*pfnAllocator)(ULONG), WCHAR **ppResult,
                                      BOOL bNoneOK /*= FALSE*/, DWORD *pResultLen /*= NULL*/)
 {
@@ -197,6 +236,176 @@ PyObject *PyWinObject_FromBstr(const BSTR bstr, BOOL takeOwnership /*=FALSE*/)
     return ret;
 }
 
+///////////////////////////////////////////////////////////
+//
+// PyBSTRBuffer
+//
+// Large strings returned by COM are often just written somewhere else,
+// hashed or passed back to COM.  A PyBSTRBuffer keeps the BSTR itself, so
+// none of that needs a Python string to be built - one is only created
+// (and then remembered) when str() is called.
+class PyBSTRBuffer : public PyObject {
+   public:
+    PyBSTRBuffer(BSTR bstr);
+    ~PyBSTRBuffer();
+    PyObject *GetStr(void);
+
+    static void deallocFunc(PyObject *ob);
+    static PyObject *strFunc(PyObject *ob);
+    static PyObject *reprFunc(PyObject *ob);
+    static Py_hash_t hashFunc(PyObject *ob);
+    static PyObject *richcompareFunc(PyObject *self, PyObject *other, int op);
+    static Py_ssize_t lengthFunc(PyObject *ob);
+    static int getbufferinfo(PyObject *self, Py_buffer *view, int flags);
+
+    BSTR m_bstr;
+    PyObject *m_obStr;
+};
+
+PyBSTRBuffer::PyBSTRBuffer(BSTR bstr)
+{
+    ob_type = &PyBSTRBufferType;
+    _Py_NewReference(this);
+    m_bstr = bstr;
+    m_obStr = NULL;
+}
+
+PyBSTRBuffer::~PyBSTRBuffer()
+{
+    SysFreeString(m_bstr);
+    Py_XDECREF(m_obStr);
+}
+
+// Returns a borrowed reference.
+PyObject *PyBSTRBuffer::GetStr(void)
+{
+    if (m_obStr == NULL)
+        m_obStr = PyUnicode_FromWideChar(m_bstr, SysStringLen(m_bstr));
+    return m_obStr;
+}
+
+/*static*/ void PyBSTRBuffer::deallocFunc(PyObject *ob) { delete (PyBSTRBuffer *)ob; }
+
+/*static*/ PyObject *PyBSTRBuffer::strFunc(PyObject *ob)
+{
+    PyObject *ret = ((PyBSTRBuffer *)ob)->GetStr();
+    Py_XINCREF(ret);
+    return ret;
+}
+
+/*static*/ PyObject *PyBSTRBuffer::reprFunc(PyObject *ob)
+{
+    return PyString_FromFormat("<PyBSTRBuffer of %u characters at %p>", SysStringLen(((PyBSTRBuffer *)ob)->m_bstr),
+                               ob);
+}
+
+/*static*/ Py_hash_t PyBSTRBuffer::hashFunc(PyObject *ob)
+{
+    // Must hash the same as the equivalent str, as they compare equal.
+    PyObject *obStr = ((PyBSTRBuffer *)ob)->GetStr();
+    return obStr ? PyObject_Hash(obStr) : -1;
+}
+
+/*static*/ PyObject *PyBSTRBuffer::richcompareFunc(PyObject *self, PyObject *other, int op)
+{
+    BSTR b1 = ((PyBSTRBuffer *)self)->m_bstr;
+    if (PyBSTRBuffer_Check(other) && (op == Py_EQ || op == Py_NE)) {
+        // No need to create either string.
+        BSTR b2 = ((PyBSTRBuffer *)other)->m_bstr;
+        UINT cb = SysStringByteLen(b1);
+        BOOL equal = cb == SysStringByteLen(b2) && memcmp(b1, b2, cb) == 0;
+        return PyBool_FromLong(op == Py_EQ ? equal : !equal);
+    }
+    PyObject *obStr = ((PyBSTRBuffer *)self)->GetStr();
+    if (obStr == NULL)
+        return NULL;
+    if (PyBSTRBuffer_Check(other)) {
+        other = ((PyBSTRBuffer *)other)->GetStr();
+        if (other == NULL)
+            return NULL;
+    }
+    return PyObject_RichCompare(obStr, other, op);
+}
+
+/*static*/ Py_ssize_t PyBSTRBuffer::lengthFunc(PyObject *ob) { return SysStringLen(((PyBSTRBuffer *)ob)->m_bstr); }
+
+/*static*/ int PyBSTRBuffer::getbufferinfo(PyObject *self, Py_buffer *view, int flags)
+{
+    BSTR bstr = ((PyBSTRBuffer *)self)->m_bstr;
+    return PyBuffer_FillInfo(view, self, bstr, SysStringByteLen(bstr), 1, flags);
+}
+
+static PySequenceMethods PyBSTRBuffer_as_sequence = {
+    PyBSTRBuffer::lengthFunc, /* sq_length */
+};
+
+static PyBufferProcs PyBSTRBuffer_as_buffer = {
+    PyBSTRBuffer::getbufferinfo,
+    NULL,  // Does not have any allocated mem in Py_buffer struct
+};
+
+// @object PyBSTRBuffer|A read-only string object which holds a COM BSTR.
+// @comm These objects are returned for large strings by COM when enabled
+// via <om pythoncom.EnableBstrBuffers>.  str(ob) returns the value as a
+// normal Python string, which is only created the first time it is needed.
+// <nl>The object supports the buffer interface, exposing the string as
+// UTF-16-LE encoded bytes without any copy - so it can be written to a file,
+// hashed or decoded directly - and can be passed anywhere a Unicode string
+// is accepted by pywin32 and COM.  len(ob) is the number of characters, and
+// it compares and hashes the same as the equivalent string.
+PYWINTYPES_EXPORT PyTypeObject PyBSTRBufferType = {
+    PYWIN_OBJECT_HEAD "PyBSTRBuffer", sizeof(PyBSTRBuffer), 0, PyBSTRBuffer::deallocFunc, /* tp_dealloc */
+    0,                                                                                   /* tp_print */
+    0,                                                                                   /* tp_getattr */
+    0,                                                                                   /* tp_setattr */
+    0,                                                                                   /* tp_compare */
+    PyBSTRBuffer::reprFunc,                                                              /* tp_repr */
+    0,                                                                                   /* tp_as_number */
+    &PyBSTRBuffer_as_sequence,                                                           /* tp_as_sequence */
+    0,                                                                                   /* tp_as_mapping */
+    PyBSTRBuffer::hashFunc,                                                              /* tp_hash */
+    0,                                                                                   /* tp_call */
+    PyBSTRBuffer::strFunc,                                                               /* tp_str */
+    PyObject_GenericGetAttr,                                                             /* tp_getattro */
+    0,                                                                                   /* tp_setattro */
+    &PyBSTRBuffer_as_buffer,                                                             /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                                                                  /* tp_flags */
+    0,                                                                                   /* tp_doc */
+    0,                                                                                   /* tp_traverse */
+    0,                                                                                   /* tp_clear */
+    PyBSTRBuffer::richcompareFunc,                                                       /* tp_richcompare */
+};
+
+// If takeOwnership is TRUE the object frees the BSTR, otherwise it takes
+// a copy of it.
+PyObject *PyWinObject_FromBstrBuffer(BSTR bstr, BOOL takeOwnership /*=FALSE*/)
+{
+    if (bstr == NULL) {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+    if (!takeOwnership) {
+        bstr = SysAllocStringByteLen((char *)bstr, SysStringByteLen(bstr));
+        if (bstr == NULL)
+            return PyErr_NoMemory();
+    }
+    PyObject *ret = new PyBSTRBuffer(bstr);
+    if (ret == NULL) {
+        SysFreeString(bstr);
+        return PyErr_NoMemory();
+    }
+    return ret;
+}
+
+BSTR PyWinObject_GetBstrBuffer(PyObject *ob)
+{
+    if (!PyBSTRBuffer_Check(ob)) {
+        PyErr_SetString(PyExc_TypeError, "A PyBSTRBuffer object is required");
+        return NULL;
+    }
+    return ((PyBSTRBuffer *)ob)->m_bstr;
+}
+
 ///////////////////////////////////////////////////////////
 //
 // Some utilities etc
@@ -246,26 +455,27 @@ BOOL PyWinObject_AsBstr(PyObject *stringObject, BSTR *pResult, BOOL bNoneOK /*=
     BOOL rc = TRUE;
     if (PyString_Check(stringObject))
         rc = PyString_AsBstr(stringObject, pResult);
+    else if (PyBSTRBuffer_Check(stringObject)) {
+        // a copy of the same BSTR - no Python string is needed.
+        BSTR bstr = ((PyBSTRBuffer *)stringObject)->m_bstr;
+        *pResult = SysAllocStringByteLen((char *)bstr, SysStringByteLen(bstr));
+    }
     else if (PyUnicode_Check(stringObject)) {
         // copy the value, including embedded NULLs
-        int nchars = PyUnicode_GET_SIZE(stringObject);
-        *pResult = SysAllocStringLen(NULL, nchars);
+        Py_ssize_t nchars = PyWinUnicode_WideLength(stringObject);
+        if (nchars == -1)
+            return FALSE;
+        *pResult = SysAllocStringLen(NULL, (UINT)nchars);
         if (*pResult) {
-#if (PY_VERSION_HEX < 0x03020000)
-#define PUAWC_TYPE PyUnicodeObject *
-#else
-#define PUAWC_TYPE PyObject *
-#endif
-            if (PyUnicode_AsWideChar((PUAWC_TYPE)stringObject, *pResult, nchars) == -1) {
-                rc = FALSE;
-            }
-            else {
-                // The SysAllocStringLen docs indicate that nchars+1 bytes are allocated,
-                // and that normally a \0 is appened by the function.  It also states
-                // the \0 is not necessary!  While it seems to work fine without it,
-                // we do copy it, as the previous code, which used SysAllocStringLen
-                // with a non-NULL arg is documented clearly as appending the \0.
-                (*pResult)[nchars] = 0;
+            // The SysAllocStringLen docs indicate that nchars+1 bytes are allocated,
+            // and that normally a \0 is appened by the function.  It also states
+            // the \0 is not necessary!  While it seems to work fine without it,
+            // we do copy it, as the previous code, which used SysAllocStringLen
+            // with a non-NULL arg is documented clearly as appending the \0.
+            if (!PyWinUnicode_CopyWide(stringObject, *pResult, nchars)) {
+                SysFreeString(*pResult);
+                *pResult = NULL;
+                return FALSE;
             }
         }
     }
@@ -298,15 +508,26 @@ void PyWinObject_FreeBstr(BSTR str) { SysFreeString(str); }
 // Convert a Python object to a WCHAR - allow embedded NULLs, None, etc.
 BOOL PyWinObject_AsWCHAR(PyObject *stringObject, WCHAR **pResult, BOOL bNoneOK /*= FALSE*/,
                          DWORD *pResultLen /*= NULL*/)
+{
+    return PyWinObject_AsWCHARBuf(stringObject, NULL, 0, pResult, bNoneOK, pResultLen);
+}
+
+void PyWinObject_FreeWCHAR(WCHAR *str) { PyMem_Free(str); }
+
+// As for PyWinObject_AsWCHAR, but the result is written to buf (which holds
+// cchBuf WCHARs) if it fits, so short strings don't need a heap allocation.
+// The result must be freed with PyWinObject_FreeWCHARBuf.
+BOOL PyWinObject_AsWCHARBuf(PyObject *stringObject, WCHAR *buf, DWORD cchBuf, WCHAR **pResult,
+                            BOOL bNoneOK /*= FALSE*/, DWORD *pResultLen /*= NULL*/)
 {
     BOOL rc = TRUE;
-    int resultLen = 0;
+    Py_ssize_t resultLen = 0;
 #if (PY_VERSION_HEX < 0x03000000)
     // Do NOT accept 'bytes' object when a plain 'WCHAR' is needed on py3k.
     if (PyString_Check(stringObject)) {
         int size = PyString_Size(stringObject);
-        const char *buf = PyString_AsString(stringObject);
-        if (buf == NULL)
+        const char *src = PyString_AsString(stringObject);
+        if (src == NULL)
             return FALSE;
 
         /* We assume that we dont need more 'wide characters' for the result
@@ -314,28 +535,41 @@ BOOL PyWinObject_AsWCHAR(PyObject *stringObject, WCHAR **pResult, BOOL bNoneOK /
            will need less, as the input may contain multi-byte chars, but we
            should never need more
         */
-        *pResult = (LPWSTR)PyMem_Malloc((size + 1) * sizeof(WCHAR));
+        if ((DWORD)size < cchBuf)
+            *pResult = buf;
+        else
+            *pResult = (LPWSTR)PyMem_Malloc((size + 1) * sizeof(WCHAR));
         if (*pResult == NULL) {
             PyErr_SetString(PyExc_MemoryError, "No memory for wide string buffer");
             return FALSE;
         }
         /* convert and get the final character size */
-        resultLen = MultiByteToWideChar(CP_ACP, 0, buf, size, *pResult, size);
+        resultLen = MultiByteToWideChar(CP_ACP, 0, src, size, *pResult, size);
         /* terminate the string */
         (*pResult)[resultLen] = L'\0';
     }
     else
 #endif  // py3k
         if (PyUnicode_Check(stringObject)) {
-        resultLen = PyUnicode_GET_SIZE(stringObject);
-        size_t cb = sizeof(WCHAR) * (resultLen + 1);
-        *pResult = (WCHAR *)PyMem_Malloc(cb);
-        if (*pResult == NULL) {
-            PyErr_SetString(PyExc_MemoryError, "Allocating WCHAR array");
+        resultLen = PyWinUnicode_WideLength(stringObject);
+        if (resultLen == -1)
+            return FALSE;
+        if (resultLen < (Py_ssize_t)cchBuf)
+            *pResult = buf;
+        else {
+            *pResult = (WCHAR *)PyMem_Malloc(sizeof(WCHAR) * (resultLen + 1));
+            if (*pResult == NULL) {
+                PyErr_SetString(PyExc_MemoryError, "Allocating WCHAR array");
+                return FALSE;
+            }
+        }
+        // copy the value, including embedded NULLs - straight from the
+        // string's own data.
+        if (!PyWinUnicode_CopyWide(stringObject, *pResult, resultLen)) {
+            PyWinObject_FreeWCHARBuf(*pResult, buf);
+            *pResult = NULL;
             return FALSE;
         }
-        // copy the value, including embedded NULLs
-        memcpy(*pResult, PyUnicode_AsUnicode(stringObject), cb);
     }
     else if (stringObject == Py_None) {
         if (bNoneOK) {
@@ -352,11 +586,15 @@ BOOL PyWinObject_AsWCHAR(PyObject *stringObject, WCHAR **pResult, BOOL bNoneOK /
         rc = FALSE;
     }
     if (rc && pResultLen)
-        *pResultLen = resultLen;
+        *pResultLen = (DWORD)resultLen;
     return rc;
 }
 
-void PyWinObject_FreeWCHAR(WCHAR *str) { PyMem_Free(str); }
+void PyWinObject_FreeWCHARBuf(WCHAR *str, WCHAR *buf)
+{
+    if (str != buf)
+        PyMem_Free(str);
+}
 
 // Converts a series of consecutive null terminated strings into a list
 // Note that a read overflow can result if the input is not properly terminated with an extra NULL.
@@ -454,6 +692,45 @@ BOOL PyWinObject_AsMultipleString(PyObject *ob, char **pmultistring, BOOL bNoneO
     return rc;
 }
 
+// Converts a sequence of unicode objects directly into the result buffer, with
+// no intermediate copy of each string.  Returns -1 (with no exception set) if
+// some item isn't a unicode object.
+static int AsMultipleStringDirect(PyObject *str_tuple, DWORD numStrings, WCHAR **pmultistring, DWORD *chars_returned)
+{
+    DWORD i;
+    size_t len = numStrings + 1;  // One null for each string plus extra terminating null
+    for (i = 0; i < numStrings; i++) {
+        PyObject *item = PyTuple_GET_ITEM(str_tuple, i);
+        if (!PyUnicode_Check(item))
+            return -1;
+        Py_ssize_t cch = PyWinUnicode_WideLength(item);
+        if (cch == -1)
+            return FALSE;
+        len += cch;
+    }
+    WCHAR *p = (WCHAR *)malloc(len * sizeof(WCHAR));
+    if (p == NULL) {
+        PyErr_NoMemory();
+        return FALSE;
+    }
+    *pmultistring = p;
+    for (i = 0; i < numStrings; i++) {
+        PyObject *item = PyTuple_GET_ITEM(str_tuple, i);
+        if (!PyWinUnicode_CopyWide(item, p, PyWinUnicode_WideLength(item))) {
+            free(*pmultistring);
+            *pmultistring = NULL;
+            return FALSE;
+        }
+        // As before, a string stops at any embedded null.
+        p += wcslen(p);
+        *p++ = L'\0';
+    }
+    *p = L'\0';  // Add second terminator.
+    if (chars_returned)
+        *chars_returned = (DWORD)(p - *pmultistring + 1);
+    return TRUE;
+}
+
 // Converts a sequence of str/unicode objects into a series of consecutive null-terminated
 //	char strings with extra terminating null
 BOOL PyWinObject_AsMultipleString(PyObject *ob, WCHAR **pmultistring, BOOL bNoneOK, DWORD *chars_returned)
@@ -465,6 +742,16 @@ BOOL PyWinObject_AsMultipleString(PyObject *ob, WCHAR **pmultistring, BOOL bNone
     *pmultistring = NULL;
     if (chars_returned)
         *chars_returned = 0;
+    if (bNoneOK && ob == Py_None)
+        return TRUE;
+    // The common case - a sequence of unicode objects - is converted in one go.
+    PyObject *str_tuple = PyWinSequence_Tuple(ob, &numStrings);
+    if (str_tuple == NULL)
+        return FALSE;
+    int direct = AsMultipleStringDirect(str_tuple, numStrings, pmultistring, chars_returned);
+    Py_DECREF(str_tuple);
+    if (direct != -1)
+        return direct;
     if (!PyWinObject_AsWCHARArray(ob, &wchars, &numStrings, bNoneOK))
         return FALSE;
     // Shortcut for None
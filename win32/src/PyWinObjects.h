@@ -26,9 +26,15 @@ class PYWINTYPES_EXPORT PyIID : public PyObject {
     static Py_hash_t hashFunc(PyObject *ob);
     static PyObject *strFunc(PyObject *ob);
     static PyObject *reprFunc(PyObject *ob);
+
+    // Allocated from a small freelist - the GIL must be held.
+    static void *operator new(size_t size) throw();
+    static void operator delete(void *p, size_t size);
 };
 #endif  // NO_PYWINTYPES_IID
 
+struct PyOVERLAPPEDPool;
+
 class PYWINTYPES_EXPORT PyOVERLAPPED : public PyObject {
    public:
     class PYWINTYPES_EXPORT sMyOverlapped : public OVERLAPPED {
@@ -57,6 +63,10 @@ class PYWINTYPES_EXPORT PyOVERLAPPED : public PyObject {
     PyOVERLAPPED(const sMyOverlapped *);
     ~PyOVERLAPPED();
 
+    // Allocated from a small freelist - the GIL must be held.
+    static void *operator new(size_t size) throw();
+    static void operator delete(void *p, size_t size);
+
     /* Python support */
     static void deallocFunc(PyObject *ob);
     static PyObject *richcompareFunc(PyObject *ob, PyObject *other, int op);
@@ -76,6 +86,10 @@ class PYWINTYPES_EXPORT PyOVERLAPPED : public PyObject {
 
     sMyOverlapped m_overlapped;
     PyObject *m_obhEvent;
+    // The buffer leased for the last read using this overlapped, if any.
+    PyObject *m_obBuffer;
+    // The pool whose slab this object lives in, or NULL if it was allocated by itself.
+    PyOVERLAPPEDPool *m_pool;
 };
 
 class PYWINTYPES_EXPORT PyHANDLE : public PyObject {
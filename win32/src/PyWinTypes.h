@@ -154,11 +154,24 @@ PYWINTYPES_EXPORT void PyWinObject_FreeBstr(BSTR pResult);
 
 PYWINTYPES_EXPORT PyObject *PyWinObject_FromBstr(const BSTR bstr, BOOL takeOwnership = FALSE);
 
+// A read-only, string-like object holding a BSTR, which is only converted
+// to a Python string on demand.  PyWinObject_AsBstr (and so COM) accepts it.
+extern PYWINTYPES_EXPORT PyTypeObject PyBSTRBufferType;
+#define PyBSTRBuffer_Check(ob) ((ob)->ob_type == &PyBSTRBufferType)
+PYWINTYPES_EXPORT PyObject *PyWinObject_FromBstrBuffer(BSTR bstr, BOOL takeOwnership = FALSE);
+// Returns the BSTR held by a PyBSTRBuffer - it remains owned by the object.
+PYWINTYPES_EXPORT BSTR PyWinObject_GetBstrBuffer(PyObject *ob);
+
 // Given a string or Unicode object, get WCHAR characters.
 PYWINTYPES_EXPORT BOOL PyWinObject_AsWCHAR(PyObject *stringObject, WCHAR **pResult, BOOL bNoneOK = FALSE,
                                            DWORD *pResultLen = NULL);
 // And free it when finished.
 PYWINTYPES_EXPORT void PyWinObject_FreeWCHAR(WCHAR *pResult);
+// As above, but the result is written to buf (of cchBuf WCHARs), without a heap
+// allocation, if it fits.  Free it (passing the same buf) when finished.
+PYWINTYPES_EXPORT BOOL PyWinObject_AsWCHARBuf(PyObject *stringObject, WCHAR *buf, DWORD cchBuf, WCHAR **pResult,
+                                              BOOL bNoneOK = FALSE, DWORD *pResultLen = NULL);
+PYWINTYPES_EXPORT void PyWinObject_FreeWCHARBuf(WCHAR *pResult, WCHAR *buf);
 
 inline BOOL PyWinObject_AsWCHAR(PyObject *stringObject, unsigned short **pResult, BOOL bNoneOK = FALSE,
                                 DWORD *pResultLen = NULL)
@@ -194,6 +207,34 @@ class TmpWCHAR {
     ~TmpWCHAR() { PyWinObject_FreeWCHAR(tmp); }
 };
 
+// Like TmpWCHAR, but strings shorter than TMPSTACKWCHAR_SIZE are converted into
+// a buffer held in the object itself (so usually on the stack), avoiding the
+// heap entirely for typical paths and names.  Convert with init().
+#define TMPSTACKWCHAR_SIZE 260
+class TmpStackWCHAR {
+   public:
+    WCHAR *tmp;
+    TmpStackWCHAR() { tmp = NULL; }
+    BOOL init(PyObject *ob, BOOL bNoneOK = FALSE, DWORD *pResultLen = NULL)
+    {
+        release();
+        return PyWinObject_AsWCHARBuf(ob, buf, TMPSTACKWCHAR_SIZE, &tmp, bNoneOK, pResultLen);
+    }
+    void release()
+    {
+        PyWinObject_FreeWCHARBuf(tmp, buf);
+        tmp = NULL;
+    }
+    operator WCHAR *() { return tmp; }
+    ~TmpStackWCHAR() { release(); }
+
+   private:
+    WCHAR buf[TMPSTACKWCHAR_SIZE];
+    // not copyable - the pointer may refer to our own buffer.
+    TmpStackWCHAR(const TmpStackWCHAR &src);
+    TmpStackWCHAR &operator=(const TmpStackWCHAR &);
+};
+
 // For 64-bit python compatibility, convert sequence to tuple and check length fits in a DWORD
 PYWINTYPES_EXPORT PyObject *PyWinSequence_Tuple(PyObject *obseq, DWORD *len);
 
@@ -271,6 +312,7 @@ PYWINTYPES_EXPORT BOOL PyWinObject_AsPfnAllocatedWCHAR(PyObject *stringObject, v
 // being returned should not depend on UNICODE or not.
 #define PyWinObject_AsTCHAR PyWinObject_AsWCHAR
 #define PyWinObject_FreeTCHAR PyWinObject_FreeWCHAR
+typedef TmpStackWCHAR TmpStackTCHAR;
 #define PyWinObject_FromTCHAR PyWinObject_FromOLECHAR
 #else /* not UNICODE */
 #define PyWinObject_AsTCHAR PyWinObject_AsString
@@ -291,6 +333,27 @@ PYWINTYPES_EXPORT void PyWinObject_FreeTaskAllocatedWCHAR(WCHAR *str);
 PYWINTYPES_EXPORT void PyWinObject_FreeString(char *str);
 PYWINTYPES_EXPORT void PyWinObject_FreeString(WCHAR *str);
 
+#ifndef UNICODE
+// The TmpStackWCHAR of a non-unicode build - just a self freeing char *.
+class TmpStackTCHAR {
+   public:
+    char *tmp;
+    TmpStackTCHAR() { tmp = NULL; }
+    BOOL init(PyObject *ob, BOOL bNoneOK = FALSE, DWORD *pResultLen = NULL)
+    {
+        release();
+        return PyWinObject_AsString(ob, &tmp, bNoneOK, pResultLen);
+    }
+    void release()
+    {
+        PyWinObject_FreeString(tmp);
+        tmp = NULL;
+    }
+    operator char *() { return tmp; }
+    ~TmpStackTCHAR() { release(); }
+};
+#endif  // UNICODE
+
 // Copy null terminated string with same allocator as PyWinObject_AsWCHAR, etc
 PYWINTYPES_EXPORT WCHAR *PyWin_CopyString(const WCHAR *input);
 PYWINTYPES_EXPORT char *PyWin_CopyString(const char *input);
@@ -338,6 +401,10 @@ PYWINTYPES_EXPORT PyObject *PyWinObject_FromOVERLAPPED(const OVERLAPPED *pOverla
 // A global function that can work as a module method for making an OVERLAPPED object.
 PYWINTYPES_EXPORT PyObject *PyWinMethod_NewOVERLAPPED(PyObject *self, PyObject *args);
 
+// A slab of preallocated PyOVERLAPPED objects, which go back to the pool when released.
+extern PYWINTYPES_EXPORT PyTypeObject PyOVERLAPPEDPoolType;
+PYWINTYPES_EXPORT PyObject *PyWinMethod_NewOVERLAPPEDPool(PyObject *self, PyObject *args);
+
 #ifndef NO_PYWINTYPES_IID
 /*
 ** IID/GUID support
@@ -357,6 +424,25 @@ PYWINTYPES_EXPORT PyObject *PyWinCoreString_FromIID(const IID &riid);
 
 // A global function that can work as a module method for making an IID object.
 PYWINTYPES_EXPORT PyObject *PyWinMethod_NewIID(PyObject *self, PyObject *args);
+PYWINTYPES_EXPORT PyObject *PyWinMethod_ClearIIDCache(PyObject *self, PyObject *args);
+
+#ifndef MS_WINCE
+// The process wide ProgID -> CLSID cache.  These functions don't need the GIL.
+struct PyWinProgIDCacheStats {
+    LONG hits;
+    LONG misses;
+    LONG entries;
+    LONG invalidations;  // number of times the cache has been flushed.
+    BOOL enabled;
+    BOOL watching;  // is the registry being watched for changes?
+};
+// Resolve a ProgID (or CLSID string) to a CLSID, via the cache.
+PYWINTYPES_EXPORT HRESULT PyWin_CLSIDFromProgID(const OLECHAR *progID, CLSID *clsid);
+// Returns the previous enabled state.
+PYWINTYPES_EXPORT BOOL PyWin_EnableProgIDCache(BOOL enable, BOOL watchRegistry);
+PYWINTYPES_EXPORT void PyWin_ClearProgIDCache(void);
+PYWINTYPES_EXPORT void PyWin_GetProgIDCacheStats(PyWinProgIDCacheStats *stats);
+#endif  // MS_WINCE
 #endif /*NO_PYWINTYPES_IID */
 
 /*
@@ -386,6 +472,9 @@ PYWINTYPES_EXPORT PyObject *PyWinMethod_NewTimeStamp(PyObject *self, PyObject *a
 
 PYWINTYPES_EXPORT BOOL PyWinTime_Check(PyObject *ob);
 
+// The pywintypes.datetime type - a subclass of datetime.datetime.
+extern PYWINTYPES_EXPORT PyTypeObject PyWinDateTimeType;
+
 // functions to return WIN32_FIND_DATA tuples, used in shell, win32api, and win32file
 PYWINTYPES_EXPORT PyObject *PyObject_FromWIN32_FIND_DATAA(WIN32_FIND_DATAA *pData);
 PYWINTYPES_EXPORT PyObject *PyObject_FromWIN32_FIND_DATAW(WIN32_FIND_DATAW *pData);
@@ -397,6 +486,8 @@ PYWINTYPES_EXPORT PyObject *PyObject_FromWIN32_FIND_DATAW(WIN32_FIND_DATAW *pDat
 
 // POINT tuple, used in win32api_display.cpp and win32gui.i
 PYWINTYPES_EXPORT BOOL PyWinObject_AsPOINT(PyObject *obpoint, LPPOINT ppoint);
+// Contiguous buffer of int32 (x,y) pairs; returns 1 (release the view), 0 (not a buffer) or -1 (error)
+PYWINTYPES_EXPORT int PyWinObject_AsPOINTBuffer(PyObject *ob, Py_buffer *view, DWORD *item_cnt);
 
 // IO_COUNTERS dict, used in win32process and win32job
 PYWINTYPES_EXPORT PyObject *PyWinObject_FromIO_COUNTERS(PIO_COUNTERS pioc);
@@ -483,6 +574,8 @@ PYWINTYPES_EXPORT PyObject *PyWinObject_FromSID(PSID pSID);
 */
 extern PYWINTYPES_EXPORT PyTypeObject PyACLType;
 #define PyACL_Check(ob) ((ob)->ob_type == &PyACLType)
+extern PYWINTYPES_EXPORT PyTypeObject PyACEType;
+extern PYWINTYPES_EXPORT PyTypeObject PyACE_ITERType;
 
 PYWINTYPES_EXPORT PyObject *PyWinMethod_NewACL(PyObject *self, PyObject *args);
 PYWINTYPES_EXPORT BOOL PyWinObject_AsACL(PyObject *ob, PACL *ppACL, BOOL bNoneOK = FALSE);
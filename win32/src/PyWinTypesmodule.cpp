@@ -21,6 +21,7 @@ PyObject *PyWinExc_ApiError = NULL;
 PyObject *PyWinExc_COMError = NULL;
 
 extern PyObject *PyWinMethod_NewHKEY(PyObject *self, PyObject *args);
+extern PyObject *PyWinMethod_FileTimesToEpoch(PyObject *self, PyObject *args);
 
 extern BOOL _PyWinDateTime_Init();
 extern BOOL _PyWinDateTime_PrepareModuleDict(PyObject *dict);
@@ -448,6 +449,43 @@ BOOL PyWinObject_AsPOINT(PyObject *obpoint, LPPOINT ppoint)
     return PyArg_ParseTuple(obpoint, "ll;POINT must be a tuple of 2 ints (x,y)", &ppoint->x, &ppoint->y);
 }
 
+// Exposes a contiguous buffer of int32 (x,y) pairs - eg, array.array('i') or a
+// numpy int32 array - as an array of POINT structs without parsing any tuples.
+// Returns 1 if view has been filled (caller must PyBuffer_Release it), 0 if the
+// object does not support the buffer protocol, or -1 with an exception set.
+int PyWinObject_AsPOINTBuffer(PyObject *ob, Py_buffer *view, DWORD *item_cnt)
+{
+    *item_cnt = 0;
+    if (!PyObject_CheckBuffer(ob))
+        return 0;
+    if (PyObject_GetBuffer(ob, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) == -1)
+        return -1;
+    const char *fmt = view->format;
+    if (fmt && (*fmt == '@' || *fmt == '=' || *fmt == '<'))
+        fmt++;
+    // Untyped (byte) buffers are accepted as raw POINT data.
+    BOOL bOK = fmt == NULL || strcmp(fmt, "B") == 0 || strcmp(fmt, "b") == 0 ||
+               (view->itemsize == sizeof(LONG) && (strcmp(fmt, "i") == 0 || strcmp(fmt, "l") == 0));
+    if (!bOK) {
+        PyErr_Format(PyExc_TypeError, "POINT buffers must contain 32 bit integers, not '%s'", view->format);
+        PyBuffer_Release(view);
+        return -1;
+    }
+    if (view->len % sizeof(POINT) != 0) {
+        PyErr_Format(PyExc_ValueError, "POINT buffer length (%zd bytes) must be a multiple of %d", view->len,
+                     (int)sizeof(POINT));
+        PyBuffer_Release(view);
+        return -1;
+    }
+    if (view->len / sizeof(POINT) > MAXDWORD) {
+        PyErr_SetString(PyExc_ValueError, "POINT buffer is too large");
+        PyBuffer_Release(view);
+        return -1;
+    }
+    *item_cnt = (DWORD)(view->len / sizeof(POINT));
+    return 1;
+}
+
 // Return an IO_COUNTERS structure, used in win32process,i and win32job.i
 PyObject *PyWinObject_FromIO_COUNTERS(PIO_COUNTERS pioc)
 {
@@ -534,6 +572,21 @@ Accordingly, here is our own version.
 BOOL PyWinLong_AsVoidPtr(PyObject *ob, void **pptr)
 {
     assert(!PyErr_Occurred());  // lingering exception?
+#if (PY_VERSION_HEX >= 0x03000000)
+    // Fast path for the common case of an exact int that fits the signed range.
+    if (PyLong_CheckExact(ob)) {
+        int overflow;
+#ifdef _WIN64
+        LONG_PTR v = PyLong_AsLongLongAndOverflow(ob, &overflow);
+#else
+        LONG_PTR v = PyLong_AsLongAndOverflow(ob, &overflow);
+#endif
+        if (!overflow) {
+            *pptr = (void *)v;
+            return TRUE;
+        }
+    }
+#endif
                                 // PyInt_AsLong (and PyLong_AsLongLong on x64) handle objects
                                 // with tp_number slots, and longs that fit in 32bits - but *not*
                                 // longs that fit in 32bits if they are treated as unsigned - eg,
@@ -798,11 +851,17 @@ static struct PyMethodDef pywintypes_functions[] = {
      1},  // @pymeth IsTextUnicode|Determines whether a buffer probably contains a form of Unicode text.
 #endif
     {"OVERLAPPED", PyWinMethod_NewOVERLAPPED, 1},  // @pymeth OVERLAPPED|Creates a new <o PyOVERLAPPED> object
+    {"OVERLAPPEDPool", PyWinMethod_NewOVERLAPPEDPool,
+     1},  // @pymeth OVERLAPPEDPool|Creates a <o PyOVERLAPPEDPool> of preallocated <o PyOVERLAPPED> objects
 #ifndef NO_PYWINTYPES_IID
     {"IID", PyWinMethod_NewIID, 1},  // @pymeth IID|Makes an <o PyIID> object from a string.
+    {"ClearIIDCache", PyWinMethod_ClearIIDCache,
+     1},  // @pymeth ClearIIDCache|Discards the cached IID objects and string to IID conversions.
 #endif
     {"Time", PyWinMethod_NewTime, 1},            // @pymeth Time|Makes a <o PyDateTime> object from the argument.
     {"TimeStamp", PyWinMethod_NewTimeStamp, 1},  // @pymeth Time|Makes a <o PyDateTime> object from the argument.
+    {"FileTimesToEpoch", PyWinMethod_FileTimesToEpoch,
+     1},  // @pymeth FileTimesToEpoch|Converts an array of FILETIME values to seconds since 1970.
 #ifndef MS_WINCE
     {"CreateGuid", PyWin_CreateGuid, 1},  // @pymeth CreateGuid|Creates a new, unique GUIID.
 #endif                                    // MS_WINCE
@@ -923,14 +982,16 @@ int PyWinGlobals_Ensure()
         ??? All extension modules that call this need to be changed to check the exit code ???
     */
     if (PyType_Ready(&PyHANDLEType) == -1 || PyType_Ready(&PyOVERLAPPEDType) == -1 ||
+        PyType_Ready(&PyOVERLAPPEDPoolType) == -1 ||
         PyType_Ready(&PyDEVMODEAType) == -1 || PyType_Ready(&PyDEVMODEWType) == -1 ||
-        PyType_Ready(&PyWAVEFORMATEXType) == -1
+        PyType_Ready(&PyWAVEFORMATEXType) == -1 || PyType_Ready(&PyBSTRBufferType) == -1
 #ifndef NO_PYWINTYPES_IID
         || PyType_Ready(&PyIIDType) == -1
 #endif  // NO_PYWINTYPES_IID
 #ifndef NO_PYWINTYPES_SECURITY
         || PyType_Ready(&PySECURITY_DESCRIPTORType) == -1 || PyType_Ready(&PySECURITY_ATTRIBUTESType) == -1 ||
-        PyType_Ready(&PySIDType) == -1 || PyType_Ready(&PyACLType) == -1
+        PyType_Ready(&PySIDType) == -1 || PyType_Ready(&PyACLType) == -1 || PyType_Ready(&PyACEType) == -1 ||
+        PyType_Ready(&PyACE_ITERType) == -1
 #endif
     )
         return -1;
@@ -950,6 +1011,11 @@ void PyWinGlobals_Free()
 }
 
 static CRITICAL_SECTION g_csMain;
+#if !defined(NO_PYWINTYPES_IID) && !defined(MS_WINCE)
+// In PyIID.cpp
+extern void PyWinProgIDCache_Init(void);
+extern void PyWinProgIDCache_Free(void);
+#endif
 #ifdef _DEBUG
 static DWORD g_cGlobalLocks = 0;
 #endif
@@ -1013,6 +1079,7 @@ PYWIN_MODULE_INIT_FUNC(pywintypes)
 #endif
     ADD_TYPE(HANDLEType);
     ADD_TYPE(OVERLAPPEDType);
+    ADD_TYPE(OVERLAPPEDPoolType);
     ADD_TYPE(DEVMODEAType);
     ADD_TYPE(DEVMODEWType);
 #ifdef UNICODE
@@ -1023,6 +1090,7 @@ PYWIN_MODULE_INIT_FUNC(pywintypes)
         PYWIN_MODULE_INIT_RETURN_ERROR;
 
     ADD_TYPE(WAVEFORMATEXType);
+    ADD_TYPE(BSTRBufferType);
 
     PYWIN_MODULE_INIT_RETURN_SUCCESS;
 }
@@ -1103,11 +1171,17 @@ extern "C" __declspec(dllexport)
             ** could throw a C++ exception, but we don't care to trap that.
             */
             InitializeCriticalSection(&g_csMain);
+#if !defined(NO_PYWINTYPES_IID) && !defined(MS_WINCE)
+            PyWinProgIDCache_Init();
+#endif
             dwTlsIndex = TlsAlloc();
             break;
         }
         case DLL_PROCESS_DETACH: {
             DeleteCriticalSection(&g_csMain);
+#if !defined(NO_PYWINTYPES_IID) && !defined(MS_WINCE)
+            PyWinProgIDCache_Free();
+#endif
             TlsFree(dwTlsIndex);
 #ifdef _DEBUG
             if (g_cGlobalLocks) {
@@ -18,6 +18,9 @@
 #include "direct.h"
 #include "objbase.h"
 #include "tchar.h"
+#include "dbt.h"
+#include "winperf.h"
+#include "PerfMon/PyPerfMonControl.h"
 
 #ifdef PYSERVICE_BUILD_DLL
 #define PYSERVICE_EXPORT extern "C" __declspec(dllexport)
@@ -80,13 +83,100 @@ typedef SERVICE_STATUS_HANDLE(WINAPI *REGSVC_EX_FN)(LPCTSTR lpServiceName, LPHAN
 
 REGSVC_EX_FN g_RegisterServiceCtrlHandlerEx = NULL;
 
+// A control waiting to be delivered to Python, with a copy of its event data.
+typedef struct _PY_QUEUED_SERVICE_CTRL {
+    struct _PY_QUEUED_SERVICE_CTRL *pNext;
+    DWORD dwCtrlCode;
+    DWORD dwEventType;
+    LONGLONG qpcQueued;  // when the SCM delivered it, for the control time counter.
+    BOOL bHaveData;  // is data a copy of the event data?
+    BYTE data[1];
+} PY_QUEUED_SERVICE_CTRL;
+
+// Reports a pending state to the SCM from a native thread, advancing the
+// checkpoint until stopped or until dwMaxWait ms have passed.
+typedef struct {
+    SERVICE_STATUS_HANDLE ssh;
+    DWORD dwState;    // SERVICE_START_PENDING or SERVICE_STOP_PENDING
+    DWORD dwMaxWait;  // after this the SCM's own timeout applies.
+    HANDLE hDone;
+    HANDLE hThread;
+} PY_PENDING_REPORTER;
+
+// State for a service whose controls are queued by the SCM thread rather
+// than delivered to Python on it.
+typedef struct {
+    CRITICAL_SECTION cs;
+    HANDLE hReady;                     // manual reset, signalled while controls are queued.
+    BOOL bStopped;                     // set once SvcRun returns.
+    PY_PENDING_REPORTER stopReporter;  // reports stop progress to the SCM once stopping.
+    DWORD dwStopWait;                  // how long (ms) stop progress is reported for.
+    PY_QUEUED_SERVICE_CTRL *pHead;
+    PY_QUEUED_SERVICE_CTRL *pTail;
+} PY_SERVICE_CTRL_QUEUE;
+
+// The counters of the standard perfmon object published for a service whose
+// PythonClass key has a "Metrics" value, laid out as the PERF_COUNTER_BLOCK of
+// a perfmondata.dll mapping.  win32serviceutil.InstallServiceMetrics writes the
+// matching counter names, with the title offsets below.
+#define PYSERVICE_PERF_OBJECT 0
+#define PYSERVICE_PERF_CONTROL_REQUESTS 2
+#define PYSERVICE_PERF_CONTROL_TIME 4
+#define PYSERVICE_PERF_CONTROL_TIME_BASE 6
+#define PYSERVICE_PERF_GIL_WAIT 8
+#define PYSERVICE_PERF_ALLOCATED_BLOCKS 10
+#define PYSERVICE_PERF_THREADS 12
+#define PYSERVICE_PERF_REQUESTS 14
+
+typedef struct {
+    PERF_COUNTER_BLOCK CounterBlock;
+    DWORD ControlRequests;            // PERF_COUNTER_COUNTER
+    ULONGLONG ControlTime;            // PERF_AVERAGE_TIMER, performance counter ticks
+    DWORD ControlTimeBase;            // PERF_AVERAGE_BASE
+    DWORD GilWait;                    // microseconds the sampler last waited for the GIL
+    ULONGLONG AllocatedBlocks;        // sys.getallocatedblocks()
+    DWORD Threads;                    // Python thread states in the main interpreter
+    DWORD Requests;                   // PERF_COUNTER_COUNTER, from servicemanager.CountRequests
+} PY_SERVICE_COUNTERS;
+
+// How often (ms) the sampler thread measures the GIL, heap and threads.
+#define METRICS_SAMPLE_INTERVAL 1000
+
+// The mapping lives as long as the process, so the SCM thread can update the
+// counters without synchronizing with the service stopping.
+typedef struct {
+    HANDLE hMapping;
+    MappingManagerControlData *pControl;
+    PY_SERVICE_COUNTERS *pCounters;
+    HANDLE hStop;
+    HANDLE hThread;  // the sampler, while the service runs.
+} PY_SERVICE_METRICS;
+
 typedef struct {
     PyObject *klass;                        // The Python class we instantiate as the service.
     SERVICE_STATUS_HANDLE sshStatusHandle;  // the handle for this service.
     PyObject *obServiceCtrlHandler;         // The Python control handler for the service.
     BOOL bUseEx;                            // does this handler expect the extra args?
+    PY_SERVICE_CTRL_QUEUE *pQueue;          // non-NULL if controls are queued.
+    DWORD dwInterpreter;                    // PYS_INTERPRETER_* - where the service runs.
+    TCHAR *szClassString;                   // The class to load in a subinterpreter, or NULL.
+    BOOL bStarting;                         // still loading, before the instance has been created.
+    PY_SERVICE_METRICS *pMetrics;           // non-NULL if the service publishes metrics.
 } PY_SERVICE_TABLE_ENTRY;
 
+// Where a hosted service runs - the main interpreter, or a subinterpreter of its
+// own which shares the main GIL or (for Python 3.12 and later) has its own.
+#define PYS_INTERPRETER_MAIN 0
+#define PYS_INTERPRETER_SHARED_GIL 1
+#define PYS_INTERPRETER_OWN_GIL 2
+
+// The wait hint reported by a PY_PENDING_REPORTER; the checkpoint is advanced
+// twice per hint.
+#define PENDING_WAIT_HINT 5000
+// How long (ms) start progress is reported while the service's code is loaded,
+// unless the StartTimeout value under the service's PythonClass key says otherwise.
+#define DEFAULT_START_TIMEOUT 120000
+
 // Globals
 // Will be set to one of SERVICE_WIN32_OWN_PROCESS etc flags.
 DWORD g_serviceProcessFlags = 0;
@@ -108,10 +198,24 @@ VOID WINAPI service_ctrl(DWORD);
 BOOL RegisterPythonServiceExe(void);
 
 static PY_SERVICE_TABLE_ENTRY *FindPythonServiceEntry(LPCTSTR svcName);
+static PY_SERVICE_CTRL_QUEUE *CreateServiceCtrlQueue();
+static PyObject *ServiceClassString(PyObject *klass);
+static PyThreadState *NewServiceInterpreter(DWORD dwInterpreter);
+static void EndServiceInterpreter(PyThreadState *subState, PyThreadState *mainState, DWORD dwInterpreter);
+static DWORD callServiceCtrlHandler(DWORD dwCtrlCode, DWORD dwEventType, LPVOID eventData, PY_SERVICE_TABLE_ENTRY *pse);
 
-static PyObject *LoadPythonServiceClass(TCHAR *svcInitString);
+static PyObject *LoadPythonServiceClass(TCHAR *svcInitString, const TCHAR *szBundle = NULL);
 static PyObject *LoadPythonServiceInstance(PyObject *, DWORD dwArgc, LPTSTR *lpszArgv);
 static BOOL LocatePythonServiceClassString(TCHAR *svcName, TCHAR *buf, int cchBuf);
+static PyObject *LoadPythonServiceClassTimed(TCHAR *svcInitString, const TCHAR *szBundle, DWORD *pdwTime,
+                                             DWORD *pdwModules);
+static void LocatePythonServiceStartOptions(TCHAR *svcName, TCHAR *szBundle, int cchBundle, DWORD *pdwStartTimeout);
+static BOOL StartPendingReporter(PY_PENDING_REPORTER *pr, SERVICE_STATUS_HANDLE ssh, DWORD dwState, DWORD dwMaxWait);
+static void StopPendingReporter(PY_PENDING_REPORTER *pr);
+static PY_SERVICE_METRICS *CreateServiceMetrics(LPCTSTR svcName);
+static void StartServiceMetrics(PY_SERVICE_METRICS *pm);
+static void StopServiceMetrics(PY_SERVICE_METRICS *pm);
+static void RecordServiceCtrlTime(PY_SERVICE_TABLE_ENTRY *pse, LONGLONG qpcStart);
 
 // Some handy service statuses we can use without filling at runtime.
 SERVICE_STATUS neverStartedStatus = {SERVICE_WIN32_OWN_PROCESS,
@@ -167,6 +271,212 @@ SERVICE_STATUS stoppedErrorStatus = {SERVICE_WIN32_OWN_PROCESS,
 ///////////////////////////////////////////////////////////////////////
 static PyObject *servicemanager_startup_error;
 
+// The asynchronous event log writer (see <om servicemanager.SetAsyncLogging>).
+// Messages are pushed onto a lock-free SList by whoever logs them, and a
+// native thread drains the list every flush interval, writing the batch with
+// a single event source handle.  Consecutive identical messages are written
+// once, followed by a count of the repeats.
+typedef struct {
+    SLIST_ENTRY entry;  // must be first, and aligned to MEMORY_ALLOCATION_ALIGNMENT.
+    WORD wType;
+    DWORD dwCode;
+    WORD numInserts;
+    DWORD cchData;
+    TCHAR data[1];  // numInserts NULL terminated strings.
+} PY_LOG_RECORD;
+
+static SLIST_HEADER g_logList;
+static CRITICAL_SECTION g_csLogWrite;  // serializes draining, so batches are written in order.
+static BOOL g_bLogInit = FALSE;
+static HANDLE g_hLogThread = NULL;  // only changed with the GIL held.
+static HANDLE g_hLogWake = NULL;
+static volatile LONG g_bLogStop = FALSE;
+static DWORD g_dwLogFlushInterval = 0;
+static LONG g_logMaxQueued = 0;
+static volatile LONG g_logQueued = 0;
+static volatile LONG g_logDropped = 0;
+static PY_LOG_RECORD *g_logLast = NULL;  // the last record written, to detect repeats.
+static DWORD g_logRepeats = 0;
+
+static void InitLogWriter()
+{
+    if (g_bLogInit)
+        return;
+    InitializeSListHead(&g_logList);
+    InitializeCriticalSection(&g_csLogWrite);
+    g_bLogInit = TRUE;
+}
+
+static PY_LOG_RECORD *NewLogRecord(DWORD dwCode, LPCTSTR *inserts, WORD wType)
+{
+    WORD numInserts = 0;
+    DWORD cchData = 0;
+    while (inserts && inserts[numInserts] != NULL) cchData += (DWORD)_tcslen(inserts[numInserts++]) + 1;
+    PY_LOG_RECORD *pr = (PY_LOG_RECORD *)_aligned_malloc(sizeof(PY_LOG_RECORD) + cchData * sizeof(TCHAR),
+                                                         MEMORY_ALLOCATION_ALIGNMENT);
+    if (pr == NULL)
+        return NULL;
+    pr->wType = wType;
+    pr->dwCode = dwCode;
+    pr->numInserts = numInserts;
+    pr->cchData = cchData;
+    TCHAR *p = pr->data;
+    for (WORD i = 0; i < numInserts; i++) {
+        size_t cch = _tcslen(inserts[i]) + 1;
+        memcpy(p, inserts[i], cch * sizeof(TCHAR));
+        p += cch;
+    }
+    return pr;
+}
+
+static BOOL SameLogRecord(PY_LOG_RECORD *a, PY_LOG_RECORD *b)
+{
+    return a->wType == b->wType && a->dwCode == b->dwCode && a->numInserts == b->numInserts &&
+           a->cchData == b->cchData && memcmp(a->data, b->data, a->cchData * sizeof(TCHAR)) == 0;
+}
+
+static void WriteLogRecord(HANDLE hEventSource, PY_LOG_RECORD *pr)
+{
+    LPCTSTR *inserts = (LPCTSTR *)malloc((pr->numInserts + 1) * sizeof(LPCTSTR));
+    if (inserts == NULL)
+        return;
+    TCHAR *p = pr->data;
+    for (WORD i = 0; i < pr->numInserts; i++) {
+        inserts[i] = p;
+        p += _tcslen(p) + 1;
+    }
+    ReportEvent(hEventSource, pr->wType, 0, pr->dwCode, NULL, pr->numInserts, 0, inserts, NULL);
+    free(inserts);
+}
+
+// Writes one of our generic "%1" messages.
+static void WriteLogNotice(HANDLE hEventSource, WORD wType, LPCTSTR msg)
+{
+    DWORD dwCode = wType == EVENTLOG_ERROR_TYPE     ? PYS_E_GENERIC_ERROR
+                   : wType == EVENTLOG_WARNING_TYPE ? PYS_E_GENERIC_WARNING
+                                                    : MSG_IR1;
+    ReportEvent(hEventSource, wType, 0, dwCode, NULL, 1, 0, &msg, NULL);
+}
+
+static void WriteLogRepeats(HANDLE hEventSource)
+{
+    if (g_logRepeats == 0)
+        return;
+    TCHAR msg[80];
+    _sntprintf(msg, sizeof(msg) / sizeof(msg[0]), _T("The previous message was repeated %lu more times"),
+               g_logRepeats);
+    msg[sizeof(msg) / sizeof(msg[0]) - 1] = _T('\0');
+    WriteLogNotice(hEventSource, g_logLast->wType, msg);
+    g_logRepeats = 0;
+}
+
+// Writes everything queued so far.  Never needs the GIL.
+static void FlushLogRecords()
+{
+    if (!g_bLogInit)
+        return;
+    EnterCriticalSection(&g_csLogWrite);
+    // The SList is LIFO - reverse what we took to restore the order it was logged in.
+    SLIST_ENTRY *pe = InterlockedFlushSList(&g_logList), *pFifo = NULL;
+    while (pe) {
+        SLIST_ENTRY *pNext = pe->Next;
+        pe->Next = pFifo;
+        pFifo = pe;
+        pe = pNext;
+    }
+    LONG dropped = InterlockedExchange(&g_logDropped, 0);
+    if (pFifo || dropped || g_logRepeats) {
+        CheckRegisterEventSourceFile();
+        HANDLE hEventSource = RegisterEventSource(NULL, g_szEventSourceName);
+        while (pFifo) {
+            PY_LOG_RECORD *pr = (PY_LOG_RECORD *)pFifo;
+            pFifo = pFifo->Next;
+            InterlockedDecrement(&g_logQueued);
+            if (g_logLast && SameLogRecord(g_logLast, pr)) {
+                g_logRepeats++;
+                _aligned_free(pr);
+                continue;
+            }
+            if (hEventSource) {
+                WriteLogRepeats(hEventSource);
+                WriteLogRecord(hEventSource, pr);
+            }
+            g_logRepeats = 0;
+            if (g_logLast)
+                _aligned_free(g_logLast);
+            g_logLast = pr;
+        }
+        if (hEventSource) {
+            // Repeats are reported at the end of each batch, so a message logged in a loop
+            // costs at most two events per flush interval.
+            WriteLogRepeats(hEventSource);
+            if (dropped) {
+                TCHAR msg[80];
+                _sntprintf(msg, sizeof(msg) / sizeof(msg[0]),
+                           _T("%ld messages were discarded as the log queue was full"), dropped);
+                msg[sizeof(msg) / sizeof(msg[0]) - 1] = _T('\0');
+                WriteLogNotice(hEventSource, EVENTLOG_WARNING_TYPE, msg);
+            }
+            DeregisterEventSource(hEventSource);
+        }
+        g_logRepeats = 0;
+    }
+    LeaveCriticalSection(&g_csLogWrite);
+}
+
+static DWORD WINAPI logWriterThread(LPVOID)
+{
+    while (!g_bLogStop) {
+        WaitForSingleObject(g_hLogWake, g_dwLogFlushInterval);
+        FlushLogRecords();
+    }
+    FlushLogRecords();
+    return 0;
+}
+
+// Stops the writer, writing anything still queued.  GIL held.
+static void StopLogWriter()
+{
+    HANDLE hThread = g_hLogThread;
+    if (hThread == NULL)
+        return;
+    // New messages are written synchronously from here on.
+    g_hLogThread = NULL;
+    Py_BEGIN_ALLOW_THREADS InterlockedExchange(&g_bLogStop, TRUE);
+    SetEvent(g_hLogWake);
+    WaitForSingleObject(hThread, INFINITE);
+    Py_END_ALLOW_THREADS CloseHandle(hThread);
+    CloseHandle(g_hLogWake);
+    g_hLogWake = NULL;
+}
+
+// Logs a message, queueing it for the writer thread if there is one.  GIL held.
+static BOOL LogMessage(DWORD code, LPCTSTR *inserts, WORD errorType)
+{
+    if (g_hLogThread && !bServiceDebug) {
+        LONG queued = InterlockedIncrement(&g_logQueued);
+        if (queued > g_logMaxQueued) {
+            InterlockedDecrement(&g_logQueued);
+            InterlockedIncrement(&g_logDropped);
+            return TRUE;
+        }
+        PY_LOG_RECORD *pr = NewLogRecord(code, inserts, errorType);
+        if (pr == NULL) {
+            InterlockedDecrement(&g_logQueued);
+            SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+            return FALSE;
+        }
+        InterlockedPushEntrySList(&g_logList, &pr->entry);
+        // Don't wait for the timer once the queue is half full.
+        if (queued == g_logMaxQueued / 2)
+            SetEvent(g_hLogWake);
+        return TRUE;
+    }
+    BOOL ok;
+    Py_BEGIN_ALLOW_THREADS ok = ReportError(code, inserts, errorType);
+    Py_END_ALLOW_THREADS return ok;
+}
+
 static PyObject *DoLogMessage(WORD errorType, PyObject *obMsg)
 {
     WCHAR *msg;
@@ -174,10 +484,10 @@ static PyObject *DoLogMessage(WORD errorType, PyObject *obMsg)
         return NULL;
     DWORD errorCode = errorType == EVENTLOG_ERROR_TYPE ? PYS_E_GENERIC_ERROR : PYS_E_GENERIC_WARNING;
     LPCTSTR inserts[] = {msg, NULL};
-    BOOL ok;
-    Py_BEGIN_ALLOW_THREADS ok = ReportError(errorCode, inserts, errorType);
+    BOOL ok = LogMessage(errorCode, inserts, errorType);
     PyWinObject_FreeWCHAR(msg);
-    Py_END_ALLOW_THREADS if (!ok) return PyWin_SetAPIError("RegisterEventSource/ReportEvent");
+    if (!ok)
+        return PyWin_SetAPIError("RegisterEventSource/ReportEvent");
     Py_INCREF(Py_None);
     return Py_None;
 }
@@ -225,13 +535,13 @@ static PyObject *PyLogMsg(PyObject *self, PyObject *args)
         PyErr_SetString(PyExc_TypeError, "strings must be None or a sequence");
         goto cleanup;
     }
-    Py_BEGIN_ALLOW_THREADS ok = ReportError(code, pStrings, errorType);
-    Py_END_ALLOW_THREADS if (ok)
-    {
+    ok = LogMessage(code, pStrings, errorType);
+    if (ok) {
         Py_INCREF(Py_None);
         rc = Py_None;
     }
-    else PyWin_SetAPIError("RegisterEventSource/ReportEvent");
+    else
+        PyWin_SetAPIError("RegisterEventSource/ReportEvent");
 
 cleanup:
     if (pStrings) {
@@ -271,6 +581,63 @@ static PyObject *PyLogErrorMsg(PyObject *self, PyObject *args)
     return DoLogMessage(EVENTLOG_ERROR_TYPE, obMsg);
 }
 
+// @pymethod |servicemanager|SetAsyncLogging|Writes logged messages to the event log from a background thread.
+static PyObject *PySetAsyncLogging(PyObject *self, PyObject *args)
+{
+    DWORD dwFlushInterval = 500;
+    long maxQueued = 4096;
+    // @pyparm int|flushInterval|500|How often, in milliseconds, queued messages are written.  Zero
+    // writes anything queued, then returns to writing each message as it is logged.
+    // @pyparm int|maxQueued|4096|The most messages which may be waiting to be written.  Beyond this
+    // messages are discarded, and a count of those discarded is written in their place.
+    if (!PyArg_ParseTuple(args, "|kl:SetAsyncLogging", &dwFlushInterval, &maxQueued))
+        return NULL;
+    if (maxQueued < 1) {
+        PyErr_SetString(PyExc_ValueError, "maxQueued must be at least 1");
+        return NULL;
+    }
+    // @comm Once enabled, <om servicemanager.LogMsg>, <om servicemanager.LogInfoMsg>,
+    // <om servicemanager.LogWarningMsg> and <om servicemanager.LogErrorMsg> only queue the message,
+    // so they never wait on the event log, and no longer raise an exception if it can't be written.
+    // A message repeated consecutively is written once, followed by a message giving the number of
+    // repeats.
+    // <nl>Messages queued when a service stops are written before it reports SERVICE_STOPPED.
+    // Use <om servicemanager.FlushLog> to have them written at any other time.
+    // Messages are written synchronously as before while debugging.
+    StopLogWriter();
+    if (dwFlushInterval) {
+        InitLogWriter();
+        g_dwLogFlushInterval = dwFlushInterval;
+        g_logMaxQueued = maxQueued;
+        g_bLogStop = FALSE;
+        g_hLogWake = CreateEvent(NULL, FALSE, FALSE, NULL);
+        if (g_hLogWake == NULL)
+            return PyWin_SetAPIError("CreateEvent");
+        DWORD tid;
+        g_hLogThread = CreateThread(NULL, 0, logWriterThread, NULL, 0, &tid);
+        if (g_hLogThread == NULL) {
+            PyWin_SetAPIError("CreateThread");
+            CloseHandle(g_hLogWake);
+            g_hLogWake = NULL;
+            return NULL;
+        }
+    }
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod |servicemanager|FlushLog|Writes any messages queued by the asynchronous logger.
+static PyObject *PyFlushLog(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":FlushLog"))
+        return NULL;
+    // @comm Returns once the messages have been written.  Does nothing unless
+    // <om servicemanager.SetAsyncLogging> has been called.
+    Py_BEGIN_ALLOW_THREADS FlushLogRecords();
+    Py_END_ALLOW_THREADS Py_INCREF(Py_None);
+    return Py_None;
+}
+
 // @pymethod |servicemanager|SetEventSourceName|Sets the event source name
 // for event log entries written by the service.
 static PyObject *PySetEventSourceName(PyObject *self, PyObject *args)
@@ -306,13 +673,27 @@ static PyObject *PyRegisterServiceCtrlHandler(PyObject *self, PyObject *args)
 {
     PyObject *nameOb, *obCallback;
     BOOL bUseEx = FALSE;
+    BOOL bQueued = FALSE;
+    DWORD dwStopWait = 30000;
     // @pyparm <o PyUnicode>|serviceName||The name of the service.  This is provided in args[0] of the service class
     // __init__ method.
     // @pyparm object|callback||The Python function that performs as the control function.  This will be called with an
     // integer status argument.
     // @pyparm bool|extra_args|False|Is this callback expecting the additional 2 args passed by HandlerEx?
-    if (!PyArg_ParseTuple(args, "OO|i", &nameOb, &obCallback, &bUseEx))
+    // @pyparm bool|queued|False|If True, controls are not delivered to the callback on the SCM's thread.  Instead
+    // they are queued, and the SCM is answered immediately - see <om servicemanager.DispatchQueuedControls>.
+    // @pyparm int|stop_wait|30000|When controls are queued, the number of milliseconds for which a stop
+    // or shutdown request is reported to the SCM as progressing while Python handles it.
+    if (!PyArg_ParseTuple(args, "OO|iik", &nameOb, &obCallback, &bUseEx, &bQueued, &dwStopWait))
         return NULL;
+    // @comm When controls are queued, a stop or shutdown request is reported to the SCM as
+    // SERVICE_STOP_PENDING as soon as it arrives, and the checkpoint is advanced by a native thread,
+    // without the GIL, until SvcRun returns or stop_wait has elapsed.  So the SCM is never kept waiting
+    // by busy Python code, but the service must stop in a bounded time.
+    // SERVICE_CONTROL_INTERROGATE is answered without involving Python, and the result of the callback
+    // is ignored, so device queries can't be denied.
+    // <nl>Services running in a subinterpreter (see <om servicemanager.SetServiceInterpreter>) must
+    // queue their controls.
     if (!PyCallable_Check(obCallback)) {
         PyErr_SetString(PyExc_TypeError, "Second argument must be a callable object");
         return NULL;
@@ -326,6 +707,25 @@ static PyObject *PyRegisterServiceCtrlHandler(PyObject *self, PyObject *args)
         PyWinObject_FreeWCHAR(szName);
         return NULL;
     }
+    if (pe->dwInterpreter != PYS_INTERPRETER_MAIN && !bQueued) {
+        PyErr_SetString(PyExc_ValueError, "The controls of a service in a subinterpreter must be queued");
+        PyWinObject_FreeWCHAR(szName);
+        return NULL;
+    }
+    if (bQueued) {
+        if (pe->pQueue == NULL && (pe->pQueue = CreateServiceCtrlQueue()) == NULL) {
+            PyWin_SetAPIError("CreateEvent");
+            PyWinObject_FreeWCHAR(szName);
+            return NULL;
+        }
+        pe->pQueue->dwStopWait = dwStopWait;
+        pe->pQueue->bStopped = FALSE;
+    }
+    else if (pe->pQueue) {
+        PyErr_SetString(PyExc_ValueError, "The controls of this service are already queued");
+        PyWinObject_FreeWCHAR(szName);
+        return NULL;
+    }
     Py_XDECREF(pe->obServiceCtrlHandler);
     pe->obServiceCtrlHandler = obCallback;
     pe->bUseEx = bUseEx;
@@ -334,13 +734,17 @@ static PyObject *PyRegisterServiceCtrlHandler(PyObject *self, PyObject *args)
         Py_INCREF(Py_None);
         return Py_None;
     }
-    if (g_RegisterServiceCtrlHandlerEx) {
-        // Use 2K/XP extended registration if available
-        pe->sshStatusHandle = g_RegisterServiceCtrlHandlerEx(szName, service_ctrl_ex, pe);
-    }
-    else {
-        // Otherwise fall back to NT
-        pe->sshStatusHandle = RegisterServiceCtrlHandler(szName, service_ctrl);
+    // service_main normally registers our handler before loading the service, so the
+    // handle is reused.
+    if (pe->sshStatusHandle == 0) {
+        if (g_RegisterServiceCtrlHandlerEx) {
+            // Use 2K/XP extended registration if available
+            pe->sshStatusHandle = g_RegisterServiceCtrlHandlerEx(szName, service_ctrl_ex, pe);
+        }
+        else {
+            // Otherwise fall back to NT
+            pe->sshStatusHandle = RegisterServiceCtrlHandler(szName, service_ctrl);
+        }
     }
     PyWinObject_FreeWCHAR(szName);
     PyObject *rc;
@@ -357,6 +761,189 @@ static PyObject *PyRegisterServiceCtrlHandler(PyObject *self, PyObject *args)
     // there is no service control manager handle, otherwise the handle to the Win32 service manager.
 }
 
+// @pymethod |servicemanager|SetServiceInterpreter|Nominates the interpreter a hosted service runs in.
+static PyObject *PySetServiceInterpreter(PyObject *self, PyObject *args)
+{
+    PyObject *nameOb;
+    DWORD dwInterpreter;
+    // @pyparm <o PyUnicode>|serviceName||The name of a service prepared with <om servicemanager.PrepareToHostSingle>
+    // or <om servicemanager.PrepareToHostMultiple>.
+    // @pyparm int|interpreter||One of the PYS_INTERPRETER_* constants.
+    if (!PyArg_ParseTuple(args, "Ok:SetServiceInterpreter", &nameOb, &dwInterpreter))
+        return NULL;
+    // @comm Must be called before <om servicemanager.StartServiceCtrlDispatcher>.  With
+    // PYS_INTERPRETER_SHARED_GIL or PYS_INTERPRETER_OWN_GIL the service's class is imported, and
+    // the service run, in a new subinterpreter which ends when the service stops.  The service's
+    // controls must be queued - <o win32serviceutil.ServiceFramework> does this automatically.
+    // <nl>PYS_INTERPRETER_OWN_GIL needs Python 3.12 or later, and lets CPU bound services hosted in
+    // the same process run in parallel.  Only extension modules supporting a per-interpreter GIL
+    // can be imported in such an interpreter.
+    if (dwInterpreter > PYS_INTERPRETER_OWN_GIL)
+        return PyErr_Format(PyExc_ValueError, "Invalid interpreter type %lu", dwInterpreter);
+#if (PY_VERSION_HEX < 0x030C0000)
+    if (dwInterpreter == PYS_INTERPRETER_OWN_GIL) {
+        PyErr_SetString(PyExc_NotImplementedError, "A per-interpreter GIL needs Python 3.12 or later");
+        return NULL;
+    }
+#endif
+    WCHAR *szName;
+    if (!PyWinObject_AsWCHAR(nameOb, &szName))
+        return NULL;
+    PY_SERVICE_TABLE_ENTRY *pe = FindPythonServiceEntry(szName);
+    PyWinObject_FreeWCHAR(szName);
+    if (pe == NULL) {
+        PyErr_SetString(PyExc_ValueError, "The service name is not hosted by this process");
+        return NULL;
+    }
+    TCHAR *szClassString = NULL;
+    if (dwInterpreter != PYS_INTERPRETER_MAIN && pe->klass) {
+        // The class object can't cross interpreters, so it is located again by name.
+        PyObject *obClassString = ServiceClassString(pe->klass);
+        if (obClassString == NULL)
+            return NULL;
+        BOOL ok = PyWinObject_AsTCHAR(obClassString, &szClassString, FALSE);
+        Py_DECREF(obClassString);
+        if (!ok)
+            return NULL;
+    }
+    if (pe->szClassString)
+        PyWinObject_FreeTCHAR(pe->szClassString);
+    pe->szClassString = szClassString;
+    pe->dwInterpreter = dwInterpreter;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod int|servicemanager|GetServiceInterpreter|Returns the type of interpreter a hosted service runs in.
+static PyObject *PyGetServiceInterpreter(PyObject *self, PyObject *args)
+{
+    PyObject *nameOb;
+    // @pyparm <o PyUnicode>|serviceName||The name of the service.
+    if (!PyArg_ParseTuple(args, "O:GetServiceInterpreter", &nameOb))
+        return NULL;
+    WCHAR *szName;
+    if (!PyWinObject_AsWCHAR(nameOb, &szName))
+        return NULL;
+    PY_SERVICE_TABLE_ENTRY *pe = FindPythonServiceEntry(szName);
+    PyWinObject_FreeWCHAR(szName);
+    if (pe == NULL) {
+        PyErr_SetString(PyExc_ValueError, "The service name is not hosted by this process");
+        return NULL;
+    }
+    return PyInt_FromLong(pe->dwInterpreter);
+    // @rdesc One of the PYS_INTERPRETER_* constants.
+}
+
+// Locates the entry for a service whose controls are queued, setting a Python
+// exception if there is none.
+static PY_SERVICE_TABLE_ENTRY *FindQueuedServiceEntry(PyObject *nameOb)
+{
+    WCHAR *szName;
+    if (!PyWinObject_AsWCHAR(nameOb, &szName))
+        return NULL;
+    PY_SERVICE_TABLE_ENTRY *pe = FindPythonServiceEntry(szName);
+    PyWinObject_FreeWCHAR(szName);
+    if (pe == NULL) {
+        PyErr_SetString(PyExc_ValueError, "The service name is not hosted by this process");
+        return NULL;
+    }
+    if (pe->pQueue == NULL) {
+        PyErr_SetString(PyExc_ValueError, "The controls of this service are not queued");
+        return NULL;
+    }
+    return pe;
+}
+
+// @pymethod int|servicemanager|GetQueuedControlEvent|Returns an event which is signalled while controls are
+// queued for a service.
+static PyObject *PyGetQueuedControlEvent(PyObject *self, PyObject *args)
+{
+    PyObject *nameOb;
+    // @pyparm <o PyUnicode>|serviceName||The name of the service, which must have registered its control
+    // handler with queued=True.
+    if (!PyArg_ParseTuple(args, "O:GetQueuedControlEvent", &nameOb))
+        return NULL;
+    PY_SERVICE_TABLE_ENTRY *pe = FindQueuedServiceEntry(nameOb);
+    if (pe == NULL)
+        return NULL;
+    return PyWinLong_FromHANDLE(pe->pQueue->hReady);
+    // @rdesc The handle remains owned by servicemanager, and must not be closed.  It can be
+    // passed to the wait functions in <o win32event>.
+}
+
+// @pymethod int|servicemanager|DispatchQueuedControls|Calls the control handler of a service for each control
+// queued for it.
+static PyObject *PyDispatchQueuedControls(PyObject *self, PyObject *args)
+{
+    PyObject *nameOb;
+    // @pyparm <o PyUnicode>|serviceName||The name of the service, which must have registered its control
+    // handler with queued=True.
+    if (!PyArg_ParseTuple(args, "O:DispatchQueuedControls", &nameOb))
+        return NULL;
+    PY_SERVICE_TABLE_ENTRY *pe = FindQueuedServiceEntry(nameOb);
+    if (pe == NULL)
+        return NULL;
+    PY_SERVICE_CTRL_QUEUE *pq = pe->pQueue;
+    long count = 0;
+    for (;;) {
+        EnterCriticalSection(&pq->cs);
+        PY_QUEUED_SERVICE_CTRL *pc = pq->pHead;
+        if (pc) {
+            pq->pHead = pc->pNext;
+            if (pq->pHead == NULL)
+                pq->pTail = NULL;
+        }
+        if (pq->pHead == NULL)
+            ResetEvent(pq->hReady);
+        LeaveCriticalSection(&pq->cs);
+        if (pc == NULL)
+            break;
+        // The SCM has already been answered, so the result is not used; exceptions are
+        // reported to the event log as usual.
+        if (pe->obServiceCtrlHandler)
+            callServiceCtrlHandler(pc->dwCtrlCode, pc->dwEventType, pc->bHaveData ? pc->data : NULL, pe);
+        RecordServiceCtrlTime(pe, pc->qpcQueued);
+        free(pc);
+        count++;
+    }
+    return PyInt_FromLong(count);
+    // @rdesc The number of controls dispatched.
+    // @comm The controls are delivered on the calling thread, in the order they arrived.  A service
+    // typically dedicates a thread to waiting on <om servicemanager.GetQueuedControlEvent> and calling this.
+}
+
+// @pymethod |servicemanager|CountRequests|Adds to the "Requests/sec" counter of the service's
+// standard perfmon object.
+static PyObject *PyCountRequests(PyObject *self, PyObject *args)
+{
+    long count = 1;
+    PyObject *nameOb = Py_None;
+    // @pyparm int|count|1|The number of requests handled.
+    // @pyparm <o PyUnicode>|serviceName|None|The name of the service, or None if the process hosts a single service.
+    if (!PyArg_ParseTuple(args, "|lO:CountRequests", &count, &nameOb))
+        return NULL;
+    PY_SERVICE_TABLE_ENTRY *pe = PythonServiceTable;
+    if (nameOb != Py_None) {
+        WCHAR *szName;
+        if (!PyWinObject_AsWCHAR(nameOb, &szName))
+            return NULL;
+        pe = FindPythonServiceEntry(szName);
+        PyWinObject_FreeWCHAR(szName);
+        if (pe == NULL) {
+            PyErr_SetString(PyExc_ValueError, "The service name is not hosted by this process");
+            return NULL;
+        }
+    }
+    if (pe->pMetrics)
+        InterlockedExchangeAdd((LONG volatile *)&pe->pMetrics->pCounters->Requests, count);
+    Py_INCREF(Py_None);
+    return Py_None;
+    // @comm The other counters of the object - control requests and their latency, the time taken to
+    // acquire the GIL, Python's allocated blocks and its threads - are maintained by the host without
+    // any Python code.  The object is only published for services installed with
+    // win32serviceutil.InstallServiceMetrics (or the --metrics install option); otherwise this does nothing.
+}
+
 // @pymethod |servicemanager|CoInitializeEx|Initialize OLE with additional options.
 static PyObject *PyCoInitializeEx(PyObject *self, PyObject *args)
 {
@@ -514,10 +1101,23 @@ static struct PyMethodDef servicemanager_functions[] = {
     {"CoUninitialize", PyCoUninitialize, 1},  // @pymeth CoUninitialize|
     {"RegisterServiceCtrlHandler", PyRegisterServiceCtrlHandler,
      1},  // @pymeth RegisterServiceCtrlHandler|Registers a function to retrieve service control notification messages.
+    {"GetQueuedControlEvent", PyGetQueuedControlEvent,
+     1},  // @pymeth GetQueuedControlEvent|Returns an event which is signalled while controls are queued for a service.
+    {"DispatchQueuedControls", PyDispatchQueuedControls,
+     1},  // @pymeth DispatchQueuedControls|Calls the control handler of a service for each control queued for it.
+    {"CountRequests", PyCountRequests,
+     1},  // @pymeth CountRequests|Adds to the requests counter of the service's standard perfmon object.
+    {"SetServiceInterpreter", PySetServiceInterpreter,
+     1},  // @pymeth SetServiceInterpreter|Nominates the interpreter a hosted service runs in.
+    {"GetServiceInterpreter", PyGetServiceInterpreter,
+     1},  // @pymeth GetServiceInterpreter|Returns the type of interpreter a hosted service runs in.
     {"LogMsg", PyLogMsg, 1},                // @pymeth LogMsg|Write an specific message to the log.
     {"LogInfoMsg", PyLogInfoMsg, 1},        // @pymeth LogInfoMsg|Write an informational message to the log.
     {"LogErrorMsg", PyLogErrorMsg, 1},      // @pymeth LogErrorMsg|Write an error message to the log.
     {"LogWarningMsg", PyLogWarningMsg, 1},  // @pymeth LogWarningMsg|Logs a generic warning message to the event log
+    {"SetAsyncLogging", PySetAsyncLogging,
+     1},  // @pymeth SetAsyncLogging|Writes logged messages to the event log from a background thread.
+    {"FlushLog", PyFlushLog, 1},  // @pymeth FlushLog|Writes any messages queued by the asynchronous logger.
     {"PumpWaitingMessages", PyPumpWaitingMessages,
      1},                            // @pymeth PumpWaitingMessages|Pumps waiting window messages for the service.
     {"Debugging", PyDebugging, 1},  // @pymeth Debugging|Indicates if the service is running in debug mode.
@@ -559,6 +1159,10 @@ PYWIN_MODULE_INIT_FUNC(servicemanager)
     ADD_CONSTANT(PYS_SERVICE_STOPPING);
     ADD_CONSTANT(PYS_SERVICE_STOPPED);
 
+    ADD_CONSTANT(PYS_INTERPRETER_MAIN);
+    ADD_CONSTANT(PYS_INTERPRETER_SHARED_GIL);
+    ADD_CONSTANT(PYS_INTERPRETER_OWN_GIL);
+
     ADD_CONSTANT(EVENTLOG_ERROR_TYPE);
     ADD_CONSTANT(EVENTLOG_INFORMATION_TYPE);
     ADD_CONSTANT(EVENTLOG_WARNING_TYPE);
@@ -684,6 +1288,7 @@ BOOL PythonService_Initialize(const TCHAR *evtsrc_name, const TCHAR *evtsrc_file
 //  PURPOSE: Finalize our service hosting framework
 void PythonService_Finalize()
 {
+    StopLogWriter();
     UINT i;
     for (i = 0; i < MAX_SERVICES; i++) {
         if (DispatchTable[i].lpServiceName == NULL)
@@ -725,6 +1330,10 @@ BOOL PythonService_PrepareToHostSingle(PyObject *klass)
     PythonServiceTable[0].sshStatusHandle = 0;
     PythonServiceTable[0].obServiceCtrlHandler = NULL;
     PythonServiceTable[0].bUseEx = 0;
+    PythonServiceTable[0].pQueue = NULL;
+    PythonServiceTable[0].dwInterpreter = PYS_INTERPRETER_MAIN;
+    PythonServiceTable[0].szClassString = NULL;
+    PythonServiceTable[0].bStarting = FALSE;
     return TRUE;
 }
 
@@ -769,6 +1378,10 @@ BOOL PythonService_PrepareToHostMultiple(const TCHAR *service_name, PyObject *kl
     PythonServiceTable[i].sshStatusHandle = 0;
     PythonServiceTable[i].obServiceCtrlHandler = NULL;
     PythonServiceTable[i].bUseEx = 0;
+    PythonServiceTable[i].pQueue = NULL;
+    PythonServiceTable[i].dwInterpreter = PYS_INTERPRETER_MAIN;
+    PythonServiceTable[i].szClassString = NULL;
+    PythonServiceTable[i].bStarting = FALSE;
     return TRUE;
 }
 
@@ -837,23 +1450,26 @@ void WINAPI service_main(DWORD dwArgc, LPTSTR *lpszArgv)
     if (bServiceDebug)
         SetConsoleCtrlHandler(DebugControlHandler, TRUE);
 
-    // NOTE: If possible, we want to always call RegisterServiceCtrlHandlerEx,
-    // even in error situations.  Otherwise Windows will get a little upset
-    // and turn us into a zombie.  Grabbing the service handle and reporting
-    // an error condition works correctly, whereas exiting doesn't.
-    // Note also that in the usual, non-error case,
-    // RegisterServiceCtrlHandlerEx is actually called via the Python code
-    // (servicemanager.RegisterServiceCtrlHandler), not via us.
+    // NOTE: We always call RegisterServiceCtrlHandlerEx before loading any
+    // Python code, so the SCM sees start progress while imports run and so
+    // we can report an error rather than turn into a zombie if they fail.
+    // Grabbing the service handle and reporting an error condition works
+    // correctly, whereas exiting doesn't.  The Python code's own call to
+    // servicemanager.RegisterServiceCtrlHandler just installs its handler.
     CEnterLeavePython _celp;
     PY_SERVICE_TABLE_ENTRY *pe;
-    if (g_serviceProcessFlags == SERVICE_WIN32_OWN_PROCESS) {
+    // A service in a subinterpreter loads its own copy of its class.
+    PyThreadState *mainState = NULL, *subState = NULL;
+    PyObject *klass = NULL;
+    PY_PENDING_REPORTER startReporter = {0};
+    TCHAR szBundle[MAX_PATH];
+    DWORD dwStartTimeout = DEFAULT_START_TIMEOUT;
+    DWORD dwStartTick = GetTickCount(), dwInstanceTick = 0;
+    DWORD dwImportTime = 0, dwModulesLoaded = 0;
+    BOOL bLoadedClass = FALSE;
+    szBundle[0] = _T('\0');
+    if (g_serviceProcessFlags == SERVICE_WIN32_OWN_PROCESS)
         pe = PythonServiceTable;
-        if (!pe->klass) {
-            TCHAR svcInitBuf[256];
-            LocatePythonServiceClassString(lpszArgv[0], svcInitBuf, sizeof(svcInitBuf) / sizeof(svcInitBuf[0]));
-            pe->klass = LoadPythonServiceClass(svcInitBuf);
-        }
-    }
     else
         pe = FindPythonServiceEntry(lpszArgv[0]);
     if (!pe) {
@@ -864,22 +1480,63 @@ void WINAPI service_main(DWORD dwArgc, LPTSTR *lpszArgv)
         goto cleanup;
     }
     assert(pe->sshStatusHandle == 0);  // should have no scm handle yet.
-    if (pe->klass)                     // avoid an extra redundant log message.
-        instance = LoadPythonServiceInstance(pe->klass, dwArgc, lpszArgv);
-    // If Python has not yet registered the service control handler, then
+    LocatePythonServiceStartOptions(lpszArgv[0], szBundle, sizeof(szBundle) / sizeof(szBundle[0]), &dwStartTimeout);
+    if (pe->pMetrics == NULL)
+        pe->pMetrics = CreateServiceMetrics(lpszArgv[0]);
+    if (pe->pMetrics)
+        StartServiceMetrics(pe->pMetrics);
+    pe->bStarting = TRUE;
+    if (!bServiceDebug) {
+        if (g_RegisterServiceCtrlHandlerEx)
+            pe->sshStatusHandle = g_RegisterServiceCtrlHandlerEx(lpszArgv[0], service_ctrl_ex, pe);
+        else
+            pe->sshStatusHandle = RegisterServiceCtrlHandler(lpszArgv[0], service_ctrl);
+        if (pe->sshStatusHandle)
+            StartPendingReporter(&startReporter, pe->sshStatusHandle, SERVICE_START_PENDING, dwStartTimeout);
+    }
+    if (pe->dwInterpreter != PYS_INTERPRETER_MAIN) {
+        TCHAR svcInitBuf[256];
+        TCHAR *szClassString = pe->szClassString;
+        if (szClassString == NULL) {
+            LocatePythonServiceClassString(lpszArgv[0], svcInitBuf, sizeof(svcInitBuf) / sizeof(svcInitBuf[0]));
+            szClassString = svcInitBuf;
+        }
+        mainState = PyThreadState_Get();
+        subState = NewServiceInterpreter(pe->dwInterpreter);
+        if (subState)
+            klass = LoadPythonServiceClassTimed(szClassString, szBundle, &dwImportTime, &dwModulesLoaded);
+        bLoadedClass = TRUE;
+    }
+    else if (g_serviceProcessFlags == SERVICE_WIN32_OWN_PROCESS && !pe->klass) {
+        TCHAR svcInitBuf[256];
+        LocatePythonServiceClassString(lpszArgv[0], svcInitBuf, sizeof(svcInitBuf) / sizeof(svcInitBuf[0]));
+        pe->klass = LoadPythonServiceClassTimed(svcInitBuf, szBundle, &dwImportTime, &dwModulesLoaded);
+        bLoadedClass = TRUE;
+    }
+    if (pe->dwInterpreter == PYS_INTERPRETER_MAIN) {
+        klass = pe->klass;
+        Py_XINCREF(klass);
+    }
+    dwInstanceTick = GetTickCount();
+    if (klass)  // avoid an extra redundant log message.
+        instance = LoadPythonServiceInstance(klass, dwArgc, lpszArgv);
+    dwInstanceTick = GetTickCount() - dwInstanceTick;
+    // Loading is over - from here the Python code reports its own progress.
+    Py_BEGIN_ALLOW_THREADS StopPendingReporter(&startReporter);
+    Py_END_ALLOW_THREADS pe->bStarting = FALSE;
+    // If Python has not registered the service control handler, then
     // we are in serious trouble - it is likely the service will enter a
     // zombie state, where it wont do anything, but you can not start
-    // another.  Therefore, we still create register the handler, thereby
-    // getting a handle, so we can immediately tell Windows the service
-    // is rooted (that is a technical term!)
+    // another.
+    // If we have an instance, it means that instance simply neglected
+    // to do the right thing - report that as an error.
+    // else no instance - an error has already been reported.
+    if (instance && !bServiceDebug && pe->obServiceCtrlHandler == NULL)
+        ReportPythonError(E_PYS_NOT_CONTROL_HANDLER);
+    // If our own registration failed, try again, thereby getting a handle,
+    // so we can immediately tell Windows the service is rooted (that is a
+    // technical term!)
     if (!bServiceDebug && pe->sshStatusHandle == 0) {
-        // If we don't have a pe->sshStatusHandle(), then the Python code
-        // failed to register itself with the SCM.
-        // If we have an instance, it means that instance simply neglected
-        // to do the right thing - report that as an error.
-        if (instance)
-            ReportPythonError(E_PYS_NOT_CONTROL_HANDLER);
-        // else no instance - an error has already been reported.
         if (!bServiceDebug)
             if (g_RegisterServiceCtrlHandlerEx) {
                 // Use 2K/XP extended registration if available
@@ -901,6 +1558,22 @@ void WINAPI service_main(DWORD dwArgc, LPTSTR *lpszArgv)
     if (!bServiceDebug)
         if (!SetServiceStatus(pe->sshStatusHandle, &startingStatus))
             ReportAPIError(PYS_E_API_CANT_SET_PENDING);
+    {
+        // Log where the start time went, to help tune slow-starting services.
+        TCHAR szTimes[256];
+        if (bLoadedClass)
+            _sntprintf(szTimes, sizeof(szTimes) / sizeof(szTimes[0]),
+                       _T("Service loaded: import %lums (%lu modules%s), instance %lums, total %lums"), dwImportTime,
+                       dwModulesLoaded, szBundle[0] ? _T(", from bundle") : _T(""), dwInstanceTick,
+                       GetTickCount() - dwStartTick);
+        else
+            _sntprintf(szTimes, sizeof(szTimes) / sizeof(szTimes[0]),
+                       _T("Service loaded: instance %lums, total %lums"), dwInstanceTick,
+                       GetTickCount() - dwStartTick);
+        szTimes[sizeof(szTimes) / sizeof(szTimes[0]) - 1] = _T('\0');
+        LPTSTR lpszStrings[] = {szTimes, NULL};
+        ReportError(MSG_IR1, (LPCTSTR *)lpszStrings, EVENTLOG_INFORMATION_TYPE);
+    }
     start = PyObject_GetAttrString(instance, "SvcRun");
     if (start == NULL)
         ReportPythonError(E_PYS_NO_RUN_METHOD);
@@ -919,31 +1592,147 @@ void WINAPI service_main(DWORD dwArgc, LPTSTR *lpszArgv)
     }
     // We are all done.
 cleanup:
+    // Stop any progress reports before the final status is reported.
+    if (pe && pe->pQueue) {
+        PY_SERVICE_CTRL_QUEUE *pq = pe->pQueue;
+        EnterCriticalSection(&pq->cs);
+        pq->bStopped = TRUE;
+        LeaveCriticalSection(&pq->cs);
+        Py_BEGIN_ALLOW_THREADS StopPendingReporter(&pq->stopReporter);
+        Py_END_ALLOW_THREADS
+    }
+    if (pe) {
+        Py_BEGIN_ALLOW_THREADS StopPendingReporter(&startReporter);
+        Py_END_ALLOW_THREADS pe->bStarting = FALSE;
+        if (pe->pMetrics)
+            StopServiceMetrics(pe->pMetrics);
+    }
     // try to report the stopped status to the service control manager.
     Py_XDECREF(start);
     Py_XDECREF(instance);
-    if (pe && pe->sshStatusHandle) {  // Wont be true if debugging.
+    Py_XDECREF(klass);
+    if (subState) {
+        // The handler belongs to the interpreter - any further controls are refused.
+        Py_CLEAR(pe->obServiceCtrlHandler);
+        EndServiceInterpreter(subState, mainState, pe->dwInterpreter);
+    }
+    // The process may be ended as soon as we report we have stopped.
+    Py_BEGIN_ALLOW_THREADS FlushLogRecords();
+    Py_END_ALLOW_THREADS if (pe && pe->sshStatusHandle)
+    {  // Wont be true if debugging.
         if (!SetServiceStatus(pe->sshStatusHandle, (stopWithError ? &stoppedErrorStatus : &stoppedStatus)))
             ReportAPIError(PYS_E_API_CANT_SET_STOPPED);
+        pe->sshStatusHandle = 0;
     }
     return;
 }
 
-// The service control handler - receives async notifications from the
-// SCM, and delegates to the Python instance.  One of service_ctrl
-// or service_ctrl_ex are used as entry points depending on whether
-// we are running on NT or 2K/XP.
+// Returns the "path\\module.Class" string LoadPythonServiceClass needs to locate
+// a class in another interpreter.
+static PyObject *ServiceClassString(PyObject *klass)
+{
+    TmpPyObject obModuleName = PyObject_GetAttrString(klass, "__module__");
+    if (obModuleName == NULL)
+        return NULL;
+    TmpPyObject obClassName = PyObject_GetAttrString(klass, "__qualname__");
+    if (obClassName == NULL)
+        return NULL;
+    TmpWCHAR moduleName, className;
+    if (!PyWinObject_AsWCHAR(obModuleName, &moduleName) || !PyWinObject_AsWCHAR(obClassName, &className))
+        return NULL;
+    if (wcschr(className, L'.')) {
+        PyErr_SetString(PyExc_ValueError, "A nested class can't be loaded in a subinterpreter");
+        return NULL;
+    }
+    WCHAR name[MAX_PATH];
+    WCHAR path[MAX_PATH] = L"";  // where the module, or its top-level package, is found.
+    wcsncpy(name, moduleName, MAX_PATH - 1);
+    name[MAX_PATH - 1] = L'\0';
+    PyObject *module = PyDict_GetItem(PyImport_GetModuleDict(), obModuleName);
+    PyObject *obFile = module ? PyObject_GetAttrString(module, "__file__") : NULL;
+    if (obFile == NULL)
+        PyErr_Clear();
+    else {
+        TmpWCHAR file;
+        BOOL ok = PyWinObject_AsWCHAR(obFile, &file);
+        Py_DECREF(obFile);
+        if (!ok)
+            return NULL;
+        wcsncpy(path, file, MAX_PATH - 1);
+        path[MAX_PATH - 1] = L'\0';
+        WCHAR *sep = wcsrchr(path, L'\\');
+        if (sep == NULL)
+            path[0] = L'\0';
+        else {
+            int levels = wcsncmp(sep + 1, L"__init__.", 9) == 0 ? 1 : 0;
+            if (wcscmp(name, L"__main__") == 0) {
+                // A script is imported by its own name in the new interpreter.
+                wcscpy(name, sep + 1);
+                WCHAR *ext = wcsrchr(name, L'.');
+                if (ext)
+                    *ext = L'\0';
+            }
+            *sep = L'\0';
+            // A module in a package is imported from the directory of its top-level package.
+            for (WCHAR *dot = wcschr(name, L'.'); dot; dot = wcschr(dot + 1, L'.')) levels++;
+            while (levels-- > 0 && (sep = wcsrchr(path, L'\\')) != NULL) *sep = L'\0';
+        }
+    }
+    if (path[0])
+        return PyUnicode_FromFormat("%ls\\%ls.%ls", path, name, (WCHAR *)className);
+    return PyUnicode_FromFormat("%ls.%ls", name, (WCHAR *)className);
+}
 
-DWORD WINAPI dispatchServiceCtrl(DWORD dwCtrlCode, DWORD dwEventType, LPVOID eventData, PY_SERVICE_TABLE_ENTRY *pse)
+// Creates a subinterpreter for a service, and makes it current.  Called with the main
+// interpreter's GIL held - for PYS_INTERPRETER_OWN_GIL, that GIL is released when the
+// new interpreter is returned.
+static PyThreadState *NewServiceInterpreter(DWORD dwInterpreter)
 {
-    if (pse->obServiceCtrlHandler == NULL) {  // Python is in error.
-        if (!bServiceDebug)
-            SetServiceStatus(pse->sshStatusHandle, &errorStatus);
-        return ERROR_CALL_NOT_IMPLEMENTED;
+#if (PY_VERSION_HEX >= 0x030C0000)
+    PyInterpreterConfig config;
+    ZeroMemory(&config, sizeof(config));
+    BOOL bOwnGil = dwInterpreter == PYS_INTERPRETER_OWN_GIL;
+    config.use_main_obmalloc = !bOwnGil;
+    config.allow_threads = 1;
+    config.allow_daemon_threads = !bOwnGil;
+    config.check_multi_interp_extensions = bOwnGil;
+    config.gil = bOwnGil ? PyInterpreterConfig_OWN_GIL : PyInterpreterConfig_SHARED_GIL;
+    PyThreadState *subState = NULL;
+    PyStatus status = Py_NewInterpreterFromConfig(&subState, &config);
+    if (PyStatus_Exception(status)) {
+        TCHAR msg[256];
+        MultiByteToWideChar(CP_ACP, 0, status.err_msg ? status.err_msg : "Py_NewInterpreterFromConfig failed", -1,
+                            msg, sizeof(msg) / sizeof(msg[0]));
+        msg[sizeof(msg) / sizeof(msg[0]) - 1] = _T('\0');
+        LPTSTR inserts[] = {msg, NULL};
+        ReportError(PYS_E_GENERIC_ERROR, (LPCTSTR *)inserts);
+        return NULL;
+    }
+    return subState;
+#else
+    PyThreadState *subState = Py_NewInterpreter();
+    if (subState == NULL) {
+        LPTSTR inserts[] = {_T("Py_NewInterpreter failed"), NULL};
+        ReportError(PYS_E_GENERIC_ERROR, (LPCTSTR *)inserts);
     }
-    // Ensure we have a context for our thread.
+    return subState;
+#endif
+}
+
+// Ends a service's subinterpreter, making the main interpreter current again.
+static void EndServiceInterpreter(PyThreadState *subState, PyThreadState *mainState, DWORD dwInterpreter)
+{
+    Py_EndInterpreter(subState);
+    if (dwInterpreter == PYS_INTERPRETER_OWN_GIL)
+        PyEval_RestoreThread(mainState);
+    else
+        PyThreadState_Swap(mainState);
+}
+
+// Calls the Python control handler - the caller must hold the GIL.
+static DWORD callServiceCtrlHandler(DWORD dwCtrlCode, DWORD dwEventType, LPVOID eventData, PY_SERVICE_TABLE_ENTRY *pse)
+{
     DWORD dwResult;
-    CEnterLeavePython celp;
     PyObject *args;
     if (pse->bUseEx) {
         PyObject *sub;
@@ -998,6 +1787,349 @@ DWORD WINAPI dispatchServiceCtrl(DWORD dwCtrlCode, DWORD dwEventType, LPVOID eve
     return dwResult;
 }
 
+// The size of the event data we pass on to Python for a control, so it can be
+// copied when the control is queued.
+static DWORD serviceCtrlDataSize(DWORD dwCtrlCode, DWORD dwEventType, LPVOID eventData)
+{
+    if (eventData == NULL)
+        return 0;
+    switch (dwCtrlCode) {
+        case SERVICE_CONTROL_DEVICEEVENT:
+            return ((DEV_BROADCAST_HDR *)eventData)->dbch_size;
+        case SERVICE_CONTROL_POWEREVENT:
+            if (dwEventType == PBT_POWERSETTINGCHANGE)
+                return offsetof(POWERBROADCAST_SETTING, Data) + ((POWERBROADCAST_SETTING *)eventData)->DataLength;
+            return 0;
+        case SERVICE_CONTROL_SESSIONCHANGE:
+            return sizeof(WTSSESSION_NOTIFICATION);
+    }
+    return 0;
+}
+
+static PY_SERVICE_CTRL_QUEUE *CreateServiceCtrlQueue()
+{
+    PY_SERVICE_CTRL_QUEUE *pq = (PY_SERVICE_CTRL_QUEUE *)malloc(sizeof(PY_SERVICE_CTRL_QUEUE));
+    if (pq == NULL) {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return NULL;
+    }
+    ZeroMemory(pq, sizeof(PY_SERVICE_CTRL_QUEUE));
+    pq->hReady = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (pq->hReady == NULL) {
+        DWORD err = GetLastError();
+        free(pq);
+        SetLastError(err);
+        return NULL;
+    }
+    InitializeCriticalSection(&pq->cs);
+    return pq;
+}
+
+// Keeps the SCM informed that a start or stop is progressing while Python gets to it.
+static DWORD WINAPI pendingReporterThread(LPVOID param)
+{
+    PY_PENDING_REPORTER *pr = (PY_PENDING_REPORTER *)param;
+    SERVICE_STATUS status = {g_serviceProcessFlags, pr->dwState, 0, 0, 0, 1, PENDING_WAIT_HINT};
+    DWORD dwStart = GetTickCount();
+    while (WaitForSingleObject(pr->hDone, PENDING_WAIT_HINT / 2) == WAIT_TIMEOUT &&
+           GetTickCount() - dwStart < pr->dwMaxWait) {
+        status.dwCheckPoint++;
+        SetServiceStatus(pr->ssh, &status);
+    }
+    return 0;
+}
+
+// Reports dwState immediately, then keeps reporting progress from a native
+// thread until StopPendingReporter is called.  The GIL is not needed by the thread.
+static BOOL StartPendingReporter(PY_PENDING_REPORTER *pr, SERVICE_STATUS_HANDLE ssh, DWORD dwState, DWORD dwMaxWait)
+{
+    SERVICE_STATUS status = {g_serviceProcessFlags, dwState, 0, 0, 0, 1, PENDING_WAIT_HINT};
+    SetServiceStatus(ssh, &status);
+    pr->ssh = ssh;
+    pr->dwState = dwState;
+    pr->dwMaxWait = dwMaxWait;
+    pr->hDone = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (pr->hDone == NULL)
+        return FALSE;
+    DWORD tid;
+    pr->hThread = CreateThread(NULL, 0, pendingReporterThread, pr, 0, &tid);
+    if (pr->hThread == NULL) {
+        CloseHandle(pr->hDone);
+        pr->hDone = NULL;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Stops, and waits for, a reporter started by StartPendingReporter.  Safe
+// to call for one which was never started.
+static void StopPendingReporter(PY_PENDING_REPORTER *pr)
+{
+    if (pr->hThread) {
+        SetEvent(pr->hDone);
+        WaitForSingleObject(pr->hThread, INFINITE);
+        CloseHandle(pr->hThread);
+        pr->hThread = NULL;
+    }
+    if (pr->hDone) {
+        CloseHandle(pr->hDone);
+        pr->hDone = NULL;
+    }
+}
+
+// The standard perfmon object of a service - see PY_SERVICE_COUNTERS.
+static const struct {
+    DWORD dwTitleIndex;
+    DWORD dwType;
+    DWORD dwSize;
+    DWORD dwOffset;
+} serviceCounterDefs[] = {
+    {PYSERVICE_PERF_CONTROL_REQUESTS, PERF_COUNTER_COUNTER, sizeof(DWORD),
+     offsetof(PY_SERVICE_COUNTERS, ControlRequests)},
+    {PYSERVICE_PERF_CONTROL_TIME, PERF_AVERAGE_TIMER, sizeof(ULONGLONG), offsetof(PY_SERVICE_COUNTERS, ControlTime)},
+    // The base must directly follow the timer it divides.
+    {PYSERVICE_PERF_CONTROL_TIME_BASE, PERF_AVERAGE_BASE, sizeof(DWORD),
+     offsetof(PY_SERVICE_COUNTERS, ControlTimeBase)},
+    {PYSERVICE_PERF_GIL_WAIT, PERF_COUNTER_RAWCOUNT, sizeof(DWORD), offsetof(PY_SERVICE_COUNTERS, GilWait)},
+    {PYSERVICE_PERF_ALLOCATED_BLOCKS, PERF_COUNTER_LARGE_RAWCOUNT, sizeof(ULONGLONG),
+     offsetof(PY_SERVICE_COUNTERS, AllocatedBlocks)},
+    {PYSERVICE_PERF_THREADS, PERF_COUNTER_RAWCOUNT, sizeof(DWORD), offsetof(PY_SERVICE_COUNTERS, Threads)},
+    {PYSERVICE_PERF_REQUESTS, PERF_COUNTER_COUNTER, sizeof(DWORD), offsetof(PY_SERVICE_COUNTERS, Requests)},
+};
+#define NUM_SERVICE_COUNTERS (sizeof(serviceCounterDefs) / sizeof(serviceCounterDefs[0]))
+
+// Creates the perfmondata.dll mapping named by the "Metrics" value of the
+// service's PythonClass key, or returns NULL if there is none.  Errors are
+// logged rather than stopping the service.
+static PY_SERVICE_METRICS *CreateServiceMetrics(LPCTSTR svcName)
+{
+    TCHAR keyName[1024];
+    TCHAR szMapping[MAX_PATH + 10];
+    HKEY key;
+    _sntprintf(keyName, sizeof(keyName) / sizeof(keyName[0]),
+               _T("System\\CurrentControlSet\\Services\\%s\\PythonClass"), svcName);
+    if (RegOpenKeyEx(HKEY_LOCAL_MACHINE, keyName, 0, KEY_QUERY_VALUE, &key) != ERROR_SUCCESS)
+        return NULL;
+    // perfmondata.dll opens the mapping named after itself, with the same prefix.
+    _tcscpy(szMapping, _T("Global\\"));
+    DWORD dataType, cb = MAX_PATH * sizeof(TCHAR);
+    LONG rc = RegQueryValueEx(key, _T("Metrics"), 0, &dataType, (LPBYTE)(szMapping + 7), &cb);
+    RegCloseKey(key);
+    if (rc != ERROR_SUCCESS || dataType != REG_SZ || cb < 2 * sizeof(TCHAR))
+        return NULL;
+    szMapping[7 + cb / sizeof(TCHAR)] = _T('\0');
+    if (_tcslen(svcName) >= MMCD_SERVICE_SIZE) {
+        LPCTSTR inserts[] = {_T("The service name is too long for its metrics to be published"), NULL};
+        ReportError(PYS_E_GENERIC_WARNING, inserts, EVENTLOG_WARNING_TYPE);
+        return NULL;
+    }
+
+    DWORD cbDefinitions = sizeof(PERF_OBJECT_TYPE) + NUM_SERVICE_COUNTERS * sizeof(PERF_COUNTER_DEFINITION);
+    DWORD cbTotal = sizeof(MappingManagerControlData) + cbDefinitions + sizeof(PY_SERVICE_COUNTERS);
+    PY_SERVICE_METRICS *pm = (PY_SERVICE_METRICS *)calloc(1, sizeof(PY_SERVICE_METRICS));
+    if (pm == NULL)
+        return NULL;
+    pm->hMapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, cbTotal, szMapping);
+    if (pm->hMapping)
+        pm->pControl = (MappingManagerControlData *)MapViewOfFile(pm->hMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (pm->pControl)
+        pm->hStop = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (pm->hStop == NULL) {
+        LPCTSTR inserts[] = {_T("The file mapping for the service's metrics could not be created"), NULL};
+        ReportError(PYS_E_GENERIC_WARNING, inserts, EVENTLOG_WARNING_TYPE);
+        if (pm->pControl)
+            UnmapViewOfFile(pm->pControl);
+        if (pm->hMapping)
+            CloseHandle(pm->hMapping);
+        free(pm);
+        return NULL;
+    }
+    MappingManagerControlData *pControl = pm->pControl;
+    memset(pControl, 0, cbTotal);
+    pControl->ControlSize = sizeof(MappingManagerControlData);
+    pControl->TotalSize = cbTotal;
+    _tcsncpy(pControl->ServiceName, svcName, MMCD_SERVICE_SIZE - 1);
+    _tcsncpy(pControl->EventSourceName, g_szEventSourceName, MMCD_EVENTSOURCE_SIZE - 1);
+
+    PERF_OBJECT_TYPE *pPOT = (PERF_OBJECT_TYPE *)(pControl + 1);
+    pPOT->TotalByteLength = cbDefinitions + sizeof(PY_SERVICE_COUNTERS);
+    pPOT->DefinitionLength = cbDefinitions;
+    pPOT->HeaderLength = sizeof(PERF_OBJECT_TYPE);
+    pPOT->ObjectNameTitleIndex = PYSERVICE_PERF_OBJECT;
+    pPOT->ObjectHelpTitleIndex = PYSERVICE_PERF_OBJECT;
+    pPOT->DetailLevel = PERF_DETAIL_NOVICE;
+    pPOT->NumCounters = NUM_SERVICE_COUNTERS;
+    pPOT->DefaultCounter = 0;
+    pPOT->NumInstances = PERF_NO_INSTANCES;
+    PERF_COUNTER_DEFINITION *pPCD = (PERF_COUNTER_DEFINITION *)(pPOT + 1);
+    for (DWORD i = 0; i < NUM_SERVICE_COUNTERS; i++) {
+        pPCD[i].ByteLength = sizeof(PERF_COUNTER_DEFINITION);
+        pPCD[i].CounterNameTitleIndex = serviceCounterDefs[i].dwTitleIndex;
+        pPCD[i].CounterHelpTitleIndex = serviceCounterDefs[i].dwTitleIndex;
+        pPCD[i].DetailLevel = PERF_DETAIL_NOVICE;
+        pPCD[i].CounterType = serviceCounterDefs[i].dwType;
+        pPCD[i].CounterSize = serviceCounterDefs[i].dwSize;
+        pPCD[i].CounterOffset = serviceCounterDefs[i].dwOffset;
+    }
+    pm->pCounters = (PY_SERVICE_COUNTERS *)(pPCD + NUM_SERVICE_COUNTERS);
+    pm->pCounters->CounterBlock.ByteLength = sizeof(PY_SERVICE_COUNTERS);
+    return pm;
+}
+
+// Samples what can only be read with the GIL held.  How long it takes to get
+// the GIL shows how long the service's own threads are holding it.
+static DWORD WINAPI serviceMetricsThread(LPVOID param)
+{
+    PY_SERVICE_METRICS *pm = (PY_SERVICE_METRICS *)param;
+    PY_SERVICE_COUNTERS *pc = pm->pCounters;
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    while (WaitForSingleObject(pm->hStop, METRICS_SAMPLE_INTERVAL) == WAIT_TIMEOUT) {
+        LARGE_INTEGER before, after;
+        QueryPerformanceCounter(&before);
+        PyGILState_STATE state = PyGILState_Ensure();
+        QueryPerformanceCounter(&after);
+        DWORD dwThreads = 0;
+        PyThreadState *me = PyThreadState_Get();
+        for (PyThreadState *ts = PyInterpreterState_ThreadHead(PyInterpreterState_Head()); ts;
+             ts = PyThreadState_Next(ts))
+            if (ts != me)
+                dwThreads++;
+        LONGLONG blocks = -1;
+        PyObject *fn = PySys_GetObject("getallocatedblocks");  // borrowed
+        PyObject *ret = fn ? PyObject_CallObject(fn, NULL) : NULL;
+        if (ret) {
+            blocks = PyLong_AsLongLong(ret);
+            Py_DECREF(ret);
+        }
+        if (PyErr_Occurred())
+            PyErr_Clear();
+        PyGILState_Release(state);
+        pc->GilWait = (DWORD)((after.QuadPart - before.QuadPart) * 1000000 / freq.QuadPart);
+        pc->Threads = dwThreads;
+        if (blocks >= 0)
+            pc->AllocatedBlocks = (ULONGLONG)blocks;
+    }
+    return 0;
+}
+
+// Marks the data as available and starts the sampler.  GIL held.
+static void StartServiceMetrics(PY_SERVICE_METRICS *pm)
+{
+    ResetEvent(pm->hStop);
+    pm->hThread = CreateThread(NULL, 0, serviceMetricsThread, pm, 0, NULL);
+    pm->pControl->supplierStatus = SupplierStatusRunning;
+}
+
+// GIL held - released while the sampler, which may be waiting for it, stops.
+static void StopServiceMetrics(PY_SERVICE_METRICS *pm)
+{
+    pm->pControl->supplierStatus = SupplierStatusStopped;
+    if (pm->hThread) {
+        SetEvent(pm->hStop);
+        Py_BEGIN_ALLOW_THREADS WaitForSingleObject(pm->hThread, INFINITE);
+        Py_END_ALLOW_THREADS CloseHandle(pm->hThread);
+        pm->hThread = NULL;
+    }
+}
+
+// Counts a control delivered to Python, with the time since qpcStart.
+static void RecordServiceCtrlTime(PY_SERVICE_TABLE_ENTRY *pse, LONGLONG qpcStart)
+{
+    PY_SERVICE_METRICS *pm = pse->pMetrics;
+    if (pm == NULL)
+        return;
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    PY_SERVICE_COUNTERS *pc = pm->pCounters;
+    InterlockedExchangeAdd64((LONGLONG volatile *)&pc->ControlTime, now.QuadPart - qpcStart);
+    InterlockedIncrement((LONG volatile *)&pc->ControlTimeBase);
+    InterlockedIncrement((LONG volatile *)&pc->ControlRequests);
+}
+
+// Called on the SCM thread for a stop or shutdown request when controls are queued.
+static void beginStopPending(PY_SERVICE_TABLE_ENTRY *pse)
+{
+    if (bServiceDebug || pse->sshStatusHandle == 0)
+        return;
+    PY_SERVICE_CTRL_QUEUE *pq = pse->pQueue;
+    EnterCriticalSection(&pq->cs);
+    if (!pq->bStopped && pq->stopReporter.hThread == NULL)
+        StartPendingReporter(&pq->stopReporter, pse->sshStatusHandle, SERVICE_STOP_PENDING, pq->dwStopWait);
+    LeaveCriticalSection(&pq->cs);
+}
+
+// Queues a control for <om servicemanager.DispatchQueuedControls>, without the GIL.
+static DWORD queueServiceCtrl(DWORD dwCtrlCode, DWORD dwEventType, LPVOID eventData, PY_SERVICE_TABLE_ENTRY *pse)
+{
+    PY_SERVICE_CTRL_QUEUE *pq = pse->pQueue;
+    switch (dwCtrlCode) {
+        case SERVICE_CONTROL_INTERROGATE:
+            // The SCM already has the last status we reported.
+            return NOERROR;
+        case SERVICE_CONTROL_STOP:
+        case SERVICE_CONTROL_SHUTDOWN:
+#ifdef SERVICE_CONTROL_PRESHUTDOWN
+        case SERVICE_CONTROL_PRESHUTDOWN:
+#endif
+            beginStopPending(pse);
+            break;
+    }
+    DWORD cbData = serviceCtrlDataSize(dwCtrlCode, dwEventType, eventData);
+    PY_QUEUED_SERVICE_CTRL *pc = (PY_QUEUED_SERVICE_CTRL *)malloc(sizeof(PY_QUEUED_SERVICE_CTRL) + cbData);
+    if (pc == NULL)
+        return ERROR_NOT_ENOUGH_MEMORY;
+    pc->pNext = NULL;
+    pc->dwCtrlCode = dwCtrlCode;
+    pc->dwEventType = dwEventType;
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    pc->qpcQueued = now.QuadPart;
+    pc->bHaveData = cbData != 0;
+    if (cbData)
+        memcpy(pc->data, eventData, cbData);
+    EnterCriticalSection(&pq->cs);
+    if (pq->pTail)
+        pq->pTail->pNext = pc;
+    else
+        pq->pHead = pc;
+    pq->pTail = pc;
+    SetEvent(pq->hReady);
+    LeaveCriticalSection(&pq->cs);
+    return NOERROR;
+}
+
+// The service control handler - receives async notifications from the
+// SCM, and delegates to the Python instance.  One of service_ctrl
+// or service_ctrl_ex are used as entry points depending on whether
+// we are running on NT or 2K/XP.
+
+DWORD WINAPI dispatchServiceCtrl(DWORD dwCtrlCode, DWORD dwEventType, LPVOID eventData, PY_SERVICE_TABLE_ENTRY *pse)
+{
+    if (pse->obServiceCtrlHandler == NULL) {
+        // Still loading - the SCM only gets the pending status being reported.
+        if (pse->bStarting)
+            return dwCtrlCode == SERVICE_CONTROL_INTERROGATE ? NOERROR : ERROR_CALL_NOT_IMPLEMENTED;
+        // Python is in error.
+        if (!bServiceDebug)
+            SetServiceStatus(pse->sshStatusHandle, &errorStatus);
+        return ERROR_CALL_NOT_IMPLEMENTED;
+    }
+    if (pse->pQueue)
+        return queueServiceCtrl(dwCtrlCode, dwEventType, eventData, pse);
+    LARGE_INTEGER start;
+    QueryPerformanceCounter(&start);
+    DWORD dwResult;
+    {
+        // Ensure we have a context for our thread.
+        CEnterLeavePython celp;
+        dwResult = callServiceCtrlHandler(dwCtrlCode, dwEventType, eventData, pse);
+    }
+    // Includes the wait for the GIL, which is most of a slow control's latency.
+    RecordServiceCtrlTime(pse, start.QuadPart);
+    return dwResult;
+}
+
 DWORD WINAPI service_ctrl_ex(DWORD dwCtrlCode,    // requested control code
                              DWORD dwEventType,   // event type
                              LPVOID lpEventData,  // event data
@@ -1169,8 +2301,9 @@ int PythonService_main(int argc, TCHAR **argv)
 }
 
 // Given the string in form [path\]module.ClassName, return
-// an instance of the class
-PyObject *LoadPythonServiceClass(TCHAR *svcInitString)
+// an instance of the class.  szBundle optionally names a zip of precompiled
+// modules (see win32serviceutil.BuildServiceBundle) searched before anything else.
+PyObject *LoadPythonServiceClass(TCHAR *svcInitString, const TCHAR *szBundle /* = NULL */)
 {
     TCHAR valueBuf[512];
     // Initialize Python
@@ -1201,6 +2334,21 @@ PyObject *LoadPythonServiceClass(TCHAR *svcInitString)
     else {
         fname = valueBuf;
     }
+    if (szBundle && szBundle[0]) {
+        // zipimport handles the bundle; inserted last so it is searched first.
+        PyObject *obPath = PySys_GetObject("path");
+        if (obPath == NULL) {
+            ReportPythonError(PYS_E_NO_SYS_PATH);
+            return NULL;
+        }
+        PyObject *obNew = PyWinObject_FromTCHAR(szBundle);
+        if (obNew == NULL) {
+            ReportPythonError(PYS_E_NO_MEMORY_FOR_SYS_PATH);
+            return NULL;
+        }
+        PyList_Insert(obPath, 0, obNew);
+        Py_DECREF(obNew);
+    }
     // Find the last "." in the name, and assume it is a module name.
     TCHAR *classNamePos = _tcsrchr(fname, _T('.'));
     if (classNamePos == NULL) {
@@ -1229,6 +2377,20 @@ PyObject *LoadPythonServiceClass(TCHAR *svcInitString)
     return pyclass;
 }
 
+// LoadPythonServiceClass, also returning how long the import took (ms) and how
+// many modules it loaded.
+static PyObject *LoadPythonServiceClassTimed(TCHAR *svcInitString, const TCHAR *szBundle, DWORD *pdwTime,
+                                             DWORD *pdwModules)
+{
+    DWORD dwStart = GetTickCount();
+    PyService_InitPython();
+    Py_ssize_t before = PyDict_Size(PyImport_GetModuleDict());
+    PyObject *klass = LoadPythonServiceClass(svcInitString, szBundle);
+    *pdwTime = GetTickCount() - dwStart;
+    *pdwModules = (DWORD)(PyDict_Size(PyImport_GetModuleDict()) - before);
+    return klass;
+}
+
 // Given a Python class and an "argv" array, instantiate our
 // instance.
 PyObject *LoadPythonServiceInstance(PyObject *pyclass, DWORD dwArgc, LPTSTR *lpszArgv)
@@ -1309,6 +2471,33 @@ BOOL LocatePythonServiceClassString(TCHAR *svcName, TCHAR *buf, int cchBuf)
     return ok;
 }
 
+// Reads the optional start settings stored next to the class string:
+// "Bundle" (REG_SZ) - a zip of precompiled modules to import from, and
+// "StartTimeout" (REG_DWORD) - how long (ms) to report start progress while loading.
+// Missing values leave the defaults the caller supplied.
+void LocatePythonServiceStartOptions(TCHAR *svcName, TCHAR *szBundle, int cchBundle, DWORD *pdwStartTimeout)
+{
+    TCHAR keyName[1024];
+    HKEY key;
+    _sntprintf(keyName, sizeof(keyName) / sizeof(keyName[0]),
+               _T("System\\CurrentControlSet\\Services\\%s\\PythonClass"), svcName);
+    if (RegOpenKeyEx(HKEY_LOCAL_MACHINE, keyName, 0, KEY_QUERY_VALUE, &key) != ERROR_SUCCESS)
+        return;
+    DWORD dataType;
+    DWORD cb = (cchBundle - 1) * sizeof(TCHAR);
+    if (RegQueryValueEx(key, _T("Bundle"), 0, &dataType, (LPBYTE)szBundle, &cb) == ERROR_SUCCESS &&
+        dataType == REG_SZ)
+        szBundle[cb / sizeof(TCHAR)] = _T('\0');
+    else
+        szBundle[0] = _T('\0');
+    DWORD dwTimeout;
+    cb = sizeof(dwTimeout);
+    if (RegQueryValueEx(key, _T("StartTimeout"), 0, &dataType, (LPBYTE)&dwTimeout, &cb) == ERROR_SUCCESS &&
+        dataType == REG_DWORD)
+        *pdwStartTimeout = dwTimeout;
+    RegCloseKey(key);
+}
+
 // Register the EXE.
 // This writes an entry to the Python registry and also
 // to the EventLog so I can stick in messages.
@@ -27,23 +27,159 @@ typedef struct {
     // Status returned by GetLastError after CreateFileMapping, so we can tell if an existing mapping was opened
     // ??? Should probably expose this as an attribute ???
     DWORD creation_status;
+    // Number of buffer views currently exported - the view can't be closed or
+    // resized while any exist, as they point directly at the mapped memory.
+    Py_ssize_t exports;
+    // Placement options given when the object was created, also used by resize
+    BOOL large_pages;
+    DWORD numa_node;
+    // With Reserve, the view covers the whole (reserved) mapping, but only
+    // the first 'size' bytes are committed - grow commits more in place.
+    BOOL reserve;
+    size_t view_size;
+    // One bit per page of the view, set for pages modified since they were
+    // last flushed.
+    size_t page_size;
+    BYTE *dirty;
 } mmapfile_object;
 
-static void mmapfile_object_dealloc(mmapfile_object *m_obj)
+#ifndef NUMA_NO_PREFERRED_NODE
+#define NUMA_NO_PREFERRED_NODE ((DWORD)-1)
+#endif
+#ifndef SEC_LARGE_PAGES
+#define SEC_LARGE_PAGES 0x80000000
+#endif
+
+// Functions that are not available on all supported versions of Windows
+typedef HANDLE(WINAPI *CreateFileMappingNumafunc)(HANDLE, LPSECURITY_ATTRIBUTES, DWORD, DWORD, DWORD, LPCTSTR, DWORD);
+static CreateFileMappingNumafunc pfnCreateFileMappingNuma = NULL;
+typedef LPVOID(WINAPI *MapViewOfFileExNumafunc)(HANDLE, DWORD, DWORD, DWORD, SIZE_T, LPVOID, DWORD);
+static MapViewOfFileExNumafunc pfnMapViewOfFileExNuma = NULL;
+// Same layout as WIN32_MEMORY_RANGE_ENTRY, which older SDKs don't have
+typedef struct {
+    PVOID VirtualAddress;
+    SIZE_T NumberOfBytes;
+} MMAPFILE_MEMORY_RANGE_ENTRY;
+typedef BOOL(WINAPI *PrefetchVirtualMemoryfunc)(HANDLE, ULONG_PTR, MMAPFILE_MEMORY_RANGE_ENTRY *, ULONG);
+static PrefetchVirtualMemoryfunc pfnPrefetchVirtualMemory = NULL;
+
+#define CHECK_PFN(fname)                                                                                \
+    if (pfn##fname == NULL)                                                                             \
+        return PyErr_Format(PyExc_NotImplementedError, "%s is not available on this platform", #fname);
+
+// Creates the file mapping object, honouring the large page and NUMA options.
+static HANDLE mmapfile_create_mapping(mmapfile_object *self, PSECURITY_ATTRIBUTES psa, ULARGE_INTEGER size)
+{
+    DWORD protect = PAGE_READWRITE;
+    if (self->large_pages)
+        protect |= SEC_COMMIT | SEC_LARGE_PAGES;
+    else if (self->reserve)
+        protect |= SEC_RESERVE;
+    if (self->numa_node != NUMA_NO_PREFERRED_NODE)
+        return (*pfnCreateFileMappingNuma)(self->file_handle, psa, protect, size.HighPart, size.LowPart, self->tagname,
+                                           self->numa_node);
+    return CreateFileMapping(self->file_handle, psa, protect, size.HighPart, size.LowPart, self->tagname);
+}
+
+static char *mmapfile_map_view(mmapfile_object *self, ULARGE_INTEGER offset, SIZE_T size)
+{
+    if (self->numa_node != NUMA_NO_PREFERRED_NODE)
+        return (char *)(*pfnMapViewOfFileExNuma)(self->map_handle, FILE_MAP_WRITE, offset.HighPart, offset.LowPart,
+                                                 size, NULL, self->numa_node);
+    return (char *)MapViewOfFile(self->map_handle, FILE_MAP_WRITE, offset.HighPart, offset.LowPart, size);
+}
+
+static SIZE_T mmapfile_page_size(mmapfile_object *self)
+{
+    if (self->large_pages)
+        return GetLargePageMinimum();
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwPageSize;
+}
+
+#define DIRTY_PAGES(self) (((self)->view_size + (self)->page_size - 1) / (self)->page_size)
+#define DIRTY_BYTES(self) ((DIRTY_PAGES(self) + 7) / 8)
+
+// (Re)allocates an empty dirty page map for a newly mapped view.
+static BOOL mmapfile_reset_dirty(mmapfile_object *self)
 {
-    if (m_obj->data != NULL)
-        UnmapViewOfFile(m_obj->data);
-    if (m_obj->map_handle != NULL)
-        CloseHandle(m_obj->map_handle);
-    if (m_obj->file_handle != INVALID_HANDLE_VALUE)
-        CloseHandle(m_obj->file_handle);
-    PyWinObject_FreeTCHAR(m_obj->tagname);
-    PyObject_Del(m_obj);
+    free(self->dirty);
+    self->page_size = mmapfile_page_size(self);
+    self->dirty = (BYTE *)calloc(DIRTY_BYTES(self) + 1, 1);
+    if (self->dirty == NULL) {
+        PyErr_NoMemory();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void mmapfile_mark_dirty(mmapfile_object *self, size_t offset, size_t len)
+{
+    if (len == 0 || self->dirty == NULL)
+        return;
+    size_t last = (offset + len - 1) / self->page_size;
+    for (size_t page = offset / self->page_size; page <= last; page++) self->dirty[page >> 3] |= 1 << (page & 7);
+}
+
+// Clears the pages entirely inside the range, after it has been flushed.
+static void mmapfile_clear_dirty(mmapfile_object *self, size_t offset, size_t len)
+{
+    if (self->dirty == NULL)
+        return;
+    size_t first = (offset + self->page_size - 1) / self->page_size;
+    size_t end = offset + len == self->view_size ? DIRTY_PAGES(self) : (offset + len) / self->page_size;
+    for (size_t page = first; page < end; page++) self->dirty[page >> 3] &= ~(1 << (page & 7));
+}
+
+// Finds the next run of consecutive dirty pages in map at or after *page,
+// returning FALSE when there are no more.  *page is updated to continue from.
+static BOOL mmapfile_next_dirty_range(mmapfile_object *self, const BYTE *map, size_t *page, size_t *offset,
+                                      size_t *len)
+{
+    size_t npages = DIRTY_PAGES(self);
+    size_t p = *page;
+    while (p < npages && !(map[p >> 3] & (1 << (p & 7)))) {
+        if (!map[p >> 3])  // skip clean groups of 8 pages quickly
+            p = (p | 7) + 1;
+        else
+            p++;
+    }
+    if (p >= npages) {
+        *page = p;
+        return FALSE;
+    }
+    size_t start = p;
+    while (p < npages && (map[p >> 3] & (1 << (p & 7)))) p++;
+    *offset = start * self->page_size;
+    *len = min(p * self->page_size, self->view_size) - *offset;
+    *page = p;
+    return TRUE;
+}
+
+// Commits the view of a Reserve mapping up to new_size, rounded up to a page.
+static BOOL mmapfile_commit(mmapfile_object *self, size_t new_size)
+{
+    if (new_size > self->view_size) {
+        PyErr_SetString(PyExc_ValueError, "The size is larger than the reserved mapping");
+        return FALSE;
+    }
+    if (new_size % self->page_size)
+        new_size += self->page_size - (new_size % self->page_size);
+    if (new_size > self->size) {
+        if (!VirtualAlloc(self->data + self->size, new_size - self->size, MEM_COMMIT, PAGE_READWRITE)) {
+            PyWin_SetAPIError("VirtualAlloc");
+            return FALSE;
+        }
+        self->size = new_size;
+    }
+    return TRUE;
 }
 
 // @pymethod |Pymmapfile|close|Closes the file mapping handle and releases mapped view
 static PyObject *mmapfile_close_method(mmapfile_object *self, PyObject *args)
 {
+    CHECK_NOT_EXPORTED("close");
     if (self->data != NULL)
         UnmapViewOfFile(self->data);
     if (self->map_handle != NULL)
@@ -125,43 +261,214 @@ static PyObject *mmapfile_read_method(mmapfile_object *self, PyObject *args)
     return (result);
 }
 
-// @pymethod int|Pymmapfile|find|Finds a string in the buffer.
-// @rdesc Returns pos of string, or -1 if not found
-static PyObject *mmapfile_find_method(mmapfile_object *self, PyObject *args)
+// @pymethod int|Pymmapfile|readinto|Copies bytes from the current pos into a writable buffer, and advances current
+// position
+// @rdesc Returns the number of bytes copied, which is less than the size of the buffer if the end of the view is
+// reached.
+static PyObject *mmapfile_readinto_method(mmapfile_object *self, PyObject *args)
 {
-    size_t start = self->pos;
-    char *needle;
-    Py_ssize_t len;
-    PyObject *obneedle, *obstart = Py_None;
+    PyObject *obbuf;
     CHECK_VALID;
-    if (!PyArg_ParseTuple(
-            args, "O|O",
-            &obneedle,  // @pyparm str|needle||String to be located
-            &obstart))  // @pyparm int|start||Pos at which to start search, current pos assumed if not specified
+    if (!PyArg_ParseTuple(args, "O:readinto",
+                          &obbuf))  // @pyparm buffer|buffer||A writable buffer, eg a bytearray or numpy array
         return NULL;
-    if (PyString_AsStringAndSize(obneedle, &needle, &len) == -1)
+    Py_buffer view;
+    if (PyObject_GetBuffer(obbuf, &view, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS) == -1)
         return NULL;
+    size_t num_bytes = view.len;
+    if (self->pos >= self->size)
+        num_bytes = 0;
+    else if (num_bytes > self->size - self->pos)
+        num_bytes = self->size - self->pos;
+    memcpy(view.buf, self->data + self->pos, num_bytes);
+    PyBuffer_Release(&view);
+    self->pos += num_bytes;
+    return PyLong_FromSize_t(num_bytes);
+}
+
+// Substring search over the mapped view.  Candidate positions are found by
+// comparing the first and last bytes of the needle against 16 positions at a
+// time, and only those are confirmed with memcmp - so large views are
+// scanned quickly, and needles may contain any bytes (including NULs).
+#if defined(_M_IX86) || defined(_M_X64)
+#include <emmintrin.h>
+#define MMAPFILE_SSE2
+#endif
+
+// Searches below this many bytes keep the GIL.
+#define MMAPFILE_SEARCH_NOGIL_SIZE (1024 * 1024)
+
+static BOOL NeedleAt(const char *p, const char *needle, size_t k)
+{
+    return p[0] == needle[0] && p[k - 1] == needle[k - 1] && memcmp(p + 1, needle + 1, k - 2) == 0;
+}
 
+// Returns the offset of the first match, or -1.  k must be at least 2.
+static SSIZE_T FindForward(const char *hay, size_t n, const char *needle, size_t k)
+{
+    if (k > n)
+        return -1;
+    size_t last = n - k;  // the last position a match can start at
+    size_t i = 0;
+#ifdef MMAPFILE_SSE2
+    __m128i first = _mm_set1_epi8(needle[0]);
+    __m128i lastb = _mm_set1_epi8(needle[k - 1]);
+    for (; i + 15 <= last; i += 16) {
+        __m128i b0 = _mm_loadu_si128((const __m128i *)(hay + i));
+        __m128i b1 = _mm_loadu_si128((const __m128i *)(hay + i + k - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(b0, first), _mm_cmpeq_epi8(b1, lastb)));
+        while (mask) {
+            unsigned long bit;
+            _BitScanForward(&bit, mask);
+            if (memcmp(hay + i + bit + 1, needle + 1, k - 2) == 0)
+                return i + bit;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i <= last; i++)
+        if (NeedleAt(hay + i, needle, k))
+            return i;
+    return -1;
+}
+
+// Returns the offset of the last match, or -1.  k must be at least 2.
+static SSIZE_T FindBackward(const char *hay, size_t n, const char *needle, size_t k)
+{
+    if (k > n)
+        return -1;
+    size_t avail = n - k + 1;  // number of positions a match can start at
+#ifdef MMAPFILE_SSE2
+    __m128i first = _mm_set1_epi8(needle[0]);
+    __m128i lastb = _mm_set1_epi8(needle[k - 1]);
+    for (; avail >= 16; avail -= 16) {
+        size_t i = avail - 16;
+        __m128i b0 = _mm_loadu_si128((const __m128i *)(hay + i));
+        __m128i b1 = _mm_loadu_si128((const __m128i *)(hay + i + k - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(b0, first), _mm_cmpeq_epi8(b1, lastb)));
+        while (mask) {
+            unsigned long bit;
+            _BitScanReverse(&bit, mask);
+            if (memcmp(hay + i + bit + 1, needle + 1, k - 2) == 0)
+                return i + bit;
+            mask &= ~(1u << bit);
+        }
+    }
+#endif
+    while (avail--)
+        if (NeedleAt(hay + avail, needle, k))
+            return avail;
+    return -1;
+}
+
+enum MMAPFILE_SEARCH { SEARCH_FIND, SEARCH_RFIND, SEARCH_COUNT };
+
+// find, rfind or count needle in hay - for find and rfind the result is an
+// offset or -1, for count the number of non-overlapping matches.
+static SSIZE_T SearchBytes(MMAPFILE_SEARCH mode, const char *hay, size_t n, const char *needle, size_t k)
+{
+    if (k == 0)  // same as str.find etc
+        return mode == SEARCH_FIND ? 0 : mode == SEARCH_RFIND ? n : n + 1;
+    if (k == 1) {
+        if (mode == SEARCH_FIND) {
+            const char *p = (const char *)memchr(hay, needle[0], n);
+            return p ? p - hay : -1;
+        }
+        SSIZE_T count = 0;
+        for (size_t i = n; i--;)
+            if (hay[i] == needle[0]) {
+                if (mode == SEARCH_RFIND)
+                    return i;
+                count++;
+            }
+        return mode == SEARCH_RFIND ? -1 : count;
+    }
+    if (mode == SEARCH_FIND)
+        return FindForward(hay, n, needle, k);
+    if (mode == SEARCH_RFIND)
+        return FindBackward(hay, n, needle, k);
+    SSIZE_T count = 0;
+    size_t pos = 0;
+    SSIZE_T found;
+    while ((found = FindForward(hay + pos, n - pos, needle, k)) != -1) {
+        count++;
+        pos += found + k;
+    }
+    return count;
+}
+
+static PyObject *mmapfile_search(mmapfile_object *self, PyObject *args, MMAPFILE_SEARCH mode, const char *fmt)
+{
+    size_t start = self->pos;
+    size_t end = self->size;
+    PyObject *obneedle, *obstart = Py_None, *obend = Py_None;
+    CHECK_VALID;
+    if (!PyArg_ParseTuple(args, fmt, &obneedle, &obstart, &obend))
+        return NULL;
     if (obstart != Py_None) {
         start = PyInt_AsSsize_t(obstart);
-        if (start == -1 && PyErr_Occurred())
+        if (start == (size_t)-1 && PyErr_Occurred())
             return NULL;
     }
+    if (obend != Py_None) {
+        end = PyInt_AsSsize_t(obend);
+        if (end == (size_t)-1 && PyErr_Occurred())
+            return NULL;
+    }
+    // silently 'adjust' out-of-range requests, as read does.
+    if (end > self->size)
+        end = self->size;
+    if (start > end)
+        return PyInt_FromLong(mode == SEARCH_COUNT ? 0 : -1);
 
-    char *p = self->data + self->pos;
-    char *e = self->data + self->size;
-    while (p < e) {
-        char *s = p;
-        char *n = needle;
-        while ((s < e) && (*n) && !(*s - *n)) {
-            s++, n++;
-        }
-        if (!*n) {
-            return PyLong_FromLongLong(p - (self->data + start));
-        }
-        p++;
+    Py_buffer needle;
+    if (PyObject_GetBuffer(obneedle, &needle, PyBUF_SIMPLE) == -1)
+        return NULL;
+    SSIZE_T ret;
+    size_t len = end - start;
+    if (len >= MMAPFILE_SEARCH_NOGIL_SIZE) {
+        // Stop the view being closed or resized while we don't hold the GIL.
+        self->exports++;
+        Py_BEGIN_ALLOW_THREADS ret = SearchBytes(mode, self->data + start, len, (const char *)needle.buf, needle.len);
+        Py_END_ALLOW_THREADS self->exports--;
     }
-    return PyInt_FromLong(-1);
+    else
+        ret = SearchBytes(mode, self->data + start, len, (const char *)needle.buf, needle.len);
+    PyBuffer_Release(&needle);
+    if (mode != SEARCH_COUNT && ret != -1)
+        ret += start;
+    return PyLong_FromSsize_t(ret);
+}
+
+// @pymethod int|Pymmapfile|find|Finds a string in the buffer.
+// @rdesc Returns the position of the first occurrence, or -1 if not found
+static PyObject *mmapfile_find_method(mmapfile_object *self, PyObject *args)
+{
+    // @pyparm bytes|needle||Bytes to be located.  Any object supporting the buffer interface may be used.
+    // @pyparm int|start|None|Pos at which to start search, current pos assumed if not specified
+    // @pyparm int|end|None|Pos at which to end search, end of view assumed if not specified
+    return mmapfile_search(self, args, SEARCH_FIND, "O|OO:find");
+    // @comm The position returned is relative to the start of the view.  For large
+    // ranges, the search is made without holding the Python lock.
+}
+
+// @pymethod int|Pymmapfile|rfind|Finds the last occurrence of a string in the buffer.
+// @rdesc Returns the position of the last occurrence, or -1 if not found
+static PyObject *mmapfile_rfind_method(mmapfile_object *self, PyObject *args)
+{
+    // @pyparm bytes|needle||Bytes to be located.  Any object supporting the buffer interface may be used.
+    // @pyparm int|start|None|Pos at which to start search, current pos assumed if not specified
+    // @pyparm int|end|None|Pos at which to end search, end of view assumed if not specified
+    return mmapfile_search(self, args, SEARCH_RFIND, "O|OO:rfind");
+}
+
+// @pymethod int|Pymmapfile|count|Counts the non-overlapping occurrences of a string in the buffer.
+static PyObject *mmapfile_count_method(mmapfile_object *self, PyObject *args)
+{
+    // @pyparm bytes|needle||Bytes to be counted.  Any object supporting the buffer interface may be used.
+    // @pyparm int|start|None|Pos at which to start search, current pos assumed if not specified
+    // @pyparm int|end|None|Pos at which to end search, end of view assumed if not specified
+    return mmapfile_search(self, args, SEARCH_COUNT, "O|OO:count");
 }
 
 // @pymethod |Pymmapfile|write|Places data at current pos in buffer.
@@ -182,6 +489,7 @@ static PyObject *mmapfile_write_method(mmapfile_object *self, PyObject *args)
         return NULL;
     }
     memcpy(self->data + self->pos, data, length);
+    mmapfile_mark_dirty(self, self->pos, length);
     self->pos = self->pos + length;
     Py_INCREF(Py_None);
     return Py_None;
@@ -200,6 +508,7 @@ static PyObject *mmapfile_write_byte_method(mmapfile_object *self, PyObject *arg
     // read and write methods can leave pos = size, technically past end of buffer
     if (self->pos < self->size) {
         *(self->data + self->pos) = value;
+        mmapfile_mark_dirty(self, self->pos, 1);
         self->pos += 1;
         Py_INCREF(Py_None);
         return Py_None;
@@ -230,6 +539,11 @@ static PyObject *mmapfile_resize_method(mmapfile_object *self, PyObject *args, P
     SSIZE_T new_view_size = 0;
     PyObject *obview_size = Py_None;
     CHECK_VALID;
+    CHECK_NOT_EXPORTED("resize");
+    if (self->reserve) {
+        PyErr_SetString(PyExc_ValueError, "Use grow to resize a mapping created with Reserve");
+        return NULL;
+    }
 
     if (!PyArg_ParseTupleAndKeywords(
             args, kwargs, "L|KO", keywords,
@@ -261,16 +575,16 @@ static PyObject *mmapfile_resize_method(mmapfile_object *self, PyObject *args, P
         // Close the mapping object
         CloseHandle(self->map_handle);
         // Create another mapping object and remap the file view
-        self->map_handle = CreateFileMapping(self->file_handle, NULL, PAGE_READWRITE, new_mapping_size.HighPart,
-                                             new_mapping_size.LowPart, self->tagname);
+        ULARGE_INTEGER size;
+        size.QuadPart = new_mapping_size.QuadPart;
+        self->map_handle = mmapfile_create_mapping(self, NULL, size);
         if (self->map_handle == NULL)
             return PyWin_SetAPIError("CreateFileMapping");
         self->creation_status = GetLastError();
         self->mapping_size.QuadPart = new_mapping_size.QuadPart;
     }
 
-    self->data =
-        (char *)MapViewOfFile(self->map_handle, FILE_MAP_WRITE, new_offset.HighPart, new_offset.LowPart, new_view_size);
+    self->data = mmapfile_map_view(self, new_offset, new_view_size);
     if (self->data == NULL)
         return PyWin_SetAPIError("MapViewOfFile");
 
@@ -283,6 +597,9 @@ static PyObject *mmapfile_resize_method(mmapfile_object *self, PyObject *args, P
     }
     else
         self->size = new_view_size;
+    self->view_size = self->size;
+    if (!mmapfile_reset_dirty(self))
+        return NULL;
 
     // When downsizing a view, old pos may be greater than currently allowed
     if (self->pos >= self->size)
@@ -319,10 +636,139 @@ static PyObject *mmapfile_flush_method(mmapfile_object *self, PyObject *args)
     }
     if (!FlushViewOfFile(self->data + offset, size))
         return PyWin_SetAPIError("FlushViewOfFile");
+    mmapfile_clear_dirty(self, offset, size ? size : self->view_size - offset);
     // Previously the BOOL result was returned without raising an error, return 1 on success
     return PyInt_FromLong(1);
 }
 
+// @pymethod int|Pymmapfile|flush_dirty|Flushes only the pages modified since they were last flushed
+// @rdesc Returns the number of bytes flushed.
+// @comm Pages written by <om Pymmapfile.write>, <om Pymmapfile.write_byte> and <om Pymmapfile.move>
+// are tracked individually, and adjacent modified pages are flushed with a single FlushViewOfFile
+// call.  Writes made through the buffer interface can't be seen, so exporting a buffer marks the
+// whole view as modified.
+static PyObject *mmapfile_flush_dirty_method(mmapfile_object *self, PyObject *args)
+{
+    CHECK_VALID;
+    size_t cb = DIRTY_BYTES(self);
+    BYTE *map = (BYTE *)malloc(cb + 1);
+    if (map == NULL)
+        return PyErr_NoMemory();
+    // Take the current set, so pages written while we flush stay dirty.
+    memcpy(map, self->dirty, cb);
+    memset(self->dirty, 0, cb);
+    size_t flushed = 0, page = 0, offset, len;
+    DWORD err = 0;
+    self->exports++;
+    Py_BEGIN_ALLOW_THREADS while (mmapfile_next_dirty_range(self, map, &page, &offset, &len))
+    {
+        if (!FlushViewOfFile(self->data + offset, len)) {
+            err = GetLastError();
+            break;
+        }
+        flushed += len;
+    }
+    Py_END_ALLOW_THREADS self->exports--;
+    if (err) {
+        // Anything not flushed is still dirty.
+        for (size_t i = 0; i < cb; i++) self->dirty[i] |= map[i];
+        free(map);
+        return PyWin_SetAPIError("FlushViewOfFile", err);
+    }
+    free(map);
+    return PyLong_FromSize_t(flushed);
+}
+
+// @pymethod [(int, int), ...]|Pymmapfile|dirty_ranges|Returns the modified ranges not yet flushed
+// @rdesc A list of (offset, size) tuples, in ascending order of offset.
+static PyObject *mmapfile_dirty_ranges_method(mmapfile_object *self, PyObject *args)
+{
+    CHECK_VALID;
+    PyObject *ret = PyList_New(0);
+    if (ret == NULL)
+        return NULL;
+    size_t page = 0, offset, len;
+    while (mmapfile_next_dirty_range(self, self->dirty, &page, &offset, &len)) {
+        PyObject *item = Py_BuildValue("NN", PyLong_FromSize_t(offset), PyLong_FromSize_t(len));
+        if (item == NULL || PyList_Append(ret, item) == -1) {
+            Py_XDECREF(item);
+            Py_DECREF(ret);
+            return NULL;
+        }
+        Py_DECREF(item);
+    }
+    return ret;
+}
+
+// @pymethod |Pymmapfile|grow|Commits more of a mapping created with Reserve, without remapping it
+// @comm The view stays at the same address, so existing buffer views remain valid (although they
+// don't include the new memory).
+static PyObject *mmapfile_grow_method(mmapfile_object *self, PyObject *args)
+{
+    PyObject *obsize;
+    CHECK_VALID;
+    if (!PyArg_ParseTuple(args, "O:grow", &obsize))  // @pyparm int|size||The new size of the view
+        return NULL;
+    size_t new_size = PyInt_AsSsize_t(obsize);
+    if (new_size == (size_t)-1 && PyErr_Occurred())
+        return NULL;
+    if (!self->reserve) {
+        PyErr_SetString(PyExc_ValueError, "Only mappings created with Reserve can grow in place - use resize");
+        return NULL;
+    }
+    if (!mmapfile_commit(self, new_size))
+        return NULL;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod int|Pymmapfile|page_size|Returns the size of the pages used by the view
+// @rdesc The large page size if the mapping was created with LargePages, otherwise the system page size.
+static PyObject *mmapfile_page_size_method(mmapfile_object *self, PyObject *args)
+{
+    CHECK_VALID;
+    return PyLong_FromSize_t(mmapfile_page_size(self));
+}
+
+// @pymethod |Pymmapfile|prefetch|Asks the system to bring part of the view into memory ahead of its use
+// @pyseeapi PrefetchVirtualMemory
+// @comm Requires Windows 8 or later.  This is only a hint - the call returns before the data is read.
+static PyObject *mmapfile_prefetch_method(mmapfile_object *self, PyObject *args)
+{
+    PyObject *oboffset = Py_None, *obsize = Py_None;
+    size_t offset = 0;
+    size_t size = 0;
+    CHECK_VALID;
+    CHECK_PFN(PrefetchVirtualMemory);
+    if (!PyArg_ParseTuple(
+            args, "|OO:prefetch",
+            &oboffset,  // @pyparm int|offset|0|Position in buffer at which to start
+            &obsize))   // @pyparm int|size|0|Number of bytes to prefetch, 0 for the remainder of buffer past the offset
+        return NULL;
+    if (oboffset != Py_None) {
+        offset = PyInt_AsSsize_t(oboffset);
+        if (offset == -1 && PyErr_Occurred())
+            return NULL;
+    }
+    if (obsize != Py_None) {
+        size = PyInt_AsSsize_t(obsize);
+        if (size == -1 && PyErr_Occurred())
+            return NULL;
+    }
+    if (offset > self->size || (offset + size) > self->size) {
+        PyErr_SetString(PyExc_ValueError, "prefetch values out of range");
+        return NULL;
+    }
+    if (size == 0)
+        size = self->size - offset;
+    MMAPFILE_MEMORY_RANGE_ENTRY entry = {self->data + offset, size};
+    BOOL ok;
+    Py_BEGIN_ALLOW_THREADS ok = (*pfnPrefetchVirtualMemory)(GetCurrentProcess(), 1, &entry, 0);
+    Py_END_ALLOW_THREADS if (!ok) return PyWin_SetAPIError("PrefetchVirtualMemory");
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
 // @pymethod int|Pymmapfile|tell|Returns current position in buffer
 static PyObject *mmapfile_tell_method(mmapfile_object *self, PyObject *args)
 {
@@ -403,6 +849,7 @@ static PyObject *mmapfile_move_method(mmapfile_object *self, PyObject *args)
         return NULL;
     }
     memmove(self->data + dest, self->data + src, count);
+    mmapfile_mark_dirty(self, dest, count);
     Py_INCREF(Py_None);
     return Py_None;
 }
@@ -411,20 +858,36 @@ static PyObject *mmapfile_move_method(mmapfile_object *self, PyObject *args)
 static struct PyMethodDef mmapfile_object_methods[] = {
     // @pymeth close|Closes the file mapping handle and releases mapped view
     {"close", (PyCFunction)mmapfile_close_method, METH_NOARGS},
+    // @pymeth count|Counts the non-overlapping occurrences of a string in the buffer.
+    {"count", (PyCFunction)mmapfile_count_method, METH_VARARGS},
     // @pymeth find|Finds a string in the buffer.
     {"find", (PyCFunction)mmapfile_find_method, METH_VARARGS},
+    // @pymeth dirty_ranges|Returns the modified ranges not yet flushed
+    {"dirty_ranges", (PyCFunction)mmapfile_dirty_ranges_method, METH_NOARGS},
     // @pymeth flush|Flushes memory buffer to disk
     {"flush", (PyCFunction)mmapfile_flush_method, METH_VARARGS},
+    // @pymeth flush_dirty|Flushes only the pages modified since they were last flushed
+    {"flush_dirty", (PyCFunction)mmapfile_flush_dirty_method, METH_NOARGS},
+    // @pymeth grow|Commits more of a mapping created with Reserve, without remapping it
+    {"grow", (PyCFunction)mmapfile_grow_method, METH_VARARGS},
     // @pymeth move|Moves data from one place in buffer to another
     {"move", (PyCFunction)mmapfile_move_method, METH_VARARGS},
+    // @pymeth page_size|Returns the size of the pages used by the view
+    {"page_size", (PyCFunction)mmapfile_page_size_method, METH_NOARGS},
+    // @pymeth prefetch|Asks the system to bring part of the view into memory ahead of its use
+    {"prefetch", (PyCFunction)mmapfile_prefetch_method, METH_VARARGS},
     // @pymeth read|Returns specified number of bytes from buffer, and advances current position
     {"read", (PyCFunction)mmapfile_read_method, METH_VARARGS},
+    // @pymeth readinto|Copies bytes from the current pos into a writable buffer
+    {"readinto", (PyCFunction)mmapfile_readinto_method, METH_VARARGS},
     // @pymeth read_byte|Reads a single character from current pos
     {"read_byte", (PyCFunction)mmapfile_read_byte_method, METH_NOARGS},
     // @pymeth read_line|Reads data from current pos up to next EOL.
     {"readline", (PyCFunction)mmapfile_read_line_method, METH_NOARGS},
     // @pymeth resize|Resizes the file mapping and view
     {"resize", (PyCFunction)mmapfile_resize_method, METH_KEYWORDS | METH_VARARGS},
+    // @pymeth rfind|Finds the last occurrence of a string in the buffer.
+    {"rfind", (PyCFunction)mmapfile_rfind_method, METH_VARARGS},
     // @pymeth seek|Changes current position
     {"seek", (PyCFunction)mmapfile_seek_method, METH_VARARGS},
     // @pymeth size|Returns size of file mapping
@@ -438,6 +901,32 @@ static struct PyMethodDef mmapfile_object_methods[] = {
     {NULL, NULL} /* sentinel */
 };
 
+static int mmapfile_getbuffer(PyObject *obself, Py_buffer *view, int flags)
+{
+    mmapfile_object *self = (mmapfile_object *)obself;
+    if (self->data == NULL) {
+        PyErr_SetString(PyExc_ValueError, "mmapfile closed or invalid");
+        return -1;
+    }
+    if (PyBuffer_FillInfo(view, obself, self->data, self->size, 0, flags) == -1)
+        return -1;
+    // We can't see writes made through the view, so assume it is all modified.
+    mmapfile_mark_dirty(self, 0, self->size);
+    self->exports++;
+    return 0;
+}
+
+static void mmapfile_releasebuffer(PyObject *obself, Py_buffer *view) { ((mmapfile_object *)obself)->exports--; }
+
+static PyBufferProcs mmapfile_as_buffer = {
+    mmapfile_getbuffer,
+    mmapfile_releasebuffer,
+};
+
+// @comm Pymmapfile objects support the buffer interface, giving writable access to the
+// entire mapped view without copying it - eg, memoryview(m)[offset:offset+size] or
+// numpy.frombuffer(m, ...).  The object can't be closed or resized while any such
+// views are alive.
 static PyTypeObject mmapfile_object_type = {
     PYWIN_OBJECT_HEAD "mmapfile",             // tp_name
     sizeof(mmapfile_object),                  // tp_size
@@ -456,7 +945,7 @@ static PyTypeObject mmapfile_object_type = {
     0,                                        /* tp_str */
     PyObject_GenericGetAttr,                  /* tp_getattro */
     0,                                        /* tp_setattro */
-    0,                                        /*tp_as_buffer*/
+    &mmapfile_as_buffer,                      /*tp_as_buffer*/
     Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /* tp_flags */
     0,                                        /* tp_doc */
     0,                                        /* tp_traverse */
@@ -488,7 +977,7 @@ static PyObject *new_mmapfile_object(PyObject *self, PyObject *args, PyObject *k
 {
     mmapfile_object *m_obj;
     TCHAR *filename;
-    PyObject *obfilename, *obtagname, *obview_size = Py_None;
+    PyObject *obfilename, *obtagname, *obview_size = Py_None, *obnuma_node = Py_None;
     PSECURITY_ATTRIBUTES psa = NULL;  // Not accepted as a parameter yet
 
     m_obj = PyObject_New(mmapfile_object, &mmapfile_object_type);
@@ -503,10 +992,18 @@ static PyObject *new_mmapfile_object(PyObject *self, PyObject *args, PyObject *k
     m_obj->offset.QuadPart = 0;
     m_obj->tagname = NULL;
     m_obj->creation_status = 0;
+    m_obj->exports = 0;
+    m_obj->large_pages = FALSE;
+    m_obj->numa_node = NUMA_NO_PREFERRED_NODE;
+    m_obj->reserve = FALSE;
+    m_obj->view_size = 0;
+    m_obj->page_size = 0;
+    m_obj->dirty = NULL;
 
-    static char *keywords[] = {"File", "Name", "MaximumSize", "FileOffset", "NumberOfBytesToMap", NULL};
+    static char *keywords[] = {"File",       "Name",     "MaximumSize", "FileOffset", "NumberOfBytesToMap",
+                               "LargePages", "NumaNode", "Reserve",    NULL};
     if (!PyArg_ParseTupleAndKeywords(
-            args, kwargs, "OO|KKO", keywords,
+            args, kwargs, "OO|KKOiOi", keywords,
             &obfilename,  // @pyparm str|File||Name of file.  Use None or '' when opening an existing named mapping, or
                           // to use system pagefile.
             &obtagname,   // @pyparm str|Name||Name of mapping object to create or open, can be None
@@ -518,11 +1015,32 @@ static PyObject *new_mmapfile_object(PyObject *self, PyObject *args, PyObject *k
             &m_obj->offset.QuadPart,  // @pyparm int|FileOffset|0|Offset into the file at which to create view.  This
                                       // should be specified as a multiple of system allocation granularity. (see <om
                                       // win32api.GetSystemInfo>)
-            &obview_size)) {  // @pyparm int|NumberOfBytesToMap|0|Size of view to create, also a multiple of system page
-                              // size. If 0, view will span from offset to end of file mapping.
+            &obview_size,  // @pyparm int|NumberOfBytesToMap|0|Size of view to create, also a multiple of system page
+                           // size. If 0, view will span from offset to end of file mapping.
+            &m_obj->large_pages,  // @pyparm bool|LargePages|False|Use large pages (SEC_LARGE_PAGES) for the mapping,
+                                  // reducing TLB misses for large mappings.  Only allowed for mappings backed by the
+                                  // system pagefile, and the SeLockMemoryPrivilege privilege must be enabled.  The
+                                  // sizes are rounded up to a multiple of the large page size - see <om
+                                  // Pymmapfile.page_size>.
+            &obnuma_node,  // @pyparm int|NumaNode|None|The NUMA node the memory should preferably be allocated
+                           // from.  Uses CreateFileMappingNuma and MapViewOfFileExNuma.
+            &m_obj->reserve)) {  // @pyparm bool|Reserve|False|Only reserve the memory for a pagefile backed
+                                 // mapping (SEC_RESERVE).  The whole mapping is mapped, but its size starts at
+                                 // NumberOfBytesToMap, and can be increased in place by <om Pymmapfile.grow>.
         Py_DECREF(m_obj);
         return NULL;
     }
+    if (obnuma_node != Py_None) {
+        if (pfnCreateFileMappingNuma == NULL || pfnMapViewOfFileExNuma == NULL) {
+            Py_DECREF(m_obj);
+            return PyErr_Format(PyExc_NotImplementedError, "NUMA mappings are not available on this platform");
+        }
+        m_obj->numa_node = PyLong_AsUnsignedLong(obnuma_node);
+        if (m_obj->numa_node == (DWORD)-1 && PyErr_Occurred()) {
+            Py_DECREF(m_obj);
+            return NULL;
+        }
+    }
 
     if (!PyWinObject_AsTCHAR(obtagname, &m_obj->tagname, TRUE)) {
         Py_DECREF(m_obj);
@@ -553,6 +1071,35 @@ static PyObject *new_mmapfile_object(PyObject *self, PyObject *args, PyObject *k
     }
     PyWinObject_FreeTCHAR(filename);
 
+    size_t initial_size = 0;
+    if (m_obj->reserve) {
+        if (m_obj->file_handle != INVALID_HANDLE_VALUE || !m_obj->mapping_size.QuadPart || m_obj->large_pages) {
+            Py_DECREF(m_obj);
+            PyErr_SetString(PyExc_ValueError,
+                            "Reserve requires a pagefile backed mapping with a MaximumSize, and no LargePages");
+            return NULL;
+        }
+        // The view covers the entire mapping, of which initial_size is committed.
+        initial_size = m_obj->size;
+        m_obj->size = 0;
+    }
+    if (m_obj->large_pages) {
+        SIZE_T large_page = GetLargePageMinimum();
+        if (large_page == 0) {
+            Py_DECREF(m_obj);
+            return PyErr_Format(PyExc_NotImplementedError, "Large pages are not supported on this system");
+        }
+        if (m_obj->file_handle != INVALID_HANDLE_VALUE || !m_obj->mapping_size.QuadPart) {
+            Py_DECREF(m_obj);
+            PyErr_SetString(PyExc_ValueError, "LargePages requires a pagefile backed mapping with a MaximumSize");
+            return NULL;
+        }
+        if (m_obj->mapping_size.QuadPart % large_page)
+            m_obj->mapping_size.QuadPart += large_page - (m_obj->mapping_size.QuadPart % large_page);
+        if (m_obj->size % large_page)
+            m_obj->size += large_page - (m_obj->size % large_page);
+    }
+
     // If mapping size was not specified, use existing file size
     if ((!m_obj->mapping_size.QuadPart) && (m_obj->file_handle != INVALID_HANDLE_VALUE)) {
         m_obj->mapping_size.LowPart = GetFileSize(m_obj->file_handle, &m_obj->mapping_size.HighPart);
@@ -575,8 +1122,7 @@ static PyObject *new_mmapfile_object(PyObject *self, PyObject *args, PyObject *k
             m_obj->mapping_size.QuadPart += si.dwPageSize - (m_obj->mapping_size.QuadPart % si.dwPageSize);
     }
 
-    m_obj->map_handle = CreateFileMapping(m_obj->file_handle, psa, PAGE_READWRITE, m_obj->mapping_size.HighPart,
-                                          m_obj->mapping_size.LowPart, m_obj->tagname);
+    m_obj->map_handle = mmapfile_create_mapping(m_obj, psa, m_obj->mapping_size);
     if (m_obj->map_handle == NULL) {
         Py_DECREF(m_obj);
         return PyWin_SetAPIError("CreateFileMapping");
@@ -593,8 +1139,7 @@ static PyObject *new_mmapfile_object(PyObject *self, PyObject *args, PyObject *k
             m_obj->file_handle = INVALID_HANDLE_VALUE;
         }
 
-    m_obj->data = (char *)MapViewOfFile(m_obj->map_handle, FILE_MAP_WRITE, m_obj->offset.HighPart,
-                                        m_obj->offset.LowPart, m_obj->size);
+    m_obj->data = mmapfile_map_view(m_obj, m_obj->offset, m_obj->size);
     if (m_obj->data == NULL) {
         Py_DECREF(m_obj);
         return PyWin_SetAPIError("MapViewOfFile");
@@ -609,6 +1154,18 @@ static PyObject *new_mmapfile_object(PyObject *self, PyObject *args, PyObject *k
         }
         m_obj->size = mb.RegionSize;
     }
+    m_obj->view_size = m_obj->size;
+    if (!mmapfile_reset_dirty(m_obj)) {
+        Py_DECREF(m_obj);
+        return NULL;
+    }
+    if (m_obj->reserve) {
+        m_obj->size = 0;
+        if (!mmapfile_commit(m_obj, initial_size)) {
+            Py_DECREF(m_obj);
+            return NULL;
+        }
+    }
     return ((PyObject *)m_obj);
 }
 
@@ -616,8 +1173,8 @@ static PyObject *new_mmapfile_object(PyObject *self, PyObject *args, PyObject *k
 static struct PyMethodDef mmapfile_functions[] = {
     // @pymeth mmapfile|Creates or opens a file mapping, and maps a view into memory
     {"mmapfile", (PyCFunction)new_mmapfile_object, METH_KEYWORDS | METH_VARARGS,
-     "Pymmapfile=mmapfile(File,Name,MaximumSize=0,FileOffset=0,NumberOfBytesToMap=0)  Creates a memory mapped file "
-     "view"},
+     "Pymmapfile=mmapfile(File,Name,MaximumSize=0,FileOffset=0,NumberOfBytesToMap=0,LargePages=False,NumaNode=None)  "
+     "Creates a memory mapped file view"},
     {NULL, NULL}  // Sentinel
 };
 
@@ -631,5 +1188,16 @@ PYWIN_MODULE_INIT_FUNC(mmapfile)
     if (PyType_Ready(&mmapfile_object_type) == -1)
         PYWIN_MODULE_INIT_RETURN_ERROR;
 
+    HMODULE hmodule = GetModuleHandle(_T("kernel32.dll"));
+    if (hmodule != NULL) {
+#ifdef UNICODE
+        pfnCreateFileMappingNuma = (CreateFileMappingNumafunc)GetProcAddress(hmodule, "CreateFileMappingNumaW");
+#else
+        pfnCreateFileMappingNuma = (CreateFileMappingNumafunc)GetProcAddress(hmodule, "CreateFileMappingNumaA");
+#endif
+        pfnMapViewOfFileExNuma = (MapViewOfFileExNumafunc)GetProcAddress(hmodule, "MapViewOfFileExNuma");
+        pfnPrefetchVirtualMemory = (PrefetchVirtualMemoryfunc)GetProcAddress(hmodule, "PrefetchVirtualMemory");
+    }
+
     PYWIN_MODULE_INIT_RETURN_SUCCESS;
 }
@@ -53,6 +53,9 @@ typedef struct {
     int connect_id;
     TCHAR *connectionString;
     PyObject *connectionError;
+    struct _stmt *stmt_cache; /* prepared statements, most recently used first */
+    int stmt_cache_size;
+    int stmt_cache_count;
 } connectionObject;
 
 static connectionObject *connection(PyObject *o) { return (connectionObject *)o; }
@@ -62,6 +65,7 @@ typedef PyObject *(*CopyFcn)(const void *, SQLLEN);
 typedef struct _out {
     struct _out *next;
     SQLLEN rcode;
+    SQLLEN *ind; /* length/indicator array, one per block row; &rcode when not block bound */
     void *bind_area;
     CopyFcn copy_fcn;
     bool bGetData;
@@ -78,6 +82,21 @@ typedef struct _in {
     char bind_area[1];
 } InputBinding;
 
+/* A prepared statement parked in its connection's cache, with the output
+   bindings and description made when it was first executed. */
+typedef struct _stmt {
+    struct _stmt *next;
+    TCHAR *sql;
+    HSTMT hstmt;
+    OutputBinding *outputVars;
+    PyObject *description;
+    int n_columns;
+    SQLULEN block_rows;
+    bool output_bound;
+} CachedStatement;
+
+#define DEFAULT_STMT_CACHE_SIZE 10
+
 typedef struct {
     PyObject_HEAD HSTMT hstmt;
     OutputBinding *outputVars;
@@ -88,8 +107,26 @@ typedef struct {
     PyObject *description;
     PyObject *cursorError;
     int n_columns;
+    long arraysize;
+    SQLULEN block_rows;   /* rows bound per SQLFetch (SQL_ATTR_ROW_ARRAY_SIZE) */
+    SQLULEN rows_fetched; /* rows in the current block, set by the driver */
+    SQLULEN block_pos;    /* next row in the current block to hand out */
+    TCHAR *sql;           /* rewritten text hstmt is prepared with, if any */
+    bool output_bound;    /* bindOutput has been done for the prepared statement */
+    int fetch_id;         /* changes whenever the cursor moves to another row */
+    int streamlobs;
+    int async_state;      /* ASYNC_* below */
+    RETCODE async_rc;     /* result of the asynchronous SQLExecute, once it has finished */
 } cursorObject;
 
+/* States of a statement started by executeasync */
+#define ASYNC_NONE 0
+#define ASYNC_RUNNING 1 /* SQLExecute has returned SQL_STILL_EXECUTING */
+#define ASYNC_DONE 2    /* finished, but not yet collected by poll */
+
+/* Upper bound on the bind areas allocated for one block of rows */
+#define MAX_BLOCK_BYTES (1024 * 1024)
+
 static cursorObject *cursor(PyObject *o) { return (cursorObject *)o; }
 
 static void cursorDealloc(PyObject *self);
@@ -234,10 +271,123 @@ static void cursorError(cursorObject *cur, const TCHAR *action)
     odbcPrintError(Env, cur->my_conx, cur->hstmt, action);
 }
 
+static void trimStatementCache(connectionObject *conn, int size);
+
+/* A connection released by a connection object and kept open for reuse by
+   another one with the same connection string.  The pool is only used with
+   the GIL held. */
+typedef struct _pooled {
+    struct _pooled *next;
+    TCHAR *connectionString;
+    HDBC hdbc;
+    DWORD released; /* GetTickCount when it was put in the pool */
+} PooledConnection;
+
+static PooledConnection *connectionPool; /* most recently released first */
+static int poolSize;                     /* 0 disables the pool */
+static int poolCount;
+static DWORD poolIdleTimeout = 60000;
+static long poolHits, poolMisses, poolDead;
+
+static void freePooledConnection(PooledConnection *pc)
+{
+    SQLDisconnect(pc->hdbc);
+    SQLFreeConnect(pc->hdbc);
+    free(pc->connectionString);
+    free(pc);
+    poolCount--;
+}
+
+/* Drops pooled connections beyond size, and those idle for too long. */
+static void trimConnectionPool(int size)
+{
+    PooledConnection **ppc = &connectionPool;
+    DWORD now = GetTickCount();
+    int n = 0;
+    while (*ppc) {
+        PooledConnection *pc = *ppc;
+        if (n < size && now - pc->released < poolIdleTimeout) {
+            n++;
+            ppc = &pc->next;
+            continue;
+        }
+        *ppc = pc->next;
+        freePooledConnection(pc);
+    }
+}
+
+/* Gives conn a pooled connection made with its connection string, if there is
+   one which is still alive.  Returns 1 if it did. */
+static int takePooledConnection(connectionObject *conn)
+{
+    if (poolSize <= 0)
+        return 0;
+    trimConnectionPool(poolSize);
+    PooledConnection **ppc = &connectionPool;
+    while (*ppc) {
+        PooledConnection *pc = *ppc;
+        if (_tcscmp(pc->connectionString, conn->connectionString) != 0) {
+            ppc = &pc->next;
+            continue;
+        }
+        *ppc = pc->next;
+        /* Drivers which can't tell are given the benefit of the doubt */
+        SQLUINTEGER dead = SQL_CD_FALSE;
+        SQLGetConnectAttr(pc->hdbc, SQL_ATTR_CONNECTION_DEAD, &dead, 0, NULL);
+        if (dead == SQL_CD_TRUE) {
+            poolDead++;
+            freePooledConnection(pc);
+            continue;
+        }
+        SQLFreeConnect(conn->hdbc);
+        conn->hdbc = pc->hdbc;
+        pc->hdbc = SQL_NULL_HDBC;
+        free(pc->connectionString);
+        free(pc);
+        poolCount--;
+        poolHits++;
+        return 1;
+    }
+    poolMisses++;
+    return 0;
+}
+
+/* Puts the connection of a connection object being destroyed in the pool,
+   once any transaction is rolled back.  Returns FALSE if it can't be pooled. */
+static BOOL poolConnection(connectionObject *conn)
+{
+    if (poolSize <= 0 || !conn->connected || conn->connectionString == NULL)
+        return FALSE;
+    if (unsuccessful(SQLTransact(Env, conn->hdbc, SQL_ROLLBACK)) ||
+        unsuccessful(SQLSetConnectOption(conn->hdbc, SQL_AUTOCOMMIT, SQL_AUTOCOMMIT_ON)))
+        return FALSE;
+    PooledConnection *pc = (PooledConnection *)malloc(sizeof(PooledConnection));
+    if (pc == NULL)
+        return FALSE;
+    pc->connectionString = conn->connectionString;
+    pc->hdbc = conn->hdbc;
+    pc->released = GetTickCount();
+    conn->connectionString = NULL;
+    conn->hdbc = SQL_NULL_HDBC;
+    conn->connected = 0;
+    pc->next = connectionPool;
+    connectionPool = pc;
+    poolCount++;
+    trimConnectionPool(poolSize);
+    return TRUE;
+}
+
 static int doConnect(connectionObject *conn)
 {
     RETCODE rc;
     short connectionStringLength;
+    /* Statements of a previous connection went away with it */
+    trimStatementCache(conn, 0);
+    if (takePooledConnection(conn)) {
+        conn->connected = 1;
+        conn->connect_id++;
+        return 0;
+    }
     Py_BEGIN_ALLOW_THREADS rc = SQLDriverConnect(conn->hdbc, NULL, (SQLTCHAR *)conn->connectionString, SQL_NTS, NULL, 0,
                                                  &connectionStringLength, SQL_DRIVER_NOPROMPT);
     Py_END_ALLOW_THREADS if (unsuccessful(rc))
@@ -261,6 +411,9 @@ static int attemptReconnect(cursorObject *cur)
             SQLFreeStmt(cur->hstmt, SQL_DROP);
         */
         cur->hstmt = NULL;
+        free(cur->sql);
+        cur->sql = NULL;
+        cur->output_bound = false;
         if (cur->my_conx->connected == 0) {
             /* ie the db has not been reconnected */
             if (doConnect(cur->my_conx)) {
@@ -356,6 +509,15 @@ static PyObject *odbcCursor(PyObject *self, PyObject *args)
     cur->inputVars = 0;
     cur->description = 0;
     cur->max_width = 65536L;
+    cur->arraysize = 1;
+    cur->block_rows = 1;
+    cur->rows_fetched = 0;
+    cur->block_pos = 0;
+    cur->sql = NULL;
+    cur->output_bound = false;
+    cur->fetch_id = 0;
+    cur->streamlobs = 0;
+    cur->async_state = ASYNC_NONE;
     cur->my_conx = 0;
     cur->hstmt = NULL;
     cur->cursorError = odbcError;
@@ -371,6 +533,25 @@ static PyObject *odbcCursor(PyObject *self, PyObject *args)
     return (PyObject *)cur;
 }
 
+/* @pymethod |connection|setstatementcachesize|Sets how many prepared statements are kept for reuse. */
+static PyObject *odbcSetStatementCacheSize(PyObject *self, PyObject *args)
+{
+    int size;
+    connectionObject *conn = connection(self);
+    /* @pyparm int|size||The number of statements, or 0 to disable the cache. */
+    if (!PyArg_ParseTuple(args, "i:setstatementcachesize", &size))
+        return NULL;
+    /* @comm When a cursor executes a different statement, or is destroyed, its
+        prepared statement is kept by the connection, and any cursor executing
+        the same SQL again reuses it without preparing it or binding its result
+        columns again.  The least recently used statements are freed when more
+        than size are kept.  The default is 10. */
+    conn->stmt_cache_size = max(size, 0);
+    trimStatementCache(conn, conn->stmt_cache_size);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
 /* @pymethod |connection|close|Closes the connection. */
 static PyObject *odbcClose(PyObject *self, PyObject *args)
 {
@@ -384,6 +565,8 @@ static struct PyMethodDef connectionMethods[] = {
     {"commit", odbcCommit, 1},               /* @pymeth commit|Commits a transaction. */
     {"rollback", odbcRollback, 1},           /* @pymeth rollback|Rollsback a transaction. */
     {"cursor", odbcCursor, 1},               /* @pymeth cursor|Creates a <o cursor> object */
+    {"setstatementcachesize", odbcSetStatementCacheSize,
+     1}, /* @pymeth setstatementcachesize|Sets how many prepared statements are kept for reuse. */
     {"close", odbcClose, 1},                 /* @pymeth close|Closes the connection. */
     {0, 0}};
 
@@ -392,24 +575,33 @@ static PyMemberDef connectionMembers[] = {{"error", T_OBJECT, offsetof(connectio
 
 static void connectionDealloc(PyObject *self)
 {
+    trimStatementCache(connection(self), 0);
     Py_XDECREF(connection(self)->connectionError);
-    SQLDisconnect(connection(self)->hdbc);
-    SQLFreeConnect(connection(self)->hdbc);
+    if (!poolConnection(connection(self))) {
+        SQLDisconnect(connection(self)->hdbc);
+        SQLFreeConnect(connection(self)->hdbc);
+    }
     if (connection(self)->connectionString) {
         free(connection(self)->connectionString);
     }
     PyObject_Del(self);
 }
 
-static void deleteOutput(cursorObject *cur)
+static void freeOutputBindings(OutputBinding *ob)
 {
-    OutputBinding *ob = cur->outputVars;
     while (ob) {
         OutputBinding *next = ob->next;
         free(ob->bind_area);
+        if (ob->ind != &ob->rcode)
+            free(ob->ind);
         free(ob);
         ob = next;
     }
+}
+
+static void deleteOutput(cursorObject *cur)
+{
+    freeOutputBindings(cur->outputVars);
     cur->outputVars = 0;
 }
 
@@ -431,12 +623,189 @@ static void deleteBinding(cursorObject *cur)
     deleteOutput(cur);
 }
 
+/* Drops cached statements beyond size, least recently used first. */
+static void trimStatementCache(connectionObject *conn, int size)
+{
+    CachedStatement **pcs = &conn->stmt_cache;
+    int n = 0;
+    while (*pcs) {
+        CachedStatement *cs = *pcs;
+        if (n++ < size) {
+            pcs = &cs->next;
+            continue;
+        }
+        *pcs = cs->next;
+        /* Handles are already gone if the connection was dropped */
+        if (conn->connected)
+            SQLFreeHandle(SQL_HANDLE_STMT, cs->hstmt);
+        freeOutputBindings(cs->outputVars);
+        Py_XDECREF(cs->description);
+        free(cs->sql);
+        free(cs);
+        conn->stmt_cache_count--;
+    }
+}
+
+/* Parks the cursor's prepared statement in the connection's cache, leaving the
+   cursor with no statement handle.  Returns FALSE, with the cursor unchanged, if
+   there is nothing to cache or the cache is disabled. */
+static BOOL releaseStatement(cursorObject *cur)
+{
+    connectionObject *conn = cur->my_conx;
+    if (cur->sql == NULL || cur->hstmt == NULL || conn->stmt_cache_size <= 0 || !conn->connected ||
+        cur->connect_id != conn->connect_id)
+        return FALSE;
+    CachedStatement *cs = (CachedStatement *)malloc(sizeof(CachedStatement));
+    if (cs == NULL)
+        return FALSE;
+    SQLFreeStmt(cur->hstmt, SQL_CLOSE);
+    SQLFreeStmt(cur->hstmt, SQL_RESET_PARAMS);
+    deleteInput(cur);
+
+    cs->sql = cur->sql;
+    cs->hstmt = cur->hstmt;
+    cs->outputVars = cur->outputVars;
+    cs->description = cur->description;
+    cs->n_columns = cur->n_columns;
+    cs->block_rows = cur->block_rows;
+    cs->output_bound = cur->output_bound;
+    cur->sql = NULL;
+    cur->hstmt = NULL;
+    cur->outputVars = NULL;
+    cur->description = NULL;
+    cur->n_columns = 0;
+    cur->block_rows = 1;
+    cur->output_bound = false;
+    cur->rows_fetched = cur->block_pos = 0;
+
+    cs->next = conn->stmt_cache;
+    conn->stmt_cache = cs;
+    conn->stmt_cache_count++;
+    trimStatementCache(conn, conn->stmt_cache_size);
+    return TRUE;
+}
+
+/* Makes cur->hstmt a statement prepared with sqlbuf: the cursor's own if it
+   already is, else one from the connection's cache, else a newly prepared one.
+   Returns 1 when a prepared statement (with its output bindings) is reused,
+   0 when sqlbuf was newly prepared, or -1 on error. */
+static int prepareStatement(cursorObject *cur, const TCHAR *sqlbuf)
+{
+    connectionObject *conn = cur->my_conx;
+    RETCODE rc;
+
+    if (cur->sql && cur->hstmt && _tcscmp(cur->sql, sqlbuf) == 0)
+        return 1;
+
+    CachedStatement **pcs = &conn->stmt_cache;
+    while (*pcs && _tcscmp((*pcs)->sql, sqlbuf) != 0) {
+        pcs = &(*pcs)->next;
+    }
+    if (*pcs) {
+        CachedStatement *cs = *pcs;
+        *pcs = cs->next;
+        conn->stmt_cache_count--;
+        if (!releaseStatement(cur) && cur->hstmt)
+            SQLFreeHandle(SQL_HANDLE_STMT, cur->hstmt);
+        free(cur->sql);
+        deleteOutput(cur);
+        Py_XDECREF(cur->description);
+
+        cur->sql = cs->sql;
+        cur->hstmt = cs->hstmt;
+        cur->outputVars = cs->outputVars;
+        cur->description = cs->description;
+        cur->n_columns = cs->n_columns;
+        cur->block_rows = cs->block_rows;
+        cur->output_bound = cs->output_bound;
+        free(cs);
+        /* The driver writes the row count of each block fetch into the cursor */
+        if (cur->block_rows > 1)
+            SQLSetStmtAttr(cur->hstmt, SQL_ATTR_ROWS_FETCHED_PTR, &cur->rows_fetched, 0);
+        return 1;
+    }
+
+    if (releaseStatement(cur) || cur->hstmt == NULL) {
+        cur->block_rows = 1;
+        if (unsuccessful(SQLAllocHandle(SQL_HANDLE_STMT, conn->hdbc, &cur->hstmt))) {
+            cur->hstmt = NULL;
+            connectionError(conn, _T("OPEN"));
+            return -1;
+        }
+    }
+    else {
+        /* Columns of the previous statement would otherwise stay bound */
+        SQLFreeStmt(cur->hstmt, SQL_UNBIND);
+    }
+    free(cur->sql);
+    cur->sql = NULL;
+    cur->output_bound = false;
+    cur->n_columns = 0;
+    deleteOutput(cur);
+    Py_XDECREF(cur->description);
+    cur->description = PyList_New(0);
+    if (!cur->description)
+        return -1;
+
+    Py_BEGIN_ALLOW_THREADS rc = SQLPrepare(cur->hstmt, (SQLTCHAR *)sqlbuf, SQL_NTS);
+    Py_END_ALLOW_THREADS if (unsuccessful(rc))
+    {
+        cursorError(cur, _T("EXEC"));
+        return -1;
+    }
+    /* Not being able to remember the text only stops it being reused */
+    cur->sql = _tcsdup(sqlbuf);
+    return 0;
+}
+
+/* Calls SQLExecute again for a statement executing asynchronously, noting when
+   it has finished.  Touches no Python objects, so is called without the GIL.
+   Returns TRUE once the statement has finished. */
+static BOOL asyncStep(cursorObject *cur)
+{
+    if (cur->async_state == ASYNC_RUNNING) {
+        RETCODE rc = SQLExecute(cur->hstmt);
+        if (rc != SQL_STILL_EXECUTING) {
+            cur->async_rc = rc;
+            cur->async_state = ASYNC_DONE;
+        }
+    }
+    return cur->async_state == ASYNC_DONE;
+}
+
+/* Cancels a statement started by executeasync, waits for it to stop and puts
+   the statement back in synchronous mode. */
+static void abandonAsync(cursorObject *cur)
+{
+    if (cur->async_state == ASYNC_RUNNING) {
+        Py_BEGIN_ALLOW_THREADS SQLCancel(cur->hstmt);
+        while (!asyncStep(cur)) Sleep(1);
+        Py_END_ALLOW_THREADS
+    }
+    if (cur->async_state != ASYNC_NONE) {
+        SQLSetStmtAttr(cur->hstmt, SQL_ATTR_ASYNC_ENABLE, (SQLPOINTER)SQL_ASYNC_ENABLE_OFF, 0);
+        cur->async_state = ASYNC_NONE;
+    }
+}
+
+static BOOL checkNotAsync(cursorObject *cur)
+{
+    if (cur->async_state == ASYNC_NONE)
+        return TRUE;
+    PyErr_SetString(odbcError, "The cursor's statement is executing asynchronously; call poll() until it has finished");
+    return FALSE;
+}
+
 static void cursorDealloc(PyObject *self)
 {
     cursorObject *cur = cursor(self);
     /* Only free HSTMT if database connection hasn't been disconnected */
-    if (cur->my_conx && cur->my_conx->connected && cur->hstmt)
-        SQLFreeHandle(SQL_HANDLE_STMT, cur->hstmt);
+    if (cur->my_conx && cur->my_conx->connected && cur->hstmt) {
+        /* A cached statement must not still be executing */
+        abandonAsync(cur);
+        if (!releaseStatement(cur))
+            SQLFreeHandle(SQL_HANDLE_STMT, cur->hstmt);
+    }
 
     deleteBinding(cur);
     if (cur->my_conx) {
@@ -444,6 +813,7 @@ static void cursorDealloc(PyObject *self)
     }
     Py_XDECREF(cur->description);
     Py_XDECREF(cur->cursorError);
+    free(cur->sql);
     PyObject_Del(self);
 }
 
@@ -468,6 +838,8 @@ static BOOL bindOutputVar(cursorObject *cur, CopyFcn fcn, short vtype, SQLLEN vs
     ob->pos = pos;
     ob->vtype = vtype;
     ob->vsize = vsize;
+    ob->bind_area = NULL;
+    ob->ind = &ob->rcode;
 
     /* Stick the new column on the end of the linked list.
        We do this because we call SQLGetData() while walking the linked list.
@@ -486,14 +858,77 @@ static BOOL bindOutputVar(cursorObject *cur, CopyFcn fcn, short vtype, SQLLEN vs
     }
 
     ob->copy_fcn = fcn;
-    ob->bind_area = malloc(vsize);
-    if (ob->bind_area == NULL) {
-        PyErr_NoMemory();
-        return FALSE;
-    }
     ob->rcode = vsize;
-    if (ob->bGetData == false) {
-        if (unsuccessful(SQLBindCol(cur->hstmt, pos, vtype, ob->bind_area, vsize, &ob->rcode))) {
+    /* Bound columns get their buffers in bindOutputBlock, once the
+       number of rows per fetch is known. */
+    if (ob->bGetData) {
+        ob->bind_area = malloc(vsize);
+        if (ob->bind_area == NULL) {
+            PyErr_NoMemory();
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/* Allocates the bind areas for all bound columns and binds them column-wise,
+   sized for as many rows as cursor.arraysize asks for (within MAX_BLOCK_BYTES),
+   so that each SQLFetch returns a whole block of rows.  Falls back to one row per
+   fetch when a column must be read with SQLGetData, as most drivers do not
+   support SQLGetData on block cursors. */
+static BOOL bindOutputBlock(cursorObject *cur)
+{
+    OutputBinding *ob;
+    SQLULEN rows = (cur->arraysize > 1 && cur->outputVars) ? (SQLULEN)cur->arraysize : 1;
+    SQLLEN row_bytes = 0;
+    for (ob = cur->outputVars; ob; ob = ob->next) {
+        if (ob->bGetData)
+            rows = 1;
+        else
+            row_bytes += ob->vsize + sizeof(SQLLEN);
+    }
+    if (rows > 1 && row_bytes > 0 && rows > (SQLULEN)(MAX_BLOCK_BYTES / row_bytes))
+        rows = max((SQLULEN)1, (SQLULEN)(MAX_BLOCK_BYTES / row_bytes));
+
+    /* The statement handle is reused, so undo a previous block size. */
+    if (rows > 1 || cur->block_rows > 1) {
+        SQLULEN actual = 1;
+        if (unsuccessful(SQLSetStmtAttr(cur->hstmt, SQL_ATTR_ROW_BIND_TYPE, (SQLPOINTER)SQL_BIND_BY_COLUMN, 0)) ||
+            unsuccessful(SQLSetStmtAttr(cur->hstmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)rows, 0)) ||
+            unsuccessful(SQLSetStmtAttr(cur->hstmt, SQL_ATTR_ROWS_FETCHED_PTR, &cur->rows_fetched, 0)) ||
+            unsuccessful(SQLGetStmtAttr(cur->hstmt, SQL_ATTR_ROW_ARRAY_SIZE, &actual, 0, NULL))) {
+            /* Driver does not do block cursors - fetch a row at a time. */
+            SQLSetStmtAttr(cur->hstmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)1, 0);
+            SQLSetStmtAttr(cur->hstmt, SQL_ATTR_ROWS_FETCHED_PTR, NULL, 0);
+            actual = 1;
+        }
+        /* The driver may have substituted another value (01S02) */
+        rows = actual >= 1 ? actual : 1;
+        /* Cached statements move between cursors, so don't leave them pointing at this one */
+        if (rows == 1)
+            SQLSetStmtAttr(cur->hstmt, SQL_ATTR_ROWS_FETCHED_PTR, NULL, 0);
+    }
+    cur->block_rows = rows;
+    cur->rows_fetched = 0;
+    cur->block_pos = 0;
+
+    for (ob = cur->outputVars; ob; ob = ob->next) {
+        if (ob->bGetData)
+            continue;
+        ob->bind_area = malloc(ob->vsize * rows);
+        if (ob->bind_area == NULL) {
+            PyErr_NoMemory();
+            return FALSE;
+        }
+        if (rows > 1) {
+            ob->ind = (SQLLEN *)malloc(rows * sizeof(SQLLEN));
+            if (ob->ind == NULL) {
+                ob->ind = &ob->rcode;
+                PyErr_NoMemory();
+                return FALSE;
+            }
+        }
+        if (unsuccessful(SQLBindCol(cur->hstmt, ob->pos, ob->vtype, ob->bind_area, ob->vsize, ob->ind))) {
             cursorError(cur, _T("BIND"));
             return FALSE;
         }
@@ -686,26 +1121,9 @@ static int ibindNull(cursorObject *cur, int column)
     return 1;
 }
 
-static int ibindDate(cursorObject *cur, int column, PyObject *item)
+/* Converts a datetime object into a TIMESTAMP_STRUCT */
+static int fillTimestamp(PyObject *item, TIMESTAMP_STRUCT *dt)
 {
-    /* Sql server apparently determines the precision and type of date based
-        on length of input, according to the character size required for column
-        storage.  This is completely bogus when passing a TIMESTAMP_STRUCT, whose
-        length is always 16.  This apparently causes Sql Server to treat it as a
-        SMALLDATETIME, and truncates seconds as well as fraction of second, and
-        also limits the range of acceptable dates.
-        Tell it we have enough room for 3 decimals, since this is all that
-        SYSTEMTIME affords, and all that Sql Server 2005 will accept.
-        Sql Server 2008 has a datetime2 with up to 7 decimals.
-        Might need to use SqlDescribeCol to get length and precision to support this.
-    */
-    SQLLEN len = 23;  // length of character storage for yyyy-mm-dd hh:mm:ss.ddd
-    assert(len >= sizeof(TIMESTAMP_STRUCT));
-    InputBinding *ib = initInputBinding(cur, len);
-    if (!ib)
-        return 0;
-    TIMESTAMP_STRUCT *dt = (TIMESTAMP_STRUCT *)ib->bind_area;
-    ZeroMemory(dt, len);
     // Accept a datetime object
     TmpPyObject timeseq = PyObject_CallMethod(item, "timetuple", NULL);
     if (timeseq == NULL)
@@ -729,6 +1147,30 @@ static int ibindDate(cursorObject *cur, int column, PyObject *item)
         // Convert to nanoseconds
         dt->fraction *= 1000;
     }
+    return 1;
+}
+
+static int ibindDate(cursorObject *cur, int column, PyObject *item)
+{
+    /* Sql server apparently determines the precision and type of date based
+        on length of input, according to the character size required for column
+        storage.  This is completely bogus when passing a TIMESTAMP_STRUCT, whose
+        length is always 16.  This apparently causes Sql Server to treat it as a
+        SMALLDATETIME, and truncates seconds as well as fraction of second, and
+        also limits the range of acceptable dates.
+        Tell it we have enough room for 3 decimals, since this is all that
+        SYSTEMTIME affords, and all that Sql Server 2005 will accept.
+        Sql Server 2008 has a datetime2 with up to 7 decimals.
+        Might need to use SqlDescribeCol to get length and precision to support this.
+    */
+    SQLLEN len = 23;  // length of character storage for yyyy-mm-dd hh:mm:ss.ddd
+    assert(len >= sizeof(TIMESTAMP_STRUCT));
+    InputBinding *ib = initInputBinding(cur, len);
+    if (!ib)
+        return 0;
+    ZeroMemory(ib->bind_area, len);
+    if (!fillTimestamp(item, (TIMESTAMP_STRUCT *)ib->bind_area))
+        return 0;
 
     if (unsuccessful(SQLBindParameter(cur->hstmt, column, SQL_PARAM_INPUT, SQL_C_TIMESTAMP, SQL_TIMESTAMP, len,
                                       3,  // Decimal digits of precision, appears to be ignored for datetime
@@ -1044,7 +1486,9 @@ static BOOL bindOutput(cursorObject *cur)
             return FALSE;
     }
 
-    /* success */
+    if (!bindOutputBlock(cur))
+        return FALSE;
+    cur->output_bound = true;
     return TRUE;
 }
 
@@ -1096,6 +1540,338 @@ static RETCODE sendSQLInputData(cursorObject *cur)
         return rc;
 }
 
+/* Parameter arrays for executemany: every row is sent in column-wise buffers
+   with SQL_ATTR_PARAMSET_SIZE, so a batch of rows costs a single SQLExecute. */
+#define PARAM_UNSUPPORTED -1
+#define PARAM_NULL 0
+#define PARAM_LONG 1
+#define PARAM_FLOAT 2
+#define PARAM_BYTES 3
+#define PARAM_UNICODE 4
+#define PARAM_DATE 5
+
+/* Upper bound on the parameter buffers allocated for one batch of rows */
+#define MAX_PARAM_BATCH_BYTES (4 * 1024 * 1024)
+
+typedef struct {
+    int kind;
+    bool wide;    /* PARAM_LONG needing a 64-bit value */
+    SQLLEN width; /* bytes per element */
+    char *data;
+    SQLLEN *ind;
+} ParamColumn;
+
+/* Works out how a value can be sent in a parameter array, and the bytes it needs.
+   Values that bindInput would send as data-at-execution or via their repr are
+   PARAM_UNSUPPORTED, and leave executemany on the row at a time path. */
+static int paramKind(PyObject *item, SQLLEN *width, bool *wide)
+{
+    *width = 0;
+    *wide = false;
+    if (PyLong_Check(item) || PyInt_Check(item)) {
+        long longval = PyLong_AsLong(item);
+        if (longval == -1 && PyErr_Occurred()) {
+            PyErr_Clear();
+            __int64 longlongval = PyLong_AsLongLong(item);
+            if (longlongval == -1 && PyErr_Occurred()) {
+                PyErr_Clear();
+                return PARAM_UNSUPPORTED;
+            }
+            *wide = true;
+        }
+        return PARAM_LONG;
+    }
+    if (PyString_Check(item)) {
+        size_t len = strlen(PyString_AsString(item));
+        if (len > 255) /* see ibindString */
+            return PARAM_UNSUPPORTED;
+        *width = len + 1;
+        return PARAM_BYTES;
+    }
+    if (PyUnicode_Check(item)) {
+        Py_ssize_t nchars = PyUnicode_GetSize(item) + 1;
+        if (nchars > 255) /* see ibindUnicode */
+            return PARAM_UNSUPPORTED;
+        *width = nchars * sizeof(WCHAR);
+        return PARAM_UNICODE;
+    }
+    if (item == Py_None)
+        return PARAM_NULL;
+    if (PyFloat_Check(item))
+        return PARAM_FLOAT;
+    if (PyWinTime_Check(item))
+        return PARAM_DATE;
+    return PARAM_UNSUPPORTED;
+}
+
+static int fillParam(ParamColumn *col, Py_ssize_t idx, PyObject *item)
+{
+    char *p = col->data + idx * col->width;
+    if (item == Py_None) {
+        col->ind[idx] = SQL_NULL_DATA;
+        return 1;
+    }
+    col->ind[idx] = col->width;
+    switch (col->kind) {
+        case PARAM_LONG:
+            if (col->wide) {
+                __int64 longlongval = PyLong_AsLongLong(item);
+                if (longlongval == -1 && PyErr_Occurred())
+                    return 0;
+                memcpy(p, &longlongval, sizeof(longlongval));
+            }
+            else {
+                long longval = PyLong_AsLong(item);
+                if (longval == -1 && PyErr_Occurred())
+                    return 0;
+                memcpy(p, &longval, sizeof(longval));
+            }
+            break;
+        case PARAM_FLOAT: {
+            double d = PyFloat_AsDouble(item);
+            if (d == -1.0 && PyErr_Occurred())
+                return 0;
+            memcpy(p, &d, sizeof(d));
+            break;
+        }
+        case PARAM_BYTES: {
+            const char *val = PyString_AsString(item);
+            if (val == NULL)
+                return 0;
+            size_t len = strlen(val);
+            if ((SQLLEN)len >= col->width) {
+                PyErr_SetString(odbcError, "Parameter rows changed during execute");
+                return 0;
+            }
+            memcpy(p, val, len + 1);
+            col->ind[idx] = len;
+            break;
+        }
+        case PARAM_UNICODE: {
+            const WCHAR *wval = (WCHAR *)PyUnicode_AsUnicode(item);
+            if (wval == NULL)
+                return 0;
+            Py_ssize_t nbytes = PyUnicode_GetSize(item) * sizeof(WCHAR);
+            if (nbytes >= col->width) {
+                PyErr_SetString(odbcError, "Parameter rows changed during execute");
+                return 0;
+            }
+            memcpy(p, wval, nbytes);
+            ((WCHAR *)p)[nbytes / sizeof(WCHAR)] = 0;
+            col->ind[idx] = nbytes;
+            break;
+        }
+        case PARAM_DATE:
+            ZeroMemory(p, col->width);
+            if (!fillTimestamp(item, (TIMESTAMP_STRUCT *)p))
+                return 0;
+            break;
+    }
+    return 1;
+}
+
+static int bindParamColumn(cursorObject *cur, int column, ParamColumn *col)
+{
+    SQLSMALLINT CType = SQL_C_CHAR, SqlType = SQL_CHAR, digits = 0;
+    SQLULEN colsize = 1;
+    switch (col->kind) {
+        case PARAM_LONG:
+            CType = col->wide ? SQL_C_SBIGINT : SQL_C_LONG;
+            SqlType = col->wide ? SQL_BIGINT : SQL_INTEGER;
+            colsize = col->width;
+            break;
+        case PARAM_FLOAT:
+            CType = SQL_C_DOUBLE;
+            SqlType = SQL_DOUBLE;
+            colsize = 15;
+            break;
+        case PARAM_BYTES:
+            SqlType = SQL_VARCHAR;
+            colsize = max(1, col->width - 1);
+            break;
+        case PARAM_UNICODE:
+            CType = SQL_C_WCHAR;
+            SqlType = SQL_WVARCHAR;
+            colsize = max(1, col->width / (SQLLEN)sizeof(WCHAR) - 1);
+            break;
+        case PARAM_DATE:
+            /* See ibindDate */
+            CType = SQL_C_TIMESTAMP;
+            SqlType = SQL_TIMESTAMP;
+            colsize = 23;
+            digits = 3;
+            break;
+    }
+    if (unsuccessful(SQLBindParameter(cur->hstmt, column, SQL_PARAM_INPUT, CType, SqlType, colsize, digits, col->data,
+                                      col->width, col->ind))) {
+        cursorError(cur, _T("input-binding"));
+        return 0;
+    }
+    return 1;
+}
+
+/* Executes the prepared statement for every row in rows using parameter arrays.
+   Returns 1 on success, 0 with an exception set on failure, or -1 when the rows
+   or the driver do not allow it and they must be executed one at a time instead. */
+static int execParamArray(cursorObject *cur, PyObject *rows, int n_columns, SQLLEN *n_rows)
+{
+    Py_ssize_t nrows = PySequence_Length(rows), batch, start, r;
+    SQLLEN row_bytes = 0, t, count = 0;
+    SQLULEN actual = 0;
+    bool bound = false;
+    int i, rv = -1;
+    RETCODE rc;
+
+    if (n_columns == 0 || nrows < 2)
+        return -1;
+    ParamColumn *cols = (ParamColumn *)calloc(n_columns, sizeof(ParamColumn));
+    if (cols == NULL) {
+        PyErr_NoMemory();
+        return 0;
+    }
+
+    /* First pass works out a C type and element size for each column. */
+    for (r = 0; r < nrows; r++) {
+        PyObject *row = PySequence_GetItem(rows, r);
+        if (row == NULL) {
+            rv = 0;
+            goto Done;
+        }
+        if (PyString_Check(row) || PyUnicode_Check(row) || !PySequence_Check(row) ||
+            PySequence_Length(row) != n_columns) {
+            /* Leave the error to the row at a time loop */
+            Py_DECREF(row);
+            PyErr_Clear();
+            goto Done;
+        }
+        for (i = 0; i < n_columns; i++) {
+            SQLLEN width;
+            bool wide;
+            PyObject *item = PySequence_GetItem(row, i);
+            if (item == NULL) {
+                Py_DECREF(row);
+                rv = 0;
+                goto Done;
+            }
+            int kind = paramKind(item, &width, &wide);
+            Py_DECREF(item);
+            if (kind == PARAM_UNSUPPORTED ||
+                (kind != PARAM_NULL && cols[i].kind != PARAM_NULL && kind != cols[i].kind)) {
+                Py_DECREF(row);
+                goto Done;
+            }
+            if (kind != PARAM_NULL)
+                cols[i].kind = kind;
+            if (wide)
+                cols[i].wide = true;
+            if (width > cols[i].width)
+                cols[i].width = width;
+        }
+        Py_DECREF(row);
+    }
+
+    for (i = 0; i < n_columns; i++) {
+        switch (cols[i].kind) {
+            case PARAM_NULL:
+                cols[i].width = 1;
+                break;
+            case PARAM_LONG:
+                cols[i].width = cols[i].wide ? sizeof(__int64) : sizeof(long);
+                break;
+            case PARAM_FLOAT:
+                cols[i].width = sizeof(double);
+                break;
+            case PARAM_DATE:
+                cols[i].width = sizeof(TIMESTAMP_STRUCT);
+                break;
+        }
+        row_bytes += cols[i].width + sizeof(SQLLEN);
+    }
+    batch = min(nrows, max(1, MAX_PARAM_BATCH_BYTES / row_bytes));
+    if (batch < 2)
+        goto Done;
+
+    if (unsuccessful(SQLSetStmtAttr(cur->hstmt, SQL_ATTR_PARAM_BIND_TYPE, (SQLPOINTER)SQL_PARAM_BIND_BY_COLUMN, 0)) ||
+        unsuccessful(SQLSetStmtAttr(cur->hstmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)batch, 0)) ||
+        unsuccessful(SQLGetStmtAttr(cur->hstmt, SQL_ATTR_PARAMSET_SIZE, &actual, 0, NULL)) ||
+        actual != (SQLULEN)batch) {
+        /* Driver does not do parameter arrays */
+        SQLSetStmtAttr(cur->hstmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)1, 0);
+        goto Done;
+    }
+    bound = true;
+
+    for (i = 0; i < n_columns; i++) {
+        cols[i].data = (char *)malloc(cols[i].width * batch);
+        cols[i].ind = (SQLLEN *)malloc(sizeof(SQLLEN) * batch);
+        if (cols[i].data == NULL || cols[i].ind == NULL) {
+            PyErr_NoMemory();
+            rv = 0;
+            goto Done;
+        }
+        if (!bindParamColumn(cur, i + 1, &cols[i])) {
+            rv = 0;
+            goto Done;
+        }
+    }
+
+    for (start = 0; start < nrows; start += batch) {
+        Py_ssize_t n = min(batch, nrows - start);
+        for (r = 0; r < n; r++) {
+            PyObject *row = PySequence_GetItem(rows, start + r);
+            if (row == NULL) {
+                rv = 0;
+                goto Done;
+            }
+            for (i = 0; i < n_columns; i++) {
+                PyObject *item = PySequence_GetItem(row, i);
+                int ok = item && fillParam(&cols[i], r, item);
+                Py_XDECREF(item);
+                if (!ok) {
+                    Py_DECREF(row);
+                    rv = 0;
+                    goto Done;
+                }
+            }
+            Py_DECREF(row);
+        }
+        if (n != batch && unsuccessful(SQLSetStmtAttr(cur->hstmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)n, 0))) {
+            cursorError(cur, _T("EXEC"));
+            rv = 0;
+            goto Done;
+        }
+        Py_BEGIN_ALLOW_THREADS rc = SQLExecute(cur->hstmt);
+        if (!unsuccessful(rc)) {
+            /* Drivers either report one count for the whole array, or one
+               per parameter set which SQLMoreResults steps through. */
+            do {
+                if (!unsuccessful(SQLRowCount(cur->hstmt, &t)) && t > 0)
+                    count += t;
+            } while (!unsuccessful(SQLMoreResults(cur->hstmt)));
+        }
+        Py_END_ALLOW_THREADS if (unsuccessful(rc))
+        {
+            cursorError(cur, _T("EXEC"));
+            rv = 0;
+            goto Done;
+        }
+    }
+    *n_rows += count;
+    rv = 1;
+
+Done:
+    if (bound) {
+        SQLFreeStmt(cur->hstmt, SQL_RESET_PARAMS);
+        SQLSetStmtAttr(cur->hstmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)1, 0);
+    }
+    for (i = 0; i < n_columns; i++) {
+        free(cols[i].data);
+        free(cols[i].ind);
+    }
+    free(cols);
+    return rv;
+}
+
 /* @pymethod int|cursor|execute|Execute some SQL */
 static PyObject *odbcCurExec(PyObject *self, PyObject *args)
 {
@@ -1110,7 +1886,7 @@ static PyObject *odbcCurExec(PyObject *self, PyObject *args)
     int n_columns = 0;
     SQLLEN n_rows = 0;
 
-    if (attemptReconnect(cur)) {
+    if (!checkNotAsync(cur) || attemptReconnect(cur)) {
         return 0;
     }
 
@@ -1142,23 +1918,12 @@ static PyObject *odbcCurExec(PyObject *self, PyObject *args)
     if (!PyWinObject_AsTCHAR(obsql, &sql, FALSE))
         return NULL;
 
-    deleteBinding(cur);
-
-    if (cur->description) {
-        Py_DECREF(cur->description);
-    }
-    cur->description = PyList_New(0);
-    if (!cur->description) {
-        PyWinObject_FreeTCHAR(sql);
-        return NULL;
-    }
-
-    cur->n_columns = 0;
+    deleteInput(cur);
+    cur->rows_fetched = cur->block_pos = 0;
+    cur->fetch_id++;
 
     sqlbuf = (TCHAR *)malloc((_tcslen(sql) + 100) * sizeof(TCHAR));
     if (!sqlbuf) {
-        Py_DECREF(cur->description);
-        cur->description = NULL;
         PyWinObject_FreeTCHAR(sql);
         return PyErr_NoMemory();
     }
@@ -1166,17 +1931,18 @@ static PyObject *odbcCurExec(PyObject *self, PyObject *args)
     SQLFreeStmt(cur->hstmt, SQL_CLOSE); /* ignore errors here */
     RETCODE rc = SQL_SUCCESS;
     n_columns = rewriteQuery(sqlbuf, sql);
-    Py_BEGIN_ALLOW_THREADS rc = SQLPrepare(cur->hstmt, (SQLTCHAR *)sqlbuf, SQL_NTS);
-    Py_END_ALLOW_THREADS if (unsuccessful(rc))
-    {
-        cursorError(cur, _T("EXEC"));
+    /* A statement prepared before keeps its output bindings and description */
+    if (prepareStatement(cur, sqlbuf) < 0)
         goto Error;
-    }
 
     if (rows) {
         int i;
+        /* Send all the rows as parameter arrays, if the values and driver allow */
+        int done = execParamArray(cur, rows, n_columns, &n_rows);
+        if (done == 0)
+            goto Error;
         /* handle insert cases... */
-        for (i = 0; i < PySequence_Length(rows); i++) {
+        for (i = 0; done < 0 && i < PySequence_Length(rows); i++) {
             inputvars = PySequence_GetItem(rows, i);
             if (!PySequence_Check(inputvars)) {
                 PyErr_SetString(odbcError, "expected sequence of sequences for bulk inserts");
@@ -1189,7 +1955,7 @@ static PyObject *odbcCurExec(PyObject *self, PyObject *args)
             if (!bindInput(cur, inputvars, n_columns)) {
                 goto Error;
             }
-            Py_BEGIN_ALLOW_THREADS rc = SQLExecDirect(cur->hstmt, (SQLTCHAR *)sqlbuf, SQL_NTS);
+            Py_BEGIN_ALLOW_THREADS rc = SQLExecute(cur->hstmt);
             Py_END_ALLOW_THREADS
                 /* move data here. */
                 if (rc == SQL_NEED_DATA)
@@ -1204,7 +1970,7 @@ static PyObject *odbcCurExec(PyObject *self, PyObject *args)
             /* Note: multiple result sets aren't supported here, just bulk inserts... */
             Py_BEGIN_ALLOW_THREADS SQLRowCount(cur->hstmt, &t);
             Py_END_ALLOW_THREADS n_rows += t;
-            deleteBinding(cur);
+            deleteInput(cur);
             Py_DECREF(inputvars);
             inputvars = NULL;
         }
@@ -1213,13 +1979,13 @@ static PyObject *odbcCurExec(PyObject *self, PyObject *args)
         if (!bindInput(cur, inputvars, n_columns)) {
             goto Error;
         }
-        Py_BEGIN_ALLOW_THREADS rc = SQLExecDirect(cur->hstmt, (SQLTCHAR *)sqlbuf, SQL_NTS);
+        Py_BEGIN_ALLOW_THREADS rc = SQLExecute(cur->hstmt);
         Py_END_ALLOW_THREADS if (rc == SQL_NEED_DATA) { rc = sendSQLInputData(cur); }
         if (unsuccessful(rc)) {
             cursorError(cur, _T("EXEC"));
             goto Error;
         }
-        else if (!bindOutput(cur)) {
+        else if (!cur->output_bound && !bindOutput(cur)) {
             goto Error;
         }
         /* success */
@@ -1240,13 +2006,471 @@ Cleanup:
     free(sqlbuf);
     return rv;
 Error:
-    Py_DECREF(cur->description);
+    /* Prepare it afresh next time */
+    free(cur->sql);
+    cur->sql = NULL;
+    cur->output_bound = false;
+    Py_XDECREF(cur->description);
     cur->description = NULL;
     rv = NULL;
     goto Cleanup;
 }
 
-static PyObject *processOutput(cursorObject *cur)
+/* @pymethod |cursor|executeasync|Starts executing some SQL, without waiting for it to finish */
+static PyObject *odbcCurExecAsync(PyObject *self, PyObject *args)
+{
+    cursorObject *cur = cursor(self);
+    TCHAR *sql = NULL;
+    TCHAR *sqlbuf = NULL;
+    PyObject *obsql;
+    PyObject *inputvars = 0;
+    PyObject *rv = 0;
+    int n_columns;
+
+    /* @pyparm string|sql||The SQL to execute */
+    /* @pyparm sequence|[var, ...]|[]|Input variables.  Unlike <om cursor.execute>, a
+        sequence of rows for a bulk insert isn't accepted. */
+    if (!PyArg_ParseTuple(args, "O|O:executeasync", &obsql, &inputvars))
+        return NULL;
+    if (inputvars && (PyString_Check(inputvars) || PyUnicode_Check(inputvars) || !PySequence_Check(inputvars)))
+        return PyErr_Format(odbcError, "Values must be a sequence, not %s", inputvars->ob_type->tp_name);
+    if (!checkNotAsync(cur) || attemptReconnect(cur))
+        return NULL;
+    if (!PyWinObject_AsTCHAR(obsql, &sql, FALSE))
+        return NULL;
+
+    deleteInput(cur);
+    cur->rows_fetched = cur->block_pos = 0;
+    cur->fetch_id++;
+
+    sqlbuf = (TCHAR *)malloc((_tcslen(sql) + 100) * sizeof(TCHAR));
+    if (!sqlbuf) {
+        PyWinObject_FreeTCHAR(sql);
+        return PyErr_NoMemory();
+    }
+
+    SQLFreeStmt(cur->hstmt, SQL_CLOSE); /* ignore errors here */
+    n_columns = rewriteQuery(sqlbuf, sql);
+    /* Only the execution is asynchronous - preparing and binding are quick */
+    if (prepareStatement(cur, sqlbuf) < 0 || !bindInput(cur, inputvars, n_columns))
+        goto Error;
+    for (InputBinding *ib = cur->inputVars; ib; ib = ib->next) {
+        if (ib->bPutData) {
+            PyErr_SetString(odbcError, "executeasync can't send long values, which are sent in pieces");
+            goto Error;
+        }
+    }
+    if (unsuccessful(SQLSetStmtAttr(cur->hstmt, SQL_ATTR_ASYNC_ENABLE, (SQLPOINTER)SQL_ASYNC_ENABLE_ON, 0))) {
+        cursorError(cur, _T("ASYNC"));
+        goto Error;
+    }
+    cur->async_state = ASYNC_RUNNING;
+    Py_BEGIN_ALLOW_THREADS asyncStep(cur);
+    Py_END_ALLOW_THREADS
+
+        Py_INCREF(Py_None);
+    rv = Py_None;
+    /* @comm The statement is executed by the driver while the calling thread goes on,
+        so one thread can have statements of many cursors in flight.  Call <om cursor.poll>
+        to find out when it has finished, or wait for several cursors with <om odbc.wait>.
+        Until then, the cursor can't be used for anything else.  The driver must support
+        SQL_ATTR_ASYNC_ENABLE for statements; those which don't raise an error here. */
+Cleanup:
+    PyWinObject_FreeTCHAR(sql);
+    free(sqlbuf);
+    return rv;
+Error:
+    free(cur->sql);
+    cur->sql = NULL;
+    cur->output_bound = false;
+    Py_XDECREF(cur->description);
+    cur->description = NULL;
+    rv = NULL;
+    goto Cleanup;
+}
+
+/* @pymethod int|cursor|poll|Checks whether a statement started by <om cursor.executeasync> has finished */
+/* @rdesc None while the statement is still executing, else what <om cursor.execute> would have returned. */
+static PyObject *odbcCurPoll(PyObject *self, PyObject *args)
+{
+    cursorObject *cur = cursor(self);
+    BOOL done;
+    SQLLEN n_rows = 0;
+    if (!PyArg_ParseTuple(args, ":poll"))
+        return NULL;
+    if (cur->async_state == ASYNC_NONE)
+        return PyErr_Format(odbcError, "The cursor has no statement executing asynchronously");
+    Py_BEGIN_ALLOW_THREADS done = asyncStep(cur);
+    Py_END_ALLOW_THREADS if (!done)
+    {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+
+    /* The diagnostics have to be read before the statement is changed */
+    if (unsuccessful(cur->async_rc)) {
+        cursorError(cur, _T("EXEC"));
+        if (cur->my_conx->connected)
+            SQLSetStmtAttr(cur->hstmt, SQL_ATTR_ASYNC_ENABLE, (SQLPOINTER)SQL_ASYNC_ENABLE_OFF, 0);
+        cur->async_state = ASYNC_NONE;
+        goto Error;
+    }
+    SQLSetStmtAttr(cur->hstmt, SQL_ATTR_ASYNC_ENABLE, (SQLPOINTER)SQL_ASYNC_ENABLE_OFF, 0);
+    cur->async_state = ASYNC_NONE;
+    if (!cur->output_bound && !bindOutput(cur))
+        goto Error;
+    if (cur->n_columns == 0) {
+        n_rows = 1; /* just in case it does not work */
+        SQLRowCount(cur->hstmt, &n_rows);
+    }
+    return PyLong_FromLongLong(n_rows);
+Error:
+    /* Prepare it afresh next time */
+    free(cur->sql);
+    cur->sql = NULL;
+    cur->output_bound = false;
+    Py_XDECREF(cur->description);
+    cur->description = NULL;
+    return NULL;
+}
+
+/* @pymethod |cursor|cancel|Cancels a statement started by <om cursor.executeasync> */
+static PyObject *odbcCurCancel(PyObject *self, PyObject *args)
+{
+    cursorObject *cur = cursor(self);
+    if (!PyArg_ParseTuple(args, ":cancel"))
+        return NULL;
+    if (cur->async_state == ASYNC_RUNNING && unsuccessful(SQLCancel(cur->hstmt))) {
+        cursorError(cur, _T("CANCEL"));
+        return NULL;
+    }
+    /* @comm The statement stops once <om cursor.poll> no longer returns None.  poll
+        then raises the error for the cancelled statement, unless it had already finished. */
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+/* A buffer that at least doubles whenever it has to grow, so filling it costs
+   linear time however large it gets. */
+typedef struct {
+    char *ptr;
+    size_t len;
+    size_t size;
+} GrowBuffer;
+
+/* Makes room for extra more bytes, returning where they start. */
+static char *reserveBuffer(GrowBuffer *gb, size_t extra)
+{
+    if (gb->len + extra > gb->size) {
+        size_t size = max(gb->size * 2, max(gb->len + extra, 256));
+        char *p;
+        /* Some BLOBs can be huge, be paranoid about allowing
+           other threads to run. */
+        Py_BEGIN_ALLOW_THREADS p = (char *)realloc(gb->ptr, size);
+        Py_END_ALLOW_THREADS if (p == NULL)
+        {
+            PyErr_NoMemory();
+            return NULL;
+        }
+        gb->ptr = p;
+        gb->size = size;
+    }
+    return gb->ptr + gb->len;
+}
+
+static void *growBuffer(GrowBuffer *gb, size_t extra)
+{
+    char *ret = reserveBuffer(gb, extra);
+    if (ret)
+        gb->len += extra;
+    return ret;
+}
+
+/* Reads a blob (or long varchar) column of the current row into ob->bind_area
+   with SQLGetData, leaving its length in ob->rcode. */
+static BOOL getLongData(cursorObject *cur, OutputBinding *ob)
+{
+    /* Loop until return code indicates all remaining data fit into buffer. */
+    RETCODE rc;
+    SQLLEN cbRead = 0, cbWant = 0;
+    ob->rcode = 0;
+    do {
+        /* Increase buffer size on second and subsequent calls, to the whole value
+            when the driver reported its size, otherwise by doubling - so a huge
+            value is not copied over and over in cursor chunk size steps.
+            cursor.setoutputsize still sets the size of the first read, which
+            can be used to work around any driver bug (such as the one in
+            SQL Anywhere 5.0, driver version 5.05.041867). */
+        if (cbWant > ob->vsize) {
+            void *pTemp;
+            /* Some BLOBs can be huge, be paranoid about allowing
+               other threads to run. */
+            Py_BEGIN_ALLOW_THREADS pTemp = realloc(ob->bind_area, cbWant);
+            Py_END_ALLOW_THREADS if (pTemp == NULL)
+            {
+                PyErr_NoMemory();
+                return FALSE;
+            }
+            ob->bind_area = pTemp;
+            ob->vsize = cbWant;
+        }
+
+        Py_BEGIN_ALLOW_THREADS rc = SQLGetData(cur->hstmt, ob->pos, ob->vtype, (char *)ob->bind_area + cbRead,
+                                               ob->vsize - cbRead, &ob->rcode);
+        Py_END_ALLOW_THREADS if (unsuccessful(rc))
+        {
+            cursorError(cur, _T("SQLGetData"));
+            return FALSE;
+        }
+        /* Return code can be a negative status code:
+            SQL_NO_TOTAL if length is not known, SQL_NULL_DATA if nothing to retreive
+            Otherwise will be total bytes remaining including current read.
+        */
+        if (ob->rcode >= 0 && ob->rcode <= ob->vsize - cbRead) {
+            /* If we get here, then this should be the last iteration through the loop. */
+            ob->rcode += cbRead;
+        }
+        else {
+            /* rcode is the number of bytes left, counting those just read */
+            cbWant = ob->rcode >= 0 ? cbRead + ob->rcode + 2 * sizeof(WCHAR) : ob->vsize * 2;
+            if (cbWant <= ob->vsize)
+                cbWant = ob->vsize * 2;
+            cbRead = ob->vsize;
+            /* We want to ignore the intermediate
+                  NULL characters SQLGetData() gives us.
+                   (silly, silly) */
+            if (ob->vtype == SQL_C_CHAR)
+                cbRead--;
+            else if (ob->vtype == SQL_C_WCHAR)
+                /* Buffer is not guaranteed to be an exact multiple of sizeof(WCHAR),
+                    leaving an extra byte and throwing the next get off by 1. */
+                cbRead -= sizeof(WCHAR) + ob->vsize % sizeof(WCHAR);
+        }
+
+    } while (rc == SQL_SUCCESS_WITH_INFO);
+    return TRUE;
+}
+
+/* A long column of the current row, read piecemeal with SQLGetData */
+typedef struct {
+    PyObject_HEAD cursorObject *cur;
+    int pos;
+    short vtype;
+    int fetch_id; /* cursor's fetch_id for the row the column belongs to */
+    bool isnull;
+    bool eof;
+    int closed;
+} lobObject;
+
+static lobObject *lob(PyObject *o) { return (lobObject *)o; }
+
+static void lobDealloc(PyObject *self);
+PyMethodDef lobMethods[];
+PyMemberDef lobMembers[];
+
+static PyTypeObject Lob_Type = {
+    PYWIN_OBJECT_HEAD "odbclob", /*tp_name */
+    sizeof(lobObject),           /*tp_basicsize */
+    0,                           /*tp_itemsize */
+    lobDealloc,                  /*tp_dealloc */
+    0,                           /*tp_print */
+    0,                           /*tp_getattr */
+    0,                           /*tp_setattr */
+    0,                           /*tp_compare */
+    0,                           /*tp_repr */
+    0,                           /*tp_as_number */
+    0,                           /* tp_as_sequence */
+    0,                           /* tp_as_mapping */
+    0,                           /* tp_hash */
+    0,                           /* tp_call */
+    0,                           /*tp_str */
+    PyObject_GenericGetAttr,     /* tp_getattro */
+    PyObject_GenericSetAttr,     /* tp_setattro */
+    0,                           /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,          /* tp_flags */
+    0,                           /* tp_doc */
+    0,                           /* tp_traverse */
+    0,                           /* tp_clear */
+    0,                           /* tp_richcompare */
+    0,                           /* tp_weaklistoffset */
+    0,                           /* tp_iter */
+    0,                           /* tp_iternext */
+    lobMethods,                  /* tp_methods */
+    lobMembers,                  /* tp_members */
+    0,                           /* tp_getset */
+    0,                           /* tp_base */
+    0,                           /* tp_dict */
+    0,                           /* tp_descr_get */
+    0,                           /* tp_descr_set */
+    0,                           /* tp_dictoffset */
+    0,                           /* tp_init */
+    0,                           /* tp_alloc */
+    0,                           /* tp_new */
+};
+
+static PyObject *newLob(cursorObject *cur, OutputBinding *ob)
+{
+    lobObject *ret = PyObject_New(lobObject, &Lob_Type);
+    if (ret == NULL)
+        return NULL;
+    ret->cur = cur;
+    Py_INCREF(cur);
+    ret->pos = ob->pos;
+    ret->vtype = ob->vtype;
+    ret->fetch_id = cur->fetch_id;
+    ret->isnull = false;
+    ret->eof = false;
+    ret->closed = 0;
+    return (PyObject *)ret;
+}
+
+static void lobDealloc(PyObject *self)
+{
+    Py_XDECREF(lob(self)->cur);
+    PyObject_Del(self);
+}
+
+/* Reads the next chunk of the column into buf, returning the number of bytes
+   read (0 at the end, or for NULL), or -1 on error.  Text columns are read as
+   UTF-16 code units, and need room for a terminator the driver adds. */
+static Py_ssize_t lobRead(lobObject *lob, char *buf, Py_ssize_t len)
+{
+    cursorObject *cur = lob->cur;
+    SQLLEN avail = len, ind = 0;
+    RETCODE rc;
+    if (lob->closed) {
+        PyErr_SetString(PyExc_ValueError, "I/O operation on closed LOB");
+        return -1;
+    }
+    if (lob->fetch_id != cur->fetch_id) {
+        PyErr_SetString(odbcError, "The cursor has moved on from the row this LOB belongs to");
+        return -1;
+    }
+    if (lob->eof)
+        return 0;
+    if (lob->vtype == SQL_C_WCHAR) {
+        if (len < 2 * (Py_ssize_t)sizeof(WCHAR)) {
+            PyErr_SetString(PyExc_ValueError, "The buffer must have room for 2 characters");
+            return -1;
+        }
+        avail = (len - sizeof(WCHAR)) & ~(SQLLEN)(sizeof(WCHAR) - 1);
+    }
+    Py_BEGIN_ALLOW_THREADS rc = SQLGetData(cur->hstmt, lob->pos, lob->vtype, buf,
+                                           lob->vtype == SQL_C_WCHAR ? avail + sizeof(WCHAR) : avail, &ind);
+    Py_END_ALLOW_THREADS if (rc == SQL_NO_DATA)
+    {
+        lob->eof = true;
+        return 0;
+    }
+    if (unsuccessful(rc)) {
+        cursorError(cur, _T("SQLGetData"));
+        return -1;
+    }
+    if (ind == SQL_NULL_DATA) {
+        lob->isnull = lob->eof = true;
+        return 0;
+    }
+    /* ind is what was left before this read, or SQL_NO_TOTAL */
+    if (ind == SQL_NO_TOTAL || ind > avail)
+        return avail;
+    if (rc == SQL_SUCCESS)
+        lob->eof = true;
+    return ind;
+}
+
+/* @pymethod bytes/str|odbclob|read|Reads from the column */
+static PyObject *lobReadMethod(PyObject *self, PyObject *args)
+{
+    lobObject *l = lob(self);
+    /* @pyparm int|size|-1|The number of bytes (characters for text columns) to
+        read, or -1 to read the rest of the value. */
+    Py_ssize_t size = -1;
+    if (!PyArg_ParseTuple(args, "|n:read", &size))
+        return NULL;
+    /* @rdesc bytes for binary columns, str for text, or None when the value is NULL. */
+    size_t unit = l->vtype == SQL_C_WCHAR ? sizeof(WCHAR) : 1;
+    GrowBuffer gb = {NULL, 0, 0};
+    PyObject *ret = NULL;
+    while (size < 0 || gb.len < size * unit) {
+        /* Reading everything asks for whatever room a doubled buffer has */
+        size_t want = size < 0 ? max(gb.size - gb.len, 65536) : size * unit - gb.len;
+        if (unit > 1)
+            want += unit;
+        char *p = reserveBuffer(&gb, want);
+        if (p == NULL)
+            goto Done;
+        Py_ssize_t n = lobRead(l, p, want);
+        if (n < 0)
+            goto Done;
+        if (n == 0)
+            break;
+        gb.len += n;
+    }
+    if (l->isnull && gb.len == 0) {
+        Py_INCREF(Py_None);
+        ret = Py_None;
+    }
+    else if (unit > 1)
+        ret = PyWinObject_FromWCHAR(gb.ptr ? (WCHAR *)gb.ptr : L"", gb.len / unit);
+    else
+        ret = PyString_FromStringAndSize(gb.ptr ? gb.ptr : "", gb.len);
+Done:
+    free(gb.ptr);
+    return ret;
+}
+
+/* @pymethod int|odbclob|readinto|Reads from the column into a writable buffer */
+static PyObject *lobReadInto(PyObject *self, PyObject *args)
+{
+    PyObject *obbuf;
+    /* @pyparm buffer|buffer||A writable buffer, such as a bytearray or memoryview */
+    if (!PyArg_ParseTuple(args, "O:readinto", &obbuf))
+        return NULL;
+    PyWinBufferView pybuf(obbuf, true);
+    if (!pybuf.ok())
+        return NULL;
+    /* @rdesc The number of bytes read, 0 at the end of the value.  Text columns
+        are read as UTF-16-LE. */
+    Py_ssize_t n = lobRead(lob(self), (char *)pybuf.ptr(), pybuf.len());
+    if (n < 0)
+        return NULL;
+    return PyLong_FromSsize_t(n);
+}
+
+/* @pymethod bool|odbclob|readable|Returns True, as for a file open for reading */
+static PyObject *lobReadable(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":readable"))
+        return NULL;
+    Py_INCREF(Py_True);
+    return Py_True;
+}
+
+/* @pymethod |odbclob|close|Stops reading the column */
+static PyObject *lobClose(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":close"))
+        return NULL;
+    lob(self)->closed = 1;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+/* @object odbclob|A long (blob or text) column of the current row, returned
+    when the cursor's streamlobs attribute is set.  The value is read in chunks
+    with SQLGetData, and can be handed to io.BufferedReader.
+    @comm The value can only be read until the cursor fetches another row, and
+    most drivers require the long columns of a row to be read in column order. */
+static PyMethodDef lobMethods[] = {
+    {"read", lobReadMethod, 1},     /* @pymeth read|Reads from the column */
+    {"readinto", lobReadInto, 1},   /* @pymeth readinto|Reads from the column into a writable buffer */
+    {"readable", lobReadable, 1},   /* @pymeth readable|Returns True, as for a file open for reading */
+    {"close", lobClose, 1},         /* @pymeth close|Stops reading the column */
+    {0, 0}};
+
+static PyMemberDef lobMembers[] = {{"closed", T_INT, offsetof(lobObject, closed), READONLY}, {NULL}};
+
+static PyObject *processOutput(cursorObject *cur, SQLULEN block_row)
 {
     OutputBinding *ob = cur->outputVars;
     int column = 0;
@@ -1255,76 +2479,31 @@ static PyObject *processOutput(cursorObject *cur)
         return NULL;
 
     while (ob) {
-        if (ob->bGetData) {
-            /* Use SQLGetData to retrieve data for blob (or long varchar) type columns.
-                Loop until return code indicates all remaining data fit into buffer.
-            */
-            RETCODE rc;
-            SQLLEN cbRead = 0;
-            ob->rcode = 0;
-            do {
-                /* Increase buffer size by cursor chunk size on second and subsequent calls
-                    If not for the SQL Anywhere 5.0 problem (driver version
-                    5.05.041867), we could probably grow by 50% each time
-                    or the remaining size (as determined by ob->rcode).
-                    Regarding above note, caller can now use cursor.setoutputsize
-                    to work around any such bug in a driver */
-                if (ob->rcode) {
-                    void *pTemp = ob->bind_area;
-                    ob->vsize += cur->max_width;
-                    /* Some BLOBs can be huge, be paranoid about allowing
-                       other threads to run. */
-                    Py_BEGIN_ALLOW_THREADS ob->bind_area = realloc(ob->bind_area, ob->vsize);
-                    Py_END_ALLOW_THREADS if (ob->bind_area == NULL)
-                    {
-                        PyErr_NoMemory();
-                        ob->vsize -= cur->max_width;
-                        ob->bind_area = pTemp;
-                        Py_DECREF(row);
-                        return NULL;
-                    }
-                }
-
-                Py_BEGIN_ALLOW_THREADS rc = SQLGetData(cur->hstmt, ob->pos, ob->vtype, (char *)ob->bind_area + cbRead,
-                                                       ob->vsize - cbRead, &ob->rcode);
-                Py_END_ALLOW_THREADS if (unsuccessful(rc))
-                {
-                    Py_DECREF(row);
-                    cursorError(cur, _T("SQLGetData"));
-                    return NULL;
-                }
-                /* Return code can be a negative status code:
-                    SQL_NO_TOTAL if length is not known, SQL_NULL_DATA if nothing to retreive
-                    Otherwise will be total bytes remaining including current read.
-                */
-                if (ob->rcode >= 0 && ob->rcode <= ob->vsize - cbRead) {
-                    /* If we get here, then this should be the last iteration through the loop. */
-                    ob->rcode += cbRead;
-                }
-                else {
-                    cbRead = ob->vsize;
-                    /* We want to ignore the intermediate
-                          NULL characters SQLGetData() gives us.
-                           (silly, silly) */
-                    if (ob->vtype == SQL_C_CHAR)
-                        cbRead--;
-                    else if (ob->vtype == SQL_C_WCHAR)
-                        /* Buffer is not guaranteed to be an exact multiple of sizeof(WCHAR),
-                            leaving an extra byte and throwing the next get off by 1. */
-                        cbRead -= sizeof(WCHAR) + ob->vsize % sizeof(WCHAR);
-                }
-
-            } while (rc == SQL_SUCCESS_WITH_INFO);
+        PyObject *v;
+        if (ob->bGetData && cur->streamlobs) {
+            v = newLob(cur, ob);
+            if (!v) {
+                Py_DECREF(row);
+                return NULL;
+            }
+            PyTuple_SET_ITEM(row, column++, v);
+            ob = ob->next;
+            continue;
+        }
+        if (ob->bGetData && !getLongData(cur, ob)) {
+            Py_DECREF(row);
+            return NULL;
         }
 
-        PyObject *v;
-        if (ob->rcode == SQL_NULL_DATA) {
+        SQLLEN rcode = ob->ind[block_row];
+        if (rcode == SQL_NULL_DATA) {
             v = Py_None;
             Py_INCREF(v);
         }
         else {
             if (ob->bGetData == false) {
-                v = ob->copy_fcn(ob->bind_area, (ob->rcode < cur->max_width) ? ob->rcode : cur->max_width);
+                v = ob->copy_fcn((char *)ob->bind_area + block_row * ob->vsize,
+                                 (rcode < cur->max_width) ? rcode : cur->max_width);
             }
             else {
                 v = ob->copy_fcn(ob->bind_area, ob->rcode);
@@ -1341,21 +2520,44 @@ static PyObject *processOutput(cursorObject *cur)
     return row;
 }
 
-static PyObject *fetchOne(cursorObject *cur)
+/* Makes sure there is a fetched row at cur->block_pos, calling SQLFetch
+   for the next block once the rows left over from the last one are used.
+   Returns 1 if there is a row, 0 at the end of the results, -1 on error. */
+static int fetchBlock(cursorObject *cur)
 {
     RETCODE rc;
+    if (cur->block_pos < cur->rows_fetched)
+        return 1;
+    if (!checkNotAsync(cur))
+        return -1;
+
+    /* The driver sets rows_fetched for block fetches */
+    cur->rows_fetched = cur->block_pos = 0;
+    cur->fetch_id++;
     Py_BEGIN_ALLOW_THREADS rc = SQLFetch(cur->hstmt);
-    Py_END_ALLOW_THREADS if (rc == SQL_NO_DATA_FOUND)
-    {
-        Py_INCREF(Py_None);
-        return Py_None;
-    }
-    else if (unsuccessful(rc))
-    {
+    Py_END_ALLOW_THREADS
+
+    if (rc == SQL_NO_DATA_FOUND)
+        return 0;
+    if (unsuccessful(rc)) {
         cursorError(cur, _T("FETCH"));
+        return -1;
+    }
+    if (cur->block_rows == 1)
+        cur->rows_fetched = 1;
+    return cur->rows_fetched > 0;
+}
+
+static PyObject *fetchOne(cursorObject *cur)
+{
+    int n = fetchBlock(cur);
+    if (n < 0)
         return 0;
+    if (n == 0) {
+        Py_INCREF(Py_None);
+        return Py_None;
     }
-    return processOutput(cur);
+    return processOutput(cur, cur->block_pos++);
 }
 
 static PyObject *fetchN(cursorObject *cur, long n_rows)
@@ -1386,17 +2588,230 @@ static PyObject *fetchN(cursorObject *cur, long n_rows)
     return list;
 }
 
+/* Result columns gathered by fetchcolumns, laid out like Apache Arrow arrays */
+typedef struct {
+    GrowBuffer data;
+    GrowBuffer offsets; /* INT32 offsets into data, for variable width columns */
+    GrowBuffer validity;
+} ColumnBuilder;
+
+/* Arrow C data interface format of the column built from an output binding */
+static const char *columnFormat(OutputBinding *ob)
+{
+    switch (ob->vtype) {
+        case SQL_C_LONG:
+            return "i";
+        case SQL_C_DOUBLE:
+            return "g";
+        case SQL_C_TIMESTAMP:
+            return "tsu:";
+        case SQL_C_WCHAR:
+            return "u";
+        default:
+            return "z";
+    }
+}
+
+/* Microseconds since 1970-01-01 for a TIMESTAMP_STRUCT (proleptic Gregorian) */
+static __int64 timestampMicroseconds(const TIMESTAMP_STRUCT *dt)
+{
+    int y = dt->year - (dt->month <= 2);
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int doy = (153 * (dt->month + (dt->month > 2 ? -3 : 9)) + 2) / 5 + dt->day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    __int64 days = (__int64)era * 146097 + doe - 719468;
+    return ((days * 24 + dt->hour) * 60 + dt->minute) * 60 * 1000000LL + dt->second * 1000000LL + dt->fraction / 1000;
+}
+
+static BOOL appendColumnValue(cursorObject *cur, ColumnBuilder *cb, OutputBinding *ob, SQLULEN block_row,
+                              Py_ssize_t row)
+{
+    const char *v;
+    SQLLEN rcode;
+    if (ob->bGetData) {
+        if (!getLongData(cur, ob))
+            return FALSE;
+        v = (const char *)ob->bind_area;
+        rcode = ob->rcode;
+    }
+    else {
+        v = (const char *)ob->bind_area + block_row * ob->vsize;
+        rcode = ob->ind[block_row];
+        if (rcode > cur->max_width)
+            rcode = cur->max_width;
+    }
+    if (row % 8 == 0) {
+        unsigned char *bits = (unsigned char *)growBuffer(&cb->validity, 1);
+        if (bits == NULL)
+            return FALSE;
+        *bits = 0;
+    }
+    bool isnull = (rcode == SQL_NULL_DATA);
+    if (!isnull)
+        cb->validity.ptr[row / 8] |= 1 << (row % 8);
+
+    switch (ob->vtype) {
+        case SQL_C_LONG:
+        case SQL_C_DOUBLE: {
+            size_t size = ob->vtype == SQL_C_LONG ? sizeof(INT32) : sizeof(double);
+            void *p = growBuffer(&cb->data, size);
+            if (p == NULL)
+                return FALSE;
+            if (isnull)
+                memset(p, 0, size);
+            else
+                memcpy(p, v, size);
+            return TRUE;
+        }
+        case SQL_C_TIMESTAMP: {
+            __int64 *p = (__int64 *)growBuffer(&cb->data, sizeof(__int64));
+            if (p == NULL)
+                return FALSE;
+            *p = isnull ? 0 : timestampMicroseconds((const TIMESTAMP_STRUCT *)v);
+            return TRUE;
+        }
+    }
+    /* Variable width - utf8 for strings, plain bytes otherwise */
+    if (row == 0) {
+        INT32 *first = (INT32 *)growBuffer(&cb->offsets, sizeof(INT32));
+        if (first == NULL)
+            return FALSE;
+        *first = 0;
+    }
+    if (!isnull && rcode > 0) {
+        if (ob->vtype == SQL_C_WCHAR) {
+            int nchars = (int)(rcode / sizeof(WCHAR));
+            size_t start = cb->data.len;
+            char *p = (char *)growBuffer(&cb->data, nchars * 3);
+            if (p == NULL)
+                return FALSE;
+            int n = WideCharToMultiByte(CP_UTF8, 0, (const WCHAR *)v, nchars, p, nchars * 3, NULL, NULL);
+            cb->data.len = start + n;
+        }
+        else {
+            char *p = (char *)growBuffer(&cb->data, rcode);
+            if (p == NULL)
+                return FALSE;
+            memcpy(p, v, rcode);
+        }
+    }
+    if (cb->data.len > INT_MAX) {
+        PyErr_SetString(odbcError, "Column data is too large for fetchcolumns");
+        return FALSE;
+    }
+    INT32 *offset = (INT32 *)growBuffer(&cb->offsets, sizeof(INT32));
+    if (offset == NULL)
+        return FALSE;
+    *offset = (INT32)cb->data.len;
+    return TRUE;
+}
+
+static PyObject *bufferAsBytes(GrowBuffer *gb) { return PyString_FromStringAndSize(gb->ptr ? gb->ptr : "", gb->len); }
+
+/* @pymethod (int, [(format, data, offsets, validity), ...])|cursor|fetchcolumns|Fetches rows as one buffer per column */
+static PyObject *odbcCurFetchColumns(PyObject *self, PyObject *args)
+{
+    cursorObject *cur = cursor(self);
+    /* @pyparm int|maxRows|all remaining|Maximum number of rows to fetch */
+    long max_rows = LONG_MAX;
+    if (!PyArg_ParseTuple(args, "|l:fetchcolumns", &max_rows))
+        return NULL;
+    /* @rdesc Returns the number of rows fetched, and a tuple for each result column.
+        Instead of a Python object per value, each column's values are packed into
+        bytes laid out as an Apache Arrow array, ready for numpy.frombuffer or
+        pyarrow.Array.from_buffers.
+        @tupleitem 0|string|format|The Arrow format string - 'i' for 32 bit ints,
+        'g' for doubles, 'tsu:' for timestamps as 64 bit microseconds since 1970,
+        'u' for strings as utf8, or 'z' for binary (and 8 bit character) data.
+        @tupleitem 1|bytes|data|The values.  Fixed width types hold 0 for NULLs.
+        @tupleitem 2|bytes|offsets|For 'u' and 'z' columns, rows+1 32 bit offsets
+        into data marking the start and end of each value, else None.
+        @tupleitem 3|bytes|validity|A bitmap with a bit set for every non-NULL value,
+        least significant bit first.
+    */
+    /* @comm Rows are consumed from the result set just like <om cursor.fetchall>,
+        and the two can be mixed.  Combined with a large cursor.arraysize this
+        avoids creating any per-row or per-value Python objects. */
+    int n_columns = cur->n_columns, i;
+    OutputBinding *ob;
+    Py_ssize_t n = 0;
+    PyObject *ret = NULL;
+    ColumnBuilder *cols = (ColumnBuilder *)calloc(max(n_columns, 1), sizeof(ColumnBuilder));
+    if (cols == NULL)
+        return PyErr_NoMemory();
+
+    while (n < max_rows) {
+        int more = fetchBlock(cur);
+        if (more < 0)
+            goto Done;
+        if (more == 0)
+            break;
+        for (ob = cur->outputVars, i = 0; ob && i < n_columns; ob = ob->next, i++) {
+            if (!appendColumnValue(cur, &cols[i], ob, cur->block_pos, n))
+                goto Done;
+        }
+        cur->block_pos++;
+        n++;
+    }
+
+    {
+        PyObject *columns = PyList_New(n_columns);
+        if (columns == NULL)
+            goto Done;
+        for (ob = cur->outputVars, i = 0; ob && i < n_columns; ob = ob->next, i++) {
+            const char *format = columnFormat(ob);
+            BOOL variable = format[0] == 'u' || format[0] == 'z';
+            if (variable && n == 0) {
+                INT32 *first = (INT32 *)growBuffer(&cols[i].offsets, sizeof(INT32));
+                if (first == NULL) {
+                    Py_DECREF(columns);
+                    goto Done;
+                }
+                *first = 0;
+            }
+            PyObject *offsets = Py_None;
+            if (variable)
+                offsets = bufferAsBytes(&cols[i].offsets);
+            else
+                Py_INCREF(Py_None);
+            PyObject *col = Py_BuildValue("sNNN", format, bufferAsBytes(&cols[i].data), offsets,
+                                          bufferAsBytes(&cols[i].validity));
+            if (col == NULL) {
+                Py_DECREF(columns);
+                goto Done;
+            }
+            PyList_SET_ITEM(columns, i, col);
+        }
+        ret = Py_BuildValue("nN", n, columns);
+    }
+
+Done:
+    for (i = 0; i < n_columns; i++) {
+        free(cols[i].data.ptr);
+        free(cols[i].offsets.ptr);
+        free(cols[i].validity.ptr);
+    }
+    free(cols);
+    return ret;
+}
+
 /* @pymethod data|cursor|fetchone|Fetch one row of data */
 static PyObject *odbcCurFetchOne(PyObject *self, PyObject *args) { return fetchOne(cursor(self)); }
 
 /* @pymethod [data, ...]|cursor|fetchmany|Fetch many rows of data */
 static PyObject *odbcCurFetchMany(PyObject *self, PyObject *args)
 {
-    long n_rows = 1;
+    /* @pyparm int|size|cursor.arraysize|Number of rows to fetch */
+    long n_rows = max(cursor(self)->arraysize, 1);
 
     if (!PyArg_ParseTuple(args, "|l", &n_rows)) {
         return NULL;
     }
+    /* @comm If cursor.arraysize is greater than 1 when the query is executed, rows
+        are retrieved from the driver in blocks of that many rows per SQLFetch
+        call (unless the result has long columns that need SQLGetData), which also
+        speeds up <om cursor.fetchall>. */
 
     return fetchN(cursor(self), n_rows);
 }
@@ -1425,15 +2840,21 @@ static PyObject *odbcCurSetOutputSize(PyObject *self, PyObject *args)
 static PyMethodDef cursorMethods[] = {
     {"close", odbcCurClose, 1},                 /* @pymeth close|Closes the cursor */
     {"execute", odbcCurExec, 1},                /* @pymeth execute|Execute some SQL */
+    {"executeasync", odbcCurExecAsync, 1},      /* @pymeth executeasync|Starts executing some SQL */
+    {"poll", odbcCurPoll, 1},                   /* @pymeth poll|Checks whether an asynchronous statement has finished */
+    {"cancel", odbcCurCancel, 1},               /* @pymeth cancel|Cancels an asynchronous statement */
     {"fetchone", odbcCurFetchOne, 1},           /* @pymeth fetchone|Fetch one row of data */
     {"fetchmany", odbcCurFetchMany, 1},         /* @pymeth fetchmany|Fetch many rows of data */
     {"fetchall", odbcCurFetchAll, 1},           /* @pymeth fetchall|Fetch all the rows of data */
+    {"fetchcolumns", odbcCurFetchColumns, 1},   /* @pymeth fetchcolumns|Fetches rows as one buffer per column */
     {"setinputsizes", odbcCurSetInputSizes, 1}, /* @pymeth setinputsizes| */
     {"setoutputsize", odbcCurSetOutputSize, 1}, /* @pymeth setoutputsize| */
     {0, 0}};
 
 static PyMemberDef cursorMembers[] = {{"description", T_OBJECT, offsetof(cursorObject, description), READONLY},
                                       {"error", T_OBJECT, offsetof(cursorObject, cursorError), READONLY},
+                                      {"arraysize", T_LONG, offsetof(cursorObject, arraysize), 0},
+                                      {"streamlobs", T_INT, offsetof(cursorObject, streamlobs), 0},
                                       {NULL}};
 
 static void parseInfo(connectionObject *conn, const TCHAR *c)
@@ -1523,6 +2944,10 @@ static PyObject *odbcLogon(PyObject *self, PyObject *args)
     conn->connectionError = odbcError;
     Py_INCREF(odbcError);
     conn->connect_id = 0; /* initialize it to anything */
+    conn->connected = 0;
+    conn->stmt_cache = NULL;
+    conn->stmt_cache_size = DEFAULT_STMT_CACHE_SIZE;
+    conn->stmt_cache_count = 0;
     conn->hdbc = SQL_NULL_HDBC;
     conn->connectionString = NULL;
     if (unsuccessful(SQLAllocConnect(Env, &conn->hdbc))) {
@@ -1576,10 +3001,105 @@ static PyObject *odbcSQLDataSources(PyObject *self, PyObject *args)
     return ret;
 }
 
+/* @pymethod [<o cursor>, ...]|odbc|wait|Waits for statements started by <om cursor.executeasync> to finish */
+/* @rdesc The cursors whose statements have finished, which is empty if the timeout expired.
+    Call <om cursor.poll> on each to get their results. */
+static PyObject *odbcWait(PyObject *self, PyObject *args)
+{
+    PyObject *obcursors;
+    int timeout = -1;
+    /* @pyparm [<o cursor>, ...]|cursors||Cursors with statements executing asynchronously */
+    /* @pyparm int|timeout|-1|Milliseconds to wait, or -1 to wait until one has finished */
+    if (!PyArg_ParseTuple(args, "O|i:wait", &obcursors, &timeout))
+        return NULL;
+    /* A tuple of our own, so the cursors can't go away while the GIL is released */
+    TmpPyObject cursors = PySequence_Tuple(obcursors);
+    if (cursors == NULL)
+        return NULL;
+    Py_ssize_t n = PyTuple_GET_SIZE((PyObject *)cursors);
+    Py_ssize_t i;
+    for (i = 0; i < n; i++) {
+        PyObject *ob = PyTuple_GET_ITEM((PyObject *)cursors, i);
+        if (!PyObject_TypeCheck(ob, &Cursor_Type))
+            return PyErr_Format(PyExc_TypeError, "cursors must be a sequence of cursors, not %s", ob->ob_type->tp_name);
+        if (cursor(ob)->async_state == ASYNC_NONE)
+            return PyErr_Format(odbcError, "A cursor has no statement executing asynchronously");
+    }
+
+    BOOL any_done = FALSE;
+    DWORD start = GetTickCount();
+    DWORD pause = 1;
+    Py_BEGIN_ALLOW_THREADS for (;;)
+    {
+        for (i = 0; i < n; i++)
+            if (asyncStep(cursor(PyTuple_GET_ITEM((PyObject *)cursors, i))))
+                any_done = TRUE;
+        if (any_done)
+            break;
+        DWORD elapsed = GetTickCount() - start;
+        if (timeout >= 0 && elapsed >= (DWORD)timeout)
+            break;
+        if (timeout >= 0)
+            pause = min(pause, (DWORD)timeout - elapsed);
+        Sleep(pause);
+        /* Statements of slow queries are polled less often */
+        pause = min(pause * 2, 50);
+    }
+    Py_END_ALLOW_THREADS
+
+        PyObject *ret = PyList_New(0);
+    for (i = 0; ret && i < n; i++) {
+        PyObject *ob = PyTuple_GET_ITEM((PyObject *)cursors, i);
+        if (cursor(ob)->async_state == ASYNC_DONE && PyList_Append(ret, ob) == -1) {
+            Py_DECREF(ret);
+            ret = NULL;
+        }
+    }
+    return ret;
+    /* @comm The module's ODBC 2 environment doesn't give drivers a way to signal
+        completion, so the statements are polled, without the GIL, at intervals
+        which grow to 50ms while none has finished. */
+}
+
+/* @pymethod |odbc|setpoolsize|Sets how many idle connections are kept for reuse */
+static PyObject *odbcSetPoolSize(PyObject *self, PyObject *args)
+{
+    int size;
+    int idleTimeout = 60;
+    /* @pyparm int|size||The number of connections, or 0 to disable pooling, which is the default. */
+    /* @pyparm int|idleTimeout|60|Seconds an idle connection is kept for. */
+    if (!PyArg_ParseTuple(args, "i|i:setpoolsize", &size, &idleTimeout))
+        return NULL;
+    /* @comm With pooling enabled, the connection of a destroyed <o connection> is
+        kept open once any transaction is rolled back and autocommit is turned back on.
+        <om odbc.odbc> with the same connection string, or reconnecting after an error,
+        then reuses it instead of logging on again.  Connections the driver reports
+        as dead (SQL_ATTR_CONNECTION_DEAD) are dropped instead of being reused. */
+    poolSize = max(size, 0);
+    poolIdleTimeout = (DWORD)max(idleTimeout, 0) * 1000;
+    trimConnectionPool(poolSize);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+/* @pymethod dict|odbc|poolstats|Returns counts of the connection pool's use */
+/* @rdesc A dict with keys idle (connections in the pool), hits, misses
+    (connections which had to log on) and dead (pooled connections found dead). */
+static PyObject *odbcPoolStats(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":poolstats"))
+        return NULL;
+    return Py_BuildValue("{s:i,s:l,s:l,s:l}", "idle", poolCount, "hits", poolHits, "misses", poolMisses, "dead",
+                         poolDead);
+}
+
 /* @module odbc|A Python wrapper around the ODBC API. */
 static PyMethodDef globalMethods[] = {
     {"odbc", odbcLogon, 1},                    /* @pymeth odbc|Creates an <o connection> object. */
     {"SQLDataSources", odbcSQLDataSources, 1}, /* @pymeth SQLDataSources|Enumerates ODBC data sources. */
+    {"wait", odbcWait, 1},                     /* @pymeth wait|Waits for asynchronous statements to finish. */
+    {"setpoolsize", odbcSetPoolSize, 1},       /* @pymeth setpoolsize|Sets how many idle connections are kept. */
+    {"poolstats", odbcPoolStats, 1},           /* @pymeth poolstats|Returns counts of the connection pool's use. */
     {0, 0}};
 
 #define ADD_CONSTANT(tok)                                 \
@@ -1594,6 +3114,8 @@ PYWIN_MODULE_INIT_FUNC(odbc)
         PYWIN_MODULE_INIT_RETURN_ERROR;
     if (PyType_Ready(&Connection_Type) == -1)
         PYWIN_MODULE_INIT_RETURN_ERROR;
+    if (PyType_Ready(&Lob_Type) == -1)
+        PYWIN_MODULE_INIT_RETURN_ERROR;
 
     // Sql dates are now returned as python's datetime object.
     //	C Api for datetime didn't exist in 2.3, stick to dynamic semantics for now.
@@ -135,8 +135,9 @@ class CDDEItem : public CObject {
     virtual WORD *GetFormatList() { return NULL; }
     virtual BOOL CanAdvise(UINT wFmt);
 
-    CString m_strName;    // name of this item
-    CDDETopic *m_pTopic;  // pointer to the topic it belongs to
+    CString m_strName;       // name of this item
+    CDDETopic *m_pTopic;     // pointer to the topic it belongs to
+    BOOL m_bAdvisePending;   // TRUE while queued in the server's advise queue
 
    protected:
 };
@@ -339,6 +340,16 @@ class CDDEServer : public CObject {
     CString StringFromHsz(HSZ hsz);
     virtual BOOL CanAdvise(UINT wFmt, const TCHAR *pszTopic, const TCHAR *pszItem);
     void PostAdvise(CDDETopic *pTopic, CDDEItem *pItem);
+    // Advise coalescing - while a batch is open or an advise interval is set, PostAdvise
+    // just queues each changed item once, and FlushAdvises() posts one advise per item,
+    // so clients only fetch the latest value.
+    void BeginAdviseBatch();
+    void EndAdviseBatch();
+    void FlushAdvises();
+    void SetAdviseInterval(UINT nMilliseconds);
+    UINT GetAdviseInterval() { return m_nAdviseInterval; }
+    int GetPendingAdviseCount() { return (int)m_PendingAdvises.GetCount(); }
+    void CancelAdvise(CDDEItem *pItem);
     CDDEConv *AddConversation(HCONV hConv, HSZ hszTopic);
     CDDEConv *AddConversation(CDDEConv *pNewConv);
     BOOL RemoveConversation(HCONV hConv);
@@ -353,6 +364,15 @@ class CDDEServer : public CObject {
     CHSZ m_hszServiceName;     // String handle for service name
     CDDEConvList m_ConvList;   // Conversation list
 
+    CPtrList m_PendingAdvises;  // CDDEItem's with a queued advise, in the order they changed
+    int m_nAdviseBatch;         // BeginAdviseBatch nesting
+    UINT m_nAdviseInterval;     // ms to coalesce advises for; 0 posts them immediately
+    UINT_PTR m_idAdviseTimer;   // timer which flushes the queue after m_nAdviseInterval
+
+    void PostAdviseNow(CDDETopic *pTopic, CDDEItem *pItem);
+    void ScheduleAdviseFlush();
+    static void CALLBACK AdviseTimerProc(HWND hwnd, UINT uMsg, UINT_PTR idEvent, DWORD dwTime);
+
     HDDEDATA DoWildConnect(HSZ hszTopic);
     BOOL DoCallback(WORD wType, WORD wFmt, HCONV hConv, HSZ hsz1, HSZ hsz2, HDDEDATA hData, HDDEDATA *phReturnData);
     CDDETopic *FindTopic(const TCHAR *pszTopic);
@@ -116,6 +116,331 @@ static PyObject *py_timer_kill_timer(PyObject *self, PyObject *args)
     return PyBool_FromLong(rc);
 }
 
+// @object PyTimer|A timer which does not need a message loop, as returned by <om timer.create_timer>.
+// @comm The timer is a waitable timer, created with CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+// where the system supports it, so periods of a millisecond or two are honoured.
+// <nl>Each delivery passes the number of periods which have elapsed since the previous
+// delivery - if a callback or the thread calling <om PyTimer.wait> falls behind, missed
+// periods are coalesced into the next delivery rather than queued, and counted in the
+// overruns attribute.  Nothing is allocated per tick.
+// <nl>Without a callback, periods are collected by calling <om PyTimer.wait> from whichever
+// Python thread should run the periodic work.  With a callback, a native thread waits
+// for the timer and calls it - the thread keeps the timer alive, so <om PyTimer.close>
+// must be called to stop it.
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+typedef HANDLE(WINAPI *CreateWaitableTimerExWfunc)(LPSECURITY_ATTRIBUTES, LPCWSTR, DWORD, DWORD);
+static CreateWaitableTimerExWfunc pfnCreateWaitableTimerExW = NULL;
+
+struct PyTimer {
+    PyObject_HEAD HANDLE hTimer;
+    HANDLE hStop;  // signalled by close
+    BOOL bClosed;
+    BOOL bDone;  // a one-shot timer has fired
+    BOOL bHighResolution;
+    DWORD period;  // milliseconds, 0 for a one-shot timer
+    LONGLONG firstDue;  // performance counter value of the first expiry
+    LONGLONG periodTicks;  // the period in performance counter units
+    LONGLONG delivered;  // periods delivered so far
+    LONGLONG overruns;
+    PyObject *obCallback;
+    HANDLE hThread;
+    DWORD threadId;
+};
+
+extern PyTypeObject PyTimer_Type;
+
+#define PT_TICK 0
+#define PT_TIMEOUT 1
+#define PT_CLOSED 2
+#define PT_ERROR 3
+
+// Waits for the timer without the GIL.
+static int pt_wait(PyTimer *t, DWORD timeout)
+{
+    if (t->bClosed)
+        return PT_CLOSED;
+    HANDLE handles[2] = {t->hStop, t->hTimer};
+    // A one-shot timer which has fired only waits for close.
+    DWORD rc = WaitForMultipleObjects(t->bDone ? 1 : 2, handles, FALSE, timeout);
+    if (rc == WAIT_OBJECT_0)
+        return PT_CLOSED;
+    if (rc == WAIT_OBJECT_0 + 1)
+        return PT_TICK;
+    if (rc == WAIT_TIMEOUT)
+        return PT_TIMEOUT;
+    return PT_ERROR;
+}
+
+// Works out how many periods a tick represents - called with the GIL held, so
+// the counters need no other lock.
+static DWORD pt_count(PyTimer *t)
+{
+    if (t->period == 0) {
+        t->bDone = TRUE;
+        t->delivered = 1;
+        return 1;
+    }
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    LONGLONG expired = now.QuadPart >= t->firstDue ? (now.QuadPart - t->firstDue) / t->periodTicks + 1 : 1;
+    LONGLONG count = expired - t->delivered;
+    // The timer can be signalled fractionally before the performance counter says it is due.
+    if (count < 1)
+        count = 1;
+    t->delivered += count;
+    t->overruns += count - 1;
+    return (DWORD)count;
+}
+
+static DWORD WINAPI pt_thread(LPVOID param)
+{
+    PyTimer *t = (PyTimer *)param;
+    for (;;) {
+        int rc = pt_wait(t, INFINITE);
+        CEnterLeavePython _celp;
+        if (rc != PT_TICK) {
+            if (rc == PT_ERROR) {
+                PyWin_SetAPIError("WaitForMultipleObjects");
+                PyErr_Print();
+            }
+            break;
+        }
+        PyObject *obCount = PyLong_FromUnsignedLong(pt_count(t));
+        PyObject *result = obCount ? PyObject_CallFunctionObjArgs(t->obCallback, (PyObject *)t, obCount, NULL) : NULL;
+        if (!result)
+            PyErr_Print();
+        Py_XDECREF(result);
+        Py_XDECREF(obCount);
+        if (t->bDone)
+            break;
+    }
+    CEnterLeavePython _celp;
+    Py_DECREF(t);
+    return 0;
+}
+
+// Stops the timer, and the thread unless called from it.
+static void pt_close(PyTimer *t)
+{
+    if (t->bClosed)
+        return;
+    t->bClosed = TRUE;
+    CancelWaitableTimer(t->hTimer);
+    SetEvent(t->hStop);
+    if (t->hThread) {
+        if (t->threadId != GetCurrentThreadId()) {
+            Py_BEGIN_ALLOW_THREADS;
+            WaitForSingleObject(t->hThread, INFINITE);
+            Py_END_ALLOW_THREADS;
+        }
+        CloseHandle(t->hThread);
+        t->hThread = NULL;
+    }
+}
+
+static void pt_dealloc(PyObject *ob)
+{
+    PyTimer *t = (PyTimer *)ob;
+    // Any thread holds a reference, so it has gone by now.
+    pt_close(t);
+    if (t->hTimer)
+        CloseHandle(t->hTimer);
+    if (t->hStop)
+        CloseHandle(t->hStop);
+    Py_XDECREF(t->obCallback);
+    PyObject_Del(ob);
+}
+
+// @pymethod int|PyTimer|wait|Waits for the timer to expire.
+// @rdesc The number of periods which have elapsed since the previous call, or 0 if the
+// timeout expired first.
+// @comm Raises ValueError if the timer is closed, including by another thread while waiting.
+static PyObject *pt_wait_method(PyObject *self, PyObject *args)
+{
+    PyTimer *t = (PyTimer *)self;
+    DWORD timeout = INFINITE;
+    if (!PyArg_ParseTuple(args, "|k:wait",
+                          &timeout))  // @pyparm int|milliseconds|win32event.INFINITE|The time to wait.
+        return NULL;
+    if (t->obCallback)
+        return PyErr_Format(PyExc_TypeError, "This timer delivers its ticks to a callback");
+    int rc;
+    Py_BEGIN_ALLOW_THREADS;
+    rc = pt_wait(t, timeout);
+    Py_END_ALLOW_THREADS;
+    switch (rc) {
+        case PT_TICK:
+            return PyLong_FromUnsignedLong(pt_count(t));
+        case PT_TIMEOUT:
+            return PyLong_FromLong(0);
+        case PT_CLOSED:
+            return PyErr_Format(PyExc_ValueError, "The timer has been closed");
+    }
+    return PyWin_SetAPIError("WaitForMultipleObjects");
+}
+
+// @pymethod |PyTimer|close|Stops the timer.
+// @comm If called from the callback, the thread stops when the callback returns.
+static PyObject *pt_close_method(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":close"))
+        return NULL;
+    pt_close((PyTimer *)self);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject *pt_get_overruns(PyObject *self, void *unused)
+{
+    return PyLong_FromLongLong(((PyTimer *)self)->overruns);
+}
+
+static PyObject *pt_get_ticks(PyObject *self, void *unused)
+{
+    return PyLong_FromLongLong(((PyTimer *)self)->delivered);
+}
+
+static PyMethodDef pt_methods[] = {
+    {"wait", pt_wait_method, METH_VARARGS},  // @pymeth wait|Waits for the timer to expire.
+    {"close", pt_close_method, METH_VARARGS},  // @pymeth close|Stops the timer.
+    {NULL}};
+
+#define OFF(e) offsetof(PyTimer, e)
+static PyMemberDef pt_members[] = {
+    // @prop int|period|The period in milliseconds, or 0 for a one-shot timer.
+    {"period", T_ULONG, OFF(period), READONLY},
+    // @prop bool|high_resolution|True if the timer was created with CREATE_WAITABLE_TIMER_HIGH_RESOLUTION.
+    {"high_resolution", T_INT, OFF(bHighResolution), READONLY},
+    {NULL}};
+#undef OFF
+
+static PyGetSetDef pt_getset[] = {
+    // @prop int|ticks|The number of periods delivered, including those coalesced.
+    {"ticks", pt_get_ticks, NULL},
+    // @prop int|overruns|The number of periods which were coalesced into a later delivery.
+    {"overruns", pt_get_overruns, NULL},
+    {NULL}};
+
+PyTypeObject PyTimer_Type = {
+    PYWIN_OBJECT_HEAD "PyTimer",
+    sizeof(PyTimer),
+    0,
+    pt_dealloc,
+    0,  // tp_print;
+    0,  // tp_getattr
+    0,  // tp_setattr
+    0,  // tp_compare
+    0,  // tp_repr
+    0,  // tp_as_number
+    0,  // tp_as_sequence
+    0,  // tp_as_mapping
+    0,
+    0,                        /* tp_call */
+    0,                        /* tp_str */
+    PyObject_GenericGetAttr,  // tp_getattro
+    0,                        // tp_setattro
+    0,                        // tp_as_buffer;
+    Py_TPFLAGS_DEFAULT,       // tp_flags;
+    0,                        // tp_doc; /* Documentation string */
+    0,                        // traverseproc tp_traverse;
+    0,                        // tp_clear;
+    0,                        // tp_richcompare;
+    0,                        // tp_weaklistoffset;
+    0,                        // tp_iter
+    0,                        // iternextfunc tp_iternext
+    pt_methods,
+    pt_members,
+    pt_getset,  // tp_getset;
+};
+
+// @pymethod <o PyTimer>|timer|create_timer|Creates a timer which does not need a message loop
+// @comm Unlike <om timer.set_timer>, the timer works in any thread, and does not depend on
+// messages being pumped.
+static PyObject *py_timer_create_timer(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"period", "callback", "due", "high_resolution", NULL};
+    DWORD period, due = (DWORD)-1;
+    PyObject *callback = Py_None;
+    BOOL bHighResolution = TRUE;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "k|Oki:create_timer", keywords,
+            &period,    // @pyparm int|period||The period in milliseconds, or 0 for a timer which fires once.
+            &callback,  // @pyparm callable|callback|None|If specified, called from a native thread with 2 args:
+                        // (timer, count), where count is the number of periods since the previous call.
+            &due,  // @pyparm int|due|period|The time in milliseconds until the timer first fires.
+            &bHighResolution))  // @pyparm bool|high_resolution|True|Whether to ask for a high resolution timer.
+                                // It is silently ignored if the system does not support them.
+        return NULL;
+    if (callback != Py_None && !PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "callback must be a callable object");
+        return NULL;
+    }
+    if (period > MAXLONG)
+        return PyErr_Format(PyExc_ValueError, "period must be at most %ld", MAXLONG);
+    if (due == (DWORD)-1)
+        due = period;
+
+    HANDLE hTimer = NULL;
+    BOOL bGotHighResolution = FALSE;
+    if (bHighResolution && pfnCreateWaitableTimerExW) {
+        hTimer = (*pfnCreateWaitableTimerExW)(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        bGotHighResolution = hTimer != NULL;
+    }
+    if (hTimer == NULL)
+        hTimer = CreateWaitableTimerW(NULL, FALSE, NULL);
+    if (hTimer == NULL)
+        return PyWin_SetAPIError("CreateWaitableTimer");
+
+    PyTimer *t = PyObject_New(PyTimer, &PyTimer_Type);
+    if (t == NULL) {
+        CloseHandle(hTimer);
+        return NULL;
+    }
+    memset(((BYTE *)t) + sizeof(PyObject), 0, sizeof(PyTimer) - sizeof(PyObject));
+    t->hTimer = hTimer;
+    t->bHighResolution = bGotHighResolution;
+    t->period = period;
+    t->hStop = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (t->hStop == NULL) {
+        PyWin_SetAPIError("CreateEvent");
+        Py_DECREF(t);
+        return NULL;
+    }
+    LARGE_INTEGER freq, now, dueTime;
+    QueryPerformanceFrequency(&freq);
+    t->periodTicks = freq.QuadPart * period / 1000;
+    if (t->periodTicks < 1)
+        t->periodTicks = 1;
+    QueryPerformanceCounter(&now);
+    t->firstDue = now.QuadPart + freq.QuadPart * due / 1000;
+    // Negative means relative, in 100ns units.
+    dueTime.QuadPart = -(LONGLONG)due * 10000;
+    if (!SetWaitableTimer(hTimer, &dueTime, (LONG)period, NULL, NULL, FALSE)) {
+        PyWin_SetAPIError("SetWaitableTimer");
+        Py_DECREF(t);
+        return NULL;
+    }
+    if (callback != Py_None) {
+#if (PY_VERSION_HEX < 0x03070000)
+        PyEval_InitThreads();
+#endif
+        t->obCallback = callback;
+        Py_INCREF(callback);
+        Py_INCREF(t);  // owned by the thread.
+        t->hThread = CreateThread(NULL, 0, pt_thread, t, 0, &t->threadId);
+        if (t->hThread == NULL) {
+            PyWin_SetAPIError("CreateThread");
+            Py_DECREF(t);
+            Py_DECREF(t);
+            return NULL;
+        }
+    }
+    return (PyObject *)t;
+}
+
 #ifdef _DEBUG
 static PyObject *py_timer_timer_map(PyObject *self, PyObject *args)
 {
@@ -135,6 +460,10 @@ static struct PyMethodDef timer_functions[] = {
      "int = set_timer(milliseconds, callback}\nCreates a timer that executes a callback function"},
     // @pymeth kill_timer|Stops a timer
     {"kill_timer", py_timer_kill_timer, METH_VARARGS, "boolean = kill_timer(timer_id)\nStops a timer"},
+    // @pymeth create_timer|Creates a timer which does not need a message loop
+    {"create_timer", (PyCFunction)py_timer_create_timer, METH_VARARGS | METH_KEYWORDS,
+     "PyTimer = create_timer(period, callback=None, due=period, high_resolution=True)\nCreates a timer which does not "
+     "need a message loop"},
 #ifdef _DEBUG
     {"_id_timer_map", py_timer_timer_map, 1},
 #endif
@@ -152,6 +481,12 @@ PYWIN_MODULE_INIT_FUNC(timer)
         PYWIN_MODULE_INIT_RETURN_ERROR;
     if (PyDict_SetItemString(dict, "__version__", PyString_FromString("0.2")) == -1)
         PYWIN_MODULE_INIT_RETURN_ERROR;
+    if (PyType_Ready(&PyTimer_Type) == -1)
+        PYWIN_MODULE_INIT_RETURN_ERROR;
+
+    HMODULE hmod = GetModuleHandle(_T("kernel32.dll"));
+    if (hmod)
+        pfnCreateWaitableTimerExW = (CreateWaitableTimerExWfunc)GetProcAddress(hmod, "CreateWaitableTimerExW");
 
     PYWIN_MODULE_INIT_RETURN_SUCCESS;
 }
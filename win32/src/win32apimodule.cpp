@@ -3486,6 +3486,547 @@ static PyObject *PyRegNotifyChangeKeyValue(PyObject *self, PyObject *args)
     return ret;
 }
 
+// @object PyRegistryWatcher|Watches many registry keys for changes, as returned by
+// <om win32api.CreateRegistryWatcher>.
+// @comm Each key added with <om PyRegistryWatcher.AddKey> has its own notification
+// event, which is waited for by the system thread pool via RegisterWaitForSingleObject,
+// so no Python thread is needed per key.  The pool callback re-arms
+// RegNotifyChangeKeyValue before recording the change, so changes made while a batch
+// is being processed are not missed.
+// <nl>The system only reports that a key changed, not what changed.  Changes are
+// collected natively into batches - a batch is delivered once the coalescing window
+// has elapsed since its first change, and a key which changes several times within a
+// batch appears once, with a count of the notifications.
+// <nl>Each batch is a list of (cookie, count) tuples.  Batches are returned by
+// <om PyRegistryWatcher.GetEvents>, by iterating over the object, or if a callback was
+// given, passed to it from a native thread.  The thread keeps the watcher alive -
+// <om PyRegistryWatcher.Close> must be called to stop it.
+// <nl>Before Windows 8, a notification is cancelled when the thread which armed it exits,
+// which shows up as a single spurious change for the keys added by that thread.
+
+#ifndef REG_NOTIFY_THREAD_AGNOSTIC
+#define REG_NOTIFY_THREAD_AGNOSTIC 0x10000000L
+#endif
+
+struct PyRegistryWatcher;
+
+typedef struct {
+    PyRegistryWatcher *watcher;
+    LONG id;
+    HKEY hKey;
+    HANDLE hEvent;
+    HANDLE hWait;
+    BOOL bSubtree;
+    DWORD filter;
+    PyObject *obCookie;
+    DWORD count;   // notifications in the pending batch, 0 if not pending
+    BOOL bRemoved;  // set before the wait is unregistered
+} PyRegWatchKey;
+
+struct PyRegistryWatcher {
+    PyObject_HEAD CRITICAL_SECTION cs;  // protects the pending batch and the counters
+    HANDLE hReady;                      // auto-reset, signalled when a change is recorded
+    HANDLE hStop;                       // signalled by Close
+    DWORD window;                       // coalescing window in milliseconds
+    DWORD batchStart;                   // tick count of the first change in the batch
+    BOOL bClosed;
+    PyRegWatchKey **keys;  // only changed with the GIL and the critical section held
+    ULONG numKeys, maxKeys;
+    PyRegWatchKey **pending;  // keys with a non-zero count, in the order they changed
+    ULONG numPending, maxPending;
+    LONG nextId;
+    DWORD lastError;
+    PyObject *obCallback;
+    HANDLE hThread;
+    DWORD threadId;
+    LONG notifications;  // statistics
+    LONG coalesced;
+    LONG rearmFailures;
+    LONG batches;
+};
+
+extern PyTypeObject PyRegistryWatcher_Type;
+
+// Whether REG_NOTIFY_THREAD_AGNOSTIC is supported - cleared the first time it is rejected.
+static BOOL rw_bThreadAgnostic = TRUE;
+
+#define RW_TIMEOUT 0
+#define RW_BATCH 1
+#define RW_CLOSED 2
+
+static LONG rw_arm(PyRegWatchKey *k)
+{
+    LONG rc = ERROR_INVALID_PARAMETER;
+    if (rw_bThreadAgnostic) {
+        rc = RegNotifyChangeKeyValue(k->hKey, k->bSubtree, k->filter | REG_NOTIFY_THREAD_AGNOSTIC, k->hEvent, TRUE);
+        if (rc == ERROR_INVALID_PARAMETER)
+            rw_bThreadAgnostic = FALSE;
+    }
+    if (!rw_bThreadAgnostic)
+        rc = RegNotifyChangeKeyValue(k->hKey, k->bSubtree, k->filter, k->hEvent, TRUE);
+    return rc;
+}
+
+// Thread pool callback - runs without the GIL.
+static VOID CALLBACK rw_signalled(PVOID param, BOOLEAN timedOut)
+{
+    PyRegWatchKey *k = (PyRegWatchKey *)param;
+    PyRegistryWatcher *w = k->watcher;
+    // Re-arm before recording the change, so nothing after this point is missed.
+    LONG rc = rw_arm(k);
+    EnterCriticalSection(&w->cs);
+    if (!k->bRemoved && !w->bClosed) {
+        w->notifications++;
+        if (rc != ERROR_SUCCESS)
+            w->rearmFailures++;
+        if (k->count) {
+            k->count++;
+            w->coalesced++;
+        }
+        else if (w->numPending < w->maxPending) {
+            // maxPending is kept at maxKeys, so there is always room.
+            k->count = 1;
+            if (w->numPending == 0)
+                w->batchStart = GetTickCount();
+            w->pending[w->numPending++] = k;
+            SetEvent(w->hReady);
+        }
+    }
+    LeaveCriticalSection(&w->cs);
+}
+
+// Waits until a batch is ready, the timeout expires or the watcher is closed.
+// Called without the GIL or the critical section.
+static int rw_wait(PyRegistryWatcher *w, DWORD timeout)
+{
+    DWORD start = GetTickCount();
+    for (;;) {
+        EnterCriticalSection(&w->cs);
+        BOOL bClosed = w->bClosed;
+        ULONG numPending = w->numPending;
+        DWORD batchStart = w->batchStart;
+        LeaveCriticalSection(&w->cs);
+        if (bClosed)
+            return RW_CLOSED;
+        DWORD now = GetTickCount();
+        if (numPending && now - batchStart >= w->window)
+            return RW_BATCH;
+        DWORD wait = INFINITE;
+        if (timeout != INFINITE) {
+            if (now - start >= timeout)
+                return numPending ? RW_BATCH : RW_TIMEOUT;
+            wait = timeout - (now - start);
+        }
+        if (numPending && w->window - (now - batchStart) < wait)
+            wait = w->window - (now - batchStart);
+        HANDLE handles[2] = {w->hReady, w->hStop};
+        WaitForMultipleObjects(2, handles, FALSE, wait);
+    }
+}
+
+// Converts and clears the pending batch - called with the GIL held.
+static PyObject *rw_take_batch(PyRegistryWatcher *w)
+{
+    EnterCriticalSection(&w->cs);
+    PyObject *ret = PyList_New(w->numPending);
+    if (ret != NULL) {
+        for (ULONG i = 0; i < w->numPending; i++) {
+            PyRegWatchKey *k = w->pending[i];
+            PyObject *item = Py_BuildValue("Ok", k->obCookie, k->count);
+            if (item == NULL) {
+                Py_DECREF(ret);
+                ret = NULL;
+                break;
+            }
+            PyList_SET_ITEM(ret, i, item);
+        }
+    }
+    if (ret != NULL) {
+        for (ULONG i = 0; i < w->numPending; i++) w->pending[i]->count = 0;
+        if (w->numPending)
+            w->batches++;
+        w->numPending = 0;
+    }
+    LeaveCriticalSection(&w->cs);
+    return ret;
+}
+
+// Returns the next batch, an empty list on timeout, or NULL without an
+// exception set if the watcher is closed.
+static PyObject *rw_get_events(PyRegistryWatcher *w, DWORD timeout)
+{
+    int rc;
+    PyW32_BEGIN_ALLOW_THREADS rc = rw_wait(w, timeout);
+    PyW32_END_ALLOW_THREADS if (rc == RW_CLOSED) return NULL;
+    return rw_take_batch(w);
+}
+
+static DWORD WINAPI rw_thread(LPVOID param)
+{
+    PyRegistryWatcher *w = (PyRegistryWatcher *)param;
+    while (rw_wait(w, INFINITE) == RW_BATCH) {
+        CEnterLeavePython celp;
+        PyObject *batch = rw_take_batch(w);
+        PyObject *ret = batch ? PyObject_CallFunctionObjArgs(w->obCallback, batch, NULL) : NULL;
+        if (ret == NULL)
+            // Nothing to be done about an exception raised by the callback
+            PyErr_Print();
+        Py_XDECREF(ret);
+        Py_XDECREF(batch);
+    }
+    CEnterLeavePython celp;
+    Py_DECREF(w);
+    return 0;
+}
+
+// Unregisters the wait and closes the handles of a key which is no longer in the
+// keys array.  Called with the GIL held.
+static void rw_free_key(PyRegistryWatcher *w, PyRegWatchKey *k)
+{
+    EnterCriticalSection(&w->cs);
+    k->bRemoved = TRUE;
+    LeaveCriticalSection(&w->cs);
+    if (k->hWait) {
+        // Waits for any callback in progress, which needs the critical section - but not the GIL.
+        Py_BEGIN_ALLOW_THREADS UnregisterWaitEx(k->hWait, INVALID_HANDLE_VALUE);
+        Py_END_ALLOW_THREADS
+    }
+    EnterCriticalSection(&w->cs);
+    for (ULONG i = 0; i < w->numPending; i++) {
+        if (w->pending[i] == k) {
+            memmove(w->pending + i, w->pending + i + 1, (w->numPending - i - 1) * sizeof(PyRegWatchKey *));
+            w->numPending--;
+            break;
+        }
+    }
+    LeaveCriticalSection(&w->cs);
+    if (k->hKey)
+        RegCloseKey(k->hKey);
+    if (k->hEvent)
+        CloseHandle(k->hEvent);
+    Py_XDECREF(k->obCookie);
+    free(k);
+}
+
+// Stops all the waits, and the thread unless called from it.
+static void rw_close(PyRegistryWatcher *w)
+{
+    EnterCriticalSection(&w->cs);
+    BOOL bClosed = w->bClosed;
+    w->bClosed = TRUE;
+    LeaveCriticalSection(&w->cs);
+    if (bClosed)
+        return;
+    SetEvent(w->hStop);
+    if (w->hThread) {
+        if (w->threadId != GetCurrentThreadId()) {
+            Py_BEGIN_ALLOW_THREADS WaitForSingleObject(w->hThread, INFINITE);
+            Py_END_ALLOW_THREADS
+        }
+        CloseHandle(w->hThread);
+        w->hThread = NULL;
+    }
+    while (w->numKeys) {
+        PyRegWatchKey *k = w->keys[--w->numKeys];
+        rw_free_key(w, k);
+    }
+}
+
+static void rw_dealloc(PyObject *ob)
+{
+    PyRegistryWatcher *w = (PyRegistryWatcher *)ob;
+    // Any thread holds a reference, so it has gone by now.
+    rw_close(w);
+    DeleteCriticalSection(&w->cs);
+    if (w->hReady)
+        CloseHandle(w->hReady);
+    if (w->hStop)
+        CloseHandle(w->hStop);
+    free(w->keys);
+    free(w->pending);
+    Py_XDECREF(w->obCallback);
+    PyObject_Del(ob);
+}
+
+// @pymethod int|PyRegistryWatcher|AddKey|Starts watching a registry key.
+// @rdesc Returns an id for the key, which can be passed to <om PyRegistryWatcher.RemoveKey>.
+// @comm The watcher opens its own handle to the key, so the handle passed in may be closed.
+static PyObject *rw_AddKey(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Key", "SubKey", "WatchSubtree", "NotifyFilter", "Cookie", NULL};
+    PyRegistryWatcher *w = (PyRegistryWatcher *)self;
+    PyObject *obKey, *obSubKey = Py_None, *obCookie = Py_None;
+    BOOL bSubtree = TRUE;
+    DWORD filter = REG_NOTIFY_CHANGE_NAME | REG_NOTIFY_CHANGE_LAST_SET;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "O|OikO:AddKey", keywords,
+            &obKey,     // @pyparm <o PyHKEY>/int|Key||An open registry key, or one of the HKEY_* constants
+            &obSubKey,  // @pyparm <o PyUnicode>|SubKey|None|Name of a subkey of Key to watch, or None to watch Key itself
+            &bSubtree,  // @pyparm bool|WatchSubtree|True|Whether to report changes to any subkey
+            &filter,    // @pyparm int|NotifyFilter|REG_NOTIFY_CHANGE_NAME\|REG_NOTIFY_CHANGE_LAST_SET|Combination of
+                        // REG_NOTIFY_CHANGE_* constants
+            &obCookie))  // @pyparm object|Cookie|None|Identifies the key in each batch.  If None, the returned id is used.
+        return NULL;
+    if (w->bClosed)
+        return PyErr_Format(PyExc_ValueError, "The watcher has been closed");
+    HKEY hKey;
+    TmpWCHAR subKey;
+    if (!PyWinObject_AsHKEY(obKey, &hKey))
+        return NULL;
+    if (!PyWinObject_AsWCHAR(obSubKey, &subKey, TRUE))
+        return NULL;
+    PyRegWatchKey *k = (PyRegWatchKey *)malloc(sizeof(PyRegWatchKey));
+    if (k == NULL)
+        return PyErr_NoMemory();
+    memset(k, 0, sizeof(PyRegWatchKey));
+    k->watcher = w;
+    k->id = ++w->nextId;
+    k->bSubtree = bSubtree;
+    k->filter = filter;
+    if (obCookie == Py_None)
+        k->obCookie = PyLong_FromLong(k->id);
+    else {
+        k->obCookie = obCookie;
+        Py_INCREF(obCookie);
+    }
+    if (k->obCookie == NULL) {
+        free(k);
+        return NULL;
+    }
+    // Make room first, so nothing can fail once the wait is registered.
+    if (w->numKeys == w->maxKeys) {
+        ULONG maxKeys = w->maxKeys ? w->maxKeys * 2 : 16;
+        PyRegWatchKey **keys = (PyRegWatchKey **)realloc(w->keys, maxKeys * sizeof(PyRegWatchKey *));
+        if (keys != NULL)
+            w->keys = keys;
+        // The pool callbacks use the pending array, so it is only grown with the critical section held.
+        EnterCriticalSection(&w->cs);
+        PyRegWatchKey **pending = (PyRegWatchKey **)realloc(w->pending, maxKeys * sizeof(PyRegWatchKey *));
+        if (pending != NULL) {
+            w->pending = pending;
+            w->maxPending = maxKeys;
+        }
+        LeaveCriticalSection(&w->cs);
+        if (keys == NULL || pending == NULL) {
+            Py_DECREF(k->obCookie);
+            free(k);
+            return PyErr_NoMemory();
+        }
+        w->maxKeys = maxKeys;
+    }
+    LONG rc;
+    PyW32_BEGIN_ALLOW_THREADS rc = RegOpenKeyExW(hKey, subKey, 0, KEY_NOTIFY, &k->hKey);
+    PyW32_END_ALLOW_THREADS if (rc != ERROR_SUCCESS)
+    {
+        k->hKey = NULL;
+        rw_free_key(w, k);
+        return PyWin_SetAPIError("RegOpenKeyEx", rc);
+    }
+    k->hEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (k->hEvent == NULL) {
+        PyWin_SetAPIError("CreateEvent");
+        rw_free_key(w, k);
+        return NULL;
+    }
+    // Arm before the wait is registered, so changes made after this returns are seen.
+    rc = rw_arm(k);
+    if (rc != ERROR_SUCCESS) {
+        rw_free_key(w, k);
+        return PyWin_SetAPIError("RegNotifyChangeKeyValue", rc);
+    }
+    EnterCriticalSection(&w->cs);
+    w->keys[w->numKeys++] = k;
+    LeaveCriticalSection(&w->cs);
+    // WT_EXECUTEINWAITTHREAD keeps the re-arming on a thread which lives as long as the wait,
+    // for systems without REG_NOTIFY_THREAD_AGNOSTIC.  The callback is short and never blocks.
+    if (!RegisterWaitForSingleObject(&k->hWait, k->hEvent, rw_signalled, k, INFINITE, WT_EXECUTEINWAITTHREAD)) {
+        k->hWait = NULL;
+        PyWin_SetAPIError("RegisterWaitForSingleObject");
+        EnterCriticalSection(&w->cs);
+        w->numKeys--;
+        LeaveCriticalSection(&w->cs);
+        rw_free_key(w, k);
+        return NULL;
+    }
+    return PyLong_FromLong(k->id);
+}
+
+// @pymethod |PyRegistryWatcher|RemoveKey|Stops watching a registry key.
+// @comm Any changes to the key in the pending batch are discarded.
+static PyObject *rw_RemoveKey(PyObject *self, PyObject *args)
+{
+    PyRegistryWatcher *w = (PyRegistryWatcher *)self;
+    LONG id;
+    if (!PyArg_ParseTuple(args, "l:RemoveKey",
+                          &id))  // @pyparm int|id||The id returned by <om PyRegistryWatcher.AddKey>
+        return NULL;
+    for (ULONG i = 0; i < w->numKeys; i++) {
+        PyRegWatchKey *k = w->keys[i];
+        if (k->id == id) {
+            EnterCriticalSection(&w->cs);
+            memmove(w->keys + i, w->keys + i + 1, (w->numKeys - i - 1) * sizeof(PyRegWatchKey *));
+            w->numKeys--;
+            LeaveCriticalSection(&w->cs);
+            rw_free_key(w, k);
+            Py_INCREF(Py_None);
+            return Py_None;
+        }
+    }
+    return PyErr_Format(PyExc_KeyError, "No key with id %ld is being watched", id);
+}
+
+// @pymethod [(cookie, count), ...]|PyRegistryWatcher|GetEvents|Waits for the next batch of changes.
+// @rdesc The result is an empty list if the timeout expires with no changes.
+// @comm The batch may be delivered before the coalescing window has elapsed if
+// the timeout expires first.
+static PyObject *rw_GetEvents(PyObject *self, PyObject *args)
+{
+    PyRegistryWatcher *w = (PyRegistryWatcher *)self;
+    DWORD timeout = INFINITE;
+    if (!PyArg_ParseTuple(args, "|k:GetEvents",
+                          &timeout))  // @pyparm int|timeout|win32event.INFINITE|The time in milliseconds to wait.
+        return NULL;
+    if (w->obCallback)
+        return PyErr_Format(PyExc_TypeError, "This watcher delivers its events to a callback");
+    PyObject *ret = rw_get_events(w, timeout);
+    if (ret == NULL && !PyErr_Occurred())
+        PyErr_Format(PyExc_ValueError, "The watcher has been closed");
+    return ret;
+}
+
+static PyObject *rw_iternext(PyObject *self)
+{
+    PyRegistryWatcher *w = (PyRegistryWatcher *)self;
+    if (w->obCallback)
+        return PyErr_Format(PyExc_TypeError, "This watcher delivers its events to a callback");
+    // NULL without an exception stops the iteration once closed.
+    return rw_get_events(w, INFINITE);
+}
+
+// @pymethod |PyRegistryWatcher|Close|Stops watching all keys and closes their handles.
+// @comm A thread blocked in <om PyRegistryWatcher.GetEvents> raises ValueError, and an
+// iteration stops.  If called from the callback, the thread stops when the callback returns.
+static PyObject *rw_Close(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":Close"))
+        return NULL;
+    rw_close((PyRegistryWatcher *)self);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject *rw_get_keys(PyObject *self, void *unused)
+{
+    PyRegistryWatcher *w = (PyRegistryWatcher *)self;
+    return PyLong_FromUnsignedLong(w->numKeys);
+}
+
+static PyMethodDef rw_methods[] = {
+    {"AddKey", (PyCFunction)rw_AddKey, METH_KEYWORDS | METH_VARARGS},  // @pymeth AddKey|Starts watching a key.
+    {"RemoveKey", rw_RemoveKey, METH_VARARGS},                         // @pymeth RemoveKey|Stops watching a key.
+    {"GetEvents", rw_GetEvents, METH_VARARGS},  // @pymeth GetEvents|Waits for the next batch of changes.
+    {"Close", rw_Close, METH_VARARGS},          // @pymeth Close|Stops watching all keys.
+    {NULL}};
+
+#define OFF(e) offsetof(PyRegistryWatcher, e)
+static PyMemberDef rw_members[] = {
+    // @prop int|notifications|The number of notifications received from the system.
+    {"notifications", T_LONG, OFF(notifications), READONLY},
+    // @prop int|coalesced|The number of notifications merged into an entry already in the batch.
+    {"coalesced", T_LONG, OFF(coalesced), READONLY},
+    // @prop int|rearmFailures|The number of times a notification could not be re-armed, usually because the key was
+    // deleted.  No further changes are reported for such a key.
+    {"rearmFailures", T_LONG, OFF(rearmFailures), READONLY},
+    // @prop int|batches|The number of batches delivered.
+    {"batches", T_LONG, OFF(batches), READONLY},
+    {NULL}};
+#undef OFF
+
+static PyGetSetDef rw_getset[] = {
+    // @prop int|keys|The number of keys being watched.
+    {"keys", rw_get_keys, NULL},
+    {NULL}};
+
+PyTypeObject PyRegistryWatcher_Type = {
+    PYWIN_OBJECT_HEAD "PyRegistryWatcher",
+    sizeof(PyRegistryWatcher),
+    0,
+    rw_dealloc,
+    0,  // tp_print;
+    0,  // tp_getattr
+    0,  // tp_setattr
+    0,  // tp_compare
+    0,  // tp_repr
+    0,  // tp_as_number
+    0,  // tp_as_sequence
+    0,  // tp_as_mapping
+    0,
+    0,                        /* tp_call */
+    0,                        /* tp_str */
+    PyObject_GenericGetAttr,  // tp_getattro
+    0,                        // tp_setattro
+    0,                        // tp_as_buffer;
+    Py_TPFLAGS_DEFAULT,       // tp_flags;
+    0,                        // tp_doc; /* Documentation string */
+    0,                        // traverseproc tp_traverse;
+    0,                        // tp_clear;
+    0,                        // tp_richcompare;
+    0,                        // tp_weaklistoffset;
+    PyObject_SelfIter,        // tp_iter
+    rw_iternext,              // iternextfunc tp_iternext
+    rw_methods,
+    rw_members,
+    rw_getset,  // tp_getset;
+};
+
+// @pymethod <o PyRegistryWatcher>|win32api|CreateRegistryWatcher|Creates an object which watches many registry keys
+// for changes
+// @comm Keys are added with <om PyRegistryWatcher.AddKey>.
+static PyObject *PyCreateRegistryWatcher(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Callback", "Window", NULL};
+    PyObject *obCallback = Py_None;
+    DWORD window = 50;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|Ok:CreateRegistryWatcher", keywords,
+            &obCallback,  // @pyparm callable|Callback|None|If specified, called from a native thread with each batch.
+            &window))  // @pyparm int|Window|50|The coalescing window in milliseconds.  0 delivers each change as soon as
+                       // it is seen.
+        return NULL;
+    if (obCallback != Py_None && !PyCallable_Check(obCallback))
+        return PyErr_Format(PyExc_TypeError, "Callback must be callable");
+#if (PY_VERSION_HEX < 0x03070000)
+    if (obCallback != Py_None)
+        PyEval_InitThreads();
+#endif
+    PyRegistryWatcher *w = PyObject_New(PyRegistryWatcher, &PyRegistryWatcher_Type);
+    if (w == NULL)
+        return NULL;
+    memset(((BYTE *)w) + sizeof(PyObject), 0, sizeof(PyRegistryWatcher) - sizeof(PyObject));
+    InitializeCriticalSection(&w->cs);
+    w->window = window;
+    w->hReady = CreateEvent(NULL, FALSE, FALSE, NULL);
+    w->hStop = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (w->hReady == NULL || w->hStop == NULL) {
+        PyWin_SetAPIError("CreateEvent");
+        Py_DECREF(w);
+        return NULL;
+    }
+    if (obCallback != Py_None) {
+        w->obCallback = obCallback;
+        Py_INCREF(obCallback);
+        Py_INCREF(w);  // owned by the thread.
+        w->hThread = CreateThread(NULL, 0, rw_thread, w, 0, &w->threadId);
+        if (w->hThread == NULL) {
+            PyWin_SetAPIError("CreateThread");
+            Py_DECREF(w);
+            Py_DECREF(w);
+            return NULL;
+        }
+    }
+    return (PyObject *)w;
+}
+
 void PyWinObject_FreeRegistryValue(DWORD typ, BYTE *buf)
 {
     if (!buf)
@@ -4128,6 +4669,310 @@ static PyObject *PyRegQueryValueEx(PyObject *self, PyObject *args)
     // retrieves the data for the given value.
 }
 
+// RegReadTree support.  The subtree is walked without the GIL, writing every
+// key and value into one growing buffer of records, which is then turned into
+// Python objects in a single pass.
+#define REGTREE_VALUE 0  // a value of the current key
+#define REGTREE_KEY 1    // a subkey - its values and subkeys follow, up to the matching REGTREE_END
+#define REGTREE_END 2
+// Each record is followed by its data (so REG_DWORD etc are aligned) then its
+// name, and padded to a multiple of 8 bytes.
+struct REGTREE_RECORD {
+    DWORD kind;
+    DWORD type;
+    DWORD cchName;
+    DWORD cbData;
+};
+#define REGTREE_RECORD_SIZE(cchName, cbData) \
+    ((sizeof(REGTREE_RECORD) + (cbData) + (cchName) * sizeof(WCHAR) + 7) & ~(size_t)7)
+#define REGTREE_MAX_NAME 16384  // the longest value name is 16383 characters
+
+struct REGTREE_WALK {
+    REGSAM sam;
+    // The records.
+    BYTE *buf;
+    size_t cbUsed, cbSize;
+    // Enumeration buffers, reused for every key.
+    WCHAR *name;
+    DWORD cbName;
+    BYTE *data;
+    DWORD cbData;
+};
+
+static BOOL RegTreeGrow(void **pbuf, DWORD *psize, DWORD size)
+{
+    if (size <= *psize)
+        return TRUE;
+    void *p = realloc(*pbuf, size);
+    if (p == NULL)
+        return FALSE;
+    *pbuf = p;
+    *psize = size;
+    return TRUE;
+}
+
+static BOOL RegTreeAppend(REGTREE_WALK *w, DWORD kind, DWORD type, const WCHAR *name, DWORD cchName,
+                          const BYTE *data, DWORD cbData)
+{
+    size_t cb = REGTREE_RECORD_SIZE(cchName, cbData);
+    if (w->cbUsed + cb > w->cbSize) {
+        size_t size = w->cbSize ? w->cbSize * 2 : 65536;
+        while (size < w->cbUsed + cb) size *= 2;
+        BYTE *p = (BYTE *)realloc(w->buf, size);
+        if (p == NULL)
+            return FALSE;
+        w->buf = p;
+        w->cbSize = size;
+    }
+    REGTREE_RECORD *rec = (REGTREE_RECORD *)(w->buf + w->cbUsed);
+    rec->kind = kind;
+    rec->type = type;
+    rec->cchName = cchName;
+    rec->cbData = cbData;
+    BYTE *p = (BYTE *)(rec + 1);
+    if (cbData)
+        memcpy(p, data, cbData);
+    if (cchName)
+        memcpy(p + cbData, name, cchName * sizeof(WCHAR));
+    w->cbUsed += cb;
+    return TRUE;
+}
+
+// Called without the GIL.  depth is the number of levels of subkeys still to
+// be read, or negative for no limit.
+static LONG RegTreeWalk(REGTREE_WALK *w, HKEY hKey, int depth)
+{
+    DWORD cValues, cchMaxSubKey, cchMaxValueName, cbMaxValue;
+    LONG rc = RegQueryInfoKeyW(hKey, NULL, NULL, NULL, NULL, &cchMaxSubKey, NULL, &cValues, &cchMaxValueName,
+                               &cbMaxValue, NULL, NULL);
+    if (rc != ERROR_SUCCESS)
+        return rc;
+    DWORD cchMax = (cchMaxSubKey > cchMaxValueName ? cchMaxSubKey : cchMaxValueName) + 1;
+    if (!RegTreeGrow((void **)&w->name, &w->cbName, cchMax * sizeof(WCHAR)) ||
+        !RegTreeGrow((void **)&w->data, &w->cbData, cbMaxValue > 64 ? cbMaxValue : 64))
+        return ERROR_OUTOFMEMORY;
+    DWORD cchNameBuf = w->cbName / sizeof(WCHAR);
+    for (DWORD i = 0; i < cValues; i++) {
+        DWORD cchName = cchNameBuf, cbData = w->cbData, type;
+        rc = RegEnumValueW(hKey, i, w->name, &cchName, NULL, &type, w->data, &cbData);
+        if (rc == ERROR_MORE_DATA) {
+            // The value changed since we asked - make room and try again.
+            if (!RegTreeGrow((void **)&w->name, &w->cbName, REGTREE_MAX_NAME * sizeof(WCHAR)) ||
+                !RegTreeGrow((void **)&w->data, &w->cbData, cbData > w->cbData ? cbData : w->cbData * 2 + 64))
+                return ERROR_OUTOFMEMORY;
+            cchNameBuf = w->cbName / sizeof(WCHAR);
+            i--;
+            continue;
+        }
+        if (rc == ERROR_NO_MORE_ITEMS)
+            break;  // values were deleted as we went.
+        if (rc != ERROR_SUCCESS)
+            return rc;
+        if (!RegTreeAppend(w, REGTREE_VALUE, type, w->name, cchName, w->data, cbData))
+            return ERROR_OUTOFMEMORY;
+    }
+    if (depth == 0)
+        return ERROR_SUCCESS;
+    for (DWORD i = 0;; i++) {
+        DWORD cchName = cchNameBuf;
+        rc = RegEnumKeyExW(hKey, i, w->name, &cchName, NULL, NULL, NULL, NULL);
+        if (rc == ERROR_NO_MORE_ITEMS)
+            break;
+        if (rc == ERROR_MORE_DATA) {
+            if (!RegTreeGrow((void **)&w->name, &w->cbName, REGTREE_MAX_NAME * sizeof(WCHAR)))
+                return ERROR_OUTOFMEMORY;
+            cchNameBuf = w->cbName / sizeof(WCHAR);
+            i--;
+            continue;
+        }
+        if (rc != ERROR_SUCCESS)
+            return rc;
+        HKEY hSubKey;
+        rc = RegOpenKeyExW(hKey, w->name, 0, w->sam, &hSubKey);
+        // Skip keys we may not read, and those deleted since the enumeration.
+        if (rc == ERROR_ACCESS_DENIED || rc == ERROR_FILE_NOT_FOUND)
+            continue;
+        if (rc != ERROR_SUCCESS)
+            return rc;
+        if (!RegTreeAppend(w, REGTREE_KEY, 0, w->name, cchName, NULL, 0))
+            rc = ERROR_OUTOFMEMORY;
+        else
+            rc = RegTreeWalk(w, hSubKey, depth - 1);
+        RegCloseKey(hSubKey);
+        if (rc != ERROR_SUCCESS)
+            return rc;
+        if (!RegTreeAppend(w, REGTREE_END, 0, NULL, 0, NULL, 0))
+            return ERROR_OUTOFMEMORY;
+        // The recursion may have moved the name buffer.
+        cchNameBuf = w->cbName / sizeof(WCHAR);
+    }
+    return ERROR_SUCCESS;
+}
+
+static const REGTREE_RECORD *RegTreeNext(const BYTE **pp)
+{
+    const REGTREE_RECORD *rec = (const REGTREE_RECORD *)*pp;
+    *pp += REGTREE_RECORD_SIZE(rec->cchName, rec->cbData);
+    return rec;
+}
+
+#define REGTREE_DATA(rec) ((BYTE *)((rec) + 1))
+#define REGTREE_NAME(rec) ((WCHAR *)(REGTREE_DATA(rec) + (rec)->cbData))
+
+// Builds {'values': {name: (data, type)}, 'subkeys': {name: {...}}} from the
+// records of one key.
+static PyObject *RegTreeBuildKey(const BYTE **pp, const BYTE *end)
+{
+    PyObject *values = PyDict_New();
+    PyObject *subkeys = PyDict_New();
+    PyObject *ret = NULL;
+    if (values == NULL || subkeys == NULL)
+        goto done;
+    while (*pp < end) {
+        const REGTREE_RECORD *rec = RegTreeNext(pp);
+        if (rec->kind == REGTREE_END)
+            break;
+        PyObject *obName = PyWinObject_FromWCHAR(REGTREE_NAME(rec), rec->cchName);
+        PyObject *obItem;
+        if (obName == NULL)
+            goto done;
+        if (rec->kind == REGTREE_KEY)
+            obItem = RegTreeBuildKey(pp, end);
+        else
+            obItem = Py_BuildValue("Nk", PyWinObject_FromRegistryValue(REGTREE_DATA(rec), rec->cbData, rec->type),
+                                   rec->type);
+        int err = obItem == NULL ? -1 : PyDict_SetItem(rec->kind == REGTREE_KEY ? subkeys : values, obName, obItem);
+        Py_DECREF(obName);
+        Py_XDECREF(obItem);
+        if (err == -1)
+            goto done;
+    }
+    ret = Py_BuildValue("{s:O,s:O}", "values", values, "subkeys", subkeys);
+done:
+    Py_XDECREF(values);
+    Py_XDECREF(subkeys);
+    return ret;
+}
+
+// Appends (path, name, type, data) for every value in the records of one key
+// (and its subkeys) to list.  path holds the key's path, of cchPath chars.
+static BOOL RegTreeBuildFlat(const BYTE **pp, const BYTE *end, PyObject *list, WCHAR **path, size_t *cchPathBuf,
+                             size_t cchPath)
+{
+    PyObject *obPath = NULL;  // created when the key's first value is seen.
+    BOOL ok = TRUE;
+    while (ok && *pp < end) {
+        const REGTREE_RECORD *rec = RegTreeNext(pp);
+        if (rec->kind == REGTREE_END)
+            break;
+        if (rec->kind == REGTREE_KEY) {
+            size_t cchSub = cchPath + (cchPath ? 1 : 0) + rec->cchName;
+            if (cchSub > *cchPathBuf) {
+                size_t size = cchSub * 2;
+                WCHAR *p = (WCHAR *)realloc(*path, size * sizeof(WCHAR));
+                if (p == NULL) {
+                    PyErr_NoMemory();
+                    ok = FALSE;
+                    break;
+                }
+                *path = p;
+                *cchPathBuf = size;
+            }
+            WCHAR *p = *path + cchPath;
+            if (cchPath)
+                *p++ = L'\\';
+            memcpy(p, REGTREE_NAME(rec), rec->cchName * sizeof(WCHAR));
+            ok = RegTreeBuildFlat(pp, end, list, path, cchPathBuf, cchSub);
+            continue;
+        }
+        if (obPath == NULL && (obPath = PyWinObject_FromWCHAR(*path, (int)cchPath)) == NULL) {
+            ok = FALSE;
+            break;
+        }
+        PyObject *obItem = Py_BuildValue("ONkN", obPath, PyWinObject_FromWCHAR(REGTREE_NAME(rec), rec->cchName),
+                                         rec->type,
+                                         PyWinObject_FromRegistryValue(REGTREE_DATA(rec), rec->cbData, rec->type));
+        ok = obItem != NULL && PyList_Append(list, obItem) == 0;
+        Py_XDECREF(obItem);
+    }
+    Py_XDECREF(obPath);
+    return ok;
+}
+
+// @pymethod dict/list|win32api|RegReadTree|Reads all the values of a key and its subkeys in one call.
+// @comm Accepts keyword arguments.
+// @comm The whole subtree is read with the GIL released, reusing the same buffers
+// (sized via RegQueryInfoKey) for every key, before any Python objects are created.
+// Subkeys which can not be opened (for example, due to their security) are skipped.
+static PyObject *PyRegReadTree(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Key", "SubKey", "Depth", "Flat", "samDesired", NULL};
+    HKEY hKey, hRoot;
+    PyObject *obKey, *obsubKey = Py_None, *ret = NULL;
+    int depth = -1, flat = FALSE;
+    REGSAM sam = KEY_READ;
+    TmpWCHAR subKey;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "O|Oiik:RegReadTree", keywords,
+            &obKey,     // @pyparm <o PyHKEY>/int|Key||An already open key, or one of the win32con.HKEY_* values
+            &obsubKey,  // @pyparm <o PyUnicode>|SubKey|None|The subkey to read, or None to read Key itself
+            &depth,     // @pyparm int|Depth|-1|The number of levels of subkeys to read - 0 reads only the values of
+                        // the key itself, and -1 the entire subtree.
+            &flat,      // @pyparm bool|Flat|False|If True, a flat list is returned instead of nested dictionaries.
+            &sam))      // @pyparm int|samDesired|KEY_READ|The access used to open each key - KEY_WOW64_32KEY or
+                        // KEY_WOW64_64KEY may be added to select a registry view.
+        return NULL;
+    if (!PyWinObject_AsHKEY(obKey, &hKey) || !PyWinObject_AsWCHAR(obsubKey, &subKey, TRUE))
+        return NULL;
+
+    REGTREE_WALK w;
+    ZeroMemory(&w, sizeof(w));
+    w.sam = sam;
+    LONG rc;
+    PyW32_BEGIN_ALLOW_THREADS rc = RegOpenKeyExW(hKey, subKey, 0, sam, &hRoot);
+    if (rc == ERROR_SUCCESS) {
+        rc = RegTreeWalk(&w, hRoot, depth);
+        // A predefined key opened with no subkey comes back as itself.
+        if (hRoot != hKey)
+            RegCloseKey(hRoot);
+    }
+    PyW32_END_ALLOW_THREADS free(w.name);
+    free(w.data);
+    if (rc == ERROR_OUTOFMEMORY) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    if (rc != ERROR_SUCCESS) {
+        PyWin_SetAPIError("RegReadTree", rc);
+        goto done;
+    }
+    {
+        const BYTE *p = w.buf, *end = w.buf + w.cbUsed;
+        if (!flat)
+            ret = RegTreeBuildKey(&p, end);
+        else {
+            // @rdesc If Flat is False, the result is a dictionary with the keys 'values' - a dictionary
+            // mapping each value name to a (data, type) tuple, as returned by <om win32api.RegQueryValueEx>
+            // - and 'subkeys', mapping each subkey name to a dictionary of the same form.
+            // <nl>If Flat is True, the result is a list of (path, name, type, data) tuples, one for each
+            // value, where path is the key's path relative to the key being read ('' for its own values).
+            size_t cchPathBuf = 256;
+            WCHAR *path = (WCHAR *)malloc(cchPathBuf * sizeof(WCHAR));
+            ret = PyList_New(0);
+            if (path == NULL) {
+                PyErr_NoMemory();
+                Py_CLEAR(ret);
+            }
+            else if (ret && !RegTreeBuildFlat(&p, end, ret, &path, &cchPathBuf, 0))
+                Py_CLEAR(ret);
+            free(path);
+        }
+    }
+done:
+    free(w.buf);
+    return ret;
+}
+
 // @pymethod |win32api|RegRestoreKey|Restores a key and subkeys from a saved registry file
 // @pyseeapi RegRestoreKey
 // @comm Implemented only as Unicode (RegRestoreKeyW).  Accepts keyword arguments.
@@ -6166,6 +7011,9 @@ static struct PyMethodDef win32api_functions[] = {
     {"CloseHandle", PyCloseHandle, 1},  // @pymeth CloseHandle|Closes an open handle.
     {"CommandLineToArgv", PyCommandLineToArgv, 1}, // @pymeth CommandLineToArgv|Parses a Unicode command line string and returns a list of command line arguments, in a way that is similar to sys.argv.
     {"CopyFile", PyCopyFile, 1},        // @pymeth CopyFile|Copy a file.
+    {"CreateRegistryWatcher", (PyCFunction)PyCreateRegistryWatcher,
+     METH_KEYWORDS | METH_VARARGS},  // @pymeth CreateRegistryWatcher|Creates an object which watches many registry keys
+                                     // for changes
     {"DebugBreak", PyDebugBreak, 1},    // @pymeth DebugBreak|Breaks into the C debugger.
     {"DeleteFile", PyDeleteFile, 1},    // @pymeth DeleteFile|Deletes the specified file.
     {"DragQueryFile", PyDragQueryFile, 1},      // @pymeth DragQueryFile|Retrieve the file names for dropped files.
@@ -6424,6 +7272,8 @@ static struct PyMethodDef win32api_functions[] = {
                                                 // value for a specified key in the registry.
     {"RegQueryValueEx", PyRegQueryValueEx, 1},  // @pymeth RegQueryValueEx|Retrieves the type and data for a specified
                                                 // value name associated with an open registry key.
+    {"RegReadTree", (PyCFunction)PyRegReadTree,
+     METH_KEYWORDS | METH_VARARGS},  // @pymeth RegReadTree|Reads all the values of a key and its subkeys in one call.
     {"RegQueryInfoKey", PyRegQueryInfoKey, 1},  // @pymeth RegQueryInfoKey|Returns information about the specified key.
     {"RegQueryInfoKeyW", PyRegQueryInfoKeyW,
      1},  // @pymeth RegQueryInfoKeyW|Returns information about an open registry key
@@ -6530,6 +7380,8 @@ PYWIN_MODULE_INIT_FUNC(win32api)
     if (PyType_Ready(&PyDISPLAY_DEVICEType) == -1 ||
         PyDict_SetItemString(dict, "PyDISPLAY_DEVICEType", (PyObject *)&PyDISPLAY_DEVICEType) == -1)
         PYWIN_MODULE_INIT_RETURN_ERROR;
+    if (PyType_Ready(&PyRegistryWatcher_Type) == -1)
+        PYWIN_MODULE_INIT_RETURN_ERROR;
 
     PyModule_AddIntConstant(module, "NameUnknown", NameUnknown);
     PyModule_AddIntConstant(module, "NameFullyQualifiedDN", NameFullyQualifiedDN);
@@ -18,6 +18,7 @@
 #define PY_SSIZE_T_CLEAN  // this should be Py_ssize_t clean!
 
 #include "pywintypes.h"
+#include "structmember.h"
 
 #define CHECK_NO_ARGS2(args, fnName)              \
     do {                                          \
@@ -39,6 +40,9 @@
 
 PyObject *ReturnAPIError(char *fnName, long err = 0) { return PyWin_SetAPIError(fnName, err); }
 
+// Callbacks registered by SetClipboardDataDelayed, keyed by format
+static PyObject *delayed_renderers = NULL;
+
 //*****************************************************************************
 //
 // @pymethod int|win32clipboard|ChangeClipboardChain|The ChangeClipboardChain
@@ -167,6 +171,8 @@ static PyObject *py_empty_clipboard(PyObject *self, PyObject *args)
     if (!rc) {
         return ReturnAPIError("EmptyClipboard");
     }
+    // Any formats we were going to render have gone
+    PyDict_Clear(delayed_renderers);
 
     RETURN_NONE;
 
@@ -799,6 +805,46 @@ static PyObject *py_register_clipboard_format(PyObject *self, PyObject *args)
     // info.
 }
 
+// Converts an integer handle, or places a copy of a string or buffer in new global memory.
+// *pbAllocated is set if the caller owns a new handle, which is only passed to the system by
+// a successful SetClipboardData.
+static BOOL PyWinObject_AsClipboardHANDLE(PyObject *obhandle, HANDLE *phandle, BOOL *pbAllocated)
+{
+    *pbAllocated = FALSE;
+    if (PyWinObject_AsHANDLE(obhandle, phandle))
+        return TRUE;
+    PyErr_Clear();
+
+    const void *buf = NULL;
+    Py_ssize_t bufSize = 0;
+    PyWinBufferView pybuf;
+    // In py3k, unicode no longer supports buffer interface
+    if (PyUnicode_Check(obhandle)) {
+        bufSize = PyUnicode_GET_DATA_SIZE(obhandle) + sizeof(Py_UNICODE);
+        buf = (void *)PyUnicode_AS_UNICODE(obhandle);
+    }
+    else {
+        if (!pybuf.init(obhandle))
+            return FALSE;
+        buf = pybuf.ptr();
+        bufSize = pybuf.len();
+        if (PyString_Check(obhandle))
+            bufSize++;  // size doesnt include nulls!
+                        // else assume buffer needs no terminator...
+    }
+    HANDLE handle = GlobalAlloc(GHND, bufSize);
+    if (handle == NULL) {
+        ReturnAPIError("GlobalAlloc");
+        return FALSE;
+    }
+    void *dest = GlobalLock(handle);
+    memcpy(dest, buf, bufSize);
+    GlobalUnlock(handle);
+    *phandle = handle;
+    *pbAllocated = TRUE;
+    return TRUE;
+}
+
 //*****************************************************************************
 //
 // @pymethod int|win32clipboard|SetClipboardData|The SetClipboardData function
@@ -827,37 +873,12 @@ static PyObject *py_set_clipboard_data(PyObject *self, PyObject *args)
     int format;
     HANDLE handle;
     PyObject *obhandle;
+    BOOL bAllocated;
 
     if (!PyArg_ParseTuple(args, "iO:SetClipboardData", &format, &obhandle))
         return NULL;
-    if (!PyWinObject_AsHANDLE(obhandle, &handle)) {
-        PyErr_Clear();
-
-        const void *buf = NULL;
-        Py_ssize_t bufSize = 0;
-        PyWinBufferView pybuf;
-        // In py3k, unicode no longer supports buffer interface
-        if (PyUnicode_Check(obhandle)) {
-            bufSize = PyUnicode_GET_DATA_SIZE(obhandle) + sizeof(Py_UNICODE);
-            buf = (void *)PyUnicode_AS_UNICODE(obhandle);
-        }
-        else {
-            if (!pybuf.init(obhandle))
-                return NULL;
-            buf = pybuf.ptr();
-            bufSize = pybuf.len();
-            if (PyString_Check(obhandle))
-                bufSize++;  // size doesnt include nulls!
-                            // else assume buffer needs no terminator...
-        }
-        handle = GlobalAlloc(GHND, bufSize);
-        if (handle == NULL) {
-            return ReturnAPIError("GlobalAlloc");
-        }
-        void *dest = GlobalLock(handle);
-        memcpy(dest, buf, bufSize);
-        GlobalUnlock(handle);
-    }
+    if (!PyWinObject_AsClipboardHANDLE(obhandle, &handle, &bAllocated))
+        return NULL;
     HANDLE data;
     Py_BEGIN_ALLOW_THREADS;
     data = SetClipboardData((UINT)format, handle);
@@ -1007,15 +1028,726 @@ static PyObject *py_set_clipboard_viewer(PyObject *self, PyObject *args)
     // chain, win32api.error is raised with the GetLastError info.
 }
 
+//*****************************************************************************
+//
+// @pymethod |win32clipboard|SetClipboardDataDelayed|Places a format on the clipboard
+// without any data, registering a function which produces the data if it is pasted.
+// @comm The data is rendered when the window that owns the clipboard receives
+// WM_RENDERFORMAT or WM_RENDERALLFORMATS, and passes them on to
+// <om win32clipboard.RenderClipboardFormat> or <om win32clipboard.RenderAllClipboardFormats>.
+// Nothing is allocated or copied until then, which avoids the work entirely for
+// large data that is never pasted.
+// <nl>The clipboard must have been opened with a window handle, which becomes the
+// owner.  The renderers are forgotten by <om win32clipboard.EmptyClipboard>,
+// and a window should call <om win32clipboard.ClearDelayedRenderers> when it
+// receives WM_DESTROYCLIPBOARD.
+static PyObject *py_set_clipboard_data_delayed(PyObject *self, PyObject *args)
+{
+    int format;
+    PyObject *obrenderer;
+    if (!PyArg_ParseTuple(args, "iO:SetClipboardDataDelayed",
+                          &format,       // @pyparm int|format||The clipboard format
+                          &obrenderer))  // @pyparm callable|renderer||Called as renderer(format), and must return
+                                         // anything accepted by <om win32clipboard.SetClipboardData>
+        return NULL;
+    if (!PyCallable_Check(obrenderer))
+        RETURN_TYPE_ERR("The renderer must be callable");
+    PyObject *obformat = PyLong_FromLong(format);
+    if (obformat == NULL)
+        return NULL;
+    HANDLE data;
+    Py_BEGIN_ALLOW_THREADS;
+    data = SetClipboardData((UINT)format, NULL);
+    Py_END_ALLOW_THREADS;
+    // A NULL return is also used for success when asking for delayed rendering
+    DWORD err = data ? 0 : GetLastError();
+    if (err) {
+        Py_DECREF(obformat);
+        return ReturnAPIError("SetClipboardData", err);
+    }
+    int rc = PyDict_SetItem(delayed_renderers, obformat, obrenderer);
+    Py_DECREF(obformat);
+    if (rc == -1)
+        return NULL;
+    RETURN_NONE;
+}
+
+// Calls the renderer for a format, and puts its data on the clipboard.
+static PyObject *RenderFormat(PyObject *obformat, PyObject *obrenderer)
+{
+    int format = PyLong_AsLong(obformat);
+    PyObject *obdata = PyObject_CallFunctionObjArgs(obrenderer, obformat, NULL);
+    if (obdata == NULL)
+        return NULL;
+    HANDLE handle, data;
+    BOOL bAllocated;
+    BOOL ok = PyWinObject_AsClipboardHANDLE(obdata, &handle, &bAllocated);
+    Py_DECREF(obdata);
+    if (!ok)
+        return NULL;
+    Py_BEGIN_ALLOW_THREADS;
+    data = SetClipboardData((UINT)format, handle);
+    Py_END_ALLOW_THREADS;
+    if (!data) {
+        DWORD err = GetLastError();
+        if (bAllocated)
+            GlobalFree(handle);
+        return ReturnAPIError("SetClipboardData", err);
+    }
+    return PyWinLong_FromHANDLE(data);
+}
+
+//*****************************************************************************
+//
+// @pymethod int|win32clipboard|RenderClipboardFormat|Renders a format registered
+// with <om win32clipboard.SetClipboardDataDelayed>, in response to WM_RENDERFORMAT.
+// @comm The clipboard is already open when WM_RENDERFORMAT is sent, so this must not
+// call OpenClipboard.  The renderer is forgotten once its data is on the clipboard.
+// @rdesc Returns the integer handle of the data.
+static PyObject *py_render_clipboard_format(PyObject *self, PyObject *args)
+{
+    int format;
+    // @pyparm int|format||The format, from the wParam of the message
+    if (!PyArg_ParseTuple(args, "i:RenderClipboardFormat", &format))
+        return NULL;
+    PyObject *obformat = PyLong_FromLong(format);
+    if (obformat == NULL)
+        return NULL;
+    PyObject *obrenderer = PyDict_GetItem(delayed_renderers, obformat);
+    if (obrenderer == NULL) {
+        Py_DECREF(obformat);
+        return PyErr_Format(PyExc_ValueError, "No renderer is registered for clipboard format %d", format);
+    }
+    Py_INCREF(obrenderer);
+    PyObject *ret = RenderFormat(obformat, obrenderer);
+    Py_DECREF(obrenderer);
+    if (ret != NULL && PyDict_DelItem(delayed_renderers, obformat) == -1)
+        PyErr_Clear();  // the renderer may have cleared them itself
+    Py_DECREF(obformat);
+    return ret;
+}
+
+//*****************************************************************************
+//
+// @pymethod |win32clipboard|RenderAllClipboardFormats|Renders all the formats registered
+// with <om win32clipboard.SetClipboardDataDelayed>, in response to WM_RENDERALLFORMATS.
+// @comm The clipboard is opened with the given window, and nothing is rendered if
+// some other window has taken ownership of it in the meantime.  The renderers
+// are forgotten afterwards, even if one of them fails.
+static PyObject *py_render_all_clipboard_formats(PyObject *self, PyObject *args)
+{
+    HWND hwnd;
+    PyObject *obhwnd;
+    // @pyparm <o PyHANDLE>|hwnd||The window that owns the clipboard
+    if (!PyArg_ParseTuple(args, "O:RenderAllClipboardFormats", &obhwnd))
+        return NULL;
+    if (!PyWinObject_AsHANDLE(obhwnd, (HANDLE *)&hwnd))
+        return NULL;
+    // Work on a copy, since this empties the registry whatever happens
+    PyObject *renderers = delayed_renderers;
+    delayed_renderers = PyDict_New();
+    if (delayed_renderers == NULL) {
+        delayed_renderers = renderers;
+        return NULL;
+    }
+    BOOL rc;
+    Py_BEGIN_ALLOW_THREADS;
+    rc = OpenClipboard(hwnd);
+    Py_END_ALLOW_THREADS;
+    if (!rc) {
+        Py_DECREF(renderers);
+        return ReturnAPIError("OpenClipboard");
+    }
+    PyObject *ret = Py_None;
+    Py_INCREF(ret);
+    if (GetClipboardOwner() == hwnd) {
+        Py_ssize_t pos = 0;
+        PyObject *obformat, *obrenderer;
+        while (PyDict_Next(renderers, &pos, &obformat, &obrenderer)) {
+            PyObject *data = RenderFormat(obformat, obrenderer);
+            if (data == NULL) {
+                Py_CLEAR(ret);
+                break;
+            }
+            Py_DECREF(data);
+        }
+    }
+    Py_BEGIN_ALLOW_THREADS;
+    CloseClipboard();
+    Py_END_ALLOW_THREADS;
+    Py_DECREF(renderers);
+    return ret;
+}
+
+//*****************************************************************************
+//
+// @pymethod |win32clipboard|ClearDelayedRenderers|Forgets all the renderers registered
+// with <om win32clipboard.SetClipboardDataDelayed>, eg in response to WM_DESTROYCLIPBOARD.
+static PyObject *py_clear_delayed_renderers(PyObject *self, PyObject *args)
+{
+    CHECK_NO_ARGS2(args, "ClearDelayedRenderers");
+    PyDict_Clear(delayed_renderers);
+    RETURN_NONE;
+}
+
+// @object PyCLIPBOARD_VIEW|A read-only view of the global memory holding clipboard data, as
+// returned by <om win32clipboard.GetClipboardDataView>.
+// @comm The memory stays locked until <om PyCLIPBOARD_VIEW.Release> is called, the object
+// is used in a with statement and the block exits, or the object is destroyed.  It
+// supports the buffer interface, so eg memoryview(view) or bytes(view) can be used
+// without copying beyond what those do themselves.
+// <nl>The clipboard owns the memory, so the view must only be used while the clipboard
+// is still open.
+class PyCLIPBOARD_VIEW : public PyObject {
+   public:
+    PyCLIPBOARD_VIEW(HGLOBAL hglobal, void *p, Py_ssize_t size);
+    ~PyCLIPBOARD_VIEW();
+    static void deallocFunc(PyObject *ob);
+    static int getbufferinfo(PyObject *self, Py_buffer *view, int flags);
+    static void releasebufferinfo(PyObject *self, Py_buffer *view);
+    static PyObject *Release(PyObject *self, PyObject *args);
+    static PyObject *Enter(PyObject *self, PyObject *args);
+    static PyObject *Exit(PyObject *self, PyObject *args);
+    BOOL Unlock();
+    static struct PyMethodDef methods[];
+    static struct PyMemberDef members[];
+
+    HGLOBAL m_hglobal;
+    void *m_p;  // NULL once released
+    Py_ssize_t m_size;
+    int m_exports;
+};
+
+struct PyMethodDef PyCLIPBOARD_VIEW::methods[] = {
+    {"Release", PyCLIPBOARD_VIEW::Release, METH_VARARGS},  // @pymeth Release|Unlocks the memory
+    {"__enter__", PyCLIPBOARD_VIEW::Enter, METH_VARARGS},
+    {"__exit__", PyCLIPBOARD_VIEW::Exit, METH_VARARGS},
+    {NULL}};
+
+struct PyMemberDef PyCLIPBOARD_VIEW::members[] = {
+    // @prop int|Size|The size of the memory, in bytes
+    {"Size", T_PYSSIZET, offsetof(PyCLIPBOARD_VIEW, m_size), READONLY},
+    {NULL}};
+
+static PyBufferProcs PyCLIPBOARD_VIEW_as_buffer = {
+    PyCLIPBOARD_VIEW::getbufferinfo,
+    PyCLIPBOARD_VIEW::releasebufferinfo,
+};
+
+PyTypeObject PyCLIPBOARD_VIEWType = {
+    PYWIN_OBJECT_HEAD "PyCLIPBOARD_VIEW",
+    sizeof(PyCLIPBOARD_VIEW),
+    0,
+    PyCLIPBOARD_VIEW::deallocFunc, /* tp_dealloc */
+    0,                             /* tp_print */
+    0,                             /* tp_getattr */
+    0,                             /* tp_setattr */
+    0,                             /* tp_compare */
+    0,                             /* tp_repr */
+    0,                             /* tp_as_number */
+    0,                             /* tp_as_sequence */
+    0,                             /* tp_as_mapping */
+    0,                             /* tp_hash */
+    0,                             /* tp_call */
+    0,                             /* tp_str */
+    PyObject_GenericGetAttr,       /* tp_getattro */
+    0,                             /* tp_setattro */
+    &PyCLIPBOARD_VIEW_as_buffer,   /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,            /* tp_flags */
+    0,                             /* tp_doc */
+    0,                             /* tp_traverse */
+    0,                             /* tp_clear */
+    0,                             /* tp_richcompare */
+    0,                             /* tp_weaklistoffset */
+    0,                             /* tp_iter */
+    0,                             /* tp_iternext */
+    PyCLIPBOARD_VIEW::methods,     /* tp_methods */
+    PyCLIPBOARD_VIEW::members,     /* tp_members */
+};
+
+PyCLIPBOARD_VIEW::PyCLIPBOARD_VIEW(HGLOBAL hglobal, void *p, Py_ssize_t size)
+{
+    ob_type = &PyCLIPBOARD_VIEWType;
+    _Py_NewReference(this);
+    m_hglobal = hglobal;
+    m_p = p;
+    m_size = size;
+    m_exports = 0;
+}
+
+PyCLIPBOARD_VIEW::~PyCLIPBOARD_VIEW()
+{
+    if (m_p)
+        GlobalUnlock(m_hglobal);
+}
+
+/*static*/ void PyCLIPBOARD_VIEW::deallocFunc(PyObject *ob) { delete (PyCLIPBOARD_VIEW *)ob; }
+
+/*static*/ int PyCLIPBOARD_VIEW::getbufferinfo(PyObject *self, Py_buffer *view, int flags)
+{
+    PyCLIPBOARD_VIEW *This = (PyCLIPBOARD_VIEW *)self;
+    if (This->m_p == NULL) {
+        PyErr_SetString(PyExc_ValueError, "The clipboard view has been released");
+        return -1;
+    }
+    if (PyBuffer_FillInfo(view, self, This->m_p, This->m_size, 1, flags) == -1)
+        return -1;
+    This->m_exports++;
+    return 0;
+}
+
+/*static*/ void PyCLIPBOARD_VIEW::releasebufferinfo(PyObject *self, Py_buffer *view)
+{
+    ((PyCLIPBOARD_VIEW *)self)->m_exports--;
+}
+
+// @pymethod |PyCLIPBOARD_VIEW|Release|Unlocks the global memory
+// @comm Raises BufferError if a memoryview or similar still refers to the memory.
+PyObject *PyCLIPBOARD_VIEW::Release(PyObject *self, PyObject *args)
+{
+    CHECK_NO_ARGS2(args, "Release");
+    if (!((PyCLIPBOARD_VIEW *)self)->Unlock())
+        return NULL;
+    RETURN_NONE;
+}
+
+BOOL PyCLIPBOARD_VIEW::Unlock()
+{
+    if (m_exports) {
+        PyErr_SetString(PyExc_BufferError, "The clipboard view is still being used by another object");
+        return FALSE;
+    }
+    if (m_p) {
+        GlobalUnlock(m_hglobal);
+        m_p = NULL;
+    }
+    return TRUE;
+}
+
+PyObject *PyCLIPBOARD_VIEW::Enter(PyObject *self, PyObject *args)
+{
+    CHECK_NO_ARGS2(args, "__enter__");
+    Py_INCREF(self);
+    return self;
+}
+
+PyObject *PyCLIPBOARD_VIEW::Exit(PyObject *self, PyObject *args)
+{
+    if (!((PyCLIPBOARD_VIEW *)self)->Unlock())
+        return NULL;
+    Py_INCREF(Py_False);
+    return Py_False;
+}
+
+//*****************************************************************************
+//
+// @pymethod <o PyCLIPBOARD_VIEW>|win32clipboard|GetClipboardDataView|Returns a view
+// of clipboard data, without copying it.
+// @comm Only formats whose data is held in global memory are supported, so eg
+// CF_BITMAP, CF_ENHMETAFILE and CF_PALETTE raise TypeError.  Unlike
+// <om win32clipboard.GetClipboardData>, text formats are not converted, so the view
+// includes the terminating null.
+static PyObject *py_get_clipboard_data_view(PyObject *self, PyObject *args)
+{
+    int format;
+    // @pyparm int|format||The clipboard format
+    if (!PyArg_ParseTuple(args, "i:GetClipboardDataView", &format))
+        return NULL;
+    switch (format) {
+        case CF_BITMAP:
+        case CF_DSPBITMAP:
+        case CF_ENHMETAFILE:
+        case CF_DSPENHMETAFILE:
+        case CF_PALETTE:
+        case CF_OWNERDISPLAY:
+            return PyErr_Format(PyExc_TypeError, "The data for clipboard format %d is not held in global memory",
+                                format);
+    }
+    if (!IsClipboardFormatAvailable(format))
+        return PyErr_Format(PyExc_TypeError, "The clipboard format %d is not available", format);
+    HANDLE handle;
+    Py_BEGIN_ALLOW_THREADS;
+    handle = GetClipboardData((UINT)format);
+    Py_END_ALLOW_THREADS;
+    if (!handle)
+        return ReturnAPIError("GetClipboardData");
+    SIZE_T size = GlobalSize(handle);
+    if (!size)
+        return ReturnAPIError("GlobalSize");
+    void *p = GlobalLock(handle);
+    if (!p)
+        return ReturnAPIError("GlobalLock");
+    PyObject *ret = new PyCLIPBOARD_VIEW(handle, p, (Py_ssize_t)size);
+    if (ret == NULL) {
+        GlobalUnlock(handle);
+        return PyErr_NoMemory();
+    }
+    return ret;
+}
+
+// @object PyCLIPBOARD_LISTENER|Listens for clipboard changes, as returned by <om win32clipboard.ClipboardListener>.
+// @comm A thread owned by the listener creates a message-only window and registers it with
+// AddClipboardFormatListener.  On each WM_CLIPBOARDUPDATE the thread records the clipboard
+// sequence number and enumerates the available formats, so a change only costs the
+// caller a call to <om PyCLIPBOARD_LISTENER.GetChanges>, with no polling and no need to
+// open the clipboard itself.
+// <nl><om PyCLIPBOARD_LISTENER.Event> is set while changes are waiting, so it can be passed
+// to eg <om win32event.WaitForMultipleObjects> alongside other events.
+// <nl>The formats can't be enumerated if another application keeps the clipboard open for
+// too long, in which case the formats are reported as None.
+
+typedef BOOL(WINAPI *AddClipboardFormatListenerfunc)(HWND);
+static AddClipboardFormatListenerfunc pfnAddClipboardFormatListener = NULL;
+static AddClipboardFormatListenerfunc pfnRemoveClipboardFormatListener = NULL;  // same signature
+
+#ifndef WM_CLIPBOARDUPDATE
+#define WM_CLIPBOARDUPDATE 0x031D
+#endif
+
+struct CLIPBOARD_CHANGE {
+    DWORD seq;
+    UINT *formats;  // NULL if the clipboard couldn't be opened
+    UINT numformats;
+};
+
+class PyCLIPBOARD_LISTENER : public PyObject {
+   public:
+    PyCLIPBOARD_LISTENER();
+    ~PyCLIPBOARD_LISTENER();
+    static void deallocFunc(PyObject *ob);
+    static PyObject *GetChanges(PyObject *self, PyObject *args);
+    static PyObject *Close(PyObject *self, PyObject *args);
+    static PyObject *get_Event(PyObject *self, void *unused);
+    static DWORD WINAPI Worker(LPVOID param);
+    static LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
+    static struct PyMethodDef methods[];
+    static struct PyMemberDef members[];
+    static PyGetSetDef getset[];
+
+    void Stop();  // called without the GIL
+    void RecordChange();
+
+    CRITICAL_SECTION cs;  // protects the queue
+    CLIPBOARD_CHANGE *queue;
+    DWORD queuesize, numqueued, first;
+    DWORD dropped;  // changes discarded because the queue was full
+    HANDLE hevent;  // manual reset, set while there are changes queued
+    HANDLE hstarted;
+    HANDLE hthread;
+    HWND hwnd;
+    DWORD starterror;
+};
+
+struct PyMethodDef PyCLIPBOARD_LISTENER::methods[] = {
+    {"GetChanges", PyCLIPBOARD_LISTENER::GetChanges, METH_VARARGS},  // @pymeth GetChanges|Returns the changes
+                                                                      // since the last call
+    {"Close", PyCLIPBOARD_LISTENER::Close, METH_VARARGS},  // @pymeth Close|Stops listening
+    {NULL}};
+
+struct PyMemberDef PyCLIPBOARD_LISTENER::members[] = {
+    // @prop int|Dropped|Number of changes discarded because the queue was full
+    {"Dropped", T_ULONG, offsetof(PyCLIPBOARD_LISTENER, dropped), READONLY},
+    {NULL}};
+
+PyGetSetDef PyCLIPBOARD_LISTENER::getset[] = {
+    // @prop int|Event|Handle to an event that is set while changes are waiting.  It is owned by the listener.
+    {"Event", PyCLIPBOARD_LISTENER::get_Event, NULL},
+    {NULL}};
+
+PyTypeObject PyCLIPBOARD_LISTENERType = {
+    PYWIN_OBJECT_HEAD "PyCLIPBOARD_LISTENER",
+    sizeof(PyCLIPBOARD_LISTENER),
+    0,
+    PyCLIPBOARD_LISTENER::deallocFunc, /* tp_dealloc */
+    0,                                 /* tp_print */
+    0,                                 /* tp_getattr */
+    0,                                 /* tp_setattr */
+    0,                                 /* tp_compare */
+    0,                                 /* tp_repr */
+    0,                                 /* tp_as_number */
+    0,                                 /* tp_as_sequence */
+    0,                                 /* tp_as_mapping */
+    0,                                 /* tp_hash */
+    0,                                 /* tp_call */
+    0,                                 /* tp_str */
+    PyObject_GenericGetAttr,           /* tp_getattro */
+    0,                                 /* tp_setattro */
+    0,                                 /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                /* tp_flags */
+    0,                                 /* tp_doc */
+    0,                                 /* tp_traverse */
+    0,                                 /* tp_clear */
+    0,                                 /* tp_richcompare */
+    0,                                 /* tp_weaklistoffset */
+    0,                                 /* tp_iter */
+    0,                                 /* tp_iternext */
+    PyCLIPBOARD_LISTENER::methods,     /* tp_methods */
+    PyCLIPBOARD_LISTENER::members,     /* tp_members */
+    PyCLIPBOARD_LISTENER::getset,      /* tp_getset */
+};
+
+PyCLIPBOARD_LISTENER::PyCLIPBOARD_LISTENER()
+{
+    ob_type = &PyCLIPBOARD_LISTENERType;
+    _Py_NewReference(this);
+    InitializeCriticalSection(&cs);
+    queue = NULL;
+    queuesize = numqueued = first = dropped = 0;
+    hevent = hstarted = hthread = NULL;
+    hwnd = NULL;
+    starterror = 0;
+}
+
+PyCLIPBOARD_LISTENER::~PyCLIPBOARD_LISTENER()
+{
+    Py_BEGIN_ALLOW_THREADS;
+    Stop();
+    Py_END_ALLOW_THREADS;
+    for (DWORD i = 0; i < numqueued; i++) free(queue[(first + i) % queuesize].formats);
+    free(queue);
+    if (hevent)
+        CloseHandle(hevent);
+    if (hstarted)
+        CloseHandle(hstarted);
+    DeleteCriticalSection(&cs);
+}
+
+/*static*/ void PyCLIPBOARD_LISTENER::deallocFunc(PyObject *ob) { delete (PyCLIPBOARD_LISTENER *)ob; }
+
+void PyCLIPBOARD_LISTENER::Stop()
+{
+    if (hthread == NULL)
+        return;
+    if (hwnd)
+        PostMessage(hwnd, WM_CLOSE, 0, 0);
+    WaitForSingleObject(hthread, INFINITE);
+    CloseHandle(hthread);
+    hthread = NULL;
+}
+
+// Runs in the listener's thread for each WM_CLIPBOARDUPDATE
+void PyCLIPBOARD_LISTENER::RecordChange()
+{
+    CLIPBOARD_CHANGE change = {GetClipboardSequenceNumber(), NULL, 0};
+    // Whoever changed the clipboard may still have it open, so retry for a little while
+    BOOL bOpen = FALSE;
+    for (int i = 0; i < 10 && !(bOpen = OpenClipboard(hwnd)); i++) Sleep(10);
+    if (bOpen) {
+        UINT count = CountClipboardFormats();
+        change.formats = (UINT *)malloc((count ? count : 1) * sizeof(UINT));
+        if (change.formats) {
+            UINT format = 0;
+            while ((format = EnumClipboardFormats(format)) != 0 && change.numformats < count)
+                change.formats[change.numformats++] = format;
+        }
+        CloseClipboard();
+    }
+    EnterCriticalSection(&cs);
+    if (numqueued == queuesize) {
+        free(queue[first].formats);
+        first = (first + 1) % queuesize;
+        numqueued--;
+        dropped++;
+    }
+    queue[(first + numqueued) % queuesize] = change;
+    numqueued++;
+    SetEvent(hevent);
+    LeaveCriticalSection(&cs);
+}
+
+/*static*/ LRESULT CALLBACK PyCLIPBOARD_LISTENER::WndProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
+{
+    PyCLIPBOARD_LISTENER *This = (PyCLIPBOARD_LISTENER *)GetWindowLongPtr(hwnd, GWLP_USERDATA);
+    switch (msg) {
+        case WM_CLIPBOARDUPDATE:
+            if (This)
+                This->RecordChange();
+            return 0;
+        case WM_CLOSE:
+            (*pfnRemoveClipboardFormatListener)(hwnd);
+            DestroyWindow(hwnd);
+            return 0;
+        case WM_DESTROY:
+            PostQuitMessage(0);
+            return 0;
+    }
+    return DefWindowProc(hwnd, msg, wparam, lparam);
+}
+
+#define CLIPBOARD_LISTENER_CLASS L"PyWin32ClipboardListener"
+
+/*static*/ DWORD WINAPI PyCLIPBOARD_LISTENER::Worker(LPVOID param)
+{
+    PyCLIPBOARD_LISTENER *This = (PyCLIPBOARD_LISTENER *)param;
+    HINSTANCE hinst = GetModuleHandle(NULL);
+    WNDCLASSW wc;
+    ZeroMemory(&wc, sizeof(wc));
+    wc.lpfnWndProc = PyCLIPBOARD_LISTENER::WndProc;
+    wc.hInstance = hinst;
+    wc.lpszClassName = CLIPBOARD_LISTENER_CLASS;
+    // Fails harmlessly if another listener has already registered it
+    RegisterClassW(&wc);
+    HWND hwnd = CreateWindowExW(0, CLIPBOARD_LISTENER_CLASS, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, NULL, hinst, NULL);
+    if (hwnd == NULL) {
+        This->starterror = GetLastError();
+        SetEvent(This->hstarted);
+        return 0;
+    }
+    SetWindowLongPtr(hwnd, GWLP_USERDATA, (LONG_PTR)This);
+    if (!(*pfnAddClipboardFormatListener)(hwnd)) {
+        This->starterror = GetLastError();
+        DestroyWindow(hwnd);
+        SetEvent(This->hstarted);
+        return 0;
+    }
+    This->hwnd = hwnd;
+    SetEvent(This->hstarted);
+    MSG msg;
+    while (GetMessage(&msg, NULL, 0, 0) > 0) DispatchMessage(&msg);
+    This->hwnd = NULL;
+    return 0;
+}
+
+// @pymethod [(int, (int, ...)), ...]|PyCLIPBOARD_LISTENER|GetChanges|Returns the changes since the last call
+// @rdesc Returns a list of (SequenceNumber, Formats) tuples, oldest first, where Formats is a tuple of the
+// formats that were available, in the order EnumClipboardFormats returned them, or None.  The list is empty if
+// the timeout expires first.
+PyObject *PyCLIPBOARD_LISTENER::GetChanges(PyObject *self, PyObject *args)
+{
+    PyCLIPBOARD_LISTENER *This = (PyCLIPBOARD_LISTENER *)self;
+    DWORD timeout = 0;
+    // @pyparm int|Timeout|0|Number of milliseconds to wait if nothing has changed yet
+    if (!PyArg_ParseTuple(args, "|k:GetChanges", &timeout))
+        return NULL;
+    if (This->hthread == NULL)
+        return PyErr_Format(PyExc_ValueError, "The listener has been closed");
+    if (timeout) {
+        Py_BEGIN_ALLOW_THREADS;
+        WaitForSingleObject(This->hevent, timeout);
+        Py_END_ALLOW_THREADS;
+    }
+    // Take the whole queue, so the conversion is done outside the critical section
+    EnterCriticalSection(&This->cs);
+    DWORD numqueued = This->numqueued, first = This->first;
+    CLIPBOARD_CHANGE *changes = (CLIPBOARD_CHANGE *)malloc((numqueued ? numqueued : 1) * sizeof(CLIPBOARD_CHANGE));
+    if (changes) {
+        for (DWORD i = 0; i < numqueued; i++) changes[i] = This->queue[(first + i) % This->queuesize];
+        This->numqueued = 0;
+        This->first = 0;
+        ResetEvent(This->hevent);
+    }
+    LeaveCriticalSection(&This->cs);
+    if (changes == NULL)
+        return PyErr_NoMemory();
+
+    PyObject *ret = PyList_New(numqueued);
+    for (DWORD i = 0; i < numqueued; i++) {
+        if (ret == NULL)
+            break;
+        PyObject *obformats;
+        if (changes[i].formats == NULL) {
+            Py_INCREF(Py_None);
+            obformats = Py_None;
+        }
+        else {
+            obformats = PyTuple_New(changes[i].numformats);
+            for (UINT j = 0; obformats && j < changes[i].numformats; j++) {
+                PyObject *obformat = PyLong_FromUnsignedLong(changes[i].formats[j]);
+                if (obformat == NULL)
+                    Py_CLEAR(obformats);
+                else
+                    PyTuple_SET_ITEM(obformats, j, obformat);
+            }
+        }
+        PyObject *item = obformats ? Py_BuildValue("kN", changes[i].seq, obformats) : NULL;
+        if (item == NULL)
+            Py_CLEAR(ret);
+        else
+            PyList_SET_ITEM(ret, i, item);
+    }
+    for (DWORD i = 0; i < numqueued; i++) free(changes[i].formats);
+    free(changes);
+    return ret;
+}
+
+// @pymethod |PyCLIPBOARD_LISTENER|Close|Stops listening, and destroys the listener's window and thread
+PyObject *PyCLIPBOARD_LISTENER::Close(PyObject *self, PyObject *args)
+{
+    PyCLIPBOARD_LISTENER *This = (PyCLIPBOARD_LISTENER *)self;
+    CHECK_NO_ARGS2(args, "Close");
+    Py_BEGIN_ALLOW_THREADS;
+    This->Stop();
+    Py_END_ALLOW_THREADS;
+    RETURN_NONE;
+}
+
+/*static*/ PyObject *PyCLIPBOARD_LISTENER::get_Event(PyObject *self, void *unused)
+{
+    return PyWinLong_FromHANDLE(((PyCLIPBOARD_LISTENER *)self)->hevent);
+}
+
+//*****************************************************************************
+//
+// @pymethod <o PyCLIPBOARD_LISTENER>|win32clipboard|ClipboardListener|Creates an object
+// which is told about clipboard changes by AddClipboardFormatListener.
+// @comm Requires Windows Vista or later.
+static PyObject *py_clipboard_listener(PyObject *self, PyObject *args)
+{
+    DWORD queuesize = 64;
+    // @pyparm int|MaxQueue|64|Maximum number of changes kept between calls to
+    // <om PyCLIPBOARD_LISTENER.GetChanges>.  The oldest are discarded first.
+    if (!PyArg_ParseTuple(args, "|k:ClipboardListener", &queuesize))
+        return NULL;
+    if (pfnAddClipboardFormatListener == NULL || pfnRemoveClipboardFormatListener == NULL)
+        return PyErr_Format(PyExc_NotImplementedError, "AddClipboardFormatListener is not available on this platform");
+    if (queuesize < 1)
+        return PyErr_Format(PyExc_ValueError, "MaxQueue must be greater than 0");
+    PyCLIPBOARD_LISTENER *ret = new PyCLIPBOARD_LISTENER();
+    if (ret == NULL)
+        return PyErr_NoMemory();
+    ret->queuesize = queuesize;
+    ret->queue = (CLIPBOARD_CHANGE *)malloc(queuesize * sizeof(CLIPBOARD_CHANGE));
+    if (ret->queue == NULL) {
+        Py_DECREF(ret);
+        return PyErr_NoMemory();
+    }
+    if ((ret->hevent = CreateEvent(NULL, TRUE, FALSE, NULL)) == NULL ||
+        (ret->hstarted = CreateEvent(NULL, TRUE, FALSE, NULL)) == NULL) {
+        Py_DECREF(ret);
+        return ReturnAPIError("CreateEvent");
+    }
+    ret->hthread = CreateThread(NULL, 0, PyCLIPBOARD_LISTENER::Worker, ret, 0, NULL);
+    if (ret->hthread == NULL) {
+        Py_DECREF(ret);
+        return ReturnAPIError("CreateThread");
+    }
+    Py_BEGIN_ALLOW_THREADS;
+    WaitForSingleObject(ret->hstarted, INFINITE);
+    Py_END_ALLOW_THREADS;
+    if (ret->starterror) {
+        DWORD err = ret->starterror;
+        Py_DECREF(ret);
+        return ReturnAPIError("AddClipboardFormatListener", err);
+    }
+    return ret;
+}
+
 // @module win32clipboard|A module which supports the Windows Clipboard API.
 
 // List of functions exported by this module
 static struct PyMethodDef clipboard_functions[] = {
 
+    // @pymeth ClearDelayedRenderers|Forgets the renderers registered with
+    // SetClipboardDataDelayed.
+    {"ClearDelayedRenderers", py_clear_delayed_renderers, 1},
+
     // @pymeth ChangeClipboardChain|Removes a specified window from the chain
     // of clipboard viewers.
     {"ChangeClipboardChain", py_change_clipboard_chain, 1},
 
+    // @pymeth ClipboardListener|Creates an object which is told about clipboard changes.
+    {"ClipboardListener", py_clipboard_listener, 1},
+
     // @pymeth CloseClipboard|Closes the clipboard.
     {"CloseClipboard", py_close_clipboard, 1},
 
@@ -1039,6 +1771,9 @@ static struct PyMethodDef clipboard_functions[] = {
     // specified format, returning the underlying integer handle.
     {"GetClipboardDataHandle", py_get_clipboard_data_handle, 1},
 
+    // @pymeth GetClipboardDataView|Returns a view of clipboard data, without copying it.
+    {"GetClipboardDataView", py_get_clipboard_data_view, 1},
+
     // @pymeth GetClipboardFormatName|Retrieves from the clipboard the name
     // of the specified registered format.
     {"GetClipboardFormatName", py_get_clipboard_formatName, 1},
@@ -1077,10 +1812,20 @@ static struct PyMethodDef clipboard_functions[] = {
     // @pymeth RegisterClipboardFormat|Registers a new clipboard format.
     {"RegisterClipboardFormat", py_register_clipboard_format, 1},
 
+    // @pymeth RenderAllClipboardFormats|Renders all delayed formats, for WM_RENDERALLFORMATS.
+    {"RenderAllClipboardFormats", py_render_all_clipboard_formats, 1},
+
+    // @pymeth RenderClipboardFormat|Renders a delayed format, for WM_RENDERFORMAT.
+    {"RenderClipboardFormat", py_render_clipboard_format, 1},
+
     // @pymeth SetClipboardData|Places data on the clipboard in a specified
     // clipboard format.
     {"SetClipboardData", py_set_clipboard_data, 1},
 
+    // @pymeth SetClipboardDataDelayed|Places a format on the clipboard, with a function
+    // to render the data if it is pasted.
+    {"SetClipboardDataDelayed", py_set_clipboard_data_delayed, 1},
+
     // @pymeth SetClipboardText|Places text on the clipboard .
     {"SetClipboardText", py_set_clipboard_text, 1},
 
@@ -1130,6 +1875,18 @@ PYWIN_MODULE_INIT_FUNC(win32clipboard)
 
     if (AddConstants(module) != 0)
         PYWIN_MODULE_INIT_RETURN_ERROR;
+    if (PyType_Ready(&PyCLIPBOARD_VIEWType) == -1 || PyType_Ready(&PyCLIPBOARD_LISTENERType) == -1)
+        PYWIN_MODULE_INIT_RETURN_ERROR;
+    HMODULE hmodule = GetModuleHandle(TEXT("user32.dll"));
+    if (hmodule != NULL) {
+        pfnAddClipboardFormatListener =
+            (AddClipboardFormatListenerfunc)GetProcAddress(hmodule, "AddClipboardFormatListener");
+        pfnRemoveClipboardFormatListener =
+            (AddClipboardFormatListenerfunc)GetProcAddress(hmodule, "RemoveClipboardFormatListener");
+    }
+    delayed_renderers = PyDict_New();
+    if (delayed_renderers == NULL)
+        PYWIN_MODULE_INIT_RETURN_ERROR;
     if (PyDict_SetItemString(dict, "error", PyWinExc_ApiError) == -1)
         PYWIN_MODULE_INIT_RETURN_ERROR;
     if (PyDict_SetItemString(dict, "UNICODE",
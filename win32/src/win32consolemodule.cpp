@@ -731,6 +731,225 @@ PyObject *PyINPUT_RECORD::tp_str(PyObject *self)
     return PyWinCoreString_FromString(buf, chars_printed);
 }
 
+// @object PyConsoleInputBatch|A reusable array of INPUT_RECORD structs, filled by
+// <om PyConsoleScreenBuffer.ReadConsoleInputBatch>
+// @comm Create using PyConsoleInputBatchType(Length), where Length is the number of records it can hold.
+// <nl>Reading into the same batch repeatedly avoids creating an object per event.  The records are available as a
+// sequence, which creates a <o PyINPUT_RECORD> only for the items actually accessed, and through the buffer
+// interface as Count raw INPUT_RECORD structs, each 20 bytes - a WORD EventType, two bytes of padding, then the
+// 16 byte event union.
+extern PyTypeObject PyConsoleInputBatchType;
+
+class PyConsoleInputBatch : public PyObject {
+   public:
+    static struct PyMemberDef members[];
+    static struct PyMethodDef methods[];
+    static PySequenceMethods sequencemethods;
+    static PyBufferProcs buffermethods;
+    static void tp_dealloc(PyObject *ob);
+    static PyObject *tp_new(PyTypeObject *tp, PyObject *args, PyObject *kwargs);
+    static PyConsoleInputBatch *Create(DWORD length);
+    static Py_ssize_t sq_length(PyObject *self);
+    static PyObject *sq_item(PyObject *self, Py_ssize_t index);
+    static int getbuffer(PyObject *self, Py_buffer *view, int flags);
+    static void releasebuffer(PyObject *self, Py_buffer *view);
+    static PyObject *PyGetText(PyObject *self, PyObject *args);
+    PyConsoleInputBatch(void);
+    ~PyConsoleInputBatch(void);
+    DWORD Coalesce(void);
+    INPUT_RECORD *records;
+    DWORD capacity, count, coalesced;
+    int exports;
+    BOOL bBusy;  // a read is in progress with the GIL released
+};
+
+PyConsoleInputBatch::PyConsoleInputBatch(void)
+{
+    ob_type = &PyConsoleInputBatchType;
+    records = NULL;
+    capacity = count = coalesced = 0;
+    exports = 0;
+    bBusy = FALSE;
+    _Py_NewReference(this);
+}
+
+PyConsoleInputBatch::~PyConsoleInputBatch(void) { free(records); }
+
+void PyConsoleInputBatch::tp_dealloc(PyObject *ob) { delete (PyConsoleInputBatch *)ob; }
+
+PyObject *PyConsoleInputBatch::tp_new(PyTypeObject *tp, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Length", NULL};
+    DWORD length = 128;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|k:PyConsoleInputBatchType", keywords, &length))
+        return NULL;
+    if (length == 0) {
+        PyErr_SetString(PyExc_ValueError, "Length must be greater than 0");
+        return NULL;
+    }
+    return Create(length);
+}
+
+PyConsoleInputBatch *PyConsoleInputBatch::Create(DWORD length)
+{
+    PyConsoleInputBatch *ret = new PyConsoleInputBatch();
+    if (ret == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    ret->records = (INPUT_RECORD *)malloc(length * sizeof(INPUT_RECORD));
+    if (ret->records == NULL) {
+        Py_DECREF(ret);
+        PyErr_Format(PyExc_MemoryError, "Unable to allocate %d bytes", length * sizeof(INPUT_RECORD));
+        return NULL;
+    }
+    ret->capacity = length;
+    return ret;
+}
+
+// Drops each mouse move that is immediately followed by another one with the same buttons and shift
+// state, keeping only the last position.  Returns the number of records dropped.
+DWORD PyConsoleInputBatch::Coalesce(void)
+{
+    DWORD src, dst = 0;
+    for (src = 0; src < count; src++) {
+        if (dst > 0 && records[src].EventType == MOUSE_EVENT && records[dst - 1].EventType == MOUSE_EVENT) {
+            MOUSE_EVENT_RECORD *prev = &records[dst - 1].Event.MouseEvent;
+            MOUSE_EVENT_RECORD *cur = &records[src].Event.MouseEvent;
+            if (prev->dwEventFlags == MOUSE_MOVED && cur->dwEventFlags == MOUSE_MOVED &&
+                prev->dwButtonState == cur->dwButtonState && prev->dwControlKeyState == cur->dwControlKeyState) {
+                records[dst - 1] = records[src];
+                continue;
+            }
+        }
+        if (dst != src)
+            records[dst] = records[src];
+        dst++;
+    }
+    DWORD dropped = count - dst;
+    count = dst;
+    return dropped;
+}
+
+Py_ssize_t PyConsoleInputBatch::sq_length(PyObject *self) { return ((PyConsoleInputBatch *)self)->count; }
+
+PyObject *PyConsoleInputBatch::sq_item(PyObject *self, Py_ssize_t index)
+{
+    PyConsoleInputBatch *batch = (PyConsoleInputBatch *)self;
+    if (index < 0 || index >= (Py_ssize_t)batch->count) {
+        PyErr_SetString(PyExc_IndexError, "PyConsoleInputBatch index out of range");
+        return NULL;
+    }
+    return PyWinObject_FromINPUT_RECORD(&batch->records[index]);
+}
+
+int PyConsoleInputBatch::getbuffer(PyObject *self, Py_buffer *view, int flags)
+{
+    PyConsoleInputBatch *batch = (PyConsoleInputBatch *)self;
+    if (PyBuffer_FillInfo(view, self, batch->records, batch->count * sizeof(INPUT_RECORD), 1, flags) == -1)
+        return -1;
+    batch->exports++;
+    return 0;
+}
+
+void PyConsoleInputBatch::releasebuffer(PyObject *self, Py_buffer *view) { ((PyConsoleInputBatch *)self)->exports--; }
+
+// @pymethod <o PyUnicode>|PyConsoleInputBatch|GetText|Returns the characters typed, from the key down events
+// @comm Each character is repeated according to the record's RepeatCount.  Key events without a character, such as
+// those for shift or the arrow keys, are ignored, as are all other kinds of event.  This allows a large paste to
+// be handled without looking at each record.
+PyObject *PyConsoleInputBatch::PyGetText(PyObject *self, PyObject *args)
+{
+    PyConsoleInputBatch *batch = (PyConsoleInputBatch *)self;
+    DWORD i, len = 0;
+    if (!PyArg_ParseTuple(args, ":GetText"))
+        return NULL;
+    for (i = 0; i < batch->count; i++) {
+        KEY_EVENT_RECORD *key = &batch->records[i].Event.KeyEvent;
+        if (batch->records[i].EventType == KEY_EVENT && key->bKeyDown && key->uChar.UnicodeChar != 0)
+            len += key->wRepeatCount;
+    }
+    WCHAR *buf = (WCHAR *)malloc((len + 1) * sizeof(WCHAR));
+    if (buf == NULL)
+        return PyErr_Format(PyExc_MemoryError, "Unable to allocate %d bytes", (len + 1) * sizeof(WCHAR));
+    WCHAR *p = buf;
+    for (i = 0; i < batch->count; i++) {
+        KEY_EVENT_RECORD *key = &batch->records[i].Event.KeyEvent;
+        if (batch->records[i].EventType == KEY_EVENT && key->bKeyDown && key->uChar.UnicodeChar != 0)
+            for (WORD repeat = 0; repeat < key->wRepeatCount; repeat++) *p++ = key->uChar.UnicodeChar;
+    }
+    PyObject *ret = PyWinObject_FromWCHAR(buf, len);
+    free(buf);
+    return ret;
+}
+
+PySequenceMethods PyConsoleInputBatch::sequencemethods = {
+    PyConsoleInputBatch::sq_length,  // inquiry sq_length;
+    NULL,                            // binaryfunc sq_concat;
+    NULL,                            // intargfunc sq_repeat;
+    PyConsoleInputBatch::sq_item,    // intargfunc sq_item;
+};
+
+PyBufferProcs PyConsoleInputBatch::buffermethods = {
+    PyConsoleInputBatch::getbuffer,
+    PyConsoleInputBatch::releasebuffer,
+};
+
+struct PyMethodDef PyConsoleInputBatch::methods[] = {
+    // @pymeth GetText|Returns the characters typed, from the key down events
+    {"GetText", PyConsoleInputBatch::PyGetText, METH_VARARGS, "Returns the characters typed, from the key down events"},
+    {NULL}};
+
+struct PyMemberDef PyConsoleInputBatch::members[] = {
+    // @prop int|Length|Number of records the batch can hold
+    {"Length", T_ULONG, offsetof(PyConsoleInputBatch, capacity), READONLY, "Number of records the batch can hold"},
+    // @prop int|Count|Number of records returned by the last read
+    {"Count", T_ULONG, offsetof(PyConsoleInputBatch, count), READONLY, "Number of records returned by the last read"},
+    // @prop int|Coalesced|Number of mouse moves dropped from the last read
+    {"Coalesced", T_ULONG, offsetof(PyConsoleInputBatch, coalesced), READONLY,
+     "Number of mouse moves dropped from the last read"},
+    {NULL}};
+
+PyTypeObject PyConsoleInputBatchType = {
+    PYWIN_OBJECT_HEAD "PyConsoleInputBatch",
+    sizeof(PyConsoleInputBatch),
+    0,
+    PyConsoleInputBatch::tp_dealloc,         // tp_dealloc
+    0,                                       // tp_print
+    0,                                       // tp_getattr
+    0,                                       // tp_setattr
+    0,                                       // tp_compare
+    0,                                       // tp_repr
+    0,                                       // tp_as_number
+    &PyConsoleInputBatch::sequencemethods,   // tp_as_sequence
+    0,                                       // tp_as_mapping
+    0,                                       // tp_hash
+    0,                                       // tp_call
+    0,                                       // tp_str
+    PyObject_GenericGetAttr,                 // tp_getattro
+    PyObject_GenericSetAttr,                 // tp_setattro
+    &PyConsoleInputBatch::buffermethods,     // tp_as_buffer
+    Py_TPFLAGS_DEFAULT,                      // tp_flags
+    "Reusable array of console input records.  Create using PyConsoleInputBatchType(Length)",  // tp_doc
+    0,                                                                                          // tp_traverse
+    0,                                                                                          // tp_clear
+    0,                                                                                          // tp_richcompare
+    0,                                                                                          // tp_weaklistoffset
+    0,                                                                                          // tp_iter
+    0,                                                                                          // tp_iternext
+    PyConsoleInputBatch::methods,                                                               // tp_methods
+    PyConsoleInputBatch::members,                                                               // tp_members
+    0,                                                                                          // tp_getset
+    0,                                                                                          // tp_base
+    0,                                                                                          // tp_dict
+    0,                                                                                          // tp_descr_get
+    0,                                                                                          // tp_descr_set
+    0,                                                                                          // tp_dictoffset
+    0,                                                                                          // tp_init
+    0,                                                                                          // tp_alloc
+    PyConsoleInputBatch::tp_new,                                                                // tp_new
+};
+
 // @object PyConsoleScreenBuffer|Handle to a console screen buffer
 // Create using <om win32console.CreateConsoleScreenBuffer> or <om win32console.GetStdHandle>
 // Use PyConsoleScreenBufferType(Handle) to wrap a pre-existing handle as returned by <om win32api.GetStdHandle>.
@@ -776,6 +995,7 @@ class PyConsoleScreenBuffer : public PyHANDLE {
     static PyObject *PyReadConsoleInput(PyObject *self, PyObject *args, PyObject *kwargs);
     static PyObject *PyPeekConsoleInput(PyObject *self, PyObject *args, PyObject *kwargs);
     static PyObject *PyGetNumberOfConsoleInputEvents(PyObject *self, PyObject *args);
+    static PyObject *PyReadConsoleInputBatch(PyObject *self, PyObject *args, PyObject *kwargs);
 };
 
 struct PyMethodDef PyConsoleScreenBuffer::methods[] = {
@@ -873,6 +1093,9 @@ struct PyMethodDef PyConsoleScreenBuffer::methods[] = {
     // @pymeth GetNumberOfConsoleInputEvents|Returns the number of unread records in the input queue
     {"GetNumberOfConsoleInputEvents", PyConsoleScreenBuffer::PyGetNumberOfConsoleInputEvents, METH_VARARGS,
      "Returns the number of unread records in the input queue"},
+    // @pymeth ReadConsoleInputBatch|Reads input records into a reusable batch
+    {"ReadConsoleInputBatch", (PyCFunction)PyConsoleScreenBuffer::PyReadConsoleInputBatch, METH_VARARGS | METH_KEYWORDS,
+     "Reads input records into a reusable batch"},
     {NULL}};
 
 // @pymethod |PyConsoleScreenBuffer|SetConsoleActiveScreenBuffer|Sets this handle as the currently displayed screen
@@ -1516,6 +1739,59 @@ PyObject *PyConsoleScreenBuffer::PyGetNumberOfConsoleInputEvents(PyObject *self,
     return PyLong_FromUnsignedLong(nbrofevents);
 }
 
+// @pymethod <o PyConsoleInputBatch>|PyConsoleScreenBuffer|ReadConsoleInputBatch|Reads input records into a
+// reusable batch
+// @rdesc Returns the batch that was filled
+// @comm Unlike <om PyConsoleScreenBuffer.ReadConsoleInput>, no <o PyINPUT_RECORD> objects are created unless
+// the batch is indexed.  The GIL is released while waiting for input.
+PyObject *PyConsoleScreenBuffer::PyReadConsoleInputBatch(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Batch", "CoalesceMouseMoves", "Peek", NULL};
+    PyObject *obbatch = Py_None;
+    BOOL coalesce = FALSE, peek = FALSE, ok;
+    DWORD nbrread;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|Oii:ReadConsoleInputBatch", keywords,
+            &obbatch,    // @pyparm <o PyConsoleInputBatch>|Batch|None|The batch to fill, replacing its previous
+                         // contents.  If None, a new batch of 128 records is created.
+            &coalesce,   // @pyparm boolean|CoalesceMouseMoves|False|If True, runs of consecutive mouse move
+                         // events with the same button and shift state are reduced to the last one
+            &peek))      // @pyparm boolean|Peek|False|If True, the records are left in the input queue (using
+                         // PeekConsoleInput), and the call returns immediately even if there is no input
+        return NULL;
+    PyConsoleInputBatch *batch;
+    if (obbatch == Py_None) {
+        batch = PyConsoleInputBatch::Create(128);
+        if (batch == NULL)
+            return NULL;
+    }
+    else {
+        if (obbatch->ob_type != &PyConsoleInputBatchType) {
+            PyErr_SetString(PyExc_TypeError, "Batch must be a PyConsoleInputBatch");
+            return NULL;
+        }
+        batch = (PyConsoleInputBatch *)obbatch;
+        if (batch->exports > 0 || batch->bBusy) {
+            PyErr_SetString(PyExc_BufferError, "The batch can't be refilled while it is in use");
+            return NULL;
+        }
+        Py_INCREF(batch);
+    }
+    HANDLE h = ((PyConsoleScreenBuffer *)self)->m_handle;
+    batch->bBusy = TRUE;
+    batch->count = batch->coalesced = 0;
+    Py_BEGIN_ALLOW_THREADS ok = peek ? PeekConsoleInputW(h, batch->records, batch->capacity, &nbrread)
+                                     : ReadConsoleInputW(h, batch->records, batch->capacity, &nbrread);
+    Py_END_ALLOW_THREADS batch->bBusy = FALSE;
+    if (!ok) {
+        Py_DECREF(batch);
+        return PyWin_SetAPIError(peek ? "PeekConsoleInput" : "ReadConsoleInput");
+    }
+    batch->count = nbrread;
+    batch->coalesced = coalesce ? batch->Coalesce() : 0;
+    return batch;
+}
+
 PyTypeObject PyConsoleScreenBufferType = {
     PYWIN_OBJECT_HEAD "PyConsoleScreenBuffer",
     sizeof(PyConsoleScreenBuffer),
@@ -1608,6 +1884,452 @@ void PyConsoleScreenBuffer::tp_dealloc(PyObject *ob)
     PyErr_Restore(typ, val, tb);
 }
 
+// @object PyConsoleBackBuffer|An off-screen grid of CHAR_INFO cells that is drawn to a console in bulk.
+// Create using <om win32console.CreateConsoleBackBuffer>.
+// @comm Changes are made in memory, and <om PyConsoleBackBuffer.Flush> writes only the cells that differ
+// from what was last written, using one WriteConsoleOutputW call per band of changed rows.
+// A full screen redraw usually costs one or two calls instead of one per string or attribute run.
+// <nl>The object supports the buffer interface, exposing the cells as Height rows of Width CHAR_INFO
+// structs (a WCHAR character followed by a WORD of attributes), so they can be edited in bulk with
+// eg memoryview(bb).cast('H').  While any such view is alive, Flush compares every row against the
+// last flushed contents, so edits made through it are picked up without calling MarkDirty.
+extern PyTypeObject PyConsoleBackBufferType;
+
+class PyConsoleBackBuffer : public PyObject {
+   public:
+    static struct PyMemberDef members[];
+    static struct PyMethodDef methods[];
+    static void tp_dealloc(PyObject *ob);
+    PyConsoleBackBuffer(void);
+    ~PyConsoleBackBuffer(void);
+    BOOL Init(SHORT width, SHORT height, WORD attributes);
+    void MarkDirty(SHORT left, SHORT top, SHORT right, SHORT bottom);
+    BOOL ClipRect(PyObject *obrect, SMALL_RECT *prect);
+    static PyObject *PyWrite(PyObject *self, PyObject *args, PyObject *kwargs);
+    static PyObject *PyFill(PyObject *self, PyObject *args, PyObject *kwargs);
+    static PyObject *PyMarkDirty(PyObject *self, PyObject *args, PyObject *kwargs);
+    static PyObject *PyFlush(PyObject *self, PyObject *args, PyObject *kwargs);
+    static PyObject *PyLoad(PyObject *self, PyObject *args, PyObject *kwargs);
+    static int getbuffer(PyObject *self, Py_buffer *view, int flags);
+    static void releasebuffer(PyObject *self, Py_buffer *view);
+    CHAR_INFO *cells;   // what the caller has drawn
+    CHAR_INFO *shadow;  // what was last written to the console
+    SHORT *dirtyleft;   // per row, first and last columns changed since the last flush
+    SHORT *dirtyright;  // (left > right when the row is clean)
+    SHORT width, height;
+    BOOL bDiff;  // buffer was exported since the last flush, so rows must be compared
+    int exports;
+    DWORD flushes, cellswritten;
+};
+
+// Larger WriteConsoleOutput calls fail on older systems, so rectangles are split into strips of rows
+// no bigger than this.
+#define BACKBUFFER_MAX_CELLS 8000
+// More bands of changed rows than this are written as a single bounding rectangle.
+#define BACKBUFFER_MAX_RECTS 4
+
+PyConsoleBackBuffer::PyConsoleBackBuffer(void)
+{
+    ob_type = &PyConsoleBackBufferType;
+    cells = shadow = NULL;
+    dirtyleft = dirtyright = NULL;
+    width = height = 0;
+    bDiff = FALSE;
+    exports = 0;
+    flushes = cellswritten = 0;
+    _Py_NewReference(this);
+}
+
+PyConsoleBackBuffer::~PyConsoleBackBuffer(void)
+{
+    free(cells);
+    free(shadow);
+    free(dirtyleft);
+    free(dirtyright);
+}
+
+void PyConsoleBackBuffer::tp_dealloc(PyObject *ob) { delete (PyConsoleBackBuffer *)ob; }
+
+BOOL PyConsoleBackBuffer::Init(SHORT w, SHORT h, WORD attributes)
+{
+    size_t nbrcells = (size_t)w * h;
+    cells = (CHAR_INFO *)malloc(nbrcells * sizeof(CHAR_INFO));
+    shadow = (CHAR_INFO *)malloc(nbrcells * sizeof(CHAR_INFO));
+    dirtyleft = (SHORT *)malloc(h * sizeof(SHORT));
+    dirtyright = (SHORT *)malloc(h * sizeof(SHORT));
+    if (cells == NULL || shadow == NULL || dirtyleft == NULL || dirtyright == NULL) {
+        PyErr_Format(PyExc_MemoryError, "Unable to allocate a back buffer of %d x %d cells", w, h);
+        return FALSE;
+    }
+    width = w;
+    height = h;
+    for (size_t i = 0; i < nbrcells; i++) {
+        cells[i].Char.UnicodeChar = L' ';
+        cells[i].Attributes = attributes;
+    }
+    memcpy(shadow, cells, nbrcells * sizeof(CHAR_INFO));
+    // Nothing is known about the console yet, so the first flush writes everything.
+    MarkDirty(0, 0, width - 1, height - 1);
+    return TRUE;
+}
+
+// Coordinates must already be clipped to the buffer.
+void PyConsoleBackBuffer::MarkDirty(SHORT left, SHORT top, SHORT right, SHORT bottom)
+{
+    for (SHORT row = top; row <= bottom; row++) {
+        if (left < dirtyleft[row])
+            dirtyleft[row] = left;
+        if (right > dirtyright[row])
+            dirtyright[row] = right;
+    }
+}
+
+// Converts an optional PySMALL_RECT to a rectangle clipped to the buffer.
+// None means the whole buffer.  Returns FALSE with no exception set if nothing is left after clipping.
+BOOL PyConsoleBackBuffer::ClipRect(PyObject *obrect, SMALL_RECT *prect)
+{
+    PSMALL_RECT psr;
+    if (!PyWinObject_AsSMALL_RECT(obrect, &psr, TRUE))
+        return FALSE;
+    if (psr == NULL) {
+        prect->Left = prect->Top = 0;
+        prect->Right = width - 1;
+        prect->Bottom = height - 1;
+        return TRUE;
+    }
+    prect->Left = max(psr->Left, 0);
+    prect->Top = max(psr->Top, 0);
+    prect->Right = min(psr->Right, width - 1);
+    prect->Bottom = min(psr->Bottom, height - 1);
+    return prect->Left <= prect->Right && prect->Top <= prect->Bottom;
+}
+
+// @pymethod int|PyConsoleBackBuffer|Write|Places a string in the buffer at the given position
+// @rdesc Returns the number of characters placed.  Text that runs past the right edge of the buffer is
+// discarded rather than wrapped.
+PyObject *PyConsoleBackBuffer::PyWrite(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"X", "Y", "Text", "Attributes", NULL};
+    PyConsoleBackBuffer *bb = (PyConsoleBackBuffer *)self;
+    SHORT x, y;
+    int attributes = -1;
+    PyObject *obtext;
+    WCHAR *text;
+    DWORD textlen, nbrwritten = 0;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "hhO|i:Write", keywords,
+            &x,            // @pyparm int|X||Column of the first character
+            &y,            // @pyparm int|Y||Row of the first character
+            &obtext,       // @pyparm <o PyUNICODE>|Text||Characters to be placed
+            &attributes))  // @pyparm int|Attributes|-1|Text attributes for the characters, or -1 to keep the
+                           // ones already in those cells
+        return NULL;
+    if (!PyWinObject_AsWCHAR(obtext, &text, FALSE, &textlen))
+        return NULL;
+    if (y >= 0 && y < bb->height && x < bb->width) {
+        DWORD skip = x < 0 ? -x : 0;
+        SHORT left = x < 0 ? 0 : x;
+        if (skip < textlen) {
+            nbrwritten = min(textlen - skip, (DWORD)(bb->width - left));
+            CHAR_INFO *cell = bb->cells + (size_t)y * bb->width + left;
+            for (DWORD i = 0; i < nbrwritten; i++, cell++) {
+                cell->Char.UnicodeChar = text[skip + i];
+                if (attributes != -1)
+                    cell->Attributes = (WORD)attributes;
+            }
+            bb->MarkDirty(left, y, (SHORT)(left + nbrwritten - 1), y);
+        }
+    }
+    PyWinObject_FreeWCHAR(text);
+    return PyLong_FromUnsignedLong(nbrwritten);
+}
+
+// @pymethod |PyConsoleBackBuffer|Fill|Sets the character and/or attributes of every cell in a rectangle
+PyObject *PyConsoleBackBuffer::PyFill(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Rect", "Char", "Attributes", NULL};
+    PyConsoleBackBuffer *bb = (PyConsoleBackBuffer *)self;
+    PyObject *obrect = Py_None, *obchar = Py_None;
+    int attributes = -1;
+    WCHAR c;
+    SMALL_RECT rect;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|OOi:Fill", keywords,
+            &obrect,       // @pyparm <o PySMALL_RECT>|Rect|None|The cells to fill, clipped to the buffer.  None
+                           // fills the whole buffer.
+            &obchar,       // @pyparm <o PyUNICODE>|Char|None|Single character to fill with, or None to keep
+                           // the existing characters
+            &attributes))  // @pyparm int|Attributes|-1|Attributes to fill with, or -1 to keep the existing ones
+        return NULL;
+    if (obchar != Py_None && !PyWinObject_AsSingleWCHAR(obchar, &c))
+        return NULL;
+    if (!bb->ClipRect(obrect, &rect)) {
+        if (PyErr_Occurred())
+            return NULL;
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+    for (SHORT row = rect.Top; row <= rect.Bottom; row++) {
+        CHAR_INFO *cell = bb->cells + (size_t)row * bb->width + rect.Left;
+        for (SHORT col = rect.Left; col <= rect.Right; col++, cell++) {
+            if (obchar != Py_None)
+                cell->Char.UnicodeChar = c;
+            if (attributes != -1)
+                cell->Attributes = (WORD)attributes;
+        }
+    }
+    bb->MarkDirty(rect.Left, rect.Top, rect.Right, rect.Bottom);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod |PyConsoleBackBuffer|MarkDirty|Forces a rectangle to be written by the next flush
+// @comm Only needed to redraw cells that were changed on the console by other means, since edits made
+// through this object's methods or its buffer interface are found automatically.
+PyObject *PyConsoleBackBuffer::PyMarkDirty(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Rect", NULL};
+    PyConsoleBackBuffer *bb = (PyConsoleBackBuffer *)self;
+    PyObject *obrect = Py_None;
+    SMALL_RECT rect;
+    // @pyparm <o PySMALL_RECT>|Rect|None|The cells to mark, or None for the whole buffer
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|O:MarkDirty", keywords, &obrect))
+        return NULL;
+    if (bb->ClipRect(obrect, &rect)) {
+        bb->MarkDirty(rect.Left, rect.Top, rect.Right, rect.Bottom);
+        // Cells that match the shadow are trimmed by Flush, so make sure these ones don't.
+        for (SHORT row = rect.Top; row <= rect.Bottom; row++) {
+            size_t offset = (size_t)row * bb->width;
+            for (SHORT col = rect.Left; col <= rect.Right; col++)
+                bb->shadow[offset + col].Attributes = ~bb->cells[offset + col].Attributes;
+        }
+    }
+    else if (PyErr_Occurred())
+        return NULL;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static BOOL PyWinObject_AsConsoleOrigin(PyObject *oborigin, COORD *porigin)
+{
+    PCOORD pcoord;
+    if (!PyWinObject_AsCOORD(oborigin, &pcoord, TRUE))
+        return FALSE;
+    if (pcoord == NULL)
+        porigin->X = porigin->Y = 0;
+    else
+        *porigin = *pcoord;
+    return TRUE;
+}
+
+// @pymethod int|PyConsoleBackBuffer|Flush|Writes the changed cells to a console screen buffer
+// @rdesc Returns the number of rectangles written, 0 if nothing had changed
+// @comm Each row's changed span is trimmed to the cells that actually differ from what was last written,
+// and consecutive changed rows are written together as one rectangle.
+PyObject *PyConsoleBackBuffer::PyFlush(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"ConsoleOutput", "Origin", NULL};
+    PyConsoleBackBuffer *bb = (PyConsoleBackBuffer *)self;
+    PyObject *obh, *oborigin = Py_None;
+    HANDLE h;
+    COORD origin, bufsize = {bb->width, bb->height};
+    SMALL_RECT rects[BACKBUFFER_MAX_RECTS + 1];
+    int nbrrects = 0;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "O|O:Flush", keywords,
+            &obh,       // @pyparm <o PyConsoleScreenBuffer>|ConsoleOutput||Handle to the screen buffer to draw on
+            &oborigin))  // @pyparm <o PyCOORD>|Origin|None|Position in the screen buffer of the back buffer's
+                         // top left cell, defaults to (0,0)
+        return NULL;
+    if (!PyWinObject_AsHANDLE(obh, &h))
+        return NULL;
+    if (!PyWinObject_AsConsoleOrigin(oborigin, &origin))
+        return NULL;
+
+    BOOL bDiff = bb->bDiff || bb->exports > 0;
+    for (SHORT row = 0; row < bb->height; row++) {
+        SHORT left = bDiff ? 0 : bb->dirtyleft[row];
+        SHORT right = bDiff ? bb->width - 1 : bb->dirtyright[row];
+        CHAR_INFO *cells = bb->cells + (size_t)row * bb->width;
+        CHAR_INFO *shadow = bb->shadow + (size_t)row * bb->width;
+        while (left <= right && memcmp(&cells[left], &shadow[left], sizeof(CHAR_INFO)) == 0) left++;
+        while (right >= left && memcmp(&cells[right], &shadow[right], sizeof(CHAR_INFO)) == 0) right--;
+        bb->dirtyleft[row] = left;
+        bb->dirtyright[row] = right;
+        if (left > right)
+            continue;
+        // Extend the current band if the row above was changed too, otherwise start a new one.  Once
+        // there are too many bands the rest all go into the last, which is merged with the others below.
+        if (nbrrects == 0 || (rects[nbrrects - 1].Bottom != row - 1 && nbrrects <= BACKBUFFER_MAX_RECTS)) {
+            SMALL_RECT *rect = &rects[nbrrects++];
+            rect->Left = left;
+            rect->Right = right;
+            rect->Top = rect->Bottom = row;
+        }
+        else {
+            SMALL_RECT *rect = &rects[nbrrects - 1];
+            rect->Bottom = row;
+            rect->Left = min(rect->Left, left);
+            rect->Right = max(rect->Right, right);
+        }
+    }
+    if (nbrrects > BACKBUFFER_MAX_RECTS) {
+        for (int i = 0; i < nbrrects - 1; i++) {
+            rects[nbrrects - 1].Left = min(rects[nbrrects - 1].Left, rects[i].Left);
+            rects[nbrrects - 1].Right = max(rects[nbrrects - 1].Right, rects[i].Right);
+        }
+        rects[nbrrects - 1].Top = rects[0].Top;
+        rects[0] = rects[nbrrects - 1];
+        nbrrects = 1;
+    }
+
+    for (int i = 0; i < nbrrects; i++) {
+        SHORT rectwidth = rects[i].Right - rects[i].Left + 1;
+        SHORT strip = (SHORT)max(1, BACKBUFFER_MAX_CELLS / rectwidth);
+        for (SHORT top = rects[i].Top; top <= rects[i].Bottom; top += strip) {
+            COORD bufpos = {rects[i].Left, top};
+            SMALL_RECT region;
+            SHORT bottom = (SHORT)min(top + strip - 1, rects[i].Bottom);
+            region.Left = origin.X + rects[i].Left;
+            region.Top = origin.Y + top;
+            region.Right = origin.X + rects[i].Right;
+            region.Bottom = origin.Y + bottom;
+            bb->flushes++;
+            // Rows not written stay dirty, and rows already written will compare equal next time.
+            if (!WriteConsoleOutputW(h, bb->cells, bufsize, bufpos, &region))
+                return PyWin_SetAPIError("WriteConsoleOutputW");
+            for (SHORT row = top; row <= bottom; row++) {
+                size_t offset = (size_t)row * bb->width + rects[i].Left;
+                memcpy(bb->shadow + offset, bb->cells + offset, rectwidth * sizeof(CHAR_INFO));
+            }
+            bb->cellswritten += rectwidth * (bottom - top + 1);
+        }
+    }
+    for (SHORT row = 0; row < bb->height; row++) {
+        bb->dirtyleft[row] = bb->width;
+        bb->dirtyright[row] = -1;
+    }
+    bb->bDiff = FALSE;
+    return PyLong_FromLong(nbrrects);
+}
+
+// @pymethod |PyConsoleBackBuffer|Load|Fills the buffer with the current contents of a console screen buffer
+// @comm The cells read are treated as already written, so only later changes are flushed.
+PyObject *PyConsoleBackBuffer::PyLoad(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"ConsoleOutput", "Origin", NULL};
+    PyConsoleBackBuffer *bb = (PyConsoleBackBuffer *)self;
+    PyObject *obh, *oborigin = Py_None;
+    HANDLE h;
+    COORD origin, bufsize = {bb->width, bb->height}, bufpos = {0, 0};
+    SHORT strip = (SHORT)max(1, BACKBUFFER_MAX_CELLS / bb->width);
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "O|O:Load", keywords,
+            &obh,        // @pyparm <o PyConsoleScreenBuffer>|ConsoleOutput||Handle to the screen buffer to read
+            &oborigin))  // @pyparm <o PyCOORD>|Origin|None|Position in the screen buffer to read from, defaults
+                         // to (0,0)
+        return NULL;
+    if (!PyWinObject_AsHANDLE(obh, &h))
+        return NULL;
+    if (!PyWinObject_AsConsoleOrigin(oborigin, &origin))
+        return NULL;
+    for (bufpos.Y = 0; bufpos.Y < bb->height; bufpos.Y += strip) {
+        SMALL_RECT region;
+        region.Left = origin.X;
+        region.Top = origin.Y + bufpos.Y;
+        region.Right = origin.X + bb->width - 1;
+        region.Bottom = origin.Y + (SHORT)min(bufpos.Y + strip, bb->height) - 1;
+        if (!ReadConsoleOutputW(h, bb->cells, bufsize, bufpos, &region))
+            return PyWin_SetAPIError("ReadConsoleOutputW");
+    }
+    memcpy(bb->shadow, bb->cells, (size_t)bb->width * bb->height * sizeof(CHAR_INFO));
+    for (SHORT row = 0; row < bb->height; row++) {
+        bb->dirtyleft[row] = bb->width;
+        bb->dirtyright[row] = -1;
+    }
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+int PyConsoleBackBuffer::getbuffer(PyObject *self, Py_buffer *view, int flags)
+{
+    PyConsoleBackBuffer *bb = (PyConsoleBackBuffer *)self;
+    if (PyBuffer_FillInfo(view, self, bb->cells, (Py_ssize_t)bb->width * bb->height * sizeof(CHAR_INFO), 0,
+                          flags) == -1)
+        return -1;
+    bb->bDiff = TRUE;
+    bb->exports++;
+    return 0;
+}
+
+void PyConsoleBackBuffer::releasebuffer(PyObject *self, Py_buffer *view) { ((PyConsoleBackBuffer *)self)->exports--; }
+
+static PyBufferProcs PyConsoleBackBuffer_as_buffer = {
+    PyConsoleBackBuffer::getbuffer,
+    PyConsoleBackBuffer::releasebuffer,
+};
+
+struct PyMethodDef PyConsoleBackBuffer::methods[] = {
+    // @pymeth Write|Places a string in the buffer at the given position
+    {"Write", (PyCFunction)PyConsoleBackBuffer::PyWrite, METH_VARARGS | METH_KEYWORDS,
+     "Places a string in the buffer at the given position"},
+    // @pymeth Fill|Sets the character and/or attributes of every cell in a rectangle
+    {"Fill", (PyCFunction)PyConsoleBackBuffer::PyFill, METH_VARARGS | METH_KEYWORDS,
+     "Sets the character and/or attributes of every cell in a rectangle"},
+    // @pymeth MarkDirty|Forces a rectangle to be written by the next flush
+    {"MarkDirty", (PyCFunction)PyConsoleBackBuffer::PyMarkDirty, METH_VARARGS | METH_KEYWORDS,
+     "Forces a rectangle to be written by the next flush"},
+    // @pymeth Flush|Writes the changed cells to a console screen buffer
+    {"Flush", (PyCFunction)PyConsoleBackBuffer::PyFlush, METH_VARARGS | METH_KEYWORDS,
+     "Writes the changed cells to a console screen buffer"},
+    // @pymeth Load|Fills the buffer with the current contents of a console screen buffer
+    {"Load", (PyCFunction)PyConsoleBackBuffer::PyLoad, METH_VARARGS | METH_KEYWORDS,
+     "Fills the buffer with the current contents of a console screen buffer"},
+    {NULL}};
+
+struct PyMemberDef PyConsoleBackBuffer::members[] = {
+    // @prop int|Width|Number of columns
+    {"Width", T_SHORT, offsetof(PyConsoleBackBuffer, width), READONLY, "Number of columns"},
+    // @prop int|Height|Number of rows
+    {"Height", T_SHORT, offsetof(PyConsoleBackBuffer, height), READONLY, "Number of rows"},
+    // @prop int|Flushes|Number of WriteConsoleOutputW calls made
+    {"Flushes", T_ULONG, offsetof(PyConsoleBackBuffer, flushes), READONLY, "Number of WriteConsoleOutputW calls made"},
+    // @prop int|CellsWritten|Total number of cells written to the console
+    {"CellsWritten", T_ULONG, offsetof(PyConsoleBackBuffer, cellswritten), READONLY,
+     "Total number of cells written to the console"},
+    {NULL}};
+
+PyTypeObject PyConsoleBackBufferType = {
+    PYWIN_OBJECT_HEAD "PyConsoleBackBuffer",
+    sizeof(PyConsoleBackBuffer),
+    0,
+    PyConsoleBackBuffer::tp_dealloc,  // tp_dealloc
+    0,                                // tp_print
+    0,                                // tp_getattr
+    0,                                // tp_setattr
+    0,                                // tp_compare
+    0,                                // tp_repr
+    0,                                // tp_as_number
+    0,                                // tp_as_sequence
+    0,                                // tp_as_mapping
+    0,                                // tp_hash
+    0,                                // tp_call
+    0,                                // tp_str
+    PyObject_GenericGetAttr,          // tp_getattro
+    PyObject_GenericSetAttr,          // tp_setattro
+    &PyConsoleBackBuffer_as_buffer,   // tp_as_buffer
+    Py_TPFLAGS_DEFAULT,               // tp_flags
+    "Off-screen grid of console cells.  Create using CreateConsoleBackBuffer",  // tp_doc
+    0,                                                                          // tp_traverse
+    0,                                                                          // tp_clear
+    0,                                                                          // tp_richcompare
+    0,                                                                          // tp_weaklistoffset
+    0,                                                                          // tp_iter
+    0,                                                                          // tp_iternext
+    PyConsoleBackBuffer::methods,                                               // tp_methods
+    PyConsoleBackBuffer::members,                                               // tp_members
+};
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 // module functions start here
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1640,6 +2362,34 @@ static PyObject *PyCreateConsoleScreenBuffer(PyObject *self, PyObject *args, PyO
     return PyWinObject_FromConsoleScreenBuffer(hconsole, FALSE);
 }
 
+// @pymethod <o PyConsoleBackBuffer>|win32console|CreateConsoleBackBuffer|Creates an off-screen grid of console
+// cells that can be drawn to a screen buffer in bulk
+static PyObject *PyCreateConsoleBackBuffer(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Width", "Height", "Attributes", NULL};
+    SHORT width, height;
+    WORD attributes = FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "hh|H:CreateConsoleBackBuffer", keywords,
+            &width,        // @pyparm int|Width||Number of columns
+            &height,       // @pyparm int|Height||Number of rows
+            &attributes))  // @pyparm int|Attributes|FOREGROUND_RED\|FOREGROUND_GREEN\|FOREGROUND_BLUE|Initial
+                           // attributes of every cell.  All cells start out as spaces.
+        return NULL;
+    if (width <= 0 || height <= 0) {
+        PyErr_SetString(PyExc_ValueError, "Width and Height must be greater than 0");
+        return NULL;
+    }
+    PyConsoleBackBuffer *ret = new PyConsoleBackBuffer();
+    if (ret == NULL)
+        return PyErr_NoMemory();
+    if (!ret->Init(width, height, attributes)) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    return ret;
+}
+
 // @pymethod int|win32console|GetConsoleDisplayMode|Returns the current console's display mode
 // @comm Only exists on Wix XP and later
 // @rdesc CONSOLE_FULLSCREEN,CONSOLE_FULLSCREEN_HARDWARE
@@ -2016,6 +2766,9 @@ static struct PyMethodDef win32console_functions[] = {
     // @pymeth CreateConsoleScreenBuffer|Creates a new console handle
     {"CreateConsoleScreenBuffer", (PyCFunction)PyCreateConsoleScreenBuffer, METH_VARARGS | METH_KEYWORDS,
      "Creates a new console screen buffer"},
+    // @pymeth CreateConsoleBackBuffer|Creates an off-screen grid of cells that can be drawn to a console in bulk
+    {"CreateConsoleBackBuffer", (PyCFunction)PyCreateConsoleBackBuffer, METH_VARARGS | METH_KEYWORDS,
+     "Creates an off-screen grid of cells that can be drawn to a console in bulk"},
     // @pymeth GetConsoleDisplayMode|Returns the current console's display mode
     {"GetConsoleDisplayMode", PyGetConsoleDisplayMode, METH_VARARGS, "Returns the current console's display mode"},
     // @pymeth AttachConsole|Attaches calling process to console of another process
@@ -2109,6 +2862,16 @@ PYWIN_MODULE_INIT_FUNC(win32console)
     if (PyDict_SetItemString(dict, "PyConsoleScreenBufferType", (PyObject *)&PyConsoleScreenBufferType) == -1)
         PYWIN_MODULE_INIT_RETURN_ERROR;
 
+    if (PyType_Ready(&PyConsoleBackBufferType) == -1)
+        PYWIN_MODULE_INIT_RETURN_ERROR;
+    if (PyDict_SetItemString(dict, "PyConsoleBackBufferType", (PyObject *)&PyConsoleBackBufferType) == -1)
+        PYWIN_MODULE_INIT_RETURN_ERROR;
+
+    if (PyType_Ready(&PyConsoleInputBatchType) == -1)
+        PYWIN_MODULE_INIT_RETURN_ERROR;
+    if (PyDict_SetItemString(dict, "PyConsoleInputBatchType", (PyObject *)&PyConsoleInputBatchType) == -1)
+        PYWIN_MODULE_INIT_RETURN_ERROR;
+
     if (PyType_Ready(&PySMALL_RECTType) == -1)
         PYWIN_MODULE_INIT_RETURN_ERROR;
     if (PyDict_SetItemString(dict, "PySMALL_RECTType", (PyObject *)&PySMALL_RECTType) == -1)
@@ -1007,6 +1007,527 @@ done:
     return ret;
 }
 
+// The block of memory returned by CredRead or CredEnumerate, shared by all the
+// <o PyCREDENTIAL_OBJECT>s created from it.  Credential blobs are wiped before the
+// block is returned to CredFree.
+struct CRED_BLOCK {
+    LONG refs;
+    void *block;
+    PCREDENTIAL *creds;
+    DWORD count;
+};
+
+CRED_BLOCK *NewCRED_BLOCK(void *block, PCREDENTIAL *creds, DWORD count)
+{
+    CRED_BLOCK *ret = (CRED_BLOCK *)malloc(sizeof(CRED_BLOCK));
+    if (ret == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    ret->refs = 1;
+    ret->block = block;
+    ret->creds = creds;
+    ret->count = count;
+    return ret;
+}
+
+void ReleaseCRED_BLOCK(CRED_BLOCK *b)
+{
+    if (--b->refs > 0)
+        return;
+    for (DWORD i = 0; i < b->count; i++)
+        if (b->creds[i]->CredentialBlob)
+            SecureZeroMemory(b->creds[i]->CredentialBlob, b->creds[i]->CredentialBlobSize);
+    CredFree(b->block);
+    free(b);
+}
+
+// @object PyCREDENTIAL_BLOB|A private copy of a credential's secret, which is wiped when the
+// object is destroyed or <om PyCREDENTIAL_BLOB.Clear> is called.
+// @comm Supports the buffer protocol, so the secret can be used via memoryview without
+// creating any other copies.  <om PyCREDENTIAL_BLOB.Text> necessarily creates an ordinary
+// string, which can't be wiped.
+class PyCREDENTIAL_BLOB : public PyObject {
+   public:
+    PyCREDENTIAL_BLOB(BYTE *data, DWORD size);
+    ~PyCREDENTIAL_BLOB();
+    static void deallocFunc(PyObject *ob);
+    static int getbufferinfo(PyObject *self, Py_buffer *view, int flags);
+    static void releasebufferinfo(PyObject *self, Py_buffer *view);
+    static PyObject *Text(PyObject *self, PyObject *args);
+    static PyObject *Clear(PyObject *self, PyObject *args);
+    static PyObject *get_Size(PyObject *self, void *unused);
+    static struct PyMethodDef methods[];
+    static struct PyGetSetDef getset[];
+
+    BYTE *m_data;  // NULL once cleared
+    DWORD m_size;
+    int m_exports;
+};
+
+struct PyMethodDef PyCREDENTIAL_BLOB::methods[] = {
+    {"Text", PyCREDENTIAL_BLOB::Text, METH_VARARGS},    // @pymeth Text|Decodes the secret as a UTF-16 string
+    {"Clear", PyCREDENTIAL_BLOB::Clear, METH_VARARGS},  // @pymeth Clear|Wipes the secret immediately
+    {NULL}};
+
+struct PyGetSetDef PyCREDENTIAL_BLOB::getset[] = {
+    // @prop int|Size|Size of the secret in bytes, 0 once cleared
+    {"Size", PyCREDENTIAL_BLOB::get_Size, NULL, "Size of the secret in bytes"},
+    {NULL}};
+
+static PyBufferProcs PyCREDENTIAL_BLOB_as_buffer = {
+    PyCREDENTIAL_BLOB::getbufferinfo,
+    PyCREDENTIAL_BLOB::releasebufferinfo,
+};
+
+PyTypeObject PyCREDENTIAL_BLOBType = {
+    PYWIN_OBJECT_HEAD "PyCREDENTIAL_BLOB",
+    sizeof(PyCREDENTIAL_BLOB),
+    0,
+    PyCREDENTIAL_BLOB::deallocFunc, /* tp_dealloc */
+    0,                              /* tp_print */
+    0,                              /* tp_getattr */
+    0,                              /* tp_setattr */
+    0,                              /* tp_compare */
+    0,                              /* tp_repr */
+    0,                              /* tp_as_number */
+    0,                              /* tp_as_sequence */
+    0,                              /* tp_as_mapping */
+    0,                              /* tp_hash */
+    0,                              /* tp_call */
+    0,                              /* tp_str */
+    PyObject_GenericGetAttr,        /* tp_getattro */
+    0,                              /* tp_setattro */
+    &PyCREDENTIAL_BLOB_as_buffer,   /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,             /* tp_flags */
+    0,                              /* tp_doc */
+    0,                              /* tp_traverse */
+    0,                              /* tp_clear */
+    0,                              /* tp_richcompare */
+    0,                              /* tp_weaklistoffset */
+    0,                              /* tp_iter */
+    0,                              /* tp_iternext */
+    PyCREDENTIAL_BLOB::methods,     /* tp_methods */
+    0,                              /* tp_members */
+    PyCREDENTIAL_BLOB::getset,      /* tp_getset */
+};
+
+PyCREDENTIAL_BLOB::PyCREDENTIAL_BLOB(BYTE *data, DWORD size)
+{
+    ob_type = &PyCREDENTIAL_BLOBType;
+    _Py_NewReference(this);
+    m_data = data;
+    m_size = size;
+    m_exports = 0;
+}
+
+PyCREDENTIAL_BLOB::~PyCREDENTIAL_BLOB()
+{
+    if (m_data) {
+        SecureZeroMemory(m_data, m_size);
+        free(m_data);
+    }
+}
+
+/*static*/ void PyCREDENTIAL_BLOB::deallocFunc(PyObject *ob) { delete (PyCREDENTIAL_BLOB *)ob; }
+
+PyObject *PyWinObject_FromCredentialBlob(PCREDENTIAL cred)
+{
+    // Always allocate at least one byte so a cleared blob can be told apart from an empty one
+    BYTE *data = (BYTE *)malloc(cred->CredentialBlobSize ? cred->CredentialBlobSize : 1);
+    if (data == NULL)
+        return PyErr_NoMemory();
+    if (cred->CredentialBlobSize)
+        memcpy(data, cred->CredentialBlob, cred->CredentialBlobSize);
+    return new PyCREDENTIAL_BLOB(data, cred->CredentialBlobSize);
+}
+
+/*static*/ int PyCREDENTIAL_BLOB::getbufferinfo(PyObject *self, Py_buffer *view, int flags)
+{
+    PyCREDENTIAL_BLOB *This = (PyCREDENTIAL_BLOB *)self;
+    if (This->m_data == NULL) {
+        PyErr_SetString(PyExc_ValueError, "The credential blob has been cleared");
+        return -1;
+    }
+    if (PyBuffer_FillInfo(view, self, This->m_data, This->m_size, 1, flags) == -1)
+        return -1;
+    This->m_exports++;
+    return 0;
+}
+
+/*static*/ void PyCREDENTIAL_BLOB::releasebufferinfo(PyObject *self, Py_buffer *view)
+{
+    ((PyCREDENTIAL_BLOB *)self)->m_exports--;
+}
+
+PyObject *PyCREDENTIAL_BLOB::get_Size(PyObject *self, void *unused)
+{
+    PyCREDENTIAL_BLOB *This = (PyCREDENTIAL_BLOB *)self;
+    return PyLong_FromUnsignedLong(This->m_data ? This->m_size : 0);
+}
+
+// @pymethod <o PyUnicode>|PyCREDENTIAL_BLOB|Text|Decodes the secret as a UTF-16 string
+// @comm This is the format used by CRED_TYPE_DOMAIN_PASSWORD credentials, and by most
+// applications that store passwords in CRED_TYPE_GENERIC credentials.
+PyObject *PyCREDENTIAL_BLOB::Text(PyObject *self, PyObject *args)
+{
+    CHECK_NO_ARGS2(args, "Text");
+    PyCREDENTIAL_BLOB *This = (PyCREDENTIAL_BLOB *)self;
+    if (This->m_data == NULL) {
+        PyErr_SetString(PyExc_ValueError, "The credential blob has been cleared");
+        return NULL;
+    }
+    return PyWinObject_FromWCHAR((WCHAR *)This->m_data, This->m_size / sizeof(WCHAR));
+}
+
+// @pymethod |PyCREDENTIAL_BLOB|Clear|Wipes and frees the secret
+// @comm Raises BufferError if a memoryview or similar still refers to the secret.
+PyObject *PyCREDENTIAL_BLOB::Clear(PyObject *self, PyObject *args)
+{
+    CHECK_NO_ARGS2(args, "Clear");
+    PyCREDENTIAL_BLOB *This = (PyCREDENTIAL_BLOB *)self;
+    if (This->m_exports) {
+        PyErr_SetString(PyExc_BufferError, "The credential blob is still being used by another object");
+        return NULL;
+    }
+    if (This->m_data) {
+        SecureZeroMemory(This->m_data, This->m_size);
+        free(This->m_data);
+        This->m_data = NULL;
+    }
+    RETURN_NONE;
+}
+
+// @object PyCREDENTIAL_OBJECT|A stored credential, as returned by <om win32cred.CredReadMany> and
+// <om win32cred.CredEnumerateObjects>.
+// @comm Fields are converted only when accessed, directly from the memory returned by the
+// credential manager, which is shared between all objects returned from the same call.
+// The secret is only copied when <om PyCREDENTIAL_OBJECT.CredentialBlob> is accessed, and
+// the memory is wiped before it is released.
+class PyCREDENTIAL_OBJECT : public PyObject {
+   public:
+    PyCREDENTIAL_OBJECT(CRED_BLOCK *block, PCREDENTIAL cred);
+    ~PyCREDENTIAL_OBJECT();
+    static void deallocFunc(PyObject *ob);
+    static PyObject *AsDict(PyObject *self, PyObject *args);
+    static PyObject *getattro(PyObject *self, void *which);
+    static struct PyMethodDef methods[];
+    static struct PyGetSetDef getset[];
+
+    CRED_BLOCK *m_block;
+    PCREDENTIAL m_cred;
+};
+
+enum {
+    CREDOBJ_FLAGS,
+    CREDOBJ_TYPE,
+    CREDOBJ_TARGETNAME,
+    CREDOBJ_COMMENT,
+    CREDOBJ_LASTWRITTEN,
+    CREDOBJ_BLOB,
+    CREDOBJ_PERSIST,
+    CREDOBJ_ATTRIBUTES,
+    CREDOBJ_TARGETALIAS,
+    CREDOBJ_USERNAME,
+};
+
+struct PyMethodDef PyCREDENTIAL_OBJECT::methods[] = {
+    {"AsDict", PyCREDENTIAL_OBJECT::AsDict, METH_VARARGS},  // @pymeth AsDict|Returns a <o PyCREDENTIAL> dict
+    {NULL}};
+
+struct PyGetSetDef PyCREDENTIAL_OBJECT::getset[] = {
+    // @prop int|Flags|Combination of CRED_FLAGS_* values
+    {"Flags", PyCREDENTIAL_OBJECT::getattro, NULL, NULL, (void *)CREDOBJ_FLAGS},
+    // @prop int|Type|One of the CRED_TYPE_* values
+    {"Type", PyCREDENTIAL_OBJECT::getattro, NULL, NULL, (void *)CREDOBJ_TYPE},
+    // @prop <o PyUnicode>|TargetName|Target of the credential
+    {"TargetName", PyCREDENTIAL_OBJECT::getattro, NULL, NULL, (void *)CREDOBJ_TARGETNAME},
+    // @prop <o PyUnicode>|Comment|Description of the credential, can be None
+    {"Comment", PyCREDENTIAL_OBJECT::getattro, NULL, NULL, (void *)CREDOBJ_COMMENT},
+    // @prop <o PyDateTime>|LastWritten|Time the credential was last modified
+    {"LastWritten", PyCREDENTIAL_OBJECT::getattro, NULL, NULL, (void *)CREDOBJ_LASTWRITTEN},
+    // @prop <o PyCREDENTIAL_BLOB>|CredentialBlob|A new private copy of the secret on each access
+    {"CredentialBlob", PyCREDENTIAL_OBJECT::getattro, NULL, NULL, (void *)CREDOBJ_BLOB},
+    // @prop int|Persist|One of the CRED_PERSIST_* values
+    {"Persist", PyCREDENTIAL_OBJECT::getattro, NULL, NULL, (void *)CREDOBJ_PERSIST},
+    // @prop tuple|Attributes|Tuple of <o PyCREDENTIAL_ATTRIBUTE> dicts
+    {"Attributes", PyCREDENTIAL_OBJECT::getattro, NULL, NULL, (void *)CREDOBJ_ATTRIBUTES},
+    // @prop <o PyUnicode>|TargetAlias|Alias for TargetName, can be None
+    {"TargetAlias", PyCREDENTIAL_OBJECT::getattro, NULL, NULL, (void *)CREDOBJ_TARGETALIAS},
+    // @prop <o PyUnicode>|UserName|User to be authenticated by target, can be None
+    {"UserName", PyCREDENTIAL_OBJECT::getattro, NULL, NULL, (void *)CREDOBJ_USERNAME},
+    {NULL}};
+
+PyTypeObject PyCREDENTIAL_OBJECTType = {
+    PYWIN_OBJECT_HEAD "PyCREDENTIAL_OBJECT",
+    sizeof(PyCREDENTIAL_OBJECT),
+    0,
+    PyCREDENTIAL_OBJECT::deallocFunc, /* tp_dealloc */
+    0,                                /* tp_print */
+    0,                                /* tp_getattr */
+    0,                                /* tp_setattr */
+    0,                                /* tp_compare */
+    0,                                /* tp_repr */
+    0,                                /* tp_as_number */
+    0,                                /* tp_as_sequence */
+    0,                                /* tp_as_mapping */
+    0,                                /* tp_hash */
+    0,                                /* tp_call */
+    0,                                /* tp_str */
+    PyObject_GenericGetAttr,          /* tp_getattro */
+    0,                                /* tp_setattro */
+    0,                                /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,               /* tp_flags */
+    0,                                /* tp_doc */
+    0,                                /* tp_traverse */
+    0,                                /* tp_clear */
+    0,                                /* tp_richcompare */
+    0,                                /* tp_weaklistoffset */
+    0,                                /* tp_iter */
+    0,                                /* tp_iternext */
+    PyCREDENTIAL_OBJECT::methods,     /* tp_methods */
+    0,                                /* tp_members */
+    PyCREDENTIAL_OBJECT::getset,      /* tp_getset */
+};
+
+PyCREDENTIAL_OBJECT::PyCREDENTIAL_OBJECT(CRED_BLOCK *block, PCREDENTIAL cred)
+{
+    ob_type = &PyCREDENTIAL_OBJECTType;
+    _Py_NewReference(this);
+    block->refs++;
+    m_block = block;
+    m_cred = cred;
+}
+
+PyCREDENTIAL_OBJECT::~PyCREDENTIAL_OBJECT() { ReleaseCRED_BLOCK(m_block); }
+
+/*static*/ void PyCREDENTIAL_OBJECT::deallocFunc(PyObject *ob) { delete (PyCREDENTIAL_OBJECT *)ob; }
+
+PyObject *PyCREDENTIAL_OBJECT::getattro(PyObject *self, void *which)
+{
+    PCREDENTIAL cred = ((PyCREDENTIAL_OBJECT *)self)->m_cred;
+    switch ((INT_PTR)which) {
+        case CREDOBJ_FLAGS:
+            return PyLong_FromUnsignedLong(cred->Flags);
+        case CREDOBJ_TYPE:
+            return PyLong_FromUnsignedLong(cred->Type);
+        case CREDOBJ_TARGETNAME:
+            return PyWinObject_FromWCHAR(cred->TargetName);
+        case CREDOBJ_COMMENT:
+            return PyWinObject_FromWCHAR(cred->Comment);
+        case CREDOBJ_LASTWRITTEN:
+            return PyWinObject_FromFILETIME(cred->LastWritten);
+        case CREDOBJ_BLOB:
+            return PyWinObject_FromCredentialBlob(cred);
+        case CREDOBJ_PERSIST:
+            return PyLong_FromUnsignedLong(cred->Persist);
+        case CREDOBJ_ATTRIBUTES:
+            return PyWinObject_FromCREDENTIAL_ATTRIBUTEArray(cred->Attributes, cred->AttributeCount);
+        case CREDOBJ_TARGETALIAS:
+            return PyWinObject_FromWCHAR(cred->TargetAlias);
+        case CREDOBJ_USERNAME:
+            return PyWinObject_FromWCHAR(cred->UserName);
+    }
+    PyErr_SetString(PyExc_SystemError, "Unknown credential attribute");
+    return NULL;
+}
+
+// @pymethod <o PyCREDENTIAL>|PyCREDENTIAL_OBJECT|AsDict|Converts all fields to a dict, in the
+// same form returned by <om win32cred.CredRead>
+// @comm The CredentialBlob in the dict is an ordinary string that will not be wiped.
+PyObject *PyCREDENTIAL_OBJECT::AsDict(PyObject *self, PyObject *args)
+{
+    CHECK_NO_ARGS2(args, "AsDict");
+    return PyWinObject_FromCREDENTIAL(((PyCREDENTIAL_OBJECT *)self)->m_cred);
+}
+
+// @pymethod [<o PyCREDENTIAL_OBJECT>,...]|win32cred|CredReadMany|Retrieves several stored credentials
+// in a single call
+// @rdesc Returns a list containing a <o PyCREDENTIAL_OBJECT> for each target, or None if the
+// target does not exist.  Any other error is raised.
+// @comm The lock is released once for the whole batch, rather than for each credential.
+PyObject *PyCredReadMany(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Targets", "Type", "Flags", NULL};
+    PyObject *obtargets, *ret = NULL;
+    DWORD cred_type = CRED_TYPE_GENERIC, flags = 0;
+    // @pyparm [<o PyUnicode>|(<o PyUnicode>, int),...]|Targets||Sequence of target names, or of
+    // (TargetName, Type) tuples to read credentials of different types
+    // @pyparm int|Type|CRED_TYPE_GENERIC|Type of credential used for target names without an explicit type
+    // @pyparm int|Flags|0|Reserved, use 0
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|kk:CredReadMany", keywords, &obtargets, &cred_type, &flags))
+        return NULL;
+    PyObject *targets_seq = PySequence_Fast(obtargets, "Targets must be a sequence");
+    if (targets_seq == NULL)
+        return NULL;
+    DWORD target_cnt = (DWORD)PySequence_Fast_GET_SIZE(targets_seq), target_ind;
+    WCHAR **targetnames = (WCHAR **)calloc(target_cnt + 1, sizeof(WCHAR *));
+    DWORD *types = (DWORD *)calloc(target_cnt + 1, sizeof(DWORD));
+    PCREDENTIAL *creds = (PCREDENTIAL *)calloc(target_cnt + 1, sizeof(PCREDENTIAL));
+    DWORD err = 0;
+    if (targetnames == NULL || types == NULL || creds == NULL) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    for (target_ind = 0; target_ind < target_cnt; target_ind++) {
+        PyObject *obtarget = PySequence_Fast_GET_ITEM(targets_seq, target_ind), *obname = obtarget;
+        types[target_ind] = cred_type;
+        if (PyTuple_Check(obtarget) && !PyArg_ParseTuple(obtarget, "Ok", &obname, &types[target_ind]))
+            goto done;
+        if (!PyWinObject_AsWCHAR(obname, &targetnames[target_ind], FALSE))
+            goto done;
+    }
+    Py_BEGIN_ALLOW_THREADS for (target_ind = 0; target_ind < target_cnt; target_ind++)
+    {
+        if (!CredRead(targetnames[target_ind], types[target_ind], flags, &creds[target_ind])) {
+            creds[target_ind] = NULL;
+            err = GetLastError();
+            if (err != ERROR_NOT_FOUND)
+                break;
+            err = 0;
+        }
+    }
+    Py_END_ALLOW_THREADS if (err)
+    {
+        PyWin_SetAPIError("CredRead", err);
+        goto done;
+    }
+    ret = PyList_New(target_cnt);
+    if (ret == NULL)
+        goto done;
+    for (target_ind = 0; target_ind < target_cnt; target_ind++) {
+        PyObject *ret_item;
+        if (creds[target_ind] == NULL) {
+            Py_INCREF(Py_None);
+            ret_item = Py_None;
+        }
+        else {
+            CRED_BLOCK *block = NewCRED_BLOCK(creds[target_ind], NULL, 1);
+            if (block == NULL) {
+                Py_CLEAR(ret);
+                goto done;
+            }
+            // The block takes over the credential
+            block->creds = (PCREDENTIAL *)&block->block;
+            creds[target_ind] = NULL;
+            ret_item = new PyCREDENTIAL_OBJECT(block, (PCREDENTIAL)block->block);
+            ReleaseCRED_BLOCK(block);
+        }
+        PyList_SET_ITEM(ret, target_ind, ret_item);
+    }
+
+done:
+    if (targetnames) {
+        for (target_ind = 0; target_ind < target_cnt; target_ind++) PyWinObject_FreeWCHAR(targetnames[target_ind]);
+        free(targetnames);
+    }
+    if (creds) {
+        for (target_ind = 0; target_ind < target_cnt; target_ind++)
+            if (creds[target_ind]) {
+                if (creds[target_ind]->CredentialBlob)
+                    SecureZeroMemory(creds[target_ind]->CredentialBlob, creds[target_ind]->CredentialBlobSize);
+                CredFree(creds[target_ind]);
+            }
+        free(creds);
+    }
+    if (types)
+        free(types);
+    Py_DECREF(targets_seq);
+    return ret;
+}
+
+// @pymethod [<o PyCREDENTIAL_OBJECT>,...]|win32cred|CredEnumerateObjects|Lists credentials for
+// current logon session, optionally filtering them by type, persistence or user name
+// @rdesc Returns a list of <o PyCREDENTIAL_OBJECT>s.  Credentials that don't match the filters
+// are skipped without creating any Python objects for them.
+// @comm If no credentials match, an empty list is returned instead of raising ERROR_NOT_FOUND
+// as <om win32cred.CredEnumerate> does.
+PyObject *PyCredEnumerateObjects(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Filter", "Flags", "Types", "Persist", "UserName", NULL};
+    PyObject *obfilter = Py_None, *obtypes = Py_None, *obpersist = Py_None, *obusername = Py_None, *ret = NULL;
+    WCHAR *filter = NULL, *username = NULL;
+    DWORD flags = 0, cred_cnt = 0, persist = 0, type_mask = 0;
+    PCREDENTIAL *credentials = NULL;
+    CRED_BLOCK *block = NULL;
+    BOOL bsuccess;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|OkOOO:CredEnumerateObjects", keywords,
+            &obfilter,    // @pyparm <o PyUnicode>|Filter|None|Matches credentials' target names by prefix, can be None
+            &flags,       // @pyparm int|Flags|0|Flags passed to CredEnumerate
+            &obtypes,     // @pyparm (int,...)|Types|None|Sequence of CRED_TYPE_* values to include, None for all
+            &obpersist,   // @pyparm int|Persist|None|Only include credentials with this CRED_PERSIST_* value
+            &obusername)) // @pyparm <o PyUnicode>|UserName|None|Only include credentials for this user, case-insensitive
+        return NULL;
+    if (obtypes != Py_None) {
+        PyObject *types_seq = PySequence_Fast(obtypes, "Types must be a sequence of ints");
+        if (types_seq == NULL)
+            return NULL;
+        for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(types_seq); i++) {
+            DWORD t = PyLong_AsUnsignedLong(PySequence_Fast_GET_ITEM(types_seq, i));
+            if (t == (DWORD)-1 && PyErr_Occurred()) {
+                Py_DECREF(types_seq);
+                return NULL;
+            }
+            if (t >= 32) {
+                Py_DECREF(types_seq);
+                return PyErr_Format(PyExc_ValueError, "Invalid credential type %u", t);
+            }
+            type_mask |= 1 << t;
+        }
+        Py_DECREF(types_seq);
+    }
+    if (obpersist != Py_None) {
+        persist = PyLong_AsUnsignedLong(obpersist);
+        if (persist == (DWORD)-1 && PyErr_Occurred())
+            return NULL;
+    }
+    if (!PyWinObject_AsWCHAR(obfilter, &filter, TRUE))
+        return NULL;
+    if (!PyWinObject_AsWCHAR(obusername, &username, TRUE))
+        goto done;
+    Py_BEGIN_ALLOW_THREADS bsuccess = CredEnumerate(filter, flags, &cred_cnt, &credentials);
+    Py_END_ALLOW_THREADS if (!bsuccess)
+    {
+        if (GetLastError() == ERROR_NOT_FOUND)
+            ret = PyList_New(0);
+        else
+            PyWin_SetAPIError("CredEnumerate");
+        goto done;
+    }
+    block = NewCRED_BLOCK(credentials, credentials, cred_cnt);
+    if (block == NULL) {
+        CredFree(credentials);
+        goto done;
+    }
+    ret = PyList_New(0);
+    if (ret == NULL)
+        goto done;
+    for (DWORD cred_ind = 0; cred_ind < cred_cnt; cred_ind++) {
+        PCREDENTIAL cred = credentials[cred_ind];
+        if (type_mask && (cred->Type >= 32 || !(type_mask & (1 << cred->Type))))
+            continue;
+        if (obpersist != Py_None && cred->Persist != persist)
+            continue;
+        if (username && (cred->UserName == NULL || _wcsicmp(cred->UserName, username) != 0))
+            continue;
+        PyObject *ret_item = new PyCREDENTIAL_OBJECT(block, cred);
+        int rc = PyList_Append(ret, ret_item);
+        Py_DECREF(ret_item);
+        if (rc == -1) {
+            Py_CLEAR(ret);
+            break;
+        }
+    }
+
+done:
+    if (block)
+        ReleaseCRED_BLOCK(block);
+    PyWinObject_FreeWCHAR(filter);
+    PyWinObject_FreeWCHAR(username);
+    return ret;
+}
+
 // @module win32cred|Interface to credentials management functions.
 // The functions in this module are only available on Windows XP and later.<nl>
 // Functions operate only on the credential set of the calling user.<nl>
@@ -1041,6 +1562,12 @@ static struct PyMethodDef win32cred_functions[] = {
     {"CredWrite", (PyCFunction)PyCredWrite, METH_VARARGS | METH_KEYWORDS, "Creates or updates a stored credential"},
     // @pymeth CredRead|Retrieves a stored credential
     {"CredRead", (PyCFunction)PyCredRead, METH_VARARGS | METH_KEYWORDS, "Retrieves a stored credential"},
+    // @pymeth CredReadMany|Retrieves several stored credentials in a single call
+    {"CredReadMany", (PyCFunction)PyCredReadMany, METH_VARARGS | METH_KEYWORDS,
+     "Retrieves several stored credentials in a single call"},
+    // @pymeth CredEnumerateObjects|Lists stored credentials as lazily converted objects, with native filtering
+    {"CredEnumerateObjects", (PyCFunction)PyCredEnumerateObjects, METH_VARARGS | METH_KEYWORDS,
+     "Lists stored credentials as lazily converted objects, with native filtering"},
     // @pymeth CredRename|Changes the target name of stored credentials
     {"CredRename", (PyCFunction)PyCredRename, METH_VARARGS | METH_KEYWORDS,
      "Changes the target name of stored credentials"},
@@ -1067,6 +1594,8 @@ static struct PyMethodDef win32cred_functions[] = {
 PYWIN_MODULE_INIT_FUNC(win32cred)
 {
     PYWIN_MODULE_INIT_PREPARE(win32cred, win32cred_functions, "Interface to credentials management functions.");
+    if (PyType_Ready(&PyCREDENTIAL_OBJECTType) == -1 || PyType_Ready(&PyCREDENTIAL_BLOBType) == -1)
+        PYWIN_MODULE_INIT_RETURN_ERROR;
 
     // CRED_MARSHAL_TYPE used with CredMarshalCredential and CredUnmarshalCredential
     PyModule_AddIntConstant(module, "CertCredential", CertCredential);
@@ -0,0 +1,713 @@
+// @doc
+#include "win32crypt.h"
+
+// Algorithm provider handles are expensive to open, so each one is opened once and kept for the life of the process.
+struct BCRYPT_PROVIDER_ENTRY {
+    WCHAR name[32];
+    ULONG flags;
+    BCRYPT_ALG_HANDLE halg;
+};
+#define MAX_BCRYPT_PROVIDERS 32
+static BCRYPT_PROVIDER_ENTRY bcrypt_providers[MAX_BCRYPT_PROVIDERS];
+static int bcrypt_provider_cnt = 0;
+
+PyObject *PyWin_SetBCryptError(char *fname, NTSTATUS status)
+{
+    return PyWin_SetAPIError(fname, LsaNtStatusToWinError(status));
+}
+
+// Called with the GIL held, which also protects the cache.
+static BCRYPT_ALG_HANDLE GetBCryptProvider(PyObject *obalgorithm, ULONG flags)
+{
+    TmpWCHAR algorithm;
+    if (!PyWinObject_AsWCHAR(obalgorithm, &algorithm, FALSE))
+        return NULL;
+    int i;
+    for (i = 0; i < bcrypt_provider_cnt; i++)
+        if (bcrypt_providers[i].flags == flags && wcscmp(bcrypt_providers[i].name, algorithm) == 0)
+            return bcrypt_providers[i].halg;
+    BCRYPT_ALG_HANDLE halg;
+    NTSTATUS status;
+    Py_BEGIN_ALLOW_THREADS status = BCryptOpenAlgorithmProvider(&halg, algorithm, NULL, flags);
+    Py_END_ALLOW_THREADS if (!BCRYPT_SUCCESS(status))
+    {
+        PyWin_SetBCryptError("BCryptOpenAlgorithmProvider", status);
+        return NULL;
+    }
+    if (bcrypt_provider_cnt < MAX_BCRYPT_PROVIDERS && wcslen(algorithm) < 32) {
+        wcscpy(bcrypt_providers[bcrypt_provider_cnt].name, algorithm);
+        bcrypt_providers[bcrypt_provider_cnt].flags = flags;
+        bcrypt_providers[bcrypt_provider_cnt].halg = halg;
+        bcrypt_provider_cnt++;
+    }
+    // When the cache is full the handle is simply never closed, which only happens with unusual algorithm names.
+    return halg;
+}
+
+static BOOL GetBCryptULONGProperty(BCRYPT_HANDLE h, LPCWSTR prop, ULONG *pval)
+{
+    ULONG size;
+    NTSTATUS status = BCryptGetProperty(h, prop, (PUCHAR)pval, sizeof(*pval), &size, 0);
+    if (!BCRYPT_SUCCESS(status)) {
+        PyWin_SetBCryptError("BCryptGetProperty", status);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// @object PyBCRYPT_HASH|A CNG hash or HMAC object, created by <om win32crypt.BCryptCreateHash>
+// @comm Data can be any object supporting the buffer interface, and is hashed in place, with the GIL released.
+// The object is reusable - after <om PyBCRYPT_HASH.BCryptFinishHash> it is ready to hash a new message with the
+// same algorithm and secret.  Only one thread may use it at a time.
+struct PyMethodDef PyBCRYPT_HASH::methods[] = {
+    // @pymeth BCryptHashData|Adds data to the hash
+    {"BCryptHashData", (PyCFunction)PyBCRYPT_HASH::PyBCryptHashData, METH_KEYWORDS | METH_VARARGS},
+    // @pymeth BCryptFinishHash|Returns the hash value and resets the object for reuse
+    {"BCryptFinishHash", PyBCRYPT_HASH::PyBCryptFinishHash, METH_NOARGS},
+    // @pymeth BCryptDuplicateHash|Copies the hash, including the data hashed so far
+    {"BCryptDuplicateHash", PyBCRYPT_HASH::PyBCryptDuplicateHash, METH_NOARGS},
+    // @pymeth HashFile|Hashes the contents of a file
+    {"HashFile", (PyCFunction)PyBCRYPT_HASH::PyHashFile, METH_KEYWORDS | METH_VARARGS},
+    // @pymeth BCryptDestroyHash|Frees the hash object
+    {"BCryptDestroyHash", PyBCRYPT_HASH::PyBCryptDestroyHash, METH_NOARGS},
+    {NULL}};
+
+struct PyMemberDef PyBCRYPT_HASH::members[] = {
+    // @prop str|Algorithm|Name of the hash algorithm
+    {"Algorithm", T_OBJECT, offsetof(PyBCRYPT_HASH, obalgorithm), READONLY, "Name of the hash algorithm"},
+    // @prop int|DigestSize|Size of the hash value in bytes
+    {"DigestSize", T_ULONG, offsetof(PyBCRYPT_HASH, digestsize), READONLY, "Size of the hash value in bytes"},
+    // @prop int|BytesHashed|Number of bytes hashed since the object was created or last finished
+    {"BytesHashed", T_ULONGLONG, offsetof(PyBCRYPT_HASH, byteshashed), READONLY,
+     "Number of bytes hashed since the object was created or last finished"},
+    {NULL} /* Sentinel */
+};
+
+PyTypeObject PyBCRYPT_HASHType = {PYWIN_OBJECT_HEAD "PyBCRYPT_HASH",
+                                  sizeof(PyBCRYPT_HASH),
+                                  0,
+                                  PyBCRYPT_HASH::deallocFunc, /* tp_dealloc */
+                                  0,                          /* tp_print */
+                                  0,                          /* tp_getattr */
+                                  0,                          /* tp_setattr */
+                                  0,                          /* tp_compare */
+                                  0,                          /* tp_repr */
+                                  0,                          /* tp_as_number */
+                                  0,                          /* tp_as_sequence */
+                                  0,                          /* tp_as_mapping */
+                                  0,
+                                  0, /* tp_call */
+                                  0, /* tp_str */
+                                  PyObject_GenericGetAttr,
+                                  PyObject_GenericSetAttr,
+                                  0,                   // PyBufferProcs *tp_as_buffer
+                                  Py_TPFLAGS_DEFAULT,  // tp_flags
+                                  0,                   // tp_doc
+                                  0,                   // traverseproc tp_traverse
+                                  0,                   // tp_clear
+                                  0,                   // richcmpfunc tp_richcompare
+                                  0,                   // tp_weaklistoffset
+                                  0,                   // getiterfunc tp_iter
+                                  0,                   // iternextfunc tp_iternext
+                                  PyBCRYPT_HASH::methods,
+                                  PyBCRYPT_HASH::members};
+
+PyBCRYPT_HASH::PyBCRYPT_HASH(void)
+{
+    ob_type = &PyBCRYPT_HASHType;
+    _Py_NewReference(this);
+    hhash = NULL;
+    halg = NULL;
+    obalgorithm = NULL;
+    secret = NULL;
+    secretlen = digestsize = 0;
+    byteshashed = 0;
+    bReusable = bBusy = FALSE;
+}
+
+PyBCRYPT_HASH::~PyBCRYPT_HASH(void)
+{
+    if (hhash != NULL)
+        BCryptDestroyHash(hhash);
+    if (secret != NULL) {
+        SecureZeroMemory(secret, secretlen);
+        free(secret);
+    }
+    Py_XDECREF(obalgorithm);
+}
+
+void PyBCRYPT_HASH::deallocFunc(PyObject *ob) { delete (PyBCRYPT_HASH *)ob; }
+
+// Creates the CNG hash object, using BCRYPT_HASH_REUSABLE_FLAG where the OS supports it (Windows 8 and later).
+NTSTATUS PyBCRYPT_HASH::Create(void)
+{
+    NTSTATUS status = BCryptCreateHash(halg, &hhash, NULL, 0, secret, secretlen, BCRYPT_HASH_REUSABLE_FLAG);
+    bReusable = BCRYPT_SUCCESS(status);
+    if (!bReusable)
+        status = BCryptCreateHash(halg, &hhash, NULL, 0, secret, secretlen, 0);
+    if (!BCRYPT_SUCCESS(status))
+        hhash = NULL;
+    return status;
+}
+
+BOOL PyBCRYPT_HASH::Enter(void)
+{
+    if (hhash == NULL) {
+        PyErr_SetString(PyExc_ValueError, "The hash object has been destroyed");
+        return FALSE;
+    }
+    if (bBusy) {
+        PyErr_SetString(PyExc_RuntimeError, "The hash object is in use by another thread");
+        return FALSE;
+    }
+    bBusy = TRUE;
+    return TRUE;
+}
+
+// @pymethod |PyBCRYPT_HASH|BCryptHashData|Adds data to the hash
+PyObject *PyBCRYPT_HASH::PyBCryptHashData(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Data", NULL};
+    PyBCRYPT_HASH *This = (PyBCRYPT_HASH *)self;
+    PyObject *obdata;
+    NTSTATUS status;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O:BCryptHashData", keywords,
+                                     &obdata))  // @pyparm buffer|Data||Data to be hashed
+        return NULL;
+    PyWinBufferView pybuf(obdata);
+    if (!pybuf.ok())
+        return NULL;
+    if (!This->Enter())
+        return NULL;
+    Py_BEGIN_ALLOW_THREADS status = BCryptHashData(This->hhash, (PUCHAR)pybuf.ptr(), pybuf.len(), 0);
+    Py_END_ALLOW_THREADS This->bBusy = FALSE;
+    if (!BCRYPT_SUCCESS(status))
+        return PyWin_SetBCryptError("BCryptHashData", status);
+    This->byteshashed += pybuf.len();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod bytes|PyBCRYPT_HASH|BCryptFinishHash|Returns the hash value and resets the object for reuse
+PyObject *PyBCRYPT_HASH::PyBCryptFinishHash(PyObject *self, PyObject *args)
+{
+    PyBCRYPT_HASH *This = (PyBCRYPT_HASH *)self;
+    if (!This->Enter())
+        return NULL;
+    PyObject *ret = PyBytes_FromStringAndSize(NULL, This->digestsize);
+    if (ret == NULL) {
+        This->bBusy = FALSE;
+        return NULL;
+    }
+    NTSTATUS status = BCryptFinishHash(This->hhash, (PUCHAR)PyBytes_AS_STRING(ret), This->digestsize, 0);
+    if (BCRYPT_SUCCESS(status) && !This->bReusable) {
+        // Without BCRYPT_HASH_REUSABLE_FLAG, a finished hash can't be used again, so make a new one.
+        BCryptDestroyHash(This->hhash);
+        status = This->Create();
+    }
+    This->bBusy = FALSE;
+    This->byteshashed = 0;
+    if (!BCRYPT_SUCCESS(status)) {
+        Py_DECREF(ret);
+        return PyWin_SetBCryptError("BCryptFinishHash", status);
+    }
+    return ret;
+}
+
+// @pymethod <o PyBCRYPT_HASH>|PyBCRYPT_HASH|BCryptDuplicateHash|Copies the hash, including the data hashed so far
+// @comm Useful for hashing many messages that start with the same data.
+PyObject *PyBCRYPT_HASH::PyBCryptDuplicateHash(PyObject *self, PyObject *args)
+{
+    PyBCRYPT_HASH *This = (PyBCRYPT_HASH *)self;
+    if (!This->Enter())
+        return NULL;
+    PyBCRYPT_HASH *ret = new PyBCRYPT_HASH();
+    NTSTATUS status = BCryptDuplicateHash(This->hhash, &ret->hhash, NULL, 0, 0);
+    This->bBusy = FALSE;
+    if (!BCRYPT_SUCCESS(status)) {
+        ret->hhash = NULL;
+        Py_DECREF(ret);
+        return PyWin_SetBCryptError("BCryptDuplicateHash", status);
+    }
+    ret->halg = This->halg;
+    ret->digestsize = This->digestsize;
+    ret->byteshashed = This->byteshashed;
+    ret->bReusable = This->bReusable;
+    Py_INCREF(This->obalgorithm);
+    ret->obalgorithm = This->obalgorithm;
+    if (This->secret != NULL) {
+        ret->secret = (BYTE *)malloc(This->secretlen);
+        if (ret->secret == NULL) {
+            Py_DECREF(ret);
+            return PyErr_NoMemory();
+        }
+        memcpy(ret->secret, This->secret, This->secretlen);
+        ret->secretlen = This->secretlen;
+    }
+    return ret;
+}
+
+// Starts reading the next chunk of the range into buf.  Returns FALSE on error, leaving GetLastError set.
+static BOOL StartRead(HANDLE hfile, BYTE *buf, DWORD chunksize, OVERLAPPED *ov, DWORD *psize, ULONGLONG *poffset,
+                      ULONGLONG *plength, BOOL *ppending)
+{
+    if (*plength == 0)
+        return TRUE;
+    *psize = (DWORD)min(*plength, (ULONGLONG)chunksize);
+    ov->Offset = (DWORD)*poffset;
+    ov->OffsetHigh = (DWORD)(*poffset >> 32);
+    if (!ReadFile(hfile, buf, *psize, NULL, ov) && GetLastError() != ERROR_IO_PENDING) {
+        if (GetLastError() != ERROR_HANDLE_EOF)
+            return FALSE;
+        *plength = 0;
+        return TRUE;
+    }
+    *ppending = TRUE;
+    *poffset += *psize;
+    *plength -= *psize;
+    return TRUE;
+}
+
+// Reads the file with two buffers, so the hashing of one chunk overlaps the read of the next when the handle was
+// opened with FILE_FLAG_OVERLAPPED.  For other handles each read simply completes before ReadFile returns.
+// Called with the GIL released, returns the failing function name, or NULL on success.
+const char *PyBCRYPT_HASH::HashFile(HANDLE hfile, ULONGLONG offset, ULONGLONG length, DWORD chunksize, DWORD *perr)
+{
+    BYTE *bufs[2] = {NULL, NULL};
+    OVERLAPPED ovs[2];
+    DWORD sizes[2], i, read;
+    BOOL pending[2] = {FALSE, FALSE};
+    const char *fname = NULL;
+    ZeroMemory(ovs, sizeof(ovs));
+    for (i = 0; i < 2; i++) {
+        bufs[i] = (BYTE *)malloc(chunksize);
+        if (bufs[i] == NULL) {
+            *perr = ERROR_NOT_ENOUGH_MEMORY;
+            fname = "malloc";
+            goto done;
+        }
+        ovs[i].hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+        if (ovs[i].hEvent == NULL) {
+            *perr = GetLastError();
+            fname = "CreateEvent";
+            goto done;
+        }
+    }
+    if (!StartRead(hfile, bufs[0], chunksize, &ovs[0], &sizes[0], &offset, &length, &pending[0])) {
+        *perr = GetLastError();
+        fname = "ReadFile";
+        goto done;
+    }
+    for (i = 0; pending[i]; i ^= 1) {
+        BOOL ok = GetOverlappedResult(hfile, &ovs[i], &read, TRUE);
+        pending[i] = FALSE;
+        if (!ok) {
+            if (GetLastError() != ERROR_HANDLE_EOF) {
+                *perr = GetLastError();
+                fname = "ReadFile";
+                goto done;
+            }
+            read = 0;
+        }
+        if (read < sizes[i])
+            // End of file - don't read any further.
+            length = 0;
+        // Start the next read before hashing this chunk.
+        if (!StartRead(hfile, bufs[i ^ 1], chunksize, &ovs[i ^ 1], &sizes[i ^ 1], &offset, &length,
+                       &pending[i ^ 1])) {
+            *perr = GetLastError();
+            fname = "ReadFile";
+            goto done;
+        }
+        NTSTATUS status = BCryptHashData(hhash, bufs[i], read, 0);
+        if (!BCRYPT_SUCCESS(status)) {
+            *perr = LsaNtStatusToWinError(status);
+            fname = "BCryptHashData";
+            goto done;
+        }
+        byteshashed += read;
+    }
+done:
+    for (i = 0; i < 2; i++) {
+        if (pending[i])
+            GetOverlappedResult(hfile, &ovs[i], &read, TRUE);
+        if (ovs[i].hEvent != NULL)
+            CloseHandle(ovs[i].hEvent);
+        free(bufs[i]);
+    }
+    return fname;
+}
+
+// @pymethod int|PyBCRYPT_HASH|HashFile|Hashes the contents of a file
+// @rdesc Returns the number of bytes hashed, which is less than Length if the end of the file was reached.
+// @comm The file is read and hashed natively with the GIL released, so no data passes through Python.  If the
+// handle was opened with FILE_FLAG_OVERLAPPED, reading the next chunk overlaps hashing the current one.
+// The file position of a handle opened without FILE_FLAG_OVERLAPPED is moved, but is not used.
+PyObject *PyBCRYPT_HASH::PyHashFile(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"File", "Offset", "Length", "ChunkSize", NULL};
+    PyBCRYPT_HASH *This = (PyBCRYPT_HASH *)self;
+    PyObject *obfile;
+    HANDLE hfile;
+    ULONGLONG offset = 0, length = (ULONGLONG)-1;
+    DWORD chunksize = 0x100000, err = 0;
+    const char *fname;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "O|KKk:HashFile", keywords,
+            &obfile,      // @pyparm <o PyHANDLE>|File||Handle to a file opened with GENERIC_READ access
+            &offset,      // @pyparm int|Offset|0|Position in the file to start from
+            &length,      // @pyparm int|Length|-1|Number of bytes to hash, or -1 for the rest of the file
+            &chunksize))  // @pyparm int|ChunkSize|1048576|Size of each read
+        return NULL;
+    if (chunksize == 0) {
+        PyErr_SetString(PyExc_ValueError, "ChunkSize must not be 0");
+        return NULL;
+    }
+    if (!PyWinObject_AsHANDLE(obfile, &hfile))
+        return NULL;
+    if (!This->Enter())
+        return NULL;
+    ULONGLONG start = This->byteshashed;
+    Py_BEGIN_ALLOW_THREADS fname = This->HashFile(hfile, offset, length, chunksize, &err);
+    Py_END_ALLOW_THREADS This->bBusy = FALSE;
+    if (fname != NULL)
+        return PyWin_SetAPIError((char *)fname, err);
+    return PyLong_FromUnsignedLongLong(This->byteshashed - start);
+}
+
+// @pymethod |PyBCRYPT_HASH|BCryptDestroyHash|Frees the hash object
+PyObject *PyBCRYPT_HASH::PyBCryptDestroyHash(PyObject *self, PyObject *args)
+{
+    PyBCRYPT_HASH *This = (PyBCRYPT_HASH *)self;
+    if (!This->Enter())
+        return NULL;
+    NTSTATUS status = BCryptDestroyHash(This->hhash);
+    This->hhash = NULL;
+    This->bBusy = FALSE;
+    if (!BCRYPT_SUCCESS(status))
+        return PyWin_SetBCryptError("BCryptDestroyHash", status);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod <o PyBCRYPT_HASH>|win32crypt|BCryptCreateHash|Creates a CNG hash or HMAC object
+// @comm The algorithm provider is opened the first time each algorithm is used, and kept open for later calls.
+PyObject *PyBCryptCreateHash(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Algorithm", "Secret", NULL};
+    PyObject *obalgorithm = NULL, *obsecret = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|OO:BCryptCreateHash", keywords,
+            &obalgorithm,  // @pyparm str|Algorithm|"SHA256"|A BCRYPT_*_ALGORITHM name, eg "SHA1", "SHA512" or "MD5"
+            &obsecret))    // @pyparm buffer|Secret|None|Key for an HMAC, or None for a plain hash
+        return NULL;
+    PyWinBufferView pysecret(obsecret, false, true);
+    if (!pysecret.ok())
+        return NULL;
+    TmpPyObject obdefault;
+    if (obalgorithm == NULL) {
+        obdefault = PyUnicode_FromString("SHA256");
+        if (obdefault == NULL)
+            return NULL;
+        obalgorithm = obdefault;
+    }
+    BCRYPT_ALG_HANDLE halg = GetBCryptProvider(obalgorithm, obsecret == Py_None ? 0 : BCRYPT_ALG_HANDLE_HMAC_FLAG);
+    if (halg == NULL)
+        return NULL;
+    PyBCRYPT_HASH *ret = new PyBCRYPT_HASH();
+    ret->halg = halg;
+    Py_INCREF(obalgorithm);
+    ret->obalgorithm = obalgorithm;
+    if (obsecret != Py_None) {
+        // Kept in case the hash has to be recreated after it is finished.
+        ret->secretlen = pysecret.len();
+        ret->secret = (BYTE *)malloc(max(ret->secretlen, 1));
+        if (ret->secret == NULL) {
+            Py_DECREF(ret);
+            return PyErr_NoMemory();
+        }
+        memcpy(ret->secret, pysecret.ptr(), ret->secretlen);
+    }
+    if (!GetBCryptULONGProperty(halg, BCRYPT_HASH_LENGTH, &ret->digestsize)) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    NTSTATUS status = ret->Create();
+    if (!BCRYPT_SUCCESS(status)) {
+        Py_DECREF(ret);
+        return PyWin_SetBCryptError("BCryptCreateHash", status);
+    }
+    return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// @object PyBCRYPT_KEY|A CNG symmetric key for authenticated encryption, created by
+// <om win32crypt.BCryptGenerateSymmetricKey>
+// @comm Input can be any object supporting the buffer interface, and the GIL is released while data is encrypted
+// or decrypted.  The result can be placed in a writable buffer supplied by the caller, which may be the input
+// itself for encryption in place.  Only one thread may use the key at a time.
+struct PyMethodDef PyBCRYPT_KEY::methods[] = {
+    // @pymeth BCryptEncrypt|Encrypts data and returns it with the authentication tag
+    {"BCryptEncrypt", (PyCFunction)PyBCRYPT_KEY::PyBCryptEncrypt, METH_KEYWORDS | METH_VARARGS},
+    // @pymeth BCryptDecrypt|Verifies the authentication tag and decrypts data
+    {"BCryptDecrypt", (PyCFunction)PyBCRYPT_KEY::PyBCryptDecrypt, METH_KEYWORDS | METH_VARARGS},
+    // @pymeth BCryptDestroyKey|Frees the key
+    {"BCryptDestroyKey", PyBCRYPT_KEY::PyBCryptDestroyKey, METH_NOARGS},
+    {NULL}};
+
+struct PyMemberDef PyBCRYPT_KEY::members[] = {
+    // @prop str|Algorithm|Name of the cipher algorithm
+    {"Algorithm", T_OBJECT, offsetof(PyBCRYPT_KEY, obalgorithm), READONLY, "Name of the cipher algorithm"},
+    // @prop str|ChainingMode|The BCRYPT_CHAIN_MODE_* in use
+    {"ChainingMode", T_OBJECT, offsetof(PyBCRYPT_KEY, obchainingmode), READONLY, "The chaining mode in use"},
+    {NULL} /* Sentinel */
+};
+
+PyTypeObject PyBCRYPT_KEYType = {PYWIN_OBJECT_HEAD "PyBCRYPT_KEY",
+                                 sizeof(PyBCRYPT_KEY),
+                                 0,
+                                 PyBCRYPT_KEY::deallocFunc, /* tp_dealloc */
+                                 0,                         /* tp_print */
+                                 0,                         /* tp_getattr */
+                                 0,                         /* tp_setattr */
+                                 0,                         /* tp_compare */
+                                 0,                         /* tp_repr */
+                                 0,                         /* tp_as_number */
+                                 0,                         /* tp_as_sequence */
+                                 0,                         /* tp_as_mapping */
+                                 0,
+                                 0, /* tp_call */
+                                 0, /* tp_str */
+                                 PyObject_GenericGetAttr,
+                                 PyObject_GenericSetAttr,
+                                 0,                   // PyBufferProcs *tp_as_buffer
+                                 Py_TPFLAGS_DEFAULT,  // tp_flags
+                                 0,                   // tp_doc
+                                 0,                   // traverseproc tp_traverse
+                                 0,                   // tp_clear
+                                 0,                   // richcmpfunc tp_richcompare
+                                 0,                   // tp_weaklistoffset
+                                 0,                   // getiterfunc tp_iter
+                                 0,                   // iternextfunc tp_iternext
+                                 PyBCRYPT_KEY::methods,
+                                 PyBCRYPT_KEY::members};
+
+PyBCRYPT_KEY::PyBCRYPT_KEY(void)
+{
+    ob_type = &PyBCRYPT_KEYType;
+    _Py_NewReference(this);
+    hkey = NULL;
+    obalgorithm = obchainingmode = NULL;
+    bBusy = FALSE;
+}
+
+PyBCRYPT_KEY::~PyBCRYPT_KEY(void)
+{
+    if (hkey != NULL)
+        BCryptDestroyKey(hkey);
+    Py_XDECREF(obalgorithm);
+    Py_XDECREF(obchainingmode);
+}
+
+void PyBCRYPT_KEY::deallocFunc(PyObject *ob) { delete (PyBCRYPT_KEY *)ob; }
+
+BOOL PyBCRYPT_KEY::Enter(void)
+{
+    if (hkey == NULL) {
+        PyErr_SetString(PyExc_ValueError, "The key has been destroyed");
+        return FALSE;
+    }
+    if (bBusy) {
+        PyErr_SetString(PyExc_RuntimeError, "The key is in use by another thread");
+        return FALSE;
+    }
+    bBusy = TRUE;
+    return TRUE;
+}
+
+// Returns the object the result is to be placed in - either the caller's writable buffer, or a new bytes object.
+static PyObject *GetOutputBuffer(PyObject *oboutput, PyWinBufferView &outview, DWORD len)
+{
+    if (oboutput == Py_None)
+        return PyBytes_FromStringAndSize(NULL, len);
+    if (!outview.init(oboutput, true))
+        return NULL;
+    if (outview.len() < len) {
+        PyErr_Format(PyExc_ValueError, "The output buffer must be at least %d bytes", len);
+        return NULL;
+    }
+    Py_INCREF(oboutput);
+    return oboutput;
+}
+
+// Encrypts or decrypts with BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO, which is used for both GCM and CCM.
+PyObject *PyBCRYPT_KEY::DoCrypt(BOOL bEncrypt, PyObject *obdata, PyObject *obnonce, PyObject *obauthdata,
+                                PyObject *obtag, DWORD tagsize, PyObject *oboutput)
+{
+    PyWinBufferView pydata(obdata), pynonce(obnonce), pyauthdata(obauthdata, false, true);
+    if (!pydata.ok() || !pynonce.ok() || !pyauthdata.ok())
+        return NULL;
+    PyWinBufferView pytag;
+    TmpPyObject obtagout;
+    BYTE *tag;
+    if (bEncrypt) {
+        obtagout = PyBytes_FromStringAndSize(NULL, tagsize);
+        if (obtagout == NULL)
+            return NULL;
+        tag = (BYTE *)PyBytes_AS_STRING((PyObject *)obtagout);
+    }
+    else {
+        if (!pytag.init(obtag))
+            return NULL;
+        tag = (BYTE *)pytag.ptr();
+        tagsize = pytag.len();
+    }
+    PyWinBufferView outview;
+    TmpPyObject ret = GetOutputBuffer(oboutput, outview, pydata.len());
+    if (ret == NULL)
+        return NULL;
+    BYTE *out = oboutput == Py_None ? (BYTE *)PyBytes_AS_STRING((PyObject *)ret) : (BYTE *)outview.ptr();
+
+    BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO info;
+    BCRYPT_INIT_AUTH_MODE_INFO(info);
+    info.pbNonce = (PUCHAR)pynonce.ptr();
+    info.cbNonce = pynonce.len();
+    info.pbAuthData = (PUCHAR)pyauthdata.ptr();
+    info.cbAuthData = pyauthdata.len();
+    info.pbTag = tag;
+    info.cbTag = tagsize;
+    if (!Enter())
+        return NULL;
+    NTSTATUS status;
+    ULONG done;
+    Py_BEGIN_ALLOW_THREADS status =
+        bEncrypt ? BCryptEncrypt(hkey, (PUCHAR)pydata.ptr(), pydata.len(), &info, NULL, 0, out, pydata.len(), &done, 0)
+                 : BCryptDecrypt(hkey, (PUCHAR)pydata.ptr(), pydata.len(), &info, NULL, 0, out, pydata.len(), &done, 0);
+    Py_END_ALLOW_THREADS bBusy = FALSE;
+    if (!BCRYPT_SUCCESS(status)) {
+        // Don't leave unauthenticated plaintext in the caller's buffer.
+        if (!bEncrypt)
+            SecureZeroMemory(out, pydata.len());
+        return PyWin_SetBCryptError(bEncrypt ? (char *)"BCryptEncrypt" : (char *)"BCryptDecrypt", status);
+    }
+    if (bEncrypt)
+        return Py_BuildValue("OO", (PyObject *)ret, (PyObject *)obtagout);
+    Py_INCREF((PyObject *)ret);
+    return ret;
+}
+
+// @pymethod (buffer, bytes)|PyBCRYPT_KEY|BCryptEncrypt|Encrypts data and returns it with the authentication tag
+// @rdesc Returns the ciphertext, which is the Output object if one was passed, and the tag
+PyObject *PyBCRYPT_KEY::PyBCryptEncrypt(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Data", "Nonce", "AuthData", "TagSize", "Output", NULL};
+    PyObject *obdata, *obnonce, *obauthdata = Py_None, *oboutput = Py_None;
+    DWORD tagsize = 16;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "OO|OkO:BCryptEncrypt", keywords,
+            &obdata,      // @pyparm buffer|Data||Plaintext to be encrypted
+            &obnonce,     // @pyparm buffer|Nonce||Unique value for this message, usually 12 bytes for GCM.  Never
+                          // use the same nonce twice with one key.
+            &obauthdata,  // @pyparm buffer|AuthData|None|Additional data that is authenticated but not encrypted
+            &tagsize,     // @pyparm int|TagSize|16|Size of the authentication tag to produce
+            &oboutput))   // @pyparm buffer|Output|None|Writable buffer to receive the ciphertext, which may be Data
+                          // itself.  If None, a new bytes object is returned.
+        return NULL;
+    return ((PyBCRYPT_KEY *)self)->DoCrypt(TRUE, obdata, obnonce, obauthdata, NULL, tagsize, oboutput);
+}
+
+// @pymethod buffer|PyBCRYPT_KEY|BCryptDecrypt|Verifies the authentication tag and decrypts data
+// @rdesc Returns the plaintext, which is the Output object if one was passed.  If the tag doesn't match, an error is
+// raised and the output buffer is cleared.
+PyObject *PyBCRYPT_KEY::PyBCryptDecrypt(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Data", "Nonce", "Tag", "AuthData", "Output", NULL};
+    PyObject *obdata, *obnonce, *obtag, *obauthdata = Py_None, *oboutput = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "OOO|OO:BCryptDecrypt", keywords,
+            &obdata,      // @pyparm buffer|Data||Ciphertext to be decrypted
+            &obnonce,     // @pyparm buffer|Nonce||The nonce used to encrypt the message
+            &obtag,       // @pyparm buffer|Tag||The authentication tag returned by <om PyBCRYPT_KEY.BCryptEncrypt>
+            &obauthdata,  // @pyparm buffer|AuthData|None|The additional authenticated data, if any
+            &oboutput))   // @pyparm buffer|Output|None|Writable buffer to receive the plaintext, which may be Data
+                          // itself.  If None, a new bytes object is returned.
+        return NULL;
+    return ((PyBCRYPT_KEY *)self)->DoCrypt(FALSE, obdata, obnonce, obauthdata, obtag, 0, oboutput);
+}
+
+// @pymethod |PyBCRYPT_KEY|BCryptDestroyKey|Frees the key
+PyObject *PyBCRYPT_KEY::PyBCryptDestroyKey(PyObject *self, PyObject *args)
+{
+    PyBCRYPT_KEY *This = (PyBCRYPT_KEY *)self;
+    if (!This->Enter())
+        return NULL;
+    NTSTATUS status = BCryptDestroyKey(This->hkey);
+    This->hkey = NULL;
+    This->bBusy = FALSE;
+    if (!BCRYPT_SUCCESS(status))
+        return PyWin_SetBCryptError("BCryptDestroyKey", status);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod <o PyBCRYPT_KEY>|win32crypt|BCryptGenerateSymmetricKey|Creates a CNG key for authenticated encryption
+// @comm Only the authenticated chaining modes, BCRYPT_CHAIN_MODE_GCM and BCRYPT_CHAIN_MODE_CCM, are supported.
+PyObject *PyBCryptGenerateSymmetricKey(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Secret", "Algorithm", "ChainingMode", NULL};
+    PyObject *obsecret, *obalgorithm = NULL, *obchainingmode = NULL;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "O|OO:BCryptGenerateSymmetricKey", keywords,
+            &obsecret,         // @pyparm buffer|Secret||The key, eg 16 or 32 bytes for AES
+            &obalgorithm,      // @pyparm str|Algorithm|"AES"|A BCRYPT_*_ALGORITHM name
+            &obchainingmode))  // @pyparm str|ChainingMode|"ChainingModeGCM"|BCRYPT_CHAIN_MODE_GCM or
+                               // BCRYPT_CHAIN_MODE_CCM
+        return NULL;
+    PyWinBufferView pysecret(obsecret);
+    if (!pysecret.ok())
+        return NULL;
+    TmpPyObject obdefaultalg, obdefaultmode;
+    if (obalgorithm == NULL) {
+        obdefaultalg = PyUnicode_FromString("AES");
+        if (obdefaultalg == NULL)
+            return NULL;
+        obalgorithm = obdefaultalg;
+    }
+    if (obchainingmode == NULL) {
+        obdefaultmode = PyUnicode_FromString("ChainingModeGCM");
+        if (obdefaultmode == NULL)
+            return NULL;
+        obchainingmode = obdefaultmode;
+    }
+    TmpWCHAR chainingmode;
+    if (!PyWinObject_AsWCHAR(obchainingmode, &chainingmode, FALSE))
+        return NULL;
+    if (wcscmp(chainingmode, BCRYPT_CHAIN_MODE_GCM) != 0 && wcscmp(chainingmode, BCRYPT_CHAIN_MODE_CCM) != 0) {
+        PyErr_SetString(PyExc_ValueError, "ChainingMode must be ChainingModeGCM or ChainingModeCCM");
+        return NULL;
+    }
+    BCRYPT_ALG_HANDLE halg = GetBCryptProvider(obalgorithm, 0);
+    if (halg == NULL)
+        return NULL;
+    PyBCRYPT_KEY *ret = new PyBCRYPT_KEY();
+    Py_INCREF(obalgorithm);
+    ret->obalgorithm = obalgorithm;
+    Py_INCREF(obchainingmode);
+    ret->obchainingmode = obchainingmode;
+    NTSTATUS status =
+        BCryptGenerateSymmetricKey(halg, &ret->hkey, NULL, 0, (PUCHAR)pysecret.ptr(), pysecret.len(), 0);
+    if (!BCRYPT_SUCCESS(status)) {
+        ret->hkey = NULL;
+        Py_DECREF(ret);
+        return PyWin_SetBCryptError("BCryptGenerateSymmetricKey", status);
+    }
+    // The provider handle is shared, so the chaining mode is set on the key rather than the algorithm.
+    status = BCryptSetProperty(ret->hkey, BCRYPT_CHAINING_MODE, (PUCHAR)(WCHAR *)chainingmode,
+                               (ULONG)(wcslen(chainingmode) + 1) * sizeof(WCHAR), 0);
+    if (!BCRYPT_SUCCESS(status)) {
+        Py_DECREF(ret);
+        return PyWin_SetBCryptError("BCryptSetProperty", status);
+    }
+    return ret;
+}
@@ -11,6 +11,9 @@ struct PyMethodDef PyCERTSTORE::methods[] = {
     {"CertEnumCertificatesInStore", PyCERTSTORE::PyCertEnumCertificatesInStore, METH_NOARGS},
     // @pymeth CertEnumCTLsInStore|Finds all Certificate Trust Lists in store.
     {"CertEnumCTLsInStore", PyCERTSTORE::PyCertEnumCTLsInStore, METH_NOARGS},
+    // @pymeth CertFindCertificatesInStore|Iterates over the certificates that match a search
+    {"CertFindCertificatesInStore", (PyCFunction)PyCERTSTORE::PyCertFindCertificatesInStore,
+     METH_KEYWORDS | METH_VARARGS},
     // @pymeth CertSaveStore|Serializes the store to memory or a file
     {"CertSaveStore", (PyCFunction)PyCERTSTORE::PyCertSaveStore, METH_KEYWORDS | METH_VARARGS},
     // @pymeth CertAddEncodedCertificateToStore|Imports an encoded certificate into the store
@@ -240,6 +243,74 @@ PyObject *PyCERTSTORE::PyCertEnumCTLsInStore(PyObject *self, PyObject *args)
     return ret;
 }
 
+// @pymethod <o PyCERTSTORE_ITER>|PyCERTSTORE|CertFindCertificatesInStore|Iterates over the certificates in the store
+// that match a search
+// @comm Unlike <om PyCERTSTORE.CertEnumCertificatesInStore>, which builds a list of every certificate up front, this
+//	returns an iterator that calls CertFindCertificateInStore as each certificate is requested.  The search, and the
+//	ExpiresBefore and ExpiresAfter checks, are done without the GIL and before any Python object is created, so
+//	certificates that don't match cost nothing on the Python side.
+// @comm The iterator holds its own reference to the store, so it remains usable if the store object is closed.
+// @pyseeapi CertFindCertificateInStore
+PyObject *PyCERTSTORE::PyCertFindCertificatesInStore(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"FindType", "FindPara", "FindFlags", "CertEncodingType", "ExpiresBefore",
+                               "ExpiresAfter", NULL};
+    HCERTSTORE hcertstore = ((PyCERTSTORE *)self)->GetHCERTSTORE();
+    DWORD findtype = CERT_FIND_ANY, findflags = 0, encoding = X509_ASN_ENCODING | PKCS_7_ASN_ENCODING;
+    PyObject *obfindpara = Py_None, *obexpiresbefore = Py_None, *obexpiresafter = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|kOkkOO:CertFindCertificatesInStore", keywords,
+            &findtype,    // @pyparm int|FindType|CERT_FIND_ANY|One of the CERT_FIND_* values, see below
+            &obfindpara,  // @pyparm object|FindPara|None|Search criteria, type depends on FindType
+            &findflags,   // @pyparm int|FindFlags|0|Flags that modify the search, used with CERT_FIND_ENHKEY_USAGE
+                          // and name searches
+            &encoding,    // @pyparm int|CertEncodingType|X509_ASN_ENCODING\|PKCS_7_ASN_ENCODING|Encoding of search data
+            &obexpiresbefore,  // @pyparm <o PyTime>|ExpiresBefore|None|Only certificates whose NotAfter time is
+                               // earlier than this are returned
+            &obexpiresafter))  // @pyparm <o PyTime>|ExpiresAfter|None|Only certificates whose NotAfter time is
+                               // later than this are returned
+        return NULL;
+    // @flagh FindType|FindPara
+    // @flag CERT_FIND_ANY|None
+    // @flag CERT_FIND_SHA1_HASH|Bytes containing the hash (thumbprint) of the certificate
+    // @flag CERT_FIND_MD5_HASH|Bytes containing the MD5 hash of the certificate
+    // @flag CERT_FIND_SIGNATURE_HASH|Bytes containing the hash of the signature
+    // @flag CERT_FIND_KEY_IDENTIFIER|Bytes containing the subject key identifier
+    // @flag CERT_FIND_PUBKEY_MD5_HASH|Bytes containing the MD5 hash of the public key
+    // @flag CERT_FIND_SUBJECT_NAME|Encoded CERT_NAME_INFO, as in <o PyCERT_CONTEXT>.Subject
+    // @flag CERT_FIND_ISSUER_NAME|Encoded CERT_NAME_INFO, as in <o PyCERT_CONTEXT>.Issuer
+    // @flag CERT_FIND_SUBJECT_STR|String that must be contained in the subject name
+    // @flag CERT_FIND_ISSUER_STR|String that must be contained in the issuer name
+    // @flag CERT_FIND_PROPERTY|Property id that the certificate must have
+    // @flag CERT_FIND_KEY_SPEC|AT_KEYEXCHANGE or AT_SIGNATURE
+    // @flag CERT_FIND_EXISTING|<o PyCERT_CONTEXT> to be matched
+    // @flag CERT_FIND_ISSUER_OF|<o PyCERT_CONTEXT> whose issuer is to be found
+    PyCERTSTORE_ITER *ret = new PyCERTSTORE_ITER(CertDuplicateStore(hcertstore));
+    if (ret == NULL)
+        return PyErr_NoMemory();
+    ret->encoding = encoding;
+    ret->findflags = findflags;
+    if (!ret->SetFindPara(findtype, obfindpara)) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    if (obexpiresbefore != Py_None) {
+        if (!PyWinObject_AsFILETIME(obexpiresbefore, &ret->expiresbefore)) {
+            Py_DECREF(ret);
+            return NULL;
+        }
+        ret->bHaveExpiresBefore = TRUE;
+    }
+    if (obexpiresafter != Py_None) {
+        if (!PyWinObject_AsFILETIME(obexpiresafter, &ret->expiresafter)) {
+            Py_DECREF(ret);
+            return NULL;
+        }
+        ret->bHaveExpiresAfter = TRUE;
+    }
+    return ret;
+}
+
 // @pymethod |PyCERTSTORE|CertSaveStore|Serializes the store to memory or a file
 PyObject *PyCERTSTORE::PyCertSaveStore(PyObject *self, PyObject *args, PyObject *kwargs)
 {
@@ -492,6 +563,160 @@ PyObject *PyCERTSTORE::PyPFXExportCertStoreEx(PyObject *self, PyObject *args, Py
     return ret;
 }
 
+// @object PyCERTSTORE_ITER|Iterator returned by <om PyCERTSTORE.CertFindCertificatesInStore>
+// @comm Yields a <o PyCERT_CONTEXT> for each matching certificate.
+PyTypeObject PyCERTSTORE_ITERType = {PYWIN_OBJECT_HEAD "PyCERTSTORE_ITER",
+                                     sizeof(PyCERTSTORE_ITER),
+                                     0,
+                                     PyCERTSTORE_ITER::deallocFunc,  // tp_dealloc
+                                     0,                              // tp_print
+                                     0,                              // tp_getattr
+                                     0,                              // tp_setattr
+                                     0,                              // tp_compare
+                                     0,                              // tp_repr
+                                     0,                              // tp_as_number
+                                     0,                              // tp_as_sequence
+                                     0,                              // tp_as_mapping
+                                     0,
+                                     0,                        // tp_call
+                                     0,                        // tp_str
+                                     PyObject_GenericGetAttr,  // tp_getattro
+                                     0,                        // tp_setattro
+                                     0,                        // PyBufferProcs *tp_as_buffer
+                                     Py_TPFLAGS_DEFAULT,       // tp_flags
+                                     0,                        // tp_doc
+                                     0,                        // traverseproc tp_traverse
+                                     0,                        // tp_clear
+                                     0,                        // richcmpfunc tp_richcompare
+                                     0,                        // tp_weaklistoffset
+                                     PyObject_SelfIter,        // getiterfunc tp_iter
+                                     PyCERTSTORE_ITER::iternext,  // iternextfunc tp_iternext
+                                     0,                           // tp_methods
+                                     0};                          // tp_members
+
+PyCERTSTORE_ITER::PyCERTSTORE_ITER(HCERTSTORE hcertstore)
+{
+    ob_type = &PyCERTSTORE_ITERType;
+    _Py_NewReference(this);
+    this->hcertstore = hcertstore;
+    pccert_context = NULL;
+    findtype = CERT_FIND_ANY;
+    findpara = NULL;
+    ZeroMemory(&findblob, sizeof(findblob));
+    finddword = 0;
+    findstr = NULL;
+    obfindpara = NULL;
+    encoding = X509_ASN_ENCODING | PKCS_7_ASN_ENCODING;
+    findflags = 0;
+    bHaveExpiresBefore = bHaveExpiresAfter = FALSE;
+    bDone = FALSE;
+}
+
+PyCERTSTORE_ITER::~PyCERTSTORE_ITER(void)
+{
+    if (pccert_context != NULL)
+        CertFreeCertificateContext(pccert_context);
+    if (hcertstore != NULL)
+        CertCloseStore(hcertstore, 0);
+    PyWinObject_FreeWCHAR(findstr);
+    Py_XDECREF(obfindpara);
+}
+
+void PyCERTSTORE_ITER::deallocFunc(PyObject *ob) { delete (PyCERTSTORE_ITER *)ob; }
+
+BOOL PyCERTSTORE_ITER::SetFindPara(DWORD findtype, PyObject *obfindpara)
+{
+    this->findtype = findtype;
+    switch (findtype) {
+        case CERT_FIND_ANY:
+            if (obfindpara != Py_None) {
+                PyErr_SetString(PyExc_TypeError, "FindPara must be None for CERT_FIND_ANY");
+                return FALSE;
+            }
+            findpara = NULL;
+            return TRUE;
+        case CERT_FIND_SHA1_HASH:
+        case CERT_FIND_MD5_HASH:
+        case CERT_FIND_SIGNATURE_HASH:
+        case CERT_FIND_KEY_IDENTIFIER:
+        case CERT_FIND_PUBKEY_MD5_HASH:
+        case CERT_FIND_SUBJECT_NAME:
+        case CERT_FIND_ISSUER_NAME: {
+            // Keep a reference to the object so the blob can point into it
+            PyWinBufferView pybuf(obfindpara);
+            if (!pybuf.ok())
+                return FALSE;
+            findblob.pbData = (BYTE *)pybuf.ptr();
+            findblob.cbData = pybuf.len();
+            Py_INCREF(obfindpara);
+            this->obfindpara = obfindpara;
+            findpara = &findblob;
+            return TRUE;
+        }
+        case CERT_FIND_SUBJECT_STR_W:
+        case CERT_FIND_ISSUER_STR_W:
+            if (!PyWinObject_AsWCHAR(obfindpara, &findstr, FALSE))
+                return FALSE;
+            findpara = findstr;
+            return TRUE;
+        case CERT_FIND_PROPERTY:
+        case CERT_FIND_KEY_SPEC:
+            finddword = PyLong_AsUnsignedLong(obfindpara);
+            if (finddword == (DWORD)-1 && PyErr_Occurred())
+                return FALSE;
+            findpara = &finddword;
+            return TRUE;
+        case CERT_FIND_EXISTING:
+        case CERT_FIND_ISSUER_OF: {
+            PCCERT_CONTEXT pcc;
+            if (!PyWinObject_AsCERT_CONTEXT(obfindpara, &pcc, FALSE))
+                return FALSE;
+            Py_INCREF(obfindpara);
+            this->obfindpara = obfindpara;
+            findpara = (void *)pcc;
+            return TRUE;
+        }
+    }
+    PyErr_Format(PyExc_NotImplementedError, "FindType 0x%x is not supported", findtype);
+    return FALSE;
+}
+
+PyObject *PyCERTSTORE_ITER::iternext(PyObject *self)
+{
+    PyCERTSTORE_ITER *This = (PyCERTSTORE_ITER *)self;
+    PCCERT_CONTEXT pcc = This->pccert_context;
+    DWORD err = 0;
+    if (This->bDone)
+        return NULL;
+    // Certificates rejected by the expiry checks are skipped without reacquiring the GIL
+    Py_BEGIN_ALLOW_THREADS for (;;)
+    {
+        pcc = CertFindCertificateInStore(This->hcertstore, This->encoding, This->findflags, This->findtype,
+                                         This->findpara, pcc);
+        if (pcc == NULL) {
+            err = GetLastError();
+            break;
+        }
+        if (This->bHaveExpiresBefore && CompareFileTime(&pcc->pCertInfo->NotAfter, &This->expiresbefore) >= 0)
+            continue;
+        if (This->bHaveExpiresAfter && CompareFileTime(&pcc->pCertInfo->NotAfter, &This->expiresafter) <= 0)
+            continue;
+        break;
+    }
+    Py_END_ALLOW_THREADS
+    // CertFindCertificateInStore has freed the previous context
+    This->pccert_context = pcc;
+    if (pcc == NULL) {
+        This->bDone = TRUE;
+        // As in CertEnumCertificatesInStore, Win2K may return ERROR_FILE_NOT_FOUND at the end
+        if ((err != CRYPT_E_NOT_FOUND) && (err != ERROR_FILE_NOT_FOUND))
+            PyWin_SetAPIError("CertFindCertificateInStore", err);
+        return NULL;
+    }
+    // The iterator keeps its context to continue the search, so the returned object gets its own reference
+    return PyWinObject_FromCERT_CONTEXT(CertDuplicateCertificateContext(pcc));
+}
+
 /*
 // @pymethod |PyCERTSTORE|CertSetStoreProperty|Sets a property of the cerficate store
 PyObject *PyCERTSTORE::PyCertSetStoreProperty(PyObject *self, PyObject *args, PyObject *kwargs)
@@ -80,8 +80,17 @@ struct PyMemberDef PyCERT_CONTEXT::members[] = {
     {"Issuer", T_OBJECT, offsetof(PyCERT_CONTEXT, obdummy), READONLY},
     // @prop <o PyDateTime>|NotBefore|Beginning of certificate's period of validity
     {"NotBefore", T_OBJECT, offsetof(PyCERT_CONTEXT, obdummy), READONLY},
-    // @prop <o PyDateTime>|NotAfter|End of certificate's period of validity
+    // @prop <o PyDateTime>|NotAfter|End of certificate's period of validity.  Converted once and cached.
     {"NotAfter", T_OBJECT, offsetof(PyCERT_CONTEXT, obdummy), READONLY},
+    // @prop <o PyUnicode>|SubjectName|Subject formatted as an X500 string (CERT_X500_NAME_STR with
+    //	CERT_NAME_STR_REVERSE_FLAG).  Decoded on first access and cached.
+    {"SubjectName", T_OBJECT, offsetof(PyCERT_CONTEXT, obdummy), READONLY},
+    // @prop <o PyUnicode>|IssuerName|Issuer formatted in the same way as SubjectName.  Decoded on first access and
+    //	cached.
+    {"IssuerName", T_OBJECT, offsetof(PyCERT_CONTEXT, obdummy), READONLY},
+    // @prop bytes|Thumbprint|SHA1 hash of the certificate (CERT_SHA1_HASH_PROP_ID), as used with
+    //	CERT_FIND_SHA1_HASH.  Retrieved on first access and cached.
+    {"Thumbprint", T_OBJECT, offsetof(PyCERT_CONTEXT, obdummy), READONLY},
     // @prop str|SignatureAlgorithm|Object id of the certifcate's signature algorithm
     {"SignatureAlgorithm", T_OBJECT, offsetof(PyCERT_CONTEXT, obdummy), READONLY},
     // @prop (<o PyCERT_EXTENSION>,...)|Extension|Sequence of CERT_EXTENSION dicts containing certificate's extensions
@@ -129,9 +138,39 @@ PyObject *PyWinObject_FromCERT_EXTENSIONArray(PCERT_EXTENSION pce, DWORD ext_cnt
     return ret;
 }
 
+// Formats a certificate's Subject or Issuer as an X500 string
+static PyObject *PyWinObject_FromCERT_NAME_BLOB(PCCERT_CONTEXT pcc, PCERT_NAME_BLOB pcnb)
+{
+    DWORD strtype = CERT_X500_NAME_STR | CERT_NAME_STR_REVERSE_FLAG;
+    DWORD buflen = CertNameToStrW(pcc->dwCertEncodingType, pcnb, strtype, NULL, 0);
+    if (buflen == 0)
+        return PyWin_SetAPIError("CertNameToStr");
+    WCHAR *buf = (WCHAR *)malloc(buflen * sizeof(WCHAR));
+    if (buf == NULL)
+        return PyErr_Format(PyExc_MemoryError, "Unable to allocate %d bytes", buflen * sizeof(WCHAR));
+    PyObject *ret = NULL;
+    if (CertNameToStrW(pcc->dwCertEncodingType, pcnb, strtype, buf, buflen) == 0)
+        PyWin_SetAPIError("CertNameToStr");
+    else
+        ret = PyWinObject_FromWCHAR(buf);
+    free(buf);
+    return ret;
+}
+
+// Stores a newly decoded attribute, and returns a new reference to it
+PyObject *PyCERT_CONTEXT::GetCachedAttr(PyObject **cached, PyObject *val)
+{
+    if (val == NULL)
+        return NULL;
+    *cached = val;
+    Py_INCREF(val);
+    return val;
+}
+
 PyObject *PyCERT_CONTEXT::getattro(PyObject *self, PyObject *obname)
 {
-    PCCERT_CONTEXT pcc = ((PyCERT_CONTEXT *)self)->GetPCCERT_CONTEXT();
+    PyCERT_CONTEXT *This = (PyCERT_CONTEXT *)self;
+    PCCERT_CONTEXT pcc = This->GetPCCERT_CONTEXT();
     char *name = PYWIN_ATTR_CONVERT(obname);
     if (name == NULL)
         return NULL;
@@ -157,8 +196,36 @@ PyObject *PyCERT_CONTEXT::getattro(PyObject *self, PyObject *obname)
         return PyString_FromStringAndSize((char *)pcc->pCertInfo->Subject.pbData, pcc->pCertInfo->Subject.cbData);
     if (strcmp(name, "NotBefore") == 0)
         return PyWinObject_FromFILETIME(pcc->pCertInfo->NotBefore);
-    if (strcmp(name, "NotAfter") == 0)
-        return PyWinObject_FromFILETIME(pcc->pCertInfo->NotAfter);
+    if (strcmp(name, "NotAfter") == 0) {
+        if (This->obnotafter == NULL)
+            return GetCachedAttr(&This->obnotafter, PyWinObject_FromFILETIME(pcc->pCertInfo->NotAfter));
+        Py_INCREF(This->obnotafter);
+        return This->obnotafter;
+    }
+    if (strcmp(name, "SubjectName") == 0) {
+        if (This->obsubjectname == NULL)
+            return GetCachedAttr(&This->obsubjectname, PyWinObject_FromCERT_NAME_BLOB(pcc, &pcc->pCertInfo->Subject));
+        Py_INCREF(This->obsubjectname);
+        return This->obsubjectname;
+    }
+    if (strcmp(name, "IssuerName") == 0) {
+        if (This->obissuername == NULL)
+            return GetCachedAttr(&This->obissuername, PyWinObject_FromCERT_NAME_BLOB(pcc, &pcc->pCertInfo->Issuer));
+        Py_INCREF(This->obissuername);
+        return This->obissuername;
+    }
+    if (strcmp(name, "Thumbprint") == 0) {
+        if (This->obthumbprint == NULL) {
+            BYTE hash[20];
+            DWORD hashlen = sizeof(hash);
+            // Calculates the hash and stores it as a property if it isn't already present
+            if (!CertGetCertificateContextProperty(pcc, CERT_SHA1_HASH_PROP_ID, hash, &hashlen))
+                return PyWin_SetAPIError("CertGetCertificateContextProperty");
+            return GetCachedAttr(&This->obthumbprint, PyString_FromStringAndSize((char *)hash, hashlen));
+        }
+        Py_INCREF(This->obthumbprint);
+        return This->obthumbprint;
+    }
     if (strcmp(name, "SignatureAlgorithm") == 0)
         return PyWinObject_FromCRYPT_ALGORITHM_IDENTIFIER(&pcc->pCertInfo->SignatureAlgorithm);
     if (strcmp(name, "Extension") == 0)
@@ -170,7 +237,14 @@ PyObject *PyCERT_CONTEXT::getattro(PyObject *self, PyObject *obname)
     return PyObject_GenericGetAttr(self, obname);
 }
 
-PyCERT_CONTEXT::~PyCERT_CONTEXT(void) { CertFreeCertificateContext(pccert_context); }
+PyCERT_CONTEXT::~PyCERT_CONTEXT(void)
+{
+    CertFreeCertificateContext(pccert_context);
+    Py_XDECREF(obsubjectname);
+    Py_XDECREF(obissuername);
+    Py_XDECREF(obthumbprint);
+    Py_XDECREF(obnotafter);
+}
 
 void PyCERT_CONTEXT::deallocFunc(PyObject *ob) { delete (PyCERT_CONTEXT *)ob; }
 
@@ -180,6 +254,7 @@ PyCERT_CONTEXT::PyCERT_CONTEXT(PCCERT_CONTEXT pccert_context)
     _Py_NewReference(this);
     this->pccert_context = pccert_context;
     this->obdummy = NULL;
+    obsubjectname = obissuername = obthumbprint = obnotafter = NULL;
 }
 
 BOOL PyWinObject_AsCERT_CONTEXT(PyObject *obpccert_context, PCCERT_CONTEXT *pccert_context, BOOL bNoneOK)
@@ -2,9 +2,14 @@
 #include "win32crypt.h"
 
 // @object PyCRYPTMSG|Wrapper for a cryptographic message handle
+// @comm Messages created by <om win32crypt.CryptMsgOpenToEncode> or <om win32crypt.CryptMsgOpenToDecode> are
+// in streaming mode.  Data is passed to them a chunk at a time using <om PyCRYPTMSG.CryptMsgUpdate>, which
+// returns the output produced so far, so that a large message never has to be held in memory at once.
 struct PyMethodDef PyCRYPTMSG::methods[] = {
     // @pymeth CryptMsgClose|Closes the message handle
     {"CryptMsgClose", PyCRYPTMSG::PyCryptMsgClose, METH_NOARGS},
+    // @pymeth CryptMsgUpdate|Adds data to a streaming message, and returns any output
+    {"CryptMsgUpdate", (PyCFunction)PyCRYPTMSG::PyCryptMsgUpdate, METH_VARARGS | METH_KEYWORDS},
     {NULL}};
 
 PyTypeObject PyCRYPTMSGType = {PYWIN_OBJECT_HEAD "PyCRYPTMSG",
@@ -39,6 +44,10 @@ PyTypeObject PyCRYPTMSGType = {PYWIN_OBJECT_HEAD "PyCRYPTMSG",
 struct PyMemberDef PyCRYPTMSG::members[] = {
     // @prop int|HCRYPTMSG|Raw message handle
     {"HCRYPTMSG", T_OBJECT, offsetof(PyCRYPTMSG, obcryptmsg), READONLY, "Raw message handle"},
+    // @prop <o PyCERT_CONTEXT>|DecryptCert|For an enveloped message being decoded, the certificate whose private
+    // key decrypted it.  None until enough of the message has been passed to <om PyCRYPTMSG.CryptMsgUpdate>.
+    {"DecryptCert", T_OBJECT, offsetof(PyCRYPTMSG, obdecryptcert), READONLY,
+     "Certificate used to decrypt an enveloped message"},
     {NULL} /* Sentinel */
 };
 
@@ -92,6 +101,9 @@ PyCRYPTMSG::~PyCRYPTMSG(void)
     if (hcryptmsg != NULL)
         CryptMsgClose(hcryptmsg);
     Py_XDECREF(this->obcryptmsg);
+    Py_XDECREF(this->obdecryptcert);
+    free(outbuf);
+    PyWinObject_FreeCRYPT_DECRYPT_MESSAGE_PARA(&decryptpara);
 }
 
 void PyCRYPTMSG::deallocFunc(PyObject *ob) { delete (PyCRYPTMSG *)ob; }
@@ -103,14 +115,189 @@ PyCRYPTMSG::PyCRYPTMSG(HCRYPTMSG h)
     this->hcryptmsg = h;
     this->obcryptmsg = PyLong_FromVoidPtr((void *)h);
     this->obdummy = NULL;
+    this->obdecryptcert = NULL;
+    this->decryptcert = NULL;
+    ZeroMemory(&streaminfo, sizeof(streaminfo));
+    ZeroMemory(&decryptpara, sizeof(decryptpara));
+    bStreaming = bDecrypted = FALSE;
+    outbuf = NULL;
+    outlen = outcap = 0;
+    lasterr = 0;
+    lastfunc = NULL;
+}
+
+// Returns stream info that directs the message's output to this object, so the message must be opened
+// before Attach is called with its handle.
+PCMSG_STREAM_INFO PyCRYPTMSG::GetStreamInfo(void)
+{
+    streaminfo.cbContent = CMSG_INDEFINITE_LENGTH;
+    streaminfo.pfnStreamOutput = PyCRYPTMSG::StreamOutput;
+    streaminfo.pvArg = this;
+    bStreaming = TRUE;
+    return &streaminfo;
+}
+
+void PyCRYPTMSG::Attach(HCRYPTMSG h)
+{
+    hcryptmsg = h;
+    Py_XDECREF(obcryptmsg);
+    obcryptmsg = PyLong_FromVoidPtr((void *)h);
+}
+
+// Called from within CryptMsgUpdate, with the GIL released.
+BOOL WINAPI PyCRYPTMSG::StreamOutput(const void *pvArg, BYTE *pbData, DWORD cbData, BOOL fFinal)
+{
+    PyCRYPTMSG *This = (PyCRYPTMSG *)pvArg;
+    if (cbData == 0)
+        return TRUE;
+    if (This->outlen + cbData > This->outcap) {
+        DWORD newcap = max(This->outcap * 2, This->outlen + cbData);
+        BYTE *newbuf = (BYTE *)realloc(This->outbuf, newcap);
+        if (newbuf == NULL) {
+            SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+            return FALSE;
+        }
+        This->outbuf = newbuf;
+        This->outcap = newcap;
+    }
+    memcpy(This->outbuf + This->outlen, pbData, cbData);
+    This->outlen += cbData;
+    return TRUE;
+}
+
+// Supplies the key for an enveloped message being decoded, once its recipient info has been decoded.
+// Called with the GIL released - records the error in lastfunc and lasterr on failure.
+BOOL PyCRYPTMSG::Decrypt(void)
+{
+    DWORD recipient_cnt, recipient_ind, store_ind, size = sizeof(recipient_cnt);
+    if (!CryptMsgGetParam(hcryptmsg, CMSG_RECIPIENT_COUNT_PARAM, 0, &recipient_cnt, &size))
+        // More of the message is needed first.
+        return TRUE;
+    DWORD acquire_flags = CRYPT_ACQUIRE_CACHE_FLAG | CRYPT_ACQUIRE_ALLOW_NCRYPT_KEY_FLAG;
+    if (decryptpara.dwFlags & CRYPT_MESSAGE_SILENT_KEYSET_FLAG)
+        acquire_flags |= CRYPT_ACQUIRE_SILENT_FLAG;
+    for (recipient_ind = 0; recipient_ind < recipient_cnt; recipient_ind++) {
+        size = 0;
+        if (!CryptMsgGetParam(hcryptmsg, CMSG_RECIPIENT_INFO_PARAM, recipient_ind, NULL, &size))
+            continue;
+        PCERT_INFO certinfo = (PCERT_INFO)malloc(size);
+        if (certinfo == NULL) {
+            lastfunc = "CryptMsgGetParam";
+            lasterr = ERROR_NOT_ENOUGH_MEMORY;
+            return FALSE;
+        }
+        PCCERT_CONTEXT cert = NULL;
+        if (CryptMsgGetParam(hcryptmsg, CMSG_RECIPIENT_INFO_PARAM, recipient_ind, certinfo, &size))
+            for (store_ind = 0; store_ind < decryptpara.cCertStore && cert == NULL; store_ind++)
+                cert = CertGetSubjectCertificateFromStore(decryptpara.rghCertStore[store_ind],
+                                                          decryptpara.dwMsgAndCertEncodingType, certinfo);
+        free(certinfo);
+        if (cert == NULL)
+            continue;
+        CMSG_CTRL_DECRYPT_PARA cdp = {0};
+        BOOL bfree;
+        cdp.cbSize = sizeof(cdp);
+        cdp.dwRecipientIndex = recipient_ind;
+        if (!CryptAcquireCertificatePrivateKey(cert, acquire_flags, NULL, &cdp.hCryptProv, &cdp.dwKeySpec, &bfree) ||
+            !CryptMsgControl(hcryptmsg, 0, CMSG_CTRL_DECRYPT, &cdp)) {
+            CertFreeCertificateContext(cert);
+            continue;
+        }
+        bDecrypted = TRUE;
+        // Converted to a PyCERT_CONTEXT once the GIL is held again.
+        decryptcert = cert;
+        return TRUE;
+    }
+    lastfunc = "CryptMsgControl";
+    lasterr = CRYPT_E_NO_DECRYPT_CERT;
+    return FALSE;
+}
+
+BOOL PyCRYPTMSG::Update(const BYTE *data, DWORD len, BOOL final)
+{
+    // Until an enveloped message has its key, the final chunk is held back, and sent as an empty final
+    // update once the key has been supplied.
+    BOOL bNeedKey = decryptpara.cbSize != 0 && !bDecrypted;
+    if (!CryptMsgUpdate(hcryptmsg, data, len, final && !bNeedKey)) {
+        lastfunc = "CryptMsgUpdate";
+        lasterr = GetLastError();
+        return FALSE;
+    }
+    if (!bNeedKey)
+        return TRUE;
+    DWORD msgtype, size = sizeof(msgtype);
+    BOOL bEnveloped = CryptMsgGetParam(hcryptmsg, CMSG_TYPE_PARAM, 0, &msgtype, &size) && msgtype == CMSG_ENVELOPED;
+    if (bEnveloped && !Decrypt())
+        return FALSE;
+    if (!final)
+        return TRUE;
+    if (bEnveloped && !bDecrypted) {
+        lastfunc = "CryptMsgUpdate";
+        lasterr = CRYPT_E_STREAM_MSG_NOT_READY;
+        return FALSE;
+    }
+    if (!CryptMsgUpdate(hcryptmsg, NULL, 0, TRUE)) {
+        lastfunc = "CryptMsgUpdate";
+        lasterr = GetLastError();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+PyObject *PyCRYPTMSG::TakeOutput(void)
+{
+    PyObject *ret = PyBytes_FromStringAndSize((char *)outbuf, outlen);
+    if (ret != NULL)
+        outlen = 0;
+    return ret;
 }
 
 // @pymethod |PyCRYPTMSG|CryptMsgClose|Closes the message handle
 PyObject *PyCRYPTMSG::PyCryptMsgClose(PyObject *self, PyObject *args)
 {
-    HCRYPTMSG h = ((PyCRYPTMSG *)self)->GetHCRYPTMSG();
+    PyCRYPTMSG *This = (PyCRYPTMSG *)self;
+    HCRYPTMSG h = This->GetHCRYPTMSG();
     if (!CryptMsgClose(h))
         return PyWin_SetAPIError("CryptMsgClose");
+    This->Attach(NULL);
     Py_INCREF(Py_None);
     return Py_None;
 }
+
+// @pymethod bytes|PyCRYPTMSG|CryptMsgUpdate|Adds data to a streaming message, and returns any output
+// @rdesc Returns the encoded or decoded data produced from this and any previous chunks that hasn't been returned
+// yet.  This may be empty, as the API buffers some data internally.
+// @comm The GIL is released while the data is processed.  When decoding an enveloped message, the recipient's
+// certificate is looked up in the CertStores of the DecryptPara as soon as enough of the message has been
+// supplied, and <om PyCRYPTMSG.DecryptCert> is set.
+PyObject *PyCRYPTMSG::PyCryptMsgUpdate(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Data", "Final", NULL};
+    PyCRYPTMSG *This = (PyCRYPTMSG *)self;
+    PyObject *obdata;
+    BOOL final = FALSE, bsuccess;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|i:CryptMsgUpdate", keywords,
+                                     &obdata,  // @pyparm buffer|Data||The next chunk of the message
+                                     &final))  // @pyparm boolean|Final|False|True for the last chunk
+        return NULL;
+    if (This->hcryptmsg == NULL) {
+        PyErr_SetString(PyExc_ValueError, "The message has been closed");
+        return NULL;
+    }
+    PyWinBufferView pybuf(obdata);
+    if (!pybuf.ok())
+        return NULL;
+    This->decryptcert = NULL;
+    Py_BEGIN_ALLOW_THREADS bsuccess = This->Update((BYTE *)pybuf.ptr(), pybuf.len(), final);
+    Py_END_ALLOW_THREADS if (This->decryptcert != NULL)
+    {
+        Py_XDECREF(This->obdecryptcert);
+        This->obdecryptcert = PyWinObject_FromCERT_CONTEXT(This->decryptcert);
+        This->decryptcert = NULL;
+    }
+    if (!bsuccess)
+        return PyWin_SetAPIError((char *)This->lastfunc, This->lasterr);
+    if (!This->bStreaming)
+        return PyBytes_FromStringAndSize(NULL, 0);
+    return This->TakeOutput();
+}
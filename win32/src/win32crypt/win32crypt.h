@@ -6,6 +6,13 @@
 #include "structmember.h"
 #include "PyWinTypes.h"
 #include "PyWinObjects.h"
+#include "bcrypt.h"
+#include "ntsecapi.h"
+
+// Only defined by the Windows 8 SDK and later
+#ifndef BCRYPT_HASH_REUSABLE_FLAG
+#define BCRYPT_HASH_REUSABLE_FLAG 0x00000020
+#endif
 
 extern __declspec(dllexport) PyTypeObject PyCRYPTKEYType;
 extern __declspec(dllexport) PyTypeObject PyCRYPTPROVType;
@@ -13,7 +20,10 @@ extern __declspec(dllexport) PyTypeObject PyCRYPTHASHType;
 extern __declspec(dllexport) PyTypeObject PyCRYPTMSGType;
 extern __declspec(dllexport) PyTypeObject PyCERTSTOREType;
 extern __declspec(dllexport) PyTypeObject PyCERT_CONTEXTType;
+extern __declspec(dllexport) PyTypeObject PyCERTSTORE_ITERType;
 extern __declspec(dllexport) PyTypeObject PyCTL_CONTEXTType;
+extern __declspec(dllexport) PyTypeObject PyBCRYPT_HASHType;
+extern __declspec(dllexport) PyTypeObject PyBCRYPT_KEYType;
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 class __declspec(dllexport) PyCERT_CONTEXT : public PyObject {
    public:
@@ -46,6 +56,9 @@ class __declspec(dllexport) PyCERT_CONTEXT : public PyObject {
    protected:
     PCCERT_CONTEXT pccert_context;
     PyObject *obdummy;
+    // Decoded on first access and kept for the life of the object
+    PyObject *obsubjectname, *obissuername, *obthumbprint, *obnotafter;
+    static PyObject *GetCachedAttr(PyObject **cached, PyObject *val);
 };
 
 // #define OFF(e) offsetof(PyCERT_CONTEXT, e)
@@ -64,6 +77,7 @@ class __declspec(dllexport) PyCERTSTORE : public PyObject {
     static PyObject *PyCertControlStore(PyObject *self, PyObject *args, PyObject *kwargs);
     static PyObject *PyCertEnumCertificatesInStore(PyObject *self, PyObject *args);
     static PyObject *PyCertEnumCTLsInStore(PyObject *self, PyObject *args);
+    static PyObject *PyCertFindCertificatesInStore(PyObject *self, PyObject *args, PyObject *kwargs);
     static PyObject *PyCertSaveStore(PyObject *self, PyObject *args, PyObject *kwargs);
     static PyObject *PyCertAddEncodedCertificateToStore(PyObject *self, PyObject *args, PyObject *kwargs);
     static PyObject *PyCertAddCertificateContextToStore(PyObject *self, PyObject *args, PyObject *kwargs);
@@ -89,6 +103,33 @@ class __declspec(dllexport) PyCERTSTORE : public PyObject {
     HCERTSTORE hcertstore;
 };
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Iterates the certificates in a store that match a CertFindCertificateInStore search
+class __declspec(dllexport) PyCERTSTORE_ITER : public PyObject {
+   public:
+    PyCERTSTORE_ITER(HCERTSTORE hcertstore);
+    ~PyCERTSTORE_ITER(void);
+
+    static void deallocFunc(PyObject *ob);
+    static PyObject *iternext(PyObject *self);
+    // Converts FindPara to the struct expected for the FindType
+    BOOL SetFindPara(DWORD findtype, PyObject *obfindpara);
+    BOOL bHaveExpiresBefore, bHaveExpiresAfter;
+    FILETIME expiresbefore, expiresafter;
+    DWORD encoding, findflags;
+
+   protected:
+    HCERTSTORE hcertstore;
+    PCCERT_CONTEXT pccert_context;
+    DWORD findtype;
+    void *findpara;
+    CRYPT_DATA_BLOB findblob;
+    DWORD finddword;
+    WCHAR *findstr;
+    PyObject *obfindpara;
+    BOOL bDone;
+};
+
 ///////////////////////////////////////////////////////////////////////////////////////////////
 class __declspec(dllexport) PyCRYPTHASH : public PyObject {
    public:
@@ -194,8 +235,30 @@ class __declspec(dllexport) PyCRYPTMSG : public PyObject {
     static PyObject *getattro(PyObject *self, PyObject *name);
     static int setattro(PyObject *self, PyObject *name, PyObject *v);
     static PyObject *PyCryptMsgClose(PyObject *self, PyObject *args);
+    static PyObject *PyCryptMsgUpdate(PyObject *self, PyObject *args, PyObject *kwargs);
     HCRYPTMSG GetHCRYPTMSG(void) { return hcryptmsg; };
 
+    // Support for messages opened in streaming mode by CryptMsgOpenToEncode and CryptMsgOpenToDecode
+    PCMSG_STREAM_INFO GetStreamInfo(void);
+    void Attach(HCRYPTMSG h);
+    static BOOL WINAPI StreamOutput(const void *pvArg, BYTE *pbData, DWORD cbData, BOOL fFinal);
+    BOOL Update(const BYTE *data, DWORD len, BOOL final);
+    BOOL Decrypt(void);
+    PyObject *TakeOutput(void);
+
+    CMSG_STREAM_INFO streaminfo;
+    BOOL bStreaming;
+    // Output from the stream callback not yet returned by CryptMsgUpdate
+    BYTE *outbuf;
+    DWORD outlen, outcap;
+    // For decoding enveloped messages, the stores searched for the recipient's certificate
+    CRYPT_DECRYPT_MESSAGE_PARA decryptpara;
+    BOOL bDecrypted;
+    PCCERT_CONTEXT decryptcert;
+    PyObject *obdecryptcert;
+    DWORD lasterr;
+    const char *lastfunc;
+
 #ifdef _MSC_VER
 #pragma warning(disable : 4251)
 #endif  // _MSC_VER
@@ -209,6 +272,73 @@ class __declspec(dllexport) PyCRYPTMSG : public PyObject {
     HCRYPTMSG hcryptmsg;
 };
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+class __declspec(dllexport) PyBCRYPT_HASH : public PyObject {
+   public:
+    PyBCRYPT_HASH(void);
+    ~PyBCRYPT_HASH(void);
+
+    static void deallocFunc(PyObject *ob);
+    static PyObject *PyBCryptHashData(PyObject *self, PyObject *args, PyObject *kwargs);
+    static PyObject *PyBCryptFinishHash(PyObject *self, PyObject *args);
+    static PyObject *PyBCryptDuplicateHash(PyObject *self, PyObject *args);
+    static PyObject *PyHashFile(PyObject *self, PyObject *args, PyObject *kwargs);
+    static PyObject *PyBCryptDestroyHash(PyObject *self, PyObject *args);
+    NTSTATUS Create(void);
+    BOOL Enter(void);
+    const char *HashFile(HANDLE hfile, ULONGLONG offset, ULONGLONG length, DWORD chunksize, DWORD *perr);
+
+#ifdef _MSC_VER
+#pragma warning(disable : 4251)
+#endif  // _MSC_VER
+    static struct PyMemberDef members[];
+#ifdef _MSC_VER
+#pragma warning(default : 4251)
+#endif  // _MSC_VER
+    static struct PyMethodDef methods[];
+
+    BCRYPT_HASH_HANDLE hhash;
+    BCRYPT_ALG_HANDLE halg;  // shared, never closed
+    PyObject *obalgorithm;
+    BYTE *secret;  // HMAC key, kept to recreate the hash if BCRYPT_HASH_REUSABLE_FLAG isn't supported
+    ULONG secretlen, digestsize;
+    ULONGLONG byteshashed;
+    BOOL bReusable, bBusy;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+class __declspec(dllexport) PyBCRYPT_KEY : public PyObject {
+   public:
+    PyBCRYPT_KEY(void);
+    ~PyBCRYPT_KEY(void);
+
+    static void deallocFunc(PyObject *ob);
+    static PyObject *PyBCryptEncrypt(PyObject *self, PyObject *args, PyObject *kwargs);
+    static PyObject *PyBCryptDecrypt(PyObject *self, PyObject *args, PyObject *kwargs);
+    static PyObject *PyBCryptDestroyKey(PyObject *self, PyObject *args);
+    BOOL Enter(void);
+    PyObject *DoCrypt(BOOL bEncrypt, PyObject *obdata, PyObject *obnonce, PyObject *obauthdata, PyObject *obtag,
+                      DWORD tagsize, PyObject *oboutput);
+
+#ifdef _MSC_VER
+#pragma warning(disable : 4251)
+#endif  // _MSC_VER
+    static struct PyMemberDef members[];
+#ifdef _MSC_VER
+#pragma warning(default : 4251)
+#endif  // _MSC_VER
+    static struct PyMethodDef methods[];
+
+    BCRYPT_KEY_HANDLE hkey;
+    PyObject *obalgorithm, *obchainingmode;
+    BOOL bBusy;
+};
+
+// CNG functions implemented in PyBCRYPT.cpp
+PyObject *PyBCryptCreateHash(PyObject *self, PyObject *args, PyObject *kwargs);
+PyObject *PyBCryptGenerateSymmetricKey(PyObject *self, PyObject *args, PyObject *kwargs);
+PyObject *PyWin_SetBCryptError(char *fname, NTSTATUS status);
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 class __declspec(dllexport) PyCTL_CONTEXT : public PyObject {
    public:
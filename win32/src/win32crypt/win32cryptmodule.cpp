@@ -1299,6 +1299,104 @@ static PyObject *PyCryptDecryptMessage(PyObject *self, PyObject *args, PyObject
     return ret;
 }
 
+// @pymethod <o PyCRYPTMSG>|win32crypt|CryptMsgOpenToEncode|Opens an enveloped message for encrypting in streaming mode
+// @comm The message is created in the same format as <om win32crypt.CryptEncryptMessage> produces, with an indefinite
+// length so it can be decoded a chunk at a time.  Pass the data to be encrypted to <om PyCRYPTMSG.CryptMsgUpdate>,
+// which returns the encrypted data so far.
+static PyObject *PyCryptMsgOpenToEncode(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"EncryptPara", "RecipientCert", "Flags", NULL};
+    PyObject *obcemp, *obrecipients;
+    CRYPT_ENCRYPT_MESSAGE_PARA cemp = {0};
+    CMSG_ENVELOPED_ENCODE_INFO eei = {0};
+    PCCERT_CONTEXT *recipients = NULL;
+    PCERT_INFO *recipient_infos = NULL;
+    DWORD recipient_cnt = 0, flags = 0;
+    HCRYPTMSG h;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "OO|k:CryptMsgOpenToEncode", keywords,
+            &obcemp,        // @pyparm <o PyCRYPT_ENCRYPT_MESSAGE_PARA>|EncryptPara||Encryption parameters
+            &obrecipients,  // @pyparm (<o PyCERT_CONTEXT>,...)|RecipientCert||Sequence of handles to recipients'
+                            // certificates
+            &flags))        // @pyparm int|Flags|0|Combination of CMSG_*_FLAG values
+        return NULL;
+    if (!PyWinObject_AsCRYPT_ENCRYPT_MESSAGE_PARA(obcemp, &cemp))
+        return NULL;
+    if (!PyWinObject_AsCERT_CONTEXTArray(obrecipients, &recipients, &recipient_cnt))
+        return NULL;
+    PyCRYPTMSG *ret = NULL;
+    recipient_infos = (PCERT_INFO *)malloc(max(recipient_cnt, 1) * sizeof(PCERT_INFO));
+    if (recipient_infos == NULL)
+        PyErr_NoMemory();
+    else {
+        for (DWORD i = 0; i < recipient_cnt; i++) recipient_infos[i] = recipients[i]->pCertInfo;
+        eei.cbSize = sizeof(eei);
+        eei.hCryptProv = cemp.hCryptProv;
+        eei.ContentEncryptionAlgorithm = cemp.ContentEncryptionAlgorithm;
+        eei.cRecipients = recipient_cnt;
+        eei.rgpRecipients = recipient_infos;
+        ret = new PyCRYPTMSG(NULL);
+        if (ret == NULL)
+            PyErr_NoMemory();
+        else {
+            PCMSG_STREAM_INFO psi = ret->GetStreamInfo();
+            Py_BEGIN_ALLOW_THREADS h = CryptMsgOpenToEncode(cemp.dwMsgEncodingType, flags, CMSG_ENVELOPED, &eei,
+                                                            NULL, psi);
+            Py_END_ALLOW_THREADS if (h == NULL)
+            {
+                PyWin_SetAPIError("CryptMsgOpenToEncode");
+                Py_DECREF(ret);
+                ret = NULL;
+            }
+            else ret->Attach(h);
+        }
+    }
+    free(recipient_infos);
+    PyWinObject_FreeCERT_CONTEXTArray(recipients, recipient_cnt);
+    return ret;
+}
+
+// @pymethod <o PyCRYPTMSG>|win32crypt|CryptMsgOpenToDecode|Opens a message for decoding in streaming mode
+// @comm Pass the encoded message to <om PyCRYPTMSG.CryptMsgUpdate> a chunk at a time, and it returns the inner
+// content decoded so far.  For example, this can decrypt the output of <om win32crypt.CryptEncryptMessage> or
+// <om win32crypt.CryptMsgOpenToEncode> without reading all of it into memory.
+static PyObject *PyCryptMsgOpenToDecode(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"DecryptPara", "MsgType", "Flags", NULL};
+    PyObject *obcdmp = Py_None;
+    DWORD msgtype = 0, flags = 0, encoding = X509_ASN_ENCODING | PKCS_7_ASN_ENCODING;
+    HCRYPTMSG h;
+
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|Okk:CryptMsgOpenToDecode", keywords,
+            &obcdmp,   // @pyparm <o PyCRYPT_DECRYPT_MESSAGE_PARA>|DecryptPara|None|The stores to search for the
+                       // certificate that decrypts an enveloped message.  Can be None for other types of message.
+            &msgtype,  // @pyparm int|MsgType|0|A CMSG_* message type, or 0 to accept any type
+            &flags))   // @pyparm int|Flags|0|Combination of CMSG_*_FLAG values
+        return NULL;
+    PyCRYPTMSG *ret = new PyCRYPTMSG(NULL);
+    if (ret == NULL)
+        return PyErr_NoMemory();
+    if (obcdmp != Py_None) {
+        if (!PyWinObject_AsCRYPT_DECRYPT_MESSAGE_PARA(obcdmp, &ret->decryptpara)) {
+            Py_DECREF(ret);
+            return NULL;
+        }
+        encoding = ret->decryptpara.dwMsgAndCertEncodingType;
+    }
+    PCMSG_STREAM_INFO psi = ret->GetStreamInfo();
+    Py_BEGIN_ALLOW_THREADS h = CryptMsgOpenToDecode(encoding, flags, msgtype, NULL, NULL, psi);
+    Py_END_ALLOW_THREADS if (h == NULL)
+    {
+        PyWin_SetAPIError("CryptMsgOpenToDecode");
+        Py_DECREF(ret);
+        return NULL;
+    }
+    ret->Attach(h);
+    return ret;
+}
+
 // @pymethod str|win32crypt|CryptSignAndEncryptMessage|Encrypts, encodes and signs a message using a certificate
 static PyObject *PyCryptSignAndEncryptMessage(PyObject *self, PyObject *args, PyObject *kwargs)
 {
@@ -2024,8 +2122,259 @@ static PyObject *PyPFXIsPFXBlob(PyObject *self, PyObject *args, PyObject *kwargs
     Py_END_ALLOW_THREADS return PyBool_FromLong(out);
 }
 
+// Only defined by the Vista SDK and later
+#ifndef CRYPT_STRING_HEXRAW
+#define CRYPT_STRING_HEXRAW 0x0000000c
+#endif
+#ifndef CRYPT_STRING_NOCRLF
+#define CRYPT_STRING_NOCRLF 0x40000000
+#endif
+#ifndef CRYPT_STRING_NOCR
+#define CRYPT_STRING_NOCR 0x80000000
+#endif
+
+// Base64 and raw hex, the common formats for CryptBinaryToString and
+// CryptStringToBinary, are converted natively in a single pass straight into
+// the result object.  They produce exactly what CryptoAPI does, and any other
+// format - or input the native decoders don't accept - goes to CryptoAPI.
+
+// Conversions of more than this many bytes release the Python lock.
+#define CRYPT_CODEC_THREAD_THRESHOLD 0x10000
+// Base64 lines are 64 characters, from 48 bytes.
+#define CRYPT_CODEC_LINE_BYTES 48
+
+static const char codec_b64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char codec_hex_chars[] = "0123456789abcdef";
+// Values of each character - 0-63 for base64 digits, 0-15 for hex digits, or one of these.
+#define CODEC_SPACE 0x40
+#define CODEC_PAD 0x41
+#define CODEC_BAD 0x80
+static BYTE codec_b64_values[256];
+static BYTE codec_hex_values[256];
+
+static void crypt_codec_init(void)
+{
+    memset(codec_b64_values, CODEC_BAD, sizeof(codec_b64_values));
+    memset(codec_hex_values, CODEC_BAD, sizeof(codec_hex_values));
+    for (BYTE i = 0; i < 64; i++) codec_b64_values[(BYTE)codec_b64_chars[i]] = i;
+    for (BYTE i = 0; i < 10; i++) codec_hex_values['0' + i] = i;
+    for (BYTE i = 0; i < 6; i++) codec_hex_values['a' + i] = codec_hex_values['A' + i] = 10 + i;
+    static const char spaces[] = " \t\r\n";
+    for (const char *c = spaces; *c; c++) codec_b64_values[(BYTE)*c] = codec_hex_values[(BYTE)*c] = CODEC_SPACE;
+    codec_b64_values['='] = CODEC_PAD;
+}
+
+// The number of characters ending each line for CryptBinaryToString flags, or -1 if the
+// combination of modifiers is left to CryptoAPI.  The format is returned without them.
+static int codec_eol_len(DWORD flags, DWORD *format)
+{
+    DWORD mods = flags & (CRYPT_STRING_NOCRLF | CRYPT_STRING_NOCR);
+    *format = flags & ~mods;
+    if (mods == 0)
+        return 2;
+    if (mods == CRYPT_STRING_NOCR)
+        return 1;
+    if (mods == CRYPT_STRING_NOCRLF)
+        return 0;
+    return -1;
+}
+
+static BYTE *codec_put_eol(BYTE *out, int eol_len)
+{
+    if (eol_len == 2)
+        *out++ = '\r';
+    if (eol_len)
+        *out++ = '\n';
+    return out;
+}
+
+static void codec_b64_encode(const BYTE *in, size_t len, BYTE *out, int eol_len)
+{
+    while (len) {
+        size_t line = len < CRYPT_CODEC_LINE_BYTES ? len : CRYPT_CODEC_LINE_BYTES;
+        len -= line;
+        for (; line >= 3; line -= 3, in += 3, out += 4) {
+            DWORD v = (in[0] << 16) | (in[1] << 8) | in[2];
+            out[0] = codec_b64_chars[v >> 18];
+            out[1] = codec_b64_chars[(v >> 12) & 0x3f];
+            out[2] = codec_b64_chars[(v >> 6) & 0x3f];
+            out[3] = codec_b64_chars[v & 0x3f];
+        }
+        // Only the last line can end part way through a group.
+        if (line) {
+            DWORD v = (in[0] << 16) | (line == 2 ? in[1] << 8 : 0);
+            out[0] = codec_b64_chars[v >> 18];
+            out[1] = codec_b64_chars[(v >> 12) & 0x3f];
+            out[2] = line == 2 ? codec_b64_chars[(v >> 6) & 0x3f] : '=';
+            out[3] = '=';
+            in += line;
+            out += 4;
+        }
+        out = codec_put_eol(out, eol_len);
+    }
+}
+
+static void codec_hex_encode(const BYTE *in, size_t len, BYTE *out, int eol_len)
+{
+    for (; len; len--, in++, out += 2) {
+        out[0] = codec_hex_chars[*in >> 4];
+        out[1] = codec_hex_chars[*in & 0xf];
+    }
+    codec_put_eol(out, eol_len);
+}
+
+// Returns the number of bytes decoded, or -1 if the string isn't padded base64 which is
+// only broken by whitespace.
+static Py_ssize_t codec_b64_decode(const BYTE *in, Py_ssize_t len, BYTE *out)
+{
+    BYTE *start = out;
+    DWORD acc = 0;
+    int digits = 0, pad = 0;
+    for (const BYTE *end = in + len; in < end; in++) {
+        BYTE v = codec_b64_values[*in];
+        if (v < 64) {
+            if (pad)
+                return -1;
+            acc = (acc << 6) | v;
+            if (++digits == 4) {
+                out[0] = (BYTE)(acc >> 16);
+                out[1] = (BYTE)(acc >> 8);
+                out[2] = (BYTE)acc;
+                out += 3;
+                digits = 0;
+                acc = 0;
+            }
+        }
+        else if (v == CODEC_PAD) {
+            if (digits < 2 || digits + ++pad > 4)
+                return -1;
+        }
+        else if (v != CODEC_SPACE)
+            return -1;
+    }
+    if (pad) {
+        if (digits + pad != 4)
+            return -1;
+        acc <<= 6 * pad;
+        *out++ = (BYTE)(acc >> 16);
+        if (digits == 3)
+            *out++ = (BYTE)(acc >> 8);
+    }
+    else if (digits)
+        return -1;
+    // Leave CryptoAPI to decide what an empty string means.
+    if (out == start)
+        return -1;
+    return out - start;
+}
+
+// Returns the number of bytes decoded, or -1 if the string isn't pairs of hex digits.  For
+// CRYPT_STRING_HEX the pairs may be separated by whitespace, but raw hex may only be followed
+// by it.
+static Py_ssize_t codec_hex_decode(const BYTE *in, Py_ssize_t len, BYTE *out, BOOL bRaw)
+{
+    BYTE *start = out;
+    const BYTE *end = in + len;
+    while (in < end) {
+        BYTE hi = codec_hex_values[*in];
+        if (hi == CODEC_SPACE) {
+            if (bRaw) {
+                for (; in < end; in++)
+                    if (codec_hex_values[*in] != CODEC_SPACE)
+                        return -1;
+                break;
+            }
+            in++;
+            continue;
+        }
+        if (hi > 15 || in + 1 == end || codec_hex_values[in[1]] > 15)
+            return -1;
+        *out++ = (BYTE)((hi << 4) | codec_hex_values[in[1]]);
+        in += 2;
+    }
+    if (out == start)
+        return -1;
+    return out - start;
+}
+
+// Returns FALSE if the conversion is left to CryptoAPI, otherwise *ret is the string or NULL
+// with an exception set.
+static BOOL codec_binary_to_string(const BYTE *in, DWORD len, DWORD flags, PyObject **ret)
+{
+    DWORD format;
+    int eol_len = codec_eol_len(flags, &format);
+    if (eol_len < 0 || len == 0 || len > (DWORD)(PY_SSIZE_T_MAX / 3))
+        return FALSE;
+    Py_ssize_t size;
+    if (format == CRYPT_STRING_BASE64)
+        size = ((Py_ssize_t)len + 2) / 3 * 4 +
+               ((Py_ssize_t)len + CRYPT_CODEC_LINE_BYTES - 1) / CRYPT_CODEC_LINE_BYTES * eol_len;
+    else if (format == CRYPT_STRING_HEXRAW)
+        size = (Py_ssize_t)len * 2 + eol_len;
+    else
+        return FALSE;
+    *ret = PyUnicode_New(size, 127);
+    if (*ret == NULL)
+        return TRUE;
+    BYTE *out = PyUnicode_1BYTE_DATA(*ret);
+    if (len > CRYPT_CODEC_THREAD_THRESHOLD) {
+        Py_BEGIN_ALLOW_THREADS;
+        if (format == CRYPT_STRING_BASE64)
+            codec_b64_encode(in, len, out, eol_len);
+        else
+            codec_hex_encode(in, len, out, eol_len);
+        Py_END_ALLOW_THREADS;
+    }
+    else if (format == CRYPT_STRING_BASE64)
+        codec_b64_encode(in, len, out, eol_len);
+    else
+        codec_hex_encode(in, len, out, eol_len);
+    return TRUE;
+}
+
+// As for codec_binary_to_string, with *ret the tuple CryptStringToBinary returns.
+static BOOL codec_string_to_binary(PyObject *obstring, DWORD flags, PyObject **ret)
+{
+    if (flags != CRYPT_STRING_BASE64 && flags != CRYPT_STRING_HEX && flags != CRYPT_STRING_HEXRAW)
+        return FALSE;
+    // Only strings of 1 byte characters can be base64 or hex.
+    if (!PyUnicode_Check(obstring) || PyUnicode_READY(obstring) == -1 ||
+        PyUnicode_KIND(obstring) != PyUnicode_1BYTE_KIND) {
+        PyErr_Clear();
+        return FALSE;
+    }
+    const BYTE *in = PyUnicode_1BYTE_DATA(obstring);
+    Py_ssize_t len = PyUnicode_GET_LENGTH(obstring);
+    PyObject *obbinary =
+        PyBytes_FromStringAndSize(NULL, flags == CRYPT_STRING_BASE64 ? len / 4 * 3 + 3 : len / 2 + 1);
+    if (obbinary == NULL) {
+        *ret = NULL;
+        return TRUE;
+    }
+    BYTE *out = (BYTE *)PyBytes_AS_STRING(obbinary);
+    Py_ssize_t decoded;
+    if (len > CRYPT_CODEC_THREAD_THRESHOLD) {
+        Py_BEGIN_ALLOW_THREADS;
+        decoded = flags == CRYPT_STRING_BASE64 ? codec_b64_decode(in, len, out)
+                                               : codec_hex_decode(in, len, out, flags == CRYPT_STRING_HEXRAW);
+        Py_END_ALLOW_THREADS;
+    }
+    else
+        decoded = flags == CRYPT_STRING_BASE64 ? codec_b64_decode(in, len, out)
+                                               : codec_hex_decode(in, len, out, flags == CRYPT_STRING_HEXRAW);
+    if (decoded < 0) {
+        Py_DECREF(obbinary);
+        return FALSE;
+    }
+    *ret = _PyBytes_Resize(&obbinary, decoded) == 0 ? Py_BuildValue("Nkk", obbinary, (DWORD)0, flags) : NULL;
+    return TRUE;
+}
+
 // @pymethod str|win32crypt|CryptBinaryToString|Formats a binary buffer into the specified type of string
 // @pyseeapi CryptBinaryToString
+// @comm CRYPT_STRING_BASE64 and CRYPT_STRING_HEXRAW, optionally with CRYPT_STRING_NOCR or
+// CRYPT_STRING_NOCRLF, are converted natively in a single pass, giving the same result as
+// CryptoAPI.  Other formats are passed to CryptBinaryToString.
 static PyObject *PyCryptBinaryToString(PyObject *self, PyObject *args, PyObject *kwargs)
 {
     static char *keywords[] = {"Binary", "Flags", NULL};
@@ -2041,6 +2390,9 @@ static PyObject *PyCryptBinaryToString(PyObject *self, PyObject *args, PyObject
     PyWinBufferView pybuf(obinput_buf);
     if (!pybuf.ok())
         return NULL;
+    PyObject *ret = NULL;
+    if (codec_binary_to_string((BYTE *)pybuf.ptr(), pybuf.len(), flags, &ret))
+        return ret;
     BOOL bsuccess;
     Py_BEGIN_ALLOW_THREADS bsuccess = CryptBinaryToString((BYTE*)pybuf.ptr(), pybuf.len(), flags,
                                                           output_buf, &output_size);
@@ -2049,7 +2401,6 @@ static PyObject *PyCryptBinaryToString(PyObject *self, PyObject *args, PyObject
     if (output_buf == NULL)
         return PyErr_NoMemory();
 
-    PyObject *ret = NULL;
     Py_BEGIN_ALLOW_THREADS bsuccess = CryptBinaryToString((BYTE*)pybuf.ptr(), pybuf.len(), flags,
                                                           output_buf, &output_size);
     Py_END_ALLOW_THREADS if (!bsuccess) PyWin_SetAPIError("CryptBinaryToString");
@@ -2062,6 +2413,9 @@ static PyObject *PyCryptBinaryToString(PyObject *self, PyObject *args, PyObject
 // @pyseeapi CryptStringToBinary
 // @rdesc Returns the decoded binary data, number of header characters skipped, and CRYPT_STRING_* value
 // denoting the type of data found (used if input Flags is one of *_ANY values)
+// @comm CRYPT_STRING_BASE64, CRYPT_STRING_HEX and CRYPT_STRING_HEXRAW strings are decoded natively
+// in a single pass.  Other formats, and strings the native decoder doesn't accept, are passed
+// to CryptStringToBinary.
 static PyObject *PyCryptStringToBinary(PyObject *self, PyObject *args, PyObject *kwargs)
 {
     static char *keywords[] = {"String", "Flags", NULL};
@@ -2075,6 +2429,9 @@ static PyObject *PyCryptStringToBinary(PyObject *self, PyObject *args, PyObject
             &obinput_buf,  // @pyparm str|String||Formatted string to be converted to raw binary data
             &flags))       // @pyparm int|Flags||Input format (win32cryptcon.CRYPT_STRING_*)
         return NULL;
+    PyObject *ret;
+    if (codec_string_to_binary(obinput_buf, flags, &ret))
+        return ret;
     if (!PyWinObject_AsWCHAR(obinput_buf, &input_buf, FALSE, &input_size))
         return NULL;
     BOOL bsuccess;
@@ -2150,6 +2507,14 @@ static struct PyMethodDef win32crypt_functions[] = {
     {"CryptEncryptMessage", (PyCFunction)PyCryptEncryptMessage, METH_VARARGS | METH_KEYWORDS},
     // @pymeth CryptDecryptMessage|Decrypts an encrypted and encoded message
     {"CryptDecryptMessage", (PyCFunction)PyCryptDecryptMessage, METH_VARARGS | METH_KEYWORDS},
+    // @pymeth BCryptCreateHash|Creates a CNG hash or HMAC object
+    {"BCryptCreateHash", (PyCFunction)PyBCryptCreateHash, METH_VARARGS | METH_KEYWORDS},
+    // @pymeth BCryptGenerateSymmetricKey|Creates a CNG key for authenticated encryption
+    {"BCryptGenerateSymmetricKey", (PyCFunction)PyBCryptGenerateSymmetricKey, METH_VARARGS | METH_KEYWORDS},
+    // @pymeth CryptMsgOpenToEncode|Opens an enveloped message for encrypting in streaming mode
+    {"CryptMsgOpenToEncode", (PyCFunction)PyCryptMsgOpenToEncode, METH_VARARGS | METH_KEYWORDS},
+    // @pymeth CryptMsgOpenToDecode|Opens a message for decoding in streaming mode
+    {"CryptMsgOpenToDecode", (PyCFunction)PyCryptMsgOpenToDecode, METH_VARARGS | METH_KEYWORDS},
     // @pymeth CryptSignAndEncryptMessage|Decrypts an encrypted and encoded message
     {"CryptSignAndEncryptMessage", (PyCFunction)PyCryptSignAndEncryptMessage, METH_VARARGS | METH_KEYWORDS},
     // @pymeth CryptVerifyMessageSignature|Verifies a message signature
@@ -2189,11 +2554,13 @@ static struct PyMethodDef win32crypt_functions[] = {
 PYWIN_MODULE_INIT_FUNC(win32crypt)
 {
     PYWIN_MODULE_INIT_PREPARE(win32crypt, win32crypt_functions, "Support for Windows cryptography functions");
+    crypt_codec_init();
 
     if (PyType_Ready(&PyCRYPTPROVType) == -1 || PyType_Ready(&PyCRYPTKEYType) == -1 ||
         PyType_Ready(&PyCRYPTHASHType) == -1 || PyType_Ready(&PyCRYPTMSGType) == -1 ||
         PyType_Ready(&PyCERTSTOREType) == -1 || PyType_Ready(&PyCERT_CONTEXTType) == -1 ||
-        PyType_Ready(&PyCTL_CONTEXTType) == -1)
+        PyType_Ready(&PyCERTSTORE_ITERType) == -1 || PyType_Ready(&PyCTL_CONTEXTType) == -1 ||
+        PyType_Ready(&PyBCRYPT_HASHType) == -1 || PyType_Ready(&PyBCRYPT_KEYType) == -1)
         PYWIN_MODULE_INIT_RETURN_ERROR;
 
 #if (PY_VERSION_HEX >= 0x03000000)
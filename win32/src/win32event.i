@@ -430,3 +430,532 @@ DWORD_WAITAPI WaitForInputIdle(
 // @flag 0|The process is ready. 
 // @flag WAIT_TIMEOUT|The time-out interval elapsed, and the process is not ready. 
 
+
+#ifndef MS_WINCE
+// @object PyMultiWait|Waits for any number of handles, as returned by <om win32event.CreateMultiWait>.
+// @comm Unlike <om win32event.WaitForMultipleObjects>, there is no limit on the number
+// of handles.  Each handle is waited for by the system thread pool, via
+// RegisterWaitForSingleObject, so no Python thread is needed per group of
+// MAXIMUM_WAIT_OBJECTS handles.
+// <nl>Handles may be added and removed while another thread is blocked in
+// <om PyMultiWait.Wait>.  Each handle is reported once, then stops being waited for - add
+// it again to wait for it again.  This suits process and thread handles, which stay
+// signalled, and auto-reset events, whose signal is consumed by the wait.
+// <nl>The object keeps a reference to each handle object until it is reported or removed, so
+// a <o PyHANDLE> is not closed while it is being waited for.  Len() returns the number of
+// handles which have been added and not yet returned by <om PyMultiWait.Wait> or removed.
+%{
+struct PyMultiWait;
+
+typedef struct {
+	PyMultiWait *mw;
+	HANDLE h;
+	HANDLE hWait;
+	PyObject *obHandle;
+	PyObject *obCookie;
+	BOOL bSignalled;	// in the pending array
+	BOOL bRemoved;	// set before the wait is unregistered
+} PyMultiWaitEntry;
+
+struct PyMultiWait {
+	PyObject_HEAD
+	CRITICAL_SECTION cs;	// protects the pending array and the flags of the entries
+	HANDLE hReady;		// auto-reset, signalled when a handle is added to the pending array
+	HANDLE hStop;		// signalled by Close
+	BOOL bClosed;
+	// handle -> entry, linear probing.  Only changed with the GIL held.
+	PyMultiWaitEntry **table;
+	ULONG tableSize;	// always a power of 2, at least twice numEntries
+	ULONG numEntries;
+	// Signalled entries, in the order they were signalled.  Always has room for every entry.
+	PyMultiWaitEntry **pending;
+	ULONG numPending, maxPending;
+	LONG signalled;		// statistics
+	LONG batches;
+};
+
+extern PyTypeObject PyMultiWait_Type;
+
+static ULONG mw_hash(HANDLE h)
+{
+	ULONG_PTR v = (ULONG_PTR)h;
+	return (ULONG)((v >> 2) ^ (v >> 17)) * 2654435761U;
+}
+
+static ULONG mw_find(PyMultiWait *mw, HANDLE h)
+{
+	ULONG mask = mw->tableSize - 1;
+	ULONG i = mw_hash(h) & mask;
+	while (mw->table[i] && mw->table[i]->h != h)
+		i = (i + 1) & mask;
+	return i;
+}
+
+// Makes room for one more entry - in the table and in the pending array.
+static BOOL mw_reserve(PyMultiWait *mw)
+{
+	if (mw->numEntries + 1 > mw->maxPending) {
+		ULONG maxPending = mw->maxPending ? mw->maxPending * 2 : 64;
+		// The pool callbacks append to the pending array, so only grow it with the critical section held.
+		EnterCriticalSection(&mw->cs);
+		PyMultiWaitEntry **pending = (PyMultiWaitEntry **)realloc(mw->pending, maxPending * sizeof(PyMultiWaitEntry *));
+		if (pending) {
+			mw->pending = pending;
+			mw->maxPending = maxPending;
+		}
+		LeaveCriticalSection(&mw->cs);
+		if (pending == NULL)
+			return FALSE;
+	}
+	if ((mw->numEntries + 1) * 2 > mw->tableSize) {
+		ULONG oldSize = mw->tableSize;
+		PyMultiWaitEntry **old = mw->table;
+		ULONG tableSize = oldSize ? oldSize * 2 : 128;
+		PyMultiWaitEntry **table = (PyMultiWaitEntry **)calloc(tableSize, sizeof(PyMultiWaitEntry *));
+		if (table == NULL)
+			return FALSE;
+		mw->table = table;
+		mw->tableSize = tableSize;
+		for (ULONG i=0;i<oldSize;i++)
+			if (old[i])
+				mw->table[mw_find(mw, old[i]->h)] = old[i];
+		free(old);
+	}
+	return TRUE;
+}
+
+// Removes the entry at slot i of the table, shifting back any entries after it
+// so the probe sequences stay unbroken.
+static void mw_unlink(PyMultiWait *mw, ULONG i)
+{
+	ULONG mask = mw->tableSize - 1;
+	mw->table[i] = NULL;
+	mw->numEntries--;
+	for (ULONG j = (i + 1) & mask; mw->table[j]; j = (j + 1) & mask) {
+		PyMultiWaitEntry *e = mw->table[j];
+		mw->table[j] = NULL;
+		mw->table[mw_find(mw, e->h)] = e;
+	}
+}
+
+// Thread pool callback - runs once per entry, without the GIL.
+static VOID CALLBACK mw_signalled(PVOID param, BOOLEAN timedOut)
+{
+	PyMultiWaitEntry *e = (PyMultiWaitEntry *)param;
+	PyMultiWait *mw = e->mw;
+	EnterCriticalSection(&mw->cs);
+	if (!e->bRemoved && !e->bSignalled) {
+		e->bSignalled = TRUE;
+		mw->pending[mw->numPending++] = e;
+		mw->signalled++;
+		SetEvent(mw->hReady);
+	}
+	LeaveCriticalSection(&mw->cs);
+}
+
+// Unregisters the waits of entries which are no longer in the table, and frees them.
+// Called with the GIL held.
+static void mw_free_entries(PyMultiWait *mw, PyMultiWaitEntry **entries, ULONG num)
+{
+	EnterCriticalSection(&mw->cs);
+	for (ULONG i=0;i<num;i++)
+		entries[i]->bRemoved = TRUE;
+	LeaveCriticalSection(&mw->cs);
+	Py_BEGIN_ALLOW_THREADS
+	// Waits for any callback in progress, which needs the critical section - but not the GIL.
+	for (ULONG i=0;i<num;i++)
+		if (entries[i]->hWait)
+			UnregisterWaitEx(entries[i]->hWait, INVALID_HANDLE_VALUE);
+	Py_END_ALLOW_THREADS
+	for (ULONG i=0;i<num;i++) {
+		Py_XDECREF(entries[i]->obHandle);
+		Py_XDECREF(entries[i]->obCookie);
+		free(entries[i]);
+	}
+}
+
+static void mw_close(PyMultiWait *mw)
+{
+	if (mw->bClosed)
+		return;
+	EnterCriticalSection(&mw->cs);
+	mw->bClosed = TRUE;
+	mw->numPending = 0;
+	LeaveCriticalSection(&mw->cs);
+	SetEvent(mw->hStop);
+	ULONG num = 0;
+	PyMultiWaitEntry **entries = mw->table;
+	for (ULONG i=0;i<mw->tableSize;i++)
+		if (mw->table[i])
+			entries[num++] = mw->table[i];
+	mw->table = NULL;
+	mw->tableSize = mw->numEntries = 0;
+	mw_free_entries(mw, entries, num);
+	free(entries);
+}
+
+static void mw_dealloc(PyObject *ob)
+{
+	PyMultiWait *mw = (PyMultiWait *)ob;
+	mw_close(mw);
+	DeleteCriticalSection(&mw->cs);
+	if (mw->hReady)
+		CloseHandle(mw->hReady);
+	if (mw->hStop)
+		CloseHandle(mw->hStop);
+	free(mw->pending);
+	PyObject_Del(ob);
+}
+
+// @pymethod |PyMultiWait|Add|Starts waiting for a handle.
+// @comm A handle which is already signalled is reported by the next <om PyMultiWait.Wait>.
+static PyObject *mw_Add(PyObject *self, PyObject *args)
+{
+	PyMultiWait *mw = (PyMultiWait *)self;
+	PyObject *obHandle, *obCookie = Py_None;
+	if (!PyArg_ParseTuple(args, "O|O:Add",
+		&obHandle, // @pyparm <o PyHANDLE>|handle||The handle to wait for.  It must not already be in the set.
+		&obCookie)) // @pyparm object|cookie|None|The object which <om PyMultiWait.Wait> returns for the handle.  If None, the handle object is returned.
+		return NULL;
+	if (mw->bClosed)
+		return PyErr_Format(PyExc_ValueError, "The multi-wait has been closed");
+	HANDLE h;
+	if (!PyWinObject_AsHANDLE(obHandle, &h))
+		return NULL;
+	if (!mw_reserve(mw))
+		return PyErr_NoMemory();
+	ULONG slot = mw_find(mw, h);
+	if (mw->table[slot])
+		return PyErr_Format(PyExc_ValueError, "The handle is already being waited for");
+	PyMultiWaitEntry *e = (PyMultiWaitEntry *)malloc(sizeof(PyMultiWaitEntry));
+	if (e == NULL)
+		return PyErr_NoMemory();
+	memset(e, 0, sizeof(PyMultiWaitEntry));
+	e->mw = mw;
+	e->h = h;
+	e->obHandle = obHandle;
+	Py_INCREF(obHandle);
+	e->obCookie = obCookie == Py_None ? obHandle : obCookie;
+	Py_INCREF(e->obCookie);
+	// The entry is in the table before the wait is registered, as the callback may run at once.
+	mw->table[slot] = e;
+	mw->numEntries++;
+	if (!RegisterWaitForSingleObject(&e->hWait, h, mw_signalled, e, INFINITE, WT_EXECUTEONLYONCE | WT_EXECUTEINWAITTHREAD)) {
+		PyWin_SetAPIError("RegisterWaitForSingleObject");
+		e->hWait = NULL;
+		mw_unlink(mw, slot);
+		mw_free_entries(mw, &e, 1);
+		return NULL;
+	}
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+// @pymethod bool|PyMultiWait|Remove|Stops waiting for a handle.
+// @rdesc True if the handle was being waited for, or had been signalled and not yet returned by
+// <om PyMultiWait.Wait>.  False if the handle is not in the set.
+static PyObject *mw_Remove(PyObject *self, PyObject *args)
+{
+	PyMultiWait *mw = (PyMultiWait *)self;
+	PyObject *obHandle;
+	if (!PyArg_ParseTuple(args, "O:Remove",
+		&obHandle)) // @pyparm <o PyHANDLE>|handle||The handle to stop waiting for.
+		return NULL;
+	HANDLE h;
+	if (!PyWinObject_AsHANDLE(obHandle, &h))
+		return NULL;
+	if (mw->tableSize == 0)
+		return PyBool_FromLong(FALSE);
+	ULONG slot = mw_find(mw, h);
+	PyMultiWaitEntry *e = mw->table[slot];
+	if (e == NULL)
+		return PyBool_FromLong(FALSE);
+	mw_unlink(mw, slot);
+	EnterCriticalSection(&mw->cs);
+	if (e->bSignalled) {
+		for (ULONG i=0;i<mw->numPending;i++) {
+			if (mw->pending[i] == e) {
+				memmove(mw->pending + i, mw->pending + i + 1, (mw->numPending - i - 1) * sizeof(PyMultiWaitEntry *));
+				mw->numPending--;
+				break;
+			}
+		}
+	}
+	LeaveCriticalSection(&mw->cs);
+	mw_free_entries(mw, &e, 1);
+	return PyBool_FromLong(TRUE);
+}
+
+// @pymethod [object, ...]|PyMultiWait|Wait|Waits until at least one handle is signalled.
+// @rdesc The cookies of all the handles signalled since the last call, in the order
+// they were signalled, or an empty list if the timeout expires.  The handles are no longer in the set.
+// @comm Raises ValueError if the object is closed, including by another thread while waiting.
+static PyObject *mw_Wait(PyObject *self, PyObject *args)
+{
+	PyMultiWait *mw = (PyMultiWait *)self;
+	DWORD timeout = INFINITE;
+	if (!PyArg_ParseTuple(args, "|k:Wait",
+		&timeout)) // @pyparm int|milliseconds|win32event.INFINITE|The time-out interval.
+		return NULL;
+	DWORD start = GetTickCount();
+	for (;;) {
+		if (mw->bClosed)
+			return PyErr_Format(PyExc_ValueError, "The multi-wait has been closed");
+		EnterCriticalSection(&mw->cs);
+		ULONG num = mw->numPending;
+		PyMultiWaitEntry **entries = NULL;
+		if (num) {
+			entries = (PyMultiWaitEntry **)malloc(num * sizeof(PyMultiWaitEntry *));
+			if (entries) {
+				memcpy(entries, mw->pending, num * sizeof(PyMultiWaitEntry *));
+				mw->numPending = 0;
+			}
+		}
+		LeaveCriticalSection(&mw->cs);
+		if (num) {
+			if (entries == NULL)
+				return PyErr_NoMemory();
+			PyObject *ret = PyList_New(num);
+			for (ULONG i=0;i<num;i++) {
+				mw_unlink(mw, mw_find(mw, entries[i]->h));
+				if (ret) {
+					PyList_SET_ITEM(ret, i, entries[i]->obCookie);
+					entries[i]->obCookie = NULL;
+				}
+			}
+			mw->batches++;
+			mw_free_entries(mw, entries, num);
+			free(entries);
+			return ret;
+		}
+		DWORD wait = INFINITE;
+		if (timeout != INFINITE) {
+			DWORD elapsed = GetTickCount() - start;
+			if (elapsed >= timeout)
+				return PyList_New(0);
+			wait = timeout - elapsed;
+		}
+		HANDLE handles[2] = {mw->hReady, mw->hStop};
+		DWORD rc;
+		Py_BEGIN_ALLOW_THREADS
+		rc = WaitForMultipleObjects(2, handles, FALSE, wait);
+		Py_END_ALLOW_THREADS
+		if (rc == WAIT_FAILED)
+			return PyWin_SetAPIError("WaitForMultipleObjects");
+	}
+}
+
+// @pymethod |PyMultiWait|Close|Stops waiting for all handles, and releases them.
+static PyObject *mw_Close(PyObject *self, PyObject *args)
+{
+	if (!PyArg_ParseTuple(args, ":Close"))
+		return NULL;
+	mw_close((PyMultiWait *)self);
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+static Py_ssize_t mw_length(PyObject *self)
+{
+	return ((PyMultiWait *)self)->numEntries;
+}
+
+static PySequenceMethods mw_sequence = {
+	mw_length,	/* sq_length */
+};
+
+static PyMethodDef mw_methods[] = {
+	{"Add", mw_Add, METH_VARARGS}, // @pymeth Add|Starts waiting for a handle.
+	{"Remove", mw_Remove, METH_VARARGS}, // @pymeth Remove|Stops waiting for a handle.
+	{"Wait", mw_Wait, METH_VARARGS}, // @pymeth Wait|Waits until at least one handle is signalled.
+	{"Close", mw_Close, METH_VARARGS}, // @pymeth Close|Stops waiting for all handles.
+	{NULL}
+};
+
+#undef OFF
+#define OFF(e) offsetof(PyMultiWait, e)
+static PyMemberDef mw_members[] = {
+	{"signalled", T_LONG, OFF(signalled), READONLY}, // @prop int|signalled|The number of handles which have been signalled.
+	{"batches", T_LONG, OFF(batches), READONLY}, // @prop int|batches|The number of non-empty lists returned by <om PyMultiWait.Wait>.
+	{NULL}
+};
+#undef OFF
+
+PyTypeObject PyMultiWait_Type = {
+	PYWIN_OBJECT_HEAD
+	"PyMultiWait",				/* tp_name */
+	sizeof(PyMultiWait),			/* tp_basicsize */
+	0,					/* tp_itemsize */
+	mw_dealloc,				/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	&mw_sequence,				/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	0,					/* tp_iter */
+	0,					/* tp_iternext */
+	mw_methods,				/* tp_methods */
+	mw_members,				/* tp_members */
+	0,					/* tp_getset */
+};
+
+// @pyswig <o PyMultiWait>|CreateMultiWait|Creates an object which waits for any number of handles.
+static PyObject *MyCreateMultiWait(PyObject *self, PyObject *args)
+{
+	PyObject *obHandles = Py_None;
+	if (!PyArg_ParseTuple(args, "|O:CreateMultiWait",
+		&obHandles)) // @pyparm [<o PyHANDLE>, ...]|handles|None|Handles to add to the set.
+		return NULL;
+	PyMultiWait *mw = PyObject_New(PyMultiWait, &PyMultiWait_Type);
+	if (mw == NULL)
+		return NULL;
+	memset(((BYTE *)mw) + sizeof(PyObject), 0, sizeof(PyMultiWait) - sizeof(PyObject));
+	InitializeCriticalSection(&mw->cs);
+	mw->hReady = CreateEvent(NULL, FALSE, FALSE, NULL);
+	mw->hStop = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if (mw->hReady == NULL || mw->hStop == NULL) {
+		PyWin_SetAPIError("CreateEvent");
+		Py_DECREF(mw);
+		return NULL;
+	}
+	if (obHandles != Py_None) {
+		TmpPyObject seq = PyWinSequence_Tuple(obHandles, NULL);
+		if (seq == NULL) {
+			Py_DECREF(mw);
+			return NULL;
+		}
+		for (Py_ssize_t i=0;i<PyTuple_GET_SIZE((PyObject *)seq);i++) {
+			PyObject *addArgs = Py_BuildValue("(O)", PyTuple_GET_ITEM((PyObject *)seq, i));
+			PyObject *ret = addArgs ? mw_Add((PyObject *)mw, addArgs) : NULL;
+			Py_XDECREF(addArgs);
+			if (ret == NULL) {
+				Py_DECREF(mw);
+				return NULL;
+			}
+			Py_DECREF(ret);
+		}
+	}
+	return (PyObject *)mw;
+}
+%}
+%native(CreateMultiWait) MyCreateMultiWait;
+#endif /* MS_WINCE */
+
+%{
+#if (PY_VERSION_HEX >= 0x03070000)
+// METH_FASTCALL versions of the wrappers called most often in tight loops.  The SWIG
+// generated ones build an argument tuple and parse it with a format string, which
+// costs more than the call itself.  The module init replaces the SWIG functions with these.
+static BOOL PyFastCheckArgs(const char *fname, Py_ssize_t nargs, Py_ssize_t expected)
+{
+	if (nargs == expected)
+		return TRUE;
+	PyErr_Format(PyExc_TypeError, "%s() takes exactly %zd argument%s (%zd given)",
+		fname, expected, expected == 1 ? "" : "s", nargs);
+	return FALSE;
+}
+
+static PyObject *PyFastHandleCall(PyObject *const *args, Py_ssize_t nargs, char *fname, BOOL (WINAPI *fn)(HANDLE))
+{
+	HANDLE h;
+	if (!PyFastCheckArgs(fname, nargs, 1) || !PyWinObject_AsHANDLE(args[0], &h))
+		return NULL;
+	// None of these block, so the lock isn't released - as for the SWIG versions.
+	if (!(*fn)(h))
+		return PyWin_SetAPIError(fname);
+	Py_RETURN_NONE;
+}
+
+static PyObject *PyFastSetEvent(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+	return PyFastHandleCall(args, nargs, "SetEvent", SetEvent);
+}
+
+static PyObject *PyFastResetEvent(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+	return PyFastHandleCall(args, nargs, "ResetEvent", ResetEvent);
+}
+
+static PyObject *PyFastPulseEvent(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+	return PyFastHandleCall(args, nargs, "PulseEvent", PulseEvent);
+}
+
+static PyObject *PyFastReleaseMutex(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+	return PyFastHandleCall(args, nargs, "ReleaseMutex", ReleaseMutex);
+}
+
+static PyObject *PyFastWaitForSingleObject(PyObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+	HANDLE h;
+	if (!PyFastCheckArgs("WaitForSingleObject", nargs, 2) || !PyWinObject_AsHANDLE(args[0], &h))
+		return NULL;
+	DWORD timeout = PyLong_AsUnsignedLongMask(args[1]);
+	if (timeout == (DWORD)-1 && PyErr_Occurred())
+		return NULL;
+	DWORD rc;
+	// A zero timeout only polls the handle, which isn't worth releasing the lock for.
+	if (timeout == 0)
+		rc = WaitForSingleObject(h, 0);
+	else {
+		Py_BEGIN_ALLOW_THREADS
+		rc = WaitForSingleObject(h, timeout);
+		Py_END_ALLOW_THREADS
+		}
+	if (rc == WAIT_FAILED)
+		return PyWin_SetAPIError("WaitForSingleObject");
+	return PyLong_FromUnsignedLong(rc);
+}
+
+static PyMethodDef win32eventFastMethods[] = {
+	{"PulseEvent", (PyCFunction)PyFastPulseEvent, METH_FASTCALL},
+	{"ReleaseMutex", (PyCFunction)PyFastReleaseMutex, METH_FASTCALL},
+	{"ResetEvent", (PyCFunction)PyFastResetEvent, METH_FASTCALL},
+	{"SetEvent", (PyCFunction)PyFastSetEvent, METH_FASTCALL},
+	{"WaitForSingleObject", (PyCFunction)PyFastWaitForSingleObject, METH_FASTCALL},
+	{NULL, NULL}
+};
+#endif // PY_VERSION_HEX >= 0x03070000
+%}
+
+%init %{
+#ifndef MS_WINCE
+	if (PyType_Ready(&PyMultiWait_Type) == -1)
+		PYWIN_MODULE_INIT_RETURN_ERROR;
+#endif
+#if (PY_VERSION_HEX >= 0x03070000)
+	// Function objects pick their calling convention when created, so the
+	// SWIG ones are replaced rather than having their flags changed.
+	{
+	PyObject *modname = PyUnicode_FromString("win32event");
+	if (modname == NULL)
+		PYWIN_MODULE_INIT_RETURN_ERROR;
+	for (PyMethodDef *pmd = win32eventFastMethods; pmd->ml_name; pmd++){
+		PyObject *func = PyCFunction_NewEx(pmd, NULL, modname);
+		if (func == NULL || PyDict_SetItemString(d, pmd->ml_name, func) == -1){
+			Py_XDECREF(func);
+			Py_DECREF(modname);
+			PYWIN_MODULE_INIT_RETURN_ERROR;
+			}
+		Py_DECREF(func);
+		}
+	Py_DECREF(modname);
+	}
+#endif
+%}
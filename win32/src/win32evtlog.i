@@ -102,6 +102,67 @@ typedef HANDLE PyEVTLOG_HANDLE;
 
 %{
 
+// Builds the python object for one of the fields of PyEventLogRecord
+enum {
+	ELR_RESERVED, ELR_RECORDNUMBER, ELR_TIMEGENERATED, ELR_TIMEWRITTEN, ELR_EVENTID,
+	ELR_EVENTTYPE, ELR_EVENTCATEGORY, ELR_RESERVEDFLAGS, ELR_CLOSINGRECORDNUMBER,
+	ELR_SOURCENAME, ELR_STRINGINSERTS, ELR_SID, ELR_DATA, ELR_COMPUTERNAME
+};
+
+static PyObject *EventLogRecordField(EVENTLOGRECORD *pEvt, int field)
+{
+	WCHAR *szSourceName = (WCHAR *)(((BYTE *)pEvt) + sizeof(EVENTLOGRECORD));
+	switch (field){
+		case ELR_RESERVED:
+			return PyLong_FromUnsignedLong(pEvt->Reserved);
+		case ELR_RECORDNUMBER:
+			return PyLong_FromUnsignedLong(pEvt->RecordNumber);
+		case ELR_TIMEGENERATED:
+			return PyWinTimeObject_Fromtime_t((time_t)pEvt->TimeGenerated);
+		case ELR_TIMEWRITTEN:
+			return PyWinTimeObject_Fromtime_t((time_t)pEvt->TimeWritten);
+		case ELR_EVENTID:
+			return PyLong_FromUnsignedLong(pEvt->EventID);
+		case ELR_EVENTTYPE:
+			return PyLong_FromLong(pEvt->EventType);
+		case ELR_EVENTCATEGORY:
+			return PyLong_FromLong(pEvt->EventCategory);
+		case ELR_RESERVEDFLAGS:
+			return PyLong_FromLong(pEvt->ReservedFlags);
+		case ELR_CLOSINGRECORDNUMBER:
+			return PyLong_FromUnsignedLong(pEvt->ClosingRecordNumber);
+		case ELR_SOURCENAME:
+			return PyWinObject_FromWCHAR(szSourceName);
+		case ELR_COMPUTERNAME:
+			return PyWinObject_FromWCHAR(szSourceName + wcslen(szSourceName) + 1);
+		case ELR_STRINGINSERTS:{
+			if (pEvt->NumStrings==0){
+				Py_INCREF(Py_None);
+				return Py_None;
+				}
+			PyObject *ret = PyTuple_New(pEvt->NumStrings);
+			if (ret) {
+				WCHAR *stringOffset = (WCHAR *) (((BYTE *)pEvt) + pEvt->StringOffset);
+				for (DWORD stringNo = 0;stringNo<pEvt->NumStrings;stringNo++) {
+					PyTuple_SET_ITEM(ret, (int)stringNo, PyWinObject_FromWCHAR(stringOffset));
+					stringOffset = stringOffset + (wcslen(stringOffset)) + 1;
+				}
+			}
+			return ret;
+			}
+		case ELR_SID:
+			if (pEvt->UserSidLength==0){
+				Py_INCREF(Py_None); // No SID in this record.
+				return Py_None;
+				}
+			return PyWinObject_FromSID( (PSID)(((BYTE *)pEvt) + pEvt->UserSidOffset));
+		case ELR_DATA:
+			return PyString_FromStringAndSize(((char *)pEvt)+pEvt->DataOffset, pEvt->DataLength);
+		}
+	PyErr_SetString(PyExc_SystemError, "Unknown event log record field");
+	return NULL;
+}
+
 // @object PyEventLogRecord|An object containing the data in an EVENTLOGRECORD.
 class PyEventLogRecord : public PyObject
 {
@@ -218,36 +279,13 @@ PyEventLogRecord::PyEventLogRecord(EVENTLOGRECORD *pEvt)
 	ReservedFlags = pEvt->ReservedFlags;
 	ClosingRecordNumber = pEvt->ClosingRecordNumber;
 
-	if (pEvt->NumStrings==0) {
-		StringInserts = Py_None;
-		Py_INCREF(Py_None);
-	} else {
-		StringInserts = PyTuple_New(pEvt->NumStrings);
-		if (StringInserts) {
-			WCHAR *stringOffset = (WCHAR *) (((BYTE *)pEvt) + pEvt->StringOffset);
-			for (DWORD stringNo = 0;stringNo<pEvt->NumStrings;stringNo++) {
-				PyTuple_SET_ITEM( StringInserts, (int)stringNo, PyWinObject_FromWCHAR(stringOffset));
-				stringOffset = stringOffset + (wcslen(stringOffset)) + 1;
-			}
-		}
-	}
-
-	TimeGenerated = PyWinTimeObject_Fromtime_t((time_t)pEvt->TimeGenerated);
-	TimeWritten = PyWinTimeObject_Fromtime_t((time_t)pEvt->TimeWritten);
-
-	if (pEvt->UserSidLength==0) {
-		Sids = Py_None; // No SID in this record.
-		Py_INCREF(Sids);
-	} else {
-		Sids = PyWinObject_FromSID( (PSID)(((BYTE *)pEvt) + pEvt->UserSidOffset));
-	}
-
-	Data = PyString_FromStringAndSize(((char *)pEvt)+pEvt->DataOffset, pEvt->DataLength);
-
-	WCHAR *szSourceName = (WCHAR *)(((BYTE *)pEvt) + sizeof(EVENTLOGRECORD));
-	SourceName = PyWinObject_FromWCHAR(szSourceName);
-
-	ComputerName = PyWinObject_FromWCHAR(szSourceName + wcslen(szSourceName) + 1);
+	StringInserts = EventLogRecordField(pEvt, ELR_STRINGINSERTS);
+	TimeGenerated = EventLogRecordField(pEvt, ELR_TIMEGENERATED);
+	TimeWritten = EventLogRecordField(pEvt, ELR_TIMEWRITTEN);
+	Sids = EventLogRecordField(pEvt, ELR_SID);
+	Data = EventLogRecordField(pEvt, ELR_DATA);
+	SourceName = EventLogRecordField(pEvt, ELR_SOURCENAME);
+	ComputerName = EventLogRecordField(pEvt, ELR_COMPUTERNAME);
 }
 
 PyEventLogRecord::~PyEventLogRecord(void)
@@ -344,6 +382,345 @@ PyObject *MyReadEventLog(PyObject *self, PyObject *args) {
     return _MyReadEventLog(hEventLog, dwReadFlags, dwRecordOffset, nNumberOfBytesToRead);
 }
 
+// Buffer shared between an event log reader and the record views read into it.  It is only
+// reused for the next read once no view refers to it any longer.
+typedef struct {
+	LONG refs;
+	DWORD size;
+	BYTE data[1];
+} EventLogBuffer;
+
+static void EventLogBufferRelease(EventLogBuffer *b)
+{
+	if (b && --b->refs == 0)
+		free(b);
+}
+
+// @object PyEventLogRecordView|An event log record read by <o PyEventLogReader>.
+// @comm Has the same attributes as <o PyEventLogRecord>, but each one is only decoded from the
+//	record when it is accessed.  The view keeps the buffer it was read into alive.
+typedef struct {
+	PyObject_HEAD
+	EventLogBuffer *buffer;
+	EVENTLOGRECORD *record;
+} PyEventLogRecordView;
+
+static void PyEventLogRecordView_dealloc(PyObject *self)
+{
+	EventLogBufferRelease(((PyEventLogRecordView *)self)->buffer);
+	PyObject_Del(self);
+}
+
+static PyObject *PyEventLogRecordView_get(PyObject *self, void *closure)
+{
+	return EventLogRecordField(((PyEventLogRecordView *)self)->record, (int)(INT_PTR)closure);
+}
+
+static PyGetSetDef PyEventLogRecordView_getset[] = {
+	{"Reserved", PyEventLogRecordView_get, NULL, NULL, (void *)ELR_RESERVED},	// @prop integer|Reserved|
+	{"RecordNumber", PyEventLogRecordView_get, NULL, NULL, (void *)ELR_RECORDNUMBER},	// @prop integer|RecordNumber|
+	{"TimeGenerated", PyEventLogRecordView_get, NULL, NULL, (void *)ELR_TIMEGENERATED},	// @prop <o PyDateTime>|TimeGenerated|
+	{"TimeWritten", PyEventLogRecordView_get, NULL, NULL, (void *)ELR_TIMEWRITTEN},	// @prop <o PyDateTime>|TimeWritten|
+	{"EventID", PyEventLogRecordView_get, NULL, NULL, (void *)ELR_EVENTID},	// @prop integer|EventID|
+	{"EventType", PyEventLogRecordView_get, NULL, NULL, (void *)ELR_EVENTTYPE},	// @prop integer|EventType|
+	{"EventCategory", PyEventLogRecordView_get, NULL, NULL, (void *)ELR_EVENTCATEGORY},	// @prop integer|EventCategory|
+	{"ReservedFlags", PyEventLogRecordView_get, NULL, NULL, (void *)ELR_RESERVEDFLAGS},	// @prop integer|ReservedFlags|
+	{"ClosingRecordNumber", PyEventLogRecordView_get, NULL, NULL, (void *)ELR_CLOSINGRECORDNUMBER},	// @prop integer|ClosingRecordNumber|
+	{"SourceName", PyEventLogRecordView_get, NULL, NULL, (void *)ELR_SOURCENAME},	// @prop <o PyUnicode>|SourceName|
+	{"StringInserts", PyEventLogRecordView_get, NULL, NULL, (void *)ELR_STRINGINSERTS},	// @prop (<o PyUnicode>,...)|StringInserts|
+	{"Sid", PyEventLogRecordView_get, NULL, NULL, (void *)ELR_SID},	// @prop <o PySID>|Sid|
+	{"Data", PyEventLogRecordView_get, NULL, NULL, (void *)ELR_DATA},	// @prop string|Data|
+	{"ComputerName", PyEventLogRecordView_get, NULL, NULL, (void *)ELR_COMPUTERNAME},	// @prop <o PyUnicode>|ComputerName|
+	{NULL}
+};
+
+PyTypeObject PyEventLogRecordViewType =
+{
+	PYWIN_OBJECT_HEAD
+	"PyEventLogRecordView",
+	sizeof(PyEventLogRecordView),
+	0,
+	PyEventLogRecordView_dealloc,	/* tp_dealloc */
+	0,						/* tp_print */
+	0,						/* tp_getattr */
+	0,						/* tp_setattr */
+	0,						/* tp_compare */
+	0,						/* tp_repr */
+	0,						/* tp_as_number */
+	0,						/* tp_as_sequence */
+	0,						/* tp_as_mapping */
+	0,						/* tp_hash */
+	0,						/* tp_call */
+	0,						/* tp_str */
+	PyObject_GenericGetAttr,	/* tp_getattro */
+	0,						/* tp_setattro */
+	0,						/*tp_as_buffer*/
+	Py_TPFLAGS_DEFAULT,		/* tp_flags */
+	0,						/* tp_doc */
+	0,						/* tp_traverse */
+	0,						/* tp_clear */
+	0,						/* tp_richcompare */
+	0,						/* tp_weaklistoffset */
+	0,						/* tp_iter */
+	0,						/* tp_iternext */
+	0,						/* tp_methods */
+	0,						/* tp_members */
+	PyEventLogRecordView_getset,	/* tp_getset */
+};
+
+// @object PyEventLogReader|Reads records from a legacy event log into a buffer kept between
+//	reads.  Created by <om win32evtlog.CreateEventLogReader>.
+typedef struct {
+	PyObject_HEAD
+	PyObject *obhandle;		// keeps the event log handle open
+	HANDLE hEventLog;
+	EventLogBuffer *buffer;
+	DWORD buffer_size;
+	DWORD *event_ids;		// sorted, NULL for all events
+	DWORD num_event_ids;
+	WCHAR **sources;		// NULL for all sources
+	DWORD num_sources;
+	LONGLONG skipped;
+} PyEventLogReader;
+
+static void PyEventLogReader_dealloc(PyObject *self)
+{
+	PyEventLogReader *r = (PyEventLogReader *)self;
+	EventLogBufferRelease(r->buffer);
+	free(r->event_ids);
+	for (DWORD i=0; i<r->num_sources; i++)
+		PyWinObject_FreeWCHAR(r->sources[i]);
+	free(r->sources);
+	Py_XDECREF(r->obhandle);
+	PyObject_Del(self);
+}
+
+static int compare_event_ids(const void *a, const void *b)
+{
+	DWORD l = *(const DWORD *)a, r = *(const DWORD *)b;
+	return l < r ? -1 : l > r;
+}
+
+static BOOL EventLogReaderWants(PyEventLogReader *r, EVENTLOGRECORD *pEvt)
+{
+	if (r->event_ids){
+		// Matched against the low word, which is the ID shown by the Event Viewer
+		DWORD id = pEvt->EventID & 0xFFFF;
+		if (!bsearch(&id, r->event_ids, r->num_event_ids, sizeof(DWORD), compare_event_ids))
+			return FALSE;
+		}
+	if (r->sources){
+		WCHAR *szSourceName = (WCHAR *)(((BYTE *)pEvt) + sizeof(EVENTLOGRECORD));
+		for (DWORD i=0; i<r->num_sources; i++)
+			if (_wcsicmp(szSourceName, r->sources[i])==0)
+				return TRUE;
+		return FALSE;
+		}
+	return TRUE;
+}
+
+// @pymethod [<o PyEventLogRecordView>,...]|PyEventLogReader|Read|Reads the next records
+// @rdesc Returns the records which pass the reader's filters.  Reads continue past
+//	buffers in which every record was filtered out, so an empty list means there are
+//	no more records.
+static PyObject *PyEventLogReader_Read(PyObject *self, PyObject *args)
+{
+	PyEventLogReader *r = (PyEventLogReader *)self;
+	DWORD flags, offset = 0;
+	if (!PyArg_ParseTuple(args, "k|k:Read",
+		&flags,		// @pyparm int|Flags||Reading flags, as for <om win32evtlog.ReadEventLog>
+		&offset))	// @pyparm int|Offset|0|Record offset to read (in SEEK mode).
+		return NULL;
+	PyObject *ret = PyList_New(0);
+	if (ret==NULL)
+		return NULL;
+	while (PyList_GET_SIZE(ret)==0){
+		// The buffer can only be read into again once no view refers to it.
+		if (r->buffer==NULL || r->buffer->refs > 1 || r->buffer->size < r->buffer_size){
+			EventLogBufferRelease(r->buffer);
+			r->buffer = (EventLogBuffer *)malloc(offsetof(EventLogBuffer, data) + r->buffer_size);
+			if (r->buffer==NULL){
+				Py_DECREF(ret);
+				return PyErr_NoMemory();
+				}
+			r->buffer->refs = 1;
+			r->buffer->size = r->buffer_size;
+			}
+		DWORD read = 0, needed = 0;
+		BOOL ok;
+		Py_BEGIN_ALLOW_THREADS
+		ok = ReadEventLogW(r->hEventLog, flags, offset, r->buffer->data, r->buffer->size, &read, &needed);
+		Py_END_ALLOW_THREADS
+		if (!ok){
+			DWORD err = GetLastError();
+			if (err==ERROR_HANDLE_EOF)
+				break;
+			if (err==ERROR_INSUFFICIENT_BUFFER){
+				// A single record larger than the buffer
+				r->buffer_size = needed;
+				continue;
+				}
+			Py_DECREF(ret);
+			return PyWin_SetAPIError("ReadEventLog", err);
+			}
+		if (read==0)
+			break;
+		BYTE *buf = r->buffer->data;
+		EVENTLOGRECORD *pEvt = NULL;
+		while (read>0){
+			pEvt = (EVENTLOGRECORD *)buf;
+			if (EventLogReaderWants(r, pEvt)){
+				PyEventLogRecordView *view = PyObject_New(PyEventLogRecordView, &PyEventLogRecordViewType);
+				if (view==NULL){
+					Py_DECREF(ret);
+					return NULL;
+					}
+				view->buffer = r->buffer;
+				view->record = pEvt;
+				r->buffer->refs++;
+				int rc = PyList_Append(ret, (PyObject *)view);
+				Py_DECREF(view);
+				if (rc==-1){
+					Py_DECREF(ret);
+					return NULL;
+					}
+				}
+			else
+				r->skipped++;
+			buf += pEvt->Length;
+			read -= pEvt->Length;
+			}
+		if (flags & EVENTLOG_SEEK_READ){
+			// Carry on sequentially from the record after the last one read
+			offset = (flags & EVENTLOG_BACKWARDS_READ) ? pEvt->RecordNumber - 1 : pEvt->RecordNumber + 1;
+			if (offset==0)
+				break;
+			}
+		}
+	return ret;
+}
+
+PyMethodDef PyEventLogReader_methods[] = {
+	{"Read", PyEventLogReader_Read, METH_VARARGS},	// @pymeth Read|Reads the next records
+	{NULL}
+};
+
+#undef OFF
+#define OFF(e) offsetof(PyEventLogReader, e)
+PyMemberDef PyEventLogReader_members[] = {
+	{"skipped", T_LONGLONG, OFF(skipped), READONLY},	// @prop int|skipped|Number of records rejected by the filters
+	{"BufferSize", T_ULONG, OFF(buffer_size), READONLY},	// @prop int|BufferSize|Size of the read buffer
+	{NULL}
+};
+
+PyTypeObject PyEventLogReaderType =
+{
+	PYWIN_OBJECT_HEAD
+	"PyEventLogReader",
+	sizeof(PyEventLogReader),
+	0,
+	PyEventLogReader_dealloc,	/* tp_dealloc */
+	0,						/* tp_print */
+	0,						/* tp_getattr */
+	0,						/* tp_setattr */
+	0,						/* tp_compare */
+	0,						/* tp_repr */
+	0,						/* tp_as_number */
+	0,						/* tp_as_sequence */
+	0,						/* tp_as_mapping */
+	0,						/* tp_hash */
+	0,						/* tp_call */
+	0,						/* tp_str */
+	PyObject_GenericGetAttr,	/* tp_getattro */
+	0,						/* tp_setattro */
+	0,						/*tp_as_buffer*/
+	Py_TPFLAGS_DEFAULT,		/* tp_flags */
+	0,						/* tp_doc */
+	0,						/* tp_traverse */
+	0,						/* tp_clear */
+	0,						/* tp_richcompare */
+	0,						/* tp_weaklistoffset */
+	0,						/* tp_iter */
+	0,						/* tp_iternext */
+	PyEventLogReader_methods,	/* tp_methods */
+	PyEventLogReader_members,	/* tp_members */
+};
+
+// @pyswig <o PyEventLogReader>|CreateEventLogReader|Creates a reader that decodes event log records lazily
+// @comm Accepts keyword args
+// @comm Unlike <om win32evtlog.ReadEventLog>, records are returned as <o PyEventLogRecordView>
+//	objects, which decode their fields only when accessed, and records rejected by the
+//	filters never become Python objects at all.
+PyObject *PyCreateEventLogReader(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[]={"Handle", "BufferSize", "EventIDs", "Sources", NULL};
+	PyObject *obhandle, *obids=Py_None, *obsources=Py_None;
+	HANDLE hEventLog;
+	DWORD buffer_size = EVTLOG_READ_BUF_LEN_MAX;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|kOO:CreateEventLogReader", keywords,
+		&obhandle,		// @pyparm <o PyEVTLOG_HANDLE>|Handle||Handle to an opened event log (see <om win32evtlog.OpenEventLog>)
+		&buffer_size,	// @pyparm int|BufferSize|0x7ffff|Size of the read buffer
+		&obids,			// @pyparm [int,...]|EventIDs|None|Only return records with one of these event IDs (the low 16 bits of EventID)
+		&obsources))	// @pyparm [str,...]|Sources|None|Only return records from one of these sources, compared case-insensitively
+		return NULL;
+	if (!PyWinObject_AsHANDLE(obhandle, &hEventLog))
+		return NULL;
+	if (buffer_size == 0)
+		buffer_size = EVTLOG_READ_BUF_LEN_DEFAULT;
+	if (buffer_size > EVTLOG_READ_BUF_LEN_MAX)
+		buffer_size = EVTLOG_READ_BUF_LEN_MAX;
+	PyEventLogReader *r = PyObject_New(PyEventLogReader, &PyEventLogReaderType);
+	if (r==NULL)
+		return NULL;
+	memset((char *)r + sizeof(PyObject), 0, sizeof(PyEventLogReader) - sizeof(PyObject));
+	Py_INCREF(obhandle);
+	r->obhandle = obhandle;
+	r->hEventLog = hEventLog;
+	r->buffer_size = buffer_size;
+	if (obids != Py_None){
+		TmpPyObject ids = PySequence_Fast(obids, "EventIDs must be a sequence of ints");
+		if (ids==NULL){
+			Py_DECREF(r);
+			return NULL;
+			}
+		DWORD n = (DWORD)PySequence_Fast_GET_SIZE((PyObject *)ids);
+		r->event_ids = (DWORD *)malloc(max(n, 1) * sizeof(DWORD));
+		if (r->event_ids==NULL){
+			Py_DECREF(r);
+			return PyErr_NoMemory();
+			}
+		for (r->num_event_ids=0; r->num_event_ids<n; r->num_event_ids++){
+			DWORD id = PyLong_AsUnsignedLong(PySequence_Fast_GET_ITEM((PyObject *)ids, r->num_event_ids));
+			if (id==(DWORD)-1 && PyErr_Occurred()){
+				Py_DECREF(r);
+				return NULL;
+				}
+			r->event_ids[r->num_event_ids] = id & 0xFFFF;
+			}
+		qsort(r->event_ids, n, sizeof(DWORD), compare_event_ids);
+		}
+	if (obsources != Py_None){
+		TmpPyObject sources = PySequence_Fast(obsources, "Sources must be a sequence of strings");
+		if (sources==NULL){
+			Py_DECREF(r);
+			return NULL;
+			}
+		DWORD n = (DWORD)PySequence_Fast_GET_SIZE((PyObject *)sources);
+		r->sources = (WCHAR **)malloc(max(n, 1) * sizeof(WCHAR *));
+		if (r->sources==NULL){
+			Py_DECREF(r);
+			return PyErr_NoMemory();
+			}
+		for (r->num_sources=0; r->num_sources<n; r->num_sources++)
+			if (!PyWinObject_AsWCHAR(PySequence_Fast_GET_ITEM((PyObject *)sources, r->num_sources), &r->sources[r->num_sources], FALSE)){
+				Py_DECREF(r);
+				return NULL;
+				}
+		}
+	return (PyObject *)r;
+}
+PyCFunction pfnPyCreateEventLogReader = (PyCFunction) PyCreateEventLogReader;
+
 PyObject * MyReportEvent( HANDLE hEventLog,
     WORD wType,	// event type to log
     WORD wCategory,	// event category
@@ -475,6 +852,7 @@ RegisterEventSourceW (
     );
 
 %native (ReadEventLog) MyReadEventLog;
+%native (CreateEventLogReader) pfnPyCreateEventLogReader;
 
 // @pyswig |ReportEvent|Reports an event
 %name (ReportEvent) PyObject *MyReportEvent (
@@ -614,6 +992,527 @@ static PyObject *PyEvtFormatMessage(PyObject *self, PyObject *args, PyObject *kw
 }
 PyCFunction pfnPyEvtFormatMessage = (PyCFunction) PyEvtFormatMessage;
 
+// @object PyEvtMessageFormatter|Formats event messages, caching what can be reused between events.
+//	Created by <om win32evtlog.CreateEventMessageFormatter>.
+// @comm The provider of each event is read from its system properties, and the publisher metadata
+//	handle for it is kept in a least recently used cache, so <om win32evtlog.EvtOpenPublisherMetadata>
+//	is only called the first time a provider is seen.  A provider whose metadata can't be opened
+//	is remembered too, and its events are formatted with no metadata handle, which works for events
+//	forwarded with their RenderingInfo.
+//	<nl>The level, task, opcode, keyword, channel and provider strings only depend on the event's definition,
+//	so they are cached by provider, event id, version, qualifiers, level, task, opcode and keywords.  Event
+//	messages and XML depend on the event's values, and are formatted every time.
+//	<nl>Rendering and formatting use buffers which are kept for the next call rather than sized
+//	by a failed call for each event.
+// Publisher metadata handles cached by a PyEvtMessageFormatter
+typedef struct {
+	WCHAR *provider;	// NULL for an unused entry
+	ULONG hash;
+	EVT_HANDLE hMetadata;	// NULL if it could not be opened
+	ULONGLONG lastUse;
+	LONG refs;		// Calls using hMetadata with the GIL released
+} EvtPublisherEntry;
+
+// A formatted string which is the same for every instance of an event definition
+typedef struct EvtCachedString {
+	struct EvtCachedString *next;
+	ULONG hash;
+	DWORD flags;
+	WCHAR *provider;
+	USHORT id, qualifiers, task;
+	BYTE version, level, opcode;
+	ULONGLONG keywords;
+	PyObject *value;
+} EvtCachedString;
+
+// Buffers for EvtRender and EvtFormatMessage, reused by later calls
+typedef struct EvtFormatBuffers {
+	struct EvtFormatBuffers *next;
+	BYTE *render;
+	DWORD render_size;
+	WCHAR *text;
+	DWORD text_chars;
+} EvtFormatBuffers;
+
+typedef struct {
+	PyObject_HEAD
+	PyObject *obsession;
+	EVT_HANDLE session;
+	LCID locale;
+	EVT_HANDLE render_context;
+	EvtPublisherEntry *publishers;
+	DWORD max_publishers;
+	ULONGLONG clock;
+	EvtCachedString **buckets;
+	DWORD num_buckets, num_strings, max_strings;
+	EvtFormatBuffers *free_buffers;
+	// stats
+	long hits;
+	long misses;
+	long opened;
+	long evicted;
+	long grows;
+} PyEvtMessageFormatter;
+
+// Everything but the (GIL released) API calls is done with the GIL held, which
+// serializes access to the caches and the free buffer list.
+
+static ULONG EvtFormatterHash(const WCHAR *s)
+{
+	ULONG h = 2166136261UL;
+	for (; *s; s++)
+		h = (h ^ towlower(*s)) * 16777619UL;
+	return h;
+}
+
+static EvtFormatBuffers *EvtFormatterGetBuffers(PyEvtMessageFormatter *f)
+{
+	EvtFormatBuffers *b = f->free_buffers;
+	if (b){
+		f->free_buffers = b->next;
+		return b;
+		}
+	b = (EvtFormatBuffers *)calloc(1, sizeof(EvtFormatBuffers));
+	if (b){
+		b->render_size = 4096;
+		b->render = (BYTE *)malloc(b->render_size);
+		b->text_chars = 2048;
+		b->text = (WCHAR *)malloc(b->text_chars * sizeof(WCHAR));
+		if (b->render==NULL || b->text==NULL){
+			free(b->render);
+			free(b->text);
+			free(b);
+			b = NULL;
+			}
+		}
+	if (b==NULL)
+		PyErr_NoMemory();
+	return b;
+}
+
+static void EvtFormatterPutBuffers(PyEvtMessageFormatter *f, EvtFormatBuffers *b)
+{
+	b->next = f->free_buffers;
+	f->free_buffers = b;
+}
+
+// Grows a buffer - called without the GIL
+static BOOL EvtFormatterGrow(void **pbuf, DWORD *psize, DWORD needed, DWORD item_size, long *pgrows)
+{
+	void *p = realloc(*pbuf, needed * item_size);
+	if (p==NULL)
+		return FALSE;
+	*pbuf = p;
+	*psize = needed;
+	InterlockedIncrement(pgrows);
+	return TRUE;
+}
+
+// Renders the system properties of an event - called without the GIL
+static DWORD EvtFormatterRender(PyEvtMessageFormatter *f, EvtFormatBuffers *b, EVT_HANDLE event)
+{
+	for (;;){
+		DWORD needed = 0, count = 0;
+		if (EvtRender(f->render_context, event, EvtRenderEventValues, b->render_size, b->render, &needed, &count))
+			return 0;
+		DWORD err = GetLastError();
+		if (err != ERROR_INSUFFICIENT_BUFFER)
+			return err;
+		if (!EvtFormatterGrow((void **)&b->render, &b->render_size, needed, 1, &f->grows))
+			return ERROR_NOT_ENOUGH_MEMORY;
+		}
+}
+
+// Formats into b->text - called without the GIL
+static DWORD EvtFormatterFormat(PyEvtMessageFormatter *f, EvtFormatBuffers *b, EVT_HANDLE metadata, EVT_HANDLE event, DWORD flags)
+{
+	for (;;){
+		DWORD used = 0;
+		// One char is kept back to double terminate a keyword list
+		if (EvtFormatMessage(metadata, event, 0, 0, NULL, flags, b->text_chars - 1, b->text, &used)){
+			b->text[used] = L'\0';
+			return 0;
+			}
+		DWORD err = GetLastError();
+		if (err != ERROR_INSUFFICIENT_BUFFER)
+			return err;
+		if (!EvtFormatterGrow((void **)&b->text, &b->text_chars, used + 1, sizeof(WCHAR), &f->grows))
+			return ERROR_NOT_ENOUGH_MEMORY;
+		}
+}
+
+static EvtPublisherEntry *EvtFormatterFindPublisher(PyEvtMessageFormatter *f, const WCHAR *provider, ULONG hash)
+{
+	for (DWORD i=0; i<f->max_publishers; i++){
+		EvtPublisherEntry *e = f->publishers + i;
+		if (e->provider && e->hash == hash && _wcsicmp(e->provider, provider)==0)
+			return e;
+		}
+	return NULL;
+}
+
+// Returns an unused entry, evicting the least recently used one which no call is using.
+static EvtPublisherEntry *EvtFormatterFreePublisher(PyEvtMessageFormatter *f)
+{
+	EvtPublisherEntry *lru = NULL;
+	for (DWORD i=0; i<f->max_publishers; i++){
+		EvtPublisherEntry *e = f->publishers + i;
+		if (e->provider==NULL)
+			return e;
+		if (e->refs==0 && (lru==NULL || e->lastUse < lru->lastUse))
+			lru = e;
+		}
+	if (lru){
+		if (lru->hMetadata)
+			EvtClose(lru->hMetadata);
+		PyMem_Free(lru->provider);
+		memset(lru, 0, sizeof(*lru));
+		f->evicted++;
+		}
+	return lru;
+}
+
+// Returns the metadata handle for a provider, which may be NULL.  *pentry is the
+// cache entry to release, or NULL if the handle must be closed after use because
+// every cached handle is busy.  Returns FALSE with an exception set on failure.
+static BOOL EvtFormatterGetPublisher(PyEvtMessageFormatter *f, const WCHAR *provider, EVT_HANDLE *pmetadata, EvtPublisherEntry **pentry)
+{
+	ULONG hash = EvtFormatterHash(provider);
+	EvtPublisherEntry *e = EvtFormatterFindPublisher(f, provider, hash);
+	if (e==NULL){
+		EVT_HANDLE h;
+		Py_BEGIN_ALLOW_THREADS
+		h = EvtOpenPublisherMetadata(f->session, provider, NULL, f->locale, 0);
+		Py_END_ALLOW_THREADS
+		f->opened++;
+		// Another thread may have opened it meanwhile.
+		e = EvtFormatterFindPublisher(f, provider, hash);
+		if (e){
+			if (h)
+				EvtClose(h);
+			}
+		else{
+			e = EvtFormatterFreePublisher(f);
+			if (e==NULL){
+				*pmetadata = h;
+				*pentry = NULL;
+				return TRUE;
+				}
+			size_t len = wcslen(provider) + 1;
+			e->provider = (WCHAR *)PyMem_Malloc(len * sizeof(WCHAR));
+			if (e->provider==NULL){
+				if (h)
+					EvtClose(h);
+				PyErr_NoMemory();
+				return FALSE;
+				}
+			memcpy(e->provider, provider, len * sizeof(WCHAR));
+			e->hash = hash;
+			e->hMetadata = h;
+			}
+		}
+	e->lastUse = ++f->clock;
+	e->refs++;
+	*pmetadata = e->hMetadata;
+	*pentry = e;
+	return TRUE;
+}
+
+static void EvtFormatterReleasePublisher(EVT_HANDLE metadata, EvtPublisherEntry *e)
+{
+	if (e)
+		e->refs--;
+	else if (metadata)
+		EvtClose(metadata);
+}
+
+static void EvtFormatterClearStrings(PyEvtMessageFormatter *f)
+{
+	for (DWORD i=0; i<f->num_buckets; i++){
+		EvtCachedString *s = f->buckets[i];
+		while (s){
+			EvtCachedString *next = s->next;
+			Py_DECREF(s->value);
+			PyMem_Free(s->provider);
+			free(s);
+			s = next;
+			}
+		f->buckets[i] = NULL;
+		}
+	f->num_strings = 0;
+}
+
+static BOOL EvtFormatterFlagsCached(DWORD flags)
+{
+	return flags==EvtFormatMessageLevel || flags==EvtFormatMessageTask || flags==EvtFormatMessageOpcode
+		|| flags==EvtFormatMessageKeyword || flags==EvtFormatMessageChannel || flags==EvtFormatMessageProvider;
+}
+
+static void PyEvtMessageFormatter_dealloc(PyObject *self)
+{
+	PyEvtMessageFormatter *f = (PyEvtMessageFormatter *)self;
+	if (f->publishers){
+		for (DWORD i=0; i<f->max_publishers; i++){
+			if (f->publishers[i].hMetadata)
+				EvtClose(f->publishers[i].hMetadata);
+			PyMem_Free(f->publishers[i].provider);
+			}
+		free(f->publishers);
+		}
+	if (f->buckets){
+		EvtFormatterClearStrings(f);
+		free(f->buckets);
+		}
+	while (f->free_buffers){
+		EvtFormatBuffers *b = f->free_buffers;
+		f->free_buffers = b->next;
+		free(b->render);
+		free(b->text);
+		free(b);
+		}
+	if (f->render_context)
+		EvtClose(f->render_context);
+	Py_XDECREF(f->obsession);
+	PyObject_Del(self);
+}
+
+// @pymethod str,list|PyEvtMessageFormatter|Format|Formats a message for an event
+// @rdesc Returns a string, or a list of strings if Flags=EvtFormatMessageKeyword, as for
+//	<om win32evtlog.EvtFormatMessage>.
+// @comm Accepts keyword args
+static PyObject *PyEvtMessageFormatter_Format(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[] = {"Event", "Flags", NULL};
+	PyEvtMessageFormatter *f = (PyEvtMessageFormatter *)self;
+	EVT_HANDLE event;
+	DWORD flags = EvtFormatMessageEvent;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&|k:Format", keywords,
+		PyWinObject_AsHANDLE, &event,	// @pyparm <o PyEVT_HANDLE>|Event||Handle to an event
+		&flags))	// @pyparm int|Flags|EvtFormatMessageEvent|One of the EvtFormatMessage* values, except EvtFormatMessageId
+		return NULL;
+	if (flags==EvtFormatMessageId)
+		return PyErr_Format(PyExc_ValueError, "EvtFormatMessageId needs a resource id - use EvtFormatMessage");
+	EvtFormatBuffers *b = EvtFormatterGetBuffers(f);
+	if (b==NULL)
+		return NULL;
+	PyObject *ret = NULL;
+	EvtCachedString *s = NULL;
+	ULONG hash = 0;
+	DWORD err;
+	Py_BEGIN_ALLOW_THREADS
+	err = EvtFormatterRender(f, b, event);
+	Py_END_ALLOW_THREADS
+	if (err){
+		PyWin_SetAPIError("EvtRender", err);
+		EvtFormatterPutBuffers(f, b);
+		return NULL;
+		}
+	// The provider name stays valid until the buffers are returned.
+	EVT_VARIANT *v = (EVT_VARIANT *)b->render;
+	const WCHAR *provider = v[EvtSystemProviderName].Type==EvtVarTypeString ? v[EvtSystemProviderName].StringVal : NULL;
+	EvtCachedString key;
+	BOOL bCache = provider && EvtFormatterFlagsCached(flags);
+	if (bCache){
+		memset(&key, 0, sizeof(key));
+		key.flags = flags;
+		if (v[EvtSystemEventID].Type != EvtVarTypeNull)
+			key.id = v[EvtSystemEventID].UInt16Val;
+		if (v[EvtSystemQualifiers].Type != EvtVarTypeNull)
+			key.qualifiers = v[EvtSystemQualifiers].UInt16Val;
+		if (v[EvtSystemTask].Type != EvtVarTypeNull)
+			key.task = v[EvtSystemTask].UInt16Val;
+		if (v[EvtSystemVersion].Type != EvtVarTypeNull)
+			key.version = v[EvtSystemVersion].ByteVal;
+		if (v[EvtSystemLevel].Type != EvtVarTypeNull)
+			key.level = v[EvtSystemLevel].ByteVal;
+		if (v[EvtSystemOpcode].Type != EvtVarTypeNull)
+			key.opcode = v[EvtSystemOpcode].ByteVal;
+		if (v[EvtSystemKeywords].Type != EvtVarTypeNull)
+			key.keywords = v[EvtSystemKeywords].UInt64Val;
+		hash = EvtFormatterHash(provider) ^ (key.id | (key.qualifiers << 16));
+		hash = (hash * 16777619UL) ^ (key.task | (key.version << 16) | (key.level << 24));
+		hash = (hash * 16777619UL) ^ (key.opcode | (flags << 8)) ^ (ULONG)key.keywords ^ (ULONG)(key.keywords >> 32);
+		for (s = f->buckets[hash % f->num_buckets]; s; s = s->next){
+			if (s->hash==hash && s->flags==flags && s->id==key.id && s->qualifiers==key.qualifiers
+				&& s->task==key.task && s->version==key.version && s->level==key.level
+				&& s->opcode==key.opcode && s->keywords==key.keywords && _wcsicmp(s->provider, provider)==0){
+				f->hits++;
+				Py_INCREF(s->value);
+				EvtFormatterPutBuffers(f, b);
+				return s->value;
+				}
+			}
+		f->misses++;
+		}
+
+	EVT_HANDLE metadata = NULL;
+	EvtPublisherEntry *entry = NULL;
+	if (provider && !EvtFormatterGetPublisher(f, provider, &metadata, &entry)){
+		EvtFormatterPutBuffers(f, b);
+		return NULL;
+		}
+	Py_BEGIN_ALLOW_THREADS
+	err = EvtFormatterFormat(f, b, metadata, event, flags);
+	Py_END_ALLOW_THREADS
+	EvtFormatterReleasePublisher(metadata, entry);
+	if (err)
+		PyWin_SetAPIError("EvtFormatMessage", err);
+	else if (flags==EvtFormatMessageKeyword)
+		ret = PyList_FromDoubleTerminatedWSTR(b->text);
+	else
+		ret = PyWinObject_FromWCHAR(b->text);
+
+	if (ret && bCache){
+		if (f->num_strings >= f->max_strings)
+			EvtFormatterClearStrings(f);
+		size_t len = wcslen(provider) + 1;
+		s = (EvtCachedString *)malloc(sizeof(EvtCachedString));
+		WCHAR *copy = (WCHAR *)PyMem_Malloc(len * sizeof(WCHAR));
+		// Not being able to cache the string isn't an error.
+		if (s && copy){
+			*s = key;
+			memcpy(copy, provider, len * sizeof(WCHAR));
+			s->provider = copy;
+			s->hash = hash;
+			s->value = ret;
+			Py_INCREF(ret);
+			s->next = f->buckets[hash % f->num_buckets];
+			f->buckets[hash % f->num_buckets] = s;
+			f->num_strings++;
+			}
+		else{
+			free(s);
+			PyMem_Free(copy);
+			}
+		}
+	EvtFormatterPutBuffers(f, b);
+	return ret;
+}
+
+// @pymethod |PyEvtMessageFormatter|ClearCache|Closes the cached publisher metadata handles and drops the cached strings
+// @comm Use this after providers have been installed or updated.
+static PyObject *PyEvtMessageFormatter_ClearCache(PyObject *self, PyObject *args)
+{
+	PyEvtMessageFormatter *f = (PyEvtMessageFormatter *)self;
+	if (!PyArg_ParseTuple(args, ":ClearCache"))
+		return NULL;
+	for (DWORD i=0; i<f->max_publishers; i++){
+		EvtPublisherEntry *e = f->publishers + i;
+		// A handle in use by another thread is left for the LRU to replace.
+		if (e->provider==NULL || e->refs)
+			continue;
+		if (e->hMetadata)
+			EvtClose(e->hMetadata);
+		PyMem_Free(e->provider);
+		memset(e, 0, sizeof(*e));
+		}
+	EvtFormatterClearStrings(f);
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+static struct PyMethodDef PyEvtMessageFormatter_methods[] = {
+	{"Format", (PyCFunction)PyEvtMessageFormatter_Format, METH_VARARGS | METH_KEYWORDS},	// @pymeth Format|Formats a message for an event
+	{"ClearCache", PyEvtMessageFormatter_ClearCache, METH_VARARGS},	// @pymeth ClearCache|Empties the caches
+	{NULL}
+};
+
+static struct PyMemberDef PyEvtMessageFormatter_members[] = {
+	// @prop int|hits|Number of strings returned from the cache
+	{"hits", T_LONG, offsetof(PyEvtMessageFormatter, hits), READONLY},
+	// @prop int|misses|Number of cacheable strings which had to be formatted
+	{"misses", T_LONG, offsetof(PyEvtMessageFormatter, misses), READONLY},
+	// @prop int|publishers_opened|Number of calls to EvtOpenPublisherMetadata
+	{"publishers_opened", T_LONG, offsetof(PyEvtMessageFormatter, opened), READONLY},
+	// @prop int|publishers_evicted|Number of metadata handles closed to make room for another provider
+	{"publishers_evicted", T_LONG, offsetof(PyEvtMessageFormatter, evicted), READONLY},
+	// @prop int|buffer_grows|Number of times a render or message buffer had to be enlarged
+	{"buffer_grows", T_LONG, offsetof(PyEvtMessageFormatter, grows), READONLY},
+	{NULL}
+};
+
+PyTypeObject PyEvtMessageFormatterType =
+{
+	PYWIN_OBJECT_HEAD
+	"PyEvtMessageFormatter",
+	sizeof(PyEvtMessageFormatter),
+	0,
+	PyEvtMessageFormatter_dealloc,	/* tp_dealloc */
+	0,						/* tp_print */
+	0,						/* tp_getattr */
+	0,						/* tp_setattr */
+	0,						/* tp_compare */
+	0,						/* tp_repr */
+	0,						/* tp_as_number */
+	0,						/* tp_as_sequence */
+	0,						/* tp_as_mapping */
+	0,						/* tp_hash */
+	0,						/* tp_call */
+	0,						/* tp_str */
+	PyObject_GenericGetAttr,	/* tp_getattro */
+	0,						/* tp_setattro */
+	0,						/*tp_as_buffer*/
+	Py_TPFLAGS_DEFAULT,		/* tp_flags */
+	0,						/* tp_doc */
+	0,						/* tp_traverse */
+	0,						/* tp_clear */
+	0,						/* tp_richcompare */
+	0,						/* tp_weaklistoffset */
+	0,						/* tp_iter */
+	0,						/* tp_iternext */
+	PyEvtMessageFormatter_methods,	/* tp_methods */
+	PyEvtMessageFormatter_members,	/* tp_members */
+};
+
+// @pyswig <o PyEvtMessageFormatter>|CreateEventMessageFormatter|Creates an object which formats event messages with cached publisher metadata
+// @comm Accepts keyword args
+// @comm Use this in place of <om win32evtlog.EvtOpenPublisherMetadata> and <om win32evtlog.EvtFormatMessage>
+//	when formatting events from many providers.
+static PyObject *PyCreateEventMessageFormatter(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[] = {"Session", "Locale", "MaxPublishers", "MaxCachedStrings", NULL};
+	PyObject *obsession = Py_None;
+	EVT_HANDLE session;
+	DWORD locale = 0, max_publishers = 256, max_strings = 4096;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|Okkk:CreateEventMessageFormatter", keywords,
+		&obsession,		// @pyparm <o PyEVT_HANDLE>|Session|None|Handle to a remote session (see <om win32evtlog.EvtOpenSession>), or None for local machine.
+		&locale,		// @pyparm int|Locale|0|Locale to use for the messages, 0 for the current locale
+		&max_publishers,	// @pyparm int|MaxPublishers|256|Number of publisher metadata handles kept open
+		&max_strings))	// @pyparm int|MaxCachedStrings|4096|Number of formatted strings kept.  The cache is emptied when it is full.
+		return NULL;
+	if (!PyWinObject_AsHANDLE(obsession, &session))
+		return NULL;
+	if (max_publishers==0 || max_strings==0)
+		return PyErr_Format(PyExc_ValueError, "MaxPublishers and MaxCachedStrings must be greater than zero");
+	PyEvtMessageFormatter *f = PyObject_New(PyEvtMessageFormatter, &PyEvtMessageFormatterType);
+	if (f==NULL)
+		return NULL;
+	memset((char *)f + sizeof(PyObject), 0, sizeof(PyEvtMessageFormatter) - sizeof(PyObject));
+	Py_INCREF(obsession);
+	f->obsession = obsession;
+	f->session = session;
+	f->locale = locale;
+	f->max_publishers = max_publishers;
+	f->max_strings = max_strings;
+	f->num_buckets = max_strings < 16 ? 16 : max_strings;
+	f->publishers = (EvtPublisherEntry *)calloc(max_publishers, sizeof(EvtPublisherEntry));
+	f->buckets = (EvtCachedString **)calloc(f->num_buckets, sizeof(EvtCachedString *));
+	if (f->publishers==NULL || f->buckets==NULL){
+		Py_DECREF(f);
+		return PyErr_NoMemory();
+		}
+	Py_BEGIN_ALLOW_THREADS
+	f->render_context = EvtCreateRenderContext(0, NULL, EvtRenderContextSystem);
+	Py_END_ALLOW_THREADS
+	if (f->render_context==NULL){
+		PyWin_SetAPIError("EvtCreateRenderContext");
+		Py_DECREF(f);
+		return NULL;
+		}
+	return (PyObject *)f;
+}
+PyCFunction pfnPyCreateEventMessageFormatter = (PyCFunction) PyCreateEventMessageFormatter;
+
 // @pyswig str|EvtNextChannelPath|Retrieves a channel path from an enumeration
 // @rdesc Returns None at end of enumeration
 // @comm Accepts keyword args
@@ -1070,6 +1969,172 @@ static PyObject *PyEvtRender(PyObject *self, PyObject *args, PyObject *kwargs)
 }
 PyCFunction pfnPyEvtRender = (PyCFunction) PyEvtRender;
 
+// Size of the buffer last needed by EvtNextRendered, so each batch starts with one that fits
+static DWORD evt_render_buffer_hint = 65536;
+
+// Converts the output of EvtRender with EvtRenderEventValues or EvtRenderEventXml
+static PyObject *PyWinObject_FromRenderedEvent(DWORD flags, BYTE *data, DWORD size, DWORD count)
+{
+	if (flags==EvtRenderEventXml){
+		// size includes the terminating null
+		WCHAR *xml = (WCHAR *)data;
+		int xml_chars = (int)(size / sizeof(WCHAR)) - 1;
+		int utf8_size = WideCharToMultiByte(CP_UTF8, 0, xml, xml_chars, NULL, 0, NULL, NULL);
+		PyObject *row = PyString_FromStringAndSize(NULL, utf8_size);
+		if (row)
+			WideCharToMultiByte(CP_UTF8, 0, xml, xml_chars, PyString_AS_STRING(row), utf8_size, NULL, NULL);
+		return row;
+		}
+	PEVT_VARIANT variants = (PEVT_VARIANT)data;
+	PyObject *row = PyList_New(count);
+	for (DWORD j=0; row && j<count; j++){
+		PyObject *item = PyWinObject_FromEVT_VARIANT(&variants[j]);
+		if (!item) {
+			// as for RenderEventValues, types that can't be converted are returned as None
+			PyErr_Clear();
+			Py_INCREF(Py_None);
+			item = Py_None;
+			}
+		PyList_SET_ITEM(row, j, item);
+		}
+	return row;
+}
+
+typedef struct {
+	DWORD offset;	// Start of the rendered event in the batch buffer
+	DWORD size;
+	DWORD count;	// Number of values for EvtRenderEventValues
+	DWORD err;
+} EvtRenderedEvent;
+
+// @pyswig [object,...]|EvtNextRendered|Returns the next events from a query, already rendered
+// @rdesc Returns a list with one item per event.  For EvtRenderEventValues, each item is a list of
+//	values as returned by <om win32evtlog.EvtRender>, for EvtRenderEventXml it is the event's
+//	XML as utf-8 encoded bytes.  An event which could not be rendered is returned as None.
+//	If no more events are available, returns an empty list.
+// @comm Accepts keyword args
+// @comm Fetching and rendering the whole batch happens with the GIL released once, into a
+//	single buffer, and the event handles are closed before returning, so no <o PyEVT_HANDLE>
+//	objects are created.  Use <om win32evtlog.EvtNext> where the handles themselves are needed,
+//	for example to create bookmarks.
+static PyObject *PyEvtNextRendered(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[]={"ResultSet", "Count", "Context", "Flags", "Timeout", NULL};
+	EVT_HANDLE query, render_context=NULL;
+	DWORD nbr_requested, nbr_returned=0, flags=EvtRenderEventValues, timeout=(DWORD)-1;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&k|O&kk:EvtNextRendered", keywords,
+		PyWinObject_AsHANDLE, &query,	// @pyparm <o PyEVT_HANDLE>|ResultSet||Handle to event query or subscription
+		&nbr_requested,		// @pyparm int|Count||Maximum number of events to return
+		PyWinObject_AsHANDLE, &render_context,	// @pyparm <o PyEVT_HANDLE>|Context|None|Render context returned by <om win32evtlog.EvtCreateRenderContext>, required for EvtRenderEventValues
+		&flags,		// @pyparm int|Flags|EvtRenderEventValues|EvtRenderEventValues or EvtRenderEventXml
+		&timeout))	// @pyparm int|Timeout|-1|Time to wait in milliseconds, use -1 for infinite
+		return NULL;
+	if (flags==EvtRenderEventValues && render_context==NULL)
+		return PyErr_Format(PyExc_ValueError, "A render context is required for EvtRenderEventValues");
+	if (flags!=EvtRenderEventValues && flags!=EvtRenderEventXml)
+		return PyErr_Format(PyExc_ValueError, "Flags must be EvtRenderEventValues or EvtRenderEventXml");
+	if (flags==EvtRenderEventXml)
+		render_context=NULL;
+	if (nbr_requested==0)
+		return PyList_New(0);
+
+	EVT_HANDLE *events = (EVT_HANDLE *)malloc(nbr_requested * sizeof(EVT_HANDLE));
+	EvtRenderedEvent *rendered = (EvtRenderedEvent *)malloc(nbr_requested * sizeof(EvtRenderedEvent));
+	DWORD bufsize = evt_render_buffer_hint;
+	BYTE *buf = (BYTE *)malloc(bufsize);
+	if (events==NULL || rendered==NULL || buf==NULL){
+		free(events);
+		free(rendered);
+		free(buf);
+		return PyErr_NoMemory();
+		}
+
+	BOOL bsuccess, nomem=FALSE;
+	DWORD err=0;
+	Py_BEGIN_ALLOW_THREADS
+	bsuccess = EvtNext(query, nbr_requested, events, timeout, 0, &nbr_returned);
+	if (!bsuccess)
+		err = GetLastError();
+	else{
+		// Render every event back to back.  If the buffer turns out to be too small, the sizes
+		// returned give the total needed, and the batch is rendered again into a larger buffer -
+		// values point into the buffer, so it can't simply be grown in place.
+		for (int pass=0; pass<2; pass++){
+			DWORD used=0;
+			BOOL overflow=FALSE;
+			for (DWORD i=0; i<nbr_returned; i++){
+				DWORD offset = (used + 7) & ~7;	// keep each EVT_VARIANT array aligned
+				DWORD avail = bufsize > offset ? bufsize - offset : 0;
+				EvtRenderedEvent *r = &rendered[i];
+				r->offset = offset;
+				r->size = 0;
+				r->count = 0;
+				r->err = 0;
+				if (EvtRender(render_context, events[i], flags, avail, avail ? buf + offset : NULL, &r->size, &r->count))
+					used = offset + r->size;
+				else{
+					r->err = GetLastError();
+					if (r->err==ERROR_INSUFFICIENT_BUFFER){
+						overflow = TRUE;
+						used = offset + r->size;
+						}
+					}
+				}
+			if (!overflow)
+				break;
+			if (pass==0){
+				BYTE *newbuf = (BYTE *)realloc(buf, used);
+				if (newbuf==NULL){
+					nomem=TRUE;
+					break;
+					}
+				buf = newbuf;
+				bufsize = used;
+				}
+			}
+		for (DWORD i=0; i<nbr_returned; i++)
+			EvtClose(events[i]);
+		}
+	Py_END_ALLOW_THREADS
+	free(events);
+
+	PyObject *ret=NULL;
+	if (!bsuccess){
+		if (err == ERROR_NO_MORE_ITEMS || (err == ERROR_INVALID_OPERATION && nbr_returned == 0))
+			ret=PyList_New(0);
+		else
+			PyWin_SetAPIError("EvtNext", err);
+		}
+	else if (nomem)
+		PyErr_NoMemory();
+	else{
+		if (bufsize > evt_render_buffer_hint)
+			evt_render_buffer_hint = bufsize;
+		ret=PyList_New(nbr_returned);
+		for (DWORD i=0; ret && i<nbr_returned; i++){
+			EvtRenderedEvent *r = &rendered[i];
+			PyObject *row;
+			if (r->err){
+				Py_INCREF(Py_None);
+				row = Py_None;
+				}
+			else
+				row = PyWinObject_FromRenderedEvent(flags, buf + r->offset, r->size, r->count);
+			if (row==NULL){
+				Py_DECREF(ret);
+				ret=NULL;
+				break;
+				}
+			PyList_SET_ITEM(ret, i, row);
+			}
+		}
+	free(rendered);
+	free(buf);
+	return ret;
+}
+PyCFunction pfnPyEvtNextRendered = (PyCFunction) PyEvtNextRendered;
+
 
 DWORD CALLBACK PyEvtSubscribe_callback(
 	EVT_SUBSCRIBE_NOTIFY_ACTION action,
@@ -1161,6 +2226,402 @@ static PyObject *PyEvtSubscribe(PyObject *self, PyObject *args, PyObject *kwargs
 }
 PyCFunction pfnPyEvtSubscribe = (PyCFunction) PyEvtSubscribe;
 
+// @object PyEVT_SUBSCRIPTION_QUEUE|A push subscription whose events are rendered into a queue,
+//	created by <om win32evtlog.EvtSubscribeQueued>.
+// @comm The subscription callback runs on a thread of the event log service's pool, renders each
+//	event and appends it to a fixed size ring without acquiring the GIL.  Python reads the events
+//	in batches with <om PyEVT_SUBSCRIPTION_QUEUE.Drain>.  The ring has a single writer (the
+//	callback, serialized by a lock that is never held by Python) and a single reader (Drain,
+//	serialized by the GIL), so neither side ever waits for the other.
+typedef struct {
+	BYTE *data;			// rendered event, owned by the entry
+	DWORD size;
+	DWORD count;
+	EVT_HANDLE bookmark;	// set on every BookmarkEvery'th event
+} EvtQueueEntry;
+
+typedef struct {
+	PyObject_HEAD
+	EVT_HANDLE subscription;
+	EVT_HANDLE render_context;
+	PyObject *obrender_context;	// keeps render_context open
+	DWORD flags;				// EvtRenderEventValues or EvtRenderEventXml
+	BOOL block;
+	DWORD render_hint;			// size of the largest event rendered so far
+	EvtQueueEntry *entries;
+	LONG capacity;
+	volatile LONG head;			// next entry to be drained, only written by Drain
+	volatile LONG tail;			// next entry to be filled, only written by the callback
+	CRITICAL_SECTION producer_lock;	// in case the service overlaps callbacks
+	HANDLE hDataEvent;	// set when an event is queued
+	HANDLE hSpaceEvent;	// set when entries are drained
+	HANDLE hStopEvent;	// releases a blocked callback when closing
+	EVT_HANDLE bookmark;		// position of the last drained event that carried a bookmark
+	DWORD bookmark_every;
+	DWORD since_bookmark;
+	LONGLONG delivered;
+	LONGLONG dropped;
+	LONGLONG blocked;
+	LONGLONG errors;
+	DWORD last_error;
+} PyEVT_SUBSCRIPTION_QUEUE;
+
+static void PyEVT_SUBSCRIPTION_QUEUE_dealloc(PyObject *self);
+extern PyMethodDef PyEVT_SUBSCRIPTION_QUEUE_methods[];
+extern PyMemberDef PyEVT_SUBSCRIPTION_QUEUE_members[];
+
+PyTypeObject PyEVT_SUBSCRIPTION_QUEUEType = {
+	PYWIN_OBJECT_HEAD
+	"PyEVT_SUBSCRIPTION_QUEUE",		/* tp_name */
+	sizeof(PyEVT_SUBSCRIPTION_QUEUE),	/* tp_basicsize */
+	0,								/* tp_itemsize */
+	PyEVT_SUBSCRIPTION_QUEUE_dealloc,	/* tp_dealloc */
+	0,								/* tp_print */
+	0,								/* tp_getattr */
+	0,								/* tp_setattr */
+	0,								/* tp_compare */
+	0,								/* tp_repr */
+	0,								/* tp_as_number */
+	0,								/* tp_as_sequence */
+	0,								/* tp_as_mapping */
+	0,								/* tp_hash */
+	0,								/* tp_call */
+	0,								/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,								/* tp_setattro */
+	0,								/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,				/* tp_flags */
+	0,								/* tp_doc */
+	0,								/* tp_traverse */
+	0,								/* tp_clear */
+	0,								/* tp_richcompare */
+	0,								/* tp_weaklistoffset */
+	0,								/* tp_iter */
+	0,								/* tp_iternext */
+	PyEVT_SUBSCRIPTION_QUEUE_methods,	/* tp_methods */
+	PyEVT_SUBSCRIPTION_QUEUE_members,	/* tp_members */
+};
+
+DWORD CALLBACK PyEvtSubscribeQueued_callback(
+	EVT_SUBSCRIBE_NOTIFY_ACTION action,
+	void *context,
+	EVT_HANDLE event)
+{
+	PyEVT_SUBSCRIPTION_QUEUE *q = (PyEVT_SUBSCRIPTION_QUEUE *)context;
+	EnterCriticalSection(&q->producer_lock);
+	if (action != EvtSubscribeActionDeliver){
+		// event is actually the error code
+		q->errors++;
+		q->last_error = (DWORD)(ULONG_PTR)event;
+		LeaveCriticalSection(&q->producer_lock);
+		return 0;
+		}
+	while (q->tail - q->head >= q->capacity){
+		if (!q->block){
+			q->dropped++;
+			LeaveCriticalSection(&q->producer_lock);
+			return 0;
+			}
+		q->blocked++;
+		HANDLE handles[2] = {q->hStopEvent, q->hSpaceEvent};
+		if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0 + 1){
+			q->dropped++;
+			LeaveCriticalSection(&q->producer_lock);
+			return 0;
+			}
+		}
+
+	DWORD size = q->render_hint, needed = 0, count = 0;
+	BYTE *data = (BYTE *)malloc(size);
+	BOOL ok = data && EvtRender(q->render_context, event, q->flags, size, data, &needed, &count);
+	if (data && !ok && GetLastError() == ERROR_INSUFFICIENT_BUFFER){
+		free(data);
+		size = needed;
+		data = (BYTE *)malloc(size);
+		ok = data && EvtRender(q->render_context, event, q->flags, size, data, &needed, &count);
+		if (ok)
+			q->render_hint = size;
+		}
+	if (!ok){
+		q->errors++;
+		q->last_error = data ? GetLastError() : ERROR_OUTOFMEMORY;
+		free(data);
+		LeaveCriticalSection(&q->producer_lock);
+		return 0;
+		}
+
+	EvtQueueEntry *e = &q->entries[q->tail % q->capacity];
+	e->data = data;
+	e->size = needed;
+	e->count = count;
+	e->bookmark = NULL;
+	// The event handle is closed when the callback returns, so its position is copied into a
+	// bookmark of its own, which becomes the queue's bookmark once Drain has returned the event.
+	if (q->bookmark_every && ++q->since_bookmark >= q->bookmark_every){
+		q->since_bookmark = 0;
+		e->bookmark = EvtCreateBookmark(NULL);
+		if (e->bookmark && !EvtUpdateBookmark(e->bookmark, event)){
+			EvtClose(e->bookmark);
+			e->bookmark = NULL;
+			}
+		}
+	q->delivered++;
+	MemoryBarrier();
+	InterlockedIncrement(&q->tail);
+	LeaveCriticalSection(&q->producer_lock);
+	SetEvent(q->hDataEvent);
+	return 0;
+}
+
+// Stops the subscription - a callback blocked on a full queue gives up its event.
+static void EvtSubscriptionQueueClose(PyEVT_SUBSCRIPTION_QUEUE *q)
+{
+	if (q->subscription==NULL)
+		return;
+	SetEvent(q->hStopEvent);
+	Py_BEGIN_ALLOW_THREADS
+	// Waits for any callback in progress
+	EvtClose(q->subscription);
+	Py_END_ALLOW_THREADS
+	q->subscription = NULL;
+}
+
+static void PyEVT_SUBSCRIPTION_QUEUE_dealloc(PyObject *self)
+{
+	PyEVT_SUBSCRIPTION_QUEUE *q = (PyEVT_SUBSCRIPTION_QUEUE *)self;
+	EvtSubscriptionQueueClose(q);
+	for (LONG i = q->head; i != q->tail; i++){
+		EvtQueueEntry *e = &q->entries[i % q->capacity];
+		free(e->data);
+		if (e->bookmark)
+			EvtClose(e->bookmark);
+		}
+	free(q->entries);
+	if (q->bookmark)
+		EvtClose(q->bookmark);
+	if (q->hDataEvent)
+		CloseHandle(q->hDataEvent);
+	if (q->hSpaceEvent)
+		CloseHandle(q->hSpaceEvent);
+	if (q->hStopEvent)
+		CloseHandle(q->hStopEvent);
+	DeleteCriticalSection(&q->producer_lock);
+	Py_XDECREF(q->obrender_context);
+	PyObject_Del(self);
+}
+
+// @pymethod [object,...]|PyEVT_SUBSCRIPTION_QUEUE|Drain|Removes events from the queue
+// @rdesc A list of events, oldest first, as for <om win32evtlog.EvtNextRendered>.
+//	Returns an empty list if no event arrived before the timeout.
+static PyObject *PyEVT_SUBSCRIPTION_QUEUE_Drain(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[]={"Count", "Timeout", NULL};
+	PyEVT_SUBSCRIPTION_QUEUE *q = (PyEVT_SUBSCRIPTION_QUEUE *)self;
+	DWORD count = 0, timeout = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|kk:Drain", keywords,
+		&count,		// @pyparm int|Count|0|Maximum number of events to return, 0 for all queued events
+		&timeout))	// @pyparm int|Timeout|0|Milliseconds to wait for an event if the queue is empty, -1 for infinite
+		return NULL;
+	if (q->head == q->tail && timeout && q->subscription){
+		Py_BEGIN_ALLOW_THREADS
+		WaitForSingleObject(q->hDataEvent, timeout);
+		Py_END_ALLOW_THREADS
+		}
+	LONG tail = q->tail;
+	MemoryBarrier();
+	LONG available = tail - q->head;
+	if (count && (LONG)count < available)
+		available = count;
+	PyObject *ret = PyList_New(available);
+	if (ret == NULL)
+		return NULL;
+	EVT_HANDLE bookmark = NULL;
+	for (LONG i = 0; i < available; i++){
+		EvtQueueEntry *e = &q->entries[q->head % q->capacity];
+		PyObject *row = PyWinObject_FromRenderedEvent(q->flags, e->data, e->size, e->count);
+		if (row == NULL){
+			// Entries already taken are lost, but the queue stays consistent.
+			Py_DECREF(ret);
+			ret = NULL;
+			break;
+			}
+		PyList_SET_ITEM(ret, i, row);
+		free(e->data);
+		if (e->bookmark){
+			if (bookmark)
+				EvtClose(bookmark);
+			bookmark = e->bookmark;
+			}
+		InterlockedIncrement(&q->head);
+		}
+	if (bookmark){
+		if (q->bookmark)
+			EvtClose(q->bookmark);
+		q->bookmark = bookmark;
+		}
+	if (available){
+		if (q->block)
+			SetEvent(q->hSpaceEvent);
+		// The data event was consumed by the wait, so keep it set while events remain.
+		if (q->head != q->tail)
+			SetEvent(q->hDataEvent);
+		}
+	return ret;
+}
+
+// @pymethod str|PyEVT_SUBSCRIPTION_QUEUE|GetBookmark|Returns the position of the events drained so far
+// @rdesc The XML of a bookmark at the most recent drained event which carried one, or None if there
+//	is none yet.  Pass it to <om win32evtlog.EvtCreateBookmark> to resume a subscription after it.
+static PyObject *PyEVT_SUBSCRIPTION_QUEUE_GetBookmark(PyObject *self, PyObject *args)
+{
+	PyEVT_SUBSCRIPTION_QUEUE *q = (PyEVT_SUBSCRIPTION_QUEUE *)self;
+	if (!PyArg_ParseTuple(args, ":GetBookmark"))
+		return NULL;
+	if (q->bookmark == NULL){
+		Py_INCREF(Py_None);
+		return Py_None;
+		}
+	DWORD bufsize = 0, bufneeded = 0, propcount = 0;
+	WCHAR *buf = NULL;
+	PyObject *ret = NULL;
+	while (1){
+		BOOL bsuccess;
+		Py_BEGIN_ALLOW_THREADS
+		bsuccess = EvtRender(NULL, q->bookmark, EvtRenderBookmark, bufsize, buf, &bufneeded, &propcount);
+		Py_END_ALLOW_THREADS
+		if (bsuccess){
+			ret = PyWinObject_FromWCHAR(buf);
+			break;
+			}
+		DWORD err = GetLastError();
+		if (err != ERROR_INSUFFICIENT_BUFFER){
+			PyWin_SetAPIError("EvtRender", err);
+			break;
+			}
+		free(buf);
+		bufsize = bufneeded;
+		buf = (WCHAR *)malloc(bufsize);
+		if (buf == NULL){
+			PyErr_NoMemory();
+			break;
+			}
+		}
+	free(buf);
+	return ret;
+}
+
+// @pymethod |PyEVT_SUBSCRIPTION_QUEUE|Close|Cancels the subscription
+// @comm Events already queued can still be drained.
+static PyObject *PyEVT_SUBSCRIPTION_QUEUE_Close(PyObject *self, PyObject *args)
+{
+	if (!PyArg_ParseTuple(args, ":Close"))
+		return NULL;
+	EvtSubscriptionQueueClose((PyEVT_SUBSCRIPTION_QUEUE *)self);
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+PyMethodDef PyEVT_SUBSCRIPTION_QUEUE_methods[] = {
+	{"Drain", (PyCFunction)PyEVT_SUBSCRIPTION_QUEUE_Drain, METH_VARARGS | METH_KEYWORDS},	// @pymeth Drain|Removes events from the queue
+	{"GetBookmark", PyEVT_SUBSCRIPTION_QUEUE_GetBookmark, METH_VARARGS},	// @pymeth GetBookmark|Returns the position of the events drained so far
+	{"Close", PyEVT_SUBSCRIPTION_QUEUE_Close, METH_VARARGS},	// @pymeth Close|Cancels the subscription
+	{NULL}
+};
+
+#undef OFF
+#define OFF(e) offsetof(PyEVT_SUBSCRIPTION_QUEUE, e)
+PyMemberDef PyEVT_SUBSCRIPTION_QUEUE_members[] = {
+	{"capacity", T_LONG, OFF(capacity), READONLY},	// @prop int|capacity|Maximum number of queued events
+	{"delivered", T_LONGLONG, OFF(delivered), READONLY},	// @prop int|delivered|Number of events queued since the subscription started
+	{"dropped", T_LONGLONG, OFF(dropped), READONLY},	// @prop int|dropped|Number of events discarded because the queue was full
+	{"blocked", T_LONGLONG, OFF(blocked), READONLY},	// @prop int|blocked|Number of times the callback waited for room in the queue
+	{"errors", T_LONGLONG, OFF(errors), READONLY},	// @prop int|errors|Number of subscription or rendering errors
+	{"last_error", T_ULONG, OFF(last_error), READONLY},	// @prop int|last_error|The most recent of those errors
+	{NULL}
+};
+
+// @pyswig <o PyEVT_SUBSCRIPTION_QUEUE>|EvtSubscribeQueued|Subscribes to events delivered into a queue
+// @comm Accepts keyword args
+// @comm Unlike a subscription using a Callback in <om win32evtlog.EvtSubscribe>, the GIL is never
+//	acquired per event.  When the queue is full, new events are dropped, or with Block=True the
+//	subscription waits until <om PyEVT_SUBSCRIPTION_QUEUE.Drain> makes room, which also holds up
+//	further delivery by the service.  Each case is counted by the queue's dropped and blocked attributes.
+static PyObject *PyEvtSubscribeQueued(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[]={"ChannelPath", "Flags", "Query", "Session", "Bookmark",
+		"Context", "RenderFlags", "QueueSize", "Block", "BookmarkEvery", NULL};
+	EVT_HANDLE session=NULL, bookmark=NULL;
+	TmpWCHAR path, query;
+	PyObject *obpath, *obquery=Py_None, *obcontext=Py_None;
+	DWORD flags, render_flags=EvtRenderEventXml, queue_size=1024, bookmark_every=0;
+	BOOL block=FALSE;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "Ok|OO&O&Okkik:EvtSubscribeQueued", keywords,
+		&obpath,	// @pyparm str|ChannelPath||Name of an event log channel
+		&flags,		// @pyparm int|Flags||Combination of EvtSubscribe* flags determining how subscription is initiated
+		&obquery,	// @pyparm str|Query|None|XML query used to select specific events, use None or '*' for all events
+		PyWinObject_AsHANDLE, &session,		// @pyparm <o PyEVT_HANDLE>|Session|None|Handle to a session on another machine, or None for local
+		PyWinObject_AsHANDLE, &bookmark,	// @pyparm <o PyEVT_HANDLE>|Bookmark|None|If Flags contains EvtSubscribeStartAfterBookmark, used as starting point
+		&obcontext,		// @pyparm <o PyEVT_HANDLE>|Context|None|Render context returned by <om win32evtlog.EvtCreateRenderContext>, required for EvtRenderEventValues
+		&render_flags,	// @pyparm int|RenderFlags|EvtRenderEventXml|EvtRenderEventXml or EvtRenderEventValues
+		&queue_size,	// @pyparm int|QueueSize|1024|Maximum number of events held in the queue
+		&block,			// @pyparm bool|Block|False|If True, wait for room when the queue is full instead of dropping events
+		&bookmark_every))	// @pyparm int|BookmarkEvery|0|Keep a bookmark at every this many events, see <om PyEVT_SUBSCRIPTION_QUEUE.GetBookmark>.  0 keeps no bookmark.
+		return NULL;
+	EVT_HANDLE render_context=NULL;
+	if (!PyWinObject_AsHANDLE(obcontext, &render_context))
+		return NULL;
+	if (render_flags==EvtRenderEventValues && render_context==NULL)
+		return PyErr_Format(PyExc_ValueError, "A render context is required for EvtRenderEventValues");
+	if (render_flags!=EvtRenderEventValues && render_flags!=EvtRenderEventXml)
+		return PyErr_Format(PyExc_ValueError, "RenderFlags must be EvtRenderEventValues or EvtRenderEventXml");
+	if (queue_size==0 || queue_size > 0x10000000)
+		return PyErr_Format(PyExc_ValueError, "QueueSize must be between 1 and %d", 0x10000000);
+	if (!PyWinObject_AsWCHAR(obpath, &path, FALSE))
+		return NULL;
+	if (!PyWinObject_AsWCHAR(obquery, &query, TRUE))
+		return NULL;
+
+	PyEVT_SUBSCRIPTION_QUEUE *q = PyObject_New(PyEVT_SUBSCRIPTION_QUEUE, &PyEVT_SUBSCRIPTION_QUEUEType);
+	if (q==NULL)
+		return NULL;
+	memset((char *)q + sizeof(PyObject), 0, sizeof(PyEVT_SUBSCRIPTION_QUEUE) - sizeof(PyObject));
+	InitializeCriticalSection(&q->producer_lock);
+	q->flags = render_flags;
+	q->render_context = render_flags==EvtRenderEventValues ? render_context : NULL;
+	if (q->render_context){
+		Py_INCREF(obcontext);
+		q->obrender_context = obcontext;
+		}
+	q->block = block;
+	q->bookmark_every = bookmark_every;
+	q->render_hint = 4096;
+	q->capacity = queue_size;
+	q->entries = (EvtQueueEntry *)malloc(queue_size * sizeof(EvtQueueEntry));
+	if (q->entries==NULL){
+		Py_DECREF(q);
+		return PyErr_NoMemory();
+		}
+	q->hDataEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	q->hSpaceEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	q->hStopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if (!q->hDataEvent || !q->hSpaceEvent || !q->hStopEvent){
+		Py_DECREF(q);
+		return PyWin_SetAPIError("CreateEvent");
+		}
+	EVT_HANDLE ret;
+	Py_BEGIN_ALLOW_THREADS
+	ret = EvtSubscribe(session, NULL, path, query, bookmark,
+		q, PyEvtSubscribeQueued_callback, flags);
+	Py_END_ALLOW_THREADS
+	if (ret==NULL){
+		Py_DECREF(q);
+		return PyWin_SetAPIError("EvtSubscribe");
+		}
+	q->subscription = ret;
+	return (PyObject *)q;
+}
+PyCFunction pfnPyEvtSubscribeQueued = (PyCFunction) PyEvtSubscribeQueued;
+
 // @pyswig <o PyEVT_HANDLE>|EvtCreateBookmark|Creates a bookmark
 // @comm Accepts keyword args
 static PyObject *PyEvtCreateBookmark(PyObject *self, PyObject *args, PyObject *kwargs)
@@ -1917,6 +3378,7 @@ PyCFunction pfnPyEvtGetObjectArrayProperty = (PyCFunction) PyEvtGetObjectArrayPr
 
 %native (EvtCreateRenderContext) pfnPyEvtCreateRenderContext;
 %native (EvtFormatMessage) pfnPyEvtFormatMessage;
+%native (CreateEventMessageFormatter) pfnPyCreateEventMessageFormatter;
 %native (EvtOpenChannelEnum) pfnPyEvtOpenChannelEnum;
 %native (EvtNextChannelPath) pfnPyEvtNextChannelPath;
 %native (EvtOpenLog) pfnPyEvtOpenLog;
@@ -1928,7 +3390,9 @@ PyCFunction pfnPyEvtGetObjectArrayProperty = (PyCFunction) PyEvtGetObjectArrayPr
 %native (EvtNext) pfnPyEvtNext;
 %native (EvtSeek) pfnPyEvtSeek;
 %native (EvtRender) pfnPyEvtRender;
+%native (EvtNextRendered) pfnPyEvtNextRendered;
 %native (EvtSubscribe) pfnPyEvtSubscribe;
+%native (EvtSubscribeQueued) pfnPyEvtSubscribeQueued;
 %native (EvtCreateBookmark) pfnPyEvtCreateBookmark;
 %native (EvtUpdateBookmark) pfnPyEvtUpdateBookmark;
 %native (EvtGetChannelConfigProperty) pfnPyEvtGetChannelConfigProperty;
@@ -1946,12 +3410,30 @@ PyCFunction pfnPyEvtGetObjectArrayProperty = (PyCFunction) PyEvtGetObjectArrayPr
 %native (EvtGetObjectArraySize) pfnPyEvtGetObjectArraySize;
 %native (EvtGetObjectArrayProperty) pfnPyEvtGetObjectArrayProperty;
 
+%{
+// ETW providers and consumers, in win32evtlog_etw.cpp
+extern PyCFunction pfnPyEVENT_DESCRIPTOR;
+extern PyCFunction pfnPyEventRegister;
+extern PyCFunction pfnPyOpenTraceQueued;
+BOOL PyWinETW_Init(PyObject *dict);
+%}
+%native (EVENT_DESCRIPTOR) pfnPyEVENT_DESCRIPTOR;
+%native (EventRegister) pfnPyEventRegister;
+%native (OpenTraceQueued) pfnPyOpenTraceQueued;
+
 
 %init %{
+	if (PyType_Ready(&PyEVT_SUBSCRIPTION_QUEUEType) == -1
+		||PyType_Ready(&PyEventLogRecordViewType) == -1
+		||PyType_Ready(&PyEventLogReaderType) == -1
+		||PyType_Ready(&PyEvtMessageFormatterType) == -1
+		||!PyWinETW_Init(d))
+		PYWIN_MODULE_INIT_RETURN_ERROR;
     for (PyMethodDef *pmd = win32evtlogMethods;pmd->ml_name;pmd++)
         if   ((strcmp(pmd->ml_name, "EvtOpenChannelEnum")==0)
 			||(strcmp(pmd->ml_name, "EvtCreateRenderContext")==0)
 			||(strcmp(pmd->ml_name, "EvtFormatMessage")==0)
+			||(strcmp(pmd->ml_name, "CreateEventMessageFormatter")==0)
 			||(strcmp(pmd->ml_name, "EvtNextChannelPath")==0)
 			||(strcmp(pmd->ml_name, "EvtOpenLog")==0)
 			||(strcmp(pmd->ml_name, "EvtClearLog")==0)
@@ -1962,7 +3444,10 @@ PyCFunction pfnPyEvtGetObjectArrayProperty = (PyCFunction) PyEvtGetObjectArrayPr
 			||(strcmp(pmd->ml_name, "EvtNext")==0)
 			||(strcmp(pmd->ml_name, "EvtSeek")==0)
 			||(strcmp(pmd->ml_name, "EvtRender")==0)
+			||(strcmp(pmd->ml_name, "EvtNextRendered")==0)
 			||(strcmp(pmd->ml_name, "EvtSubscribe")==0)
+			||(strcmp(pmd->ml_name, "EvtSubscribeQueued")==0)
+			||(strcmp(pmd->ml_name, "CreateEventLogReader")==0)
 			||(strcmp(pmd->ml_name, "EvtCreateBookmark")==0)
 			||(strcmp(pmd->ml_name, "EvtUpdateBookmark")==0)
 			||(strcmp(pmd->ml_name, "EvtGetChannelConfigProperty")==0)
@@ -1979,6 +3464,9 @@ PyCFunction pfnPyEvtGetObjectArrayProperty = (PyCFunction) PyEvtGetObjectArrayPr
 			||(strcmp(pmd->ml_name, "EvtGetEventInfo")==0)
 			||(strcmp(pmd->ml_name, "EvtGetObjectArraySize")==0)
 			||(strcmp(pmd->ml_name, "EvtGetObjectArrayProperty")==0)
+			||(strcmp(pmd->ml_name, "EVENT_DESCRIPTOR")==0)
+			||(strcmp(pmd->ml_name, "EventRegister")==0)
+			||(strcmp(pmd->ml_name, "OpenTraceQueued")==0)
 			){
 			pmd->ml_flags = METH_VARARGS | METH_KEYWORDS;
 			}
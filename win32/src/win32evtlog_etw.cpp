@@ -0,0 +1,978 @@
+// Event Tracing for Windows support for win32evtlog.
+//
+// Providers are registered with EventRegister and write events described by
+// precompiled EVENT_DESCRIPTOR objects.  Writing checks EventEnabled before
+// touching the data, so an event nobody is listening to costs little more
+// than the call itself, and the data is passed to EventWrite straight from
+// the Python objects wherever their memory layout allows.
+//
+// Sessions are consumed by OpenTraceQueued, which runs ProcessTrace on a
+// thread of its own and queues the events for Python to drain in batches,
+// in the same way as EvtSubscribeQueued in win32evtlog.i.
+
+// @doc - This file contains autoduck documentation
+
+#include "PyWinTypes.h"
+#include "structmember.h"
+#include <evntprov.h>
+#include <evntrace.h>
+#include <evntcons.h>
+#include <tdh.h>
+
+// Levels from winmeta.h, which is not included by every SDK's evntprov.h
+#ifndef WINEVENT_LEVEL_LOG_ALWAYS
+#define WINEVENT_LEVEL_LOG_ALWAYS 0
+#define WINEVENT_LEVEL_CRITICAL 1
+#define WINEVENT_LEVEL_ERROR 2
+#define WINEVENT_LEVEL_WARNING 3
+#define WINEVENT_LEVEL_INFO 4
+#define WINEVENT_LEVEL_VERBOSE 5
+#endif
+
+// @object PyEVENT_DESCRIPTOR|A precompiled EVENT_DESCRIPTOR, as created by <om win32evtlog.EVENT_DESCRIPTOR>
+// @comm The Layout gives the type of each item of the data passed to <om PyETW_PROVIDER.Write>, one
+// character per item:<nl>
+//	b/B - 8 bit integer<nl>
+//	h/H - 16 bit integer<nl>
+//	i/I - 32 bit integer<nl>
+//	q/Q - 64 bit integer<nl>
+//	p - pointer sized integer<nl>
+//	f - float<nl>
+//	d - double<nl>
+//	t - 32 bit BOOL<nl>
+//	z - null terminated UTF-16 string<nl>
+//	y - the raw bytes of any object supporting the buffer interface<nl>
+// Without a Layout, ints are written as 64 bit integers, floats as doubles, bools as BOOL, strings as
+// null terminated UTF-16 and other objects as raw buffers.  None always writes an empty item.
+struct PyEVENT_DESCRIPTOR {
+    PyObject_HEAD EVENT_DESCRIPTOR desc;
+    PyObject *obLayout;
+    const char *layout;  // points into obLayout, or NULL
+    Py_ssize_t nlayout;
+    // Exposed as members, since EVENT_DESCRIPTOR is packed into odd sizes
+    unsigned short id;
+    unsigned char version, channel, level, opcode;
+    unsigned short task;
+    unsigned long long keyword;
+};
+
+#define OFF(e) offsetof(PyEVENT_DESCRIPTOR, e)
+static struct PyMemberDef PyEVENT_DESCRIPTOR_members[] = {
+    {"Id", T_USHORT, OFF(id), READONLY},              // @prop int|Id|
+    {"Version", T_UBYTE, OFF(version), READONLY},     // @prop int|Version|
+    {"Channel", T_UBYTE, OFF(channel), READONLY},     // @prop int|Channel|
+    {"Level", T_UBYTE, OFF(level), READONLY},         // @prop int|Level|
+    {"Opcode", T_UBYTE, OFF(opcode), READONLY},       // @prop int|Opcode|
+    {"Task", T_USHORT, OFF(task), READONLY},          // @prop int|Task|
+    {"Keyword", T_ULONGLONG, OFF(keyword), READONLY}, // @prop int|Keyword|
+    {"Layout", T_OBJECT, OFF(obLayout), READONLY},    // @prop str|Layout|None if no layout was given
+    {NULL}};
+#undef OFF
+
+static void PyEVENT_DESCRIPTOR_dealloc(PyObject *self)
+{
+    Py_XDECREF(((PyEVENT_DESCRIPTOR *)self)->obLayout);
+    PyObject_Del(self);
+}
+
+PyTypeObject PyEVENT_DESCRIPTORType = {
+    PYWIN_OBJECT_HEAD "PyEVENT_DESCRIPTOR",
+    sizeof(PyEVENT_DESCRIPTOR),
+    0,
+    PyEVENT_DESCRIPTOR_dealloc, /* tp_dealloc */
+    0,                          /* tp_print */
+    0,                          /* tp_getattr */
+    0,                          /* tp_setattr */
+    0,                          /* tp_compare */
+    0,                          /* tp_repr */
+    0,                          /* tp_as_number */
+    0,                          /* tp_as_sequence */
+    0,                          /* tp_as_mapping */
+    0,                          /* tp_hash */
+    0,                          /* tp_call */
+    0,                          /* tp_str */
+    PyObject_GenericGetAttr,    /* tp_getattro */
+    0,                          /* tp_setattro */
+    0,                          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,         /* tp_flags */
+    0,                          /* tp_doc */
+    0,                          /* tp_traverse */
+    0,                          /* tp_clear */
+    0,                          /* tp_richcompare */
+    0,                          /* tp_weaklistoffset */
+    0,                          /* tp_iter */
+    0,                          /* tp_iternext */
+    0,                          /* tp_methods */
+    PyEVENT_DESCRIPTOR_members, /* tp_members */
+};
+
+static const char etw_layout_codes[] = "bBhHiIqQpfdtzy";
+
+// @pymethod <o PyEVENT_DESCRIPTOR>|win32evtlog|EVENT_DESCRIPTOR|Creates a precompiled event descriptor
+// @comm Accepts keyword args
+static PyObject *PyEVENT_DESCRIPTOR_new(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Id", "Version", "Channel", "Level", "Opcode", "Task", "Keyword", "Layout", NULL};
+    unsigned short id, task = 0;
+    unsigned char version = 0, channel = 0, level = WINEVENT_LEVEL_INFO, opcode = 0;
+    unsigned long long keyword = 0;
+    PyObject *obLayout = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "H|bbbbHKO:EVENT_DESCRIPTOR", keywords,
+                                     &id,         // @pyparm int|Id||The event id
+                                     &version,    // @pyparm int|Version|0|
+                                     &channel,    // @pyparm int|Channel|0|
+                                     &level,      // @pyparm int|Level|WINEVENT_LEVEL_INFO|
+                                     &opcode,     // @pyparm int|Opcode|0|
+                                     &task,       // @pyparm int|Task|0|
+                                     &keyword,    // @pyparm int|Keyword|0|
+                                     &obLayout))  // @pyparm str|Layout|None|The type of each data item, see <o PyEVENT_DESCRIPTOR>
+        return NULL;
+    const char *layout = NULL;
+    Py_ssize_t nlayout = 0;
+    if (obLayout != Py_None) {
+        layout = PyUnicode_AsUTF8AndSize(obLayout, &nlayout);
+        if (layout == NULL)
+            return NULL;
+        if (nlayout > MAX_EVENT_DATA_DESCRIPTORS)
+            return PyErr_Format(PyExc_ValueError, "An event can have at most %d items", MAX_EVENT_DATA_DESCRIPTORS);
+        for (Py_ssize_t i = 0; i < nlayout; i++)
+            if (layout[i] == 0 || strchr(etw_layout_codes, layout[i]) == NULL)
+                return PyErr_Format(PyExc_ValueError, "Invalid layout code '%c'", layout[i]);
+    }
+    PyEVENT_DESCRIPTOR *ret = PyObject_New(PyEVENT_DESCRIPTOR, &PyEVENT_DESCRIPTORType);
+    if (ret == NULL)
+        return NULL;
+    EventDescCreate(&ret->desc, id, version, channel, level, task, opcode, keyword);
+    ret->id = id;
+    ret->version = version;
+    ret->channel = channel;
+    ret->level = level;
+    ret->opcode = opcode;
+    ret->task = task;
+    ret->keyword = keyword;
+    Py_INCREF(obLayout);
+    ret->obLayout = obLayout;
+    ret->layout = layout;
+    ret->nlayout = nlayout;
+    return (PyObject *)ret;
+}
+PyCFunction pfnPyEVENT_DESCRIPTOR = (PyCFunction)PyEVENT_DESCRIPTOR_new;
+
+// @object PyETW_PROVIDER|A registered ETW provider, as returned by <om win32evtlog.EventRegister>
+// @comm The provider is unregistered when the object is destroyed, or by <om PyETW_PROVIDER.Close>.
+struct PyETW_PROVIDER {
+    PyObject_HEAD REGHANDLE handle;
+    PyObject *obguid;
+};
+
+static PyObject *PyETW_PROVIDER_Enabled(PyObject *self, PyObject *args);
+static PyObject *PyETW_PROVIDER_Write(PyObject *self, PyObject *args);
+static PyObject *PyETW_PROVIDER_WriteString(PyObject *self, PyObject *args);
+static PyObject *PyETW_PROVIDER_Close(PyObject *self, PyObject *args);
+
+// @object PyETW_PROVIDER|
+static struct PyMethodDef PyETW_PROVIDER_methods[] = {
+    {"Enabled", PyETW_PROVIDER_Enabled, METH_VARARGS},  // @pymeth Enabled|Checks if any session is listening
+    {"Write", PyETW_PROVIDER_Write, METH_VARARGS},      // @pymeth Write|Writes an event
+    {"WriteString", PyETW_PROVIDER_WriteString,
+     METH_VARARGS},                                   // @pymeth WriteString|Writes an event holding only a string
+    {"Close", PyETW_PROVIDER_Close, METH_VARARGS},  // @pymeth Close|Unregisters the provider
+    {NULL}};
+
+static struct PyMemberDef PyETW_PROVIDER_members[] = {
+    // @prop <o PyIID>|ProviderId|The GUID the provider was registered with
+    {"ProviderId", T_OBJECT, offsetof(PyETW_PROVIDER, obguid), READONLY},
+    {NULL}};
+
+static void PyETW_PROVIDER_dealloc(PyObject *self)
+{
+    PyETW_PROVIDER *This = (PyETW_PROVIDER *)self;
+    if (This->handle)
+        EventUnregister(This->handle);
+    Py_XDECREF(This->obguid);
+    PyObject_Del(self);
+}
+
+PyTypeObject PyETW_PROVIDERType = {
+    PYWIN_OBJECT_HEAD "PyETW_PROVIDER",
+    sizeof(PyETW_PROVIDER),
+    0,
+    PyETW_PROVIDER_dealloc,  /* tp_dealloc */
+    0,                       /* tp_print */
+    0,                       /* tp_getattr */
+    0,                       /* tp_setattr */
+    0,                       /* tp_compare */
+    0,                       /* tp_repr */
+    0,                       /* tp_as_number */
+    0,                       /* tp_as_sequence */
+    0,                       /* tp_as_mapping */
+    0,                       /* tp_hash */
+    0,                       /* tp_call */
+    0,                       /* tp_str */
+    PyObject_GenericGetAttr, /* tp_getattro */
+    0,                       /* tp_setattro */
+    0,                       /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,      /* tp_flags */
+    0,                       /* tp_doc */
+    0,                       /* tp_traverse */
+    0,                       /* tp_clear */
+    0,                       /* tp_richcompare */
+    0,                       /* tp_weaklistoffset */
+    0,                       /* tp_iter */
+    0,                       /* tp_iternext */
+    PyETW_PROVIDER_methods,  /* tp_methods */
+    PyETW_PROVIDER_members,  /* tp_members */
+};
+
+static BOOL PyETW_PROVIDER_Check(PyObject *self)
+{
+    if (((PyETW_PROVIDER *)self)->handle == 0) {
+        PyErr_SetString(PyExc_ValueError, "The provider has been closed");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// Failures of EventWrite that mean the event was dropped rather than that
+// the call was wrong.
+static BOOL etw_event_dropped(ULONG err)
+{
+    return err == ERROR_NOT_ENOUGH_MEMORY || err == ERROR_ARITHMETIC_OVERFLOW || err == ERROR_LOG_FILE_FULL;
+}
+
+// @pymethod <o PyETW_PROVIDER>|win32evtlog|EventRegister|Registers an ETW provider
+// @pyseeapi EventRegister
+static PyObject *PyEventRegister(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"ProviderId", NULL};
+    PyObject *obguid;
+    GUID guid;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O:EventRegister", keywords,
+                                     &obguid))  // @pyparm <o PyIID>|ProviderId||The GUID of the provider
+        return NULL;
+    if (!PyWinObject_AsIID(obguid, &guid))
+        return NULL;
+    PyETW_PROVIDER *ret = PyObject_New(PyETW_PROVIDER, &PyETW_PROVIDERType);
+    if (ret == NULL)
+        return NULL;
+    ret->handle = 0;
+    ret->obguid = PyWinObject_FromIID(guid);
+    if (ret->obguid == NULL) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    ULONG err = EventRegister(&guid, NULL, NULL, &ret->handle);
+    if (err != ERROR_SUCCESS) {
+        ret->handle = 0;
+        Py_DECREF(ret);
+        return PyWin_SetAPIError("EventRegister", err);
+    }
+    return (PyObject *)ret;
+}
+PyCFunction pfnPyEventRegister = (PyCFunction)PyEventRegister;
+
+// @pymethod bool|PyETW_PROVIDER|Enabled|Checks if any session is listening for an event
+// @comm With a descriptor, uses EventEnabled, otherwise EventProviderEnabled with the level and keyword.
+static PyObject *PyETW_PROVIDER_Enabled(PyObject *self, PyObject *args)
+{
+    PyObject *obdesc = Py_None;
+    unsigned char level = 0;
+    unsigned long long keyword = 0;
+    // @pyparm <o PyEVENT_DESCRIPTOR>|Descriptor|None|The event, or None to check a level and keyword
+    // @pyparm int|Level|0|
+    // @pyparm int|Keyword|0|
+    if (!PyArg_ParseTuple(args, "|ObK:Enabled", &obdesc, &level, &keyword))
+        return NULL;
+    if (!PyETW_PROVIDER_Check(self))
+        return NULL;
+    REGHANDLE h = ((PyETW_PROVIDER *)self)->handle;
+    BOOLEAN enabled;
+    if (obdesc == Py_None)
+        enabled = EventProviderEnabled(h, level, keyword);
+    else if (Py_TYPE(obdesc) != &PyEVENT_DESCRIPTORType) {
+        PyErr_SetString(PyExc_TypeError, "Descriptor must be a PyEVENT_DESCRIPTOR or None");
+        return NULL;
+    }
+    else
+        enabled = EventEnabled(h, &((PyEVENT_DESCRIPTOR *)obdesc)->desc);
+    return PyBool_FromLong(enabled);
+}
+
+// Fills one data descriptor from a Python object.  Scalars are stored in
+// *scalar, and views or allocated strings that must be released after the
+// write are recorded in the caller's arrays.
+static BOOL etw_fill_descriptor(PyObject *ob, char code, EVENT_DATA_DESCRIPTOR *edd, ULONGLONG *scalar,
+                                Py_buffer *views, int *nviews, wchar_t **strs, int *nstrs)
+{
+    if (ob == Py_None) {
+        EventDataDescCreate(edd, scalar, 0);
+        return TRUE;
+    }
+    if (code == 0) {
+        if (PyBool_Check(ob))
+            code = 't';
+        else if (PyLong_Check(ob))
+            code = 'q';
+        else if (PyFloat_Check(ob))
+            code = 'd';
+        else if (PyUnicode_Check(ob))
+            code = 'z';
+        else
+            code = 'y';
+    }
+    *scalar = 0;
+    ULONG size;
+    switch (code) {
+        case 'b':
+        case 'h':
+        case 'i':
+        case 'q':
+        case 't': {
+            long long v = PyLong_AsLongLong(ob);
+            if (v == -1 && PyErr_Occurred())
+                return FALSE;
+            size = code == 'b' ? 1 : code == 'h' ? 2 : code == 'q' ? 8 : 4;
+            if (code == 't')
+                v = v != 0;
+            // Little endian, so the low bytes come first
+            *(long long *)scalar = v;
+            break;
+        }
+        case 'B':
+        case 'H':
+        case 'I':
+        case 'Q':
+        case 'p': {
+            unsigned long long v = PyLong_AsUnsignedLongLongMask(ob);
+            if (v == (unsigned long long)-1 && PyErr_Occurred())
+                return FALSE;
+            size = code == 'B' ? 1 : code == 'H' ? 2 : code == 'I' ? 4 : code == 'Q' ? 8 : sizeof(void *);
+            *scalar = v;
+            break;
+        }
+        case 'f': {
+            double v = PyFloat_AsDouble(ob);
+            if (v == -1.0 && PyErr_Occurred())
+                return FALSE;
+            *(float *)scalar = (float)v;
+            size = sizeof(float);
+            break;
+        }
+        case 'd': {
+            double v = PyFloat_AsDouble(ob);
+            if (v == -1.0 && PyErr_Occurred())
+                return FALSE;
+            *(double *)scalar = v;
+            size = sizeof(double);
+            break;
+        }
+        case 'z': {
+            if (!PyUnicode_Check(ob)) {
+                PyErr_Format(PyExc_TypeError, "Layout 'z' requires a str, not %s", Py_TYPE(ob)->tp_name);
+                return FALSE;
+            }
+            if (PyUnicode_READY(ob) == -1)
+                return FALSE;
+            // Strings stored as UCS2 are already null terminated UTF-16
+            if (PyUnicode_KIND(ob) == PyUnicode_2BYTE_KIND) {
+                EventDataDescCreate(edd, PyUnicode_DATA(ob), (ULONG)((PyUnicode_GET_LENGTH(ob) + 1) * sizeof(WCHAR)));
+                return TRUE;
+            }
+            Py_ssize_t len;
+            wchar_t *s = PyUnicode_AsWideCharString(ob, &len);
+            if (s == NULL)
+                return FALSE;
+            strs[(*nstrs)++] = s;
+            EventDataDescCreate(edd, s, (ULONG)((len + 1) * sizeof(WCHAR)));
+            return TRUE;
+        }
+        default: {  // 'y'
+            Py_buffer *view = views + *nviews;
+            if (PyObject_GetBuffer(ob, view, PyBUF_SIMPLE) == -1)
+                return FALSE;
+            (*nviews)++;
+            EventDataDescCreate(edd, view->buf, (ULONG)view->len);
+            return TRUE;
+        }
+    }
+    EventDataDescCreate(edd, scalar, size);
+    return TRUE;
+}
+
+// @pymethod bool|PyETW_PROVIDER|Write|Writes an event
+// @rdesc Returns True if the event was written, or False if no session is listening for it or the
+// session's buffers are full.
+// @comm EventEnabled is checked first, so the data is not looked at unless the event is wanted.
+static PyObject *PyETW_PROVIDER_Write(PyObject *self, PyObject *args)
+{
+    // @pyparm <o PyEVENT_DESCRIPTOR>|Descriptor||The event
+    // @pyparm tuple|Data|None|The items of the event, converted as given by the descriptor's Layout
+    // The arguments are unpacked by hand, since this is called at very high rates.
+    Py_ssize_t nargs = PyTuple_GET_SIZE(args);
+    if (nargs < 1 || nargs > 2)
+        return PyErr_Format(PyExc_TypeError, "Write takes 1 or 2 arguments (%zd given)", nargs);
+    PyObject *obdesc = PyTuple_GET_ITEM(args, 0);
+    PyObject *obdata = nargs > 1 ? PyTuple_GET_ITEM(args, 1) : Py_None;
+    if (Py_TYPE(obdesc) != &PyEVENT_DESCRIPTORType) {
+        PyErr_SetString(PyExc_TypeError, "Descriptor must be a PyEVENT_DESCRIPTOR");
+        return NULL;
+    }
+    if (!PyETW_PROVIDER_Check(self))
+        return NULL;
+    REGHANDLE h = ((PyETW_PROVIDER *)self)->handle;
+    PyEVENT_DESCRIPTOR *desc = (PyEVENT_DESCRIPTOR *)obdesc;
+    if (!EventEnabled(h, &desc->desc))
+        Py_RETURN_FALSE;
+
+    Py_ssize_t nitems = 0;
+    PyObject **items = NULL;
+    TmpPyObject seq;
+    if (obdata != Py_None) {
+        seq = PySequence_Fast(obdata, "Data must be a tuple");
+        if (seq == NULL)
+            return NULL;
+        nitems = PySequence_Fast_GET_SIZE((PyObject *)seq);
+        items = PySequence_Fast_ITEMS((PyObject *)seq);
+    }
+    if (nitems > MAX_EVENT_DATA_DESCRIPTORS)
+        return PyErr_Format(PyExc_ValueError, "An event can have at most %d items", MAX_EVENT_DATA_DESCRIPTORS);
+    if (desc->layout && nitems != desc->nlayout)
+        return PyErr_Format(PyExc_ValueError, "The event's layout has %zd items, but %zd were given", desc->nlayout,
+                            nitems);
+
+    EVENT_DATA_DESCRIPTOR edd[MAX_EVENT_DATA_DESCRIPTORS];
+    ULONGLONG scalars[MAX_EVENT_DATA_DESCRIPTORS];
+    Py_buffer views[MAX_EVENT_DATA_DESCRIPTORS];
+    wchar_t *strs[MAX_EVENT_DATA_DESCRIPTORS];
+    int nviews = 0, nstrs = 0, i;
+    PyObject *ret = NULL;
+    for (i = 0; i < nitems; i++)
+        if (!etw_fill_descriptor(items[i], desc->layout ? desc->layout[i] : 0, edd + i, scalars + i, views, &nviews,
+                                 strs, &nstrs))
+            goto done;
+    ULONG err;
+    err = EventWrite(h, &desc->desc, (ULONG)nitems, nitems ? edd : NULL);
+    if (err == ERROR_SUCCESS)
+        ret = Py_True;
+    else if (etw_event_dropped(err))
+        ret = Py_False;
+    else
+        PyWin_SetAPIError("EventWrite", err);
+    Py_XINCREF(ret);
+done:
+    for (i = 0; i < nviews; i++) PyBuffer_Release(views + i);
+    for (i = 0; i < nstrs; i++) PyMem_Free(strs[i]);
+    return ret;
+}
+
+// @pymethod bool|PyETW_PROVIDER|WriteString|Writes an event holding only a string
+// @rdesc As for <om PyETW_PROVIDER.Write>
+// @pyseeapi EventWriteString
+static PyObject *PyETW_PROVIDER_WriteString(PyObject *self, PyObject *args)
+{
+    unsigned char level;
+    unsigned long long keyword;
+    PyObject *obstr;
+    // @pyparm int|Level||
+    // @pyparm int|Keyword||
+    // @pyparm str|String||
+    if (!PyArg_ParseTuple(args, "bKO:WriteString", &level, &keyword, &obstr))
+        return NULL;
+    if (!PyETW_PROVIDER_Check(self))
+        return NULL;
+    REGHANDLE h = ((PyETW_PROVIDER *)self)->handle;
+    if (!EventProviderEnabled(h, level, keyword))
+        Py_RETURN_FALSE;
+    TmpWCHAR str;
+    if (!PyWinObject_AsWCHAR(obstr, &str, FALSE))
+        return NULL;
+    ULONG err = EventWriteString(h, level, keyword, str);
+    if (err == ERROR_SUCCESS)
+        Py_RETURN_TRUE;
+    if (etw_event_dropped(err))
+        Py_RETURN_FALSE;
+    return PyWin_SetAPIError("EventWriteString", err);
+}
+
+// @pymethod |PyETW_PROVIDER|Close|Unregisters the provider
+static PyObject *PyETW_PROVIDER_Close(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":Close"))
+        return NULL;
+    PyETW_PROVIDER *This = (PyETW_PROVIDER *)self;
+    if (This->handle) {
+        ULONG err = EventUnregister(This->handle);
+        This->handle = 0;
+        if (err != ERROR_SUCCESS)
+            return PyWin_SetAPIError("EventUnregister", err);
+    }
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @object PyETW_TRACE_QUEUE|A real-time ETW consumer whose events are copied into a queue,
+// created by <om win32evtlog.OpenTraceQueued>.
+// @comm ProcessTrace runs on a thread of its own, which copies the header and data of each event,
+// and optionally its properties formatted by TDH, into a fixed size ring without acquiring the GIL.
+// Python reads the events in batches with <om PyETW_TRACE_QUEUE.Drain>.  ProcessTrace delivers
+// events one at a time, so the ring has a single writer and a single reader (serialized by the
+// GIL) and needs no lock.  When the ring is full new events are dropped and counted.
+struct EtwQueueEntry {
+    EVENT_HEADER header;
+    USHORT processor;
+    USHORT cbdata;  // user data, at the start of data
+    ULONG cbprops;  // decoded properties as name\0value\0 pairs, following the user data
+    BYTE *data;
+};
+
+struct PyETW_TRACE_QUEUE {
+    PyObject_HEAD TRACEHANDLE trace;
+    HANDLE hThread;
+    HANDLE hDataEvent;
+    EtwQueueEntry *entries;
+    LONG capacity;
+    volatile LONG head;     // next entry to be drained, only written by Drain
+    volatile LONG tail;     // next entry to be filled, only written by the trace thread
+    volatile LONG waiting;  // Drain is waiting for hDataEvent
+    volatile LONG running;
+    BOOL decode;
+    // Scratch buffers for TDH, only used by the trace thread
+    BYTE *info_buf;
+    ULONG info_size;
+    WCHAR *fmt_buf;
+    ULONG fmt_size;
+    WCHAR *props_buf;
+    ULONG props_size;
+    // Provider of the last drained event, since consecutive events mostly share one
+    GUID last_provider;
+    PyObject *oblast_provider;
+    LONGLONG delivered;
+    LONGLONG dropped;
+    LONGLONG decode_errors;
+    ULONG last_error;
+};
+
+#ifndef INVALID_PROCESSTRACE_HANDLE
+#define INVALID_PROCESSTRACE_HANDLE ((TRACEHANDLE)INVALID_HANDLE_VALUE)
+#endif
+
+// EventTraceGuid, the provider of the header event at the start of every trace
+static const GUID etw_trace_header_guid = {0x68fdd900, 0x4a3e, 0x11d1, {0x84, 0xf4, 0x00, 0x00, 0xf8, 0x04, 0x64, 0xe3}};
+
+static BOOL etw_grow(void **buf, ULONG *size, ULONG needed)
+{
+    if (needed <= *size)
+        return TRUE;
+    void *p = realloc(*buf, needed);
+    if (p == NULL)
+        return FALSE;
+    *buf = p;
+    *size = needed;
+    return TRUE;
+}
+
+// Formats the top level properties of an event into q->props_buf, stopping at
+// the first one whose size depends on another (structs, arrays and
+// parameterised lengths), since those need the whole schema walked.
+// Returns the number of bytes used.
+static ULONG etw_decode_properties(PyETW_TRACE_QUEUE *q, PEVENT_RECORD ev)
+{
+    ULONG size = q->info_size;
+    ULONG err = TdhGetEventInformation(ev, 0, NULL, (PTRACE_EVENT_INFO)q->info_buf, &size);
+    if (err == ERROR_INSUFFICIENT_BUFFER) {
+        if (!etw_grow((void **)&q->info_buf, &q->info_size, size))
+            err = ERROR_OUTOFMEMORY;
+        else
+            err = TdhGetEventInformation(ev, 0, NULL, (PTRACE_EVENT_INFO)q->info_buf, &size);
+    }
+    if (err != ERROR_SUCCESS) {
+        // Events without a manifest or MOF class still carry their raw data
+        q->decode_errors++;
+        q->last_error = err;
+        return 0;
+    }
+    PTRACE_EVENT_INFO info = (PTRACE_EVENT_INFO)q->info_buf;
+    ULONG ptrsize = (ev->EventHeader.Flags & EVENT_HEADER_FLAG_32_BIT_HEADER)   ? 4
+                    : (ev->EventHeader.Flags & EVENT_HEADER_FLAG_64_BIT_HEADER) ? 8
+                                                                                : sizeof(void *);
+    BYTE *p = (BYTE *)ev->UserData, *end = p + ev->UserDataLength;
+    ULONG used = 0;  // in WCHARs
+    for (ULONG i = 0; i < info->TopLevelPropertyCount; i++) {
+        EVENT_PROPERTY_INFO *pi = info->EventPropertyInfoArray + i;
+        if ((pi->Flags & (PropertyStruct | PropertyParamCount | PropertyParamLength)) || pi->count != 1)
+            break;
+        USHORT consumed = 0;
+        ULONG fmtsize = q->fmt_size;
+        err = TdhFormatProperty(info, NULL, ptrsize, pi->nonStructType.InType, pi->nonStructType.OutType, pi->length,
+                                (USHORT)(end - p), p, &fmtsize, q->fmt_buf, &consumed);
+        if (err == ERROR_INSUFFICIENT_BUFFER) {
+            if (!etw_grow((void **)&q->fmt_buf, &q->fmt_size, fmtsize))
+                break;
+            err = TdhFormatProperty(info, NULL, ptrsize, pi->nonStructType.InType, pi->nonStructType.OutType,
+                                    pi->length, (USHORT)(end - p), p, &fmtsize, q->fmt_buf, &consumed);
+        }
+        if (err != ERROR_SUCCESS) {
+            q->decode_errors++;
+            q->last_error = err;
+            break;
+        }
+        const WCHAR *name = (const WCHAR *)((BYTE *)info + pi->NameOffset);
+        size_t namelen = wcslen(name), valuelen = wcslen(q->fmt_buf);
+        if (!etw_grow((void **)&q->props_buf, &q->props_size,
+                      (ULONG)((used + namelen + valuelen + 2) * sizeof(WCHAR))))
+            break;
+        memcpy(q->props_buf + used, name, (namelen + 1) * sizeof(WCHAR));
+        used += (ULONG)namelen + 1;
+        memcpy(q->props_buf + used, q->fmt_buf, (valuelen + 1) * sizeof(WCHAR));
+        used += (ULONG)valuelen + 1;
+        p += consumed;
+    }
+    return used * sizeof(WCHAR);
+}
+
+static VOID WINAPI etw_event_callback(PEVENT_RECORD ev)
+{
+    PyETW_TRACE_QUEUE *q = (PyETW_TRACE_QUEUE *)ev->UserContext;
+    if (IsEqualGUID(ev->EventHeader.ProviderId, etw_trace_header_guid))
+        return;
+    if (q->tail - q->head >= q->capacity) {
+        q->dropped++;
+        return;
+    }
+    ULONG cbprops = q->decode ? etw_decode_properties(q, ev) : 0;
+    BYTE *data = NULL;
+    if (ev->UserDataLength + cbprops) {
+        data = (BYTE *)malloc(ev->UserDataLength + cbprops);
+        if (data == NULL) {
+            q->dropped++;
+            q->last_error = ERROR_OUTOFMEMORY;
+            return;
+        }
+        memcpy(data, ev->UserData, ev->UserDataLength);
+        if (cbprops)
+            memcpy(data + ev->UserDataLength, q->props_buf, cbprops);
+    }
+    EtwQueueEntry *e = q->entries + (q->tail % q->capacity);
+    e->header = ev->EventHeader;
+    e->processor = ev->BufferContext.ProcessorIndex;
+    e->cbdata = ev->UserDataLength;
+    e->cbprops = cbprops;
+    e->data = data;
+    q->delivered++;
+    // Full barrier, so the entry is complete before Drain can see it and
+    // waiting is read after the new tail is visible.
+    InterlockedIncrement(&q->tail);
+    if (q->waiting)
+        SetEvent(q->hDataEvent);
+}
+
+static DWORD WINAPI etw_process_thread(void *param)
+{
+    PyETW_TRACE_QUEUE *q = (PyETW_TRACE_QUEUE *)param;
+    TRACEHANDLE trace = q->trace;
+    ULONG err = ProcessTrace(&trace, 1, NULL, NULL);
+    if (err != ERROR_SUCCESS && err != ERROR_CANCELLED)
+        q->last_error = err;
+    InterlockedExchange(&q->running, 0);
+    SetEvent(q->hDataEvent);
+    return 0;
+}
+
+// Stops processing - events already queued stay in the queue.
+static void EtwTraceQueueClose(PyETW_TRACE_QUEUE *q)
+{
+    if (q->trace != INVALID_PROCESSTRACE_HANDLE) {
+        TRACEHANDLE trace = q->trace;
+        q->trace = INVALID_PROCESSTRACE_HANDLE;
+        Py_BEGIN_ALLOW_THREADS;
+        CloseTrace(trace);
+        Py_END_ALLOW_THREADS;
+    }
+    if (q->hThread) {
+        Py_BEGIN_ALLOW_THREADS;
+        WaitForSingleObject(q->hThread, INFINITE);
+        Py_END_ALLOW_THREADS;
+        CloseHandle(q->hThread);
+        q->hThread = NULL;
+    }
+}
+
+static void PyETW_TRACE_QUEUE_dealloc(PyObject *self)
+{
+    PyETW_TRACE_QUEUE *q = (PyETW_TRACE_QUEUE *)self;
+    EtwTraceQueueClose(q);
+    if (q->entries)
+        for (LONG i = q->head; i != q->tail; i++) free(q->entries[i % q->capacity].data);
+    free(q->entries);
+    free(q->info_buf);
+    free(q->fmt_buf);
+    free(q->props_buf);
+    if (q->hDataEvent)
+        CloseHandle(q->hDataEvent);
+    Py_XDECREF(q->oblast_provider);
+    PyObject_Del(self);
+}
+
+static PyObject *etw_entry_to_tuple(PyETW_TRACE_QUEUE *q, EtwQueueEntry *e)
+{
+    const EVENT_HEADER &h = e->header;
+    if (q->oblast_provider == NULL || !IsEqualGUID(h.ProviderId, q->last_provider)) {
+        PyObject *obguid = PyWinObject_FromIID(h.ProviderId);
+        if (obguid == NULL)
+            return NULL;
+        Py_XDECREF(q->oblast_provider);
+        q->oblast_provider = obguid;
+        q->last_provider = h.ProviderId;
+    }
+    PyObject *obprops;
+    if (!q->decode) {
+        Py_INCREF(Py_None);
+        obprops = Py_None;
+    }
+    else {
+        obprops = PyDict_New();
+        if (obprops == NULL)
+            return NULL;
+        const WCHAR *p = (const WCHAR *)(e->data + e->cbdata);
+        const WCHAR *end = (const WCHAR *)(e->data + e->cbdata + e->cbprops);
+        while (p < end) {
+            size_t namelen = wcslen(p);
+            const WCHAR *value = p + namelen + 1;
+            size_t valuelen = wcslen(value);
+            TmpPyObject obname = PyWinObject_FromWCHAR(p, (DWORD)namelen);
+            TmpPyObject obvalue = PyWinObject_FromWCHAR(value, (DWORD)valuelen);
+            if (obname == NULL || obvalue == NULL || PyDict_SetItem(obprops, obname, obvalue) == -1) {
+                Py_DECREF(obprops);
+                return NULL;
+            }
+            p = value + valuelen + 1;
+        }
+    }
+    PyObject *obdata = PyBytes_FromStringAndSize((char *)e->data, e->cbdata);
+    if (obdata == NULL) {
+        Py_DECREF(obprops);
+        return NULL;
+    }
+    const EVENT_DESCRIPTOR &d = h.EventDescriptor;
+    Py_INCREF(q->oblast_provider);
+    return Py_BuildValue("NHBBBBHKkkLHHNN", q->oblast_provider, d.Id, d.Version, d.Channel, d.Level, d.Opcode,
+                         d.Task, d.Keyword, h.ProcessId, h.ThreadId, h.TimeStamp.QuadPart, e->processor, h.Flags,
+                         obdata, obprops);
+}
+
+// @pymethod [tuple,...]|PyETW_TRACE_QUEUE|Drain|Removes events from the queue
+// @rdesc A list of events, oldest first.  Each is a tuple of (ProviderId, Id, Version, Channel, Level,
+// Opcode, Task, Keyword, ProcessId, ThreadId, TimeStamp, ProcessorIndex, Flags, UserData, Properties).
+// TimeStamp is in the clock units of the session, UserData is the raw event data as bytes, and
+// Properties is a dict of the event's formatted top level properties, or None unless DecodeProperties
+// was given to <om win32evtlog.OpenTraceQueued>.<nl>
+// Returns an empty list if no event arrived before the timeout.
+static PyObject *PyETW_TRACE_QUEUE_Drain(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Count", "Timeout", NULL};
+    PyETW_TRACE_QUEUE *q = (PyETW_TRACE_QUEUE *)self;
+    DWORD count = 0, timeout = 0;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|kk:Drain", keywords,
+            &count,     // @pyparm int|Count|0|Maximum number of events to return, 0 for all queued events
+            &timeout))  // @pyparm int|Timeout|0|Milliseconds to wait for an event if the queue is empty, -1 for infinite
+        return NULL;
+    if (q->head == q->tail && timeout && q->running) {
+        InterlockedExchange(&q->waiting, 1);
+        if (q->head == q->tail && q->running) {
+            Py_BEGIN_ALLOW_THREADS;
+            WaitForSingleObject(q->hDataEvent, timeout);
+            Py_END_ALLOW_THREADS;
+        }
+        InterlockedExchange(&q->waiting, 0);
+    }
+    LONG tail = q->tail;
+    MemoryBarrier();
+    LONG available = tail - q->head;
+    if (count && (LONG)count < available)
+        available = count;
+    PyObject *ret = PyList_New(available);
+    if (ret == NULL)
+        return NULL;
+    for (LONG i = 0; i < available; i++) {
+        EtwQueueEntry *e = q->entries + (q->head % q->capacity);
+        PyObject *row = etw_entry_to_tuple(q, e);
+        if (row == NULL) {
+            // Entries already taken are lost, but the queue stays consistent.
+            Py_DECREF(ret);
+            return NULL;
+        }
+        PyList_SET_ITEM(ret, i, row);
+        free(e->data);
+        e->data = NULL;
+        InterlockedIncrement(&q->head);
+    }
+    return ret;
+}
+
+// @pymethod |PyETW_TRACE_QUEUE|Close|Stops processing the trace
+// @comm Events already queued can still be drained.  The session itself is not stopped.
+static PyObject *PyETW_TRACE_QUEUE_Close(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":Close"))
+        return NULL;
+    EtwTraceQueueClose((PyETW_TRACE_QUEUE *)self);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static struct PyMethodDef PyETW_TRACE_QUEUE_methods[] = {
+    {"Drain", (PyCFunction)PyETW_TRACE_QUEUE_Drain, METH_VARARGS | METH_KEYWORDS},  // @pymeth Drain|Removes events from the queue
+    {"Close", PyETW_TRACE_QUEUE_Close, METH_VARARGS},  // @pymeth Close|Stops processing the trace
+    {NULL}};
+
+#define OFF(e) offsetof(PyETW_TRACE_QUEUE, e)
+static struct PyMemberDef PyETW_TRACE_QUEUE_members[] = {
+    // @prop int|capacity|Maximum number of queued events
+    {"capacity", T_LONG, OFF(capacity), READONLY},
+    // @prop int|delivered|Number of events queued since processing started
+    {"delivered", T_LONGLONG, OFF(delivered), READONLY},
+    // @prop int|dropped|Number of events discarded because the queue was full
+    {"dropped", T_LONGLONG, OFF(dropped), READONLY},
+    // @prop int|decode_errors|Number of events whose properties could not be decoded
+    {"decode_errors", T_LONGLONG, OFF(decode_errors), READONLY},
+    // @prop int|last_error|The most recent error from decoding or ProcessTrace
+    {"last_error", T_ULONG, OFF(last_error), READONLY},
+    // @prop int|running|Nonzero until ProcessTrace returns, when the session stops or the queue is closed
+    {"running", T_LONG, OFF(running), READONLY},
+    {NULL}};
+#undef OFF
+
+PyTypeObject PyETW_TRACE_QUEUEType = {
+    PYWIN_OBJECT_HEAD "PyETW_TRACE_QUEUE",
+    sizeof(PyETW_TRACE_QUEUE),
+    0,
+    PyETW_TRACE_QUEUE_dealloc,  /* tp_dealloc */
+    0,                          /* tp_print */
+    0,                          /* tp_getattr */
+    0,                          /* tp_setattr */
+    0,                          /* tp_compare */
+    0,                          /* tp_repr */
+    0,                          /* tp_as_number */
+    0,                          /* tp_as_sequence */
+    0,                          /* tp_as_mapping */
+    0,                          /* tp_hash */
+    0,                          /* tp_call */
+    0,                          /* tp_str */
+    PyObject_GenericGetAttr,    /* tp_getattro */
+    0,                          /* tp_setattro */
+    0,                          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,         /* tp_flags */
+    0,                          /* tp_doc */
+    0,                          /* tp_traverse */
+    0,                          /* tp_clear */
+    0,                          /* tp_richcompare */
+    0,                          /* tp_weaklistoffset */
+    0,                          /* tp_iter */
+    0,                          /* tp_iternext */
+    PyETW_TRACE_QUEUE_methods,  /* tp_methods */
+    PyETW_TRACE_QUEUE_members,  /* tp_members */
+};
+
+// @pymethod <o PyETW_TRACE_QUEUE>|win32evtlog|OpenTraceQueued|Consumes a trace session or log file into a queue
+// @comm Accepts keyword args
+// @comm Exactly one of LoggerName and LogFileName must be given.  The session must already be
+// running, for instance started with logman or xperf.  The GIL is never acquired per event.
+// @pyseeapi OpenTrace
+// @pyseeapi ProcessTrace
+static PyObject *PyOpenTraceQueued(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"LoggerName", "LogFileName", "QueueSize", "DecodeProperties", NULL};
+    PyObject *oblogger = Py_None, *oblogfile = Py_None;
+    DWORD queue_size = 4096;
+    BOOL decode = FALSE;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|OOki:OpenTraceQueued", keywords,
+            &oblogger,     // @pyparm str|LoggerName|None|Name of a real-time session, eg 'NT Kernel Logger'
+            &oblogfile,    // @pyparm str|LogFileName|None|An .etl file to read instead of a session
+            &queue_size,   // @pyparm int|QueueSize|4096|Maximum number of events held in the queue
+            &decode))      // @pyparm bool|DecodeProperties|False|Format each event's properties using TDH
+        return NULL;
+    if ((oblogger == Py_None) == (oblogfile == Py_None))
+        return PyErr_Format(PyExc_ValueError, "Exactly one of LoggerName and LogFileName must be given");
+    if (queue_size == 0 || queue_size > 0x10000000)
+        return PyErr_Format(PyExc_ValueError, "QueueSize must be between 1 and %d", 0x10000000);
+    TmpWCHAR logger, logfile;
+    if (!PyWinObject_AsWCHAR(oblogger, &logger, TRUE) || !PyWinObject_AsWCHAR(oblogfile, &logfile, TRUE))
+        return NULL;
+
+    PyETW_TRACE_QUEUE *q = PyObject_New(PyETW_TRACE_QUEUE, &PyETW_TRACE_QUEUEType);
+    if (q == NULL)
+        return NULL;
+    memset((char *)q + sizeof(PyObject), 0, sizeof(PyETW_TRACE_QUEUE) - sizeof(PyObject));
+    q->trace = INVALID_PROCESSTRACE_HANDLE;
+    q->decode = decode;
+    q->capacity = queue_size;
+    q->entries = (EtwQueueEntry *)malloc(queue_size * sizeof(EtwQueueEntry));
+    if (q->entries == NULL) {
+        Py_DECREF(q);
+        return PyErr_NoMemory();
+    }
+    q->hDataEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (q->hDataEvent == NULL) {
+        DWORD err = GetLastError();
+        Py_DECREF(q);
+        return PyWin_SetAPIError("CreateEvent", err);
+    }
+    EVENT_TRACE_LOGFILEW lf;
+    memset(&lf, 0, sizeof(lf));
+    lf.LoggerName = logger;
+    lf.LogFileName = logfile;
+    lf.ProcessTraceMode = PROCESS_TRACE_MODE_EVENT_RECORD | (oblogger != Py_None ? PROCESS_TRACE_MODE_REAL_TIME : 0);
+    lf.EventRecordCallback = etw_event_callback;
+    lf.Context = q;
+    TRACEHANDLE trace;
+    Py_BEGIN_ALLOW_THREADS;
+    trace = OpenTraceW(&lf);
+    Py_END_ALLOW_THREADS;
+    if (trace == INVALID_PROCESSTRACE_HANDLE) {
+        DWORD err = GetLastError();
+        Py_DECREF(q);
+        return PyWin_SetAPIError("OpenTrace", err);
+    }
+    q->trace = trace;
+    q->running = 1;
+    q->hThread = CreateThread(NULL, 0, etw_process_thread, q, 0, NULL);
+    if (q->hThread == NULL) {
+        q->running = 0;
+        PyWin_SetAPIError("CreateThread");
+        Py_DECREF(q);
+        return NULL;
+    }
+    return (PyObject *)q;
+}
+PyCFunction pfnPyOpenTraceQueued = (PyCFunction)PyOpenTraceQueued;
+
+// Readies the types and adds the constants, called from the module init.
+BOOL PyWinETW_Init(PyObject *dict)
+{
+    if (PyType_Ready(&PyEVENT_DESCRIPTORType) == -1 || PyType_Ready(&PyETW_PROVIDERType) == -1 ||
+        PyType_Ready(&PyETW_TRACE_QUEUEType) == -1)
+        return FALSE;
+    static const struct {
+        const char *name;
+        long value;
+    } consts[] = {
+        {"WINEVENT_LEVEL_LOG_ALWAYS", WINEVENT_LEVEL_LOG_ALWAYS},
+        {"WINEVENT_LEVEL_CRITICAL", WINEVENT_LEVEL_CRITICAL},
+        {"WINEVENT_LEVEL_ERROR", WINEVENT_LEVEL_ERROR},
+        {"WINEVENT_LEVEL_WARNING", WINEVENT_LEVEL_WARNING},
+        {"WINEVENT_LEVEL_INFO", WINEVENT_LEVEL_INFO},
+        {"WINEVENT_LEVEL_VERBOSE", WINEVENT_LEVEL_VERBOSE},
+        {"MAX_EVENT_DATA_DESCRIPTORS", MAX_EVENT_DATA_DESCRIPTORS},
+    };
+    for (int i = 0; i < sizeof(consts) / sizeof(consts[0]); i++) {
+        PyObject *ob = PyLong_FromLong(consts[i].value);
+        if (ob == NULL || PyDict_SetItemString(dict, consts[i].name, ob) == -1) {
+            Py_XDECREF(ob);
+            return FALSE;
+        }
+        Py_DECREF(ob);
+    }
+    return TRUE;
+}
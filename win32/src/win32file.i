@@ -25,7 +25,9 @@
 #ifndef MS_WINCE
 //#define FAR
 #ifndef _WIN32_WINNT
-#define _WIN32_WINNT 0x0600
+// 0x0602 for the Registered I/O declarations in mswsock.h - the functions
+// themselves are only located at runtime.
+#define _WIN32_WINNT 0x0602
 #endif
 
 // We use the deprecated API
@@ -52,6 +54,7 @@
 #include "winbase.h"
 #include "assert.h"
 #include <stddef.h>
+#include <wctype.h>
 #include "sfc.h"
 
 // pyconfig.h defines socklen_t, which conflicts with below header
@@ -512,6 +515,653 @@ PyCFunction pfnpy_DeviceIoControl=(PyCFunction)py_DeviceIoControl;
 %}
 %native(DeviceIoControl) pfnpy_DeviceIoControl;
 
+// @object PyIoctlDescriptor|A control code paired with the layouts of its input and
+// output structures, as returned by <om win32file.CreateIoctlDescriptor>.
+// @comm Calling the object (or <om PyIoctlDescriptor.Call>) packs the arguments into the
+// input structure, calls DeviceIoControl and decodes the output natively, so no struct
+// module calls are needed.  The input and output buffers belong to the descriptor and
+// are reused by every call - a call made while another thread is using them gets
+// temporary buffers.
+// <nl>Layouts are described with a subset of the struct module's format codes -
+// x, c, b, B, ?, h, H, i, I, l, L, q, Q, n, N, P, f, d and s - plus W, a fixed
+// size WCHAR array (whose repeat count is its length in characters) decoded as a
+// string ending at the first NUL.  l and L are 4 bytes, as in C on Windows.  The
+// format may start with @ (the default) for C alignment, where the size is also
+// padded to the strictest alignment as a C compiler would, or with = or < for no
+// padding at all.
+// <nl>A structure ending in a variable length array is described with ItemFormat,
+// for the layout of each element, and CountIndex, the index of the field of OutFormat
+// which holds the number of elements.  The array starts at the first offset after
+// the fields of OutFormat which is suitably aligned for an element.  The result is then
+// (header, [item, ...]), and if the output buffer is too small it is grown and the
+// call repeated.
+%{
+typedef struct {
+	char code;
+	DWORD count;		// the length of an 's' or 'W' field, otherwise 1
+	DWORD offset;
+} PyIoctlField;
+
+typedef struct {
+	PyIoctlField *fields;
+	int numFields;
+	DWORD end;		// the offset after the last field
+	DWORD size;		// end, padded to align for C layouts
+	DWORD align;
+	BOOL bNative;
+} PyIoctlLayout;
+
+typedef struct {
+	PyObject_HEAD
+	DWORD code;
+	BOOL bRawIn;		// InFormat was None - the input is a buffer
+	PyIoctlLayout inLayout, outLayout, itemLayout;
+	BOOL bOut, bItems;
+	int countIndex;
+	PyObject *obRecordType;
+	PyObject *obItemType;
+	BYTE *inBuf;
+	BYTE *outBuf;
+	DWORD outSize;
+	BOOL bBusy;
+	LONG calls;		// statistics
+	LONG grows;
+} PyIoctlDescriptor;
+
+extern PyTypeObject PyIoctlDescriptor_Type;
+
+// The largest output buffer a call will grow to.
+#define IOCTL_MAX_OUT_SIZE (64 * 1024 * 1024)
+
+static DWORD ioctl_code_size(char code)
+{
+	switch (code) {
+		case 'x': case 'c': case 'b': case 'B': case '?': case 's':
+			return 1;
+		case 'h': case 'H': case 'W':
+			return 2;
+		case 'i': case 'I': case 'l': case 'L': case 'f':
+			return 4;
+		case 'q': case 'Q': case 'd':
+			return 8;
+		case 'n': case 'N': case 'P':
+			return sizeof(void *);
+	}
+	return 0;
+}
+
+static BOOL ioctl_parse_layout(PyObject *obFormat, PyIoctlLayout *layout, const char *argName)
+{
+	memset(layout, 0, sizeof(*layout));
+	layout->bNative = TRUE;
+	layout->align = 1;
+	if (!PyUnicode_Check(obFormat)) {
+		PyErr_Format(PyExc_TypeError, "%s must be a string or None, not %s", argName, obFormat->ob_type->tp_name);
+		return FALSE;
+	}
+	const char *fmt = PyUnicode_AsUTF8(obFormat);
+	if (fmt == NULL)
+		return FALSE;
+	const char *p = fmt;
+	if (*p == '@')
+		p++;
+	else if (*p == '=' || *p == '<') {
+		layout->bNative = FALSE;
+		p++;
+	}
+	// Two passes - the first counts the fields, the second fills them in.
+	for (int pass=0;pass<2;pass++) {
+		DWORD offset = 0;
+		int numFields = 0;
+		for (const char *q = p;*q;) {
+			if (*q == ' ') {
+				q++;
+				continue;
+			}
+			DWORD count = 1;
+			if (*q >= '0' && *q <= '9') {
+				count = 0;
+				while (*q >= '0' && *q <= '9') {
+					count = count * 10 + (*q++ - '0');
+					if (count > 0xFFFFFF) {
+						PyErr_Format(PyExc_ValueError, "%s: repeat count too large", argName);
+						return FALSE;
+					}
+				}
+			}
+			char code = *q++;
+			DWORD size = ioctl_code_size(code);
+			if (size == 0) {
+				PyErr_Format(PyExc_ValueError, "%s: bad format code '%c'", argName, code ? code : '0');
+				return FALSE;
+			}
+			if (layout->bNative && code != 'x') {
+				offset = (offset + size - 1) & ~(size - 1);
+				if (pass == 0 && size > layout->align)
+					layout->align = size;
+			}
+			if (code == 'x')
+				offset += count;
+			else if (code == 's' || code == 'W') {
+				if (pass) {
+					layout->fields[numFields].code = code;
+					layout->fields[numFields].count = count;
+					layout->fields[numFields].offset = offset;
+				}
+				numFields++;
+				offset += count * size;
+			} else {
+				for (DWORD i=0;i<count;i++) {
+					if (pass) {
+						layout->fields[numFields].code = code;
+						layout->fields[numFields].count = 1;
+						layout->fields[numFields].offset = offset;
+					}
+					numFields++;
+					offset += size;
+				}
+			}
+			if (offset > IOCTL_MAX_OUT_SIZE) {
+				PyErr_Format(PyExc_ValueError, "%s describes a structure which is too large", argName);
+				return FALSE;
+			}
+		}
+		if (pass == 0) {
+			layout->numFields = numFields;
+			layout->end = offset;
+			layout->size = layout->bNative ? (offset + layout->align - 1) & ~(layout->align - 1) : offset;
+			layout->fields = (PyIoctlField *)malloc((numFields ? numFields : 1) * sizeof(PyIoctlField));
+			if (layout->fields == NULL) {
+				PyErr_NoMemory();
+				return FALSE;
+			}
+		}
+	}
+	return TRUE;
+}
+
+static PyObject *ioctl_decode_field(const PyIoctlField *f, const BYTE *p)
+{
+	p += f->offset;
+	switch (f->code) {
+		case 'c': return PyBytes_FromStringAndSize((const char *)p, 1);
+		case 'b': return PyLong_FromLong(*(const signed char *)p);
+		case 'B': return PyLong_FromLong(*p);
+		case '?': return PyBool_FromLong(*p);
+		case 's': return PyBytes_FromStringAndSize((const char *)p, f->count);
+	}
+	// Fields may be unaligned in packed layouts.
+	union {
+		SHORT h; USHORT H; LONG i; ULONG I; LONGLONG q; ULONGLONG Q;
+		SSIZE_T n; SIZE_T N; float f; double d;
+	} v;
+	memcpy(&v, p, ioctl_code_size(f->code));
+	switch (f->code) {
+		case 'h': return PyLong_FromLong(v.h);
+		case 'H': return PyLong_FromLong(v.H);
+		case 'i': case 'l': return PyLong_FromLong(v.i);
+		case 'I': case 'L': return PyLong_FromUnsignedLong(v.I);
+		case 'q': return PyLong_FromLongLong(v.q);
+		case 'Q': return PyLong_FromUnsignedLongLong(v.Q);
+		case 'n': return PyLong_FromSsize_t(v.n);
+		case 'N': case 'P': return PyLong_FromSize_t(v.N);
+		case 'f': return PyFloat_FromDouble(v.f);
+		case 'd': return PyFloat_FromDouble(v.d);
+		case 'W': {
+			const WCHAR *s = (const WCHAR *)p;
+			DWORD len = 0;
+			WCHAR c;
+			while (len < f->count) {
+				memcpy(&c, s + len, sizeof(c));
+				if (c == 0)
+					break;
+				len++;
+			}
+			// Copied, as the array may be unaligned.
+			WCHAR *tmp = (WCHAR *)malloc((len + 1) * sizeof(WCHAR));
+			if (tmp == NULL)
+				return PyErr_NoMemory();
+			memcpy(tmp, s, len * sizeof(WCHAR));
+			PyObject *ret = PyWinObject_FromWCHAR(tmp, len);
+			free(tmp);
+			return ret;
+		}
+	}
+	return PyErr_Format(PyExc_SystemError, "Bad ioctl field code '%c'", f->code);
+}
+
+static BOOL ioctl_encode_field(const PyIoctlField *f, PyObject *ob, BYTE *p)
+{
+	p += f->offset;
+	DWORD size = ioctl_code_size(f->code);
+	switch (f->code) {
+		case 'c': case 's': {
+			if (!PyBytes_Check(ob) || (f->code == 'c' && PyBytes_GET_SIZE(ob) != 1)) {
+				PyErr_Format(PyExc_TypeError, "format '%c' requires a bytes object%s",
+					f->code, f->code == 'c' ? " of length 1" : "");
+				return FALSE;
+			}
+			Py_ssize_t len = PyBytes_GET_SIZE(ob);
+			if (len > (Py_ssize_t)f->count)
+				len = f->count;
+			memcpy(p, PyBytes_AS_STRING(ob), len);
+			return TRUE;
+		}
+		case 'W': {
+			WCHAR *s;
+			DWORD len;
+			if (!PyWinObject_AsWCHAR(ob, &s, FALSE, &len))
+				return FALSE;
+			if (len > f->count)
+				len = f->count;
+			memcpy(p, s, len * sizeof(WCHAR));
+			PyWinObject_FreeWCHAR(s);
+			return TRUE;
+		}
+		case '?': {
+			int b = PyObject_IsTrue(ob);
+			if (b == -1)
+				return FALSE;
+			*p = (BYTE)b;
+			return TRUE;
+		}
+		case 'f': case 'd': {
+			double d = PyFloat_AsDouble(ob);
+			if (d == -1.0 && PyErr_Occurred())
+				return FALSE;
+			if (f->code == 'f') {
+				float fl = (float)d;
+				memcpy(p, &fl, sizeof(fl));
+			} else
+				memcpy(p, &d, sizeof(d));
+			return TRUE;
+		}
+	}
+	// Integers - negative values are stored as two's complement, so both signed
+	// and unsigned values are accepted for any of the codes.
+	PyObject *obIndex = PyNumber_Index(ob);
+	if (obIndex == NULL)
+		return FALSE;
+	ULONGLONG v = PyLong_AsUnsignedLongLongMask(obIndex);
+	Py_DECREF(obIndex);
+	if (v == (ULONGLONG)-1 && PyErr_Occurred())
+		return FALSE;
+	memcpy(p, &v, size);	// little endian
+	return TRUE;
+}
+
+// Returns a new tuple of the fields at p, passed through obType if it isn't NULL.
+static PyObject *ioctl_decode(const PyIoctlLayout *layout, const BYTE *p, PyObject *obType)
+{
+	PyObject *ret = PyTuple_New(layout->numFields);
+	if (ret == NULL)
+		return NULL;
+	for (int i=0;i<layout->numFields;i++) {
+		PyObject *ob = ioctl_decode_field(layout->fields + i, p);
+		if (ob == NULL) {
+			Py_DECREF(ret);
+			return NULL;
+		}
+		PyTuple_SET_ITEM(ret, i, ob);
+	}
+	if (obType) {
+		PyObject *record = PyObject_Call(obType, ret, NULL);
+		Py_DECREF(ret);
+		ret = record;
+	}
+	return ret;
+}
+
+static PyObject *ioctl_decode_output(PyIoctlDescriptor *d, const BYTE *buf, DWORD nbytes)
+{
+	if (!d->bOut && !d->bItems)
+		return PyBytes_FromStringAndSize((const char *)buf, nbytes);
+	PyObject *header = NULL;
+	DWORD start = 0, count = 0xFFFFFFFF;
+	if (d->bOut) {
+		if (nbytes < d->outLayout.end)
+			return PyErr_Format(PyExc_ValueError, "DeviceIoControl returned %u bytes, less than the %u bytes of OutFormat",
+				nbytes, d->outLayout.end);
+		header = ioctl_decode(&d->outLayout, buf, d->bItems ? NULL : d->obRecordType);
+		if (header == NULL || !d->bItems)
+			return header;
+		start = d->outLayout.end;
+		if (d->itemLayout.bNative)
+			start = (start + d->itemLayout.align - 1) & ~(d->itemLayout.align - 1);
+		count = PyLong_AsUnsignedLong(PyTuple_GET_ITEM(header, d->countIndex));
+		if (count == (DWORD)-1 && PyErr_Occurred()) {
+			Py_DECREF(header);
+			return NULL;
+		}
+		if (d->obRecordType) {
+			PyObject *record = PyObject_Call(d->obRecordType, header, NULL);
+			Py_DECREF(header);
+			if ((header = record) == NULL)
+				return NULL;
+		}
+	}
+	// A well formed result never claims more elements than were returned.
+	DWORD stride = d->itemLayout.size ? d->itemLayout.size : 1;
+	DWORD avail = nbytes > start ? (nbytes - start) / stride : 0;
+	if (count > avail)
+		count = avail;
+	PyObject *items = PyList_New(count);
+	if (items == NULL) {
+		Py_XDECREF(header);
+		return NULL;
+	}
+	for (DWORD i=0;i<count;i++) {
+		PyObject *item = ioctl_decode(&d->itemLayout, buf + start + i * stride, d->obItemType);
+		if (item == NULL) {
+			Py_DECREF(items);
+			Py_XDECREF(header);
+			return NULL;
+		}
+		PyList_SET_ITEM(items, i, item);
+	}
+	if (header == NULL)
+		return items;
+	return Py_BuildValue("NN", header, items);
+}
+
+// Issues the ioctl for one device.  args are the values for InFormat, or the
+// optional input buffer.
+static PyObject *ioctl_call(PyIoctlDescriptor *d, HANDLE hDevice, PyObject *args, Py_ssize_t first)
+{
+	Py_ssize_t nargs = PyTuple_GET_SIZE(args) - first;
+	PyWinBufferView in_view;
+	if (d->bRawIn) {
+		if (nargs > 1)
+			return PyErr_Format(PyExc_TypeError, "This descriptor takes an optional input buffer, not %zd arguments", nargs);
+		if (!in_view.init(nargs ? PyTuple_GET_ITEM(args, first) : Py_None, false, true))
+			return NULL;
+	} else if (nargs != d->inLayout.numFields)
+		return PyErr_Format(PyExc_TypeError, "InFormat needs %d values, but %zd were given", d->inLayout.numFields, nargs);
+
+	BOOL bShared = !d->bBusy;
+	BYTE *inBuf = NULL, *outBuf;
+	DWORD outSize = d->outSize;
+	if (bShared) {
+		d->bBusy = TRUE;
+		inBuf = d->inBuf;
+		outBuf = d->outBuf;
+	} else {
+		if (!d->bRawIn && (inBuf = (BYTE *)malloc(d->inLayout.size ? d->inLayout.size : 1)) == NULL)
+			return PyErr_NoMemory();
+		if ((outBuf = (BYTE *)malloc(outSize ? outSize : 1)) == NULL) {
+			free(inBuf);
+			return PyErr_NoMemory();
+		}
+	}
+	PyObject *ret = NULL;
+	const void *in = in_view.ptr();
+	DWORD inSize = in_view.len();
+	if (!d->bRawIn) {
+		memset(inBuf, 0, d->inLayout.size);
+		for (int i=0;i<d->inLayout.numFields;i++)
+			if (!ioctl_encode_field(d->inLayout.fields + i, PyTuple_GET_ITEM(args, first + i), inBuf))
+				goto done;
+		in = inBuf;
+		inSize = d->inLayout.size;
+	}
+	for (;;) {
+		DWORD nbytes = 0, err = 0;
+		BOOL ok;
+		Py_BEGIN_ALLOW_THREADS
+		ok = DeviceIoControl(hDevice, d->code, (void *)in, inSize, outSize ? outBuf : NULL, outSize, &nbytes, NULL);
+		if (!ok)
+			err = GetLastError();
+		Py_END_ALLOW_THREADS
+		d->calls++;
+		if (!ok && (err == ERROR_INSUFFICIENT_BUFFER || (err == ERROR_MORE_DATA && d->bItems))
+			&& outSize && outSize < IOCTL_MAX_OUT_SIZE) {
+			BYTE *p = (BYTE *)realloc(outBuf, outSize * 2);
+			if (p == NULL) {
+				PyErr_NoMemory();
+				break;
+			}
+			outBuf = p;
+			outSize *= 2;
+			d->grows++;
+			continue;
+		}
+		if (!ok)
+			PyWin_SetAPIError("DeviceIoControl", err);
+		else if (outSize == 0) {
+			Py_INCREF(Py_None);
+			ret = Py_None;
+		} else
+			ret = ioctl_decode_output(d, outBuf, nbytes);
+		break;
+	}
+done:
+	if (bShared) {
+		// Keep a grown buffer for the next call.
+		d->outBuf = outBuf;
+		d->outSize = outSize;
+		d->bBusy = FALSE;
+	} else {
+		free(inBuf);
+		free(outBuf);
+	}
+	return ret;
+}
+
+static void ioctl_dealloc(PyObject *ob)
+{
+	PyIoctlDescriptor *d = (PyIoctlDescriptor *)ob;
+	free(d->inLayout.fields);
+	free(d->outLayout.fields);
+	free(d->itemLayout.fields);
+	free(d->inBuf);
+	free(d->outBuf);
+	Py_XDECREF(d->obRecordType);
+	Py_XDECREF(d->obItemType);
+	PyObject_Del(ob);
+}
+
+// @pymethod object|PyIoctlDescriptor|Call|Sends the control code to a device and decodes the result.
+// @comm The object can also be called directly, with the same arguments.
+// @rdesc The decoded output - a tuple (or RecordType instance) for OutFormat, a
+// list of items for ItemFormat alone, or (header, [item, ...]) for both.  With
+// no output layout the output is returned as bytes, or None if OutSize is 0.
+static PyObject *ioctl_Call(PyObject *self, PyObject *args)
+{
+	HANDLE hDevice;
+	if (PyTuple_GET_SIZE(args) < 1)
+		return PyErr_Format(PyExc_TypeError, "Call() needs a device handle");
+	// @pyparm <o PyHANDLE>|Device||Handle to a file, device, or volume
+	// @pyparm object|*args||The values of the fields of InFormat, or if InFormat is None, an optional input buffer.
+	if (!PyWinObject_AsHANDLE(PyTuple_GET_ITEM(args, 0), &hDevice))
+		return NULL;
+	return ioctl_call((PyIoctlDescriptor *)self, hDevice, args, 1);
+}
+
+static PyObject *ioctl_tp_call(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	if (kwargs && PyDict_Size(kwargs))
+		return PyErr_Format(PyExc_TypeError, "Keyword arguments are not accepted");
+	return ioctl_Call(self, args);
+}
+
+// @pymethod [object, ...]|PyIoctlDescriptor|CallMany|Sends the control code to each of a sequence of devices.
+// @rdesc A list with the result for each device, in order.  A device for which
+// DeviceIoControl failed has the <o pywintypes.error> instance in its place,
+// rather than it being raised.
+static PyObject *ioctl_CallMany(PyObject *self, PyObject *args)
+{
+	PyObject *obDevices, *obArgs = NULL;
+	if (!PyArg_ParseTuple(args, "O|O!:CallMany",
+		&obDevices, // @pyparm [<o PyHANDLE>, ...]|Devices||The device handles.
+		&PyTuple_Type, &obArgs)) // @pyparm tuple|args|()|The arguments passed to each call, as for <om PyIoctlDescriptor.Call>.
+		return NULL;
+	PyObject *seq = PySequence_Fast(obDevices, "Devices must be a sequence of handles");
+	if (seq == NULL)
+		return NULL;
+	PyObject *callArgs = obArgs ? obArgs : PyTuple_New(0);
+	Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+	PyObject *ret = callArgs ? PyList_New(n) : NULL;
+	for (Py_ssize_t i=0;ret && i<n;i++) {
+		HANDLE hDevice;
+		PyObject *result = NULL;
+		if (PyWinObject_AsHANDLE(PySequence_Fast_GET_ITEM(seq, i), &hDevice))
+			result = ioctl_call((PyIoctlDescriptor *)self, hDevice, callArgs, 0);
+		if (result == NULL && PyErr_ExceptionMatches(PyWinExc_ApiError)) {
+			PyObject *type, *value, *tb;
+			PyErr_Fetch(&type, &value, &tb);
+			PyErr_NormalizeException(&type, &value, &tb);
+			Py_XDECREF(type);
+			Py_XDECREF(tb);
+			result = value;
+		}
+		if (result == NULL) {
+			Py_CLEAR(ret);
+			break;
+		}
+		PyList_SET_ITEM(ret, i, result);
+	}
+	if (obArgs == NULL)
+		Py_XDECREF(callArgs);
+	Py_DECREF(seq);
+	return ret;
+}
+
+static PyMethodDef ioctl_methods[] = {
+	{"Call", ioctl_Call, METH_VARARGS}, // @pymeth Call|Sends the control code to a device.
+	{"CallMany", ioctl_CallMany, METH_VARARGS}, // @pymeth CallMany|Sends the control code to each of a sequence of devices.
+	{NULL}
+};
+
+#undef OFF
+#define OFF(e) offsetof(PyIoctlDescriptor, e)
+static PyMemberDef ioctl_members[] = {
+	{"IoControlCode", T_ULONG, OFF(code), READONLY}, // @prop int|IoControlCode|The control code.
+	{"InSize", T_ULONG, OFF(inLayout.size), READONLY}, // @prop int|InSize|The size of the input structure.
+	{"OutSize", T_ULONG, OFF(outSize), READONLY}, // @prop int|OutSize|The current size of the output buffer.
+	{"calls", T_LONG, OFF(calls), READONLY}, // @prop int|calls|The number of DeviceIoControl calls made.
+	{"grows", T_LONG, OFF(grows), READONLY}, // @prop int|grows|The number of times a call was repeated with a larger output buffer.
+	{NULL}
+};
+#undef OFF
+
+PyTypeObject PyIoctlDescriptor_Type = {
+	PYWIN_OBJECT_HEAD
+	"PyIoctlDescriptor",			/* tp_name */
+	sizeof(PyIoctlDescriptor),		/* tp_basicsize */
+	0,					/* tp_itemsize */
+	ioctl_dealloc,				/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	0,					/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	ioctl_tp_call,				/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	0,					/* tp_iter */
+	0,					/* tp_iternext */
+	ioctl_methods,				/* tp_methods */
+	ioctl_members,				/* tp_members */
+	0,					/* tp_getset */
+};
+
+// @pyswig <o PyIoctlDescriptor>|CreateIoctlDescriptor|Describes a control code and the
+// layouts of its input and output, for repeated calls with native decoding.
+// @comm Accepts keyword args.
+// @comm For example, IOCTL_DISK_GET_LENGTH_INFO can be described as
+// CreateIoctlDescriptor(winioctlcon.IOCTL_DISK_GET_LENGTH_INFO, OutFormat="q"), and
+// IOCTL_VOLUME_GET_VOLUME_DISK_EXTENTS as
+// CreateIoctlDescriptor(winioctlcon.IOCTL_VOLUME_GET_VOLUME_DISK_EXTENTS, OutFormat="I", ItemFormat="Iqq", CountIndex=0).
+static PyObject *py_CreateIoctlDescriptor(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[] = {"IoControlCode", "InFormat", "OutFormat", "OutSize",
+		"ItemFormat", "CountIndex", "RecordType", "ItemType", NULL};
+	DWORD code, outSize = 0;
+	PyObject *obInFormat = Py_None, *obOutFormat = Py_None, *obItemFormat = Py_None;
+	PyObject *obRecordType = Py_None, *obItemType = Py_None;
+	int countIndex = -1;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "k|OOkOiOO:CreateIoctlDescriptor", keywords,
+		&code, // @pyparm int|IoControlCode||IOControl Code to use, from winioctlcon
+		&obInFormat, // @pyparm str|InFormat|None|The layout of the input structure.  If None, each call takes an optional input buffer instead of values.
+		&obOutFormat, // @pyparm str|OutFormat|None|The layout of the output structure, or of its fixed part if ItemFormat is given.  If both are None, the output is returned as bytes.
+		&outSize, // @pyparm int|OutSize|0|The initial size of the output buffer.  The default is the size of OutFormat, plus room for 16 items if ItemFormat is given.  With no output layout, 0 means the control code has no output.
+		&obItemFormat, // @pyparm str|ItemFormat|None|The layout of each element of a variable length array following OutFormat.  If OutFormat is None, the whole output is an array of these.
+		&countIndex, // @pyparm int|CountIndex|-1|The index of the field of OutFormat holding the number of elements.  Required if both OutFormat and ItemFormat are given.
+		&obRecordType, // @pyparm callable|RecordType|None|If given, called with the fields of OutFormat as arguments (a collections.namedtuple class, for example) to build the result.
+		&obItemType)) // @pyparm callable|ItemType|None|As RecordType, for each item.
+		return NULL;
+	if (obRecordType != Py_None && !PyCallable_Check(obRecordType))
+		return PyErr_Format(PyExc_TypeError, "RecordType must be callable");
+	if (obItemType != Py_None && !PyCallable_Check(obItemType))
+		return PyErr_Format(PyExc_TypeError, "ItemType must be callable");
+	PyIoctlDescriptor *d = PyObject_New(PyIoctlDescriptor, &PyIoctlDescriptor_Type);
+	if (d == NULL)
+		return NULL;
+	memset(((BYTE *)d) + sizeof(PyObject), 0, sizeof(PyIoctlDescriptor) - sizeof(PyObject));
+	d->code = code;
+	d->countIndex = countIndex;
+	d->bRawIn = obInFormat == Py_None;
+	d->bOut = obOutFormat != Py_None;
+	d->bItems = obItemFormat != Py_None;
+	if ((!d->bRawIn && !ioctl_parse_layout(obInFormat, &d->inLayout, "InFormat"))
+		|| (d->bOut && !ioctl_parse_layout(obOutFormat, &d->outLayout, "OutFormat"))
+		|| (d->bItems && !ioctl_parse_layout(obItemFormat, &d->itemLayout, "ItemFormat"))) {
+		Py_DECREF(d);
+		return NULL;
+	}
+	if (d->bOut && d->bItems) {
+		if (countIndex < 0 || countIndex >= d->outLayout.numFields
+			|| strchr("cs?fdW", d->outLayout.fields[countIndex].code)) {
+			Py_DECREF(d);
+			return PyErr_Format(PyExc_ValueError, "CountIndex must be the index of an integer field of OutFormat");
+		}
+	}
+	if (outSize == 0) {
+		if (d->bOut)
+			outSize = d->outLayout.size;
+		if (d->bItems) {
+			if (d->bOut && d->itemLayout.bNative)
+				outSize = (d->outLayout.end + d->itemLayout.align - 1) & ~(d->itemLayout.align - 1);
+			outSize += 16 * d->itemLayout.size;
+		}
+	}
+	if (outSize > IOCTL_MAX_OUT_SIZE) {
+		Py_DECREF(d);
+		return PyErr_Format(PyExc_ValueError, "OutSize is too large");
+	}
+	d->outSize = outSize;
+	d->outBuf = (BYTE *)malloc(outSize ? outSize : 1);
+	d->inBuf = (BYTE *)malloc(d->inLayout.size ? d->inLayout.size : 1);
+	if (d->outBuf == NULL || d->inBuf == NULL) {
+		Py_DECREF(d);
+		return PyErr_NoMemory();
+	}
+	if (obRecordType != Py_None) {
+		Py_INCREF(obRecordType);
+		d->obRecordType = obRecordType;
+	}
+	if (obItemType != Py_None) {
+		Py_INCREF(obItemType);
+		d->obItemType = obItemType;
+	}
+	return (PyObject *)d;
+}
+PyCFunction pfnpy_CreateIoctlDescriptor=(PyCFunction)py_CreateIoctlDescriptor;
+%}
+%native(CreateIoctlDescriptor) pfnpy_CreateIoctlDescriptor;
+
 
 %native (OVERLAPPED) PyWinMethod_NewOVERLAPPED;
 
@@ -904,81 +1554,377 @@ PyObject *MyAllocateReadBuffer(PyObject *self, PyObject *args)
 %native(AllocateReadBuffer) MyAllocateReadBuffer;
 #endif
 
+// @object PyReadBufferPool|A pool of fixed-size, page-aligned read buffers.
+// @comm Pass the pool in place of the buffer to <om win32file.ReadFile> or
+// <om win32file.WSARecv> and a buffer is leased from it for the operation.
+// The leased buffer is attached to the <o PyOVERLAPPED> as its buffer
+// attribute, and goes back to the pool when nothing references it any
+// more - typically when the overlapped object is used for the next read,
+// or destroyed.
+// <nl>Buffers are carved from slabs allocated with VirtualAlloc, so unused
+// buffers cost no heap fragmentation, and the slabs can optionally be locked
+// into physical memory.  The memory is only released when the pool and all
+// its leased buffers have been destroyed.
 %{
-// @pyswig (int, string)|ReadFile|Reads a string from a file
-// @rdesc The result is a tuple of (hr, string/<o PyOVERLAPPEDReadBuffer>), where hr may be 
-// 0, ERROR_MORE_DATA or ERROR_IO_PENDING.
-// If the overlapped param is not None, then the result is a <o PyOVERLAPPEDReadBuffer>.  Once the overlapped IO operation
-// has completed, you can convert this to a string (str(object)) [py2k] or (bytes(object)) [py3k] to obtain the data.
-// While the operation is in progress, you can use the slice operations (object[:end]) to
-// obtain the data read so far.
-// You must use the OVERLAPPED API functions to determine how much of the data is valid.
-PyObject *MyReadFile(PyObject *self, PyObject *args)
+#define READBUFFERPOOL_SLAB_SIZE 0x10000	// The VirtualAlloc allocation granularity.
+
+typedef struct {
+	PyObject_HEAD
+	DWORD bufSize;		// size of each buffer - a size class, not the size requested.
+	DWORD slabSize;
+	BOOL bLock;		// lock the slabs into physical memory.
+	void **slabs;
+	ULONG numSlabs;
+	ULONG maxSlabs;
+	void *freeList;		// free buffers, linked through their first bytes.
+	ULONG numFree;
+	ULONG hits;
+	ULONG misses;
+	ULONG outstanding;
+} PyReadBufferPool;
+
+typedef struct {
+	PyObject_HEAD
+	PyReadBufferPool *pool;
+	void *buf;
+} PyReadBufferLease;
+
+extern PyTypeObject PyReadBufferPool_Type;
+extern PyTypeObject PyReadBufferLease_Type;
+#define PyReadBufferPool_Check(ob) (Py_TYPE(ob)==&PyReadBufferPool_Type)
+
+// Round a requested size up to its size class; a power of two from 512
+// bytes up to the slab size, and a whole number of slabs above that.  Every
+// buffer of a page or more is therefore page aligned.
+static DWORD rbp_size_class(DWORD size)
 {
-	OVERLAPPED *pOverlapped=NULL;
-	PyObject *obhFile;
-	HANDLE hFile;
-	DWORD bufSize;
-	PyObject *obOverlapped = Py_None;
-	BOOL bBufMallocd = FALSE;
-	PyObject *obBuf, *obRet=NULL;
+	if (size > READBUFFERPOOL_SLAB_SIZE)
+		return (size + READBUFFERPOOL_SLAB_SIZE - 1) & ~(READBUFFERPOOL_SLAB_SIZE - 1);
+	DWORD ret = 512;
+	while (ret < size)
+		ret <<= 1;
+	return ret;
+}
 
-	if (!PyArg_ParseTuple(args, "OO|O:ReadFile", 
-		&obhFile, // @pyparm <o PyHANDLE>/int|hFile||Handle to the file
-		// @pyparm <o PyOVERLAPPEDReadBuffer>/int|buffer/bufSize||Size of the buffer to create for the result,
-		// or a buffer to fill with the result. If a buffer object and overlapped is passed, the result is
-		// the buffer itself.  If a buffer but no overlapped is passed, the result is a new string object,
-		// built from the buffer, but with a length that reflects the data actually read.
-		&obBuf, 
-		&obOverlapped))	// @pyparm <o PyOVERLAPPED>|overlapped|None|An overlapped structure
-		return NULL;
-	if (!PyWinObject_AsHANDLE(obhFile, &hFile))
-		return NULL;
+static BOOL rbp_grow(PyReadBufferPool *pool)
+{
+	if (pool->numSlabs == pool->maxSlabs) {
+		ULONG newMax = pool->maxSlabs ? pool->maxSlabs * 2 : 8;
+		void **newSlabs = (void **)realloc(pool->slabs, newMax * sizeof(void *));
+		if (newSlabs == NULL) {
+			PyErr_NoMemory();
+			return FALSE;
+		}
+		pool->slabs = newSlabs;
+		pool->maxSlabs = newMax;
+	}
+	void *slab = VirtualAlloc(NULL, pool->slabSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+	if (slab == NULL) {
+		PyWin_SetAPIError("VirtualAlloc");
+		return FALSE;
+	}
+	if (pool->bLock && !VirtualLock(slab, pool->slabSize)) {
+		DWORD err = GetLastError();
+		VirtualFree(slab, 0, MEM_RELEASE);
+		PyWin_SetAPIError("VirtualLock", err);
+		return FALSE;
+	}
+	pool->slabs[pool->numSlabs++] = slab;
+	char *p = (char *)slab + pool->slabSize;
+	while (p > (char *)slab) {
+		p -= pool->bufSize;
+		*(void **)p = pool->freeList;
+		pool->freeList = p;
+		pool->numFree++;
+	}
+	return TRUE;
+}
 
-	// @comm in a multi-threaded overlapped environment, it is likely to be necessary to pre-allocate the read buffer using the <om win32file.AllocateReadBuffer> method, otherwise the I/O operation may complete before you can assign to the resulting buffer.
-	if (obOverlapped!=Py_None){
-#ifdef MS_WINCE
-		PyErr_SetString(PyExc_NotImplementedError,"Overlapped operation is not supported on this platform");
-		return NULL;
-#else
-		if (!PyWinObject_AsOVERLAPPED(obOverlapped, &pOverlapped))
+// Leases a buffer - the result is a memoryview over it.
+static PyObject *rbp_lease(PyReadBufferPool *pool)
+{
+	if (pool->freeList)
+		pool->hits++;
+	else {
+		pool->misses++;
+		if (!rbp_grow(pool))
 			return NULL;
-#endif
-		}
+	}
+	PyReadBufferLease *lease = PyObject_New(PyReadBufferLease, &PyReadBufferLease_Type);
+	if (lease == NULL)
+		return NULL;
+	lease->buf = pool->freeList;
+	pool->freeList = *(void **)lease->buf;
+	pool->numFree--;
+	pool->outstanding++;
+	Py_INCREF(pool);
+	lease->pool = pool;
+	PyObject *ret = PyMemoryView_FromObject(lease);
+	Py_DECREF(lease);  // the memoryview keeps its own reference.
+	return ret;
+}
 
-	void *buf = NULL;
-	PyWinBufferView pybuf;
+static void rbl_dealloc(PyObject *ob)
+{
+	PyReadBufferLease *lease = (PyReadBufferLease *)ob;
+	PyReadBufferPool *pool = lease->pool;
+	*(void **)lease->buf = pool->freeList;
+	pool->freeList = lease->buf;
+	pool->numFree++;
+	pool->outstanding--;
+	PyObject_Del(ob);
+	Py_DECREF(pool);
+}
 
-	bufSize = PyInt_AsLong(obBuf);
-	if ((bufSize!=(DWORD)-1) || !PyErr_Occurred()){
-		if (pOverlapped){	// guaranteed to be NULL on CE
-			obRet = PyBuffer_New(bufSize);
-			if (obRet==NULL)
-				return NULL;
-			// This should never fail
-			if (!pybuf.init(obRet, true)) {
-				Py_DECREF(obRet);
-				return NULL;
-				}
-			buf = pybuf.ptr();
-			bufSize = pybuf.len();
-			}
-		else{
-			obRet=PyString_FromStringAndSize(NULL, bufSize);
-			if (obRet==NULL)
-				return NULL;
-			buf=PyString_AS_STRING(obRet);
-			bBufMallocd=TRUE;
-			}
-		}
-	else{
-		PyErr_Clear();
-		if (!pybuf.init(obBuf, true)) {
-			PyErr_SetString(PyExc_TypeError, "Second param must be an integer or writeable buffer object");
-			return NULL;
-			}
-		buf = pybuf.ptr();
-		bufSize = pybuf.len();
+static int rbl_getbuffer(PyObject *ob, Py_buffer *view, int flags)
+{
+	PyReadBufferLease *lease = (PyReadBufferLease *)ob;
+	return PyBuffer_FillInfo(view, ob, lease->buf, lease->pool->bufSize, 0, flags);
+}
+
+static PyBufferProcs rbl_as_buffer = {
+	rbl_getbuffer,		/* bf_getbuffer */
+	0,			/* bf_releasebuffer */
+};
+
+PyTypeObject PyReadBufferLease_Type = {
+	PYWIN_OBJECT_HEAD
+	"PyReadBufferLease",			/* tp_name */
+	sizeof(PyReadBufferLease),		/* tp_basicsize */
+	0,					/* tp_itemsize */
+	rbl_dealloc,				/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	0,					/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	&rbl_as_buffer,				/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+};
+
+static void rbp_dealloc(PyObject *ob)
+{
+	// Every lease holds a reference, so all buffers are back in the pool.
+	PyReadBufferPool *pool = (PyReadBufferPool *)ob;
+	for (ULONG i=0;i<pool->numSlabs;i++)
+		VirtualFree(pool->slabs[i], 0, MEM_RELEASE);
+	free(pool->slabs);
+	PyObject_Del(ob);
+}
+
+// @pymethod buffer|PyReadBufferPool|Lease|Leases a buffer from the pool.
+// @rdesc The result is a writable memoryview, which goes back to the pool when
+// it is no longer referenced.
+static PyObject *rbp_Lease(PyObject *self, PyObject *args)
+{
+	if (!PyArg_ParseTuple(args, ":Lease"))
+		return NULL;
+	return rbp_lease((PyReadBufferPool *)self);
+}
+
+static PyMethodDef rbp_methods[] = {
+	{"Lease", rbp_Lease, METH_VARARGS}, // @pymeth Lease|Leases a buffer from the pool.
+	{NULL}
+};
+
+#undef OFF
+#define OFF(e) offsetof(PyReadBufferPool, e)
+static PyMemberDef rbp_members[] = {
+	{"bufferSize", T_ULONG, OFF(bufSize), READONLY}, // @prop int|bufferSize|The size of each buffer.
+	{"slabs", T_ULONG, OFF(numSlabs), READONLY}, // @prop int|slabs|The number of slabs allocated.
+	{"free", T_ULONG, OFF(numFree), READONLY}, // @prop int|free|The number of buffers available for lease.
+	{"hits", T_ULONG, OFF(hits), READONLY}, // @prop int|hits|The number of leases satisfied by a free buffer.
+	{"misses", T_ULONG, OFF(misses), READONLY}, // @prop int|misses|The number of leases which had to allocate a new slab.
+	{"outstanding", T_ULONG, OFF(outstanding), READONLY}, // @prop int|outstanding|The number of buffers currently leased.
+	{NULL}
+};
+#undef OFF
+
+PyTypeObject PyReadBufferPool_Type = {
+	PYWIN_OBJECT_HEAD
+	"PyReadBufferPool",			/* tp_name */
+	sizeof(PyReadBufferPool),		/* tp_basicsize */
+	0,					/* tp_itemsize */
+	rbp_dealloc,				/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	0,					/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	0,					/* tp_iter */
+	0,					/* tp_iternext */
+	rbp_methods,				/* tp_methods */
+	rbp_members,				/* tp_members */
+};
+
+// @pyswig <o PyReadBufferPool>|AllocateReadBufferPool|Creates a pool of read buffers for use with <om win32file.ReadFile> and <om win32file.WSARecv>
+PyObject *MyAllocateReadBufferPool(PyObject *self, PyObject *args)
+{
+	DWORD bufSize;
+	int prealloc = 0;
+	BOOL bLock = FALSE;
+	if (!PyArg_ParseTuple(args, "k|ii:AllocateReadBufferPool",
+		&bufSize, // @pyparm int|bufSize||The minimum size of each buffer.  This is rounded up to a size class.
+		&prealloc, // @pyparm int|preallocate|0|The number of buffers to allocate immediately.
+		&bLock)) // @pyparm bool|lock|False|If True, the buffers are locked into physical memory using VirtualLock.  The process working set may need to be enlarged using <om win32process.SetProcessWorkingSetSize>.
+		return NULL;
+	if (bufSize == 0 || bufSize > 0x40000000)
+		return PyErr_Format(PyExc_ValueError, "bufSize must be between 1 and 0x40000000");
+	PyReadBufferPool *pool = PyObject_New(PyReadBufferPool, &PyReadBufferPool_Type);
+	if (pool == NULL)
+		return NULL;
+	pool->bufSize = rbp_size_class(bufSize);
+	pool->slabSize = max(pool->bufSize, READBUFFERPOOL_SLAB_SIZE);
+	pool->bLock = bLock;
+	pool->slabs = NULL;
+	pool->numSlabs = pool->maxSlabs = 0;
+	pool->freeList = NULL;
+	pool->numFree = pool->hits = pool->misses = pool->outstanding = 0;
+	while ((int)pool->numFree < prealloc)
+		if (!rbp_grow(pool)) {
+			Py_DECREF(pool);
+			return NULL;
+		}
+	return pool;
+}
+
+// Attach a leased buffer to an overlapped object, releasing the buffer
+// previously attached.
+static void rbp_attach(OVERLAPPED *pOverlapped, PyObject *obBuf)
+{
+	PyOVERLAPPED *po = (PyOVERLAPPED *)(((LPBYTE)pOverlapped) - offsetof(PyOVERLAPPED, m_overlapped));
+	PyObject *obOld = po->m_obBuffer;
+	Py_XINCREF(obBuf);
+	po->m_obBuffer = obBuf;
+	Py_XDECREF(obOld);
+}
+%}
+
+%native(AllocateReadBufferPool) MyAllocateReadBufferPool;
+#endif
+
+%{
+// @pyswig (int, string)|ReadFile|Reads a string from a file
+// @rdesc The result is a tuple of (hr, string/<o PyOVERLAPPEDReadBuffer>), where hr may be 
+// 0, ERROR_MORE_DATA or ERROR_IO_PENDING.
+// If the overlapped param is not None, then the result is a <o PyOVERLAPPEDReadBuffer>.  Once the overlapped IO operation
+// has completed, you can convert this to a string (str(object)) [py2k] or (bytes(object)) [py3k] to obtain the data.
+// While the operation is in progress, you can use the slice operations (object[:end]) to
+// obtain the data read so far.
+// You must use the OVERLAPPED API functions to determine how much of the data is valid.
+PyObject *MyReadFile(PyObject *self, PyObject *args)
+{
+	OVERLAPPED *pOverlapped=NULL;
+	PyObject *obhFile;
+	HANDLE hFile;
+	DWORD bufSize;
+	PyObject *obOverlapped = Py_None;
+	BOOL bBufMallocd = FALSE;
+	PyObject *obBuf, *obRet=NULL;
+
+	if (!PyArg_ParseTuple(args, "OO|O:ReadFile", 
+		&obhFile, // @pyparm <o PyHANDLE>/int|hFile||Handle to the file
+		// @pyparm <o PyOVERLAPPEDReadBuffer>/int|buffer/bufSize||Size of the buffer to create for the result,
+		// or a buffer to fill with the result. If a buffer object and overlapped is passed, the result is
+		// the buffer itself.  If a buffer but no overlapped is passed, the result is a new string object,
+		// built from the buffer, but with a length that reflects the data actually read.
+		// <nl>If a <o PyReadBufferPool> is passed, a buffer is leased from it; with an overlapped,
+		// the result is the leased buffer, which is also attached to the overlapped object as its
+		// buffer attribute.
+		&obBuf, 
+		&obOverlapped))	// @pyparm <o PyOVERLAPPED>|overlapped|None|An overlapped structure
+		return NULL;
+	if (!PyWinObject_AsHANDLE(obhFile, &hFile))
+		return NULL;
+
+	// @comm in a multi-threaded overlapped environment, it is likely to be necessary to pre-allocate the read buffer using the <om win32file.AllocateReadBuffer> method, otherwise the I/O operation may complete before you can assign to the resulting buffer.
+	if (obOverlapped!=Py_None){
+#ifdef MS_WINCE
+		PyErr_SetString(PyExc_NotImplementedError,"Overlapped operation is not supported on this platform");
+		return NULL;
+#else
+		if (!PyWinObject_AsOVERLAPPED(obOverlapped, &pOverlapped))
+			return NULL;
+#endif
+		}
+
+	void *buf = NULL;
+	PyWinBufferView pybuf;
+	BOOL bLeased = FALSE;
+
+#ifndef MS_WINCE
+	if (PyReadBufferPool_Check(obBuf)) {
+		obRet = rbp_lease((PyReadBufferPool *)obBuf);
+		if (obRet==NULL)
+			return NULL;
+		if (!pybuf.init(obRet, true)) {
+			Py_DECREF(obRet);
+			return NULL;
+			}
+		buf = pybuf.ptr();
+		bufSize = pybuf.len();
+		if (pOverlapped){
+			// Attached before the read, as it may complete on another
+			// thread as soon as we release the GIL.
+			rbp_attach(pOverlapped, obRet);
+			bLeased = TRUE;
+			}
+		// else the result is a new string, so the lease only lasts for the read.
+		}
+	else
+#endif
+	if (((bufSize = PyInt_AsLong(obBuf))!=(DWORD)-1) || !PyErr_Occurred()){
+		if (pOverlapped){	// guaranteed to be NULL on CE
+			obRet = PyBuffer_New(bufSize);
+			if (obRet==NULL)
+				return NULL;
+			// This should never fail
+			if (!pybuf.init(obRet, true)) {
+				Py_DECREF(obRet);
+				return NULL;
+				}
+			buf = pybuf.ptr();
+			bufSize = pybuf.len();
+			}
+		else{
+			obRet=PyString_FromStringAndSize(NULL, bufSize);
+			if (obRet==NULL)
+				return NULL;
+			buf=PyString_AS_STRING(obRet);
+			bBufMallocd=TRUE;
+			}
+		}
+	else{
+		PyErr_Clear();
+		if (!pybuf.init(obBuf, true)) {
+			PyErr_SetString(PyExc_TypeError, "Second param must be an integer or writeable buffer object");
+			return NULL;
+			}
+		buf = pybuf.ptr();
+		bufSize = pybuf.len();
 		// If they didn't pass an overlapped, then we can't return the
 		// original buffer as they have no way to know how many bytes
 		// were read - so leave obRet NULL and the ret will be a new
@@ -998,10 +1944,22 @@ PyObject *MyReadFile(PyObject *self, PyObject *args)
 	if (!ok) {
 		err = GetLastError();
 		if (err!=ERROR_MORE_DATA && err != ERROR_IO_PENDING) {
+#ifndef MS_WINCE
+			if (bLeased)
+				rbp_attach(pOverlapped, NULL);
+#endif
 			Py_XDECREF(obRet);
 			return PyWin_SetAPIError("ReadFile", err);
 		}
 	}
+#ifndef MS_WINCE
+	if (pOverlapped==NULL && PyReadBufferPool_Check(obBuf)) {
+		PyObject *obLease = obRet;
+		obRet=PyString_FromStringAndSize((char *)buf, numRead);
+		Py_DECREF(obLease);
+	}
+	else
+#endif
 	if (obRet==NULL)
 		obRet=PyString_FromStringAndSize((char *)buf, numRead);
 	else if (bBufMallocd && (numRead < bufSize))
@@ -1058,6 +2016,131 @@ PyObject *MyWriteFile(PyObject *self, PyObject *args)
 	return Py_BuildValue("ll", err, numWritten);
 }
 
+#ifndef MS_WINCE
+// Shared by ReadFileScatter and WriteFileGather.
+static PyObject *PyWin_ScatterGather(PyObject *args, BOOL bWrite)
+{
+	PyObject *obhFile, *obBuffers, *obOverlapped;
+	if (!PyArg_ParseTuple(args, bWrite ? "OOO:WriteFileGather" : "OOO:ReadFileScatter",
+		&obhFile, &obBuffers, &obOverlapped))
+		return NULL;
+	HANDLE hFile;
+	if (!PyWinObject_AsHANDLE(obhFile, &hFile))
+		return NULL;
+	OVERLAPPED *pOverlapped;
+	if (!PyWinObject_AsOVERLAPPED(obOverlapped, &pOverlapped, FALSE))
+		return NULL;
+	static DWORD dwPageSize = 0;
+	if (dwPageSize == 0) {
+		SYSTEM_INFO si;
+		GetSystemInfo(&si);
+		dwPageSize = si.dwPageSize;
+	}
+	PyObject *obTuple = PySequence_Tuple(obBuffers);
+	if (obTuple == NULL)
+		return NULL;
+	Py_ssize_t nBuffers = PyTuple_GET_SIZE(obTuple);
+	Py_ssize_t i, nPages = 0;
+	PyObject *ret = NULL;
+	FILE_SEGMENT_ELEMENT *segs = NULL;
+	Py_buffer *views = (Py_buffer *)calloc(nBuffers ? nBuffers : 1, sizeof(Py_buffer));
+	if (views == NULL) {
+		PyErr_NoMemory();
+		goto done;
+	}
+	for (i=0;i<nBuffers;i++) {
+		if (PyObject_GetBuffer(PyTuple_GET_ITEM(obTuple, i), &views[i], bWrite ? PyBUF_SIMPLE : PyBUF_WRITABLE) == -1) {
+			views[i].obj = NULL;
+			goto done;
+		}
+		if (((ULONG_PTR)views[i].buf % dwPageSize) != 0 || (views[i].len % dwPageSize) != 0 || views[i].len == 0) {
+			PyErr_Format(PyExc_ValueError,
+				"Buffer %d must be page aligned and a non-zero multiple of the page size (%d bytes)",
+				(int)i, dwPageSize);
+			goto done;
+		}
+		nPages += views[i].len / dwPageSize;
+	}
+	if (nPages == 0) {
+		PyErr_SetString(PyExc_ValueError, "At least one buffer must be supplied");
+		goto done;
+	}
+	if ((unsigned PY_LONG_LONG)nPages * dwPageSize > MAXDWORD) {
+		PyErr_SetString(PyExc_ValueError, "The buffers are too large for one operation");
+		goto done;
+	}
+	// The array is terminated by a NULL element.
+	segs = (FILE_SEGMENT_ELEMENT *)calloc(nPages + 1, sizeof(FILE_SEGMENT_ELEMENT));
+	if (segs == NULL) {
+		PyErr_NoMemory();
+		goto done;
+	}
+	{
+	FILE_SEGMENT_ELEMENT *seg = segs;
+	for (i=0;i<nBuffers;i++)
+		for (Py_ssize_t off=0;off<views[i].len;off+=dwPageSize)
+			(seg++)->Buffer = PtrToPtr64((char *)views[i].buf + off);
+	// The buffers are attached to the overlapped, so they stay alive until
+	// it is reused - and before the call, as it may complete on another
+	// thread as soon as we release the GIL.
+	rbp_attach(pOverlapped, obTuple);
+	DWORD nBytes = (DWORD)(nPages * dwPageSize);
+	BOOL ok;
+	DWORD err = 0;
+	Py_BEGIN_ALLOW_THREADS
+	ok = bWrite ? WriteFileGather(hFile, segs, nBytes, NULL, pOverlapped)
+		: ReadFileScatter(hFile, segs, nBytes, NULL, pOverlapped);
+	if (!ok)
+		err = GetLastError();
+	Py_END_ALLOW_THREADS
+	if (!ok && err != ERROR_IO_PENDING) {
+		rbp_attach(pOverlapped, NULL);
+		PyWin_SetAPIError(bWrite ? "WriteFileGather" : "ReadFileScatter", err);
+		goto done;
+	}
+	ret = PyInt_FromLong(err);
+	}
+done:
+	if (views) {
+		for (i=0;i<nBuffers;i++)
+			if (views[i].obj)
+				PyBuffer_Release(&views[i]);
+		free(views);
+	}
+	free(segs);
+	Py_DECREF(obTuple);
+	return ret;
+}
+
+// @pyswig int|ReadFileScatter|Reads data from a file into a number of page-sized buffers with a single call.
+// @rdesc The result is 0 or ERROR_IO_PENDING.  Use <om win32file.GetOverlappedResult> or an
+// I/O completion port to find when the read has completed.
+// @pyparm <o PyHANDLE>/int|hFile||Handle to a file opened with FILE_FLAG_OVERLAPPED and FILE_FLAG_NO_BUFFERING.
+// @pyparm [<o buffer>, ...]|buffers||A sequence of writable buffers.  Each buffer must be page aligned and a
+// whole number of pages long - buffers from a <o PyReadBufferPool> with a bufSize of a page or more are suitable.
+// @pyparm <o PyOVERLAPPED>|ol||An overlapped structure - this is required.
+// @comm The buffers are attached to the overlapped object as its buffer attribute,
+// so they live until the overlapped is next used.  They must not be resized while
+// the operation is pending.
+static PyObject *MyReadFileScatter(PyObject *self, PyObject *args)
+{
+	return PyWin_ScatterGather(args, FALSE);
+}
+
+// @pyswig int|WriteFileGather|Writes data to a file from a number of page-sized buffers with a single call.
+// @rdesc The result is 0 or ERROR_IO_PENDING.
+// @pyparm <o PyHANDLE>/int|hFile||Handle to a file opened with FILE_FLAG_OVERLAPPED and FILE_FLAG_NO_BUFFERING.
+// @pyparm [<o buffer>, ...]|buffers||A sequence of buffers.  Each buffer must be page aligned and a whole
+// number of pages long.
+// @pyparm <o PyOVERLAPPED>|ol||An overlapped structure - this is required.
+// @comm The buffers are attached to the overlapped object as its buffer attribute,
+// so they live until the overlapped is next used.
+static PyObject *MyWriteFileGather(PyObject *self, PyObject *args)
+{
+	return PyWin_ScatterGather(args, TRUE);
+}
+#endif // MS_WINCE
+
 // @pyswig |CloseHandle|Closes an open handle.
 static PyObject *MyCloseHandle(PyObject *self, PyObject *args)
 {
@@ -1278,50 +2361,622 @@ PyObject *myPostQueuedCompletionStatus(PyObject *self, PyObject *args)
 	// See MS KB article Q192800 for a summary of this.
 }
 
-%}
 
-%native (GetQueuedCompletionStatus) myGetQueuedCompletionStatus;
-%native (PostQueuedCompletionStatus) myPostQueuedCompletionStatus;
-#endif // MS_WINCE
+// @object PyOVERLAPPED_ENTRIES|A reusable array of OVERLAPPED_ENTRY structures, filled
+// by <om win32file.GetQueuedCompletionStatusEx>.
+// @comm The object behaves as a sequence of the <o PyOVERLAPPED> objects dequeued by
+// the last call to <om win32file.GetQueuedCompletionStatusEx>.  The completion key
+// and byte count of each entry are available without creating a tuple per
+// entry via the GetKey and GetBytes methods.
+// <nl>Each call to <om win32file.GetQueuedCompletionStatusEx> discards the
+// entries from the previous call.
+typedef struct {
+	PyObject_HEAD
+	ULONG size;		// number of entries allocated.
+	ULONG count;		// number of entries filled by the last dequeue.
+	OVERLAPPED_ENTRY *entries;
+	PyObject **overlappeds;	// the dequeued PyOVERLAPPED objects (or None).
+} PyOVERLAPPED_ENTRIES;
 
-%native(ReadFile) MyReadFile;
-%native(WriteFile) MyWriteFile;
-%native(CloseHandle) MyCloseHandle;
+extern PyTypeObject PyOVERLAPPED_ENTRIES_Type;
 
-#ifndef MS_WINCE
-// @pyswig int|GetFileType|Determines the type of a file.
-unsigned long GetFileType( // DWORD
-    PyHANDLE hFile // @pyparm <o PyHANDLE>|hFile||The handle to the file.
-);
-#define FILE_TYPE_UNKNOWN FILE_TYPE_UNKNOWN // The type of the specified file is unknown.
-#define FILE_TYPE_DISK FILE_TYPE_DISK // The specified file is a disk file.
-#define FILE_TYPE_CHAR FILE_TYPE_CHAR // The specified file is a character file, typically an LPT device or a console.
-#define FILE_TYPE_PIPE FILE_TYPE_PIPE // The specified file is either a named or anonymous pipe.
+static void poe_clear(PyOVERLAPPED_ENTRIES *poe)
+{
+	for (ULONG i=0;i<poe->count;i++)
+		Py_CLEAR(poe->overlappeds[i]);
+	poe->count = 0;
+}
 
-// @pyswig int|GetLogicalDrives|Returns a bitmaks of the logical drives installed.
-unsigned long GetLogicalDrives( // DWORD
-);
+static void poe_dealloc(PyObject *ob)
+{
+	PyOVERLAPPED_ENTRIES *poe = (PyOVERLAPPED_ENTRIES *)ob;
+	poe_clear(poe);
+	free(poe->entries);
+	free(poe->overlappeds);
+	PyObject_Del(ob);
+}
 
-#endif // MS_WINCE
-/**
-GetLogicalDriveStrings	
-GetShortPathName	
-GetTempFileName	
-GetTempPath	
-GetVolumeInformation	
-*/
+static Py_ssize_t poe_length(PyObject *ob)
+{
+	return ((PyOVERLAPPED_ENTRIES *)ob)->count;
+}
 
-#ifndef MS_WINCE
-// @pyswig int|GetOverlappedResult|Determines the result of the most recent call with an OVERLAPPED object.
-// @comm The result is the number of bytes transferred.  The overlapped object's attributes will be changed during this call.
-BOOLAPI GetOverlappedResult(
-	PyHANDLE hFile, 	// @pyparm <o PyHANDLE>|hFile||The handle to the pipe or file
-	OVERLAPPED *lpOverlapped, // @pyparm <o PyOVERLAPPED>|overlapped||The overlapped object to check.
-	unsigned long *OUTPUT, // lpNumberOfBytesTransferred
-	BOOL bWait	// @pyparm int|bWait||Indicates if the function should wait for data to become available.
-);
+static PyObject *poe_item(PyObject *ob, Py_ssize_t index)
+{
+	PyOVERLAPPED_ENTRIES *poe = (PyOVERLAPPED_ENTRIES *)ob;
+	if (index<0 || index>=(Py_ssize_t)poe->count) {
+		PyErr_SetString(PyExc_IndexError, "PyOVERLAPPED_ENTRIES index out of range");
+		return NULL;
+	}
+	Py_INCREF(poe->overlappeds[index]);
+	return poe->overlappeds[index];
+}
 
-#endif // MS_WINCE
+static BOOL poe_index(PyOVERLAPPED_ENTRIES *poe, PyObject *args, const char *fmt, ULONG *pindex)
+{
+	Py_ssize_t index;
+	if (!PyArg_ParseTuple(args, fmt, &index))
+		return FALSE;
+	if (index<0)
+		index += poe->count;
+	if (index<0 || index>=(Py_ssize_t)poe->count) {
+		PyErr_SetString(PyExc_IndexError, "PyOVERLAPPED_ENTRIES index out of range");
+		return FALSE;
+	}
+	*pindex = (ULONG)index;
+	return TRUE;
+}
+
+// @pymethod int|PyOVERLAPPED_ENTRIES|GetKey|Returns the completion key of a dequeued entry.
+static PyObject *poe_GetKey(PyObject *self, PyObject *args)
+{
+	PyOVERLAPPED_ENTRIES *poe = (PyOVERLAPPED_ENTRIES *)self;
+	ULONG index;
+	// @pyparm int|index||Index of the entry.
+	if (!poe_index(poe, args, "n:GetKey", &index))
+		return NULL;
+	return PyWinObject_FromULONG_PTR(poe->entries[index].lpCompletionKey);
+}
+
+// @pymethod int|PyOVERLAPPED_ENTRIES|GetBytes|Returns the number of bytes transferred for a dequeued entry.
+static PyObject *poe_GetBytes(PyObject *self, PyObject *args)
+{
+	PyOVERLAPPED_ENTRIES *poe = (PyOVERLAPPED_ENTRIES *)self;
+	ULONG index;
+	// @pyparm int|index||Index of the entry.
+	if (!poe_index(poe, args, "n:GetBytes", &index))
+		return NULL;
+	return PyLong_FromUnsignedLong(poe->entries[index].dwNumberOfBytesTransferred);
+}
+
+static PyMethodDef poe_methods[] = {
+	{"GetKey", poe_GetKey, METH_VARARGS}, // @pymeth GetKey|Returns the completion key of a dequeued entry.
+	{"GetBytes", poe_GetBytes, METH_VARARGS}, // @pymeth GetBytes|Returns the number of bytes transferred for a dequeued entry.
+	{NULL}
+};
+
+static PySequenceMethods poe_sequence = {
+	poe_length,		/* sq_length */
+	0,			/* sq_concat */
+	0,			/* sq_repeat */
+	poe_item,		/* sq_item */
+};
+
+PyTypeObject PyOVERLAPPED_ENTRIES_Type = {
+	PYWIN_OBJECT_HEAD
+	"PyOVERLAPPED_ENTRIES",			/* tp_name */
+	sizeof(PyOVERLAPPED_ENTRIES),		/* tp_basicsize */
+	0,					/* tp_itemsize */
+	/* methods */
+	poe_dealloc,				/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	&poe_sequence,				/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT, 			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	0,					/* tp_iter */
+	0,					/* tp_iternext */
+	poe_methods,				/* tp_methods */
+};
+
+// @pyswig <o PyOVERLAPPED_ENTRIES>|AllocateOverlappedEntries|Allocates an array of OVERLAPPED_ENTRY structures for use with <om win32file.GetQueuedCompletionStatusEx>
+static PyObject *MyAllocateOverlappedEntries(PyObject *self, PyObject *args)
+{
+	long size;
+	// @pyparm int|count||The maximum number of entries to dequeue in one call.
+	if (!PyArg_ParseTuple(args, "l:AllocateOverlappedEntries", &size))
+		return NULL;
+	if (size<1)
+		return PyErr_Format(PyExc_ValueError, "count must be at least 1");
+	PyOVERLAPPED_ENTRIES *poe = PyObject_New(PyOVERLAPPED_ENTRIES, &PyOVERLAPPED_ENTRIES_Type);
+	if (poe==NULL)
+		return NULL;
+	poe->size = (ULONG)size;
+	poe->count = 0;
+	poe->entries = (OVERLAPPED_ENTRY *)calloc(size, sizeof(OVERLAPPED_ENTRY));
+	poe->overlappeds = (PyObject **)calloc(size, sizeof(PyObject *));
+	if (poe->entries==NULL || poe->overlappeds==NULL) {
+		Py_DECREF(poe);
+		return PyErr_NoMemory();
+	}
+	return poe;
+}
+
+// @pyswig int|GetQueuedCompletionStatusEx|Dequeues many I/O completion packets from a completion port in one call.
+// @rdesc The result is the number of entries dequeued into the <o PyOVERLAPPED_ENTRIES>
+// object, which is zero if the timeout expired (or, if alertable is True, an APC was
+// delivered) before any packets were available.
+// @comm Unlike <om win32file.GetQueuedCompletionStatus>, this function raises an
+// API error on failure.  The status of each individual operation can be found in
+// the Internal attribute of its <o PyOVERLAPPED>.
+static PyObject *myGetQueuedCompletionStatusEx(PyObject *self, PyObject *args)
+{
+	PyObject *obHandle, *obEntries;
+	DWORD timeout;
+	BOOL alertable = FALSE;
+	if (!PyArg_ParseTuple(args, "OO!l|i:GetQueuedCompletionStatusEx",
+		&obHandle, // @pyparm <o PyHANDLE>|hPort||The handle to the completion port.
+		&PyOVERLAPPED_ENTRIES_Type, &obEntries, // @pyparm <o PyOVERLAPPED_ENTRIES>|entries||The array to fill, as returned by <om win32file.AllocateOverlappedEntries>
+		&timeout, // @pyparm int|timeOut||Timeout in milli-seconds.
+		&alertable)) // @pyparm bool|alertable|False|If True, the function returns when an APC is queued to the thread.
+		return NULL;
+	HANDLE handle;
+	if (!PyWinObject_AsHANDLE(obHandle, &handle))
+		return NULL;
+	PyOVERLAPPED_ENTRIES *poe = (PyOVERLAPPED_ENTRIES *)obEntries;
+	poe_clear(poe);
+	ULONG removed = 0;
+	DWORD errCode;
+	BOOL ok;
+	Py_BEGIN_ALLOW_THREADS
+	ok = GetQueuedCompletionStatusEx(handle, poe->entries, poe->size, &removed, timeout, alertable);
+	errCode = ok ? 0 : GetLastError();
+	Py_END_ALLOW_THREADS
+	if (!ok) {
+		if (errCode==WAIT_TIMEOUT || errCode==WAIT_IO_COMPLETION)
+			return PyLong_FromLong(0);
+		return PyWin_SetAPIError("GetQueuedCompletionStatusEx", errCode);
+	}
+	if (removed>poe->size)
+		removed = poe->size;
+	// Take ownership of every dequeued overlapped before reporting any
+	// error, so none of their queued references are leaked.
+	PyObject *obErrType = NULL, *obErrValue, *obErrTraceback;
+	for (ULONG i=0;i<removed;i++) {
+		PyObject *ob = PyWinObject_FromQueuedOVERLAPPED(poe->entries[i].lpOverlapped);
+		if (ob==NULL) {
+			if (obErrType==NULL)
+				PyErr_Fetch(&obErrType, &obErrValue, &obErrTraceback);
+			else
+				PyErr_Clear();
+			Py_INCREF(Py_None);
+			ob = Py_None;
+		}
+		poe->overlappeds[i] = ob;
+	}
+	poe->count = removed;
+	if (obErrType) {
+		PyErr_Restore(obErrType, obErrValue, obErrTraceback);
+		return NULL;
+	}
+	return PyLong_FromUnsignedLong(removed);
+	// @comm If any of the dequeued overlapped objects has already been destroyed,
+	// a RuntimeError is raised, but the other entries remain available in the
+	// <o PyOVERLAPPED_ENTRIES> object (with None for the dead object).
+}
+
+// @object PyCompletionReactor|A completion port with native worker threads which dispatch
+// completions to Python callbacks, as returned by <om win32file.CreateCompletionReactor>.
+// @comm Each worker thread dequeues up to batchSize packets with GetQueuedCompletionStatusEx,
+// without the GIL, then acquires the GIL once to dispatch the whole batch.
+// <nl>Each packet is dispatched by calling, with (errCode, numberOfBytesTransferred,
+// completionKey, overlapped), the object attribute of the <o PyOVERLAPPED> if it is
+// callable, or otherwise the callback the reactor was created with.  errCode is 0 if
+// the operation succeeded, otherwise the win32 error code.  As callbacks run on the
+// worker threads, code driving an asyncio event loop should complete its futures via
+// loop.call_soon_threadsafe.
+// <nl>The worker threads keep the reactor alive - <om PyCompletionReactor.Close> must
+// be called to stop them.
+%{
+typedef ULONG (WINAPI *RtlNtStatusToDosErrorfunc)(LONG);
+static RtlNtStatusToDosErrorfunc pfnRtlNtStatusToDosError = NULL;
+
+#define REACTOR_MAX_THREADS 64
+
+typedef struct {
+	PyObject_HEAD
+	HANDLE hPort;
+	BOOL bOwnPort;
+	PyObject *obCallback;	// used when the overlapped has no callable object.
+	ULONG batchSize;
+	ULONG numThreads;
+	HANDLE hThreads[REACTOR_MAX_THREADS];
+	DWORD threadIds[REACTOR_MAX_THREADS];
+	BOOL bClosed;
+	LONG batches;		// statistics - updated with the GIL held.
+	LONG dispatched;
+} PyCompletionReactor;
+
+extern PyTypeObject PyCompletionReactor_Type;
+
+// A packet with this key and no overlapped tells a worker to exit.
+#define REACTOR_STOP_KEY(r) ((ULONG_PTR)(r))
+
+static void reactor_dispatch(PyCompletionReactor *r, OVERLAPPED_ENTRY *e)
+{
+	PyObject *obOverlapped = PyWinObject_FromQueuedOVERLAPPED(e->lpOverlapped);
+	if (obOverlapped == NULL) {
+		PyErr_Print();
+		return;
+	}
+	DWORD err = 0;
+	if (e->lpOverlapped && e->lpOverlapped->Internal) {
+		err = pfnRtlNtStatusToDosError ? pfnRtlNtStatusToDosError((LONG)e->lpOverlapped->Internal)
+			: (DWORD)e->lpOverlapped->Internal;
+	}
+	PyObject *callback = r->obCallback;
+	if (obOverlapped != Py_None) {
+		PyObject *obState = ((PyOVERLAPPED *)obOverlapped)->m_overlapped.obState;
+		if (obState && PyCallable_Check(obState))
+			callback = obState;
+	}
+	if (callback) {
+		Py_INCREF(callback);
+		PyObject *ret = PyObject_CallFunction(callback, "kkNO", err, e->dwNumberOfBytesTransferred,
+			PyWinObject_FromULONG_PTR(e->lpCompletionKey), obOverlapped);
+		if (ret == NULL)
+			// Nothing to be done about an exception raised by the callback
+			PyErr_Print();
+		Py_XDECREF(ret);
+		Py_DECREF(callback);
+	}
+	Py_DECREF(obOverlapped);
+	r->dispatched++;
+}
+
+static DWORD WINAPI reactor_thread(LPVOID param)
+{
+	PyCompletionReactor *r = (PyCompletionReactor *)param;
+	OVERLAPPED_ENTRY *entries = (OVERLAPPED_ENTRY *)malloc(r->batchSize * sizeof(OVERLAPPED_ENTRY));
+	BOOL bStop = entries == NULL;
+	while (!bStop) {
+		ULONG removed = 0;
+		if (!GetQueuedCompletionStatusEx(r->hPort, entries, r->batchSize, &removed, INFINITE, FALSE)) {
+			// Only fails like this if the port has been closed under us.
+			break;
+		}
+		CEnterLeavePython celp;
+		r->batches++;
+		for (ULONG i=0;i<removed;i++) {
+			if (entries[i].lpOverlapped == NULL && entries[i].lpCompletionKey == REACTOR_STOP_KEY(r))
+				bStop = TRUE;
+			else
+				reactor_dispatch(r, entries + i);
+		}
+	}
+	free(entries);
+	CEnterLeavePython celp;
+	Py_DECREF(r);
+	return 0;
+}
+
+// Stops the workers, and waits for them unless called from one of them.
+static void reactor_close(PyCompletionReactor *r)
+{
+	if (r->bClosed)
+		return;
+	r->bClosed = TRUE;
+	ULONG i;
+	for (i=0;i<r->numThreads;i++)
+		PostQueuedCompletionStatus(r->hPort, 0, REACTOR_STOP_KEY(r), NULL);
+	DWORD tid = GetCurrentThreadId();
+	Py_BEGIN_ALLOW_THREADS
+	for (i=0;i<r->numThreads;i++) {
+		if (r->threadIds[i] != tid)
+			WaitForSingleObject(r->hThreads[i], INFINITE);
+		CloseHandle(r->hThreads[i]);
+	}
+	Py_END_ALLOW_THREADS
+	r->numThreads = 0;
+}
+
+static void reactor_dealloc(PyObject *ob)
+{
+	PyCompletionReactor *r = (PyCompletionReactor *)ob;
+	// Any workers hold a reference, so they have all gone by now.
+	if (r->bOwnPort && r->hPort)
+		CloseHandle(r->hPort);
+	Py_XDECREF(r->obCallback);
+	PyObject_Del(ob);
+}
+
+// @pymethod |PyCompletionReactor|Register|Associates a handle or socket with the reactor's completion port.
+static PyObject *reactor_Register(PyObject *self, PyObject *args)
+{
+	PyCompletionReactor *r = (PyCompletionReactor *)self;
+	PyObject *obHandle, *obKey = Py_None;
+	if (!PyArg_ParseTuple(args, "O|O:Register",
+		&obHandle, // @pyparm <o PyHANDLE>/<o PySocket>/int|handle||A handle opened for overlapped I/O.
+		&obKey)) // @pyparm int|completionKey|None|The key passed to callbacks for this handle.
+		return NULL;
+	HANDLE h;
+	if (!PyWinObject_AsHANDLE(obHandle, &h)) {
+		// Allow socket objects too.
+		PyErr_Clear();
+		SOCKET sock;
+		if (!PySocket_AsSOCKET(obHandle, &sock))
+			return NULL;
+		h = (HANDLE)sock;
+	}
+	ULONG_PTR key = 0;
+	if (obKey != Py_None && !PyWinLong_AsVoidPtr(obKey, (void **)&key))
+		return NULL;
+	HANDLE hRet;
+	Py_BEGIN_ALLOW_THREADS
+	hRet = CreateIoCompletionPort(h, r->hPort, key, 0);
+	Py_END_ALLOW_THREADS
+	if (hRet == NULL)
+		return PyWin_SetAPIError("CreateIoCompletionPort");
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+// @pymethod |PyCompletionReactor|Cancel|Cancels pending I/O on a handle using CancelIoEx.
+// @comm Cancelled operations are still dispatched, with an errCode of ERROR_OPERATION_ABORTED.
+static PyObject *reactor_Cancel(PyObject *self, PyObject *args)
+{
+	PyObject *obHandle, *obOverlapped = Py_None;
+	if (!PyArg_ParseTuple(args, "O|O:Cancel",
+		&obHandle, // @pyparm <o PyHANDLE>/<o PySocket>/int|handle||The handle with pending I/O.
+		&obOverlapped)) // @pyparm <o PyOVERLAPPED>|overlapped|None|The operation to cancel, or None to cancel all I/O on the handle issued by this process.
+		return NULL;
+	HANDLE h;
+	if (!PyWinObject_AsHANDLE(obHandle, &h)) {
+		PyErr_Clear();
+		SOCKET sock;
+		if (!PySocket_AsSOCKET(obHandle, &sock))
+			return NULL;
+		h = (HANDLE)sock;
+	}
+	OVERLAPPED *pOverlapped;
+	if (!PyWinObject_AsOVERLAPPED(obOverlapped, &pOverlapped, TRUE))
+		return NULL;
+	BOOL ok;
+	Py_BEGIN_ALLOW_THREADS
+	ok = CancelIoEx(h, pOverlapped);
+	Py_END_ALLOW_THREADS
+	if (!ok)
+		return PyWin_SetAPIError("CancelIoEx");
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+// @pymethod |PyCompletionReactor|Post|Posts a packet to the reactor, as per <om win32file.PostQueuedCompletionStatus>.
+static PyObject *reactor_Post(PyObject *self, PyObject *args)
+{
+	PyCompletionReactor *r = (PyCompletionReactor *)self;
+	PyObject *obOverlapped = NULL, *obKey = Py_None;
+	DWORD bytes = 0;
+	if (!PyArg_ParseTuple(args, "|kOO:Post",
+		&bytes, // @pyparm int|numberOfBytes|0|
+		&obKey, // @pyparm int|completionKey|None|
+		&obOverlapped)) // @pyparm <o PyOVERLAPPED>|overlapped|None|
+		return NULL;
+	ULONG_PTR key = 0;
+	if (obKey != Py_None && !PyWinLong_AsVoidPtr(obKey, (void **)&key))
+		return NULL;
+	if (obOverlapped == NULL && key == REACTOR_STOP_KEY(r))
+		return PyErr_Format(PyExc_ValueError, "This completion key is reserved");
+	OVERLAPPED *pOverlapped;
+	if (!PyWinObject_AsQueuedOVERLAPPED(obOverlapped, &pOverlapped, TRUE))
+		return NULL;
+	if (!PostQueuedCompletionStatus(r->hPort, bytes, key, pOverlapped))
+		return PyWin_SetAPIError("PostQueuedCompletionStatus");
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+// @pymethod |PyCompletionReactor|Close|Stops the worker threads.
+// @comm Packets already dequeued by a worker are dispatched before it stops.
+// If called from a callback, the calling worker stops after its current batch.
+static PyObject *reactor_Close(PyObject *self, PyObject *args)
+{
+	if (!PyArg_ParseTuple(args, ":Close"))
+		return NULL;
+	reactor_close((PyCompletionReactor *)self);
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+static PyObject *reactor_get_handle(PyObject *self, void *unused)
+{
+	return PyWinLong_FromHANDLE(((PyCompletionReactor *)self)->hPort);
+}
+
+static PyMethodDef reactor_methods[] = {
+	{"Register", reactor_Register, METH_VARARGS}, // @pymeth Register|Associates a handle or socket with the reactor's completion port.
+	{"Cancel", reactor_Cancel, METH_VARARGS}, // @pymeth Cancel|Cancels pending I/O on a handle.
+	{"Post", reactor_Post, METH_VARARGS}, // @pymeth Post|Posts a packet to the reactor.
+	{"Close", reactor_Close, METH_VARARGS}, // @pymeth Close|Stops the worker threads.
+	{NULL}
+};
+
+static PyGetSetDef reactor_getset[] = {
+	// @prop int|handle|The handle of the completion port.
+	{"handle", reactor_get_handle, NULL},
+	{NULL}
+};
+
+#undef OFF
+#define OFF(e) offsetof(PyCompletionReactor, e)
+static PyMemberDef reactor_members[] = {
+	{"batches", T_LONG, OFF(batches), READONLY}, // @prop int|batches|The number of batches dispatched.
+	{"dispatched", T_LONG, OFF(dispatched), READONLY}, // @prop int|dispatched|The number of packets dispatched.
+	{NULL}
+};
+#undef OFF
+
+PyTypeObject PyCompletionReactor_Type = {
+	PYWIN_OBJECT_HEAD
+	"PyCompletionReactor",			/* tp_name */
+	sizeof(PyCompletionReactor),		/* tp_basicsize */
+	0,					/* tp_itemsize */
+	reactor_dealloc,			/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	0,					/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	0,					/* tp_iter */
+	0,					/* tp_iternext */
+	reactor_methods,			/* tp_methods */
+	reactor_members,			/* tp_members */
+	reactor_getset,				/* tp_getset */
+};
+
+// @pyswig <o PyCompletionReactor>|CreateCompletionReactor|Creates a completion port serviced by native worker threads.
+static PyObject *MyCreateCompletionReactor(PyObject *self, PyObject *args)
+{
+	PyObject *obCallback = Py_None, *obPort = Py_None;
+	int numThreads = 1, batchSize = 64;
+	if (!PyArg_ParseTuple(args, "|OiiO:CreateCompletionReactor",
+		&obCallback, // @pyparm callable|callback|None|Called for packets whose overlapped object is not callable.
+		&numThreads, // @pyparm int|numThreads|1|The number of worker threads.
+		&batchSize, // @pyparm int|batchSize|64|The maximum number of packets each worker dispatches per GIL acquisition.
+		&obPort)) // @pyparm <o PyHANDLE>|hPort|None|An existing completion port to service, or None to create one.
+		return NULL;
+	if (obCallback != Py_None && !PyCallable_Check(obCallback))
+		return PyErr_Format(PyExc_TypeError, "callback must be callable");
+	if (numThreads < 1 || numThreads > REACTOR_MAX_THREADS)
+		return PyErr_Format(PyExc_ValueError, "numThreads must be between 1 and %d", REACTOR_MAX_THREADS);
+	if (batchSize < 1)
+		return PyErr_Format(PyExc_ValueError, "batchSize must be at least 1");
+	HANDLE hPort = NULL;
+	if (obPort != Py_None && !PyWinObject_AsHANDLE(obPort, &hPort))
+		return NULL;
+	if (pfnRtlNtStatusToDosError == NULL) {
+		HMODULE hmod = GetModuleHandle(TEXT("ntdll.dll"));
+		if (hmod)
+			pfnRtlNtStatusToDosError = (RtlNtStatusToDosErrorfunc)GetProcAddress(hmod, "RtlNtStatusToDosError");
+	}
+#if (PY_VERSION_HEX < 0x03070000)
+	PyEval_InitThreads();
+#endif
+	PyCompletionReactor *r = PyObject_New(PyCompletionReactor, &PyCompletionReactor_Type);
+	if (r == NULL)
+		return NULL;
+	r->bOwnPort = hPort == NULL;
+	if (r->bOwnPort) {
+		hPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, numThreads);
+		if (hPort == NULL) {
+			r->hPort = NULL;
+			r->obCallback = NULL;
+			Py_DECREF(r);
+			return PyWin_SetAPIError("CreateIoCompletionPort");
+		}
+	}
+	r->hPort = hPort;
+	r->obCallback = obCallback == Py_None ? NULL : obCallback;
+	Py_XINCREF(r->obCallback);
+	r->batchSize = batchSize;
+	r->numThreads = 0;
+	r->bClosed = FALSE;
+	r->batches = r->dispatched = 0;
+	for (int i=0;i<numThreads;i++) {
+		Py_INCREF(r);  // owned by the thread.
+		HANDLE h = CreateThread(NULL, 0, reactor_thread, r, 0, &r->threadIds[r->numThreads]);
+		if (h == NULL) {
+			PyWin_SetAPIError("CreateThread");
+			Py_DECREF(r);
+			reactor_close(r);
+			Py_DECREF(r);
+			return NULL;
+		}
+		r->hThreads[r->numThreads++] = h;
+	}
+	return r;
+}
+%}
+
+%native (GetQueuedCompletionStatus) myGetQueuedCompletionStatus;
+%native (PostQueuedCompletionStatus) myPostQueuedCompletionStatus;
+%native (AllocateOverlappedEntries) MyAllocateOverlappedEntries;
+%native (CreateCompletionReactor) MyCreateCompletionReactor;
+%native (GetQueuedCompletionStatusEx) myGetQueuedCompletionStatusEx;
+#endif // MS_WINCE
+
+%native(ReadFile) MyReadFile;
+%native(WriteFile) MyWriteFile;
+#ifndef MS_WINCE
+%native(ReadFileScatter) MyReadFileScatter;
+%native(WriteFileGather) MyWriteFileGather;
+#endif
+%native(CloseHandle) MyCloseHandle;
+
+#ifndef MS_WINCE
+// @pyswig int|GetFileType|Determines the type of a file.
+unsigned long GetFileType( // DWORD
+    PyHANDLE hFile // @pyparm <o PyHANDLE>|hFile||The handle to the file.
+);
+#define FILE_TYPE_UNKNOWN FILE_TYPE_UNKNOWN // The type of the specified file is unknown.
+#define FILE_TYPE_DISK FILE_TYPE_DISK // The specified file is a disk file.
+#define FILE_TYPE_CHAR FILE_TYPE_CHAR // The specified file is a character file, typically an LPT device or a console.
+#define FILE_TYPE_PIPE FILE_TYPE_PIPE // The specified file is either a named or anonymous pipe.
+
+// @pyswig int|GetLogicalDrives|Returns a bitmaks of the logical drives installed.
+unsigned long GetLogicalDrives( // DWORD
+);
+
+#endif // MS_WINCE
+/**
+GetLogicalDriveStrings	
+GetShortPathName	
+GetTempFileName	
+GetTempPath	
+GetVolumeInformation	
+*/
+
+#ifndef MS_WINCE
+// @pyswig int|GetOverlappedResult|Determines the result of the most recent call with an OVERLAPPED object.
+// @comm The result is the number of bytes transferred.  The overlapped object's attributes will be changed during this call.
+BOOLAPI GetOverlappedResult(
+	PyHANDLE hFile, 	// @pyparm <o PyHANDLE>|hFile||The handle to the pipe or file
+	OVERLAPPED *lpOverlapped, // @pyparm <o PyOVERLAPPED>|overlapped||The overlapped object to check.
+	unsigned long *OUTPUT, // lpNumberOfBytesTransferred
+	BOOL bWait	// @pyparm int|bWait||Indicates if the function should wait for data to become available.
+);
+
+#endif // MS_WINCE
 
 #ifndef MS_WINCE
 // @pyswig |LockFile|Locks a specified file for exclusive access by the calling process.
@@ -1571,18 +3226,554 @@ PyObject *PyFILE_NOTIFY_INFORMATION(PyObject *self, PyObject *args)
 %native(ReadDirectoryChangesW) PyReadDirectoryChangesW;
 %native(FILE_NOTIFY_INFORMATION) PyFILE_NOTIFY_INFORMATION;
 
-// ReadFileEx
-// SearchPath	
+// @object PyDirectoryWatcher|A directory watch which keeps an overlapped
+// ReadDirectoryChangesW continuously in flight, as returned by <om win32file.CreateDirectoryWatcher>.
+// @comm Two buffers are used - as soon as one completes, the watch is re-armed
+// with the other before the completed one is decoded, so no changes are missed
+// while notifications are processed.
+// <nl>Notifications are collected natively into batches.  A batch is delivered once
+// the coalescing window has elapsed since its first notification.  Within a batch, a
+// FILE_ACTION_MODIFIED notification is dropped if the latest notification for the
+// same path is FILE_ACTION_ADDED or FILE_ACTION_MODIFIED.  Other notifications,
+// including renames, are never dropped.
+// <nl>Each batch is a list of (action, filename) tuples, as returned by
+// <om win32file.FILE_NOTIFY_INFORMATION>.  If the system overflowed its buffer
+// and notifications were lost, the batch includes an (0, None) entry and the
+// overflows counter is incremented - the directory should be rescanned.
+// <nl>Batches are returned by <om PyDirectoryWatcher.GetEvents>, by iterating over
+// the object, or if a callback was given, passed to it from a native thread.
+// The thread keeps the watcher alive - <om PyDirectoryWatcher.Close> must be called
+// to stop it.
+%{
+typedef struct {
+	DWORD action;
+	DWORD nameLen;		// in characters
+	WCHAR *name;		// NULL for an overflow record
+} PyDirWatchEvent;
 
-#ifndef MS_WINCE
-// @pyswig |SetCurrentDirectory|Sets the current directory.
-%name(SetCurrentDirectory) BOOLAPI SetCurrentDirectoryW(
-    WCHAR *lpPathName	// @pyparm str/<o PyUnicode>|lpPathName||Name of the path to set current.
-);
-#endif // MS_WINCE
+typedef struct {
+	PyObject_HEAD
+	HANDLE hDir;
+	HANDLE hEvent;		// signalled when a read completes
+	HANDLE hStop;		// signalled by Close
+	OVERLAPPED ol;
+	BYTE *bufs[2];
+	int cur;		// the buffer in flight
+	BOOL bPending;
+	DWORD bufSize;
+	BOOL bSubtree;
+	DWORD filter;
+	DWORD window;		// coalescing window in milliseconds
+	DWORD batchStart;	// tick count of the first event in the batch
+	DWORD lastError;
+	BOOL bClosed;
+	CRITICAL_SECTION cs;	// serializes the pump and the pending batch
+	PyDirWatchEvent *events;
+	ULONG numEvents, maxEvents;
+	LONG *hashTable;	// path -> index of the latest event for that path
+	ULONG hashSize;		// always a power of 2, at least twice maxEvents
+	PyObject *obCallback;
+	HANDLE hThread;
+	DWORD threadId;
+	LONG completions;	// statistics
+	LONG notifications;
+	LONG coalesced;
+	LONG overflows;
+	LONG batches;
+} PyDirectoryWatcher;
+
+extern PyTypeObject PyDirectoryWatcher_Type;
+
+#define DW_TIMEOUT 0
+#define DW_BATCH 1
+#define DW_CLOSED 2
+#define DW_ERROR -1
+
+static ULONG dw_hash(const WCHAR *name, DWORD len)
+{
+	ULONG h = 2166136261U;
+	for (DWORD i=0;i<len;i++)
+		h = (h ^ name[i]) * 16777619U;
+	return h;
+}
 
-// @pyswig |SetEndOfFile|Moves the end-of-file (EOF) position for the specified file to the current position of the file pointer. 
-BOOL SetEndOfFile(
+static LONG *dw_lookup(PyDirectoryWatcher *w, const WCHAR *name, DWORD len)
+{
+	ULONG mask = w->hashSize - 1;
+	for (ULONG i = dw_hash(name, len) & mask;; i = (i + 1) & mask) {
+		LONG *slot = w->hashTable + i;
+		if (*slot == -1)
+			return slot;
+		PyDirWatchEvent *e = w->events + *slot;
+		if (e->nameLen == len && memcmp(e->name, name, len * sizeof(WCHAR)) == 0)
+			return slot;
+	}
+}
+
+static BOOL dw_grow(PyDirectoryWatcher *w)
+{
+	ULONG maxEvents = w->maxEvents ? w->maxEvents * 2 : 256;
+	PyDirWatchEvent *events = (PyDirWatchEvent *)realloc(w->events, maxEvents * sizeof(PyDirWatchEvent));
+	if (events == NULL)
+		return FALSE;
+	w->events = events;
+	LONG *hashTable = (LONG *)malloc(maxEvents * 2 * sizeof(LONG));
+	if (hashTable == NULL)
+		return FALSE;
+	free(w->hashTable);
+	w->hashTable = hashTable;
+	w->hashSize = maxEvents * 2;
+	w->maxEvents = maxEvents;
+	memset(w->hashTable, 0xff, w->hashSize * sizeof(LONG));
+	for (ULONG i=0;i<w->numEvents;i++) {
+		PyDirWatchEvent *e = w->events + i;
+		if (e->name)
+			*dw_lookup(w, e->name, e->nameLen) = (LONG)i;
+	}
+	return TRUE;
+}
+
+static BOOL dw_add(PyDirectoryWatcher *w, DWORD action, const WCHAR *name, DWORD len)
+{
+	LONG *slot = NULL;
+	if (name && w->window) {
+		if (w->hashTable == NULL && !dw_grow(w))
+			return FALSE;
+		slot = dw_lookup(w, name, len);
+		if (*slot != -1 && action == FILE_ACTION_MODIFIED) {
+			DWORD prev = w->events[*slot].action;
+			if (prev == FILE_ACTION_ADDED || prev == FILE_ACTION_MODIFIED) {
+				w->coalesced++;
+				return TRUE;
+			}
+		}
+	}
+	if (w->numEvents == w->maxEvents) {
+		if (!dw_grow(w))
+			return FALSE;
+		if (slot)
+			slot = dw_lookup(w, name, len);
+	}
+	PyDirWatchEvent *e = w->events + w->numEvents;
+	e->action = action;
+	e->nameLen = len;
+	e->name = NULL;
+	if (name) {
+		e->name = (WCHAR *)malloc(len ? len * sizeof(WCHAR) : 1);
+		if (e->name == NULL)
+			return FALSE;
+		memcpy(e->name, name, len * sizeof(WCHAR));
+	}
+	if (slot)
+		*slot = (LONG)w->numEvents;
+	if (w->numEvents++ == 0)
+		w->batchStart = GetTickCount();
+	return TRUE;
+}
+
+static void dw_clear(PyDirectoryWatcher *w)
+{
+	for (ULONG i=0;i<w->numEvents;i++)
+		free(w->events[i].name);
+	w->numEvents = 0;
+	if (w->hashTable)
+		memset(w->hashTable, 0xff, w->hashSize * sizeof(LONG));
+}
+
+static BOOL dw_decode(PyDirectoryWatcher *w, BYTE *buf, DWORD nbytes)
+{
+	DWORD offset = 0;
+	// See PyObject_FromFILE_NOTIFY_INFORMATION for the size of the head.
+	while (offset + sizeof(DWORD)*3 <= nbytes) {
+		FILE_NOTIFY_INFORMATION *p = (FILE_NOTIFY_INFORMATION *)(buf + offset);
+		DWORD len = p->FileNameLength / sizeof(WCHAR);
+		if (offset + sizeof(DWORD)*3 + len * sizeof(WCHAR) > nbytes)
+			break;
+		w->notifications++;
+		if (!dw_add(w, p->Action, p->FileName, len))
+			return FALSE;
+		if (p->NextEntryOffset == 0)
+			break;
+		offset += p->NextEntryOffset;
+	}
+	return TRUE;
+}
+
+static BOOL dw_arm(PyDirectoryWatcher *w)
+{
+	memset(&w->ol, 0, sizeof(w->ol));
+	w->ol.hEvent = w->hEvent;
+	if (!::ReadDirectoryChangesW(w->hDir, w->bufs[w->cur], w->bufSize, w->bSubtree, w->filter, NULL, &w->ol, NULL)) {
+		w->lastError = GetLastError();
+		return FALSE;
+	}
+	w->bPending = TRUE;
+	return TRUE;
+}
+
+// Collects notifications until a batch is ready, the timeout expires or the
+// watcher is closed.  Called without the GIL, with the critical section held.
+static int dw_pump(PyDirectoryWatcher *w, DWORD timeout)
+{
+	DWORD start = GetTickCount();
+	for (;;) {
+		if (w->bClosed)
+			return DW_CLOSED;
+		if (!w->bPending && !dw_arm(w))
+			return DW_ERROR;
+		DWORD now = GetTickCount();
+		if (w->numEvents && now - w->batchStart >= w->window)
+			return DW_BATCH;
+		DWORD wait = INFINITE;
+		if (timeout != INFINITE) {
+			if (now - start >= timeout)
+				return w->numEvents ? DW_BATCH : DW_TIMEOUT;
+			wait = timeout - (now - start);
+		}
+		if (w->numEvents && w->window - (now - w->batchStart) < wait)
+			wait = w->window - (now - w->batchStart);
+		HANDLE handles[2] = {w->hEvent, w->hStop};
+		DWORD rc = WaitForMultipleObjects(2, handles, FALSE, wait);
+		if (rc == WAIT_OBJECT_0 + 1)
+			continue;	// bClosed is set before hStop is signalled.
+		if (rc == WAIT_TIMEOUT)
+			continue;
+		if (rc != WAIT_OBJECT_0) {
+			w->lastError = GetLastError();
+			return DW_ERROR;
+		}
+		DWORD nbytes = 0;
+		DWORD err = 0;
+		if (!GetOverlappedResult(w->hDir, &w->ol, &nbytes, FALSE))
+			err = GetLastError();
+		w->bPending = FALSE;
+		BYTE *buf = w->bufs[w->cur];
+		w->cur ^= 1;
+		if (err && err != ERROR_NOTIFY_ENUM_DIR) {
+			w->lastError = err;
+			return DW_ERROR;
+		}
+		// Re-arm with the other buffer before decoding this one.
+		if (!dw_arm(w))
+			return DW_ERROR;
+		w->completions++;
+		if (err || nbytes == 0) {
+			w->overflows++;
+			if (!dw_add(w, 0, NULL, 0)) {
+				w->lastError = ERROR_NOT_ENOUGH_MEMORY;
+				return DW_ERROR;
+			}
+		}
+		else if (!dw_decode(w, buf, nbytes)) {
+			w->lastError = ERROR_NOT_ENOUGH_MEMORY;
+			return DW_ERROR;
+		}
+	}
+}
+
+// Converts and clears the pending batch - called with the GIL and the critical section held.
+static PyObject *dw_take_batch(PyDirectoryWatcher *w)
+{
+	PyObject *ret = PyList_New(w->numEvents);
+	if (ret == NULL)
+		return NULL;
+	for (ULONG i=0;i<w->numEvents;i++) {
+		PyDirWatchEvent *e = w->events + i;
+		PyObject *item;
+		if (e->name)
+			item = Py_BuildValue("kN", e->action, PyWinObject_FromOLECHAR(e->name, e->nameLen));
+		else
+			item = Py_BuildValue("kO", e->action, Py_None);
+		if (item == NULL) {
+			Py_DECREF(ret);
+			return NULL;
+		}
+		PyList_SET_ITEM(ret, i, item);
+	}
+	if (w->numEvents)
+		w->batches++;
+	dw_clear(w);
+	return ret;
+}
+
+// Runs the pump and returns the next batch, an empty list on timeout, or NULL
+// without an exception set if the watcher is closed.
+static PyObject *dw_get_events(PyDirectoryWatcher *w, DWORD timeout)
+{
+	int rc;
+	Py_BEGIN_ALLOW_THREADS
+	EnterCriticalSection(&w->cs);
+	rc = dw_pump(w, timeout);
+	Py_END_ALLOW_THREADS
+	PyObject *ret = NULL;
+	if (rc == DW_ERROR)
+		PyWin_SetAPIError("ReadDirectoryChangesW", w->lastError);
+	else if (rc != DW_CLOSED)
+		ret = dw_take_batch(w);
+	LeaveCriticalSection(&w->cs);
+	return ret;
+}
+
+static DWORD WINAPI dw_thread(LPVOID param)
+{
+	PyDirectoryWatcher *w = (PyDirectoryWatcher *)param;
+	for (;;) {
+		EnterCriticalSection(&w->cs);
+		int rc = dw_pump(w, INFINITE);
+		CEnterLeavePython celp;
+		if (rc != DW_BATCH) {
+			LeaveCriticalSection(&w->cs);
+			if (rc == DW_ERROR) {
+				PyWin_SetAPIError("ReadDirectoryChangesW", w->lastError);
+				PyErr_Print();
+			}
+			break;
+		}
+		PyObject *batch = dw_take_batch(w);
+		LeaveCriticalSection(&w->cs);
+		PyObject *ret = batch ? PyObject_CallFunctionObjArgs(w->obCallback, batch, NULL) : NULL;
+		if (ret == NULL)
+			// Nothing to be done about an exception raised by the callback
+			PyErr_Print();
+		Py_XDECREF(ret);
+		Py_XDECREF(batch);
+	}
+	CEnterLeavePython celp;
+	Py_DECREF(w);
+	return 0;
+}
+
+// Stops the watch, and the thread unless called from it.
+static void dw_close(PyDirectoryWatcher *w)
+{
+	if (w->bClosed)
+		return;
+	w->bClosed = TRUE;
+	SetEvent(w->hStop);
+	Py_BEGIN_ALLOW_THREADS
+	if (w->hThread) {
+		if (w->threadId != GetCurrentThreadId())
+			WaitForSingleObject(w->hThread, INFINITE);
+		CloseHandle(w->hThread);
+		w->hThread = NULL;
+	}
+	EnterCriticalSection(&w->cs);
+	if (w->bPending) {
+		DWORD nbytes;
+		CancelIoEx(w->hDir, &w->ol);
+		GetOverlappedResult(w->hDir, &w->ol, &nbytes, TRUE);
+		w->bPending = FALSE;
+	}
+	CloseHandle(w->hDir);
+	w->hDir = INVALID_HANDLE_VALUE;
+	Py_END_ALLOW_THREADS
+	dw_clear(w);
+	LeaveCriticalSection(&w->cs);
+}
+
+static void dw_dealloc(PyObject *ob)
+{
+	PyDirectoryWatcher *w = (PyDirectoryWatcher *)ob;
+	// Any thread holds a reference, so it has gone by now.
+	dw_close(w);
+	DeleteCriticalSection(&w->cs);
+	CloseHandle(w->hEvent);
+	CloseHandle(w->hStop);
+	free(w->bufs[0]);
+	free(w->bufs[1]);
+	free(w->events);
+	free(w->hashTable);
+	Py_XDECREF(w->obCallback);
+	PyObject_Del(ob);
+}
+
+// @pymethod [(action, filename), ...]|PyDirectoryWatcher|GetEvents|Waits for the next batch of notifications.
+// @rdesc The result is an empty list if the timeout expires with no notifications.
+// @comm The batch may be delivered before the coalescing window has elapsed if
+// the timeout expires first.
+static PyObject *dw_GetEvents(PyObject *self, PyObject *args)
+{
+	PyDirectoryWatcher *w = (PyDirectoryWatcher *)self;
+	DWORD timeout = INFINITE;
+	if (!PyArg_ParseTuple(args, "|k:GetEvents",
+		&timeout)) // @pyparm int|timeout|win32event.INFINITE|The time in milliseconds to wait.
+		return NULL;
+	if (w->obCallback)
+		return PyErr_Format(PyExc_TypeError, "This watcher delivers its events to a callback");
+	if (w->bClosed)
+		return PyErr_Format(PyExc_ValueError, "The watcher has been closed");
+	PyObject *ret = dw_get_events(w, timeout);
+	if (ret == NULL && !PyErr_Occurred())
+		PyErr_Format(PyExc_ValueError, "The watcher has been closed");
+	return ret;
+}
+
+static PyObject *dw_iternext(PyObject *self)
+{
+	PyDirectoryWatcher *w = (PyDirectoryWatcher *)self;
+	if (w->obCallback)
+		return PyErr_Format(PyExc_TypeError, "This watcher delivers its events to a callback");
+	// NULL without an exception stops the iteration once closed.
+	return dw_get_events(w, INFINITE);
+}
+
+// @pymethod |PyDirectoryWatcher|Close|Cancels the watch and closes the directory handle.
+// @comm A thread blocked in <om PyDirectoryWatcher.GetEvents> raises ValueError, and an
+// iteration stops.  If called from the callback, the thread stops when the callback returns.
+static PyObject *dw_Close(PyObject *self, PyObject *args)
+{
+	if (!PyArg_ParseTuple(args, ":Close"))
+		return NULL;
+	dw_close((PyDirectoryWatcher *)self);
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+static PyMethodDef dw_methods[] = {
+	{"GetEvents", dw_GetEvents, METH_VARARGS}, // @pymeth GetEvents|Waits for the next batch of notifications.
+	{"Close", dw_Close, METH_VARARGS}, // @pymeth Close|Cancels the watch.
+	{NULL}
+};
+
+#undef OFF
+#define OFF(e) offsetof(PyDirectoryWatcher, e)
+static PyMemberDef dw_members[] = {
+	{"completions", T_LONG, OFF(completions), READONLY}, // @prop int|completions|The number of ReadDirectoryChangesW calls which have completed.
+	{"notifications", T_LONG, OFF(notifications), READONLY}, // @prop int|notifications|The number of notifications received from the system.
+	{"coalesced", T_LONG, OFF(coalesced), READONLY}, // @prop int|coalesced|The number of notifications dropped by coalescing.
+	{"overflows", T_LONG, OFF(overflows), READONLY}, // @prop int|overflows|The number of times the system reported that notifications were lost.
+	{"batches", T_LONG, OFF(batches), READONLY}, // @prop int|batches|The number of batches delivered.
+	{NULL}
+};
+#undef OFF
+
+PyTypeObject PyDirectoryWatcher_Type = {
+	PYWIN_OBJECT_HEAD
+	"PyDirectoryWatcher",			/* tp_name */
+	sizeof(PyDirectoryWatcher),		/* tp_basicsize */
+	0,					/* tp_itemsize */
+	dw_dealloc,				/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	0,					/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	PyObject_SelfIter,			/* tp_iter */
+	dw_iternext,				/* tp_iternext */
+	dw_methods,				/* tp_methods */
+	dw_members,				/* tp_members */
+	0,					/* tp_getset */
+};
+
+// @pyswig <o PyDirectoryWatcher>|CreateDirectoryWatcher|Starts watching a directory for changes.
+static PyObject *MyCreateDirectoryWatcher(PyObject *self, PyObject *args)
+{
+	PyObject *obPath, *obCallback = Py_None;
+	BOOL bSubtree = TRUE;
+	DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE;
+	DWORD bufSize = 65536, window = 50;
+	if (!PyArg_ParseTuple(args, "O|ikkkO:CreateDirectoryWatcher",
+		&obPath, // @pyparm <o PyUnicode>|path||The directory to watch.
+		&bSubtree, // @pyparm int|bWatchSubtree|True|Whether to watch the whole tree rooted at the directory.
+		&filter, // @pyparm int|dwNotifyFilter|FILE_NOTIFY_CHANGE_FILE_NAME\|FILE_NOTIFY_CHANGE_DIR_NAME\|FILE_NOTIFY_CHANGE_LAST_WRITE|A combination of FILE_NOTIFY_CHANGE_* values.
+		&bufSize, // @pyparm int|bufSize|65536|The size of each of the two notification buffers.  Watches on network shares fail if this is over 64K.
+		&window, // @pyparm int|window|50|The coalescing window in milliseconds.  0 delivers each buffer of notifications as soon as it arrives, without coalescing.
+		&obCallback)) // @pyparm callable|callback|None|If specified, called from a native thread with each batch.
+		return NULL;
+	if (obCallback != Py_None && !PyCallable_Check(obCallback))
+		return PyErr_Format(PyExc_TypeError, "callback must be callable");
+	if (bufSize < 1024)
+		return PyErr_Format(PyExc_ValueError, "bufSize must be at least 1024");
+	WCHAR *path;
+	if (!PyWinObject_AsWCHAR(obPath, &path, FALSE))
+		return NULL;
+	HANDLE hDir;
+	Py_BEGIN_ALLOW_THREADS
+	hDir = CreateFileW(path, FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+	Py_END_ALLOW_THREADS
+	PyWinObject_FreeWCHAR(path);
+	if (hDir == INVALID_HANDLE_VALUE)
+		return PyWin_SetAPIError("CreateFile");
+#if (PY_VERSION_HEX < 0x03070000)
+	if (obCallback != Py_None)
+		PyEval_InitThreads();
+#endif
+	PyDirectoryWatcher *w = PyObject_New(PyDirectoryWatcher, &PyDirectoryWatcher_Type);
+	if (w == NULL) {
+		CloseHandle(hDir);
+		return NULL;
+	}
+	memset(((BYTE *)w) + sizeof(PyObject), 0, sizeof(PyDirectoryWatcher) - sizeof(PyObject));
+	InitializeCriticalSection(&w->cs);
+	w->hDir = hDir;
+	w->bufSize = bufSize;
+	w->bSubtree = bSubtree;
+	w->filter = filter;
+	w->window = window;
+	w->hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+	w->hStop = CreateEvent(NULL, TRUE, FALSE, NULL);
+	w->bufs[0] = (BYTE *)malloc(bufSize);
+	w->bufs[1] = (BYTE *)malloc(bufSize);
+	if (w->bufs[0] == NULL || w->bufs[1] == NULL) {
+		Py_DECREF(w);
+		return PyErr_NoMemory();
+	}
+	if (w->hEvent == NULL || w->hStop == NULL) {
+		PyWin_SetAPIError("CreateEvent");
+		Py_DECREF(w);
+		return NULL;
+	}
+	// Arm now, so changes made after this returns are seen.
+	if (!dw_arm(w)) {
+		PyWin_SetAPIError("ReadDirectoryChangesW", w->lastError);
+		Py_DECREF(w);
+		return NULL;
+	}
+	if (obCallback != Py_None) {
+		w->obCallback = obCallback;
+		Py_INCREF(obCallback);
+		Py_INCREF(w);  // owned by the thread.
+		w->hThread = CreateThread(NULL, 0, dw_thread, w, 0, &w->threadId);
+		if (w->hThread == NULL) {
+			PyWin_SetAPIError("CreateThread");
+			Py_DECREF(w);
+			Py_DECREF(w);
+			return NULL;
+		}
+	}
+	return w;
+}
+%}
+%native(CreateDirectoryWatcher) MyCreateDirectoryWatcher;
+
+// ReadFileEx
+// SearchPath	
+
+#ifndef MS_WINCE
+// @pyswig |SetCurrentDirectory|Sets the current directory.
+%name(SetCurrentDirectory) BOOLAPI SetCurrentDirectoryW(
+    WCHAR *lpPathName	// @pyparm str/<o PyUnicode>|lpPathName||Name of the path to set current.
+);
+#endif // MS_WINCE
+
+// @pyswig |SetEndOfFile|Moves the end-of-file (EOF) position for the specified file to the current position of the file pointer. 
+BOOL SetEndOfFile(
     PyHANDLE hFile	// @pyparm <o PyHANDLE>|hFile||handle of file whose EOF is to be set 
 );
 
@@ -1791,6 +3982,121 @@ PyCFunction pfnpy_TransmitFile=(PyCFunction)py_TransmitFile;
 %}
 %native(TransmitFile) pfnpy_TransmitFile;
 
+// @pyswig int|TransmitPackets|Transmits in-memory data and file ranges over a connected socket in a single call.
+// @rdesc The result is 0 or ERROR_IO_PENDING.
+// @comm Memory elements are sent directly from the objects passed, without a copy.
+// When an overlapped object is used, the elements are attached to it as its buffer
+// attribute so they live until the overlapped is next used; buffers must not be
+// modified or resized while the operation is pending.
+static PyObject *py_TransmitPackets( PyObject *self, PyObject *args, PyObject *kwargs ) {
+	PyObject *obSocket, *obElements, *obOverlapped = Py_None;
+	DWORD flags = 0, sendSize = 0;
+	static char *keywords[]={"Socket","Elements","Overlapped","Flags","SendSize", NULL};
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|Okk:TransmitPackets", keywords,
+		&obSocket, // @pyparm <o PySocket>/int|Socket||A connected socket.
+		&obElements, // @pyparm [<o buffer>\|(<o PyHANDLE>, int, int), ...]|Elements||The data to send.  Each item is either a buffer to send, or a tuple of (hFile, offset, length) to send part of a file.  A length of 0 sends the file from offset to its end.
+		&obOverlapped, // @pyparm <o PyOVERLAPPED>|Overlapped|None|An overlapped structure, or None.
+		&flags, // @pyparm int|Flags|0|A combination of win32file.TF_* values.
+		&sendSize)) // @pyparm int|SendSize|0|The size of each send operation, or 0 for the default.
+		return NULL;
+	SOCKET s;
+	if (!PySocket_AsSOCKET(obSocket, &s))
+		return NULL;
+	OVERLAPPED *pOverlapped;
+	if (!PyWinObject_AsOVERLAPPED(obOverlapped, &pOverlapped, TRUE))
+		return NULL;
+	GUID guid = WSAID_TRANSMITPACKETS;
+	DWORD dwBytes;
+	LPFN_TRANSMITPACKETS lpfnTransmitPackets = NULL;
+	if (WSAIoctl(s, SIO_GET_EXTENSION_FUNCTION_POINTER, &guid, sizeof(GUID),
+			&lpfnTransmitPackets, sizeof(lpfnTransmitPackets), &dwBytes, NULL, NULL) == SOCKET_ERROR)
+		return PyWin_SetAPIError("WSAIoctl", WSAGetLastError());
+
+	PyObject *obTuple = PySequence_Tuple(obElements);
+	if (obTuple == NULL)
+		return NULL;
+	Py_ssize_t i, n = PyTuple_GET_SIZE(obTuple);
+	PyObject *ret = NULL, *obArray = NULL;
+	Py_buffer *views = (Py_buffer *)calloc(n ? n : 1, sizeof(Py_buffer));
+	if (views == NULL) {
+		PyErr_NoMemory();
+		goto done;
+	}
+	if (n > MAXDWORD) {
+		PyErr_SetString(PyExc_ValueError, "Too many elements");
+		goto done;
+	}
+	// The element array is held in a bytes object, so it can be attached to
+	// the overlapped along with the elements.
+	obArray = PyBytes_FromStringAndSize(NULL, (n ? n : 1) * sizeof(TRANSMIT_PACKETS_ELEMENT));
+	if (obArray == NULL)
+		goto done;
+	{
+	TRANSMIT_PACKETS_ELEMENT *elts = (TRANSMIT_PACKETS_ELEMENT *)PyBytes_AS_STRING(obArray);
+	memset(elts, 0, n * sizeof(TRANSMIT_PACKETS_ELEMENT));
+	for (i=0;i<n;i++) {
+		PyObject *ob = PyTuple_GET_ITEM(obTuple, i);
+		if (PyTuple_Check(ob)) {
+			PyObject *obFile;
+			PY_LONG_LONG offset;
+			DWORD length;
+			if (!PyArg_ParseTuple(ob, "OLk:TransmitPackets element", &obFile, &offset, &length))
+				goto done;
+			if (!PyWinObject_AsHANDLE(obFile, &elts[i].hFile))
+				goto done;
+			elts[i].dwElFlags = TP_ELEMENT_FILE;
+			elts[i].nFileOffset.QuadPart = offset;
+			elts[i].cLength = length;
+		}
+		else {
+			if (PyObject_GetBuffer(ob, &views[i], PyBUF_SIMPLE) == -1) {
+				views[i].obj = NULL;
+				goto done;
+			}
+			if (views[i].len > MAXDWORD) {
+				PyErr_SetString(PyExc_ValueError, "A memory element is too large");
+				goto done;
+			}
+			elts[i].dwElFlags = TP_ELEMENT_MEMORY;
+			elts[i].pBuffer = views[i].buf;
+			elts[i].cLength = (ULONG)views[i].len;
+		}
+	}
+	if (pOverlapped) {
+		PyObject *obKeep = Py_BuildValue("OO", obTuple, obArray);
+		if (obKeep == NULL)
+			goto done;
+		rbp_attach(pOverlapped, obKeep);
+		Py_DECREF(obKeep);
+	}
+	int rc = 0;
+	Py_BEGIN_ALLOW_THREADS;
+	if (!lpfnTransmitPackets(s, elts, (DWORD)n, sendSize, pOverlapped, flags))
+		rc = WSAGetLastError();
+	Py_END_ALLOW_THREADS;
+	if (rc == 0 || rc == ERROR_IO_PENDING || rc == WSA_IO_PENDING)
+		ret = PyInt_FromLong(rc);
+	else {
+		if (pOverlapped)
+			rbp_attach(pOverlapped, NULL);
+		PyWin_SetAPIError("TransmitPackets", rc);
+	}
+	}
+done:
+	if (views) {
+		for (i=0;i<n;i++)
+			if (views[i].obj)
+				PyBuffer_Release(&views[i]);
+		free(views);
+	}
+	Py_XDECREF(obArray);
+	Py_DECREF(obTuple);
+	return ret;
+}
+PyCFunction pfnpy_TransmitPackets=(PyCFunction)py_TransmitPackets;
+%}
+%native(TransmitPackets) pfnpy_TransmitPackets;
+
 ////////////////////////////////////////////////////////////////////////////////    
 %{
 // @pyswig (int, int)|ConnectEx|Version of connect that uses Overlapped I/O
@@ -2366,56 +4672,672 @@ MyWSAEnumNetworkEvents(PyObject *self, PyObject *args)
 }
 %}
 
+// @object PySocketSelector|Waits for readiness on any number of sockets, as returned by
+// <om win32file.CreateSocketSelector>.
+// @comm Each socket has its own auto-reset event, set by WSAEventSelect and waited for by
+// the system thread pool, so there is no limit on the number of sockets (unlike select(),
+// which is limited to 512) and <om PySocketSelector.Select> only looks at the sockets whose
+// events fired.
+// <nl>Readiness is level-triggered, as for the selectors module: a socket reported ready is
+// checked again on the next Select, with a zero timeout WSAPoll over just the ready sockets,
+// and reported until it is no longer ready.
+// <nl>WSAEventSelect makes the socket non-blocking, and it stays non-blocking after it is
+// unregistered.  win32selectors.SocketSelector wraps this object as a selectors.BaseSelector.
 %{
+#define SELECTOR_EVENT_READ 1	// selectors.EVENT_READ
+#define SELECTOR_EVENT_WRITE 2	// selectors.EVENT_WRITE
 
-PyObject* MyWSAAsyncSelect
-(
-	SOCKET *s, 
-	HWND hwnd,
-	LONG wMsg,
-	LONG lNetworkEvents
-)
+struct PySocketSelector;
+
+typedef struct {
+	PySocketSelector *ss;
+	SOCKET s;
+	HANDLE hEvent;
+	HANDLE hWait;
+	int events;		// the SELECTOR_EVENT_* wanted.
+	int ready;		// the SELECTOR_EVENT_* reported by the last Select.
+	BOOL bInReady;	// in the ready array
+	BOOL bError;	// a connect failed - stays ready for everything.
+	PyObject *obCookie;
+	BOOL bSignalled;	// in the pending array
+	BOOL bRemoved;	// set before the wait is unregistered
+} PySocketSelectorEntry;
+
+struct PySocketSelector {
+	PyObject_HEAD
+	CRITICAL_SECTION cs;	// protects the pending array and the flags of the entries
+	HANDLE hReady;		// auto-reset, signalled when an entry is added to the pending array
+	HANDLE hStop;		// signalled by Close
+	BOOL bClosed;
+	// socket -> entry, linear probing.  Only changed with the GIL held.
+	PySocketSelectorEntry **table;
+	ULONG tableSize;	// always a power of 2, at least twice numEntries
+	ULONG numEntries;
+	// Entries whose events fired.  Always has room for every entry.
+	PySocketSelectorEntry **pending;
+	ULONG numPending, maxPending;
+	// Entries reported ready by the last Select.  Only used with the GIL held.
+	PySocketSelectorEntry **ready;
+	ULONG numReady;
+	LONG selects;		// statistics
+	LONG polled;
+};
+
+extern PyTypeObject PySocketSelector_Type;
+
+static ULONG ss_hash(SOCKET s)
 {
-	int rc;
-	Py_BEGIN_ALLOW_THREADS;
-	rc = WSAAsyncSelect(*s, hwnd, wMsg, lNetworkEvents);
-	Py_END_ALLOW_THREADS;
-	if (rc == SOCKET_ERROR)
-	{
-		PyWin_SetAPIError("WSAAsyncSelect", WSAGetLastError());
-		return NULL;
+	ULONG_PTR v = (ULONG_PTR)s;
+	return (ULONG)((v >> 2) ^ (v >> 17)) * 2654435761U;
+}
+
+static ULONG ss_find(PySocketSelector *ss, SOCKET s)
+{
+	ULONG mask = ss->tableSize - 1;
+	ULONG i = ss_hash(s) & mask;
+	while (ss->table[i] && ss->table[i]->s != s)
+		i = (i + 1) & mask;
+	return i;
+}
+
+// Makes room for one more entry - in the table, the pending array and the ready array.
+static BOOL ss_reserve(PySocketSelector *ss)
+{
+	if (ss->numEntries + 1 > ss->maxPending) {
+		ULONG maxPending = ss->maxPending ? ss->maxPending * 2 : 64;
+		PySocketSelectorEntry **ready = (PySocketSelectorEntry **)realloc(ss->ready, maxPending * sizeof(PySocketSelectorEntry *));
+		if (ready == NULL)
+			return FALSE;
+		ss->ready = ready;
+		// The pool callbacks append to the pending array, so only grow it with the critical section held.
+		EnterCriticalSection(&ss->cs);
+		PySocketSelectorEntry **pending = (PySocketSelectorEntry **)realloc(ss->pending, maxPending * sizeof(PySocketSelectorEntry *));
+		if (pending) {
+			ss->pending = pending;
+			ss->maxPending = maxPending;
+		}
+		LeaveCriticalSection(&ss->cs);
+		if (pending == NULL)
+			return FALSE;
 	}
-	Py_INCREF(Py_None);
-	return Py_None;
+	if ((ss->numEntries + 1) * 2 > ss->tableSize) {
+		ULONG oldSize = ss->tableSize;
+		PySocketSelectorEntry **old = ss->table;
+		ULONG tableSize = oldSize ? oldSize * 2 : 128;
+		PySocketSelectorEntry **table = (PySocketSelectorEntry **)calloc(tableSize, sizeof(PySocketSelectorEntry *));
+		if (table == NULL)
+			return FALSE;
+		ss->table = table;
+		ss->tableSize = tableSize;
+		for (ULONG i=0;i<oldSize;i++)
+			if (old[i])
+				ss->table[ss_find(ss, old[i]->s)] = old[i];
+		free(old);
+	}
+	return TRUE;
 }
 
-%}
+// Removes the entry at slot i of the table, shifting back any entries after it
+// so the probe sequences stay unbroken.
+static void ss_unlink(PySocketSelector *ss, ULONG i)
+{
+	ULONG mask = ss->tableSize - 1;
+	ss->table[i] = NULL;
+	ss->numEntries--;
+	for (ULONG j = (i + 1) & mask; ss->table[j]; j = (j + 1) & mask) {
+		PySocketSelectorEntry *e = ss->table[j];
+		ss->table[j] = NULL;
+		ss->table[ss_find(ss, e->s)] = e;
+	}
+}
 
-// @pyswig |WSAAsyncSelect|Request windows message notification for the supplied set of FD_XXXX network events.
-%name(WSAAsyncSelect) PyObject *MyWSAAsyncSelect
-(
-	SOCKET *s, // @pyparm <o PySocket>|socket||socket to attach to the event
-	HWND hwnd, // @pyparm <o hwnd>|hwnd||Window handle for the socket to become attached to.
-	LONG wMsg, // @pyparm <o int>|int||Window message that will be posted.
-	LONG lNetworkEvents // @pyparm int|networkEvents||A bitmask of network events that will cause wMsg to be posted. e.g. (FD_CLOSE \| FD_READ)
-);
+// Thread pool callback, without the GIL.  The wait stays registered, and the
+// auto-reset event is reset by the wait itself.
+static VOID CALLBACK ss_signalled(PVOID param, BOOLEAN timedOut)
+{
+	PySocketSelectorEntry *e = (PySocketSelectorEntry *)param;
+	PySocketSelector *ss = e->ss;
+	EnterCriticalSection(&ss->cs);
+	if (!e->bRemoved && !e->bSignalled) {
+		e->bSignalled = TRUE;
+		ss->pending[ss->numPending++] = e;
+		SetEvent(ss->hReady);
+	}
+	LeaveCriticalSection(&ss->cs);
+}
 
-%native(WSASend) MyWSASend;
-%native(WSARecv) MyWSARecv;
+static long ss_network_events(int events)
+{
+	long ret = FD_CLOSE;
+	if (events & SELECTOR_EVENT_READ)
+		ret |= FD_READ | FD_ACCEPT;
+	if (events & SELECTOR_EVENT_WRITE)
+		ret |= FD_WRITE | FD_CONNECT;
+	return ret;
+}
 
-%{
-// @pyswig (rc, cBytesSent)|WSASend|Winsock send() equivalent function for Overlapped I/O.
-PyObject *MyWSASend
-(
-	PyObject *self,
-	PyObject *args
-)
+// Unregisters the waits of entries which are no longer in the table, and frees them.
+// Called with the GIL held.
+static void ss_free_entries(PySocketSelector *ss, PySocketSelectorEntry **entries, ULONG num)
 {
-	SOCKET s;
-	PyObject *obSocket = NULL;
-	WSABUF wsBuf;
-	DWORD cbSent = 0;
-	OVERLAPPED *pOverlapped = NULL;
+	EnterCriticalSection(&ss->cs);
+	for (ULONG i=0;i<num;i++) {
+		PySocketSelectorEntry *e = entries[i];
+		e->bRemoved = TRUE;
+		if (e->bSignalled) {
+			for (ULONG j=0;j<ss->numPending;j++) {
+				if (ss->pending[j] == e) {
+					memmove(ss->pending + j, ss->pending + j + 1, (ss->numPending - j - 1) * sizeof(PySocketSelectorEntry *));
+					ss->numPending--;
+					break;
+				}
+			}
+		}
+	}
+	LeaveCriticalSection(&ss->cs);
+	for (ULONG i=0;i<num;i++) {
+		if (entries[i]->bInReady) {
+			for (ULONG j=0;j<ss->numReady;j++) {
+				if (ss->ready[j] == entries[i]) {
+					ss->ready[j] = ss->ready[--ss->numReady];
+					break;
+				}
+			}
+		}
+	}
+	Py_BEGIN_ALLOW_THREADS
+	for (ULONG i=0;i<num;i++) {
+		PySocketSelectorEntry *e = entries[i];
+		// Fails harmlessly if the socket has already been closed.
+		WSAEventSelect(e->s, NULL, 0);
+		// Waits for any callback in progress, which needs the critical section - but not the GIL.
+		if (e->hWait)
+			UnregisterWaitEx(e->hWait, INVALID_HANDLE_VALUE);
+		CloseHandle(e->hEvent);
+	}
+	Py_END_ALLOW_THREADS
+	for (ULONG i=0;i<num;i++) {
+		Py_XDECREF(entries[i]->obCookie);
+		free(entries[i]);
+	}
+}
+
+static void ss_close(PySocketSelector *ss)
+{
+	if (ss->bClosed)
+		return;
+	EnterCriticalSection(&ss->cs);
+	ss->bClosed = TRUE;
+	LeaveCriticalSection(&ss->cs);
+	SetEvent(ss->hStop);
+	ULONG num = 0;
+	PySocketSelectorEntry **entries = ss->table;
+	for (ULONG i=0;i<ss->tableSize;i++)
+		if (ss->table[i])
+			entries[num++] = ss->table[i];
+	ss->table = NULL;
+	ss->tableSize = ss->numEntries = 0;
+	ss_free_entries(ss, entries, num);
+	free(entries);
+}
+
+static void ss_dealloc(PyObject *ob)
+{
+	PySocketSelector *ss = (PySocketSelector *)ob;
+	ss_close(ss);
+	DeleteCriticalSection(&ss->cs);
+	if (ss->hReady)
+		CloseHandle(ss->hReady);
+	if (ss->hStop)
+		CloseHandle(ss->hStop);
+	free(ss->pending);
+	free(ss->ready);
+	PyObject_Del(ob);
+}
+
+static PySocketSelectorEntry *ss_lookup(PySocketSelector *ss, PyObject *obSocket, SOCKET *ps, ULONG *pslot)
+{
+	if (ss->bClosed) {
+		PyErr_SetString(PyExc_ValueError, "The selector has been closed");
+		return NULL;
+	}
+	if (!PySocket_AsSOCKET(obSocket, ps))
+		return NULL;
+	if (ss->tableSize == 0) {
+		*pslot = 0;
+		return NULL;
+	}
+	*pslot = ss_find(ss, *ps);
+	return ss->table[*pslot];
+}
+
+static BOOL ss_check_events(int events)
+{
+	if (events == 0 || (events & ~(SELECTOR_EVENT_READ | SELECTOR_EVENT_WRITE))) {
+		PyErr_Format(PyExc_ValueError, "Invalid events: %d", events);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+// @pymethod |PySocketSelector|Register|Starts watching a socket.
+// @comm Raises ValueError if the socket is already registered.
+static PyObject *ss_Register(PyObject *self, PyObject *args)
+{
+	PySocketSelector *ss = (PySocketSelector *)self;
+	PyObject *obSocket, *obCookie = Py_None;
+	int events;
+	if (!PyArg_ParseTuple(args, "Oi|O:Register",
+		&obSocket, // @pyparm <o PySocket>|socket||The socket, or its integer handle.
+		&events, // @pyparm int|events||A combination of selectors.EVENT_READ and selectors.EVENT_WRITE
+		&obCookie)) // @pyparm object|cookie|None|The object <om PySocketSelector.Select> returns for the socket.  If None, the socket object is returned.
+		return NULL;
+	SOCKET s;
+	ULONG slot;
+	if (ss_lookup(ss, obSocket, &s, &slot))
+		return PyErr_Format(PyExc_ValueError, "The socket is already registered");
+	if (PyErr_Occurred() || !ss_check_events(events))
+		return NULL;
+	if (!ss_reserve(ss))
+		return PyErr_NoMemory();
+	slot = ss_find(ss, s);
+	PySocketSelectorEntry *e = (PySocketSelectorEntry *)calloc(1, sizeof(PySocketSelectorEntry));
+	if (e == NULL)
+		return PyErr_NoMemory();
+	e->ss = ss;
+	e->s = s;
+	e->events = events;
+	e->obCookie = obCookie == Py_None ? obSocket : obCookie;
+	Py_INCREF(e->obCookie);
+	e->hEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	if (e->hEvent == NULL) {
+		PyWin_SetAPIError("CreateEvent");
+		Py_DECREF(e->obCookie);
+		free(e);
+		return NULL;
+	}
+	// The entry is in the table before the wait is registered, as the callback may run at once.
+	ss->table[slot] = e;
+	ss->numEntries++;
+	const char *fname = NULL;
+	DWORD err = 0;
+	if (WSAEventSelect(s, e->hEvent, ss_network_events(events)) == SOCKET_ERROR) {
+		fname = "WSAEventSelect";
+		err = WSAGetLastError();
+	}
+	else if (!RegisterWaitForSingleObject(&e->hWait, e->hEvent, ss_signalled, e, INFINITE, WT_EXECUTEINWAITTHREAD)) {
+		fname = "RegisterWaitForSingleObject";
+		err = GetLastError();
+		e->hWait = NULL;
+	}
+	if (fname) {
+		ss_unlink(ss, slot);
+		ss_free_entries(ss, &e, 1);
+		return PyWin_SetAPIError(fname, err);
+	}
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+// @pymethod |PySocketSelector|Modify|Changes the events watched for a socket, and its cookie.
+// @comm Raises KeyError if the socket is not registered.
+static PyObject *ss_Modify(PyObject *self, PyObject *args)
+{
+	PySocketSelector *ss = (PySocketSelector *)self;
+	PyObject *obSocket, *obCookie = Py_None;
+	int events;
+	if (!PyArg_ParseTuple(args, "Oi|O:Modify",
+		&obSocket, // @pyparm <o PySocket>|socket||The socket, or its integer handle.
+		&events, // @pyparm int|events||A combination of selectors.EVENT_READ and selectors.EVENT_WRITE
+		&obCookie)) // @pyparm object|cookie|None|The new cookie.  If None, the cookie is not changed.
+		return NULL;
+	SOCKET s;
+	ULONG slot;
+	PySocketSelectorEntry *e = ss_lookup(ss, obSocket, &s, &slot);
+	if (e == NULL) {
+		if (!PyErr_Occurred())
+			PyErr_SetObject(PyExc_KeyError, obSocket);
+		return NULL;
+	}
+	if (!ss_check_events(events))
+		return NULL;
+	if (events != e->events) {
+		int rc;
+		Py_BEGIN_ALLOW_THREADS
+		// Records the conditions which are already true again, so nothing is lost.
+		rc = WSAEventSelect(s, e->hEvent, ss_network_events(events));
+		Py_END_ALLOW_THREADS
+		if (rc == SOCKET_ERROR)
+			return PyWin_SetAPIError("WSAEventSelect", WSAGetLastError());
+		e->events = events;
+	}
+	if (obCookie != Py_None) {
+		Py_INCREF(obCookie);
+		Py_DECREF(e->obCookie);
+		e->obCookie = obCookie;
+	}
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+// @pymethod bool|PySocketSelector|Unregister|Stops watching a socket.
+// @rdesc False if the socket was not registered.
+// @comm The socket may already have been closed.
+static PyObject *ss_Unregister(PyObject *self, PyObject *args)
+{
+	PySocketSelector *ss = (PySocketSelector *)self;
+	PyObject *obSocket;
+	if (!PyArg_ParseTuple(args, "O:Unregister",
+		&obSocket)) // @pyparm <o PySocket>|socket||The socket, or its integer handle.
+		return NULL;
+	SOCKET s;
+	ULONG slot;
+	PySocketSelectorEntry *e = ss_lookup(ss, obSocket, &s, &slot);
+	if (e == NULL)
+		return PyErr_Occurred() ? NULL : PyBool_FromLong(FALSE);
+	ss_unlink(ss, slot);
+	ss_free_entries(ss, &e, 1);
+	return PyBool_FromLong(TRUE);
+}
+
+// Folds the network events of an entry whose event fired into its readiness.
+static void ss_enum_events(PySocketSelectorEntry *e, long *pNetworkEvents)
+{
+	WSANETWORKEVENTS ne;
+	if (WSAEnumNetworkEvents(e->s, NULL, &ne) == SOCKET_ERROR) {
+		// Probably closed under us - let the caller find out.
+		e->bError = TRUE;
+		return;
+	}
+	*pNetworkEvents = ne.lNetworkEvents;
+	if (ne.lNetworkEvents & (FD_READ | FD_ACCEPT | FD_CLOSE))
+		e->ready |= SELECTOR_EVENT_READ;
+	if (ne.lNetworkEvents & (FD_WRITE | FD_CONNECT | FD_CLOSE))
+		e->ready |= SELECTOR_EVENT_WRITE;
+	if ((ne.lNetworkEvents & FD_CONNECT) && ne.iErrorCode[FD_CONNECT_BIT])
+		e->bError = TRUE;
+}
+
+// @pymethod [(object, int, int), ...]|PySocketSelector|Select|Waits until at least one socket is ready.
+// @rdesc A list of (cookie, events, networkEvents) tuples, or an empty list if the timeout expires.
+// events is the combination of selectors.EVENT_READ and selectors.EVENT_WRITE the socket is ready for, and
+// networkEvents the FD_* events which WSAEnumNetworkEvents reported for it in this call (0 if it was
+// still ready from the last call).
+// @comm Only one thread should call Select at a time.  Raises ValueError if the selector is closed,
+// including by another thread while waiting.
+static PyObject *ss_Select(PyObject *self, PyObject *args)
+{
+	PySocketSelector *ss = (PySocketSelector *)self;
+	DWORD timeout = INFINITE;
+	if (!PyArg_ParseTuple(args, "|k:Select",
+		&timeout)) // @pyparm int|milliseconds|win32event.INFINITE|The time-out interval.
+		return NULL;
+	DWORD start = GetTickCount();
+	long *networkEvents = NULL;
+	WSAPOLLFD *fds = NULL;
+	for (;;) {
+		if (ss->bClosed)
+			return PyErr_Format(PyExc_ValueError, "The selector has been closed");
+		// The sockets still ready from the last call, checked without waiting.
+		ULONG numReady = ss->numReady;
+		if (numReady) {
+			fds = (WSAPOLLFD *)malloc(numReady * sizeof(WSAPOLLFD));
+			networkEvents = (long *)calloc(ss->numEntries, sizeof(long));
+			if (fds == NULL || networkEvents == NULL)
+				goto nomem;
+			for (ULONG i=0;i<numReady;i++) {
+				PySocketSelectorEntry *e = ss->ready[i];
+				fds[i].fd = e->s;
+				fds[i].events = ((e->events & SELECTOR_EVENT_READ) ? POLLRDNORM : 0)
+					| ((e->events & SELECTOR_EVENT_WRITE) ? POLLWRNORM : 0);
+				fds[i].revents = 0;
+			}
+			int rc;
+			Py_BEGIN_ALLOW_THREADS
+			rc = WSAPoll(fds, numReady, 0);
+			Py_END_ALLOW_THREADS
+			ss->polled += numReady;
+			for (ULONG i=0;i<numReady;i++) {
+				PySocketSelectorEntry *e = ss->ready[i];
+				if (e->bError)
+					continue;
+				e->ready = 0;
+				if (rc == SOCKET_ERROR)
+					continue;  // report nothing for these rather than fail.
+				if (fds[i].revents & (POLLRDNORM | POLLHUP | POLLERR | POLLNVAL))
+					e->ready |= SELECTOR_EVENT_READ;
+				if (fds[i].revents & (POLLWRNORM | POLLHUP | POLLERR | POLLNVAL))
+					e->ready |= SELECTOR_EVENT_WRITE;
+			}
+			free(fds);
+			fds = NULL;
+		}
+		// Then the sockets whose events fired.
+		EnterCriticalSection(&ss->cs);
+		ULONG numPending = ss->numPending;
+		PySocketSelectorEntry **pending = NULL;
+		if (numPending) {
+			pending = (PySocketSelectorEntry **)malloc(numPending * sizeof(PySocketSelectorEntry *));
+			if (pending) {
+				memcpy(pending, ss->pending, numPending * sizeof(PySocketSelectorEntry *));
+				ss->numPending = 0;
+				for (ULONG i=0;i<numPending;i++)
+					pending[i]->bSignalled = FALSE;
+			}
+		}
+		LeaveCriticalSection(&ss->cs);
+		if (numPending && pending == NULL)
+			goto nomem;
+		if (numPending && networkEvents == NULL && (networkEvents = (long *)calloc(ss->numEntries, sizeof(long))) == NULL) {
+			free(pending);
+			goto nomem;
+		}
+		for (ULONG i=0;i<numPending;i++) {
+			PySocketSelectorEntry *e = pending[i];
+			long ne = 0;
+			ss_enum_events(e, &ne);
+			if ((e->ready || e->bError) && !e->bInReady) {
+				ss->ready[ss->numReady++] = e;
+				e->bInReady = TRUE;
+			}
+			for (ULONG j=0;j<ss->numReady;j++)
+				if (ss->ready[j] == e) {
+					networkEvents[j] = ne;
+					break;
+				}
+		}
+		free(pending);
+		// Build the result from the ready array, dropping those no longer ready.
+		PyObject *ret = PyList_New(0);
+		ULONG kept = 0;
+		for (ULONG i=0;i<ss->numReady;i++) {
+			PySocketSelectorEntry *e = ss->ready[i];
+			int events = (e->bError ? SELECTOR_EVENT_READ | SELECTOR_EVENT_WRITE : e->ready) & e->events;
+			if (e->bError)
+				e->ready = e->events;
+			if (e->ready == 0) {
+				e->bInReady = FALSE;
+				continue;
+			}
+			long ne = networkEvents[i];
+			ss->ready[kept] = e;
+			networkEvents[kept++] = ne;
+			if (events && ret) {
+				PyObject *item = Py_BuildValue("Oil", e->obCookie, events, ne);
+				if (item == NULL || PyList_Append(ret, item) == -1)
+					Py_CLEAR(ret);
+				Py_XDECREF(item);
+			}
+		}
+		ss->numReady = kept;
+		free(networkEvents);
+		networkEvents = NULL;
+		if (ret == NULL || PyList_GET_SIZE(ret)) {
+			ss->selects++;
+			return ret;
+		}
+		Py_DECREF(ret);
+		DWORD wait = INFINITE;
+		if (timeout != INFINITE) {
+			DWORD elapsed = GetTickCount() - start;
+			if (elapsed >= timeout)
+				return PyList_New(0);
+			wait = timeout - elapsed;
+		}
+		HANDLE handles[2] = {ss->hReady, ss->hStop};
+		DWORD rc;
+		Py_BEGIN_ALLOW_THREADS
+		rc = WaitForMultipleObjects(2, handles, FALSE, wait);
+		Py_END_ALLOW_THREADS
+		if (rc == WAIT_FAILED)
+			return PyWin_SetAPIError("WaitForMultipleObjects");
+	}
+nomem:
+	free(fds);
+	free(networkEvents);
+	return PyErr_NoMemory();
+}
+
+// @pymethod |PySocketSelector|Close|Stops watching all sockets.
+static PyObject *ss_Close(PyObject *self, PyObject *args)
+{
+	if (!PyArg_ParseTuple(args, ":Close"))
+		return NULL;
+	ss_close((PySocketSelector *)self);
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+static Py_ssize_t ss_length(PyObject *self)
+{
+	return ((PySocketSelector *)self)->numEntries;
+}
+
+static PySequenceMethods ss_sequence = {
+	ss_length,	/* sq_length */
+};
+
+static PyMethodDef ss_methods[] = {
+	{"Register", ss_Register, METH_VARARGS}, // @pymeth Register|Starts watching a socket.
+	{"Modify", ss_Modify, METH_VARARGS}, // @pymeth Modify|Changes the events watched for a socket.
+	{"Unregister", ss_Unregister, METH_VARARGS}, // @pymeth Unregister|Stops watching a socket.
+	{"Select", ss_Select, METH_VARARGS}, // @pymeth Select|Waits until at least one socket is ready.
+	{"Close", ss_Close, METH_VARARGS}, // @pymeth Close|Stops watching all sockets.
+	{NULL}
+};
+
+#define OFF(e) offsetof(PySocketSelector, e)
+static PyMemberDef ss_members[] = {
+	{"selects", T_LONG, OFF(selects), READONLY}, // @prop int|selects|The number of non-empty lists returned by <om PySocketSelector.Select>.
+	{"polled", T_LONG, OFF(polled), READONLY}, // @prop int|polled|The number of sockets checked again because they were ready in the previous call.
+	{NULL}
+};
+#undef OFF
+
+PyTypeObject PySocketSelector_Type = {
+	PYWIN_OBJECT_HEAD
+	"PySocketSelector",			/* tp_name */
+	sizeof(PySocketSelector),		/* tp_basicsize */
+	0,					/* tp_itemsize */
+	ss_dealloc,				/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	&ss_sequence,				/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	0,					/* tp_iter */
+	0,					/* tp_iternext */
+	ss_methods,				/* tp_methods */
+	ss_members,				/* tp_members */
+};
+
+// @pyswig <o PySocketSelector>|CreateSocketSelector|Creates an object which waits for readiness on any number of sockets.
+static PyObject *MyCreateSocketSelector(PyObject *self, PyObject *args)
+{
+	if (!PyArg_ParseTuple(args, ":CreateSocketSelector"))
+		return NULL;
+	PySocketSelector *ss = PyObject_New(PySocketSelector, &PySocketSelector_Type);
+	if (ss == NULL)
+		return NULL;
+	memset(((BYTE *)ss) + sizeof(PyObject), 0, sizeof(PySocketSelector) - sizeof(PyObject));
+	InitializeCriticalSection(&ss->cs);
+	ss->hReady = CreateEvent(NULL, FALSE, FALSE, NULL);
+	ss->hStop = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if (ss->hReady == NULL || ss->hStop == NULL) {
+		PyWin_SetAPIError("CreateEvent");
+		Py_DECREF(ss);
+		return NULL;
+	}
+	return (PyObject *)ss;
+}
+%}
+%native(CreateSocketSelector) MyCreateSocketSelector;
+
+%{
+
+PyObject* MyWSAAsyncSelect
+(
+	SOCKET *s, 
+	HWND hwnd,
+	LONG wMsg,
+	LONG lNetworkEvents
+)
+{
+	int rc;
+	Py_BEGIN_ALLOW_THREADS;
+	rc = WSAAsyncSelect(*s, hwnd, wMsg, lNetworkEvents);
+	Py_END_ALLOW_THREADS;
+	if (rc == SOCKET_ERROR)
+	{
+		PyWin_SetAPIError("WSAAsyncSelect", WSAGetLastError());
+		return NULL;
+	}
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+%}
+
+// @pyswig |WSAAsyncSelect|Request windows message notification for the supplied set of FD_XXXX network events.
+%name(WSAAsyncSelect) PyObject *MyWSAAsyncSelect
+(
+	SOCKET *s, // @pyparm <o PySocket>|socket||socket to attach to the event
+	HWND hwnd, // @pyparm <o hwnd>|hwnd||Window handle for the socket to become attached to.
+	LONG wMsg, // @pyparm <o int>|int||Window message that will be posted.
+	LONG lNetworkEvents // @pyparm int|networkEvents||A bitmask of network events that will cause wMsg to be posted. e.g. (FD_CLOSE \| FD_READ)
+);
+
+%native(WSASend) MyWSASend;
+%native(WSARecv) MyWSARecv;
+
+%{
+// @pyswig (rc, cBytesSent)|WSASend|Winsock send() equivalent function for Overlapped I/O.
+PyObject *MyWSASend
+(
+	PyObject *self,
+	PyObject *args
+)
+{
+	SOCKET s;
+	PyObject *obSocket = NULL;
+	WSABUF wsBuf;
+	DWORD cbSent = 0;
+	OVERLAPPED *pOverlapped = NULL;
 	int rc = 0;
 	PyObject *rv = NULL;
 	PyObject *obTemp = NULL;
@@ -2496,7 +5418,6 @@ PyObject *MyWSASend
 Cleanup:
 	return rv;
 Error:
-	Py_XDECREF(obBuf);
 	Py_XDECREF(rv);
 	rv = NULL;
 	goto Cleanup;
@@ -2525,7 +5446,7 @@ PyObject *MyWSARecv
 		args,
 		"OOO|i:WSARecv",
 		&obSocket, // @pyparm <o PySocket>/int|s||Socket to send data on.
-		&obBuf, // @pyparm <o buffer>|buffer||Buffer to send data from.
+		&obBuf, // @pyparm <o buffer>/<o PyReadBufferPool>|buffer||Buffer to receive data into, or a pool to lease one from.  A leased buffer is available as the buffer attribute of the overlapped object.
 		&obOverlapped, // @pyparm <o PyOVERLAPPED>|ol||An overlapped structure
 		&dwFlags)) // @pyparm int|dwFlags||Optional reception flags.
 	{
@@ -2542,6 +5463,21 @@ PyObject *MyWSARecv
 		return NULL;
 	}
 
+	// A buffer leased from a pool is attached to the overlapped before the
+	// receive starts, as it may complete on another thread as soon as we
+	// release the GIL.
+	PyObject *obLease = NULL;
+	if (PyReadBufferPool_Check(obBuf)) {
+		if (pOverlapped == NULL)
+			return PyErr_Format(PyExc_TypeError, "A PyReadBufferPool can only be used with an overlapped object");
+		obLease = rbp_lease((PyReadBufferPool *)obBuf);
+		if (obLease == NULL)
+			return NULL;
+		obBuf = obLease;
+		rbp_attach(pOverlapped, obLease);
+		Py_DECREF(obLease);
+	}
+
 	PyWinBufferView pybuf(obBuf, true);
 	if (!pybuf.ok())
 		return NULL;
@@ -2565,6 +5501,8 @@ PyObject *MyWSARecv
 		if (rc != ERROR_IO_PENDING)
 		{
 			PyWin_SetAPIError("WSARecv", rc);
+			if (obLease)
+				rbp_attach(pOverlapped, NULL);
 			goto Error;
 		}
 	}
@@ -2594,55 +5532,503 @@ PyObject *MyWSARecv
 Cleanup:
 	return rv;
 Error:
-	Py_DECREF(obBuf);
 	Py_XDECREF(rv);
 	rv = NULL;
 	goto Cleanup;
 }
 
 
-%}
 
-#define SO_UPDATE_ACCEPT_CONTEXT SO_UPDATE_ACCEPT_CONTEXT
-#define SO_UPDATE_CONNECT_CONTEXT SO_UPDATE_CONNECT_CONTEXT
-#define SO_CONNECT_TIME SO_CONNECT_TIME
+// Registered I/O support.
+// The RIO functions are only available via WSAIoctl, and only on Windows 8
+// or later - they are located the first time they are needed.
+static RIO_EXTENSION_FUNCTION_TABLE rioFuncs;
+static BOOL bRIOLoaded = FALSE;
 
-#define WSAEWOULDBLOCK WSAEWOULDBLOCK
-#define WSAENETDOWN WSAENETDOWN
-#define WSAENOTCONN WSAENOTCONN
-#define WSAEINTR WSAEINTR
-#define WSAEINPROGRESS WSAEINPROGRESS
-#define WSAENETRESET WSAENETRESET
-#define WSAENOTSOCK WSAENOTSOCK
-#define WSAEFAULT WSAEFAULT
-#define WSAEOPNOTSUPP WSAEOPNOTSUPP
-#define WSAESHUTDOWN WSAESHUTDOWN
-#define WSAEMSGSIZE WSAEMSGSIZE
-#define WSAEINVAL WSAEINVAL
-#define WSAECONNABORTED WSAECONNABORTED
-#define WSAECONNRESET WSAECONNRESET
-#define WSAENOBUFS WSAENOBUFS
-#define WSAEDISCON WSAEDISCON
-#define WSA_IO_PENDING WSA_IO_PENDING
-#define WSA_OPERATION_ABORTED WSA_OPERATION_ABORTED
-#define FD_READ FD_READ
-#define FD_WRITE FD_WRITE
-#define FD_OOB FD_OOB
-#define FD_ACCEPT FD_ACCEPT
-#define FD_CONNECT FD_CONNECT
-#define FD_CLOSE FD_CLOSE
-#define FD_QOS FD_QOS
-#define FD_GROUP_QOS FD_GROUP_QOS
-#define FD_ROUTING_INTERFACE_CHANGE FD_ROUTING_INTERFACE_CHANGE
-#define FD_ADDRESS_LIST_CHANGE FD_ADDRESS_LIST_CHANGE
+static BOOL PyRIO_Load(SOCKET s)
+{
+	if (bRIOLoaded)
+		return TRUE;
+	// Any socket will do - create one if we weren't given one.
+	SOCKET sTemp = INVALID_SOCKET;
+	if (s == INVALID_SOCKET) {
+		sTemp = s = WSASocket(AF_INET, SOCK_DGRAM, IPPROTO_UDP, NULL, 0, WSA_FLAG_REGISTERED_IO);
+		if (s == INVALID_SOCKET) {
+			PyWin_SetAPIError("WSASocket", WSAGetLastError());
+			return FALSE;
+		}
+	}
+	GUID guid = WSAID_MULTIPLE_RIO;
+	DWORD dwBytes;
+	rioFuncs.cbSize = sizeof(rioFuncs);
+	int error = WSAIoctl(s, SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER, &guid, sizeof(GUID),
+				   &rioFuncs, sizeof(rioFuncs), &dwBytes, NULL, NULL);
+	int rc = error == SOCKET_ERROR ? WSAGetLastError() : 0;
+	if (sTemp != INVALID_SOCKET)
+		closesocket(sTemp);
+	if (error == SOCKET_ERROR) {
+		PyWin_SetAPIError("WSAIoctl", rc);
+		return FALSE;
+	}
+	bRIOLoaded = TRUE;
+	return TRUE;
+}
 
-#endif // MS_WINCE
+// @object PyRIO_BUFFER|A buffer registered for use with Registered I/O, as returned by <om win32file.RIORegisterBuffer>.
+// @comm The object supports the buffer protocol, exposing the registered memory.
+// The registration is removed when the object is destroyed, so it must be
+// kept alive until all operations using it have completed.
+typedef struct {
+	PyObject_HEAD
+	Py_buffer view;		// the registered memory.
+	RIO_BUFFERID id;
+} PyRIO_BUFFER;
 
-%native (DCB) PyWinMethod_NewDCB;
+// @object PyRIO_CQ|A Registered I/O completion queue, as returned by <om win32file.RIOCreateCompletionQueue>.
+typedef struct {
+	PyObject_HEAD
+	RIO_CQ cq;
+	PyObject *obOverlapped;	// used for completion port notification.
+} PyRIO_CQ;
 
-%typemap(python,in) DCB *
+// @object PyRIO_RQ|A Registered I/O request queue, as returned by <om win32file.RIOCreateRequestQueue>.
+// @comm The request queue is destroyed when its socket is closed, so the socket
+// should be closed before the completion queues are released.
+typedef struct {
+	PyObject_HEAD
+	RIO_RQ rq;
+	PyObject *obReceiveCQ;
+	PyObject *obSendCQ;
+} PyRIO_RQ;
+
+// @object PyRIO_RESULTS|A reusable array of RIORESULT structures, filled by <om win32file.RIODequeueCompletion>.
+// @comm The object is a sequence of the results dequeued by the last call to
+// <om win32file.RIODequeueCompletion>, each a tuple of (status, bytesTransferred,
+// socketContext, requestContext).
+typedef struct {
+	PyObject_HEAD
+	ULONG size;
+	ULONG count;
+	RIORESULT *results;
+} PyRIO_RESULTS;
+
+extern PyTypeObject PyRIO_BUFFER_Type, PyRIO_CQ_Type, PyRIO_RQ_Type, PyRIO_RESULTS_Type;
+
+static void rio_buffer_dealloc(PyObject *ob)
 {
-	if (!PyWinObject_AsDCB($source, &$target, TRUE))
+	PyRIO_BUFFER *prb = (PyRIO_BUFFER *)ob;
+	if (prb->id != RIO_INVALID_BUFFERID)
+		rioFuncs.RIODeregisterBuffer(prb->id);
+	if (prb->view.obj)
+		PyBuffer_Release(&prb->view);
+	PyObject_Del(ob);
+}
+
+static int rio_buffer_getbuffer(PyObject *ob, Py_buffer *view, int flags)
+{
+	PyRIO_BUFFER *prb = (PyRIO_BUFFER *)ob;
+	return PyBuffer_FillInfo(view, ob, prb->view.buf, prb->view.len, prb->view.readonly, flags);
+}
+
+static PyBufferProcs rio_buffer_as_buffer = {
+	rio_buffer_getbuffer,	/* bf_getbuffer */
+	0,			/* bf_releasebuffer */
+};
+
+static void rio_cq_dealloc(PyObject *ob)
+{
+	PyRIO_CQ *pcq = (PyRIO_CQ *)ob;
+	if (pcq->cq != RIO_INVALID_CQ)
+		rioFuncs.RIOCloseCompletionQueue(pcq->cq);
+	Py_XDECREF(pcq->obOverlapped);
+	PyObject_Del(ob);
+}
+
+static void rio_rq_dealloc(PyObject *ob)
+{
+	PyRIO_RQ *prq = (PyRIO_RQ *)ob;
+	Py_XDECREF(prq->obReceiveCQ);
+	Py_XDECREF(prq->obSendCQ);
+	PyObject_Del(ob);
+}
+
+static void rio_results_dealloc(PyObject *ob)
+{
+	free(((PyRIO_RESULTS *)ob)->results);
+	PyObject_Del(ob);
+}
+
+static Py_ssize_t rio_results_length(PyObject *ob)
+{
+	return ((PyRIO_RESULTS *)ob)->count;
+}
+
+static PyObject *rio_results_item(PyObject *ob, Py_ssize_t index)
+{
+	PyRIO_RESULTS *prr = (PyRIO_RESULTS *)ob;
+	if (index<0 || index>=(Py_ssize_t)prr->count) {
+		PyErr_SetString(PyExc_IndexError, "PyRIO_RESULTS index out of range");
+		return NULL;
+	}
+	RIORESULT *r = prr->results + index;
+	return Py_BuildValue("lkNN", r->Status, r->BytesTransferred,
+		PyLong_FromUnsignedLongLong(r->SocketContext),
+		PyLong_FromUnsignedLongLong(r->RequestContext));
+}
+
+static PySequenceMethods rio_results_sequence = {
+	rio_results_length,	/* sq_length */
+	0,			/* sq_concat */
+	0,			/* sq_repeat */
+	rio_results_item,	/* sq_item */
+};
+
+#define RIO_TYPE(name, type, tp_dealloc, tp_as_sequence, tp_as_buffer) { \
+	PYWIN_OBJECT_HEAD \
+	name,			/* tp_name */ \
+	sizeof(type),		/* tp_basicsize */ \
+	0,			/* tp_itemsize */ \
+	tp_dealloc,		/* tp_dealloc */ \
+	0,			/* tp_print */ \
+	0,			/* tp_getattr */ \
+	0,			/* tp_setattr */ \
+	0,			/* tp_compare */ \
+	0,			/* tp_repr */ \
+	0,			/* tp_as_number */ \
+	tp_as_sequence,		/* tp_as_sequence */ \
+	0,			/* tp_as_mapping */ \
+	0,			/* tp_hash */ \
+	0,			/* tp_call */ \
+	0,			/* tp_str */ \
+	PyObject_GenericGetAttr,	/* tp_getattro */ \
+	0,			/* tp_setattro */ \
+	tp_as_buffer,		/* tp_as_buffer */ \
+	Py_TPFLAGS_DEFAULT,	/* tp_flags */ \
+}
+
+PyTypeObject PyRIO_BUFFER_Type = RIO_TYPE("PyRIO_BUFFER", PyRIO_BUFFER, rio_buffer_dealloc, 0, &rio_buffer_as_buffer);
+PyTypeObject PyRIO_CQ_Type = RIO_TYPE("PyRIO_CQ", PyRIO_CQ, rio_cq_dealloc, 0, 0);
+PyTypeObject PyRIO_RQ_Type = RIO_TYPE("PyRIO_RQ", PyRIO_RQ, rio_rq_dealloc, 0, 0);
+PyTypeObject PyRIO_RESULTS_Type = RIO_TYPE("PyRIO_RESULTS", PyRIO_RESULTS, rio_results_dealloc, &rio_results_sequence, 0);
+#undef RIO_TYPE
+
+static int PyRIO_InitTypes(void)
+{
+	if (PyType_Ready(&PyRIO_BUFFER_Type) == -1
+		||PyType_Ready(&PyRIO_CQ_Type) == -1
+		||PyType_Ready(&PyRIO_RQ_Type) == -1
+		||PyType_Ready(&PyRIO_RESULTS_Type) == -1)
+		return -1;
+	return 0;
+}
+
+// @pyswig int|WSASocket|Creates a socket, allowing flags not available via the socket module.
+// @comm The result is the socket handle, which can be wrapped with
+// socket.socket(fileno=handle).  Sockets for use with Registered I/O must be
+// created with WSA_FLAG_REGISTERED_IO.
+static PyObject *MyWSASocket(PyObject *self, PyObject *args)
+{
+	int af, type, protocol;
+	DWORD flags = WSA_FLAG_OVERLAPPED;
+	if (!PyArg_ParseTuple(args, "iii|k:WSASocket",
+		&af, // @pyparm int|af||The address family, eg socket.AF_INET
+		&type, // @pyparm int|type||The socket type, eg socket.SOCK_DGRAM
+		&protocol, // @pyparm int|protocol||The protocol, eg socket.IPPROTO_UDP
+		&flags)) // @pyparm int|flags|WSA_FLAG_OVERLAPPED|Combination of win32file.WSA_FLAG_* values
+		return NULL;
+	SOCKET s;
+	Py_BEGIN_ALLOW_THREADS
+	s = WSASocket(af, type, protocol, NULL, 0, flags);
+	Py_END_ALLOW_THREADS
+	if (s == INVALID_SOCKET)
+		return PyWin_SetAPIError("WSASocket", WSAGetLastError());
+	return PyWinObject_FromULONG_PTR(s);
+}
+
+// @pyswig <o PyRIO_BUFFER>|RIORegisterBuffer|Registers a buffer for use with Registered I/O.
+static PyObject *MyRIORegisterBuffer(PyObject *self, PyObject *args)
+{
+	PyObject *obBuf;
+	// @pyparm <o buffer>|buffer||The memory to register.  A read-only buffer can only be used with <om win32file.RIOSend>.
+	if (!PyArg_ParseTuple(args, "O:RIORegisterBuffer", &obBuf))
+		return NULL;
+	if (!PyRIO_Load(INVALID_SOCKET))
+		return NULL;
+	PyRIO_BUFFER *prb = PyObject_New(PyRIO_BUFFER, &PyRIO_BUFFER_Type);
+	if (prb == NULL)
+		return NULL;
+	prb->id = RIO_INVALID_BUFFERID;
+	if (PyObject_GetBuffer(obBuf, &prb->view, PyBUF_WRITABLE) == -1) {
+		PyErr_Clear();
+		if (PyObject_GetBuffer(obBuf, &prb->view, PyBUF_SIMPLE) == -1) {
+			prb->view.obj = NULL;
+			Py_DECREF(prb);
+			return NULL;
+		}
+	}
+	if (prb->view.len > MAXDWORD) {
+		Py_DECREF(prb);
+		return PyErr_Format(PyExc_ValueError, "The buffer is too large to register");
+	}
+	prb->id = rioFuncs.RIORegisterBuffer((PCHAR)prb->view.buf, (DWORD)prb->view.len);
+	if (prb->id == RIO_INVALID_BUFFERID) {
+		PyWin_SetAPIError("RIORegisterBuffer", WSAGetLastError());
+		Py_DECREF(prb);
+		return NULL;
+	}
+	return prb;
+}
+
+// @pyswig <o PyRIO_CQ>|RIOCreateCompletionQueue|Creates a Registered I/O completion queue.
+static PyObject *MyRIOCreateCompletionQueue(PyObject *self, PyObject *args)
+{
+	DWORD queueSize;
+	PyObject *obPort = Py_None, *obKey = Py_None, *obOverlapped = Py_None;
+	if (!PyArg_ParseTuple(args, "k|OOO:RIOCreateCompletionQueue",
+		&queueSize, // @pyparm int|queueSize||The number of entries in the queue.
+		&obPort, // @pyparm <o PyHANDLE>|hPort|None|An I/O completion port to notify via <om win32file.RIONotify>, or None to poll the queue.
+		&obKey, // @pyparm int|completionKey|None|The completion key for notifications.
+		&obOverlapped)) // @pyparm <o PyOVERLAPPED>|overlapped|None|The overlapped object returned with notifications.  Required if hPort is given.
+		return NULL;
+	RIO_NOTIFICATION_COMPLETION notify, *pNotify = NULL;
+	if (obPort != Py_None) {
+		memset(&notify, 0, sizeof(notify));
+		notify.Type = RIO_IOCP_COMPLETION;
+		if (!PyWinObject_AsHANDLE(obPort, &notify.Iocp.IocpHandle))
+			return NULL;
+		if (obKey != Py_None && !PyWinLong_AsVoidPtr(obKey, &notify.Iocp.CompletionKey))
+			return NULL;
+		OVERLAPPED *pOverlapped;
+		if (!PyWinObject_AsOVERLAPPED(obOverlapped, &pOverlapped, FALSE))
+			return NULL;
+		notify.Iocp.Overlapped = pOverlapped;
+		pNotify = &notify;
+	}
+	if (!PyRIO_Load(INVALID_SOCKET))
+		return NULL;
+	RIO_CQ cq = rioFuncs.RIOCreateCompletionQueue(queueSize, pNotify);
+	if (cq == RIO_INVALID_CQ)
+		return PyWin_SetAPIError("RIOCreateCompletionQueue", WSAGetLastError());
+	PyRIO_CQ *pcq = PyObject_New(PyRIO_CQ, &PyRIO_CQ_Type);
+	if (pcq == NULL) {
+		rioFuncs.RIOCloseCompletionQueue(cq);
+		return NULL;
+	}
+	pcq->cq = cq;
+	// The overlapped must live as long as the queue.
+	pcq->obOverlapped = pNotify ? obOverlapped : NULL;
+	Py_XINCREF(pcq->obOverlapped);
+	return pcq;
+}
+
+// @pyswig <o PyRIO_RQ>|RIOCreateRequestQueue|Creates a Registered I/O request queue for a socket.
+static PyObject *MyRIOCreateRequestQueue(PyObject *self, PyObject *args)
+{
+	PyObject *obSocket;
+	ULONG maxOutstandingReceive, maxReceiveDataBuffers, maxOutstandingSend, maxSendDataBuffers;
+	PyObject *obReceiveCQ, *obSendCQ;
+	unsigned PY_LONG_LONG socketContext = 0;
+	if (!PyArg_ParseTuple(args, "OkkkkO!O!|K:RIOCreateRequestQueue",
+		&obSocket, // @pyparm <o PySocket>/int|s||A socket created with WSA_FLAG_REGISTERED_IO - see <om win32file.WSASocket>
+		&maxOutstandingReceive, // @pyparm int|maxOutstandingReceive||
+		&maxReceiveDataBuffers, // @pyparm int|maxReceiveDataBuffers||Currently must be 1.
+		&maxOutstandingSend, // @pyparm int|maxOutstandingSend||
+		&maxSendDataBuffers, // @pyparm int|maxSendDataBuffers||Currently must be 1.
+		&PyRIO_CQ_Type, &obReceiveCQ, // @pyparm <o PyRIO_CQ>|receiveCQ||
+		&PyRIO_CQ_Type, &obSendCQ, // @pyparm <o PyRIO_CQ>|sendCQ||May be the same queue as receiveCQ.
+		&socketContext)) // @pyparm int|socketContext|0|Returned with each result for this socket.
+		return NULL;
+	SOCKET s;
+	if (!PySocket_AsSOCKET(obSocket, &s))
+		return NULL;
+	if (!PyRIO_Load(s))
+		return NULL;
+	RIO_RQ rq = rioFuncs.RIOCreateRequestQueue(s, maxOutstandingReceive, maxReceiveDataBuffers,
+		maxOutstandingSend, maxSendDataBuffers, ((PyRIO_CQ *)obReceiveCQ)->cq,
+		((PyRIO_CQ *)obSendCQ)->cq, (PVOID)socketContext);
+	if (rq == RIO_INVALID_RQ)
+		return PyWin_SetAPIError("RIOCreateRequestQueue", WSAGetLastError());
+	PyRIO_RQ *prq = PyObject_New(PyRIO_RQ, &PyRIO_RQ_Type);
+	if (prq == NULL)
+		return NULL;
+	prq->rq = rq;
+	Py_INCREF(obReceiveCQ);
+	prq->obReceiveCQ = obReceiveCQ;
+	Py_INCREF(obSendCQ);
+	prq->obSendCQ = obSendCQ;
+	return prq;
+}
+
+// Shared by RIOReceive and RIOSend - the GIL is not released, as the calls
+// never block and the request queue must not be used by two threads at once.
+static PyObject *PyRIO_SendOrReceive(PyObject *args, BOOL bSend)
+{
+	PyObject *obRQ, *obBuf;
+	DWORD offset = 0, length = MAXDWORD, flags = 0;
+	unsigned PY_LONG_LONG requestContext = 0;
+	if (!PyArg_ParseTuple(args, bSend ? "O!O!|kkkK:RIOSend" : "O!O!|kkkK:RIOReceive",
+		&PyRIO_RQ_Type, &obRQ,
+		&PyRIO_BUFFER_Type, &obBuf,
+		&offset, &length, &flags, &requestContext))
+		return NULL;
+	PyRIO_BUFFER *prb = (PyRIO_BUFFER *)obBuf;
+	if (!bSend && prb->view.readonly)
+		return PyErr_Format(PyExc_TypeError, "Can't receive into a read-only buffer");
+	if (offset > (DWORD)prb->view.len)
+		return PyErr_Format(PyExc_ValueError, "offset is beyond the end of the buffer");
+	if (length == MAXDWORD)
+		length = (DWORD)prb->view.len - offset;
+	else if (length > (DWORD)prb->view.len - offset)
+		return PyErr_Format(PyExc_ValueError, "length extends beyond the end of the buffer");
+	RIO_BUF rb;
+	rb.BufferId = prb->id;
+	rb.Offset = offset;
+	rb.Length = length;
+	RIO_RQ rq = ((PyRIO_RQ *)obRQ)->rq;
+	BOOL ok = bSend ? rioFuncs.RIOSend(rq, &rb, 1, flags, (PVOID)requestContext)
+			: rioFuncs.RIOReceive(rq, &rb, 1, flags, (PVOID)requestContext);
+	if (!ok)
+		return PyWin_SetAPIError(bSend ? "RIOSend" : "RIOReceive", WSAGetLastError());
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+// @pyswig |RIOReceive|Queues a receive into a registered buffer.
+// @pyparm <o PyRIO_RQ>|rq||The request queue.
+// @pyparm <o PyRIO_BUFFER>|buffer||The buffer to receive into.
+// @pyparm int|offset|0|Offset into the buffer.
+// @pyparm int|length|-1|Number of bytes, or -1 for the rest of the buffer.
+// @pyparm int|flags|0|Combination of win32file.RIO_MSG_* values.
+// @pyparm int|requestContext|0|Returned with the result of this request.
+static PyObject *MyRIOReceive(PyObject *self, PyObject *args)
+{
+	return PyRIO_SendOrReceive(args, FALSE);
+}
+
+// @pyswig |RIOSend|Queues a send from a registered buffer.
+// @pyparm <o PyRIO_RQ>|rq||The request queue.
+// @pyparm <o PyRIO_BUFFER>|buffer||The buffer to send from.
+// @pyparm int|offset|0|Offset into the buffer.
+// @pyparm int|length|-1|Number of bytes, or -1 for the rest of the buffer.
+// @pyparm int|flags|0|Combination of win32file.RIO_MSG_* values.
+// @pyparm int|requestContext|0|Returned with the result of this request.
+static PyObject *MyRIOSend(PyObject *self, PyObject *args)
+{
+	return PyRIO_SendOrReceive(args, TRUE);
+}
+
+// @pyswig <o PyRIO_RESULTS>|AllocateRIOResults|Allocates a reusable array for <om win32file.RIODequeueCompletion>
+static PyObject *MyAllocateRIOResults(PyObject *self, PyObject *args)
+{
+	long size;
+	// @pyparm int|count||The maximum number of results to dequeue in one call.
+	if (!PyArg_ParseTuple(args, "l:AllocateRIOResults", &size))
+		return NULL;
+	if (size<1)
+		return PyErr_Format(PyExc_ValueError, "count must be at least 1");
+	PyRIO_RESULTS *prr = PyObject_New(PyRIO_RESULTS, &PyRIO_RESULTS_Type);
+	if (prr == NULL)
+		return NULL;
+	prr->size = (ULONG)size;
+	prr->count = 0;
+	prr->results = (RIORESULT *)calloc(size, sizeof(RIORESULT));
+	if (prr->results == NULL) {
+		Py_DECREF(prr);
+		return PyErr_NoMemory();
+	}
+	return prr;
+}
+
+// @pyswig int|RIODequeueCompletion|Removes completed requests from a completion queue.
+// @rdesc The number of results dequeued into the <o PyRIO_RESULTS> object.
+static PyObject *MyRIODequeueCompletion(PyObject *self, PyObject *args)
+{
+	PyObject *obCQ, *obResults;
+	if (!PyArg_ParseTuple(args, "O!O!:RIODequeueCompletion",
+		&PyRIO_CQ_Type, &obCQ, // @pyparm <o PyRIO_CQ>|cq||The completion queue.
+		&PyRIO_RESULTS_Type, &obResults)) // @pyparm <o PyRIO_RESULTS>|results||The array to fill, as returned by <om win32file.AllocateRIOResults>
+		return NULL;
+	PyRIO_RESULTS *prr = (PyRIO_RESULTS *)obResults;
+	prr->count = 0;
+	ULONG n = rioFuncs.RIODequeueCompletion(((PyRIO_CQ *)obCQ)->cq, prr->results, prr->size);
+	if (n == RIO_CORRUPT_CQ)
+		return PyWin_SetAPIError("RIODequeueCompletion", WSAGetLastError());
+	prr->count = n;
+	return PyLong_FromUnsignedLong(n);
+}
+
+// @pyswig |RIONotify|Requests a notification when the completion queue next has results.
+static PyObject *MyRIONotify(PyObject *self, PyObject *args)
+{
+	PyObject *obCQ;
+	// @pyparm <o PyRIO_CQ>|cq||The completion queue.
+	if (!PyArg_ParseTuple(args, "O!:RIONotify", &PyRIO_CQ_Type, &obCQ))
+		return NULL;
+	int rc = rioFuncs.RIONotify(((PyRIO_CQ *)obCQ)->cq);
+	if (rc != ERROR_SUCCESS)
+		return PyWin_SetAPIError("RIONotify", rc);
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+%}
+
+%native(WSASocket) MyWSASocket;
+%native(RIORegisterBuffer) MyRIORegisterBuffer;
+%native(RIOCreateCompletionQueue) MyRIOCreateCompletionQueue;
+%native(RIOCreateRequestQueue) MyRIOCreateRequestQueue;
+%native(RIOReceive) MyRIOReceive;
+%native(RIOSend) MyRIOSend;
+%native(AllocateRIOResults) MyAllocateRIOResults;
+%native(RIODequeueCompletion) MyRIODequeueCompletion;
+%native(RIONotify) MyRIONotify;
+
+#define WSA_FLAG_OVERLAPPED WSA_FLAG_OVERLAPPED
+#define WSA_FLAG_REGISTERED_IO WSA_FLAG_REGISTERED_IO
+#define RIO_MSG_DONT_NOTIFY RIO_MSG_DONT_NOTIFY
+#define RIO_MSG_DEFER RIO_MSG_DEFER
+#define RIO_MSG_WAITALL RIO_MSG_WAITALL
+#define RIO_MSG_COMMIT_ONLY RIO_MSG_COMMIT_ONLY
+
+#define SO_UPDATE_ACCEPT_CONTEXT SO_UPDATE_ACCEPT_CONTEXT
+#define SO_UPDATE_CONNECT_CONTEXT SO_UPDATE_CONNECT_CONTEXT
+#define SO_CONNECT_TIME SO_CONNECT_TIME
+
+#define WSAEWOULDBLOCK WSAEWOULDBLOCK
+#define WSAENETDOWN WSAENETDOWN
+#define WSAENOTCONN WSAENOTCONN
+#define WSAEINTR WSAEINTR
+#define WSAEINPROGRESS WSAEINPROGRESS
+#define WSAENETRESET WSAENETRESET
+#define WSAENOTSOCK WSAENOTSOCK
+#define WSAEFAULT WSAEFAULT
+#define WSAEOPNOTSUPP WSAEOPNOTSUPP
+#define WSAESHUTDOWN WSAESHUTDOWN
+#define WSAEMSGSIZE WSAEMSGSIZE
+#define WSAEINVAL WSAEINVAL
+#define WSAECONNABORTED WSAECONNABORTED
+#define WSAECONNRESET WSAECONNRESET
+#define WSAENOBUFS WSAENOBUFS
+#define WSAEDISCON WSAEDISCON
+#define WSA_IO_PENDING WSA_IO_PENDING
+#define WSA_OPERATION_ABORTED WSA_OPERATION_ABORTED
+#define FD_READ FD_READ
+#define FD_WRITE FD_WRITE
+#define FD_OOB FD_OOB
+#define FD_ACCEPT FD_ACCEPT
+#define FD_CONNECT FD_CONNECT
+#define FD_CLOSE FD_CLOSE
+#define FD_QOS FD_QOS
+#define FD_GROUP_QOS FD_GROUP_QOS
+#define FD_ROUTING_INTERFACE_CHANGE FD_ROUTING_INTERFACE_CHANGE
+#define FD_ADDRESS_LIST_CHANGE FD_ADDRESS_LIST_CHANGE
+
+#endif // MS_WINCE
+
+%native (DCB) PyWinMethod_NewDCB;
+
+%typemap(python,in) DCB *
+{
+	if (!PyWinObject_AsDCB($source, &$target, TRUE))
 		return NULL;
 }
 %typemap(python,argout) DCB *OUTPUT {
@@ -2904,6 +6290,9 @@ static PyObject *MyWaitCommEvent(PyObject *self, PyObject *args)
 %}
 %native (WaitCommEvent) MyWaitCommEvent;
 
+// @pyswig <o PySerialReader>|CreateSerialReader|Creates an object which reads many serial ports continuously and splits what is read into frames.
+%native (CreateSerialReader) PyWinMethod_CreateSerialReader;
+
 // Some Win2k specific volume mounting functions, thanks to Roger Upole
 %{
 #define CHECK_PFN(fname) if (pfn##fname==NULL) return PyErr_Format(PyExc_NotImplementedError,"%s is not available on this platform", #fname);
@@ -3990,6 +7379,366 @@ py_BackupWrite(PyObject *self, PyObject *args)
 	return Py_BuildValue("lN", bytes_written, PyWinLong_FromVoidPtr(ctxt));
 }
 
+// @pyswig (int, [(int, int, int, str), ...])|BackupPump|Streams the backup data of a file to a handle or a callback.
+// @comm Accepts keyword args.
+// @comm A native thread calls BackupRead into a ring of NumBuffers buffers, while
+// the calling thread passes each filled buffer to the sink.  The WIN32_STREAM_ID
+// headers are parsed natively, so the data, alternate data streams and (with
+// ProcessSecurity) the security descriptor can be dealt with one stream at a time.
+// <nl>If Sink is a handle, the backup data, headers included, is written to it
+// with WriteFile - or with BackupWrite if Restore is True, which copies all the
+// streams of Source to the file Sink.  The whole pump then runs without the GIL.
+// <nl>If Sink is callable, it is called as Sink(stream, offset, data) for each
+// piece of each stream, where stream is the (id, attributes, size, name) tuple
+// also returned in the result, offset is the position of the piece within the
+// stream and data is a read-only memoryview of the ring buffer.  The view is
+// released when the callback returns, so it must be copied if it is needed later.
+// Streams with no data are passed once, with an empty view.  If the callback raises
+// an exception the backup is aborted and the exception propagated.
+// @rdesc The total number of bytes read, and the (id, attributes, size, name)
+// tuple for each stream, where id is one of the BACKUP_* values and name is an
+// empty string for unnamed streams.
+#define BP_MAX_BUFFERS 64
+// The fixed part of a WIN32_STREAM_ID, before the name.
+#define BP_HEADER_SIZE 20
+
+typedef struct {
+	DWORD id;
+	DWORD attributes;
+	ULONGLONG size;
+	WCHAR *name;
+	DWORD nameLen;		// in characters
+} BackupStreamInfo;
+
+typedef struct {
+	HANDLE hSource;
+	BOOL bProcessSecurity;
+	BYTE *ring;
+	DWORD bufSize;
+	DWORD numBufs;
+	DWORD lens[BP_MAX_BUFFERS];
+	HANDLE hFilled;		// semaphores counting filled and free buffers
+	HANDLE hFree;
+	volatile LONG bStop;
+	DWORD err;		// the BackupRead error which ended the read, if any
+	ULONGLONG bytesRead;
+	// The stream parser
+	int state;
+	BYTE hdr[BP_HEADER_SIZE];
+	DWORD have;		// bytes of the header or name collected so far
+	DWORD nameBytes;
+	ULONGLONG remaining;	// bytes of the current stream's data still to come
+	BackupStreamInfo *streams;
+	ULONG numStreams, maxStreams;
+	BOOL bNoMemory;
+} BackupPump;
+
+#define BP_HEADER 0
+#define BP_NAME 1
+#define BP_DATA 2
+
+// Called for each piece of a stream's data.  Returns FALSE to stop.
+typedef BOOL (*BackupPieceFunc)(void *ctx, BackupPump *bp, const BYTE *data, DWORD len);
+
+static DWORD WINAPI bp_reader(LPVOID param)
+{
+	BackupPump *bp = (BackupPump *)param;
+	LPVOID ctxt = NULL;
+	DWORD n;
+	for (DWORD slot = 0;;slot = (slot + 1) % bp->numBufs) {
+		WaitForSingleObject(bp->hFree, INFINITE);
+		if (bp->bStop)
+			break;
+		if (!(*pfnBackupRead)(bp->hSource, bp->ring + (SIZE_T)slot * bp->bufSize, bp->bufSize, &n, FALSE, bp->bProcessSecurity, &ctxt)) {
+			bp->err = GetLastError();
+			n = 0;
+		}
+		bp->bytesRead += n;
+		bp->lens[slot] = n;
+		ReleaseSemaphore(bp->hFilled, 1, NULL);
+		if (n == 0)
+			break;
+	}
+	// Frees the backup context.
+	(*pfnBackupRead)(bp->hSource, NULL, 0, &n, TRUE, bp->bProcessSecurity, &ctxt);
+	return 0;
+}
+
+static BackupStreamInfo *bp_begin_stream(BackupPump *bp)
+{
+	if (bp->numStreams == bp->maxStreams) {
+		ULONG maxStreams = bp->maxStreams ? bp->maxStreams * 2 : 8;
+		BackupStreamInfo *streams = (BackupStreamInfo *)realloc(bp->streams, maxStreams * sizeof(BackupStreamInfo));
+		if (streams == NULL)
+			return NULL;
+		bp->streams = streams;
+		bp->maxStreams = maxStreams;
+	}
+	BackupStreamInfo *s = bp->streams + bp->numStreams;
+	memcpy(&s->id, bp->hdr, sizeof(DWORD));
+	memcpy(&s->attributes, bp->hdr + 4, sizeof(DWORD));
+	memcpy(&s->size, bp->hdr + 8, sizeof(ULONGLONG));
+	memcpy(&bp->nameBytes, bp->hdr + 16, sizeof(DWORD));
+	s->nameLen = bp->nameBytes / sizeof(WCHAR);
+	s->name = (WCHAR *)malloc(bp->nameBytes ? bp->nameBytes : 1);
+	if (s->name == NULL)
+		return NULL;
+	bp->numStreams++;
+	return s;
+}
+
+// Splits a buffer of backup data into headers and stream data.
+static BOOL bp_parse(BackupPump *bp, const BYTE *p, DWORD n, BackupPieceFunc fn, void *ctx)
+{
+	while (n) {
+		BackupStreamInfo *s = bp->numStreams ? bp->streams + bp->numStreams - 1 : NULL;
+		DWORD take;
+		switch (bp->state) {
+			case BP_HEADER:
+				take = BP_HEADER_SIZE - bp->have;
+				if (take > n)
+					take = n;
+				memcpy(bp->hdr + bp->have, p, take);
+				bp->have += take;
+				if (bp->have == BP_HEADER_SIZE) {
+					if ((s = bp_begin_stream(bp)) == NULL) {
+						bp->bNoMemory = TRUE;
+						return FALSE;
+					}
+					bp->have = 0;
+					bp->remaining = s->size;
+					bp->state = bp->nameBytes ? BP_NAME : BP_DATA;
+					if (bp->state == BP_DATA && s->size == 0) {
+						bp->state = BP_HEADER;
+						if (fn && !fn(ctx, bp, p, 0))
+							return FALSE;
+					}
+				}
+				break;
+			case BP_NAME:
+				take = bp->nameBytes - bp->have;
+				if (take > n)
+					take = n;
+				memcpy((BYTE *)s->name + bp->have, p, take);
+				bp->have += take;
+				if (bp->have == bp->nameBytes) {
+					bp->have = 0;
+					bp->state = BP_DATA;
+					if (s->size == 0) {
+						bp->state = BP_HEADER;
+						if (fn && !fn(ctx, bp, p, 0))
+							return FALSE;
+					}
+				}
+				break;
+			default:
+				take = bp->remaining < n ? (DWORD)bp->remaining : n;
+				bp->remaining -= take;
+				if (bp->remaining == 0)
+					bp->state = BP_HEADER;
+				if (fn && !fn(ctx, bp, p, take))
+					return FALSE;
+				break;
+		}
+		p += take;
+		n -= take;
+	}
+	return TRUE;
+}
+
+static PyObject *bp_stream_tuple(BackupStreamInfo *s)
+{
+	return Py_BuildValue("kkKN", s->id, s->attributes, s->size, PyWinObject_FromWCHAR(s->name, s->nameLen));
+}
+
+typedef struct {
+	PyObject *obCallback;
+	PyObject *obStream;	// the tuple for the current stream
+	ULONG streamIndex;
+} BackupPumpCallback;
+
+static BOOL bp_call(void *ctx, BackupPump *bp, const BYTE *data, DWORD len)
+{
+	BackupPumpCallback *c = (BackupPumpCallback *)ctx;
+	BackupStreamInfo *s = bp->streams + bp->numStreams - 1;
+	if (c->obStream == NULL || c->streamIndex != bp->numStreams) {
+		Py_XDECREF(c->obStream);
+		if ((c->obStream = bp_stream_tuple(s)) == NULL)
+			return FALSE;
+		c->streamIndex = bp->numStreams;
+	}
+	// The piece ends the data of the current stream if it is in the header state again.
+	ULONGLONG offset = s->size - bp->remaining - len;
+	PyObject *view = PyMemoryView_FromMemory((char *)data, len, PyBUF_READ);
+	if (view == NULL)
+		return FALSE;
+	PyObject *ret = PyObject_CallFunction(c->obCallback, "OKO", c->obStream, offset, view);
+	PyObject *released = PyObject_CallMethod(view, "release", NULL);
+	Py_XDECREF(released);
+	if (released == NULL && ret != NULL) {
+		// The callback kept an export of the view.
+		Py_DECREF(ret);
+		ret = NULL;
+	}
+	Py_DECREF(view);
+	Py_XDECREF(ret);
+	return ret != NULL;
+}
+
+static PyObject *py_BackupPump(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	CHECK_PFN(BackupRead);
+	PyObject *obSource, *obSink;
+	DWORD bufSize = 1024 * 1024, numBufs = 4;
+	BOOL bProcessSecurity = TRUE, bRestore = FALSE;
+	static char *keywords[] = {"Source", "Sink", "BufferSize", "NumBuffers", "ProcessSecurity", "Restore", NULL};
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|kkii:BackupPump", keywords,
+		&obSource,	// @pyparm <o PyHANDLE>|Source||The file to back up, opened with FILE_FLAG_BACKUP_SEMANTICS for a directory.
+		&obSink,	// @pyparm <o PyHANDLE>/callable|Sink||The handle to write to, or a callable passed each piece of each stream.
+		&bufSize,	// @pyparm int|BufferSize|1048576|The size of each buffer in the ring.
+		&numBufs,	// @pyparm int|NumBuffers|4|The number of buffers in the ring.
+		&bProcessSecurity,	// @pyparm boolean|ProcessSecurity|True|Whether to include the security descriptor.  Reading the SACL needs SE_SECURITY_NAME.
+		&bRestore))	// @pyparm boolean|Restore|False|If True, the data is restored to Sink with BackupWrite instead of written with WriteFile.
+		return NULL;
+	if (bufSize < 4096)
+		return PyErr_Format(PyExc_ValueError, "BufferSize must be at least 4096");
+	if (numBufs < 2 || numBufs > BP_MAX_BUFFERS)
+		return PyErr_Format(PyExc_ValueError, "NumBuffers must be between 2 and %d", BP_MAX_BUFFERS);
+	BackupPump bp;
+	memset(&bp, 0, sizeof(bp));
+	HANDLE hSink = NULL;
+	BackupPumpCallback cb = {NULL, NULL, 0};
+	if (!PyWinObject_AsHANDLE(obSource, &bp.hSource))
+		return NULL;
+	if (PyCallable_Check(obSink))
+		cb.obCallback = obSink;
+	else if (!PyWinObject_AsHANDLE(obSink, &hSink))
+		return NULL;
+	if (bRestore) {
+		if (cb.obCallback)
+			return PyErr_Format(PyExc_ValueError, "Restore needs a handle for the sink");
+		CHECK_PFN(BackupWrite);
+	}
+	bp.bProcessSecurity = bProcessSecurity;
+	bp.bufSize = bufSize;
+	bp.numBufs = numBufs;
+	bp.ring = (BYTE *)VirtualAlloc(NULL, (SIZE_T)bufSize * numBufs, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+	if (bp.ring == NULL)
+		return PyWin_SetAPIError("VirtualAlloc");
+	PyObject *ret = NULL;
+	HANDLE hThread = NULL;
+	DWORD sinkErr = 0;
+	const char *sinkFn = NULL;
+	bp.hFilled = CreateSemaphore(NULL, 0, numBufs, NULL);
+	bp.hFree = CreateSemaphore(NULL, numBufs, numBufs, NULL);
+	if (bp.hFilled == NULL || bp.hFree == NULL) {
+		PyWin_SetAPIError("CreateSemaphore");
+		goto done;
+	}
+	hThread = CreateThread(NULL, 0, bp_reader, &bp, 0, NULL);
+	if (hThread == NULL) {
+		PyWin_SetAPIError("CreateThread");
+		goto done;
+	}
+	if (cb.obCallback) {
+		for (DWORD slot = 0;;slot = (slot + 1) % numBufs) {
+			Py_BEGIN_ALLOW_THREADS
+			WaitForSingleObject(bp.hFilled, INFINITE);
+			Py_END_ALLOW_THREADS
+			DWORD n = bp.lens[slot];
+			BOOL ok = bp_parse(&bp, bp.ring + (SIZE_T)slot * bufSize, n, bp_call, &cb);
+			ReleaseSemaphore(bp.hFree, 1, NULL);
+			if (!ok) {
+				if (bp.bNoMemory)
+					PyErr_NoMemory();
+				sinkFn = "";
+				break;
+			}
+			if (n == 0)
+				break;
+		}
+	} else {
+		LPVOID wctxt = NULL;
+		Py_BEGIN_ALLOW_THREADS
+		for (DWORD slot = 0;;slot = (slot + 1) % numBufs) {
+			WaitForSingleObject(bp.hFilled, INFINITE);
+			DWORD n = bp.lens[slot], written;
+			BYTE *p = bp.ring + (SIZE_T)slot * bufSize;
+			BOOL ok = bp_parse(&bp, p, n, NULL, NULL);
+			if (ok && n) {
+				if (bRestore)
+					ok = (*pfnBackupWrite)(hSink, p, n, &written, FALSE, bProcessSecurity, &wctxt);
+				else
+					ok = WriteFile(hSink, p, n, &written, NULL);
+				if (!ok) {
+					sinkErr = GetLastError();
+					sinkFn = bRestore ? "BackupWrite" : "WriteFile";
+				} else if (written != n) {
+					sinkErr = ERROR_HANDLE_DISK_FULL;
+					sinkFn = bRestore ? "BackupWrite" : "WriteFile";
+					ok = FALSE;
+				}
+			} else if (!ok)
+				sinkFn = "";
+			ReleaseSemaphore(bp.hFree, 1, NULL);
+			if (!ok || n == 0)
+				break;
+		}
+		if (bRestore) {
+			DWORD written;
+			(*pfnBackupWrite)(hSink, NULL, 0, &written, TRUE, bProcessSecurity, &wctxt);
+		}
+		Py_END_ALLOW_THREADS
+		if (bp.bNoMemory)
+			PyErr_NoMemory();
+	}
+	// Wake the reader if it is waiting for a free buffer.
+	InterlockedExchange(&bp.bStop, 1);
+	ReleaseSemaphore(bp.hFree, 1, NULL);
+	Py_BEGIN_ALLOW_THREADS
+	WaitForSingleObject(hThread, INFINITE);
+	Py_END_ALLOW_THREADS
+	if (sinkFn) {
+		if (sinkErr)
+			PyWin_SetAPIError(sinkFn, sinkErr);
+		goto done;
+	}
+	if (bp.err) {
+		PyWin_SetAPIError("BackupRead", bp.err);
+		goto done;
+	}
+	if (bp.state != BP_HEADER || bp.have) {
+		PyErr_Format(PyExc_ValueError, "BackupRead ended in the middle of a stream");
+		goto done;
+	}
+	{
+	PyObject *obStreams = PyList_New(bp.numStreams);
+	for (ULONG i=0;obStreams && i<bp.numStreams;i++) {
+		PyObject *item = bp_stream_tuple(bp.streams + i);
+		if (item == NULL)
+			Py_CLEAR(obStreams);
+		else
+			PyList_SET_ITEM(obStreams, i, item);
+	}
+	if (obStreams)
+		ret = Py_BuildValue("KN", bp.bytesRead, obStreams);
+	}
+done:
+	if (hThread)
+		CloseHandle(hThread);
+	if (bp.hFilled)
+		CloseHandle(bp.hFilled);
+	if (bp.hFree)
+		CloseHandle(bp.hFree);
+	VirtualFree(bp.ring, 0, MEM_RELEASE);
+	for (ULONG i=0;i<bp.numStreams;i++)
+		free(bp.streams[i].name);
+	free(bp.streams);
+	Py_XDECREF(cb.obStream);
+	return ret;
+}
+PyCFunction pfnpy_BackupPump=(PyCFunction)py_BackupPump;
+
 // @pyswig |SetFileShortName|Set the 8.3 name of a file
 // @comm This function is only available on WinXP and later
 // @comm File handle must be opened with FILE_FLAG_BACKUP_SEMANTICS, and SE_RESTORE_NAME privilege must be enabled
@@ -4143,41 +7892,456 @@ py_CopyFileEx(PyObject *self, PyObject *args, PyObject *kwargs)
 }
 PyCFunction pfnpy_CopyFileEx=(PyCFunction)py_CopyFileEx;
 
-// @pyswig |MoveFileWithProgress|Moves a file, and reports progress to a callback function
-// @comm Only available on Windows 2000 or later
-// @comm Accepts keyword arguments.
-// @comm On Vista and later, the Transaction arg can be passed to invoke MoveFileTransacted
-static PyObject*
-py_MoveFileWithProgress(PyObject *self, PyObject *args, PyObject *kwargs)
-{
-	PyObject *obsrc, *obdst, *obcallback=Py_None, *obdata=Py_None, *ret=NULL;
-	PyObject *obtrans=Py_None;
-	WCHAR *src=NULL, *dst=NULL;
-	BOOL bsuccess;
-	LPPROGRESS_ROUTINE callback=NULL;
-	LPVOID callback_data=NULL;
-	PyObject *callback_objects[2];
-	DWORD flags=0;
-	HANDLE htrans;
-	static char *keywords[]={"ExistingFileName","NewFileName","ProgressRoutine","Data","Flags","Transaction", NULL};
+// @object PyCopyJob|A set of files being copied by a pool of native threads, as
+// returned by <om win32file.CreateCopyJob>.
+// @comm Each file is copied with CopyFile2, or CopyFileExW before Windows 8, by
+// whichever thread takes it next.  Progress callbacks are handled natively and only
+// update the job's counters, so Python can sample them whenever it likes with
+// <om PyCopyJob.GetProgress> or the job's attributes.
+// <nl>Files with sources at least UnbufferedThreshold bytes long are copied with
+// COPY_FILE_NO_BUFFERING, which avoids flushing the file cache with data
+// which is unlikely to be read again.
+// <nl>The threads keep running if the job object is released - <om PyCopyJob.Cancel>
+// stops them, and the object waits for them when destroyed.
+typedef HRESULT (WINAPI *CopyFile2func)(PCWSTR, PCWSTR, COPYFILE2_EXTENDED_PARAMETERS *);
+static CopyFile2func pfnCopyFile2=NULL;
+
+#define CJ_MAX_THREADS 64
+
+#define CJ_PENDING 0
+#define CJ_COPIED 1
+#define CJ_FAILED 2
+#define CJ_SKIPPED 3		// cancelled before it was started
 
-	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|OOkO:MoveFileWithProgress", keywords,
-		&obsrc,		// @pyparm <o PyUNICODE>|ExistingFileName||File or directory to be moved
-		&obdst,		// @pyparm <o PyUNICODE>|NewFileName||Destination, can be None if flags contain MOVEFILE_DELAY_UNTIL_REBOOT
-		&obcallback,	// @pyparm <o CopyProgressRoutine>|ProgressRoutine|None|A python function that receives progress updates, can be None
-		&obdata,	// @pyparm object|Data|None|An arbitrary object to be passed to the callback function
-		&flags,		// @pyparm int|Flags|0|Combination of MOVEFILE_* flags
-		&obtrans))	// @pyparm <o PyHANDLE>|Transaction|None|Handle to a transaction (optional).  See <om win32transaction.CreateTransaction>.
-		return NULL;
+typedef struct {
+	WCHAR *src;
+	WCHAR *dst;
+	DWORD state;
+	DWORD error;
+} CopyJobFile;
 
-	if (!PyWinObject_AsHANDLE(obtrans, &htrans))
-		return NULL;
-	if (htrans){
-		CHECK_PFN(MoveFileTransacted);
-		}
-	else{
-		CHECK_PFN(MoveFileWithProgress);
-		}
+typedef struct {
+	PyObject_HEAD
+	CopyJobFile *files;
+	LONG numFiles;
+	DWORD flags;
+	ULONGLONG unbufferedThreshold;
+	BOOL bCreateDirectories;
+	ULONG numThreads;
+	HANDLE hThreads[CJ_MAX_THREADS];
+	HANDLE hDone;		// set when the last thread finishes
+	volatile LONG next;	// the index of the next file to copy
+	volatile LONG bCancel;
+	volatile LONG runningThreads;
+	volatile LONG filesCopied;	// statistics
+	volatile LONG filesFailed;
+	volatile LONG filesSkipped;
+	volatile LONGLONG bytesCopied;
+	volatile LONGLONG bytesTotal;	// of the files which have been started
+	volatile LONG unbuffered;
+} PyCopyJob;
+
+extern PyTypeObject PyCopyJob_Type;
+
+// Progress for the file being copied by one thread.
+typedef struct {
+	PyCopyJob *job;
+	LONGLONG transferred;
+	LONGLONG size;
+	BOOL bSized;
+} CopyJobProgress;
+
+static void cj_progress(CopyJobProgress *p, LONGLONG size, LONGLONG transferred)
+{
+	if (!p->bSized) {
+		p->bSized = TRUE;
+		p->size = size;
+		InterlockedExchangeAdd64(&p->job->bytesTotal, size);
+	}
+	if (transferred > p->transferred) {
+		InterlockedExchangeAdd64(&p->job->bytesCopied, transferred - p->transferred);
+		p->transferred = transferred;
+	}
+}
+
+static COPYFILE2_MESSAGE_ACTION CALLBACK cj_progress2(const COPYFILE2_MESSAGE *msg, PVOID context)
+{
+	CopyJobProgress *p = (CopyJobProgress *)context;
+	if (msg->Type == COPYFILE2_CALLBACK_CHUNK_FINISHED)
+		cj_progress(p, msg->Info.ChunkFinished.uliTotalFileSize.QuadPart,
+			msg->Info.ChunkFinished.uliTotalBytesTransferred.QuadPart);
+	else if (msg->Type == COPYFILE2_CALLBACK_STREAM_STARTED)
+		cj_progress(p, msg->Info.StreamStarted.uliTotalFileSize.QuadPart, p->transferred);
+	return p->job->bCancel ? COPYFILE2_PROGRESS_CANCEL : COPYFILE2_PROGRESS_CONTINUE;
+}
+
+static DWORD CALLBACK cj_progress_ex(LARGE_INTEGER totalSize, LARGE_INTEGER totalTransferred,
+	LARGE_INTEGER streamSize, LARGE_INTEGER streamTransferred, DWORD streamNumber,
+	DWORD reason, HANDLE hSource, HANDLE hDest, LPVOID context)
+{
+	CopyJobProgress *p = (CopyJobProgress *)context;
+	cj_progress(p, totalSize.QuadPart, totalTransferred.QuadPart);
+	return p->job->bCancel ? PROGRESS_CANCEL : PROGRESS_CONTINUE;
+}
+
+// Creates the missing parent directories of path.
+static BOOL cj_make_parents(const WCHAR *path)
+{
+	size_t len = wcslen(path);
+	WCHAR *dir = (WCHAR *)malloc((len + 1) * sizeof(WCHAR));
+	if (dir == NULL)
+		return FALSE;
+	wcscpy(dir, path);
+	// Walk back to the deepest directory which exists, then create each one below it.
+	WCHAR *sep = wcsrchr(dir, L'\\');
+	WCHAR *fwd = wcsrchr(dir, L'/');
+	if (fwd > sep)
+		sep = fwd;
+	BOOL ok = FALSE;
+	if (sep && sep != dir) {
+		*sep = 0;
+		ok = CreateDirectoryW(dir, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+		if (!ok && GetLastError() == ERROR_PATH_NOT_FOUND && cj_make_parents(dir))
+			ok = CreateDirectoryW(dir, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+	}
+	free(dir);
+	return ok;
+}
+
+static DWORD cj_copy_one(PyCopyJob *job, CopyJobFile *f)
+{
+	DWORD flags = job->flags;
+	if (job->unbufferedThreshold) {
+		WIN32_FILE_ATTRIBUTE_DATA fad;
+		if (GetFileAttributesExW(f->src, GetFileExInfoStandard, &fad)
+			&& (((ULONGLONG)fad.nFileSizeHigh << 32) | fad.nFileSizeLow) >= job->unbufferedThreshold) {
+			flags |= COPY_FILE_NO_BUFFERING;
+			InterlockedIncrement(&job->unbuffered);
+		}
+	}
+	DWORD err = 0;
+	for (int attempt=0;attempt<2;attempt++) {
+		CopyJobProgress p = {job, 0, 0, FALSE};
+		if (pfnCopyFile2) {
+			COPYFILE2_EXTENDED_PARAMETERS params = {sizeof(params)};
+			params.dwCopyFlags = flags;
+			params.pfCancel = (BOOL *)&job->bCancel;
+			params.pProgressRoutine = cj_progress2;
+			params.pvCallbackContext = &p;
+			HRESULT hr = (*pfnCopyFile2)(f->src, f->dst, &params);
+			err = SUCCEEDED(hr) ? 0 : (HRESULT_FACILITY(hr) == FACILITY_WIN32 ? HRESULT_CODE(hr) : (DWORD)hr);
+		} else if (!(*pfnCopyFileEx)(f->src, f->dst, cj_progress_ex, &p, (BOOL *)&job->bCancel, flags))
+			err = GetLastError();
+		else
+			err = 0;
+		// A failed copy's bytes no longer count as copied or to copy.
+		if (err) {
+			InterlockedExchangeAdd64(&job->bytesCopied, -p.transferred);
+			InterlockedExchangeAdd64(&job->bytesTotal, -p.size);
+		}
+		if (err != ERROR_PATH_NOT_FOUND || !job->bCreateDirectories || attempt || !cj_make_parents(f->dst))
+			break;
+	}
+	return err;
+}
+
+static DWORD WINAPI cj_thread(LPVOID param)
+{
+	PyCopyJob *job = (PyCopyJob *)param;
+	for (;;) {
+		LONG i = InterlockedIncrement(&job->next) - 1;
+		if (i >= job->numFiles)
+			break;
+		CopyJobFile *f = job->files + i;
+		if (job->bCancel) {
+			f->state = CJ_SKIPPED;
+			InterlockedIncrement(&job->filesSkipped);
+			continue;
+		}
+		f->error = cj_copy_one(job, f);
+		if (f->error == 0) {
+			f->state = CJ_COPIED;
+			InterlockedIncrement(&job->filesCopied);
+		} else if (f->error == ERROR_REQUEST_ABORTED && job->bCancel) {
+			f->state = CJ_SKIPPED;
+			InterlockedIncrement(&job->filesSkipped);
+		} else {
+			f->state = CJ_FAILED;
+			InterlockedIncrement(&job->filesFailed);
+		}
+	}
+	if (InterlockedDecrement(&job->runningThreads) == 0)
+		SetEvent(job->hDone);
+	return 0;
+}
+
+static void cj_dealloc(PyObject *ob)
+{
+	PyCopyJob *job = (PyCopyJob *)ob;
+	InterlockedExchange(&job->bCancel, 1);
+	if (job->numThreads) {
+		Py_BEGIN_ALLOW_THREADS
+		WaitForMultipleObjects(job->numThreads, job->hThreads, TRUE, INFINITE);
+		Py_END_ALLOW_THREADS
+	}
+	for (ULONG i=0;i<job->numThreads;i++)
+		CloseHandle(job->hThreads[i]);
+	if (job->hDone)
+		CloseHandle(job->hDone);
+	if (job->files) {
+		for (LONG i=0;i<job->numFiles;i++) {
+			PyWinObject_FreeWCHAR(job->files[i].src);
+			PyWinObject_FreeWCHAR(job->files[i].dst);
+		}
+		free(job->files);
+	}
+	PyObject_Del(ob);
+}
+
+// @pymethod boolean|PyCopyJob|Wait|Waits for all the files to be copied.
+// @rdesc True if the job has finished, or False if the timeout expired.
+static PyObject *cj_Wait(PyObject *self, PyObject *args)
+{
+	PyCopyJob *job = (PyCopyJob *)self;
+	DWORD timeout = INFINITE;
+	if (!PyArg_ParseTuple(args, "|k:Wait",
+		&timeout)) // @pyparm int|timeout|win32event.INFINITE|The time in milliseconds to wait.
+		return NULL;
+	DWORD rc;
+	Py_BEGIN_ALLOW_THREADS
+	rc = WaitForSingleObject(job->hDone, timeout);
+	Py_END_ALLOW_THREADS
+	if (rc == WAIT_FAILED)
+		return PyWin_SetAPIError("WaitForSingleObject");
+	return PyBool_FromLong(rc == WAIT_OBJECT_0);
+}
+
+// @pymethod |PyCopyJob|Cancel|Cancels the copies in progress, and skips the files not yet started.
+// @comm Returns at once - use <om PyCopyJob.Wait> to wait for the threads to stop.
+// A partly copied destination is deleted by the system.
+static PyObject *cj_Cancel(PyObject *self, PyObject *args)
+{
+	if (!PyArg_ParseTuple(args, ":Cancel"))
+		return NULL;
+	InterlockedExchange(&((PyCopyJob *)self)->bCancel, 1);
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+// @pymethod (int, int, int, int, int, int)|PyCopyJob|GetProgress|Returns a consistent snapshot of the job's progress.
+// @rdesc (filesCopied, filesFailed, filesSkipped, filesTotal, bytesCopied, bytesTotal).
+// bytesTotal only includes the files which have been started.
+static PyObject *cj_GetProgress(PyObject *self, PyObject *args)
+{
+	PyCopyJob *job = (PyCopyJob *)self;
+	if (!PyArg_ParseTuple(args, ":GetProgress"))
+		return NULL;
+	LONGLONG bytesTotal = InterlockedCompareExchange64(&job->bytesTotal, 0, 0);
+	LONGLONG bytesCopied = InterlockedCompareExchange64(&job->bytesCopied, 0, 0);
+	// A chunk may have finished between the two reads.
+	if (bytesCopied > bytesTotal)
+		bytesCopied = bytesTotal;
+	return Py_BuildValue("lllkLL", job->filesCopied, job->filesFailed, job->filesSkipped,
+		(unsigned long)job->numFiles, bytesCopied, bytesTotal);
+}
+
+// @pymethod [(int, int), ...]|PyCopyJob|GetErrors|Returns the files which failed to copy so far.
+// @rdesc A list of (index, winerror) tuples, where index is the position of the
+// file in the sequence passed to <om win32file.CreateCopyJob>.
+static PyObject *cj_GetErrors(PyObject *self, PyObject *args)
+{
+	PyCopyJob *job = (PyCopyJob *)self;
+	if (!PyArg_ParseTuple(args, ":GetErrors"))
+		return NULL;
+	PyObject *ret = PyList_New(0);
+	for (LONG i=0;ret && i<job->numFiles;i++) {
+		if (job->files[i].state != CJ_FAILED)
+			continue;
+		PyObject *item = Py_BuildValue("lk", i, job->files[i].error);
+		if (item == NULL || PyList_Append(ret, item) == -1)
+			Py_CLEAR(ret);
+		Py_XDECREF(item);
+	}
+	return ret;
+}
+
+static PyMethodDef cj_methods[] = {
+	{"Wait", cj_Wait, METH_VARARGS}, // @pymeth Wait|Waits for the job to finish.
+	{"Cancel", cj_Cancel, METH_VARARGS}, // @pymeth Cancel|Cancels the job.
+	{"GetProgress", cj_GetProgress, METH_VARARGS}, // @pymeth GetProgress|Returns a snapshot of the job's progress.
+	{"GetErrors", cj_GetErrors, METH_VARARGS}, // @pymeth GetErrors|Returns the files which failed to copy.
+	{NULL}
+};
+
+#undef OFF
+#define OFF(e) offsetof(PyCopyJob, e)
+static PyMemberDef cj_members[] = {
+	{"filesTotal", T_LONG, OFF(numFiles), READONLY}, // @prop int|filesTotal|The number of files in the job.
+	{"filesCopied", T_LONG, OFF(filesCopied), READONLY}, // @prop int|filesCopied|The number of files copied so far.
+	{"filesFailed", T_LONG, OFF(filesFailed), READONLY}, // @prop int|filesFailed|The number of files which could not be copied.
+	{"filesSkipped", T_LONG, OFF(filesSkipped), READONLY}, // @prop int|filesSkipped|The number of files not copied because the job was cancelled.
+	{"bytesCopied", T_LONGLONG, OFF(bytesCopied), READONLY}, // @prop int|bytesCopied|The number of bytes copied so far.
+	{"bytesTotal", T_LONGLONG, OFF(bytesTotal), READONLY}, // @prop int|bytesTotal|The total size of the files which have been started.
+	{"unbuffered", T_LONG, OFF(unbuffered), READONLY}, // @prop int|unbuffered|The number of files copied with COPY_FILE_NO_BUFFERING.
+	{NULL}
+};
+#undef OFF
+
+PyTypeObject PyCopyJob_Type = {
+	PYWIN_OBJECT_HEAD
+	"PyCopyJob",				/* tp_name */
+	sizeof(PyCopyJob),			/* tp_basicsize */
+	0,					/* tp_itemsize */
+	cj_dealloc,				/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	0,					/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	0,					/* tp_iter */
+	0,					/* tp_iternext */
+	cj_methods,				/* tp_methods */
+	cj_members,				/* tp_members */
+	0,					/* tp_getset */
+};
+
+// @pyswig <o PyCopyJob>|CreateCopyJob|Starts copying a list of files with a pool of native threads.
+// @comm Accepts keyword args.
+// @comm Files are started in the order given, so it is best to list large
+// files first.
+static PyObject *py_CreateCopyJob(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	PyObject *obFiles;
+	int numThreads = 4;
+	DWORD flags = 0;
+	ULONGLONG unbufferedThreshold = 256 * 1024 * 1024;
+	BOOL bCreateDirectories = TRUE;
+	static char *keywords[]={"Files","NumThreads","CopyFlags","UnbufferedThreshold","CreateDirectories", NULL};
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|ikKi:CreateCopyJob", keywords,
+		&obFiles,	// @pyparm [(<o PyUnicode>, <o PyUnicode>), ...]|Files||A sequence of (source, destination) pairs.
+		&numThreads,	// @pyparm int|NumThreads|4|The number of files copied at once.
+		&flags,		// @pyparm int|CopyFlags|0|COPY_FILE_* flags used for every file, as for <om win32file.CopyFileEx>.
+		&unbufferedThreshold,	// @pyparm int|UnbufferedThreshold|268435456|Files at least this large are copied with COPY_FILE_NO_BUFFERING.  0 disables this.
+		&bCreateDirectories))	// @pyparm boolean|CreateDirectories|True|Whether to create missing destination directories.
+		return NULL;
+	if (pfnCopyFile2 == NULL)
+		CHECK_PFN(CopyFileEx);
+	if (numThreads < 1 || numThreads > CJ_MAX_THREADS)
+		return PyErr_Format(PyExc_ValueError, "NumThreads must be between 1 and %d", CJ_MAX_THREADS);
+	PyObject *seq = PySequence_Fast(obFiles, "Files must be a sequence of (source, destination) pairs");
+	if (seq == NULL)
+		return NULL;
+	Py_ssize_t numFiles = PySequence_Fast_GET_SIZE(seq);
+	if (numFiles > LONG_MAX - CJ_MAX_THREADS) {
+		Py_DECREF(seq);
+		return PyErr_Format(PyExc_ValueError, "Too many files");
+	}
+	PyCopyJob *job = PyObject_New(PyCopyJob, &PyCopyJob_Type);
+	if (job == NULL) {
+		Py_DECREF(seq);
+		return NULL;
+	}
+	memset(((BYTE *)job) + sizeof(PyObject), 0, sizeof(PyCopyJob) - sizeof(PyObject));
+	job->files = (CopyJobFile *)calloc(numFiles ? numFiles : 1, sizeof(CopyJobFile));
+	if (job->files == NULL) {
+		Py_DECREF(seq);
+		Py_DECREF(job);
+		return PyErr_NoMemory();
+	}
+	for (Py_ssize_t i=0;i<numFiles;i++) {
+		PyObject *obSrc, *obDst;
+		CopyJobFile *f = job->files + job->numFiles;
+		if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(seq, i), "OO", &obSrc, &obDst)
+			|| !PyWinObject_AsWCHAR(obSrc, &f->src, FALSE)) {
+			Py_DECREF(seq);
+			Py_DECREF(job);
+			return NULL;
+		}
+		job->numFiles++;
+		if (!PyWinObject_AsWCHAR(obDst, &f->dst, FALSE)) {
+			Py_DECREF(seq);
+			Py_DECREF(job);
+			return NULL;
+		}
+	}
+	Py_DECREF(seq);
+	job->flags = flags;
+	job->unbufferedThreshold = unbufferedThreshold;
+	job->bCreateDirectories = bCreateDirectories;
+	job->hDone = CreateEvent(NULL, TRUE, FALSE, NULL);
+	if (job->hDone == NULL) {
+		PyWin_SetAPIError("CreateEvent");
+		Py_DECREF(job);
+		return NULL;
+	}
+	// No point in more threads than files.
+	if (numThreads > job->numFiles)
+		numThreads = job->numFiles ? job->numFiles : 1;
+	job->runningThreads = numThreads;
+	for (job->numThreads=0; job->numThreads<(ULONG)numThreads; job->numThreads++) {
+		job->hThreads[job->numThreads] = CreateThread(NULL, 0, cj_thread, job, 0, NULL);
+		if (job->hThreads[job->numThreads] == NULL) {
+			PyWin_SetAPIError("CreateThread");
+			// Stop the threads which were started.
+			InterlockedExchange(&job->bCancel, 1);
+			Py_DECREF(job);
+			return NULL;
+		}
+	}
+	return (PyObject *)job;
+}
+PyCFunction pfnpy_CreateCopyJob=(PyCFunction)py_CreateCopyJob;
+
+// @pyswig |MoveFileWithProgress|Moves a file, and reports progress to a callback function
+// @comm Only available on Windows 2000 or later
+// @comm Accepts keyword arguments.
+// @comm On Vista and later, the Transaction arg can be passed to invoke MoveFileTransacted
+static PyObject*
+py_MoveFileWithProgress(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	PyObject *obsrc, *obdst, *obcallback=Py_None, *obdata=Py_None, *ret=NULL;
+	PyObject *obtrans=Py_None;
+	WCHAR *src=NULL, *dst=NULL;
+	BOOL bsuccess;
+	LPPROGRESS_ROUTINE callback=NULL;
+	LPVOID callback_data=NULL;
+	PyObject *callback_objects[2];
+	DWORD flags=0;
+	HANDLE htrans;
+	static char *keywords[]={"ExistingFileName","NewFileName","ProgressRoutine","Data","Flags","Transaction", NULL};
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|OOkO:MoveFileWithProgress", keywords,
+		&obsrc,		// @pyparm <o PyUNICODE>|ExistingFileName||File or directory to be moved
+		&obdst,		// @pyparm <o PyUNICODE>|NewFileName||Destination, can be None if flags contain MOVEFILE_DELAY_UNTIL_REBOOT
+		&obcallback,	// @pyparm <o CopyProgressRoutine>|ProgressRoutine|None|A python function that receives progress updates, can be None
+		&obdata,	// @pyparm object|Data|None|An arbitrary object to be passed to the callback function
+		&flags,		// @pyparm int|Flags|0|Combination of MOVEFILE_* flags
+		&obtrans))	// @pyparm <o PyHANDLE>|Transaction|None|Handle to a transaction (optional).  See <om win32transaction.CreateTransaction>.
+		return NULL;
+
+	if (!PyWinObject_AsHANDLE(obtrans, &htrans))
+		return NULL;
+	if (htrans){
+		CHECK_PFN(MoveFileTransacted);
+		}
+	else{
+		CHECK_PFN(MoveFileWithProgress);
+		}
 
 	if (obcallback!=Py_None){
 		if (!PyCallable_Check(obcallback)){
@@ -4907,6 +9071,282 @@ static PyObject *py_RemoveDirectory(PyObject *self, PyObject *args, PyObject *kw
 }
 PyCFunction pfnpy_RemoveDirectory=(PyCFunction)py_RemoveDirectory;
 
+// @pyswig (boolean, [int, ...], <o PyHANDLE>)|ApplyTransactedOperations|Applies a list of file operations under one KTM transaction.
+// @comm Accepts keyword args.
+// @comm Each operation is an (op, src, dst, data) tuple, with op one of -
+// <nl>"write": creates or replaces the file src with the bytes-like data.
+// <nl>"delete": deletes the file src.
+// <nl>"move": moves src to dst, replacing dst if it exists.  data is None, or MOVEFILE_* flags to use instead.
+// <nl>"copy": copies src to dst.  data is None, or COPY_FILE_* flags.
+// <nl>"mkdir": creates the directory src.
+// <nl>"rmdir": removes the empty directory src.
+// <nl>"setattr": sets the attributes of src to the FILE_ATTRIBUTE_* flags in data.
+// <nl>Unused items may be None, and the tuple may be shorter than 4 items.  All
+// the operations are converted before any are applied, and are then applied in
+// order without the GIL.
+// @comm If any operation fails and StopOnError is True, the rest are not
+// attempted and the transaction is rolled back, so none of the changes are made.
+// @rdesc (committed, results, transaction).  results has the error code of each
+// operation - 0 if it succeeded, or None if it was not attempted.  committed is True
+// if the transaction was committed, or with Async, if committing it was started -
+// the transaction handle is signalled once it completes.  If a transaction was
+// created, the caller owns the returned handle.
+typedef HANDLE (WINAPI *CreateTransactionfunc)(LPSECURITY_ATTRIBUTES, LPGUID, DWORD, DWORD, DWORD, DWORD, LPWSTR);
+static CreateTransactionfunc pfnCreateTransaction = NULL;
+typedef BOOL (WINAPI *CommitTransactionfunc)(HANDLE);
+static CommitTransactionfunc pfnCommitTransaction = NULL;
+static CommitTransactionfunc pfnCommitTransactionAsync = NULL;
+static CommitTransactionfunc pfnRollbackTransaction = NULL;
+
+#define TXOP_WRITE 0
+#define TXOP_DELETE 1
+#define TXOP_MOVE 2
+#define TXOP_COPY 3
+#define TXOP_MKDIR 4
+#define TXOP_RMDIR 5
+#define TXOP_SETATTR 6
+
+static const char *txop_names[] = {"write", "delete", "move", "copy", "mkdir", "rmdir", "setattr", NULL};
+
+typedef struct {
+	int op;
+	WCHAR *src;
+	WCHAR *dst;
+	Py_buffer data;
+	BOOL bData;
+	DWORD flags;
+	DWORD err;
+	BOOL bDone;
+} TxFileOp;
+
+static void txop_free(TxFileOp *ops, Py_ssize_t n)
+{
+	for (Py_ssize_t i=0;i<n;i++) {
+		PyWinObject_FreeWCHAR(ops[i].src);
+		PyWinObject_FreeWCHAR(ops[i].dst);
+		if (ops[i].bData)
+			PyBuffer_Release(&ops[i].data);
+	}
+	free(ops);
+}
+
+static BOOL txop_parse(PyObject *ob, TxFileOp *t)
+{
+	PyObject *obOp, *obSrc = Py_None, *obDst = Py_None, *obData = Py_None;
+	if (!PyArg_ParseTuple(ob, "O|OOO:operation", &obOp, &obSrc, &obDst, &obData))
+		return FALSE;
+	const char *name = PyUnicode_Check(obOp) ? PyUnicode_AsUTF8(obOp) : NULL;
+	if (name == NULL) {
+		if (!PyErr_Occurred())
+			PyErr_Format(PyExc_TypeError, "The operation must be a string, not %s", obOp->ob_type->tp_name);
+		return FALSE;
+	}
+	for (t->op=0;txop_names[t->op];t->op++)
+		if (strcmp(txop_names[t->op], name) == 0)
+			break;
+	if (txop_names[t->op] == NULL) {
+		PyErr_Format(PyExc_ValueError, "Unknown operation '%s'", name);
+		return FALSE;
+	}
+	if (!PyWinObject_AsWCHAR(obSrc, &t->src, FALSE))
+		return FALSE;
+	BOOL bNeedDst = t->op == TXOP_MOVE || t->op == TXOP_COPY;
+	if (!PyWinObject_AsWCHAR(obDst, &t->dst, !bNeedDst))
+		return FALSE;
+	switch (t->op) {
+		case TXOP_WRITE:
+			if (PyObject_GetBuffer(obData, &t->data, PyBUF_SIMPLE) == -1)
+				return FALSE;
+			t->bData = TRUE;
+			break;
+		case TXOP_MOVE:
+		case TXOP_COPY:
+		case TXOP_SETATTR:
+			if (obData == Py_None) {
+				if (t->op == TXOP_SETATTR) {
+					PyErr_Format(PyExc_TypeError, "setattr needs the attributes as data");
+					return FALSE;
+				}
+				t->flags = t->op == TXOP_MOVE ? MOVEFILE_REPLACE_EXISTING : 0;
+			} else {
+				t->flags = PyLong_AsUnsignedLongMask(obData);
+				if (t->flags == (DWORD)-1 && PyErr_Occurred())
+					return FALSE;
+			}
+			break;
+	}
+	return TRUE;
+}
+
+// Called without the GIL.
+static DWORD txop_apply(TxFileOp *t, HANDLE hTrans)
+{
+	BOOL ok = FALSE;
+	switch (t->op) {
+		case TXOP_WRITE: {
+			HANDLE h = (*pfnCreateFileTransacted)(t->src, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+				FILE_ATTRIBUTE_NORMAL, NULL, hTrans, NULL, NULL);
+			if (h == INVALID_HANDLE_VALUE)
+				break;
+			BYTE *p = (BYTE *)t->data.buf;
+			Py_ssize_t left = t->data.len;
+			ok = TRUE;
+			while (ok && left > 0) {
+				DWORD chunk = left > 0x10000000 ? 0x10000000 : (DWORD)left, written;
+				ok = WriteFile(h, p, chunk, &written, NULL);
+				p += written;
+				left -= written;
+			}
+			DWORD err = GetLastError();
+			CloseHandle(h);
+			SetLastError(err);
+			break;
+		}
+		case TXOP_DELETE:
+			ok = (*pfnDeleteFileTransacted)(t->src, hTrans);
+			break;
+		case TXOP_MOVE:
+			ok = (*pfnMoveFileTransacted)(t->src, t->dst, NULL, NULL, t->flags, hTrans);
+			break;
+		case TXOP_COPY:
+			ok = (*pfnCopyFileTransacted)(t->src, t->dst, NULL, NULL, NULL, t->flags, hTrans);
+			break;
+		case TXOP_MKDIR:
+			ok = (*pfnCreateDirectoryTransacted)(NULL, t->src, NULL, hTrans);
+			break;
+		case TXOP_RMDIR:
+			ok = (*pfnRemoveDirectoryTransacted)(t->src, hTrans);
+			break;
+		case TXOP_SETATTR:
+			ok = (*pfnSetFileAttributesTransacted)(t->src, t->flags, hTrans);
+			break;
+	}
+	return ok ? 0 : GetLastError();
+}
+
+static PyObject *py_ApplyTransactedOperations(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	CHECK_PFN(CreateFileTransacted);
+	CHECK_PFN(DeleteFileTransacted);
+	CHECK_PFN(MoveFileTransacted);
+	CHECK_PFN(CopyFileTransacted);
+	CHECK_PFN(CreateDirectoryTransacted);
+	CHECK_PFN(RemoveDirectoryTransacted);
+	CHECK_PFN(SetFileAttributesTransacted);
+	PyObject *obOps, *obTrans = Py_None;
+	BOOL bCommit = TRUE, bAsync = FALSE, bStopOnError = TRUE;
+	DWORD timeout = 0;
+	static char *keywords[] = {"Operations", "Transaction", "Commit", "Async", "StopOnError", "Timeout", NULL};
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|Oiiik:ApplyTransactedOperations", keywords,
+		&obOps,		// @pyparm [(str, <o PyUnicode>, <o PyUnicode>, object), ...]|Operations||The operations to apply.
+		&obTrans,	// @pyparm <o PyHANDLE>|Transaction|None|The transaction to use.  If None, a new one is created.
+		&bCommit,	// @pyparm boolean|Commit|True|Whether to commit the transaction once all the operations succeed.  If False, the caller commits or rolls back the returned transaction.
+		&bAsync,	// @pyparm boolean|Async|False|Commit with CommitTransactionAsync, and return without waiting.
+		&bStopOnError,	// @pyparm boolean|StopOnError|True|Stop at the first failed operation and roll the transaction back.  If False, all the operations are attempted and the transaction is committed regardless.
+		&timeout))	// @pyparm int|Timeout|0|For a new transaction, the time in milliseconds after which it is aborted.  0 means no timeout.
+		return NULL;
+	HANDLE hTrans;
+	if (!PyWinObject_AsHANDLE(obTrans, &hTrans))
+		return NULL;
+	if (hTrans == NULL)
+		CHECK_PFN(CreateTransaction);
+	if (bCommit)
+		CHECK_PFN(CommitTransaction);
+	if (bAsync)
+		CHECK_PFN(CommitTransactionAsync);
+	PyObject *seq = PySequence_Fast(obOps, "Operations must be a sequence");
+	if (seq == NULL)
+		return NULL;
+	Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+	TxFileOp *ops = (TxFileOp *)calloc(n ? n : 1, sizeof(TxFileOp));
+	if (ops == NULL) {
+		Py_DECREF(seq);
+		return PyErr_NoMemory();
+	}
+	for (Py_ssize_t i=0;i<n;i++)
+		if (!txop_parse(PySequence_Fast_GET_ITEM(seq, i), ops + i)) {
+			Py_DECREF(seq);
+			txop_free(ops, i + 1);
+			return NULL;
+		}
+	Py_DECREF(seq);
+
+	BOOL bCreated = hTrans == NULL, bFailed = FALSE, bCommitted = FALSE;
+	DWORD commitErr = 0;
+	const char *commitFn = NULL;
+	Py_BEGIN_ALLOW_THREADS
+	if (bCreated) {
+		hTrans = (*pfnCreateTransaction)(NULL, NULL, 0, 0, 0, timeout, NULL);
+		if (hTrans == INVALID_HANDLE_VALUE) {
+			hTrans = NULL;
+			commitErr = GetLastError();
+			commitFn = "CreateTransaction";
+		}
+	}
+	for (Py_ssize_t i=0;hTrans && i<n && !(bFailed && bStopOnError);i++) {
+		ops[i].err = txop_apply(ops + i, hTrans);
+		ops[i].bDone = TRUE;
+		if (ops[i].err)
+			bFailed = TRUE;
+	}
+	if (hTrans && bFailed && bStopOnError) {
+		// Only roll back a caller's transaction if we were asked to finish it.
+		if ((bCreated || bCommit) && pfnRollbackTransaction)
+			(*pfnRollbackTransaction)(hTrans);
+	} else if (hTrans && bCommit) {
+		bCommitted = bAsync ? (*pfnCommitTransactionAsync)(hTrans) : (*pfnCommitTransaction)(hTrans);
+		// An async commit still in progress reports ERROR_IO_PENDING.
+		if (!bCommitted && bAsync && GetLastError() == ERROR_IO_PENDING)
+			bCommitted = TRUE;
+		if (!bCommitted) {
+			commitErr = GetLastError();
+			commitFn = bAsync ? "CommitTransactionAsync" : "CommitTransaction";
+		}
+	}
+	Py_END_ALLOW_THREADS
+
+	PyObject *ret = NULL;
+	if (commitFn) {
+		PyWin_SetAPIError(commitFn, commitErr);
+		if (bCreated && hTrans)
+			CloseHandle(hTrans);
+		txop_free(ops, n);
+		return NULL;
+	}
+	PyObject *results = PyList_New(n);
+	for (Py_ssize_t i=0;results && i<n;i++) {
+		PyObject *item;
+		if (ops[i].bDone)
+			item = PyLong_FromUnsignedLong(ops[i].err);
+		else {
+			item = Py_None;
+			Py_INCREF(item);
+		}
+		if (item == NULL)
+			Py_CLEAR(results);
+		else
+			PyList_SET_ITEM(results, i, item);
+	}
+	txop_free(ops, n);
+	if (results) {
+		PyObject *obRetTrans;
+		if (bCreated)
+			obRetTrans = PyWinObject_FromHANDLE(hTrans);
+		else {
+			obRetTrans = obTrans;
+			Py_INCREF(obRetTrans);
+		}
+		if (obRetTrans)
+			ret = Py_BuildValue("NNN", PyBool_FromLong(bCommitted), results, obRetTrans);
+		else
+			Py_DECREF(results);
+	}
+	else if (bCreated)
+		CloseHandle(hTrans);
+	return ret;
+}
+PyCFunction pfnpy_ApplyTransactedOperations=(PyCFunction)py_ApplyTransactedOperations;
+
 // @pyswig list|FindFilesW|Retrieves a list of matching filenames, using the Windows Unicode API.  An interface to the API FindFirstFileW/FindNextFileW/Find close functions.
 // @comm Accepts keyword args.
 // @comm FindFirstFileTransacted will be called if a transaction handle is passed in.
@@ -5033,37 +9473,602 @@ static PyObject *py_FindFilesIterator(PyObject *self, PyObject *args, PyObject *
 }
 PyCFunction pfnpy_FindFilesIterator=(PyCFunction)py_FindFilesIterator;
 
-// @pyswig [(long, <o PyUnicode>),...]|FindStreams|List the data streams for a file
-// @rdesc Returns a list of tuples containing each stream's size and name
-// @comm This uses the API functions FindFirstStreamW, FindNextStreamW and FindClose
-// @comm Available on Windows Server 2003 and Vista
-// @comm If the Transaction arg is not None, FindFirstStreamTransacted will be called in place of FindFirstStreamW
-static PyObject *py_FindStreams(PyObject *self, PyObject *args, PyObject *kwargs)
-{
-	CHECK_PFN(FindFirstStream);
-	CHECK_PFN(FindNextStream);
-	
-	PyObject *obfname, *obtrans=Py_None, *ret=NULL, *ret_item;
-	WCHAR *fname=NULL;
-	HANDLE hfind, htrans;
-	STREAM_INFO_LEVELS lvl =  FindStreamInfoStandard;  // only level that currently exists
-	WIN32_FIND_STREAM_DATA fsd;
-	DWORD err=0, flags=0, ret_cnt=0;   // flags are reserved, don't even accept as input
-	static char *keywords[]={"FileName","Transaction", NULL};
+// @object PyTreeWalker|An iterator over a whole directory tree, as returned by <om win32file.WalkDirectoryTree>.
+// @comm The tree is scanned by native threads using FindFirstFileExW with
+// FindExInfoBasic and FIND_FIRST_EX_LARGE_FETCH.  Each thread keeps its own stack
+// of directories to scan and, when that is empty, takes work from the bottom of
+// the other threads' stacks - so large subtrees are shared out without any
+// central queue.
+// <nl>Entries which pass the filters are packed into native chunks, and Python
+// objects are only created as the iterator is advanced.  The threads stop once a
+// fixed number of chunks are waiting, so a slow consumer bounds the memory used.
+// <nl>Directories which can't be opened are skipped, and counted in the errors
+// attribute.  The order of the entries is not defined.
+#define TW_MAX_THREADS 64
+#define TW_CHUNK_RECORDS 512
+#define TW_CHUNK_CHARS 32768
+#define TW_MAX_QUEUED 64
 
-	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O:FindStreams", keywords,
-		&obfname,	// @pyparm <o PyUnicode>|FileName||Name of file (or directory) to operate on
-		&obtrans))	// @pyparm <o PyHANDLE>|Transaction|None|Handle to a transaction, can be None
-		return NULL;
-	if (!PyWinObject_AsHANDLE(obtrans, &htrans))
-		return NULL;
-	if (htrans!=NULL)
-		CHECK_PFN(FindFirstStreamTransacted);
-	if (!PyWinObject_AsWCHAR(obfname, &fname, FALSE))
-		return NULL;
+typedef struct {
+	ULONG nameOffset;
+	ULONG nameLen;
+	DWORD attrs;
+	ULONGLONG size;
+	ULONGLONG mtime;
+} TreeWalkRecord;
+
+typedef struct TreeWalkChunk {
+	struct TreeWalkChunk *next;
+	ULONG count;
+	ULONG used;		// characters used in names
+	TreeWalkRecord recs[TW_CHUNK_RECORDS];
+	WCHAR names[TW_CHUNK_CHARS];
+} TreeWalkChunk;
+
+struct PyTreeWalker;
+
+// The directories (relative to the root) waiting to be scanned by one thread.
+// The owner pushes and pops at the top, other threads steal from the bottom.
+typedef struct {
+	struct PyTreeWalker *w;
+	ULONG index;
+	CRITICAL_SECTION cs;
+	WCHAR **dirs;
+	ULONG bottom, top, size;
+	TreeWalkChunk *chunk;	// the chunk being filled
+} TreeWalkWorker;
+
+typedef struct PyTreeWalker {
+	PyObject_HEAD
+	WCHAR *root;
+	WCHAR *pattern;		// NULL to match everything
+	DWORD attrRequired;
+	DWORD attrExcluded;
+	BOOL bFollowReparse;
+	ULONG numThreads;
+	TreeWalkWorker *workers;
+	HANDLE hThreads[TW_MAX_THREADS];
+	volatile LONG pendingDirs;	// directories queued or being scanned
+	volatile LONG bStop;
+	volatile LONG doneThreads;
+	HANDLE hWork;		// a directory has been queued
+	HANDLE hOutput;		// a chunk has been queued, or a thread has finished
+	HANDLE hSpace;		// a chunk has been taken
+	CRITICAL_SECTION csOut;
+	TreeWalkChunk *outHead, *outTail;
+	LONG outCount;
+	TreeWalkChunk *cur;	// the chunk being consumed
+	ULONG curIndex;
+	LONG directories;	// statistics
+	LONG entries;
+	LONG matched;
+	LONG errors;
+	LONG steals;
+} PyTreeWalker;
+
+extern PyTypeObject PyTreeWalker_Type;
+
+// Case-insensitive match supporting '*' and '?', as FindFirstFile does.
+static BOOL tw_match(const WCHAR *pat, const WCHAR *s)
+{
+	const WCHAR *star = NULL, *retry = NULL;
+	while (*s) {
+		if (*pat == L'*') {
+			star = pat++;
+			retry = s;
+		}
+		else if (*pat == L'?' || towupper(*pat) == towupper(*s)) {
+			pat++;
+			s++;
+		}
+		else if (star) {
+			pat = star + 1;
+			s = ++retry;
+		}
+		else
+			return FALSE;
+	}
+	while (*pat == L'*')
+		pat++;
+	return *pat == 0;
+}
 
-	if (htrans!=NULL)
-		hfind=(*pfnFindFirstStreamTransacted)(fname, lvl, &fsd, flags, htrans);
+static BOOL tw_push(TreeWalkWorker *me, WCHAR *dir)
+{
+	BOOL ok = TRUE;
+	EnterCriticalSection(&me->cs);
+	if (me->bottom == me->top)
+		me->bottom = me->top = 0;
+	if (me->top == me->size) {
+		if (me->bottom) {
+			memmove(me->dirs, me->dirs + me->bottom, (me->top - me->bottom) * sizeof(WCHAR *));
+			me->top -= me->bottom;
+			me->bottom = 0;
+		}
+		else {
+			ULONG size = me->size ? me->size * 2 : 64;
+			WCHAR **dirs = (WCHAR **)realloc(me->dirs, size * sizeof(WCHAR *));
+			if (dirs) {
+				me->dirs = dirs;
+				me->size = size;
+			}
+			else
+				ok = FALSE;
+		}
+	}
+	if (ok)
+		me->dirs[me->top++] = dir;
+	LeaveCriticalSection(&me->cs);
+	return ok;
+}
+
+static WCHAR *tw_pop(TreeWalkWorker *me)
+{
+	WCHAR *ret = NULL;
+	EnterCriticalSection(&me->cs);
+	if (me->top > me->bottom)
+		ret = me->dirs[--me->top];
+	LeaveCriticalSection(&me->cs);
+	return ret;
+}
+
+static WCHAR *tw_steal(TreeWalkWorker *me)
+{
+	PyTreeWalker *w = me->w;
+	for (ULONG i=1;i<w->numThreads;i++) {
+		TreeWalkWorker *victim = w->workers + (me->index + i) % w->numThreads;
+		WCHAR *ret = NULL;
+		EnterCriticalSection(&victim->cs);
+		if (victim->top > victim->bottom)
+			ret = victim->dirs[victim->bottom++];
+		LeaveCriticalSection(&victim->cs);
+		if (ret) {
+			InterlockedIncrement(&w->steals);
+			return ret;
+		}
+	}
+	return NULL;
+}
+
+// Queues a filled chunk for the consumer, waiting while too many are queued.
+static void tw_flush(TreeWalkWorker *me)
+{
+	PyTreeWalker *w = me->w;
+	TreeWalkChunk *chunk = me->chunk;
+	me->chunk = NULL;
+	if (chunk == NULL)
+		return;
+	if (chunk->count == 0) {
+		free(chunk);
+		return;
+	}
+	EnterCriticalSection(&w->csOut);
+	while (w->outCount >= TW_MAX_QUEUED && !w->bStop) {
+		LeaveCriticalSection(&w->csOut);
+		WaitForSingleObject(w->hSpace, 100);
+		EnterCriticalSection(&w->csOut);
+	}
+	chunk->next = NULL;
+	if (w->outTail)
+		w->outTail->next = chunk;
+	else
+		w->outHead = chunk;
+	w->outTail = chunk;
+	w->outCount++;
+	LeaveCriticalSection(&w->csOut);
+	SetEvent(w->hOutput);
+}
+
+static void tw_emit(TreeWalkWorker *me, const WCHAR *name, ULONG len, WIN32_FIND_DATAW *fd)
+{
+	TreeWalkChunk *chunk = me->chunk;
+	if (chunk && (chunk->count == TW_CHUNK_RECORDS || chunk->used + len > TW_CHUNK_CHARS)) {
+		tw_flush(me);
+		chunk = NULL;
+	}
+	if (chunk == NULL) {
+		chunk = me->chunk = (TreeWalkChunk *)malloc(sizeof(TreeWalkChunk));
+		if (chunk == NULL) {
+			InterlockedIncrement(&me->w->errors);
+			return;
+		}
+		chunk->count = chunk->used = 0;
+	}
+	TreeWalkRecord *r = chunk->recs + chunk->count++;
+	r->nameOffset = chunk->used;
+	r->nameLen = len;
+	r->attrs = fd->dwFileAttributes;
+	r->size = ((ULONGLONG)fd->nFileSizeHigh << 32) | fd->nFileSizeLow;
+	r->mtime = ((ULONGLONG)fd->ftLastWriteTime.dwHighDateTime << 32) | fd->ftLastWriteTime.dwLowDateTime;
+	memcpy(chunk->names + chunk->used, name, len * sizeof(WCHAR));
+	chunk->used += len;
+}
+
+static void tw_scan(TreeWalkWorker *me, const WCHAR *dir)
+{
+	PyTreeWalker *w = me->w;
+	size_t rootLen = wcslen(w->root), dirLen = wcslen(dir);
+	// root\dir\name - the name is at most MAX_PATH characters.
+	WCHAR *path = (WCHAR *)malloc((rootLen + dirLen + MAX_PATH + 3) * sizeof(WCHAR));
+	if (path == NULL) {
+		InterlockedIncrement(&w->errors);
+		return;
+	}
+	WCHAR *rel = path + rootLen + 1;
+	wcscpy(path, w->root);
+	path[rootLen] = L'\\';
+	wcscpy(rel, dir);
+	WCHAR *name = rel + dirLen;
+	if (dirLen)
+		*name++ = L'\\';
+	wcscpy(name, L"*");
+
+	WIN32_FIND_DATAW fd;
+	HANDLE hFind = FindFirstFileExW(path, FindExInfoBasic, &fd, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+	if (hFind == INVALID_HANDLE_VALUE) {
+		if (GetLastError() != ERROR_FILE_NOT_FOUND)
+			InterlockedIncrement(&w->errors);
+		free(path);
+		return;
+	}
+	InterlockedIncrement(&w->directories);
+	do {
+		if (fd.cFileName[0] == L'.' && (fd.cFileName[1] == 0 || (fd.cFileName[1] == L'.' && fd.cFileName[2] == 0)))
+			continue;
+		InterlockedIncrement(&w->entries);
+		wcscpy(name, fd.cFileName);
+		ULONG relLen = (ULONG)(name - rel + wcslen(fd.cFileName));
+		if ((fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			&& (w->bFollowReparse || !(fd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT))) {
+			WCHAR *sub = (WCHAR *)malloc((relLen + 1) * sizeof(WCHAR));
+			InterlockedIncrement(&w->pendingDirs);
+			if (sub)
+				wcscpy(sub, rel);
+			if (sub && tw_push(me, sub))
+				SetEvent(w->hWork);
+			else {
+				free(sub);
+				InterlockedIncrement(&w->errors);
+				InterlockedDecrement(&w->pendingDirs);
+			}
+		}
+		if ((fd.dwFileAttributes & w->attrRequired) != w->attrRequired
+			|| (fd.dwFileAttributes & w->attrExcluded)
+			|| (w->pattern && !tw_match(w->pattern, fd.cFileName)))
+			continue;
+		InterlockedIncrement(&w->matched);
+		tw_emit(me, rel, relLen, &fd);
+	} while (!w->bStop && FindNextFileW(hFind, &fd));
+	FindClose(hFind);
+	free(path);
+}
+
+static DWORD WINAPI tw_thread(LPVOID param)
+{
+	TreeWalkWorker *me = (TreeWalkWorker *)param;
+	PyTreeWalker *w = me->w;
+	while (!w->bStop) {
+		WCHAR *dir = tw_pop(me);
+		if (dir == NULL)
+			dir = tw_steal(me);
+		if (dir == NULL) {
+			if (w->pendingDirs == 0)
+				break;
+			WaitForSingleObject(w->hWork, 10);
+			continue;
+		}
+		tw_scan(me, dir);
+		free(dir);
+		InterlockedDecrement(&w->pendingDirs);
+	}
+	tw_flush(me);
+	InterlockedIncrement(&w->doneThreads);
+	SetEvent(w->hOutput);
+	return 0;
+}
+
+// Returns the next chunk, or NULL when the walk is complete.  Called without the GIL.
+static TreeWalkChunk *tw_next_chunk(PyTreeWalker *w)
+{
+	for (;;) {
+		EnterCriticalSection(&w->csOut);
+		TreeWalkChunk *chunk = w->outHead;
+		if (chunk) {
+			w->outHead = chunk->next;
+			if (w->outHead == NULL)
+				w->outTail = NULL;
+			w->outCount--;
+		}
+		BOOL done = w->doneThreads == (LONG)w->numThreads;
+		LeaveCriticalSection(&w->csOut);
+		if (chunk) {
+			SetEvent(w->hSpace);
+			return chunk;
+		}
+		if (done)
+			return NULL;
+		// The timeout covers several threads consuming the same walker.
+		WaitForSingleObject(w->hOutput, 100);
+	}
+}
+
+static void tw_close(PyTreeWalker *w)
+{
+	if (w->workers == NULL)
+		return;
+	InterlockedExchange(&w->bStop, 1);
+	SetEvent(w->hSpace);
+	Py_BEGIN_ALLOW_THREADS
+	WaitForMultipleObjects(w->numThreads, w->hThreads, TRUE, INFINITE);
+	Py_END_ALLOW_THREADS
+	ULONG i;
+	for (i=0;i<w->numThreads;i++) {
+		CloseHandle(w->hThreads[i]);
+		TreeWalkWorker *worker = w->workers + i;
+		for (ULONG j=worker->bottom;j<worker->top;j++)
+			free(worker->dirs[j]);
+		free(worker->dirs);
+		DeleteCriticalSection(&worker->cs);
+	}
+	free(w->workers);
+	w->workers = NULL;
+	// Another thread may be waiting in tw_next_chunk.
+	EnterCriticalSection(&w->csOut);
+	while (w->outHead) {
+		TreeWalkChunk *next = w->outHead->next;
+		free(w->outHead);
+		w->outHead = next;
+	}
+	w->outTail = NULL;
+	w->outCount = 0;
+	w->doneThreads = w->numThreads;
+	LeaveCriticalSection(&w->csOut);
+	SetEvent(w->hOutput);
+}
+
+static void tw_dealloc(PyObject *ob)
+{
+	PyTreeWalker *w = (PyTreeWalker *)ob;
+	tw_close(w);
+	free(w->cur);
+	DeleteCriticalSection(&w->csOut);
+	if (w->hWork)
+		CloseHandle(w->hWork);
+	if (w->hOutput)
+		CloseHandle(w->hOutput);
+	if (w->hSpace)
+		CloseHandle(w->hSpace);
+	PyWinObject_FreeWCHAR(w->root);
+	PyWinObject_FreeWCHAR(w->pattern);
+	PyObject_Del(ob);
+}
+
+static PyObject *tw_iternext(PyObject *self)
+{
+	PyTreeWalker *w = (PyTreeWalker *)self;
+	while (w->cur == NULL || w->curIndex == w->cur->count) {
+		free(w->cur);
+		w->cur = NULL;
+		if (w->workers == NULL)
+			return NULL;
+		TreeWalkChunk *chunk;
+		Py_BEGIN_ALLOW_THREADS
+		chunk = tw_next_chunk(w);
+		Py_END_ALLOW_THREADS
+		if (chunk == NULL)
+			return NULL;
+		if (w->cur) {
+			// Another thread got in first - put this one back.
+			EnterCriticalSection(&w->csOut);
+			chunk->next = w->outHead;
+			w->outHead = chunk;
+			if (w->outTail == NULL)
+				w->outTail = chunk;
+			w->outCount++;
+			LeaveCriticalSection(&w->csOut);
+			continue;
+		}
+		w->cur = chunk;
+		w->curIndex = 0;
+	}
+	TreeWalkRecord *r = w->cur->recs + w->curIndex++;
+	return Py_BuildValue("NkKK",
+		PyWinObject_FromOLECHAR(w->cur->names + r->nameOffset, r->nameLen),
+		r->attrs, r->size, r->mtime);
+}
+
+// @pymethod |PyTreeWalker|Close|Stops the scan and discards any entries not yet returned.
+static PyObject *tw_Close(PyObject *self, PyObject *args)
+{
+	if (!PyArg_ParseTuple(args, ":Close"))
+		return NULL;
+	tw_close((PyTreeWalker *)self);
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+static PyMethodDef tw_methods[] = {
+	{"Close", tw_Close, METH_VARARGS}, // @pymeth Close|Stops the scan.
+	{NULL}
+};
+
+#undef OFF
+#define OFF(e) offsetof(PyTreeWalker, e)
+static PyMemberDef tw_members[] = {
+	{"directories", T_LONG, OFF(directories), READONLY}, // @prop int|directories|The number of directories scanned so far.
+	{"entries", T_LONG, OFF(entries), READONLY}, // @prop int|entries|The number of entries seen so far.
+	{"matched", T_LONG, OFF(matched), READONLY}, // @prop int|matched|The number of entries which passed the filters.
+	{"errors", T_LONG, OFF(errors), READONLY}, // @prop int|errors|The number of directories which could not be scanned.
+	{"steals", T_LONG, OFF(steals), READONLY}, // @prop int|steals|The number of directories taken by one thread from another.
+	{NULL}
+};
+#undef OFF
+
+PyTypeObject PyTreeWalker_Type = {
+	PYWIN_OBJECT_HEAD
+	"PyTreeWalker",				/* tp_name */
+	sizeof(PyTreeWalker),			/* tp_basicsize */
+	0,					/* tp_itemsize */
+	tw_dealloc,				/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	0,					/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	PyObject_SelfIter,			/* tp_iter */
+	tw_iternext,				/* tp_iternext */
+	tw_methods,				/* tp_methods */
+	tw_members,				/* tp_members */
+	0,					/* tp_getset */
+};
+
+// @pyswig <o PyTreeWalker>|WalkDirectoryTree|Scans a directory tree using a pool of native threads.
+// @rdesc The result is an iterator, with each next() returning a tuple of
+// (name, attributes, size, mtime).  name is relative to the root, and mtime is
+// the last write time as an integer in 100-nanosecond units, as per a FILETIME.
+// @comm Accepts keyword args.
+// @comm Directories are included in the results if they pass the filters, but
+// are scanned whether they do or not.
+static PyObject *py_WalkDirectoryTree(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	PyObject *obRoot, *obPattern = Py_None;
+	DWORD attrRequired = 0, attrExcluded = 0;
+	int numThreads = 4;
+	BOOL bFollowReparse = FALSE;
+	static char *keywords[]={"Root","Pattern","AttributesRequired","AttributesExcluded","NumThreads","FollowReparsePoints", NULL};
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|Okkii:WalkDirectoryTree", keywords,
+		&obRoot,	// @pyparm <o PyUnicode>|Root||The directory to scan.
+		&obPattern,	// @pyparm <o PyUnicode>|Pattern|None|Only entries whose names match this wildcard pattern are returned.  The match is case-insensitive and supports * and ?.
+		&attrRequired,	// @pyparm int|AttributesRequired|0|Only entries with all of these FILE_ATTRIBUTE_* flags are returned.
+		&attrExcluded,	// @pyparm int|AttributesExcluded|0|Entries with any of these FILE_ATTRIBUTE_* flags are not returned.  For example, FILE_ATTRIBUTE_DIRECTORY returns only files.
+		&numThreads,	// @pyparm int|NumThreads|4|The number of threads scanning the tree.
+		&bFollowReparse))	// @pyparm boolean|FollowReparsePoints|False|Whether to scan directories which are reparse points, such as junctions.  Beware of cycles if this is set.
+		return NULL;
+	if (numThreads < 1 || numThreads > TW_MAX_THREADS)
+		return PyErr_Format(PyExc_ValueError, "NumThreads must be between 1 and %d", TW_MAX_THREADS);
+	PyTreeWalker *w = PyObject_New(PyTreeWalker, &PyTreeWalker_Type);
+	if (w == NULL)
+		return NULL;
+	memset(((BYTE *)w) + sizeof(PyObject), 0, sizeof(PyTreeWalker) - sizeof(PyObject));
+	InitializeCriticalSection(&w->csOut);
+	if (!PyWinObject_AsWCHAR(obRoot, &w->root, FALSE)
+		|| !PyWinObject_AsWCHAR(obPattern, &w->pattern, TRUE)) {
+		Py_DECREF(w);
+		return NULL;
+	}
+	DWORD attrs;
+	Py_BEGIN_ALLOW_THREADS
+	attrs = GetFileAttributesW(w->root);
+	Py_END_ALLOW_THREADS
+	if (attrs == INVALID_FILE_ATTRIBUTES) {
+		Py_DECREF(w);
+		return PyWin_SetAPIError("GetFileAttributesW");
+	}
+	if (!(attrs & FILE_ATTRIBUTE_DIRECTORY)) {
+		Py_DECREF(w);
+		return PyWin_SetAPIError("WalkDirectoryTree", ERROR_DIRECTORY);
+	}
+	// Trailing separators would give us doubled ones.
+	size_t rootLen = wcslen(w->root);
+	while (rootLen && (w->root[rootLen-1] == L'\\' || w->root[rootLen-1] == L'/'))
+		w->root[--rootLen] = 0;
+	w->attrRequired = attrRequired;
+	w->attrExcluded = attrExcluded;
+	w->bFollowReparse = bFollowReparse;
+	w->hWork = CreateEvent(NULL, FALSE, FALSE, NULL);
+	w->hOutput = CreateEvent(NULL, FALSE, FALSE, NULL);
+	w->hSpace = CreateEvent(NULL, FALSE, FALSE, NULL);
+	if (w->hWork == NULL || w->hOutput == NULL || w->hSpace == NULL) {
+		PyWin_SetAPIError("CreateEvent");
+		Py_DECREF(w);
+		return NULL;
+	}
+	w->workers = (TreeWalkWorker *)calloc(numThreads, sizeof(TreeWalkWorker));
+	if (w->workers == NULL) {
+		Py_DECREF(w);
+		return PyErr_NoMemory();
+	}
+	for (int i=0;i<numThreads;i++) {
+		w->workers[i].w = w;
+		w->workers[i].index = i;
+		InitializeCriticalSection(&w->workers[i].cs);
+	}
+	WCHAR *top = (WCHAR *)malloc(sizeof(WCHAR));
+	if (top == NULL || !tw_push(w->workers, top)) {
+		free(top);
+		w->numThreads = numThreads;
+		Py_DECREF(w);
+		return PyErr_NoMemory();
+	}
+	*top = 0;
+	w->pendingDirs = 1;
+	for (w->numThreads=0; w->numThreads<(ULONG)numThreads; w->numThreads++) {
+		w->hThreads[w->numThreads] = CreateThread(NULL, 0, tw_thread, w->workers + w->numThreads, 0, NULL);
+		if (w->hThreads[w->numThreads] == NULL) {
+			PyWin_SetAPIError("CreateThread");
+			// tw_close only cleans up the workers which were started.
+			for (int i=w->numThreads;i<numThreads;i++)
+				DeleteCriticalSection(&w->workers[i].cs);
+			if (w->numThreads == 0) {
+				free(top);
+				free(w->workers[0].dirs);
+				free(w->workers);
+				w->workers = NULL;
+			}
+			Py_DECREF(w);
+			return NULL;
+		}
+	}
+	return w;
+}
+PyCFunction pfnpy_WalkDirectoryTree=(PyCFunction)py_WalkDirectoryTree;
+
+// @pyswig [(long, <o PyUnicode>),...]|FindStreams|List the data streams for a file
+// @rdesc Returns a list of tuples containing each stream's size and name
+// @comm This uses the API functions FindFirstStreamW, FindNextStreamW and FindClose
+// @comm Available on Windows Server 2003 and Vista
+// @comm If the Transaction arg is not None, FindFirstStreamTransacted will be called in place of FindFirstStreamW
+static PyObject *py_FindStreams(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	CHECK_PFN(FindFirstStream);
+	CHECK_PFN(FindNextStream);
+	
+	PyObject *obfname, *obtrans=Py_None, *ret=NULL, *ret_item;
+	WCHAR *fname=NULL;
+	HANDLE hfind, htrans;
+	STREAM_INFO_LEVELS lvl =  FindStreamInfoStandard;  // only level that currently exists
+	WIN32_FIND_STREAM_DATA fsd;
+	DWORD err=0, flags=0, ret_cnt=0;   // flags are reserved, don't even accept as input
+	static char *keywords[]={"FileName","Transaction", NULL};
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|O:FindStreams", keywords,
+		&obfname,	// @pyparm <o PyUnicode>|FileName||Name of file (or directory) to operate on
+		&obtrans))	// @pyparm <o PyHANDLE>|Transaction|None|Handle to a transaction, can be None
+		return NULL;
+	if (!PyWinObject_AsHANDLE(obtrans, &htrans))
+		return NULL;
+	if (htrans!=NULL)
+		CHECK_PFN(FindFirstStreamTransacted);
+	if (!PyWinObject_AsWCHAR(obfname, &fname, FALSE))
+		return NULL;
+
+	if (htrans!=NULL)
+		hfind=(*pfnFindFirstStreamTransacted)(fname, lvl, &fsd, flags, htrans);
 	else
 		hfind=(*pfnFindFirstStream)(fname, lvl, &fsd, flags);
 	PyWinObject_FreeWCHAR(fname);
@@ -5727,6 +10732,274 @@ static PyObject *py_GetFileInformationByHandleEx(PyObject *self, PyObject *args,
 PyCFunction pfnpy_GetFileInformationByHandleEx=(PyCFunction)py_GetFileInformationByHandleEx;
 %}
 
+// @object PyDirectoryInformation|A sequence of the entries in a directory, as returned by <om win32file.GetDirectoryInformation>.
+// @comm The raw FILE_ID_BOTH_DIR_INFO or FILE_FULL_DIR_INFO structs are kept
+// in a single buffer, and each is only converted to a dict when it is
+// indexed.  The dicts have the same keys as those returned by
+// <om win32file.GetFileInformationByHandleEx> (FILE_FULL_DIR_INFO has no
+// ShortName or FileId).
+%{
+typedef struct {
+	PyObject_HEAD
+	PyObject *obFile;	// keeps the handle alive
+	HANDLE hFile;
+	FILE_INFO_BY_HANDLE_CLASS info_class;
+	DWORD chunkSize;	// the size passed to each GetFileInformationByHandleEx call
+	BYTE *buf;
+	size_t bufSize;
+	size_t *offsets;	// of each entry within buf
+	Py_ssize_t count;
+	Py_ssize_t maxCount;
+	LONG calls;		// statistics
+} PyDirectoryInformation;
+
+extern PyTypeObject PyDirectoryInformation_Type;
+
+// Fetches the whole directory, reusing the buffer.  Called without the GIL;
+// returns 0 or the win32 error code.
+static DWORD di_fill(PyDirectoryInformation *di)
+{
+	FILE_INFO_BY_HANDLE_CLASS restart_class = di->info_class == FileIdBothDirectoryInfo ?
+		FileIdBothDirectoryRestartInfo : FileFullDirectoryRestartInfo;
+	size_t used = 0;
+	di->count = 0;
+	for (BOOL bFirst = TRUE;; bFirst = FALSE) {
+		if (used + di->chunkSize > di->bufSize) {
+			size_t size = di->bufSize ? di->bufSize * 2 : di->chunkSize;
+			while (size < used + di->chunkSize)
+				size *= 2;
+			BYTE *buf = (BYTE *)realloc(di->buf, size);
+			if (buf == NULL)
+				return ERROR_NOT_ENOUGH_MEMORY;
+			di->buf = buf;
+			di->bufSize = size;
+		}
+		di->calls++;
+		if (!(*pfnGetFileInformationByHandleEx)(di->hFile, bFirst ? restart_class : di->info_class,
+				di->buf + used, di->chunkSize)) {
+			DWORD err = GetLastError();
+			return err == ERROR_NO_MORE_FILES ? 0 : err;
+		}
+		// The structs are 8 byte aligned, and the size of the data returned
+		// is only known from the last of them.
+		size_t offset = used;
+		for (;;) {
+			if (di->count == di->maxCount) {
+				Py_ssize_t maxCount = di->maxCount ? di->maxCount * 2 : 256;
+				size_t *offsets = (size_t *)realloc(di->offsets, maxCount * sizeof(size_t));
+				if (offsets == NULL)
+					return ERROR_NOT_ENOUGH_MEMORY;
+				di->offsets = offsets;
+				di->maxCount = maxCount;
+			}
+			di->offsets[di->count++] = offset;
+			ULONG next = *(ULONG *)(di->buf + offset);
+			if (next == 0)
+				break;
+			offset += next;
+		}
+		if (di->info_class == FileIdBothDirectoryInfo) {
+			FILE_ID_BOTH_DIR_INFO *p = (FILE_ID_BOTH_DIR_INFO *)(di->buf + offset);
+			offset += offsetof(FILE_ID_BOTH_DIR_INFO, FileName) + p->FileNameLength;
+		}
+		else {
+			FILE_FULL_DIR_INFO *p = (FILE_FULL_DIR_INFO *)(di->buf + offset);
+			offset += offsetof(FILE_FULL_DIR_INFO, FileName) + p->FileNameLength;
+		}
+		used = (offset + 7) & ~(size_t)7;
+	}
+}
+
+static void di_dealloc(PyObject *ob)
+{
+	PyDirectoryInformation *di = (PyDirectoryInformation *)ob;
+	free(di->buf);
+	free(di->offsets);
+	Py_XDECREF(di->obFile);
+	PyObject_Del(ob);
+}
+
+static Py_ssize_t di_length(PyObject *self)
+{
+	return ((PyDirectoryInformation *)self)->count;
+}
+
+static PyObject *di_item(PyObject *self, Py_ssize_t i)
+{
+	PyDirectoryInformation *di = (PyDirectoryInformation *)self;
+	if (i < 0 || i >= di->count) {
+		PyErr_SetString(PyExc_IndexError, "index out of range");
+		return NULL;
+	}
+	BYTE *p = di->buf + di->offsets[i];
+	if (di->info_class == FileIdBothDirectoryInfo) {
+		FILE_ID_BOTH_DIR_INFO *pdi = (FILE_ID_BOTH_DIR_INFO *)p;
+		return Py_BuildValue("{s:k, s:N, s:N, s:N, s:N, s:N, s:N, s:k, s:k, s:N, s:N, s:N}",
+			"FileIndex", pdi->FileIndex,
+			"CreationTime", PyWinObject_FromTimeStamp(pdi->CreationTime),
+			"LastAccessTime", PyWinObject_FromTimeStamp(pdi->LastAccessTime),
+			"LastWriteTime", PyWinObject_FromTimeStamp(pdi->LastWriteTime),
+			"ChangeTime", PyWinObject_FromTimeStamp(pdi->ChangeTime),
+			"EndOfFile", PyWinObject_FromLARGE_INTEGER(pdi->EndOfFile),
+			"AllocationSize", PyWinObject_FromLARGE_INTEGER(pdi->AllocationSize),
+			"FileAttributes", pdi->FileAttributes,
+			"EaSize", pdi->EaSize,
+			"ShortName", PyWinObject_FromWCHAR(pdi->ShortName, pdi->ShortNameLength/sizeof(WCHAR)),
+			"FileId", PyWinObject_FromLARGE_INTEGER(pdi->FileId),
+			"FileName", PyWinObject_FromWCHAR(pdi->FileName, pdi->FileNameLength/sizeof(WCHAR)));
+	}
+	FILE_FULL_DIR_INFO *pfi = (FILE_FULL_DIR_INFO *)p;
+	return Py_BuildValue("{s:k, s:N, s:N, s:N, s:N, s:N, s:N, s:k, s:k, s:N}",
+		"FileIndex", pfi->FileIndex,
+		"CreationTime", PyWinObject_FromTimeStamp(pfi->CreationTime),
+		"LastAccessTime", PyWinObject_FromTimeStamp(pfi->LastAccessTime),
+		"LastWriteTime", PyWinObject_FromTimeStamp(pfi->LastWriteTime),
+		"ChangeTime", PyWinObject_FromTimeStamp(pfi->ChangeTime),
+		"EndOfFile", PyWinObject_FromLARGE_INTEGER(pfi->EndOfFile),
+		"AllocationSize", PyWinObject_FromLARGE_INTEGER(pfi->AllocationSize),
+		"FileAttributes", pfi->FileAttributes,
+		"EaSize", pfi->EaSize,
+		"FileName", PyWinObject_FromWCHAR(pfi->FileName, pfi->FileNameLength/sizeof(WCHAR)));
+}
+
+// @pymethod <o PyUnicode>|PyDirectoryInformation|GetFileName|Returns the name of an entry, without converting the rest of it.
+static PyObject *di_GetFileName(PyObject *self, PyObject *args)
+{
+	PyDirectoryInformation *di = (PyDirectoryInformation *)self;
+	Py_ssize_t i;
+	if (!PyArg_ParseTuple(args, "n:GetFileName",
+		&i)) // @pyparm int|index||The index of the entry.
+		return NULL;
+	if (i < 0 || i >= di->count) {
+		PyErr_SetString(PyExc_IndexError, "index out of range");
+		return NULL;
+	}
+	BYTE *p = di->buf + di->offsets[i];
+	if (di->info_class == FileIdBothDirectoryInfo) {
+		FILE_ID_BOTH_DIR_INFO *pdi = (FILE_ID_BOTH_DIR_INFO *)p;
+		return PyWinObject_FromWCHAR(pdi->FileName, pdi->FileNameLength/sizeof(WCHAR));
+	}
+	FILE_FULL_DIR_INFO *pfi = (FILE_FULL_DIR_INFO *)p;
+	return PyWinObject_FromWCHAR(pfi->FileName, pfi->FileNameLength/sizeof(WCHAR));
+}
+
+// @pymethod |PyDirectoryInformation|Refresh|Fetches the directory entries again, reusing the buffer.
+static PyObject *di_Refresh(PyObject *self, PyObject *args)
+{
+	PyDirectoryInformation *di = (PyDirectoryInformation *)self;
+	if (!PyArg_ParseTuple(args, ":Refresh"))
+		return NULL;
+	DWORD err;
+	Py_BEGIN_ALLOW_THREADS
+	err = di_fill(di);
+	Py_END_ALLOW_THREADS
+	if (err)
+		return PyWin_SetAPIError("GetFileInformationByHandleEx", err);
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+static PySequenceMethods di_sequence = {
+	di_length,		/* sq_length */
+	0,			/* sq_concat */
+	0,			/* sq_repeat */
+	di_item,		/* sq_item */
+};
+
+static PyMethodDef di_methods[] = {
+	{"GetFileName", di_GetFileName, METH_VARARGS}, // @pymeth GetFileName|Returns the name of an entry.
+	{"Refresh", di_Refresh, METH_VARARGS}, // @pymeth Refresh|Fetches the directory entries again.
+	{NULL}
+};
+
+#undef OFF
+#define OFF(e) offsetof(PyDirectoryInformation, e)
+static PyMemberDef di_members[] = {
+	{"calls", T_LONG, OFF(calls), READONLY}, // @prop int|calls|The number of GetFileInformationByHandleEx calls made so far.
+	{NULL}
+};
+#undef OFF
+
+PyTypeObject PyDirectoryInformation_Type = {
+	PYWIN_OBJECT_HEAD
+	"PyDirectoryInformation",		/* tp_name */
+	sizeof(PyDirectoryInformation),		/* tp_basicsize */
+	0,					/* tp_itemsize */
+	di_dealloc,				/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	&di_sequence,				/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	0,					/* tp_iter */
+	0,					/* tp_iternext */
+	di_methods,				/* tp_methods */
+	di_members,				/* tp_members */
+	0,					/* tp_getset */
+};
+
+// @pyswig <o PyDirectoryInformation>|GetDirectoryInformation|Retrieves all the entries of a directory using GetFileInformationByHandleEx.
+// @comm Available on Windows 8 and later (on Vista and Windows 7, only FileIdBothDirectoryInfo is supported).
+// @comm Accepts keyword args.
+// @comm Each call to GetFileInformationByHandleEx returns as many entries as fit in BufferSize,
+// so a whole directory generally costs one handle and a few calls, rather than a
+// <om win32file.GetFileAttributesEx> per file.
+static PyObject *py_GetDirectoryInformation(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	CHECK_PFN(GetFileInformationByHandleEx);
+	static char *keywords[] = {"File", "FileInformationClass", "BufferSize", NULL};
+	PyObject *obFile;
+	HANDLE handle;
+	FILE_INFO_BY_HANDLE_CLASS info_class = FileIdBothDirectoryInfo;
+	DWORD bufSize = 65536;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|ik:GetDirectoryInformation", keywords,
+		&obFile,	// @pyparm <o PyHANDLE>|File||Handle to a directory, opened with FILE_LIST_DIRECTORY access and FILE_FLAG_BACKUP_SEMANTICS.
+		&info_class,	// @pyparm int|FileInformationClass|FileIdBothDirectoryInfo|FileIdBothDirectoryInfo or FileFullDirectoryInfo.
+		&bufSize))	// @pyparm int|BufferSize|65536|The size of the buffer passed to each call.
+		return NULL;
+	if (!PyWinObject_AsHANDLE(obFile, &handle))
+		return NULL;
+	if (info_class != FileIdBothDirectoryInfo && info_class != FileFullDirectoryInfo)
+		return PyErr_Format(PyExc_ValueError, "FileInformationClass must be FileIdBothDirectoryInfo or FileFullDirectoryInfo");
+	if (bufSize < 4096)
+		return PyErr_Format(PyExc_ValueError, "BufferSize must be at least 4096");
+	PyDirectoryInformation *di = PyObject_New(PyDirectoryInformation, &PyDirectoryInformation_Type);
+	if (di == NULL)
+		return NULL;
+	memset(((BYTE *)di) + sizeof(PyObject), 0, sizeof(PyDirectoryInformation) - sizeof(PyObject));
+	di->obFile = obFile;
+	Py_INCREF(obFile);
+	di->hFile = handle;
+	di->info_class = info_class;
+	di->chunkSize = (bufSize + 7) & ~7;
+	DWORD err;
+	Py_BEGIN_ALLOW_THREADS
+	err = di_fill(di);
+	Py_END_ALLOW_THREADS
+	if (err) {
+		Py_DECREF(di);
+		return PyWin_SetAPIError("GetFileInformationByHandleEx", err);
+	}
+	return di;
+}
+PyCFunction pfnpy_GetDirectoryInformation=(PyCFunction)py_GetDirectoryInformation;
+%}
+
 %{
 // @pyswig |SetFileInformationByHandle|Changes file characteristics by file handle
 // @comm Available on Vista and later.
@@ -5875,88 +11148,1194 @@ static PyObject *py_SetFileInformationByHandle(PyObject *self, PyObject *args, P
 		Py_INCREF(Py_None);
 		return Py_None;
 		}
-	return PyWin_SetAPIError("SetFileInformationByHandle");
+	return PyWin_SetAPIError("SetFileInformationByHandle");
+}
+PyCFunction pfnpy_SetFileInformationByHandle=(PyCFunction)py_SetFileInformationByHandle;
+%}
+
+%{
+// @pyswig <o PyHANDLE>|ReOpenFile|Creates a new handle to an open file
+// @comm Available on Vista and later.
+// @comm Accepts keyword args.
+static PyObject *py_ReOpenFile(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	CHECK_PFN(ReOpenFile);
+	static char *keywords[] = {"OriginalFile", "DesiredAccess", "ShareMode", "Flags", NULL};
+	HANDLE horig, hret;
+	DWORD DesiredAccess, ShareMode, Flags;			
+	// @pyparm <o PyHANDLE>|OriginalFile||An open file handle
+	// @pyparm int|DesiredAccess||Access mode, cannot conflict with original access mode
+	// @pyparm int|ShareMode||Sharing mode (FILE_SHARE_*), cannot conflict with original share mode
+	// @pyparm int|Flags||Combination of FILE_FLAG_* flags
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&kkk:ReOpenFile", keywords,
+		PyWinObject_AsHANDLE, &horig, &DesiredAccess, &ShareMode, &Flags))
+		return NULL;
+
+	Py_BEGIN_ALLOW_THREADS
+	hret = (*pfnReOpenFile)(horig, DesiredAccess, ShareMode, Flags);
+	// hret = ReOpenFile(horig, DesiredAccess, ShareMode, Flags);
+	Py_END_ALLOW_THREADS
+	if (hret == INVALID_HANDLE_VALUE)
+		return PyWin_SetAPIError("ReOpenFile");
+	return PyWinObject_FromHANDLE(hret);
+}
+PyCFunction pfnpy_ReOpenFile=(PyCFunction)py_ReOpenFile;
+%}
+
+%{
+// @pyswig <o PyHANDLE>|OpenFileById|Opens a file by File Id or Object Id
+// @comm Available on Vista and later.
+// @comm Accepts keyword args.
+static PyObject *py_OpenFileById(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	CHECK_PFN(OpenFileById);
+	static char *keywords[] = {"File", "FileID", "DesiredAccess", "ShareMode",
+		"Flags", "SecurityAttributes", NULL};
+	HANDLE hvol, hret;
+	DWORD DesiredAccess, ShareMode, Flags;
+	PyObject *obsa = Py_None;
+	PSECURITY_ATTRIBUTES sa;
+	PyObject *obfileid;
+	FILE_ID_DESCRIPTOR fileid = {sizeof(FILE_ID_DESCRIPTOR)};
+
+	// @pyparm <o PyHANDLE>|File||Handle to a file on the volume that contains the file to open
+	// @pyparm int/<o PyIID>|FileId||File Id or Object Id of the file to open
+	// @pyparm int|DesiredAccess||Access mode
+	// @pyparm int|ShareMode||Sharing mode (FILE_SHARE_*)
+	// @pyparm int|Flags||Combination of FILE_FLAG_* flags
+	// @pyparm <o PySECURITY_ATTRIBUTES>|SecurityAttributes|None|Reserved, use only None
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&Okkk|O:OpenFileById", keywords,
+		PyWinObject_AsHANDLE, &hvol, &obfileid, &DesiredAccess, &ShareMode, &Flags, &obsa))
+		return NULL;
+	if (!PyWinObject_AsSECURITY_ATTRIBUTES(obsa, &sa, TRUE))
+		return NULL;
+		
+	fileid.Type = FileIdType;
+	if (!PyWinObject_AsLARGE_INTEGER(obfileid, &fileid.FileId)){
+		PyErr_Clear();
+		fileid.Type = ObjectIdType;
+		if (!PyWinObject_AsIID(obfileid, &fileid.ObjectId)){
+			PyErr_Clear();
+			PyErr_SetString(PyExc_TypeError, "FileId must be an integer or GUID");
+			return NULL;
+			}
+		}
+
+	Py_BEGIN_ALLOW_THREADS
+	hret = (*pfnOpenFileById)(hvol, &fileid, DesiredAccess, ShareMode, sa, Flags);
+	// hret = OpenFileById(hvol, &fileid, DesiredAccess, ShareMode, sa, Flags);
+	Py_END_ALLOW_THREADS
+	if (hret == INVALID_HANDLE_VALUE)
+		return PyWin_SetAPIError("OpenFileById");
+	return PyWinObject_FromHANDLE(hret);
+}
+PyCFunction pfnpy_OpenFileById=(PyCFunction)py_OpenFileById;
+%}
+
+// @object PyUsnJournalReader|Reads the NTFS/ReFS change journal of a volume, as returned
+// by <om win32file.CreateUsnJournalReader>.
+// @comm Each FSCTL_READ_USN_JOURNAL (or FSCTL_ENUM_USN_DATA) call fills a single
+// buffer which is reused for the life of the object, and its USN_RECORD_V2 and
+// USN_RECORD_V3 records are decoded natively into tuples of
+// (usn, fileReferenceNumber, parentFileReferenceNumber, reason, timeStamp, fileAttributes, fileName).
+// The time stamp is the raw FILETIME as an integer, and a V3 128-bit file id is
+// returned as an integer.
+// <nl>If resolvePaths is set, a path relative to the volume root (or None if it
+// could not be found) is appended to each tuple.  Directory names are cached as
+// their records are seen, and a directory which is not yet cached is looked up once
+// with OpenFileById and GetFinalPathNameByHandle.  The cache reflects records as they
+// are read, so the path of a record which was written before a later rename of one of
+// its parent directories may already show the new name.
+// <nl>Batches are returned by <om PyUsnJournalReader.ReadBatch>, or by iterating over
+// the object, which stops once the reader has caught up with the journal (or the
+// enumeration is complete).
+%{
+typedef struct {
+	ULONGLONG frn;		// 0 for an empty slot
+	ULONGLONG parent;
+	WCHAR *name;		// the path from the root if bAbsolute, otherwise the name within parent
+	DWORD nameLen;		// in characters
+	BOOL bAbsolute;
+} PyUsnDirEntry;
+
+typedef struct {
+	PyObject_HEAD
+	HANDLE hVolume;
+	BOOL bOwnHandle;
+	BOOL bEnum;		// FSCTL_ENUM_USN_DATA rather than FSCTL_READ_USN_JOURNAL
+	BOOL bV0;		// the file system only accepts version 0 input structures
+	BOOL bDone;		// the enumeration has completed
+	BOOL bBusy;		// a read is in progress, possibly on another thread
+	DWORD busyThreadId;
+	BOOL bClosePending;	// Close was called during a read
+	ULONGLONG journalId;
+	LONGLONG nextUsn;	// where the next journal read starts
+	LONGLONG firstUsn;
+	LONGLONG highUsn;	// the NextUsn of the journal when enumeration started
+	ULONGLONG nextFrn;	// where the next enumeration starts
+	DWORD reasonMask;
+	BOOL bReturnOnlyOnClose;
+	BYTE *buf;
+	DWORD bufSize;
+	BOOL bResolve;
+	PyUsnDirEntry *dirs;
+	ULONG numDirs;
+	ULONG dirsSize;		// always a power of 2, at least twice numDirs
+	WCHAR *pathBuf;
+	DWORD pathBufSize;	// in characters
+	LONGLONG records;	// statistics
+	LONG reads;
+	LONG lookups;
+} PyUsnJournalReader;
+
+extern PyTypeObject PyUsnJournalReader_Type;
+
+// Longer chains of parent directories are treated as unresolvable.
+#define USN_MAX_DEPTH 1024
+
+static PyUsnDirEntry *usn_lookup(PyUsnJournalReader *r, ULONGLONG frn)
+{
+	ULONG mask = r->dirsSize - 1;
+	for (ULONG i = (ULONG)((frn * 0x9E3779B97F4A7C15ULL) >> 32) & mask;; i = (i + 1) & mask) {
+		PyUsnDirEntry *e = r->dirs + i;
+		if (e->frn == 0 || e->frn == frn)
+			return e;
+	}
+}
+
+static BOOL usn_grow(PyUsnJournalReader *r)
+{
+	ULONG oldSize = r->dirsSize;
+	PyUsnDirEntry *old = r->dirs;
+	ULONG dirsSize = oldSize ? oldSize * 2 : 1024;
+	PyUsnDirEntry *dirs = (PyUsnDirEntry *)calloc(dirsSize, sizeof(PyUsnDirEntry));
+	if (dirs == NULL)
+		return FALSE;
+	r->dirs = dirs;
+	r->dirsSize = dirsSize;
+	for (ULONG i=0;i<oldSize;i++)
+		if (old[i].frn)
+			*usn_lookup(r, old[i].frn) = old[i];
+	free(old);
+	return TRUE;
+}
+
+static BOOL usn_set_dir(PyUsnJournalReader *r, ULONGLONG frn, ULONGLONG parent, const WCHAR *name, DWORD len, BOOL bAbsolute)
+{
+	if (frn == 0)
+		return TRUE;
+	// The root directory is its own parent.
+	if (frn == parent) {
+		len = 0;
+		bAbsolute = TRUE;
+	}
+	if ((r->numDirs + 1) * 2 > r->dirsSize && !usn_grow(r))
+		return FALSE;
+	PyUsnDirEntry *e = usn_lookup(r, frn);
+	if (e->frn && e->parent == parent && e->bAbsolute == bAbsolute && e->nameLen == len
+		&& memcmp(e->name, name, len * sizeof(WCHAR)) == 0)
+		return TRUE;
+	WCHAR *copy = (WCHAR *)malloc(len ? len * sizeof(WCHAR) : 1);
+	if (copy == NULL)
+		return FALSE;
+	memcpy(copy, name, len * sizeof(WCHAR));
+	if (e->frn)
+		free(e->name);
+	else
+		r->numDirs++;
+	e->frn = frn;
+	e->parent = parent;
+	e->name = copy;
+	e->nameLen = len;
+	e->bAbsolute = bAbsolute;
+	return TRUE;
+}
+
+static void usn_clear_dirs(PyUsnJournalReader *r)
+{
+	for (ULONG i=0;i<r->dirsSize;i++)
+		free(r->dirs[i].name);
+	free(r->dirs);
+	r->dirs = NULL;
+	r->dirsSize = r->numDirs = 0;
+}
+
+// Looks up a directory which isn't cached from the file system, and caches
+// its full path.  Called with the GIL held, which is released for the lookup.
+static BOOL usn_fetch_dir(PyUsnJournalReader *r, ULONGLONG frn)
+{
+	if (pfnOpenFileById == NULL || pfnGetFinalPathNameByHandle == NULL)
+		return FALSE;
+	FILE_ID_DESCRIPTOR fileid = {sizeof(FILE_ID_DESCRIPTOR)};
+	fileid.Type = FileIdType;
+	fileid.FileId.QuadPart = (LONGLONG)frn;
+	WCHAR *path = NULL;
+	DWORD len = 0;
+	r->lookups++;
+	Py_BEGIN_ALLOW_THREADS
+	HANDLE h = (*pfnOpenFileById)(r->hVolume, &fileid, FILE_READ_ATTRIBUTES,
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, FILE_FLAG_BACKUP_SEMANTICS);
+	if (h != INVALID_HANDLE_VALUE) {
+		DWORD size = MAX_PATH;
+		for (;;) {
+			WCHAR *p = (WCHAR *)realloc(path, size * sizeof(WCHAR));
+			if (p == NULL)
+				break;
+			path = p;
+			len = (*pfnGetFinalPathNameByHandle)(h, path, size, FILE_NAME_NORMALIZED | VOLUME_NAME_NONE);
+			if (len < size)
+				break;
+			size = len + 1;
+		}
+		CloseHandle(h);
+	}
+	Py_END_ALLOW_THREADS
+	BOOL ok = FALSE;
+	if (path && len) {
+		// Cache the root as an empty path, so components can always be joined with a backslash.
+		if (path[len-1] == L'\\')
+			len--;
+		ok = usn_set_dir(r, frn, 0, path, len, TRUE);
+	}
+	free(path);
+	return ok;
+}
+
+// Builds the path of name within the directory parent, or of parent itself if
+// name is NULL.  Returns None (with no exception) if the path can't be determined.
+static PyObject *usn_resolve(PyUsnJournalReader *r, ULONGLONG parent, const WCHAR *name, DWORD nameLen)
+{
+	if (r->dirs == NULL && !usn_grow(r))
+		return PyErr_NoMemory();
+	PyUsnDirEntry *chain[USN_MAX_DEPTH];
+	int depth;
+	// Each pass either completes the chain or caches the directory it stopped at.
+	for (BOOL bFetched = FALSE;;) {
+		ULONGLONG frn = parent;
+		PyUsnDirEntry *e = NULL;
+		for (depth=0;depth<USN_MAX_DEPTH;depth++) {
+			e = usn_lookup(r, frn);
+			if (e->frn == 0)
+				break;
+			chain[depth] = e;
+			if (e->bAbsolute)
+				break;
+			frn = e->parent;
+		}
+		if (depth < USN_MAX_DEPTH && e->frn && e->bAbsolute)
+			break;
+		if (depth == USN_MAX_DEPTH || bFetched || !usn_fetch_dir(r, frn)) {
+			if (PyErr_Occurred())
+				return NULL;
+			Py_INCREF(Py_None);
+			return Py_None;
+		}
+		// The fetched directory is absolute, so the next pass ends there.
+		bFetched = TRUE;
+	}
+	DWORD len = name ? nameLen + 1 : 0;
+	for (int i=0;i<=depth;i++)
+		len += chain[i]->nameLen + 1;
+	if (len + 1 > r->pathBufSize) {
+		WCHAR *p = (WCHAR *)realloc(r->pathBuf, (len + 1) * sizeof(WCHAR));
+		if (p == NULL)
+			return PyErr_NoMemory();
+		r->pathBuf = p;
+		r->pathBufSize = len + 1;
+	}
+	WCHAR *p = r->pathBuf;
+	// The absolute entry at the top of the chain already starts with its backslash.
+	for (int i=depth;i>=0;i--) {
+		if (i != depth)
+			*p++ = L'\\';
+		memcpy(p, chain[i]->name, chain[i]->nameLen * sizeof(WCHAR));
+		p += chain[i]->nameLen;
+	}
+	if (name) {
+		*p++ = L'\\';
+		memcpy(p, name, nameLen * sizeof(WCHAR));
+		p += nameLen;
+	} else if (p == r->pathBuf)
+		*p++ = L'\\';
+	return PyWinObject_FromWCHAR(r->pathBuf, (DWORD)(p - r->pathBuf));
+}
+
+static PyObject *usn_from_file_id(const FILE_ID_128 *id, ULONGLONG *pfrn)
+{
+	ULONGLONG lo, hi;
+	memcpy(&lo, id->Identifier, sizeof(lo));
+	memcpy(&hi, id->Identifier + sizeof(lo), sizeof(hi));
+	// Ids which don't fit in 64 bits (only seen on ReFS) aren't cached.
+	*pfrn = hi ? 0 : lo;
+	if (hi == 0)
+		return PyLong_FromUnsignedLongLong(lo);
+	return _PyLong_FromByteArray((unsigned char *)id->Identifier, sizeof(id->Identifier), TRUE, FALSE);
+}
+
+static PyObject *usn_decode_record(PyUsnJournalReader *r, USN_RECORD_COMMON_HEADER *hdr)
+{
+	ULONGLONG frn, parent;
+	PyObject *obFrn, *obParent;
+	USN usn;
+	LONGLONG timeStamp;
+	DWORD reason, attributes, nameOffset, nameBytes;
+	if (hdr->MajorVersion == 2) {
+		USN_RECORD_V2 *p = (USN_RECORD_V2 *)hdr;
+		frn = p->FileReferenceNumber;
+		parent = p->ParentFileReferenceNumber;
+		obFrn = PyLong_FromUnsignedLongLong(frn);
+		obParent = PyLong_FromUnsignedLongLong(parent);
+		usn = p->Usn;
+		timeStamp = p->TimeStamp.QuadPart;
+		reason = p->Reason;
+		attributes = p->FileAttributes;
+		nameOffset = p->FileNameOffset;
+		nameBytes = p->FileNameLength;
+	} else {
+		USN_RECORD_V3 *p = (USN_RECORD_V3 *)hdr;
+		obFrn = usn_from_file_id(&p->FileReferenceNumber, &frn);
+		obParent = usn_from_file_id(&p->ParentFileReferenceNumber, &parent);
+		usn = p->Usn;
+		timeStamp = p->TimeStamp.QuadPart;
+		reason = p->Reason;
+		attributes = p->FileAttributes;
+		nameOffset = p->FileNameOffset;
+		nameBytes = p->FileNameLength;
+	}
+	if (nameOffset + nameBytes > hdr->RecordLength)
+		nameBytes = 0;
+	const WCHAR *name = (const WCHAR *)((BYTE *)hdr + nameOffset);
+	DWORD nameLen = nameBytes / sizeof(WCHAR);
+	PyObject *ret = PyTuple_New(r->bResolve ? 8 : 7);
+	PyObject *obName = PyWinObject_FromWCHAR(name, nameLen);
+	if (ret == NULL || obFrn == NULL || obParent == NULL || obName == NULL)
+		goto error;
+	PyTuple_SET_ITEM(ret, 1, obFrn);
+	PyTuple_SET_ITEM(ret, 2, obParent);
+	PyTuple_SET_ITEM(ret, 6, obName);
+	obFrn = obParent = obName = NULL;
+	if (r->bResolve) {
+		// Records for the old name of a rename, or for a deletion, don't replace the cached name.
+		if ((attributes & FILE_ATTRIBUTE_DIRECTORY) && frn && parent
+			&& !(reason & (USN_REASON_RENAME_OLD_NAME | USN_REASON_FILE_DELETE))
+			&& !usn_set_dir(r, frn, parent, name, nameLen, FALSE)) {
+			PyErr_NoMemory();
+			goto error;
+		}
+		PyObject *obPath;
+		if (parent)
+			obPath = usn_resolve(r, parent, name, nameLen);
+		else {
+			obPath = Py_None;
+			Py_INCREF(obPath);
+		}
+		if (obPath == NULL)
+			goto error;
+		PyTuple_SET_ITEM(ret, 7, obPath);
+	}
+	PyTuple_SET_ITEM(ret, 0, PyLong_FromLongLong(usn));
+	PyTuple_SET_ITEM(ret, 3, PyLong_FromUnsignedLong(reason));
+	PyTuple_SET_ITEM(ret, 4, PyLong_FromLongLong(timeStamp));
+	PyTuple_SET_ITEM(ret, 5, PyLong_FromUnsignedLong(attributes));
+	if (PyTuple_GET_ITEM(ret, 0) == NULL || PyTuple_GET_ITEM(ret, 3) == NULL
+		|| PyTuple_GET_ITEM(ret, 4) == NULL || PyTuple_GET_ITEM(ret, 5) == NULL)
+		goto error;
+	return ret;
+error:
+	Py_XDECREF(ret);
+	Py_XDECREF(obFrn);
+	Py_XDECREF(obParent);
+	Py_XDECREF(obName);
+	return NULL;
+}
+
+static void usn_close(PyUsnJournalReader *r)
+{
+	if (r->hVolume == INVALID_HANDLE_VALUE)
+		return;
+	if (r->bOwnHandle)
+		CloseHandle(r->hVolume);
+	r->hVolume = INVALID_HANDLE_VALUE;
+}
+
+// Returns the records from the next read which returns any, or an empty list
+// once the reader has caught up (or, with bWait, blocks until there are some).
+static PyObject *usn_do_read_batch(PyUsnJournalReader *r, BOOL bWait)
+{
+	PyObject *ret = PyList_New(0);
+	if (ret == NULL)
+		return NULL;
+	while (!r->bDone) {
+		DWORD nbytes = 0, err = 0;
+		BOOL ok;
+		Py_BEGIN_ALLOW_THREADS
+		for (;;) {
+			if (r->bEnum) {
+				MFT_ENUM_DATA_V1 med = {0};
+				med.StartFileReferenceNumber = r->nextFrn;
+				med.LowUsn = 0;
+				med.HighUsn = r->nextUsn;
+				med.MinMajorVersion = 2;
+				med.MaxMajorVersion = 3;
+				ok = DeviceIoControl(r->hVolume, FSCTL_ENUM_USN_DATA, &med,
+					r->bV0 ? sizeof(MFT_ENUM_DATA_V0) : sizeof(med), r->buf, r->bufSize, &nbytes, NULL);
+			} else {
+				READ_USN_JOURNAL_DATA_V1 rd = {0};
+				rd.StartUsn = r->nextUsn;
+				rd.ReasonMask = r->reasonMask;
+				rd.ReturnOnlyOnClose = r->bReturnOnlyOnClose;
+				rd.BytesToWaitFor = bWait ? 1 : 0;
+				rd.UsnJournalID = r->journalId;
+				rd.MinMajorVersion = 2;
+				rd.MaxMajorVersion = 3;
+				ok = DeviceIoControl(r->hVolume, FSCTL_READ_USN_JOURNAL, &rd,
+					r->bV0 ? sizeof(READ_USN_JOURNAL_DATA_V0) : sizeof(rd), r->buf, r->bufSize, &nbytes, NULL);
+			}
+			if (ok)
+				break;
+			err = GetLastError();
+			// Before Windows 8 only the version 0 structures are accepted.
+			if (err != ERROR_INVALID_PARAMETER || r->bV0)
+				break;
+			r->bV0 = TRUE;
+		}
+		Py_END_ALLOW_THREADS
+		if (r->bClosePending)
+			break;
+		if (!ok) {
+			if (r->bEnum && err == ERROR_HANDLE_EOF) {
+				r->bDone = TRUE;
+				break;
+			}
+			Py_DECREF(ret);
+			return PyWin_SetAPIError(r->bEnum ? "DeviceIoControl(FSCTL_ENUM_USN_DATA)" : "DeviceIoControl(FSCTL_READ_USN_JOURNAL)", err);
+		}
+		r->reads++;
+		if (nbytes < sizeof(USN))
+			break;
+		// The output starts with where the next read should start.
+		ULONGLONG next;
+		memcpy(&next, r->buf, sizeof(next));
+		DWORD offset = sizeof(USN);
+		while (offset + sizeof(USN_RECORD_COMMON_HEADER) <= nbytes) {
+			USN_RECORD_COMMON_HEADER *hdr = (USN_RECORD_COMMON_HEADER *)(r->buf + offset);
+			if (hdr->RecordLength == 0 || offset + hdr->RecordLength > nbytes)
+				break;
+			if (hdr->MajorVersion == 2 || hdr->MajorVersion == 3) {
+				PyObject *rec = usn_decode_record(r, hdr);
+				if (rec == NULL || PyList_Append(ret, rec) == -1) {
+					Py_XDECREF(rec);
+					Py_DECREF(ret);
+					return NULL;
+				}
+				Py_DECREF(rec);
+				r->records++;
+			}
+			offset += hdr->RecordLength;
+		}
+		BOOL bMoved;
+		if (r->bEnum) {
+			bMoved = next != r->nextFrn;
+			r->nextFrn = next;
+		} else {
+			bMoved = (LONGLONG)next != r->nextUsn;
+			r->nextUsn = (LONGLONG)next;
+		}
+		// All the records in a read may have been filtered out by reasonMask.
+		if (PyList_GET_SIZE(ret) || !bMoved)
+			break;
+	}
+	return ret;
+}
+
+// The GIL is released during reads and path lookups, so other threads are kept
+// out until they finish.
+static BOOL usn_enter(PyUsnJournalReader *r)
+{
+	if (r->hVolume == INVALID_HANDLE_VALUE) {
+		PyErr_Format(PyExc_ValueError, "The reader has been closed");
+		return FALSE;
+	}
+	if (r->bBusy) {
+		PyErr_Format(PyExc_ValueError, "The reader is in use by another thread");
+		return FALSE;
+	}
+	r->bBusy = TRUE;
+	r->busyThreadId = GetCurrentThreadId();
+	return TRUE;
+}
+
+static PyObject *usn_leave(PyUsnJournalReader *r, PyObject *ret)
+{
+	r->bBusy = FALSE;
+	if (r->bClosePending) {
+		usn_close(r);
+		Py_XDECREF(ret);
+		return PyErr_Format(PyExc_ValueError, "The reader has been closed");
+	}
+	return ret;
+}
+
+static PyObject *usn_read_batch(PyUsnJournalReader *r, BOOL bWait)
+{
+	if (!usn_enter(r))
+		return NULL;
+	return usn_leave(r, usn_do_read_batch(r, bWait));
+}
+
+static void usn_dealloc(PyObject *ob)
+{
+	PyUsnJournalReader *r = (PyUsnJournalReader *)ob;
+	usn_close(r);
+	usn_clear_dirs(r);
+	free(r->buf);
+	free(r->pathBuf);
+	PyObject_Del(ob);
+}
+
+// @pymethod [tuple, ...]|PyUsnJournalReader|ReadBatch|Reads the next batch of records.
+// @rdesc The result is an empty list if there are no new records, or if the
+// enumeration is complete.
+static PyObject *usn_ReadBatch(PyObject *self, PyObject *args)
+{
+	BOOL bWait = FALSE;
+	if (!PyArg_ParseTuple(args, "|i:ReadBatch",
+		&bWait)) // @pyparm boolean|wait|False|If True, a journal read blocks until there is at least one new record.  <om PyUsnJournalReader.Close> from another thread cancels the wait.
+		return NULL;
+	return usn_read_batch((PyUsnJournalReader *)self, bWait);
+}
+
+static PyObject *usn_iternext(PyObject *self)
+{
+	PyObject *ret = usn_read_batch((PyUsnJournalReader *)self, FALSE);
+	if (ret && PyList_GET_SIZE(ret) == 0) {
+		Py_DECREF(ret);
+		return NULL;
+	}
+	return ret;
+}
+
+// @pymethod str|PyUsnJournalReader|ResolvePath|Returns the path of a file or directory relative to the volume root.
+// @rdesc None if the path can't be determined, for example because the file has been deleted.
+static PyObject *usn_ResolvePath(PyObject *self, PyObject *args)
+{
+	PyUsnJournalReader *r = (PyUsnJournalReader *)self;
+	ULONGLONG frn;
+	if (!PyArg_ParseTuple(args, "K:ResolvePath",
+		&frn)) // @pyparm int|fileReferenceNumber||The file reference number from a record.
+		return NULL;
+	if (frn == 0) {
+		Py_INCREF(Py_None);
+		return Py_None;
+	}
+	if (!usn_enter(r))
+		return NULL;
+	return usn_leave(r, usn_resolve(r, frn, NULL, 0));
+}
+
+// @pymethod |PyUsnJournalReader|Close|Closes the volume handle, if it was opened by the reader.
+// @comm A thread blocked in <om PyUsnJournalReader.ReadBatch> raises ValueError.
+static PyObject *usn_Close(PyObject *self, PyObject *args)
+{
+	PyUsnJournalReader *r = (PyUsnJournalReader *)self;
+	if (!PyArg_ParseTuple(args, ":Close"))
+		return NULL;
+	if (r->bBusy) {
+		// The reading thread closes the handle once the read is cancelled.
+		r->bClosePending = TRUE;
+		HANDLE hThread = OpenThread(THREAD_TERMINATE, FALSE, r->busyThreadId);
+		if (hThread) {
+			CancelSynchronousIo(hThread);
+			CloseHandle(hThread);
+		}
+	} else
+		usn_close(r);
+	Py_INCREF(Py_None);
+	return Py_None;
 }
-PyCFunction pfnpy_SetFileInformationByHandle=(PyCFunction)py_SetFileInformationByHandle;
-%}
 
-%{
-// @pyswig <o PyHANDLE>|ReOpenFile|Creates a new handle to an open file
-// @comm Available on Vista and later.
+static PyMethodDef usn_methods[] = {
+	{"ReadBatch", usn_ReadBatch, METH_VARARGS}, // @pymeth ReadBatch|Reads the next batch of records.
+	{"ResolvePath", usn_ResolvePath, METH_VARARGS}, // @pymeth ResolvePath|Returns the path of a file or directory.
+	{"Close", usn_Close, METH_VARARGS}, // @pymeth Close|Closes the reader.
+	{NULL}
+};
+
+#undef OFF
+#define OFF(e) offsetof(PyUsnJournalReader, e)
+static PyMemberDef usn_members[] = {
+	{"journalId", T_ULONGLONG, OFF(journalId), READONLY}, // @prop int|journalId|The id of the journal being read.
+	{"firstUsn", T_LONGLONG, OFF(firstUsn), READONLY}, // @prop int|firstUsn|The first USN in the journal when the reader was created.
+	{"nextUsn", T_LONGLONG, OFF(nextUsn), READONLY}, // @prop int|nextUsn|Where the next journal read starts.  When enumerating, the end of the journal when the reader was created, from which a journal reader can continue once the enumeration is complete.
+	{"records", T_LONGLONG, OFF(records), READONLY}, // @prop int|records|The number of records returned.
+	{"reads", T_LONG, OFF(reads), READONLY}, // @prop int|reads|The number of FSCTL_READ_USN_JOURNAL or FSCTL_ENUM_USN_DATA calls made.
+	{"lookups", T_LONG, OFF(lookups), READONLY}, // @prop int|lookups|The number of directories looked up from the file system when resolving paths.
+	{"cachedDirectories", T_ULONG, OFF(numDirs), READONLY}, // @prop int|cachedDirectories|The number of directories in the path cache.
+	{NULL}
+};
+#undef OFF
+
+PyTypeObject PyUsnJournalReader_Type = {
+	PYWIN_OBJECT_HEAD
+	"PyUsnJournalReader",			/* tp_name */
+	sizeof(PyUsnJournalReader),		/* tp_basicsize */
+	0,					/* tp_itemsize */
+	usn_dealloc,				/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	0,					/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	PyObject_SelfIter,			/* tp_iter */
+	usn_iternext,				/* tp_iternext */
+	usn_methods,				/* tp_methods */
+	usn_members,				/* tp_members */
+	0,					/* tp_getset */
+};
+
+// @pyswig <o PyUsnJournalReader>|CreateUsnJournalReader|Opens the change journal of a volume for reading.
 // @comm Accepts keyword args.
-static PyObject *py_ReOpenFile(PyObject *self, PyObject *args, PyObject *kwargs)
+// @comm Reading the journal requires administrative rights, and the journal
+// must be active - see FSCTL_CREATE_USN_JOURNAL.
+static PyObject *py_CreateUsnJournalReader(PyObject *self, PyObject *args, PyObject *kwargs)
 {
-	CHECK_PFN(ReOpenFile);
-	static char *keywords[] = {"OriginalFile", "DesiredAccess", "ShareMode", "Flags", NULL};
-	HANDLE horig, hret;
-	DWORD DesiredAccess, ShareMode, Flags;			
-	// @pyparm <o PyHANDLE>|OriginalFile||An open file handle
-	// @pyparm int|DesiredAccess||Access mode, cannot conflict with original access mode
-	// @pyparm int|ShareMode||Sharing mode (FILE_SHARE_*), cannot conflict with original share mode
-	// @pyparm int|Flags||Combination of FILE_FLAG_* flags
-	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&kkk:ReOpenFile", keywords,
-		PyWinObject_AsHANDLE, &horig, &DesiredAccess, &ShareMode, &Flags))
+	static char *keywords[] = {"volume", "startUsn", "reasonMask", "returnOnlyOnClose",
+		"enumerate", "resolvePaths", "bufSize", NULL};
+	PyObject *obVolume, *obStartUsn = Py_None;
+	DWORD reasonMask = 0xFFFFFFFF, bufSize = 1024 * 1024;
+	BOOL bReturnOnlyOnClose = FALSE, bEnum = FALSE, bResolve = FALSE;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|Okiiik:CreateUsnJournalReader", keywords,
+		&obVolume, // @pyparm str/<o PyHANDLE>|volume||The volume, for example "\\\\.\\C:", or an open handle to it.  A handle is not closed by the reader.
+		&obStartUsn, // @pyparm int|startUsn|None|The USN to start reading from.  The default is the end of the journal, so only changes made after the reader is created are returned.  Use 0 to read the whole journal.
+		&reasonMask, // @pyparm int|reasonMask|0xFFFFFFFF|Only records with one of these USN_REASON_* flags are returned.
+		&bReturnOnlyOnClose, // @pyparm boolean|returnOnlyOnClose|False|If True, only the record written when the last handle to a file is closed is returned.
+		&bEnum, // @pyparm boolean|enumerate|False|If True, the files and directories on the volume are enumerated with FSCTL_ENUM_USN_DATA instead of reading the journal.  startUsn and the filters are ignored.
+		&bResolve, // @pyparm boolean|resolvePaths|False|If True, each record includes its path relative to the volume root.
+		&bufSize)) // @pyparm int|bufSize|1048576|The size of the output buffer.  Each read returns as many records as fit.
+		return NULL;
+	if (bufSize < 4096)
+		return PyErr_Format(PyExc_ValueError, "bufSize must be at least 4096");
+	LONGLONG startUsn = 0;
+	if (obStartUsn != Py_None) {
+		startUsn = PyLong_AsLongLong(obStartUsn);
+		if (startUsn == -1 && PyErr_Occurred())
+			return NULL;
+	}
+	HANDLE hVolume;
+	BOOL bOwnHandle = PyUnicode_Check(obVolume) || PyBytes_Check(obVolume);
+	if (bOwnHandle) {
+		WCHAR *path;
+		if (!PyWinObject_AsWCHAR(obVolume, &path, FALSE))
+			return NULL;
+		Py_BEGIN_ALLOW_THREADS
+		hVolume = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+		Py_END_ALLOW_THREADS
+		PyWinObject_FreeWCHAR(path);
+		if (hVolume == INVALID_HANDLE_VALUE)
+			return PyWin_SetAPIError("CreateFile");
+	} else if (!PyWinObject_AsHANDLE(obVolume, &hVolume))
 		return NULL;
-
+	PyUsnJournalReader *r = PyObject_New(PyUsnJournalReader, &PyUsnJournalReader_Type);
+	if (r == NULL) {
+		if (bOwnHandle)
+			CloseHandle(hVolume);
+		return NULL;
+	}
+	memset(((BYTE *)r) + sizeof(PyObject), 0, sizeof(PyUsnJournalReader) - sizeof(PyObject));
+	r->hVolume = hVolume;
+	r->bOwnHandle = bOwnHandle;
+	r->bEnum = bEnum;
+	r->bResolve = bResolve;
+	r->reasonMask = reasonMask;
+	r->bReturnOnlyOnClose = bReturnOnlyOnClose;
+	r->bufSize = bufSize;
+	r->buf = (BYTE *)malloc(bufSize);
+	if (r->buf == NULL) {
+		Py_DECREF(r);
+		return PyErr_NoMemory();
+	}
+	USN_JOURNAL_DATA_V0 jd;
+	DWORD nbytes;
+	BOOL ok;
 	Py_BEGIN_ALLOW_THREADS
-	hret = (*pfnReOpenFile)(horig, DesiredAccess, ShareMode, Flags);
-	// hret = ReOpenFile(horig, DesiredAccess, ShareMode, Flags);
+	ok = DeviceIoControl(hVolume, FSCTL_QUERY_USN_JOURNAL, NULL, 0, &jd, sizeof(jd), &nbytes, NULL);
 	Py_END_ALLOW_THREADS
-	if (hret == INVALID_HANDLE_VALUE)
-		return PyWin_SetAPIError("ReOpenFile");
-	return PyWinObject_FromHANDLE(hret);
+	if (!ok) {
+		PyWin_SetAPIError("DeviceIoControl(FSCTL_QUERY_USN_JOURNAL)");
+		Py_DECREF(r);
+		return NULL;
+	}
+	r->journalId = jd.UsnJournalID;
+	r->firstUsn = jd.FirstUsn;
+	r->nextUsn = (obStartUsn == Py_None || bEnum) ? jd.NextUsn : startUsn;
+	return (PyObject *)r;
 }
-PyCFunction pfnpy_ReOpenFile=(PyCFunction)py_ReOpenFile;
+PyCFunction pfnpy_CreateUsnJournalReader=(PyCFunction)py_CreateUsnJournalReader;
 %}
 
+// @object PySequentialReader|Reads a file from start to end with several reads in
+// flight, as returned by <om win32file.CreateSequentialReader>.
+// @comm The reader keeps numReads overlapped reads of chunkSize bytes queued ahead of
+// the caller, so the disk is busy while the previous chunk is being processed.  The
+// chunk size and the file offset of every read are a multiple of the sector size and
+// the buffers are page aligned, so the file can be opened with FILE_FLAG_NO_BUFFERING
+// and read without going through the system cache.
+// <nl>Each chunk is returned as a read-only memoryview over one of the reader's buffers,
+// which goes back to the reader when nothing references it any more - keep a reference
+// only as long as the data is needed, or copy it with bytes().  There are numReads+2
+// buffers, so holding on to the most recent chunk while fetching the next one doesn't
+// cost a read in flight.
+// <nl>Chunks are returned by <om PySequentialReader.Read>, or by iterating over the object.
 %{
-// @pyswig <o PyHANDLE>|OpenFileById|Opens a file by File Id or Object Id
-// @comm Available on Vista and later.
+#define SEQREAD_FREE 0
+#define SEQREAD_QUEUED 1	// a read has been issued into the buffer
+#define SEQREAD_HELD 2		// returned as a chunk which is still referenced
+
+typedef struct {
+	OVERLAPPED ov;
+	BYTE *buf;
+	LONGLONG offset;	// the file offset of buf[0]
+	DWORD state;
+	DWORD err;		// the read failed as it was issued
+} PySeqReadSlot;
+
+typedef struct {
+	PyObject_HEAD
+	HANDLE hFile;		// NULL once closed
+	BOOL bOwnHandle;
+	BOOL bBusy;		// a read is in progress, possibly on another thread
+	BOOL bClosePending;	// Close was called during a read
+	DWORD chunkSize;
+	DWORD numReads;		// the reads kept in flight
+	DWORD sectorSize;
+	DWORD numSlots;
+	BYTE *mem;		// the buffers of all the slots
+	PySeqReadSlot *slots;
+	DWORD *queue;		// the slots with reads issued, in file order
+	DWORD queueHead;
+	DWORD queueCount;
+	LONGLONG end;		// reading stops at this offset
+	LONGLONG nextRead;	// the offset of the next read to issue
+	LONGLONG position;	// the offset following the last chunk returned
+	DWORD err;		// a read failed, and the reader is finished
+	LONGLONG bytesRead;	// statistics
+	LONG chunks;
+	LONG stalls;
+} PySequentialReader;
+
+typedef struct {
+	PyObject_HEAD
+	PySequentialReader *reader;
+	PySeqReadSlot *slot;
+	BYTE *data;
+	DWORD len;
+} PySequentialChunk;
+
+extern PyTypeObject PySequentialReader_Type;
+extern PyTypeObject PySequentialChunk_Type;
+
+// Queue reads into the free buffers until numReads are in flight.
+static void seq_submit(PySequentialReader *r)
+{
+	for (DWORD i = 0; i < r->numSlots && r->queueCount < r->numReads && r->nextRead < r->end; i++) {
+		PySeqReadSlot *s = r->slots + i;
+		if (s->state != SEQREAD_FREE)
+			continue;
+		s->offset = r->nextRead;
+		r->nextRead += r->chunkSize;
+		s->ov.Internal = s->ov.InternalHigh = 0;
+		s->ov.Offset = (DWORD)s->offset;
+		s->ov.OffsetHigh = (DWORD)(s->offset >> 32);
+		ResetEvent(s->ov.hEvent);
+		s->err = 0;
+		if (!ReadFile(r->hFile, s->buf, r->chunkSize, NULL, &s->ov)) {
+			DWORD err = GetLastError();
+			if (err != ERROR_IO_PENDING)
+				s->err = err;
+		}
+		s->state = SEQREAD_QUEUED;
+		r->queue[(r->queueHead + r->queueCount++) % r->numSlots] = i;
+	}
+}
+
+// Cancel the queued reads and wait for them to finish with the buffers.
+static void seq_cancel(PySequentialReader *r)
+{
+	for (; r->queueCount; r->queueCount--, r->queueHead = (r->queueHead + 1) % r->numSlots) {
+		PySeqReadSlot *s = r->slots + r->queue[r->queueHead];
+		if (s->err == 0) {
+			DWORD n;
+			CancelIoEx(r->hFile, &s->ov);
+			Py_BEGIN_ALLOW_THREADS
+			GetOverlappedResult(r->hFile, &s->ov, &n, TRUE);
+			Py_END_ALLOW_THREADS
+		}
+		s->state = SEQREAD_FREE;
+	}
+}
+
+static void seq_close(PySequentialReader *r)
+{
+	if (r->hFile == NULL)
+		return;
+	seq_cancel(r);
+	if (r->bOwnHandle)
+		CloseHandle(r->hFile);
+	r->hFile = NULL;
+	r->bClosePending = FALSE;
+}
+
+// Returns the next chunk, or None at the end of the file.
+static PyObject *seq_read(PySequentialReader *r)
+{
+	if (r->hFile == NULL)
+		return PyErr_Format(PyExc_ValueError, "The reader is closed");
+	if (r->bBusy)
+		return PyErr_Format(PyExc_ValueError, "The reader is already being read by another thread");
+	if (r->err)
+		return PyWin_SetAPIError("ReadFile", r->err);
+	r->bBusy = TRUE;
+	seq_submit(r);
+	PyObject *ret = NULL;
+	while (r->queueCount) {
+		PySeqReadSlot *s = r->slots + r->queue[r->queueHead];
+		DWORD err = s->err, n = 0;
+		if (err == 0) {
+			BOOL ok;
+			if (!HasOverlappedIoCompleted(&s->ov))
+				r->stalls++;
+			Py_BEGIN_ALLOW_THREADS
+			ok = GetOverlappedResult(r->hFile, &s->ov, &n, TRUE);
+			Py_END_ALLOW_THREADS
+			if (!ok)
+				err = GetLastError();
+		}
+		r->queueHead = (r->queueHead + 1) % r->numSlots;
+		r->queueCount--;
+		s->state = SEQREAD_FREE;
+		if (r->bClosePending) {
+			seq_close(r);
+			PyErr_Format(PyExc_ValueError, "The reader was closed");
+			goto done;
+		}
+		if (err == ERROR_HANDLE_EOF)
+			err = n = 0;
+		if (err) {
+			r->err = err;
+			seq_cancel(r);
+			PyWin_SetAPIError("ReadFile", err);
+			goto done;
+		}
+		// A short read means the file is now shorter than when the reader was created.
+		if (n < r->chunkSize && s->offset + n < r->end)
+			r->end = s->offset + n;
+		LONGLONG lo = max(r->position, s->offset);
+		LONGLONG hi = min(s->offset + n, r->end);
+		if (hi <= lo)
+			continue;
+		PySequentialChunk *chunk = PyObject_New(PySequentialChunk, &PySequentialChunk_Type);
+		if (chunk == NULL)
+			goto done;
+		Py_INCREF(r);
+		chunk->reader = r;
+		chunk->slot = s;
+		chunk->data = s->buf + (lo - s->offset);
+		chunk->len = (DWORD)(hi - lo);
+		s->state = SEQREAD_HELD;
+		r->position = hi;
+		r->bytesRead += chunk->len;
+		r->chunks++;
+		seq_submit(r);
+		ret = PyMemoryView_FromObject((PyObject *)chunk);
+		Py_DECREF(chunk);  // the memoryview keeps its own reference.
+		goto done;
+	}
+	if (r->nextRead < r->end)
+		PyErr_Format(PyExc_BufferError, "All of the reader's buffers are held by chunks which are still referenced");
+	else {
+		Py_INCREF(Py_None);
+		ret = Py_None;
+	}
+done:
+	r->bBusy = FALSE;
+	return ret;
+}
+
+static void seqc_dealloc(PyObject *ob)
+{
+	PySequentialChunk *chunk = (PySequentialChunk *)ob;
+	chunk->slot->state = SEQREAD_FREE;
+	PySequentialReader *r = chunk->reader;
+	PyObject_Del(ob);
+	Py_DECREF(r);
+}
+
+static int seqc_getbuffer(PyObject *ob, Py_buffer *view, int flags)
+{
+	PySequentialChunk *chunk = (PySequentialChunk *)ob;
+	return PyBuffer_FillInfo(view, ob, chunk->data, chunk->len, 1, flags);
+}
+
+static PyBufferProcs seqc_as_buffer = {
+	seqc_getbuffer,		/* bf_getbuffer */
+	0,			/* bf_releasebuffer */
+};
+
+PyTypeObject PySequentialChunk_Type = {
+	PYWIN_OBJECT_HEAD
+	"PySequentialChunk",			/* tp_name */
+	sizeof(PySequentialChunk),		/* tp_basicsize */
+	0,					/* tp_itemsize */
+	seqc_dealloc,				/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	0,					/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	&seqc_as_buffer,			/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+};
+
+static void seq_dealloc(PyObject *ob)
+{
+	// Every chunk holds a reference, so none of the buffers are in use.
+	PySequentialReader *r = (PySequentialReader *)ob;
+	seq_close(r);
+	if (r->slots) {
+		for (DWORD i = 0; i < r->numSlots; i++)
+			if (r->slots[i].ov.hEvent)
+				CloseHandle(r->slots[i].ov.hEvent);
+		free(r->slots);
+	}
+	free(r->queue);
+	if (r->mem)
+		VirtualFree(r->mem, 0, MEM_RELEASE);
+	PyObject_Del(ob);
+}
+
+// @pymethod memoryview|PySequentialReader|Read|Returns the next chunk of the file.
+// @rdesc A read-only memoryview, or None at the end of the file.  Chunks are at most
+// chunkSize bytes, and the first and last may be shorter.
+// @comm BufferError is raised if every buffer is still referenced by an earlier chunk.
+static PyObject *seq_Read(PyObject *self, PyObject *args)
+{
+	if (!PyArg_ParseTuple(args, ":Read"))
+		return NULL;
+	return seq_read((PySequentialReader *)self);
+}
+
+static PyObject *seq_iternext(PyObject *self)
+{
+	PyObject *ret = seq_read((PySequentialReader *)self);
+	if (ret == Py_None) {
+		Py_DECREF(ret);
+		return NULL;
+	}
+	return ret;
+}
+
+// @pymethod |PySequentialReader|Close|Cancels the reads in flight and closes the file, if it was opened by the reader.
+// @comm A thread blocked in <om PySequentialReader.Read> raises ValueError.  Chunks already
+// returned remain valid.
+static PyObject *seq_Close(PyObject *self, PyObject *args)
+{
+	PySequentialReader *r = (PySequentialReader *)self;
+	if (!PyArg_ParseTuple(args, ":Close"))
+		return NULL;
+	if (r->bBusy) {
+		// The reading thread closes the handle once its read is cancelled.
+		r->bClosePending = TRUE;
+		CancelIoEx(r->hFile, NULL);
+	} else
+		seq_close(r);
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+static PyMethodDef seq_methods[] = {
+	{"Read", seq_Read, METH_VARARGS}, // @pymeth Read|Returns the next chunk of the file.
+	{"Close", seq_Close, METH_VARARGS}, // @pymeth Close|Closes the reader.
+	{NULL}
+};
+
+#undef OFF
+#define OFF(e) offsetof(PySequentialReader, e)
+static PyMemberDef seq_members[] = {
+	{"chunkSize", T_ULONG, OFF(chunkSize), READONLY}, // @prop int|chunkSize|The size of each read, a multiple of the sector size.
+	{"numReads", T_ULONG, OFF(numReads), READONLY}, // @prop int|numReads|The number of reads kept in flight.
+	{"sectorSize", T_ULONG, OFF(sectorSize), READONLY}, // @prop int|sectorSize|The sector size reads are aligned to.
+	{"position", T_LONGLONG, OFF(position), READONLY}, // @prop int|position|The file offset following the last chunk returned.
+	{"end", T_LONGLONG, OFF(end), READONLY}, // @prop int|end|The file offset reading stops at.
+	{"bytesRead", T_LONGLONG, OFF(bytesRead), READONLY}, // @prop int|bytesRead|The number of bytes returned in chunks.
+	{"chunks", T_LONG, OFF(chunks), READONLY}, // @prop int|chunks|The number of chunks returned.
+	{"stalls", T_LONG, OFF(stalls), READONLY}, // @prop int|stalls|The number of chunks which had to be waited for because their read had not completed.  If this is close to chunks, the caller is faster than the disk - more reads in flight may help.
+	{NULL}
+};
+#undef OFF
+
+PyTypeObject PySequentialReader_Type = {
+	PYWIN_OBJECT_HEAD
+	"PySequentialReader",			/* tp_name */
+	sizeof(PySequentialReader),		/* tp_basicsize */
+	0,					/* tp_itemsize */
+	seq_dealloc,				/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	0,					/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	PyObject_SelfIter,			/* tp_iter */
+	seq_iternext,				/* tp_iternext */
+	seq_methods,				/* tp_methods */
+	seq_members,				/* tp_members */
+	0,					/* tp_getset */
+};
+
+// @pyswig <o PySequentialReader>|CreateSequentialReader|Opens a file for sequential reading with several reads in flight.
 // @comm Accepts keyword args.
-static PyObject *py_OpenFileById(PyObject *self, PyObject *args, PyObject *kwargs)
+// @comm The end of the file is taken from its size when the reader is created.
+static PyObject *py_CreateSequentialReader(PyObject *self, PyObject *args, PyObject *kwargs)
 {
-	CHECK_PFN(OpenFileById);
-	static char *keywords[] = {"File", "FileID", "DesiredAccess", "ShareMode",
-		"Flags", "SecurityAttributes", NULL};
-	HANDLE hvol, hret;
-	DWORD DesiredAccess, ShareMode, Flags;
-	PyObject *obsa = Py_None;
-	PSECURITY_ATTRIBUTES sa;
-	PyObject *obfileid;
-	FILE_ID_DESCRIPTOR fileid = {sizeof(FILE_ID_DESCRIPTOR)};
+	static char *keywords[] = {"fileName", "chunkSize", "numReads", "offset", "length", "unbuffered", NULL};
+	PyObject *obFileName, *obLength = Py_None;
+	DWORD chunkSize = 1024 * 1024, numReads = 4;
+	LONGLONG offset = 0;
+	BOOL bUnbuffered = TRUE;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|kkLOi:CreateSequentialReader", keywords,
+		&obFileName, // @pyparm str/<o PyHANDLE>|fileName||The file to read, or a handle to it.  A handle must have been opened with FILE_FLAG_OVERLAPPED, and is not closed by the reader.
+		&chunkSize, // @pyparm int|chunkSize|1048576|The size of each read.  This is rounded up to a multiple of the sector size.
+		&numReads, // @pyparm int|numReads|4|The number of reads to keep in flight.
+		&offset, // @pyparm int|offset|0|The file offset to start reading at.  It need not be aligned.
+		&obLength, // @pyparm int|length|None|The number of bytes to read, or None to read to the end of the file.
+		&bUnbuffered)) // @pyparm boolean|unbuffered|True|If True, a file opened by name is opened with FILE_FLAG_NO_BUFFERING, so the data is not cached.  Otherwise it is opened with FILE_FLAG_SEQUENTIAL_SCAN.
+		return NULL;
+	if (chunkSize == 0 || chunkSize > 0x40000000)
+		return PyErr_Format(PyExc_ValueError, "chunkSize must be between 1 and 0x40000000");
+	if (numReads == 0 || numReads > 64)
+		return PyErr_Format(PyExc_ValueError, "numReads must be between 1 and 64");
+	if (offset < 0)
+		return PyErr_Format(PyExc_ValueError, "offset can't be negative");
+	LONGLONG length = -1;
+	if (obLength != Py_None) {
+		length = PyLong_AsLongLong(obLength);
+		if (length == -1 && PyErr_Occurred())
+			return NULL;
+		if (length < 0)
+			return PyErr_Format(PyExc_ValueError, "length can't be negative");
+	}
+	HANDLE hFile;
+	BOOL bOwnHandle = PyUnicode_Check(obFileName) || PyBytes_Check(obFileName);
+	if (bOwnHandle) {
+		WCHAR *fileName;
+		if (!PyWinObject_AsWCHAR(obFileName, &fileName, FALSE))
+			return NULL;
+		DWORD flags = FILE_FLAG_OVERLAPPED | (bUnbuffered ? FILE_FLAG_NO_BUFFERING : FILE_FLAG_SEQUENTIAL_SCAN);
+		Py_BEGIN_ALLOW_THREADS
+		hFile = CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+			OPEN_EXISTING, flags, NULL);
+		Py_END_ALLOW_THREADS
+		PyWinObject_FreeWCHAR(fileName);
+		if (hFile == INVALID_HANDLE_VALUE)
+			return PyWin_SetAPIError("CreateFile");
+	} else if (!PyWinObject_AsHANDLE(obFileName, &hFile))
+		return NULL;
+	PySequentialReader *r = PyObject_New(PySequentialReader, &PySequentialReader_Type);
+	if (r == NULL) {
+		if (bOwnHandle)
+			CloseHandle(hFile);
+		return NULL;
+	}
+	memset(((BYTE *)r) + sizeof(PyObject), 0, sizeof(PySequentialReader) - sizeof(PyObject));
+	r->hFile = hFile;
+	r->bOwnHandle = bOwnHandle;
+	r->numReads = numReads;
+	r->numSlots = numReads + 2;
 
-	// @pyparm <o PyHANDLE>|File||Handle to a file on the volume that contains the file to open
-	// @pyparm int/<o PyIID>|FileId||File Id or Object Id of the file to open
-	// @pyparm int|DesiredAccess||Access mode
-	// @pyparm int|ShareMode||Sharing mode (FILE_SHARE_*)
-	// @pyparm int|Flags||Combination of FILE_FLAG_* flags
-	// @pyparm <o PySECURITY_ATTRIBUTES>|SecurityAttributes|None|Reserved, use only None
-	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O&Okkk|O:OpenFileById", keywords,
-		PyWinObject_AsHANDLE, &hvol, &obfileid, &DesiredAccess, &ShareMode, &Flags, &obsa))
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(hFile, &size)) {
+		PyWin_SetAPIError("GetFileSizeEx");
+		Py_DECREF(r);
 		return NULL;
-	if (!PyWinObject_AsSECURITY_ATTRIBUTES(obsa, &sa, TRUE))
+	}
+	r->end = size.QuadPart;
+	if (length >= 0 && offset + length < r->end)
+		r->end = offset + length;
+	// The physical sector size is what unbuffered I/O must be aligned to on
+	// Advanced Format disks; fall back to a page, which is a multiple of any
+	// sector size in use.
+	FILE_STORAGE_INFO si;
+	r->sectorSize = 4096;
+	if (GetFileInformationByHandleEx(hFile, FileStorageInfo, &si, sizeof(si))
+		&& si.PhysicalBytesPerSectorForPerformance != 0
+		&& (si.PhysicalBytesPerSectorForPerformance & (si.PhysicalBytesPerSectorForPerformance - 1)) == 0)
+		r->sectorSize = si.PhysicalBytesPerSectorForPerformance;
+	r->chunkSize = (chunkSize + r->sectorSize - 1) & ~(r->sectorSize - 1);
+	r->position = offset;
+	r->nextRead = offset & ~(LONGLONG)(r->sectorSize - 1);
+
+	// VirtualAlloc memory is page aligned, and each buffer is a whole number of sectors.
+	r->mem = (BYTE *)VirtualAlloc(NULL, (SIZE_T)r->chunkSize * r->numSlots, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+	if (r->mem == NULL) {
+		PyWin_SetAPIError("VirtualAlloc");
+		Py_DECREF(r);
 		return NULL;
-		
-	fileid.Type = FileIdType;
-	if (!PyWinObject_AsLARGE_INTEGER(obfileid, &fileid.FileId)){
-		PyErr_Clear();
-		fileid.Type = ObjectIdType;
-		if (!PyWinObject_AsIID(obfileid, &fileid.ObjectId)){
-			PyErr_Clear();
-			PyErr_SetString(PyExc_TypeError, "FileId must be an integer or GUID");
+	}
+	r->slots = (PySeqReadSlot *)calloc(r->numSlots, sizeof(PySeqReadSlot));
+	r->queue = (DWORD *)calloc(r->numSlots, sizeof(DWORD));
+	if (r->slots == NULL || r->queue == NULL) {
+		Py_DECREF(r);
+		return PyErr_NoMemory();
+	}
+	for (DWORD i = 0; i < r->numSlots; i++) {
+		r->slots[i].buf = r->mem + (SIZE_T)r->chunkSize * i;
+		r->slots[i].ov.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+		if (r->slots[i].ov.hEvent == NULL) {
+			PyWin_SetAPIError("CreateEvent");
+			Py_DECREF(r);
 			return NULL;
-			}
 		}
-
-	Py_BEGIN_ALLOW_THREADS
-	hret = (*pfnOpenFileById)(hvol, &fileid, DesiredAccess, ShareMode, sa, Flags);
-	// hret = OpenFileById(hvol, &fileid, DesiredAccess, ShareMode, sa, Flags);
-	Py_END_ALLOW_THREADS
-	if (hret == INVALID_HANDLE_VALUE)
-		return PyWin_SetAPIError("OpenFileById");
-	return PyWinObject_FromHANDLE(hret);
+	}
+	return (PyObject *)r;
 }
-PyCFunction pfnpy_OpenFileById=(PyCFunction)py_OpenFileById;
+PyCFunction pfnpy_CreateSequentialReader=(PyCFunction)py_CreateSequentialReader;
 %}
 
 
@@ -5983,8 +12362,10 @@ PyCFunction pfnpy_OpenFileById=(PyCFunction)py_OpenFileById;
 %native (BackupRead) py_BackupRead;
 %native (BackupSeek) py_BackupSeek;
 %native (BackupWrite) py_BackupWrite;
+%native (BackupPump) pfnpy_BackupPump;
 %native (SetFileShortName) py_SetFileShortName;
 %native (CopyFileEx) pfnpy_CopyFileEx;
+%native (CreateCopyJob) pfnpy_CreateCopyJob;
 %native (MoveFileWithProgress) pfnpy_MoveFileWithProgress;
 %native (ReplaceFile) py_ReplaceFile;
 %native (OpenEncryptedFileRaw) py_OpenEncryptedFileRaw;
@@ -5996,12 +12377,15 @@ PyCFunction pfnpy_OpenFileById=(PyCFunction)py_OpenFileById;
 %native (GetFileAttributesEx) pfnpy_GetFileAttributesEx;
 %native (GetFileAttributesExW) pfnpy_GetFileAttributesExW;
 %native (GetFileInformationByHandleEx) pfnpy_GetFileInformationByHandleEx;
+%native (GetDirectoryInformation) pfnpy_GetDirectoryInformation;
 %native (SetFileInformationByHandle) pfnpy_SetFileInformationByHandle;
 %native (SetFileAttributesW) pfnpy_SetFileAttributesW;
 %native (CreateDirectoryExW) pfnpy_CreateDirectoryExW;
 %native (RemoveDirectory) pfnpy_RemoveDirectory;
+%native (ApplyTransactedOperations) pfnpy_ApplyTransactedOperations;
 %native (FindFilesW) pfnpy_FindFilesW;
 %native (FindFilesIterator) pfnpy_FindFilesIterator;
+%native (WalkDirectoryTree) pfnpy_WalkDirectoryTree;
 %native (FindStreams) pfnpy_FindStreams;
 %native (FindFileNames) pfnpy_FindFileNames;
 %native (GetFinalPathNameByHandle) pfnpy_GetFinalPathNameByHandle;
@@ -6015,13 +12399,32 @@ PyCFunction pfnpy_OpenFileById=(PyCFunction)py_OpenFileById;
 %native (Wow64RevertWow64FsRedirection) py_Wow64RevertWow64FsRedirection;
 %native (ReOpenFile) pfnpy_ReOpenFile;
 %native (OpenFileById) pfnpy_OpenFileById;
+%native (CreateUsnJournalReader) pfnpy_CreateUsnJournalReader;
+%native (CreateSequentialReader) pfnpy_CreateSequentialReader;
 
 
 %init %{
 
 	if (PyType_Ready(&FindFileIterator_Type) == -1
+		||PyType_Ready(&PyTreeWalker_Type) == -1
+		||PyType_Ready(&PyDirectoryInformation_Type) == -1
+#ifndef MS_WINCE
+		||PyType_Ready(&PyOVERLAPPED_ENTRIES_Type) == -1
+		||PyType_Ready(&PyReadBufferPool_Type) == -1
+		||PyType_Ready(&PyReadBufferLease_Type) == -1
+		||PyRIO_InitTypes() == -1
+		||PyType_Ready(&PyCompletionReactor_Type) == -1
+#endif
+		||PyType_Ready(&PyDirectoryWatcher_Type) == -1
+		||PyType_Ready(&PyUsnJournalReader_Type) == -1
+		||PyType_Ready(&PySequentialReader_Type) == -1
+		||PyType_Ready(&PySequentialChunk_Type) == -1
+		||PyType_Ready(&PyIoctlDescriptor_Type) == -1
+		||PyType_Ready(&PyCopyJob_Type) == -1
+		||PyType_Ready(&PySocketSelector_Type) == -1
 		||PyType_Ready(&PyDCB::type) == -1
-		||PyType_Ready(&PyCOMSTAT::type) == -1)
+		||PyType_Ready(&PyCOMSTAT::type) == -1
+		||PyType_Ready(&PySerialReader_Type) == -1)
 		PYWIN_MODULE_INIT_RETURN_ERROR;
 
 	if (PyDict_SetItemString(d, "error", PyWinExc_ApiError) == -1)
@@ -6036,6 +12439,8 @@ PyCFunction pfnpy_OpenFileById=(PyCFunction)py_OpenFileById;
 			||(strcmp(pmd->ml_name, "DeleteFileW")==0)
 			||(strcmp(pmd->ml_name, "MoveFileWithProgress")==0)
 			||(strcmp(pmd->ml_name, "CopyFileEx")==0)
+			||(strcmp(pmd->ml_name, "CreateCopyJob")==0)
+			||(strcmp(pmd->ml_name, "BackupPump")==0)
 			||(strcmp(pmd->ml_name, "GetFileAttributesEx")==0)
 			||(strcmp(pmd->ml_name, "GetFileAttributesExW")==0)
 			||(strcmp(pmd->ml_name, "SetFileAttributesW")==0)
@@ -6043,8 +12448,10 @@ PyCFunction pfnpy_OpenFileById=(PyCFunction)py_OpenFileById;
 			||(strcmp(pmd->ml_name, "CreateSymbolicLink")==0)
 			||(strcmp(pmd->ml_name, "CreateDirectoryExW")==0)
 			||(strcmp(pmd->ml_name, "RemoveDirectory")==0)
+			||(strcmp(pmd->ml_name, "ApplyTransactedOperations")==0)
 			||(strcmp(pmd->ml_name, "FindFilesW")==0)
 			||(strcmp(pmd->ml_name, "FindFilesIterator")==0)
+			||(strcmp(pmd->ml_name, "WalkDirectoryTree")==0)
 			||(strcmp(pmd->ml_name, "FindStreams")==0)
 			||(strcmp(pmd->ml_name, "FindFileNames")==0)
 			||(strcmp(pmd->ml_name, "GetFinalPathNameByHandle")==0)
@@ -6057,12 +12464,17 @@ PyCFunction pfnpy_OpenFileById=(PyCFunction)py_OpenFileById;
 			||(strcmp(pmd->ml_name, "GetLongPathName")==0)
 			||(strcmp(pmd->ml_name, "GetFullPathName")==0)
 			||(strcmp(pmd->ml_name, "GetFileInformationByHandleEx")==0)
+			||(strcmp(pmd->ml_name, "GetDirectoryInformation")==0)
 			||(strcmp(pmd->ml_name, "SetFileInformationByHandle")==0)
 			||(strcmp(pmd->ml_name, "DeviceIoControl")==0)
+			||(strcmp(pmd->ml_name, "CreateIoctlDescriptor")==0)
 			||(strcmp(pmd->ml_name, "TransmitFile")==0)
+			||(strcmp(pmd->ml_name, "TransmitPackets")==0)
 			||(strcmp(pmd->ml_name, "ConnectEx")==0)
 			||(strcmp(pmd->ml_name, "ReOpenFile")==0)
 			||(strcmp(pmd->ml_name, "OpenFileById")==0)
+			||(strcmp(pmd->ml_name, "CreateUsnJournalReader")==0)
+			||(strcmp(pmd->ml_name, "CreateSequentialReader")==0)
 			||(strcmp(pmd->ml_name, "SetFileTime")==0)
 			)
 			pmd->ml_flags = METH_VARARGS | METH_KEYWORDS;
@@ -6108,6 +12520,7 @@ PyCFunction pfnpy_OpenFileById=(PyCFunction)py_OpenFileById;
 		pfnBackupWrite=(BackupWritefunc)GetProcAddress(hmodule,"BackupWrite");
 		pfnSetFileShortName=(SetFileShortNamefunc)GetProcAddress(hmodule,"SetFileShortNameW");
 		pfnCopyFileEx=(CopyFileExfunc)GetProcAddress(hmodule,"CopyFileExW");
+		pfnCopyFile2=(CopyFile2func)GetProcAddress(hmodule,"CopyFile2");
 		pfnCopyFileTransacted=(CopyFileTransactedfunc)GetProcAddress(hmodule, "CopyFileTransactedW");
 		pfnMoveFileWithProgress=(MoveFileWithProgressfunc)GetProcAddress(hmodule,"MoveFileWithProgressW");
 		pfnMoveFileTransacted=(MoveFileTransactedfunc)GetProcAddress(hmodule, "MoveFileTransactedW");
@@ -6139,6 +12552,16 @@ PyCFunction pfnpy_OpenFileById=(PyCFunction)py_OpenFileById;
 		pfnOpenFileById=(OpenFileByIdfunc)GetProcAddress(hmodule, "OpenFileById");
 		}
 
+	hmodule=GetModuleHandle(TEXT("ktmw32.dll"));
+	if (hmodule==NULL)
+		hmodule=LoadLibrary(TEXT("ktmw32.dll"));
+	if (hmodule){
+		pfnCreateTransaction=(CreateTransactionfunc)GetProcAddress(hmodule, "CreateTransaction");
+		pfnCommitTransaction=(CommitTransactionfunc)GetProcAddress(hmodule, "CommitTransaction");
+		pfnCommitTransactionAsync=(CommitTransactionfunc)GetProcAddress(hmodule, "CommitTransactionAsync");
+		pfnRollbackTransaction=(CommitTransactionfunc)GetProcAddress(hmodule, "RollbackTransaction");
+		}
+
 	hmodule=GetModuleHandle(TEXT("sfc.dll"));
 	if (hmodule==NULL)
 		hmodule=LoadLibrary(TEXT("sfc.dll"));
@@ -6158,6 +12581,11 @@ PyCFunction pfnpy_OpenFileById=(PyCFunction)py_OpenFileById;
 #define EV_RXCHAR EV_RXCHAR // A character was received and placed in the input buffer. 
 #define EV_RXFLAG EV_RXFLAG // The event character was received and placed in the input buffer. The event character is specified in the device's DCB structure, which is applied to a serial port by using the SetCommState function. 
 #define EV_TXEMPTY EV_TXEMPTY // The last character in the output buffer was sent.
+#define CE_BREAK CE_BREAK // The hardware detected a break condition.
+#define CE_FRAME CE_FRAME // The hardware detected a framing error.
+#define CE_OVERRUN CE_OVERRUN // A character-buffer overrun has occurred. The next character is lost.
+#define CE_RXOVER CE_RXOVER // An input buffer overflow has occurred.
+#define CE_RXPARITY CE_RXPARITY // The hardware detected a parity error.
 #define CBR_110 CBR_110 
 #define CBR_19200 CBR_19200
 #define CBR_300 CBR_300 
@@ -6264,6 +12692,8 @@ PyCFunction pfnpy_OpenFileById=(PyCFunction)py_OpenFileById;
 #define FileAttributeTagInfo FileAttributeTagInfo
 #define FileIdBothDirectoryInfo FileIdBothDirectoryInfo
 #define FileIdBothDirectoryRestartInfo FileIdBothDirectoryRestartInfo
+#define FileFullDirectoryInfo FileFullDirectoryInfo
+#define FileFullDirectoryRestartInfo FileFullDirectoryRestartInfo
 #define FileIoPriorityHintInfo FileIoPriorityHintInfo
 
 #define IoPriorityHintVeryLow IoPriorityHintVeryLow
@@ -417,3 +417,580 @@ int PyCOMSTAT::setattro(PyObject *self, PyObject *obname, PyObject *v)
 }
 
 /*static*/ void PyCOMSTAT::deallocFunc(PyObject *ob) { delete (PyCOMSTAT *)ob; }
+
+////////////////////////////////////////////////////////////////
+//
+// Serial reader object.
+//
+////////////////////////////////////////////////////////////////
+// @object PySerialReader|Reads any number of serial ports continuously, and splits
+// what is read into frames, as returned by <om win32file.CreateSerialReader>.
+// @comm Each port added has an overlapped ReadFile kept in flight, completing to the
+// reader's I/O completion port.  One native thread services all the ports - it frames
+// what is read and queues complete frames, which <om PySerialReader.GetFrames> returns
+// in batches.
+// <nl>A frame ends when the port's delimiter is read, when no byte has arrived for the
+// port's inter-byte timeout, or when it reaches the maximum frame size.  With neither a
+// delimiter nor a timeout, whatever each read returns is a frame.
+// <nl>ClearCommError is called after each read, and the errors it reports are counted
+// and passed with the frame being read.
+// <nl>The port handles must be opened with FILE_FLAG_OVERLAPPED.  Adding a port changes
+// its read timeouts, so a read completes as soon as any bytes arrive, and associates it
+// with the reader's completion port - so a handle can only be added to one reader, once.
+
+#define SERIAL_READ_SIZE 1024
+#define SERIAL_MAX_DELIMITER 16
+// The longest a read waits for its first byte, which bounds how long removing a port takes.
+#define SERIAL_READ_TIMEOUT 1000
+
+struct PySerialReader;
+
+typedef struct {
+    PySerialReader *reader;
+    HANDLE hFile;
+    PyObject *obHandle;
+    PyObject *obCookie;
+    OVERLAPPED ol;
+    BOOL bPending;  // a read is in flight
+    BOOL bRemoved;  // set by RemovePort, with the critical section held
+    BOOL bDead;     // no more reads will be issued
+    BYTE readBuf[SERIAL_READ_SIZE];
+    // The frame being assembled.  Only used by the thread.
+    BYTE *frame;
+    DWORD cbFrame;
+    DWORD maxFrame;
+    DWORD frameErrors;  // CE_* values seen during the frame
+    DWORD lastByte;     // tick count of the last byte read
+    BYTE delimiter[SERIAL_MAX_DELIMITER];
+    DWORD cbDelimiter;
+    DWORD interByteTimeout;
+    DWORD lastError;
+    // Statistics, changed with the critical section held.
+    LONG bytes;
+    LONG frames;
+    LONG overruns;
+    LONG parityErrors;
+    LONG framingErrors;
+    LONG breaks;
+} SerialPort;
+
+typedef struct SerialFrame {
+    struct SerialFrame *next;
+    SerialPort *port;
+    DWORD errors;
+    BOOL bFailed;  // the port failed, and has stopped reading
+    DWORD cb;
+    BYTE data[1];
+} SerialFrame;
+
+struct PySerialReader {
+    PyObject_HEAD HANDLE hPort;
+    HANDLE hReady;  // auto-reset, signalled when frames are queued or the reader closes
+    HANDLE hThread;
+    BOOL bClosed;
+    CRITICAL_SECTION cs;  // protects the ports array, the frame queue and the statistics
+    SerialPort **ports;   // ports are only freed when the reader is closed
+    ULONG numPorts, maxPorts;
+    SerialFrame *head, *tail;
+    LONG frames;  // statistics
+    LONG overruns;
+    LONG batches;
+};
+
+// Queues a frame.  Called by the thread.
+static void serial_emit(SerialPort *port, const BYTE *data, DWORD cb, BOOL bFailed)
+{
+    PySerialReader *r = port->reader;
+    SerialFrame *f = (SerialFrame *)malloc(sizeof(SerialFrame) + cb);
+    if (f == NULL)
+        return;  // nothing better to do - the frame is lost.
+    f->next = NULL;
+    f->port = port;
+    f->errors = port->frameErrors;
+    f->bFailed = bFailed;
+    f->cb = cb;
+    memcpy(f->data, data, cb);
+    port->frameErrors = 0;
+    EnterCriticalSection(&r->cs);
+    if (r->tail)
+        r->tail->next = f;
+    else
+        r->head = f;
+    r->tail = f;
+    if (!bFailed) {
+        port->frames++;
+        r->frames++;
+    }
+    LeaveCriticalSection(&r->cs);
+    SetEvent(r->hReady);
+}
+
+// Frames the bytes just read.  Called by the thread.
+static void serial_input(SerialPort *port, const BYTE *data, DWORD cb)
+{
+    if (port->cbDelimiter == 0 && port->interByteTimeout == 0) {
+        serial_emit(port, data, cb, FALSE);
+        return;
+    }
+    BYTE last = port->cbDelimiter ? port->delimiter[port->cbDelimiter - 1] : 0;
+    for (DWORD i = 0; i < cb; i++) {
+        port->frame[port->cbFrame++] = data[i];
+        if (port->cbDelimiter && data[i] == last && port->cbFrame >= port->cbDelimiter &&
+            memcmp(port->frame + port->cbFrame - port->cbDelimiter, port->delimiter, port->cbDelimiter) == 0) {
+            // The delimiter is not part of the frame.
+            serial_emit(port, port->frame, port->cbFrame - port->cbDelimiter, FALSE);
+            port->cbFrame = 0;
+        }
+        else if (port->cbFrame == port->maxFrame) {
+            serial_emit(port, port->frame, port->cbFrame, FALSE);
+            port->cbFrame = 0;
+        }
+    }
+    port->lastByte = GetTickCount();
+}
+
+// Issues the next read, unless the port has been removed.  Called with the critical section held.
+static void serial_read(SerialPort *port)
+{
+    if (port->bRemoved || port->bDead)
+        return;
+    memset(&port->ol, 0, sizeof(port->ol));
+    if (ReadFile(port->hFile, port->readBuf, sizeof(port->readBuf), NULL, &port->ol) ||
+        GetLastError() == ERROR_IO_PENDING)
+        port->bPending = TRUE;  // a completion packet is queued either way.
+    else {
+        port->lastError = GetLastError();
+        port->bDead = TRUE;
+    }
+}
+
+static void serial_count_errors(SerialPort *port, DWORD errors)
+{
+    PySerialReader *r = port->reader;
+    port->frameErrors |= errors;
+    EnterCriticalSection(&r->cs);
+    if (errors & (CE_OVERRUN | CE_RXOVER)) {
+        port->overruns++;
+        r->overruns++;
+    }
+    if (errors & CE_RXPARITY)
+        port->parityErrors++;
+    if (errors & CE_FRAME)
+        port->framingErrors++;
+    if (errors & CE_BREAK)
+        port->breaks++;
+    LeaveCriticalSection(&r->cs);
+}
+
+// Ends the frames whose inter-byte timeout has expired, returning how long until the next
+// one does.  Called by the thread.
+static DWORD serial_check_timeouts(PySerialReader *r)
+{
+    DWORD wait = INFINITE, now = GetTickCount();
+    // AddPort may grow the array.  serial_emit enters the critical section again, which is allowed.
+    EnterCriticalSection(&r->cs);
+    for (ULONG i = 0; i < r->numPorts; i++) {
+        SerialPort *port = r->ports[i];
+        if (port->cbFrame == 0 || port->interByteTimeout == 0)
+            continue;
+        DWORD elapsed = now - port->lastByte;
+        if (elapsed >= port->interByteTimeout) {
+            serial_emit(port, port->frame, port->cbFrame, FALSE);
+            port->cbFrame = 0;
+        }
+        else if (port->interByteTimeout - elapsed < wait)
+            wait = port->interByteTimeout - elapsed;
+    }
+    LeaveCriticalSection(&r->cs);
+    return wait;
+}
+
+static DWORD WINAPI serial_thread(LPVOID param)
+{
+    PySerialReader *r = (PySerialReader *)param;
+    for (;;) {
+        DWORD wait = serial_check_timeouts(r);
+        DWORD cb = 0;
+        ULONG_PTR key = 0;
+        OVERLAPPED *pOverlapped = NULL;
+        BOOL ok = GetQueuedCompletionStatus(r->hPort, &cb, &key, &pOverlapped, wait);
+        DWORD err = ok ? 0 : GetLastError();
+        if (pOverlapped == NULL) {
+            if (!ok && err == WAIT_TIMEOUT)
+                continue;
+            break;  // Close posted us a packet, or the port is gone.
+        }
+        SerialPort *port = (SerialPort *)key;
+        port->bPending = FALSE;
+        if (ok && cb) {
+            InterlockedExchangeAdd(&port->bytes, cb);
+            serial_input(port, port->readBuf, cb);
+        }
+        DWORD errors = 0;
+        if (ClearCommError(port->hFile, &errors, NULL) && errors)
+            serial_count_errors(port, errors);
+        EnterCriticalSection(&r->cs);
+        if (!ok && !port->bRemoved && err != ERROR_OPERATION_ABORTED) {
+            port->lastError = err;
+            port->bDead = TRUE;
+        }
+        serial_read(port);
+        BOOL bFailed = port->bDead && !port->bRemoved;
+        LeaveCriticalSection(&r->cs);
+        if (!port->bPending) {
+            // Removed, or failed - deliver what we have.
+            if (port->cbFrame)
+                serial_emit(port, port->frame, port->cbFrame, FALSE);
+            port->cbFrame = 0;
+            port->bDead = TRUE;
+            if (bFailed)
+                serial_emit(port, NULL, 0, TRUE);
+        }
+    }
+    // Make sure nothing is still using the OVERLAPPEDs.
+    for (ULONG i = 0; i < r->numPorts; i++) {
+        SerialPort *port = r->ports[i];
+        DWORD cb;
+        if (port->bPending && CancelIoEx(port->hFile, &port->ol))
+            GetOverlappedResult(port->hFile, &port->ol, &cb, TRUE);
+        port->bPending = FALSE;
+    }
+    return 0;
+}
+
+static void serial_close(PySerialReader *r)
+{
+    if (r->bClosed)
+        return;
+    r->bClosed = TRUE;
+    if (r->hThread) {
+        PostQueuedCompletionStatus(r->hPort, 0, 0, NULL);
+        Py_BEGIN_ALLOW_THREADS WaitForSingleObject(r->hThread, INFINITE);
+        Py_END_ALLOW_THREADS CloseHandle(r->hThread);
+        r->hThread = NULL;
+    }
+    if (r->hPort) {
+        CloseHandle(r->hPort);
+        r->hPort = NULL;
+    }
+    for (ULONG i = 0; i < r->numPorts; i++) {
+        SerialPort *port = r->ports[i];
+        Py_DECREF(port->obHandle);
+        Py_DECREF(port->obCookie);
+        free(port->frame);
+        free(port);
+    }
+    free(r->ports);
+    r->ports = NULL;
+    r->numPorts = r->maxPorts = 0;
+    while (r->head) {
+        SerialFrame *f = r->head;
+        r->head = f->next;
+        free(f);
+    }
+    r->tail = NULL;
+    SetEvent(r->hReady);
+}
+
+static void serial_dealloc(PyObject *ob)
+{
+    PySerialReader *r = (PySerialReader *)ob;
+    serial_close(r);
+    if (r->hReady)
+        CloseHandle(r->hReady);
+    DeleteCriticalSection(&r->cs);
+    PyObject_Del(ob);
+}
+
+static SerialPort *serial_find(PySerialReader *r, PyObject *obHandle)
+{
+    HANDLE h;
+    if (!PyWinObject_AsHANDLE(obHandle, &h))
+        return NULL;
+    for (ULONG i = 0; i < r->numPorts; i++)
+        if (r->ports[i]->hFile == h && !r->ports[i]->bRemoved)
+            return r->ports[i];
+    PyErr_SetString(PyExc_KeyError, "The port has not been added to the reader");
+    return NULL;
+}
+
+// @pymethod |PySerialReader|AddPort|Starts reading a serial port.
+static PyObject *serial_AddPort(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    PySerialReader *r = (PySerialReader *)self;
+    static char *keywords[] = {"handle", "cookie", "interByteTimeout", "delimiter", "maxFrame", NULL};
+    PyObject *obHandle, *obCookie = Py_None, *obDelimiter = Py_None;
+    DWORD interByteTimeout = 0, maxFrame = 4096;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "O|OkOk:AddPort", keywords,
+            &obHandle,  // @pyparm <o PyHANDLE>|handle||The port, opened with FILE_FLAG_OVERLAPPED
+            &obCookie,  // @pyparm object|cookie|None|Identifies the port in the frames returned.  If None, the
+                        // handle is used.
+            &interByteTimeout,  // @pyparm int|interByteTimeout|0|Milliseconds without a byte which end a frame, or 0
+            &obDelimiter,       // @pyparm bytes|delimiter|None|The bytes which end a frame.  They are not included in
+                                // the frame.
+            &maxFrame))  // @pyparm int|maxFrame|4096|The largest frame - longer frames are split.
+        return NULL;
+    if (r->bClosed)
+        return PyErr_Format(PyExc_ValueError, "The serial reader has been closed");
+    if (maxFrame < 1)
+        return PyErr_Format(PyExc_ValueError, "maxFrame must be at least 1");
+    HANDLE h;
+    if (!PyWinObject_AsHANDLE(obHandle, &h))
+        return NULL;
+    SerialPort *port = (SerialPort *)calloc(1, sizeof(SerialPort));
+    if (port == NULL)
+        return PyErr_NoMemory();
+    if (obDelimiter != Py_None) {
+        PyWinBufferView pybuf(obDelimiter);
+        if (!pybuf.ok()) {
+            free(port);
+            return NULL;
+        }
+        if (pybuf.len() < 1 || pybuf.len() > SERIAL_MAX_DELIMITER) {
+            free(port);
+            return PyErr_Format(PyExc_ValueError, "The delimiter must be between 1 and %d bytes",
+                                SERIAL_MAX_DELIMITER);
+        }
+        memcpy(port->delimiter, pybuf.ptr(), pybuf.len());
+        port->cbDelimiter = pybuf.len();
+    }
+    port->reader = r;
+    port->hFile = h;
+    port->interByteTimeout = interByteTimeout;
+    port->maxFrame = maxFrame;
+    if ((port->cbDelimiter || interByteTimeout) && (port->frame = (BYTE *)malloc(maxFrame)) == NULL) {
+        free(port);
+        return PyErr_NoMemory();
+    }
+    if (r->numPorts == r->maxPorts) {
+        ULONG maxPorts = r->maxPorts ? r->maxPorts * 2 : 16;
+        // The thread reads the array, so only grow it with the critical section held.
+        EnterCriticalSection(&r->cs);
+        SerialPort **ports = (SerialPort **)realloc(r->ports, maxPorts * sizeof(SerialPort *));
+        if (ports) {
+            r->ports = ports;
+            r->maxPorts = maxPorts;
+        }
+        LeaveCriticalSection(&r->cs);
+        if (ports == NULL) {
+            free(port->frame);
+            free(port);
+            return PyErr_NoMemory();
+        }
+    }
+    const char *fname = NULL;
+    COMMTIMEOUTS timeouts;
+    Py_BEGIN_ALLOW_THREADS if (!GetCommTimeouts(h, &timeouts)) fname = "GetCommTimeouts";
+    else
+    {
+        // Complete as soon as any bytes arrive, or after SERIAL_READ_TIMEOUT with none.
+        timeouts.ReadIntervalTimeout = MAXDWORD;
+        timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+        timeouts.ReadTotalTimeoutConstant = SERIAL_READ_TIMEOUT;
+        if (!SetCommTimeouts(h, &timeouts))
+            fname = "SetCommTimeouts";
+        else if (CreateIoCompletionPort(h, r->hPort, (ULONG_PTR)port, 0) == NULL)
+            fname = "CreateIoCompletionPort";
+    }
+    Py_END_ALLOW_THREADS if (fname)
+    {
+        PyWin_SetAPIError(fname);
+        free(port->frame);
+        free(port);
+        return NULL;
+    }
+    port->obHandle = obHandle;
+    Py_INCREF(obHandle);
+    port->obCookie = obCookie == Py_None ? obHandle : obCookie;
+    Py_INCREF(port->obCookie);
+    EnterCriticalSection(&r->cs);
+    r->ports[r->numPorts++] = port;
+    serial_read(port);
+    DWORD err = port->bDead ? port->lastError : 0;
+    LeaveCriticalSection(&r->cs);
+    if (err)
+        // The port stays in the array, as the thread may be looking at it.
+        return PyWin_SetAPIError("ReadFile", err);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod |PySerialReader|RemovePort|Stops reading a serial port.
+// @comm Any partial frame is delivered, and reading stops within a second.
+static PyObject *serial_RemovePort(PyObject *self, PyObject *args)
+{
+    PySerialReader *r = (PySerialReader *)self;
+    PyObject *obHandle;
+    // @pyparm <o PyHANDLE>|handle||The port, as passed to <om PySerialReader.AddPort>
+    if (!PyArg_ParseTuple(args, "O:RemovePort", &obHandle))
+        return NULL;
+    SerialPort *port = serial_find(r, obHandle);
+    if (port == NULL)
+        return NULL;
+    EnterCriticalSection(&r->cs);
+    port->bRemoved = TRUE;
+    if (port->bPending)
+        CancelIoEx(port->hFile, &port->ol);
+    LeaveCriticalSection(&r->cs);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod [(object, bytes, int), ...]|PySerialReader|GetFrames|Waits for complete frames.
+// @rdesc A list of (cookie, data, errors) tuples, in the order the frames were completed, or an
+// empty list if the timeout expired.  errors is the combination of the CE_* values ClearCommError
+// reported while the frame was read.  data is None if the port failed and has stopped reading.
+// @comm Raises ValueError if the reader is closed, including by another thread while waiting.
+static PyObject *serial_GetFrames(PyObject *self, PyObject *args)
+{
+    PySerialReader *r = (PySerialReader *)self;
+    DWORD timeout = INFINITE;
+    // @pyparm int|timeout|win32event.INFINITE|Milliseconds to wait for a frame.
+    if (!PyArg_ParseTuple(args, "|k:GetFrames", &timeout))
+        return NULL;
+    DWORD start = GetTickCount();
+    for (;;) {
+        if (r->bClosed)
+            return PyErr_Format(PyExc_ValueError, "The serial reader has been closed");
+        EnterCriticalSection(&r->cs);
+        SerialFrame *head = r->head;
+        r->head = r->tail = NULL;
+        LeaveCriticalSection(&r->cs);
+        if (head) {
+            PyObject *ret = PyList_New(0);
+            while (head) {
+                SerialFrame *f = head;
+                head = f->next;
+                if (ret) {
+                    PyObject *item;
+                    if (f->bFailed)
+                        item = Py_BuildValue("OOk", f->port->obCookie, Py_None, f->errors);
+                    else
+                        item = Py_BuildValue("Oy#k", f->port->obCookie, f->data, (Py_ssize_t)f->cb, f->errors);
+                    if (item == NULL || PyList_Append(ret, item) == -1)
+                        Py_CLEAR(ret);
+                    Py_XDECREF(item);
+                }
+                free(f);
+            }
+            r->batches++;
+            return ret;
+        }
+        DWORD wait = INFINITE;
+        if (timeout != INFINITE) {
+            DWORD elapsed = GetTickCount() - start;
+            if (elapsed >= timeout)
+                return PyList_New(0);
+            wait = timeout - elapsed;
+        }
+        DWORD rc;
+        Py_BEGIN_ALLOW_THREADS rc = WaitForSingleObject(r->hReady, wait);
+        Py_END_ALLOW_THREADS if (rc == WAIT_FAILED) return PyWin_SetAPIError("WaitForSingleObject");
+    }
+}
+
+// @pymethod dict|PySerialReader|GetStats|Returns the counters for a port.
+// @rdesc A dict with keys bytes, frames, overruns (CE_OVERRUN or CE_RXOVER), parityErrors,
+// framingErrors and breaks.
+static PyObject *serial_GetStats(PyObject *self, PyObject *args)
+{
+    PySerialReader *r = (PySerialReader *)self;
+    PyObject *obHandle;
+    // @pyparm <o PyHANDLE>|handle||The port, as passed to <om PySerialReader.AddPort>
+    if (!PyArg_ParseTuple(args, "O:GetStats", &obHandle))
+        return NULL;
+    SerialPort *port = serial_find(r, obHandle);
+    if (port == NULL)
+        return NULL;
+    EnterCriticalSection(&r->cs);
+    SerialPort snap = *port;
+    LeaveCriticalSection(&r->cs);
+    return Py_BuildValue("{s:l,s:l,s:l,s:l,s:l,s:l}", "bytes", snap.bytes, "frames", snap.frames, "overruns",
+                         snap.overruns, "parityErrors", snap.parityErrors, "framingErrors", snap.framingErrors,
+                         "breaks", snap.breaks);
+}
+
+// @pymethod |PySerialReader|Close|Stops reading all ports.
+// @comm Frames which have not been returned by <om PySerialReader.GetFrames> are discarded.
+static PyObject *serial_Close(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":Close"))
+        return NULL;
+    serial_close((PySerialReader *)self);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyMethodDef serial_methods[] = {
+    {"AddPort", (PyCFunction)serial_AddPort, METH_VARARGS | METH_KEYWORDS},  // @pymeth AddPort|Starts reading a serial port.
+    {"RemovePort", serial_RemovePort, METH_VARARGS},  // @pymeth RemovePort|Stops reading a serial port.
+    {"GetFrames", serial_GetFrames, METH_VARARGS},    // @pymeth GetFrames|Waits for complete frames.
+    {"GetStats", serial_GetStats, METH_VARARGS},      // @pymeth GetStats|Returns the counters for a port.
+    {"Close", serial_Close, METH_VARARGS},            // @pymeth Close|Stops reading all ports.
+    {NULL}};
+
+#define OFF(e) offsetof(PySerialReader, e)
+static PyMemberDef serial_members[] = {
+    {"frames", T_LONG, OFF(frames), READONLY},  // @prop int|frames|The number of frames read, from all the ports.
+    {"overruns", T_LONG, OFF(overruns), READONLY},  // @prop int|overruns|The number of overruns ClearCommError reported, for all the ports.
+    {"batches", T_LONG, OFF(batches), READONLY},  // @prop int|batches|The number of non-empty lists returned by <om PySerialReader.GetFrames>.
+    {NULL}};
+#undef OFF
+
+PyTypeObject PySerialReader_Type = {
+    PYWIN_OBJECT_HEAD "PySerialReader", /* tp_name */
+    sizeof(PySerialReader),             /* tp_basicsize */
+    0,                                  /* tp_itemsize */
+    serial_dealloc,                     /* tp_dealloc */
+    0,                                  /* tp_print */
+    0,                                  /* tp_getattr */
+    0,                                  /* tp_setattr */
+    0,                                  /* tp_compare */
+    0,                                  /* tp_repr */
+    0,                                  /* tp_as_number */
+    0,                                  /* tp_as_sequence */
+    0,                                  /* tp_as_mapping */
+    0,                                  /* tp_hash */
+    0,                                  /* tp_call */
+    0,                                  /* tp_str */
+    PyObject_GenericGetAttr,            /* tp_getattro */
+    0,                                  /* tp_setattro */
+    0,                                  /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                 /* tp_flags */
+    0,                                  /* tp_doc */
+    0,                                  /* tp_traverse */
+    0,                                  /* tp_clear */
+    0,                                  /* tp_richcompare */
+    0,                                  /* tp_weaklistoffset */
+    0,                                  /* tp_iter */
+    0,                                  /* tp_iternext */
+    serial_methods,                     /* tp_methods */
+    serial_members,                     /* tp_members */
+};
+
+// @pymethod <o PySerialReader>|win32file|CreateSerialReader|Creates an object which reads many serial ports
+// continuously and splits what is read into frames.
+PyObject *PyWinMethod_CreateSerialReader(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":CreateSerialReader"))
+        return NULL;
+    PySerialReader *r = PyObject_New(PySerialReader, &PySerialReader_Type);
+    if (r == NULL)
+        return NULL;
+    memset(((BYTE *)r) + sizeof(PyObject), 0, sizeof(PySerialReader) - sizeof(PyObject));
+    InitializeCriticalSection(&r->cs);
+    const char *fname = NULL;
+    if ((r->hReady = CreateEvent(NULL, FALSE, FALSE, NULL)) == NULL)
+        fname = "CreateEvent";
+    else if ((r->hPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1)) == NULL)
+        fname = "CreateIoCompletionPort";
+    else if ((r->hThread = CreateThread(NULL, 0, serial_thread, r, 0, NULL)) == NULL)
+        fname = "CreateThread";
+    if (fname) {
+        PyWin_SetAPIError(fname);
+        Py_DECREF(r);
+        return NULL;
+    }
+    return (PyObject *)r;
+}
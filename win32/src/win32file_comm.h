@@ -11,6 +11,10 @@ extern PyObject *PyWinMethod_NewDCB(PyObject *self, PyObject *args);
 extern PyObject *PyWinObject_FromCOMMTIMEOUTS(COMMTIMEOUTS *p);
 extern BOOL PyWinObject_AsCOMMTIMEOUTS(PyObject *ob, COMMTIMEOUTS *p);
 
+// The serial reader object.
+extern PyTypeObject PySerialReader_Type;
+extern PyObject *PyWinMethod_CreateSerialReader(PyObject *self, PyObject *args);
+
 class PyDCB : public PyObject {
    public:
     DCB *GetDCB() { return &m_DCB; }
@@ -33,6 +33,10 @@
 #include "windowsx.h" // For edit control hacks.
 #include "Dbt.h" // device notification
 #include "malloc.h"
+#ifndef MS_WINCE
+#include "win32screencapture.h"
+#include "win32rawinput.h"
+#endif
 
 #ifdef MS_WINCE
 #include "winbase.h"
@@ -261,6 +265,12 @@ if (PyType_Ready(&PyWNDCLASSType) == -1 ||
 	PyType_Ready(&PyBITMAPType) == -1 ||
 	PyType_Ready(&PyLOGFONTType) == -1)
 	PYWIN_MODULE_INIT_RETURN_ERROR;
+#ifndef MS_WINCE
+if (PyType_Ready(&PyScreenCaptureType) == -1 ||
+	PyType_Ready(&PyRawInputBatchType) == -1)
+	PYWIN_MODULE_INIT_RETURN_ERROR;
+PyDict_SetItemString(d, "PyRawInputBatchType", (PyObject *)&PyRawInputBatchType);
+#endif
 
 // Expose the window procedure and window class dicts to aid debugging
 g_AtomMap = PyDict_New();
@@ -294,6 +304,14 @@ for (PyMethodDef *pmd = win32guiMethods; pmd->ml_name; pmd++)
 		||strcmp(pmd->ml_name, "GetSaveFileNameW")==0
 		||strcmp(pmd->ml_name, "SystemParametersInfo")==0
 		||strcmp(pmd->ml_name, "DrawTextW")==0
+		||strcmp(pmd->ml_name, "PumpMessagesEx")==0
+		||strcmp(pmd->ml_name, "SnapshotWindows")==0
+		||strcmp(pmd->ml_name, "SendMessageStruct")==0
+		||strcmp(pmd->ml_name, "SendMessageStructs")==0
+		||strcmp(pmd->ml_name, "ListViewSnapshot")==0
+		||strcmp(pmd->ml_name, "TreeViewSnapshot")==0
+		||strcmp(pmd->ml_name, "CreateScreenCapture")==0
+		||strcmp(pmd->ml_name, "GetRawInputBuffer")==0
 		)
 		pmd->ml_flags = METH_VARARGS | METH_KEYWORDS;
 
@@ -2021,6 +2039,332 @@ static PyObject *PySendMessageTimeout(PyObject *self, PyObject *args)
 %}
 %native (SendMessageTimeout) PySendMessageTimeout;
 
+%{
+// Blocks of memory in other processes used by SendMessageStruct(s).  They are
+// cached per target process, so scraping a control item by item doesn't pay for
+// OpenProcess and VirtualAllocEx on every message.  Only touched with the GIL held.
+#define PYREMOTE_PAYLOAD_SLOTS 4
+struct PyRemotePayload {
+	DWORD pid;
+	HANDLE hprocess;
+	BYTE *remote;
+	SIZE_T size;
+	BOOL busy;		// in use by a call which has released the GIL
+};
+static PyRemotePayload remotePayloads[PYREMOTE_PAYLOAD_SLOTS];
+static int remotePayloadNext = 0;
+
+static void PyRemotePayload_Free(PyRemotePayload *p)
+{
+	if (p->remote)
+		VirtualFreeEx(p->hprocess, p->remote, 0, MEM_RELEASE);
+	if (p->hprocess)
+		CloseHandle(p->hprocess);
+	memset(p, 0, sizeof(*p));
+}
+
+// Returns a slot for process 'pid' with at least 'size' bytes allocated, and marks it busy.
+static PyRemotePayload *PyRemotePayload_Acquire(DWORD pid, SIZE_T size)
+{
+	PyRemotePayload *p = NULL;
+	int i;
+	for (i = 0; i < PYREMOTE_PAYLOAD_SLOTS && p == NULL; i++){
+		PyRemotePayload *cand = &remotePayloads[i];
+		if (cand->hprocess == NULL || cand->pid != pid || cand->busy)
+			continue;
+		// Process ids are recycled, so make sure the cached process is still running.
+		if (WaitForSingleObject(cand->hprocess, 0) == WAIT_TIMEOUT)
+			p = cand;
+		else
+			PyRemotePayload_Free(cand);
+		}
+	if (p == NULL){
+		for (i = 0; i < PYREMOTE_PAYLOAD_SLOTS && p == NULL; i++)
+			if (remotePayloads[i].hprocess == NULL)
+				p = &remotePayloads[i];
+		for (i = 0; i < PYREMOTE_PAYLOAD_SLOTS && p == NULL; i++){
+			PyRemotePayload *cand = &remotePayloads[remotePayloadNext];
+			remotePayloadNext = (remotePayloadNext + 1) % PYREMOTE_PAYLOAD_SLOTS;
+			if (!cand->busy){
+				PyRemotePayload_Free(cand);
+				p = cand;
+				}
+			}
+		if (p == NULL){
+			PyErr_SetString(PyExc_RuntimeError, "Too many threads are sending messages to other processes");
+			return NULL;
+			}
+		p->hprocess = OpenProcess(PROCESS_VM_OPERATION | PROCESS_VM_READ | PROCESS_VM_WRITE | SYNCHRONIZE, FALSE, pid);
+		if (p->hprocess == NULL){
+			PyWin_SetAPIError("OpenProcess");
+			return NULL;
+			}
+		p->pid = pid;
+		}
+	if (p->size < size){
+		if (p->remote){
+			VirtualFreeEx(p->hprocess, p->remote, 0, MEM_RELEASE);
+			p->remote = NULL;
+			p->size = 0;
+			}
+		SIZE_T alloc = (size + 4095) & ~(SIZE_T)4095;
+		p->remote = (BYTE *)VirtualAllocEx(p->hprocess, NULL, alloc, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+		if (p->remote == NULL){
+			PyWin_SetAPIError("VirtualAllocEx");
+			return NULL;
+			}
+		p->size = alloc;
+		}
+	p->busy = TRUE;
+	return p;
+}
+
+// Sends one message whose lparam is the address of 'block' in the target process.  The
+// pointer-sized values at the 'fixups' offsets are offsets into the block on the way in, and are
+// rebased to real addresses for the duration of the call.  Called without the GIL.
+static BOOL PySendStructMessageBlock(HWND hwnd, UINT msg, WPARAM wparam, BYTE *block, SIZE_T len,
+	PyRemotePayload *remote, DWORD *fixups, DWORD nfixups, UINT timeout, LRESULT *prc, const char **failed)
+{
+	BYTE *base = remote ? remote->remote : block;
+	DWORD i;
+	for (i = 0; i < nfixups; i++){
+		BYTE **slot = (BYTE **)(block + fixups[i]);
+		*slot = base + (SIZE_T)*slot;
+		}
+	if (remote && !WriteProcessMemory(remote->hprocess, base, block, len, NULL)){
+		*failed = "WriteProcessMemory";
+		return FALSE;
+		}
+	if (timeout == INFINITE)
+		*prc = SendMessage(hwnd, msg, wparam, (LPARAM)base);
+	else {
+		DWORD_PTR result;
+		if (!SendMessageTimeout(hwnd, msg, wparam, (LPARAM)base, SMTO_ABORTIFHUNG, timeout, &result)){
+			*failed = "SendMessageTimeout";
+			return FALSE;
+			}
+		*prc = (LRESULT)result;
+		}
+	if (remote && !ReadProcessMemory(remote->hprocess, base, block, len, NULL)){
+		*failed = "ReadProcessMemory";
+		return FALSE;
+		}
+	// Turn pointers back into offsets so the caller sees the layout it passed in.  Controls
+	// may substitute their own buffer (eg, for LVM_GETITEM text), which is left untouched.
+	for (i = 0; i < nfixups; i++){
+		BYTE **slot = (BYTE **)(block + fixups[i]);
+		if (*slot >= base && *slot < base + len)
+			*slot = (BYTE *)(*slot - base);
+		}
+	return TRUE;
+}
+
+// The guts of SendMessageStruct and SendMessageStructs - 'items' is a tuple of (wparam, payload) tuples.
+static PyObject *PyDoSendMessageStructs(HWND hwnd, UINT msg, PyObject *items, DWORD nitems,
+	DWORD extra, DWORD *fixups, DWORD nfixups, UINT timeout)
+{
+	DWORD pid = 0;
+	if (GetWindowThreadProcessId(hwnd, &pid) == 0)
+		return PyWin_SetAPIError("GetWindowThreadProcessId");
+	WPARAM *wparams = (WPARAM *)malloc(nitems * sizeof(WPARAM) + 1);
+	Py_buffer *views = (Py_buffer *)calloc(nitems + 1, sizeof(Py_buffer));
+	SIZE_T *offsets = (SIZE_T *)malloc((nitems + 1) * sizeof(SIZE_T));
+	LRESULT *results = (LRESULT *)malloc(nitems * sizeof(LRESULT) + 1);
+	PyRemotePayload *remote = NULL;
+	BYTE *blocks = NULL;
+	PyObject *ret = NULL;
+	DWORD i, nviews = 0, nsent = 0;
+	SIZE_T maxlen = 0;
+	BOOL ok;
+	const char *failed = NULL;
+	if (wparams == NULL || views == NULL || offsets == NULL || results == NULL){
+		PyErr_NoMemory();
+		goto done;
+		}
+	// Each item gets its own copy of the payload, followed by 'extra' zeroed bytes.
+	offsets[0] = 0;
+	for (i = 0; i < nitems; i++){
+		PyObject *obwparam, *obpayload;
+		if (!PyArg_ParseTuple(PyTuple_GET_ITEM(items, i), "OO:SendMessageStructs item", &obwparam, &obpayload))
+			goto done;
+		if (!PyWinObject_AsPARAM(obwparam, &wparams[i]))
+			goto done;
+		// Writable payloads are updated in place, so try for a writable view first.
+		if (PyObject_GetBuffer(obpayload, &views[i], PyBUF_WRITABLE) == -1){
+			PyErr_Clear();
+			if (PyObject_GetBuffer(obpayload, &views[i], PyBUF_SIMPLE) == -1)
+				goto done;
+			}
+		nviews++;
+		SIZE_T len = (SIZE_T)views[i].len + extra;
+		for (DWORD f = 0; f < nfixups; f++)
+			if (fixups[f] + sizeof(void *) > len){
+				PyErr_Format(PyExc_ValueError, "Pointer offset %u is outside the %zu byte payload", fixups[f], (size_t)len);
+				goto done;
+				}
+		offsets[i + 1] = offsets[i] + ((len + 7) & ~(SIZE_T)7);
+		if (len > maxlen)
+			maxlen = len;
+		}
+	blocks = (BYTE *)calloc(offsets[nitems] + 1, 1);
+	if (blocks == NULL){
+		PyErr_NoMemory();
+		goto done;
+		}
+	for (i = 0; i < nitems; i++){
+		memcpy(blocks + offsets[i], views[i].buf, views[i].len);
+		for (DWORD f = 0; f < nfixups; f++)
+			if (*(SIZE_T *)(blocks + offsets[i] + fixups[f]) >= (SIZE_T)views[i].len + extra){
+				PyErr_Format(PyExc_ValueError, "The pointer at offset %u must be an offset into the payload", fixups[f]);
+				goto done;
+				}
+		}
+	if (pid != GetCurrentProcessId() && maxlen){
+		remote = PyRemotePayload_Acquire(pid, maxlen);
+		if (remote == NULL)
+			goto done;
+		}
+	Py_BEGIN_ALLOW_THREADS
+	for (ok = TRUE; ok && nsent < nitems; nsent++){
+		SIZE_T len = (SIZE_T)views[nsent].len + extra;
+		ok = PySendStructMessageBlock(hwnd, msg, wparams[nsent], blocks + offsets[nsent], len,
+			remote, fixups, nfixups, timeout, &results[nsent], &failed);
+		}
+	Py_END_ALLOW_THREADS
+	if (remote)
+		remote->busy = FALSE;
+	if (failed){
+		PyWin_SetAPIError((char *)failed);
+		goto done;
+		}
+	ret = PyList_New(nitems);
+	for (i = 0; ret && i < nitems; i++){
+		if (!views[i].readonly)
+			memcpy(views[i].buf, blocks + offsets[i], views[i].len);
+		PyObject *item = Py_BuildValue("NN", PyWinLong_FromVoidPtr((void *)results[i]),
+			PyBytes_FromStringAndSize((char *)blocks + offsets[i], views[i].len + extra));
+		if (item == NULL)
+			Py_CLEAR(ret);
+		else
+			PyList_SET_ITEM(ret, i, item);
+		}
+done:
+	for (i = 0; i < nviews; i++)
+		PyBuffer_Release(&views[i]);
+	free(wparams);
+	free(views);
+	free(offsets);
+	free(results);
+	free(blocks);
+	return ret;
+}
+
+// @pyswig int, bytes|SendMessageStruct|Sends a message whose lparam is the address of a structure,
+// copying the structure into the window's process when it belongs to another one.
+// @comm Passing structures to windows in other processes otherwise means allocating, writing and
+// reading memory in that process with <om win32process.VirtualAllocEx> and friends for every message.
+// Here the memory is allocated once per target process and reused by later calls.
+// <nl>Embedded pointers (such as the pszText member of an LVITEM) must point into the payload
+// itself.  Store the offset from the start of the payload in the structure and list the offset of
+// the member in the pointers arg - the address is fixed up for whichever process receives the message,
+// and changed back to an offset afterwards.  If the control replaces the pointer with one of its own,
+// it is returned unchanged.
+// <nl>The target process must have the same pointer size as Python.
+// <nl>There is no equivalent for PostMessage, as the payload must stay valid until the message is handled.
+// @rdesc The result of the message, and the payload plus any extra bytes as the target process left them.
+// If the payload supports writable buffers, such as a bytearray or ctypes structure, it is also updated in place.
+// @pyseeapi SendMessage
+static PyObject *PySendMessageStruct(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[] = {"hwnd", "message", "wparam", "payload", "extra", "pointers", "timeout", NULL};
+	PyObject *obhwnd, *obwparam, *obpayload, *obfixups = Py_None;
+	UINT msg, timeout = INFINITE;
+	DWORD extra = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OIOO|kOI:SendMessageStruct", keywords,
+		&obhwnd,	// @pyparm <o PyHANDLE>|hwnd||The handle to the window
+		&msg,		// @pyparm int|message||The ID of the message to send
+		&obwparam,	// @pyparm int|wparam||An integer whose value depends on the message
+		&obpayload,	// @pyparm buffer|payload||The structure, as any object that supports the buffer interface - eg, a ctypes structure
+		&extra,		// @pyparm int|extra|0|Number of zeroed bytes to append to the payload, for data such as text buffers that the pointers refer to.
+		&obfixups,	// @pyparm [int, ...]|pointers|None|Offsets of pointer members in the payload, whose values are offsets into the payload
+		&timeout))	// @pyparm int|timeout|INFINITE|If specified, <om win32gui.SendMessageTimeout> is used with SMTO_ABORTIFHUNG and this timeout in milliseconds.
+		return NULL;
+	HWND hwnd;
+	if (!PyWinObject_AsHANDLE(obhwnd, (HANDLE *)&hwnd))
+		return NULL;
+	DWORD *fixups = NULL, nfixups = 0;
+	if (!PyWinObject_AsDWORDArray(obfixups, &fixups, &nfixups, TRUE))
+		return NULL;
+	PyObject *ret = NULL;
+	PyObject *items = Py_BuildValue("((OO))", obwparam, obpayload);
+	if (items){
+		PyObject *results = PyDoSendMessageStructs(hwnd, msg, items, 1, extra, fixups, nfixups, timeout);
+		if (results){
+			ret = PyList_GET_ITEM(results, 0);
+			Py_INCREF(ret);
+			Py_DECREF(results);
+			}
+		Py_DECREF(items);
+		}
+	if (fixups)
+		free(fixups);
+	return ret;
+}
+
+// @pyswig [(int, bytes), ...]|SendMessageStructs|Sends a batch of messages like <om win32gui.SendMessageStruct>,
+// in one call.
+// @comm The payloads are all copied and the messages sent without reacquiring the Python lock, so
+// reading every item of a list view with LVM_GETITEM costs one Python call.  If any message fails, an
+// exception is raised and none of the payloads are updated.
+// @rdesc A list with the result and final payload bytes of each message, in order.
+static PyObject *PySendMessageStructs(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[] = {"hwnd", "message", "items", "extra", "pointers", "timeout", NULL};
+	PyObject *obhwnd, *obitems, *obfixups = Py_None;
+	UINT msg, timeout = INFINITE;
+	DWORD extra = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OIO|kOI:SendMessageStructs", keywords,
+		&obhwnd,	// @pyparm <o PyHANDLE>|hwnd||The handle to the window
+		&msg,		// @pyparm int|message||The ID of the message to send
+		&obitems,	// @pyparm [(int, buffer), ...]|items||The wparam and payload of each message
+		&extra,		// @pyparm int|extra|0|Number of zeroed bytes appended to each payload
+		&obfixups,	// @pyparm [int, ...]|pointers|None|Offsets of pointer members in every payload, as for <om win32gui.SendMessageStruct>
+		&timeout))	// @pyparm int|timeout|INFINITE|Timeout for each message in milliseconds
+		return NULL;
+	HWND hwnd;
+	if (!PyWinObject_AsHANDLE(obhwnd, (HANDLE *)&hwnd))
+		return NULL;
+	DWORD nitems;
+	PyObject *items = PyWinSequence_Tuple(obitems, &nitems);
+	if (items == NULL)
+		return NULL;
+	DWORD *fixups = NULL, nfixups = 0;
+	PyObject *ret = NULL;
+	if (PyWinObject_AsDWORDArray(obfixups, &fixups, &nfixups, TRUE))
+		ret = PyDoSendMessageStructs(hwnd, msg, items, nitems, extra, fixups, nfixups, timeout);
+	Py_DECREF(items);
+	if (fixups)
+		free(fixups);
+	return ret;
+}
+
+// @pyswig |FreeMessageStructBuffers|Releases the memory <om win32gui.SendMessageStruct> has cached in other processes.
+// @comm The memory is otherwise kept until the window's process exits, or is displaced by a message to a different process.
+static PyObject *PyFreeMessageStructBuffers(PyObject *self, PyObject *args)
+{
+	if (!PyArg_ParseTuple(args, ":FreeMessageStructBuffers"))
+		return NULL;
+	for (int i = 0; i < PYREMOTE_PAYLOAD_SLOTS; i++)
+		if (!remotePayloads[i].busy)
+			PyRemotePayload_Free(&remotePayloads[i]);
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+%}
+%native (SendMessageStruct) PySendMessageStruct;
+%native (SendMessageStructs) PySendMessageStructs;
+%native (FreeMessageStructBuffers) PyFreeMessageStructBuffers;
+
 // @pyswig |PostMessage|
 // @pyparm int|hwnd||The handle to the Window
 // @pyparm int|message||The ID of the message to post
@@ -2165,12 +2509,583 @@ static PyObject *PyEnumChildWindows(PyObject *self, PyObject *args)
 	return Py_None;
 }
 
+// Native support for SnapshotWindows - the windows are enumerated and their
+// attributes fetched without the GIL, strings going into one growable pool.
+#define SNAPSHOT_CLASS		0x01
+#define SNAPSHOT_TEXT		0x02
+#define SNAPSHOT_RECT		0x04
+#define SNAPSHOT_PID		0x08
+#define SNAPSHOT_VISIBLE	0x10
+
+struct PyWindowSnapshotEntry {
+	HWND hwnd;
+	DWORD pid;
+	RECT rect;
+	BOOL visible;
+	size_t classOffset;	// offsets into the string pool
+	size_t textOffset;
+};
+
+struct PyWindowSnapshot {
+	HWND *hwnds;
+	DWORD num_hwnds, max_hwnds;
+	WCHAR *pool;
+	size_t pool_used, pool_size;
+	BOOL failed;
+};
+
+BOOL CALLBACK PySnapshotWindowsProc(HWND hwnd, LPARAM lParam)
+{
+	PyWindowSnapshot *snap = (PyWindowSnapshot *)lParam;
+	if (snap->num_hwnds == snap->max_hwnds){
+		DWORD newmax = snap->max_hwnds ? snap->max_hwnds * 2 : 1024;
+		HWND *newhwnds = (HWND *)realloc(snap->hwnds, newmax * sizeof(HWND));
+		if (newhwnds == NULL){
+			snap->failed = TRUE;
+			return FALSE;
+			}
+		snap->hwnds = newhwnds;
+		snap->max_hwnds = newmax;
+		}
+	snap->hwnds[snap->num_hwnds++] = hwnd;
+	return TRUE;
+}
+
+// Appends a string (and its terminator) to the pool, returning its offset or -1.
+static size_t PySnapshotAddString(PyWindowSnapshot *snap, const WCHAR *str, int len)
+{
+	if (snap->pool_used + len + 1 > snap->pool_size){
+		size_t newsize = snap->pool_size ? snap->pool_size * 2 : 65536;
+		while (newsize < snap->pool_used + len + 1)
+			newsize *= 2;
+		WCHAR *newpool = (WCHAR *)realloc(snap->pool, newsize * sizeof(WCHAR));
+		if (newpool == NULL){
+			snap->failed = TRUE;
+			return (size_t)-1;
+			}
+		snap->pool = newpool;
+		snap->pool_size = newsize;
+		}
+	size_t offset = snap->pool_used;
+	memcpy(snap->pool + offset, str, len * sizeof(WCHAR));
+	snap->pool[offset + len] = 0;
+	snap->pool_used += len + 1;
+	return offset;
+}
+
+// Case insensitive match of '*' and '?' wildcards.
+static BOOL PyWildcardMatch(const WCHAR *pattern, const WCHAR *str)
+{
+	const WCHAR *star = NULL, *resume = NULL;
+	while (*str){
+		if (*pattern == L'*'){
+			star = pattern++;
+			resume = str;
+			}
+		else if (*pattern == L'?' || towlower(*pattern) == towlower(*str)){
+			pattern++;
+			str++;
+			}
+		else if (star){
+			pattern = star + 1;
+			str = ++resume;
+			}
+		else
+			return FALSE;
+		}
+	while (*pattern == L'*')
+		pattern++;
+	return *pattern == 0;
+}
+
+// @pyswig dict|SnapshotWindows|Returns chosen attributes of many windows in one call.
+// @comm Enumerating 50,000 windows with <om win32gui.EnumWindows> and then calling
+// <om win32gui.GetClassName> and <om win32gui.GetWindowText> for each costs several Python calls per window.
+// SnapshotWindows does the enumeration, filtering and attribute lookup natively, without
+// the Python lock, and builds the result once.
+// @rdesc A dictionary of equal length lists, keyed by 'hwnd' and each requested attribute.
+// The i'th item of every list describes the same window.
+static PyObject *PySnapshotWindows(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[] = {"parent", "attributes", "classFilter", "pids", "visibleOnly", NULL};
+	PyObject *obparent = Py_None, *obattrs = Py_None, *obclassfilter = Py_None, *obpids = Py_None;
+	BOOL visibleOnly = FALSE;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|OOOOi:SnapshotWindows", keywords,
+		&obparent,		// @pyparm <o PyHANDLE>|parent|None|If specified, all descendants of this window are
+						// returned, otherwise the top-level windows.  Pass <om win32gui.GetDesktopWindow> for every window on the desktop.
+		&obattrs,		// @pyparm (str, ...)|attributes|None|The attributes to return - any of 'class', 'text', 'rect' ((left, top, right, bottom) in screen coordinates),
+						// 'pid' and 'visible'.  The default is all of them.
+		&obclassfilter,	// @pyparm str|classFilter|None|Only windows whose class name matches this pattern are returned.  The '*' and '?'
+						// wildcards are supported and the match is case insensitive.
+		&obpids,		// @pyparm [int, ...]|pids|None|Only windows owned by one of these process ids are returned.
+		&visibleOnly))	// @pyparm bool|visibleOnly|False|Only visible windows are returned.
+		return NULL;
+
+	HWND hwndParent = NULL;
+	if (obparent != Py_None && !PyWinObject_AsHANDLE(obparent, (HANDLE *)&hwndParent))
+		return NULL;
+	int attrs = SNAPSHOT_CLASS | SNAPSHOT_TEXT | SNAPSHOT_RECT | SNAPSHOT_PID | SNAPSHOT_VISIBLE;
+	if (obattrs != Py_None){
+		attrs = 0;
+		DWORD nattrs;
+		PyObject *attr_tuple = PyWinSequence_Tuple(obattrs, &nattrs);
+		if (attr_tuple == NULL)
+			return NULL;
+		for (DWORD i = 0; i < nattrs; i++){
+			PyObject *obattr = PyTuple_GET_ITEM(attr_tuple, i);
+			const char *name = PyUnicode_Check(obattr) ? PyUnicode_AsUTF8(obattr) : NULL;
+			int bit = 0;
+			if (name){
+				if (strcmp(name, "class") == 0) bit = SNAPSHOT_CLASS;
+				else if (strcmp(name, "text") == 0) bit = SNAPSHOT_TEXT;
+				else if (strcmp(name, "rect") == 0) bit = SNAPSHOT_RECT;
+				else if (strcmp(name, "pid") == 0) bit = SNAPSHOT_PID;
+				else if (strcmp(name, "visible") == 0) bit = SNAPSHOT_VISIBLE;
+				}
+			if (bit == 0){
+				PyErr_Format(PyExc_ValueError, "Unknown window attribute %R", obattr);
+				Py_DECREF(attr_tuple);
+				return NULL;
+				}
+			attrs |= bit;
+			}
+		Py_DECREF(attr_tuple);
+		}
+	WCHAR *classFilter = NULL;
+	if (!PyWinObject_AsWCHAR(obclassfilter, &classFilter, TRUE))
+		return NULL;
+	DWORD *pids = NULL, npids = 0;
+	if (obpids != Py_None && !PyWinObject_AsDWORDArray(obpids, &pids, &npids, FALSE)){
+		PyWinObject_FreeWCHAR(classFilter);
+		return NULL;
+		}
+
+	PyWindowSnapshot snap;
+	memset(&snap, 0, sizeof(snap));
+	PyWindowSnapshotEntry *entries = NULL;
+	DWORD nentries = 0;
+	PyObject *ret = NULL;
+	Py_BEGIN_ALLOW_THREADS
+	if (hwndParent)
+		EnumChildWindows(hwndParent, PySnapshotWindowsProc, (LPARAM)&snap);
+	else
+		EnumWindows(PySnapshotWindowsProc, (LPARAM)&snap);
+	if (!snap.failed && snap.num_hwnds)
+		entries = (PyWindowSnapshotEntry *)malloc(snap.num_hwnds * sizeof(PyWindowSnapshotEntry));
+	for (DWORD i = 0; entries && !snap.failed && i < snap.num_hwnds; i++){
+		// Cheap tests first - windows may also have been destroyed since they were enumerated.
+		PyWindowSnapshotEntry *e = &entries[nentries];
+		e->hwnd = snap.hwnds[i];
+		e->visible = IsWindowVisible(e->hwnd);
+		if (visibleOnly && !e->visible)
+			continue;
+		e->pid = 0;
+		if (GetWindowThreadProcessId(e->hwnd, &e->pid) == 0)
+			continue;
+		if (npids){
+			DWORD j;
+			for (j = 0; j < npids && pids[j] != e->pid; j++)
+				;
+			if (j == npids)
+				continue;
+			}
+		WCHAR buf[512];
+		e->classOffset = e->textOffset = (size_t)-1;
+		if (classFilter || (attrs & SNAPSHOT_CLASS)){
+			int len = GetClassNameW(e->hwnd, buf, sizeof(buf)/sizeof(buf[0]));
+			if (len == 0)
+				continue;
+			buf[len] = 0;
+			if (classFilter && !PyWildcardMatch(classFilter, buf))
+				continue;
+			if (attrs & SNAPSHOT_CLASS)
+				e->classOffset = PySnapshotAddString(&snap, buf, len);
+			}
+		if (attrs & SNAPSHOT_TEXT){
+			int len = GetWindowTextW(e->hwnd, buf, sizeof(buf)/sizeof(buf[0]));
+			e->textOffset = PySnapshotAddString(&snap, buf, len);
+			}
+		if ((attrs & SNAPSHOT_RECT) && !GetWindowRect(e->hwnd, &e->rect))
+			memset(&e->rect, 0, sizeof(e->rect));
+		nentries++;
+		}
+	Py_END_ALLOW_THREADS
+
+	if (snap.failed || (snap.num_hwnds && entries == NULL)){
+		PyErr_NoMemory();
+		goto done;
+		}
+	ret = PyDict_New();
+	if (ret == NULL)
+		goto done;
+	{
+	PyObject *cols[6] = {NULL, NULL, NULL, NULL, NULL, NULL};
+	static const char *colnames[6] = {"hwnd", "class", "text", "rect", "pid", "visible"};
+	static const int colbits[6] = {-1, SNAPSHOT_CLASS, SNAPSHOT_TEXT, SNAPSHOT_RECT, SNAPSHOT_PID, SNAPSHOT_VISIBLE};
+	BOOL ok = TRUE;
+	for (int c = 0; c < 6 && ok; c++){
+		if (!(colbits[c] & attrs))
+			continue;
+		cols[c] = PyList_New(nentries);
+		ok = cols[c] != NULL && PyDict_SetItemString(ret, colnames[c], cols[c]) == 0;
+		}
+	for (DWORD i = 0; i < nentries && ok; i++){
+		PyWindowSnapshotEntry *e = &entries[i];
+		PyObject *items[6] = {
+			PyWinLong_FromHANDLE(e->hwnd),
+			cols[1] ? PyWinObject_FromWCHAR(snap.pool + e->classOffset) : NULL,
+			cols[2] ? PyWinObject_FromWCHAR(snap.pool + e->textOffset) : NULL,
+			cols[3] ? Py_BuildValue("llll", e->rect.left, e->rect.top, e->rect.right, e->rect.bottom) : NULL,
+			cols[4] ? PyLong_FromUnsignedLong(e->pid) : NULL,
+			cols[5] ? PyBool_FromLong(e->visible) : NULL,
+			};
+		for (int c = 0; c < 6; c++){
+			if (cols[c] == NULL)
+				continue;
+			if (items[c] == NULL)
+				ok = FALSE;
+			else
+				PyList_SET_ITEM(cols[c], i, items[c]);
+			}
+		}
+	for (int c = 0; c < 6; c++)
+		Py_XDECREF(cols[c]);
+	if (!ok)
+		Py_CLEAR(ret);
+	}
+done:
+	free(entries);
+	free(snap.hwnds);
+	free(snap.pool);
+	if (pids)
+		free(pids);
+	PyWinObject_FreeWCHAR(classFilter);
+	return ret;
+}
+
 #endif	/* not MS_WINCE */
 %}
 %native (EnumWindows) PyEnumWindows;
 #ifndef MS_WINCE
 %native (EnumThreadWindows) PyEnumThreadWindows;
 %native (EnumChildWindows) PyEnumChildWindows;
+%native (SnapshotWindows) PySnapshotWindows;
+#endif	/* not MS_WINCE */
+
+%{
+#ifndef MS_WINCE
+// An LVITEMW/TVITEMW followed by a text buffer, in the process which owns a common control.
+// The remote memory comes from the same per-process cache as SendMessageStruct.
+struct PyControlScrape {
+	PyRemotePayload *remote;	// NULL if the control belongs to this process
+	BYTE *local;				// our copy of the block
+	BYTE *base;					// address of the block in the control's process
+	SIZE_T hdrsize;				// size of the item struct - the text buffer follows it
+	SIZE_T size;
+	const char *failed;
+	PyWindowSnapshot text;		// pool of all the text read
+};
+
+// Called with the GIL held.
+static BOOL PyControlScrape_Init(PyControlScrape *scrape, HWND hwnd, SIZE_T hdrsize, DWORD textSize)
+{
+	memset(scrape, 0, sizeof(*scrape));
+	DWORD pid = 0;
+	if (GetWindowThreadProcessId(hwnd, &pid) == 0){
+		PyWin_SetAPIError("GetWindowThreadProcessId");
+		return FALSE;
+		}
+	scrape->hdrsize = (hdrsize + 7) & ~(SIZE_T)7;
+	scrape->size = scrape->hdrsize + (textSize + 1) * sizeof(WCHAR);
+	scrape->local = (BYTE *)calloc(scrape->size, 1);
+	if (scrape->local == NULL){
+		PyErr_NoMemory();
+		return FALSE;
+		}
+	scrape->base = scrape->local;
+	if (pid != GetCurrentProcessId()){
+		scrape->remote = PyRemotePayload_Acquire(pid, scrape->size);
+		if (scrape->remote == NULL){
+			free(scrape->local);
+			scrape->local = NULL;
+			return FALSE;
+			}
+		scrape->base = scrape->remote->remote;
+		}
+	return TRUE;
+}
+
+// Called with the GIL held.
+static void PyControlScrape_Release(PyControlScrape *scrape)
+{
+	if (scrape->remote)
+		scrape->remote->busy = FALSE;
+	free(scrape->local);
+	free(scrape->text.pool);
+}
+
+static BOOL PyControlScrape_Copy(PyControlScrape *scrape, BOOL bWrite, BYTE *remote_addr, BYTE *local_addr, SIZE_T len)
+{
+	if (scrape->remote == NULL){
+		if (remote_addr != local_addr)
+			memcpy(bWrite ? remote_addr : local_addr, bWrite ? local_addr : remote_addr, len);
+		return TRUE;
+		}
+	BOOL ok = bWrite ? WriteProcessMemory(scrape->remote->hprocess, remote_addr, local_addr, len, NULL)
+		: ReadProcessMemory(scrape->remote->hprocess, remote_addr, local_addr, len, NULL);
+	if (!ok)
+		scrape->failed = bWrite ? "WriteProcessMemory" : "ReadProcessMemory";
+	return ok;
+}
+
+// Adds the text the control returned to the pool.  'pszText' is where the item struct now says
+// the text is - controls are allowed to point it at their own buffer instead of filling ours.
+static size_t PyControlScrape_AddText(PyControlScrape *scrape, WCHAR *pszText, int cch)
+{
+	WCHAR *ours = (WCHAR *)(scrape->local + scrape->hdrsize);
+	DWORD maxcch = (DWORD)((scrape->size - scrape->hdrsize) / sizeof(WCHAR)) - 1;
+	if (pszText == NULL)
+		cch = 0;
+	else if ((BYTE *)pszText != scrape->base + scrape->hdrsize){
+		SIZE_T avail = (cch < 0 || (DWORD)cch > maxcch) ? maxcch : cch;
+		if (scrape->remote == NULL){
+			SIZE_T n;
+			for (n = 0; n < avail && pszText[n]; n++)
+				ours[n] = pszText[n];
+			avail = n;
+			}
+		// The control's own buffer may be shorter than ours - take nothing rather than fail.
+		else if (!PyControlScrape_Copy(scrape, FALSE, (BYTE *)pszText, (BYTE *)ours, avail * sizeof(WCHAR))){
+			scrape->failed = NULL;
+			avail = 0;
+			}
+		ours[avail] = 0;
+		cch = -1;
+		}
+	if (cch < 0 || (DWORD)cch > maxcch){
+		ours[maxcch] = 0;
+		cch = (int)wcslen(ours);
+		}
+	return PySnapshotAddString(&scrape->text, ours, cch);
+}
+
+// @pyswig [[str, ...], ...]|ListViewSnapshot|Returns the text of every item in a list view control,
+// which may belong to another process.
+// @comm The items are read with LVM_GETITEMTEXT through a single block of memory in the control's
+// process, without the Python lock, rather than with a sequence of remote memory calls per cell.
+// <nl>The control's process must have the same pointer size as Python.
+// @rdesc A list with a row per item, each a list of the text in the requested columns.
+static PyObject *PyListViewSnapshot(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[] = {"hwnd", "columns", "textSize", NULL};
+	PyObject *obhwnd, *obcolumns = Py_None;
+	DWORD textSize = 260;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|Ok:ListViewSnapshot", keywords,
+		&obhwnd,		// @pyparm <o PyHANDLE>|hwnd||Handle to a SysListView32 control
+		&obcolumns,		// @pyparm [int, ...]|columns|None|Indexes of the columns (subitems) to read.  By default, every column
+						// in the control's header is read, or just the item label if it has none.
+		&textSize))		// @pyparm int|textSize|260|Maximum number of characters read for each cell
+		return NULL;
+	HWND hwnd;
+	if (!PyWinObject_AsHANDLE(obhwnd, (HANDLE *)&hwnd))
+		return NULL;
+	DWORD *columns = NULL, ncolumns = 0, defcolumn = 0;
+	if (!PyWinObject_AsDWORDArray(obcolumns, &columns, &ncolumns, TRUE))
+		return NULL;
+	if (obcolumns == Py_None){
+		HWND hwndHeader = (HWND)SendMessage(hwnd, LVM_GETHEADER, 0, 0);
+		int nheader = hwndHeader ? (int)SendMessage(hwndHeader, HDM_GETITEMCOUNT, 0, 0) : 0;
+		if (nheader > 0){
+			columns = (DWORD *)malloc(nheader * sizeof(DWORD));
+			if (columns == NULL)
+				return PyErr_NoMemory();
+			for (ncolumns = 0; ncolumns < (DWORD)nheader; ncolumns++)
+				columns[ncolumns] = ncolumns;
+			}
+		}
+	DWORD *cols = columns ? columns : &defcolumn;
+	if (columns == NULL)
+		ncolumns = 1;
+
+	PyControlScrape scrape;
+	PyObject *ret = NULL;
+	size_t *offsets = NULL;
+	DWORD nitems = 0, i, c;
+	if (!PyControlScrape_Init(&scrape, hwnd, sizeof(LVITEMW), textSize))
+		goto done;
+	Py_BEGIN_ALLOW_THREADS
+	nitems = (DWORD)SendMessage(hwnd, LVM_GETITEMCOUNT, 0, 0);
+	if (nitems)
+		offsets = (size_t *)malloc((size_t)nitems * ncolumns * sizeof(size_t));
+	LVITEMW *lvi = (LVITEMW *)scrape.local;
+	for (i = 0; offsets && !scrape.failed && !scrape.text.failed && i < nitems; i++)
+		for (c = 0; c < ncolumns && !scrape.failed; c++){
+			memset(lvi, 0, sizeof(*lvi));
+			lvi->iSubItem = cols[c];
+			lvi->pszText = (WCHAR *)(scrape.base + scrape.hdrsize);
+			lvi->cchTextMax = textSize + 1;
+			if (!PyControlScrape_Copy(&scrape, TRUE, scrape.base, scrape.local, sizeof(*lvi)))
+				break;
+			int len = (int)SendMessage(hwnd, LVM_GETITEMTEXTW, i, (LPARAM)scrape.base);
+			if (len < 0)
+				len = 0;
+			else if ((DWORD)len > textSize)
+				len = textSize;
+			// one read for the item and the text which follows it
+			if (!PyControlScrape_Copy(&scrape, FALSE, scrape.base, scrape.local,
+				scrape.hdrsize + (len + 1) * sizeof(WCHAR)))
+				break;
+			offsets[i * ncolumns + c] = PyControlScrape_AddText(&scrape, lvi->pszText, len);
+			}
+	Py_END_ALLOW_THREADS
+	if (scrape.failed){
+		PyWin_SetAPIError((char *)scrape.failed);
+		goto done;
+		}
+	if (scrape.text.failed || (nitems && offsets == NULL)){
+		PyErr_NoMemory();
+		goto done;
+		}
+	ret = PyList_New(nitems);
+	for (i = 0; ret && i < nitems; i++){
+		PyObject *row = PyList_New(ncolumns);
+		for (c = 0; row && c < ncolumns; c++){
+			PyObject *text = PyWinObject_FromWCHAR(scrape.text.pool + offsets[i * ncolumns + c]);
+			if (text == NULL)
+				Py_CLEAR(row);
+			else
+				PyList_SET_ITEM(row, c, text);
+			}
+		if (row == NULL)
+			Py_CLEAR(ret);
+		else
+			PyList_SET_ITEM(ret, i, row);
+		}
+done:
+	PyControlScrape_Release(&scrape);
+	free(offsets);
+	if (columns)
+		free(columns);
+	return ret;
+}
+
+struct PyTreeSnapshotEntry {
+	HTREEITEM hitem;
+	HTREEITEM hparent;
+	int depth;
+	size_t textOffset;
+};
+
+// @pyswig [(int, int, int, str), ...]|TreeViewSnapshot|Returns the text of every item in a tree view
+// control, which may belong to another process.
+// @comm The tree is walked with TVM_GETNEXTITEM and the text read with TVM_GETITEM through a single
+// block of memory in the control's process, without the Python lock.  Only items which exist are
+// returned - the children of collapsed items that are filled in on demand are not.
+// <nl>The control's process must have the same pointer size as Python.
+// @rdesc A list of (hitem, hparent, depth, text) tuples in display order, with a parent always
+// before its children.  Top-level items have an hparent of 0 and a depth of 0.
+static PyObject *PyTreeViewSnapshot(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[] = {"hwnd", "textSize", NULL};
+	PyObject *obhwnd;
+	DWORD textSize = 260;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|k:TreeViewSnapshot", keywords,
+		&obhwnd,		// @pyparm <o PyHANDLE>|hwnd||Handle to a SysTreeView32 control
+		&textSize))		// @pyparm int|textSize|260|Maximum number of characters read for each item
+		return NULL;
+	HWND hwnd;
+	if (!PyWinObject_AsHANDLE(obhwnd, (HANDLE *)&hwnd))
+		return NULL;
+
+	PyControlScrape scrape;
+	PyObject *ret = NULL;
+	PyTreeSnapshotEntry *entries = NULL;
+	HTREEITEM *parents = NULL;
+	DWORD nentries = 0, maxentries = 0, i;
+	int depth = 0, maxdepth = 0;
+	BOOL nomem = FALSE;
+	if (!PyControlScrape_Init(&scrape, hwnd, sizeof(TVITEMW), textSize))
+		goto done;
+	Py_BEGIN_ALLOW_THREADS
+	TVITEMW *tvi = (TVITEMW *)scrape.local;
+	HTREEITEM hitem = (HTREEITEM)SendMessage(hwnd, TVM_GETNEXTITEM, TVGN_ROOT, 0);
+	while (hitem && !scrape.failed && !scrape.text.failed){
+		if (nentries == maxentries || depth == maxdepth){
+			// grow both arrays together - depth can never exceed the entry count
+			DWORD newmax = maxentries ? maxentries * 2 : 1024;
+			PyTreeSnapshotEntry *newentries = (PyTreeSnapshotEntry *)realloc(entries, newmax * sizeof(PyTreeSnapshotEntry));
+			if (newentries)
+				entries = newentries;
+			HTREEITEM *newparents = (HTREEITEM *)realloc(parents, (newmax + 1) * sizeof(HTREEITEM));
+			if (newparents)
+				parents = newparents;
+			if (newentries == NULL || newparents == NULL){
+				nomem = TRUE;
+				break;
+				}
+			maxentries = newmax;
+			maxdepth = newmax;
+			}
+		memset(tvi, 0, sizeof(*tvi));
+		tvi->mask = TVIF_TEXT | TVIF_HANDLE;
+		tvi->hItem = hitem;
+		tvi->pszText = (WCHAR *)(scrape.base + scrape.hdrsize);
+		tvi->cchTextMax = textSize + 1;
+		if (!PyControlScrape_Copy(&scrape, TRUE, scrape.base, scrape.local, sizeof(*tvi)))
+			break;
+		BOOL got = (BOOL)SendMessage(hwnd, TVM_GETITEMW, 0, (LPARAM)scrape.base);
+		if (!PyControlScrape_Copy(&scrape, FALSE, scrape.base, scrape.local, scrape.size))
+			break;
+		PyTreeSnapshotEntry *e = &entries[nentries++];
+		e->hitem = hitem;
+		e->hparent = depth ? parents[depth - 1] : NULL;
+		e->depth = depth;
+		e->textOffset = PyControlScrape_AddText(&scrape, got ? tvi->pszText : NULL, -1);
+
+		// Pre-order walk - first child, else next sibling, else the next sibling of the nearest ancestor.
+		HTREEITEM hnext = (HTREEITEM)SendMessage(hwnd, TVM_GETNEXTITEM, TVGN_CHILD, (LPARAM)hitem);
+		if (hnext){
+			parents[depth++] = hitem;
+			hitem = hnext;
+			continue;
+			}
+		hnext = (HTREEITEM)SendMessage(hwnd, TVM_GETNEXTITEM, TVGN_NEXT, (LPARAM)hitem);
+		while (hnext == NULL && depth > 0){
+			hitem = parents[--depth];
+			hnext = (HTREEITEM)SendMessage(hwnd, TVM_GETNEXTITEM, TVGN_NEXT, (LPARAM)hitem);
+			}
+		hitem = hnext;
+		}
+	Py_END_ALLOW_THREADS
+	if (scrape.failed){
+		PyWin_SetAPIError((char *)scrape.failed);
+		goto done;
+		}
+	if (nomem || scrape.text.failed){
+		PyErr_NoMemory();
+		goto done;
+		}
+	ret = PyList_New(nentries);
+	for (i = 0; ret && i < nentries; i++){
+		PyTreeSnapshotEntry *e = &entries[i];
+		PyObject *item = Py_BuildValue("NNiN", PyWinLong_FromHANDLE(e->hitem), PyWinLong_FromHANDLE(e->hparent),
+			e->depth, PyWinObject_FromWCHAR(scrape.text.pool + e->textOffset));
+		if (item == NULL)
+			Py_CLEAR(ret);
+		else
+			PyList_SET_ITEM(ret, i, item);
+		}
+done:
+	PyControlScrape_Release(&scrape);
+	free(entries);
+	free(parents);
+	return ret;
+}
+#endif	/* not MS_WINCE */
+%}
+#ifndef MS_WINCE
+%native (ListViewSnapshot) PyListViewSnapshot;
+%native (TreeViewSnapshot) PyTreeViewSnapshot;
 #endif	/* not MS_WINCE */
 
 
@@ -2720,6 +3635,11 @@ BOOLAPI BitBlt(
   DWORD dwRop  // @pyparm int|dwRop||raster operation code
 );
 
+#ifndef MS_WINCE
+// CreateScreenCapture is documented in win32screencapture.cpp
+%native (CreateScreenCapture) PyCreateScreenCapture;
+#endif	/* not MS_WINCE */
+
 // @pyswig |StretchBlt|Copies a bitmap from a source rectangle into a destination
 // rectangle, stretching or compressing the bitmap to fit the dimensions of the
 // destination rectangle, if necessary
@@ -3374,9 +4294,176 @@ static PyObject *PyPumpWaitingMessages(PyObject *self, PyObject *args)
 	return PyWinLong_FromVoidPtr((void *)result);
 }
 
+// @pyswig int|PumpMessagesEx|Runs a message loop which also waits for a set of handles,
+// until a WM_QUIT message is received or the timeout expires.
+// @rdesc The exit code from PostQuitMessage, or None if the timeout expired.
+// @comm Window messages are dispatched natively, as by <om win32gui.PumpMessages>, so
+// Python is only entered by the window procedures which are written in Python.
+// <nl>When more than one handle is signalled, the callbacks for all of them are called in
+// one batch, in the order of the handles.  Each callback is called with the handle as its
+// only argument.  If it returns False the handle is no longer waited for, otherwise it
+// stays in the set - a process or other handle which stays signalled should return False,
+// or it will be reported on every iteration.
+// <nl>The idle callback is called with no arguments each time the message queue has been
+// drained and no handle is signalled, before blocking.  If it returns True it is called
+// again straight away, unless messages or handles are waiting - so work can be done in
+// small slices while the window stays responsive.
+// <nl>An exception raised by a callback stops the loop and is raised by this function.
+// @xref <om win32gui.PumpMessages>
+static PyObject *PyPumpMessagesEx(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[] = {"handles", "timeout", "idle", NULL};
+	PyObject *obHandles = Py_None, *obIdle = Py_None;
+	DWORD timeout = INFINITE;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|OkO:PumpMessagesEx", keywords,
+		&obHandles, // @pyparm {<o PyHANDLE>: callable, ...}|handles|None|A dict mapping handles to the callbacks to call when they are signalled.  At most MAXIMUM_WAIT_OBJECTS-1 handles may be passed.
+		&timeout, // @pyparm int|timeout|win32event.INFINITE|The time in milliseconds to run the loop for.
+		&obIdle)) // @pyparm callable|idle|None|Called when there is nothing else to do.
+		return NULL;
+	if (obIdle != Py_None && !PyCallable_Check(obIdle))
+		return PyErr_Format(PyExc_TypeError, "idle must be callable");
+	if (obHandles != Py_None && !PyDict_Check(obHandles))
+		return PyErr_Format(PyExc_TypeError, "handles must be a dict mapping handles to callbacks");
+
+	HANDLE handles[MAXIMUM_WAIT_OBJECTS];
+	PyObject *obKeys[MAXIMUM_WAIT_OBJECTS];
+	PyObject *obCallbacks[MAXIMUM_WAIT_OBJECTS];
+	BOOL fired[MAXIMUM_WAIT_OBJECTS];
+	DWORD num = 0, i;
+	PyObject *ret = NULL;
+	DWORD start = GetTickCount();
+	BOOL bIdle = obIdle != Py_None;
+	if (obHandles != Py_None) {
+		if (PyDict_Size(obHandles) > MAXIMUM_WAIT_OBJECTS - 1)
+			return PyErr_Format(PyExc_ValueError, "At most %d handles can be waited for", MAXIMUM_WAIT_OBJECTS - 1);
+		Py_ssize_t pos = 0;
+		PyObject *key, *value;
+		while (PyDict_Next(obHandles, &pos, &key, &value)) {
+			if (!PyWinObject_AsHANDLE(key, &handles[num]))
+				goto done;
+			if (!PyCallable_Check(value)) {
+				PyErr_Format(PyExc_TypeError, "The callback for each handle must be callable");
+				goto done;
+			}
+			obKeys[num] = key;
+			Py_INCREF(key);
+			obCallbacks[num] = value;
+			Py_INCREF(value);
+			num++;
+		}
+	}
+
+	for (;;) {
+		// Drain the queue.
+		MSG msg;
+		BOOL bQuit = FALSE;
+		Py_BEGIN_ALLOW_THREADS
+		while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+			if (msg.message == WM_QUIT) {
+				bQuit = TRUE;
+				break;
+			}
+			if(NULL == hDialogCurrent || !IsDialogMessage(hDialogCurrent,&msg)) {
+				TranslateMessage(&msg);
+				DispatchMessage(&msg);
+			}
+		}
+		Py_END_ALLOW_THREADS
+		if (bQuit) {
+			ret = PyWinLong_FromVoidPtr((void *)msg.wParam);
+			break;
+		}
+
+		DWORD wait = INFINITE;
+		if (timeout != INFINITE) {
+			DWORD elapsed = GetTickCount() - start;
+			if (elapsed >= timeout) {
+				Py_INCREF(Py_None);
+				ret = Py_None;
+				break;
+			}
+			wait = timeout - elapsed;
+		}
+		if (bIdle) {
+			PyObject *obrc = PyObject_CallObject(obIdle, NULL);
+			if (obrc == NULL)
+				break;
+			bIdle = PyObject_IsTrue(obrc);
+			Py_DECREF(obrc);
+			if (bIdle == -1)
+				break;
+			if (bIdle)
+				wait = 0;
+		}
+
+		DWORD rc;
+		Py_BEGIN_ALLOW_THREADS
+		rc = MsgWaitForMultipleObjectsEx(num, handles, wait, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+		Py_END_ALLOW_THREADS
+		if (rc == WAIT_FAILED) {
+			PyWin_SetAPIError("MsgWaitForMultipleObjectsEx");
+			break;
+		}
+		if (rc == WAIT_TIMEOUT)
+			continue;
+		// Whatever woke us, the idle callback gets another chance once it has been handled.
+		bIdle = obIdle != Py_None;
+		if (rc == WAIT_OBJECT_0 + num)
+			continue;
+		DWORD first = rc >= WAIT_ABANDONED_0 ? rc - WAIT_ABANDONED_0 : rc - WAIT_OBJECT_0;
+		// The wait reports the lowest signalled index - check the ones after it, so a
+		// burst is handled in a single batch.
+		for (i=0;i<num;i++) {
+			if (i < first)
+				fired[i] = FALSE;
+			else if (i == first)
+				fired[i] = TRUE;
+			else {
+				DWORD polled = WaitForSingleObject(handles[i], 0);
+				fired[i] = polled == WAIT_OBJECT_0 || polled == WAIT_ABANDONED;
+			}
+		}
+		BOOL bError = FALSE;
+		for (i=0;i<num && !bError;i++) {
+			if (!fired[i])
+				continue;
+			PyObject *obrc = PyObject_CallFunctionObjArgs(obCallbacks[i], obKeys[i], NULL);
+			if (obrc == NULL)
+				bError = TRUE;
+			else if (obrc == Py_False) {
+				// Drop it once the batch is done.
+				fired[i] = -1;
+			}
+			Py_XDECREF(obrc);
+		}
+		DWORD kept = 0;
+		for (i=0;i<num;i++) {
+			if (fired[i] == -1) {
+				Py_DECREF(obKeys[i]);
+				Py_DECREF(obCallbacks[i]);
+				continue;
+			}
+			handles[kept] = handles[i];
+			obKeys[kept] = obKeys[i];
+			obCallbacks[kept] = obCallbacks[i];
+			kept++;
+		}
+		num = kept;
+		if (bError)
+			break;
+	}
+done:
+	for (i=0;i<num;i++) {
+		Py_DECREF(obKeys[i]);
+		Py_DECREF(obCallbacks[i]);
+	}
+	return ret;
+}
+
 %}
 %native (PumpMessages) PyPumpMessages;
 %native (PumpWaitingMessages) PyPumpWaitingMessages;
+%native (PumpMessagesEx) PyPumpMessagesEx;
 
 // @pyswig MSG|GetMessage|
 BOOL GetMessage(MSG *OUTPUT, 
@@ -5118,6 +6205,25 @@ BOOL PyWinObject_AsPOINTArray(PyObject *obpoints, POINT **ppoints, DWORD *item_c
 	*ppoints=NULL;
 	*item_cnt=0;
 
+	// A buffer of int32 pairs is copied directly, with no per-point tuple parsing
+	Py_buffer view;
+	int isbuf=PyWinObject_AsPOINTBuffer(obpoints, &view, item_cnt);
+	if (isbuf==-1)
+		return FALSE;
+	if (isbuf==1){
+		bufsize=*item_cnt * sizeof(POINT);
+		*ppoints=(POINT *)malloc(bufsize ? bufsize : 1);
+		if (*ppoints==NULL){
+			PyErr_Format(PyExc_MemoryError, "Unable to allocate %d bytes", bufsize);
+			*item_cnt=0;
+			ret=FALSE;
+			}
+		else
+			memcpy(*ppoints, view.buf, bufsize);
+		PyBuffer_Release(&view);
+		return ret;
+		}
+
 	if ((points_tuple=PyWinSequence_Tuple(obpoints, item_cnt))==NULL)
 		return FALSE;
 
@@ -5180,7 +6286,7 @@ static PyObject *PyPolyline(PyObject *self, PyObject *args)
 	PyObject *obpoints, *obdc, *ret=NULL;
 	if (!PyArg_ParseTuple(args, "OO:Polyline", 
 		&obdc,		// @pyparm <o PyHANDLE>|hdc||Handle to a device context
-		&obpoints))	// @pyparm [(int,int),...]|Points||Sequence of POINT tuples: ((x,y),...)
+		&obpoints))	// @pyparm [(int,int),...]|Points||Sequence of POINT tuples: ((x,y),...), or a buffer of 32 bit (x,y) pairs such as array.array('i')
 		return NULL;
 	if (!PyWinObject_AsHANDLE(obdc, (HANDLE *)&hdc))
 		return NULL;
@@ -5197,6 +6303,51 @@ static PyObject *PyPolyline(PyObject *self, PyObject *args)
 	return ret;
 }
 
+// @pyswig |PolyPolyline|Draws several series of connected line segments in a single call
+// @comm Drawing many short lines with one PolyPolyline call is much faster than making
+// a <om win32gui.Polyline> call for each of them.
+static PyObject *PyPolyPolyline(PyObject *self, PyObject *args)
+{
+	HDC hdc;
+	POINT *points=NULL;
+	DWORD *counts=NULL;
+	DWORD point_cnt, count_cnt, total=0;
+	PyObject *obpoints, *obcounts, *obdc, *ret=NULL;
+	BOOL bsuccess;
+	if (!PyArg_ParseTuple(args, "OOO:PolyPolyline",
+		&obdc,		// @pyparm <o PyHANDLE>|hdc||Handle to a device context
+		&obpoints,	// @pyparm [(int,int),...]|Points||Sequence of POINT tuples for all the polylines, or a buffer of 32 bit (x,y) pairs
+		&obcounts))	// @pyparm [int,...]|PolyCounts||Number of points in each polyline
+		return NULL;
+	if (!PyWinObject_AsHANDLE(obdc, (HANDLE *)&hdc))
+		return NULL;
+	if (!PyWinObject_AsDWORDArray(obcounts, &counts, &count_cnt, FALSE))
+		return NULL;
+	for (DWORD i=0; i<count_cnt; i++)
+		total+=counts[i];
+	if (!PyWinObject_AsPOINTArray(obpoints, &points, &point_cnt))
+		goto done;
+	if (total!=point_cnt){
+		PyErr_Format(PyExc_ValueError, "PolyCounts add up to %d points, but %d were supplied", total, point_cnt);
+		goto done;
+		}
+	Py_BEGIN_ALLOW_THREADS
+	bsuccess=PolyPolyline(hdc, points, counts, count_cnt);
+	Py_END_ALLOW_THREADS
+	if (!bsuccess)
+		PyWin_SetAPIError("PolyPolyline");
+	else{
+		Py_INCREF(Py_None);
+		ret=Py_None;
+		}
+done:
+	if (points)
+		free(points);
+	if (counts)
+		free(counts);
+	return ret;
+}
+
 // @pyswig |PolylineTo|Draws a series of lines starting from current position.  Updates current position with end point.
 static PyObject *PyPolylineTo(PyObject *self, PyObject *args)
 {
@@ -5346,6 +6497,7 @@ static PyObject *PyCreatePolygonRgn(PyObject *self, PyObject *args)
 %native (Polygon) PyPolygon;
 %native (Polyline) PyPolyline;
 %native (PolylineTo) PyPolylineTo;
+%native (PolyPolyline) PyPolyPolyline;
 %native (PolyBezier) PyPolyBezier;
 %native (PolyBezierTo) PyPolyBezierTo;
 %native (PlgBlt) PyPlgBlt;
@@ -7603,6 +8755,13 @@ PyObject *PyRegisterDeviceNotification(PyObject *self, PyObject *args)
 // handle values may be extracted via the struct module and need to be closed explicitly.
 BOOLAPI UnregisterDeviceNotification(HANDLE);
 
+#ifndef MS_WINCE
+// The raw input functions are documented in win32rawinput.cpp
+%native(RegisterRawInputDevices) PyRegisterRawInputDevices;
+%native(GetRegisteredRawInputDevices) PyGetRegisteredRawInputDevices;
+%native(GetRawInputBuffer) PyGetRawInputBuffer;
+#endif	/* not MS_WINCE */
+
 // @pyswig |RegisterHotKey|Registers a hotkey for a window
 // @pyseeapi RegisterHotKey
 // @pyparm <o PyHANDLE>|hWnd||Handle to window that will receive WM_HOTKEY messages
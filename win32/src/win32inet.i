@@ -746,6 +746,91 @@ done:
 %}
 %native (InternetReadFile) PyInternetReadFile;
 
+%{
+// @pyswig int|InternetReadFileInto|Reads data from an internet handle into an existing buffer.
+// @comm Like <om win32inet.InternetReadFile>, but reads directly into the memory of the
+// buffer rather than creating a new string for each call.
+PyObject *PyInternetReadFileInto(PyObject *self, PyObject *args)
+{
+	PyObject *obH, *obBuffer;
+	HINTERNET hiin;
+	DWORD read = 0;
+	BOOL ok;
+	if (!PyArg_ParseTuple(args, "OO:InternetReadFileInto",
+		&obH,		// @pyparm <o PyHINTERNET>|hInternet||Handle to read from
+		&obBuffer))	// @pyparm buffer|Buffer||Writable buffer object, such as a bytearray or memoryview
+		return NULL;
+	if (!PyWinObject_AsHANDLE(obH, (HANDLE *)&hiin))
+		return NULL;
+	PyWinBufferView pybuf(obBuffer, true);
+	if (!pybuf.ok())
+		return NULL;
+	if (pybuf.len()==0)
+		return PyErr_Format(PyExc_ValueError, "Can't read zero bytes");
+	Py_BEGIN_ALLOW_THREADS
+	ok = InternetReadFile(hiin, pybuf.ptr(), pybuf.len(), &read);
+	Py_END_ALLOW_THREADS
+	if (!ok)
+		return PyWin_SetAPIError("InternetReadFile");
+	// @rdesc Returns the number of bytes placed at the start of the buffer, which is 0
+	// when the end is reached.
+	return PyLong_FromUnsignedLong(read);
+}
+%}
+%native (InternetReadFileInto) PyInternetReadFileInto;
+
+%{
+// @pyswig long|InternetReadFileToHandle|Copies all remaining data from an internet handle to a file.
+// @comm The whole transfer happens with the GIL released, reusing a single buffer, so
+// downloading a large file takes no Python calls per chunk.
+PyObject *PyInternetReadFileToHandle(PyObject *self, PyObject *args)
+{
+	PyObject *obH, *obFile;
+	HINTERNET hiin;
+	HANDLE hFile;
+	DWORD bufsize = 65536;
+	if (!PyArg_ParseTuple(args, "OO|k:InternetReadFileToHandle",
+		&obH,		// @pyparm <o PyHINTERNET>|hInternet||Handle to read from
+		&obFile,	// @pyparm <o PyHANDLE>|File||Handle to a file, pipe or other object opened for
+					// synchronous writing, as accepted by WriteFile
+		&bufsize))	// @pyparm int|BufferSize|65536|Size of the buffer used for each read
+		return NULL;
+	if (bufsize==0)
+		return PyErr_Format(PyExc_ValueError, "BufferSize can't be zero");
+	if (!PyWinObject_AsHANDLE(obH, (HANDLE *)&hiin))
+		return NULL;
+	if (!PyWinObject_AsHANDLE(obFile, &hFile))
+		return NULL;
+	char *buf = (char *)malloc(bufsize);
+	if (buf == NULL)
+		return PyErr_NoMemory();
+	ULONGLONG total = 0;
+	DWORD read, written;
+	char *failed = NULL;
+	Py_BEGIN_ALLOW_THREADS
+	while (1) {
+		if (!InternetReadFile(hiin, buf, bufsize, &read)) {
+			failed = "InternetReadFile";
+			break;
+		}
+		if (read == 0)
+			break;
+		if (!WriteFile(hFile, buf, read, &written, NULL)) {
+			failed = "WriteFile";
+			break;
+		}
+		total += read;
+	}
+	Py_END_ALLOW_THREADS
+	free(buf);
+	if (failed)
+		return PyWin_SetAPIError(failed);
+	// @rdesc Returns the number of bytes copied.
+	return PyLong_FromUnsignedLongLong(total);
+}
+%}
+%native (InternetReadFileToHandle) PyInternetReadFileToHandle;
+
 %{
 // @pyswig int|InternetWriteFile|Writes data to a handle opened by <om win32inet.FtpOpenFile>.
 PyObject *PyInternetWriteFile(PyObject *self, PyObject *args)
@@ -1940,12 +2025,15 @@ extern PyObject *PyWinHttpGetIEProxyConfigForCurrentUser(PyObject *, PyObject *)
 extern PyObject *PyWinHttpGetDefaultProxyConfiguration(PyObject *, PyObject *);
 extern PyObject *PyWinHttpGetProxyForUrl(PyObject *, PyObject *);
 extern PyObject *PyWinHttpOpen(PyObject *, PyObject *);
+extern PyObject *PyWinHttpAsyncSession(PyObject *, PyObject *, PyObject *);
+PyCFunction pfnPyWinHttpAsyncSession = (PyCFunction)PyWinHttpAsyncSession;
 %}
 
 %native(WinHttpGetIEProxyConfigForCurrentUser) PyWinHttpGetIEProxyConfigForCurrentUser;
 %native(WinHttpGetDefaultProxyConfiguration) PyWinHttpGetDefaultProxyConfiguration;
 %native(WinHttpGetProxyForUrl) PyWinHttpGetProxyForUrl;
 %native(WinHttpOpen) PyWinHttpOpen;
+%native(WinHttpAsyncSession) pfnPyWinHttpAsyncSession;
 
 %init %{
 	PyDict_SetItemString(d,	"error", PyWinExc_ApiError);
@@ -1974,6 +2062,7 @@ extern PyObject *PyWinHttpOpen(PyObject *, PyObject *);
 			||(strcmp(pmd->ml_name, "CommitUrlCacheEntry")==0)
 			||(strcmp(pmd->ml_name, "SetUrlCacheEntryGroup")==0)
 			||(strcmp(pmd->ml_name, "SetUrlCacheGroupAttribute")==0)
+			||(strcmp(pmd->ml_name, "WinHttpAsyncSession")==0)
 			){
 			pmd->ml_flags =	METH_VARARGS | METH_KEYWORDS;
 			}
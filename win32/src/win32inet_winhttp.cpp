@@ -9,6 +9,7 @@
 #include "pywintypes.h"
 #include "pywinobjects.h"
 #include "winhttp.h"
+#include "structmember.h"
 
 // @doc
 typedef BOOL(WINAPI *funcWinHttpGetIEProxyConfigForCurrentUser)(WINHTTP_CURRENT_USER_IE_PROXY_CONFIG *);
@@ -26,6 +27,37 @@ static funcWinHttpOpen pfnWinHttpOpen = NULL;
 typedef BOOL(WINAPI *funcWinHttpCloseHandle)(HINTERNET);
 static funcWinHttpCloseHandle pfnWinHttpCloseHandle = NULL;
 
+typedef HINTERNET(WINAPI *funcWinHttpConnect)(HINTERNET, LPCWSTR, INTERNET_PORT, DWORD);
+static funcWinHttpConnect pfnWinHttpConnect = NULL;
+
+typedef HINTERNET(WINAPI *funcWinHttpOpenRequest)(HINTERNET, LPCWSTR, LPCWSTR, LPCWSTR, LPCWSTR, LPCWSTR *, DWORD);
+static funcWinHttpOpenRequest pfnWinHttpOpenRequest = NULL;
+
+typedef BOOL(WINAPI *funcWinHttpSendRequest)(HINTERNET, LPCWSTR, DWORD, LPVOID, DWORD, DWORD, DWORD_PTR);
+static funcWinHttpSendRequest pfnWinHttpSendRequest = NULL;
+
+typedef BOOL(WINAPI *funcWinHttpReceiveResponse)(HINTERNET, LPVOID);
+static funcWinHttpReceiveResponse pfnWinHttpReceiveResponse = NULL;
+
+typedef BOOL(WINAPI *funcWinHttpQueryHeaders)(HINTERNET, DWORD, LPCWSTR, LPVOID, LPDWORD, LPDWORD);
+static funcWinHttpQueryHeaders pfnWinHttpQueryHeaders = NULL;
+
+typedef BOOL(WINAPI *funcWinHttpReadData)(HINTERNET, LPVOID, DWORD, LPDWORD);
+static funcWinHttpReadData pfnWinHttpReadData = NULL;
+
+typedef BOOL(WINAPI *funcWinHttpQueryDataAvailable)(HINTERNET, LPDWORD);
+static funcWinHttpQueryDataAvailable pfnWinHttpQueryDataAvailable = NULL;
+
+typedef WINHTTP_STATUS_CALLBACK(WINAPI *funcWinHttpSetStatusCallback)(HINTERNET, WINHTTP_STATUS_CALLBACK, DWORD,
+                                                                      DWORD_PTR);
+static funcWinHttpSetStatusCallback pfnWinHttpSetStatusCallback = NULL;
+
+typedef BOOL(WINAPI *funcWinHttpSetOption)(HINTERNET, DWORD, LPVOID, DWORD);
+static funcWinHttpSetOption pfnWinHttpSetOption = NULL;
+
+typedef BOOL(WINAPI *funcWinHttpCrackUrl)(LPCWSTR, DWORD, DWORD, LPURL_COMPONENTS);
+static funcWinHttpCrackUrl pfnWinHttpCrackUrl = NULL;
+
 #define CHECK_PFN(fname)    \
     if (pfn##fname == NULL) \
         return PyErr_Format(PyExc_NotImplementedError, "%s is not available on this platform", #fname);
@@ -39,8 +71,11 @@ static FARPROC loadwinhttpfunc(char *funcname, HMODULE hmodule)
     return GetProcAddress(hmodule, funcname);
 }
 
+extern PyTypeObject PyWINHTTP_SESSIONType;
+
 void init_win32inetstuff()
 {
+    PyType_Ready(&PyWINHTTP_SESSIONType);
     HMODULE hmod = LoadLibrary(_T("Winhttp.dll"));
     if (!hmod)
         return;  // nothing else to do!
@@ -49,6 +84,16 @@ void init_win32inetstuff()
     LOAD_PFN(WinHttpOpen);
     LOAD_PFN(WinHttpCloseHandle);
     LOAD_PFN(WinHttpGetDefaultProxyConfiguration);
+    LOAD_PFN(WinHttpConnect);
+    LOAD_PFN(WinHttpOpenRequest);
+    LOAD_PFN(WinHttpSendRequest);
+    LOAD_PFN(WinHttpReceiveResponse);
+    LOAD_PFN(WinHttpQueryHeaders);
+    LOAD_PFN(WinHttpReadData);
+    LOAD_PFN(WinHttpQueryDataAvailable);
+    LOAD_PFN(WinHttpSetStatusCallback);
+    LOAD_PFN(WinHttpSetOption);
+    LOAD_PFN(WinHttpCrackUrl);
     // winhttp.dll also provides the string resources for its errors.
     PyWin_RegisterErrorMessageModule(WINHTTP_ERROR_BASE, WINHTTP_ERROR_LAST, hmod);
 }
@@ -273,3 +318,664 @@ done:
         PyWinObject_FreeWCHAR(proxy_bypass);
     return ret;
 }
+
+/////////////////////////////////////////////////////////////////////////////
+// PyWINHTTP_SESSION - an asynchronous WinHttp client.
+//
+// All network activity is driven by WinHttp's own threads through
+// PyWINHTTP_SESSION::Callback, which never touches Python.  Finished requests
+// are queued, and handed to Python in batches by GetCompletions.
+
+// Only defined by the Windows 10 SDK and later
+#ifndef WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL
+#define WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL 133
+#endif
+#ifndef WINHTTP_PROTOCOL_FLAG_HTTP2
+#define WINHTTP_PROTOCOL_FLAG_HTTP2 0x1
+#endif
+
+// How much the body buffer grows by when the caller doesn't supply one
+#define WINHTTP_READ_CHUNK 65536
+
+class PyWINHTTP_SESSION;
+
+// A cached connect handle - WinHttp keeps its pool of connections per connect
+// handle, so all requests to the same host and port share them.
+struct WINHTTP_CONNECTION {
+    WCHAR *host;
+    INTERNET_PORT port;
+    HINTERNET hconnect;
+    WINHTTP_CONNECTION *next;
+};
+
+// The native state of a single request.  One reference is held by the
+// session until the completion has been returned to Python, and another by
+// the request handle until WINHTTP_CALLBACK_STATUS_HANDLE_CLOSING.
+struct WINHTTP_REQUEST {
+    LONG refs;
+    PyWINHTTP_SESSION *session;
+    // Protected by the session's critical section
+    HINTERNET hrequest;
+    BOOL bQueued;
+    WINHTTP_REQUEST *next;  // Completion queue
+    // Only touched with the GIL held
+    WINHTTP_REQUEST *pyprev, *pynext;  // Requests not yet returned by GetCompletions
+    PyObject *obcontext;
+    Py_buffer bodyview, outview;
+    BOOL bHaveBodyView, bHaveOutView;
+    // Only touched by the callback until the request is queued
+    BYTE *out;  // Either outview.buf, or malloc'ed
+    DWORD outlen, outcap;
+    BOOL bOwnOut;
+    DWORD statuscode;
+    WCHAR *headers;
+    DWORD err;
+};
+
+static void ReleaseWinHttpRequest(WINHTTP_REQUEST *req)
+{
+    if (InterlockedDecrement(&req->refs) != 0)
+        return;
+    if (req->bOwnOut)
+        free(req->out);
+    free(req->headers);
+    free(req);
+}
+
+class PyWINHTTP_SESSION : public PyObject {
+   public:
+    PyWINHTTP_SESSION(void);
+    ~PyWINHTTP_SESSION(void);
+    static void deallocFunc(PyObject *ob);
+    static PyObject *PyRequest(PyObject *self, PyObject *args, PyObject *kwargs);
+    static PyObject *PyGetCompletions(PyObject *self, PyObject *args, PyObject *kwargs);
+    static PyObject *PyClose(PyObject *self, PyObject *args);
+    static void CALLBACK Callback(HINTERNET hinternet, DWORD_PTR context, DWORD status, LPVOID info, DWORD infolen);
+    static struct PyMethodDef methods[];
+    static struct PyMemberDef members[];
+
+    BOOL Open(WCHAR *useragent, DWORD accesstype, BOOL enablehttp2);
+    void Close(void);
+    HINTERNET GetConnection(WCHAR *host, INTERNET_PORT port);
+    void Complete(WINHTTP_REQUEST *req, DWORD err);
+    BOOL ReadMore(WINHTTP_REQUEST *req);
+    PyObject *PopCompletion(void);
+    void Forget(WINHTTP_REQUEST *req);
+
+    DWORD numpending;  // Requests whose completion hasn't been returned yet
+    BOOL bHttp2;
+
+   protected:
+    HINTERNET hsession;
+    WINHTTP_CONNECTION *connections;
+    CRITICAL_SECTION cs;
+    HANDLE hready;  // Manual-reset, signalled while the completion queue isn't empty
+    HANDLE hidle;   // Manual-reset, signalled while no request handles are open
+    WINHTTP_REQUEST *head, **tail;
+    WINHTTP_REQUEST *pending;
+    LONG numhandles;
+    BOOL bBusy;
+};
+
+// @object PyWINHTTP_SESSION|An asynchronous WinHttp session, created by <om win32inet.WinHttpAsyncSession>.
+// @comm Requests are started by <om PyWINHTTP_SESSION.Request> and run entirely on WinHttp's own
+// threads, without needing the GIL.  Finished requests are collected in batches by
+// <om PyWINHTTP_SESSION.GetCompletions>, so a single Python thread can keep many requests in flight.
+// @comm Connect handles are cached per host and port, so requests to the same server reuse
+// WinHttp's pooled connections, and HTTP/2 is enabled where the OS supports it.
+struct PyMethodDef PyWINHTTP_SESSION::methods[] = {
+    {"Request", (PyCFunction)PyWINHTTP_SESSION::PyRequest,
+     METH_VARARGS | METH_KEYWORDS},  // @pymeth Request|Starts a request
+    {"GetCompletions", (PyCFunction)PyWINHTTP_SESSION::PyGetCompletions,
+     METH_VARARGS | METH_KEYWORDS},  // @pymeth GetCompletions|Waits for requests to finish
+    {"Close", PyWINHTTP_SESSION::PyClose, METH_NOARGS},  // @pymeth Close|Cancels outstanding requests and closes the session
+    {NULL}};
+
+struct PyMemberDef PyWINHTTP_SESSION::members[] = {
+    // @prop int|Pending|Number of requests whose completion hasn't been returned yet
+    {"Pending", T_ULONG, offsetof(PyWINHTTP_SESSION, numpending), READONLY},
+    // @prop boolean|Http2|True if HTTP/2 was enabled for the session
+    {"Http2", T_INT, offsetof(PyWINHTTP_SESSION, bHttp2), READONLY},
+    {NULL}};
+
+PyTypeObject PyWINHTTP_SESSIONType = {
+    PYWIN_OBJECT_HEAD "PyWINHTTP_SESSION",
+    sizeof(PyWINHTTP_SESSION),
+    0,
+    PyWINHTTP_SESSION::deallocFunc,  // tp_dealloc
+    0,                               // tp_print
+    0,                               // tp_getattr
+    0,                               // tp_setattr
+    0,                               // tp_compare
+    0,                               // tp_repr
+    0,                               // tp_as_number
+    0,                               // tp_as_sequence
+    0,                               // tp_as_mapping
+    0,                               // tp_hash
+    0,                               // tp_call
+    0,                               // tp_str
+    PyObject_GenericGetAttr,         // tp_getattro
+    PyObject_GenericSetAttr,         // tp_setattro
+    0,                               // tp_as_buffer
+    Py_TPFLAGS_DEFAULT,              // tp_flags
+    0,                               // tp_doc
+    0,                               // tp_traverse
+    0,                               // tp_clear
+    0,                               // tp_richcompare
+    0,                               // tp_weaklistoffset
+    0,                               // tp_iter
+    0,                               // tp_iternext
+    PyWINHTTP_SESSION::methods,      // tp_methods
+    PyWINHTTP_SESSION::members,      // tp_members
+};
+
+PyWINHTTP_SESSION::PyWINHTTP_SESSION(void)
+{
+    ob_type = &PyWINHTTP_SESSIONType;
+    _Py_NewReference(this);
+    hsession = NULL;
+    connections = NULL;
+    InitializeCriticalSection(&cs);
+    hready = CreateEvent(NULL, TRUE, FALSE, NULL);
+    hidle = CreateEvent(NULL, TRUE, TRUE, NULL);
+    head = NULL;
+    tail = &head;
+    pending = NULL;
+    numpending = 0;
+    numhandles = 0;
+    bHttp2 = FALSE;
+    bBusy = FALSE;
+}
+
+PyWINHTTP_SESSION::~PyWINHTTP_SESSION(void)
+{
+    Close();
+    if (hready)
+        CloseHandle(hready);
+    if (hidle)
+        CloseHandle(hidle);
+    DeleteCriticalSection(&cs);
+}
+
+void PyWINHTTP_SESSION::deallocFunc(PyObject *ob) { delete (PyWINHTTP_SESSION *)ob; }
+
+BOOL PyWINHTTP_SESSION::Open(WCHAR *useragent, DWORD accesstype, BOOL enablehttp2)
+{
+    if (hready == NULL || hidle == NULL) {
+        PyWin_SetAPIError("CreateEvent");
+        return FALSE;
+    }
+    HINTERNET h;
+    Py_BEGIN_ALLOW_THREADS h = (*pfnWinHttpOpen)(useragent, accesstype, WINHTTP_NO_PROXY_NAME,
+                                                 WINHTTP_NO_PROXY_BYPASS, WINHTTP_FLAG_ASYNC);
+    Py_END_ALLOW_THREADS if (h == NULL)
+    {
+        PyWin_SetAPIError("WinHttpOpen");
+        return FALSE;
+    }
+    if ((*pfnWinHttpSetStatusCallback)(h, Callback, WINHTTP_CALLBACK_FLAG_ALL_COMPLETIONS | WINHTTP_CALLBACK_FLAG_HANDLES,
+                                       0) == WINHTTP_INVALID_STATUS_CALLBACK) {
+        PyWin_SetAPIError("WinHttpSetStatusCallback");
+        (*pfnWinHttpCloseHandle)(h);
+        return FALSE;
+    }
+    hsession = h;
+    // Older versions of Windows don't know the option, in which case we just stay on HTTP/1.1
+    if (enablehttp2) {
+        DWORD protocols = WINHTTP_PROTOCOL_FLAG_HTTP2;
+        bHttp2 = (*pfnWinHttpSetOption)(h, WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL, &protocols, sizeof(protocols));
+    }
+    return TRUE;
+}
+
+void PyWINHTTP_SESSION::Close(void)
+{
+    if (hsession == NULL)
+        return;
+    // Marks the session as closed while the GIL is released below
+    HINTERNET h = hsession;
+    hsession = NULL;
+    // Closing a request handle cancels whatever it is doing.
+    WINHTTP_REQUEST *req;
+    EnterCriticalSection(&cs);
+    for (req = pending; req; req = req->pynext)
+        if (req->hrequest) {
+            HINTERNET hrequest = req->hrequest;
+            req->hrequest = NULL;
+            (*pfnWinHttpCloseHandle)(hrequest);
+        }
+    LeaveCriticalSection(&cs);
+    Py_BEGIN_ALLOW_THREADS WaitForSingleObject(hidle, INFINITE);
+    Py_END_ALLOW_THREADS
+    // The last callback signals hidle while still holding the lock, so wait for it to let go
+    EnterCriticalSection(&cs);
+    LeaveCriticalSection(&cs);
+    while (pending) Forget(pending);
+    head = NULL;
+    tail = &head;
+    ResetEvent(hready);
+    WINHTTP_CONNECTION *conn;
+    while ((conn = connections) != NULL) {
+        connections = conn->next;
+        (*pfnWinHttpCloseHandle)(conn->hconnect);
+        free(conn->host);
+        free(conn);
+    }
+    (*pfnWinHttpSetStatusCallback)(h, NULL, WINHTTP_CALLBACK_FLAG_ALL_NOTIFICATIONS, 0);
+    (*pfnWinHttpCloseHandle)(h);
+}
+
+HINTERNET PyWINHTTP_SESSION::GetConnection(WCHAR *host, INTERNET_PORT port)
+{
+    WINHTTP_CONNECTION *conn;
+    for (conn = connections; conn; conn = conn->next)
+        if (conn->port == port && _wcsicmp(conn->host, host) == 0)
+            return conn->hconnect;
+    size_t hostlen = wcslen(host) + 1;
+    conn = (WINHTTP_CONNECTION *)malloc(sizeof(WINHTTP_CONNECTION));
+    WCHAR *hostcopy = (WCHAR *)malloc(hostlen * sizeof(WCHAR));
+    if (conn == NULL || hostcopy == NULL) {
+        free(conn);
+        free(hostcopy);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    // Only sets up the handle, no network activity happens until a request is sent
+    HINTERNET hconnect = (*pfnWinHttpConnect)(hsession, host, port, 0);
+    if (hconnect == NULL) {
+        free(conn);
+        free(hostcopy);
+        PyWin_SetAPIError("WinHttpConnect");
+        return NULL;
+    }
+    memcpy(hostcopy, host, hostlen * sizeof(WCHAR));
+    conn->host = hostcopy;
+    conn->port = port;
+    conn->hconnect = hconnect;
+    conn->next = connections;
+    connections = conn;
+    return hconnect;
+}
+
+// Queues a finished request and closes its handle.  Only the first call for a request has any effect.
+void PyWINHTTP_SESSION::Complete(WINHTTP_REQUEST *req, DWORD err)
+{
+    EnterCriticalSection(&cs);
+    if (req->bQueued) {
+        LeaveCriticalSection(&cs);
+        return;
+    }
+    req->bQueued = TRUE;
+    req->err = err;
+    HINTERNET h = req->hrequest;
+    req->hrequest = NULL;
+    req->next = NULL;
+    *tail = req;
+    tail = &req->next;
+    SetEvent(hready);
+    LeaveCriticalSection(&cs);
+    if (h)
+        (*pfnWinHttpCloseHandle)(h);
+}
+
+// Starts reading the next chunk of the body.  Once a caller supplied buffer
+// is full, checks if there is any more data so overflow can be reported.
+BOOL PyWINHTTP_SESSION::ReadMore(WINHTTP_REQUEST *req)
+{
+    if (req->outlen == req->outcap) {
+        if (!req->bOwnOut)
+            return (*pfnWinHttpQueryDataAvailable)(req->hrequest, NULL);
+        BYTE *out = (BYTE *)realloc(req->out, req->outcap + WINHTTP_READ_CHUNK);
+        if (out == NULL) {
+            SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+            return FALSE;
+        }
+        req->out = out;
+        req->outcap += WINHTTP_READ_CHUNK;
+    }
+    return (*pfnWinHttpReadData)(req->hrequest, req->out + req->outlen, req->outcap - req->outlen, NULL);
+}
+
+// Called on WinHttp's threads - must not touch Python.
+void CALLBACK PyWINHTTP_SESSION::Callback(HINTERNET hinternet, DWORD_PTR context, DWORD status, LPVOID info,
+                                          DWORD infolen)
+{
+    WINHTTP_REQUEST *req = (WINHTTP_REQUEST *)context;
+    if (req == NULL)  // The session and connect handles have no context
+        return;
+    PyWINHTTP_SESSION *session = req->session;
+    BOOL ok = TRUE;
+    switch (status) {
+        case WINHTTP_CALLBACK_STATUS_SENDREQUEST_COMPLETE:
+            ok = (*pfnWinHttpReceiveResponse)(hinternet, NULL);
+            break;
+        case WINHTTP_CALLBACK_STATUS_HEADERS_AVAILABLE: {
+            DWORD len = sizeof(req->statuscode);
+            (*pfnWinHttpQueryHeaders)(hinternet, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                                      WINHTTP_HEADER_NAME_BY_INDEX, &req->statuscode, &len, WINHTTP_NO_HEADER_INDEX);
+            len = 0;
+            (*pfnWinHttpQueryHeaders)(hinternet, WINHTTP_QUERY_RAW_HEADERS_CRLF, WINHTTP_HEADER_NAME_BY_INDEX,
+                                      WINHTTP_NO_OUTPUT_BUFFER, &len, WINHTTP_NO_HEADER_INDEX);
+            if (len) {
+                req->headers = (WCHAR *)malloc(len + sizeof(WCHAR));
+                if (req->headers &&
+                    !(*pfnWinHttpQueryHeaders)(hinternet, WINHTTP_QUERY_RAW_HEADERS_CRLF, WINHTTP_HEADER_NAME_BY_INDEX,
+                                               req->headers, &len, WINHTTP_NO_HEADER_INDEX)) {
+                    free(req->headers);
+                    req->headers = NULL;
+                }
+            }
+            ok = session->ReadMore(req);
+            break;
+        }
+        case WINHTTP_CALLBACK_STATUS_READ_COMPLETE:
+            if (infolen == 0) {
+                session->Complete(req, 0);
+                return;
+            }
+            req->outlen += infolen;
+            ok = session->ReadMore(req);
+            break;
+        case WINHTTP_CALLBACK_STATUS_DATA_AVAILABLE:
+            // Only asked for once a caller supplied buffer is full
+            session->Complete(req, *(DWORD *)info ? ERROR_INSUFFICIENT_BUFFER : 0);
+            return;
+        case WINHTTP_CALLBACK_STATUS_REQUEST_ERROR:
+            session->Complete(req, ((WINHTTP_ASYNC_RESULT *)info)->dwError);
+            return;
+        case WINHTTP_CALLBACK_STATUS_HANDLE_CLOSING:
+            // Once the handle count drops to zero, Close may free the session.
+            EnterCriticalSection(&session->cs);
+            ReleaseWinHttpRequest(req);
+            if (--session->numhandles == 0)
+                SetEvent(session->hidle);
+            LeaveCriticalSection(&session->cs);
+            return;
+        default:
+            return;
+    }
+    if (!ok)
+        session->Complete(req, GetLastError());
+}
+
+// Drops the session's reference to a request, with the GIL held.
+void PyWINHTTP_SESSION::Forget(WINHTTP_REQUEST *req)
+{
+    if (req->pyprev)
+        req->pyprev->pynext = req->pynext;
+    else
+        pending = req->pynext;
+    if (req->pynext)
+        req->pynext->pyprev = req->pyprev;
+    numpending--;
+    if (req->bHaveBodyView)
+        PyBuffer_Release(&req->bodyview);
+    if (req->bHaveOutView)
+        PyBuffer_Release(&req->outview);
+    Py_XDECREF(req->obcontext);
+    ReleaseWinHttpRequest(req);
+}
+
+// Takes the first request off the completion queue, or returns None if it's empty.
+PyObject *PyWINHTTP_SESSION::PopCompletion(void)
+{
+    EnterCriticalSection(&cs);
+    WINHTTP_REQUEST *req = head;
+    if (req) {
+        head = req->next;
+        if (head == NULL) {
+            tail = &head;
+            ResetEvent(hready);
+        }
+    }
+    LeaveCriticalSection(&cs);
+    if (req == NULL)
+        Py_RETURN_NONE;
+
+    PyObject *obbody;
+    if (req->bOwnOut)
+        obbody = PyBytes_FromStringAndSize((char *)req->out, req->outlen);
+    else
+        obbody = PyLong_FromUnsignedLong(req->outlen);
+    PyObject *ret = Py_BuildValue("OkkNN", req->obcontext, req->err, req->statuscode,
+                                  PyWinObject_FromWCHAR(req->headers), obbody);
+    Forget(req);
+    return ret;
+}
+
+// @pymethod |PyWINHTTP_SESSION|Request|Starts an asynchronous request
+// @comm The request runs in the background, and its result is returned by
+// <om PyWINHTTP_SESSION.GetCompletions>.  Failures after the URL has been accepted,
+// including failure to send the request, are reported there rather than raised.
+// @comm If a Buffer is passed, the response body is read directly into it, and if the body is
+// larger than the buffer the completion reports ERROR_INSUFFICIENT_BUFFER with the buffer full.
+// The buffer must not be resized until the completion has been returned.
+PyObject *PyWINHTTP_SESSION::PyRequest(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Url", "Method", "Headers", "Body", "Buffer", "Context", NULL};
+    PyWINHTTP_SESSION *This = (PyWINHTTP_SESSION *)self;
+    PyObject *oburl, *obmethod = Py_None, *obheaders = Py_None, *obbody = Py_None, *obbuffer = Py_None;
+    PyObject *obcontext = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "O|OOOOO:Request", keywords,
+            &oburl,      // @pyparm str|Url||Absolute http or https url
+            &obmethod,   // @pyparm str|Method|None|The HTTP verb, defaults to GET
+            &obheaders,  // @pyparm str|Headers|None|Extra headers, separated by CRLF
+            &obbody,     // @pyparm bytes|Body|None|Buffer containing data to send with the request
+            &obbuffer,   // @pyparm buffer|Buffer|None|Writable buffer to receive the response body.  If None,
+                         // the body is returned as bytes.
+            &obcontext))  // @pyparm object|Context|None|Any object, returned with the completion to identify the request
+        return NULL;
+    if (This->hsession == NULL)
+        return PyErr_Format(PyExc_ValueError, "The session has been closed");
+
+    WCHAR *url = NULL, *method = NULL, *headers = NULL, *host = NULL;
+    WINHTTP_REQUEST *req = NULL;
+    HINTERNET hconnect, hrequest;
+    URL_COMPONENTS uc;
+    PyObject *ret = NULL;
+    if (!PyWinObject_AsWCHAR(oburl, &url) || !PyWinObject_AsWCHAR(obmethod, &method, TRUE) ||
+        !PyWinObject_AsWCHAR(obheaders, &headers, TRUE))
+        goto done;
+    ZeroMemory(&uc, sizeof(uc));
+    uc.dwStructSize = sizeof(uc);
+    uc.dwHostNameLength = (DWORD)-1;
+    uc.dwUrlPathLength = (DWORD)-1;
+    uc.dwExtraInfoLength = (DWORD)-1;
+    if (!(*pfnWinHttpCrackUrl)(url, 0, 0, &uc)) {
+        PyWin_SetAPIError("WinHttpCrackUrl");
+        goto done;
+    }
+    // The path and query are contiguous in the original string, and the
+    // host has to be copied to be terminated.
+    host = (WCHAR *)malloc((uc.dwHostNameLength + 1) * sizeof(WCHAR));
+    req = (WINHTTP_REQUEST *)calloc(1, sizeof(WINHTTP_REQUEST));
+    if (host == NULL || req == NULL) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    memcpy(host, uc.lpszHostName, uc.dwHostNameLength * sizeof(WCHAR));
+    host[uc.dwHostNameLength] = 0;
+    req->refs = 1;
+    req->session = This;
+    if (obbody != Py_None) {
+        if (PyObject_GetBuffer(obbody, &req->bodyview, PyBUF_SIMPLE) == -1)
+            goto done;
+        req->bHaveBodyView = TRUE;
+    }
+    if (obbuffer != Py_None) {
+        if (PyObject_GetBuffer(obbuffer, &req->outview, PyBUF_WRITABLE) == -1)
+            goto done;
+        req->bHaveOutView = TRUE;
+        if (req->outview.len > MAXDWORD) {
+            PyErr_SetString(PyExc_ValueError, "Buffer is too large");
+            goto done;
+        }
+        req->out = (BYTE *)req->outview.buf;
+        req->outcap = (DWORD)req->outview.len;
+    }
+    else
+        req->bOwnOut = TRUE;
+    if (req->bodyview.len > MAXDWORD) {
+        PyErr_SetString(PyExc_ValueError, "Body is too large");
+        goto done;
+    }
+    hconnect = This->GetConnection(host, uc.nPort);
+    if (hconnect == NULL)
+        goto done;
+    hrequest = (*pfnWinHttpOpenRequest)(hconnect, method, uc.lpszUrlPath, NULL, WINHTTP_NO_REFERER,
+                                        WINHTTP_DEFAULT_ACCEPT_TYPES,
+                                        uc.nScheme == INTERNET_SCHEME_HTTPS ? WINHTTP_FLAG_SECURE : 0);
+    if (hrequest == NULL) {
+        PyWin_SetAPIError("WinHttpOpenRequest");
+        goto done;
+    }
+    // From here on the handle owns a reference, released by WINHTTP_CALLBACK_STATUS_HANDLE_CLOSING
+    DWORD_PTR ctx;
+    ctx = (DWORD_PTR)req;
+    if (!(*pfnWinHttpSetOption)(hrequest, WINHTTP_OPTION_CONTEXT_VALUE, &ctx, sizeof(ctx))) {
+        PyWin_SetAPIError("WinHttpSetOption");
+        (*pfnWinHttpCloseHandle)(hrequest);
+        goto done;
+    }
+    EnterCriticalSection(&This->cs);
+    req->refs++;
+    req->hrequest = hrequest;
+    if (This->numhandles++ == 0)
+        ResetEvent(This->hidle);
+    LeaveCriticalSection(&This->cs);
+    Py_INCREF(obcontext);
+    req->obcontext = obcontext;
+    req->pynext = This->pending;
+    if (This->pending)
+        This->pending->pyprev = req;
+    This->pending = req;
+    This->numpending++;
+
+    BOOL ok;
+    Py_BEGIN_ALLOW_THREADS ok = (*pfnWinHttpSendRequest)(
+        hrequest, headers ? headers : WINHTTP_NO_ADDITIONAL_HEADERS, headers ? (DWORD)-1 : 0, req->bodyview.buf,
+        (DWORD)req->bodyview.len, (DWORD)req->bodyview.len, 0);
+    Py_END_ALLOW_THREADS if (!ok) This->Complete(req, GetLastError());
+    req = NULL;  // Now owned by the pending list
+    Py_INCREF(Py_None);
+    ret = Py_None;
+done:
+    if (req) {
+        if (req->bHaveBodyView)
+            PyBuffer_Release(&req->bodyview);
+        if (req->bHaveOutView)
+            PyBuffer_Release(&req->outview);
+        req->bHaveBodyView = req->bHaveOutView = FALSE;
+        ReleaseWinHttpRequest(req);
+    }
+    free(host);
+    PyWinObject_FreeWCHAR(url);
+    PyWinObject_FreeWCHAR(method);
+    PyWinObject_FreeWCHAR(headers);
+    return ret;
+}
+
+// @pymethod [(object, int, int, str, object),...]|PyWINHTTP_SESSION|GetCompletions|Waits for requests to finish
+// @rdesc Returns a list of (Context, Error, StatusCode, Headers, Body) for each finished request, which
+// is empty if the timeout expired.  Error is 0 on success, or a win32 or WinHttp error code.  Headers are the
+// raw response headers, or None if no response was received.  Body is the response as bytes, or the number
+// of bytes written when a Buffer was passed to <om PyWINHTTP_SESSION.Request>.
+// @comm The GIL is released while waiting, and all completions that are ready are returned at once.
+PyObject *PyWINHTTP_SESSION::PyGetCompletions(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Timeout", "MaxCount", NULL};
+    PyWINHTTP_SESSION *This = (PyWINHTTP_SESSION *)self;
+    DWORD timeout = INFINITE, maxcount = 0;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|kk:GetCompletions", keywords,
+            &timeout,    // @pyparm int|Timeout|INFINITE|Milliseconds to wait for the first completion
+            &maxcount))  // @pyparm int|MaxCount|0|Maximum number of completions to return, 0 for no limit
+        return NULL;
+    if (This->hsession == NULL)
+        return PyErr_Format(PyExc_ValueError, "The session has been closed");
+    if (This->bBusy)
+        return PyErr_Format(PyExc_RuntimeError, "GetCompletions is already in progress on another thread");
+    PyObject *ret = PyList_New(0);
+    if (ret == NULL)
+        return NULL;
+    // Don't wait forever when nothing can ever complete
+    if (This->numpending == 0)
+        return ret;
+    DWORD waitret;
+    This->bBusy = TRUE;
+    Py_BEGIN_ALLOW_THREADS waitret = WaitForSingleObject(This->hready, timeout);
+    Py_END_ALLOW_THREADS This->bBusy = FALSE;
+    if (waitret == WAIT_FAILED) {
+        Py_DECREF(ret);
+        return PyWin_SetAPIError("WaitForSingleObject");
+    }
+    while (maxcount == 0 || (DWORD)PyList_GET_SIZE(ret) < maxcount) {
+        PyObject *item = This->PopCompletion();
+        if (item == Py_None) {
+            Py_DECREF(item);
+            break;
+        }
+        if (item == NULL || PyList_Append(ret, item) == -1) {
+            Py_XDECREF(item);
+            Py_DECREF(ret);
+            return NULL;
+        }
+        Py_DECREF(item);
+    }
+    return ret;
+}
+
+// @pymethod |PyWINHTTP_SESSION|Close|Cancels all outstanding requests and closes the session
+// @comm Completions that have not been returned by <om PyWINHTTP_SESSION.GetCompletions> are discarded.
+// The session is also closed when the object is destroyed.
+PyObject *PyWINHTTP_SESSION::PyClose(PyObject *self, PyObject *args)
+{
+    PyWINHTTP_SESSION *This = (PyWINHTTP_SESSION *)self;
+    if (This->bBusy)
+        return PyErr_Format(PyExc_RuntimeError, "GetCompletions is in progress on another thread");
+    This->Close();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod <o PyWINHTTP_SESSION>|win32inet|WinHttpAsyncSession|Creates an asynchronous winhttp session
+// @comm Uses WinHttpOpen with WINHTTP_FLAG_ASYNC, and drives requests from a status callback.  See
+// <o PyWINHTTP_SESSION> for details.
+PyObject *PyWinHttpAsyncSession(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"UserAgent", "AccessType", "EnableHttp2", NULL};
+    PyObject *obua = Py_None;
+    DWORD accesstype = WINHTTP_ACCESS_TYPE_DEFAULT_PROXY;
+    BOOL enablehttp2 = TRUE;
+    CHECK_PFN(WinHttpOpen);
+    CHECK_PFN(WinHttpCloseHandle);
+    CHECK_PFN(WinHttpConnect);
+    CHECK_PFN(WinHttpOpenRequest);
+    CHECK_PFN(WinHttpSendRequest);
+    CHECK_PFN(WinHttpReceiveResponse);
+    CHECK_PFN(WinHttpQueryHeaders);
+    CHECK_PFN(WinHttpReadData);
+    CHECK_PFN(WinHttpQueryDataAvailable);
+    CHECK_PFN(WinHttpSetStatusCallback);
+    CHECK_PFN(WinHttpSetOption);
+    CHECK_PFN(WinHttpCrackUrl);
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|Oki:WinHttpAsyncSession", keywords,
+            &obua,          // @pyparm str|UserAgent|None|
+            &accesstype,    // @pyparm int|AccessType|WINHTTP_ACCESS_TYPE_DEFAULT_PROXY|
+            &enablehttp2))  // @pyparm boolean|EnableHttp2|True|Enables HTTP/2 where the OS supports it
+        return NULL;
+    WCHAR *ua;
+    if (!PyWinObject_AsWCHAR(obua, &ua, TRUE))
+        return NULL;
+    PyWINHTTP_SESSION *ret = new PyWINHTTP_SESSION();
+    if (ret == NULL)
+        PyErr_NoMemory();
+    else if (!ret->Open(ua, accesstype, enablehttp2)) {
+        Py_DECREF(ret);
+        ret = NULL;
+    }
+    PyWinObject_FreeWCHAR(ua);
+    return ret;
+}
@@ -416,6 +416,596 @@ PyObject *PySetInformationJobObject(PyObject *self, PyObject *args)
 %}
 %native (SetInformationJobObject) PySetInformationJobObject;
 
+// Bulk accounting, rate control and the job monitor.  The structures for the
+// newer information classes are declared here, as this module is built for
+// Windows 2000 headers.
+%{
+#define PyJobObjectCpuRateControlInformation 15
+#define PY_JOB_OBJECT_CPU_RATE_CONTROL_ENABLE 0x1
+#define PY_JOB_OBJECT_CPU_RATE_CONTROL_WEIGHT_BASED 0x2
+#define PY_JOB_OBJECT_CPU_RATE_CONTROL_HARD_CAP 0x4
+#define PY_JOB_OBJECT_CPU_RATE_CONTROL_NOTIFY 0x8
+#define PY_JOB_OBJECT_IO_RATE_CONTROL_ENABLE 0x1
+
+typedef struct {
+	DWORD ControlFlags;
+	DWORD CpuRate;	// or Weight, if JOB_OBJECT_CPU_RATE_CONTROL_WEIGHT_BASED
+} PyJOBOBJECT_CPU_RATE_CONTROL_INFORMATION;
+
+typedef struct {
+	LONG64 MaxIops;
+	LONG64 MaxBandwidth;
+	LONG64 ReservationIops;
+	PCWSTR VolumeName;
+	ULONG BaseIoSize;
+	ULONG ControlFlags;
+} PyJOBOBJECT_IO_RATE_CONTROL_INFORMATION;
+
+typedef struct {
+	ULONG_PTR lpCompletionKey;
+	LPOVERLAPPED lpOverlapped;
+	ULONG_PTR Internal;
+	DWORD dwNumberOfBytesTransferred;
+} PyJOB_OVERLAPPED_ENTRY;
+
+typedef DWORD (WINAPI *SetIoRateControlInformationJobObjectfunc)(HANDLE, PyJOBOBJECT_IO_RATE_CONTROL_INFORMATION *);
+static SetIoRateControlInformationJobObjectfunc pfnSetIoRateControlInformationJobObject=NULL;
+typedef BOOL (WINAPI *GetQueuedCompletionStatusExfunc)(HANDLE, PyJOB_OVERLAPPED_ENTRY *, ULONG, PULONG, DWORD, BOOL);
+static GetQueuedCompletionStatusExfunc pfnGetQueuedCompletionStatusEx=NULL;
+
+typedef struct {
+	JOBOBJECT_BASIC_AND_IO_ACCOUNTING_INFORMATION acct;
+	JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits;
+} PyJobAccounting;
+
+#define JOBACCT_LONGLONG 0
+#define JOBACCT_DWORD 1
+#define JOBACCT_SIZE 2
+typedef struct {
+	const char *name;
+	size_t offset;
+	int type;
+} PyJobAccountingField;
+
+#define JOBACCT_BASIC(name, type) {#name, offsetof(PyJobAccounting, acct.BasicInfo.name), type}
+#define JOBACCT_IO(name) {#name, offsetof(PyJobAccounting, acct.IoInfo.name), JOBACCT_LONGLONG}
+static PyJobAccountingField jobAccountingFields[] = {
+	JOBACCT_BASIC(TotalUserTime, JOBACCT_LONGLONG),
+	JOBACCT_BASIC(TotalKernelTime, JOBACCT_LONGLONG),
+	JOBACCT_BASIC(ThisPeriodTotalUserTime, JOBACCT_LONGLONG),
+	JOBACCT_BASIC(ThisPeriodTotalKernelTime, JOBACCT_LONGLONG),
+	JOBACCT_BASIC(TotalPageFaultCount, JOBACCT_DWORD),
+	JOBACCT_BASIC(TotalProcesses, JOBACCT_DWORD),
+	JOBACCT_BASIC(ActiveProcesses, JOBACCT_DWORD),
+	JOBACCT_BASIC(TotalTerminatedProcesses, JOBACCT_DWORD),
+	JOBACCT_IO(ReadOperationCount),
+	JOBACCT_IO(WriteOperationCount),
+	JOBACCT_IO(OtherOperationCount),
+	JOBACCT_IO(ReadTransferCount),
+	JOBACCT_IO(WriteTransferCount),
+	JOBACCT_IO(OtherTransferCount),
+	{"PeakProcessMemoryUsed", offsetof(PyJobAccounting, limits.PeakProcessMemoryUsed), JOBACCT_SIZE},
+	{"PeakJobMemoryUsed", offsetof(PyJobAccounting, limits.PeakJobMemoryUsed), JOBACCT_SIZE},
+	{NULL}
+};
+#undef JOBACCT_BASIC
+#undef JOBACCT_IO
+
+// Queries all the jobs without the GIL and builds the columns, adding them to ret.
+static BOOL QueryJobAccountingColumns(HANDLE *jobs, DWORD num, PyObject *ret)
+{
+	PyJobAccounting *acct = (PyJobAccounting *)malloc((num ? num : 1) * sizeof(PyJobAccounting));
+	if (acct == NULL) {
+		PyErr_NoMemory();
+		return FALSE;
+	}
+	DWORD failed = num, err = 0;
+	Py_BEGIN_ALLOW_THREADS
+	for (DWORD i=0;i<num;i++) {
+		if (!QueryInformationJobObject(jobs[i], JobObjectBasicAndIoAccountingInformation, &acct[i].acct, sizeof(acct[i].acct), NULL)
+			|| !QueryInformationJobObject(jobs[i], JobObjectExtendedLimitInformation, &acct[i].limits, sizeof(acct[i].limits), NULL)) {
+			err = GetLastError();
+			failed = i;
+			break;
+		}
+	}
+	Py_END_ALLOW_THREADS
+	BOOL ok = FALSE;
+	if (failed != num) {
+		PyWin_SetAPIError("QueryInformationJobObject", err);
+		goto done;
+	}
+	for (PyJobAccountingField *field = jobAccountingFields; field->name; field++) {
+		PyObject *column = PyList_New(num);
+		if (column == NULL)
+			goto done;
+		for (DWORD i=0;i<num;i++) {
+			BYTE *p = (BYTE *)&acct[i] + field->offset;
+			PyObject *item;
+			if (field->type == JOBACCT_LONGLONG)
+				item = PyLong_FromLongLong(*(LONGLONG *)p);
+			else if (field->type == JOBACCT_DWORD)
+				item = PyLong_FromUnsignedLong(*(DWORD *)p);
+			else
+				item = PyLong_FromSize_t(*(SIZE_T *)p);
+			if (item == NULL) {
+				Py_DECREF(column);
+				goto done;
+			}
+			PyList_SET_ITEM(column, i, item);
+		}
+		int rc = PyDict_SetItemString(ret, field->name, column);
+		Py_DECREF(column);
+		if (rc == -1)
+			goto done;
+	}
+	ok = TRUE;
+done:
+	free(acct);
+	return ok;
+}
+
+// @pyswig dict|QueryJobAccounting|Returns accounting information for many jobs in one call.
+// @rdesc A dict mapping each field name to a list with one entry per job, in the order of the jobs passed.
+// The fields are those of JOBOBJECT_BASIC_ACCOUNTING_INFORMATION (times in 100 nanosecond units),
+// the IO_COUNTERS of JOBOBJECT_BASIC_AND_IO_ACCOUNTING_INFORMATION, and PeakProcessMemoryUsed and
+// PeakJobMemoryUsed from JOBOBJECT_EXTENDED_LIMIT_INFORMATION.
+// @comm The jobs are queried without the Python lock held, and only the result lists are built in
+// Python - this is much cheaper than calling <om win32job.QueryInformationJobObject> twice per job.
+static PyObject *PyQueryJobAccounting(PyObject *self, PyObject *args)
+{
+	PyObject *obJobs;
+	// @pyparm [<o PyHANDLE>, ...]|Jobs||Handles to the jobs, opened with JOB_OBJECT_QUERY access.
+	if (!PyArg_ParseTuple(args, "O:QueryJobAccounting", &obJobs))
+		return NULL;
+	DWORD num;
+	TmpPyObject seq = PyWinSequence_Tuple(obJobs, &num);
+	if (seq == NULL)
+		return NULL;
+	HANDLE *jobs = (HANDLE *)malloc((num ? num : 1) * sizeof(HANDLE));
+	if (jobs == NULL)
+		return PyErr_NoMemory();
+	PyObject *ret = NULL;
+	for (DWORD i=0;i<num;i++)
+		if (!PyWinObject_AsHANDLE(PyTuple_GET_ITEM((PyObject *)seq, i), &jobs[i]))
+			goto done;
+	ret = PyDict_New();
+	if (ret && !QueryJobAccountingColumns(jobs, num, ret)) {
+		Py_DECREF(ret);
+		ret = NULL;
+	}
+done:
+	free(jobs);
+	return ret;
+}
+
+// @pyswig |SetJobCpuRateLimit|Limits the CPU time a job may use, using JobObjectCpuRateControlInformation.
+// @comm Requires Windows 8 or later.  Pass neither rate nor weight to remove the limit.
+static PyObject *PySetJobCpuRateLimit(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[]={"Job", "Rate", "Weight", "HardCap", "Notify", NULL};
+	PyObject *obJob, *obRate = Py_None;
+	DWORD weight = 0;
+	BOOL bHardCap = TRUE, bNotify = FALSE;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|Okii:SetJobCpuRateLimit", keywords,
+		&obJob,		// @pyparm <o PyHANDLE>|Job||Handle to a job, with JOB_OBJECT_SET_ATTRIBUTES access
+		&obRate,	// @pyparm float|Rate|None|The percentage of the machine's CPU the job may use, from 0.01 to 100.
+		&weight,	// @pyparm int|Weight|0|Alternatively, a scheduling weight from 1 to 9, relative to other jobs.
+		&bHardCap,	// @pyparm bool|HardCap|True|If true, the job gets no more than its rate even when the CPU is idle.  Ignored for a weight.
+		&bNotify))	// @pyparm bool|Notify|False|If true, JOB_OBJECT_MSG_NOTIFICATION_LIMIT is posted to the job's completion port when the rate is exceeded.
+		return NULL;
+	HANDLE hJob;
+	if (!PyWinObject_AsHANDLE(obJob, &hJob))
+		return NULL;
+	PyJOBOBJECT_CPU_RATE_CONTROL_INFORMATION info = {0, 0};
+	if (obRate != Py_None && weight)
+		return PyErr_Format(PyExc_ValueError, "Only one of Rate and Weight may be given");
+	if (obRate != Py_None) {
+		double rate = PyFloat_AsDouble(obRate);
+		if (rate == -1.0 && PyErr_Occurred())
+			return NULL;
+		if (rate < 0.01 || rate > 100.0)
+			return PyErr_Format(PyExc_ValueError, "Rate must be between 0.01 and 100");
+		// In hundredths of a percent.
+		info.CpuRate = (DWORD)(rate * 100 + 0.5);
+		info.ControlFlags = PY_JOB_OBJECT_CPU_RATE_CONTROL_ENABLE;
+		if (bHardCap)
+			info.ControlFlags |= PY_JOB_OBJECT_CPU_RATE_CONTROL_HARD_CAP;
+	}
+	else if (weight) {
+		if (weight > 9)
+			return PyErr_Format(PyExc_ValueError, "Weight must be between 1 and 9");
+		info.CpuRate = weight;
+		info.ControlFlags = PY_JOB_OBJECT_CPU_RATE_CONTROL_ENABLE | PY_JOB_OBJECT_CPU_RATE_CONTROL_WEIGHT_BASED;
+	}
+	if (bNotify && info.ControlFlags)
+		info.ControlFlags |= PY_JOB_OBJECT_CPU_RATE_CONTROL_NOTIFY;
+	if (!SetInformationJobObject(hJob, (JOBOBJECTINFOCLASS)PyJobObjectCpuRateControlInformation, &info, sizeof(info)))
+		return PyWin_SetAPIError("SetInformationJobObject");
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+// @pyswig |SetJobIoRateLimit|Limits the I/O rate of a job, using SetIoRateControlInformationJobObject.
+// @comm Requires Windows 10 or later.  Pass no limits to remove them.
+static PyObject *PySetJobIoRateLimit(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	CHECK_PFN(SetIoRateControlInformationJobObject);
+	static char *keywords[]={"Job", "MaxIops", "MaxBandwidth", "ReservationIops", "VolumeName", "BaseIoSize", NULL};
+	PyObject *obJob, *obVolume = Py_None;
+	PyJOBOBJECT_IO_RATE_CONTROL_INFORMATION info;
+	ZeroMemory(&info, sizeof(info));
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|LLLOk:SetJobIoRateLimit", keywords,
+		&obJob,					// @pyparm <o PyHANDLE>|Job||Handle to a job, with JOB_OBJECT_SET_ATTRIBUTES access
+		&info.MaxIops,			// @pyparm int|MaxIops|0|The maximum number of I/O operations per second, 0 for no limit
+		&info.MaxBandwidth,		// @pyparm int|MaxBandwidth|0|The maximum bytes per second, 0 for no limit
+		&info.ReservationIops,	// @pyparm int|ReservationIops|0|The number of I/O operations per second reserved for the job
+		&obVolume,				// @pyparm <o PyUnicode>|VolumeName|None|The volume the limits apply to - None for all volumes
+		&info.BaseIoSize))		// @pyparm int|BaseIoSize|0|The size of the I/O used to normalise operation counts, 0 for the system default
+		return NULL;
+	HANDLE hJob;
+	TmpWCHAR volume;
+	if (!PyWinObject_AsHANDLE(obJob, &hJob))
+		return NULL;
+	if (!PyWinObject_AsWCHAR(obVolume, &volume, TRUE))
+		return NULL;
+	info.VolumeName = volume;
+	if (info.MaxIops || info.MaxBandwidth || info.ReservationIops)
+		info.ControlFlags = PY_JOB_OBJECT_IO_RATE_CONTROL_ENABLE;
+	DWORD err = (*pfnSetIoRateControlInformationJobObject)(hJob, &info);
+	// Returns 0 on failure - otherwise documented as returning the id of the new control.
+	if (err == 0)
+		return PyWin_SetAPIError("SetIoRateControlInformationJobObject");
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+// @object PyJobMonitor|Receives notifications from many jobs through one I/O completion port,
+// as returned by <om win32job.CreateJobMonitor>.
+// @comm Each job added with <om PyJobMonitor.AddJob> is associated with the monitor's completion
+// port, so no thread or wait is needed per job.  <om PyJobMonitor.GetEvents> dequeues every
+// notification which is waiting in a single GetQueuedCompletionStatusEx call.
+// <nl>A job can only ever be associated with one completion port, so a job which already has one
+// can not be added, and <om PyJobMonitor.RemoveJob> only stops its notifications being reported.
+typedef struct {
+	ULONG_PTR key;
+	PyObject *obJob;
+	PyObject *obCookie;
+} PyJobMonitorEntry;
+
+typedef struct {
+	PyObject_HEAD
+	HANDLE hPort;
+	ULONG_PTR nextKey;
+	// Sorted by key, as keys only grow.  Only changed with the GIL held.
+	PyJobMonitorEntry *entries;
+	ULONG numEntries, maxEntries;
+	LONG notifications;		// statistics
+	LONG dropped;
+} PyJobMonitor;
+
+extern PyTypeObject PyJobMonitor_Type;
+
+static PyJobMonitorEntry *jm_find(PyJobMonitor *jm, ULONG_PTR key)
+{
+	ULONG lo = 0, hi = jm->numEntries;
+	while (lo < hi) {
+		ULONG mid = (lo + hi) / 2;
+		if (jm->entries[mid].key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo < jm->numEntries && jm->entries[lo].key == key)
+		return jm->entries + lo;
+	return NULL;
+}
+
+static void jm_close(PyJobMonitor *jm)
+{
+	if (jm->hPort) {
+		CloseHandle(jm->hPort);
+		jm->hPort = NULL;
+	}
+	for (ULONG i=0;i<jm->numEntries;i++) {
+		Py_DECREF(jm->entries[i].obJob);
+		Py_DECREF(jm->entries[i].obCookie);
+	}
+	jm->numEntries = 0;
+}
+
+static void jm_dealloc(PyObject *ob)
+{
+	PyJobMonitor *jm = (PyJobMonitor *)ob;
+	jm_close(jm);
+	free(jm->entries);
+	PyObject_Del(ob);
+}
+
+// @pymethod int|PyJobMonitor|AddJob|Starts receiving notifications from a job.
+// @rdesc The completion key used for the job.
+static PyObject *jm_AddJob(PyObject *self, PyObject *args)
+{
+	PyJobMonitor *jm = (PyJobMonitor *)self;
+	PyObject *obJob, *obCookie = Py_None;
+	if (!PyArg_ParseTuple(args, "O|O:AddJob",
+		&obJob,		// @pyparm <o PyHANDLE>|Job||Handle to a job, with JOB_OBJECT_SET_ATTRIBUTES access
+		&obCookie))	// @pyparm object|Cookie|None|Identifies the job in notifications and accounting.  If None, the job handle is used.
+		return NULL;
+	if (jm->hPort == NULL)
+		return PyErr_Format(PyExc_ValueError, "The monitor has been closed");
+	HANDLE hJob;
+	if (!PyWinObject_AsHANDLE(obJob, &hJob))
+		return NULL;
+	if (jm->numEntries == jm->maxEntries) {
+		ULONG maxEntries = jm->maxEntries ? jm->maxEntries * 2 : 16;
+		PyJobMonitorEntry *entries = (PyJobMonitorEntry *)realloc(jm->entries, maxEntries * sizeof(PyJobMonitorEntry));
+		if (entries == NULL)
+			return PyErr_NoMemory();
+		jm->entries = entries;
+		jm->maxEntries = maxEntries;
+	}
+	JOBOBJECT_ASSOCIATE_COMPLETION_PORT info;
+	info.CompletionKey = (PVOID)++jm->nextKey;
+	info.CompletionPort = jm->hPort;
+	if (!SetInformationJobObject(hJob, JobObjectAssociateCompletionPortInformation, &info, sizeof(info)))
+		return PyWin_SetAPIError("SetInformationJobObject");
+	PyJobMonitorEntry *e = jm->entries + jm->numEntries++;
+	e->key = jm->nextKey;
+	e->obJob = obJob;
+	Py_INCREF(obJob);
+	e->obCookie = obCookie == Py_None ? obJob : obCookie;
+	Py_INCREF(e->obCookie);
+	return PyLong_FromSize_t(e->key);
+}
+
+// @pymethod bool|PyJobMonitor|RemoveJob|Stops reporting notifications from a job.
+// @rdesc False if the job was not being monitored.
+// @comm The job remains associated with the completion port, but any further notifications from it are discarded.
+static PyObject *jm_RemoveJob(PyObject *self, PyObject *args)
+{
+	PyJobMonitor *jm = (PyJobMonitor *)self;
+	PyObject *obJob;
+	// @pyparm <o PyHANDLE>|Job||The job, as passed to <om PyJobMonitor.AddJob>
+	if (!PyArg_ParseTuple(args, "O:RemoveJob", &obJob))
+		return NULL;
+	HANDLE hJob;
+	if (!PyWinObject_AsHANDLE(obJob, &hJob))
+		return NULL;
+	for (ULONG i=0;i<jm->numEntries;i++) {
+		HANDLE h;
+		if (!PyWinObject_AsHANDLE(jm->entries[i].obJob, &h))
+			return NULL;
+		if (h == hJob) {
+			Py_DECREF(jm->entries[i].obJob);
+			Py_DECREF(jm->entries[i].obCookie);
+			memmove(jm->entries + i, jm->entries + i + 1, (jm->numEntries - i - 1) * sizeof(PyJobMonitorEntry));
+			jm->numEntries--;
+			return PyBool_FromLong(TRUE);
+		}
+	}
+	return PyBool_FromLong(FALSE);
+}
+
+// @pymethod [(cookie, message, processId), ...]|PyJobMonitor|GetEvents|Waits for notifications from the jobs.
+// @rdesc A list of the notifications which were waiting, or an empty list if the timeout expired.
+// message is one of the JOB_OBJECT_MSG_* values.  processId is the process the notification is about
+// for JOB_OBJECT_MSG_NEW_PROCESS, JOB_OBJECT_MSG_EXIT_PROCESS, JOB_OBJECT_MSG_ABNORMAL_EXIT_PROCESS,
+// JOB_OBJECT_MSG_PROCESS_MEMORY_LIMIT and JOB_OBJECT_MSG_END_OF_PROCESS_TIME, otherwise 0.
+static PyObject *jm_GetEvents(PyObject *self, PyObject *args)
+{
+	PyJobMonitor *jm = (PyJobMonitor *)self;
+	DWORD timeout = INFINITE;
+	ULONG maxEvents = 256;
+	if (!PyArg_ParseTuple(args, "|kk:GetEvents",
+		&timeout,		// @pyparm int|timeout|win32event.INFINITE|The time in milliseconds to wait for the first notification.
+		&maxEvents))	// @pyparm int|maxEvents|256|The most notifications to return.
+		return NULL;
+	if (jm->hPort == NULL)
+		return PyErr_Format(PyExc_ValueError, "The monitor has been closed");
+	if (maxEvents == 0)
+		return PyErr_Format(PyExc_ValueError, "maxEvents must be at least 1");
+	PyJOB_OVERLAPPED_ENTRY *events = (PyJOB_OVERLAPPED_ENTRY *)malloc(maxEvents * sizeof(PyJOB_OVERLAPPED_ENTRY));
+	if (events == NULL)
+		return PyErr_NoMemory();
+	HANDLE hPort = jm->hPort;
+	ULONG num = 0;
+	DWORD err = 0;
+	Py_BEGIN_ALLOW_THREADS
+	if (pfnGetQueuedCompletionStatusEx) {
+		if (!(*pfnGetQueuedCompletionStatusEx)(hPort, events, maxEvents, &num, timeout, FALSE))
+			err = GetLastError();
+	}
+	else {
+		// Wait for the first, then take any others which are already queued.
+		while (num < maxEvents) {
+			DWORD bytes;
+			if (!GetQueuedCompletionStatus(hPort, &bytes, &events[num].lpCompletionKey, &events[num].lpOverlapped, num ? 0 : timeout)) {
+				if (events[num].lpOverlapped == NULL && num == 0)
+					err = GetLastError();
+				break;
+			}
+			events[num++].dwNumberOfBytesTransferred = bytes;
+		}
+	}
+	Py_END_ALLOW_THREADS
+	PyObject *ret = NULL;
+	if (err == WAIT_TIMEOUT)
+		ret = PyList_New(0);
+	else if (err) {
+		if (jm->hPort == NULL)
+			PyErr_Format(PyExc_ValueError, "The monitor has been closed");
+		else
+			PyWin_SetAPIError("GetQueuedCompletionStatus", err);
+	}
+	else {
+		ret = PyList_New(0);
+		for (ULONG i=0;ret && i<num;i++) {
+			jm->notifications++;
+			PyJobMonitorEntry *e = jm_find(jm, events[i].lpCompletionKey);
+			if (e == NULL) {
+				jm->dropped++;
+				continue;
+			}
+			// For job notifications, the byte count is the message and the OVERLAPPED pointer the process id.
+			PyObject *item = Py_BuildValue("Okk", e->obCookie, events[i].dwNumberOfBytesTransferred,
+				(unsigned long)(ULONG_PTR)events[i].lpOverlapped);
+			if (item == NULL || PyList_Append(ret, item) == -1) {
+				Py_XDECREF(item);
+				Py_DECREF(ret);
+				ret = NULL;
+				break;
+			}
+			Py_DECREF(item);
+		}
+	}
+	free(events);
+	return ret;
+}
+
+// @pymethod dict|PyJobMonitor|QueryAccounting|Returns accounting information for all the monitored jobs.
+// @rdesc As for <om win32job.QueryJobAccounting>, with a Cookie column added.
+static PyObject *jm_QueryAccounting(PyObject *self, PyObject *args)
+{
+	PyJobMonitor *jm = (PyJobMonitor *)self;
+	if (!PyArg_ParseTuple(args, ":QueryAccounting"))
+		return NULL;
+	ULONG num = jm->numEntries;
+	HANDLE *jobs = (HANDLE *)malloc((num ? num : 1) * sizeof(HANDLE));
+	if (jobs == NULL)
+		return PyErr_NoMemory();
+	PyObject *ret = NULL, *cookies = NULL;
+	for (ULONG i=0;i<num;i++)
+		if (!PyWinObject_AsHANDLE(jm->entries[i].obJob, &jobs[i]))
+			goto done;
+	cookies = PyList_New(num);
+	if (cookies == NULL)
+		goto done;
+	for (ULONG i=0;i<num;i++) {
+		Py_INCREF(jm->entries[i].obCookie);
+		PyList_SET_ITEM(cookies, i, jm->entries[i].obCookie);
+	}
+	ret = PyDict_New();
+	// The entries can change while the queries run without the GIL, so the columns are
+	// built from the copies taken here.
+	if (ret && (PyDict_SetItemString(ret, "Cookie", cookies) == -1 || !QueryJobAccountingColumns(jobs, num, ret))) {
+		Py_DECREF(ret);
+		ret = NULL;
+	}
+done:
+	Py_XDECREF(cookies);
+	free(jobs);
+	return ret;
+}
+
+// @pymethod |PyJobMonitor|Close|Closes the completion port and releases the jobs.
+static PyObject *jm_Close(PyObject *self, PyObject *args)
+{
+	if (!PyArg_ParseTuple(args, ":Close"))
+		return NULL;
+	jm_close((PyJobMonitor *)self);
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+static Py_ssize_t jm_length(PyObject *self)
+{
+	return ((PyJobMonitor *)self)->numEntries;
+}
+
+static PySequenceMethods jm_sequence = {
+	jm_length,	/* sq_length */
+};
+
+static PyMethodDef jm_methods[] = {
+	{"AddJob", jm_AddJob, METH_VARARGS}, // @pymeth AddJob|Starts receiving notifications from a job.
+	{"RemoveJob", jm_RemoveJob, METH_VARARGS}, // @pymeth RemoveJob|Stops reporting notifications from a job.
+	{"GetEvents", jm_GetEvents, METH_VARARGS}, // @pymeth GetEvents|Waits for notifications from the jobs.
+	{"QueryAccounting", jm_QueryAccounting, METH_VARARGS}, // @pymeth QueryAccounting|Returns accounting information for all the monitored jobs.
+	{"Close", jm_Close, METH_VARARGS}, // @pymeth Close|Closes the completion port.
+	{NULL}
+};
+
+#undef OFF
+#define OFF(e) offsetof(PyJobMonitor, e)
+static PyMemberDef jm_members[] = {
+	{"notifications", T_LONG, OFF(notifications), READONLY}, // @prop int|notifications|The number of notifications dequeued.
+	{"dropped", T_LONG, OFF(dropped), READONLY}, // @prop int|dropped|The number of notifications discarded because their job had been removed.
+	{NULL}
+};
+#undef OFF
+
+PyTypeObject PyJobMonitor_Type = {
+	PYWIN_OBJECT_HEAD
+	"PyJobMonitor",				/* tp_name */
+	sizeof(PyJobMonitor),			/* tp_basicsize */
+	0,					/* tp_itemsize */
+	jm_dealloc,				/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	&jm_sequence,				/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	0,					/* tp_iter */
+	0,					/* tp_iternext */
+	jm_methods,				/* tp_methods */
+	jm_members,				/* tp_members */
+	0,					/* tp_getset */
+};
+
+// @pyswig <o PyJobMonitor>|CreateJobMonitor|Creates an object which receives notifications from many jobs.
+static PyObject *PyCreateJobMonitor(PyObject *self, PyObject *args)
+{
+	if (!PyArg_ParseTuple(args, ":CreateJobMonitor"))
+		return NULL;
+	HANDLE hPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+	if (hPort == NULL)
+		return PyWin_SetAPIError("CreateIoCompletionPort");
+	PyJobMonitor *jm = PyObject_New(PyJobMonitor, &PyJobMonitor_Type);
+	if (jm == NULL) {
+		CloseHandle(hPort);
+		return NULL;
+	}
+	memset(((BYTE *)jm) + sizeof(PyObject), 0, sizeof(PyJobMonitor) - sizeof(PyObject));
+	jm->hPort = hPort;
+	return (PyObject *)jm;
+}
+%}
+%native (QueryJobAccounting) PyQueryJobAccounting;
+%native (SetJobCpuRateLimit) PySetJobCpuRateLimit;
+%native (SetJobIoRateLimit) PySetJobIoRateLimit;
+%native (CreateJobMonitor) PyCreateJobMonitor;
+
+%init %{
+	if (PyType_Ready(&PyJobMonitor_Type) == -1)
+		PYWIN_MODULE_INIT_RETURN_ERROR;
+	if (hmodule){
+		pfnSetIoRateControlInformationJobObject=(SetIoRateControlInformationJobObjectfunc)GetProcAddress(hmodule,"SetIoRateControlInformationJobObject");
+		pfnGetQueuedCompletionStatusEx=(GetQueuedCompletionStatusExfunc)GetProcAddress(hmodule,"GetQueuedCompletionStatusEx");
+		}
+	for (PyMethodDef *pmd = win32jobMethods;pmd->ml_name;pmd++)
+		if   ((strcmp(pmd->ml_name, "SetJobCpuRateLimit")==0)
+			||(strcmp(pmd->ml_name, "SetJobIoRateLimit")==0)
+			){
+			pmd->ml_flags = METH_VARARGS | METH_KEYWORDS;
+			}
+%}
+
 
 
 // some of these are in winnt.py also
@@ -439,6 +1029,7 @@ PyObject *PySetInformationJobObject(PyObject *self, PyObject *args)
 #define JOB_OBJECT_MSG_ABNORMAL_EXIT_PROCESS JOB_OBJECT_MSG_ABNORMAL_EXIT_PROCESS
 #define JOB_OBJECT_MSG_PROCESS_MEMORY_LIMIT JOB_OBJECT_MSG_PROCESS_MEMORY_LIMIT
 #define JOB_OBJECT_MSG_JOB_MEMORY_LIMIT JOB_OBJECT_MSG_JOB_MEMORY_LIMIT
+#define JOB_OBJECT_MSG_NOTIFICATION_LIMIT 11
 
 #define JOB_OBJECT_LIMIT_WORKINGSET JOB_OBJECT_LIMIT_WORKINGSET
 #define JOB_OBJECT_LIMIT_PROCESS_TIME JOB_OBJECT_LIMIT_PROCESS_TIME
@@ -491,5 +1082,6 @@ PyObject *PySetInformationJobObject(PyObject *self, PyObject *args)
 #define JobObjectBasicAndIoAccountingInformation JobObjectBasicAndIoAccountingInformation
 #define JobObjectExtendedLimitInformation JobObjectExtendedLimitInformation
 #define JobObjectJobSetInformation JobObjectJobSetInformation
+#define JobObjectCpuRateControlInformation 15
 #define MaxJobObjectInfoClass MaxJobObjectInfoClass
 
@@ -26,6 +26,8 @@ struct PyNET_STRUCT {
 };
 
 PyObject *PyObject_FromNET_STRUCT(PyNET_STRUCT *pI, BYTE *buf);
+PyObject *PyObject_FromNET_STRUCTKeys(PyNET_STRUCT *pI, BYTE *buf, PyObject *keys);
+PyObject *PyObject_FromNET_STRUCT_ITEM(PyNET_STRUCT_ITEM *pItem, BYTE *buf);
 BOOL PyObject_AsNET_STRUCT(PyObject *ob, PyNET_STRUCT *pI, BYTE **ppRet);
 void PyObject_FreeNET_STRUCT(PyNET_STRUCT *pI, BYTE *pBuf);
 BOOL FindNET_STRUCT(DWORD level, PyNET_STRUCT *pBase, PyNET_STRUCT **ppRet);
@@ -37,6 +39,18 @@ PyObject *PyDoSimpleEnum(PyObject *self, PyObject *args, PFNSIMPLEENUM pfn, char
 typedef DWORD(__stdcall *PFNNAMEDENUM)(LPCWSTR, LPCWSTR, DWORD, LPBYTE *, DWORD, LPDWORD, LPDWORD, PDWORD_PTR);
 PyObject *PyDoNamedEnum(PyObject *self, PyObject *args, PFNNAMEDENUM pfn, char *fnname, PyNET_STRUCT *pInfos);
 
+// Like PFNSIMPLEENUM, with an extra filter and a DWORD resume handle, as used by NetUserEnum
+typedef DWORD(__stdcall *PFNFILTEREDENUM)(LPCWSTR, DWORD, DWORD, LPBYTE *, DWORD, LPDWORD, LPDWORD, PDWORD);
+// Returns an iterator that pages through the results of whichever one of the functions is given
+PyObject *PyDoEnumIterator(PyObject *args, PyObject *kwargs, PFNSIMPLEENUM pfnSimple, PFNNAMEDENUM pfnNamed,
+                           PFNFILTEREDENUM pfnFiltered, char *fnname, PyNET_STRUCT *pInfos);
+extern PyTypeObject PyNETENUMType;
+
+// Defined in win32netmisc.cpp, and also used by NetBatchEnum
+extern PyNET_STRUCT share_infos[];
+extern PyNET_STRUCT wktau_infos[];
+extern PyTypeObject PyNETBATCHType;
+
 typedef DWORD(__stdcall *PFNGROUPSET)(LPCWSTR, LPCWSTR, DWORD, LPBYTE, DWORD);
 PyObject *PyDoGroupSet(PyObject *self, PyObject *args, PFNGROUPSET pfn, char *fnname, PyNET_STRUCT *pInfos);
 
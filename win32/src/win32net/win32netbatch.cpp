@@ -0,0 +1,522 @@
+// win32netbatch.cpp
+//
+// Runs one of the Net*Enum functions against many servers concurrently.
+//
+// @doc
+#include "PyWinTypes.h"
+#include "structmember.h"
+#include "lm.h"
+#include "win32net.h"
+#include "stddef.h"
+
+// The SESSION_INFO levels, using the same keys as <om win32net.NetSessionEnum>
+static struct PyNET_STRUCT_ITEM sesi0[] = {{"client_name", NSI_WSTR, offsetof(SESSION_INFO_0, sesi0_cname), 0},
+                                           {NULL}};
+static struct PyNET_STRUCT_ITEM sesi1[] = {
+    {"client_name", NSI_WSTR, offsetof(SESSION_INFO_1, sesi1_cname), 0},
+    {"user_name", NSI_WSTR, offsetof(SESSION_INFO_1, sesi1_username), 0},
+    {"num_opens", NSI_DWORD, offsetof(SESSION_INFO_1, sesi1_num_opens), 0},
+    {"active_time", NSI_DWORD, offsetof(SESSION_INFO_1, sesi1_time), 0},
+    {"idle_time", NSI_DWORD, offsetof(SESSION_INFO_1, sesi1_idle_time), 0},
+    {"user_flags", NSI_DWORD, offsetof(SESSION_INFO_1, sesi1_user_flags), 0},
+    {NULL}};
+static struct PyNET_STRUCT_ITEM sesi2[] = {
+    {"client_name", NSI_WSTR, offsetof(SESSION_INFO_2, sesi2_cname), 0},
+    {"user_name", NSI_WSTR, offsetof(SESSION_INFO_2, sesi2_username), 0},
+    {"num_opens", NSI_DWORD, offsetof(SESSION_INFO_2, sesi2_num_opens), 0},
+    {"active_time", NSI_DWORD, offsetof(SESSION_INFO_2, sesi2_time), 0},
+    {"idle_time", NSI_DWORD, offsetof(SESSION_INFO_2, sesi2_idle_time), 0},
+    {"user_flags", NSI_DWORD, offsetof(SESSION_INFO_2, sesi2_user_flags), 0},
+    {"client_type", NSI_WSTR, offsetof(SESSION_INFO_2, sesi2_cltype_name), 0},
+    {NULL}};
+static struct PyNET_STRUCT_ITEM sesi10[] = {
+    {"client_name", NSI_WSTR, offsetof(SESSION_INFO_10, sesi10_cname), 0},
+    {"user_name", NSI_WSTR, offsetof(SESSION_INFO_10, sesi10_username), 0},
+    {"active_time", NSI_DWORD, offsetof(SESSION_INFO_10, sesi10_time), 0},
+    {"idle_time", NSI_DWORD, offsetof(SESSION_INFO_10, sesi10_idle_time), 0},
+    {NULL}};
+static struct PyNET_STRUCT_ITEM sesi502[] = {
+    {"client_name", NSI_WSTR, offsetof(SESSION_INFO_502, sesi502_cname), 0},
+    {"user_name", NSI_WSTR, offsetof(SESSION_INFO_502, sesi502_username), 0},
+    {"num_opens", NSI_DWORD, offsetof(SESSION_INFO_502, sesi502_num_opens), 0},
+    {"active_time", NSI_DWORD, offsetof(SESSION_INFO_502, sesi502_time), 0},
+    {"idle_time", NSI_DWORD, offsetof(SESSION_INFO_502, sesi502_idle_time), 0},
+    {"user_flags", NSI_DWORD, offsetof(SESSION_INFO_502, sesi502_user_flags), 0},
+    {"client_type", NSI_WSTR, offsetof(SESSION_INFO_502, sesi502_cltype_name), 0},
+    {"transport", NSI_WSTR, offsetof(SESSION_INFO_502, sesi502_transport), 0},
+    {NULL}};
+static struct PyNET_STRUCT session_infos[] = {{0, sesi0, sizeof(SESSION_INFO_0)},
+                                              {1, sesi1, sizeof(SESSION_INFO_1)},
+                                              {2, sesi2, sizeof(SESSION_INFO_2)},
+                                              {10, sesi10, sizeof(SESSION_INFO_10)},
+                                              {502, sesi502, sizeof(SESSION_INFO_502)},
+                                              {0, NULL, 0}};
+
+enum NETBATCH_FUNC {
+    NETBATCH_SHAREENUM,
+    NETBATCH_SESSIONENUM,
+    NETBATCH_WKSTAUSERENUM,
+};
+
+enum NETBATCH_STATE {
+    NBS_QUEUED,
+    NBS_RUNNING,
+    NBS_DONE,
+    NBS_TIMEDOUT,
+    NBS_REPORTED,
+};
+
+// One server.  Once running, the pages are only touched by the worker thread until the state is NBS_DONE.
+struct NETBATCH_ITEM {
+    WCHAR *server;  // malloc'ed, as it may be freed by a worker thread
+    NETBATCH_STATE state;
+    DWORD err;
+    DWORD starttick;
+    BYTE **pages;
+    DWORD *counts;
+    DWORD numpages;
+};
+
+// State shared between the Python object and the worker threads - freed when the last of them releases it.
+struct NETBATCH {
+    LONG refs;
+    CRITICAL_SECTION cs;
+    HANDLE hevent;  // Auto-reset, set whenever a call completes
+    NETBATCH_FUNC func;
+    DWORD level;
+    NETBATCH_ITEM *items;
+    DWORD numitems;
+    DWORD nextitem;  // Next item to be started
+    DWORD *done;     // Indexes of completed items, in the order they completed
+    DWORD numdone, donehead;
+    DWORD *running;  // Item being run by each thread, or -1
+    LONG nextslot;
+    BOOL bCancelled;
+};
+
+static void NetBatchFreePages(NETBATCH_ITEM *item)
+{
+    for (DWORD i = 0; i < item->numpages; i++) NetApiBufferFree(item->pages[i]);
+    free(item->pages);
+    free(item->counts);
+    item->pages = NULL;
+    item->counts = NULL;
+    item->numpages = 0;
+}
+
+static void NetBatchRelease(NETBATCH *batch)
+{
+    if (InterlockedDecrement(&batch->refs) != 0)
+        return;
+    for (DWORD i = 0; i < batch->numitems; i++) {
+        free(batch->items[i].server);
+        NetBatchFreePages(&batch->items[i]);
+    }
+    free(batch->items);
+    free(batch->done);
+    free(batch->running);
+    if (batch->hevent)
+        CloseHandle(batch->hevent);
+    DeleteCriticalSection(&batch->cs);
+    free(batch);
+}
+
+// Makes the call for one server, following any resume handle until all the data has been read.
+static DWORD NetBatchCall(NETBATCH *batch, NETBATCH_ITEM *item)
+{
+    DWORD err, numRead, totalEntries, resumeHandle = 0;
+    do {
+        BYTE *buf = NULL;
+        numRead = 0;
+        switch (batch->func) {
+            case NETBATCH_SHAREENUM:
+                err = NetShareEnum(item->server, batch->level, &buf, MAX_PREFERRED_LENGTH, &numRead, &totalEntries,
+                                   &resumeHandle);
+                break;
+            case NETBATCH_SESSIONENUM:
+                err = NetSessionEnum(item->server, NULL, NULL, batch->level, &buf, MAX_PREFERRED_LENGTH, &numRead,
+                                     &totalEntries, &resumeHandle);
+                break;
+            default:
+                err = NetWkstaUserEnum(item->server, batch->level, &buf, MAX_PREFERRED_LENGTH, &numRead,
+                                       &totalEntries, &resumeHandle);
+                break;
+        }
+        if (err != 0 && err != ERROR_MORE_DATA) {
+            if (buf)
+                NetApiBufferFree(buf);
+            return err;
+        }
+        if (buf == NULL)
+            continue;
+        BYTE **pages = (BYTE **)realloc(item->pages, (item->numpages + 1) * sizeof(BYTE *));
+        if (pages != NULL)
+            item->pages = pages;
+        DWORD *counts = (DWORD *)realloc(item->counts, (item->numpages + 1) * sizeof(DWORD));
+        if (counts != NULL)
+            item->counts = counts;
+        if (pages == NULL || counts == NULL) {
+            NetApiBufferFree(buf);
+            return ERROR_NOT_ENOUGH_MEMORY;
+        }
+        item->pages[item->numpages] = buf;
+        item->counts[item->numpages++] = numRead;
+    } while (err == ERROR_MORE_DATA);
+    return 0;
+}
+
+static DWORD WINAPI NetBatchWorker(LPVOID param)
+{
+    NETBATCH *batch = (NETBATCH *)param;
+    DWORD slot = InterlockedIncrement(&batch->nextslot) - 1;
+    for (;;) {
+        EnterCriticalSection(&batch->cs);
+        if (batch->bCancelled || batch->nextitem >= batch->numitems) {
+            LeaveCriticalSection(&batch->cs);
+            break;
+        }
+        DWORD index = batch->nextitem++;
+        NETBATCH_ITEM *item = &batch->items[index];
+        item->state = NBS_RUNNING;
+        item->starttick = GetTickCount();
+        batch->running[slot] = index;
+        LeaveCriticalSection(&batch->cs);
+
+        DWORD err = NetBatchCall(batch, item);
+
+        EnterCriticalSection(&batch->cs);
+        batch->running[slot] = (DWORD)-1;
+        item->err = err;
+        // If the call has already been reported as timed out, the result is discarded
+        if (item->state == NBS_RUNNING) {
+            item->state = NBS_DONE;
+            batch->done[batch->numdone++] = index;
+        }
+        LeaveCriticalSection(&batch->cs);
+        SetEvent(batch->hevent);
+    }
+    NetBatchRelease(batch);
+    return 0;
+}
+
+class PyNETBATCH : public PyObject {
+   public:
+    PyNETBATCH(void);
+    ~PyNETBATCH(void);
+    static void deallocFunc(PyObject *ob);
+    static PyObject *iternext(PyObject *self);
+    static struct PyMemberDef members[];
+    PyObject *ResultFromItem(DWORD index);
+
+    NETBATCH *batch;
+    PyObject *servers;
+    PyObject *keys;
+    PyNET_STRUCT *pInfo;
+    char *fnname;
+    DWORD timeout, numthreads, numreported;
+    BOOL bBusy;
+};
+
+PyTypeObject PyNETBATCHType = {
+    PYWIN_OBJECT_HEAD "PyNETBATCH",
+    sizeof(PyNETBATCH),
+    0,
+    PyNETBATCH::deallocFunc,  // tp_dealloc
+    0,                        // tp_print
+    0,                        // tp_getattr
+    0,                        // tp_setattr
+    0,                        // tp_compare
+    0,                        // tp_repr
+    0,                        // tp_as_number
+    0,                        // tp_as_sequence
+    0,                        // tp_as_mapping
+    0,                        // tp_hash
+    0,                        // tp_call
+    0,                        // tp_str
+    PyObject_GenericGetAttr,  // tp_getattro
+    0,                        // tp_setattro
+    0,                        // tp_as_buffer
+    Py_TPFLAGS_DEFAULT,       // tp_flags
+    0,                        // tp_doc
+    0,                        // tp_traverse
+    0,                        // tp_clear
+    0,                        // tp_richcompare
+    0,                        // tp_weaklistoffset
+    PyObject_SelfIter,        // tp_iter
+    PyNETBATCH::iternext,     // tp_iternext
+    0,                        // tp_methods
+    PyNETBATCH::members,      // tp_members
+};
+
+// @object PyNETBATCH|Iterator returned by <om win32net.NetBatchEnum>
+// @comm Yields (server, result) as each call completes.  result is a list of dictionaries, or a <o win32net.error>
+//	instance if the call failed or timed out.
+struct PyMemberDef PyNETBATCH::members[] = {
+    // @prop int|Threads|Number of worker threads
+    {"Threads", T_ULONG, offsetof(PyNETBATCH, numthreads), READONLY},
+    // @prop int|Reported|Number of servers returned so far
+    {"Reported", T_ULONG, offsetof(PyNETBATCH, numreported), READONLY},
+    {NULL}};
+
+PyNETBATCH::PyNETBATCH(void)
+{
+    ob_type = &PyNETBATCHType;
+    _Py_NewReference(this);
+    batch = NULL;
+    servers = NULL;
+    keys = NULL;
+    pInfo = NULL;
+    fnname = NULL;
+    timeout = INFINITE;
+    numthreads = numreported = 0;
+    bBusy = FALSE;
+}
+
+PyNETBATCH::~PyNETBATCH(void)
+{
+    if (batch) {
+        // Calls already running can't be interrupted, but no more will be started.
+        EnterCriticalSection(&batch->cs);
+        batch->bCancelled = TRUE;
+        LeaveCriticalSection(&batch->cs);
+        NetBatchRelease(batch);
+    }
+    Py_XDECREF(servers);
+    Py_XDECREF(keys);
+}
+
+void PyNETBATCH::deallocFunc(PyObject *ob) { delete (PyNETBATCH *)ob; }
+
+// Returns the exception instance for a failed call.
+static PyObject *NetBatchError(char *fnname, DWORD err)
+{
+    PyObject *type, *value, *traceback;
+    ReturnNetError(fnname, err);
+    PyErr_Fetch(&type, &value, &traceback);
+    PyErr_NormalizeException(&type, &value, &traceback);
+    Py_XDECREF(type);
+    Py_XDECREF(traceback);
+    return value;
+}
+
+PyObject *PyNETBATCH::ResultFromItem(DWORD index)
+{
+    NETBATCH_ITEM *item = &batch->items[index];
+    PyObject *result;
+    numreported++;
+    if (item->state == NBS_TIMEDOUT)
+        result = NetBatchError(fnname, WAIT_TIMEOUT);
+    else if (item->err)
+        result = NetBatchError(fnname, item->err);
+    else {
+        DWORD total = 0;
+        for (DWORD p = 0; p < item->numpages; p++) total += item->counts[p];
+        result = PyList_New(total);
+        for (DWORD p = 0, n = 0; result != NULL && p < item->numpages; p++) {
+            for (DWORD i = 0; i < item->counts[p]; i++) {
+                PyObject *sub = PyObject_FromNET_STRUCTKeys(pInfo, item->pages[p] + (i * pInfo->structsize), keys);
+                if (sub == NULL) {
+                    Py_DECREF(result);
+                    result = NULL;
+                    break;
+                }
+                PyList_SET_ITEM(result, n++, sub);
+            }
+        }
+        NetBatchFreePages(item);
+    }
+    if (result == NULL)
+        return NULL;
+    return Py_BuildValue("ON", PyTuple_GET_ITEM(servers, index), result);
+}
+
+PyObject *PyNETBATCH::iternext(PyObject *self)
+{
+    PyNETBATCH *This = (PyNETBATCH *)self;
+    NETBATCH *batch = This->batch;
+    for (;;) {
+        DWORD index = (DWORD)-1, wait = INFINITE;
+        EnterCriticalSection(&batch->cs);
+        if (batch->donehead < batch->numdone) {
+            index = batch->done[batch->donehead++];
+            batch->items[index].state = NBS_REPORTED;
+        }
+        else if (This->timeout != INFINITE) {
+            // Look for a running call that has exceeded the timeout, and otherwise work out how long to wait
+            DWORD now = GetTickCount();
+            for (DWORD slot = 0; slot < This->numthreads; slot++) {
+                DWORD running = batch->running[slot];
+                if (running == (DWORD)-1 || batch->items[running].state != NBS_RUNNING)
+                    continue;
+                DWORD elapsed = now - batch->items[running].starttick;
+                if (elapsed >= This->timeout) {
+                    index = running;
+                    batch->items[index].state = NBS_TIMEDOUT;
+                    break;
+                }
+                if (This->timeout - elapsed < wait)
+                    wait = This->timeout - elapsed;
+            }
+        }
+        LeaveCriticalSection(&batch->cs);
+        if (index != (DWORD)-1)
+            return This->ResultFromItem(index);
+        if (This->numreported >= batch->numitems)
+            return NULL;
+        // Only one thread can wait on the event, or a completion could wake the wrong one
+        if (This->bBusy) {
+            PyErr_SetString(PyExc_RuntimeError, "The iterator is already in use by another thread");
+            return NULL;
+        }
+        This->bBusy = TRUE;
+        Py_BEGIN_ALLOW_THREADS WaitForSingleObject(batch->hevent, wait);
+        Py_END_ALLOW_THREADS This->bBusy = FALSE;
+    }
+}
+
+// @pymethod <o PyNETBATCH>|win32net|NetBatchEnum|Calls an enumeration function against many servers concurrently
+// @comm The calls are made from a pool of native threads, each fetching all the data for a server (following any
+//	resume handle) before moving on to the next.  Results are returned as each call completes, so the order is
+//	not that of the Servers sequence.
+// @comm Net* calls can't be cancelled, so a call that exceeds Timeout is reported as failed with WAIT_TIMEOUT and its
+//	thread is abandoned until the call returns, at which point the thread moves on to the next server.
+//	Destroying the iterator prevents any further calls from being started.
+// @rdesc Returns an iterator yielding (server, result) tuples, where server is the item from the Servers sequence
+//	and result is a list of dictionaries as returned by the specified function, or a <o win32net.error> instance.
+PyObject *PyNetBatchEnum(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Function", "Servers", "Level", "Threads", "Timeout", NULL};
+    char *fnname;
+    PyObject *observers;
+    DWORD level, numthreads = 16, timeout = INFINITE, numservers, i;
+    NETBATCH_FUNC func;
+    PyNET_STRUCT *pInfos, *pInfo;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "sOk|kk:NetBatchEnum", keywords,
+            &fnname,      // @pyparm str|Function||Name of the function to call, one of NetShareEnum, NetSessionEnum or
+                          // NetWkstaUserEnum
+            &observers,   // @pyparm [string/<o PyUnicode>, ...]|Servers||Sequence of server names, None can be used
+                          // for the local machine
+            &level,       // @pyparm int|Level||The level of data required
+            &numthreads,  // @pyparm int|Threads|16|Maximum number of calls to run at once
+            &timeout))    // @pyparm int|Timeout|INFINITE|Time in milliseconds that each call is allowed to run
+        return NULL;
+    if (strcmp(fnname, "NetShareEnum") == 0) {
+        func = NETBATCH_SHAREENUM;
+        pInfos = share_infos;
+        fnname = "NetShareEnum";
+    }
+    else if (strcmp(fnname, "NetSessionEnum") == 0) {
+        func = NETBATCH_SESSIONENUM;
+        pInfos = session_infos;
+        fnname = "NetSessionEnum";
+    }
+    else if (strcmp(fnname, "NetWkstaUserEnum") == 0) {
+        func = NETBATCH_WKSTAUSERENUM;
+        pInfos = wktau_infos;
+        fnname = "NetWkstaUserEnum";
+    }
+    else
+        return PyErr_Format(PyExc_ValueError, "Function '%s' is not supported", fnname);
+    if (!FindNET_STRUCT(level, pInfos, &pInfo))
+        return NULL;
+    if (numthreads == 0) {
+        PyErr_SetString(PyExc_ValueError, "Threads must be at least 1");
+        return NULL;
+    }
+
+    PyNETBATCH *ret = new PyNETBATCH();
+    if (ret == NULL)
+        return PyErr_NoMemory();
+    ret->pInfo = pInfo;
+    ret->fnname = fnname;
+    ret->timeout = timeout;
+    ret->servers = PyWinSequence_Tuple(observers, &numservers);
+    if (ret->servers == NULL) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    // Attribute names are created once, rather than for every entry
+    DWORD numkeys = 0;
+    while (pInfo->entries[numkeys].attrname != NULL) numkeys++;
+    ret->keys = PyTuple_New(numkeys);
+    if (ret->keys == NULL) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    for (i = 0; i < numkeys; i++) {
+        PyObject *key = PyUnicode_InternFromString(pInfo->entries[i].attrname);
+        if (key == NULL) {
+            Py_DECREF(ret);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(ret->keys, i, key);
+    }
+
+    if (numthreads > numservers)
+        numthreads = numservers;
+    NETBATCH *batch = (NETBATCH *)malloc(sizeof(NETBATCH));
+    if (batch == NULL) {
+        Py_DECREF(ret);
+        return PyErr_NoMemory();
+    }
+    ZeroMemory(batch, sizeof(NETBATCH));
+    InitializeCriticalSection(&batch->cs);
+    batch->refs = 1;
+    batch->func = func;
+    batch->level = level;
+    batch->numitems = numservers;
+    ret->batch = batch;
+    batch->hevent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (batch->hevent == NULL) {
+        PyWin_SetAPIError("CreateEvent");
+        Py_DECREF(ret);
+        return NULL;
+    }
+    // Allocate at least one of each, so an empty Servers sequence isn't mistaken for a failure
+    batch->items = (NETBATCH_ITEM *)calloc(numservers + 1, sizeof(NETBATCH_ITEM));
+    batch->done = (DWORD *)malloc((numservers + 1) * sizeof(DWORD));
+    batch->running = (DWORD *)malloc((numthreads + 1) * sizeof(DWORD));
+    if (batch->items == NULL || batch->done == NULL || batch->running == NULL) {
+        Py_DECREF(ret);
+        return PyErr_NoMemory();
+    }
+    for (i = 0; i < numthreads; i++) batch->running[i] = (DWORD)-1;
+    for (i = 0; i < numservers; i++) {
+        WCHAR *server;
+        if (!PyWinObject_AsWCHAR(PyTuple_GET_ITEM(ret->servers, i), &server, TRUE)) {
+            Py_DECREF(ret);
+            return NULL;
+        }
+        if (server != NULL) {
+            size_t len = wcslen(server) + 1;
+            batch->items[i].server = (WCHAR *)malloc(len * sizeof(WCHAR));
+            if (batch->items[i].server != NULL)
+                memcpy(batch->items[i].server, server, len * sizeof(WCHAR));
+            PyWinObject_FreeWCHAR(server);
+            if (batch->items[i].server == NULL) {
+                Py_DECREF(ret);
+                return PyErr_NoMemory();
+            }
+        }
+        batch->items[i].state = NBS_QUEUED;
+    }
+
+    for (i = 0; i < numthreads; i++) {
+        InterlockedIncrement(&batch->refs);
+        HANDLE hthread = CreateThread(NULL, 0, NetBatchWorker, batch, 0, NULL);
+        if (hthread == NULL) {
+            InterlockedDecrement(&batch->refs);
+            // Any threads already running will still complete the whole batch
+            if (i == 0) {
+                PyWin_SetAPIError("CreateThread");
+                Py_DECREF(ret);
+                return NULL;
+            }
+            break;
+        }
+        CloseHandle(hthread);
+    }
+    ret->numthreads = numthreads;
+    return ret;
+}
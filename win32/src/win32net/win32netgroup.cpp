@@ -308,6 +308,21 @@ PyObject *PyNetGroupEnum(PyObject *self, PyObject *args)
     return PyDoSimpleEnum(self, args, &NetGroupEnum, "NetGroupEnum", group_infos);
 }
 
+// @pymethod <o PyNETENUM>|win32net|NetGroupEnumIterator|Returns an iterator over the global groups on a server
+// @rdesc Each item is a dictionary of format <o PyGROUP_INFO_*>, depending on the level parameter.
+// @comm Unlike <om win32net.NetGroupEnum>, the resume handle is managed internally - every page is fetched as
+// the iterator is consumed, without the GIL.  If columns is True, each item is instead a dictionary of lists, one
+// list per attribute, holding a whole page of entries.
+PyObject *PyNetGroupEnumIterator(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    // @pyparm string/<o PyUnicode>|server||The name of the server, or None.
+    // @pyparm int|level||The level of data required.
+    // @pyparm bool|columns|False|If True, each page is returned as a dictionary of lists
+    // @pyparm int|prefLen|MAX_PREFERRED_LENGTH|The preferred length of the data buffer.
+    // @pyseeapi NetGroupEnum
+    return PyDoEnumIterator(args, kwargs, &NetGroupEnum, NULL, NULL, "NetGroupEnum", group_infos);
+}
+
 // @pymethod ([dict, ...], total, resumeHandle)|win32net|NetGroupGetUsers|Enumerates the users in a group.
 // @rdesc The result is a list of items read (with each item being a dictionary of format
 // <o PyGROUP_USERS_INFO_*>, depending on the level parameter),
@@ -328,6 +343,22 @@ PyObject *PyNetGroupGetUsers(PyObject *self, PyObject *args)
     return PyDoNamedEnum(self, args, &NetGroupGetUsers, "NetGroupGetUsers", group_users_infos);
 }
 
+// @pymethod <o PyNETENUM>|win32net|NetGroupGetUsersIterator|Returns an iterator over the users in a global group
+// @rdesc Each item is a dictionary of format <o PyGROUP_USERS_INFO_*>, depending on the level parameter.
+// @comm Unlike <om win32net.NetGroupGetUsers>, the resume handle is managed internally - every page is fetched as
+// the iterator is consumed, without the GIL.  If columns is True, each item is instead a dictionary of lists, one
+// list per attribute, holding a whole page of entries.
+PyObject *PyNetGroupGetUsersIterator(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    // @pyparm string/<o PyUnicode>|server||The name of the server, or None.
+    // @pyparm string/<o PyUnicode>|groupName||The name of the group.
+    // @pyparm int|level||The level of data required.
+    // @pyparm bool|columns|False|If True, each page is returned as a dictionary of lists
+    // @pyparm int|prefLen|MAX_PREFERRED_LENGTH|The preferred length of the data buffer.
+    // @pyseeapi NetGroupGetUsers
+    return PyDoEnumIterator(args, kwargs, NULL, &NetGroupGetUsers, NULL, "NetGroupGetUsers", group_users_infos);
+}
+
 PyObject *PyNetGroupSetUsers(PyObject *self, PyObject *args)
 {
     // @pymethod |win32net|NetGroupSetUsers|Sets the members of a local group.  Any existing members not listed are
@@ -405,6 +436,21 @@ PyObject *PyNetLocalGroupEnum(PyObject *self, PyObject *args)
     return PyDoSimpleEnum(self, args, &NetLocalGroupEnum, "NetLocalGroupEnum", localgroup_infos);
 }
 
+// @pymethod <o PyNETENUM>|win32net|NetLocalGroupEnumIterator|Returns an iterator over the local groups on a server
+// @rdesc Each item is a dictionary of format <o PyLOCALGROUP_INFO_*>, depending on the level parameter.
+// @comm Unlike <om win32net.NetLocalGroupEnum>, the resume handle is managed internally - every page is fetched as
+// the iterator is consumed, without the GIL.  If columns is True, each item is instead a dictionary of lists, one
+// list per attribute, holding a whole page of entries.
+PyObject *PyNetLocalGroupEnumIterator(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    // @pyparm string/<o PyUnicode>|server||The name of the server, or None.
+    // @pyparm int|level||The level of data required.
+    // @pyparm bool|columns|False|If True, each page is returned as a dictionary of lists
+    // @pyparm int|prefLen|MAX_PREFERRED_LENGTH|The preferred length of the data buffer.
+    // @pyseeapi NetLocalGroupEnum
+    return PyDoEnumIterator(args, kwargs, &NetLocalGroupEnum, NULL, NULL, "NetLocalGroupEnum", localgroup_infos);
+}
+
 PyObject *PyNetLocalGroupAddMembers(PyObject *self, PyObject *args)
 {
     // @pymethod |win32net|NetLocalGroupAddMembers|Adds users to a local group.
@@ -449,6 +495,22 @@ PyObject *PyNetLocalGroupGetMembers(PyObject *self, PyObject *args)
     return PyDoNamedEnum(self, args, &NetLocalGroupGetMembers, "NetLocalGroupGetMembers", localgroup_members_infos);
 }
 
+// @pymethod <o PyNETENUM>|win32net|NetLocalGroupGetMembersIterator|Returns an iterator over the members of a local group
+// @rdesc Each item is a dictionary of format <o PyLOCALGROUP_MEMBERS_INFO_*>, depending on the level parameter.
+// @comm Unlike <om win32net.NetLocalGroupGetMembers>, the resume handle is managed internally - every page is fetched as
+// the iterator is consumed, without the GIL.  If columns is True, each item is instead a dictionary of lists, one
+// list per attribute, holding a whole page of entries.
+PyObject *PyNetLocalGroupGetMembersIterator(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    // @pyparm string/<o PyUnicode>|server||The name of the server, or None.
+    // @pyparm string/<o PyUnicode>|groupName||The name of the group.
+    // @pyparm int|level||The level of data required.
+    // @pyparm bool|columns|False|If True, each page is returned as a dictionary of lists
+    // @pyparm int|prefLen|MAX_PREFERRED_LENGTH|The preferred length of the data buffer.
+    // @pyseeapi NetLocalGroupGetMembers
+    return PyDoEnumIterator(args, kwargs, NULL, &NetLocalGroupGetMembers, NULL, "NetLocalGroupGetMembers", localgroup_members_infos);
+}
+
 PyObject *PyNetLocalGroupDelMembers(PyObject *self, PyObject *args)
 {
     // @pymethod |win32net|NetLocalGroupDelMembers|Deletes users from a local group.
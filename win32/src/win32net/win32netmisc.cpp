@@ -72,7 +72,7 @@ static struct PyNET_STRUCT_ITEM si502[] = {SI502_ENTRY(netname, NSI_WSTR, 0),  /
                                            {NULL}};
 
 // @object PySHARE_INFO_*|The following SHARE_INFO levels are supported.
-static struct PyNET_STRUCT share_infos[] = {  // @flagh Level|Data
+struct PyNET_STRUCT share_infos[] = {  // @flagh Level|Data
     {0, si0, sizeof(SHARE_INFO_0)},           // @flag 0|<o PySHARE_INFO_0>
     {1, si1, sizeof(SHARE_INFO_1)},           // @flag 1|<o PySHARE_INFO_1>
     {2, si2, sizeof(SHARE_INFO_2)},           // @flag 2|<o PySHARE_INFO_2>
@@ -337,7 +337,7 @@ static struct PyNET_STRUCT_ITEM wkui1[] = {
     {NULL}};
 
 // @object PyWKSTA_USER_INFO_*|The following WKSTA_USER_INFO levels are supported.
-static struct PyNET_STRUCT wktau_infos[] = {  // @flagh Level|Data
+struct PyNET_STRUCT wktau_infos[] = {  // @flagh Level|Data
     {0, wkui0, sizeof(WKSTA_USER_INFO_0)},    // @flag 0,| <o PyWKSTA_USER_INFO_0>
     {1, wkui1, sizeof(WKSTA_USER_INFO_1)},    // @flag 1,| <o PyWKSTA_USER_INFO_1>
     {0, NULL, 0}};
@@ -467,6 +467,21 @@ PyObject *PyNetShareEnum(PyObject *self, PyObject *args)
     return PyDoSimpleEnum(self, args, pfn, "NetShareEnum", share_infos);
 }
 
+// @pymethod <o PyNETENUM>|win32net|NetShareEnumIterator|Returns an iterator over the shared resources on a server
+// @rdesc Each item is a dictionary of format <o PySHARE_INFO_*>, depending on the level parameter.
+// @comm Unlike <om win32net.NetShareEnum>, the resume handle is managed internally - every page is fetched as
+// the iterator is consumed, without the GIL.  If columns is True, each item is instead a dictionary of lists, one
+// list per attribute, holding a whole page of entries.
+PyObject *PyNetShareEnumIterator(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    // @pyparm string/<o PyUnicode>|server||The name of the server, or None.
+    // @pyparm int|level||The level of data required.
+    // @pyparm bool|columns|False|If True, each page is returned as a dictionary of lists
+    // @pyparm int|prefLen|MAX_PREFERRED_LENGTH|The preferred length of the data buffer.
+    // @pyseeapi NetShareEnum
+    return PyDoEnumIterator(args, kwargs, (PFNSIMPLEENUM)&NetShareEnum, NULL, NULL, "NetShareEnum", share_infos);
+}
+
 // @pymethod dict|win32net|NetShareGetInfo|Retrieves information about a particular share on a server.
 PyObject *PyNetShareGetInfo(PyObject *self, PyObject *args)
 {
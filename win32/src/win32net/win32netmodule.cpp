@@ -35,6 +35,7 @@ conversion is required.
 #include "win32net.h"
 
 #include "assert.h"
+#include "structmember.h"
 
 #if WINVER >= 0x0500
 NetGetJoinInformationfunc pfnNetGetJoinInformation = NULL;
@@ -207,47 +208,53 @@ done:
     return TRUE;
 }
 
+PyObject *PyObject_FromNET_STRUCT_ITEM(PyNET_STRUCT_ITEM *pItem, BYTE *buf)
+{
+    PyObject *newObj = NULL;
+    switch (pItem->type) {
+        case NSI_WSTR:
+            newObj = PyWinObject_FromWCHAR(*((WCHAR **)(buf + pItem->off)));
+            break;
+        case NSI_DWORD:
+            newObj = PyLong_FromUnsignedLong(*((DWORD *)(buf + pItem->off)));
+            break;
+        case NSI_LONG:
+            newObj = PyInt_FromLong(*((LONG *)(buf + pItem->off)));
+            break;
+        case NSI_BOOL:
+            newObj = *((BOOL *)(buf + pItem->off)) ? Py_True : Py_False;
+            Py_INCREF(newObj);
+            break;
+        case NSI_HOURS: {
+            char *data = *((char **)(buf + pItem->off));
+            if (data) {
+                newObj = PyString_FromStringAndSize(data, 21);
+            }
+            else {
+                newObj = Py_None;
+                Py_INCREF(Py_None);
+            }
+            break;
+        }
+        case NSI_SID:
+            newObj = PyWinObject_FromSID(*((SID **)(buf + pItem->off)));
+            break;
+        case NSI_SECURITY_DESCRIPTOR:
+            newObj = PyWinObject_FromSECURITY_DESCRIPTOR(*((PSECURITY_DESCRIPTOR *)(buf + pItem->off)));
+            break;
+        default:
+            PyErr_SetString(PyExc_RuntimeError, "invalid internal data");
+            break;
+    }
+    return newObj;
+}
+
 PyObject *PyObject_FromNET_STRUCT(PyNET_STRUCT *pI, BYTE *buf)
 {
     PyObject *ret = PyDict_New();
     PyNET_STRUCT_ITEM *pItem;
     for (pItem = pI->entries; pItem->attrname != NULL; pItem++) {
-        PyObject *newObj = NULL;
-        switch (pItem->type) {
-            case NSI_WSTR:
-                newObj = PyWinObject_FromWCHAR(*((WCHAR **)(buf + pItem->off)));
-                break;
-            case NSI_DWORD:
-                newObj = PyLong_FromUnsignedLong(*((DWORD *)(buf + pItem->off)));
-                break;
-            case NSI_LONG:
-                newObj = PyInt_FromLong(*((LONG *)(buf + pItem->off)));
-                break;
-            case NSI_BOOL:
-                newObj = *((BOOL *)(buf + pItem->off)) ? Py_True : Py_False;
-                Py_INCREF(newObj);
-                break;
-            case NSI_HOURS: {
-                char *data = *((char **)(buf + pItem->off));
-                if (data) {
-                    newObj = PyString_FromStringAndSize(data, 21);
-                }
-                else {
-                    newObj = Py_None;
-                    Py_INCREF(Py_None);
-                }
-                break;
-            }
-            case NSI_SID:
-                newObj = PyWinObject_FromSID(*((SID **)(buf + pItem->off)));
-                break;
-            case NSI_SECURITY_DESCRIPTOR:
-                newObj = PyWinObject_FromSECURITY_DESCRIPTOR(*((PSECURITY_DESCRIPTOR *)(buf + pItem->off)));
-                break;
-            default:
-                PyErr_SetString(PyExc_RuntimeError, "invalid internal data");
-                break;
-        }
+        PyObject *newObj = PyObject_FromNET_STRUCT_ITEM(pItem, buf);
         if (newObj == NULL) {
             Py_DECREF(ret);
             return NULL;
@@ -258,6 +265,24 @@ PyObject *PyObject_FromNET_STRUCT(PyNET_STRUCT *pI, BYTE *buf)
     return ret;
 }
 
+// As above, but using the attribute names already created by the caller, one for each entry in pI
+PyObject *PyObject_FromNET_STRUCTKeys(PyNET_STRUCT *pI, BYTE *buf, PyObject *keys)
+{
+    PyObject *ret = PyDict_New();
+    if (ret == NULL)
+        return NULL;
+    for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(keys); i++) {
+        PyObject *newObj = PyObject_FromNET_STRUCT_ITEM(&pI->entries[i], buf);
+        if (newObj == NULL || PyDict_SetItem(ret, PyTuple_GET_ITEM(keys, i), newObj) == -1) {
+            Py_XDECREF(newObj);
+            Py_DECREF(ret);
+            return NULL;
+        }
+        Py_DECREF(newObj);
+    }
+    return ret;
+}
+
 PyObject *PyDoSimpleEnum(PyObject *self, PyObject *args, PFNSIMPLEENUM pfn, char *fnname, PyNET_STRUCT *pInfos)
 {
     WCHAR *szServer = NULL;
@@ -381,6 +406,260 @@ done:
     return ret;
 }
 
+// The native iterator behind the Net*EnumIterator functions.  Pages are fetched with MAX_PREFERRED_LENGTH (by
+// default) and the GIL released, and entries are converted using the level's PyNET_STRUCT table with the
+// attribute names created once per iterator.
+class PyNETENUM : public PyObject {
+   public:
+    PyNETENUM(void);
+    ~PyNETENUM(void);
+    static void deallocFunc(PyObject *ob);
+    static PyObject *iternext(PyObject *self);
+    static struct PyMemberDef members[];
+    BOOL Init(PyNET_STRUCT *pInfo);
+    DWORD FetchPage(void);
+    PyObject *ColumnsFromPage(void);
+
+    PFNSIMPLEENUM pfnSimple;
+    PFNNAMEDENUM pfnNamed;
+    PFNFILTEREDENUM pfnFiltered;
+    char *fnname;
+    WCHAR *szServer, *szName;
+    DWORD level, filter, dwPrefLen;
+    BOOL bColumns;
+
+   protected:
+    PyNET_STRUCT *pInfo;
+    PyObject *keys;  // Interned attribute names, in the same order as pInfo->entries
+    DWORD numKeys;
+    DWORD_PTR resumeHandle;
+    DWORD resumeHandle32;  // Used by the functions (eg NetUserEnum) that take a DWORD resume handle
+    BYTE *buf;
+    DWORD numRead, index, totalEntries, numPages;
+    BOOL bMore, bBusy;
+};
+
+PyTypeObject PyNETENUMType = {
+    PYWIN_OBJECT_HEAD "PyNETENUM",
+    sizeof(PyNETENUM),
+    0,
+    PyNETENUM::deallocFunc,   // tp_dealloc
+    0,                        // tp_print
+    0,                        // tp_getattr
+    0,                        // tp_setattr
+    0,                        // tp_compare
+    0,                        // tp_repr
+    0,                        // tp_as_number
+    0,                        // tp_as_sequence
+    0,                        // tp_as_mapping
+    0,                        // tp_hash
+    0,                        // tp_call
+    0,                        // tp_str
+    PyObject_GenericGetAttr,  // tp_getattro
+    0,                        // tp_setattro
+    0,                        // tp_as_buffer
+    Py_TPFLAGS_DEFAULT,       // tp_flags
+    0,                        // tp_doc
+    0,                        // tp_traverse
+    0,                        // tp_clear
+    0,                        // tp_richcompare
+    0,                        // tp_weaklistoffset
+    PyObject_SelfIter,        // tp_iter
+    PyNETENUM::iternext,      // tp_iternext
+    0,                        // tp_methods
+    PyNETENUM::members,       // tp_members
+};
+
+// @object PyNETENUM|Iterator returned by the win32net Net*EnumIterator functions.
+// @comm Yields a dictionary for each entry, or a dictionary of lists for each page if columns=True was passed.
+struct PyMemberDef PyNETENUM::members[] = {
+    // @prop int|TotalEntries|Total number of entries as reported by the most recent page
+    {"TotalEntries", T_ULONG, offsetof(PyNETENUM, totalEntries), READONLY},
+    // @prop int|Pages|Number of pages fetched so far
+    {"Pages", T_ULONG, offsetof(PyNETENUM, numPages), READONLY},
+    {NULL}};
+
+PyNETENUM::PyNETENUM(void)
+{
+    ob_type = &PyNETENUMType;
+    _Py_NewReference(this);
+    pfnSimple = NULL;
+    pfnNamed = NULL;
+    pfnFiltered = NULL;
+    fnname = NULL;
+    szServer = szName = NULL;
+    level = filter = 0;
+    dwPrefLen = MAX_PREFERRED_LENGTH;
+    bColumns = FALSE;
+    pInfo = NULL;
+    keys = NULL;
+    numKeys = 0;
+    resumeHandle = 0;
+    resumeHandle32 = 0;
+    buf = NULL;
+    numRead = index = totalEntries = numPages = 0;
+    bMore = TRUE;
+    bBusy = FALSE;
+}
+
+PyNETENUM::~PyNETENUM(void)
+{
+    if (buf)
+        NetApiBufferFree(buf);
+    PyWinObject_FreeWCHAR(szServer);
+    PyWinObject_FreeWCHAR(szName);
+    Py_XDECREF(keys);
+}
+
+void PyNETENUM::deallocFunc(PyObject *ob) { delete (PyNETENUM *)ob; }
+
+BOOL PyNETENUM::Init(PyNET_STRUCT *pInfo)
+{
+    PyNET_STRUCT_ITEM *pItem;
+    this->pInfo = pInfo;
+    for (pItem = pInfo->entries; pItem->attrname != NULL; pItem++) numKeys++;
+    keys = PyTuple_New(numKeys);
+    if (keys == NULL)
+        return FALSE;
+    for (DWORD i = 0; i < numKeys; i++) {
+        PyObject *key = PyUnicode_InternFromString(pInfo->entries[i].attrname);
+        if (key == NULL)
+            return FALSE;
+        PyTuple_SET_ITEM(keys, i, key);
+    }
+    return TRUE;
+}
+
+// Fetches the next non-empty page, called without the GIL.
+DWORD PyNETENUM::FetchPage(void)
+{
+    DWORD err = 0;
+    while (bMore) {
+        if (buf) {
+            NetApiBufferFree(buf);
+            buf = NULL;
+        }
+        numRead = index = 0;
+        /* Bad resume handles etc can cause access violations here - catch them. */
+        PYWINTYPES_TRY
+        {
+            if (pfnSimple)
+                err = (*pfnSimple)(szServer, level, &buf, dwPrefLen, &numRead, &totalEntries, &resumeHandle);
+            else if (pfnNamed)
+                err = (*pfnNamed)(szServer, szName, level, &buf, dwPrefLen, &numRead, &totalEntries, &resumeHandle);
+            else
+                err = (*pfnFiltered)(szServer, level, filter, &buf, dwPrefLen, &numRead, &totalEntries,
+                                     &resumeHandle32);
+        }
+        PYWINTYPES_EXCEPT { err = ERROR_INVALID_PARAMETER; }
+        if (err != 0 && err != ERROR_MORE_DATA) {
+            bMore = FALSE;
+            return err;
+        }
+        numPages++;
+        bMore = err == ERROR_MORE_DATA;
+        if (numRead)
+            break;
+    }
+    return 0;
+}
+
+PyObject *PyNETENUM::ColumnsFromPage(void)
+{
+    PyObject *ret = PyDict_New();
+    if (ret == NULL)
+        return NULL;
+    for (DWORD k = 0; k < numKeys; k++) {
+        PyObject *column = PyList_New(numRead);
+        if (column == NULL || PyDict_SetItem(ret, PyTuple_GET_ITEM(keys, k), column) == -1) {
+            Py_XDECREF(column);
+            Py_DECREF(ret);
+            return NULL;
+        }
+        Py_DECREF(column);
+        for (DWORD i = 0; i < numRead; i++) {
+            PyObject *val = PyObject_FromNET_STRUCT_ITEM(&pInfo->entries[k], buf + (i * pInfo->structsize));
+            if (val == NULL) {
+                Py_DECREF(ret);
+                return NULL;
+            }
+            PyList_SET_ITEM(column, i, val);
+        }
+    }
+    index = numRead;
+    return ret;
+}
+
+PyObject *PyNETENUM::iternext(PyObject *self)
+{
+    PyNETENUM *This = (PyNETENUM *)self;
+    DWORD err = 0;
+    if (This->bBusy) {
+        PyErr_SetString(PyExc_RuntimeError, "The iterator is already in use by another thread");
+        return NULL;
+    }
+    if (This->index >= This->numRead) {
+        if (!This->bMore)
+            return NULL;
+        This->bBusy = TRUE;
+        Py_BEGIN_ALLOW_THREADS err = This->FetchPage();
+        Py_END_ALLOW_THREADS This->bBusy = FALSE;
+        if (err)
+            return ReturnNetError(This->fnname, err);
+        if (This->index >= This->numRead)
+            return NULL;
+    }
+    if (This->bColumns)
+        return This->ColumnsFromPage();
+    return PyObject_FromNET_STRUCTKeys(This->pInfo, This->buf + (This->index++ * This->pInfo->structsize),
+                                       This->keys);
+}
+
+// Creates a PyNETENUM for one of the Net*EnumIterator functions.  Exactly one of the function pointers is given, and
+// determines the arguments accepted.
+PyObject *PyDoEnumIterator(PyObject *args, PyObject *kwargs, PFNSIMPLEENUM pfnSimple, PFNNAMEDENUM pfnNamed,
+                           PFNFILTEREDENUM pfnFiltered, char *fnname, PyNET_STRUCT *pInfos)
+{
+    static char *simple_keywords[] = {"server", "level", "columns", "prefLen", NULL};
+    static char *named_keywords[] = {"server", "groupName", "level", "columns", "prefLen", NULL};
+    static char *filtered_keywords[] = {"server", "level", "filter", "columns", "prefLen", NULL};
+    PyObject *obServer, *obName = NULL;
+    PyNET_STRUCT *pInfo;
+    DWORD level, filter = FILTER_NORMAL_ACCOUNT, dwPrefLen = MAX_PREFERRED_LENGTH;
+    int bColumns = FALSE;
+    BOOL ok;
+    if (pfnSimple)
+        ok = PyArg_ParseTupleAndKeywords(args, kwargs, "Ok|ik", simple_keywords, &obServer, &level, &bColumns,
+                                         &dwPrefLen);
+    else if (pfnNamed)
+        ok = PyArg_ParseTupleAndKeywords(args, kwargs, "OOk|ik", named_keywords, &obServer, &obName, &level,
+                                         &bColumns, &dwPrefLen);
+    else
+        ok = PyArg_ParseTupleAndKeywords(args, kwargs, "Ok|kik", filtered_keywords, &obServer, &level, &filter,
+                                         &bColumns, &dwPrefLen);
+    if (!ok)
+        return NULL;
+    if (!FindNET_STRUCT(level, pInfos, &pInfo))
+        return NULL;
+    PyNETENUM *ret = new PyNETENUM();
+    if (ret == NULL)
+        return PyErr_NoMemory();
+    ret->pfnSimple = pfnSimple;
+    ret->pfnNamed = pfnNamed;
+    ret->pfnFiltered = pfnFiltered;
+    ret->fnname = fnname;
+    ret->level = level;
+    ret->filter = filter;
+    ret->dwPrefLen = dwPrefLen;
+    ret->bColumns = bColumns;
+    if (!ret->Init(pInfo) || !PyWinObject_AsWCHAR(obServer, &ret->szServer, TRUE) ||
+        (obName != NULL && !PyWinObject_AsWCHAR(obName, &ret->szName, FALSE))) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    return ret;
+}
+
 PyObject *PyDoGroupSet(PyObject *self, PyObject *args, PFNGROUPSET pfn, char *fnname, PyNET_STRUCT *pInfos)
 {
     WCHAR *szServer = NULL;
@@ -996,6 +1275,7 @@ extern PyObject *PyNetUserSetInfo(PyObject *self, PyObject *args);
 extern PyObject *PyNetUserGetInfo(PyObject *self, PyObject *args);
 extern PyObject *PyNetUserDel(PyObject *self, PyObject *args);
 extern PyObject *PyNetUserEnum(PyObject *self, PyObject *args);
+extern PyObject *PyNetUserEnumIterator(PyObject *self, PyObject *args, PyObject *kwargs);
 extern PyObject *PyNetUserChangePassword(PyObject *self, PyObject *args);
 extern PyObject *PyNetUserGetLocalGroups(PyObject *self, PyObject *args);
 extern PyObject *PyNetUserGetGroups(PyObject *self, PyObject *args);
@@ -1010,7 +1290,9 @@ extern PyObject *PyNetGroupAddUser(PyObject *self, PyObject *args);
 extern PyObject *PyNetGroupDel(PyObject *self, PyObject *args);
 extern PyObject *PyNetGroupDelUser(PyObject *self, PyObject *args);
 extern PyObject *PyNetGroupEnum(PyObject *self, PyObject *args);
+extern PyObject *PyNetGroupEnumIterator(PyObject *self, PyObject *args, PyObject *kwargs);
 extern PyObject *PyNetGroupGetUsers(PyObject *self, PyObject *args);
+extern PyObject *PyNetGroupGetUsersIterator(PyObject *self, PyObject *args, PyObject *kwargs);
 extern PyObject *PyNetGroupSetUsers(PyObject *self, PyObject *args);
 
 extern PyObject *PyNetLocalGroupGetInfo(PyObject *self, PyObject *args);
@@ -1020,7 +1302,9 @@ extern PyObject *PyNetLocalGroupAddMembers(PyObject *self, PyObject *args);
 extern PyObject *PyNetLocalGroupDelMembers(PyObject *self, PyObject *args);
 extern PyObject *PyNetLocalGroupDel(PyObject *self, PyObject *args);
 extern PyObject *PyNetLocalGroupEnum(PyObject *self, PyObject *args);
+extern PyObject *PyNetLocalGroupEnumIterator(PyObject *self, PyObject *args, PyObject *kwargs);
 extern PyObject *PyNetLocalGroupGetMembers(PyObject *self, PyObject *args);
+extern PyObject *PyNetLocalGroupGetMembersIterator(PyObject *self, PyObject *args, PyObject *kwargs);
 extern PyObject *PyNetLocalGroupSetMembers(PyObject *self, PyObject *args);
 
 extern PyObject *PyNetServerEnum(PyObject *self, PyObject *args);
@@ -1030,6 +1314,7 @@ extern PyObject *PyNetServerSetInfo(PyObject *self, PyObject *args);
 extern PyObject *PyNetShareAdd(PyObject *self, PyObject *args);
 extern PyObject *PyNetShareDel(PyObject *self, PyObject *args);
 extern PyObject *PyNetShareEnum(PyObject *self, PyObject *args);
+extern PyObject *PyNetShareEnumIterator(PyObject *self, PyObject *args, PyObject *kwargs);
 extern PyObject *PyNetShareGetInfo(PyObject *self, PyObject *args);
 extern PyObject *PyNetShareSetInfo(PyObject *self, PyObject *args);
 extern PyObject *PyNetShareCheck(PyObject *self, PyObject *args);
@@ -1049,6 +1334,7 @@ extern PyObject *PyNetUseDel(PyObject *self, PyObject *args);
 extern PyObject *PyNetUseEnum(PyObject *self, PyObject *args);
 extern PyObject *PyNetUseGetInfo(PyObject *self, PyObject *args);
 extern PyObject *PyNetSessionEnum(PyObject *self, PyObject *args);
+extern PyObject *PyNetBatchEnum(PyObject *self, PyObject *args, PyObject *kwargs);
 extern PyObject *PyNetSessionDel(PyObject *self, PyObject *args);
 extern PyObject *PyNetSessionGetInfo(PyObject *self, PyObject *args);
 extern PyObject *PyNetFileEnum(PyObject *self, PyObject *args);
@@ -1070,6 +1356,8 @@ static struct PyMethodDef win32net_functions[] = {
     {"NetGroupGetInfo", PyNetGroupGetInfo,
      1},  // @pymeth NetGroupGetInfo|Retrieves information about a particular group on a server.
     {"NetGroupGetUsers", PyNetGroupGetUsers, 1},  // @pymeth NetGroupGetUsers|Enumerates the users in a group.
+    {"NetGroupGetUsersIterator", (PyCFunction)PyNetGroupGetUsersIterator,
+     METH_VARARGS | METH_KEYWORDS},  // @pymeth NetGroupGetUsersIterator|Returns an iterator over the users in a group.
     {"NetGroupSetUsers", PyNetGroupSetUsers, 1},  // @pymeth NetGroupSetUsers|Sets the users in a group on server.
     {"NetGroupSetInfo", PyNetGroupSetInfo,
      1},  // @pymeth NetGroupSetInfo|Sets information about a particular group account on a server.
@@ -1078,6 +1366,8 @@ static struct PyMethodDef win32net_functions[] = {
     {"NetGroupDel", PyNetGroupDel, 1},          // @pymeth NetGroupDel|Deletes a group.
     {"NetGroupDelUser", PyNetGroupDelUser, 1},  // @pymeth NetGroupDelUser|Deletes a user from the group
     {"NetGroupEnum", PyNetGroupEnum, 1},        // @pymeth NetGroupEnum|Enumerates the groups.
+    {"NetGroupEnumIterator", (PyCFunction)PyNetGroupEnumIterator,
+     METH_VARARGS | METH_KEYWORDS},  // @pymeth NetGroupEnumIterator|Returns an iterator over the groups.
 
     {"NetLocalGroupAdd", PyNetLocalGroupAdd, 1},  // @pymeth NetGroupAdd|Creates a new group.
     {"NetLocalGroupAddMembers", PyNetLocalGroupAddMembers,
@@ -1086,10 +1376,15 @@ static struct PyMethodDef win32net_functions[] = {
      1},                                            // @pymeth NetLocalGroupDelMembers|Deletes users from a local group.
     {"NetLocalGroupDel", PyNetLocalGroupDel, 1},    // @pymeth NetGroupDel|Deletes a group.
     {"NetLocalGroupEnum", PyNetLocalGroupEnum, 1},  // @pymeth NetGroupEnum|Enumerates the groups.
+    {"NetLocalGroupEnumIterator", (PyCFunction)PyNetLocalGroupEnumIterator,
+     METH_VARARGS | METH_KEYWORDS},  // @pymeth NetLocalGroupEnumIterator|Returns an iterator over the local groups.
     {"NetLocalGroupGetInfo", PyNetLocalGroupGetInfo,
      1},  // @pymeth NetGroupGetInfo|Retrieves information about a particular group on a server.
     {"NetLocalGroupGetMembers", PyNetLocalGroupGetMembers,
      1},  // @pymeth NetLocalGroupGetMembers|Enumerates the members in a local group.
+    {"NetLocalGroupGetMembersIterator", (PyCFunction)PyNetLocalGroupGetMembersIterator,
+     METH_VARARGS | METH_KEYWORDS},  // @pymeth NetLocalGroupGetMembersIterator|Returns an iterator over the members
+                                     // in a local group.
     {"NetLocalGroupSetInfo", PyNetLocalGroupSetInfo,
      1},  // @pymeth NetGroupSetInfo|Sets information about a particular group account on a server.
     {"NetLocalGroupSetMembers", PyNetLocalGroupSetMembers,
@@ -1115,6 +1410,8 @@ static struct PyMethodDef win32net_functions[] = {
     {"NetShareEnum", PyNetShareEnum, 1,
      "Obsolete Function,Level 1 call"},  // @pymeth NetShareEnum|Retrieves information about each shared resource on a
                                          // server.
+    {"NetShareEnumIterator", (PyCFunction)PyNetShareEnumIterator,
+     METH_VARARGS | METH_KEYWORDS},  // @pymeth NetShareEnumIterator|Returns an iterator over the shared resources.
     {"NetShareGetInfo", PyNetShareGetInfo,
      1},  // @pymeth NetShareGetInfo|Retrieves information about a particular share on a server.
     {"NetShareSetInfo", PyNetShareSetInfo,
@@ -1124,6 +1421,8 @@ static struct PyMethodDef win32net_functions[] = {
     {"NetUserChangePassword", PyNetUserChangePassword,
      1},  // @pymeth NetUserChangePassword|Changes a users password on the specified domain.
     {"NetUserEnum", PyNetUserEnum, 1},  // @pymeth NetUserEnum|Enumerates all users.
+    {"NetUserEnumIterator", (PyCFunction)PyNetUserEnumIterator,
+     METH_VARARGS | METH_KEYWORDS},  // @pymeth NetUserEnumIterator|Returns an iterator over all users.
     {"NetUserGetGroups", PyNetUserGetGroups, 1,
      "Updated - New Behavior"},  // @pymeth NetUserGetGroups|Returns a list of groups,attributes for all groups for the
                                  // user.
@@ -1169,6 +1468,9 @@ static struct PyMethodDef win32net_functions[] = {
     {"NetGetDCName", PyNetGetDCName,
      1},  // @pymeth NetGetDCName|Returns the name of the primary domain controller (PDC).
 
+    {"NetBatchEnum", (PyCFunction)PyNetBatchEnum,
+     METH_VARARGS | METH_KEYWORDS},  // @pymeth NetBatchEnum|Calls an enumeration function against many servers
+                                     // concurrently
     {"NetSessionEnum", PyNetSessionEnum, 1},  // @pymeth NetSessionEnum|Returns network session for the server, limited
                                               // to single client and/or user if specified.
     {"NetSessionDel", PyNetSessionDel, 1},  // @pymeth NetSessionDel|Delete network session for specified server, client
@@ -1204,6 +1506,9 @@ PYWIN_MODULE_INIT_FUNC(win32net)
 {
     PYWIN_MODULE_INIT_PREPARE(win32net, win32net_functions, "A module encapsulating the Windows Network API.");
 
+    if (PyType_Ready(&PyNETENUMType) == -1 || PyType_Ready(&PyNETBATCHType) == -1)
+        PYWIN_MODULE_INIT_RETURN_ERROR;
+
     PyDict_SetItemString(dict, "error", PyWinExc_ApiError);
     PyDict_SetItemString(dict, "SERVICE_SERVER", PyUnicode_FromWideChar(SERVICE_SERVER, wcslen(SERVICE_SERVER)));
     PyDict_SetItemString(dict, "SERVICE_WORKSTATION",
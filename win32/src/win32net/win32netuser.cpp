@@ -462,6 +462,22 @@ done:
     return ret;
 }
 
+// @pymethod <o PyNETENUM>|win32net|NetUserEnumIterator|Returns an iterator over the user accounts on a server
+// @rdesc Each item is a dictionary of format <o PyUSER_INFO_*>, depending on the level parameter.
+// @comm Unlike <om win32net.NetUserEnum>, the resume handle is managed internally - every page is fetched as
+// the iterator is consumed, without the GIL.  If columns is True, each item is instead a dictionary of lists, one
+// list per attribute, holding a whole page of entries.
+PyObject *PyNetUserEnumIterator(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    // @pyparm string/<o PyUnicode>|server||The name of the server, or None.
+    // @pyparm int|level||The level of data required.
+    // @pyparm int|filter|win32netcon.FILTER_NORMAL_ACCOUNT|The types of accounts to enumerate.
+    // @pyparm bool|columns|False|If True, each page is returned as a dictionary of lists
+    // @pyparm int|prefLen|MAX_PREFERRED_LENGTH|The preferred length of the data buffer.
+    // @pyseeapi NetUserEnum
+    return PyDoEnumIterator(args, kwargs, NULL, NULL, &NetUserEnum, "NetUserEnum", user_infos);
+}
+
 // @pymethod |win32net|NetUserChangePassword|Changes the password for a user.
 PyObject *PyNetUserChangePassword(PyObject *self, PyObject *args)
 {
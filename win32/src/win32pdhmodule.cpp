@@ -104,6 +104,8 @@ typedef PDH_STATUS(WINAPI *FuncPdhGetFormattedCounterArray)(
 
 typedef PDH_STATUS(WINAPI *FuncPdhCollectQueryData)(HQUERY hQuery);
 
+typedef PDH_STATUS(WINAPI *FuncPdhCollectQueryDataEx)(HQUERY hQuery, DWORD dwIntervalTime, HANDLE hNewDataEvent);
+
 typedef PDH_STATUS(WINAPI *FuncPdhValidatePath)(LPCTSTR szFullCounterPath);
 
 typedef PDH_STATUS(WINAPI *FuncPdhExpandCounterPath)(LPCTSTR szWildCardPath,      // counter path to expand
@@ -134,6 +136,24 @@ typedef PDH_STATUS(WINAPI *FuncPdhLookupPerfIndexByName)(LPCTSTR szMachineName,
 typedef PDH_STATUS(WINAPI *FuncPdhLookupPerfNameByIndex)(LPCTSTR szMachineName, DWORD index, LPCTSTR szCounterName,
                                                          LPDWORD pcchBuffer);
 
+typedef PDH_STATUS(WINAPI *FuncPdhOpenLog)(LPCTSTR szLogFileName, DWORD dwAccessFlags, LPDWORD lpdwLogType, HQUERY hQuery,
+                                           DWORD dwMaxSize, LPCTSTR szUserCaption, HLOG *phLog);
+
+typedef PDH_STATUS(WINAPI *FuncPdhUpdateLog)(HLOG hLog, LPCTSTR szUserString);
+
+typedef PDH_STATUS(WINAPI *FuncPdhCloseLog)(HLOG hLog, DWORD dwFlags);
+
+typedef PDH_STATUS(WINAPI *FuncPdhBindInputDataSource)(HLOG *phDataSource, LPCTSTR LogFileNameList);
+
+typedef PDH_STATUS(WINAPI *FuncPdhOpenQueryH)(HLOG hDataSource, DWORD_PTR dwUserData, HQUERY *phQuery);
+
+typedef PDH_STATUS(WINAPI *FuncPdhGetDataSourceTimeRangeH)(HLOG hDataSource, LPDWORD pdwNumEntries, PPDH_TIME_INFO pInfo,
+                                                           LPDWORD pdwBufferSize);
+
+typedef PDH_STATUS(WINAPI *FuncPdhSetQueryTimeRange)(HQUERY hQuery, PPDH_TIME_INFO pInfo);
+
+typedef PDH_STATUS(WINAPI *FuncPdhCollectQueryDataWithTime)(HQUERY hQuery, LONGLONG *pllTimeStamp);
+
 #define CHECK_PDH_PTR(ptr)                                                                                  \
     if ((ptr) == NULL) {                                                                                    \
         PyErr_Format(PyExc_RuntimeError, "The pdh.dll entry point function %s could not be loaded.", #ptr); \
@@ -153,6 +173,7 @@ FuncPdhGetCounterInfo pPdhGetCounterInfo = NULL;
 FuncPdhGetFormattedCounterValue pPdhGetFormattedCounterValue = NULL;
 FuncPdhGetFormattedCounterArray pPdhGetFormattedCounterArray = NULL;
 FuncPdhCollectQueryData pPdhCollectQueryData = NULL;
+FuncPdhCollectQueryDataEx pPdhCollectQueryDataEx = NULL;
 FuncPdhValidatePath pPdhValidatePath = NULL;
 FuncPdhExpandCounterPath pPdhExpandCounterPath = NULL;
 FuncPdhParseCounterPath pPdhParseCounterPath = NULL;
@@ -164,6 +185,15 @@ FuncPdhConnectMachine pPdhConnectMachine = NULL;
 FuncPdhLookupPerfIndexByName pPdhLookupPerfIndexByName = NULL;
 FuncPdhLookupPerfNameByIndex pPdhLookupPerfNameByIndex = NULL;
 
+FuncPdhOpenLog pPdhOpenLog = NULL;
+FuncPdhUpdateLog pPdhUpdateLog = NULL;
+FuncPdhCloseLog pPdhCloseLog = NULL;
+FuncPdhBindInputDataSource pPdhBindInputDataSource = NULL;
+FuncPdhOpenQueryH pPdhOpenQueryH = NULL;
+FuncPdhGetDataSourceTimeRangeH pPdhGetDataSourceTimeRangeH = NULL;
+FuncPdhSetQueryTimeRange pPdhSetQueryTimeRange = NULL;
+FuncPdhCollectQueryDataWithTime pPdhCollectQueryDataWithTime = NULL;
+
 // TCHAR that frees itself
 class TmpTCHAR {
    public:
@@ -213,6 +243,7 @@ BOOL LoadPointers()
     pPdhGetFormattedCounterArray =
         (FuncPdhGetFormattedCounterArray)GetProcAddress(handle, "PdhGetFormattedCounterArray" A_OR_W);
     pPdhCollectQueryData = (FuncPdhCollectQueryData)GetProcAddress(handle, "PdhCollectQueryData");
+    pPdhCollectQueryDataEx = (FuncPdhCollectQueryDataEx)GetProcAddress(handle, "PdhCollectQueryDataEx");
     pPdhValidatePath = (FuncPdhValidatePath)GetProcAddress(handle, "PdhValidatePath" A_OR_W);
     pPdhExpandCounterPath = (FuncPdhExpandCounterPath)GetProcAddress(handle, "PdhExpandCounterPath" A_OR_W);
     pPdhParseCounterPath = (FuncPdhParseCounterPath)GetProcAddress(handle, "PdhParseCounterPath" A_OR_W);
@@ -222,6 +253,16 @@ BOOL LoadPointers()
     pPdhConnectMachine = (FuncPdhConnectMachine)GetProcAddress(handle, "PdhConnectMachine" A_OR_W);
     pPdhLookupPerfNameByIndex = (FuncPdhLookupPerfNameByIndex)GetProcAddress(handle, "PdhLookupPerfNameByIndex" A_OR_W);
     pPdhLookupPerfIndexByName = (FuncPdhLookupPerfIndexByName)GetProcAddress(handle, "PdhLookupPerfIndexByName" A_OR_W);
+    pPdhOpenLog = (FuncPdhOpenLog)GetProcAddress(handle, "PdhOpenLog" A_OR_W);
+    pPdhUpdateLog = (FuncPdhUpdateLog)GetProcAddress(handle, "PdhUpdateLog" A_OR_W);
+    pPdhCloseLog = (FuncPdhCloseLog)GetProcAddress(handle, "PdhCloseLog");
+    pPdhBindInputDataSource = (FuncPdhBindInputDataSource)GetProcAddress(handle, "PdhBindInputDataSource" A_OR_W);
+    pPdhOpenQueryH = (FuncPdhOpenQueryH)GetProcAddress(handle, "PdhOpenQueryH");
+    pPdhGetDataSourceTimeRangeH =
+        (FuncPdhGetDataSourceTimeRangeH)GetProcAddress(handle, "PdhGetDataSourceTimeRangeH");
+    pPdhSetQueryTimeRange = (FuncPdhSetQueryTimeRange)GetProcAddress(handle, "PdhSetQueryTimeRange");
+    pPdhCollectQueryDataWithTime =
+        (FuncPdhCollectQueryDataWithTime)GetProcAddress(handle, "PdhCollectQueryDataWithTime");
 
     // Pdh error codes are in 2 different ranges
     PyWin_RegisterErrorMessageModule(PDH_CSTATUS_NO_MACHINE, PDH_CANNOT_SET_DEFAULT_REALTIME_DATASOURCE, handle);
@@ -746,6 +787,9 @@ static PyObject *PyPdhGetFormattedCounterArray(PyObject *self, PyObject *args)
     return rc;
 }
 
+// @comm For wildcard counters sampled repeatedly, <om win32pdh.CreateCounterArray> avoids
+// the allocations of this function.
+
 // @pymethod |win32pdh|CollectQueryData|Collects the current raw data value for all counters in the specified query and
 // updates the status code of each counter.
 static PyObject *PyCollectQueryData(PyObject *self, PyObject *args)
@@ -1217,6 +1261,1151 @@ static PyObject *PyLookupPerfNameByIndex(PyObject *self, PyObject *args)
     return ret;
 }
 
+// @object PyPDHCounterArray|Samples every instance of a wildcard counter into buffers
+// kept between samples.
+// @comm Each instance is given a stable index the first time it is seen, and keeps it
+// until it disappears.  <om PyPDHCounterArray.Update> reports only the instances added
+// and removed since the previous sample, and the values can be read as a buffer aligned
+// to those indexes, so a counter with thousands of instances costs no Python objects per
+// sample.  When the same name is reported more than once (for example, several
+// processes with the same image name), the later ones are named name#1, name#2 and so on,
+// as in counter paths.  Created by <om win32pdh.CreateCounterArray>.
+typedef struct {
+    PyObject_HEAD HCOUNTER hCounter;
+    DWORD format;
+    BYTE *buf;  // PDH_FMT_COUNTERVALUE_ITEM array, reused between samples
+    DWORD bufSize;
+    PyObject *index;  // instance name -> slot
+    // Per slot, indexed by the stable instance index
+    DWORD numSlots, maxSlots;
+    __int64 *values;  // doubles for PDH_FMT_DOUBLE, 64 bit ints otherwise
+    DWORD *statuses;
+    DWORD *generations;  // the sample in which the slot was last seen
+    PyObject **names;    // NULL for free slots
+    DWORD *freeSlots;
+    DWORD numFree;
+    DWORD numInstances;
+    DWORD generation;
+    // Per item of the last sample, so an unchanged instance list needs no lookups
+    DWORD numPositions, maxPositions;
+    TCHAR **posNames;    // copies of szName
+    PyObject **posBase;  // szName as an interned string
+    DWORD *posSlots;
+} PyPDHCounterArray;
+
+static void PyPDHCounterArray_dealloc(PyObject *self);
+extern PyMethodDef PyPDHCounterArray_methods[];
+extern PyMemberDef PyPDHCounterArray_members[];
+
+PyTypeObject PyPDHCounterArrayType = {
+    PYWIN_OBJECT_HEAD "PyPDHCounterArray", /* tp_name */
+    sizeof(PyPDHCounterArray),             /* tp_basicsize */
+    0,                                     /* tp_itemsize */
+    PyPDHCounterArray_dealloc,             /* tp_dealloc */
+    0,                                     /* tp_print */
+    0,                                     /* tp_getattr */
+    0,                                     /* tp_setattr */
+    0,                                     /* tp_compare */
+    0,                                     /* tp_repr */
+    0,                                     /* tp_as_number */
+    0,                                     /* tp_as_sequence */
+    0,                                     /* tp_as_mapping */
+    0,                                     /* tp_hash */
+    0,                                     /* tp_call */
+    0,                                     /* tp_str */
+    PyObject_GenericGetAttr,               /* tp_getattro */
+    0,                                     /* tp_setattro */
+    0,                                     /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                    /* tp_flags */
+    0,                                     /* tp_doc */
+    0,                                     /* tp_traverse */
+    0,                                     /* tp_clear */
+    0,                                     /* tp_richcompare */
+    0,                                     /* tp_weaklistoffset */
+    0,                                     /* tp_iter */
+    0,                                     /* tp_iternext */
+    PyPDHCounterArray_methods,             /* tp_methods */
+    PyPDHCounterArray_members,             /* tp_members */
+};
+
+// Makes room for need positions - returns FALSE with MemoryError set on failure.
+static BOOL GrowPositions(PyPDHCounterArray *a, DWORD need)
+{
+    if (need <= a->maxPositions)
+        return TRUE;
+    DWORD cap = max(need, a->maxPositions * 2);
+    void *p;
+    if ((p = realloc(a->posNames, cap * sizeof(TCHAR *))) == NULL)
+        goto nomem;
+    a->posNames = (TCHAR **)p;
+    if ((p = realloc(a->posBase, cap * sizeof(PyObject *))) == NULL)
+        goto nomem;
+    a->posBase = (PyObject **)p;
+    if ((p = realloc(a->posSlots, cap * sizeof(DWORD))) == NULL)
+        goto nomem;
+    a->posSlots = (DWORD *)p;
+    a->maxPositions = cap;
+    return TRUE;
+nomem:
+    PyErr_NoMemory();
+    return FALSE;
+}
+
+static void CounterArrayClearPositions(PyPDHCounterArray *a)
+{
+    for (DWORD i = 0; i < a->numPositions; i++) {
+        free(a->posNames[i]);
+        Py_DECREF(a->posBase[i]);
+    }
+    a->numPositions = 0;
+}
+
+static void PyPDHCounterArray_dealloc(PyObject *self)
+{
+    PyPDHCounterArray *a = (PyPDHCounterArray *)self;
+    CounterArrayClearPositions(a);
+    for (DWORD i = 0; i < a->numSlots; i++) Py_XDECREF(a->names[i]);
+    Py_XDECREF(a->index);
+    free(a->buf);
+    free(a->values);
+    free(a->statuses);
+    free(a->generations);
+    free(a->names);
+    free(a->freeSlots);
+    free(a->posNames);
+    free(a->posBase);
+    free(a->posSlots);
+    PyObject_Del(self);
+}
+
+// Returns the slot of an instance, allocating one (and appending it to added) if it is new.
+// Returns -1 with an exception set on failure.
+static long CounterArraySlot(PyPDHCounterArray *a, PyObject *name, PyObject *added)
+{
+    PyObject *obSlot = PyDict_GetItem(a->index, name);
+    if (obSlot)
+        return PyLong_AsLong(obSlot);
+    DWORD slot;
+    if (a->numFree)
+        slot = a->freeSlots[--a->numFree];
+    else {
+        if (a->numSlots == a->maxSlots) {
+            // All the slot arrays share maxSlots, which only moves once every one has grown.
+            DWORD cap = max(16, a->maxSlots * 2);
+            void *p;
+            if ((p = realloc(a->values, cap * sizeof(__int64))) == NULL)
+                goto nomem;
+            a->values = (__int64 *)p;
+            if ((p = realloc(a->statuses, cap * sizeof(DWORD))) == NULL)
+                goto nomem;
+            a->statuses = (DWORD *)p;
+            if ((p = realloc(a->generations, cap * sizeof(DWORD))) == NULL)
+                goto nomem;
+            a->generations = (DWORD *)p;
+            if ((p = realloc(a->names, cap * sizeof(PyObject *))) == NULL)
+                goto nomem;
+            a->names = (PyObject **)p;
+            if ((p = realloc(a->freeSlots, cap * sizeof(DWORD))) == NULL)
+                goto nomem;
+            a->freeSlots = (DWORD *)p;
+            a->maxSlots = cap;
+        }
+        slot = a->numSlots++;
+    }
+    obSlot = PyLong_FromUnsignedLong(slot);
+    if (obSlot == NULL || PyDict_SetItem(a->index, name, obSlot) == -1) {
+        Py_XDECREF(obSlot);
+        a->freeSlots[a->numFree++] = slot;
+        return -1;
+    }
+    Py_DECREF(obSlot);
+    Py_INCREF(name);
+    a->names[slot] = name;
+    a->values[slot] = 0;
+    a->generations[slot] = 0;
+    a->numInstances++;
+    {
+        PyObject *item = Py_BuildValue("kO", slot, name);
+        if (item == NULL || PyList_Append(added, item) == -1) {
+            Py_XDECREF(item);
+            return -1;
+        }
+        Py_DECREF(item);
+    }
+    return slot;
+nomem:
+    PyErr_NoMemory();
+    return -1;
+}
+
+// @pymethod ([(int, str), ...], [(int, str), ...])|PyPDHCounterArray|Update|Fetches the formatted values of every
+// instance of the counter
+// @rdesc Returns (added, removed), lists of the (index, name) of the instances which appeared and disappeared
+// since the previous call.  The index of a removed instance may be given to a new one by a later call.
+// @comm Call <om win32pdh.CollectQueryData> on the counter's query before each call.
+static PyObject *PyPDHCounterArray_Update(PyObject *self, PyObject *args)
+{
+    PyPDHCounterArray *a = (PyPDHCounterArray *)self;
+    if (!PyArg_ParseTuple(args, ":Update"))
+        return NULL;
+    PDH_STATUS pdhStatus;
+    DWORD size, count;
+    for (;;) {
+        size = a->bufSize;
+        Py_BEGIN_ALLOW_THREADS pdhStatus = (*pPdhGetFormattedCounterArray)(
+            a->hCounter, a->format, &size, &count, a->bufSize ? (PDH_FMT_COUNTERVALUE_ITEM *)a->buf : NULL);
+        Py_END_ALLOW_THREADS if (pdhStatus != PDH_MORE_DATA) break;
+        // Leave room for a few more instances so growth does not cost a call every sample.
+        size += size / 4;
+        BYTE *n = (BYTE *)realloc(a->buf, size);
+        if (n == NULL)
+            return PyErr_NoMemory();
+        a->buf = n;
+        a->bufSize = size;
+    }
+    if (pdhStatus != ERROR_SUCCESS)
+        return PyWin_SetAPIError("PdhGetFormattedCounterArray", pdhStatus);
+    PDH_FMT_COUNTERVALUE_ITEM *items = (PDH_FMT_COUNTERVALUE_ITEM *)a->buf;
+
+    TmpPyObject added = PyList_New(0);
+    TmpPyObject removed = PyList_New(0);
+    if (added == NULL || removed == NULL)
+        return NULL;
+    TmpPyObject seen;  // base name -> occurrences, only built once the instance list changes
+    DWORD gen = ++a->generation;
+    if (gen == 0)  // wrapped - 0 marks a slot which was never seen
+        gen = a->generation = 1;
+    DWORD i;
+    // While the instance names match the previous sample position by position, reuse its slots.
+    DWORD unchanged = min(count, a->numPositions);
+    for (i = 0; i < unchanged; i++)
+        if (_tcscmp(items[i].szName, a->posNames[i]) != 0)
+            break;
+    unchanged = i;
+    for (i = 0; i < count; i++) {
+        long slot;
+        if (i < unchanged)
+            slot = a->posSlots[i];
+        else {
+            if (seen == NULL) {
+                seen = PyDict_New();
+                if (seen == NULL)
+                    return NULL;
+                for (DWORD j = 0; j < i; j++) {
+                    PyObject *n = PyDict_GetItem(seen, a->posBase[j]);
+                    TmpPyObject c = PyLong_FromLong(n ? PyLong_AsLong(n) + 1 : 1);
+                    if (c == NULL || PyDict_SetItem(seen, a->posBase[j], c) == -1)
+                        return NULL;
+                }
+            }
+            PyObject *base = PyWinObject_FromTCHAR(items[i].szName);
+            if (base == NULL)
+                return NULL;
+            PyUnicode_InternInPlace(&base);
+            PyObject *n = PyDict_GetItem(seen, base);
+            long occurrence = n ? PyLong_AsLong(n) : 0;
+            TmpPyObject c = PyLong_FromLong(occurrence + 1);
+            TmpPyObject name;
+            if (occurrence) {
+                name = PyUnicode_FromFormat("%U#%ld", base, occurrence);
+                if (name != NULL)
+                    PyUnicode_InternInPlace(&name.tmp);
+            }
+            else {
+                Py_INCREF(base);
+                name = base;
+            }
+            if (c == NULL || name == NULL || PyDict_SetItem(seen, base, c) == -1) {
+                Py_DECREF(base);
+                return NULL;
+            }
+            slot = CounterArraySlot(a, name, added);
+            TCHAR *copy = slot >= 0 ? _tcsdup(items[i].szName) : NULL;
+            if (copy == NULL || !GrowPositions(a, i + 1)) {
+                Py_DECREF(base);
+                free(copy);
+                if (!PyErr_Occurred())
+                    PyErr_NoMemory();
+                return NULL;
+            }
+            if (i < a->numPositions) {
+                free(a->posNames[i]);
+                Py_DECREF(a->posBase[i]);
+            }
+            else
+                a->numPositions = i + 1;
+            a->posNames[i] = copy;
+            a->posBase[i] = base;
+            a->posSlots[i] = slot;
+        }
+        a->generations[slot] = gen;
+        a->statuses[slot] = items[i].FmtValue.CStatus;
+        if (a->format & PDH_FMT_DOUBLE)
+            memcpy(&a->values[slot], &items[i].FmtValue.doubleValue, sizeof(double));
+        else if (a->format & PDH_FMT_LARGE)
+            a->values[slot] = items[i].FmtValue.largeValue;
+        else
+            a->values[slot] = items[i].FmtValue.longValue;
+    }
+    // Drop the positions beyond the end of this sample.
+    while (a->numPositions > count) {
+        a->numPositions--;
+        free(a->posNames[a->numPositions]);
+        Py_DECREF(a->posBase[a->numPositions]);
+    }
+    for (DWORD slot = 0; slot < a->numSlots; slot++) {
+        if (a->names[slot] == NULL || a->generations[slot] == gen)
+            continue;
+        PyObject *item = Py_BuildValue("kO", slot, a->names[slot]);
+        if (item == NULL || PyList_Append(removed, item) == -1) {
+            Py_XDECREF(item);
+            return NULL;
+        }
+        Py_DECREF(item);
+        if (PyDict_DelItem(a->index, a->names[slot]) == -1)
+            return NULL;
+        Py_CLEAR(a->names[slot]);
+        a->values[slot] = 0;
+        a->statuses[slot] = PDH_CSTATUS_NO_INSTANCE;
+        a->freeSlots[a->numFree++] = slot;
+        a->numInstances--;
+    }
+    return Py_BuildValue("OO", (PyObject *)added, (PyObject *)removed);
+}
+
+// @pymethod bytes|PyPDHCounterArray|GetValues|Returns the values of the last sample, in index order
+// @rdesc One 8 byte value per index - doubles for PDH_FMT_DOUBLE (array.array('d', values)),
+// otherwise 64 bit ints (array.array('q', values)).  Free indexes hold 0.
+static PyObject *PyPDHCounterArray_GetValues(PyObject *self, PyObject *args)
+{
+    PyPDHCounterArray *a = (PyPDHCounterArray *)self;
+    if (!PyArg_ParseTuple(args, ":GetValues"))
+        return NULL;
+    return PyString_FromStringAndSize((char *)a->values, a->numSlots * sizeof(__int64));
+}
+
+// @pymethod bytes|PyPDHCounterArray|GetStatuses|Returns the PDH status of each value of the last sample
+// @rdesc One 32 bit status per index, as for <om PyPDHCounterArray.GetValues>.  Free indexes hold
+// PDH_CSTATUS_NO_INSTANCE.
+static PyObject *PyPDHCounterArray_GetStatuses(PyObject *self, PyObject *args)
+{
+    PyPDHCounterArray *a = (PyPDHCounterArray *)self;
+    if (!PyArg_ParseTuple(args, ":GetStatuses"))
+        return NULL;
+    return PyString_FromStringAndSize((char *)a->statuses, a->numSlots * sizeof(DWORD));
+}
+
+// @pymethod {str:int, ...}|PyPDHCounterArray|GetIndex|Returns the index of each current instance
+static PyObject *PyPDHCounterArray_GetIndex(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":GetIndex"))
+        return NULL;
+    return PyDict_Copy(((PyPDHCounterArray *)self)->index);
+}
+
+PyMethodDef PyPDHCounterArray_methods[] = {
+    {"Update", PyPDHCounterArray_Update,
+     METH_VARARGS},  // @pymeth Update|Fetches the formatted values of every instance of the counter
+    {"GetValues", PyPDHCounterArray_GetValues,
+     METH_VARARGS},  // @pymeth GetValues|Returns the values of the last sample, in index order
+    {"GetStatuses", PyPDHCounterArray_GetStatuses,
+     METH_VARARGS},  // @pymeth GetStatuses|Returns the PDH status of each value of the last sample
+    {"GetIndex", PyPDHCounterArray_GetIndex,
+     METH_VARARGS},  // @pymeth GetIndex|Returns the index of each current instance
+    {NULL}};
+
+#undef OFF
+#define OFF(e) offsetof(PyPDHCounterArray, e)
+PyMemberDef PyPDHCounterArray_members[] = {
+    {"size", T_ULONG, OFF(numSlots), READONLY},  // @prop int|size|Number of indexes, including free ones
+    {"instances", T_ULONG, OFF(numInstances), READONLY},  // @prop int|instances|Number of current instances
+    {"format", T_ULONG, OFF(format), READONLY},           // @prop int|format|The format of the values
+    {NULL}};
+
+// @pymethod <o PyPDHCounterArray>|win32pdh|CreateCounterArray|Creates an object which fetches every instance of a
+// counter into buffers reused between samples
+static PyObject *PyCreateCounterArray(PyObject *self, PyObject *args)
+{
+    HCOUNTER handle;
+    PyObject *obhandle;
+    DWORD format = PDH_FMT_DOUBLE;
+    if (!PyArg_ParseTuple(args, "O|k:CreateCounterArray",
+                          &obhandle,  // @pyparm int|handle||Handle to a counter, usually with a wildcard instance
+                          &format))   // @pyparm int|format|PDH_FMT_DOUBLE|PDH_FMT_DOUBLE, PDH_FMT_LARGE or PDH_FMT_LONG,
+                                      // optionally or'd with PDH_FMT_NOSCALE, PDH_FMT_1000
+        return NULL;
+    if (!PyWinObject_AsHANDLE(obhandle, &handle))
+        return NULL;
+    CHECK_PDH_PTR(pPdhGetFormattedCounterArray);
+    if (!(format & (PDH_FMT_DOUBLE | PDH_FMT_LARGE | PDH_FMT_LONG)))
+        return PyErr_Format(PyExc_ValueError, "format must include PDH_FMT_DOUBLE, PDH_FMT_LARGE or PDH_FMT_LONG");
+    PyPDHCounterArray *a = PyObject_New(PyPDHCounterArray, &PyPDHCounterArrayType);
+    if (a == NULL)
+        return NULL;
+    memset((char *)a + sizeof(PyObject), 0, sizeof(PyPDHCounterArray) - sizeof(PyObject));
+    a->hCounter = handle;
+    a->format = format;
+    a->index = PyDict_New();
+    if (a->index == NULL) {
+        Py_DECREF(a);
+        return NULL;
+    }
+    return (PyObject *)a;
+    // @comm The object does not own the counter, which must stay open while it is used.
+}
+
+// @object PyPDHSampler|Samples every counter of its own query at a fixed interval,
+// on a thread of its own, into a ring of frames.
+// @comm Sampling uses PdhCollectQueryDataEx, and the values of all counters are
+// formatted as doubles by the sampling thread without needing the GIL.  Each frame
+// is read in one call as a buffer of doubles, alongside a buffer of the PDH status
+// codes of each counter.  Created by <om win32pdh.CreateSampler>.
+typedef struct {
+    PyObject_HEAD HQUERY hQuery;
+    HCOUNTER *counters;
+    DWORD numCounters;
+    DWORD format;
+    DWORD numFrames;
+    double *values;       // numFrames rows of numCounters values
+    DWORD *statuses;      // numFrames rows of numCounters CStatus codes
+    __int64 *sequences;   // sequence number of each frame slot
+    __int64 *timestamps;  // FILETIME at which each frame was sampled
+    __int64 sequence;     // sequence number of the latest complete frame, 0 if none yet
+    __int64 errors;       // samples where formatting failed for every counter
+    CRITICAL_SECTION cs;
+    HANDLE hCollectEvent;  // set by pdh after each collection
+    HANDLE hStopEvent;
+    HANDLE hFrameEvent;  // set by the sampling thread after each frame
+    HANDLE hThread;
+    HLOG hLog;             // written by the sampling thread before each frame, or NULL
+    __int64 logErrors;     // samples which could not be written to the log
+} PyPDHSampler;
+
+static void PyPDHSampler_dealloc(PyObject *self);
+extern PyMethodDef PyPDHSampler_methods[];
+extern PyMemberDef PyPDHSampler_members[];
+
+PyTypeObject PyPDHSamplerType = {
+    PYWIN_OBJECT_HEAD "PyPDHSampler", /* tp_name */
+    sizeof(PyPDHSampler),             /* tp_basicsize */
+    0,                                /* tp_itemsize */
+    PyPDHSampler_dealloc,             /* tp_dealloc */
+    0,                                /* tp_print */
+    0,                                /* tp_getattr */
+    0,                                /* tp_setattr */
+    0,                                /* tp_compare */
+    0,                                /* tp_repr */
+    0,                                /* tp_as_number */
+    0,                                /* tp_as_sequence */
+    0,                                /* tp_as_mapping */
+    0,                                /* tp_hash */
+    0,                                /* tp_call */
+    0,                                /* tp_str */
+    PyObject_GenericGetAttr,          /* tp_getattro */
+    0,                                /* tp_setattro */
+    0,                                /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,               /* tp_flags */
+    0,                                /* tp_doc */
+    0,                                /* tp_traverse */
+    0,                                /* tp_clear */
+    0,                                /* tp_richcompare */
+    0,                                /* tp_weaklistoffset */
+    0,                                /* tp_iter */
+    0,                                /* tp_iternext */
+    PyPDHSampler_methods,             /* tp_methods */
+    PyPDHSampler_members,             /* tp_members */
+};
+
+static DWORD WINAPI SamplerThread(LPVOID param)
+{
+    PyPDHSampler *s = (PyPDHSampler *)param;
+    HANDLE handles[2] = {s->hStopEvent, s->hCollectEvent};
+    while (WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1) {
+        // With a log, hCollectEvent is a periodic timer and UpdateLog does the collection.
+        if (s->hLog && (*pPdhUpdateLog)(s->hLog, NULL) != ERROR_SUCCESS)
+            s->logErrors++;
+        FILETIME now;
+        GetSystemTimeAsFileTime(&now);
+        // Only the slot being written needs the lock - format straight into it.
+        EnterCriticalSection(&s->cs);
+        __int64 seq = s->sequence + 1;
+        DWORD slot = (DWORD)(seq % s->numFrames);
+        double *values = s->values + (size_t)slot * s->numCounters;
+        DWORD *statuses = s->statuses + (size_t)slot * s->numCounters;
+        DWORD failed = 0;
+        for (DWORD i = 0; i < s->numCounters; i++) {
+            PDH_FMT_COUNTERVALUE v;
+            PDH_STATUS status = (*pPdhGetFormattedCounterValue)(s->counters[i], s->format, NULL, &v);
+            if (status == ERROR_SUCCESS)
+                status = v.CStatus;
+            if (status == ERROR_SUCCESS || status == PDH_CSTATUS_NEW_DATA)
+                values[i] = v.doubleValue;
+            else {
+                values[i] = 0.0;
+                failed++;
+            }
+            statuses[i] = status;
+        }
+        if (s->numCounters && failed == s->numCounters)
+            s->errors++;
+        s->sequences[slot] = seq;
+        s->timestamps[slot] = ((__int64)now.dwHighDateTime << 32) | now.dwLowDateTime;
+        s->sequence = seq;
+        LeaveCriticalSection(&s->cs);
+        SetEvent(s->hFrameEvent);
+    }
+    return 0;
+}
+
+static void SamplerClose(PyPDHSampler *s)
+{
+    if (s->hThread) {
+        SetEvent(s->hStopEvent);
+        Py_BEGIN_ALLOW_THREADS WaitForSingleObject(s->hThread, INFINITE);
+        Py_END_ALLOW_THREADS CloseHandle(s->hThread);
+        s->hThread = NULL;
+    }
+    if (s->hLog) {
+        (*pPdhCloseLog)(s->hLog, 0);
+        s->hLog = NULL;
+    }
+    if (s->hQuery) {
+        // Also stops the collection thread started by PdhCollectQueryDataEx
+        (*pPdhCloseQuery)(s->hQuery);
+        s->hQuery = NULL;
+    }
+}
+
+static void PyPDHSampler_dealloc(PyObject *self)
+{
+    PyPDHSampler *s = (PyPDHSampler *)self;
+    SamplerClose(s);
+    if (s->hCollectEvent)
+        CloseHandle(s->hCollectEvent);
+    if (s->hStopEvent)
+        CloseHandle(s->hStopEvent);
+    if (s->hFrameEvent)
+        CloseHandle(s->hFrameEvent);
+    DeleteCriticalSection(&s->cs);
+    free(s->counters);
+    free(s->values);
+    free(s->statuses);
+    free(s->sequences);
+    free(s->timestamps);
+    PyObject_Del(self);
+}
+
+// Builds the (sequence, timestamp, values, statuses) tuple for a slot - call with the lock held.
+static PyObject *SamplerFrame(PyPDHSampler *s, DWORD slot)
+{
+    return Py_BuildValue("LLNN", s->sequences[slot], s->timestamps[slot],
+                         PyString_FromStringAndSize((char *)(s->values + (size_t)slot * s->numCounters),
+                                                    s->numCounters * sizeof(double)),
+                         PyString_FromStringAndSize((char *)(s->statuses + (size_t)slot * s->numCounters),
+                                                    s->numCounters * sizeof(DWORD)));
+}
+
+// @pymethod (int, int, bytes, bytes)|PyPDHSampler|GetFrame|Returns one frame of samples
+// @rdesc Returns (sequence, timestamp, values, statuses), or None if the requested
+// frame has not been sampled yet or has already been overwritten.  timestamp is a FILETIME
+// as an int, values is a buffer of one double per counter (for example, for array.array('d', values)),
+// and statuses holds the PDH status of each counter as 32 bit ints.  The value of a counter whose
+// status is not ERROR_SUCCESS or PDH_CSTATUS_NEW_DATA is 0.
+static PyObject *PyPDHSampler_GetFrame(PyObject *self, PyObject *args)
+{
+    PyPDHSampler *s = (PyPDHSampler *)self;
+    __int64 seq = 0;
+    // @pyparm int|sequence|0|Sequence number of the frame, or 0 for the latest.
+    if (!PyArg_ParseTuple(args, "|L:GetFrame", &seq))
+        return NULL;
+    PyObject *ret = NULL;
+    EnterCriticalSection(&s->cs);
+    if (seq == 0)
+        seq = s->sequence;
+    if (seq > 0 && seq <= s->sequence && s->sequences[seq % s->numFrames] == seq)
+        ret = SamplerFrame(s, (DWORD)(seq % s->numFrames));
+    LeaveCriticalSection(&s->cs);
+    if (ret == NULL && !PyErr_Occurred()) {
+        Py_INCREF(Py_None);
+        ret = Py_None;
+    }
+    return ret;
+}
+
+// @pymethod [(int, int, bytes, bytes), ...]|PyPDHSampler|GetFrames|Returns every frame still held after a given one
+// @rdesc A list of frames as returned by <om PyPDHSampler.GetFrame>, oldest first.
+static PyObject *PyPDHSampler_GetFrames(PyObject *self, PyObject *args)
+{
+    PyPDHSampler *s = (PyPDHSampler *)self;
+    __int64 since = 0;
+    // @pyparm int|sequence|0|Return frames with a sequence number after this one.
+    if (!PyArg_ParseTuple(args, "|L:GetFrames", &since))
+        return NULL;
+    PyObject *ret = PyList_New(0);
+    if (ret == NULL)
+        return NULL;
+    EnterCriticalSection(&s->cs);
+    __int64 first = max(since + 1, s->sequence - s->numFrames + 1);
+    for (__int64 seq = max(first, 1); seq <= s->sequence; seq++) {
+        PyObject *frame = SamplerFrame(s, (DWORD)(seq % s->numFrames));
+        if (frame == NULL || PyList_Append(ret, frame) == -1) {
+            Py_XDECREF(frame);
+            Py_DECREF(ret);
+            ret = NULL;
+            break;
+        }
+        Py_DECREF(frame);
+    }
+    LeaveCriticalSection(&s->cs);
+    return ret;
+}
+
+// @pymethod bool|PyPDHSampler|Wait|Waits for the next frame to be sampled
+// @rdesc True if a frame was sampled, False on timeout.
+static PyObject *PyPDHSampler_Wait(PyObject *self, PyObject *args)
+{
+    PyPDHSampler *s = (PyPDHSampler *)self;
+    DWORD timeout = INFINITE;
+    // @pyparm int|timeout|INFINITE|Milliseconds to wait
+    if (!PyArg_ParseTuple(args, "|k:Wait", &timeout))
+        return NULL;
+    if (s->hThread == NULL)
+        return PyErr_Format(PyExc_ValueError, "The sampler is closed");
+    DWORD rc;
+    Py_BEGIN_ALLOW_THREADS rc = WaitForSingleObject(s->hFrameEvent, timeout);
+    Py_END_ALLOW_THREADS if (rc == WAIT_FAILED) return PyWin_SetAPIError("WaitForSingleObject");
+    return PyBool_FromLong(rc == WAIT_OBJECT_0);
+}
+
+// @pymethod |PyPDHSampler|Close|Stops sampling and closes the query
+static PyObject *PyPDHSampler_Close(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":Close"))
+        return NULL;
+    SamplerClose((PyPDHSampler *)self);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+PyMethodDef PyPDHSampler_methods[] = {
+    {"GetFrame", PyPDHSampler_GetFrame, METH_VARARGS},  // @pymeth GetFrame|Returns one frame of samples
+    {"GetFrames", PyPDHSampler_GetFrames,
+     METH_VARARGS},                              // @pymeth GetFrames|Returns every frame still held after a given one
+    {"Wait", PyPDHSampler_Wait, METH_VARARGS},   // @pymeth Wait|Waits for the next frame to be sampled
+    {"Close", PyPDHSampler_Close, METH_VARARGS},  // @pymeth Close|Stops sampling and closes the query
+    {NULL}};
+
+#undef OFF
+#define OFF(e) offsetof(PyPDHSampler, e)
+PyMemberDef PyPDHSampler_members[] = {
+    {"counters", T_ULONG, OFF(numCounters), READONLY},  // @prop int|counters|Number of counters sampled
+    {"frames", T_ULONG, OFF(numFrames), READONLY},      // @prop int|frames|Number of frames the ring holds
+    {"sequence", T_LONGLONG, OFF(sequence), READONLY},  // @prop int|sequence|Sequence number of the latest frame
+    {"errors", T_LONGLONG, OFF(errors),
+     READONLY},  // @prop int|errors|Number of samples in which no counter could be formatted
+    {"log_errors", T_LONGLONG, OFF(logErrors),
+     READONLY},  // @prop int|log_errors|Number of samples which could not be written to the log
+    {NULL}};
+
+// @pymethod <o PyPDHSampler>|win32pdh|CreateSampler|Creates a query of the given counters, sampled in the background
+static PyObject *PyCreateSampler(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Paths", "Interval", "Frames", "Format", "English", "LogFile", "LogType", "LogMaxSize", NULL};
+    PyObject *obPaths, *obLogFile = Py_None;
+    DWORD interval = 1, frames = 60, format = 0, logType = PDH_LOG_TYPE_BINARY, logMaxSize = 0;
+    BOOL english = FALSE;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "O|kkkiOkk:CreateSampler", keywords,
+            &obPaths,    // @pyparm [str, ...]|Paths||Full paths of the counters to sample
+            &interval,   // @pyparm int|Interval|1|Seconds between samples
+            &frames,     // @pyparm int|Frames|60|Number of frames kept in the ring
+            &format,     // @pyparm int|Format|0|PDH_FMT_NOSCALE and/or PDH_FMT_1000. Values are always doubles.
+            &english,    // @pyparm bool|English|False|If True, paths use English names, as for <om win32pdh.AddEnglishCounter>
+            &obLogFile,  // @pyparm str|LogFile|None|If given, each sample is also appended to this log, which is created
+                         // or replaced.
+            &logType,    // @pyparm int|LogType|PDH_LOG_TYPE_BINARY|Type of the log, one of the PDH_LOG_TYPE_* values
+            &logMaxSize))  // @pyparm int|LogMaxSize|0|If not 0, the log is circular and wraps around at this many bytes
+        return NULL;
+    TmpTCHAR logFile;
+    if (!PyWinObject_AsTCHAR(obLogFile, &logFile, TRUE))
+        return NULL;
+    if (logFile != NULL) {
+        CHECK_PDH_PTR(pPdhOpenLog);
+        CHECK_PDH_PTR(pPdhUpdateLog);
+        CHECK_PDH_PTR(pPdhCloseLog);
+    }
+    CHECK_PDH_PTR(pPdhOpenQuery);
+    CHECK_PDH_PTR(pPdhCollectQueryDataEx);
+    CHECK_PDH_PTR(pPdhGetFormattedCounterValue);
+    FuncPdhAddCounter pfnAdd = english ? pPdhAddEnglishCounter : pPdhAddCounter;
+    CHECK_PDH_PTR(pfnAdd);
+    if (interval == 0 || frames == 0)
+        return PyErr_Format(PyExc_ValueError, "Interval and Frames must be greater than 0");
+
+    TmpPyObject paths = PySequence_Fast(obPaths, "Paths must be a sequence of counter paths");
+    if (paths == NULL)
+        return NULL;
+    DWORD numCounters = (DWORD)PySequence_Fast_GET_SIZE((PyObject *)paths);
+
+    PyPDHSampler *s = PyObject_New(PyPDHSampler, &PyPDHSamplerType);
+    if (s == NULL)
+        return NULL;
+    memset((char *)s + sizeof(PyObject), 0, sizeof(PyPDHSampler) - sizeof(PyObject));
+    InitializeCriticalSection(&s->cs);
+    s->numCounters = numCounters;
+    s->numFrames = frames;
+    s->format = PDH_FMT_DOUBLE | (format & (PDH_FMT_NOSCALE | PDH_FMT_1000 | PDH_FMT_NOCAP100));
+    s->counters = (HCOUNTER *)malloc(max(numCounters, 1) * sizeof(HCOUNTER));
+    s->values = (double *)calloc((size_t)frames * max(numCounters, 1), sizeof(double));
+    s->statuses = (DWORD *)calloc((size_t)frames * max(numCounters, 1), sizeof(DWORD));
+    s->sequences = (__int64 *)calloc(frames, sizeof(__int64));
+    s->timestamps = (__int64 *)calloc(frames, sizeof(__int64));
+    if (!s->counters || !s->values || !s->statuses || !s->sequences || !s->timestamps) {
+        Py_DECREF(s);
+        return PyErr_NoMemory();
+    }
+
+    PDH_STATUS pdhStatus;
+    Py_BEGIN_ALLOW_THREADS pdhStatus = (*pPdhOpenQuery)(NULL, 0, &s->hQuery);
+    Py_END_ALLOW_THREADS if (pdhStatus != ERROR_SUCCESS)
+    {
+        s->hQuery = NULL;
+        Py_DECREF(s);
+        return PyWin_SetAPIError("OpenQuery", pdhStatus);
+    }
+    for (DWORD i = 0; i < numCounters; i++) {
+        TCHAR *szPath;
+        if (!PyWinObject_AsTCHAR(PySequence_Fast_GET_ITEM((PyObject *)paths, i), &szPath, FALSE)) {
+            Py_DECREF(s);
+            return NULL;
+        }
+        Py_BEGIN_ALLOW_THREADS pdhStatus = (*pfnAdd)(s->hQuery, szPath, 0, &s->counters[i]);
+        Py_END_ALLOW_THREADS PyWinObject_FreeTCHAR(szPath);
+        if (pdhStatus != ERROR_SUCCESS) {
+            Py_DECREF(s);
+            return PyWin_SetAPIError(english ? "AddEnglishCounter" : "AddCounter", pdhStatus);
+        }
+    }
+
+    if (logFile != NULL) {
+        DWORD access = PDH_LOG_WRITE_ACCESS | PDH_LOG_CREATE_ALWAYS | (logMaxSize ? PDH_LOG_OPT_CIRCULAR : 0);
+        Py_BEGIN_ALLOW_THREADS pdhStatus =
+            (*pPdhOpenLog)(logFile, access, &logType, s->hQuery, logMaxSize, NULL, &s->hLog);
+        Py_END_ALLOW_THREADS if (pdhStatus != ERROR_SUCCESS)
+        {
+            s->hLog = NULL;
+            Py_DECREF(s);
+            return PyWin_SetAPIError("OpenLog", pdhStatus);
+        }
+        // UpdateLog collects the data itself, so it is driven by a timer instead of CollectQueryDataEx.
+        s->hCollectEvent = CreateWaitableTimer(NULL, FALSE, NULL);
+    }
+    else
+        s->hCollectEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    s->hStopEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    s->hFrameEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (!s->hCollectEvent || !s->hStopEvent || !s->hFrameEvent) {
+        Py_DECREF(s);
+        return PyWin_SetAPIError("CreateEvent");
+    }
+    // Rate counters need a first collection before they can be formatted.
+    Py_BEGIN_ALLOW_THREADS(*pPdhCollectQueryData)(s->hQuery);
+    if (s->hLog) {
+        LARGE_INTEGER due;
+        due.QuadPart = -(LONGLONG)interval * 10000000;
+        pdhStatus = SetWaitableTimer(s->hCollectEvent, &due, interval * 1000, NULL, NULL, FALSE) ? ERROR_SUCCESS
+                                                                                                  : GetLastError();
+    }
+    else
+        pdhStatus = (*pPdhCollectQueryDataEx)(s->hQuery, interval, s->hCollectEvent);
+    Py_END_ALLOW_THREADS if (pdhStatus != ERROR_SUCCESS)
+    {
+        const char *fname = s->hLog ? "SetWaitableTimer" : "CollectQueryDataEx";
+        Py_DECREF(s);
+        return PyWin_SetAPIError((char *)fname, pdhStatus);
+    }
+    s->hThread = CreateThread(NULL, 0, SamplerThread, s, 0, NULL);
+    if (s->hThread == NULL) {
+        Py_DECREF(s);
+        return PyWin_SetAPIError("CreateThread");
+    }
+    return (PyObject *)s;
+    // @comm The sampler owns its query, which is closed by <om PyPDHSampler.Close> or
+    // when the object is destroyed.  The same goes for the log, which is written with <om win32pdh.UpdateLog>
+    // by the sampling thread at each interval, and can be read back with <om win32pdh.ReadLogRange>.  The frame with sequence number n is stored in slot
+    // n % Frames, so a reader polling at least once per Frames intervals sees every frame.
+}
+
+// @pymethod int|win32pdh|OpenLog|Opens a performance log file for reading or writing
+static PyObject *PyOpenLog(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"LogFileName", "AccessFlags", "LogType", "Query", "MaxSize", "UserCaption", NULL};
+    PyObject *obFileName, *obQuery = Py_None, *obCaption = Py_None;
+    DWORD access = PDH_LOG_WRITE_ACCESS | PDH_LOG_CREATE_ALWAYS, logType = PDH_LOG_TYPE_BINARY, maxSize = 0;
+    HQUERY hQuery = NULL;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "O|kkOkO:OpenLog", keywords,
+            &obFileName,  // @pyparm str|LogFileName||Name of the log file
+            &access,      // @pyparm int|AccessFlags|PDH_LOG_WRITE_ACCESS\|PDH_LOG_CREATE_ALWAYS|One of the
+                          // PDH_LOG_*_ACCESS values combined with one of the PDH_LOG_CREATE_*/PDH_LOG_OPEN_* values,
+                          // and optionally PDH_LOG_OPT_CIRCULAR
+            &logType,     // @pyparm int|LogType|PDH_LOG_TYPE_BINARY|One of the PDH_LOG_TYPE_* values.  Ignored when
+                          // opening an existing log, whose type is detected.
+            &obQuery,     // @pyparm int|Query|None|Handle to the query whose counters are written by <om
+                          // win32pdh.UpdateLog>.  Required for write access.
+            &maxSize,     // @pyparm int|MaxSize|0|Maximum size of the log in bytes, or 0 for no limit.  A circular
+                          // log wraps around at this size.
+            &obCaption))  // @pyparm str|UserCaption|None|Caption stored in the log
+        return NULL;
+    CHECK_PDH_PTR(pPdhOpenLog);
+    if (obQuery != Py_None && !PyWinObject_AsHANDLE(obQuery, &hQuery))
+        return NULL;
+    TmpTCHAR fileName, caption;
+    if (!PyWinObject_AsTCHAR(obFileName, &fileName, FALSE) || !PyWinObject_AsTCHAR(obCaption, &caption, TRUE))
+        return NULL;
+    HLOG hLog;
+    PDH_STATUS pdhStatus;
+    Py_BEGIN_ALLOW_THREADS pdhStatus = (*pPdhOpenLog)(fileName, access, &logType, hQuery, maxSize, caption, &hLog);
+    Py_END_ALLOW_THREADS if (pdhStatus != ERROR_SUCCESS) return PyWin_SetAPIError("OpenLog", pdhStatus);
+    // @rdesc Returns the handle to the log.  Pass it to <om win32pdh.CloseLog> when done.
+    return PyWinLong_FromHANDLE(hLog);
+}
+
+// @pymethod |win32pdh|UpdateLog|Collects the current data of a log's query and writes it to the log
+static PyObject *PyUpdateLog(PyObject *self, PyObject *args)
+{
+    PyObject *obLog, *obUserString = Py_None;
+    HLOG hLog;
+    if (!PyArg_ParseTuple(args, "O|O:UpdateLog",
+                          &obLog,          // @pyparm int|hLog||Handle returned by <om win32pdh.OpenLog>
+                          &obUserString))  // @pyparm str|UserString|None|Comment stored with the record
+        return NULL;
+    CHECK_PDH_PTR(pPdhUpdateLog);
+    if (!PyWinObject_AsHANDLE(obLog, &hLog))
+        return NULL;
+    TmpTCHAR userString;
+    if (!PyWinObject_AsTCHAR(obUserString, &userString, TRUE))
+        return NULL;
+    PDH_STATUS pdhStatus;
+    Py_BEGIN_ALLOW_THREADS pdhStatus = (*pPdhUpdateLog)(hLog, userString);
+    Py_END_ALLOW_THREADS if (pdhStatus != ERROR_SUCCESS) return PyWin_SetAPIError("UpdateLog", pdhStatus);
+    Py_INCREF(Py_None);
+    return Py_None;
+    // @comm This collects the query data itself, so don't also call <om win32pdh.CollectQueryData> for the
+    // same query or rate counters will be computed across the wrong interval.
+}
+
+// @pymethod |win32pdh|CloseLog|Closes a log, or a data source returned by <om win32pdh.BindInputDataSource>
+static PyObject *PyCloseLog(PyObject *self, PyObject *args)
+{
+    PyObject *obLog;
+    HLOG hLog;
+    DWORD flags = 0;
+    if (!PyArg_ParseTuple(args, "O|k:CloseLog",
+                          &obLog,   // @pyparm int|hLog||Handle to the log
+                          &flags))  // @pyparm int|Flags|0|PDH_FLAGS_CLOSE_QUERY to also close the log's query
+        return NULL;
+    CHECK_PDH_PTR(pPdhCloseLog);
+    if (!PyWinObject_AsHANDLE(obLog, &hLog))
+        return NULL;
+    PDH_STATUS pdhStatus;
+    Py_BEGIN_ALLOW_THREADS pdhStatus = (*pPdhCloseLog)(hLog, flags);
+    Py_END_ALLOW_THREADS if (pdhStatus != ERROR_SUCCESS) return PyWin_SetAPIError("CloseLog", pdhStatus);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// Converts one log file name, or a sequence of them, to a multi-string
+static BOOL PyWinObject_AsLogFileList(PyObject *ob, WCHAR **pFiles)
+{
+    if (PyString_Check(ob) || PyUnicode_Check(ob)) {
+        TmpPyObject tuple = PyTuple_Pack(1, ob);
+        if (tuple == NULL)
+            return FALSE;
+        return PyWinObject_AsMultipleString(tuple, pFiles, FALSE);
+    }
+    return PyWinObject_AsMultipleString(ob, pFiles, TRUE);
+}
+
+// @pymethod int|win32pdh|BindInputDataSource|Binds one or more performance logs into a data source for queries
+static PyObject *PyBindInputDataSource(PyObject *self, PyObject *args)
+{
+    PyObject *obFiles;
+    // @pyparm str or [str, ...]|LogFiles||Log files to read, or None for real-time data
+    if (!PyArg_ParseTuple(args, "O:BindInputDataSource", &obFiles))
+        return NULL;
+    CHECK_PDH_PTR(pPdhBindInputDataSource);
+    WCHAR *files;
+    if (!PyWinObject_AsLogFileList(obFiles, &files))
+        return NULL;
+    HLOG hSource;
+    PDH_STATUS pdhStatus;
+    Py_BEGIN_ALLOW_THREADS pdhStatus = (*pPdhBindInputDataSource)(&hSource, files);
+    Py_END_ALLOW_THREADS PyWinObject_FreeMultipleString(files);
+    if (pdhStatus != ERROR_SUCCESS)
+        return PyWin_SetAPIError("BindInputDataSource", pdhStatus);
+    return PyWinLong_FromHANDLE(hSource);
+    // @comm Open queries over the data source with <om win32pdh.OpenQueryH>, and close it with <om win32pdh.CloseLog>.
+}
+
+// @pymethod int|win32pdh|OpenQueryH|Opens a query over a data source returned by <om win32pdh.BindInputDataSource>
+static PyObject *PyOpenQueryH(PyObject *self, PyObject *args)
+{
+    PyObject *obSource, *obuserData = Py_None;
+    HLOG hSource;
+    DWORD_PTR userData = 0;
+    if (!PyArg_ParseTuple(args, "O|O:OpenQueryH",
+                          &obSource,     // @pyparm int|DataSource||Handle to the data source
+                          &obuserData))  // @pyparm int|userData|0|User data associated with the query.
+        return NULL;
+    CHECK_PDH_PTR(pPdhOpenQueryH);
+    if (!PyWinObject_AsHANDLE(obSource, &hSource))
+        return NULL;
+    if (obuserData != Py_None && !PyWinLong_AsDWORD_PTR(obuserData, &userData))
+        return NULL;
+    HQUERY hQuery;
+    PDH_STATUS pdhStatus;
+    Py_BEGIN_ALLOW_THREADS pdhStatus = (*pPdhOpenQueryH)(hSource, userData, &hQuery);
+    Py_END_ALLOW_THREADS if (pdhStatus != ERROR_SUCCESS) return PyWin_SetAPIError("OpenQueryH", pdhStatus);
+    return PyWinLong_FromHANDLE(hQuery);
+    // @comm Counters are added with <om win32pdh.AddCounter> as for live queries.  Each call to
+    // <om win32pdh.CollectQueryDataWithTime> moves to the next sample in the logs.
+}
+
+// @pymethod (int, int, int)|win32pdh|GetDataSourceTimeRange|Returns the time range of a data source
+// @rdesc Returns (StartTime, EndTime, SampleCount), with the times as FILETIME ints.
+static PyObject *PyGetDataSourceTimeRange(PyObject *self, PyObject *args)
+{
+    PyObject *obSource;
+    HLOG hSource;
+    // @pyparm int|DataSource||Handle returned by <om win32pdh.BindInputDataSource>
+    if (!PyArg_ParseTuple(args, "O:GetDataSourceTimeRange", &obSource))
+        return NULL;
+    CHECK_PDH_PTR(pPdhGetDataSourceTimeRangeH);
+    if (!PyWinObject_AsHANDLE(obSource, &hSource))
+        return NULL;
+    PDH_TIME_INFO info;
+    DWORD numEntries, size = sizeof(info);
+    PDH_STATUS pdhStatus;
+    Py_BEGIN_ALLOW_THREADS pdhStatus = (*pPdhGetDataSourceTimeRangeH)(hSource, &numEntries, &info, &size);
+    Py_END_ALLOW_THREADS if (pdhStatus != ERROR_SUCCESS) return PyWin_SetAPIError("GetDataSourceTimeRange", pdhStatus);
+    return Py_BuildValue("LLk", info.StartTime, info.EndTime, info.SampleCount);
+}
+
+// @pymethod |win32pdh|SetQueryTimeRange|Limits the samples a query over logs returns to a time range
+static PyObject *PySetQueryTimeRange(PyObject *self, PyObject *args)
+{
+    PyObject *obQuery;
+    HQUERY hQuery;
+    PDH_TIME_INFO info;
+    info.SampleCount = 0;
+    if (!PyArg_ParseTuple(args, "OLL:SetQueryTimeRange",
+                          &obQuery,          // @pyparm int|hQuery||Handle to a query opened by <om win32pdh.OpenQueryH>
+                          &info.StartTime,   // @pyparm int|StartTime||First time, as a FILETIME int
+                          &info.EndTime))    // @pyparm int|EndTime||Last time, as a FILETIME int
+        return NULL;
+    CHECK_PDH_PTR(pPdhSetQueryTimeRange);
+    if (!PyWinObject_AsHANDLE(obQuery, &hQuery))
+        return NULL;
+    PDH_STATUS pdhStatus;
+    Py_BEGIN_ALLOW_THREADS pdhStatus = (*pPdhSetQueryTimeRange)(hQuery, &info);
+    Py_END_ALLOW_THREADS if (pdhStatus != ERROR_SUCCESS) return PyWin_SetAPIError("SetQueryTimeRange", pdhStatus);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod int|win32pdh|CollectQueryDataWithTime|Collects data for a query and returns the time of the sample
+// @rdesc Returns the FILETIME of the sample as an int, or None at the end of the logs of a query opened
+// by <om win32pdh.OpenQueryH>.
+static PyObject *PyCollectQueryDataWithTime(PyObject *self, PyObject *args)
+{
+    PyObject *obQuery;
+    HQUERY hQuery;
+    // @pyparm int|hQuery||Handle to an open query.
+    if (!PyArg_ParseTuple(args, "O:CollectQueryDataWithTime", &obQuery))
+        return NULL;
+    CHECK_PDH_PTR(pPdhCollectQueryDataWithTime);
+    if (!PyWinObject_AsHANDLE(obQuery, &hQuery))
+        return NULL;
+    LONGLONG timeStamp = 0;
+    PDH_STATUS pdhStatus;
+    Py_BEGIN_ALLOW_THREADS pdhStatus = (*pPdhCollectQueryDataWithTime)(hQuery, &timeStamp);
+    Py_END_ALLOW_THREADS if (pdhStatus == PDH_NO_MORE_DATA)
+    {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+    if (pdhStatus != ERROR_SUCCESS)
+        return PyWin_SetAPIError("CollectQueryDataWithTime", pdhStatus);
+    return PyLong_FromLongLong(timeStamp);
+}
+
+// Reads samples of a log query into growing arrays - called without the GIL.
+struct LogRange {
+    HCOUNTER *counters;
+    DWORD numCounters;
+    DWORD format;
+    size_t numSamples, capacity;
+    __int64 *timestamps;
+    double *values;
+    DWORD *statuses;
+};
+
+static PDH_STATUS ReadLogSamples(HQUERY hQuery, LogRange *r)
+{
+    for (;;) {
+        LONGLONG timeStamp;
+        PDH_STATUS pdhStatus = (*pPdhCollectQueryDataWithTime)(hQuery, &timeStamp);
+        if (pdhStatus == PDH_NO_MORE_DATA)
+            return ERROR_SUCCESS;
+        if (pdhStatus != ERROR_SUCCESS)
+            return pdhStatus;
+        if (r->numSamples == r->capacity) {
+            size_t capacity = r->capacity ? r->capacity * 2 : 256;
+            size_t cols = max(r->numCounters, 1);
+            __int64 *timestamps = (__int64 *)realloc(r->timestamps, capacity * sizeof(__int64));
+            if (timestamps)
+                r->timestamps = timestamps;
+            double *values = (double *)realloc(r->values, capacity * cols * sizeof(double));
+            if (values)
+                r->values = values;
+            DWORD *statuses = (DWORD *)realloc(r->statuses, capacity * cols * sizeof(DWORD));
+            if (statuses)
+                r->statuses = statuses;
+            if (!timestamps || !values || !statuses)
+                return ERROR_NOT_ENOUGH_MEMORY;
+            r->capacity = capacity;
+        }
+        double *values = r->values + r->numSamples * r->numCounters;
+        DWORD *statuses = r->statuses + r->numSamples * r->numCounters;
+        for (DWORD i = 0; i < r->numCounters; i++) {
+            PDH_FMT_COUNTERVALUE v;
+            PDH_STATUS status = (*pPdhGetFormattedCounterValue)(r->counters[i], r->format, NULL, &v);
+            if (status == ERROR_SUCCESS)
+                status = v.CStatus;
+            values[i] = (status == ERROR_SUCCESS || status == PDH_CSTATUS_NEW_DATA) ? v.doubleValue : 0.0;
+            statuses[i] = status;
+        }
+        r->timestamps[r->numSamples++] = timeStamp;
+    }
+}
+
+// @pymethod (bytes, bytes, bytes)|win32pdh|ReadLogRange|Reads every sample of some counters from performance logs
+// @rdesc Returns (timestamps, values, statuses).  timestamps holds the FILETIME of each sample as a 64 bit
+// int, values holds one row of doubles per sample with one double per counter, and statuses holds the
+// PDH status of each value as 32 bit ints, as for the frames of <o PyPDHSampler>.
+static PyObject *PyReadLogRange(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"LogFiles", "Paths", "StartTime", "EndTime", "Format", "English", NULL};
+    PyObject *obFiles, *obPaths;
+    PDH_TIME_INFO range = {0, 0, 0};
+    DWORD format = 0;
+    BOOL english = FALSE;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "OO|LLki:ReadLogRange", keywords,
+            &obFiles,          // @pyparm str or [str, ...]|LogFiles||Log files to read
+            &obPaths,          // @pyparm [str, ...]|Paths||Full paths of the counters to read
+            &range.StartTime,  // @pyparm int|StartTime|0|First time to read, as a FILETIME int, or 0 for the start
+            &range.EndTime,    // @pyparm int|EndTime|0|Last time to read, as a FILETIME int, or 0 for the end
+            &format,           // @pyparm int|Format|0|PDH_FMT_NOSCALE and/or PDH_FMT_1000. Values are always doubles.
+            &english))  // @pyparm bool|English|False|If True, paths use English names, as for <om win32pdh.AddEnglishCounter>
+        return NULL;
+    CHECK_PDH_PTR(pPdhBindInputDataSource);
+    CHECK_PDH_PTR(pPdhOpenQueryH);
+    CHECK_PDH_PTR(pPdhCollectQueryDataWithTime);
+    CHECK_PDH_PTR(pPdhGetDataSourceTimeRangeH);
+    CHECK_PDH_PTR(pPdhSetQueryTimeRange);
+    CHECK_PDH_PTR(pPdhGetFormattedCounterValue);
+    CHECK_PDH_PTR(pPdhCloseLog);
+    FuncPdhAddCounter pfnAdd = english ? pPdhAddEnglishCounter : pPdhAddCounter;
+    CHECK_PDH_PTR(pfnAdd);
+
+    TmpPyObject paths = PySequence_Fast(obPaths, "Paths must be a sequence of counter paths");
+    if (paths == NULL)
+        return NULL;
+    DWORD numCounters = (DWORD)PySequence_Fast_GET_SIZE((PyObject *)paths);
+    LogRange r;
+    memset(&r, 0, sizeof(r));
+    r.numCounters = numCounters;
+    r.format = PDH_FMT_DOUBLE | (format & (PDH_FMT_NOSCALE | PDH_FMT_1000 | PDH_FMT_NOCAP100));
+    r.counters = (HCOUNTER *)malloc(max(numCounters, 1) * sizeof(HCOUNTER));
+    TCHAR **szPaths = (TCHAR **)calloc(max(numCounters, 1), sizeof(TCHAR *));
+    WCHAR *files = NULL;
+    PyObject *ret = NULL;
+    const char *fname = NULL;
+    PDH_STATUS pdhStatus = ERROR_SUCCESS;
+    HLOG hSource = NULL;
+    HQUERY hQuery = NULL;
+    if (r.counters == NULL || szPaths == NULL) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    for (DWORD i = 0; i < numCounters; i++)
+        if (!PyWinObject_AsTCHAR(PySequence_Fast_GET_ITEM((PyObject *)paths, i), &szPaths[i], FALSE))
+            goto done;
+    if (!PyWinObject_AsLogFileList(obFiles, &files))
+        goto done;
+    if (files == NULL) {
+        PyErr_SetString(PyExc_ValueError, "At least one log file must be given");
+        goto done;
+    }
+
+    Py_BEGIN_ALLOW_THREADS pdhStatus = (*pPdhBindInputDataSource)(&hSource, files);
+    if (pdhStatus != ERROR_SUCCESS) {
+        hSource = NULL;
+        fname = "BindInputDataSource";
+    }
+    else if ((pdhStatus = (*pPdhOpenQueryH)(hSource, 0, &hQuery)) != ERROR_SUCCESS) {
+        hQuery = NULL;
+        fname = "OpenQueryH";
+    }
+    for (DWORD i = 0; fname == NULL && i < numCounters; i++)
+        if ((pdhStatus = (*pfnAdd)(hQuery, szPaths[i], 0, &r.counters[i])) != ERROR_SUCCESS)
+            fname = english ? "AddEnglishCounter" : "AddCounter";
+    if (fname == NULL && (range.StartTime || range.EndTime)) {
+        // Fill in the end of the range which wasn't given
+        PDH_TIME_INFO full;
+        DWORD numEntries, size = sizeof(full);
+        if ((pdhStatus = (*pPdhGetDataSourceTimeRangeH)(hSource, &numEntries, &full, &size)) != ERROR_SUCCESS)
+            fname = "GetDataSourceTimeRange";
+        else {
+            if (range.StartTime == 0)
+                range.StartTime = full.StartTime;
+            if (range.EndTime == 0)
+                range.EndTime = full.EndTime;
+            if ((pdhStatus = (*pPdhSetQueryTimeRange)(hQuery, &range)) != ERROR_SUCCESS)
+                fname = "SetQueryTimeRange";
+        }
+    }
+    if (fname == NULL && (pdhStatus = ReadLogSamples(hQuery, &r)) != ERROR_SUCCESS)
+        fname = "CollectQueryDataWithTime";
+    if (hQuery)
+        (*pPdhCloseQuery)(hQuery);
+    if (hSource)
+        (*pPdhCloseLog)(hSource, 0);
+    Py_END_ALLOW_THREADS if (fname != NULL)
+    {
+        PyWin_SetAPIError((char *)fname, pdhStatus);
+        goto done;
+    }
+    ret = Py_BuildValue("NNN", PyString_FromStringAndSize((char *)r.timestamps, r.numSamples * sizeof(__int64)),
+                        PyString_FromStringAndSize((char *)r.values, r.numSamples * numCounters * sizeof(double)),
+                        PyString_FromStringAndSize((char *)r.statuses, r.numSamples * numCounters * sizeof(DWORD)));
+done:
+    if (szPaths) {
+        for (DWORD i = 0; i < numCounters; i++) PyWinObject_FreeTCHAR(szPaths[i]);
+        free(szPaths);
+    }
+    PyWinObject_FreeMultipleString(files);
+    free(r.counters);
+    free(r.timestamps);
+    free(r.values);
+    free(r.statuses);
+    return ret;
+    // @comm The logs are bound, queried and closed within the call, and all samples are read and
+    // formatted without the GIL.  Like a live query, the first sample of a rate counter has no value.
+}
+
 /* List of functions exported by this module */
 // @module win32pdh|A module, encapsulating the Windows Performance Data Helpers API
 static struct PyMethodDef win32pdh_functions[] = {
@@ -1258,6 +2447,27 @@ static struct PyMethodDef win32pdh_functions[] = {
      1},  // @pymeth LookupPerfIndexByName|Returns the counter index corresponding to the specified counter name.
     {"LookupPerfNameByIndex", PyLookupPerfNameByIndex,
      1},  // @pymeth LookupPerfNameByIndex|Returns the performance object name corresponding to the specified index.
+    {"CreateCounterArray", PyCreateCounterArray,
+     1},  // @pymeth CreateCounterArray|Creates an object which fetches every instance of a counter into buffers reused
+          // between samples
+    {"CreateSampler", (PyCFunction)PyCreateSampler,
+     METH_VARARGS | METH_KEYWORDS},  // @pymeth CreateSampler|Creates a query of the given counters, sampled in the
+                                     // background
+    {"OpenLog", (PyCFunction)PyOpenLog,
+     METH_VARARGS | METH_KEYWORDS},           // @pymeth OpenLog|Opens a performance log file for reading or writing
+    {"UpdateLog", PyUpdateLog, 1},  // @pymeth UpdateLog|Collects the data of a log's query and writes it to the log
+    {"CloseLog", PyCloseLog, 1},    // @pymeth CloseLog|Closes a log or data source
+    {"BindInputDataSource", PyBindInputDataSource,
+     1},  // @pymeth BindInputDataSource|Binds one or more performance logs into a data source for queries
+    {"OpenQueryH", PyOpenQueryH, 1},  // @pymeth OpenQueryH|Opens a query over a data source
+    {"GetDataSourceTimeRange", PyGetDataSourceTimeRange,
+     1},  // @pymeth GetDataSourceTimeRange|Returns the time range of a data source
+    {"SetQueryTimeRange", PySetQueryTimeRange,
+     1},  // @pymeth SetQueryTimeRange|Limits the samples a query over logs returns to a time range
+    {"CollectQueryDataWithTime", PyCollectQueryDataWithTime,
+     1},  // @pymeth CollectQueryDataWithTime|Collects data for a query and returns the time of the sample
+    {"ReadLogRange", (PyCFunction)PyReadLogRange,
+     METH_VARARGS | METH_KEYWORDS},  // @pymeth ReadLogRange|Reads every sample of some counters from performance logs
     {NULL}};
 
 #define ADD_CONSTANT(tok) PyModule_AddIntConstant(module, #tok, tok)
@@ -1272,6 +2482,8 @@ PYWIN_MODULE_INIT_FUNC(win32pdh)
     win32pdh_counter_error = PyErr_NewException("win32pdh.counter_status_error", NULL, NULL);
     PyDict_SetItemString(dict, "counter_status_error", win32pdh_counter_error);
     LoadPointers();  // Setting an error in this function will cause Python to spew.
+    if (PyType_Ready(&PyPDHSamplerType) == -1 || PyType_Ready(&PyPDHCounterArrayType) == -1)
+        PYWIN_MODULE_INIT_RETURN_ERROR;
 
     ADD_CONSTANT(PDH_VERSION);
 
@@ -1283,6 +2495,7 @@ PYWIN_MODULE_INIT_FUNC(win32pdh)
     ADD_CONSTANT(PDH_FMT_LARGE);
     ADD_CONSTANT(PDH_FMT_NOSCALE);
     ADD_CONSTANT(PDH_FMT_1000);
+    ADD_CONSTANT(PDH_FMT_NOCAP100);
     ADD_CONSTANT(PDH_FMT_NODATA);
 
     ADD_CONSTANT(PDH_MAX_SCALE);
@@ -1294,6 +2507,21 @@ PYWIN_MODULE_INIT_FUNC(win32pdh)
     ADD_CONSTANT(PERF_DETAIL_WIZARD);
     ADD_CONSTANT(PDH_PATH_WBEM_RESULT);
     ADD_CONSTANT(PDH_PATH_WBEM_INPUT);
+
+    ADD_CONSTANT(PDH_LOG_READ_ACCESS);
+    ADD_CONSTANT(PDH_LOG_WRITE_ACCESS);
+    ADD_CONSTANT(PDH_LOG_UPDATE_ACCESS);
+    ADD_CONSTANT(PDH_LOG_CREATE_NEW);
+    ADD_CONSTANT(PDH_LOG_CREATE_ALWAYS);
+    ADD_CONSTANT(PDH_LOG_OPEN_ALWAYS);
+    ADD_CONSTANT(PDH_LOG_OPEN_EXISTING);
+    ADD_CONSTANT(PDH_LOG_OPT_CIRCULAR);
+    ADD_CONSTANT(PDH_LOG_TYPE_UNDEFINED);
+    ADD_CONSTANT(PDH_LOG_TYPE_CSV);
+    ADD_CONSTANT(PDH_LOG_TYPE_TSV);
+    ADD_CONSTANT(PDH_LOG_TYPE_SQL);
+    ADD_CONSTANT(PDH_LOG_TYPE_BINARY);
+    ADD_CONSTANT(PDH_FLAGS_CLOSE_QUERY);
     //	ADD_CONSTANT();
     PYWIN_MODULE_INIT_RETURN_SUCCESS;
 }
@@ -25,6 +25,10 @@ static GetNamedPipeClientProcessIdfunc pfnGetNamedPipeServerSessionId = NULL;
 	// All errors raised by this module are of this type.
 	PyDict_SetItemString(d, "error", PyWinExc_ApiError);
 
+	if (PyType_Ready(&PyPipeServer_Type) == -1
+		||PyType_Ready(&PyProcessGroup_Type) == -1)
+		PYWIN_MODULE_INIT_RETURN_ERROR;
+
 	HMODULE hmod=GetModuleHandle(_T("Kernel32.dll"));
 	if (!hmod)
 		hmod=LoadLibrary(_T("Kernel32.dll"));
@@ -569,3 +573,1027 @@ PyObject *MyGetNamedPipeServerSessionId(PyObject *self, PyObject *args)
 %native(GetNamedPipeServerProcessId) MyGetNamedPipeServerProcessId;
 %native(GetNamedPipeClientSessionId) MyGetNamedPipeClientSessionId;
 %native(GetNamedPipeServerSessionId) MyGetNamedPipeServerSessionId;
+
+// @object PyPipeServer|A named pipe server which keeps a number of pipe instances
+// listening, as returned by <om win32pipe.CreatePipeServer>.
+// @comm All pipe instances are created up front, each with an overlapped
+// ConnectNamedPipe pending, and serviced through a private I/O completion port.
+// When a client disconnects, its instance is disconnected and made to listen
+// again, rather than being closed and recreated.
+// <nl>The server is driven by calling <om PyPipeServer.GetMessages>, which
+// processes connections and reads without the GIL, and returns each complete
+// message read.  Only one thread may call GetMessages at a time.
+%{
+enum {PIPE_STATE_CONNECTING, PIPE_STATE_READING, PIPE_STATE_CLOSED};
+
+typedef struct {
+	OVERLAPPED ol;		// for ConnectNamedPipe and ReadFile.
+	HANDLE hPipe;
+	HANDLE hWriteEvent;
+	int state;
+	char *msg;		// the message being read.
+	DWORD cbMsg;
+	DWORD cbMsgAlloc;
+} PipeServerInstance;
+
+// A message read by GetMessages while the GIL was released.
+typedef struct {
+	ULONG instance;
+	char *data;		// NULL if the client disconnected.
+	DWORD cb;
+} PipeServerMessage;
+
+typedef struct {
+	PyObject_HEAD
+	HANDLE hPort;
+	ULONG numInstances;
+	PipeServerInstance *instances;
+	DWORD bufSize;
+	BOOL bBusy;
+	ULONG connections;
+	ULONG messages;
+} PyPipeServer;
+
+extern PyTypeObject PyPipeServer_Type;
+
+// Start an instance listening.  Never called with the GIL held.
+static void pipeserver_listen(PyPipeServer *ps, ULONG i)
+{
+	PipeServerInstance *inst = ps->instances + i;
+	memset(&inst->ol, 0, sizeof(inst->ol));
+	inst->state = PIPE_STATE_CONNECTING;
+	inst->cbMsg = 0;
+	if (ConnectNamedPipe(inst->hPipe, &inst->ol))
+		return;  // a completion packet is queued.
+	DWORD err = GetLastError();
+	if (err == ERROR_PIPE_CONNECTED)
+		// A client connected before we asked - no packet is queued, so fake one.
+		PostQueuedCompletionStatus(ps->hPort, 0, i, &inst->ol);
+	else if (err != ERROR_IO_PENDING)
+		inst->state = PIPE_STATE_CLOSED;
+}
+
+// Start, or continue, reading a message.  Returns FALSE if the client has gone.
+static BOOL pipeserver_read(PyPipeServer *ps, PipeServerInstance *inst)
+{
+	if (inst->cbMsgAlloc - inst->cbMsg < ps->bufSize) {
+		char *p = (char *)realloc(inst->msg, inst->cbMsg + ps->bufSize);
+		if (p == NULL)
+			return FALSE;
+		inst->msg = p;
+		inst->cbMsgAlloc = inst->cbMsg + ps->bufSize;
+	}
+	memset(&inst->ol, 0, sizeof(inst->ol));
+	inst->state = PIPE_STATE_READING;
+	if (ReadFile(inst->hPipe, inst->msg + inst->cbMsg, ps->bufSize, NULL, &inst->ol))
+		return TRUE;
+	DWORD err = GetLastError();
+	return err == ERROR_IO_PENDING || err == ERROR_MORE_DATA;
+}
+
+// Process one completion packet, adding any message to msgs.  Never called
+// with the GIL held.
+static void pipeserver_process(PyPipeServer *ps, ULONG i, BOOL ok, DWORD err, DWORD cb,
+	PipeServerMessage *msgs, ULONG *pnMsgs)
+{
+	PipeServerInstance *inst = ps->instances + i;
+	if (inst->state == PIPE_STATE_CONNECTING) {
+		if (!ok) {
+			pipeserver_listen(ps, i);
+			return;
+		}
+		ps->connections++;
+	}
+	else if (inst->state == PIPE_STATE_READING) {
+		if (ok || err == ERROR_MORE_DATA)
+			inst->cbMsg += cb;
+		if (ok) {
+			PipeServerMessage *m = msgs + (*pnMsgs)++;
+			m->instance = i;
+			m->cb = inst->cbMsg;
+			m->data = (char *)malloc(inst->cbMsg ? inst->cbMsg : 1);
+			if (m->data)
+				memcpy(m->data, inst->msg, inst->cbMsg);
+			else
+				m->cb = 0;
+			inst->cbMsg = 0;
+			ps->messages++;
+		}
+		else if (err != ERROR_MORE_DATA) {
+			// The client has gone (or the read was cancelled) - reuse the instance.
+			PipeServerMessage *m = msgs + (*pnMsgs)++;
+			m->instance = i;
+			m->data = NULL;
+			m->cb = 0;
+			DisconnectNamedPipe(inst->hPipe);
+			pipeserver_listen(ps, i);
+			return;
+		}
+	}
+	else
+		return;
+	if (!pipeserver_read(ps, inst)) {
+		PipeServerMessage *m = msgs + (*pnMsgs)++;
+		m->instance = i;
+		m->data = NULL;
+		m->cb = 0;
+		DisconnectNamedPipe(inst->hPipe);
+		pipeserver_listen(ps, i);
+	}
+}
+
+static void pipeserver_close(PyPipeServer *ps)
+{
+	if (ps->instances) {
+		for (ULONG i=0;i<ps->numInstances;i++) {
+			PipeServerInstance *inst = ps->instances + i;
+			if (inst->hPipe != INVALID_HANDLE_VALUE) {
+				// Make sure nothing is still using our OVERLAPPED.
+				DWORD cb;
+				if (CancelIoEx(inst->hPipe, &inst->ol))
+					GetOverlappedResult(inst->hPipe, &inst->ol, &cb, TRUE);
+				CloseHandle(inst->hPipe);
+			}
+			if (inst->hWriteEvent)
+				CloseHandle(inst->hWriteEvent);
+			free(inst->msg);
+		}
+		free(ps->instances);
+		ps->instances = NULL;
+	}
+	ps->numInstances = 0;
+	if (ps->hPort) {
+		CloseHandle(ps->hPort);
+		ps->hPort = NULL;
+	}
+}
+
+static void pipeserver_dealloc(PyObject *ob)
+{
+	PyPipeServer *ps = (PyPipeServer *)ob;
+	Py_BEGIN_ALLOW_THREADS
+	pipeserver_close(ps);
+	Py_END_ALLOW_THREADS
+	PyObject_Del(ob);
+}
+
+// @pymethod [(int, string), ...]|PyPipeServer|GetMessages|Processes pipe I/O, returning the messages read.
+// @rdesc A list of (instance, data) tuples.  data is None when the client using
+// the instance has disconnected.  The list is empty if the timeout expired.
+static PyObject *pipeserver_GetMessages(PyObject *self, PyObject *args)
+{
+	PyPipeServer *ps = (PyPipeServer *)self;
+	DWORD timeout = INFINITE;
+	int maxMessages = 64;
+	if (!PyArg_ParseTuple(args, "|ki:GetMessages",
+		&timeout, // @pyparm int|timeout|win32event.INFINITE|Milliseconds to wait for a message.
+		&maxMessages)) // @pyparm int|maxMessages|64|The maximum number of messages to return.
+		return NULL;
+	if (ps->hPort == NULL)
+		return PyErr_Format(PyExc_ValueError, "The pipe server has been closed");
+	if (maxMessages < 1)
+		return PyErr_Format(PyExc_ValueError, "maxMessages must be at least 1");
+	if (ps->bBusy)
+		return PyErr_Format(PyExc_RuntimeError, "GetMessages is already running on another thread");
+	// Each completion packet adds at most one message.
+	PipeServerMessage *msgs = (PipeServerMessage *)malloc(maxMessages * sizeof(PipeServerMessage));
+	if (msgs == NULL)
+		return PyErr_NoMemory();
+	ULONG nMsgs = 0;
+	ps->bBusy = TRUE;
+	Py_BEGIN_ALLOW_THREADS
+	ULONGLONG start = GetTickCount64();
+	DWORD wait = timeout;
+	while (nMsgs < (ULONG)maxMessages) {
+		DWORD cb = 0;
+		ULONG_PTR key = 0;
+		OVERLAPPED *pOverlapped = NULL;
+		BOOL ok = GetQueuedCompletionStatus(ps->hPort, &cb, &key, &pOverlapped, wait);
+		DWORD err = ok ? 0 : GetLastError();
+		if (pOverlapped == NULL)
+			break;  // timed out.
+		if (key < ps->numInstances)
+			pipeserver_process(ps, (ULONG)key, ok, err, cb, msgs, &nMsgs);
+		// Once we have something, only take what is already queued.
+		if (nMsgs)
+			wait = 0;
+		else if (timeout != INFINITE) {
+			ULONGLONG elapsed = GetTickCount64() - start;
+			wait = elapsed >= timeout ? 0 : timeout - (DWORD)elapsed;
+		}
+	}
+	Py_END_ALLOW_THREADS
+	ps->bBusy = FALSE;
+	PyObject *ret = PyList_New(nMsgs);
+	for (ULONG i=0;i<nMsgs;i++) {
+		if (ret) {
+			PyObject *ob;
+			if (msgs[i].data)
+				ob = Py_BuildValue("kN", msgs[i].instance, PyString_FromStringAndSize(msgs[i].data, msgs[i].cb));
+			else
+				ob = Py_BuildValue("kO", msgs[i].instance, Py_None);
+			if (ob == NULL)
+				Py_CLEAR(ret);
+			else
+				PyList_SET_ITEM(ret, i, ob);
+		}
+		free(msgs[i].data);
+	}
+	free(msgs);
+	return ret;
+}
+
+static PipeServerInstance *pipeserver_instance(PyPipeServer *ps, ULONG i)
+{
+	if (i >= ps->numInstances) {
+		PyErr_SetString(PyExc_IndexError, "Invalid pipe instance");
+		return NULL;
+	}
+	return ps->instances + i;
+}
+
+// @pymethod int|PyPipeServer|Write|Writes a message to the client connected to an instance.
+// @rdesc The number of bytes written.
+static PyObject *pipeserver_Write(PyObject *self, PyObject *args)
+{
+	PyPipeServer *ps = (PyPipeServer *)self;
+	ULONG i;
+	PyObject *obData;
+	if (!PyArg_ParseTuple(args, "kO:Write",
+		&i, // @pyparm int|instance||The instance, as returned by <om PyPipeServer.GetMessages>
+		&obData)) // @pyparm string/buffer|data||The message to write.
+		return NULL;
+	PipeServerInstance *inst = pipeserver_instance(ps, i);
+	if (inst == NULL)
+		return NULL;
+	PyWinBufferView pybuf(obData);
+	if (!pybuf.ok())
+		return NULL;
+	OVERLAPPED ol;
+	memset(&ol, 0, sizeof(ol));
+	// Setting the low bit of hEvent stops the completion being queued to our port.
+	ol.hEvent = (HANDLE)((ULONG_PTR)inst->hWriteEvent | 1);
+	DWORD cb = 0, err = 0;
+	BOOL ok;
+	Py_BEGIN_ALLOW_THREADS
+	ok = WriteFile(inst->hPipe, pybuf.ptr(), pybuf.len(), &cb, &ol);
+	if (!ok && GetLastError() == ERROR_IO_PENDING)
+		ok = GetOverlappedResult(inst->hPipe, &ol, &cb, TRUE);
+	if (!ok)
+		err = GetLastError();
+	Py_END_ALLOW_THREADS
+	if (!ok)
+		return PyWin_SetAPIError("WriteFile", err);
+	return PyLong_FromUnsignedLong(cb);
+}
+
+// @pymethod |PyPipeServer|Disconnect|Disconnects the client connected to an instance.
+// @comm The disconnection is reported, and the instance reused, by <om PyPipeServer.GetMessages>.
+static PyObject *pipeserver_Disconnect(PyObject *self, PyObject *args)
+{
+	PyPipeServer *ps = (PyPipeServer *)self;
+	ULONG i;
+	// @pyparm int|instance||The instance, as returned by <om PyPipeServer.GetMessages>
+	if (!PyArg_ParseTuple(args, "k:Disconnect", &i))
+		return NULL;
+	PipeServerInstance *inst = pipeserver_instance(ps, i);
+	if (inst == NULL)
+		return NULL;
+	if (inst->state == PIPE_STATE_READING && !CancelIoEx(inst->hPipe, &inst->ol) && GetLastError() != ERROR_NOT_FOUND)
+		return PyWin_SetAPIError("CancelIoEx");
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+// @pymethod |PyPipeServer|Close|Closes all pipe instances.
+static PyObject *pipeserver_Close(PyObject *self, PyObject *args)
+{
+	PyPipeServer *ps = (PyPipeServer *)self;
+	if (!PyArg_ParseTuple(args, ":Close"))
+		return NULL;
+	if (ps->bBusy)
+		return PyErr_Format(PyExc_RuntimeError, "GetMessages is running on another thread");
+	Py_BEGIN_ALLOW_THREADS
+	pipeserver_close(ps);
+	Py_END_ALLOW_THREADS
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+static PyMethodDef pipeserver_methods[] = {
+	{"GetMessages", pipeserver_GetMessages, METH_VARARGS}, // @pymeth GetMessages|Processes pipe I/O, returning the messages read.
+	{"Write", pipeserver_Write, METH_VARARGS}, // @pymeth Write|Writes a message to the client connected to an instance.
+	{"Disconnect", pipeserver_Disconnect, METH_VARARGS}, // @pymeth Disconnect|Disconnects the client connected to an instance.
+	{"Close", pipeserver_Close, METH_VARARGS}, // @pymeth Close|Closes all pipe instances.
+	{NULL}
+};
+
+#define OFF(e) offsetof(PyPipeServer, e)
+static PyMemberDef pipeserver_members[] = {
+	{"instances", T_ULONG, OFF(numInstances), READONLY}, // @prop int|instances|The number of pipe instances.
+	{"connections", T_ULONG, OFF(connections), READONLY}, // @prop int|connections|The number of client connections accepted.
+	{"messages", T_ULONG, OFF(messages), READONLY}, // @prop int|messages|The number of messages read.
+	{NULL}
+};
+#undef OFF
+
+PyTypeObject PyPipeServer_Type = {
+	PYWIN_OBJECT_HEAD
+	"PyPipeServer",				/* tp_name */
+	sizeof(PyPipeServer),			/* tp_basicsize */
+	0,					/* tp_itemsize */
+	pipeserver_dealloc,			/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	0,					/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	0,					/* tp_iter */
+	0,					/* tp_iternext */
+	pipeserver_methods,			/* tp_methods */
+	pipeserver_members,			/* tp_members */
+};
+
+// @pyswig <o PyPipeServer>|CreatePipeServer|Creates a message-mode named pipe server with a pool of listening instances.
+PyObject *MyCreatePipeServer(PyObject *self, PyObject *args)
+{
+	PyObject *obName, *obSA = Py_None;
+	ULONG numInstances;
+	DWORD bufSize = 4096;
+	if (!PyArg_ParseTuple(args, "Ok|kO:CreatePipeServer",
+		&obName, // @pyparm <o PyUnicode>|pipeName||The name of the pipe
+		&numInstances, // @pyparm int|numInstances||The number of instances to keep listening.
+		&bufSize, // @pyparm int|bufSize|4096|The size of the pipe buffers, and of each read.  Longer messages are read in several pieces.
+		&obSA)) // @pyparm <o PySECURITY_ATTRIBUTES>|sa|None|
+		return NULL;
+	if (numInstances < 1 || numInstances >= PIPE_UNLIMITED_INSTANCES)
+		return PyErr_Format(PyExc_ValueError, "numInstances must be between 1 and %d", PIPE_UNLIMITED_INSTANCES - 1);
+	if (bufSize < 1)
+		return PyErr_Format(PyExc_ValueError, "bufSize must be at least 1");
+	SECURITY_ATTRIBUTES *pSA;
+	if (!PyWinObject_AsSECURITY_ATTRIBUTES(obSA, &pSA, TRUE))
+		return NULL;
+	TCHAR *szName;
+	if (!PyWinObject_AsTCHAR(obName, &szName))
+		return NULL;
+	PyPipeServer *ps = PyObject_New(PyPipeServer, &PyPipeServer_Type);
+	if (ps == NULL) {
+		PyWinObject_FreeTCHAR(szName);
+		return NULL;
+	}
+	ps->numInstances = 0;
+	ps->bufSize = bufSize;
+	ps->bBusy = FALSE;
+	ps->connections = ps->messages = 0;
+	ps->hPort = NULL;
+	ps->instances = (PipeServerInstance *)calloc(numInstances, sizeof(PipeServerInstance));
+	if (ps->instances == NULL) {
+		PyWinObject_FreeTCHAR(szName);
+		Py_DECREF(ps);
+		return PyErr_NoMemory();
+	}
+	const char *fname = NULL;
+	DWORD err = 0;
+	Py_BEGIN_ALLOW_THREADS
+	ps->hPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+	if (ps->hPort == NULL) {
+		fname = "CreateIoCompletionPort";
+		err = GetLastError();
+	}
+	for (ULONG i=0;i<numInstances && fname==NULL;i++) {
+		PipeServerInstance *inst = ps->instances + i;
+		inst->hPipe = CreateNamedPipe(szName,
+			PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (i==0 ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0),
+			PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT,
+			numInstances, bufSize, bufSize, 0, pSA);
+		inst->hWriteEvent = NULL;
+		inst->state = PIPE_STATE_CLOSED;
+		ps->numInstances = i + 1;
+		if (inst->hPipe == INVALID_HANDLE_VALUE) {
+			fname = "CreateNamedPipe";
+			err = GetLastError();
+		}
+		else if ((inst->hWriteEvent = CreateEvent(NULL, TRUE, FALSE, NULL)) == NULL) {
+			fname = "CreateEvent";
+			err = GetLastError();
+		}
+		else if (CreateIoCompletionPort(inst->hPipe, ps->hPort, i, 0) == NULL) {
+			fname = "CreateIoCompletionPort";
+			err = GetLastError();
+		}
+		else
+			pipeserver_listen(ps, i);
+	}
+	if (fname)
+		pipeserver_close(ps);
+	Py_END_ALLOW_THREADS
+	PyWinObject_FreeTCHAR(szName);
+	if (fname) {
+		Py_DECREF(ps);
+		return PyWin_SetAPIError(fname, err);
+	}
+	return (PyObject *)ps;
+}
+%}
+%native(CreatePipeServer) MyCreatePipeServer;
+
+// @object PyProcessGroup|A group of child processes whose output is captured
+// natively, as returned by <om win32pipe.CreateProcessGroup>.
+// @comm Each child's stdout, stderr and stdin are overlapped named pipes bound
+// to the group's I/O completion port, and each child's exit is posted to the
+// same port by a thread pool wait - so no thread is needed per pipe, and any
+// number of children can be waited for together by <om PyProcessGroup.Wait>.
+// Output is accumulated in growable native buffers and only turned into
+// Python objects when the child has finished.
+// <nl>A child is finished when it has exited and its output pipes are closed,
+// so a grandchild which inherited the pipes will hold up its parent's result.
+// Only one thread may call Wait at a time, and Spawn can not be called while it runs.
+%{
+#define POPEN_STDOUT 0
+#define POPEN_STDERR 1
+#define POPEN_STDIN 2
+#define POPEN_EXIT 3	// the completion key for the process exit, not a stream.
+#define POPEN_READ_SIZE 4096
+
+typedef struct {
+	OVERLAPPED ol;
+	HANDLE hPipe;	// our end - INVALID_HANDLE_VALUE once closed.
+	BOOL bPending;
+	char *buf;	// the output read, or the input to write.
+	DWORD cb;
+	DWORD cbAlloc;
+} PopenStream;
+
+// Allocated individually, so the address (with the stream in the low bits)
+// can be used as the completion key.
+typedef struct {
+	PopenStream streams[3];
+	HANDLE hPort;
+	HANDLE hProcess;
+	HANDLE hWait;
+	DWORD pid;
+	DWORD exitCode;
+	BOOL bExited;
+	BOOL bMergeStderr;
+	PyObject *obCookie;
+} PopenChild;
+
+typedef struct {
+	PyObject_HEAD
+	HANDLE hPort;
+	PopenChild **children;	// running children
+	ULONG numChildren, maxChildren;
+	BOOL bBusy;
+	ULONG spawned;
+	ULONG finished;
+} PyProcessGroup;
+
+extern PyTypeObject PyProcessGroup_Type;
+static LONG popenPipeSerial = 0;
+
+static VOID CALLBACK popen_exited(PVOID context, BOOLEAN timedOut)
+{
+	PopenChild *child = (PopenChild *)context;
+	PostQueuedCompletionStatus(child->hPort, 0, (ULONG_PTR)child | POPEN_EXIT, NULL);
+}
+
+// Creates an overlapped pipe for one of the child's streams, returning the
+// child's end, which is inheritable.  Never called with the GIL held.
+static HANDLE popen_create_pipe(PopenChild *child, int stream, const char **fname)
+{
+	WCHAR name[80];
+	wsprintfW(name, L"\\\\.\\pipe\\pywin32-popen-%lu-%lu", GetCurrentProcessId(), InterlockedIncrement(&popenPipeSerial));
+	BOOL bInput = stream == POPEN_STDIN;
+	PopenStream *s = child->streams + stream;
+	s->hPipe = CreateNamedPipeW(name,
+		(bInput ? PIPE_ACCESS_OUTBOUND : PIPE_ACCESS_INBOUND) | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+		PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT, 1, POPEN_READ_SIZE, POPEN_READ_SIZE, 0, NULL);
+	if (s->hPipe == INVALID_HANDLE_VALUE) {
+		*fname = "CreateNamedPipe";
+		return INVALID_HANDLE_VALUE;
+	}
+	if (CreateIoCompletionPort(s->hPipe, child->hPort, (ULONG_PTR)child | stream, 0) == NULL) {
+		*fname = "CreateIoCompletionPort";
+		return INVALID_HANDLE_VALUE;
+	}
+	SECURITY_ATTRIBUTES sa = {sizeof(sa), NULL, TRUE};
+	HANDLE h = CreateFileW(name, bInput ? GENERIC_READ : GENERIC_WRITE, 0, &sa, OPEN_EXISTING, 0, NULL);
+	if (h == INVALID_HANDLE_VALUE)
+		*fname = "CreateFile";
+	return h;
+}
+
+// Starts the next read, or the write of the input.  Never called with the GIL held.
+static void popen_start_io(PopenStream *s, int stream)
+{
+	memset(&s->ol, 0, sizeof(s->ol));
+	BOOL ok;
+	if (stream == POPEN_STDIN)
+		ok = WriteFile(s->hPipe, s->buf, s->cb, NULL, &s->ol);
+	else {
+		if (s->cbAlloc - s->cb < POPEN_READ_SIZE) {
+			DWORD cbAlloc = s->cbAlloc ? s->cbAlloc * 2 : POPEN_READ_SIZE;
+			char *p = (char *)realloc(s->buf, cbAlloc);
+			if (p == NULL) {
+				// Out of memory - give up on this stream and keep what we have.
+				CloseHandle(s->hPipe);
+				s->hPipe = INVALID_HANDLE_VALUE;
+				return;
+			}
+			s->buf = p;
+			s->cbAlloc = cbAlloc;
+		}
+		ok = ReadFile(s->hPipe, s->buf + s->cb, s->cbAlloc - s->cb, NULL, &s->ol);
+	}
+	if (ok || GetLastError() == ERROR_IO_PENDING)
+		s->bPending = TRUE;  // a completion packet will be queued either way.
+	else {
+		CloseHandle(s->hPipe);
+		s->hPipe = INVALID_HANDLE_VALUE;
+	}
+}
+
+static BOOL popen_child_finished(PopenChild *child)
+{
+	if (!child->bExited)
+		return FALSE;
+	for (int i=0;i<3;i++)
+		if (child->streams[i].bPending)
+			return FALSE;
+	return TRUE;
+}
+
+// Releases everything but the cookie.  Never called with the GIL held.
+static void popen_child_close(PopenChild *child)
+{
+	if (child->hWait) {
+		UnregisterWaitEx(child->hWait, INVALID_HANDLE_VALUE);
+		child->hWait = NULL;
+	}
+	for (int i=0;i<3;i++) {
+		PopenStream *s = child->streams + i;
+		if (s->hPipe != INVALID_HANDLE_VALUE) {
+			DWORD cb;
+			if (s->bPending && CancelIoEx(s->hPipe, &s->ol))
+				GetOverlappedResult(s->hPipe, &s->ol, &cb, TRUE);
+			CloseHandle(s->hPipe);
+			s->hPipe = INVALID_HANDLE_VALUE;
+		}
+		free(s->buf);
+		s->buf = NULL;
+	}
+	if (child->hProcess) {
+		CloseHandle(child->hProcess);
+		child->hProcess = NULL;
+	}
+}
+
+// Processes one completion packet, returning TRUE if the child has now finished.
+// Never called with the GIL held.
+static BOOL popen_process(ULONG_PTR key, BOOL ok, DWORD cb)
+{
+	PopenChild *child = (PopenChild *)(key & ~(ULONG_PTR)3);
+	int stream = (int)(key & 3);
+	if (stream == POPEN_EXIT) {
+		if (child->hWait) {
+			UnregisterWaitEx(child->hWait, INVALID_HANDLE_VALUE);
+			child->hWait = NULL;
+		}
+		GetExitCodeProcess(child->hProcess, &child->exitCode);
+		child->bExited = TRUE;
+		return popen_child_finished(child);
+	}
+	PopenStream *s = child->streams + stream;
+	s->bPending = FALSE;
+	if (stream == POPEN_STDIN || !ok || cb == 0) {
+		// Input written (or the child stopped reading), or end of output - closing our
+		// end of stdin is how the child sees the end of its input.
+		CloseHandle(s->hPipe);
+		s->hPipe = INVALID_HANDLE_VALUE;
+	}
+	else {
+		s->cb += cb;
+		popen_start_io(s, stream);
+	}
+	return popen_child_finished(child);
+}
+
+static PyObject *popen_stream_object(PopenStream *s)
+{
+	return PyString_FromStringAndSize(s->buf ? s->buf : "", s->cb);
+}
+
+// Builds a unicode environment block from a dict.
+static WCHAR *popen_environment(PyObject *obEnv)
+{
+	if (!PyDict_Check(obEnv)) {
+		PyErr_SetString(PyExc_TypeError, "env must be a dict of strings");
+		return NULL;
+	}
+	Py_ssize_t pos = 0, len = 1;
+	PyObject *k, *v;
+	while (PyDict_Next(obEnv, &pos, &k, &v)) {
+		if (!PyUnicode_Check(k) || !PyUnicode_Check(v)) {
+			PyErr_SetString(PyExc_TypeError, "env must be a dict of strings");
+			return NULL;
+		}
+		len += PyUnicode_GetLength(k) * 2 + PyUnicode_GetLength(v) * 2 + 2;  // allow for surrogates
+	}
+	WCHAR *env = (WCHAR *)malloc(len * sizeof(WCHAR));
+	if (env == NULL) {
+		PyErr_NoMemory();
+		return NULL;
+	}
+	WCHAR *p = env;
+	pos = 0;
+	while (PyDict_Next(obEnv, &pos, &k, &v)) {
+		Py_ssize_t n = PyUnicode_AsWideChar(k, p, env + len - p);
+		if (n == -1)
+			goto error;
+		p += n;
+		*p++ = L'=';
+		n = PyUnicode_AsWideChar(v, p, env + len - p);
+		if (n == -1)
+			goto error;
+		p += n;
+		*p++ = L'\0';
+	}
+	if (p == env)
+		*p++ = L'\0';
+	*p = L'\0';
+	return env;
+error:
+	free(env);
+	return NULL;
+}
+
+static void processgroup_close(PyProcessGroup *pg, BOOL bTerminate)
+{
+	for (ULONG i=0;i<pg->numChildren;i++) {
+		PopenChild *child = pg->children[i];
+		if (bTerminate && !child->bExited)
+			TerminateProcess(child->hProcess, 1);
+		popen_child_close(child);
+	}
+	if (pg->hPort) {
+		CloseHandle(pg->hPort);
+		pg->hPort = NULL;
+	}
+}
+
+static void processgroup_free_children(PyProcessGroup *pg)
+{
+	for (ULONG i=0;i<pg->numChildren;i++) {
+		Py_DECREF(pg->children[i]->obCookie);
+		free(pg->children[i]);
+	}
+	pg->numChildren = 0;
+}
+
+static void processgroup_dealloc(PyObject *ob)
+{
+	PyProcessGroup *pg = (PyProcessGroup *)ob;
+	Py_BEGIN_ALLOW_THREADS
+	processgroup_close(pg, FALSE);
+	Py_END_ALLOW_THREADS
+	processgroup_free_children(pg);
+	free(pg->children);
+	PyObject_Del(ob);
+}
+
+// @pymethod int|PyProcessGroup|Spawn|Starts a child process with its output captured.
+// @rdesc The process id of the child.
+static PyObject *processgroup_Spawn(PyObject *self, PyObject *args)
+{
+	PyProcessGroup *pg = (PyProcessGroup *)self;
+	PyObject *obCommandLine, *obCookie = Py_None, *obCwd = Py_None, *obEnv = Py_None, *obInput = Py_None;
+	BOOL bMergeStderr = FALSE;
+	if (!PyArg_ParseTuple(args, "O|OOOOi:Spawn",
+		&obCommandLine, // @pyparm <o PyUnicode>|commandLine||The command line to execute
+		&obCookie, // @pyparm object|cookie|None|Identifies the child in the results of <om PyProcessGroup.Wait>.  If None, the process id is used.
+		&obCwd, // @pyparm <o PyUnicode>|cwd|None|The current directory for the child, or None to use ours
+		&obEnv, // @pyparm dict|env|None|The environment for the child, or None to inherit ours
+		&obInput, // @pyparm string/buffer|input|None|Data written to the child's stdin, which is then closed.  If None, stdin is closed immediately.
+		&bMergeStderr)) // @pyparm bool|mergeStderr|False|If true, stderr is written to the stdout pipe.
+		return NULL;
+	if (pg->hPort == NULL)
+		return PyErr_Format(PyExc_ValueError, "The process group has been closed");
+	if (pg->bBusy)
+		return PyErr_Format(PyExc_RuntimeError, "Wait is running on another thread");
+	if (pg->numChildren == pg->maxChildren) {
+		ULONG maxChildren = pg->maxChildren ? pg->maxChildren * 2 : 16;
+		PopenChild **children = (PopenChild **)realloc(pg->children, maxChildren * sizeof(PopenChild *));
+		if (children == NULL)
+			return PyErr_NoMemory();
+		pg->children = children;
+		pg->maxChildren = maxChildren;
+	}
+	TmpWCHAR commandLine, cwd;
+	if (!PyWinObject_AsWCHAR(obCommandLine, &commandLine))
+		return NULL;
+	if (!PyWinObject_AsWCHAR(obCwd, &cwd, TRUE))
+		return NULL;
+	PopenChild *child = (PopenChild *)calloc(1, sizeof(PopenChild));
+	if (child == NULL)
+		return PyErr_NoMemory();
+	for (int i=0;i<3;i++)
+		child->streams[i].hPipe = INVALID_HANDLE_VALUE;
+	child->hPort = pg->hPort;
+	child->bMergeStderr = bMergeStderr;
+	WCHAR *env = NULL;
+	if (obEnv != Py_None && (env = popen_environment(obEnv)) == NULL) {
+		free(child);
+		return NULL;
+	}
+	if (obInput != Py_None) {
+		PyWinBufferView pybuf(obInput);
+		if (!pybuf.ok() || (child->streams[POPEN_STDIN].buf = (char *)malloc(pybuf.len() ? pybuf.len() : 1)) == NULL) {
+			if (pybuf.ok())
+				PyErr_NoMemory();
+			free(env);
+			free(child);
+			return NULL;
+		}
+		memcpy(child->streams[POPEN_STDIN].buf, pybuf.ptr(), pybuf.len());
+		child->streams[POPEN_STDIN].cb = pybuf.len();
+	}
+	const char *fname = NULL;
+	DWORD err = 0;
+	HANDLE hChild[3] = {INVALID_HANDLE_VALUE, INVALID_HANDLE_VALUE, INVALID_HANDLE_VALUE};
+	HANDLE inherit[3];
+	int numInherit = 0;
+	Py_BEGIN_ALLOW_THREADS
+	hChild[POPEN_STDOUT] = popen_create_pipe(child, POPEN_STDOUT, &fname);
+	if (fname == NULL && !bMergeStderr)
+		hChild[POPEN_STDERR] = popen_create_pipe(child, POPEN_STDERR, &fname);
+	if (fname == NULL)
+		hChild[POPEN_STDIN] = popen_create_pipe(child, POPEN_STDIN, &fname);
+	PROCESS_INFORMATION pi;
+	STARTUPINFOEXW si;
+	memset(&si, 0, sizeof(si));
+	SIZE_T cbAttrs = 0;
+	if (fname == NULL) {
+		si.StartupInfo.cb = sizeof(si);
+		si.StartupInfo.dwFlags = STARTF_USESTDHANDLES;
+		si.StartupInfo.hStdInput = hChild[POPEN_STDIN];
+		si.StartupInfo.hStdOutput = hChild[POPEN_STDOUT];
+		si.StartupInfo.hStdError = bMergeStderr ? hChild[POPEN_STDOUT] : hChild[POPEN_STDERR];
+		// Only let the child inherit its own pipes - otherwise children spawned at the
+		// same time inherit each other's, and none see the end of their input.
+		InitializeProcThreadAttributeList(NULL, 1, 0, &cbAttrs);
+		si.lpAttributeList = (LPPROC_THREAD_ATTRIBUTE_LIST)malloc(cbAttrs);
+		if (si.lpAttributeList == NULL || !InitializeProcThreadAttributeList(si.lpAttributeList, 1, 0, &cbAttrs)) {
+			free(si.lpAttributeList);
+			si.lpAttributeList = NULL;
+			fname = "InitializeProcThreadAttributeList";
+		}
+		else {
+			for (int i=0;i<3;i++)
+				if (hChild[i] != INVALID_HANDLE_VALUE)
+					inherit[numInherit++] = hChild[i];
+			if (!UpdateProcThreadAttribute(si.lpAttributeList, 0, PROC_THREAD_ATTRIBUTE_HANDLE_LIST, inherit,
+				numInherit * sizeof(HANDLE), NULL, NULL))
+				fname = "UpdateProcThreadAttribute";
+		}
+	}
+	if (fname == NULL && !CreateProcessW(NULL, commandLine, NULL, NULL, TRUE,
+		CREATE_UNICODE_ENVIRONMENT | CREATE_NO_WINDOW | EXTENDED_STARTUPINFO_PRESENT, env, cwd,
+		&si.StartupInfo, &pi))
+		fname = "CreateProcess";
+	if (fname)
+		err = GetLastError();
+	if (si.lpAttributeList) {
+		DeleteProcThreadAttributeList(si.lpAttributeList);
+		free(si.lpAttributeList);
+	}
+	for (int i=0;i<3;i++)
+		if (hChild[i] != INVALID_HANDLE_VALUE)
+			CloseHandle(hChild[i]);
+	if (fname == NULL) {
+		CloseHandle(pi.hThread);
+		child->hProcess = pi.hProcess;
+		child->pid = pi.dwProcessId;
+		for (int i=0;i<3;i++) {
+			PopenStream *s = child->streams + i;
+			if (s->hPipe == INVALID_HANDLE_VALUE)
+				continue;
+			if (i == POPEN_STDIN && s->cb == 0) {
+				// No input - the child sees the end of it straight away.
+				CloseHandle(s->hPipe);
+				s->hPipe = INVALID_HANDLE_VALUE;
+			}
+			else
+				popen_start_io(s, i);
+		}
+		if (!RegisterWaitForSingleObject(&child->hWait, child->hProcess, popen_exited, child, INFINITE,
+			WT_EXECUTEINWAITTHREAD | WT_EXECUTEONLYONCE)) {
+			// Still report the child, with whatever exit code it has now.
+			child->hWait = NULL;
+			PostQueuedCompletionStatus(child->hPort, 0, (ULONG_PTR)child | POPEN_EXIT, NULL);
+		}
+	}
+	else
+		popen_child_close(child);
+	Py_END_ALLOW_THREADS
+	free(env);
+	if (fname) {
+		free(child);
+		return PyWin_SetAPIError(fname, err);
+	}
+	child->obCookie = obCookie == Py_None ? PyLong_FromUnsignedLong(child->pid) : obCookie;
+	if (obCookie != Py_None)
+		Py_INCREF(obCookie);
+	pg->children[pg->numChildren++] = child;
+	pg->spawned++;
+	return PyLong_FromUnsignedLong(child->pid);
+}
+
+// @pymethod [(object, int, string, string), ...]|PyProcessGroup|Wait|Waits for children to finish.
+// @rdesc A list of (cookie, exitCode, stdout, stderr) tuples for the children which have finished.
+// stderr is None for children spawned with mergeStderr.  The list is empty if the timeout expired
+// before any child finished.
+static PyObject *processgroup_Wait(PyObject *self, PyObject *args)
+{
+	PyProcessGroup *pg = (PyProcessGroup *)self;
+	DWORD timeout = INFINITE;
+	BOOL bAll = FALSE;
+	if (!PyArg_ParseTuple(args, "|ki:Wait",
+		&timeout, // @pyparm int|timeout|win32event.INFINITE|Milliseconds to wait.
+		&bAll)) // @pyparm bool|waitAll|False|If true, wait until every child has finished (or the timeout expires),
+				// rather than returning as soon as any have.
+		return NULL;
+	if (pg->hPort == NULL)
+		return PyErr_Format(PyExc_ValueError, "The process group has been closed");
+	if (pg->bBusy)
+		return PyErr_Format(PyExc_RuntimeError, "Wait is already running on another thread");
+	ULONG numFinished = 0, numChildren = pg->numChildren;
+	PopenChild **children = pg->children;
+	pg->bBusy = TRUE;
+	Py_BEGIN_ALLOW_THREADS
+	ULONGLONG start = GetTickCount64();
+	DWORD wait = timeout;
+	while (numFinished < numChildren) {
+		DWORD cb = 0;
+		ULONG_PTR key = 0;
+		OVERLAPPED *pOverlapped = NULL;
+		BOOL ok = GetQueuedCompletionStatus(pg->hPort, &cb, &key, &pOverlapped, wait);
+		if (!ok && pOverlapped == NULL)
+			break;  // timed out.
+		if (key && popen_process(key, ok, cb)) {
+			// Move the finished child to the front of the array.
+			PopenChild *child = (PopenChild *)(key & ~(ULONG_PTR)3);
+			for (ULONG i=numFinished;i<numChildren;i++)
+				if (children[i] == child) {
+					children[i] = children[numFinished];
+					children[numFinished++] = child;
+					break;
+				}
+		}
+		// Once we have something, only take what is already queued.
+		if (numFinished && !bAll)
+			wait = 0;
+		else if (timeout != INFINITE) {
+			ULONGLONG elapsed = GetTickCount64() - start;
+			wait = elapsed >= timeout ? 0 : timeout - (DWORD)elapsed;
+		}
+	}
+	Py_END_ALLOW_THREADS
+	pg->bBusy = FALSE;
+	PyObject *ret = PyList_New(numFinished);
+	for (ULONG i=0;i<numFinished;i++) {
+		PopenChild *child = children[i];
+		if (ret) {
+			PyObject *obErr;
+			if (child->bMergeStderr) {
+				obErr = Py_None;
+				Py_INCREF(obErr);
+			}
+			else
+				obErr = popen_stream_object(child->streams + POPEN_STDERR);
+			PyObject *ob = Py_BuildValue("OkNN", child->obCookie, child->exitCode,
+				popen_stream_object(child->streams + POPEN_STDOUT), obErr);
+			if (ob == NULL)
+				Py_CLEAR(ret);
+			else
+				PyList_SET_ITEM(ret, i, ob);
+		}
+		Py_BEGIN_ALLOW_THREADS
+		popen_child_close(child);
+		Py_END_ALLOW_THREADS
+		Py_DECREF(child->obCookie);
+		free(child);
+	}
+	memmove(children, children + numFinished, (numChildren - numFinished) * sizeof(PopenChild *));
+	pg->numChildren -= numFinished;
+	pg->finished += numFinished;
+	return ret;
+}
+
+// @pymethod |PyProcessGroup|Close|Stops capturing the output of any running children.
+static PyObject *processgroup_Close(PyObject *self, PyObject *args)
+{
+	PyProcessGroup *pg = (PyProcessGroup *)self;
+	BOOL bTerminate = FALSE;
+	// @pyparm bool|terminate|False|If true, running children are terminated.
+	if (!PyArg_ParseTuple(args, "|i:Close", &bTerminate))
+		return NULL;
+	if (pg->bBusy)
+		return PyErr_Format(PyExc_RuntimeError, "Wait is running on another thread");
+	Py_BEGIN_ALLOW_THREADS
+	processgroup_close(pg, bTerminate);
+	Py_END_ALLOW_THREADS
+	processgroup_free_children(pg);
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+static Py_ssize_t processgroup_length(PyObject *self)
+{
+	return ((PyProcessGroup *)self)->numChildren;
+}
+
+static PySequenceMethods processgroup_sequence = {
+	processgroup_length,	/* sq_length */
+};
+
+static PyMethodDef processgroup_methods[] = {
+	{"Spawn", processgroup_Spawn, METH_VARARGS}, // @pymeth Spawn|Starts a child process with its output captured.
+	{"Wait", processgroup_Wait, METH_VARARGS}, // @pymeth Wait|Waits for children to finish.
+	{"Close", processgroup_Close, METH_VARARGS}, // @pymeth Close|Stops capturing the output of any running children.
+	{NULL}
+};
+
+#define OFF(e) offsetof(PyProcessGroup, e)
+static PyMemberDef processgroup_members[] = {
+	{"spawned", T_ULONG, OFF(spawned), READONLY}, // @prop int|spawned|The number of children started.
+	{"finished", T_ULONG, OFF(finished), READONLY}, // @prop int|finished|The number of children returned by <om PyProcessGroup.Wait>.
+	{NULL}
+};
+#undef OFF
+
+PyTypeObject PyProcessGroup_Type = {
+	PYWIN_OBJECT_HEAD
+	"PyProcessGroup",			/* tp_name */
+	sizeof(PyProcessGroup),			/* tp_basicsize */
+	0,					/* tp_itemsize */
+	processgroup_dealloc,			/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	&processgroup_sequence,			/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	0,					/* tp_iter */
+	0,					/* tp_iternext */
+	processgroup_methods,			/* tp_methods */
+	processgroup_members,			/* tp_members */
+};
+
+// @pyswig <o PyProcessGroup>|CreateProcessGroup|Creates an object which starts child processes and captures their output.
+PyObject *MyCreateProcessGroup(PyObject *self, PyObject *args)
+{
+	if (!PyArg_ParseTuple(args, ":CreateProcessGroup"))
+		return NULL;
+	HANDLE hPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+	if (hPort == NULL)
+		return PyWin_SetAPIError("CreateIoCompletionPort");
+	PyProcessGroup *pg = PyObject_New(PyProcessGroup, &PyProcessGroup_Type);
+	if (pg == NULL) {
+		CloseHandle(hPort);
+		return NULL;
+	}
+	memset(((BYTE *)pg) + sizeof(PyObject), 0, sizeof(PyProcessGroup) - sizeof(PyObject));
+	pg->hPort = hPort;
+	return (PyObject *)pg;
+}
+%}
+%native(CreateProcessGroup) MyCreateProcessGroup;
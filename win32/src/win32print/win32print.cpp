@@ -2527,6 +2527,1062 @@ static PyObject *PyFlushPrinter(PyObject *self, PyObject *args)
     return PyLong_FromUnsignedLong(bytes_written);
 }
 
+// @object PyPRINTJOB_STREAM|A print job that is fed to the spooler by a background thread.
+// Created by <om win32print.PrintJobStream>.
+// @comm Data passed to <om PyPRINTJOB_STREAM.Write> or <om PyPRINTJOB_STREAM.WriteFile> is copied into a small
+// ring of reusable buffers, and a thread owned by the stream calls WritePrinter on each one as it is filled.
+// The caller only waits when every buffer is already queued, so several jobs can be spooled to different
+// printers at once, with the spooler's latency overlapped with producing the next chunk.
+// @comm Errors from WritePrinter are raised by the next call to Write, WriteFile or Close.  The status
+// properties are maintained by the stream itself, so there is no need to poll <om win32print.GetJob>.
+class PyPRINTJOB_STREAM : public PyObject {
+   public:
+    PyPRINTJOB_STREAM();
+    ~PyPRINTJOB_STREAM();
+    static void deallocFunc(PyObject *ob);
+    static PyObject *Write(PyObject *self, PyObject *args);
+    static PyObject *WriteFile(PyObject *self, PyObject *args);
+    static PyObject *Flush(PyObject *self, PyObject *args);
+    static PyObject *Close(PyObject *self, PyObject *args, PyObject *kwargs);
+    static PyObject *getStatus(PyObject *self, void *closure);
+    static DWORD WINAPI Worker(LPVOID param);
+    static struct PyMethodDef methods[];
+    static PyGetSetDef getset[];
+
+    // These are called without the GIL
+    BYTE *AcquireChunk();
+    void SubmitChunk();
+    void Shutdown(BOOL bAbort);
+    BOOL CheckError();
+
+    HANDLE hprinter;
+    HANDLE hthread;
+    HANDLE hfree;    // semaphore counting buffers available to the caller
+    HANDLE hqueued;  // semaphore counting buffers waiting for the worker
+    CRITICAL_SECTION cs;
+    DWORD jobid;
+    DWORD depth, chunksize;
+    BYTE **bufs;
+    DWORD *lens;
+    DWORD head;  // only used by the caller
+    DWORD tail;  // only used by the worker
+    BOOL have_chunk;
+    DWORD chunk_len;
+    // protected by cs
+    ULONGLONG submitted, written;
+    DWORD error;
+    BOOL bAbort;
+
+    BOOL bBusy, bClosed;
+};
+
+struct PyMethodDef PyPRINTJOB_STREAM::methods[] = {
+    {"Write", PyPRINTJOB_STREAM::Write, METH_VARARGS},  // @pymeth Write|Queues data to be sent to the printer
+    {"WriteFile", PyPRINTJOB_STREAM::WriteFile,
+     METH_VARARGS},                                     // @pymeth WriteFile|Queues the contents of a file
+    {"Flush", PyPRINTJOB_STREAM::Flush, METH_VARARGS},  // @pymeth Flush|Queues a partly filled buffer
+    {"Close", (PyCFunction)PyPRINTJOB_STREAM::Close,
+     METH_VARARGS | METH_KEYWORDS},  // @pymeth Close|Waits for the data to be written and ends the job
+    {NULL}};
+
+#define PRINTJOB_STATUS_SUBMITTED 0
+#define PRINTJOB_STATUS_WRITTEN 1
+#define PRINTJOB_STATUS_PENDING 2
+#define PRINTJOB_STATUS_ERROR 3
+#define PRINTJOB_STATUS_JOBID 4
+#define PRINTJOB_STATUS_CLOSED 5
+
+PyGetSetDef PyPRINTJOB_STREAM::getset[] = {
+    // @prop int|BytesSubmitted|Number of bytes accepted by Write and WriteFile
+    {"BytesSubmitted", PyPRINTJOB_STREAM::getStatus, NULL, NULL, (void *)PRINTJOB_STATUS_SUBMITTED},
+    // @prop int|BytesWritten|Number of bytes the spooler has accepted from WritePrinter
+    {"BytesWritten", PyPRINTJOB_STREAM::getStatus, NULL, NULL, (void *)PRINTJOB_STATUS_WRITTEN},
+    // @prop int|BytesPending|Number of bytes submitted but not yet written
+    {"BytesPending", PyPRINTJOB_STREAM::getStatus, NULL, NULL, (void *)PRINTJOB_STATUS_PENDING},
+    // @prop int|Error|The error code from a failed WritePrinter, or 0
+    {"Error", PyPRINTJOB_STREAM::getStatus, NULL, NULL, (void *)PRINTJOB_STATUS_ERROR},
+    // @prop int|JobId|The job id returned by StartDocPrinter
+    {"JobId", PyPRINTJOB_STREAM::getStatus, NULL, NULL, (void *)PRINTJOB_STATUS_JOBID},
+    // @prop boolean|Closed|True once <om PyPRINTJOB_STREAM.Close> has been called
+    {"Closed", PyPRINTJOB_STREAM::getStatus, NULL, NULL, (void *)PRINTJOB_STATUS_CLOSED},
+    {NULL}};
+
+PyTypeObject PyPRINTJOB_STREAMType = {
+    PYWIN_OBJECT_HEAD "PyPRINTJOB_STREAM",
+    sizeof(PyPRINTJOB_STREAM),
+    0,
+    PyPRINTJOB_STREAM::deallocFunc, /* tp_dealloc */
+    0,                              /* tp_print */
+    0,                              /* tp_getattr */
+    0,                              /* tp_setattr */
+    0,                              /* tp_compare */
+    0,                              /* tp_repr */
+    0,                              /* tp_as_number */
+    0,                              /* tp_as_sequence */
+    0,                              /* tp_as_mapping */
+    0,                              /* tp_hash */
+    0,                              /* tp_call */
+    0,                              /* tp_str */
+    PyObject_GenericGetAttr,        /* tp_getattro */
+    0,                              /* tp_setattro */
+    0,                              /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,             /* tp_flags */
+    0,                              /* tp_doc */
+    0,                              /* tp_traverse */
+    0,                              /* tp_clear */
+    0,                              /* tp_richcompare */
+    0,                              /* tp_weaklistoffset */
+    0,                              /* tp_iter */
+    0,                              /* tp_iternext */
+    PyPRINTJOB_STREAM::methods,     /* tp_methods */
+    0,                              /* tp_members */
+    PyPRINTJOB_STREAM::getset,      /* tp_getset */
+};
+
+PyPRINTJOB_STREAM::PyPRINTJOB_STREAM()
+{
+    ob_type = &PyPRINTJOB_STREAMType;
+    _Py_NewReference(this);
+    hprinter = hthread = hfree = hqueued = NULL;
+    InitializeCriticalSection(&cs);
+    jobid = depth = chunksize = 0;
+    bufs = NULL;
+    lens = NULL;
+    head = tail = chunk_len = 0;
+    have_chunk = FALSE;
+    submitted = written = 0;
+    error = 0;
+    bAbort = bBusy = bClosed = FALSE;
+}
+
+PyPRINTJOB_STREAM::~PyPRINTJOB_STREAM()
+{
+    if (!bClosed) {
+        Py_BEGIN_ALLOW_THREADS Shutdown(TRUE);
+        Py_END_ALLOW_THREADS
+    }
+    if (hfree)
+        CloseHandle(hfree);
+    if (hqueued)
+        CloseHandle(hqueued);
+    if (bufs) {
+        for (DWORD i = 0; i < depth; i++) free(bufs[i]);
+        free(bufs);
+    }
+    if (lens)
+        free(lens);
+    DeleteCriticalSection(&cs);
+}
+
+/*static*/ void PyPRINTJOB_STREAM::deallocFunc(PyObject *ob) { delete (PyPRINTJOB_STREAM *)ob; }
+
+// Returns the buffer being filled by the caller, waiting for the worker to free one if necessary
+BYTE *PyPRINTJOB_STREAM::AcquireChunk()
+{
+    if (!have_chunk) {
+        WaitForSingleObject(hfree, INFINITE);
+        have_chunk = TRUE;
+        chunk_len = 0;
+    }
+    return bufs[head % depth];
+}
+
+// Hands the current buffer to the worker.  A zero length buffer tells it to exit.
+void PyPRINTJOB_STREAM::SubmitChunk()
+{
+    lens[head % depth] = chunk_len;
+    head++;
+    have_chunk = FALSE;
+    ReleaseSemaphore(hqueued, 1, NULL);
+}
+
+BOOL PyPRINTJOB_STREAM::CheckError()
+{
+    EnterCriticalSection(&cs);
+    BOOL ret = error != 0;
+    LeaveCriticalSection(&cs);
+    return ret;
+}
+
+// Waits for the worker to finish, then ends or aborts the job and closes the printer
+void PyPRINTJOB_STREAM::Shutdown(BOOL bAbortJob)
+{
+    if (hthread) {
+        if (bAbortJob) {
+            EnterCriticalSection(&cs);
+            bAbort = TRUE;
+            LeaveCriticalSection(&cs);
+        }
+        if (have_chunk && chunk_len)
+            SubmitChunk();
+        AcquireChunk();
+        chunk_len = 0;
+        SubmitChunk();
+        WaitForSingleObject(hthread, INFINITE);
+        CloseHandle(hthread);
+        hthread = NULL;
+    }
+    if (hprinter) {
+        if (jobid) {
+            if (bAbortJob || error)
+                AbortPrinter(hprinter);
+            else if (!EndDocPrinter(hprinter))
+                error = GetLastError();
+        }
+        ClosePrinter(hprinter);
+        hprinter = NULL;
+    }
+    bClosed = TRUE;
+}
+
+/*static*/ DWORD WINAPI PyPRINTJOB_STREAM::Worker(LPVOID param)
+{
+    PyPRINTJOB_STREAM *This = (PyPRINTJOB_STREAM *)param;
+    while (1) {
+        WaitForSingleObject(This->hqueued, INFINITE);
+        DWORD i = This->tail % This->depth;
+        DWORD len = This->lens[i], done = 0;
+        if (len == 0)
+            break;
+        EnterCriticalSection(&This->cs);
+        BOOL bSkip = This->error || This->bAbort;
+        LeaveCriticalSection(&This->cs);
+        // Once anything has failed, buffers are just discarded so the caller never blocks
+        while (!bSkip && done < len) {
+            DWORD w = 0, err = 0;
+            if (!WritePrinter(This->hprinter, This->bufs[i] + done, len - done, &w))
+                err = GetLastError();
+            else if (w == 0)
+                err = ERROR_WRITE_FAULT;
+            done += w;
+            EnterCriticalSection(&This->cs);
+            This->written += w;
+            if (err)
+                This->error = err;
+            bSkip = This->error || This->bAbort;
+            LeaveCriticalSection(&This->cs);
+        }
+        This->tail++;
+        ReleaseSemaphore(This->hfree, 1, NULL);
+    }
+    return 0;
+}
+
+#define CHECK_PRINTJOB_STREAM(This)                                                         \
+    if (This->bClosed) {                                                                    \
+        PyErr_SetString(PyExc_ValueError, "The print job has been closed");                 \
+        return NULL;                                                                        \
+    }                                                                                       \
+    if (This->bBusy) {                                                                      \
+        PyErr_SetString(PyExc_RuntimeError, "The print job is being used by another thread"); \
+        return NULL;                                                                        \
+    }
+
+// @pymethod int|PyPRINTJOB_STREAM|Write|Queues data to be sent to the printer
+// @comm Small writes are combined into full buffers.  Use <om PyPRINTJOB_STREAM.Flush> to send a partial buffer.
+// @rdesc Returns the number of bytes queued
+PyObject *PyPRINTJOB_STREAM::Write(PyObject *self, PyObject *args)
+{
+    PyPRINTJOB_STREAM *This = (PyPRINTJOB_STREAM *)self;
+    PyObject *obdata;
+    // @pyparm buffer|Data||Any object supporting the buffer interface, eg bytes, bytearray or memoryview
+    if (!PyArg_ParseTuple(args, "O:Write", &obdata))
+        return NULL;
+    CHECK_PRINTJOB_STREAM(This);
+    PyWinBufferView pybuf(obdata);
+    if (!pybuf.ok())
+        return NULL;
+    BYTE *src = (BYTE *)pybuf.ptr();
+    DWORD len = pybuf.len();
+    BOOL bError;
+    This->bBusy = TRUE;
+    Py_BEGIN_ALLOW_THREADS;
+    while (!(bError = This->CheckError()) && len) {
+        BYTE *dest = This->AcquireChunk();
+        DWORD n = min(len, This->chunksize - This->chunk_len);
+        memcpy(dest + This->chunk_len, src, n);
+        This->chunk_len += n;
+        src += n;
+        len -= n;
+        EnterCriticalSection(&This->cs);
+        This->submitted += n;
+        LeaveCriticalSection(&This->cs);
+        if (This->chunk_len == This->chunksize)
+            This->SubmitChunk();
+    }
+    Py_END_ALLOW_THREADS;
+    This->bBusy = FALSE;
+    if (bError)
+        return PyWin_SetAPIError("WritePrinter", This->error);
+    return PyLong_FromUnsignedLong(pybuf.len());
+}
+
+// @pymethod int|PyPRINTJOB_STREAM|WriteFile|Queues the contents of a file, read directly into the stream's buffers
+// @rdesc Returns the number of bytes read from the file
+PyObject *PyPRINTJOB_STREAM::WriteFile(PyObject *self, PyObject *args)
+{
+    PyPRINTJOB_STREAM *This = (PyPRINTJOB_STREAM *)self;
+    PyObject *obfile;
+    // @pyparm str\|<o PyHANDLE>|File||Name of the file to send, or a handle open for reading.  A handle is read from
+    // its current position to the end of the file.
+    if (!PyArg_ParseTuple(args, "O:WriteFile", &obfile))
+        return NULL;
+    CHECK_PRINTJOB_STREAM(This);
+    HANDLE hfile;
+    BOOL bCloseFile = FALSE;
+    if (PyUnicode_Check(obfile)) {
+        TmpWCHAR filename;
+        if (!PyWinObject_AsWCHAR(obfile, &filename))
+            return NULL;
+        Py_BEGIN_ALLOW_THREADS hfile = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                                   FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        Py_END_ALLOW_THREADS if (hfile == INVALID_HANDLE_VALUE) return PyWin_SetAPIError("CreateFile");
+        bCloseFile = TRUE;
+    }
+    else if (!PyWinObject_AsHANDLE(obfile, &hfile))
+        return NULL;
+
+    ULONGLONG total = 0;
+    DWORD err = 0;
+    char *failed = NULL;
+    This->bBusy = TRUE;
+    Py_BEGIN_ALLOW_THREADS;
+    while (1) {
+        if (This->CheckError()) {
+            err = This->error;
+            failed = "WritePrinter";
+            break;
+        }
+        BYTE *dest = This->AcquireChunk();
+        DWORD n = 0;
+        if (!::ReadFile(hfile, dest + This->chunk_len, This->chunksize - This->chunk_len, &n, NULL)) {
+            err = GetLastError();
+            failed = "ReadFile";
+            break;
+        }
+        if (n == 0)
+            break;
+        This->chunk_len += n;
+        total += n;
+        EnterCriticalSection(&This->cs);
+        This->submitted += n;
+        LeaveCriticalSection(&This->cs);
+        if (This->chunk_len == This->chunksize)
+            This->SubmitChunk();
+    }
+    if (bCloseFile)
+        CloseHandle(hfile);
+    Py_END_ALLOW_THREADS;
+    This->bBusy = FALSE;
+    if (failed)
+        return PyWin_SetAPIError(failed, err);
+    return PyLong_FromUnsignedLongLong(total);
+}
+
+// @pymethod |PyPRINTJOB_STREAM|Flush|Queues the partly filled buffer, if any, without waiting for it to be written
+PyObject *PyPRINTJOB_STREAM::Flush(PyObject *self, PyObject *args)
+{
+    PyPRINTJOB_STREAM *This = (PyPRINTJOB_STREAM *)self;
+    if (!PyArg_ParseTuple(args, ":Flush"))
+        return NULL;
+    CHECK_PRINTJOB_STREAM(This);
+    if (This->have_chunk && This->chunk_len)
+        This->SubmitChunk();
+    if (This->CheckError())
+        return PyWin_SetAPIError("WritePrinter", This->error);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod int|PyPRINTJOB_STREAM|Close|Waits for all queued data to be written, then ends the job
+// @comm Calling Close more than once is allowed, and simply returns the same result.
+// @rdesc Returns the number of bytes written to the printer
+PyObject *PyPRINTJOB_STREAM::Close(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    PyPRINTJOB_STREAM *This = (PyPRINTJOB_STREAM *)self;
+    static char *keywords[] = {"Abort", NULL};
+    BOOL bAbortJob = FALSE;
+    // @pyparm boolean|Abort|False|If True, data that hasn't been written yet is discarded and the job is deleted
+    // using AbortPrinter.  Errors are not raised in this case.
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|i:Close", keywords, &bAbortJob))
+        return NULL;
+    if (!This->bClosed) {
+        if (This->bBusy) {
+            PyErr_SetString(PyExc_RuntimeError, "The print job is being used by another thread");
+            return NULL;
+        }
+        This->bBusy = TRUE;
+        Py_BEGIN_ALLOW_THREADS This->Shutdown(bAbortJob);
+        Py_END_ALLOW_THREADS This->bBusy = FALSE;
+        if (bAbortJob)
+            This->error = 0;
+    }
+    if (This->error)
+        return PyWin_SetAPIError("WritePrinter", This->error);
+    return PyLong_FromUnsignedLongLong(This->written);
+}
+
+/*static*/ PyObject *PyPRINTJOB_STREAM::getStatus(PyObject *self, void *closure)
+{
+    PyPRINTJOB_STREAM *This = (PyPRINTJOB_STREAM *)self;
+    ULONGLONG submitted, written;
+    DWORD error;
+    EnterCriticalSection(&This->cs);
+    submitted = This->submitted;
+    written = This->written;
+    error = This->error;
+    LeaveCriticalSection(&This->cs);
+    switch ((INT_PTR)closure) {
+        case PRINTJOB_STATUS_SUBMITTED:
+            return PyLong_FromUnsignedLongLong(submitted);
+        case PRINTJOB_STATUS_WRITTEN:
+            return PyLong_FromUnsignedLongLong(written);
+        case PRINTJOB_STATUS_PENDING:
+            return PyLong_FromUnsignedLongLong(submitted - written);
+        case PRINTJOB_STATUS_ERROR:
+            return PyLong_FromUnsignedLong(error);
+        case PRINTJOB_STATUS_JOBID:
+            return PyLong_FromUnsignedLong(This->jobid);
+        case PRINTJOB_STATUS_CLOSED:
+            return PyBool_FromLong(This->bClosed);
+    }
+    PyErr_SetString(PyExc_SystemError, "Unknown print job status");
+    return NULL;
+}
+
+// @pymethod <o PyPRINTJOB_STREAM>|win32print|PrintJobStream|Starts a print job whose data is written to the spooler
+// by a background thread
+// @comm The printer is opened, and StartDocPrinter called, before this returns.  The job is not split into pages,
+// so this is intended for raw data such as PCL, ZPL or Postscript.
+static PyObject *PyPrintJobStream(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"PrinterName", "DocName", "DataType", "QueueDepth", "ChunkSize", NULL};
+    PyObject *obprintername, *obdocname, *obdatatype = NULL;
+    DWORD depth = 4, chunksize = 65536;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "OO|Okk:PrintJobStream", keywords,
+            &obprintername,  // @pyparm str|PrinterName||Name of the printer
+            &obdocname,      // @pyparm str|DocName||Name of the document, as shown in the print queue
+            &obdatatype,     // @pyparm str|DataType|"RAW"|Data type of the job, or None for the printer's default
+            &depth,          // @pyparm int|QueueDepth|4|Number of buffers that can be queued for the printer
+            &chunksize))     // @pyparm int|ChunkSize|65536|Size of each buffer
+        return NULL;
+    if (depth < 1 || chunksize < 1) {
+        PyErr_SetString(PyExc_ValueError, "QueueDepth and ChunkSize must be greater than 0");
+        return NULL;
+    }
+    TmpWCHAR printername, docname, datatypebuf;
+    WCHAR *datatype = L"RAW";
+    if (!PyWinObject_AsWCHAR(obprintername, &printername) || !PyWinObject_AsWCHAR(obdocname, &docname))
+        return NULL;
+    if (obdatatype != NULL) {
+        if (!PyWinObject_AsWCHAR(obdatatype, &datatypebuf, TRUE))
+            return NULL;
+        datatype = datatypebuf;
+    }
+
+    PyPRINTJOB_STREAM *ret = new PyPRINTJOB_STREAM();
+    if (ret == NULL)
+        return PyErr_NoMemory();
+    ret->depth = depth;
+    ret->chunksize = chunksize;
+    ret->bufs = (BYTE **)calloc(depth, sizeof(BYTE *));
+    ret->lens = (DWORD *)calloc(depth, sizeof(DWORD));
+    if (ret->bufs == NULL || ret->lens == NULL) {
+        Py_DECREF(ret);
+        return PyErr_NoMemory();
+    }
+    for (DWORD i = 0; i < depth; i++)
+        if ((ret->bufs[i] = (BYTE *)malloc(chunksize)) == NULL) {
+            Py_DECREF(ret);
+            return PyErr_NoMemory();
+        }
+
+    char *failed = NULL;
+    DOC_INFO_1W info = {docname, NULL, datatype};
+    Py_BEGIN_ALLOW_THREADS;
+    if (!OpenPrinterW(printername, &ret->hprinter, NULL)) {
+        ret->hprinter = NULL;
+        failed = "OpenPrinter";
+    }
+    else if ((ret->jobid = StartDocPrinterW(ret->hprinter, 1, (LPBYTE)&info)) == 0)
+        failed = "StartDocPrinter";
+    else if ((ret->hfree = CreateSemaphore(NULL, depth, depth, NULL)) == NULL ||
+             (ret->hqueued = CreateSemaphore(NULL, 0, depth, NULL)) == NULL)
+        failed = "CreateSemaphore";
+    else if ((ret->hthread = CreateThread(NULL, 0, PyPRINTJOB_STREAM::Worker, ret, 0, NULL)) == NULL)
+        failed = "CreateThread";
+    Py_END_ALLOW_THREADS;
+    if (failed) {
+        PyWin_SetAPIError(failed);
+        Py_DECREF(ret);
+        return NULL;
+    }
+    return ret;
+}
+PyCFunction pfnPyPrintJobStream = (PyCFunction)PyPrintJobStream;
+
+// @object PyPRINTER_MONITOR|Watches many printers for changes to printer and job information, as returned by
+// <om win32print.PrinterChangeMonitor>.
+// @comm Each printer added with <om PyPRINTER_MONITOR.AddPrinter> has a change notification created with
+// FindFirstPrinterChangeNotification.  A single native thread owned by the monitor waits for all of them, and
+// collects the fields reported by FindNextPrinterChangeNotification - only the fields which actually changed
+// are reported, so there is no need to rebuild whole JOB_INFO or PRINTER_INFO dictionaries.
+// <nl>Changes are delivered by <om PyPRINTER_MONITOR.GetChanges> as a list of (Cookie, Type, Id, Fields) tuples,
+// where Type is PRINTER_NOTIFY_TYPE or JOB_NOTIFY_TYPE, Id is the job id (0 for printers), and Fields is a dict
+// mapping PRINTER_NOTIFY_FIELD_* or JOB_NOTIFY_FIELD_* values to their new values.  Several changes to the
+// same job between calls are merged into one tuple.
+// <nl>If the spooler had to discard notifications, the monitor requests a full refresh for that printer, and
+// reports a (Cookie, None, 0, None) tuple before the refreshed values.  Jobs that went away in the meantime
+// are not reported by the refresh.
+// <nl>One thread can wait for at most 63 printers, so use several monitors for more.  The thread keeps the
+// monitor alive - <om PyPRINTER_MONITOR.Close> must be called to stop it.
+
+struct PRINTER_WATCH {
+    LONG id;
+    HANDLE hprinter;
+    HANDLE hchange;
+    PyObject *obcookie;
+    PRINTER_NOTIFY_OPTIONS options;
+    PRINTER_NOTIFY_OPTIONS_TYPE types[2];
+    BOOL bRemoved;  // set by RemovePrinter, the thread closes the handles
+};
+
+#define MAX_PRINTER_WATCHES (MAXIMUM_WAIT_OBJECTS - 1)
+
+class PyPRINTER_MONITOR : public PyObject {
+   public:
+    PyPRINTER_MONITOR();
+    ~PyPRINTER_MONITOR();
+    static void deallocFunc(PyObject *ob);
+    static PyObject *AddPrinter(PyObject *self, PyObject *args, PyObject *kwargs);
+    static PyObject *RemovePrinter(PyObject *self, PyObject *args);
+    static PyObject *GetChanges(PyObject *self, PyObject *args);
+    static PyObject *Close(PyObject *self, PyObject *args);
+    static DWORD WINAPI Worker(LPVOID param);
+    static struct PyMethodDef methods[];
+
+    // Called by the worker with the GIL held
+    BOOL AddChanges(PRINTER_WATCH *w, PRINTER_NOTIFY_INFO *pinfo, BOOL bRefreshed);
+    static void FreeWatch(PRINTER_WATCH *w);
+
+    CRITICAL_SECTION cs;  // protects watches, numwatches and bStop
+    PRINTER_WATCH *watches[MAX_PRINTER_WATCHES];
+    DWORD numwatches;
+    LONG nextid;
+    BOOL bStop;
+    HANDLE hwake;   // tells the thread the set of printers changed, or to stop
+    HANDLE hready;  // set when changes are added
+    HANDLE hthread;
+    PyObject *pending;  // dict of (Cookie, Type, Id) -> fields, only used with the GIL held
+    BOOL bClosed;
+};
+
+struct PyMethodDef PyPRINTER_MONITOR::methods[] = {
+    {"AddPrinter", (PyCFunction)PyPRINTER_MONITOR::AddPrinter,
+     METH_VARARGS | METH_KEYWORDS},  // @pymeth AddPrinter|Starts watching a printer
+    {"RemovePrinter", PyPRINTER_MONITOR::RemovePrinter,
+     METH_VARARGS},  // @pymeth RemovePrinter|Stops watching a printer
+    {"GetChanges", PyPRINTER_MONITOR::GetChanges,
+     METH_VARARGS},                                         // @pymeth GetChanges|Waits for changes
+    {"Close", PyPRINTER_MONITOR::Close, METH_VARARGS},  // @pymeth Close|Stops the monitor
+    {NULL}};
+
+PyTypeObject PyPRINTER_MONITORType = {
+    PYWIN_OBJECT_HEAD "PyPRINTER_MONITOR",
+    sizeof(PyPRINTER_MONITOR),
+    0,
+    PyPRINTER_MONITOR::deallocFunc, /* tp_dealloc */
+    0,                              /* tp_print */
+    0,                              /* tp_getattr */
+    0,                              /* tp_setattr */
+    0,                              /* tp_compare */
+    0,                              /* tp_repr */
+    0,                              /* tp_as_number */
+    0,                              /* tp_as_sequence */
+    0,                              /* tp_as_mapping */
+    0,                              /* tp_hash */
+    0,                              /* tp_call */
+    0,                              /* tp_str */
+    PyObject_GenericGetAttr,        /* tp_getattro */
+    0,                              /* tp_setattro */
+    0,                              /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,             /* tp_flags */
+    0,                              /* tp_doc */
+    0,                              /* tp_traverse */
+    0,                              /* tp_clear */
+    0,                              /* tp_richcompare */
+    0,                              /* tp_weaklistoffset */
+    0,                              /* tp_iter */
+    0,                              /* tp_iternext */
+    PyPRINTER_MONITOR::methods,     /* tp_methods */
+};
+
+// Fields requested when AddPrinter isn't given a list.  PRINTER_NOTIFY_FIELD_STATUS_STRING isn't supported.
+static WORD default_printer_fields[] = {
+    PRINTER_NOTIFY_FIELD_SERVER_NAME, PRINTER_NOTIFY_FIELD_PRINTER_NAME,    PRINTER_NOTIFY_FIELD_SHARE_NAME,
+    PRINTER_NOTIFY_FIELD_PORT_NAME,   PRINTER_NOTIFY_FIELD_DRIVER_NAME,     PRINTER_NOTIFY_FIELD_COMMENT,
+    PRINTER_NOTIFY_FIELD_LOCATION,    PRINTER_NOTIFY_FIELD_PRINT_PROCESSOR, PRINTER_NOTIFY_FIELD_DATATYPE,
+    PRINTER_NOTIFY_FIELD_ATTRIBUTES,  PRINTER_NOTIFY_FIELD_PRIORITY,        PRINTER_NOTIFY_FIELD_STATUS,
+    PRINTER_NOTIFY_FIELD_CJOBS,
+};
+static WORD default_job_fields[] = {
+    JOB_NOTIFY_FIELD_PRINTER_NAME,  JOB_NOTIFY_FIELD_MACHINE_NAME,  JOB_NOTIFY_FIELD_USER_NAME,
+    JOB_NOTIFY_FIELD_DATATYPE,      JOB_NOTIFY_FIELD_STATUS,        JOB_NOTIFY_FIELD_STATUS_STRING,
+    JOB_NOTIFY_FIELD_DOCUMENT,      JOB_NOTIFY_FIELD_PRIORITY,      JOB_NOTIFY_FIELD_POSITION,
+    JOB_NOTIFY_FIELD_SUBMITTED,     JOB_NOTIFY_FIELD_TOTAL_PAGES,   JOB_NOTIFY_FIELD_PAGES_PRINTED,
+    JOB_NOTIFY_FIELD_TOTAL_BYTES,   JOB_NOTIFY_FIELD_BYTES_PRINTED,
+};
+
+// Converts the value of one field, which may be either in adwData or pointed to by pBuf
+static PyObject *PyWinObject_FromPRINTER_NOTIFY_INFO_DATA(PRINTER_NOTIFY_INFO_DATA *data)
+{
+    BOOL bDevMode = FALSE, bSD = FALSE, bTime = FALSE, bString = FALSE;
+    if (data->Type == PRINTER_NOTIFY_TYPE)
+        switch (data->Field) {
+            case PRINTER_NOTIFY_FIELD_DEVMODE:
+                bDevMode = TRUE;
+                break;
+            case PRINTER_NOTIFY_FIELD_SECURITY_DESCRIPTOR:
+                bSD = TRUE;
+                break;
+            case PRINTER_NOTIFY_FIELD_SERVER_NAME:
+            case PRINTER_NOTIFY_FIELD_PRINTER_NAME:
+            case PRINTER_NOTIFY_FIELD_SHARE_NAME:
+            case PRINTER_NOTIFY_FIELD_PORT_NAME:
+            case PRINTER_NOTIFY_FIELD_DRIVER_NAME:
+            case PRINTER_NOTIFY_FIELD_COMMENT:
+            case PRINTER_NOTIFY_FIELD_LOCATION:
+            case PRINTER_NOTIFY_FIELD_SEPFILE:
+            case PRINTER_NOTIFY_FIELD_PRINT_PROCESSOR:
+            case PRINTER_NOTIFY_FIELD_PARAMETERS:
+            case PRINTER_NOTIFY_FIELD_DATATYPE:
+            case PRINTER_NOTIFY_FIELD_STATUS_STRING:
+            case PRINTER_NOTIFY_FIELD_OBJECT_GUID:
+                bString = TRUE;
+                break;
+        }
+    else if (data->Type == JOB_NOTIFY_TYPE)
+        switch (data->Field) {
+            case JOB_NOTIFY_FIELD_DEVMODE:
+                bDevMode = TRUE;
+                break;
+            case JOB_NOTIFY_FIELD_SECURITY_DESCRIPTOR:
+                bSD = TRUE;
+                break;
+            case JOB_NOTIFY_FIELD_SUBMITTED:
+                bTime = TRUE;
+                break;
+            case JOB_NOTIFY_FIELD_PRINTER_NAME:
+            case JOB_NOTIFY_FIELD_MACHINE_NAME:
+            case JOB_NOTIFY_FIELD_PORT_NAME:
+            case JOB_NOTIFY_FIELD_USER_NAME:
+            case JOB_NOTIFY_FIELD_NOTIFY_NAME:
+            case JOB_NOTIFY_FIELD_DATATYPE:
+            case JOB_NOTIFY_FIELD_PRINT_PROCESSOR:
+            case JOB_NOTIFY_FIELD_PARAMETERS:
+            case JOB_NOTIFY_FIELD_DRIVER_NAME:
+            case JOB_NOTIFY_FIELD_STATUS_STRING:
+            case JOB_NOTIFY_FIELD_DOCUMENT:
+                bString = TRUE;
+                break;
+        }
+    if (!(bDevMode || bSD || bTime || bString))
+        return PyLong_FromUnsignedLong(data->NotifyData.adwData[0]);
+    if (data->NotifyData.Data.pBuf == NULL) {
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
+    if (bDevMode)
+        return PyWinObject_FromDEVMODE((PDEVMODEW)data->NotifyData.Data.pBuf);
+    if (bSD)
+        return PyWinObject_FromSECURITY_DESCRIPTOR((PSECURITY_DESCRIPTOR)data->NotifyData.Data.pBuf);
+    if (bTime)
+        return PyWinObject_FromSYSTEMTIME(*(SYSTEMTIME *)data->NotifyData.Data.pBuf);
+    return PyWinObject_FromWCHAR((WCHAR *)data->NotifyData.Data.pBuf);
+}
+
+PyPRINTER_MONITOR::PyPRINTER_MONITOR()
+{
+    ob_type = &PyPRINTER_MONITORType;
+    _Py_NewReference(this);
+    InitializeCriticalSection(&cs);
+    numwatches = 0;
+    nextid = 0;
+    bStop = bClosed = FALSE;
+    hwake = hready = hthread = NULL;
+    pending = NULL;
+}
+
+PyPRINTER_MONITOR::~PyPRINTER_MONITOR()
+{
+    // The thread holds a reference, so it has finished by now
+    for (DWORD i = 0; i < numwatches; i++) FreeWatch(watches[i]);
+    if (hthread)
+        CloseHandle(hthread);
+    if (hwake)
+        CloseHandle(hwake);
+    if (hready)
+        CloseHandle(hready);
+    Py_XDECREF(pending);
+    DeleteCriticalSection(&cs);
+}
+
+/*static*/ void PyPRINTER_MONITOR::deallocFunc(PyObject *ob) { delete (PyPRINTER_MONITOR *)ob; }
+
+// Closes the handles of a watch - called with the GIL held
+/*static*/ void PyPRINTER_MONITOR::FreeWatch(PRINTER_WATCH *w)
+{
+    if (w->hchange != NULL && w->hchange != INVALID_HANDLE_VALUE)
+        FindClosePrinterChangeNotification(w->hchange);
+    if (w->hprinter)
+        ClosePrinter(w->hprinter);
+    for (DWORD i = 0; i < w->options.Count; i++) free(w->types[i].pFields);
+    Py_XDECREF(w->obcookie);
+    free(w);
+}
+
+BOOL PyPRINTER_MONITOR::AddChanges(PRINTER_WATCH *w, PRINTER_NOTIFY_INFO *pinfo, BOOL bRefreshed)
+{
+    if (bRefreshed) {
+        PyObject *key = Py_BuildValue("OOk", w->obcookie, Py_None, 0);
+        if (key == NULL || PyDict_SetItem(pending, key, Py_None) == -1) {
+            Py_XDECREF(key);
+            return FALSE;
+        }
+        Py_DECREF(key);
+    }
+    for (DWORD i = 0; i < pinfo->Count; i++) {
+        PRINTER_NOTIFY_INFO_DATA *data = &pinfo->aData[i];
+        PyObject *key = Py_BuildValue("OHk", w->obcookie, data->Type, data->Type == JOB_NOTIFY_TYPE ? data->Id : 0);
+        if (key == NULL)
+            return FALSE;
+        PyObject *fields = PyDict_GetItem(pending, key);
+        if (fields == NULL || fields == Py_None) {
+            fields = PyDict_New();
+            if (fields == NULL || PyDict_SetItem(pending, key, fields) == -1) {
+                Py_XDECREF(fields);
+                Py_DECREF(key);
+                return FALSE;
+            }
+            Py_DECREF(fields);  // the dict holds a reference
+        }
+        Py_DECREF(key);
+        PyObject *obfield = PyLong_FromLong(data->Field);
+        PyObject *obvalue = PyWinObject_FromPRINTER_NOTIFY_INFO_DATA(data);
+        BOOL bOk = obfield && obvalue && PyDict_SetItem(fields, obfield, obvalue) != -1;
+        Py_XDECREF(obfield);
+        Py_XDECREF(obvalue);
+        if (!bOk)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/*static*/ DWORD WINAPI PyPRINTER_MONITOR::Worker(LPVOID param)
+{
+    PyPRINTER_MONITOR *This = (PyPRINTER_MONITOR *)param;
+    PRINTER_NOTIFY_OPTIONS refresh = {2, PRINTER_NOTIFY_OPTIONS_REFRESH, 0, NULL};
+    HANDLE handles[MAXIMUM_WAIT_OBJECTS];
+    PRINTER_WATCH *current[MAX_PRINTER_WATCHES], *removed[MAX_PRINTER_WATCHES];
+    DWORD numcurrent, numremoved;
+    while (1) {
+        // Only this thread closes the notification handles, so it never waits on a closed one
+        EnterCriticalSection(&This->cs);
+        BOOL bStop = This->bStop;
+        numcurrent = numremoved = 0;
+        for (DWORD i = 0; i < This->numwatches; i++) {
+            PRINTER_WATCH *w = This->watches[i];
+            if (w->bRemoved || bStop)
+                removed[numremoved++] = w;
+            else
+                current[numcurrent++] = w;
+        }
+        memcpy(This->watches, current, numcurrent * sizeof(PRINTER_WATCH *));
+        This->numwatches = numcurrent;
+        LeaveCriticalSection(&This->cs);
+        if (numremoved) {
+            CEnterLeavePython celp;
+            for (DWORD i = 0; i < numremoved; i++) FreeWatch(removed[i]);
+        }
+        if (bStop)
+            break;
+
+        handles[0] = This->hwake;
+        for (DWORD i = 0; i < numcurrent; i++) handles[i + 1] = current[i]->hchange;
+        DWORD rc = WaitForMultipleObjects(numcurrent + 1, handles, FALSE, INFINITE);
+        if (rc == WAIT_OBJECT_0 || rc < WAIT_OBJECT_0 + 1 || rc > WAIT_OBJECT_0 + numcurrent)
+            continue;
+        PRINTER_WATCH *w = current[rc - WAIT_OBJECT_0 - 1];
+        DWORD change = 0;
+        PRINTER_NOTIFY_INFO *pinfo = NULL;
+        BOOL bRefreshed = FALSE;
+        BOOL bOk = FindNextPrinterChangeNotification(w->hchange, &change, NULL, (LPVOID *)&pinfo);
+        if (bOk && pinfo && (pinfo->Flags & PRINTER_NOTIFY_INFO_DISCARDED)) {
+            FreePrinterNotifyInfo(pinfo);
+            pinfo = NULL;
+            bOk = FindNextPrinterChangeNotification(w->hchange, &change, &refresh, (LPVOID *)&pinfo);
+            bRefreshed = TRUE;
+        }
+        if (!bOk) {
+            // The notification is no good any more, so stop waiting on it rather than spin
+            EnterCriticalSection(&This->cs);
+            w->bRemoved = TRUE;
+            LeaveCriticalSection(&This->cs);
+        }
+        if (pinfo) {
+            CEnterLeavePython celp;
+            if (!This->AddChanges(w, pinfo, bRefreshed))
+                PyErr_Print();
+            FreePrinterNotifyInfo(pinfo);
+            SetEvent(This->hready);
+        }
+    }
+    CEnterLeavePython celp;
+    Py_DECREF(This);
+    return 0;
+}
+
+// @pymethod int|PyPRINTER_MONITOR|AddPrinter|Starts watching a printer
+// @rdesc Returns an id that can be passed to <om PyPRINTER_MONITOR.RemovePrinter>
+PyObject *PyPRINTER_MONITOR::AddPrinter(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"PrinterName", "Cookie", "JobFields", "PrinterFields", NULL};
+    PyPRINTER_MONITOR *This = (PyPRINTER_MONITOR *)self;
+    PyObject *obname, *obcookie = Py_None, *objobfields = Py_None, *obprinterfields = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "O|OOO:AddPrinter", keywords,
+            &obname,     // @pyparm str|PrinterName||Name of the printer or print server to watch
+            &obcookie,   // @pyparm object|Cookie|None|Identifies the printer in the changes.  Must be hashable.  If
+                         // None, the returned id is used.
+            &objobfields,  // @pyparm [int, ...]|JobFields|None|JOB_NOTIFY_FIELD_* values to watch, an empty list for
+                           // none, or None for the status, position, page and byte counts, and the names
+            &obprinterfields))  // @pyparm [int, ...]|PrinterFields|None|PRINTER_NOTIFY_FIELD_* values to watch, an
+                                // empty list for none, or None for the status, job count, attributes and names
+        return NULL;
+    if (This->bClosed)
+        return PyErr_Format(PyExc_ValueError, "The monitor has been closed");
+    TmpWCHAR name;
+    if (!PyWinObject_AsWCHAR(obname, &name))
+        return NULL;
+    if (obcookie != Py_None && PyObject_Hash(obcookie) == -1)
+        return NULL;
+
+    PRINTER_WATCH *w = (PRINTER_WATCH *)malloc(sizeof(PRINTER_WATCH));
+    if (w == NULL)
+        return PyErr_NoMemory();
+    ZeroMemory(w, sizeof(PRINTER_WATCH));
+    w->id = ++This->nextid;
+    if (obcookie == Py_None)
+        w->obcookie = PyLong_FromLong(w->id);
+    else {
+        Py_INCREF(obcookie);
+        w->obcookie = obcookie;
+    }
+    if (w->obcookie == NULL) {
+        FreeWatch(w);
+        return NULL;
+    }
+    w->options.Version = 2;
+    w->options.pTypes = w->types;
+    PyObject *obfields[2] = {objobfields, obprinterfields};
+    WORD types[2] = {JOB_NOTIFY_TYPE, PRINTER_NOTIFY_TYPE};
+    WORD *defaults[2] = {default_job_fields, default_printer_fields};
+    DWORD numdefaults[2] = {sizeof(default_job_fields) / sizeof(WORD), sizeof(default_printer_fields) / sizeof(WORD)};
+    for (int t = 0; t < 2; t++) {
+        PRINTER_NOTIFY_OPTIONS_TYPE *ptype = &w->types[w->options.Count];
+        DWORD count = numdefaults[t];
+        PyObject *obtuple = NULL;
+        if (obfields[t] != Py_None) {
+            obtuple = PyWinSequence_Tuple(obfields[t], &count);
+            if (obtuple == NULL) {
+                FreeWatch(w);
+                return NULL;
+            }
+        }
+        if (count == 0) {
+            Py_XDECREF(obtuple);
+            continue;
+        }
+        ptype->Type = types[t];
+        ptype->pFields = (PWORD)malloc(count * sizeof(WORD));
+        if (ptype->pFields == NULL) {
+            Py_XDECREF(obtuple);
+            FreeWatch(w);
+            return PyErr_NoMemory();
+        }
+        w->options.Count++;
+        ptype->Count = count;
+        for (DWORD i = 0; i < count; i++) {
+            if (obtuple == NULL) {
+                ptype->pFields[i] = defaults[t][i];
+                continue;
+            }
+            long field = PyLong_AsLong(PyTuple_GET_ITEM(obtuple, i));
+            if (field == -1 && PyErr_Occurred()) {
+                Py_DECREF(obtuple);
+                FreeWatch(w);
+                return NULL;
+            }
+            ptype->pFields[i] = (WORD)field;
+        }
+        Py_XDECREF(obtuple);
+    }
+    if (w->options.Count == 0) {
+        FreeWatch(w);
+        PyErr_SetString(PyExc_ValueError, "No fields to watch");
+        return NULL;
+    }
+
+    char *failed = NULL;
+    Py_BEGIN_ALLOW_THREADS;
+    if (!OpenPrinterW(name, &w->hprinter, NULL)) {
+        w->hprinter = NULL;
+        failed = "OpenPrinter";
+    }
+    else if ((w->hchange = FindFirstPrinterChangeNotification(w->hprinter, 0, 0, &w->options)) ==
+             INVALID_HANDLE_VALUE)
+        failed = "FindFirstPrinterChangeNotification";
+    Py_END_ALLOW_THREADS;
+    if (failed) {
+        PyWin_SetAPIError(failed);
+        FreeWatch(w);
+        return NULL;
+    }
+    EnterCriticalSection(&This->cs);
+    BOOL bFull = This->numwatches == MAX_PRINTER_WATCHES;
+    if (!bFull)
+        This->watches[This->numwatches++] = w;
+    LeaveCriticalSection(&This->cs);
+    if (bFull) {
+        FreeWatch(w);
+        return PyErr_Format(PyExc_ValueError, "A monitor can only watch %d printers", MAX_PRINTER_WATCHES);
+    }
+    SetEvent(This->hwake);
+    return PyLong_FromLong(w->id);
+}
+
+// @pymethod |PyPRINTER_MONITOR|RemovePrinter|Stops watching a printer
+// @comm Changes already collected for the printer are still returned by <om PyPRINTER_MONITOR.GetChanges>.
+PyObject *PyPRINTER_MONITOR::RemovePrinter(PyObject *self, PyObject *args)
+{
+    PyPRINTER_MONITOR *This = (PyPRINTER_MONITOR *)self;
+    LONG id;
+    // @pyparm int|id||The id returned by <om PyPRINTER_MONITOR.AddPrinter>
+    if (!PyArg_ParseTuple(args, "l:RemovePrinter", &id))
+        return NULL;
+    BOOL bFound = FALSE;
+    EnterCriticalSection(&This->cs);
+    for (DWORD i = 0; i < This->numwatches; i++)
+        if (This->watches[i]->id == id && !This->watches[i]->bRemoved) {
+            This->watches[i]->bRemoved = TRUE;
+            bFound = TRUE;
+        }
+    LeaveCriticalSection(&This->cs);
+    if (!bFound)
+        return PyErr_Format(PyExc_KeyError, "No printer with id %d", id);
+    SetEvent(This->hwake);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod [(object, int, int, dict), ...]|PyPRINTER_MONITOR|GetChanges|Waits for changes to the watched printers
+// and their jobs
+// @rdesc Returns a list of (Cookie, Type, Id, Fields) tuples, or an empty list if the timeout expires first.
+PyObject *PyPRINTER_MONITOR::GetChanges(PyObject *self, PyObject *args)
+{
+    PyPRINTER_MONITOR *This = (PyPRINTER_MONITOR *)self;
+    DWORD timeout = INFINITE;
+    // @pyparm int|Timeout|INFINITE|Number of milliseconds to wait if there are no changes already
+    if (!PyArg_ParseTuple(args, "|k:GetChanges", &timeout))
+        return NULL;
+    if (PyDict_Size(This->pending) == 0) {
+        if (This->bClosed)
+            return PyErr_Format(PyExc_ValueError, "The monitor has been closed");
+        // The thread only adds changes with the GIL held, after which it sets the event
+        DWORD start = GetTickCount();
+        while (PyDict_Size(This->pending) == 0) {
+            DWORD elapsed = GetTickCount() - start, wait = INFINITE;
+            if (timeout != INFINITE) {
+                if (elapsed >= timeout)
+                    break;
+                wait = timeout - elapsed;
+            }
+            Py_BEGIN_ALLOW_THREADS WaitForSingleObject(This->hready, wait);
+            Py_END_ALLOW_THREADS
+        }
+    }
+    PyObject *ret = PyList_New(0);
+    if (ret == NULL)
+        return NULL;
+    Py_ssize_t pos = 0;
+    PyObject *key, *fields;
+    while (PyDict_Next(This->pending, &pos, &key, &fields)) {
+        PyObject *item = Py_BuildValue("OOOO", PyTuple_GET_ITEM(key, 0), PyTuple_GET_ITEM(key, 1),
+                                       PyTuple_GET_ITEM(key, 2), fields);
+        if (item == NULL || PyList_Append(ret, item) == -1) {
+            Py_XDECREF(item);
+            Py_DECREF(ret);
+            return NULL;
+        }
+        Py_DECREF(item);
+    }
+    PyDict_Clear(This->pending);
+    return ret;
+}
+
+// @pymethod |PyPRINTER_MONITOR|Close|Stops the monitor thread and closes all the notifications
+PyObject *PyPRINTER_MONITOR::Close(PyObject *self, PyObject *args)
+{
+    PyPRINTER_MONITOR *This = (PyPRINTER_MONITOR *)self;
+    if (!PyArg_ParseTuple(args, ":Close"))
+        return NULL;
+    if (!This->bClosed) {
+        This->bClosed = TRUE;
+        EnterCriticalSection(&This->cs);
+        This->bStop = TRUE;
+        LeaveCriticalSection(&This->cs);
+        SetEvent(This->hwake);
+        Py_BEGIN_ALLOW_THREADS WaitForSingleObject(This->hthread, INFINITE);
+        Py_END_ALLOW_THREADS
+    }
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod <o PyPRINTER_MONITOR>|win32print|PrinterChangeMonitor|Creates an object that watches many printers for
+// changes, using a single thread
+static PyObject *PyPrinterChangeMonitor(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":PrinterChangeMonitor"))
+        return NULL;
+    PyPRINTER_MONITOR *ret = new PyPRINTER_MONITOR();
+    if (ret == NULL)
+        return PyErr_NoMemory();
+    ret->pending = PyDict_New();
+    if (ret->pending == NULL) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    if ((ret->hwake = CreateEvent(NULL, FALSE, FALSE, NULL)) == NULL ||
+        (ret->hready = CreateEvent(NULL, FALSE, FALSE, NULL)) == NULL) {
+        PyWin_SetAPIError("CreateEvent");
+        Py_DECREF(ret);
+        return NULL;
+    }
+    // The thread's reference is released when it exits
+    Py_INCREF(ret);
+    ret->hthread = CreateThread(NULL, 0, PyPRINTER_MONITOR::Worker, ret, 0, NULL);
+    if (ret->hthread == NULL) {
+        PyWin_SetAPIError("CreateThread");
+        ret->bClosed = TRUE;
+        Py_DECREF(ret);
+        Py_DECREF(ret);
+        return NULL;
+    }
+    return ret;
+}
+
 /* List of functions exported by this module */
 // @module win32print|A module encapsulating the Windows printing API.
 static struct PyMethodDef win32print_functions[] = {
@@ -2593,6 +3649,10 @@ static struct PyMethodDef win32print_functions[] = {
     {"DeletePrinterDriverEx", PyDeletePrinterDriverEx,
      1},                                  //@pymeth DeletePrinterDriverEx|Deletes a printer driver and associated files
     {"FlushPrinter", PyFlushPrinter, 1},  //@pymeth FlushPrinter|Clears printer from error state if WritePrinter fails
+    {"PrintJobStream", pfnPyPrintJobStream,
+     METH_VARARGS | METH_KEYWORDS},  //@pymeth PrintJobStream|Starts a print job fed by a background thread
+    {"PrinterChangeMonitor", PyPrinterChangeMonitor,
+     1},  //@pymeth PrinterChangeMonitor|Creates an object that watches many printers for changes
     {NULL}};
 
 static void AddConstant(PyObject *dict, char *name, long val)
@@ -2768,6 +3828,61 @@ PYWIN_MODULE_INIT_FUNC(win32print)
     AddConstant(dict, "PORT_STATUS_TYPE_WARNING", PORT_STATUS_TYPE_WARNING);
     AddConstant(dict, "PORT_STATUS_TYPE_INFO", PORT_STATUS_TYPE_INFO);
 
+    // Notification types and fields used with PrinterChangeMonitor
+    AddConstant(dict, "PRINTER_NOTIFY_TYPE", PRINTER_NOTIFY_TYPE);
+    AddConstant(dict, "JOB_NOTIFY_TYPE", JOB_NOTIFY_TYPE);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_SERVER_NAME", PRINTER_NOTIFY_FIELD_SERVER_NAME);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_PRINTER_NAME", PRINTER_NOTIFY_FIELD_PRINTER_NAME);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_SHARE_NAME", PRINTER_NOTIFY_FIELD_SHARE_NAME);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_PORT_NAME", PRINTER_NOTIFY_FIELD_PORT_NAME);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_DRIVER_NAME", PRINTER_NOTIFY_FIELD_DRIVER_NAME);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_COMMENT", PRINTER_NOTIFY_FIELD_COMMENT);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_LOCATION", PRINTER_NOTIFY_FIELD_LOCATION);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_DEVMODE", PRINTER_NOTIFY_FIELD_DEVMODE);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_SEPFILE", PRINTER_NOTIFY_FIELD_SEPFILE);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_PRINT_PROCESSOR", PRINTER_NOTIFY_FIELD_PRINT_PROCESSOR);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_PARAMETERS", PRINTER_NOTIFY_FIELD_PARAMETERS);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_DATATYPE", PRINTER_NOTIFY_FIELD_DATATYPE);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_SECURITY_DESCRIPTOR", PRINTER_NOTIFY_FIELD_SECURITY_DESCRIPTOR);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_ATTRIBUTES", PRINTER_NOTIFY_FIELD_ATTRIBUTES);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_PRIORITY", PRINTER_NOTIFY_FIELD_PRIORITY);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_DEFAULT_PRIORITY", PRINTER_NOTIFY_FIELD_DEFAULT_PRIORITY);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_START_TIME", PRINTER_NOTIFY_FIELD_START_TIME);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_UNTIL_TIME", PRINTER_NOTIFY_FIELD_UNTIL_TIME);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_STATUS", PRINTER_NOTIFY_FIELD_STATUS);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_STATUS_STRING", PRINTER_NOTIFY_FIELD_STATUS_STRING);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_CJOBS", PRINTER_NOTIFY_FIELD_CJOBS);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_AVERAGE_PPM", PRINTER_NOTIFY_FIELD_AVERAGE_PPM);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_TOTAL_PAGES", PRINTER_NOTIFY_FIELD_TOTAL_PAGES);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_PAGES_PRINTED", PRINTER_NOTIFY_FIELD_PAGES_PRINTED);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_TOTAL_BYTES", PRINTER_NOTIFY_FIELD_TOTAL_BYTES);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_BYTES_PRINTED", PRINTER_NOTIFY_FIELD_BYTES_PRINTED);
+    AddConstant(dict, "PRINTER_NOTIFY_FIELD_OBJECT_GUID", PRINTER_NOTIFY_FIELD_OBJECT_GUID);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_PRINTER_NAME", JOB_NOTIFY_FIELD_PRINTER_NAME);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_MACHINE_NAME", JOB_NOTIFY_FIELD_MACHINE_NAME);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_PORT_NAME", JOB_NOTIFY_FIELD_PORT_NAME);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_USER_NAME", JOB_NOTIFY_FIELD_USER_NAME);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_NOTIFY_NAME", JOB_NOTIFY_FIELD_NOTIFY_NAME);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_DATATYPE", JOB_NOTIFY_FIELD_DATATYPE);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_PRINT_PROCESSOR", JOB_NOTIFY_FIELD_PRINT_PROCESSOR);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_PARAMETERS", JOB_NOTIFY_FIELD_PARAMETERS);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_DRIVER_NAME", JOB_NOTIFY_FIELD_DRIVER_NAME);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_DEVMODE", JOB_NOTIFY_FIELD_DEVMODE);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_STATUS", JOB_NOTIFY_FIELD_STATUS);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_STATUS_STRING", JOB_NOTIFY_FIELD_STATUS_STRING);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_SECURITY_DESCRIPTOR", JOB_NOTIFY_FIELD_SECURITY_DESCRIPTOR);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_DOCUMENT", JOB_NOTIFY_FIELD_DOCUMENT);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_PRIORITY", JOB_NOTIFY_FIELD_PRIORITY);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_POSITION", JOB_NOTIFY_FIELD_POSITION);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_SUBMITTED", JOB_NOTIFY_FIELD_SUBMITTED);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_START_TIME", JOB_NOTIFY_FIELD_START_TIME);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_UNTIL_TIME", JOB_NOTIFY_FIELD_UNTIL_TIME);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_TIME", JOB_NOTIFY_FIELD_TIME);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_TOTAL_PAGES", JOB_NOTIFY_FIELD_TOTAL_PAGES);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_PAGES_PRINTED", JOB_NOTIFY_FIELD_PAGES_PRINTED);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_TOTAL_BYTES", JOB_NOTIFY_FIELD_TOTAL_BYTES);
+    AddConstant(dict, "JOB_NOTIFY_FIELD_BYTES_PRINTED", JOB_NOTIFY_FIELD_BYTES_PRINTED);
+
     HMODULE hmodule = LoadLibrary(TEXT("winspool.drv"));
     if (hmodule != NULL) {
         pfnEnumForms = (EnumFormsfunc)GetProcAddress(hmodule, "EnumFormsW");
@@ -2789,6 +3904,8 @@ PYWIN_MODULE_INIT_FUNC(win32print)
         pfnSetDefaultPrinter = (SetDefaultPrinterfunc)GetProcAddress(hmodule, "SetDefaultPrinterW");
     }
     dummy_tuple = PyTuple_New(0);
+    if (PyType_Ready(&PyPRINTJOB_STREAMType) == -1 || PyType_Ready(&PyPRINTER_MONITORType) == -1)
+        PYWIN_MODULE_INIT_RETURN_ERROR;
 
     PYWIN_MODULE_INIT_RETURN_SUCCESS;
 }
@@ -9,6 +9,9 @@
 #include "windows.h"
 #include "Psapi.h"
 #include "PyWinTypes.h"
+#ifndef MS_WINCE
+#include "win32process_threadpool.h"
+#endif
 %}
 
 %include "typemaps.i"
@@ -1444,6 +1447,315 @@ PyObject *PyGetProcessIoCounters(PyObject *self, PyObject *args)
 }
 %}
 
+// GetProcessSnapshot support.  SYSTEM_PROCESS_INFORMATION is only partly declared
+// in winternl.h, so the full (long stable) layout is declared here.
+%{
+typedef LONG (WINAPI *NtQuerySystemInformationfunc)(int, PVOID, ULONG, PULONG);
+static NtQuerySystemInformationfunc pfnNtQuerySystemInformation = NULL;
+typedef BOOL (WINAPI *QueryFullProcessImageNameWfunc)(HANDLE, DWORD, LPWSTR, PDWORD);
+static QueryFullProcessImageNameWfunc pfnQueryFullProcessImageNameW = NULL;
+
+#define PYSYSTEM_PROCESS_INFORMATION_CLASS 5
+#define PYSTATUS_INFO_LENGTH_MISMATCH ((LONG)0xC0000004L)
+#ifndef PROCESS_QUERY_LIMITED_INFORMATION
+#define PROCESS_QUERY_LIMITED_INFORMATION 0x1000
+#endif
+
+typedef struct {
+	ULONG NextEntryOffset;
+	ULONG NumberOfThreads;
+	LARGE_INTEGER WorkingSetPrivateSize;
+	ULONG HardFaultCount;
+	ULONG NumberOfThreadsHighWatermark;
+	ULONGLONG CycleTime;
+	LARGE_INTEGER CreateTime;
+	LARGE_INTEGER UserTime;
+	LARGE_INTEGER KernelTime;
+	USHORT ImageNameLength;	// A UNICODE_STRING
+	USHORT ImageNameMaximumLength;
+	PWSTR ImageNameBuffer;
+	LONG BasePriority;
+	HANDLE UniqueProcessId;
+	HANDLE InheritedFromUniqueProcessId;
+	ULONG HandleCount;
+	ULONG SessionId;
+	ULONG_PTR UniqueProcessKey;
+	SIZE_T PeakVirtualSize;
+	SIZE_T VirtualSize;
+	ULONG PageFaultCount;
+	SIZE_T PeakWorkingSetSize;
+	SIZE_T WorkingSetSize;
+	SIZE_T QuotaPeakPagedPoolUsage;
+	SIZE_T QuotaPagedPoolUsage;
+	SIZE_T QuotaPeakNonPagedPoolUsage;
+	SIZE_T QuotaNonPagedPoolUsage;
+	SIZE_T PagefileUsage;
+	SIZE_T PeakPagefileUsage;
+	SIZE_T PrivatePageCount;
+	LARGE_INTEGER ReadOperationCount;
+	LARGE_INTEGER WriteOperationCount;
+	LARGE_INTEGER OtherOperationCount;
+	LARGE_INTEGER ReadTransferCount;
+	LARGE_INTEGER WriteTransferCount;
+	LARGE_INTEGER OtherTransferCount;
+} PYSYSTEM_PROCESS_INFORMATION;
+
+#define SNAP_ULONG 0
+#define SNAP_LONG 1
+#define SNAP_SIZE 2
+#define SNAP_LONGLONG 3
+#define SNAP_PID 4
+#define SNAP_NAME 5
+#define SNAP_PATH 6		// not in the structure - needs a handle to each process
+
+typedef struct {
+	const char *name;
+	size_t offset;
+	int type;
+	BOOL bDefault;
+} PySnapshotField;
+
+#define SNAP_FIELD(name, type) {#name, offsetof(PYSYSTEM_PROCESS_INFORMATION, name), type, TRUE}
+static PySnapshotField snapshotFields[] = {
+	{"ProcessId", offsetof(PYSYSTEM_PROCESS_INFORMATION, UniqueProcessId), SNAP_PID, TRUE},
+	{"ParentProcessId", offsetof(PYSYSTEM_PROCESS_INFORMATION, InheritedFromUniqueProcessId), SNAP_PID, TRUE},
+	{"ImageName", 0, SNAP_NAME, TRUE},
+	SNAP_FIELD(SessionId, SNAP_ULONG),
+	SNAP_FIELD(BasePriority, SNAP_LONG),
+	SNAP_FIELD(NumberOfThreads, SNAP_ULONG),
+	SNAP_FIELD(HandleCount, SNAP_ULONG),
+	SNAP_FIELD(CreateTime, SNAP_LONGLONG),
+	SNAP_FIELD(UserTime, SNAP_LONGLONG),
+	SNAP_FIELD(KernelTime, SNAP_LONGLONG),
+	SNAP_FIELD(CycleTime, SNAP_LONGLONG),
+	SNAP_FIELD(VirtualSize, SNAP_SIZE),
+	SNAP_FIELD(PeakVirtualSize, SNAP_SIZE),
+	SNAP_FIELD(PageFaultCount, SNAP_ULONG),
+	SNAP_FIELD(HardFaultCount, SNAP_ULONG),
+	SNAP_FIELD(WorkingSetSize, SNAP_SIZE),
+	SNAP_FIELD(PeakWorkingSetSize, SNAP_SIZE),
+	SNAP_FIELD(WorkingSetPrivateSize, SNAP_LONGLONG),
+	SNAP_FIELD(QuotaPagedPoolUsage, SNAP_SIZE),
+	SNAP_FIELD(QuotaPeakPagedPoolUsage, SNAP_SIZE),
+	SNAP_FIELD(QuotaNonPagedPoolUsage, SNAP_SIZE),
+	SNAP_FIELD(QuotaPeakNonPagedPoolUsage, SNAP_SIZE),
+	SNAP_FIELD(PagefileUsage, SNAP_SIZE),
+	SNAP_FIELD(PeakPagefileUsage, SNAP_SIZE),
+	SNAP_FIELD(PrivatePageCount, SNAP_SIZE),
+	SNAP_FIELD(ReadOperationCount, SNAP_LONGLONG),
+	SNAP_FIELD(WriteOperationCount, SNAP_LONGLONG),
+	SNAP_FIELD(OtherOperationCount, SNAP_LONGLONG),
+	SNAP_FIELD(ReadTransferCount, SNAP_LONGLONG),
+	SNAP_FIELD(WriteTransferCount, SNAP_LONGLONG),
+	SNAP_FIELD(OtherTransferCount, SNAP_LONGLONG),
+	{"ImagePath", 0, SNAP_PATH, FALSE},
+	{NULL}
+};
+#undef SNAP_FIELD
+
+// The size of the last snapshot, so a periodic caller normally needs one system call.
+static ULONG snapshotBufSize = 256 * 1024;
+
+static PyObject *MakeSnapshotColumn(PySnapshotField *field, PYSYSTEM_PROCESS_INFORMATION **procs, ULONG num, WCHAR **paths)
+{
+	PyObject *ret = PyList_New(num);
+	if (ret == NULL)
+		return NULL;
+	for (ULONG i=0;i<num;i++) {
+		BYTE *p = (BYTE *)procs[i] + field->offset;
+		PyObject *item;
+		switch (field->type) {
+			case SNAP_ULONG:
+				item = PyLong_FromUnsignedLong(*(ULONG *)p);
+				break;
+			case SNAP_LONG:
+				item = PyLong_FromLong(*(LONG *)p);
+				break;
+			case SNAP_SIZE:
+				item = PyLong_FromSize_t(*(SIZE_T *)p);
+				break;
+			case SNAP_LONGLONG:
+				item = PyLong_FromLongLong(*(LONGLONG *)p);
+				break;
+			case SNAP_PID:
+				item = PyLong_FromUnsignedLong((ULONG)(ULONG_PTR)*(HANDLE *)p);
+				break;
+			case SNAP_NAME:
+				if (procs[i]->ImageNameBuffer == NULL) {
+					// The idle process
+					Py_INCREF(Py_None);
+					item = Py_None;
+				}
+				else
+					item = PyWinObject_FromWCHAR(procs[i]->ImageNameBuffer, procs[i]->ImageNameLength / sizeof(WCHAR));
+				break;
+			default:	// SNAP_PATH
+				if (paths[i] == NULL) {
+					Py_INCREF(Py_None);
+					item = Py_None;
+				}
+				else
+					item = PyWinObject_FromWCHAR(paths[i]);
+				break;
+		}
+		if (item == NULL) {
+			Py_DECREF(ret);
+			return NULL;
+		}
+		PyList_SET_ITEM(ret, i, item);
+	}
+	return ret;
+}
+
+// @pyswig dict|GetProcessSnapshot|Returns information about all running processes in a single call.
+// @rdesc A dict mapping each requested field name to a list, with one entry per process - the
+// entries at the same index in each list describe the same process.
+// @comm The information comes from a single NtQuerySystemInformation(SystemProcessInformation)
+// call, so no process handles are opened, and processes which the caller can not open are
+// included.  The exception is the ImagePath field, which needs a handle to each process -
+// it is None for processes which can not be opened.
+// <nl>The available fields are ProcessId, ParentProcessId, ImageName (the file name of the
+// executable, None for the idle process), SessionId, BasePriority, NumberOfThreads, HandleCount,
+// CreateTime (as an integer FILETIME), UserTime and KernelTime (in 100 nanosecond units),
+// CycleTime, the memory counters returned by <om win32process.GetProcessMemoryInfo>,
+// VirtualSize, PeakVirtualSize, HardFaultCount, WorkingSetPrivateSize, PrivatePageCount,
+// the I/O counters returned by <om win32process.GetProcessIoCounters>, and ImagePath (the full
+// path of the executable).  By default, all fields except ImagePath are returned.
+// <nl>The snapshot is not atomic with respect to process creation and exit, any more than
+// <om win32process.EnumProcesses> is.
+static PyObject *PyGetProcessSnapshot(PyObject *self, PyObject *args)
+{
+	CHECK_PFN(NtQuerySystemInformation);
+	PyObject *obFields = Py_None;
+	// @pyparm [str, ...]|fields|None|The names of the fields to return.  If None, all fields except ImagePath are returned.
+	if (!PyArg_ParseTuple(args, "|O:GetProcessSnapshot", &obFields))
+		return NULL;
+
+	const int numFields = sizeof(snapshotFields) / sizeof(snapshotFields[0]) - 1;
+	BOOL wanted[sizeof(snapshotFields) / sizeof(snapshotFields[0])];
+	BOOL bPaths = FALSE;
+	int i;
+	for (i=0;i<numFields;i++)
+		wanted[i] = obFields == Py_None && snapshotFields[i].bDefault;
+	if (obFields != Py_None) {
+		TmpPyObject seq = PyWinSequence_Tuple(obFields, NULL);
+		if (seq == NULL)
+			return NULL;
+		for (Py_ssize_t j=0;j<PyTuple_GET_SIZE((PyObject *)seq);j++) {
+			PyObject *obName = PyTuple_GET_ITEM((PyObject *)seq, j);
+			const char *name = PyUnicode_Check(obName) ? PyUnicode_AsUTF8(obName) : NULL;
+			if (name == NULL) {
+				if (!PyErr_Occurred())
+					PyErr_Format(PyExc_TypeError, "Field names must be strings, not %s", obName->ob_type->tp_name);
+				return NULL;
+			}
+			for (i=0;i<numFields;i++)
+				if (strcmp(name, snapshotFields[i].name) == 0)
+					break;
+			if (i == numFields)
+				return PyErr_Format(PyExc_ValueError, "Unknown process snapshot field '%s'", name);
+			wanted[i] = TRUE;
+		}
+	}
+	for (i=0;i<numFields;i++)
+		if (wanted[i] && snapshotFields[i].type == SNAP_PATH)
+			bPaths = TRUE;
+
+	BYTE *buf = NULL;
+	PYSYSTEM_PROCESS_INFORMATION **procs = NULL;
+	WCHAR **paths = NULL;
+	ULONG num = 0, size, k;
+	LONG status;
+	PyObject *ret = NULL;
+	Py_BEGIN_ALLOW_THREADS
+	size = snapshotBufSize;
+	for (;;) {
+		buf = (BYTE *)malloc(size);
+		if (buf == NULL) {
+			status = PYSTATUS_INFO_LENGTH_MISMATCH;
+			break;
+		}
+		ULONG needed = 0;
+		status = (*pfnNtQuerySystemInformation)(PYSYSTEM_PROCESS_INFORMATION_CLASS, buf, size, &needed);
+		if (status != PYSTATUS_INFO_LENGTH_MISMATCH)
+			break;
+		free(buf);
+		buf = NULL;
+		// Leave room for processes started since the size was returned.
+		size = (needed > size ? needed : size * 2) + 16 * 1024;
+	}
+	if (status == 0) {
+		snapshotBufSize = size;
+		for (BYTE *p = buf;; p += ((PYSYSTEM_PROCESS_INFORMATION *)p)->NextEntryOffset) {
+			num++;
+			if (((PYSYSTEM_PROCESS_INFORMATION *)p)->NextEntryOffset == 0)
+				break;
+		}
+		procs = (PYSYSTEM_PROCESS_INFORMATION **)malloc(num * sizeof(PYSYSTEM_PROCESS_INFORMATION *));
+		if (procs) {
+			BYTE *p = buf;
+			for (k=0;k<num;k++) {
+				procs[k] = (PYSYSTEM_PROCESS_INFORMATION *)p;
+				p += procs[k]->NextEntryOffset;
+			}
+		}
+		if (procs && bPaths) {
+			paths = (WCHAR **)calloc(num, sizeof(WCHAR *));
+			for (k=0;paths && pfnQueryFullProcessImageNameW && k<num;k++) {
+				HANDLE h = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, (DWORD)(ULONG_PTR)procs[k]->UniqueProcessId);
+				if (h == NULL)
+					continue;
+				WCHAR path[MAX_PATH * 4];
+				DWORD len = sizeof(path) / sizeof(path[0]);
+				if ((*pfnQueryFullProcessImageNameW)(h, 0, path, &len)) {
+					paths[k] = (WCHAR *)malloc((len + 1) * sizeof(WCHAR));
+					if (paths[k])
+						memcpy(paths[k], path, (len + 1) * sizeof(WCHAR));
+				}
+				CloseHandle(h);
+			}
+		}
+	}
+	Py_END_ALLOW_THREADS
+
+	if (buf == NULL)
+		return PyErr_NoMemory();
+	if (status != 0) {
+		free(buf);
+		return PyWin_SetAPIError("NtQuerySystemInformation", status);
+	}
+	if (procs == NULL || (bPaths && paths == NULL)) {
+		PyErr_NoMemory();
+		goto done;
+	}
+	ret = PyDict_New();
+	if (ret == NULL)
+		goto done;
+	for (i=0;i<numFields;i++) {
+		if (!wanted[i])
+			continue;
+		PyObject *column = MakeSnapshotColumn(&snapshotFields[i], procs, num, paths);
+		if (column == NULL || PyDict_SetItemString(ret, snapshotFields[i].name, column) == -1) {
+			Py_XDECREF(column);
+			Py_DECREF(ret);
+			ret = NULL;
+			goto done;
+		}
+		Py_DECREF(column);
+	}
+done:
+	if (paths) {
+		for (k=0;k<num;k++)
+			free(paths[k]);
+		free(paths);
+	}
+	free(procs);
+	free(buf);
+	return ret;
+}
+%}
+%native(GetProcessSnapshot) PyGetProcessSnapshot;
+
 // @pyswig |GetProcessWindowStation|Returns a handle to the window station for the calling process
 %native(GetProcessWindowStation) PyGetProcessWindowStation;
 %{
@@ -1703,6 +2015,626 @@ PyObject *PyWriteProcessMemory(PyObject *self, PyObject *args)
 }
 %}
 
+// @object PyProcessLauncher|Starts batches of processes in a job, and reports their exits
+// through the job's I/O completion port, as returned by <om win32process.CreateProcessLauncher>.
+// @comm <om PyProcessLauncher.Launch> creates every process in a batch with one call, and
+// only the handles passed to it are inherited - the list is given to CreateProcess with
+// PROC_THREAD_ATTRIBUTE_HANDLE_LIST, so handles which happen to be inheritable in this
+// process, such as other children's pipes, are not leaked to the new processes.
+// <nl>The processes are created suspended and added to the launcher's job before they run,
+// so they and any processes they start are all in the job.  Exits are reported by
+// <om PyProcessLauncher.GetExits>, which dequeues the job's notifications, so no handle
+// needs to be waited on per process.  The launcher keeps a handle to each process until its
+// exit has been reported, so process ids are not reused while they may still be reported.
+%{
+#ifndef EXTENDED_STARTUPINFO_PRESENT
+#define EXTENDED_STARTUPINFO_PRESENT 0x00080000
+#endif
+#define PY_PROC_THREAD_ATTRIBUTE_HANDLE_LIST 0x00020002
+
+// STARTUPINFOEX and the attribute list functions are only declared for Vista and later.
+typedef struct {
+	STARTUPINFO StartupInfo;
+	void *lpAttributeList;
+} PySTARTUPINFOEX;
+
+typedef BOOL (WINAPI *InitializeProcThreadAttributeListfunc)(void *, DWORD, DWORD, PSIZE_T);
+static InitializeProcThreadAttributeListfunc pfnInitializeProcThreadAttributeList = NULL;
+typedef BOOL (WINAPI *UpdateProcThreadAttributefunc)(void *, DWORD, DWORD_PTR, PVOID, SIZE_T, PVOID, PSIZE_T);
+static UpdateProcThreadAttributefunc pfnUpdateProcThreadAttribute = NULL;
+typedef void (WINAPI *DeleteProcThreadAttributeListfunc)(void *);
+static DeleteProcThreadAttributeListfunc pfnDeleteProcThreadAttributeList = NULL;
+
+typedef struct {
+	ULONG_PTR lpCompletionKey;
+	LPOVERLAPPED lpOverlapped;
+	ULONG_PTR Internal;
+	DWORD dwNumberOfBytesTransferred;
+} PyPROC_OVERLAPPED_ENTRY;
+typedef BOOL (WINAPI *GetQueuedCompletionStatusExfunc)(HANDLE, PyPROC_OVERLAPPED_ENTRY *, ULONG, PULONG, DWORD, BOOL);
+static GetQueuedCompletionStatusExfunc pfnGetQueuedCompletionStatusEx = NULL;
+
+// The completion key the job is associated with.
+#define PROCESSLAUNCHER_KEY 1
+
+typedef struct {
+	PyObject_HEAD
+	HANDLE hJob;
+	HANDLE hPort;
+	// pid -> process handle of each process launched whose exit hasn't been reported.
+	PyObject *processes;
+	// pid -> process handle of processes terminated by a failed Launch, until their exits are seen.
+	PyObject *discarded;
+	LONG launched;		// statistics
+	LONG exited;
+	LONG batches;
+} PyProcessLauncher;
+
+extern PyTypeObject PyProcessLauncher_Type;
+
+static void pl_close_handles(PyObject *dict)
+{
+	Py_ssize_t pos = 0;
+	PyObject *obPid, *obHandle;
+	while (PyDict_Next(dict, &pos, &obPid, &obHandle)) {
+		HANDLE h;
+		if (PyWinObject_AsHANDLE(obHandle, &h))
+			CloseHandle(h);
+		else
+			PyErr_Clear();
+	}
+	PyDict_Clear(dict);
+}
+
+static void pl_close(PyProcessLauncher *pl)
+{
+	if (pl->hJob) {
+		CloseHandle(pl->hJob);
+		pl->hJob = NULL;
+	}
+	if (pl->hPort) {
+		CloseHandle(pl->hPort);
+		pl->hPort = NULL;
+	}
+	if (pl->processes)
+		pl_close_handles(pl->processes);
+	if (pl->discarded)
+		pl_close_handles(pl->discarded);
+}
+
+static void pl_dealloc(PyObject *ob)
+{
+	PyProcessLauncher *pl = (PyProcessLauncher *)ob;
+	pl_close(pl);
+	Py_XDECREF(pl->processes);
+	Py_XDECREF(pl->discarded);
+	PyObject_Del(ob);
+}
+
+// Add a handle to the handle list, unless it is already there.
+static void pl_add_handle(HANDLE *handles, DWORD *pNum, HANDLE h)
+{
+	if (h == NULL || h == INVALID_HANDLE_VALUE)
+		return;
+	for (DWORD i = 0; i < *pNum; i++)
+		if (handles[i] == h)
+			return;
+	handles[(*pNum)++] = h;
+}
+
+// Records a launched process, or one being discarded, in one of the dicts.  The
+// handle is only closed once the process is removed again.
+static BOOL pl_track(PyObject *dict, DWORD pid, HANDLE hProcess)
+{
+	PyObject *obPid = PyLong_FromUnsignedLong(pid);
+	PyObject *obHandle = PyWinLong_FromHANDLE(hProcess);
+	int rc = obPid && obHandle ? PyDict_SetItem(dict, obPid, obHandle) : -1;
+	Py_XDECREF(obPid);
+	Py_XDECREF(obHandle);
+	return rc == 0;
+}
+
+static void pl_untrack(PyObject *dict, DWORD pid)
+{
+	PyObject *exc_type, *exc_value, *exc_tb;
+	PyErr_Fetch(&exc_type, &exc_value, &exc_tb);
+	PyObject *obPid = PyLong_FromUnsignedLong(pid);
+	if (obPid == NULL || PyDict_DelItem(dict, obPid) == -1)
+		PyErr_Clear();
+	Py_XDECREF(obPid);
+	PyErr_Restore(exc_type, exc_value, exc_tb);
+}
+
+// @pymethod [int, ...]|PyProcessLauncher|Launch|Creates a batch of processes.
+// @rdesc The process ids of the new processes, in the order of the command lines.
+// @comm Accepts keyword args.
+// @comm The batch succeeds or fails as a whole.  If any process can not be created, those
+// already created are terminated before they have run, and the error is raised.
+// <nl>The handles to inherit must be inheritable - see <om win32api.SetHandleInformation>.
+// If startupInfo has STARTF_USESTDHANDLES set, its standard handles are inherited too.  If no
+// handles are given, nothing is inherited.
+static PyObject *pl_Launch(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	PyProcessLauncher *pl = (PyProcessLauncher *)self;
+	static char *keywords[] = {"commandLines", "appName", "currentDirectory", "environment",
+		"startupInfo", "inheritHandles", "creationFlags", NULL};
+	PyObject *obCommandLines, *obAppName = Py_None, *obDirectory = Py_None, *obEnv = Py_None;
+	PyObject *obStartupInfo = Py_None, *obHandles = Py_None;
+	DWORD creationFlags = 0;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|OOOOOk:Launch", keywords,
+		&obCommandLines, // @pyparm [str, ...]|commandLines||The command line of each process to create.
+		&obAppName, // @pyparm str|appName|None|The executable for every process, or None to take it from each command line.
+		&obDirectory, // @pyparm str|currentDirectory|None|The current directory of the processes, or None for the current directory of this process.
+		&obEnv, // @pyparm dict|environment|None|The environment of the processes, as for <om win32process.CreateProcess>, or None to inherit this process's environment.
+		&obStartupInfo, // @pyparm <o PySTARTUPINFO>|startupInfo|None|How the processes should start up.
+		&obHandles, // @pyparm [<o PyHANDLE>, ...]|inheritHandles|None|The only handles the processes inherit.
+		&creationFlags)) // @pyparm int|creationFlags|0|The flags for CreateProcess.  CREATE_SUSPENDED is not allowed.
+		return NULL;
+	if (pl->hJob == NULL)
+		return PyErr_Format(PyExc_ValueError, "The launcher has been closed");
+	if (creationFlags & CREATE_SUSPENDED)
+		return PyErr_Format(PyExc_ValueError, "CREATE_SUSPENDED can not be used with a launcher");
+	STARTUPINFO *psi;
+	if (!PyWinObject_AsSTARTUPINFO(obStartupInfo, &psi, TRUE))
+		return NULL;
+	DWORD num, numHandles = 0, numPassed = 0, i;
+	TmpPyObject seqCommandLines = PyWinSequence_Tuple(obCommandLines, &num);
+	if (seqCommandLines == NULL)
+		return NULL;
+	TmpPyObject seqHandles;
+	if (obHandles != Py_None) {
+		seqHandles = PyWinSequence_Tuple(obHandles, &numPassed);
+		if (seqHandles == NULL)
+			return NULL;
+	}
+
+	PyObject *ret = NULL;
+	TCHAR *appName = NULL, *directory = NULL;
+	TCHAR **commandLines = NULL;
+	HANDLE *handles = NULL;
+	PROCESS_INFORMATION *pis = NULL;
+	LPVOID pEnv = NULL;
+	BOOL bEnvIsUnicode;
+	void *attrs = NULL;
+	PySTARTUPINFOEX si;
+	DWORD created = 0, assigned = 0, err = 0;
+	const char *fn = NULL;
+	ZeroMemory(&si, sizeof(si));
+	if (psi)
+		memcpy(&si.StartupInfo, psi, sizeof(STARTUPINFO));
+	si.StartupInfo.cb = sizeof(STARTUPINFO);
+
+	if (!PyWinObject_AsTCHAR(obAppName, &appName, TRUE) || !PyWinObject_AsTCHAR(obDirectory, &directory, TRUE))
+		goto done;
+	commandLines = (TCHAR **)calloc(num ? num : 1, sizeof(TCHAR *));
+	handles = (HANDLE *)malloc((numPassed + 3) * sizeof(HANDLE));
+	pis = (PROCESS_INFORMATION *)calloc(num ? num : 1, sizeof(PROCESS_INFORMATION));
+	if (commandLines == NULL || handles == NULL || pis == NULL) {
+		PyErr_NoMemory();
+		goto done;
+	}
+	for (i = 0; i < num; i++)
+		if (!PyWinObject_AsTCHAR(PyTuple_GET_ITEM((PyObject *)seqCommandLines, i), &commandLines[i], FALSE))
+			goto done;
+	for (i = 0; i < numPassed; i++) {
+		HANDLE h;
+		if (!PyWinObject_AsHANDLE(PyTuple_GET_ITEM((PyObject *)seqHandles, i), &h))
+			goto done;
+		pl_add_handle(handles, &numHandles, h);
+	}
+	if (si.StartupInfo.dwFlags & STARTF_USESTDHANDLES) {
+		pl_add_handle(handles, &numHandles, si.StartupInfo.hStdInput);
+		pl_add_handle(handles, &numHandles, si.StartupInfo.hStdOutput);
+		pl_add_handle(handles, &numHandles, si.StartupInfo.hStdError);
+	}
+	if (numHandles) {
+		if (pfnInitializeProcThreadAttributeList == NULL || pfnUpdateProcThreadAttribute == NULL) {
+			PyErr_Format(PyExc_NotImplementedError, "Inheriting a list of handles is not available on this platform");
+			goto done;
+		}
+		SIZE_T attrSize = 0;
+		(*pfnInitializeProcThreadAttributeList)(NULL, 1, 0, &attrSize);
+		attrs = malloc(attrSize);
+		if (attrs == NULL) {
+			PyErr_NoMemory();
+			goto done;
+		}
+		if (!(*pfnInitializeProcThreadAttributeList)(attrs, 1, 0, &attrSize)) {
+			free(attrs);
+			attrs = NULL;
+			PyWin_SetAPIError("InitializeProcThreadAttributeList");
+			goto done;
+		}
+		if (!(*pfnUpdateProcThreadAttribute)(attrs, 0, PY_PROC_THREAD_ATTRIBUTE_HANDLE_LIST, handles,
+				numHandles * sizeof(HANDLE), NULL, NULL)) {
+			PyWin_SetAPIError("UpdateProcThreadAttribute");
+			goto done;
+		}
+		si.lpAttributeList = attrs;
+		si.StartupInfo.cb = sizeof(si);
+		creationFlags |= EXTENDED_STARTUPINFO_PRESENT;
+	}
+	if (!CreateEnvironmentString(obEnv, &pEnv, &bEnvIsUnicode))
+		goto done;
+	if (bEnvIsUnicode)
+		creationFlags |= CREATE_UNICODE_ENVIRONMENT;
+	creationFlags |= CREATE_SUSPENDED;
+
+	Py_BEGIN_ALLOW_THREADS
+	for (; created < num; created++) {
+		if (!CreateProcess(appName, commandLines[created], NULL, NULL, numHandles != 0, creationFlags, pEnv,
+				directory, &si.StartupInfo, &pis[created])) {
+			err = GetLastError();
+			fn = "CreateProcess";
+			break;
+		}
+		if (!AssignProcessToJobObject(pl->hJob, pis[created].hProcess)) {
+			err = GetLastError();
+			fn = "AssignProcessToJobObject";
+			created++;
+			break;
+		}
+		assigned++;
+	}
+	Py_END_ALLOW_THREADS
+
+	// Record every process before any of them can run, so an exit can't be dequeued first.
+	if (fn == NULL) {
+		ret = PyList_New(num);
+		for (i = 0; ret && i < num; i++) {
+			PyObject *obPid = PyLong_FromUnsignedLong(pis[i].dwProcessId);
+			if (obPid == NULL) {
+				Py_CLEAR(ret);
+				break;
+			}
+			PyList_SET_ITEM(ret, i, obPid);
+		}
+		DWORD tracked = 0;
+		while (ret && tracked < num && pl_track(pl->processes, pis[tracked].dwProcessId, pis[tracked].hProcess))
+			tracked++;
+		if (ret && tracked < num) {
+			// The processes already recorded are discarded along with the rest.
+			for (i = 0; i < tracked; i++)
+				pl_untrack(pl->processes, pis[i].dwProcessId);
+			Py_CLEAR(ret);
+		}
+		if (ret) {
+			for (i = 0; i < num; i++) {
+				ResumeThread(pis[i].hThread);
+				CloseHandle(pis[i].hThread);
+			}
+			pl->launched += num;
+			pl->batches++;
+			goto done;
+		}
+	}
+	// Failed - none of the processes have run, so they are quietly terminated.
+	for (i = 0; i < created; i++) {
+		TerminateProcess(pis[i].hProcess, 1);
+		CloseHandle(pis[i].hThread);
+		// The job will report the exit of an assigned process, so hold on to its id until then.
+		PyObject *exc_type, *exc_value, *exc_tb;
+		PyErr_Fetch(&exc_type, &exc_value, &exc_tb);
+		if (i >= assigned || !pl_track(pl->discarded, pis[i].dwProcessId, pis[i].hProcess))
+			CloseHandle(pis[i].hProcess);
+		PyErr_Clear();
+		PyErr_Restore(exc_type, exc_value, exc_tb);
+	}
+	if (fn)
+		PyWin_SetAPIError(fn, err);
+done:
+	if (attrs) {
+		if (pfnDeleteProcThreadAttributeList)
+			(*pfnDeleteProcThreadAttributeList)(attrs);
+		free(attrs);
+	}
+	free(pEnv);
+	if (commandLines) {
+		for (i = 0; i < num; i++)
+			PyWinObject_FreeTCHAR(commandLines[i]);
+		free(commandLines);
+	}
+	free(handles);
+	free(pis);
+	PyWinObject_FreeTCHAR(appName);
+	PyWinObject_FreeTCHAR(directory);
+	return ret;
+}
+
+// Appends (pid, exitCode) for a process whose exit has been seen, and forgets it.
+static BOOL pl_exited(PyProcessLauncher *pl, PyObject *obPid, PyObject *ret)
+{
+	HANDLE h;
+	PyObject *obHandle = PyDict_GetItem(pl->discarded, obPid);
+	if (obHandle) {
+		if (!PyWinObject_AsHANDLE(obHandle, &h))
+			return FALSE;
+		CloseHandle(h);
+		return PyDict_DelItem(pl->discarded, obPid) == 0;
+	}
+	obHandle = PyDict_GetItem(pl->processes, obPid);
+	if (obHandle == NULL)
+		// A process started by one of ours.
+		return TRUE;
+	DWORD exitCode;
+	if (!PyWinObject_AsHANDLE(obHandle, &h))
+		return FALSE;
+	if (!GetExitCodeProcess(h, &exitCode)) {
+		PyWin_SetAPIError("GetExitCodeProcess");
+		return FALSE;
+	}
+	PyObject *item = Py_BuildValue("Ok", obPid, exitCode);
+	if (item == NULL || PyList_Append(ret, item) == -1) {
+		Py_XDECREF(item);
+		return FALSE;
+	}
+	Py_DECREF(item);
+	pl->exited++;
+	CloseHandle(h);
+	return PyDict_DelItem(pl->processes, obPid) == 0;
+}
+
+// Reports the processes which have exited, whether or not their notifications were seen.
+static BOOL pl_sweep(PyProcessLauncher *pl, PyObject *dict, PyObject *ret)
+{
+	PyObject *done = PyList_New(0);
+	if (done == NULL)
+		return FALSE;
+	Py_ssize_t pos = 0;
+	PyObject *obPid, *obHandle;
+	while (PyDict_Next(dict, &pos, &obPid, &obHandle)) {
+		HANDLE h;
+		if (!PyWinObject_AsHANDLE(obHandle, &h) || (WaitForSingleObject(h, 0) == WAIT_OBJECT_0 && PyList_Append(done, obPid) == -1)) {
+			Py_DECREF(done);
+			return FALSE;
+		}
+	}
+	BOOL ok = TRUE;
+	for (Py_ssize_t i = 0; ok && i < PyList_GET_SIZE(done); i++)
+		ok = pl_exited(pl, PyList_GET_ITEM(done, i), ret);
+	Py_DECREF(done);
+	return ok;
+}
+
+// @pymethod [(int, int), ...]|PyProcessLauncher|GetExits|Waits for launched processes to exit.
+// @rdesc A list of (processId, exitCode) for the processes which have exited, or an empty list
+// if the timeout expired.
+// @comm Notifications from a job's completion port are not guaranteed to be delivered, so when the
+// job reports it has no processes left, any launched process which has exited without its
+// notification being seen is reported too.
+static PyObject *pl_GetExits(PyObject *self, PyObject *args)
+{
+	PyProcessLauncher *pl = (PyProcessLauncher *)self;
+	DWORD timeout = INFINITE;
+	ULONG maxEvents = 256;
+	if (!PyArg_ParseTuple(args, "|kk:GetExits",
+		&timeout,		// @pyparm int|timeout|win32event.INFINITE|The time in milliseconds to wait for the first notification.
+		&maxEvents))	// @pyparm int|maxEvents|256|The most notifications to dequeue - one is queued for each process starting or exiting.
+		return NULL;
+	if (pl->hPort == NULL)
+		return PyErr_Format(PyExc_ValueError, "The launcher has been closed");
+	if (maxEvents == 0)
+		return PyErr_Format(PyExc_ValueError, "maxEvents must be at least 1");
+	PyPROC_OVERLAPPED_ENTRY *events = (PyPROC_OVERLAPPED_ENTRY *)malloc(maxEvents * sizeof(PyPROC_OVERLAPPED_ENTRY));
+	if (events == NULL)
+		return PyErr_NoMemory();
+	HANDLE hPort = pl->hPort;
+	ULONG num = 0;
+	DWORD err = 0;
+	Py_BEGIN_ALLOW_THREADS
+	if (pfnGetQueuedCompletionStatusEx) {
+		if (!(*pfnGetQueuedCompletionStatusEx)(hPort, events, maxEvents, &num, timeout, FALSE))
+			err = GetLastError();
+	}
+	else {
+		// Wait for the first, then take any others which are already queued.
+		while (num < maxEvents) {
+			DWORD bytes;
+			if (!GetQueuedCompletionStatus(hPort, &bytes, &events[num].lpCompletionKey, &events[num].lpOverlapped, num ? 0 : timeout)) {
+				if (events[num].lpOverlapped == NULL && num == 0)
+					err = GetLastError();
+				break;
+			}
+			events[num++].dwNumberOfBytesTransferred = bytes;
+		}
+	}
+	Py_END_ALLOW_THREADS
+	PyObject *ret = NULL;
+	if (err == WAIT_TIMEOUT)
+		ret = PyList_New(0);
+	else if (err) {
+		if (pl->hPort == NULL)
+			PyErr_Format(PyExc_ValueError, "The launcher has been closed");
+		else
+			PyWin_SetAPIError("GetQueuedCompletionStatus", err);
+	}
+	else {
+		ret = PyList_New(0);
+		for (ULONG i = 0; ret && i < num; i++) {
+			if (events[i].lpCompletionKey != PROCESSLAUNCHER_KEY)
+				continue;
+			// For job notifications, the byte count is the message and the OVERLAPPED pointer the process id.
+			BOOL ok = TRUE;
+			switch (events[i].dwNumberOfBytesTransferred) {
+				case JOB_OBJECT_MSG_EXIT_PROCESS:
+				case JOB_OBJECT_MSG_ABNORMAL_EXIT_PROCESS: {
+					PyObject *obPid = PyLong_FromUnsignedLong((DWORD)(ULONG_PTR)events[i].lpOverlapped);
+					ok = obPid && pl_exited(pl, obPid, ret);
+					Py_XDECREF(obPid);
+					break;
+				}
+				case JOB_OBJECT_MSG_ACTIVE_PROCESS_ZERO:
+					ok = pl_sweep(pl, pl->processes, ret) && pl_sweep(pl, pl->discarded, ret);
+					break;
+			}
+			if (!ok)
+				Py_CLEAR(ret);
+		}
+	}
+	free(events);
+	return ret;
+}
+
+// @pymethod |PyProcessLauncher|Terminate|Terminates every process in the job.
+// @comm Their exits are still reported by <om PyProcessLauncher.GetExits>.
+static PyObject *pl_Terminate(PyObject *self, PyObject *args)
+{
+	PyProcessLauncher *pl = (PyProcessLauncher *)self;
+	UINT exitCode = 1;
+	// @pyparm int|exitCode|1|The exit code of the processes.
+	if (!PyArg_ParseTuple(args, "|I:Terminate", &exitCode))
+		return NULL;
+	if (pl->hJob == NULL)
+		return PyErr_Format(PyExc_ValueError, "The launcher has been closed");
+	if (!TerminateJobObject(pl->hJob, exitCode))
+		return PyWin_SetAPIError("TerminateJobObject");
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+// @pymethod |PyProcessLauncher|Close|Closes the job and its completion port.
+// @comm If the launcher was created with killOnClose, the processes still running
+// in the job are terminated.
+static PyObject *pl_Close(PyObject *self, PyObject *args)
+{
+	if (!PyArg_ParseTuple(args, ":Close"))
+		return NULL;
+	pl_close((PyProcessLauncher *)self);
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+static PyMethodDef pl_methods[] = {
+	{"Launch", (PyCFunction)pl_Launch, METH_VARARGS | METH_KEYWORDS}, // @pymeth Launch|Creates a batch of processes.
+	{"GetExits", pl_GetExits, METH_VARARGS}, // @pymeth GetExits|Waits for launched processes to exit.
+	{"Terminate", pl_Terminate, METH_VARARGS}, // @pymeth Terminate|Terminates every process in the job.
+	{"Close", pl_Close, METH_VARARGS}, // @pymeth Close|Closes the job and its completion port.
+	{NULL}
+};
+
+static PyObject *pl_get_running(PyObject *self, void *)
+{
+	PyProcessLauncher *pl = (PyProcessLauncher *)self;
+	return PyLong_FromSsize_t(pl->processes ? PyDict_Size(pl->processes) : 0);
+}
+
+static PyObject *pl_get_job(PyObject *self, void *)
+{
+	PyProcessLauncher *pl = (PyProcessLauncher *)self;
+	if (pl->hJob == NULL) {
+		Py_INCREF(Py_None);
+		return Py_None;
+	}
+	return PyWinLong_FromHANDLE(pl->hJob);
+}
+
+static PyGetSetDef pl_getset[] = {
+	// @prop int|running|The number of launched processes whose exits haven't been reported.
+	{"running", pl_get_running, NULL},
+	// @prop int|job|The handle of the job, which remains owned by the launcher, or None once closed.
+	// Limits can be set on it with <om win32job.SetInformationJobObject>.
+	{"job", pl_get_job, NULL},
+	{NULL}
+};
+
+#undef OFF
+#define OFF(e) offsetof(PyProcessLauncher, e)
+static PyMemberDef pl_members[] = {
+	{"launched", T_LONG, OFF(launched), READONLY}, // @prop int|launched|The number of processes launched.
+	{"exited", T_LONG, OFF(exited), READONLY}, // @prop int|exited|The number of exits reported.
+	{"batches", T_LONG, OFF(batches), READONLY}, // @prop int|batches|The number of successful calls to <om PyProcessLauncher.Launch>.
+	{NULL}
+};
+#undef OFF
+
+PyTypeObject PyProcessLauncher_Type = {
+	PYWIN_OBJECT_HEAD
+	"PyProcessLauncher",			/* tp_name */
+	sizeof(PyProcessLauncher),		/* tp_basicsize */
+	0,					/* tp_itemsize */
+	pl_dealloc,				/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	0,					/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	0,					/* tp_iter */
+	0,					/* tp_iternext */
+	pl_methods,				/* tp_methods */
+	pl_members,				/* tp_members */
+	pl_getset,				/* tp_getset */
+};
+
+// @pyswig <o PyProcessLauncher>|CreateProcessLauncher|Creates a job and completion port for launching batches of processes.
+static PyObject *PyCreateProcessLauncher(PyObject *self, PyObject *args)
+{
+	BOOL bKillOnClose = TRUE;
+	// @pyparm bool|killOnClose|True|If True, the processes still running when the launcher is closed or destroyed are terminated.
+	if (!PyArg_ParseTuple(args, "|i:CreateProcessLauncher", &bKillOnClose))
+		return NULL;
+	PyProcessLauncher *pl = PyObject_New(PyProcessLauncher, &PyProcessLauncher_Type);
+	if (pl == NULL)
+		return NULL;
+	memset(((BYTE *)pl) + sizeof(PyObject), 0, sizeof(PyProcessLauncher) - sizeof(PyObject));
+	pl->processes = PyDict_New();
+	pl->discarded = PyDict_New();
+	if (pl->processes == NULL || pl->discarded == NULL) {
+		Py_DECREF(pl);
+		return NULL;
+	}
+	pl->hJob = CreateJobObject(NULL, NULL);
+	if (pl->hJob == NULL) {
+		PyWin_SetAPIError("CreateJobObject");
+		Py_DECREF(pl);
+		return NULL;
+	}
+	pl->hPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+	if (pl->hPort == NULL) {
+		PyWin_SetAPIError("CreateIoCompletionPort");
+		Py_DECREF(pl);
+		return NULL;
+	}
+	JOBOBJECT_ASSOCIATE_COMPLETION_PORT info;
+	info.CompletionKey = (PVOID)PROCESSLAUNCHER_KEY;
+	info.CompletionPort = pl->hPort;
+	if (!SetInformationJobObject(pl->hJob, JobObjectAssociateCompletionPortInformation, &info, sizeof(info))) {
+		PyWin_SetAPIError("SetInformationJobObject");
+		Py_DECREF(pl);
+		return NULL;
+	}
+	if (bKillOnClose) {
+		JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits;
+		ZeroMemory(&limits, sizeof(limits));
+		limits.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+		if (!SetInformationJobObject(pl->hJob, JobObjectExtendedLimitInformation, &limits, sizeof(limits))) {
+			PyWin_SetAPIError("SetInformationJobObject");
+			Py_DECREF(pl);
+			return NULL;
+		}
+	}
+	return (PyObject *)pl;
+}
+%}
+%native(CreateProcessLauncher) PyCreateProcessLauncher;
+
+// The thread pool functions are documented in win32process_threadpool.cpp
+%native(CreateThreadpool) PyCreateThreadpool;
+
 #endif	// MS_WINCE
 
 %init %{
@@ -1711,6 +2643,11 @@ PyObject *PyWriteProcessMemory(PyObject *self, PyObject *args)
 	if (PyType_Ready(&PySTARTUPINFOType) == -1)
 		return NULL;
 #endif
+#ifndef MS_WINCE
+	if (PyType_Ready(&PyProcessLauncher_Type) == -1
+		|| PyType_Ready(&PyThreadpool_Type) == -1)
+		PYWIN_MODULE_INIT_RETURN_ERROR;
+#endif
 
 	FARPROC fp=NULL;
 	HMODULE hmodule=NULL;
@@ -1749,8 +2686,17 @@ PyObject *PyWriteProcessMemory(PyObject *self, PyObject *args)
 		pfnSetProcessAffinityMask=(SetProcessAffinityMaskfunc)GetProcAddress(hmodule,"SetProcessAffinityMask");
 		pfnGetProcessId=(GetProcessIdfunc)GetProcAddress(hmodule, "GetProcessId");
 		pfnIsWow64Process=(IsWow64Processfunc)GetProcAddress(hmodule, "IsWow64Process");
+		pfnQueryFullProcessImageNameW=(QueryFullProcessImageNameWfunc)GetProcAddress(hmodule, "QueryFullProcessImageNameW");
+		pfnInitializeProcThreadAttributeList=(InitializeProcThreadAttributeListfunc)GetProcAddress(hmodule, "InitializeProcThreadAttributeList");
+		pfnUpdateProcThreadAttribute=(UpdateProcThreadAttributefunc)GetProcAddress(hmodule, "UpdateProcThreadAttribute");
+		pfnDeleteProcThreadAttributeList=(DeleteProcThreadAttributeListfunc)GetProcAddress(hmodule, "DeleteProcThreadAttributeList");
+		pfnGetQueuedCompletionStatusEx=(GetQueuedCompletionStatusExfunc)GetProcAddress(hmodule, "GetQueuedCompletionStatusEx");
 		}
 
+	hmodule=GetModuleHandle(_T("ntdll.dll"));
+	if (hmodule!=NULL)
+		pfnNtQuerySystemInformation=(NtQuerySystemInformationfunc)GetProcAddress(hmodule, "NtQuerySystemInformation");
+
 	hmodule=GetModuleHandle(_T("User32.dll"));
 	if (hmodule==NULL)
 		hmodule=LoadLibrary(_T("User32.dll"));
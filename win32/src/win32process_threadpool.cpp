@@ -0,0 +1,630 @@
+// win32process_threadpool.cpp - native work on the Windows thread pool
+//
+// A PyThreadpool owns a private thread pool and a cleanup group.  Files are
+// hashed, copied or compressed by the pool's threads without the GIL; each
+// submission queues a task and submits the pool's single TP_WORK, whose
+// callback takes the next task from the queue.  Finished tasks wait on a
+// completion queue, which Python drains in batches - either by calling
+// GetCompletions, or by giving a callback, which is called with every
+// completion that has accumulated each time it gets the GIL.
+
+// @doc - Autoduck!
+
+#define _WIN32_WINNT 0x0602  // The thread pool API needs Vista, and the Compression API Windows 8
+#include "python.h"
+#undef PyHANDLE
+#include <windows.h>
+#include <wincrypt.h>
+#include "pywintypes.h"
+#include "structmember.h"
+#include "win32process_threadpool.h"
+
+// The Compression API is only declared in the Windows 8 SDK, so cabinet.dll is
+// loaded when the first pool is created.
+typedef BOOL(WINAPI *CreateCompressorfunc)(DWORD, void *, HANDLE *);
+static CreateCompressorfunc pfnCreateCompressor = NULL;
+typedef BOOL(WINAPI *Compressfunc)(HANDLE, const void *, SIZE_T, void *, SIZE_T, SIZE_T *);
+static Compressfunc pfnCompress = NULL;
+typedef BOOL(WINAPI *CloseCompressorfunc)(HANDLE);
+static CloseCompressorfunc pfnCloseCompressor = NULL;
+#define PY_COMPRESS_ALGORITHM_XPRESS_HUFF 4
+
+#define TPTASK_HASH 0
+#define TPTASK_COPY 1
+#define TPTASK_COMPRESS 2
+
+// Files are hashed in chunks of this size.
+#define TPTASK_BUFSIZE 0x100000
+
+struct PyTpTask {
+    PyTpTask *next;
+    int kind;
+    WCHAR *source;
+    WCHAR *dest;
+    DWORD param;         // the ALG_ID, copy flags or compression algorithm
+    PyObject *obCookie;  // only touched with the GIL held
+    // Filled in by the pool thread.
+    DWORD err;
+    BYTE digest[64];
+    DWORD digestLen;
+    ULONGLONG bytesIn;
+    ULONGLONG bytesOut;
+};
+
+struct PyThreadpool {
+    PyObject_HEAD
+    PTP_POOL pool;  // NULL once closed
+    PTP_CLEANUP_GROUP group;
+    TP_CALLBACK_ENVIRON env;
+    PTP_WORK work;          // each submission runs one queued task
+    PTP_WORK dispatchWork;  // hands the completions to the callback
+    HCRYPTPROV hProv;
+    DWORD provErr;  // why hProv couldn't be acquired
+    PyObject *obCallback;
+    CRITICAL_SECTION lock;  // protects the queues and bDispatchPending
+    PyTpTask *queueHead, *queueTail;  // submitted, not yet started
+    PyTpTask *doneHead, *doneTail;    // finished, not yet returned
+    HANDLE hDoneEvent;                // set while there are finished tasks
+    BOOL bDispatchPending;
+    DWORD dispatchThreadId;  // the thread calling the callback, or 0
+    LONGLONG nextId;
+    LONG submitted;  // statistics
+    LONG completed;
+    LONG dispatches;
+};
+
+static void tp_free_task(PyTpTask *task)
+{
+    PyWinObject_FreeWCHAR(task->source);
+    PyWinObject_FreeWCHAR(task->dest);
+    Py_XDECREF(task->obCookie);
+    free(task);
+}
+
+static DWORD tp_hash_file(PyThreadpool *tp, PyTpTask *task)
+{
+    if (tp->hProv == 0)
+        return tp->provErr;
+    HANDLE h = CreateFileW(task->source, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                           NULL);
+    if (h == INVALID_HANDLE_VALUE)
+        return GetLastError();
+    DWORD err = 0;
+    HCRYPTHASH hHash = 0;
+    BYTE *buf = (BYTE *)malloc(TPTASK_BUFSIZE);
+    if (buf == NULL)
+        err = ERROR_NOT_ENOUGH_MEMORY;
+    else if (!CryptCreateHash(tp->hProv, task->param, 0, 0, &hHash))
+        err = GetLastError();
+    while (err == 0) {
+        DWORD n;
+        if (!ReadFile(h, buf, TPTASK_BUFSIZE, &n, NULL))
+            err = GetLastError();
+        else if (n == 0)
+            break;
+        else if (!CryptHashData(hHash, buf, n, 0))
+            err = GetLastError();
+        task->bytesIn += n;
+    }
+    task->digestLen = sizeof(task->digest);
+    if (err == 0 && !CryptGetHashParam(hHash, HP_HASHVAL, task->digest, &task->digestLen, 0))
+        err = GetLastError();
+    if (hHash)
+        CryptDestroyHash(hHash);
+    free(buf);
+    CloseHandle(h);
+    return err;
+}
+
+// Reads a whole file into memory.
+static DWORD tp_read_file(const WCHAR *fileName, BYTE **pbuf, SIZE_T *psize)
+{
+    HANDLE h = CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                           NULL);
+    if (h == INVALID_HANDLE_VALUE)
+        return GetLastError();
+    DWORD err = 0;
+    LARGE_INTEGER size;
+    *pbuf = NULL;
+    if (!GetFileSizeEx(h, &size))
+        err = GetLastError();
+    else if ((ULONGLONG)size.QuadPart > (SIZE_T)-1 / 2 || (*pbuf = (BYTE *)malloc((SIZE_T)size.QuadPart + 1)) == NULL)
+        err = ERROR_NOT_ENOUGH_MEMORY;
+    SIZE_T done = 0;
+    while (err == 0 && done < (SIZE_T)size.QuadPart) {
+        SIZE_T chunk = (SIZE_T)size.QuadPart - done;
+        DWORD n;
+        if (!ReadFile(h, *pbuf + done, chunk > 0x40000000 ? 0x40000000 : (DWORD)chunk, &n, NULL))
+            err = GetLastError();
+        else if (n == 0)
+            break;  // the file was truncated
+        done += n;
+    }
+    CloseHandle(h);
+    if (err) {
+        free(*pbuf);
+        *pbuf = NULL;
+    }
+    *psize = done;
+    return err;
+}
+
+static DWORD tp_write_file(const WCHAR *fileName, const BYTE *buf, SIZE_T size)
+{
+    HANDLE h = CreateFileW(fileName, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE)
+        return GetLastError();
+    DWORD err = 0;
+    for (SIZE_T done = 0; err == 0 && done < size;) {
+        SIZE_T chunk = size - done;
+        DWORD n;
+        if (!WriteFile(h, buf + done, chunk > 0x40000000 ? 0x40000000 : (DWORD)chunk, &n, NULL))
+            err = GetLastError();
+        done += n;
+    }
+    if (!CloseHandle(h) && err == 0)
+        err = GetLastError();
+    return err;
+}
+
+static DWORD tp_compress_file(PyTpTask *task)
+{
+    if (pfnCreateCompressor == NULL || pfnCompress == NULL || pfnCloseCompressor == NULL)
+        return ERROR_NOT_SUPPORTED;
+    BYTE *in, *out = NULL;
+    SIZE_T inSize, outSize = 0;
+    DWORD err = tp_read_file(task->source, &in, &inSize);
+    if (err)
+        return err;
+    HANDLE hCompressor = NULL;
+    if (!(*pfnCreateCompressor)(task->param, NULL, &hCompressor))
+        err = GetLastError();
+    else {
+        SIZE_T needed = 0;
+        // Asking for the size fails with ERROR_INSUFFICIENT_BUFFER.
+        (*pfnCompress)(hCompressor, in, inSize, NULL, 0, &needed);
+        out = (BYTE *)malloc(needed ? needed : 1);
+        if (out == NULL)
+            err = ERROR_NOT_ENOUGH_MEMORY;
+        else if (!(*pfnCompress)(hCompressor, in, inSize, out, needed, &outSize))
+            err = GetLastError();
+        (*pfnCloseCompressor)(hCompressor);
+    }
+    free(in);
+    if (err == 0)
+        err = tp_write_file(task->dest, out, outSize);
+    free(out);
+    task->bytesIn = inSize;
+    task->bytesOut = outSize;
+    return err;
+}
+
+static void CALLBACK tp_work_callback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work)
+{
+    PyThreadpool *tp = (PyThreadpool *)context;
+    EnterCriticalSection(&tp->lock);
+    PyTpTask *task = tp->queueHead;
+    if (task) {
+        tp->queueHead = task->next;
+        if (tp->queueHead == NULL)
+            tp->queueTail = NULL;
+    }
+    LeaveCriticalSection(&tp->lock);
+    if (task == NULL)
+        return;
+    switch (task->kind) {
+        case TPTASK_HASH:
+            task->err = tp_hash_file(tp, task);
+            break;
+        case TPTASK_COPY:
+            if (!CopyFileExW(task->source, task->dest, NULL, NULL, NULL, task->param))
+                task->err = GetLastError();
+            break;
+        case TPTASK_COMPRESS:
+            task->err = tp_compress_file(task);
+            break;
+    }
+    task->next = NULL;
+    BOOL bDispatch = FALSE;
+    EnterCriticalSection(&tp->lock);
+    if (tp->doneTail)
+        tp->doneTail->next = task;
+    else
+        tp->doneHead = task;
+    tp->doneTail = task;
+    tp->completed++;
+    SetEvent(tp->hDoneEvent);
+    if (tp->obCallback && !tp->bDispatchPending)
+        bDispatch = tp->bDispatchPending = TRUE;
+    LeaveCriticalSection(&tp->lock);
+    if (bDispatch)
+        SubmitThreadpoolWork(tp->dispatchWork);
+}
+
+// Takes every finished task.
+static PyTpTask *tp_take_done(PyThreadpool *tp)
+{
+    EnterCriticalSection(&tp->lock);
+    PyTpTask *done = tp->doneHead;
+    tp->doneHead = tp->doneTail = NULL;
+    ResetEvent(tp->hDoneEvent);
+    LeaveCriticalSection(&tp->lock);
+    return done;
+}
+
+// Builds the list of (cookie, result, error) for the finished tasks, and frees them.
+static PyObject *tp_completions(PyTpTask *done)
+{
+    PyObject *ret = PyList_New(0);
+    while (done) {
+        PyTpTask *task = done;
+        done = task->next;
+        if (ret == NULL) {
+            tp_free_task(task);
+            continue;
+        }
+        PyObject *result;
+        if (task->err) {
+            Py_INCREF(Py_None);
+            result = Py_None;
+        }
+        else if (task->kind == TPTASK_HASH)
+            result = PyBytes_FromStringAndSize((char *)task->digest, task->digestLen);
+        else if (task->kind == TPTASK_COMPRESS)
+            result = Py_BuildValue("KK", task->bytesIn, task->bytesOut);
+        else {
+            Py_INCREF(Py_None);
+            result = Py_None;
+        }
+        PyObject *item = result ? Py_BuildValue("ONk", task->obCookie, result, task->err) : NULL;
+        if (item == NULL || PyList_Append(ret, item) == -1)
+            Py_CLEAR(ret);
+        Py_XDECREF(item);
+        tp_free_task(task);
+    }
+    return ret;
+}
+
+static void CALLBACK tp_dispatch_callback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_WORK work)
+{
+    PyThreadpool *tp = (PyThreadpool *)context;
+    CEnterLeavePython _celp;
+    tp->dispatchThreadId = GetCurrentThreadId();
+    // Completions which arrive while the callback runs are delivered in the next batch,
+    // without submitting the dispatch again.
+    for (;;) {
+        EnterCriticalSection(&tp->lock);
+        PyTpTask *done = tp->doneHead;
+        tp->doneHead = tp->doneTail = NULL;
+        ResetEvent(tp->hDoneEvent);
+        if (done == NULL)
+            tp->bDispatchPending = FALSE;
+        LeaveCriticalSection(&tp->lock);
+        if (done == NULL)
+            break;
+        tp->dispatches++;
+        PyObject *obDone = tp_completions(done);
+        PyObject *result = obDone ? PyObject_CallFunctionObjArgs(tp->obCallback, obDone, NULL) : NULL;
+        if (result == NULL)
+            PyErr_Print();  // Called asynchronously, best we can do is print the exception
+        Py_XDECREF(result);
+        Py_XDECREF(obDone);
+    }
+    tp->dispatchThreadId = 0;
+}
+
+// Waits for the callbacks to finish (or be cancelled) and closes the pool.
+static void tp_close(PyThreadpool *tp, BOOL bCancel)
+{
+    PTP_POOL pool = tp->pool;
+    if (pool == NULL)
+        return;
+    // Nothing more can be submitted while the callbacks finish without the GIL.
+    tp->pool = NULL;
+    if (tp->group) {
+        Py_BEGIN_ALLOW_THREADS;
+        CloseThreadpoolCleanupGroupMembers(tp->group, bCancel, NULL);
+        Py_END_ALLOW_THREADS;
+        CloseThreadpoolCleanupGroup(tp->group);
+        tp->group = NULL;
+    }
+    DestroyThreadpoolEnvironment(&tp->env);
+    CloseThreadpool(pool);
+    // Tasks whose callbacks were cancelled never ran.
+    EnterCriticalSection(&tp->lock);
+    PyTpTask *queued = tp->queueHead;
+    tp->queueHead = tp->queueTail = NULL;
+    LeaveCriticalSection(&tp->lock);
+    while (queued) {
+        PyTpTask *task = queued;
+        queued = task->next;
+        tp_free_task(task);
+    }
+}
+
+static void tp_dealloc(PyObject *ob)
+{
+    PyThreadpool *tp = (PyThreadpool *)ob;
+    // The pool can't be waited for by its own callback, so if the callback dropped
+    // the last reference, the pool is left to run down and leaked.
+    if (tp->dispatchThreadId == GetCurrentThreadId())
+        return;
+    tp_close(tp, TRUE);
+    PyTpTask *done = tp->doneHead;
+    while (done) {
+        PyTpTask *task = done;
+        done = task->next;
+        tp_free_task(task);
+    }
+    if (tp->hDoneEvent)
+        CloseHandle(tp->hDoneEvent);
+    DeleteCriticalSection(&tp->lock);
+    if (tp->hProv)
+        CryptReleaseContext(tp->hProv, 0);
+    Py_XDECREF(tp->obCallback);
+    PyObject_Del(ob);
+}
+
+static PyObject *tp_submit(PyThreadpool *tp, int kind, PyObject *obSource, PyObject *obDest, DWORD param,
+                           PyObject *obCookie)
+{
+    if (tp->pool == NULL)
+        return PyErr_Format(PyExc_ValueError, "The thread pool has been closed");
+    PyTpTask *task = (PyTpTask *)calloc(1, sizeof(PyTpTask));
+    if (task == NULL)
+        return PyErr_NoMemory();
+    task->kind = kind;
+    task->param = param;
+    if (!PyWinObject_AsWCHAR(obSource, &task->source, FALSE) ||
+        (obDest && !PyWinObject_AsWCHAR(obDest, &task->dest, FALSE))) {
+        tp_free_task(task);
+        return NULL;
+    }
+    PyObject *ret = PyLong_FromLongLong(++tp->nextId);
+    if (ret == NULL) {
+        tp_free_task(task);
+        return NULL;
+    }
+    task->obCookie = obCookie == Py_None ? ret : obCookie;
+    Py_INCREF(task->obCookie);
+    EnterCriticalSection(&tp->lock);
+    if (tp->queueTail)
+        tp->queueTail->next = task;
+    else
+        tp->queueHead = task;
+    tp->queueTail = task;
+    LeaveCriticalSection(&tp->lock);
+    tp->submitted++;
+    SubmitThreadpoolWork(tp->work);
+    return ret;
+}
+
+// @object PyThreadpool|A private Windows thread pool running native file tasks, as returned by
+// <om win32process.CreateThreadpool>.
+// @comm Each Submit method queues a task and returns at once - the task runs on one of the pool's
+// threads without the Python lock, so tasks run in parallel on as many cores as the pool has
+// threads.  The result of each task is a completion tuple of (cookie, result, error), where error
+// is 0 or the Win32 error code which stopped the task, and result is None if the task failed.
+// cookie is the value passed to the Submit method, or the integer it returned.
+// <nl>If the pool was created with a callback, it is called on a pool thread with a list of every
+// completion which has accumulated, so the Python lock is acquired once per batch rather than per
+// task.  Otherwise, the completions are returned by <om PyThreadpool.GetCompletions>.
+
+// @pymethod int|PyThreadpool|SubmitHash|Queues a file to be hashed.
+// @rdesc The id of the task.  The result is the hash value as bytes.
+// @comm Accepts keyword args.
+static PyObject *tp_SubmitHash(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"FileName", "Algorithm", "Cookie", NULL};
+    PyObject *obFileName, *obCookie = Py_None;
+    DWORD alg = CALG_SHA_256;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "O|kO:SubmitHash", keywords,
+            &obFileName,  // @pyparm str|FileName||The file to hash
+            &alg,         // @pyparm int|Algorithm|CALG_SHA_256|The hash algorithm, one of the win32cryptcon.CALG_* hash values
+            &obCookie))   // @pyparm object|Cookie|None|Identifies the task in its completion
+        return NULL;
+    return tp_submit((PyThreadpool *)self, TPTASK_HASH, obFileName, NULL, alg, obCookie);
+}
+
+// @pymethod int|PyThreadpool|SubmitCopy|Queues a file to be copied with CopyFileEx.
+// @rdesc The id of the task.  The result is None.
+// @comm Accepts keyword args.
+static PyObject *tp_SubmitCopy(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Source", "Destination", "Flags", "Cookie", NULL};
+    PyObject *obSource, *obDest, *obCookie = Py_None;
+    DWORD flags = 0;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "OO|kO:SubmitCopy", keywords,
+            &obSource,  // @pyparm str|Source||The file to copy
+            &obDest,    // @pyparm str|Destination||The new file
+            &flags,     // @pyparm int|Flags|0|A combination of win32file.COPY_FILE_* flags
+            &obCookie))  // @pyparm object|Cookie|None|Identifies the task in its completion
+        return NULL;
+    return tp_submit((PyThreadpool *)self, TPTASK_COPY, obSource, obDest, flags, obCookie);
+}
+
+// @pymethod int|PyThreadpool|SubmitCompress|Queues a file to be compressed with the Compression API.
+// @rdesc The id of the task.  The result is a tuple of (bytesIn, bytesOut).
+// @comm Accepts keyword args.
+// @comm The whole file is compressed in memory, in the buffer format, which is decompressed
+// with the Decompress function of the Compression API.  Requires Windows 8 or later - otherwise
+// the task fails with ERROR_NOT_SUPPORTED.
+static PyObject *tp_SubmitCompress(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Source", "Destination", "Algorithm", "Cookie", NULL};
+    PyObject *obSource, *obDest, *obCookie = Py_None;
+    DWORD alg = PY_COMPRESS_ALGORITHM_XPRESS_HUFF;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "OO|kO:SubmitCompress", keywords,
+            &obSource,  // @pyparm str|Source||The file to compress
+            &obDest,    // @pyparm str|Destination||The compressed file, which is replaced if it exists
+            &alg,  // @pyparm int|Algorithm|COMPRESS_ALGORITHM_XPRESS_HUFF|The COMPRESS_ALGORITHM_* value - 2 for MSZIP, 3 for XPRESS, 4 for XPRESS_HUFF or 5 for LZMS
+            &obCookie))  // @pyparm object|Cookie|None|Identifies the task in its completion
+        return NULL;
+    return tp_submit((PyThreadpool *)self, TPTASK_COMPRESS, obSource, obDest, alg, obCookie);
+}
+
+// @pymethod [(object, object, int), ...]|PyThreadpool|GetCompletions|Returns the completions of finished tasks.
+// @rdesc A list of every completion waiting, or an empty list if the timeout expires or no task
+// is outstanding.
+// @comm A pool created with a callback hands its completions to the callback instead, so this only
+// returns those left when the pool was closed.
+static PyObject *tp_GetCompletions(PyObject *self, PyObject *args)
+{
+    PyThreadpool *tp = (PyThreadpool *)self;
+    DWORD timeout = INFINITE;
+    // @pyparm int|Timeout|win32event.INFINITE|The time in milliseconds to wait for the first completion.
+    if (!PyArg_ParseTuple(args, "|k:GetCompletions", &timeout))
+        return NULL;
+    for (;;) {
+        PyTpTask *done = tp_take_done(tp);
+        if (done)
+            return tp_completions(done);
+        if (timeout == 0 || tp->pool == NULL || tp->obCallback || tp->submitted == tp->completed)
+            return PyList_New(0);
+        DWORD rc;
+        Py_BEGIN_ALLOW_THREADS;
+        rc = WaitForSingleObject(tp->hDoneEvent, timeout);
+        Py_END_ALLOW_THREADS;
+        if (rc == WAIT_TIMEOUT)
+            return PyList_New(0);
+        if (rc == WAIT_FAILED)
+            return PyWin_SetAPIError("WaitForSingleObject");
+        // Another thread may take the completions first - only an infinite wait is repeated.
+        if (timeout != INFINITE)
+            timeout = 0;
+    }
+}
+
+// @pymethod |PyThreadpool|Close|Waits for the tasks to finish, and closes the pool.
+// @comm Completions which have not been delivered can still be fetched with
+// <om PyThreadpool.GetCompletions>.  Can't be called from the pool's callback.
+static PyObject *tp_Close(PyObject *self, PyObject *args)
+{
+    PyThreadpool *tp = (PyThreadpool *)self;
+    BOOL bCancel = FALSE;
+    // @pyparm bool|CancelPending|False|If True, queued tasks which haven't started are discarded
+    // without a completion.  Tasks already running are always finished.
+    if (!PyArg_ParseTuple(args, "|i:Close", &bCancel))
+        return NULL;
+    if (tp->dispatchThreadId == GetCurrentThreadId())
+        return PyErr_Format(PyExc_ValueError, "The thread pool can't be closed from its own callback");
+    tp_close(tp, bCancel);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyMethodDef tp_methods[] = {
+    {"SubmitHash", (PyCFunction)tp_SubmitHash, METH_VARARGS | METH_KEYWORDS},  // @pymeth SubmitHash|Queues a file to be hashed.
+    {"SubmitCopy", (PyCFunction)tp_SubmitCopy, METH_VARARGS | METH_KEYWORDS},  // @pymeth SubmitCopy|Queues a file to be copied.
+    {"SubmitCompress", (PyCFunction)tp_SubmitCompress, METH_VARARGS | METH_KEYWORDS},  // @pymeth SubmitCompress|Queues a file to be compressed.
+    {"GetCompletions", tp_GetCompletions, METH_VARARGS},  // @pymeth GetCompletions|Returns the completions of finished tasks.
+    {"Close", tp_Close, METH_VARARGS},                    // @pymeth Close|Waits for the tasks to finish, and closes the pool.
+    {NULL}};
+
+#define OFF(e) offsetof(PyThreadpool, e)
+static PyMemberDef tp_members[] = {
+    {"submitted", T_LONG, OFF(submitted), READONLY},  // @prop int|submitted|The number of tasks submitted.
+    {"completed", T_LONG, OFF(completed), READONLY},  // @prop int|completed|The number of tasks which have finished.
+    {"dispatches", T_LONG, OFF(dispatches), READONLY},  // @prop int|dispatches|The number of times the callback has been called.
+    {NULL}};
+#undef OFF
+
+PyTypeObject PyThreadpool_Type = {
+    PYWIN_OBJECT_HEAD "PyThreadpool",
+    sizeof(PyThreadpool),
+    0,
+    tp_dealloc,               // tp_dealloc
+    0,                        // tp_print
+    0,                        // tp_getattr
+    0,                        // tp_setattr
+    0,                        // tp_compare
+    0,                        // tp_repr
+    0,                        // tp_as_number
+    0,                        // tp_as_sequence
+    0,                        // tp_as_mapping
+    0,                        // tp_hash
+    0,                        // tp_call
+    0,                        // tp_str
+    PyObject_GenericGetAttr,  // tp_getattro
+    0,                        // tp_setattro
+    0,                        // tp_as_buffer
+    Py_TPFLAGS_DEFAULT,       // tp_flags
+    0,                        // tp_doc
+    0,                        // tp_traverse
+    0,                        // tp_clear
+    0,                        // tp_richcompare
+    0,                        // tp_weaklistoffset
+    0,                        // tp_iter
+    0,                        // tp_iternext
+    tp_methods,               // tp_methods
+    tp_members,               // tp_members
+};
+
+// @pyswig <o PyThreadpool>|CreateThreadpool|Creates a private thread pool for native file tasks.
+PyObject *PyCreateThreadpool(PyObject *self, PyObject *args)
+{
+    DWORD minThreads = 0, maxThreads = 0;
+    PyObject *obCallback = Py_None;
+    if (!PyArg_ParseTuple(args, "|kkO:CreateThreadpool",
+                          &minThreads,   // @pyparm int|MinThreads|0|The minimum number of threads, or 0 for the system default.
+                          &maxThreads,   // @pyparm int|MaxThreads|0|The maximum number of threads, or 0 for the system default.
+                          &obCallback))  // @pyparm callable|Callback|None|Called on a pool thread with a list of completions, each time some are waiting.  If None, completions are returned by <om PyThreadpool.GetCompletions>.
+        return NULL;
+    if (obCallback != Py_None && !PyCallable_Check(obCallback))
+        return PyErr_Format(PyExc_TypeError, "Callback must be callable");
+    if (maxThreads && minThreads > maxThreads)
+        return PyErr_Format(PyExc_ValueError, "MinThreads can't be more than MaxThreads");
+    if (pfnCreateCompressor == NULL) {
+        HMODULE hmod = LoadLibraryW(L"cabinet.dll");
+        if (hmod) {
+            pfnCompress = (Compressfunc)GetProcAddress(hmod, "Compress");
+            pfnCloseCompressor = (CloseCompressorfunc)GetProcAddress(hmod, "CloseCompressor");
+            pfnCreateCompressor = (CreateCompressorfunc)GetProcAddress(hmod, "CreateCompressor");
+        }
+    }
+    PyThreadpool *tp = PyObject_New(PyThreadpool, &PyThreadpool_Type);
+    if (tp == NULL)
+        return NULL;
+    memset(((BYTE *)tp) + sizeof(PyObject), 0, sizeof(PyThreadpool) - sizeof(PyObject));
+    InitializeCriticalSection(&tp->lock);
+    if (obCallback != Py_None) {
+        Py_INCREF(obCallback);
+        tp->obCallback = obCallback;
+    }
+    // A hash task fails with this error if there is no provider.
+    if (!CryptAcquireContextW(&tp->hProv, NULL, NULL, PROV_RSA_AES, CRYPT_VERIFYCONTEXT)) {
+        tp->hProv = 0;
+        tp->provErr = GetLastError();
+    }
+    const char *fn = NULL;
+    tp->hDoneEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (tp->hDoneEvent == NULL)
+        fn = "CreateEvent";
+    else if ((tp->pool = CreateThreadpool(NULL)) == NULL)
+        fn = "CreateThreadpool";
+    else {
+        InitializeThreadpoolEnvironment(&tp->env);
+        SetThreadpoolCallbackPool(&tp->env, tp->pool);
+        if (maxThreads)
+            SetThreadpoolThreadMaximum(tp->pool, maxThreads);
+        if (minThreads && !SetThreadpoolThreadMinimum(tp->pool, minThreads))
+            fn = "SetThreadpoolThreadMinimum";
+        else if ((tp->group = CreateThreadpoolCleanupGroup()) == NULL)
+            fn = "CreateThreadpoolCleanupGroup";
+        else {
+            SetThreadpoolCallbackCleanupGroup(&tp->env, tp->group, NULL);
+            if ((tp->work = CreateThreadpoolWork(tp_work_callback, tp, &tp->env)) == NULL ||
+                (tp->dispatchWork = CreateThreadpoolWork(tp_dispatch_callback, tp, &tp->env)) == NULL)
+                fn = "CreateThreadpoolWork";
+        }
+    }
+    if (fn) {
+        PyWin_SetAPIError(fn);
+        Py_DECREF(tp);
+        return NULL;
+    }
+    return (PyObject *)tp;
+}
@@ -0,0 +1,13 @@
+// win32process_threadpool.h - native work on the Windows thread pool for win32process
+//
+// File hashing, copying and compression run on a private thread pool without
+// the GIL, and their completions are handed to Python in batches.
+
+#ifndef WIN32PROCESS_THREADPOOL_H
+#define WIN32PROCESS_THREADPOOL_H
+
+extern PyTypeObject PyThreadpool_Type;
+
+PyObject *PyCreateThreadpool(PyObject *self, PyObject *args);
+
+#endif  // WIN32PROCESS_THREADPOOL_H
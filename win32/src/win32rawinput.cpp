@@ -0,0 +1,498 @@
+// win32rawinput.cpp - raw input devices for win32gui
+//
+// At high polling rates, decoding each WM_INPUT message in Python loses events.
+// GetRawInputBuffer instead drains every pending record in one call into a
+// PyRawInputBatch, which decodes the mouse and keyboard records into an array of
+// fixed size structs, available without creating an object per event.
+
+// @doc - Autoduck!
+
+#define _WIN32_WINNT 0x501  // Raw input is only available on WinXP
+#include "python.h"
+#undef PyHANDLE
+#include <windows.h>
+#include "pywintypes.h"
+#include "structmember.h"
+#include "win32rawinput.h"
+
+// One decoded record, as exposed through the buffer interface.  The mouse and
+// keyboard fields are zero for other kinds of record.
+typedef struct {
+    LONGLONG Time;          // QueryPerformanceCounter when the record was drained
+    ULONGLONG Device;       // RAWINPUTHEADER.hDevice
+    DWORD Type;             // RIM_TYPE*
+    USHORT MouseFlags;      // RAWMOUSE.usFlags
+    USHORT ButtonFlags;     // RAWMOUSE.usButtonFlags
+    SHORT ButtonData;       // RAWMOUSE.usButtonData - signed, as it holds wheel deltas
+    LONG X;                 // RAWMOUSE.lLastX
+    LONG Y;                 // RAWMOUSE.lLastY
+    USHORT MakeCode;        // RAWKEYBOARD.MakeCode
+    USHORT KeyFlags;        // RAWKEYBOARD.Flags
+    USHORT VKey;            // RAWKEYBOARD.VKey
+    UINT Message;           // RAWKEYBOARD.Message
+    ULONG ExtraInformation; // from either
+} PY_RAWINPUT_EVENT;
+C_ASSERT(sizeof(PY_RAWINPUT_EVENT) == 56);
+
+// The PEP 3118 format of a PY_RAWINPUT_EVENT, so numpy can make a structured
+// array from a batch.
+#define RAWINPUT_EVENT_FORMAT                                                                                       \
+    "T{=q:Time:Q:Device:I:Type:H:MouseFlags:H:ButtonFlags:h:ButtonData:2xi:X:i:Y:H:MakeCode:H:KeyFlags:H:VKey:2xI:" \
+    "Message:I:ExtraInformation:4x}"
+
+// A 32 bit process on 64 bit Windows gets GetRawInputBuffer records laid out for
+// 64 bits - the header is 8 bytes larger and records are aligned to 8 bytes.
+// (GetRawInputData doesn't have this problem.)
+static UINT cbBufferHeader = 0;
+static UINT cbBufferAlign = 0;
+
+static void InitBufferLayout(void)
+{
+    if (cbBufferHeader)
+        return;
+    cbBufferHeader = sizeof(RAWINPUTHEADER);
+    cbBufferAlign = sizeof(ULONG_PTR);
+#ifndef _WIN64
+    BOOL bWow64 = FALSE;
+    typedef BOOL(WINAPI * IsWow64Processfunc)(HANDLE, PBOOL);
+    IsWow64Processfunc pfnIsWow64Process =
+        (IsWow64Processfunc)GetProcAddress(GetModuleHandle(TEXT("kernel32.dll")), "IsWow64Process");
+    if (pfnIsWow64Process && pfnIsWow64Process(GetCurrentProcess(), &bWow64) && bWow64) {
+        cbBufferHeader = sizeof(RAWINPUTHEADER) + 8;
+        cbBufferAlign = 8;
+    }
+#endif
+}
+
+#define ALIGN_UP(cb, align) (((cb) + (align)-1) & ~((align)-1))
+
+// cbHeader is the size of the header the record was returned with.
+static void DecodeRawInput(const BYTE *p, UINT cbHeader, LONGLONG time, PY_RAWINPUT_EVENT *ev)
+{
+    const RAWINPUTHEADER *header = (const RAWINPUTHEADER *)p;
+    memset(ev, 0, sizeof(*ev));
+    ev->Time = time;
+    ev->Type = header->dwType;
+    // In the wider header a 32 bit handle is the low half of a 64 bit field.
+    ev->Device = (ULONGLONG)(ULONG_PTR)header->hDevice;
+    const BYTE *data = p + cbHeader;
+    if (header->dwType == RIM_TYPEMOUSE) {
+        const RAWMOUSE *mouse = (const RAWMOUSE *)data;
+        ev->MouseFlags = mouse->usFlags;
+        ev->ButtonFlags = mouse->usButtonFlags;
+        ev->ButtonData = (SHORT)mouse->usButtonData;
+        ev->X = mouse->lLastX;
+        ev->Y = mouse->lLastY;
+        ev->ExtraInformation = mouse->ulExtraInformation;
+    }
+    else if (header->dwType == RIM_TYPEKEYBOARD) {
+        const RAWKEYBOARD *keyboard = (const RAWKEYBOARD *)data;
+        ev->MakeCode = keyboard->MakeCode;
+        ev->KeyFlags = keyboard->Flags;
+        ev->VKey = keyboard->VKey;
+        ev->Message = keyboard->Message;
+        ev->ExtraInformation = keyboard->ExtraInformation;
+    }
+}
+
+// @object PyRawInputBatch|A reusable array of decoded raw input records, filled by
+// <om win32gui.GetRawInputBuffer>
+// @comm Create using PyRawInputBatchType(Length), where Length is the number of records it can hold.
+// <nl>The records are available as a sequence of tuples of (Time, Device, Type, MouseFlags, ButtonFlags,
+// ButtonData, X, Y, MakeCode, KeyFlags, VKey, Message, ExtraInformation), created only for the items
+// accessed, and through the buffer interface as Count 56 byte structs with named fields, which numpy
+// converts directly to a structured array.
+// <nl>Time is the performance counter value (see <om win32api.QueryPerformanceCounter>) when the record was
+// drained - all the records of one call share it.  The mouse fields are only set for RIM_TYPEMOUSE records
+// and the keyboard fields for RIM_TYPEKEYBOARD records; HID records only have Time, Device and Type.
+class PyRawInputBatch : public PyObject {
+   public:
+    static struct PyMemberDef members[];
+    static PySequenceMethods sequencemethods;
+    static PyBufferProcs buffermethods;
+    static void tp_dealloc(PyObject *ob);
+    static PyObject *tp_new(PyTypeObject *tp, PyObject *args, PyObject *kwargs);
+    static PyRawInputBatch *Create(DWORD length);
+    static Py_ssize_t sq_length(PyObject *self);
+    static PyObject *sq_item(PyObject *self, Py_ssize_t index);
+    static int getbuffer(PyObject *self, Py_buffer *view, int flags);
+    static void releasebuffer(PyObject *self, Py_buffer *view);
+    PyRawInputBatch(void);
+    ~PyRawInputBatch(void);
+    UINT Fill(HRAWINPUT hRawInput);  // without the GIL
+
+    PY_RAWINPUT_EVENT *events;
+    DWORD capacity, count, dropped;
+    BOOL bMore;           // the batch filled up, so records may still be pending
+    LONGLONG frequency;   // of the performance counter
+    BYTE *raw;            // GetRawInputBuffer's buffer
+    UINT cbRaw;
+    Py_ssize_t shape, stride;  // for exported buffers
+    int exports;
+    BOOL bBusy;  // a fill is in progress with the GIL released
+};
+
+PyRawInputBatch::PyRawInputBatch(void)
+{
+    ob_type = &PyRawInputBatchType;
+    events = NULL;
+    capacity = count = dropped = 0;
+    bMore = FALSE;
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    frequency = freq.QuadPart;
+    raw = NULL;
+    cbRaw = 0;
+    shape = 0;
+    stride = sizeof(PY_RAWINPUT_EVENT);
+    exports = 0;
+    bBusy = FALSE;
+    _Py_NewReference(this);
+}
+
+PyRawInputBatch::~PyRawInputBatch(void)
+{
+    free(events);
+    free(raw);
+}
+
+void PyRawInputBatch::tp_dealloc(PyObject *ob) { delete (PyRawInputBatch *)ob; }
+
+PyObject *PyRawInputBatch::tp_new(PyTypeObject *tp, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Length", NULL};
+    DWORD length = 256;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|k:PyRawInputBatchType", keywords, &length))
+        return NULL;
+    if (length == 0) {
+        PyErr_SetString(PyExc_ValueError, "Length must be greater than 0");
+        return NULL;
+    }
+    return Create(length);
+}
+
+PyRawInputBatch *PyRawInputBatch::Create(DWORD length)
+{
+    InitBufferLayout();
+    PyRawInputBatch *ret = new PyRawInputBatch();
+    if (ret == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    // Enough for a mouse record per event - fills stop before there are more
+    // records than events.
+    ret->cbRaw = length * ALIGN_UP(cbBufferHeader + sizeof(RAWMOUSE), cbBufferAlign);
+    ret->events = (PY_RAWINPUT_EVENT *)malloc(length * sizeof(PY_RAWINPUT_EVENT));
+    ret->raw = (BYTE *)malloc(ret->cbRaw);
+    if (ret->events == NULL || ret->raw == NULL) {
+        Py_DECREF(ret);
+        PyErr_Format(PyExc_MemoryError, "Unable to allocate a batch of %d records", length);
+        return NULL;
+    }
+    ret->capacity = length;
+    return ret;
+}
+
+// Returns 0, or the error from GetRawInputBuffer/GetRawInputData.
+UINT PyRawInputBatch::Fill(HRAWINPUT hRawInput)
+{
+    count = dropped = 0;
+    bMore = FALSE;
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    if (hRawInput) {
+        // The record of the WM_INPUT being handled is only available this way.
+        RAWINPUT ri;
+        UINT cb = sizeof(ri);
+        if (GetRawInputData(hRawInput, RID_INPUT, &ri, &cb, sizeof(RAWINPUTHEADER)) != (UINT)-1)
+            DecodeRawInput((BYTE *)&ri, sizeof(RAWINPUTHEADER), now.QuadPart, &events[count++]);
+        else if (GetLastError() != ERROR_INSUFFICIENT_BUFFER)  // a large HID record, which isn't decoded anyway.
+            return GetLastError();
+    }
+    // No record is smaller than this, so a buffer of n of them can't return
+    // more than n records.
+    UINT cbMinRecord = ALIGN_UP(cbBufferHeader + offsetof(RAWHID, bRawData) + 1, cbBufferAlign);
+    while (count < capacity) {
+        UINT cbNeeded = 0;
+        if (GetRawInputBuffer(NULL, &cbNeeded, sizeof(RAWINPUTHEADER)) == (UINT)-1)
+            return GetLastError();
+        // cbNeeded is never more than a RAWINPUT, except for HID devices with large reports.
+        if (cbNeeded > cbRaw) {
+            BYTE *p = (BYTE *)realloc(raw, cbNeeded);
+            if (p == NULL)
+                return ERROR_NOT_ENOUGH_MEMORY;
+            raw = p;
+            cbRaw = cbNeeded;
+        }
+        UINT cb = (capacity - count) * cbMinRecord;
+        if (cb > cbRaw)
+            cb = cbRaw;
+        if (cb < cbNeeded) {
+            if (count > 0) {
+                bMore = TRUE;
+                break;
+            }
+            cb = cbNeeded;
+        }
+        UINT n = GetRawInputBuffer((PRAWINPUT)raw, &cb, sizeof(RAWINPUTHEADER));
+        if (n == (UINT)-1)
+            return GetLastError();
+        if (n == 0)
+            break;
+        QueryPerformanceCounter(&now);
+        BYTE *p = raw;
+        for (UINT i = 0; i < n; i++) {
+            if (count < capacity)
+                DecodeRawInput(p, cbBufferHeader, now.QuadPart, &events[count++]);
+            else
+                dropped++;  // only possible with HID reports larger than the batch.
+            p += ALIGN_UP(((RAWINPUTHEADER *)p)->dwSize, cbBufferAlign);
+        }
+    }
+    if (count == capacity)
+        bMore = TRUE;
+    return 0;
+}
+
+Py_ssize_t PyRawInputBatch::sq_length(PyObject *self) { return ((PyRawInputBatch *)self)->count; }
+
+PyObject *PyRawInputBatch::sq_item(PyObject *self, Py_ssize_t index)
+{
+    PyRawInputBatch *batch = (PyRawInputBatch *)self;
+    if (index < 0 || index >= (Py_ssize_t)batch->count) {
+        PyErr_SetString(PyExc_IndexError, "PyRawInputBatch index out of range");
+        return NULL;
+    }
+    PY_RAWINPUT_EVENT *ev = &batch->events[index];
+    return Py_BuildValue("LKkHHhllHHHIk", ev->Time, ev->Device, ev->Type, ev->MouseFlags, ev->ButtonFlags,
+                         ev->ButtonData, ev->X, ev->Y, ev->MakeCode, ev->KeyFlags, ev->VKey, ev->Message,
+                         ev->ExtraInformation);
+}
+
+int PyRawInputBatch::getbuffer(PyObject *self, Py_buffer *view, int flags)
+{
+    PyRawInputBatch *batch = (PyRawInputBatch *)self;
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "A PyRawInputBatch is read only");
+        return -1;
+    }
+    batch->shape = batch->count;
+    view->obj = self;
+    Py_INCREF(self);
+    view->buf = batch->events;
+    view->len = batch->count * sizeof(PY_RAWINPUT_EVENT);
+    view->readonly = 1;
+    view->itemsize = sizeof(PY_RAWINPUT_EVENT);
+    view->format = (flags & PyBUF_FORMAT) ? RAWINPUT_EVENT_FORMAT : NULL;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? &batch->shape : NULL;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? &batch->stride : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    batch->exports++;
+    return 0;
+}
+
+void PyRawInputBatch::releasebuffer(PyObject *self, Py_buffer *view) { ((PyRawInputBatch *)self)->exports--; }
+
+PySequenceMethods PyRawInputBatch::sequencemethods = {
+    PyRawInputBatch::sq_length,  // inquiry sq_length;
+    NULL,                        // binaryfunc sq_concat;
+    NULL,                        // intargfunc sq_repeat;
+    PyRawInputBatch::sq_item,    // intargfunc sq_item;
+};
+
+PyBufferProcs PyRawInputBatch::buffermethods = {
+    PyRawInputBatch::getbuffer,
+    PyRawInputBatch::releasebuffer,
+};
+
+struct PyMemberDef PyRawInputBatch::members[] = {
+    // @prop int|Length|Number of records the batch can hold
+    {"Length", T_ULONG, offsetof(PyRawInputBatch, capacity), READONLY, "Number of records the batch can hold"},
+    // @prop int|Count|Number of records returned by the last call
+    {"Count", T_ULONG, offsetof(PyRawInputBatch, count), READONLY, "Number of records returned by the last call"},
+    // @prop bool|More|True if the last call stopped because the batch was full, so more records may be pending
+    {"More", T_INT, offsetof(PyRawInputBatch, bMore), READONLY,
+     "True if the last call stopped because the batch was full"},
+    // @prop int|Dropped|Number of records lost by the last call, which can only happen when HID reports are
+    // larger than the space for the batch's records
+    {"Dropped", T_ULONG, offsetof(PyRawInputBatch, dropped), READONLY, "Number of records lost by the last call"},
+    // @prop int|Frequency|Ticks per second of the Time of each record
+    {"Frequency", T_LONGLONG, offsetof(PyRawInputBatch, frequency), READONLY,
+     "Ticks per second of the Time of each record"},
+    {NULL}};
+
+PyTypeObject PyRawInputBatchType = {
+    PYWIN_OBJECT_HEAD "PyRawInputBatch",
+    sizeof(PyRawInputBatch),
+    0,
+    PyRawInputBatch::tp_dealloc,        // tp_dealloc
+    0,                                  // tp_print
+    0,                                  // tp_getattr
+    0,                                  // tp_setattr
+    0,                                  // tp_compare
+    0,                                  // tp_repr
+    0,                                  // tp_as_number
+    &PyRawInputBatch::sequencemethods,  // tp_as_sequence
+    0,                                  // tp_as_mapping
+    0,                                  // tp_hash
+    0,                                  // tp_call
+    0,                                  // tp_str
+    PyObject_GenericGetAttr,            // tp_getattro
+    PyObject_GenericSetAttr,            // tp_setattro
+    &PyRawInputBatch::buffermethods,    // tp_as_buffer
+    Py_TPFLAGS_DEFAULT,                 // tp_flags
+    "Reusable array of decoded raw input records.  Create using PyRawInputBatchType(Length)",  // tp_doc
+    0,                                                                                         // tp_traverse
+    0,                                                                                         // tp_clear
+    0,                                                                                         // tp_richcompare
+    0,                                                                                         // tp_weaklistoffset
+    0,                                                                                         // tp_iter
+    0,                                                                                         // tp_iternext
+    0,                                                                                         // tp_methods
+    PyRawInputBatch::members,                                                                  // tp_members
+    0,                                                                                         // tp_getset
+    0,                                                                                         // tp_base
+    0,                                                                                         // tp_dict
+    0,                                                                                         // tp_descr_get
+    0,                                                                                         // tp_descr_set
+    0,                                                                                         // tp_dictoffset
+    0,                                                                                         // tp_init
+    0,                                                                                         // tp_alloc
+    PyRawInputBatch::tp_new,                                                                   // tp_new
+};
+
+// @pyswig |RegisterRawInputDevices|Registers the devices that supply raw input (WM_INPUT messages)
+// @pyseeapi RegisterRawInputDevices
+// @comm Each registration is a tuple of (UsagePage, Usage, Flags, Target), where Flags (a combination
+// of win32con.RIDEV_* values) and Target (the window to receive the input, or None for the window with
+// the keyboard focus) are optional.  For example, (1, 2) registers the mouse and (1, 6) the keyboard.
+PyObject *PyRegisterRawInputDevices(PyObject *self, PyObject *args)
+{
+    PyObject *obdevices;
+    // @pyparm [(int, int, int, <o PyHANDLE>), ...]|Devices||The devices to register
+    if (!PyArg_ParseTuple(args, "O:RegisterRawInputDevices", &obdevices))
+        return NULL;
+    PyObject *seq = PySequence_Fast(obdevices, "Devices must be a sequence of tuples");
+    if (seq == NULL)
+        return NULL;
+    Py_ssize_t n = PySequence_Fast_GET_SIZE(seq);
+    RAWINPUTDEVICE *devices = (RAWINPUTDEVICE *)malloc((n ? n : 1) * sizeof(RAWINPUTDEVICE));
+    if (devices == NULL) {
+        Py_DECREF(seq);
+        return PyErr_NoMemory();
+    }
+    PyObject *ret = NULL;
+    for (Py_ssize_t i = 0; i < n; i++) {
+        PyObject *obtarget = Py_None;
+        USHORT usagePage, usage;
+        DWORD flags = 0;
+        if (!PyArg_ParseTuple(PySequence_Fast_GET_ITEM(seq, i), "HH|kO:RAWINPUTDEVICE", &usagePage, &usage, &flags,
+                              &obtarget))
+            goto done;
+        devices[i].usUsagePage = usagePage;
+        devices[i].usUsage = usage;
+        devices[i].dwFlags = flags;
+        devices[i].hwndTarget = NULL;
+        if (obtarget != Py_None && !PyWinObject_AsHANDLE(obtarget, (HANDLE *)&devices[i].hwndTarget))
+            goto done;
+    }
+    if (!RegisterRawInputDevices(devices, (UINT)n, sizeof(RAWINPUTDEVICE)))
+        PyWin_SetAPIError("RegisterRawInputDevices");
+    else {
+        Py_INCREF(Py_None);
+        ret = Py_None;
+    }
+done:
+    free(devices);
+    Py_DECREF(seq);
+    return ret;
+}
+
+// @pyswig [(int, int, int, <o PyHANDLE>), ...]|GetRegisteredRawInputDevices|Returns the raw input
+// devices registered by the process
+// @pyseeapi GetRegisteredRawInputDevices
+// @rdesc A list of (UsagePage, Usage, Flags, Target) tuples, as passed to <om win32gui.RegisterRawInputDevices>
+PyObject *PyGetRegisteredRawInputDevices(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":GetRegisteredRawInputDevices"))
+        return NULL;
+    UINT n = 0;
+    if (GetRegisteredRawInputDevices(NULL, &n, sizeof(RAWINPUTDEVICE)) == (UINT)-1)
+        return PyWin_SetAPIError("GetRegisteredRawInputDevices");
+    RAWINPUTDEVICE *devices = (RAWINPUTDEVICE *)malloc((n ? n : 1) * sizeof(RAWINPUTDEVICE));
+    if (devices == NULL)
+        return PyErr_NoMemory();
+    UINT got = n ? GetRegisteredRawInputDevices(devices, &n, sizeof(RAWINPUTDEVICE)) : 0;
+    if (got == (UINT)-1) {
+        free(devices);
+        return PyWin_SetAPIError("GetRegisteredRawInputDevices");
+    }
+    PyObject *ret = PyList_New(got);
+    for (UINT i = 0; ret && i < got; i++) {
+        PyObject *item = Py_BuildValue("HHkN", devices[i].usUsagePage, devices[i].usUsage, devices[i].dwFlags,
+                                       PyWinLong_FromHANDLE(devices[i].hwndTarget));
+        if (item == NULL) {
+            Py_DECREF(ret);
+            ret = NULL;
+        }
+        else
+            PyList_SET_ITEM(ret, i, item);
+    }
+    free(devices);
+    return ret;
+}
+
+// @pyswig <o PyRawInputBatch>|GetRawInputBuffer|Drains the pending raw input records into a reusable batch
+// @pyseeapi GetRawInputBuffer
+// @rdesc Returns the batch that was filled
+// @comm Call this from the thread which owns the window raw input is delivered to, typically on receiving
+// a WM_INPUT message.  Records are drained until none are pending or the batch is full - when its More
+// attribute is set, call again.  Unlike decoding each WM_INPUT message, no Python objects are created
+// unless the batch is indexed.
+PyObject *PyGetRawInputBuffer(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Batch", "RawInput", NULL};
+    PyObject *obbatch = Py_None, *obrawinput = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|OO:GetRawInputBuffer", keywords,
+            &obbatch,      // @pyparm <o PyRawInputBatch>|Batch|None|The batch to fill, replacing its previous
+                           // contents.  If None, a new batch of 256 records is created.
+            &obrawinput))  // @pyparm <o PyHANDLE>|RawInput|None|The lParam of the WM_INPUT message being handled.
+                           // Its record is not returned by GetRawInputBuffer, so is fetched with GetRawInputData
+                           // and placed first in the batch.
+        return NULL;
+    HRAWINPUT hRawInput = NULL;
+    if (obrawinput != Py_None && !PyWinObject_AsHANDLE(obrawinput, (HANDLE *)&hRawInput))
+        return NULL;
+    PyRawInputBatch *batch;
+    if (obbatch == Py_None) {
+        batch = PyRawInputBatch::Create(256);
+        if (batch == NULL)
+            return NULL;
+    }
+    else {
+        if (obbatch->ob_type != &PyRawInputBatchType) {
+            PyErr_SetString(PyExc_TypeError, "Batch must be a PyRawInputBatch");
+            return NULL;
+        }
+        batch = (PyRawInputBatch *)obbatch;
+        if (batch->exports > 0 || batch->bBusy) {
+            PyErr_SetString(PyExc_BufferError, "The batch can't be refilled while it is in use");
+            return NULL;
+        }
+        Py_INCREF(batch);
+    }
+    UINT err;
+    batch->bBusy = TRUE;
+    Py_BEGIN_ALLOW_THREADS;
+    err = batch->Fill(hRawInput);
+    Py_END_ALLOW_THREADS;
+    batch->bBusy = FALSE;
+    if (err) {
+        Py_DECREF(batch);
+        return PyWin_SetAPIError("GetRawInputBuffer", err);
+    }
+    return batch;
+}
@@ -0,0 +1,15 @@
+// win32rawinput.h - raw input devices for win32gui
+//
+// Pending WM_INPUT records are drained with GetRawInputBuffer into a reusable
+// PyRawInputBatch, which decodes mouse and keyboard records natively.
+
+#ifndef WIN32RAWINPUT_H
+#define WIN32RAWINPUT_H
+
+extern PyTypeObject PyRawInputBatchType;
+
+PyObject *PyRegisterRawInputDevices(PyObject *self, PyObject *args);
+PyObject *PyGetRegisteredRawInputDevices(PyObject *self, PyObject *args);
+PyObject *PyGetRawInputBuffer(PyObject *self, PyObject *args, PyObject *kwargs);
+
+#endif  // WIN32RAWINPUT_H
@@ -0,0 +1,654 @@
+// win32screencapture.cpp - screen and window capture for win32gui
+//
+// A PyScreenCapture keeps everything a frame needs - the duplication interface
+// and staging texture, or the memory DC and DIB section - for its lifetime, and
+// hands frames out in bytearrays which are reused once the caller lets go of them.
+
+// @doc - Autoduck!
+
+#include "python.h"
+#undef PyHANDLE
+#include <windows.h>
+#include "pywintypes.h"
+#include "structmember.h"
+#include <d3d11.h>
+#include <dxgi1_2.h>
+#include "win32screencapture.h"
+
+// d3d11.dll is loaded on demand, so win32gui still imports where it doesn't exist.
+typedef HRESULT(WINAPI *D3D11CreateDevicefunc)(IDXGIAdapter *, D3D_DRIVER_TYPE, HMODULE, UINT,
+                                               const D3D_FEATURE_LEVEL *, UINT, UINT, ID3D11Device **,
+                                               D3D_FEATURE_LEVEL *, ID3D11DeviceContext **);
+static D3D11CreateDevicefunc pfnD3D11CreateDevice = NULL;
+static BOOL bLoadedD3D11 = FALSE;
+
+#define SAFE_RELEASE(p) \
+    if (p) {            \
+        p->Release();   \
+        p = NULL;       \
+    }
+
+class PyScreenCapture : public PyObject {
+   public:
+    PyScreenCapture();
+    ~PyScreenCapture();
+
+    HRESULT InitDXGI(UINT output);
+    BOOL InitGDI(HWND hwnd, UINT output);
+    void Close();
+    PyObject *GetFrame(DWORD timeout, PyObject *obbuffer);
+
+    /* Python support */
+    static void deallocFunc(PyObject *ob);
+    static PyObject *PyGetFrame(PyObject *self, PyObject *args, PyObject *kwargs);
+    static PyObject *PyClose(PyObject *self, PyObject *args);
+    static struct PyMemberDef members[];
+    static struct PyMethodDef methods[];
+
+    int m_left, m_top, m_width, m_height;
+    int m_bDXGI;
+
+   protected:
+    PyObject *RecycledFrame(Py_ssize_t size);
+    BOOL ResizeGDI(int width, int height);
+    HRESULT CaptureDXGI(DWORD timeout, BYTE *dest, RECT **prects, UINT *pnrects);
+    BOOL CaptureGDI(BYTE *dest);
+
+    BOOL m_busy;             // a frame is being captured without the GIL
+    PyObject *m_frames[2];   // bytearrays handed out by GetFrame, for reuse
+    int m_nextFrame;
+    // DXGI
+    UINT m_output;
+    ID3D11Device *m_device;
+    ID3D11DeviceContext *m_context;
+    IDXGIOutputDuplication *m_dupl;
+    ID3D11Texture2D *m_staging;
+    BYTE *m_metadata;
+    UINT m_metadataSize;
+    BOOL m_haveImage;
+    // GDI
+    HWND m_hwnd;
+    HDC m_hdcMem;
+    HBITMAP m_hbm, m_hbmOld;
+    BYTE *m_bits;
+};
+
+PyScreenCapture::PyScreenCapture()
+{
+    ob_type = &PyScreenCaptureType;
+    _Py_NewReference(this);
+    m_left = m_top = m_width = m_height = 0;
+    m_bDXGI = FALSE;
+    m_busy = FALSE;
+    m_frames[0] = m_frames[1] = NULL;
+    m_nextFrame = 0;
+    m_output = 0;
+    m_device = NULL;
+    m_context = NULL;
+    m_dupl = NULL;
+    m_staging = NULL;
+    m_metadata = NULL;
+    m_metadataSize = 0;
+    m_haveImage = FALSE;
+    m_hwnd = NULL;
+    m_hdcMem = NULL;
+    m_hbm = m_hbmOld = NULL;
+    m_bits = NULL;
+}
+
+PyScreenCapture::~PyScreenCapture()
+{
+    Close();
+    Py_XDECREF(m_frames[0]);
+    Py_XDECREF(m_frames[1]);
+}
+
+void PyScreenCapture::Close()
+{
+    SAFE_RELEASE(m_staging);
+    SAFE_RELEASE(m_dupl);
+    SAFE_RELEASE(m_context);
+    SAFE_RELEASE(m_device);
+    free(m_metadata);
+    m_metadata = NULL;
+    m_metadataSize = 0;
+    if (m_hdcMem) {
+        if (m_hbmOld)
+            SelectObject(m_hdcMem, m_hbmOld);
+        DeleteDC(m_hdcMem);
+        m_hdcMem = NULL;
+    }
+    if (m_hbm) {
+        DeleteObject(m_hbm);
+        m_hbm = m_hbmOld = NULL;
+    }
+    m_bits = NULL;
+}
+
+HRESULT PyScreenCapture::InitDXGI(UINT output)
+{
+    if (!bLoadedD3D11) {
+        bLoadedD3D11 = TRUE;
+        HMODULE hmod = LoadLibrary(TEXT("d3d11.dll"));
+        if (hmod)
+            pfnD3D11CreateDevice = (D3D11CreateDevicefunc)GetProcAddress(hmod, "D3D11CreateDevice");
+    }
+    if (pfnD3D11CreateDevice == NULL)
+        return E_NOTIMPL;
+    m_output = output;
+    HRESULT hr = (*pfnD3D11CreateDevice)(NULL, D3D_DRIVER_TYPE_HARDWARE, NULL, 0, NULL, 0, D3D11_SDK_VERSION,
+                                         &m_device, NULL, &m_context);
+    IDXGIDevice *dxgiDevice = NULL;
+    IDXGIAdapter *adapter = NULL;
+    IDXGIOutput *out = NULL;
+    IDXGIOutput1 *out1 = NULL;
+    if (SUCCEEDED(hr))
+        hr = m_device->QueryInterface(__uuidof(IDXGIDevice), (void **)&dxgiDevice);
+    if (SUCCEEDED(hr))
+        hr = dxgiDevice->GetAdapter(&adapter);
+    if (SUCCEEDED(hr))
+        hr = adapter->EnumOutputs(output, &out);
+    if (SUCCEEDED(hr))
+        hr = out->QueryInterface(__uuidof(IDXGIOutput1), (void **)&out1);
+    if (SUCCEEDED(hr)) {
+        DXGI_OUTPUT_DESC odesc;
+        hr = out->GetDesc(&odesc);
+        m_left = odesc.DesktopCoordinates.left;
+        m_top = odesc.DesktopCoordinates.top;
+    }
+    if (SUCCEEDED(hr))
+        hr = out1->DuplicateOutput(m_device, &m_dupl);
+    if (SUCCEEDED(hr)) {
+        DXGI_OUTDUPL_DESC ddesc;
+        m_dupl->GetDesc(&ddesc);
+        m_width = ddesc.ModeDesc.Width;
+        m_height = ddesc.ModeDesc.Height;
+        D3D11_TEXTURE2D_DESC tdesc;
+        memset(&tdesc, 0, sizeof(tdesc));
+        tdesc.Width = m_width;
+        tdesc.Height = m_height;
+        tdesc.MipLevels = 1;
+        tdesc.ArraySize = 1;
+        tdesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+        tdesc.SampleDesc.Count = 1;
+        tdesc.Usage = D3D11_USAGE_STAGING;
+        tdesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        hr = m_device->CreateTexture2D(&tdesc, NULL, &m_staging);
+    }
+    SAFE_RELEASE(out1);
+    SAFE_RELEASE(out);
+    SAFE_RELEASE(adapter);
+    SAFE_RELEASE(dxgiDevice);
+    if (FAILED(hr))
+        Close();
+    else {
+        m_bDXGI = TRUE;
+        m_haveImage = FALSE;
+    }
+    return hr;
+}
+
+struct PyMonitorSearch {
+    UINT index;
+    UINT upto;
+    RECT rect;
+    BOOL found;
+};
+
+static BOOL CALLBACK PyFindMonitorProc(HMONITOR hmon, HDC hdc, LPRECT prect, LPARAM lParam)
+{
+    PyMonitorSearch *search = (PyMonitorSearch *)lParam;
+    if (search->upto++ != search->index)
+        return TRUE;
+    search->rect = *prect;
+    search->found = TRUE;
+    return FALSE;
+}
+
+BOOL PyScreenCapture::InitGDI(HWND hwnd, UINT output)
+{
+    m_hwnd = hwnd;
+    RECT rc;
+    if (hwnd) {
+        if (!GetWindowRect(hwnd, &rc)) {
+            PyWin_SetAPIError("GetWindowRect");
+            return FALSE;
+        }
+    }
+    else {
+        PyMonitorSearch search = {output, 0};
+        EnumDisplayMonitors(NULL, NULL, PyFindMonitorProc, (LPARAM)&search);
+        if (!search.found) {
+            PyErr_Format(PyExc_ValueError, "There is no display output %u", output);
+            return FALSE;
+        }
+        rc = search.rect;
+    }
+    m_left = rc.left;
+    m_top = rc.top;
+    m_hdcMem = CreateCompatibleDC(NULL);
+    if (m_hdcMem == NULL) {
+        PyWin_SetAPIError("CreateCompatibleDC");
+        return FALSE;
+    }
+    return ResizeGDI(rc.right - rc.left, rc.bottom - rc.top);
+}
+
+// (Re)creates the top-down 32bpp DIB section frames are blitted into.
+BOOL PyScreenCapture::ResizeGDI(int width, int height)
+{
+    if (m_hbm && width == m_width && height == m_height)
+        return TRUE;
+    if (width <= 0 || height <= 0) {
+        PyErr_SetString(PyExc_ValueError, "The window has no area to capture");
+        return FALSE;
+    }
+    BITMAPINFO bmi;
+    memset(&bmi, 0, sizeof(bmi));
+    bmi.bmiHeader.biSize = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth = width;
+    bmi.bmiHeader.biHeight = -height;
+    bmi.bmiHeader.biPlanes = 1;
+    bmi.bmiHeader.biBitCount = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    void *bits = NULL;
+    HBITMAP hbm = CreateDIBSection(m_hdcMem, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+    if (hbm == NULL) {
+        PyWin_SetAPIError("CreateDIBSection");
+        return FALSE;
+    }
+    HBITMAP hbmOld = (HBITMAP)SelectObject(m_hdcMem, hbm);
+    if (m_hbm)
+        DeleteObject(m_hbm);
+    else
+        m_hbmOld = hbmOld;
+    m_hbm = hbm;
+    m_bits = (BYTE *)bits;
+    m_width = width;
+    m_height = height;
+    return TRUE;
+}
+
+// Returns a new reference to a bytearray of 'size' bytes.  A previous frame is reused
+// if nothing but this object refers to it any more.
+PyObject *PyScreenCapture::RecycledFrame(Py_ssize_t size)
+{
+    for (int i = 0; i < 2; i++) {
+        PyObject *frame = m_frames[i];
+        if (frame && Py_REFCNT(frame) == 1 && PyByteArray_GET_SIZE(frame) == size) {
+            Py_INCREF(frame);
+            return frame;
+        }
+    }
+    PyObject *frame = PyByteArray_FromStringAndSize(NULL, size);
+    if (frame == NULL)
+        return NULL;
+    Py_XDECREF(m_frames[m_nextFrame]);
+    m_frames[m_nextFrame] = frame;
+    m_nextFrame = (m_nextFrame + 1) % 2;
+    Py_INCREF(frame);
+    return frame;
+}
+
+// Called without the GIL.  Returns DXGI_ERROR_WAIT_TIMEOUT if the screen hasn't changed.
+HRESULT PyScreenCapture::CaptureDXGI(DWORD timeout, BYTE *dest, RECT **prects, UINT *pnrects)
+{
+    DXGI_OUTDUPL_FRAME_INFO info;
+    IDXGIResource *resource = NULL;
+    HRESULT hr = m_dupl->AcquireNextFrame(timeout, &info, &resource);
+    if (FAILED(hr))
+        return hr;
+    BOOL bNewImage = info.LastPresentTime.QuadPart != 0;
+    BOOL bFirstImage = bNewImage && !m_haveImage;
+    if (bNewImage) {
+        ID3D11Texture2D *texture = NULL;
+        hr = resource->QueryInterface(__uuidof(ID3D11Texture2D), (void **)&texture);
+        if (SUCCEEDED(hr)) {
+            m_context->CopyResource(m_staging, texture);
+            texture->Release();
+            m_haveImage = TRUE;
+        }
+    }
+    resource->Release();
+
+    // Moved regions are reported as dirty at their destination.
+    UINT nmoves = 0, ndirty = 0;
+    BOOL bWhole = bFirstImage || (bNewImage && info.TotalMetadataBufferSize == 0);
+    if (SUCCEEDED(hr) && bNewImage && !bWhole) {
+        if (m_metadataSize < info.TotalMetadataBufferSize) {
+            BYTE *metadata = (BYTE *)realloc(m_metadata, info.TotalMetadataBufferSize);
+            if (metadata == NULL)
+                hr = E_OUTOFMEMORY;
+            else {
+                m_metadata = metadata;
+                m_metadataSize = info.TotalMetadataBufferSize;
+            }
+        }
+        UINT moveBytes = 0, dirtyBytes = 0;
+        if (SUCCEEDED(hr))
+            hr = m_dupl->GetFrameMoveRects(m_metadataSize, (DXGI_OUTDUPL_MOVE_RECT *)m_metadata, &moveBytes);
+        if (SUCCEEDED(hr))
+            hr = m_dupl->GetFrameDirtyRects(m_metadataSize - moveBytes, (RECT *)(m_metadata + moveBytes), &dirtyBytes);
+        nmoves = moveBytes / sizeof(DXGI_OUTDUPL_MOVE_RECT);
+        ndirty = dirtyBytes / sizeof(RECT);
+    }
+    m_dupl->ReleaseFrame();
+    if (FAILED(hr))
+        return hr;
+
+    *pnrects = bWhole ? 1 : nmoves + ndirty;
+    if (*pnrects) {
+        RECT *rects = (RECT *)malloc(*pnrects * sizeof(RECT));
+        if (rects == NULL)
+            return E_OUTOFMEMORY;
+        if (bWhole)
+            SetRect(rects, 0, 0, m_width, m_height);
+        else {
+            DXGI_OUTDUPL_MOVE_RECT *moves = (DXGI_OUTDUPL_MOVE_RECT *)m_metadata;
+            for (UINT i = 0; i < nmoves; i++) rects[i] = moves[i].DestinationRect;
+            memcpy(rects + nmoves, m_metadata + nmoves * sizeof(DXGI_OUTDUPL_MOVE_RECT), ndirty * sizeof(RECT));
+        }
+        *prects = rects;
+    }
+    if (!m_haveImage) {
+        // Only the mouse has changed since the duplication started, so there is no image yet.
+        memset(dest, 0, (size_t)m_width * m_height * 4);
+        return S_OK;
+    }
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    hr = m_context->Map(m_staging, 0, D3D11_MAP_READ, 0, &mapped);
+    if (FAILED(hr))
+        return hr;
+    const BYTE *src = (const BYTE *)mapped.pData;
+    size_t rowBytes = (size_t)m_width * 4;
+    if (mapped.RowPitch == rowBytes)
+        memcpy(dest, src, rowBytes * m_height);
+    else
+        for (int y = 0; y < m_height; y++) memcpy(dest + y * rowBytes, src + (size_t)y * mapped.RowPitch, rowBytes);
+    m_context->Unmap(m_staging, 0);
+    return S_OK;
+}
+
+// Called without the GIL.
+BOOL PyScreenCapture::CaptureGDI(BYTE *dest)
+{
+    HDC hdcSrc = GetWindowDC(m_hwnd);  // the whole screen if m_hwnd is NULL
+    if (hdcSrc == NULL)
+        return FALSE;
+    int x = m_hwnd ? 0 : m_left, y = m_hwnd ? 0 : m_top;
+    BOOL ok = BitBlt(m_hdcMem, 0, 0, m_width, m_height, hdcSrc, x, y, SRCCOPY | CAPTUREBLT);
+    DWORD err = GetLastError();
+    ReleaseDC(m_hwnd, hdcSrc);
+    GdiFlush();
+    if (ok)
+        memcpy(dest, m_bits, (size_t)m_width * m_height * 4);
+    SetLastError(err);
+    return ok;
+}
+
+PyObject *PyScreenCapture::GetFrame(DWORD timeout, PyObject *obbuffer)
+{
+    if (m_busy) {
+        PyErr_SetString(PyExc_RuntimeError, "Another thread is capturing from this object");
+        return NULL;
+    }
+    if (!m_dupl && !m_hdcMem) {
+        if (!m_bDXGI) {
+            PyErr_SetString(PyExc_RuntimeError, "The capture object has been closed");
+            return NULL;
+        }
+        // The duplication was lost (eg, a mode change or the secure desktop) - try to get it back.
+        HRESULT hr;
+        m_busy = TRUE;
+        Py_BEGIN_ALLOW_THREADS;
+        hr = InitDXGI(m_output);
+        Py_END_ALLOW_THREADS;
+        m_busy = FALSE;
+        if (FAILED(hr)) {
+            if (hr == DXGI_ERROR_UNSUPPORTED || hr == E_ACCESSDENIED)
+                Py_RETURN_NONE;  // still on the secure desktop
+            return PyWin_SetAPIError("DuplicateOutput", hr);
+        }
+    }
+    if (m_hwnd) {
+        RECT rc;
+        if (!GetWindowRect(m_hwnd, &rc))
+            return PyWin_SetAPIError("GetWindowRect");
+        m_left = rc.left;
+        m_top = rc.top;
+        if (!ResizeGDI(rc.right - rc.left, rc.bottom - rc.top))
+            return NULL;
+    }
+    Py_ssize_t size = (Py_ssize_t)m_width * m_height * 4;
+    PyObject *frame;
+    Py_buffer view;
+    if (obbuffer == Py_None) {
+        frame = RecycledFrame(size);
+        if (frame == NULL)
+            return NULL;
+    }
+    else {
+        frame = obbuffer;
+        Py_INCREF(frame);
+    }
+    if (PyObject_GetBuffer(frame, &view, PyBUF_WRITABLE) == -1) {
+        Py_DECREF(frame);
+        return NULL;
+    }
+    if (view.len < size) {
+        PyErr_Format(PyExc_ValueError, "The buffer must be at least %zd bytes", size);
+        PyBuffer_Release(&view);
+        Py_DECREF(frame);
+        return NULL;
+    }
+
+    RECT *rects = NULL, whole = {0, 0, m_width, m_height};
+    UINT nrects = 0;
+    HRESULT hr = S_OK;
+    m_busy = TRUE;
+    Py_BEGIN_ALLOW_THREADS;
+    if (m_dupl)
+        hr = CaptureDXGI(timeout, (BYTE *)view.buf, &rects, &nrects);
+    else if (!CaptureGDI((BYTE *)view.buf))
+        hr = HRESULT_FROM_WIN32(GetLastError());
+    Py_END_ALLOW_THREADS;
+    m_busy = FALSE;
+    PyBuffer_Release(&view);
+
+    PyObject *ret = NULL;
+    if (hr == DXGI_ERROR_WAIT_TIMEOUT) {
+        Py_INCREF(Py_None);
+        ret = Py_None;
+    }
+    else if (hr == DXGI_ERROR_ACCESS_LOST) {
+        // Reopened on the next call.
+        Close();
+        Py_INCREF(Py_None);
+        ret = Py_None;
+    }
+    else if (FAILED(hr))
+        PyWin_SetAPIError(m_dupl ? (char *)"AcquireNextFrame" : (char *)"BitBlt", hr);
+    else {
+        if (!m_dupl)
+            nrects = 1;  // GDI doesn't know what changed
+        PyObject *obrects = PyList_New(nrects);
+        for (UINT i = 0; obrects && i < nrects; i++) {
+            RECT *r = rects ? &rects[i] : &whole;
+            PyObject *obrect = Py_BuildValue("llll", r->left, r->top, r->right, r->bottom);
+            if (obrect == NULL)
+                Py_CLEAR(obrects);
+            else
+                PyList_SET_ITEM(obrects, i, obrect);
+        }
+        if (obrects)
+            ret = Py_BuildValue("ON", frame, obrects);
+    }
+    free(rects);
+    Py_DECREF(frame);
+    return ret;
+}
+
+// @pymethod (buffer, [(int, int, int, int), ...])|PyScreenCapture|GetFrame|Captures the next frame.
+// @rdesc The frame, and a list of the (left, top, right, bottom) rectangles which changed since the
+// previous frame, relative to the top-left of the capture.  The frame is 32 bits per pixel, in BGRA
+// order, top row first with no padding between rows.  If the screen hasn't changed within the timeout,
+// or the desktop duplication was interrupted (eg, by a display mode change), None is returned.
+// @comm Unless a buffer is passed, the frame is a bytearray.  Once the caller drops all references
+// to it (including any memoryviews), the same bytearray is filled by a later call rather than a new
+// one allocated.
+// <nl>Captures made with GDI always report the whole area as changed.
+PyObject *PyScreenCapture::PyGetFrame(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"timeout", "buffer", NULL};
+    DWORD timeout = 0;
+    PyObject *obbuffer = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|kO:GetFrame", keywords,
+                                     &timeout,    // @pyparm int|timeout|0|Milliseconds to wait for the screen to change.
+                                                  // Only DXGI captures wait - GDI captures are taken immediately.
+                                     &obbuffer))  // @pyparm buffer|buffer|None|A writable buffer of at least
+                                                  // width*height*4 bytes to fill instead of a recycled bytearray
+        return NULL;
+    return ((PyScreenCapture *)self)->GetFrame(timeout, obbuffer);
+}
+
+// @pymethod |PyScreenCapture|Close|Releases the capture resources.
+// @comm This also happens when the object is destroyed.
+PyObject *PyScreenCapture::PyClose(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":Close"))
+        return NULL;
+    PyScreenCapture *capture = (PyScreenCapture *)self;
+    if (capture->m_busy) {
+        PyErr_SetString(PyExc_RuntimeError, "Another thread is capturing from this object");
+        return NULL;
+    }
+    capture->Close();
+    capture->m_bDXGI = FALSE;
+    Py_RETURN_NONE;
+}
+
+// @object PyScreenCapture|Captures frames from a display output or window.
+// @comm Created by <om win32gui.CreateScreenCapture>.  An object should only be used by one thread at a time.
+struct PyMethodDef PyScreenCapture::methods[] = {
+    {"GetFrame", (PyCFunction)PyScreenCapture::PyGetFrame, METH_VARARGS | METH_KEYWORDS},  // @pymeth GetFrame|Captures the next frame.
+    {"Close", PyScreenCapture::PyClose, METH_VARARGS},  // @pymeth Close|Releases the capture resources.
+    {NULL}};
+
+#undef OFF
+#define OFF(e) offsetof(PyScreenCapture, e)
+
+struct PyMemberDef PyScreenCapture::members[] = {
+    {"left", T_INT, OFF(m_left), READONLY},      // @prop int|left|Desktop coordinate of the left edge of the capture
+    {"top", T_INT, OFF(m_top), READONLY},        // @prop int|top|Desktop coordinate of the top edge of the capture
+    {"width", T_INT, OFF(m_width), READONLY},    // @prop int|width|Width of each frame in pixels
+    {"height", T_INT, OFF(m_height), READONLY},  // @prop int|height|Height of each frame in pixels
+    {"usesDXGI", T_INT, OFF(m_bDXGI), READONLY},  // @prop bool|usesDXGI|True if frames come from DXGI desktop
+                                                 // duplication, False if from GDI.
+    {NULL}};
+
+void PyScreenCapture::deallocFunc(PyObject *ob) { delete (PyScreenCapture *)ob; }
+
+PyTypeObject PyScreenCaptureType = {
+    PYWIN_OBJECT_HEAD "PyScreenCapture",
+    sizeof(PyScreenCapture),
+    0,
+    PyScreenCapture::deallocFunc, /* tp_dealloc */
+    0,                            /* tp_print */
+    0,                            /* tp_getattr */
+    0,                            /* tp_setattr */
+    0,                            /* tp_compare */
+    0,                            /* tp_repr */
+    0,                            /* tp_as_number */
+    0,                            /* tp_as_sequence */
+    0,                            /* tp_as_mapping */
+    0,                            /* tp_hash */
+    0,                            /* tp_call */
+    0,                            /* tp_str */
+    PyObject_GenericGetAttr,      /* tp_getattro */
+    0,                            /* tp_setattro */
+    0,                            /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,           /* tp_flags */
+    0,                            /* tp_doc */
+    0,                            /* tp_traverse */
+    0,                            /* tp_clear */
+    0,                            /* tp_richcompare */
+    0,                            /* tp_weaklistoffset */
+    0,                            /* tp_iter */
+    0,                            /* tp_iternext */
+    PyScreenCapture::methods,     /* tp_methods */
+    PyScreenCapture::members,     /* tp_members */
+    0,                            /* tp_getset */
+    0,                            /* tp_base */
+    0,                            /* tp_dict */
+    0,                            /* tp_descr_get */
+    0,                            /* tp_descr_set */
+    0,                            /* tp_dictoffset */
+    0,                            /* tp_init */
+    0,                            /* tp_alloc */
+    0,                            /* tp_new */
+};
+
+// @pyswig <o PyScreenCapture>|CreateScreenCapture|Creates an object which captures frames from a display
+// output or a window.
+// @comm Whole outputs are captured with DXGI desktop duplication (Windows 8 and later) where possible,
+// which only copies frames when the screen changes and reports what changed.  Otherwise, and for
+// windows, frames are copied with BitBlt from the window or screen DC into a DIB section which is kept
+// for the life of the object.
+// <nl>DXGI outputs are numbered as the default adapter enumerates them, GDI outputs in the order of
+// <om win32api.EnumDisplayMonitors>.
+PyObject *PyCreateScreenCapture(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"output", "hwnd", "method", NULL};
+    UINT output = 0;
+    PyObject *obhwnd = Py_None;
+    char *method = NULL;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|IOz:CreateScreenCapture", keywords,
+                                     &output,  // @pyparm int|output|0|Index of the display output to capture
+                                     &obhwnd,  // @pyparm <o PyHANDLE>|hwnd|None|A window to capture instead of an output.
+                                               // The window's frame is included, and the capture follows its size.
+                                     &method))  // @pyparm str|method|None|'dxgi' or 'gdi' to require one way of
+                                                // capturing.  By default DXGI is used when available.
+        return NULL;
+    HWND hwnd = NULL;
+    if (obhwnd != Py_None && !PyWinObject_AsHANDLE(obhwnd, (HANDLE *)&hwnd))
+        return NULL;
+    BOOL bDXGI;
+    if (method == NULL)
+        bDXGI = hwnd == NULL;
+    else if (strcmp(method, "dxgi") == 0) {
+        if (hwnd) {
+            PyErr_SetString(PyExc_ValueError, "Windows can only be captured with 'gdi'");
+            return NULL;
+        }
+        bDXGI = TRUE;
+    }
+    else if (strcmp(method, "gdi") == 0)
+        bDXGI = FALSE;
+    else
+        return PyErr_Format(PyExc_ValueError, "Unknown capture method '%s'", method);
+
+    PyScreenCapture *capture = new PyScreenCapture();
+    if (capture == NULL)
+        return PyErr_NoMemory();
+    if (bDXGI) {
+        HRESULT hr;
+        Py_BEGIN_ALLOW_THREADS;
+        hr = capture->InitDXGI(output);
+        Py_END_ALLOW_THREADS;
+        if (SUCCEEDED(hr))
+            return capture;
+        if (method) {
+            Py_DECREF(capture);
+            if (hr == E_NOTIMPL)
+                return PyErr_Format(PyExc_NotImplementedError, "DXGI desktop duplication is not available");
+            return PyWin_SetAPIError("DuplicateOutput", hr);
+        }
+        // fall back to GDI
+        capture->m_bDXGI = FALSE;
+    }
+    if (!capture->InitGDI(hwnd, output)) {
+        Py_DECREF(capture);
+        return NULL;
+    }
+    return capture;
+}
@@ -0,0 +1,13 @@
+// win32screencapture.h - screen and window capture for win32gui
+//
+// Frames come from DXGI desktop duplication when it is available, otherwise
+// from GDI BitBlt.
+
+#ifndef WIN32SCREENCAPTURE_H
+#define WIN32SCREENCAPTURE_H
+
+extern PyTypeObject PyScreenCaptureType;
+
+PyObject *PyCreateScreenCapture(PyObject *self, PyObject *args, PyObject *kwargs);
+
+#endif  // WIN32SCREENCAPTURE_H
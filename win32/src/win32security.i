@@ -51,6 +51,9 @@ static LsaRegisterPolicyChangeNotificationfunc pfnLsaUnregisterPolicyChangeNotif
 typedef BOOL (WINAPI *CryptEnumProvidersfunc)(DWORD, DWORD *, DWORD, DWORD *, LPTSTR, DWORD *);
 static CryptEnumProvidersfunc pfnCryptEnumProviders=NULL;
 
+typedef NTSTATUS (WINAPI *LsaLookupSids2func)(LSA_HANDLE, ULONG, ULONG, PSID *, PLSA_REFERENCED_DOMAIN_LIST *, PLSA_TRANSLATED_NAME *);
+static LsaLookupSids2func pfnLsaLookupSids2=NULL;
+
 typedef BOOL (WINAPI *CheckTokenMembershipfunc)(HANDLE, PSID, PBOOL);
 static CheckTokenMembershipfunc pfnCheckTokenMembership=NULL;
 typedef BOOL (WINAPI *CreateRestrictedTokenfunc)(HANDLE,DWORD,DWORD,PSID_AND_ATTRIBUTES,
@@ -770,6 +773,7 @@ void PyWinObject_FreeTOKEN_PRIVILEGES(TOKEN_PRIVILEGES *pPriv)
 	netapi32_dll =loadmodule(_T("netapi32.dll"));
 	
 	pfnCheckTokenMembership=(CheckTokenMembershipfunc)loadapifunc("CheckTokenMembership", advapi32_dll);
+	pfnLsaLookupSids2=(LsaLookupSids2func)loadapifunc("LsaLookupSids2", advapi32_dll);
 	pfnCreateRestrictedToken=(CreateRestrictedTokenfunc)loadapifunc("CreateRestrictedToken", advapi32_dll);
 
 	pfnCryptEnumProviders=(CryptEnumProvidersfunc)loadapifunc("CryptEnumProvidersW", advapi32_dll);
@@ -840,6 +844,8 @@ void PyWinObject_FreeTOKEN_PRIVILEGES(TOKEN_PRIVILEGES *pPriv)
 		return NULL;
 	if (PyType_Ready(&PyCredHandleType) == -1)
 		return NULL;
+	if (PyType_Ready(&PySecureChannelType) == -1)
+		return NULL;
 #endif
 
 	// old names, these should not be used
@@ -852,10 +858,12 @@ void PyWinObject_FreeTOKEN_PRIVILEGES(TOKEN_PRIVILEGES *pPriv)
 	PyDict_SetItemString(d, "PySecBufferDescType", (PyObject *)&PySecBufferDescType);
 	PyDict_SetItemString(d, "PyCtxtHandleType", (PyObject *)&PyCtxtHandleType);
 	PyDict_SetItemString(d, "PyCredHandleType", (PyObject *)&PyCredHandleType);
+	PyDict_SetItemString(d, "PySecureChannelType", (PyObject *)&PySecureChannelType);
 
     // Patch up any kwarg functions - SWIG doesn't like them.
     for (PyMethodDef *pmd = win32securityMethods;pmd->ml_name;pmd++)
         if   ((strcmp(pmd->ml_name, "DsGetDcName")==0)
+			||(strcmp(pmd->ml_name, "SetAccountSidCache")==0)
 			||(strcmp(pmd->ml_name, "DuplicateTokenEx")==0) 
 			||(strcmp(pmd->ml_name, "AdjustTokenPrivileges")==0)
 			||(strcmp(pmd->ml_name, "AdjustTokenGroups")==0)
@@ -864,6 +872,7 @@ void PyWinObject_FreeTOKEN_PRIVILEGES(TOKEN_PRIVILEGES *pPriv)
 			||(strcmp(pmd->ml_name, "LsaRemoveAccountRights")==0)
 			||(strcmp(pmd->ml_name, "LogonUser")==0)
 			||(strcmp(pmd->ml_name, "LogonUserEx")==0)
+			||(strcmp(pmd->ml_name, "CreateSecureChannel")==0)
 			){
 			pmd->ml_flags = METH_VARARGS | METH_KEYWORDS;
 			}
@@ -955,6 +964,22 @@ void PyWinObject_FreeTOKEN_PRIVILEGES(TOKEN_PRIVILEGES *pPriv)
 // @pyswig [ <o PyDS_NAME_RESULT_ITEM>, ...]|DsListDomainsInSite|
 // @pyparm <o PyDS_HANDLE>|hds||Directory service handle as returned by <om win32security.DsBind>
 
+%native (ScanSecurityDescriptors) extern PyObject *PyScanSecurityDescriptors(PyObject *self, PyObject *args);
+// @pyswig ([<o PySECURITY_DESCRIPTOR>, ...], [(str, int), ...], [(str, int), ...])|ScanSecurityDescriptors|Reads the security
+// descriptors of every file and directory in a tree, using a pool of threads.
+// @pyparm <o PyUnicode>|Path||File or directory to start from.  Use a \\?\ prefix for trees with long paths.
+// @pyparm int|SecurityInformation|OWNER_SECURITY_INFORMATION \| GROUP_SECURITY_INFORMATION \| DACL_SECURITY_INFORMATION|
+// Parts of the security descriptors to read.  SACL_SECURITY_INFORMATION requires SeSecurityPrivilege.
+// @pyparm int|Threads|8|Number of threads walking the tree, at most 64
+// @rdesc Returns a tuple of (SecurityDescriptors, Files, Errors).  SecurityDescriptors holds each distinct
+// security descriptor found, once.  Files is a list of (path, index) with the index of each path's descriptor
+// in SecurityDescriptors.  Errors is a list of (path, winerror) for each descriptor that couldn't be read or
+// directory that couldn't be listed.
+// @comm Files are opened with backup semantics, so if SeBackupPrivilege is enabled descriptors can be read
+// regardless of the DACL.  Identical descriptors, which inherited ACLs normally produce, are only returned once.
+// The GIL is released for the whole scan, and the order of Files is not defined.
+// @comm Junctions and symbolic links are reported but not followed.
+
 // @pyswig PyACL|ACL|Creates a new <o PyACL> object.
 // @pyparm int|bufSize|64|The size of the buffer for the ACL.
 %native(ACL) PyWinMethod_NewACL;
@@ -1191,8 +1216,93 @@ done:
 }
 %}
 
+%{
+// Optional process-wide cache of SID lookups, used by LookupAccountSid
+// and LookupAccountSids.  Keys are (system name, SID bytes), values are
+// (name, domain, type, error, expiry tick).  Only ERROR_NONE_MAPPED is
+// cached as a failure, since anything else may well be transient.
+static PyObject *sid_cache = NULL;
+static DWORD sid_cache_timeout = 0;
+static DWORD sid_cache_negative_timeout = 0;
+static DWORD sid_cache_max_entries = 0;
+
+static PyObject *SidCacheKey(PyObject *obSystemName, PSID psid)
+{
+	if (sid_cache == NULL)
+		return NULL;
+	PyObject *ret = Py_BuildValue("ON", obSystemName, PyBytes_FromStringAndSize((char *)psid, GetLengthSid(psid)));
+	if (ret == NULL)
+		PyErr_Clear();
+	return ret;
+}
+
+// Returns a borrowed reference to a live cache entry, or NULL if there isn't one.
+// The cache is only an optimization, so never sets an exception.
+static PyObject *SidCacheGet(PyObject *key)
+{
+	if (sid_cache == NULL || key == NULL)
+		return NULL;
+	PyObject *entry = PyDict_GetItem(sid_cache, key);
+	if (entry == NULL)
+		return NULL;
+	if (PyLong_AsUnsignedLongLong(PyTuple_GET_ITEM(entry, 4)) > GetTickCount64())
+		return entry;
+	PyDict_DelItem(sid_cache, key);
+	PyErr_Clear();
+	return NULL;
+}
+
+static void SidCacheSet(PyObject *key, PyObject *obName, PyObject *obDomain, SID_NAME_USE sidType, DWORD err)
+{
+	if (sid_cache == NULL || key == NULL)
+		return;
+	DWORD timeout = err ? sid_cache_negative_timeout : sid_cache_timeout;
+	if (timeout == 0)
+		return;
+	// No attempt at LRU - when it fills up, just start again
+	if (sid_cache_max_entries && (DWORD)PyDict_Size(sid_cache) >= sid_cache_max_entries)
+		PyDict_Clear(sid_cache);
+	PyObject *entry = Py_BuildValue("OOlkK", obName, obDomain, sidType, err, GetTickCount64() + timeout);
+	if (entry == NULL || PyDict_SetItem(sid_cache, key, entry) == -1)
+		PyErr_Clear();
+	Py_XDECREF(entry);
+}
+%}
+
+// @pyswig |SetAccountSidCache|Configures a process-wide cache of the results of
+// <om win32security.LookupAccountSid> and <om win32security.LookupAccountSids>.
+// @comm The cache is disabled by default.  Any existing entries are discarded each time this is called.
+// @comm Entries are keyed on both the system name and the SID, so lookups on different servers
+// are cached separately.  Failures other than ERROR_NONE_MAPPED are never cached.
+%native(SetAccountSidCache) pfnPySetAccountSidCache;
+%{
+static PyObject *PySetAccountSidCache(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[] = {"Timeout", "NegativeTimeout", "MaxEntries", NULL};
+	DWORD timeout, negative_timeout = 0, max_entries = 100000;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "k|kk:SetAccountSidCache", keywords,
+		&timeout,			// @pyparm int|Timeout||Milliseconds for which a resolved SID is remembered, or 0 to disable the cache
+		&negative_timeout,	// @pyparm int|NegativeTimeout|0|Milliseconds for which a SID that couldn't be mapped is remembered
+		&max_entries))		// @pyparm int|MaxEntries|100000|Cache is emptied when it reaches this size, 0 for no limit
+		return NULL;
+	Py_CLEAR(sid_cache);
+	if (timeout || negative_timeout) {
+		sid_cache = PyDict_New();
+		if (sid_cache == NULL)
+			return NULL;
+		}
+	sid_cache_timeout = timeout;
+	sid_cache_negative_timeout = negative_timeout;
+	sid_cache_max_entries = max_entries;
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+PyCFunction pfnPySetAccountSidCache=(PyCFunction)PySetAccountSidCache;
+%}
+
 // @pyswig string, string, int|LookupAccountSid|Accepts a security identifier (SID) as input. It retrieves the name of the account for this SID and the name of the first domain on which this SID is found.
 // @rdesc The result is a tuple of the name, the domain name where the account was found, and the type of account the SID is for.
+// @comm If enabled by <om win32security.SetAccountSidCache>, results are served from the cache.
 %native(LookupAccountSid) LookupAccountSid;
 %{
 PyObject *LookupAccountSid(PyObject *self, PyObject *args)
@@ -1209,6 +1319,7 @@ PyObject *LookupAccountSid(PyObject *self, PyObject *args)
 	PyObject *obSid;
 	SID_NAME_USE sidType;
 	PyObject *result = NULL;
+	PyObject *obKey = NULL, *obCached;
 
 	if (!PyArg_ParseTuple(args, "OO:LookupAccountSid", 
 	                 &obSystemName, // @pyparm string|systemName||The system name, or None
@@ -1221,27 +1332,170 @@ PyObject *LookupAccountSid(PyObject *self, PyObject *args)
 	if (!PyWinObject_AsSID(obSid, &pSid))
 		goto done;
 
+	obKey = SidCacheKey(obSystemName, pSid);
+	obCached = SidCacheGet(obKey);
+	if (obCached) {
+		DWORD err = PyLong_AsUnsignedLong(PyTuple_GET_ITEM(obCached, 3));
+		if (err)
+			PyWin_SetAPIError("LookupAccountSid", err);
+		else
+			result = PyTuple_GetSlice(obCached, 0, 3);
+		goto done;
+	}
+
         BOOL ok;
         Py_BEGIN_ALLOW_THREADS
         ok = LookupAccountSid(szSystemName, pSid, szRetAcctName, &retAcctNameSize, refDomain, &refDomainSize, &sidType);
         Py_END_ALLOW_THREADS
 
 	if (!ok) {
-		PyWin_SetAPIError("LookupAccountSid");
+		DWORD err = GetLastError();
+		if (err == ERROR_NONE_MAPPED)
+			SidCacheSet(obKey, Py_None, Py_None, SidTypeUnknown, err);
+		PyWin_SetAPIError("LookupAccountSid", err);
 		goto done;
 	}
 	obRetAcctName = PyWinObject_FromTCHAR(szRetAcctName);
 	obDomain = PyWinObject_FromTCHAR(refDomain);
 	result = Py_BuildValue("OOl", obRetAcctName, obDomain, sidType);
+	if (result)
+		SidCacheSet(obKey, obRetAcctName, obDomain, sidType, 0);
 
 done:
 	PyWinObject_FreeTCHAR(szSystemName);
 	Py_XDECREF(obRetAcctName);
 	Py_XDECREF(obDomain);
+	Py_XDECREF(obKey);
 	return result;
 }
 %}
 
+// @pyswig [(string, string, int),...]|LookupAccountSids|Resolves a batch of SIDs to account names in a single call
+// @rdesc Returns a list with a (name, domain, type) tuple for each SID, in the same order.  SIDs that
+// can't be mapped give (None, None, SidTypeUnknown) rather than raising an error.
+// @comm Uses LsaLookupSids2 against a single policy handle, so the whole batch costs one round trip
+// to the LSA instead of one per SID.  If enabled by <om win32security.SetAccountSidCache>,
+// only SIDs missing from the cache are looked up.
+%native(LookupAccountSids) PyLookupAccountSids;
+%{
+static PyObject *PyLookupAccountSids(PyObject *self, PyObject *args)
+{
+	PyObject *obSystemName, *obSids, *obsids_tuple = NULL, *ret = NULL;
+	DWORD options = 0, sid_cnt, lookup_cnt = 0, i;
+	PSID *psids = NULL;
+	DWORD *lookup_index = NULL;
+	PyObject **keys = NULL;
+	LSA_UNICODE_STRING system_name = {0};
+	LSA_OBJECT_ATTRIBUTES ObjectAttributes;
+	LSA_HANDLE hpolicy = NULL;
+	PLSA_REFERENCED_DOMAIN_LIST domains = NULL;
+	PLSA_TRANSLATED_NAME names = NULL;
+	NTSTATUS ntstatus;
+	CHECK_PFN(LsaLookupSids2);
+	if (!PyArg_ParseTuple(args, "OO|k:LookupAccountSids",
+		&obSystemName,	// @pyparm string|SystemName||The system to perform the lookup on, or None for the local machine
+		&obSids,		// @pyparm [<o PySID>,...]|Sids||Sequence of SIDs to look up
+		&options))		// @pyparm int|LookupOptions|0|LSA_LOOKUP_* flags for LsaLookupSids2
+		return NULL;
+	if (!PyWinObject_AsLSA_UNICODE_STRING(obSystemName, &system_name, TRUE))
+		return NULL;
+	obsids_tuple = PyWinSequence_Tuple(obSids, &sid_cnt);
+	if (obsids_tuple == NULL)
+		goto done;
+	ret = PyList_New(sid_cnt);
+	psids = (PSID *)malloc(max(sid_cnt, 1) * sizeof(PSID));
+	lookup_index = (DWORD *)malloc(max(sid_cnt, 1) * sizeof(DWORD));
+	keys = (PyObject **)calloc(max(sid_cnt, 1), sizeof(PyObject *));
+	if (ret == NULL || psids == NULL || lookup_index == NULL || keys == NULL) {
+		PyErr_NoMemory();
+		goto done;
+		}
+	// Fill in what we can from the cache, and collect the rest for a single LSA call
+	for (i = 0; i < sid_cnt; i++) {
+		PSID psid;
+		if (!PyWinObject_AsSID(PyTuple_GET_ITEM(obsids_tuple, i), &psid))
+			goto done;
+		keys[i] = SidCacheKey(obSystemName, psid);
+		PyObject *obCached = SidCacheGet(keys[i]);
+		if (obCached) {
+			PyObject *item = PyTuple_GetSlice(obCached, 0, 3);
+			if (item == NULL)
+				goto done;
+			PyList_SET_ITEM(ret, i, item);
+			}
+		else {
+			psids[lookup_cnt] = psid;
+			lookup_index[lookup_cnt++] = i;
+			}
+		}
+
+	if (lookup_cnt) {
+		ZeroMemory(&ObjectAttributes, sizeof(ObjectAttributes));
+		Py_BEGIN_ALLOW_THREADS
+		ntstatus = LsaOpenPolicy(&system_name, &ObjectAttributes, POLICY_LOOKUP_NAMES, &hpolicy);
+		if (ntstatus == STATUS_SUCCESS)
+			ntstatus = (*pfnLsaLookupSids2)(hpolicy, options, lookup_cnt, psids, &domains, &names);
+		Py_END_ALLOW_THREADS
+		DWORD err = LsaNtStatusToWinError(ntstatus);
+		// Output buffers are still allocated when some or none of the SIDs could be mapped
+		if (err != ERROR_SUCCESS && err != ERROR_SOME_NOT_MAPPED && err != ERROR_NONE_MAPPED) {
+			PyWin_SetAPIError(hpolicy ? "LsaLookupSids2" : "LsaOpenPolicy", err);
+			goto done;
+			}
+		for (i = 0; i < lookup_cnt; i++) {
+			DWORD sid_ind = lookup_index[i];
+			PyObject *item;
+			if (names[i].Use == SidTypeUnknown || names[i].Use == SidTypeInvalid) {
+				item = Py_BuildValue("OOl", Py_None, Py_None, SidTypeUnknown);
+				if (item)
+					SidCacheSet(keys[sid_ind], Py_None, Py_None, SidTypeUnknown, ERROR_NONE_MAPPED);
+				}
+			else {
+				PyObject *obName = PyWinObject_FromLSA_UNICODE_STRING(names[i].Name);
+				PyObject *obDomain = names[i].DomainIndex >= 0
+					? PyWinObject_FromLSA_UNICODE_STRING(domains->Domains[names[i].DomainIndex].Name)
+					: PyWinObject_FromWCHAR(L"");
+				item = NULL;
+				if (obName && obDomain) {
+					item = Py_BuildValue("OOl", obName, obDomain, names[i].Use);
+					if (item)
+						SidCacheSet(keys[sid_ind], obName, obDomain, names[i].Use, 0);
+					}
+				Py_XDECREF(obName);
+				Py_XDECREF(obDomain);
+				}
+			if (item == NULL)
+				goto done;
+			PyList_SET_ITEM(ret, sid_ind, item);
+			}
+		}
+	Py_DECREF(obsids_tuple);
+	obsids_tuple = NULL;
+
+done:
+	if (PyErr_Occurred())
+		Py_CLEAR(ret);
+	Py_XDECREF(obsids_tuple);
+	if (keys) {
+		for (i = 0; i < sid_cnt; i++)
+			Py_XDECREF(keys[i]);
+		free(keys);
+		}
+	if (psids)
+		free(psids);
+	if (lookup_index)
+		free(lookup_index);
+	if (names)
+		LsaFreeMemory(names);
+	if (domains)
+		LsaFreeMemory(domains);
+	if (hpolicy)
+		LsaClose(hpolicy);
+	PyWinObject_FreeWCHAR(system_name.Buffer);
+	return ret;
+}
+%}
+
 %{/* from MS knowledge base article Q198907
     GetBinarySid() accepts a buffer that contains the textual
     representation of a SID. This function returns NULL
@@ -3613,6 +3867,25 @@ void PyWinObject_FreeSEC_WINNT_AUTH_IDENTITY(PSEC_WINNT_AUTH_IDENTITY_W pAuthDat
 
 %}
 
+%{
+// work around issues with SWIG and kwargs.
+#define PYCREATESECURECHANNEL (PyCFunction)PyCreateSecureChannel
+%}
+%native (CreateSecureChannel) PYCREATESECURECHANNEL;
+// @pyswig <o PySecureChannel>|CreateSecureChannel|Creates a TLS connection over a connected socket
+// @comm This function supports keyword arguments.  No network traffic happens until the handshake, which is done
+// by <om PySecureChannel.Handshake> or by the first read or write.
+// <nl>Client credentials are usually created with <om win32security.AcquireCredentialsHandle> for the
+// "Microsoft Unified Security Protocol Provider" package, with SECPKG_CRED_OUTBOUND and no AuthData.
+// A server needs credentials that include its certificate.
+// @pyparm <o PySocket>|Socket||A connected, blocking socket, or its handle
+// @pyparm <o PyCredHandle>|Credentials||Schannel credentials.  They must stay valid while the channel is in use.
+// @pyparm <o PyUnicode>|TargetName|None|For a client, the name of the server.  This is checked against its
+// certificate and sent for SNI.
+// @pyparm boolean|Server|False|True to accept a connection, False to initiate one
+// @pyparm int|ContextReq|0|Additional ISC_REQ_* or ASC_REQ_* flags.  Stream mode, confidentiality, replay and sequence
+// detection are always requested.
+
 // @pyswig (<o PyCredHandle>,<o PyDateTime>)|AcquireCredentialsHandle|Creates a handle to credentials for use with SSPI
 // @rdesc Returns credential handle and credential's expiration time
 %native(AcquireCredentialsHandle) PyAcquireCredentialsHandle;
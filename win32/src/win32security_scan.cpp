@@ -0,0 +1,404 @@
+// This file is not processed by Autoduck.  Tags for objects and functions are in win32security.i.
+
+// Native implementation of ScanSecurityDescriptors.  A pool of threads walks
+// a directory tree reading the security descriptor of every file and
+// directory, and identical descriptors (the norm for inherited ACLs) are
+// stored only once.  Nothing touches Python until the walk is finished.
+
+#include "PyWinTypes.h"
+#include "PyWinObjects.h"
+#include "PySecurityObjects.h"
+
+// Prime, so the low bits of the hash don't matter too much
+#define SCAN_BUCKETS 4099
+#define SCAN_MAX_THREADS MAXIMUM_WAIT_OBJECTS
+
+struct SCAN_SD {
+    DWORD hash;
+    DWORD len;
+    DWORD index;
+    SCAN_SD *next;
+    BYTE sd[1];  // Self-relative, len bytes - allocated along with the struct
+};
+
+// A file or directory, with either the index of its descriptor or an error
+struct SCAN_FILE {
+    WCHAR *path;
+    LONG index;
+    DWORD err;
+};
+
+struct SCAN_DIR {
+    WCHAR *path;
+    SCAN_DIR *next;
+};
+
+struct SCAN_STATE {
+    CRITICAL_SECTION cs;
+    HANDLE hwork;  // Semaphore, counts directories waiting in the queue
+    HANDLE hdone;  // Manual-reset, set once every directory has been listed
+    SECURITY_INFORMATION secinfo;
+    DWORD access;
+    SCAN_DIR *dirs;
+    LONG outstanding;  // Directories queued or being listed
+    SCAN_SD *buckets[SCAN_BUCKETS];
+    SCAN_SD **sds;  // By index
+    DWORD numsds, sdcap;
+    SCAN_FILE *files;
+    DWORD numfiles, filecap;
+    BOOL bOutOfMemory;
+};
+
+static WCHAR *ScanJoinPath(const WCHAR *dir, const WCHAR *name)
+{
+    size_t dirlen = wcslen(dir), namelen = wcslen(name);
+    BOOL bsep = dirlen && dir[dirlen - 1] != L'\\' && dir[dirlen - 1] != L'/';
+    WCHAR *ret = (WCHAR *)malloc((dirlen + bsep + namelen + 1) * sizeof(WCHAR));
+    if (ret == NULL)
+        return NULL;
+    memcpy(ret, dir, dirlen * sizeof(WCHAR));
+    if (bsep)
+        ret[dirlen++] = L'\\';
+    memcpy(ret + dirlen, name, (namelen + 1) * sizeof(WCHAR));
+    return ret;
+}
+
+// Paths are freed by the worker threads, so live on the C heap rather than Python's
+static WCHAR *ScanCopyPath(const WCHAR *path)
+{
+    size_t len = (wcslen(path) + 1) * sizeof(WCHAR);
+    WCHAR *ret = (WCHAR *)malloc(len);
+    if (ret)
+        memcpy(ret, path, len);
+    return ret;
+}
+
+// FNV-1a
+static DWORD ScanHash(const BYTE *p, DWORD len)
+{
+    DWORD hash = 2166136261U;
+    for (DWORD i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+// Returns the index of an existing identical descriptor, or adds a new one.
+// Called with the lock held.
+static LONG ScanAddSD(SCAN_STATE *state, BYTE *sd, DWORD len)
+{
+    DWORD hash = ScanHash(sd, len);
+    SCAN_SD **bucket = &state->buckets[hash % SCAN_BUCKETS];
+    SCAN_SD *entry;
+    for (entry = *bucket; entry; entry = entry->next)
+        if (entry->hash == hash && entry->len == len && memcmp(entry->sd, sd, len) == 0)
+            return entry->index;
+    if (state->numsds == state->sdcap) {
+        DWORD newcap = state->sdcap ? state->sdcap * 2 : 64;
+        SCAN_SD **newsds = (SCAN_SD **)realloc(state->sds, newcap * sizeof(SCAN_SD *));
+        if (newsds == NULL)
+            return -1;
+        state->sds = newsds;
+        state->sdcap = newcap;
+    }
+    entry = (SCAN_SD *)malloc(offsetof(SCAN_SD, sd) + len);
+    if (entry == NULL)
+        return -1;
+    entry->hash = hash;
+    entry->len = len;
+    entry->index = state->numsds;
+    memcpy(entry->sd, sd, len);
+    entry->next = *bucket;
+    *bucket = entry;
+    state->sds[state->numsds++] = entry;
+    return entry->index;
+}
+
+// Records the result for a path, taking ownership of it.  Called with the lock held.
+static void ScanAddFile(SCAN_STATE *state, WCHAR *path, LONG index, DWORD err)
+{
+    if (state->numfiles == state->filecap) {
+        DWORD newcap = state->filecap ? state->filecap * 2 : 1024;
+        SCAN_FILE *newfiles = (SCAN_FILE *)realloc(state->files, newcap * sizeof(SCAN_FILE));
+        if (newfiles == NULL) {
+            state->bOutOfMemory = TRUE;
+            free(path);
+            return;
+        }
+        state->files = newfiles;
+        state->filecap = newcap;
+    }
+    SCAN_FILE *file = &state->files[state->numfiles++];
+    file->path = path;
+    file->index = index;
+    file->err = err;
+}
+
+// Reads the descriptor of a single file or directory.  *buf is reused between calls, and grown as needed.
+static void ScanFile(SCAN_STATE *state, WCHAR *path, BYTE **buf, DWORD *bufsize)
+{
+    DWORD err = 0, needed = 0;
+    // Backup semantics both allow directories to be opened, and bypass the DACL when
+    // the caller has enabled SeBackupPrivilege.
+    HANDLE h = CreateFileW(path, state->access, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                           OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OPEN_REPARSE_POINT, NULL);
+    if (h == INVALID_HANDLE_VALUE)
+        err = GetLastError();
+    else {
+        while (!GetKernelObjectSecurity(h, state->secinfo, *buf, *bufsize, &needed)) {
+            err = GetLastError();
+            if (err != ERROR_INSUFFICIENT_BUFFER)
+                break;
+            BYTE *newbuf = (BYTE *)realloc(*buf, needed);
+            if (newbuf == NULL)
+                break;
+            *buf = newbuf;
+            *bufsize = needed;
+            err = 0;
+        }
+        CloseHandle(h);
+    }
+    EnterCriticalSection(&state->cs);
+    LONG index = -1;
+    if (err == 0) {
+        index = ScanAddSD(state, *buf, GetSecurityDescriptorLength(*buf));
+        if (index == -1)
+            err = ERROR_NOT_ENOUGH_MEMORY;
+    }
+    if (err == ERROR_NOT_ENOUGH_MEMORY)
+        state->bOutOfMemory = TRUE;
+    ScanAddFile(state, path, index, err);
+    LeaveCriticalSection(&state->cs);
+}
+
+// Queues a directory to be listed, taking ownership of the path
+static void ScanPushDir(SCAN_STATE *state, WCHAR *path)
+{
+    SCAN_DIR *dir = (SCAN_DIR *)malloc(sizeof(SCAN_DIR));
+    EnterCriticalSection(&state->cs);
+    if (dir == NULL) {
+        state->bOutOfMemory = TRUE;
+        LeaveCriticalSection(&state->cs);
+        free(path);
+        return;
+    }
+    dir->path = path;
+    dir->next = state->dirs;
+    state->dirs = dir;
+    state->outstanding++;
+    LeaveCriticalSection(&state->cs);
+    ReleaseSemaphore(state->hwork, 1, NULL);
+}
+
+static void ScanDir(SCAN_STATE *state, WCHAR *dirpath, BYTE **buf, DWORD *bufsize)
+{
+    WIN32_FIND_DATAW fd;
+    WCHAR *pattern = ScanJoinPath(dirpath, L"*");
+    if (pattern == NULL) {
+        state->bOutOfMemory = TRUE;
+        return;
+    }
+    HANDLE hfind = FindFirstFileExW(pattern, FindExInfoBasic, &fd, FindExSearchNameMatch, NULL,
+                                    FIND_FIRST_EX_LARGE_FETCH);
+    free(pattern);
+    if (hfind == INVALID_HANDLE_VALUE) {
+        DWORD err = GetLastError();
+        // The directory itself has already been recorded, so this is a second entry for the same path
+        WCHAR *path = ScanCopyPath(dirpath);
+        EnterCriticalSection(&state->cs);
+        if (path)
+            ScanAddFile(state, path, -1, err);
+        else
+            state->bOutOfMemory = TRUE;
+        LeaveCriticalSection(&state->cs);
+        return;
+    }
+    do {
+        if (wcscmp(fd.cFileName, L".") == 0 || wcscmp(fd.cFileName, L"..") == 0)
+            continue;
+        WCHAR *path = ScanJoinPath(dirpath, fd.cFileName);
+        if (path == NULL) {
+            state->bOutOfMemory = TRUE;
+            continue;
+        }
+        ScanFile(state, path, buf, bufsize);
+        // Junctions and symlinks are reported, but not followed
+        if ((fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && !(fd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)) {
+            WCHAR *subdir = ScanJoinPath(dirpath, fd.cFileName);
+            if (subdir)
+                ScanPushDir(state, subdir);
+            else
+                state->bOutOfMemory = TRUE;
+        }
+    } while (FindNextFileW(hfind, &fd));
+    FindClose(hfind);
+}
+
+static DWORD WINAPI ScanThread(LPVOID param)
+{
+    SCAN_STATE *state = (SCAN_STATE *)param;
+    HANDLE waits[2] = {state->hwork, state->hdone};
+    DWORD bufsize = 1024;
+    BYTE *buf = (BYTE *)malloc(bufsize);
+    if (buf == NULL)
+        bufsize = 0;
+    while (WaitForMultipleObjects(2, waits, FALSE, INFINITE) == WAIT_OBJECT_0) {
+        EnterCriticalSection(&state->cs);
+        SCAN_DIR *dir = state->dirs;
+        state->dirs = dir->next;
+        LeaveCriticalSection(&state->cs);
+        ScanDir(state, dir->path, &buf, &bufsize);
+        free(dir->path);
+        free(dir);
+        EnterCriticalSection(&state->cs);
+        if (--state->outstanding == 0)
+            SetEvent(state->hdone);
+        LeaveCriticalSection(&state->cs);
+    }
+    free(buf);
+    return 0;
+}
+
+static void ScanFreeState(SCAN_STATE *state)
+{
+    DWORD i;
+    for (i = 0; i < state->numsds; i++) free(state->sds[i]);
+    free(state->sds);
+    for (i = 0; i < state->numfiles; i++) free(state->files[i].path);
+    free(state->files);
+    if (state->hwork)
+        CloseHandle(state->hwork);
+    if (state->hdone)
+        CloseHandle(state->hdone);
+    DeleteCriticalSection(&state->cs);
+    free(state);
+}
+
+PyObject *PyScanSecurityDescriptors(PyObject *self, PyObject *args)
+{
+    PyObject *obpath, *ret = NULL, *obsds = NULL, *obfiles = NULL, *oberrors = NULL;
+    SECURITY_INFORMATION secinfo = OWNER_SECURITY_INFORMATION | GROUP_SECURITY_INFORMATION | DACL_SECURITY_INFORMATION;
+    DWORD numthreads = 8, numstarted = 0, i;
+    HANDLE threads[SCAN_MAX_THREADS];
+    WCHAR *path = NULL, *rootpath = NULL;
+    SCAN_STATE *state = NULL;
+    if (!PyArg_ParseTuple(args, "O|kk:ScanSecurityDescriptors", &obpath, &secinfo, &numthreads))
+        return NULL;
+    if (numthreads == 0 || numthreads > SCAN_MAX_THREADS)
+        return PyErr_Format(PyExc_ValueError, "Threads must be between 1 and %d", SCAN_MAX_THREADS);
+    if (!PyWinObject_AsWCHAR(obpath, &path))
+        return NULL;
+    rootpath = ScanCopyPath(path);
+    state = (SCAN_STATE *)calloc(1, sizeof(SCAN_STATE));
+    if (rootpath == NULL || state == NULL) {
+        free(rootpath);
+        free(state);
+        state = NULL;
+        PyErr_NoMemory();
+        goto done;
+    }
+    InitializeCriticalSection(&state->cs);
+    state->secinfo = secinfo;
+    state->access = READ_CONTROL;
+    if (secinfo & SACL_SECURITY_INFORMATION)
+        state->access |= ACCESS_SYSTEM_SECURITY;
+    state->hwork = CreateSemaphore(NULL, 0, MAXLONG, NULL);
+    state->hdone = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (state->hwork == NULL || state->hdone == NULL) {
+        free(rootpath);
+        PyWin_SetAPIError("CreateEvent");
+        goto done;
+    }
+
+    DWORD attrs, err;
+    char *failed;
+    err = 0;
+    failed = NULL;
+    Py_BEGIN_ALLOW_THREADS attrs = GetFileAttributesW(rootpath);
+    if (attrs == INVALID_FILE_ATTRIBUTES) {
+        err = GetLastError();
+        failed = "GetFileAttributes";
+        free(rootpath);
+    }
+    else {
+        DWORD bufsize = 0;
+        BYTE *buf = NULL;
+        if ((attrs & FILE_ATTRIBUTE_DIRECTORY) && !(attrs & FILE_ATTRIBUTE_REPARSE_POINT)) {
+            WCHAR *rootdir = ScanCopyPath(rootpath);
+            if (rootdir)
+                ScanPushDir(state, rootdir);
+            else
+                state->bOutOfMemory = TRUE;
+        }
+        ScanFile(state, rootpath, &buf, &bufsize);
+        free(buf);
+        if (state->outstanding == 0)
+            SetEvent(state->hdone);
+        for (numstarted = 0; numstarted < numthreads; numstarted++) {
+            threads[numstarted] = CreateThread(NULL, 0, ScanThread, state, 0, NULL);
+            if (threads[numstarted] == NULL)
+                break;
+        }
+        if (numstarted == 0) {
+            err = GetLastError();
+            failed = "CreateThread";
+            // Nothing will consume the queue, so let go of it here
+            while (state->dirs) {
+                SCAN_DIR *dir = state->dirs;
+                state->dirs = dir->next;
+                free(dir->path);
+                free(dir);
+            }
+        }
+        else {
+            WaitForSingleObject(state->hdone, INFINITE);
+            WaitForMultipleObjects(numstarted, threads, TRUE, INFINITE);
+            for (i = 0; i < numstarted; i++) CloseHandle(threads[i]);
+        }
+    }
+    Py_END_ALLOW_THREADS
+
+    if (failed) {
+        PyWin_SetAPIError(failed, err);
+        goto done;
+    }
+    if (state->bOutOfMemory) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    obsds = PyList_New(state->numsds);
+    obfiles = PyList_New(0);
+    oberrors = PyList_New(0);
+    if (obsds == NULL || obfiles == NULL || oberrors == NULL)
+        goto done;
+    for (i = 0; i < state->numsds; i++) {
+        PyObject *obsd = PyWinObject_FromSECURITY_DESCRIPTOR(state->sds[i]->sd);
+        if (obsd == NULL)
+            goto done;
+        PyList_SET_ITEM(obsds, i, obsd);
+    }
+    for (i = 0; i < state->numfiles; i++) {
+        SCAN_FILE *file = &state->files[i];
+        PyObject *item;
+        if (file->index == -1)
+            item = Py_BuildValue("Nk", PyWinObject_FromWCHAR(file->path), file->err);
+        else
+            item = Py_BuildValue("Nl", PyWinObject_FromWCHAR(file->path), file->index);
+        if (item == NULL || PyList_Append(file->index == -1 ? oberrors : obfiles, item) == -1) {
+            Py_XDECREF(item);
+            goto done;
+        }
+        Py_DECREF(item);
+    }
+    ret = Py_BuildValue("OOO", obsds, obfiles, oberrors);
+
+done:
+    Py_XDECREF(obsds);
+    Py_XDECREF(obfiles);
+    Py_XDECREF(oberrors);
+    if (state)
+        ScanFreeState(state);
+    PyWinObject_FreeWCHAR(path);
+    return ret;
+}
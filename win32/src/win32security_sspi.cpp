@@ -283,9 +283,16 @@ PyObject *PyWinObject_FromSecBufferDesc(PSecBufferDesc pSecBufferDesc)
 ////////////////////////////////////////////////////////////////////////
 
 // @object PySecBuffer|Python object wrapping a SecBuffer structure
-//  Created using win32security.PySecBufferType(type,size) where type is a SECBUFFER_* constant
+//  Created using win32security.PySecBufferType(size,type,Wrap=None,Offset=0) where type is a SECBUFFER_* constant
+// @comm By default the object allocates and owns its memory, and data must be copied in and out using the Buffer
+// attribute.  If Wrap is a writable buffer object such as a bytearray, the SecBuffer points directly into its memory,
+// Offset bytes from the start, for size bytes (or the rest of the object if size is 0).  Encryption and decryption
+// then happen in place in the caller's object, and <om PySecBuffer.SetRegion> and the DataOffset attribute allow a
+// stream to be processed without copying.  The wrapped object can't be resized while the PySecBuffer is alive.
 struct PyMethodDef PySecBuffer::methods[] = {
     {"Clear", PySecBuffer::Clear, 1},  // @pymeth Clear|Resets all members of the structure
+    {"SetRegion", PySecBuffer::SetRegion,
+     1},  // @pymeth SetRegion|Points the buffer at a range of its own memory or of the wrapped object
     {NULL}};
 
 #undef OFF
@@ -300,6 +307,10 @@ struct PyMemberDef PySecBuffer::members[] = {
     {"BufferSize", T_ULONG, OFF(secbuffer.cbBuffer), 0, "Current size of data in buffer"},
     // @prop int|MaxBufferSize|
     {"MaxBufferSize", T_ULONG, OFF(maxbufsize), READONLY, "Maximum size of data buffer"},
+    // @prop int|DataOffset|Position of the data within the wrapped object or allocated memory, or None if a security
+    // package has pointed the SecBuffer elsewhere.  After an in place <om PyCtxtHandle.DecryptMessage> of a
+    // SECBUFFER_STREAM, the plaintext is at wrapped[DataOffset:DataOffset+BufferSize].
+    {"DataOffset", T_OBJECT, OFF(obdummy), READONLY, "Position of the data within the wrapped object"},
     {NULL}};
 
 PyTypeObject PySecBufferType = {
@@ -344,6 +355,10 @@ PyTypeObject PySecBufferType = {
 
 PySecBuffer::PySecBuffer(PSecBuffer psecbuffer)
 {
+    obdummy = NULL;
+    allocBuffer = NULL;
+    allocSize = 0;
+    bWrapped = FALSE;
     maxbufsize = secbuffer.cbBuffer;
     ob_type = &PySecBufferType;
     secbuffer = *psecbuffer;
@@ -359,18 +374,21 @@ PySecBuffer::PySecBuffer(PSecBuffer psecbuffer)
 PySecBuffer::PySecBuffer(ULONG cbBuffer, ULONG BufferType)
 {
     obdummy = NULL;
+    bWrapped = FALSE;
     maxbufsize = cbBuffer;
     ob_type = &PySecBufferType;
     secbuffer.cbBuffer = cbBuffer;
     secbuffer.BufferType = BufferType;
 
     allocBuffer = NULL;
+    allocSize = 0;
     if (cbBuffer > 0)
     {
         // Stores our allocated memory in a class property so we don't try and free memory that wasn't allocated by us.
         // Windows could change where pvBuffer points to after a function call and we should only be concerned about
         // freeing memory that we have allocated ourselves.
         allocBuffer = malloc(cbBuffer);
+        allocSize = cbBuffer;
 
         // Any code that creates instances should check that buffer is not NULL !
         if (allocBuffer == NULL)
@@ -390,6 +408,40 @@ PySecBuffer::~PySecBuffer()
     // block of memory.
     if (allocBuffer != NULL)
         free(allocBuffer);
+    if (bWrapped)
+        PyBuffer_Release(&wrapview);
+}
+
+// Replaces the object's own memory with a writable view of another object
+BOOL PySecBuffer::Wrap(PyObject *ob, ULONG offset, ULONG size)
+{
+    if (PyObject_GetBuffer(ob, &wrapview, PyBUF_WRITABLE) == -1)
+        return FALSE;
+    if (offset > (ULONG)wrapview.len || size > (ULONG)wrapview.len - offset) {
+        PyErr_Format(PyExc_ValueError, "Region (offset %d, size %d) is outside the wrapped buffer (%d bytes)", offset,
+                     size, wrapview.len);
+        PyBuffer_Release(&wrapview);
+        return FALSE;
+    }
+    bWrapped = TRUE;
+    if (allocBuffer != NULL) {
+        free(allocBuffer);
+        allocBuffer = NULL;
+        allocSize = 0;
+    }
+    maxbufsize = (ULONG)wrapview.len - offset;
+    secbuffer.pvBuffer = (BYTE *)wrapview.buf + offset;
+    secbuffer.cbBuffer = size ? size : maxbufsize;
+    return TRUE;
+}
+
+BYTE *PySecBuffer::GetBase(void) { return (BYTE *)(bWrapped ? wrapview.buf : allocBuffer); }
+
+ULONG PySecBuffer::GetBaseSize(void)
+{
+    if (bWrapped)
+        return (ULONG)wrapview.len;
+    return allocBuffer == NULL ? 0 : allocSize;
 }
 
 BOOL PySecBuffer_Check(PyObject *ob)
@@ -413,6 +465,14 @@ PyObject *PySecBuffer::getattro(PyObject *self, PyObject *obname)
         return NULL;
     if (strcmp(name, "Buffer") == 0)
         return PyString_FromStringAndSize((char *)psecbuffer->pvBuffer, psecbuffer->cbBuffer);
+    if (strcmp(name, "DataOffset") == 0) {
+        PySecBuffer *This = (PySecBuffer *)self;
+        BYTE *base = This->GetBase(), *data = (BYTE *)psecbuffer->pvBuffer;
+        if (base != NULL && data >= base && data + psecbuffer->cbBuffer <= base + This->GetBaseSize())
+            return PyLong_FromUnsignedLong((ULONG)(data - base));
+        Py_INCREF(Py_None);
+        return Py_None;
+    }
     return PyObject_GenericGetAttr(self, obname);
 }
 
@@ -433,7 +493,9 @@ int PySecBuffer::setattro(PyObject *self, PyObject *obname, PyObject *obvalue)
                          This->maxbufsize);
             return -1;
         }
-        ZeroMemory(psecbuffer->pvBuffer, This->maxbufsize);
+        // Don't clobber the rest of a caller's object
+        if (!This->bWrapped)
+            ZeroMemory(psecbuffer->pvBuffer, This->maxbufsize);
         memcpy(psecbuffer->pvBuffer, pybuf.ptr(), pybuf.len());
         // buffer length should be size of actual data, allocated size is kept in our own maxbufsize
         psecbuffer->cbBuffer = pybuf.len();
@@ -445,11 +507,19 @@ int PySecBuffer::setattro(PyObject *self, PyObject *obname, PyObject *obvalue)
 
 PyObject *PySecBuffer::tp_new(PyTypeObject *typ, PyObject *args, PyObject *kwargs)
 {
-    ULONG cbBuffer, BufferType;
-    static char *keywords[] = {"BufferSize", "BufferType", NULL};
-    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "ll", keywords, &cbBuffer, &BufferType))
+    ULONG cbBuffer, BufferType, offset = 0;
+    PyObject *obwrap = Py_None;
+    static char *keywords[] = {"BufferSize", "BufferType", "Wrap", "Offset", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "ll|Ol", keywords, &cbBuffer, &BufferType, &obwrap, &offset))
+        return NULL;
+    if (obwrap == Py_None)
+        return new PySecBuffer(cbBuffer, BufferType);
+    PySecBuffer *ret = new PySecBuffer(0, BufferType);
+    if (ret != NULL && !ret->Wrap(obwrap, offset, cbBuffer)) {
+        Py_DECREF(ret);
         return NULL;
-    return new PySecBuffer(cbBuffer, BufferType);
+    }
+    return ret;
 }
 
 PyObject * PySecBuffer::tp_repr(PyObject * obj)
@@ -472,6 +542,32 @@ PyObject *PySecBuffer::Clear(PyObject *self, PyObject *args)
     return Py_None;
 }
 
+// @pymethod |PySecBuffer|SetRegion|Points the buffer at a range of its own memory or of the wrapped object
+// @comm No data is copied.  This is typically used with a wrapped receive buffer, to pass the next unprocessed
+// bytes to <om PyCtxtHandle.DecryptMessage> after the previous call has consumed some of them.
+PyObject *PySecBuffer::SetRegion(PyObject *self, PyObject *args)
+{
+    PySecBuffer *This = (PySecBuffer *)self;
+    ULONG offset, size, basesize;
+    // @pyparm int|Offset||Start of the range, from the start of the wrapped object or allocated memory
+    // @pyparm int|Size||Number of bytes
+    if (!PyArg_ParseTuple(args, "ll:SetRegion", &offset, &size))
+        return NULL;
+    BYTE *base = This->GetBase();
+    basesize = This->GetBaseSize();
+    if (base == NULL || offset > basesize || size > basesize - offset) {
+        PyErr_Format(PyExc_ValueError, "Region (offset %d, size %d) is outside the buffer (%d bytes)", offset, size,
+                     basesize);
+        return NULL;
+    }
+    PSecBuffer psecbuffer = This->GetSecBuffer();
+    psecbuffer->pvBuffer = base + offset;
+    psecbuffer->cbBuffer = size;
+    This->maxbufsize = basesize - offset;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
 BOOL PyWinObject_AsSecBuffer(PyObject *ob, PSecBuffer *psecbuffer, BOOL bNoneOk)
 {
     if (!PySecBuffer_Check(ob))
@@ -508,6 +604,10 @@ struct PyMethodDef PyCtxtHandle::methods[] = {
      1},  // @pymeth EncryptMessage|Encrypts data with security context's session key
     {"DecryptMessage", PyCtxtHandle::DecryptMessage,
      1},  // @pymeth DecryptMessage|Decrypts data encrypted by <om PyCtxtHandle.EncryptMessage>
+    {"EncryptMessages", PyCtxtHandle::EncryptMessages,
+     1},  // @pymeth EncryptMessages|Encrypts a number of messages with one call
+    {"DecryptMessages", PyCtxtHandle::DecryptMessages,
+     1},  // @pymeth DecryptMessages|Decrypts a number of messages with one call
     {"ImpersonateSecurityContext", PyCtxtHandle::ImpersonateSecurityContext,
      1},  // @pymeth ImpersonateSecurityContext|Causes a server to act in the security context of an authenticated
           // client
@@ -737,6 +837,128 @@ PyObject *PyCtxtHandle::DecryptMessage(PyObject *self, PyObject *args)
     return NULL;
 }
 
+// Converts a sequence of PySecBufferDesc objects for EncryptMessages/DecryptMessages.  The returned tuple keeps the
+// objects alive, and must be released after the buffers have been copied back with modify_in_place.
+static PyObject *PyWinObject_AsSecBufferDescArray(PyObject *obdescs, PSecBufferDesc **ppdescs, DWORD *pcount)
+{
+    PyObject *tuple = PyWinSequence_Tuple(obdescs, pcount);
+    if (tuple == NULL)
+        return NULL;
+    *ppdescs = (PSecBufferDesc *)malloc(max(*pcount, 1) * sizeof(PSecBufferDesc));
+    if (*ppdescs == NULL) {
+        Py_DECREF(tuple);
+        PyErr_NoMemory();
+        return NULL;
+    }
+    for (DWORD i = 0; i < *pcount; i++)
+        if (!PyWinObject_AsSecBufferDesc(PyTuple_GET_ITEM(tuple, i), &(*ppdescs)[i], FALSE)) {
+            free(*ppdescs);
+            Py_DECREF(tuple);
+            return NULL;
+        }
+    return tuple;
+}
+
+// @pymethod [int, ...]|PyCtxtHandle|EncryptMessages|Encrypts a number of messages with one call
+// @rdesc Returns the status of each message processed.  Processing stops after the first message that fails, so the
+// list may be shorter than Messages.  Errors are returned rather than raised, since earlier messages will have been
+// encrypted already.
+// @comm This is equivalent to calling <om PyCtxtHandle.EncryptMessage> for each message in turn, but the GIL is only
+// released once.  Combined with PySecBuffer objects that wrap the caller's buffers, a batch of records can be sealed
+// without copying any of the data.
+PyObject *PyCtxtHandle::EncryptMessages(PyObject *self, PyObject *args)
+{
+    SECURITY_STATUS *errs;
+    PyObject *obdescs, *tuple, *ret;
+    PSecBufferDesc *pdescs;
+    ULONG fqop, seq_no;
+    DWORD count, i, done = 0;
+    CHECK_SECURITYFUNCTIONTABLE(EncryptMessage);
+    // @pyparm int|fqop||Flags that indicate quality of protection desired, specific to each security package
+    // @pyparm [<o PySecBufferDesc>, ...]|Messages||Buffer configurations to be encrypted, in order
+    // @pyparm int|MessageSeqNo||Sequence number of the first message, incremented for each one after it
+    if (!PyArg_ParseTuple(args, "lOl:EncryptMessages", &fqop, &obdescs, &seq_no))
+        return NULL;
+    tuple = PyWinObject_AsSecBufferDescArray(obdescs, &pdescs, &count);
+    if (tuple == NULL)
+        return NULL;
+    errs = (SECURITY_STATUS *)malloc(max(count, 1) * sizeof(SECURITY_STATUS));
+    if (errs == NULL) {
+        free(pdescs);
+        Py_DECREF(tuple);
+        return PyErr_NoMemory();
+    }
+    PCtxtHandle pctxt = ((PyCtxtHandle *)self)->GetCtxtHandle();
+    Py_BEGIN_ALLOW_THREADS while (done < count)
+    {
+        errs[done] = (*psecurityfunctiontable->EncryptMessage)(pctxt, fqop, pdescs[done], seq_no + done);
+        if (errs[done++] < 0)
+            break;
+    }
+    Py_END_ALLOW_THREADS ret = PyList_New(done);
+    for (i = 0; i < done; i++) {
+        ((PySecBufferDesc *)PyTuple_GET_ITEM(tuple, i))->modify_in_place();
+        if (ret != NULL)
+            PyList_SET_ITEM(ret, i, PyLong_FromLong(errs[i]));
+    }
+    free(errs);
+    free(pdescs);
+    Py_DECREF(tuple);
+    return ret;
+}
+
+// @pymethod [(int, int), ...]|PyCtxtHandle|DecryptMessages|Decrypts a number of messages with one call
+// @rdesc Returns a (status, fqop) tuple for each message processed.  Processing stops after the first message whose
+// status isn't SEC_E_OK - eg SEC_E_INCOMPLETE_MESSAGE at the end of a stream, or SEC_I_RENEGOTIATE - so the list
+// may be shorter than Messages.  Errors are returned rather than raised, since earlier messages will have been
+// decrypted already.
+// @comm This is equivalent to calling <om PyCtxtHandle.DecryptMessage> for each message in turn, but the GIL is only
+// released once.
+PyObject *PyCtxtHandle::DecryptMessages(PyObject *self, PyObject *args)
+{
+    SECURITY_STATUS *errs;
+    PyObject *obdescs, *tuple, *ret;
+    PSecBufferDesc *pdescs;
+    ULONG *fqops, seq_no;
+    DWORD count, i, done = 0;
+    CHECK_SECURITYFUNCTIONTABLE(DecryptMessage);
+    // @pyparm [<o PySecBufferDesc>, ...]|Messages||Buffer configurations to be decrypted, in order
+    // @pyparm int|MessageSeqNo||Sequence number of the first message, incremented for each one after it
+    if (!PyArg_ParseTuple(args, "Ol:DecryptMessages", &obdescs, &seq_no))
+        return NULL;
+    tuple = PyWinObject_AsSecBufferDescArray(obdescs, &pdescs, &count);
+    if (tuple == NULL)
+        return NULL;
+    errs = (SECURITY_STATUS *)malloc(max(count, 1) * sizeof(SECURITY_STATUS));
+    fqops = (ULONG *)malloc(max(count, 1) * sizeof(ULONG));
+    if (errs == NULL || fqops == NULL) {
+        free(errs);
+        free(fqops);
+        free(pdescs);
+        Py_DECREF(tuple);
+        return PyErr_NoMemory();
+    }
+    PCtxtHandle pctxt = ((PyCtxtHandle *)self)->GetCtxtHandle();
+    Py_BEGIN_ALLOW_THREADS while (done < count)
+    {
+        fqops[done] = 0;
+        errs[done] = (*psecurityfunctiontable->DecryptMessage)(pctxt, pdescs[done], seq_no + done, &fqops[done]);
+        if (errs[done++] != SEC_E_OK)
+            break;
+    }
+    Py_END_ALLOW_THREADS ret = PyList_New(done);
+    for (i = 0; i < done; i++) {
+        ((PySecBufferDesc *)PyTuple_GET_ITEM(tuple, i))->modify_in_place();
+        if (ret != NULL)
+            PyList_SET_ITEM(ret, i, Py_BuildValue("ll", errs[i], fqops[i]));
+    }
+    free(errs);
+    free(fqops);
+    free(pdescs);
+    Py_DECREF(tuple);
+    return ret;
+}
+
 // @pymethod long|PyCtxtHandle|Detach|Disassociates object from handle and returns integer value of handle
 // @comm Use when the security context needs to persist beyond the lifetime of the Python object
 PyObject *PyCtxtHandle::Detach(PyObject *self, PyObject *args)
@@ -1198,3 +1420,644 @@ PyObject *PyCredHandle::QueryCredentialsAttributes(PyObject *self, PyObject *arg
     }
     return ret;
 }
+
+////////////////////////////////////////////////////////////////////////
+//
+// PySecureChannel
+//
+////////////////////////////////////////////////////////////////////////
+// @object PySecureChannel|A TLS connection over a socket, using Schannel
+// @comm Create using <om win32security.CreateSecureChannel>.  The handshake, splitting of data into records with
+// room for the SECPKG_ATTR_STREAM_SIZES header and trailer, and reassembly of records that arrive in pieces are
+// all done natively, with the GIL released while waiting for the network.  Incoming records are decrypted in
+// place in an internal receive buffer, and outgoing ones are built in an internal send buffer, so a read or
+// write costs a single Python call however many records it spans.
+// <nl>The socket must be connected and in blocking mode, and shouldn't be used directly while the channel is open.
+// Only one thread may use the channel at a time.
+struct PyMethodDef PySecureChannel::methods[] = {
+    {"Handshake", PySecureChannel::Handshake,
+     1},  // @pymeth Handshake|Negotiates the connection, if it hasn't been done already
+    {"Read", PySecureChannel::Read, 1},  // @pymeth Read|Receives decrypted data
+    {"ReadInto", PySecureChannel::ReadInto, 1},  // @pymeth ReadInto|Receives decrypted data into a writable buffer
+    {"Write", PySecureChannel::Write, 1},        // @pymeth Write|Encrypts and sends data
+    {"Shutdown", PySecureChannel::Shutdown, 1},  // @pymeth Shutdown|Sends a TLS close notification to the peer
+    {"QueryContextAttributes", PySecureChannel::QueryContextAttributes,
+     1},  // @pymeth QueryContextAttributes|Retrieves info about the security context
+    {"Close", PySecureChannel::Close, 1},  // @pymeth Close|Deletes the security context and frees the buffers
+    {NULL}};
+
+#undef OFF
+#define OFF(e) offsetof(PySecureChannel, e)
+struct PyMemberDef PySecureChannel::members[] = {
+    // @prop boolean|Connected|True once the handshake is complete, until Shutdown or Close is called
+    {"Connected", T_INT, OFF(bConnected), READONLY, "True once the handshake is complete"},
+    // @prop boolean|ShutdownSent|True once <om PySecureChannel.Shutdown> has been called
+    {"ShutdownSent", T_INT, OFF(bShutdown), READONLY, "True once Shutdown has been called"},
+    // @prop boolean|Eof|True when the peer has closed its side of the connection
+    {"Eof", T_INT, OFF(bEof), READONLY, "True when the peer has closed its side of the connection"},
+    // @prop int|Pending|Number of decrypted bytes that can be read without waiting
+    {"Pending", T_ULONG, OFF(plainlen), READONLY, "Number of decrypted bytes that can be read without waiting"},
+    // @prop int|HeaderSize|Size of the record header
+    {"HeaderSize", T_ULONG, OFF(sizes.cbHeader), READONLY, "Size of the record header"},
+    // @prop int|TrailerSize|Maximum size of the record trailer
+    {"TrailerSize", T_ULONG, OFF(sizes.cbTrailer), READONLY, "Maximum size of the record trailer"},
+    // @prop int|MaximumMessage|Largest amount of data that fits in one record
+    {"MaximumMessage", T_ULONG, OFF(sizes.cbMaximumMessage), READONLY,
+     "Largest amount of data that fits in one record"},
+    // @prop int|RecordsRead|Number of records decrypted
+    {"RecordsRead", T_ULONG, OFF(recordsread), READONLY, "Number of records decrypted"},
+    // @prop int|RecordsWritten|Number of records sent
+    {"RecordsWritten", T_ULONG, OFF(recordswritten), READONLY, "Number of records sent"},
+    {NULL}};
+
+PyTypeObject PySecureChannelType = {
+    PYWIN_OBJECT_HEAD "PySecureChannel",
+    sizeof(PySecureChannel),
+    0,
+    PySecureChannel::deallocFunc,  // tp_dealloc
+    0,                             // tp_print
+    0,                             // tp_getattr
+    0,                             // tp_setattr
+    0,                             // tp_compare
+    0,                             // tp_repr
+    0,                             // PyNumberMethods *tp_as_number
+    0,                             // PySequenceMethods *tp_as_sequence
+    0,                             // PyMappingMethods *tp_as_mapping
+    0,                             // hashfunc tp_hash
+    0,                             // tp_call
+    0,                             // tp_str
+    PyObject_GenericGetAttr,       // tp_getattro
+    PyObject_GenericSetAttr,       // tp_setattro
+    0,                             // PyBufferProcs *tp_as_buffer
+    Py_TPFLAGS_DEFAULT,            // tp_flags
+    0,                             // tp_doc
+    0,                             // traverseproc tp_traverse
+    0,                             // tp_clear
+    0,                             // richcmpfunc tp_richcompare
+    0,                             // tp_weaklistoffset
+    0,                             // getiterfunc tp_iter
+    0,                             // iternextfunc tp_iternext
+    PySecureChannel::methods,
+    PySecureChannel::members,
+};
+
+// The receive buffer grows to hold large handshake messages (certificate chains), up to this size.
+#define SECURECHANNEL_MAX_INPUT 0x100000
+
+PySecureChannel::PySecureChannel(void)
+{
+    ob_type = &PySecureChannelType;
+    obsocket = obcredentials = NULL;
+    sock = INVALID_SOCKET;
+    SecInvalidateHandle(&credhandle);
+    SecInvalidateHandle(&ctxthandle);
+    targetname = NULL;
+    contextreq = contextattr = 0;
+    bServer = bHaveContext = bConnected = bShutdown = bEof = bBusy = bClosed = FALSE;
+    ZeroMemory(&sizes, sizeof(sizes));
+    inbuf = plainbuf = sendbuf = NULL;
+    incap = incount = plaincap = plainpos = plainlen = sendcap = 0;
+    recordsread = recordswritten = 0;
+    lastfunc = NULL;
+    lasterr = 0;
+    _Py_NewReference(this);
+}
+
+PySecureChannel::~PySecureChannel()
+{
+    Cleanup();
+    Py_XDECREF(obsocket);
+    Py_XDECREF(obcredentials);
+    PyWinObject_FreeWCHAR(targetname);
+}
+
+void PySecureChannel::Cleanup(void)
+{
+    if (SecIsValidHandle(&ctxthandle))
+        (*psecurityfunctiontable->DeleteSecurityContext)(&ctxthandle);
+    SecInvalidateHandle(&ctxthandle);
+    bHaveContext = bConnected = FALSE;
+    free(inbuf);
+    free(plainbuf);
+    free(sendbuf);
+    inbuf = plainbuf = sendbuf = NULL;
+    incap = incount = plaincap = plainpos = plainlen = sendcap = 0;
+}
+
+void PySecureChannel::deallocFunc(PyObject *ob) { delete (PySecureChannel *)ob; }
+
+// The methods below that return BOOL or int run with the GIL released, so they record the failing function and
+// error code, to be raised by SetError once the GIL is held again.
+BOOL PySecureChannel::Fail(const char *fname, DWORD err)
+{
+    lastfunc = fname;
+    lasterr = err;
+    return FALSE;
+}
+
+PyObject *PySecureChannel::SetError(void) { return PyWin_SetAPIError((char *)lastfunc, lasterr); }
+
+BOOL PySecureChannel::Reserve(BYTE **pbuf, DWORD *pcap, DWORD size)
+{
+    if (size <= *pcap)
+        return TRUE;
+    BYTE *newbuf = (BYTE *)realloc(*pbuf, size);
+    if (newbuf == NULL)
+        return Fail("realloc", ERROR_NOT_ENOUGH_MEMORY);
+    *pbuf = newbuf;
+    *pcap = size;
+    return TRUE;
+}
+
+BOOL PySecureChannel::SendAll(const BYTE *data, DWORD len)
+{
+    while (len > 0) {
+        int sent = send(sock, (const char *)data, len, 0);
+        if (sent == SOCKET_ERROR)
+            return Fail("send", WSAGetLastError());
+        data += sent;
+        len -= sent;
+    }
+    return TRUE;
+}
+
+// Appends whatever has arrived to the receive buffer.  Returns 1 if data was received, 0 if the peer closed
+// the connection, or -1 on error.
+int PySecureChannel::RecvMore(void)
+{
+    if (incount == incap) {
+        if (incap >= SECURECHANNEL_MAX_INPUT) {
+            Fail("recv", ERROR_INSUFFICIENT_BUFFER);
+            return -1;
+        }
+        if (!Reserve(&inbuf, &incap, incap * 2))
+            return -1;
+    }
+    int received = recv(sock, (char *)inbuf + incount, incap - incount, 0);
+    if (received == SOCKET_ERROR) {
+        Fail("recv", WSAGetLastError());
+        return -1;
+    }
+    incount += received;
+    return received > 0;
+}
+
+// Moves anything Schannel marked as SECBUFFER_EXTRA to the start of the receive buffer, discarding the rest.
+void PySecureChannel::KeepExtra(SecBuffer *bufs, ULONG nbufs)
+{
+    for (ULONG i = 0; i < nbufs; i++)
+        if (bufs[i].BufferType == SECBUFFER_EXTRA && bufs[i].cbBuffer > 0) {
+            memmove(inbuf, inbuf + incount - bufs[i].cbBuffer, bufs[i].cbBuffer);
+            incount = bufs[i].cbBuffer;
+            return;
+        }
+    incount = 0;
+}
+
+// Runs the handshake to completion, starting with any data already in the receive buffer.  Also used to
+// process the messages that follow a SEC_I_RENEGOTIATE from DecryptMessage.
+BOOL PySecureChannel::DoHandshake(void)
+{
+    SECURITY_STATUS err;
+    BOOL bNeedInput = (bServer || bHaveContext) && incount == 0, bRetried = FALSE;
+    for (;;) {
+        if (bNeedInput) {
+            int got = RecvMore();
+            if (got < 0)
+                return FALSE;
+            if (got == 0)
+                return Fail("recv", WSAECONNRESET);
+        }
+        SecBuffer inbufs[2], outbufs[1];
+        SecBufferDesc indesc = {SECBUFFER_VERSION, 2, inbufs}, outdesc = {SECBUFFER_VERSION, 1, outbufs};
+        inbufs[0].BufferType = SECBUFFER_TOKEN;
+        inbufs[0].cbBuffer = incount;
+        inbufs[0].pvBuffer = inbuf;
+        inbufs[1].BufferType = SECBUFFER_EMPTY;
+        inbufs[1].cbBuffer = 0;
+        inbufs[1].pvBuffer = NULL;
+        outbufs[0].BufferType = SECBUFFER_TOKEN;
+        outbufs[0].cbBuffer = 0;
+        outbufs[0].pvBuffer = NULL;
+        if (bServer)
+            err = (*psecurityfunctiontable->AcceptSecurityContext)(&credhandle, bHaveContext ? &ctxthandle : NULL,
+                                                                   &indesc, contextreq, 0, &ctxthandle, &outdesc,
+                                                                   &contextattr, NULL);
+        else
+            err = (*psecurityfunctiontable->InitializeSecurityContextW)(
+                &credhandle, bHaveContext ? &ctxthandle : NULL, targetname, contextreq, 0, 0,
+                bHaveContext ? &indesc : NULL, 0, bHaveContext ? NULL : &ctxthandle, &outdesc, &contextattr, NULL);
+        if (err == SEC_E_OK || err == SEC_I_CONTINUE_NEEDED || (FAILED(err) && (contextattr & ISC_RET_EXTENDED_ERROR)))
+            if (outbufs[0].cbBuffer > 0 && outbufs[0].pvBuffer != NULL) {
+                BOOL bSent = SendAll((BYTE *)outbufs[0].pvBuffer, outbufs[0].cbBuffer);
+                (*psecurityfunctiontable->FreeContextBuffer)(outbufs[0].pvBuffer);
+                if (!bSent)
+                    return FALSE;
+            }
+        if (err == SEC_E_INCOMPLETE_MESSAGE) {
+            bNeedInput = TRUE;
+            continue;
+        }
+        if (err == SEC_I_INCOMPLETE_CREDENTIALS && !bRetried) {
+            // The server asked for a client certificate - carry on without one.
+            bRetried = TRUE;
+            bNeedInput = FALSE;
+            continue;
+        }
+        if (FAILED(err))
+            return Fail(bServer ? "AcceptSecurityContext" : "InitializeSecurityContext", err);
+        if (bHaveContext || bServer)
+            KeepExtra(inbufs, 2);
+        bHaveContext = TRUE;
+        if (err == SEC_E_OK)
+            break;
+        bNeedInput = incount == 0;
+    }
+    err = (*psecurityfunctiontable->QueryContextAttributesW)(&ctxthandle, SECPKG_ATTR_STREAM_SIZES, &sizes);
+    if (err != SEC_E_OK)
+        return Fail("QueryContextAttributes", err);
+    DWORD recordsize = sizes.cbHeader + sizes.cbMaximumMessage + sizes.cbTrailer;
+    if (!Reserve(&inbuf, &incap, recordsize) || !Reserve(&plainbuf, &plaincap, sizes.cbMaximumMessage) ||
+        !Reserve(&sendbuf, &sendcap, recordsize))
+        return FALSE;
+    bConnected = TRUE;
+    return TRUE;
+}
+
+// Makes decrypted data available in plainbuf.  Returns 1 if there is some, 0 at the end of the stream, -1 on
+// error, or 2 if bWait is FALSE and more data would have to be received first.
+int PySecureChannel::ReadRecord(BOOL bWait)
+{
+    while (plainlen == 0) {
+        if (bEof)
+            return 0;
+        if (incount == 0) {
+            if (!bWait)
+                return 2;
+            int got = RecvMore();
+            if (got < 0)
+                return -1;
+            if (got == 0) {
+                // Closed without a close notification - treat it as the end of the stream.
+                bEof = TRUE;
+                return 0;
+            }
+        }
+        SecBuffer bufs[4];
+        SecBufferDesc desc = {SECBUFFER_VERSION, 4, bufs};
+        bufs[0].BufferType = SECBUFFER_DATA;
+        bufs[0].cbBuffer = incount;
+        bufs[0].pvBuffer = inbuf;
+        for (int i = 1; i < 4; i++) {
+            bufs[i].BufferType = SECBUFFER_EMPTY;
+            bufs[i].cbBuffer = 0;
+            bufs[i].pvBuffer = NULL;
+        }
+        SECURITY_STATUS err = (*psecurityfunctiontable->DecryptMessage)(&ctxthandle, &desc, 0, NULL);
+        if (err == SEC_E_INCOMPLETE_MESSAGE) {
+            if (!bWait)
+                return 2;
+            int got = RecvMore();
+            if (got < 0)
+                return -1;
+            if (got == 0) {
+                Fail("recv", WSAECONNRESET);
+                return -1;
+            }
+            continue;
+        }
+        if (err == SEC_I_CONTEXT_EXPIRED) {
+            bEof = TRUE;
+            incount = 0;
+            return 0;
+        }
+        if (err != SEC_E_OK && err != SEC_I_RENEGOTIATE) {
+            Fail("DecryptMessage", err);
+            return -1;
+        }
+        for (int i = 1; i < 4; i++)
+            if (bufs[i].BufferType == SECBUFFER_DATA && bufs[i].cbBuffer > 0) {
+                if (!Reserve(&plainbuf, &plaincap, bufs[i].cbBuffer))
+                    return -1;
+                memcpy(plainbuf, bufs[i].pvBuffer, bufs[i].cbBuffer);
+                plainpos = 0;
+                plainlen = bufs[i].cbBuffer;
+                recordsread++;
+                break;
+            }
+        KeepExtra(bufs, 4);
+        if (err == SEC_I_RENEGOTIATE && !DoHandshake())
+            return -1;
+    }
+    return 1;
+}
+
+// Copies up to len decrypted bytes to dest, waiting only for the first of them.
+int PySecureChannel::ReadData(BYTE *dest, DWORD len, DWORD *pread)
+{
+    int status = ReadRecord(TRUE);
+    *pread = 0;
+    while (status == 1) {
+        DWORD chunk = min(len - *pread, plainlen);
+        memcpy(dest + *pread, plainbuf + plainpos, chunk);
+        plainpos += chunk;
+        plainlen -= chunk;
+        *pread += chunk;
+        if (*pread == len)
+            break;
+        // Carry on with any complete records that have already arrived.
+        status = ReadRecord(FALSE);
+    }
+    return status;
+}
+
+BOOL PySecureChannel::WriteData(const BYTE *data, DWORD len)
+{
+    while (len > 0) {
+        DWORD chunk = min(len, sizes.cbMaximumMessage);
+        SecBuffer bufs[4];
+        SecBufferDesc desc = {SECBUFFER_VERSION, 4, bufs};
+        bufs[0].BufferType = SECBUFFER_STREAM_HEADER;
+        bufs[0].cbBuffer = sizes.cbHeader;
+        bufs[0].pvBuffer = sendbuf;
+        bufs[1].BufferType = SECBUFFER_DATA;
+        bufs[1].cbBuffer = chunk;
+        bufs[1].pvBuffer = sendbuf + sizes.cbHeader;
+        bufs[2].BufferType = SECBUFFER_STREAM_TRAILER;
+        bufs[2].cbBuffer = sizes.cbTrailer;
+        bufs[2].pvBuffer = sendbuf + sizes.cbHeader + chunk;
+        bufs[3].BufferType = SECBUFFER_EMPTY;
+        bufs[3].cbBuffer = 0;
+        bufs[3].pvBuffer = NULL;
+        memcpy(bufs[1].pvBuffer, data, chunk);
+        SECURITY_STATUS err = (*psecurityfunctiontable->EncryptMessage)(&ctxthandle, 0, &desc, 0);
+        if (FAILED(err))
+            return Fail("EncryptMessage", err);
+        if (!SendAll(sendbuf, bufs[0].cbBuffer + bufs[1].cbBuffer + bufs[2].cbBuffer))
+            return FALSE;
+        recordswritten++;
+        data += chunk;
+        len -= chunk;
+    }
+    return TRUE;
+}
+
+BOOL PySecureChannel::DoShutdown(void)
+{
+    DWORD type = SCHANNEL_SHUTDOWN;
+    SecBuffer buf, outbufs[1];
+    SecBufferDesc desc = {SECBUFFER_VERSION, 1, &buf}, outdesc = {SECBUFFER_VERSION, 1, outbufs};
+    buf.BufferType = SECBUFFER_TOKEN;
+    buf.cbBuffer = sizeof(type);
+    buf.pvBuffer = &type;
+    SECURITY_STATUS err = (*psecurityfunctiontable->ApplyControlToken)(&ctxthandle, &desc);
+    if (FAILED(err))
+        return Fail("ApplyControlToken", err);
+    outbufs[0].BufferType = SECBUFFER_TOKEN;
+    outbufs[0].cbBuffer = 0;
+    outbufs[0].pvBuffer = NULL;
+    if (bServer)
+        err = (*psecurityfunctiontable->AcceptSecurityContext)(&credhandle, &ctxthandle, NULL, contextreq, 0,
+                                                               &ctxthandle, &outdesc, &contextattr, NULL);
+    else
+        err = (*psecurityfunctiontable->InitializeSecurityContextW)(&credhandle, &ctxthandle, targetname, contextreq,
+                                                                    0, 0, NULL, 0, &ctxthandle, &outdesc,
+                                                                    &contextattr, NULL);
+    if (FAILED(err))
+        return Fail(bServer ? "AcceptSecurityContext" : "InitializeSecurityContext", err);
+    bConnected = FALSE;
+    bShutdown = TRUE;
+    if (outbufs[0].cbBuffer > 0 && outbufs[0].pvBuffer != NULL) {
+        BOOL bSent = SendAll((BYTE *)outbufs[0].pvBuffer, outbufs[0].cbBuffer);
+        (*psecurityfunctiontable->FreeContextBuffer)(outbufs[0].pvBuffer);
+        return bSent;
+    }
+    return TRUE;
+}
+
+// Claims the object for the calling thread, doing the handshake first if bConnect is TRUE.
+BOOL PySecureChannel::Enter(BOOL bConnect)
+{
+    if (bBusy) {
+        PyErr_SetString(PyExc_RuntimeError, "The PySecureChannel is in use by another thread");
+        return FALSE;
+    }
+    if (bClosed) {
+        PyErr_SetString(PyExc_ValueError, "The PySecureChannel has been closed");
+        return FALSE;
+    }
+    bBusy = TRUE;
+    if (bConnect && !bConnected && !bShutdown) {
+        BOOL ok;
+        Py_BEGIN_ALLOW_THREADS ok = DoHandshake();
+        Py_END_ALLOW_THREADS if (!ok)
+        {
+            bBusy = FALSE;
+            SetError();
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// @pymethod |PySecureChannel|Handshake|Negotiates the connection, if it hasn't been done already
+// @comm Read and Write do this automatically, but calling it explicitly allows handshake errors to be told
+// apart from later ones.
+PyObject *PySecureChannel::Handshake(PyObject *self, PyObject *args)
+{
+    PySecureChannel *This = (PySecureChannel *)self;
+    if (!PyArg_ParseTuple(args, ":Handshake"))
+        return NULL;
+    if (!This->Enter(TRUE))
+        return NULL;
+    This->bBusy = FALSE;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod bytes|PySecureChannel|Read|Receives decrypted data
+// @rdesc Returns between 1 and BufferSize bytes, or an empty string once the peer has closed the connection.
+// Waits only until some data is available, then also returns the contents of any other complete records that
+// have already arrived.
+PyObject *PySecureChannel::Read(PyObject *self, PyObject *args)
+{
+    PySecureChannel *This = (PySecureChannel *)self;
+    DWORD bufsize = 0x4000, nbrread;
+    int status;
+    // @pyparm int|BufferSize|16384|Maximum number of bytes to return
+    if (!PyArg_ParseTuple(args, "|k:Read", &bufsize))
+        return NULL;
+    PyObject *ret = PyBytes_FromStringAndSize(NULL, bufsize);
+    if (ret == NULL)
+        return NULL;
+    if (!This->Enter(TRUE)) {
+        Py_DECREF(ret);
+        return NULL;
+    }
+    BYTE *dest = (BYTE *)PyBytes_AS_STRING(ret);
+    Py_BEGIN_ALLOW_THREADS status = This->ReadData(dest, bufsize, &nbrread);
+    Py_END_ALLOW_THREADS This->bBusy = FALSE;
+    if (status < 0 && nbrread == 0) {
+        Py_DECREF(ret);
+        return This->SetError();
+    }
+    if (nbrread != bufsize)
+        _PyBytes_Resize(&ret, nbrread);
+    return ret;
+}
+
+// @pymethod int|PySecureChannel|ReadInto|Receives decrypted data into a writable buffer
+// @rdesc Returns the number of bytes placed in the buffer, 0 once the peer has closed the connection
+// @comm Behaves like <om PySecureChannel.Read>, without creating a new object for the data.
+PyObject *PySecureChannel::ReadInto(PyObject *self, PyObject *args)
+{
+    PySecureChannel *This = (PySecureChannel *)self;
+    PyObject *obbuf;
+    DWORD nbrread;
+    int status;
+    // @pyparm buffer|Buffer||Writable object to receive the data, eg a bytearray or memoryview
+    if (!PyArg_ParseTuple(args, "O:ReadInto", &obbuf))
+        return NULL;
+    PyWinBufferView pybuf(obbuf, true);
+    if (!pybuf.ok())
+        return NULL;
+    if (!This->Enter(TRUE))
+        return NULL;
+    Py_BEGIN_ALLOW_THREADS status = This->ReadData((BYTE *)pybuf.ptr(), pybuf.len(), &nbrread);
+    Py_END_ALLOW_THREADS This->bBusy = FALSE;
+    if (status < 0 && nbrread == 0)
+        return This->SetError();
+    return PyLong_FromUnsignedLong(nbrread);
+}
+
+// @pymethod |PySecureChannel|Write|Encrypts and sends data
+// @comm Data larger than <om PySecureChannel.MaximumMessage> is split into several records.  Returns once all of
+// it has been sent.
+PyObject *PySecureChannel::Write(PyObject *self, PyObject *args)
+{
+    PySecureChannel *This = (PySecureChannel *)self;
+    PyObject *obdata;
+    BOOL ok;
+    // @pyparm buffer|Data||The data to send
+    if (!PyArg_ParseTuple(args, "O:Write", &obdata))
+        return NULL;
+    PyWinBufferView pybuf(obdata);
+    if (!pybuf.ok())
+        return NULL;
+    if (This->bShutdown) {
+        PyErr_SetString(PyExc_ValueError, "The PySecureChannel has been shut down");
+        return NULL;
+    }
+    if (!This->Enter(TRUE))
+        return NULL;
+    Py_BEGIN_ALLOW_THREADS ok = This->WriteData((BYTE *)pybuf.ptr(), pybuf.len());
+    Py_END_ALLOW_THREADS This->bBusy = FALSE;
+    if (!ok)
+        return This->SetError();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod |PySecureChannel|Shutdown|Sends a TLS close notification to the peer
+// @comm No more data can be written afterwards, but data already sent by the peer can still be read.  The socket
+// itself is left open.
+PyObject *PySecureChannel::Shutdown(PyObject *self, PyObject *args)
+{
+    PySecureChannel *This = (PySecureChannel *)self;
+    BOOL ok = TRUE;
+    if (!PyArg_ParseTuple(args, ":Shutdown"))
+        return NULL;
+    if (!This->Enter(FALSE))
+        return NULL;
+    if (This->bConnected) {
+        Py_BEGIN_ALLOW_THREADS ok = This->DoShutdown();
+        Py_END_ALLOW_THREADS
+    }
+    This->bBusy = FALSE;
+    if (!ok)
+        return This->SetError();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// @pymethod object|PySecureChannel|QueryContextAttributes|Retrieves info about the security context
+// @comm Takes the same Attribute parameter and returns the same values as <om PyCtxtHandle.QueryContextAttributes>,
+// eg SECPKG_ATTR_CONNECTION_INFO or SECPKG_ATTR_REMOTE_CERT_CONTEXT.
+PyObject *PySecureChannel::QueryContextAttributes(PyObject *self, PyObject *args)
+{
+    PySecureChannel *This = (PySecureChannel *)self;
+    if (!This->bHaveContext) {
+        PyErr_SetString(PyExc_ValueError, "The PySecureChannel has no security context yet");
+        return NULL;
+    }
+    // Lend our context to a temporary PyCtxtHandle, and take it back before it can be deleted.
+    PyCtxtHandle *ctxt = new PyCtxtHandle(&This->ctxthandle);
+    if (ctxt == NULL)
+        return PyErr_NoMemory();
+    PyObject *ret = PyCtxtHandle::QueryContextAttributes(ctxt, args);
+    SecInvalidateHandle(ctxt->GetCtxtHandle());
+    Py_DECREF(ctxt);
+    return ret;
+}
+
+// @pymethod |PySecureChannel|Close|Deletes the security context and frees the buffers
+// @comm The socket is not closed.  Call <om PySecureChannel.Shutdown> first to tell the peer.
+PyObject *PySecureChannel::Close(PyObject *self, PyObject *args)
+{
+    PySecureChannel *This = (PySecureChannel *)self;
+    if (!PyArg_ParseTuple(args, ":Close"))
+        return NULL;
+    if (This->bBusy) {
+        PyErr_SetString(PyExc_RuntimeError, "The PySecureChannel is in use by another thread");
+        return NULL;
+    }
+    This->Cleanup();
+    This->bClosed = TRUE;
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+// Implementation of win32security.CreateSecureChannel, documented in win32security.i
+PyObject *PyCreateSecureChannel(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Socket", "Credentials", "TargetName", "Server", "ContextReq", NULL};
+    PyObject *obsocket, *obcred, *obtargetname = Py_None;
+    BOOL bServer = FALSE;
+    ULONG contextreq = 0;
+    SOCKET sock;
+    PCredHandle pcredhandle;
+    CHECK_SECURITYFUNCTIONTABLE(InitializeSecurityContextW);
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "OO|Oil:CreateSecureChannel", keywords,
+            &obsocket, &obcred, &obtargetname, &bServer, &contextreq))
+        return NULL;
+    if (!PySocket_AsSOCKET(obsocket, &sock))
+        return NULL;
+    if (!PyWinObject_AsCredHandle(obcred, &pcredhandle, FALSE))
+        return NULL;
+    PySecureChannel *ret = new PySecureChannel();
+    if (ret == NULL)
+        return PyErr_NoMemory();
+    if (!PyWinObject_AsWCHAR(obtargetname, &ret->targetname, TRUE) ||
+        !ret->Reserve(&ret->inbuf, &ret->incap, 0x4000)) {
+        if (ret->lastfunc != NULL)
+            ret->SetError();
+        Py_DECREF(ret);
+        return NULL;
+    }
+    ret->sock = sock;
+    ret->credhandle = *pcredhandle;
+    ret->bServer = bServer;
+    if (bServer)
+        ret->contextreq = contextreq | ASC_REQ_SEQUENCE_DETECT | ASC_REQ_REPLAY_DETECT | ASC_REQ_CONFIDENTIALITY |
+                          ASC_REQ_EXTENDED_ERROR | ASC_REQ_ALLOCATE_MEMORY | ASC_REQ_STREAM;
+    else
+        ret->contextreq = contextreq | ISC_REQ_SEQUENCE_DETECT | ISC_REQ_REPLAY_DETECT | ISC_REQ_CONFIDENTIALITY |
+                          ISC_REQ_EXTENDED_ERROR | ISC_REQ_ALLOCATE_MEMORY | ISC_REQ_STREAM;
+    // Keep the socket and credentials alive for as long as we use them.
+    Py_INCREF(obsocket);
+    ret->obsocket = obsocket;
+    Py_INCREF(obcred);
+    ret->obcredentials = obcred;
+    return ret;
+}
@@ -53,8 +53,12 @@ class PySecBuffer : public PyObject {
     static PyObject *tp_new(PyTypeObject *, PyObject *, PyObject *);
     static PyObject *tp_repr(PyObject * obj);
     static PyObject *Clear(PyObject *self, PyObject *args);
+    static PyObject *SetRegion(PyObject *self, PyObject *args);
 
     PSecBuffer GetSecBuffer(void);
+    BOOL Wrap(PyObject *ob, ULONG offset, ULONG size);
+    BYTE *GetBase(void);
+    ULONG GetBaseSize(void);
     PyObject *obdummy;
     // InitializeSecurityContext and AcceptSecurityContext change the cbBuffer in the structure to reflect
     // bytes used, keep our own allocated size
@@ -63,6 +67,10 @@ class PySecBuffer : public PyObject {
    protected:
     SecBuffer secbuffer;
     void *allocBuffer;
+    ULONG allocSize;
+    // Writable view of a caller's object when the buffer wraps it instead of owning its memory
+    Py_buffer wrapview;
+    BOOL bWrapped;
 };
 
 class PySecBufferDesc : public PyObject {
@@ -117,6 +125,8 @@ class PyCtxtHandle : public PyObject {
     static PyObject *VerifySignature(PyObject *self, PyObject *args);
     static PyObject *EncryptMessage(PyObject *self, PyObject *args);
     static PyObject *DecryptMessage(PyObject *self, PyObject *args);
+    static PyObject *EncryptMessages(PyObject *self, PyObject *args);
+    static PyObject *DecryptMessages(PyObject *self, PyObject *args);
     static PyObject *Detach(PyObject *self, PyObject *args);
     static PyObject *DeleteSecurityContext(PyObject *self, PyObject *args);
     static PyObject *CompleteAuthToken(PyObject *self, PyObject *args);
@@ -157,12 +167,68 @@ class PyCredHandle : public PyObject {
     CredHandle credhandle;
 };
 
+// TLS connection over a socket, created by win32security.CreateSecureChannel
+extern __declspec(dllexport) PyTypeObject PySecureChannelType;
+
+class PySecureChannel : public PyObject {
+   public:
+#ifdef _MSC_VER
+#pragma warning(disable : 4251)
+#endif  // _MSC_VER
+    static struct PyMemberDef members[];
+    static struct PyMethodDef methods[];
+#ifdef _MSC_VER
+#pragma warning(default : 4251)
+#endif  // _MSC_VER
+
+    PySecureChannel(void);
+    ~PySecureChannel();
+    static void deallocFunc(PyObject *ob);
+    static PyObject *Handshake(PyObject *self, PyObject *args);
+    static PyObject *Read(PyObject *self, PyObject *args);
+    static PyObject *ReadInto(PyObject *self, PyObject *args);
+    static PyObject *Write(PyObject *self, PyObject *args);
+    static PyObject *Shutdown(PyObject *self, PyObject *args);
+    static PyObject *QueryContextAttributes(PyObject *self, PyObject *args);
+    static PyObject *Close(PyObject *self, PyObject *args);
+
+    BOOL Reserve(BYTE **pbuf, DWORD *pcap, DWORD size);
+    PyObject *SetError(void);
+    BOOL Enter(BOOL bConnect);
+    void Cleanup(void);
+    BOOL Fail(const char *fname, DWORD err);
+    BOOL SendAll(const BYTE *data, DWORD len);
+    int RecvMore(void);
+    void KeepExtra(SecBuffer *bufs, ULONG nbufs);
+    BOOL DoHandshake(void);
+    int ReadRecord(BOOL bWait);
+    int ReadData(BYTE *dest, DWORD len, DWORD *pread);
+    BOOL WriteData(const BYTE *data, DWORD len);
+    BOOL DoShutdown(void);
+
+    PyObject *obsocket, *obcredentials;
+    SOCKET sock;
+    CredHandle credhandle;
+    CtxtHandle ctxthandle;
+    WCHAR *targetname;
+    ULONG contextreq, contextattr;
+    BOOL bServer, bHaveContext, bConnected, bShutdown, bEof, bBusy, bClosed;
+    SecPkgContext_StreamSizes sizes;
+    // Received data not yet decrypted, decrypted data not yet read, and space to build an outgoing record.
+    BYTE *inbuf, *plainbuf, *sendbuf;
+    DWORD incap, incount, plaincap, plainpos, plainlen, sendcap;
+    ULONG recordsread, recordswritten;
+    const char *lastfunc;
+    DWORD lasterr;
+};
+
 // functions implemented in win32security_sspi.cpp and wrapped as %native with SWIG
 PyObject *PyDsGetSpn(PyObject *self, PyObject *args);
 PyObject *PyDsWriteAccountSpn(PyObject *self, PyObject *args);
 PyObject *PyDsBind(PyObject *self, PyObject *args);
 PyObject *PyDsUnBind(PyObject *self, PyObject *args);
 PyObject *PyDsGetDcName(PyObject *self, PyObject *args, PyObject *kw);
+PyObject *PyCreateSecureChannel(PyObject *self, PyObject *args, PyObject *kwargs);
 
 // function pointers that are initialized in win32security.i and used in win32security_sspi.cpp
 typedef DWORD(WINAPI *DsBindfunc)(LPCTSTR, LPCTSTR, HANDLE *);
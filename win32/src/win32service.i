@@ -20,6 +20,8 @@ QueryServiceConfig2func fpQueryServiceConfig2=NULL;
 typedef BOOL (WINAPI *EnumServicesStatusExfunc)(SC_HANDLE,SC_ENUM_TYPE,DWORD,DWORD,
 	LPBYTE,DWORD,LPDWORD,LPDWORD,LPDWORD,LPCTSTR);
 EnumServicesStatusExfunc fpEnumServicesStatusEx=NULL;
+typedef DWORD (WINAPI *NotifyServiceStatusChangefunc)(SC_HANDLE,DWORD,PSERVICE_NOTIFYW);
+NotifyServiceStatusChangefunc fpNotifyServiceStatusChange=NULL;
 
 // according to msdn, 256 is limit for service names and service display names
 #define MAX_SERVICE_NAME_LEN 256   
@@ -33,6 +35,8 @@ EnumServicesStatusExfunc fpEnumServicesStatusEx=NULL;
 		PyType_Ready(&PyHDESKType) == -1)
 		return NULL;
 #endif
+	if (PyType_Ready(&PyServiceStatusWatcher_Type) == -1)
+		PYWIN_MODULE_INIT_RETURN_ERROR;
 
 	// All errors raised by this module are of this type.
 	PyDict_SetItemString(d, "error", PyWinExc_ApiError);
@@ -56,6 +60,9 @@ EnumServicesStatusExfunc fpEnumServicesStatusEx=NULL;
 		fp=GetProcAddress(hmod,"EnumServicesStatusExW");
 		if (fp!=NULL)
 			fpEnumServicesStatusEx=(EnumServicesStatusExfunc)fp;
+		fp=GetProcAddress(hmod,"NotifyServiceStatusChangeW");
+		if (fp!=NULL)
+			fpNotifyServiceStatusChange=(NotifyServiceStatusChangefunc)fp;
 		}
 %}
 
@@ -990,6 +997,220 @@ static PyObject *MyEnumServicesStatusEx(PyObject *self, PyObject *args)
 }
 %}
 
+// @pyswig dict|EnumServicesSnapshot|Returns the status, and optionally the configuration, of all matching services in columns.
+// @rdesc Returns a dict mapping each field name to a tuple with one item per service, in the order
+// the services were enumerated.  The keys are ServiceName, DisplayName and the fields of
+// ENUM_SERVICE_STATUS_PROCESS (ServiceType, CurrentState, ControlsAccepted, Win32ExitCode,
+// ServiceSpecificExitCode, CheckPoint, WaitHint, ProcessId, ServiceFlags).  If IncludeConfig is true,
+// the fields of QUERY_SERVICE_CONFIG are added (StartType, ErrorControl, BinaryPathName, LoadOrderGroup,
+// TagId, Dependencies, ServiceStartName) along with ConfigError, which is 0 or the error code that prevented
+// the configuration of that service from being read.  The config items of such a service are None.
+// @comm The whole snapshot is taken with the GIL released, using the one SCM handle, before any
+// Python objects are created.  This is much cheaper than calling <om win32service.EnumServicesStatusEx>
+// followed by <om win32service.OpenService> and <om win32service.QueryServiceConfig> for each service.
+// @pyseeapi EnumServicesStatusEx
+// @pyseeapi QueryServiceConfig
+%native (EnumServicesSnapshot) MyEnumServicesSnapshot;
+%{
+// The largest QUERY_SERVICE_CONFIG that QueryServiceConfig can return
+#define SNAPSHOT_CONFIG_SIZE 8192
+
+typedef struct {
+	QUERY_SERVICE_CONFIGW *config;	// A copy of the config with its pointers relocated, or NULL
+	DWORD err;
+} SNAPSHOT_CONFIG;
+
+static const char *snapshot_status_cols[] = {"ServiceType", "CurrentState", "ControlsAccepted",
+	"Win32ExitCode", "ServiceSpecificExitCode", "CheckPoint", "WaitHint", "ProcessId", "ServiceFlags"};
+#define SNAPSHOT_NUM_STATUS (sizeof(snapshot_status_cols) / sizeof(snapshot_status_cols[0]))
+static const char *snapshot_config_cols[] = {"StartType", "ErrorControl", "BinaryPathName",
+	"LoadOrderGroup", "TagId", "Dependencies", "ServiceStartName", "ConfigError"};
+#define SNAPSHOT_NUM_CONFIG (sizeof(snapshot_config_cols) / sizeof(snapshot_config_cols[0]))
+
+static WCHAR *snapshot_relocate(WCHAR *p, BYTE *from, BYTE *to)
+{
+	return p ? (WCHAR *)(to + ((BYTE *)p - from)) : NULL;
+}
+
+// Reads the config of each service - called without the GIL.
+static void snapshot_read_configs(SC_HANDLE hscm, ENUM_SERVICE_STATUS_PROCESSW *essp, DWORD nbr,
+	SNAPSHOT_CONFIG *configs, BYTE *cfgbuf)
+{
+	for (DWORD i=0; i<nbr; i++){
+		SC_HANDLE hsvc = OpenServiceW(hscm, essp[i].lpServiceName, SERVICE_QUERY_CONFIG);
+		if (hsvc == NULL){
+			configs[i].err = GetLastError();
+			continue;
+			}
+		DWORD needed;
+		if (!QueryServiceConfigW(hsvc, (QUERY_SERVICE_CONFIGW *)cfgbuf, SNAPSHOT_CONFIG_SIZE, &needed))
+			configs[i].err = GetLastError();
+		else{
+			BYTE *copy = (BYTE *)malloc(SNAPSHOT_CONFIG_SIZE);
+			if (copy == NULL)
+				configs[i].err = ERROR_NOT_ENOUGH_MEMORY;
+			else{
+				memcpy(copy, cfgbuf, SNAPSHOT_CONFIG_SIZE);
+				QUERY_SERVICE_CONFIGW *c = (QUERY_SERVICE_CONFIGW *)copy;
+				c->lpBinaryPathName = snapshot_relocate(c->lpBinaryPathName, cfgbuf, copy);
+				c->lpLoadOrderGroup = snapshot_relocate(c->lpLoadOrderGroup, cfgbuf, copy);
+				c->lpDependencies = snapshot_relocate(c->lpDependencies, cfgbuf, copy);
+				c->lpServiceStartName = snapshot_relocate(c->lpServiceStartName, cfgbuf, copy);
+				c->lpDisplayName = snapshot_relocate(c->lpDisplayName, cfgbuf, copy);
+				configs[i].config = c;
+				}
+			}
+		CloseServiceHandle(hsvc);
+		}
+}
+
+static PyObject *snapshot_config_item(SNAPSHOT_CONFIG *sc, DWORD col)
+{
+	QUERY_SERVICE_CONFIGW *c = sc->config;
+	if (col == 7)
+		return PyLong_FromUnsignedLong(sc->err);
+	if (c == NULL){
+		Py_INCREF(Py_None);
+		return Py_None;
+		}
+	switch (col){
+		case 0: return PyLong_FromUnsignedLong(c->dwStartType);
+		case 1: return PyLong_FromUnsignedLong(c->dwErrorControl);
+		case 2: return PyWinObject_FromWCHAR(c->lpBinaryPathName);
+		case 3: return PyWinObject_FromWCHAR(c->lpLoadOrderGroup);
+		case 4: return PyLong_FromUnsignedLong(c->dwTagId);
+		case 5: return PyWinObject_FromMultipleString(c->lpDependencies);
+		default: return PyWinObject_FromWCHAR(c->lpServiceStartName);
+		}
+}
+
+static PyObject *MyEnumServicesSnapshot(PyObject *self, PyObject *args)
+{
+	// @pyparm <o PySC_HANDLE>|SCManager||Handle to service control manager as returned by <om win32service.OpenSCManager>
+	// @pyparm int|ServiceType|SERVICE_WIN32|Types of services to enumerate (SERVICE_DRIVER and/or SERVICE_WIN32)
+	// @pyparm int|ServiceState|SERVICE_STATE_ALL|Limits to services in specified state
+	// @pyparm bool|IncludeConfig|True|Also read the configuration of each service.  The SCM handle needs
+	// SC_MANAGER_CONNECT access, and configs of services which can't be opened for SERVICE_QUERY_CONFIG are left out.
+	SC_HANDLE hscm;
+	DWORD service_type = SERVICE_WIN32, service_state = SERVICE_STATE_ALL;
+	BOOL bConfig = TRUE;
+	BYTE *buf = NULL, *cfgbuf = NULL;
+	DWORD buf_size = 0, buf_needed = 0, nbr = 0, resume_handle, err = 0;
+	SNAPSHOT_CONFIG *configs = NULL;
+	PyObject *cols[2 + SNAPSHOT_NUM_STATUS + SNAPSHOT_NUM_CONFIG];
+	DWORD ncols = 0, i, c;
+	PyObject *ret = NULL;
+	BOOL bsuccess = FALSE;
+
+	if (fpEnumServicesStatusEx == NULL){
+		PyErr_SetString(PyExc_NotImplementedError, "EnumServicesStatusEx does not exist on this platform");
+		return NULL;
+		}
+	if (!PyArg_ParseTuple(args, "O&|kki:EnumServicesSnapshot",
+		PyWinObject_AsHANDLE, &hscm,
+		&service_type, &service_state, &bConfig))
+		return NULL;
+
+	Py_BEGIN_ALLOW_THREADS
+	// Start from the top until everything fits in one call, so that the entries are consistent
+	// with each other.  A few retries allow for services being created meanwhile.
+	for (int tries=0; tries<8; tries++){
+		resume_handle = 0;
+		bsuccess = (*fpEnumServicesStatusEx)(hscm, SC_ENUM_PROCESS_INFO, service_type, service_state,
+			buf, buf_size, &buf_needed, &nbr, &resume_handle, NULL);
+		if (bsuccess)
+			break;
+		err = GetLastError();
+		if (err != ERROR_MORE_DATA)
+			break;
+		free(buf);
+		buf_size += buf_needed + 4096;
+		buf = (BYTE *)malloc(buf_size);
+		if (buf == NULL){
+			err = ERROR_NOT_ENOUGH_MEMORY;
+			break;
+			}
+		}
+	if (bsuccess && bConfig && nbr){
+		configs = (SNAPSHOT_CONFIG *)calloc(nbr, sizeof(SNAPSHOT_CONFIG));
+		cfgbuf = (BYTE *)malloc(SNAPSHOT_CONFIG_SIZE);
+		if (configs == NULL || cfgbuf == NULL){
+			bsuccess = FALSE;
+			err = ERROR_NOT_ENOUGH_MEMORY;
+			}
+		else
+			snapshot_read_configs(hscm, (ENUM_SERVICE_STATUS_PROCESSW *)buf, nbr, configs, cfgbuf);
+		}
+	Py_END_ALLOW_THREADS
+
+	if (!bsuccess){
+		PyWin_SetAPIError("EnumServicesStatusEx", err);
+		goto cleanup;
+		}
+	ENUM_SERVICE_STATUS_PROCESSW *essp;
+	essp = (ENUM_SERVICE_STATUS_PROCESSW *)buf;
+	ncols = 2 + SNAPSHOT_NUM_STATUS + (bConfig ? SNAPSHOT_NUM_CONFIG : 0);
+	memset(cols, 0, sizeof(cols));
+	for (c=0; c<ncols; c++){
+		cols[c] = PyTuple_New(nbr);
+		if (cols[c] == NULL)
+			goto cleanup;
+		}
+	for (i=0; i<nbr; i++){
+		PyObject *item;
+		for (c=0; c<ncols; c++){
+			if (c == 0)
+				item = PyWinObject_FromWCHAR(essp[i].lpServiceName);
+			else if (c == 1)
+				item = PyWinObject_FromWCHAR(essp[i].lpDisplayName);
+			else if (c < 2 + SNAPSHOT_NUM_STATUS)
+				// SERVICE_STATUS_PROCESS is all DWORDs, in the order of snapshot_status_cols
+				item = PyLong_FromUnsignedLong(((DWORD *)&essp[i].ServiceStatusProcess)[c - 2]);
+			else if (configs)
+				item = snapshot_config_item(configs + i, c - 2 - SNAPSHOT_NUM_STATUS);
+			else{
+				Py_INCREF(Py_None);
+				item = Py_None;
+				}
+			if (item == NULL)
+				goto cleanup;
+			PyTuple_SET_ITEM(cols[c], i, item);
+			}
+		}
+	ret = PyDict_New();
+	if (ret == NULL)
+		goto cleanup;
+	for (c=0; c<ncols; c++){
+		const char *name;
+		if (c == 0)
+			name = "ServiceName";
+		else if (c == 1)
+			name = "DisplayName";
+		else if (c < 2 + SNAPSHOT_NUM_STATUS)
+			name = snapshot_status_cols[c - 2];
+		else
+			name = snapshot_config_cols[c - 2 - SNAPSHOT_NUM_STATUS];
+		if (PyDict_SetItemString(ret, name, cols[c]) == -1){
+			Py_DECREF(ret);
+			ret = NULL;
+			break;
+			}
+		}
+
+cleanup:
+	for (c=0; c<ncols; c++)
+		Py_XDECREF(cols[c]);
+	if (configs){
+		for (i=0; i<nbr; i++)
+			free(configs[i].config);
+		free(configs);
+		}
+	free(cfgbuf);
+	free(buf);
+	return ret;
+}
+%}
+
 // @pyswig (tuple,...)|EnumDependentServices|Lists services that depend on a service
 // @rdesc Returns a sequence of tuples representing ENUM_SERVICE_STATUS structs: (ServiceName, DisplayName, <o SERVICE_STATUS>)
 %native (EnumDependentServices) MyEnumDependentServices;
@@ -1268,6 +1489,474 @@ PyObject *MyQueryServiceStatusEx(PyObject *self, PyObject *args)
 }
 %}
 
+// @object PyServiceStatusWatcher|Receives status change notifications for a set of services,
+// returned by <om win32service.CreateServiceStatusWatcher>.
+// @comm A native thread registers each service with NotifyServiceStatusChange and waits
+// in an alertable state.  The notification callbacks (which run as APCs on that thread)
+// only copy the SERVICE_STATUS_PROCESS into a fixed size queue and re-register, so
+// no Python code runs until the transitions are collected with <om PyServiceStatusWatcher.GetBatch>
+// or by iterating over the watcher.
+// <nl>Each transition is a tuple of (ServiceName, NotificationTriggered, NotificationStatus, ServiceType,
+// CurrentState, ControlsAccepted, Win32ExitCode, ServiceSpecificExitCode, CheckPoint, WaitHint, ProcessId,
+// ServiceFlags).  NotificationStatus is 0 unless the notification failed.  If a service can't be watched
+// any more (after it is deleted, or if it can't be registered again) a final tuple with NotificationTriggered of 0
+// and the error code as NotificationStatus is queued for it.
+%{
+#ifndef ERROR_SERVICE_NOTIFY_CLIENT_LAGGING
+#define ERROR_SERVICE_NOTIFY_CLIENT_LAGGING 1294L
+#endif
+#define SSW_ALL_NOTIFICATIONS (SERVICE_NOTIFY_STOPPED | SERVICE_NOTIFY_START_PENDING | \
+	SERVICE_NOTIFY_STOP_PENDING | SERVICE_NOTIFY_RUNNING | SERVICE_NOTIFY_CONTINUE_PENDING | \
+	SERVICE_NOTIFY_PAUSE_PENDING | SERVICE_NOTIFY_PAUSED | SERVICE_NOTIFY_DELETE_PENDING)
+
+struct PyServiceStatusWatcher;
+
+typedef struct {
+	SERVICE_NOTIFYW notify;
+	struct PyServiceStatusWatcher *w;
+	SC_HANDLE hService;
+	WCHAR *name;
+	PyObject *obName;
+	BOOL bArmed;	// A registration is outstanding
+	BOOL bDead;	// The service isn't watched any more
+} SSW_SLOT;
+
+typedef struct {
+	DWORD slot;
+	DWORD triggered;
+	DWORD status;
+	SERVICE_STATUS_PROCESS ssp;
+} SSW_EVENT;
+
+typedef struct PyServiceStatusWatcher {
+	PyObject_HEAD
+	CRITICAL_SECTION cs;
+	HANDLE hThread;
+	HANDLE hStop;		// manual reset, set by ssw_close
+	HANDLE hReady;		// manual reset, set while the queue isn't empty
+	HANDLE hStarted;
+	SC_HANDLE hSCM;
+	DWORD mask;
+	SSW_SLOT *slots;
+	DWORD numSlots;
+	SSW_EVENT *queue;	// ring of maxQueue events
+	DWORD maxQueue, head, count;
+	DWORD startError;	// first registration failure, reported by the factory
+	BOOL bClosed;
+	// stats
+	long notifications;
+	long dropped;
+	long batches;
+	long reopened;
+} PyServiceStatusWatcher;
+
+extern PyTypeObject PyServiceStatusWatcher_Type;
+
+// Adds a transition to the queue, dropping the oldest if it is full.
+static void ssw_push(PyServiceStatusWatcher *w, DWORD slot, DWORD triggered, DWORD status, SERVICE_STATUS_PROCESS *ssp)
+{
+	EnterCriticalSection(&w->cs);
+	if (w->count == w->maxQueue){
+		w->head = (w->head + 1) % w->maxQueue;
+		w->count--;
+		w->dropped++;
+		}
+	SSW_EVENT *e = w->queue + (w->head + w->count) % w->maxQueue;
+	e->slot = slot;
+	e->triggered = triggered;
+	e->status = status;
+	if (ssp)
+		e->ssp = *ssp;
+	else
+		memset(&e->ssp, 0, sizeof(e->ssp));
+	w->count++;
+	SetEvent(w->hReady);
+	LeaveCriticalSection(&w->cs);
+}
+
+static VOID CALLBACK ssw_callback(PVOID param)
+{
+	SERVICE_NOTIFYW *n = (SERVICE_NOTIFYW *)param;
+	SSW_SLOT *s = (SSW_SLOT *)n->pContext;
+	PyServiceStatusWatcher *w = s->w;
+	s->bArmed = FALSE;
+	InterlockedIncrement(&w->notifications);
+	// The handle can't be registered again once the service is marked for deletion.
+	if (n->dwNotificationTriggered & SERVICE_NOTIFY_DELETE_PENDING)
+		s->bDead = TRUE;
+	ssw_push(w, (DWORD)(s - w->slots), n->dwNotificationTriggered, n->dwNotificationStatus, &n->ServiceStatus);
+}
+
+// Registers a slot for its next notification - called on the watcher thread.
+static DWORD ssw_arm(PyServiceStatusWatcher *w, SSW_SLOT *s)
+{
+	memset(&s->notify, 0, sizeof(s->notify));
+	s->notify.dwVersion = SERVICE_NOTIFY_STATUS_CHANGE;
+	s->notify.pfnNotifyCallback = (PFN_SC_NOTIFY_CALLBACK)ssw_callback;
+	s->notify.pContext = s;
+	DWORD err = (*fpNotifyServiceStatusChange)(s->hService, w->mask, &s->notify);
+	if (err == ERROR_SERVICE_NOTIFY_CLIENT_LAGGING){
+		// We fell too far behind the SCM, and the handle has to be reopened.
+		CloseServiceHandle(s->hService);
+		w->reopened++;
+		s->hService = OpenServiceW(w->hSCM, s->name, SERVICE_QUERY_STATUS);
+		if (s->hService == NULL)
+			err = GetLastError();
+		else
+			err = (*fpNotifyServiceStatusChange)(s->hService, w->mask, &s->notify);
+		}
+	if (err == ERROR_SUCCESS)
+		s->bArmed = TRUE;
+	return err;
+}
+
+static void ssw_arm_all(PyServiceStatusWatcher *w, BOOL bStarting)
+{
+	for (DWORD i=0; i<w->numSlots; i++){
+		SSW_SLOT *s = w->slots + i;
+		if (s->bArmed)
+			continue;
+		DWORD err = s->bDead ? ERROR_SERVICE_MARKED_FOR_DELETE : ssw_arm(w, s);
+		if (err == ERROR_SUCCESS)
+			continue;
+		if (bStarting){
+			if (w->startError == 0)
+				w->startError = err;
+			continue;
+			}
+		// Queue the final tuple, and close the handle so the slot is skipped from now on.
+		ssw_push(w, i, 0, err, NULL);
+		s->bArmed = TRUE;
+		s->bDead = TRUE;
+		if (s->hService){
+			CloseServiceHandle(s->hService);
+			s->hService = NULL;
+			}
+		}
+}
+
+static DWORD WINAPI ssw_thread(LPVOID param)
+{
+	PyServiceStatusWatcher *w = (PyServiceStatusWatcher *)param;
+	ssw_arm_all(w, TRUE);
+	SetEvent(w->hStarted);
+	if (w->startError == 0){
+		for (;;){
+			DWORD rc = WaitForSingleObjectEx(w->hStop, INFINITE, TRUE);
+			if (rc != WAIT_IO_COMPLETION)
+				break;
+			// One or more callbacks have run - register those services again.
+			ssw_arm_all(w, FALSE);
+			}
+		}
+	// Closing the handles cancels the registrations, then run any callbacks that were already queued.
+	for (DWORD i=0; i<w->numSlots; i++){
+		if (w->slots[i].hService){
+			CloseServiceHandle(w->slots[i].hService);
+			w->slots[i].hService = NULL;
+			}
+		}
+	SleepEx(0, TRUE);
+	return 0;
+}
+
+static void ssw_close(PyServiceStatusWatcher *w)
+{
+	if (w->bClosed)
+		return;
+	w->bClosed = TRUE;
+	Py_BEGIN_ALLOW_THREADS
+	if (w->hThread){
+		SetEvent(w->hStop);
+		WaitForSingleObject(w->hThread, INFINITE);
+		CloseHandle(w->hThread);
+		w->hThread = NULL;
+		}
+	for (DWORD i=0; i<w->numSlots; i++){
+		if (w->slots[i].hService){
+			CloseServiceHandle(w->slots[i].hService);
+			w->slots[i].hService = NULL;
+			}
+		}
+	if (w->hSCM){
+		CloseServiceHandle(w->hSCM);
+		w->hSCM = NULL;
+		}
+	Py_END_ALLOW_THREADS
+}
+
+static void ssw_dealloc(PyObject *ob)
+{
+	PyServiceStatusWatcher *w = (PyServiceStatusWatcher *)ob;
+	ssw_close(w);
+	if (w->slots){
+		for (DWORD i=0; i<w->numSlots; i++){
+			PyWinObject_FreeWCHAR(w->slots[i].name);
+			Py_XDECREF(w->slots[i].obName);
+			}
+		free(w->slots);
+		}
+	free(w->queue);
+	if (w->hStop)
+		CloseHandle(w->hStop);
+	if (w->hReady)
+		CloseHandle(w->hReady);
+	if (w->hStarted)
+		CloseHandle(w->hStarted);
+	DeleteCriticalSection(&w->cs);
+	PyObject_Del(ob);
+}
+
+// Waits for transitions and takes up to maxItems of them.  Returns NULL without
+// an exception set if the watcher is closed.
+static PyObject *ssw_get_batch(PyServiceStatusWatcher *w, DWORD timeout, DWORD maxItems)
+{
+	DWORD rc;
+	HANDLE handles[2] = {w->hReady, w->hStop};
+	Py_BEGIN_ALLOW_THREADS
+	rc = WaitForMultipleObjects(2, handles, FALSE, timeout);
+	Py_END_ALLOW_THREADS
+	if (rc == WAIT_FAILED)
+		return PyWin_SetAPIError("WaitForMultipleObjects");
+	if (w->bClosed)
+		return NULL;
+	EnterCriticalSection(&w->cs);
+	DWORD n = w->count;
+	if (maxItems && maxItems < n)
+		n = maxItems;
+	PyObject *ret = PyList_New(n);
+	if (ret != NULL){
+		for (DWORD i=0; i<n; i++){
+			SSW_EVENT *e = w->queue + (w->head + i) % w->maxQueue;
+			SERVICE_STATUS_PROCESS *p = &e->ssp;
+			PyObject *item = Py_BuildValue("Okkkkkkkkkkk", w->slots[e->slot].obName,
+				e->triggered, e->status, p->dwServiceType, p->dwCurrentState,
+				p->dwControlsAccepted, p->dwWin32ExitCode, p->dwServiceSpecificExitCode,
+				p->dwCheckPoint, p->dwWaitHint, p->dwProcessId, p->dwServiceFlags);
+			if (item == NULL){
+				Py_DECREF(ret);
+				ret = NULL;
+				break;
+				}
+			PyList_SET_ITEM(ret, i, item);
+			}
+		}
+	if (ret != NULL){
+		w->head = (w->head + n) % w->maxQueue;
+		w->count -= n;
+		if (w->count == 0)
+			ResetEvent(w->hReady);
+		if (n)
+			w->batches++;
+		}
+	LeaveCriticalSection(&w->cs);
+	return ret;
+}
+
+// @pymethod [tuple, ...]|PyServiceStatusWatcher|GetBatch|Waits for status transitions and returns those queued.
+// @rdesc The result is an empty list if the timeout expires first.  See <o PyServiceStatusWatcher> for the
+// contents of each tuple.
+static PyObject *ssw_GetBatch(PyObject *self, PyObject *args)
+{
+	PyServiceStatusWatcher *w = (PyServiceStatusWatcher *)self;
+	DWORD timeout = INFINITE, maxItems = 0;
+	if (!PyArg_ParseTuple(args, "|kk:GetBatch",
+		&timeout, // @pyparm int|timeout|win32event.INFINITE|The time in milliseconds to wait.
+		&maxItems)) // @pyparm int|maxItems|0|The most transitions to return, or 0 for all of them.
+		return NULL;
+	if (w->bClosed)
+		return PyErr_Format(PyExc_ValueError, "The watcher has been closed");
+	PyObject *ret = ssw_get_batch(w, timeout, maxItems);
+	if (ret == NULL && !PyErr_Occurred())
+		PyErr_Format(PyExc_ValueError, "The watcher has been closed");
+	return ret;
+}
+
+static PyObject *ssw_iternext(PyObject *self)
+{
+	PyServiceStatusWatcher *w = (PyServiceStatusWatcher *)self;
+	if (w->bClosed)
+		return NULL;
+	// NULL without an exception stops the iteration once closed.
+	return ssw_get_batch(w, INFINITE, 0);
+}
+
+// @pymethod |PyServiceStatusWatcher|Close|Cancels the notifications and stops the thread.
+// @comm A thread blocked in <om PyServiceStatusWatcher.GetBatch> raises ValueError, and an iteration stops.
+static PyObject *ssw_Close(PyObject *self, PyObject *args)
+{
+	if (!PyArg_ParseTuple(args, ":Close"))
+		return NULL;
+	ssw_close((PyServiceStatusWatcher *)self);
+	Py_INCREF(Py_None);
+	return Py_None;
+}
+
+// @prop int|event|An integer handle to a manual reset event which is signalled while transitions are queued,
+// for use with win32event.WaitForMultipleObjects.  It stays owned by the watcher.
+static PyObject *ssw_get_event(PyObject *self, void *context)
+{
+	return PyWinLong_FromHANDLE(((PyServiceStatusWatcher *)self)->hReady);
+}
+
+static PyMethodDef ssw_methods[] = {
+	{"GetBatch", ssw_GetBatch, METH_VARARGS}, // @pymeth GetBatch|Waits for status transitions and returns those queued.
+	{"Close", ssw_Close, METH_VARARGS}, // @pymeth Close|Cancels the notifications.
+	{NULL}
+};
+
+static PyGetSetDef ssw_getset[] = {
+	{"event", ssw_get_event, NULL},
+	{NULL}
+};
+
+#undef OFF
+#define OFF(e) offsetof(PyServiceStatusWatcher, e)
+static PyMemberDef ssw_members[] = {
+	{"notifications", T_LONG, OFF(notifications), READONLY}, // @prop int|notifications|The number of notification callbacks received.
+	{"dropped", T_LONG, OFF(dropped), READONLY}, // @prop int|dropped|The number of transitions lost because the queue was full.
+	{"batches", T_LONG, OFF(batches), READONLY}, // @prop int|batches|The number of non-empty batches returned.
+	{"reopened", T_LONG, OFF(reopened), READONLY}, // @prop int|reopened|The number of service handles reopened because the SCM reported the watcher as lagging.
+	{NULL}
+};
+#undef OFF
+
+PyTypeObject PyServiceStatusWatcher_Type = {
+	PYWIN_OBJECT_HEAD
+	"PyServiceStatusWatcher",		/* tp_name */
+	sizeof(PyServiceStatusWatcher),		/* tp_basicsize */
+	0,					/* tp_itemsize */
+	ssw_dealloc,				/* tp_dealloc */
+	0,					/* tp_print */
+	0,					/* tp_getattr */
+	0,					/* tp_setattr */
+	0,					/* tp_compare */
+	0,					/* tp_repr */
+	0,					/* tp_as_number */
+	0,					/* tp_as_sequence */
+	0,					/* tp_as_mapping */
+	0,					/* tp_hash */
+	0,					/* tp_call */
+	0,					/* tp_str */
+	PyObject_GenericGetAttr,		/* tp_getattro */
+	0,					/* tp_setattro */
+	0,					/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,			/* tp_flags */
+	0,					/* tp_doc */
+	0,					/* tp_traverse */
+	0,					/* tp_clear */
+	0,					/* tp_richcompare */
+	0,					/* tp_weaklistoffset */
+	PyObject_SelfIter,			/* tp_iter */
+	ssw_iternext,				/* tp_iternext */
+	ssw_methods,				/* tp_methods */
+	ssw_members,				/* tp_members */
+	ssw_getset,				/* tp_getset */
+};
+
+static PyObject *MyCreateServiceStatusWatcher(PyObject *self, PyObject *args)
+{
+	PyObject *obServices, *obMachine = Py_None;
+	DWORD mask = SSW_ALL_NOTIFICATIONS, maxQueue = 4096;
+	if (fpNotifyServiceStatusChange == NULL){
+		PyErr_SetString(PyExc_NotImplementedError, "NotifyServiceStatusChange does not exist on this platform");
+		return NULL;
+		}
+	if (!PyArg_ParseTuple(args, "O|kOk:CreateServiceStatusWatcher",
+		&obServices, // @pyparm [<o PyUnicode>, ...]|Services||The names of the services to watch.
+		&mask, // @pyparm int|NotifyMask|all SERVICE_NOTIFY_* states|The SERVICE_NOTIFY_* transitions to report.
+		&obMachine, // @pyparm <o PyUnicode>|MachineName|None|The computer whose services are watched.  The watcher opens its own SCM handle.
+		&maxQueue)) // @pyparm int|MaxQueue|4096|The most transitions kept between batches.  The oldest are dropped, and counted, past this.
+		return NULL;
+	if (maxQueue == 0)
+		return PyErr_Format(PyExc_ValueError, "MaxQueue must be greater than zero");
+	TmpPyObject seq = PySequence_Fast(obServices, "Services must be a sequence of service names");
+	if (seq == NULL)
+		return NULL;
+	DWORD n = (DWORD)PySequence_Fast_GET_SIZE((PyObject *)seq);
+	if (n == 0)
+		return PyErr_Format(PyExc_ValueError, "At least one service must be given");
+	TmpWCHAR machine;
+	if (!PyWinObject_AsWCHAR(obMachine, &machine, TRUE))
+		return NULL;
+
+	PyServiceStatusWatcher *w = PyObject_New(PyServiceStatusWatcher, &PyServiceStatusWatcher_Type);
+	if (w == NULL)
+		return NULL;
+	memset(((PyObject *)w) + 1, 0, sizeof(PyServiceStatusWatcher) - sizeof(PyObject));
+	InitializeCriticalSection(&w->cs);
+	w->mask = mask;
+	w->maxQueue = maxQueue;
+	w->slots = (SSW_SLOT *)calloc(n, sizeof(SSW_SLOT));
+	w->queue = (SSW_EVENT *)malloc(maxQueue * sizeof(SSW_EVENT));
+	if (w->slots == NULL || w->queue == NULL){
+		Py_DECREF(w);
+		return PyErr_NoMemory();
+		}
+	w->numSlots = n;
+	for (DWORD i=0; i<n; i++){
+		SSW_SLOT *s = w->slots + i;
+		s->w = w;
+		s->obName = PySequence_Fast_GET_ITEM((PyObject *)seq, i);
+		Py_INCREF(s->obName);
+		if (!PyWinObject_AsWCHAR(s->obName, &s->name)){
+			Py_DECREF(w);
+			return NULL;
+			}
+		}
+	w->hStop = CreateEvent(NULL, TRUE, FALSE, NULL);
+	w->hReady = CreateEvent(NULL, TRUE, FALSE, NULL);
+	w->hStarted = CreateEvent(NULL, FALSE, FALSE, NULL);
+	if (w->hStop == NULL || w->hReady == NULL || w->hStarted == NULL){
+		PyWin_SetAPIError("CreateEvent");
+		Py_DECREF(w);
+		return NULL;
+		}
+
+	const char *fname = NULL;
+	DWORD err = 0;
+	Py_BEGIN_ALLOW_THREADS
+	w->hSCM = OpenSCManagerW(machine, NULL, SC_MANAGER_CONNECT);
+	if (w->hSCM == NULL){
+		fname = "OpenSCManager";
+		err = GetLastError();
+		}
+	for (DWORD i=0; fname == NULL && i<n; i++){
+		w->slots[i].hService = OpenServiceW(w->hSCM, w->slots[i].name, SERVICE_QUERY_STATUS);
+		if (w->slots[i].hService == NULL){
+			fname = "OpenService";
+			err = GetLastError();
+			}
+		}
+	if (fname == NULL){
+		w->hThread = CreateThread(NULL, 0, ssw_thread, w, 0, NULL);
+		if (w->hThread == NULL){
+			fname = "CreateThread";
+			err = GetLastError();
+			}
+		else{
+			WaitForSingleObject(w->hStarted, INFINITE);
+			if (w->startError){
+				fname = "NotifyServiceStatusChange";
+				err = w->startError;
+				}
+			}
+		}
+	Py_END_ALLOW_THREADS
+	if (fname){
+		PyWin_SetAPIError((char *)fname, err);
+		Py_DECREF(w);
+		return NULL;
+		}
+	return (PyObject *)w;
+}
+%}
+
+// @pyswig <o PyServiceStatusWatcher>|CreateServiceStatusWatcher|Starts watching a set of services for status changes.
+// @comm Replaces polling <om win32service.QueryServiceStatusEx> for each service.  Requires Vista or later.
+// @pyseeapi NotifyServiceStatusChange
+%native (CreateServiceStatusWatcher) MyCreateServiceStatusWatcher;
+
 // @pyswig |SetServiceObjectSecurity|Set the security descriptor for a service
 %native (SetServiceObjectSecurity) MySetServiceObjectSecurity;
 %{
@@ -1955,6 +2644,16 @@ PyObject *PyQueryServiceConfig2(PyObject *self, PyObject *args)
 // Info level for EnumServicesStatusEx
 #define SC_ENUM_PROCESS_INFO SC_ENUM_PROCESS_INFO
 
+// Transitions reported by NotifyServiceStatusChange, used with CreateServiceStatusWatcher
+#define SERVICE_NOTIFY_STOPPED SERVICE_NOTIFY_STOPPED
+#define SERVICE_NOTIFY_START_PENDING SERVICE_NOTIFY_START_PENDING
+#define SERVICE_NOTIFY_STOP_PENDING SERVICE_NOTIFY_STOP_PENDING
+#define SERVICE_NOTIFY_RUNNING SERVICE_NOTIFY_RUNNING
+#define SERVICE_NOTIFY_CONTINUE_PENDING SERVICE_NOTIFY_CONTINUE_PENDING
+#define SERVICE_NOTIFY_PAUSE_PENDING SERVICE_NOTIFY_PAUSE_PENDING
+#define SERVICE_NOTIFY_PAUSED SERVICE_NOTIFY_PAUSED
+#define SERVICE_NOTIFY_DELETE_PENDING SERVICE_NOTIFY_DELETE_PENDING
+
 // Used with SERVICE_CONFIG_SERVICE_SID_INFO
 #define SERVICE_SID_TYPE_NONE SERVICE_SID_TYPE_NONE 
 #define SERVICE_SID_TYPE_RESTRICTED SERVICE_SID_TYPE_RESTRICTED
@@ -9,35 +9,150 @@ It is assumed there may be many current clients sending output to the
 tracer, but only one process reading it.  [Violating this will not cause a
 crash, just cause only one of the processes to see a given piece of text.]
 
-The implementation is very simple, because of the above assumptions.
-
-* There is a mem-mapped file, with the first word being an integer, and the
-rest being string data.  The integer is the current length of the string.
-* A write operation appends data to the buffer, and updates the length.
-* A read operation reads the entire buffer, and resets the length to zero.
-  (Thus, there is no way to read only chunks of the data)
-* A single mutex protects the entire structure.  While the mutex is held, there
-  can at worst be a strcpy, malloc, and integer change, so this should be reasonable.
-
-Currently, the memmapped file is allocated in the system swap space, and only 64k of
-data is allocated.  If this buffer fills before a server gets to read it, the _entire_
-output is discarded, and the text written to the new, empty buffer.
-
-However, the most we will write at a time is "buffer_size/2" bytes, then we
-will have a short, optimized sleep between chunks.
-
-See - I told you the implementation was simple :-)
+The implementation:
+
+* There is a mem-mapped file, holding a TraceRingHeader followed by a ring of
+  variable length records.  The header has two 64 bit counters - 'head', the
+  total bytes ever reserved by writers, and 'tail', the total bytes ever
+  consumed by the reader.  The ring size is a power of 2, so a position in the
+  ring is just the counter masked.
+* A writer reserves space for its record by advancing 'head' with a compare
+  and exchange, fills the record in, then publishes it by storing the record's
+  position + 1 in its 'seq' field.  A record which would cross the end of the
+  ring is preceded by a padding record, so records are always contiguous.
+* The reader walks from 'tail', stopping at the first record not yet
+  published, and then advances 'tail'.  No mutex is involved on either side.
+* If a record doesn't fit, it is discarded and the shared 'dropped' counter is
+  incremented - writers never wait for the reader.
+
+Each record carries the process and thread ID of the writer and a timestamp,
+although read() and blockingread() just return the concatenated text.
+
+The layout is not compatible with the original 'length + text' mapping, so it
+uses differently named objects.
 
 */
 
 #include "PyWinTypes.h"
 #include "PyWinObjects.h"
 
-const unsigned long BUFFER_SIZE = 0x20000;  // Includes size integer.
-const TCHAR *MAP_OBJECT_NAME = _T("Global\\PythonTraceOutputMapping");
-const TCHAR *MUTEX_OBJECT_NAME = _T("Global\\PythonTraceOutputMutex");
+const unsigned long DEFAULT_BUFFER_SIZE = 0x100000;  // The record area, excluding the header.
+const unsigned long MIN_BUFFER_SIZE = 0x10000;
+const unsigned long MAX_BUFFER_SIZE = 0x10000000;
+const TCHAR *MAP_OBJECT_NAME = _T("Global\\PythonTraceOutputRing");
 const TCHAR *EVENT_OBJECT_NAME = _T("Global\\PythonTraceOutputEvent");
-const TCHAR *EVENT_EMPTY_OBJECT_NAME = _T("Global\\PythonTraceOutputEmptyEvent");
+
+#define TRACE_RING_MAGIC 0x52545950  // 'PYTR'
+#define TRACE_RING_VERSION 1
+
+// Shared between processes, so must use types with identical sizes on win32 and win64.
+struct TraceRingHeader {
+    volatile LONG magic;  // set by the creator once the rest is initialized.
+    DWORD version;
+    DWORD dataSize;    // size of the record area - a power of 2.
+    DWORD headerSize;  // offset of the record area from the start of the mapping.
+    volatile LONG64 head;  // total bytes reserved by writers.
+    volatile LONG64 tail;  // total bytes consumed by the reader.
+    volatile LONG64 dropped;  // records discarded because the ring was full.
+    volatile LONG64 written;  // records published.
+    BYTE reserved[16];
+};
+
+#define TRACE_RECORD_PADDING 0x80000000  // flag for filler at the end of the ring.
+
+struct TraceRecord {
+    volatile LONG64 seq;  // the record's position + 1, once published.
+    DWORD size;           // including this header, a multiple of 8.
+    DWORD flags;
+    DWORD pid;
+    DWORD tid;
+    LONG64 timestamp;  // a FILETIME, in UTC.
+    DWORD length;      // of the data following this header.
+    DWORD reserved;
+};
+
+// A padding record may start up to 8 bytes before the end of the ring, so
+// the mapping has room for a record header after the record area.
+static DWORD TraceMapSize(DWORD dataSize) { return sizeof(TraceRingHeader) + dataSize + sizeof(TraceRecord); }
+
+static BYTE *TraceRingData(TraceRingHeader *ring) { return ((BYTE *)ring) + ring->headerSize; }
+
+// 64 bit reads aren't atomic on win32.
+static LONG64 TraceLoad(volatile LONG64 *p) { return InterlockedCompareExchange64(p, 0, 0); }
+
+// Publishes one record, or counts it as dropped if the ring is full.
+static BOOL TraceRingWrite(TraceRingHeader *ring, const char *data, DWORD len, DWORD flags)
+{
+    LONG64 mask = ring->dataSize - 1;
+    DWORD recSize = (sizeof(TraceRecord) + len + 7) & ~7;
+    LONG64 head, pad;
+    for (;;) {
+        head = TraceLoad(&ring->head);
+        LONG64 tail = TraceLoad(&ring->tail);
+        LONG64 offset = head & mask;
+        pad = (offset + recSize > ring->dataSize) ? ring->dataSize - offset : 0;
+        if (head + pad + recSize - tail > ring->dataSize) {
+            InterlockedIncrement64(&ring->dropped);
+            return FALSE;
+        }
+        if (InterlockedCompareExchange64(&ring->head, head + pad + recSize, head) == head)
+            break;
+    }
+    BYTE *base = TraceRingData(ring);
+    if (pad) {
+        TraceRecord *filler = (TraceRecord *)(base + (head & mask));
+        filler->size = (DWORD)pad;
+        filler->flags = TRACE_RECORD_PADDING;
+        filler->length = 0;
+        InterlockedExchange64(&filler->seq, head + 1);
+        head += pad;
+    }
+    TraceRecord *rec = (TraceRecord *)(base + (head & mask));
+    rec->size = recSize;
+    rec->flags = flags;
+    rec->pid = GetCurrentProcessId();
+    rec->tid = GetCurrentThreadId();
+    GetSystemTimeAsFileTime((FILETIME *)&rec->timestamp);
+    rec->length = len;
+    rec->reserved = 0;
+    memcpy(rec + 1, data, len);
+    InterlockedIncrement64(&ring->written);
+    InterlockedExchange64(&rec->seq, head + 1);
+    return TRUE;
+}
+
+// Called for each published record by TraceRingDrain - return FALSE to stop
+// without consuming the record.
+typedef BOOL (*TraceRecordFunc)(void *context, TraceRecord *rec);
+
+// Passes each published record to fn, in order, and consumes it.  Returns the
+// number of records consumed.
+static LONG64 TraceRingDrain(TraceRingHeader *ring, TraceRecordFunc fn, void *context)
+{
+    LONG64 mask = ring->dataSize - 1;
+    BYTE *base = TraceRingData(ring);
+    LONG64 count = 0;
+    for (;;) {
+        LONG64 tail = TraceLoad(&ring->tail);
+        if (tail == TraceLoad(&ring->head))
+            break;
+        TraceRecord *rec = (TraceRecord *)(base + (tail & mask));
+        if (TraceLoad(&rec->seq) != tail + 1)
+            break;  // reserved, but not yet published.
+        DWORD size = rec->size;
+        DWORD minSize = (rec->flags & TRACE_RECORD_PADDING) ? 8 : sizeof(TraceRecord);
+        if (size < minSize || size > ring->dataSize || (size & 7)) {
+            // Corrupt - most likely a writer died mid-record.  Discard everything pending.
+            InterlockedCompareExchange64(&ring->tail, TraceLoad(&ring->head), tail);
+            break;
+        }
+        if (!(rec->flags & TRACE_RECORD_PADDING) && !fn(context, rec))
+            break;
+        if (InterlockedCompareExchange64(&ring->tail, tail + size, tail) == tail)
+            count++;
+    }
+    return count;
+}
 
 // Global\\ etc goodness:
 // On NT4/9x, 'Global\\' is not understood and will fail.
@@ -77,12 +192,8 @@ static const TCHAR *FixupObjectName(const TCHAR *global_name)
 // in the sys module that we store our PyTraceObject pointer
 char *TRACEOBJECT_NAME = "__win32traceObject__";
 
-HANDLE hMutex = NULL;
 // An auto-reset event so a reader knows when data is avail without polling.
 HANDLE hEvent = NULL;
-// An auto-reset event so writing large data can know when the buffer has
-// been read.
-HANDLE hEventEmpty = NULL;
 
 SECURITY_ATTRIBUTES sa;           // Security attributes.
 PSECURITY_DESCRIPTOR pSD = NULL;  // Pointer to SD.
@@ -94,6 +205,7 @@ class PyTraceObject : public PyObject {
     HANDLE hMapFileWrite;  // The handle to the write side of the mem-mapped file
     void *pMapBaseRead;
     void *pMapBaseWrite;
+    DWORD bufferSize;  // the size to create the mapping with, if it doesn't exist.
 
    public:
     void Initialize();
@@ -103,6 +215,8 @@ class PyTraceObject : public PyObject {
     BOOL CloseWriteMap();
     BOOL WriteData(const char *data, unsigned len);
     BOOL ReadData(char **ppResult, int *retSize, int waitMilliseconds);
+    TraceRingHeader *GetRing() { return (TraceRingHeader *)(pMapBaseWrite ? pMapBaseWrite : pMapBaseRead); }
+    void SetBufferSize(DWORD size) { bufferSize = size; }
     int fSoftSpace;
 };  // PyTraceObject
 
@@ -232,26 +346,72 @@ static PyObject *ReturnError(char *msg, char *fnName = NULL)
     return NULL;
 }
 
-BOOL DoOpenMap(HANDLE *pHandle, VOID **ppPtr)
+// Opens the ring, creating it with a record area of bufferSize bytes if it
+// doesn't exist.  An existing ring is used at whatever size it was created with.
+BOOL DoOpenMap(HANDLE *pHandle, VOID **ppPtr, DWORD bufferSize, const TCHAR *mapName)
 {
     if (*pHandle || *ppPtr) {
         ReturnError("DoOpenMap, already open");
         return FALSE;
     }
+    DWORD dataSize = MIN_BUFFER_SIZE;
+    while (dataSize < bufferSize && dataSize < MAX_BUFFER_SIZE) dataSize *= 2;
+    BOOL bExisted;
     Py_BEGIN_ALLOW_THREADS *pHandle =
-        CreateFileMapping((HANDLE)-1, &sa, PAGE_READWRITE, 0, BUFFER_SIZE, FixupObjectName(MAP_OBJECT_NAME));
+        CreateFileMapping((HANDLE)-1, &sa, PAGE_READWRITE, 0, TraceMapSize(dataSize), mapName);
+    bExisted = GetLastError() == ERROR_ALREADY_EXISTS;
     Py_END_ALLOW_THREADS if (*pHandle == NULL)
     {
         PyWin_SetAPIError("CreateFileMapping");
         return FALSE;
     }
-    Py_BEGIN_ALLOW_THREADS *ppPtr = MapViewOfFile(*pHandle, FILE_MAP_ALL_ACCESS, 0, 0, BUFFER_SIZE);
-    Py_END_ALLOW_THREADS if (*ppPtr == NULL)
+    const char *failed = NULL;
+    DWORD err = 0;
+    Py_BEGIN_ALLOW_THREADS if (bExisted)
+    {
+        // Find out how big it is - waiting for the creator, as it may still be
+        // initializing the header.
+        TraceRingHeader *ring = (TraceRingHeader *)MapViewOfFile(*pHandle, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(TraceRingHeader));
+        if (ring == NULL) {
+            failed = "MapViewOfFile";
+            err = GetLastError();
+        }
+        else {
+            for (int i = 0; i < 1000 && ring->magic != TRACE_RING_MAGIC; i++) Sleep(1);
+            if (ring->magic != TRACE_RING_MAGIC || ring->version != TRACE_RING_VERSION) {
+                failed = "The trace buffer has an unknown layout";
+                err = ERROR_INVALID_DATA;
+            }
+            else
+                dataSize = ring->dataSize;
+            UnmapViewOfFile(ring);
+        }
+    }
+    if (!failed) {
+        *ppPtr = MapViewOfFile(*pHandle, FILE_MAP_ALL_ACCESS, 0, 0, TraceMapSize(dataSize));
+        if (*ppPtr == NULL) {
+            failed = "MapViewOfFile";
+            err = GetLastError();
+        }
+        else if (!bExisted) {
+            // Pagefile backed, so already zeroed.
+            TraceRingHeader *ring = (TraceRingHeader *)*ppPtr;
+            ring->version = TRACE_RING_VERSION;
+            ring->dataSize = dataSize;
+            ring->headerSize = sizeof(TraceRingHeader);
+            InterlockedExchange(&ring->magic, TRACE_RING_MAGIC);
+        }
+    }
+    Py_END_ALLOW_THREADS if (failed)
     {
         // not allowed to access the interpreter inside
         // Py_BEGIN_ALLOW_THREADS block
-        PyWin_SetAPIError("MapViewOfFile");
+        if (err == ERROR_INVALID_DATA)
+            ReturnError((char *)failed, (char *)"DoOpenMap");
+        else
+            PyWin_SetAPIError((char *)failed, err);
         CloseHandle(*pHandle);
+        *pHandle = NULL;
         return FALSE;
     }
     return TRUE;
@@ -276,33 +436,13 @@ BOOL DoCloseMap(HANDLE *pHandle, VOID **ppPtr)
     return TRUE;
 }
 
-BOOL GetMyMutex()
-{
-    // Give the mutex 10 seconds before timing out
-    if (WaitForSingleObject(hMutex, 10 * 1000) == WAIT_FAILED) {
-        // Danger this is currently called without holding the GIL
-        PyWin_SetAPIError("WaitForSingleObject", GetLastError());
-        return FALSE;
-    }
-    return TRUE;
-}
-
-BOOL ReleaseMyMutex()
-{
-    if (!ReleaseMutex(hMutex)) {
-        // Danger this is currently called without holding the GIL
-        PyWin_SetAPIError("ReleaseMutex", GetLastError());
-        return FALSE;
-    }
-    return TRUE;
-}
-
 void PyTraceObject::Initialize()
 {
     hMapFileRead = NULL;
     hMapFileWrite = NULL;
     pMapBaseRead = NULL;
     pMapBaseWrite = NULL;
+    bufferSize = DEFAULT_BUFFER_SIZE;
     fSoftSpace = 0;
 }
 
@@ -312,39 +452,42 @@ BOOL PyTraceObject::WriteData(const char *data, unsigned len)
         ReturnError("The module has not been setup for writing");
         return FALSE;
     }
-    BOOL rc = TRUE;
-    Py_BEGIN_ALLOW_THREADS const char *data_this = data;
+    Py_BEGIN_ALLOW_THREADS TraceRingHeader *ring = (TraceRingHeader *)pMapBaseWrite;
+    // Big writes are split, so one can't take the whole ring.
+    unsigned maxRecord = ring->dataSize / 4 - sizeof(TraceRecord);
+    const char *data_this = data;
     while (len) {
-        unsigned len_this = min(len, BUFFER_SIZE / 2);
-        BOOL ok = GetMyMutex();
-        if (ok) {
-            // must use types with identical size on win32 and win64
-            unsigned long *pLen = (unsigned long *)pMapBaseWrite;
-            unsigned long sizeLeft = (BUFFER_SIZE - sizeof(unsigned long)) - *pLen;
-            // If less than double we need left, wait for it to empty, or .1 sec.
-            if (sizeLeft < len_this * 2) {
-                ReleaseMyMutex();
-                SetEvent(hEvent);
-                WaitForSingleObject(hEventEmpty, 100);
-                ok = GetMyMutex();
-            }
-        }
-        if (ok) {
-            unsigned long *pLen = (unsigned long *)pMapBaseWrite;
-            char *buffer = (char *)(((unsigned long *)pMapBaseWrite) + 1);
-
-            unsigned long sizeLeft = (BUFFER_SIZE - sizeof(unsigned long)) - *pLen;
-            if (sizeLeft < len_this)
-                *pLen = 0;
-            memcpy(buffer + (*pLen), data_this, len_this);
-            *pLen += len_this;
-            rc = ReleaseMyMutex();
-            SetEvent(hEvent);
-            data_this += len_this;
-            len -= len_this;
-        }
+        unsigned len_this = min(len, maxRecord);
+        TraceRingWrite(ring, data_this, len_this, 0);
+        data_this += len_this;
+        len -= len_this;
+    }
+    SetEvent(hEvent);
+    Py_END_ALLOW_THREADS return TRUE;
+}
+
+// Accumulates the text of the records for ReadData.
+struct TraceReadBuffer {
+    char *data;
+    unsigned long len;
+    unsigned long size;
+};
+
+static BOOL TraceReadAppend(void *context, TraceRecord *rec)
+{
+    TraceReadBuffer *buf = (TraceReadBuffer *)context;
+    if (buf->len + rec->length + 1 > buf->size) {
+        unsigned long size = buf->size * 2;
+        while (buf->len + rec->length + 1 > size) size *= 2;
+        char *data = (char *)realloc(buf->data, size);
+        if (data == NULL)
+            return FALSE;
+        buf->data = data;
+        buf->size = size;
     }
-    Py_END_ALLOW_THREADS return rc;
+    memcpy(buf->data + buf->len, rec + 1, rec->length);
+    buf->len += rec->length;
+    return TRUE;
 }
 
 BOOL PyTraceObject::ReadData(char **ppResult, int *retSize, int waitMilliseconds)
@@ -353,7 +496,8 @@ BOOL PyTraceObject::ReadData(char **ppResult, int *retSize, int waitMilliseconds
         ReturnError("The module has not been setup for reading");
         return FALSE;
     }
-    if (waitMilliseconds != 0) {
+    TraceRingHeader *ring = (TraceRingHeader *)pMapBaseRead;
+    if (waitMilliseconds != 0 && TraceLoad(&ring->head) == TraceLoad(&ring->tail)) {
         DWORD rc;
         Py_BEGIN_ALLOW_THREADS rc = WaitForSingleObject(hEvent, waitMilliseconds);
         Py_END_ALLOW_THREADS if (rc == WAIT_FAILED)
@@ -362,40 +506,31 @@ BOOL PyTraceObject::ReadData(char **ppResult, int *retSize, int waitMilliseconds
             return FALSE;
         }
     }
-    BOOL rc = FALSE;
-    char *result = NULL;
-    Py_BEGIN_ALLOW_THREADS if (GetMyMutex())
-    {
-        // must use sizes that are identical on win32 and win64
-        unsigned long *pLen = (unsigned long *)pMapBaseRead;
-        char *buffer = (char *)(((unsigned long *)pMapBaseRead) + 1);
-
-        result = (char *)malloc(*pLen + 1);
-        if (result) {
-            memcpy(result, buffer, *pLen);
-            result[*pLen] = '\0';
-            *retSize = *pLen;
-            *pLen = 0;
-        }
-        rc = ReleaseMyMutex();
-        SetEvent(hEventEmpty);  // in case anyone wants to optimize waiting.
-    }
-    Py_END_ALLOW_THREADS if (!rc && result) { free(result); }
-    if (rc && result == NULL) {
+    TraceReadBuffer buf;
+    buf.len = 0;
+    buf.size = 4096;
+    buf.data = (char *)malloc(buf.size);
+    if (buf.data == NULL) {
         PyErr_SetString(PyExc_MemoryError, "Allocating buffer for trace data");
-        rc = FALSE;
+        return FALSE;
     }
-    if (rc)
-        *ppResult = result;
-    return rc;
+    Py_BEGIN_ALLOW_THREADS TraceRingDrain(ring, TraceReadAppend, &buf);
+    Py_END_ALLOW_THREADS
+    // A failed realloc just leaves the rest for next time.
+    buf.data[buf.len] = '\0';
+    *ppResult = buf.data;
+    *retSize = buf.len;
+    return TRUE;
 }
 
-BOOL PyTraceObject::OpenReadMap() { return DoOpenMap(&hMapFileRead, &pMapBaseRead); }
+BOOL PyTraceObject::OpenReadMap()
+{
+    return DoOpenMap(&hMapFileRead, &pMapBaseRead, bufferSize, FixupObjectName(MAP_OBJECT_NAME));
+}
 
 BOOL PyTraceObject::OpenWriteMap()
 {
-    return DoOpenMap(&hMapFileWrite, &pMapBaseWrite);
-    ;
+    return DoOpenMap(&hMapFileWrite, &pMapBaseWrite, bufferSize, FixupObjectName(MAP_OBJECT_NAME));
 }
 
 BOOL PyTraceObject::CloseReadMap() { return DoCloseMap(&hMapFileRead, &pMapBaseRead); }
@@ -414,10 +549,17 @@ static PyObject *win32trace_GetTracer(PyObject *, PyObject *)
     return traceObject;
 }
 
+// @pymethod |win32trace|InitRead|Opens the trace buffer for reading.
 static PyObject *win32trace_InitRead(PyObject *self, PyObject *args)
 {
     BOOL ok;
+    DWORD bufferSize = DEFAULT_BUFFER_SIZE;
+    // @pyparm int|bufferSize|0x100000|The size of the buffer to create, if no other process has created
+    // it.  It is rounded up to a power of 2.
+    if (!PyArg_ParseTuple(args, "|k:InitRead", &bufferSize))
+        return NULL;
     PyObject *traceObject = win32trace_GetTracer(NULL, NULL);
+    static_cast<PyTraceObject *>(traceObject)->SetBufferSize(bufferSize);
     ok = static_cast<PyTraceObject *>(traceObject)->OpenReadMap();
     Py_DECREF(traceObject);
     if (!ok)
@@ -426,10 +568,17 @@ static PyObject *win32trace_InitRead(PyObject *self, PyObject *args)
     return Py_None;
 }
 
+// @pymethod |win32trace|InitWrite|Opens the trace buffer for writing.
 static PyObject *win32trace_InitWrite(PyObject *self, PyObject *args)
 {
     BOOL ok;
+    DWORD bufferSize = DEFAULT_BUFFER_SIZE;
+    // @pyparm int|bufferSize|0x100000|The size of the buffer to create, if no other process has created
+    // it.  It is rounded up to a power of 2.
+    if (!PyArg_ParseTuple(args, "|k:InitWrite", &bufferSize))
+        return NULL;
     PyObject *traceObject = win32trace_GetTracer(NULL, NULL);
+    static_cast<PyTraceObject *>(traceObject)->SetBufferSize(bufferSize);
     ok = static_cast<PyTraceObject *>(traceObject)->OpenWriteMap();
     Py_DECREF(traceObject);
     if (!ok)
@@ -545,11 +694,380 @@ static PyObject *win32trace_GetHandle(PyObject *self, PyObject *args)
     return Py_BuildValue("i", hEvent);
 }
 
+static PyObject *TraceRingStatistics(TraceRingHeader *ring)
+{
+    return Py_BuildValue("{s:k, s:L, s:L, s:L}", "BufferSize", ring->dataSize, "Pending",
+                         TraceLoad(&ring->head) - TraceLoad(&ring->tail), "Written", TraceLoad(&ring->written),
+                         "Dropped", TraceLoad(&ring->dropped));
+}
+
+// @pymethod dict|win32trace|GetStatistics|Returns the counters kept in the shared trace buffer.
+// @comm The buffer must have been opened with <om win32trace.InitRead> or <om win32trace.InitWrite>.
+static PyObject *win32trace_GetStatistics(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":GetStatistics"))
+        return NULL;
+    PyObject *traceObject = PySys_GetObject(TRACEOBJECT_NAME);
+    TraceRingHeader *ring = traceObject ? static_cast<PyTraceObject *>(traceObject)->GetRing() : NULL;
+    if (ring == NULL)
+        return ReturnError("The module has not been setup for reading or writing");
+    // @rdesc The result is a dictionary with keys:
+    // @flagh Key|Value
+    // @flag BufferSize|The size of the record area.
+    // @flag Pending|The number of bytes written but not yet read.
+    // @flag Written|The number of records written by all processes.
+    // @flag Dropped|The number of records discarded because the buffer was full.
+    return TraceRingStatistics(ring);
+}
+
+// Channels - each is a separately named ring and event, read as batches of records.
+const TCHAR *CHANNEL_MAP_PREFIX = _T("Global\\PythonTraceChannel-");
+const TCHAR *CHANNEL_EVENT_PREFIX = _T("Global\\PythonTraceChannelEvent-");
+#define TRACE_LEVEL_MASK 0xFFFF
+
+// @object PyTraceChannel|A named trace channel, as returned by <om win32trace.OpenChannel>.
+// @comm Each channel has its own shared buffer and event, so busy writers on
+// one channel can't cause records on another to be dropped.  Records are
+// read as (pid, tid, timestamp, level, text) tuples - timestamp is a FILETIME,
+// in UTC, as an integer.
+struct PyTraceChannel {
+    PyObject_HEAD HANDLE hMap;
+    TraceRingHeader *ring;
+    HANDLE hEvent;
+    PyObject *obName;
+};
+
+extern PyTypeObject PyTraceChannelType;
+
+static void PyTraceChannel_close(PyTraceChannel *channel)
+{
+    DoCloseMap(&channel->hMap, (VOID **)&channel->ring);
+    if (channel->hEvent) {
+        CloseHandle(channel->hEvent);
+        channel->hEvent = NULL;
+    }
+}
+
+static void PyTraceChannel_dealloc(PyObject *self)
+{
+    PyTraceChannel *channel = (PyTraceChannel *)self;
+    PyTraceChannel_close(channel);
+    Py_XDECREF(channel->obName);
+    PyObject_Del(self);
+}
+
+static BOOL PyTraceChannel_check(PyTraceChannel *channel)
+{
+    if (channel->ring == NULL) {
+        ReturnError("The channel has been closed");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// @pymethod |PyTraceChannel|write|Writes a record to the channel.
+static PyObject *PyTraceChannel_write(PyObject *self, PyObject *args)
+{
+    PyTraceChannel *channel = (PyTraceChannel *)self;
+    int len;
+    char *data = NULL;
+    unsigned int level = 0;
+    // @pyparm string|data||The text of the record - split into several records if
+    // it is over a quarter of the buffer size.
+    // @pyparm int|level|0|A level for the reader to filter on, from 0 to 65535.
+    if (!PyArg_ParseTuple(args, "et#|I:write", "latin-1", &data, &len, &level))
+        return NULL;
+    if (!PyTraceChannel_check(channel) || level > TRACE_LEVEL_MASK) {
+        if (!PyErr_Occurred())
+            PyErr_SetString(PyExc_ValueError, "level must be between 0 and 65535");
+        PyMem_Free(data);
+        return NULL;
+    }
+    BOOL ok = TRUE;
+    Py_BEGIN_ALLOW_THREADS TraceRingHeader *ring = channel->ring;
+    unsigned maxRecord = ring->dataSize / 4 - sizeof(TraceRecord);
+    const char *data_this = data;
+    while (len) {
+        unsigned len_this = min((unsigned)len, maxRecord);
+        ok = TraceRingWrite(ring, data_this, len_this, level) && ok;
+        data_this += len_this;
+        len -= len_this;
+    }
+    SetEvent(channel->hEvent);
+    Py_END_ALLOW_THREADS PyMem_Free(data);
+    // @rdesc True if the record was written, or False if the buffer was full and it was dropped.
+    return PyBool_FromLong(ok);
+}
+
+struct TraceRecordList {
+    PyObject *list;
+    Py_ssize_t maxRecords;  // 0 for no limit
+    BOOL bFailed;
+};
+
+static BOOL TraceRecordAppend(void *context, TraceRecord *rec)
+{
+    TraceRecordList *records = (TraceRecordList *)context;
+    if (records->maxRecords && PyList_GET_SIZE(records->list) >= records->maxRecords)
+        return FALSE;
+#if (PY_VERSION_HEX < 0x03000000)
+    PyObject *text = PyString_FromStringAndSize((char *)(rec + 1), rec->length);
+#else
+    PyObject *text = PyUnicode_DecodeLatin1((char *)(rec + 1), rec->length, "replace");
+#endif
+    PyObject *item = text ? Py_BuildValue("kkLkN", rec->pid, rec->tid, rec->timestamp,
+                                          rec->flags & TRACE_LEVEL_MASK, text)
+                          : NULL;
+    if (item == NULL || PyList_Append(records->list, item) == -1) {
+        Py_XDECREF(item);
+        records->bFailed = TRUE;
+        return FALSE;
+    }
+    Py_DECREF(item);
+    return TRUE;
+}
+
+// Returns a list of the pending records - called with the GIL held.
+static PyObject *PyTraceChannel_drain(PyTraceChannel *channel, Py_ssize_t maxRecords)
+{
+    TraceRecordList records;
+    records.list = PyList_New(0);
+    records.maxRecords = maxRecords;
+    records.bFailed = FALSE;
+    if (records.list == NULL)
+        return NULL;
+    TraceRingDrain(channel->ring, TraceRecordAppend, &records);
+    if (records.bFailed) {
+        // The record which failed has not been consumed.
+        Py_DECREF(records.list);
+        return NULL;
+    }
+    return records.list;
+}
+
+// @pymethod [(pid, tid, timestamp, level, text), ...]|PyTraceChannel|read|Reads the pending records from the channel.
+static PyObject *PyTraceChannel_read(PyObject *self, PyObject *args)
+{
+    PyTraceChannel *channel = (PyTraceChannel *)self;
+    Py_ssize_t maxRecords = 0;
+    // @pyparm int|maxRecords|0|The maximum number of records to return, or 0 for all of them.
+    if (!PyArg_ParseTuple(args, "|n:read", &maxRecords))
+        return NULL;
+    if (!PyTraceChannel_check(channel))
+        return NULL;
+    return PyTraceChannel_drain(channel, maxRecords);
+}
+
+// @pymethod dict|PyTraceChannel|GetStatistics|Returns the counters kept in the channel's buffer.
+// @comm The result is as for <om win32trace.GetStatistics>.
+static PyObject *PyTraceChannel_GetStatistics(PyObject *self, PyObject *args)
+{
+    PyTraceChannel *channel = (PyTraceChannel *)self;
+    if (!PyArg_ParseTuple(args, ":GetStatistics"))
+        return NULL;
+    if (!PyTraceChannel_check(channel))
+        return NULL;
+    return TraceRingStatistics(channel->ring);
+}
+
+// @pymethod |PyTraceChannel|Close|Closes the channel.
+static PyObject *PyTraceChannel_Close(PyObject *self, PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ":Close"))
+        return NULL;
+    PyTraceChannel_close((PyTraceChannel *)self);
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
+static PyObject *PyTraceChannel_get_handle(PyObject *self, void *)
+{
+    // Like GetHandle, the handle remains owned by the channel.
+    return PyWinLong_FromHANDLE(((PyTraceChannel *)self)->hEvent);
+}
+
+static PyObject *PyTraceChannel_get_name(PyObject *self, void *)
+{
+    PyObject *ret = ((PyTraceChannel *)self)->obName;
+    Py_INCREF(ret);
+    return ret;
+}
+
+static PyMethodDef PyTraceChannel_methods[] = {
+    {"write", PyTraceChannel_write, METH_VARARGS},                  // @pymeth write|Writes a record.
+    {"read", PyTraceChannel_read, METH_VARARGS},                    // @pymeth read|Reads the pending records.
+    {"GetStatistics", PyTraceChannel_GetStatistics, METH_VARARGS},  // @pymeth GetStatistics|Returns the counters.
+    {"Close", PyTraceChannel_Close, METH_VARARGS},                  // @pymeth Close|Closes the channel.
+    {0, 0},
+};
+
+static PyGetSetDef PyTraceChannel_getset[] = {
+    // @prop int|handle|An event which is signalled when records are written, for use with
+    // win32event.WaitForMultipleObjects.
+    {"handle", PyTraceChannel_get_handle, NULL},
+    // @prop string|name|The name of the channel.
+    {"name", PyTraceChannel_get_name, NULL},
+    {NULL}};
+
+PyTypeObject PyTraceChannelType = {
+    PYWIN_OBJECT_HEAD "PyTraceChannel", sizeof(PyTraceChannel), 0,
+    // standard methods
+    PyTraceChannel_dealloc, (printfunc)0,
+    0,  // getattr
+    0,  // setattr
+    0,  // cmp
+    0,  // repr
+    // type categories
+    0, 0, 0,
+    // more methods
+    (hashfunc)0, 0, 0, PyObject_GenericGetAttr, 0, 0, Py_TPFLAGS_DEFAULT,
+    0,  // doc
+    0,  // tp_traverse
+    0,  // tp_clear
+    0,  // tp_richcompare
+    0,
+    0,  // tp_iter
+    0,  // iternext
+    PyTraceChannel_methods,
+    0,                      // tp_members
+    PyTraceChannel_getset,  // tp_getsetlist
+};
+
+// Builds prefix + name, in the namespace chosen at module init.
+static TCHAR *MakeChannelObjectName(const TCHAR *prefix, const TCHAR *name)
+{
+    TCHAR *ret = (TCHAR *)malloc((_tcslen(prefix) + _tcslen(name) + 1) * sizeof(TCHAR));
+    if (ret == NULL)
+        return NULL;
+    _tcscpy(ret, prefix);
+    _tcscat(ret, name);
+    return ret;
+}
+
+// @pymethod <o PyTraceChannel>|win32trace|OpenChannel|Opens a named trace channel, creating it if necessary.
+// @comm Writers and readers open a channel the same way.  For a channel per
+// process, a writer can use a name based on its process ID.
+static PyObject *win32trace_OpenChannel(PyObject *self, PyObject *args)
+{
+    PyObject *obName;
+    DWORD bufferSize = DEFAULT_BUFFER_SIZE;
+    // @pyparm string|name||The name of the channel.  It may not contain a backslash.
+    // @pyparm int|bufferSize|0x100000|The size of the buffer to create, if the channel doesn't exist.
+    if (!PyArg_ParseTuple(args, "O|k:OpenChannel", &obName, &bufferSize))
+        return NULL;
+    TCHAR *name;
+    if (!PyWinObject_AsTCHAR(obName, &name, FALSE))
+        return NULL;
+    if (name[0] == 0 || _tcschr(name, '\\')) {
+        PyWinObject_FreeTCHAR(name);
+        PyErr_SetString(PyExc_ValueError, "The channel name must be non-empty, without a backslash");
+        return NULL;
+    }
+    TCHAR *mapName = MakeChannelObjectName(CHANNEL_MAP_PREFIX, name);
+    TCHAR *eventName = MakeChannelObjectName(CHANNEL_EVENT_PREFIX, name);
+    PyWinObject_FreeTCHAR(name);
+    PyTraceChannel *channel = NULL;
+    if (mapName == NULL || eventName == NULL) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    channel = PyObject_New(PyTraceChannel, &PyTraceChannelType);
+    if (channel == NULL)
+        goto done;
+    channel->hMap = NULL;
+    channel->ring = NULL;
+    channel->obName = obName;
+    Py_INCREF(obName);
+    channel->hEvent = CreateEvent(&sa, FALSE, FALSE, FixupObjectName(eventName));
+    if (channel->hEvent == NULL) {
+        PyWin_SetAPIError("CreateEvent");
+        Py_DECREF(channel);
+        channel = NULL;
+        goto done;
+    }
+    if (!DoOpenMap(&channel->hMap, (VOID **)&channel->ring, bufferSize, FixupObjectName(mapName))) {
+        Py_DECREF(channel);
+        channel = NULL;
+    }
+done:
+    free(mapName);
+    free(eventName);
+    return channel;
+}
+
+// @pymethod [(<o PyTraceChannel>, [(pid, tid, timestamp, level, text), ...]), ...]|win32trace|ReadChannels|Waits for
+// records on any of several channels, and reads them.
+// @rdesc The result has an entry for each channel with records pending, and is
+// empty if the timeout expired.
+// @comm If no channel has records pending, a single WaitForMultipleObjects waits on all of them.
+static PyObject *win32trace_ReadChannels(PyObject *self, PyObject *args)
+{
+    PyObject *obChannels;
+    DWORD timeout = INFINITE;
+    // @pyparm [<o PyTraceChannel>, ...]|channels||Up to 64 channels to read from.
+    // @pyparm int|milliSeconds|win32event.INFINITE|The time to wait for a record.
+    if (!PyArg_ParseTuple(args, "O|k:ReadChannels", &obChannels, &timeout))
+        return NULL;
+    PyObject *seq = PySequence_Fast(obChannels, "channels must be a sequence");
+    if (seq == NULL)
+        return NULL;
+    Py_ssize_t i, n = PySequence_Fast_GET_SIZE(seq);
+    PyObject *ret = NULL;
+    HANDLE handles[MAXIMUM_WAIT_OBJECTS];
+    BOOL bPending = FALSE;
+    if (n < 1 || n > MAXIMUM_WAIT_OBJECTS) {
+        PyErr_Format(PyExc_ValueError, "Between 1 and %d channels must be passed", MAXIMUM_WAIT_OBJECTS);
+        goto done;
+    }
+    for (i = 0; i < n; i++) {
+        PyObject *ob = PySequence_Fast_GET_ITEM(seq, i);
+        if (!PyObject_TypeCheck(ob, &PyTraceChannelType)) {
+            PyErr_SetString(PyExc_TypeError, "channels must be PyTraceChannel objects");
+            goto done;
+        }
+        PyTraceChannel *channel = (PyTraceChannel *)ob;
+        if (!PyTraceChannel_check(channel))
+            goto done;
+        handles[i] = channel->hEvent;
+        if (TraceLoad(&channel->ring->head) != TraceLoad(&channel->ring->tail))
+            bPending = TRUE;
+    }
+    if (!bPending) {
+        DWORD rc;
+        Py_BEGIN_ALLOW_THREADS rc = WaitForMultipleObjects((DWORD)n, handles, FALSE, timeout);
+        Py_END_ALLOW_THREADS if (rc == WAIT_FAILED)
+        {
+            PyWin_SetAPIError("WaitForMultipleObjects");
+            goto done;
+        }
+    }
+    ret = PyList_New(0);
+    for (i = 0; ret && i < n; i++) {
+        PyTraceChannel *channel = (PyTraceChannel *)PySequence_Fast_GET_ITEM(seq, i);
+        // It may have been closed by another thread while we waited.
+        if (channel->ring == NULL || TraceLoad(&channel->ring->head) == TraceLoad(&channel->ring->tail))
+            continue;
+        PyObject *records = PyTraceChannel_drain(channel, 0);
+        PyObject *item = records ? Py_BuildValue("ON", channel, records) : NULL;
+        if (item == NULL || PyList_Append(ret, item) == -1) {
+            Py_CLEAR(ret);
+        }
+        Py_XDECREF(item);
+    }
+done:
+    Py_DECREF(seq);
+    return ret;
+}
+
+
 /* List of functions exported by this module */
 // @object win32trace|A module providing out-of-process tracing capabilities for Python.
 static struct PyMethodDef win32trace_functions[] = {
     {"GetTracer", win32trace_GetTracer, METH_NOARGS},  // @pymeth GetTracer
     {"GetHandle", win32trace_GetHandle, 1},            // @pymeth GetHandle|
+    {"GetStatistics", win32trace_GetStatistics, 1},    // @pymeth GetStatistics|Returns the shared counters.
+    {"OpenChannel", win32trace_OpenChannel, 1},        // @pymeth OpenChannel|Opens a named trace channel.
+    {"ReadChannels", win32trace_ReadChannels, 1},      // @pymeth ReadChannels|Reads records from several channels.
     {"InitRead", win32trace_InitRead, 1},              // @pymeth InitRead|
     {"InitWrite", win32trace_InitWrite, 1},            // @pymeth InitWrite|
     {"TermRead", win32trace_TermRead, 1},              // @pymeth TermRead|
@@ -567,7 +1085,7 @@ PYWIN_MODULE_INIT_FUNC(win32trace)
         win32trace, win32trace_functions,
         "Interface to the Windows Console functions for dealing with character-mode applications.");
 
-    if (PyType_Ready(&PyTraceObjectType) == -1)
+    if (PyType_Ready(&PyTraceObjectType) == -1 || PyType_Ready(&PyTraceChannelType) == -1)
         PYWIN_MODULE_INIT_RETURN_ERROR;
     if (PyDict_SetItemString(dict, "error", PyWinExc_ApiError) == -1)
         PYWIN_MODULE_INIT_RETURN_ERROR;
@@ -587,8 +1105,6 @@ PYWIN_MODULE_INIT_FUNC(win32trace)
     sa.lpSecurityDescriptor = pSD;
     sa.bInheritHandle = TRUE;
 
-    assert(hMutex == NULL);
-
     // See comments re global namespace above - the problem child is
     // CreateFileMapping - so we temporarily use that just to work out what
     // namespace to use for our objects.
@@ -598,13 +1114,14 @@ PYWIN_MODULE_INIT_FUNC(win32trace)
     // see comments at top of file - if it exists locally, stick with
     // local - use_global_namespace is still FALSE now, so that is the
     // name we get.
-    HANDLE h = CreateFileMapping((HANDLE)-1, &sa, PAGE_READWRITE, 0, BUFFER_SIZE, FixupObjectName(MAP_OBJECT_NAME));
+    DWORD mapSize = TraceMapSize(MIN_BUFFER_SIZE);
+    HANDLE h = CreateFileMapping((HANDLE)-1, &sa, PAGE_READWRITE, 0, mapSize, FixupObjectName(MAP_OBJECT_NAME));
     if (GetLastError() != ERROR_ALREADY_EXISTS) {
         // no local one exists - see if we can create it globally - if
         // we can, we go global, else we stick with local.
         use_global_namespace = TRUE;
         HANDLE h2 =
-            CreateFileMapping((HANDLE)-1, &sa, PAGE_READWRITE, 0, BUFFER_SIZE, FixupObjectName(MAP_OBJECT_NAME));
+            CreateFileMapping((HANDLE)-1, &sa, PAGE_READWRITE, 0, mapSize, FixupObjectName(MAP_OBJECT_NAME));
         use_global_namespace = h2 != NULL;
         if (h2)
             CloseHandle(h2);
@@ -614,22 +1131,11 @@ PYWIN_MODULE_INIT_FUNC(win32trace)
     // use_global_namespace is now set and will not change - all objects
     // we use are in the same namespace.
 
-    hMutex = CreateMutex(&sa, FALSE, FixupObjectName(MUTEX_OBJECT_NAME));
-    if (hMutex == NULL) {
-        PyWin_SetAPIError("CreateMutex");
-        PYWIN_MODULE_INIT_RETURN_ERROR;
-    }
     assert(hEvent == NULL);
     hEvent = CreateEvent(&sa, FALSE, FALSE, FixupObjectName(EVENT_OBJECT_NAME));
     if (hEvent == NULL) {
         PyWin_SetAPIError("CreateEvent");
         PYWIN_MODULE_INIT_RETURN_ERROR;
     }
-    assert(hEventEmpty == NULL);
-    hEventEmpty = CreateEvent(&sa, FALSE, FALSE, FixupObjectName(EVENT_EMPTY_OBJECT_NAME));
-    if (hEventEmpty == NULL) {
-        PyWin_SetAPIError("CreateEvent");
-        PYWIN_MODULE_INIT_RETURN_ERROR;
-    }
     PYWIN_MODULE_INIT_RETURN_SUCCESS;
 }
@@ -25,6 +25,13 @@ static ProcessIdToSessionIdfunc pfnProcessIdToSessionId = NULL;
 typedef BOOL(WINAPI *WTSVirtualChannelQueryfunc)(HANDLE, WTS_VIRTUAL_CLASS, PVOID *, DWORD *);
 static WTSVirtualChannelQueryfunc pfnWTSVirtualChannelQuery = NULL;
 
+typedef BOOL(WINAPI *WTSEnumerateSessionsExWfunc)(HANDLE, DWORD *, DWORD, PWTS_SESSION_INFO_1W *, DWORD *);
+static WTSEnumerateSessionsExWfunc pfnWTSEnumerateSessionsExW = NULL;
+typedef BOOL(WINAPI *WTSEnumerateProcessesExWfunc)(HANDLE, DWORD *, DWORD, LPWSTR *, DWORD *);
+static WTSEnumerateProcessesExWfunc pfnWTSEnumerateProcessesExW = NULL;
+typedef BOOL(WINAPI *WTSFreeMemoryExWfunc)(WTS_TYPE_CLASS, PVOID, ULONG);
+static WTSFreeMemoryExWfunc pfnWTSFreeMemoryExW = NULL;
+
 // @object PyTS_HANDLE|Handle to a Terminal Server
 class PyTS_HANDLE : public PyHANDLE {
    public:
@@ -672,6 +679,487 @@ static PyObject *PyWTSSendMessage(PyObject *self, PyObject *args, PyObject *kwar
     return ret;
 }
 
+// Results of enumerating a single server for <o PyWTS_SNAPSHOT>
+struct WTS_SERVER_SNAPSHOT {
+    WCHAR *name;  // NULL for the local server
+    PWTS_SESSION_INFO_1W sessions;
+    DWORD session_cnt;
+    PWTS_PROCESS_INFO_EXW processes;
+    DWORD process_cnt;
+    DWORD err;
+};
+
+struct WTS_SNAPSHOT_WORK {
+    WTS_SERVER_SNAPSHOT *servers;
+    LONG server_cnt;
+    LONG next;
+    BOOL bprocesses;
+};
+
+// Enumerates one server, called without the GIL
+static void WTSSnapshotServer(WTS_SERVER_SNAPSHOT *s, BOOL bprocesses)
+{
+    HANDLE h = WTS_CURRENT_SERVER_HANDLE;
+    DWORD level;
+    if (s->name) {
+        h = WTSOpenServerW(s->name);
+        if (h == NULL) {
+            s->err = GetLastError();
+            return;
+        }
+    }
+    level = 1;
+    if (!(*pfnWTSEnumerateSessionsExW)(h, &level, 0, &s->sessions, &s->session_cnt)) {
+        s->err = GetLastError();
+        s->sessions = NULL;
+        s->session_cnt = 0;
+    }
+    else if (bprocesses) {
+        level = 1;
+        if (!(*pfnWTSEnumerateProcessesExW)(h, &level, WTS_ANY_SESSION, (LPWSTR *)&s->processes, &s->process_cnt)) {
+            s->err = GetLastError();
+            s->processes = NULL;
+            s->process_cnt = 0;
+        }
+    }
+    if (h != WTS_CURRENT_SERVER_HANDLE)
+        WTSCloseServer(h);
+}
+
+static DWORD WINAPI WTSSnapshotThread(LPVOID arg)
+{
+    WTS_SNAPSHOT_WORK *work = (WTS_SNAPSHOT_WORK *)arg;
+    LONG server_ind;
+    while ((server_ind = InterlockedIncrement(&work->next) - 1) < work->server_cnt)
+        WTSSnapshotServer(&work->servers[server_ind], work->bprocesses);
+    return 0;
+}
+
+// Enumerates all servers in the work list, using up to max_threads threads
+static void WTSRunSnapshot(WTS_SNAPSHOT_WORK *work, DWORD max_threads)
+{
+    HANDLE threads[MAXIMUM_WAIT_OBJECTS];
+    DWORD thread_cnt = 0;
+    if (work->server_cnt > 1) {
+        // The calling thread only waits, so that thread_cnt stays within what
+        // WaitForMultipleObjects can handle
+        if (max_threads > (DWORD)work->server_cnt)
+            max_threads = work->server_cnt;
+        for (; thread_cnt < max_threads; thread_cnt++) {
+            threads[thread_cnt] = CreateThread(NULL, 0, WTSSnapshotThread, work, 0, NULL);
+            if (threads[thread_cnt] == NULL)
+                break;
+        }
+        if (thread_cnt) {
+            WaitForMultipleObjects(thread_cnt, threads, TRUE, INFINITE);
+            for (DWORD i = 0; i < thread_cnt; i++) CloseHandle(threads[i]);
+        }
+    }
+    // Picks up the single local server, or any servers left over if threads could not be created
+    WTSSnapshotThread(work);
+}
+
+static const char *wts_session_columns[] = {"Server",   "SessionId",  "State",    "SessionName", "HostName",
+                                            "UserName", "DomainName", "FarmName", NULL};
+enum {
+    WTSCOL_S_SERVER,
+    WTSCOL_S_SESSIONID,
+    WTSCOL_S_STATE,
+    WTSCOL_S_SESSIONNAME,
+    WTSCOL_S_HOSTNAME,
+    WTSCOL_S_USERNAME,
+    WTSCOL_S_DOMAINNAME,
+    WTSCOL_S_FARMNAME,
+};
+
+static const char *wts_process_columns[] = {"Server",
+                                            "SessionId",
+                                            "ProcessId",
+                                            "ProcessName",
+                                            "UserSid",
+                                            "NumberOfThreads",
+                                            "HandleCount",
+                                            "PagefileUsage",
+                                            "PeakPagefileUsage",
+                                            "WorkingSetSize",
+                                            "PeakWorkingSetSize",
+                                            "UserTime",
+                                            "KernelTime",
+                                            NULL};
+enum {
+    WTSCOL_P_SERVER,
+    WTSCOL_P_SESSIONID,
+    WTSCOL_P_PROCESSID,
+    WTSCOL_P_PROCESSNAME,
+    WTSCOL_P_USERSID,
+    WTSCOL_P_NUMBEROFTHREADS,
+    WTSCOL_P_HANDLECOUNT,
+    WTSCOL_P_PAGEFILEUSAGE,
+    WTSCOL_P_PEAKPAGEFILEUSAGE,
+    WTSCOL_P_WORKINGSETSIZE,
+    WTSCOL_P_PEAKWORKINGSETSIZE,
+    WTSCOL_P_USERTIME,
+    WTSCOL_P_KERNELTIME,
+};
+
+static PyObject *PyWTSSessionValue(WTS_SERVER_SNAPSHOT *s, DWORD i, int col)
+{
+    PWTS_SESSION_INFO_1W si = &s->sessions[i];
+    switch (col) {
+        case WTSCOL_S_SERVER:
+            return PyWinObject_FromWCHAR(s->name);
+        case WTSCOL_S_SESSIONID:
+            return PyLong_FromUnsignedLong(si->SessionId);
+        case WTSCOL_S_STATE:
+            return PyInt_FromLong(si->State);
+        case WTSCOL_S_SESSIONNAME:
+            return PyWinObject_FromWCHAR(si->pSessionName);
+        case WTSCOL_S_HOSTNAME:
+            return PyWinObject_FromWCHAR(si->pHostName);
+        case WTSCOL_S_USERNAME:
+            return PyWinObject_FromWCHAR(si->pUserName);
+        case WTSCOL_S_DOMAINNAME:
+            return PyWinObject_FromWCHAR(si->pDomainName);
+        case WTSCOL_S_FARMNAME:
+            return PyWinObject_FromWCHAR(si->pFarmName);
+    }
+    PyErr_SetString(PyExc_SystemError, "Unknown session column");
+    return NULL;
+}
+
+static PyObject *PyWTSProcessValue(WTS_SERVER_SNAPSHOT *s, DWORD i, int col)
+{
+    PWTS_PROCESS_INFO_EXW pi = &s->processes[i];
+    switch (col) {
+        case WTSCOL_P_SERVER:
+            return PyWinObject_FromWCHAR(s->name);
+        case WTSCOL_P_SESSIONID:
+            return PyLong_FromUnsignedLong(pi->SessionId);
+        case WTSCOL_P_PROCESSID:
+            return PyLong_FromUnsignedLong(pi->ProcessId);
+        case WTSCOL_P_PROCESSNAME:
+            return PyWinObject_FromWCHAR(pi->pProcessName);
+        case WTSCOL_P_USERSID:
+            return PyWinObject_FromSID(pi->pUserSid);
+        case WTSCOL_P_NUMBEROFTHREADS:
+            return PyLong_FromUnsignedLong(pi->NumberOfThreads);
+        case WTSCOL_P_HANDLECOUNT:
+            return PyLong_FromUnsignedLong(pi->HandleCount);
+        case WTSCOL_P_PAGEFILEUSAGE:
+            return PyLong_FromUnsignedLong(pi->PagefileUsage);
+        case WTSCOL_P_PEAKPAGEFILEUSAGE:
+            return PyLong_FromUnsignedLong(pi->PeakPagefileUsage);
+        case WTSCOL_P_WORKINGSETSIZE:
+            return PyLong_FromUnsignedLong(pi->WorkingSetSize);
+        case WTSCOL_P_PEAKWORKINGSETSIZE:
+            return PyLong_FromUnsignedLong(pi->PeakWorkingSetSize);
+        case WTSCOL_P_USERTIME:
+            return PyLong_FromLongLong(pi->UserTime.QuadPart);
+        case WTSCOL_P_KERNELTIME:
+            return PyLong_FromLongLong(pi->KernelTime.QuadPart);
+    }
+    PyErr_SetString(PyExc_SystemError, "Unknown process column");
+    return NULL;
+}
+
+// @object PyWTS_SNAPSHOT|Sessions and processes of one or more terminal servers, as returned by
+// <om win32ts.WTSSnapshot>
+// @comm The data is kept in the form returned by WTSEnumerateSessionsEx and WTSEnumerateProcessesEx,
+// and only the columns requested from <om PyWTS_SNAPSHOT.Sessions> or <om PyWTS_SNAPSHOT.Processes>
+// are converted to Python objects.  Rows from all servers are concatenated, with the Server column
+// identifying which server each row came from (None for the local server).
+class PyWTS_SNAPSHOT : public PyObject {
+   public:
+    PyWTS_SNAPSHOT(WTS_SERVER_SNAPSHOT *servers, DWORD server_cnt);
+    ~PyWTS_SNAPSHOT();
+    static void deallocFunc(PyObject *ob);
+    static PyObject *Sessions(PyObject *self, PyObject *args, PyObject *kwargs);
+    static PyObject *Processes(PyObject *self, PyObject *args, PyObject *kwargs);
+    static PyObject *get_SessionCount(PyObject *self, void *unused);
+    static PyObject *get_ProcessCount(PyObject *self, void *unused);
+    static PyObject *get_Errors(PyObject *self, void *unused);
+    static struct PyMethodDef methods[];
+    static struct PyGetSetDef getset[];
+    PyObject *Columns(PyObject *obcolumns, const char **names, BOOL bprocesses);
+
+    WTS_SERVER_SNAPSHOT *m_servers;
+    DWORD m_server_cnt;
+};
+
+struct PyMethodDef PyWTS_SNAPSHOT::methods[] = {
+    // @pymeth Sessions|Returns session information as a dict of columns
+    {"Sessions", (PyCFunction)PyWTS_SNAPSHOT::Sessions, METH_VARARGS | METH_KEYWORDS},
+    // @pymeth Processes|Returns process information as a dict of columns
+    {"Processes", (PyCFunction)PyWTS_SNAPSHOT::Processes, METH_VARARGS | METH_KEYWORDS},
+    {NULL}};
+
+struct PyGetSetDef PyWTS_SNAPSHOT::getset[] = {
+    // @prop int|SessionCount|Total number of sessions on all servers
+    {"SessionCount", PyWTS_SNAPSHOT::get_SessionCount, NULL, "Total number of sessions on all servers"},
+    // @prop int|ProcessCount|Total number of processes on all servers
+    {"ProcessCount", PyWTS_SNAPSHOT::get_ProcessCount, NULL, "Total number of processes on all servers"},
+    // @prop dict|Errors|Win32 error codes for servers that could not be enumerated, keyed by server name
+    {"Errors", PyWTS_SNAPSHOT::get_Errors, NULL, "Error codes for servers that could not be enumerated"},
+    {NULL}};
+
+PyTypeObject PyWTS_SNAPSHOTType = {
+    PYWIN_OBJECT_HEAD "PyWTS_SNAPSHOT",
+    sizeof(PyWTS_SNAPSHOT),
+    0,
+    PyWTS_SNAPSHOT::deallocFunc, /* tp_dealloc */
+    0,                           /* tp_print */
+    0,                           /* tp_getattr */
+    0,                           /* tp_setattr */
+    0,                           /* tp_compare */
+    0,                           /* tp_repr */
+    0,                           /* tp_as_number */
+    0,                           /* tp_as_sequence */
+    0,                           /* tp_as_mapping */
+    0,                           /* tp_hash */
+    0,                           /* tp_call */
+    0,                           /* tp_str */
+    PyObject_GenericGetAttr,     /* tp_getattro */
+    0,                           /* tp_setattro */
+    0,                           /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,          /* tp_flags */
+    0,                           /* tp_doc */
+    0,                           /* tp_traverse */
+    0,                           /* tp_clear */
+    0,                           /* tp_richcompare */
+    0,                           /* tp_weaklistoffset */
+    0,                           /* tp_iter */
+    0,                           /* tp_iternext */
+    PyWTS_SNAPSHOT::methods,     /* tp_methods */
+    0,                           /* tp_members */
+    PyWTS_SNAPSHOT::getset,      /* tp_getset */
+};
+
+PyWTS_SNAPSHOT::PyWTS_SNAPSHOT(WTS_SERVER_SNAPSHOT *servers, DWORD server_cnt)
+{
+    ob_type = &PyWTS_SNAPSHOTType;
+    _Py_NewReference(this);
+    m_servers = servers;
+    m_server_cnt = server_cnt;
+}
+
+static void FreeWTS_SERVER_SNAPSHOTs(WTS_SERVER_SNAPSHOT *servers, DWORD server_cnt)
+{
+    for (DWORD i = 0; i < server_cnt; i++) {
+        if (servers[i].sessions)
+            (*pfnWTSFreeMemoryExW)(WTSTypeSessionInfoLevel1, servers[i].sessions, servers[i].session_cnt);
+        if (servers[i].processes)
+            (*pfnWTSFreeMemoryExW)(WTSTypeProcessInfoLevel1, servers[i].processes, servers[i].process_cnt);
+        PyWinObject_FreeWCHAR(servers[i].name);
+    }
+    free(servers);
+}
+
+PyWTS_SNAPSHOT::~PyWTS_SNAPSHOT() { FreeWTS_SERVER_SNAPSHOTs(m_servers, m_server_cnt); }
+
+/*static*/ void PyWTS_SNAPSHOT::deallocFunc(PyObject *ob) { delete (PyWTS_SNAPSHOT *)ob; }
+
+PyObject *PyWTS_SNAPSHOT::get_SessionCount(PyObject *self, void *unused)
+{
+    PyWTS_SNAPSHOT *This = (PyWTS_SNAPSHOT *)self;
+    DWORD cnt = 0;
+    for (DWORD i = 0; i < This->m_server_cnt; i++) cnt += This->m_servers[i].session_cnt;
+    return PyLong_FromUnsignedLong(cnt);
+}
+
+PyObject *PyWTS_SNAPSHOT::get_ProcessCount(PyObject *self, void *unused)
+{
+    PyWTS_SNAPSHOT *This = (PyWTS_SNAPSHOT *)self;
+    DWORD cnt = 0;
+    for (DWORD i = 0; i < This->m_server_cnt; i++) cnt += This->m_servers[i].process_cnt;
+    return PyLong_FromUnsignedLong(cnt);
+}
+
+PyObject *PyWTS_SNAPSHOT::get_Errors(PyObject *self, void *unused)
+{
+    PyWTS_SNAPSHOT *This = (PyWTS_SNAPSHOT *)self;
+    PyObject *ret = PyDict_New();
+    if (ret == NULL)
+        return NULL;
+    for (DWORD i = 0; i < This->m_server_cnt; i++) {
+        if (This->m_servers[i].err == 0)
+            continue;
+        PyObject *key = PyWinObject_FromWCHAR(This->m_servers[i].name);
+        PyObject *val = PyLong_FromUnsignedLong(This->m_servers[i].err);
+        if (key == NULL || val == NULL || PyDict_SetItem(ret, key, val) == -1) {
+            Py_XDECREF(key);
+            Py_XDECREF(val);
+            Py_DECREF(ret);
+            return NULL;
+        }
+        Py_DECREF(key);
+        Py_DECREF(val);
+    }
+    return ret;
+}
+
+PyObject *PyWTS_SNAPSHOT::Columns(PyObject *obcolumns, const char **names, BOOL bprocesses)
+{
+    int col_ids[32], col_cnt = 0, col_ind;
+    if (obcolumns == Py_None) {
+        while (names[col_cnt]) {
+            col_ids[col_cnt] = col_cnt;
+            col_cnt++;
+        }
+    }
+    else {
+        PyObject *columns_seq = PySequence_Fast(obcolumns, "Columns must be a sequence of strings");
+        if (columns_seq == NULL)
+            return NULL;
+        Py_ssize_t seq_len = PySequence_Fast_GET_SIZE(columns_seq);
+        if (seq_len > 32) {
+            Py_DECREF(columns_seq);
+            PyErr_SetString(PyExc_ValueError, "Too many columns requested");
+            return NULL;
+        }
+        for (Py_ssize_t i = 0; i < seq_len; i++) {
+            PyObject *obname = PySequence_Fast_GET_ITEM(columns_seq, i);
+            const char *name = PyUnicode_Check(obname) ? PyUnicode_AsUTF8(obname) : NULL;
+            if (name == NULL) {
+                Py_DECREF(columns_seq);
+                if (!PyErr_Occurred())
+                    PyErr_SetString(PyExc_TypeError, "Columns must be a sequence of strings");
+                return NULL;
+            }
+            for (col_ind = 0; names[col_ind]; col_ind++)
+                if (strcmp(names[col_ind], name) == 0)
+                    break;
+            if (names[col_ind] == NULL) {
+                PyErr_Format(PyExc_ValueError, "Unknown column '%s'", name);
+                Py_DECREF(columns_seq);
+                return NULL;
+            }
+            col_ids[col_cnt++] = col_ind;
+        }
+        Py_DECREF(columns_seq);
+    }
+
+    DWORD row_cnt = 0;
+    for (DWORD i = 0; i < m_server_cnt; i++)
+        row_cnt += bprocesses ? m_servers[i].process_cnt : m_servers[i].session_cnt;
+    PyObject *ret = PyDict_New();
+    if (ret == NULL)
+        return NULL;
+    for (col_ind = 0; col_ind < col_cnt; col_ind++) {
+        PyObject *column = PyList_New(row_cnt);
+        if (column == NULL || PyDict_SetItemString(ret, names[col_ids[col_ind]], column) == -1) {
+            Py_XDECREF(column);
+            Py_DECREF(ret);
+            return NULL;
+        }
+        Py_DECREF(column);  // the dict holds the reference
+        DWORD row_ind = 0;
+        for (DWORD i = 0; i < m_server_cnt; i++) {
+            DWORD cnt = bprocesses ? m_servers[i].process_cnt : m_servers[i].session_cnt;
+            for (DWORD j = 0; j < cnt; j++) {
+                PyObject *val = bprocesses ? PyWTSProcessValue(&m_servers[i], j, col_ids[col_ind])
+                                           : PyWTSSessionValue(&m_servers[i], j, col_ids[col_ind]);
+                if (val == NULL) {
+                    Py_DECREF(ret);
+                    return NULL;
+                }
+                PyList_SET_ITEM(column, row_ind++, val);
+            }
+        }
+    }
+    return ret;
+}
+
+// @pymethod dict|PyWTS_SNAPSHOT|Sessions|Returns session information as a dict of columns
+// @rdesc Each column is a list with one entry per session.  Available columns are Server, SessionId,
+// State, SessionName, HostName, UserName, DomainName and FarmName.
+PyObject *PyWTS_SNAPSHOT::Sessions(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Columns", NULL};
+    PyObject *obcolumns = Py_None;
+    // @pyparm [str,...]|Columns|None|Names of the columns to return, None for all
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|O:Sessions", keywords, &obcolumns))
+        return NULL;
+    return ((PyWTS_SNAPSHOT *)self)->Columns(obcolumns, wts_session_columns, FALSE);
+}
+
+// @pymethod dict|PyWTS_SNAPSHOT|Processes|Returns process information as a dict of columns
+// @rdesc Each column is a list with one entry per process.  Available columns are Server, SessionId,
+// ProcessId, ProcessName, UserSid, NumberOfThreads, HandleCount, PagefileUsage, PeakPagefileUsage,
+// WorkingSetSize, PeakWorkingSetSize, UserTime and KernelTime.  Times are in 100ns units.
+// @comm All columns are empty if the snapshot was taken with IncludeProcesses=False.
+PyObject *PyWTS_SNAPSHOT::Processes(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    static char *keywords[] = {"Columns", NULL};
+    PyObject *obcolumns = Py_None;
+    // @pyparm [str,...]|Columns|None|Names of the columns to return, None for all
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|O:Processes", keywords, &obcolumns))
+        return NULL;
+    return ((PyWTS_SNAPSHOT *)self)->Columns(obcolumns, wts_process_columns, TRUE);
+}
+
+// @pymethod <o PyWTS_SNAPSHOT>|win32ts|WTSSnapshot|Captures the sessions and processes of one or more
+// terminal servers
+// @comm Uses WTSEnumerateSessionsEx and WTSEnumerateProcessesEx, which return in one call the
+// information that otherwise requires a <om win32ts.WTSQuerySessionInformation> call for each
+// session and info class.  Multiple servers are enumerated concurrently on up to MaxThreads
+// threads, without holding the Python lock.<nl>
+// Requires Windows 7 or Windows Server 2008 R2 or later.
+// @comm When Servers is None, failure to enumerate the local server raises an exception.  Otherwise
+// servers that fail are reported in <om PyWTS_SNAPSHOT.Errors> and contribute no rows.
+static PyObject *PyWTSSnapshot(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+    CHECK_PFN(WTSEnumerateSessionsExW);
+    CHECK_PFN(WTSEnumerateProcessesExW);
+    CHECK_PFN(WTSFreeMemoryExW);
+    static char *keywords[] = {"Servers", "IncludeProcesses", "MaxThreads", NULL};
+    PyObject *observers = Py_None, *servers_seq = NULL;
+    BOOL bprocesses = TRUE;
+    DWORD max_threads = 8, server_cnt = 1, i;
+    WTS_SNAPSHOT_WORK work;
+    if (!PyArg_ParseTupleAndKeywords(
+            args, kwargs, "|Oik:WTSSnapshot", keywords,
+            &observers,    // @pyparm [<o PyUnicode>,...]|Servers|None|Names of servers to enumerate, None for the
+                           // local server only
+            &bprocesses,   // @pyparm boolean|IncludeProcesses|True|Also enumerate processes
+            &max_threads)) // @pyparm int|MaxThreads|8|Maximum number of servers to enumerate at once, at most 64
+        return NULL;
+    if (max_threads < 1 || max_threads > MAXIMUM_WAIT_OBJECTS)
+        return PyErr_Format(PyExc_ValueError, "MaxThreads must be between 1 and %d", MAXIMUM_WAIT_OBJECTS);
+    if (observers != Py_None) {
+        servers_seq = PySequence_Fast(observers, "Servers must be a sequence of server names");
+        if (servers_seq == NULL)
+            return NULL;
+        server_cnt = (DWORD)PySequence_Fast_GET_SIZE(servers_seq);
+    }
+    WTS_SERVER_SNAPSHOT *servers = (WTS_SERVER_SNAPSHOT *)calloc(server_cnt ? server_cnt : 1, sizeof(*servers));
+    if (servers == NULL) {
+        Py_XDECREF(servers_seq);
+        return PyErr_NoMemory();
+    }
+    if (servers_seq) {
+        for (i = 0; i < server_cnt; i++)
+            if (!PyWinObject_AsWCHAR(PySequence_Fast_GET_ITEM(servers_seq, i), &servers[i].name, FALSE)) {
+                Py_DECREF(servers_seq);
+                FreeWTS_SERVER_SNAPSHOTs(servers, server_cnt);
+                return NULL;
+            }
+        Py_DECREF(servers_seq);
+    }
+
+    work.servers = servers;
+    work.server_cnt = server_cnt;
+    work.next = 0;
+    work.bprocesses = bprocesses;
+    Py_BEGIN_ALLOW_THREADS WTSRunSnapshot(&work, max_threads);
+    Py_END_ALLOW_THREADS if (observers == Py_None && servers[0].err)
+    {
+        PyWin_SetAPIError("WTSSnapshot", servers[0].err);
+        FreeWTS_SERVER_SNAPSHOTs(servers, server_cnt);
+        return NULL;
+    }
+    return new PyWTS_SNAPSHOT(servers, server_cnt);
+}
+
 // @module win32ts|Interface to the Terminal Services Api
 //	All functions in this module accept keyword arguments
 static struct PyMethodDef win32ts_functions[] = {
@@ -727,6 +1215,9 @@ static struct PyMethodDef win32ts_functions[] = {
     // @pymeth WTSWaitSystemEvent|Waits for an event to occur
     {"WTSWaitSystemEvent", (PyCFunction)PyWTSWaitSystemEvent, METH_VARARGS | METH_KEYWORDS,
      "Waits for an event to occur"},
+    // @pymeth WTSSnapshot|Captures the sessions and processes of one or more terminal servers
+    {"WTSSnapshot", (PyCFunction)PyWTSSnapshot, METH_VARARGS | METH_KEYWORDS,
+     "Captures the sessions and processes of one or more terminal servers"},
     // @pymeth WTSSendMessage|Sends a popup message to a terminal services session
     {"WTSSendMessage", (PyCFunction)PyWTSSendMessage, METH_VARARGS | METH_KEYWORDS,
      "Sends a popup message to a terminal services session"},
@@ -735,6 +1226,8 @@ static struct PyMethodDef win32ts_functions[] = {
 PYWIN_MODULE_INIT_FUNC(win32ts)
 {
     PYWIN_MODULE_INIT_PREPARE(win32ts, win32ts_functions, "Interface to the Terminal Services Api.");
+    if (PyType_Ready(&PyWTS_SNAPSHOTType) == -1)
+        PYWIN_MODULE_INIT_RETURN_ERROR;
 
     // WTS_CONNECTSTATE_CLASS
     PyModule_AddIntConstant(module, "WTSActive", WTSActive);
@@ -839,6 +1332,9 @@ PYWIN_MODULE_INIT_FUNC(win32ts)
             (WTSRegisterSessionNotificationfunc)GetProcAddress(h, "WTSRegisterSessionNotification");
         pfnWTSUnRegisterSessionNotification =
             (WTSUnRegisterSessionNotificationfunc)GetProcAddress(h, "WTSUnRegisterSessionNotification");
+        pfnWTSEnumerateSessionsExW = (WTSEnumerateSessionsExWfunc)GetProcAddress(h, "WTSEnumerateSessionsExW");
+        pfnWTSEnumerateProcessesExW = (WTSEnumerateProcessesExWfunc)GetProcAddress(h, "WTSEnumerateProcessesExW");
+        pfnWTSFreeMemoryExW = (WTSFreeMemoryExWfunc)GetProcAddress(h, "WTSFreeMemoryExW");
     }
 
     h = GetModuleHandle(L"kernel32.dll");
@@ -0,0 +1,389 @@
+# A benchmark of the I/O paths through win32file, win32pipe and sockets.
+#
+# Each benchmark runs a loop of one kind of operation on each of a number of
+# threads for a fixed time, and reports the operations and megabytes per second
+# and the percentiles of the latency of the individual operations.  Every
+# combination of the buffer sizes and thread counts given is run.  The files are
+# small enough to stay in the cache, so the times are mostly the wrappers and the
+# kernel's I/O paths rather than the disk.
+#
+# The results can be written as JSON, and the JSON written by another build
+# given to --compare to show the changes in throughput and latency - eg, to check
+# a new build against the last release:
+#   bench_io.py --json new.json --compare release.json
+# Usage: bench_io.py [--bench name,...] [--sizes 512,4096,...] [--threads 1,4,...]
+#                    [--duration seconds] [--json file] [--compare file]
+import sys
+import os
+import json
+import time
+import socket
+import shutil
+import tempfile
+import threading
+import argparse
+import pywintypes
+import win32con
+import win32event
+import win32file
+import win32pipe
+
+# The reads and writes of each file cycle through this much of it.
+FILE_SPAN = 8 * 1024 * 1024
+
+def _open_file(size, workdir, index, flags=0):
+    span = max(FILE_SPAN // size, 1) * size
+    name = os.path.join(workdir, "file%d.dat" % index)
+    if not os.path.exists(name):
+        with open(name, "wb") as f:
+            f.write(os.urandom(span))
+    h = win32file.CreateFile(name, win32con.GENERIC_READ | win32con.GENERIC_WRITE, 0, None,
+                             win32con.OPEN_EXISTING, win32con.FILE_ATTRIBUTE_NORMAL | flags, None)
+    return h, span
+
+def _overlapped():
+    ol = pywintypes.OVERLAPPED()
+    ol.hEvent = win32event.CreateEvent(None, 1, 0, None)
+    return ol
+
+# Each make_* function prepares one thread's share of a benchmark, and returns a
+# function to perform one operation, which returns the number of bytes it moved,
+# and a function to clean up.
+def make_file_write(size, workdir, index):
+    h, span = _open_file(size, workdir, index)
+    data = os.urandom(size)
+    pos = 0
+    def op():
+        nonlocal pos
+        if pos >= span:
+            win32file.SetFilePointer(h, 0, win32file.FILE_BEGIN)
+            pos = 0
+        win32file.WriteFile(h, data)
+        pos += size
+        return size
+    return op, h.Close
+
+def make_file_read(size, workdir, index):
+    h, span = _open_file(size, workdir, index)
+    buf = win32file.AllocateReadBuffer(size)
+    pos = 0
+    def op():
+        nonlocal pos
+        if pos >= span:
+            win32file.SetFilePointer(h, 0, win32file.FILE_BEGIN)
+            pos = 0
+        hr, data = win32file.ReadFile(h, buf)
+        pos += len(data)
+        return len(data)
+    return op, h.Close
+
+def _make_overlapped_file(size, workdir, index, reading):
+    h, span = _open_file(size, workdir, index, win32file.FILE_FLAG_OVERLAPPED)
+    ol = _overlapped()
+    buf = win32file.AllocateReadBuffer(size) if reading else os.urandom(size)
+    offset = 0
+    def op():
+        nonlocal offset
+        ol.Offset = offset
+        if reading:
+            win32file.ReadFile(h, buf, ol)
+        else:
+            win32file.WriteFile(h, buf, ol)
+        n = win32file.GetOverlappedResult(h, ol, True)
+        offset = (offset + size) % span
+        return n
+    return op, h.Close
+
+def make_overlapped_read(size, workdir, index):
+    return _make_overlapped_file(size, workdir, index, True)
+
+def make_overlapped_write(size, workdir, index):
+    return _make_overlapped_file(size, workdir, index, False)
+
+def make_iocp_read(size, workdir, index):
+    # Overlapped reads, reaped from a completion port with GetQueuedCompletionStatus.
+    h, span = _open_file(size, workdir, index, win32file.FILE_FLAG_OVERLAPPED)
+    port = win32file.CreateIoCompletionPort(h, None, index, 0)
+    ol = pywintypes.OVERLAPPED()
+    buf = win32file.AllocateReadBuffer(size)
+    offset = 0
+    def op():
+        nonlocal offset
+        ol.Offset = offset
+        win32file.ReadFile(h, buf, ol)
+        rc, n, key, ol_done = win32file.GetQueuedCompletionStatus(port, win32event.INFINITE)
+        offset = (offset + size) % span
+        return n
+    def close():
+        h.Close()
+        port.Close()
+    return op, close
+
+def make_iocp_post(size, workdir, index):
+    # Just the completion port - a PostQueuedCompletionStatus reaped by
+    # GetQueuedCompletionStatus.  The size is ignored.
+    port = win32file.CreateIoCompletionPort(win32file.INVALID_HANDLE_VALUE, None, 0, 0)
+    def op():
+        win32file.PostQueuedCompletionStatus(port, 0, index, None)
+        win32file.GetQueuedCompletionStatus(port, win32event.INFINITE)
+        return 0
+    return op, port.Close
+
+def make_pipe_transact(size, workdir, index):
+    # TransactNamedPipe to a thread which echoes each message.
+    name = r"\\.\pipe\pywin32_bench_io_%d_%d" % (os.getpid(), index)
+    server = win32pipe.CreateNamedPipe(name, win32pipe.PIPE_ACCESS_DUPLEX,
+                                       win32pipe.PIPE_TYPE_MESSAGE | win32pipe.PIPE_READMODE_MESSAGE | win32pipe.PIPE_WAIT,
+                                       1, size, size, 0, None)
+    def serve():
+        try:
+            win32pipe.ConnectNamedPipe(server)
+            while True:
+                hr, data = win32file.ReadFile(server, size)
+                win32file.WriteFile(server, data)
+        except win32file.error:
+            pass  # the client closed its end.
+        finally:
+            server.Close()
+    thread = threading.Thread(target=serve)
+    thread.start()
+    client = win32file.CreateFile(name, win32con.GENERIC_READ | win32con.GENERIC_WRITE, 0, None,
+                                  win32con.OPEN_EXISTING, 0, None)
+    win32pipe.SetNamedPipeHandleState(client, win32pipe.PIPE_READMODE_MESSAGE, None, None)
+    data = os.urandom(size)
+    buf = win32file.AllocateReadBuffer(size)
+    def op():
+        win32pipe.TransactNamedPipe(client, data, buf, None)
+        return size
+    def close():
+        client.Close()
+        thread.join()
+    return op, close
+
+def _connect(serve):
+    # Returns a client socket connected over loopback to a thread running serve(sock).
+    listener = socket.socket()
+    listener.bind(("127.0.0.1", 0))
+    listener.listen(1)
+    def run():
+        sock, addr = listener.accept()
+        listener.close()
+        sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        try:
+            serve(sock)
+        except socket.error:
+            pass
+        finally:
+            sock.close()
+    thread = threading.Thread(target=run)
+    thread.start()
+    client = socket.socket()
+    client.connect(listener.getsockname())
+    client.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    def close():
+        client.close()
+        thread.join()
+    return client, close
+
+def make_socket_echo(size, workdir, index):
+    # Overlapped WSASend of a buffer, and WSARecv of its echo.
+    def serve(sock):
+        buf = bytearray(size)
+        while True:
+            n = sock.recv_into(buf)
+            if not n:
+                break
+            sock.sendall(memoryview(buf)[:n])
+    client, close = _connect(serve)
+    data = os.urandom(size)
+    buf = win32file.AllocateReadBuffer(size)
+    ol_send = _overlapped()
+    ol_recv = _overlapped()
+    def op():
+        win32file.WSASend(client, data, ol_send, 0)
+        win32file.GetOverlappedResult(client.fileno(), ol_send, True)
+        got = 0
+        while got < size:
+            win32file.WSARecv(client, buf, ol_recv, 0)
+            n = win32file.GetOverlappedResult(client.fileno(), ol_recv, True)
+            if not n:
+                raise RuntimeError("The echo server closed the connection")
+            got += n
+        return size
+    return op, close
+
+def make_transmit_file(size, workdir, index):
+    # TransmitFile of a whole file to a thread which discards what it receives.
+    def serve(sock):
+        buf = bytearray(1024 * 1024)
+        while sock.recv_into(buf):
+            pass
+    name = os.path.join(workdir, "transmit%d.dat" % index)
+    with open(name, "wb") as f:
+        f.write(os.urandom(size))
+    h = win32file.CreateFile(name, win32con.GENERIC_READ, win32con.FILE_SHARE_READ, None,
+                             win32con.OPEN_EXISTING, win32file.FILE_FLAG_SEQUENTIAL_SCAN, None)
+    client, close_socket = _connect(serve)
+    ol = _overlapped()
+    def op():
+        win32file.SetFilePointer(h, 0, win32file.FILE_BEGIN)
+        win32file.TransmitFile(client, h, size, 0, ol, 0)
+        return win32file.GetOverlappedResult(client.fileno(), ol, True)
+    def close():
+        close_socket()
+        h.Close()
+    return op, close
+
+BENCHMARKS = [
+    ("file_write", make_file_write),
+    ("file_read", make_file_read),
+    ("overlapped_write", make_overlapped_write),
+    ("overlapped_read", make_overlapped_read),
+    ("iocp_read", make_iocp_read),
+    ("iocp_post", make_iocp_post),
+    ("pipe_transact", make_pipe_transact),
+    ("socket_echo", make_socket_echo),
+    ("transmit_file", make_transmit_file),
+]
+
+def percentile(sorted_values, pct):
+    return sorted_values[int(pct / 100.0 * (len(sorted_values) - 1))]
+
+def run(make, size, threads, duration, workdir):
+    workers = []
+    try:
+        for i in range(threads):
+            workers.append(make(size, workdir, i))
+        # Warm up, and make sure each works before timing them.
+        for op, close in workers:
+            op()
+        barrier = threading.Barrier(threads + 1)
+        results = [None] * threads
+        def work(i):
+            op = workers[i][0]
+            latencies = []
+            nbytes = 0
+            barrier.wait()
+            now = time.perf_counter()
+            end = now + duration
+            while now < end:
+                nbytes += op()
+                t = time.perf_counter()
+                latencies.append(t - now)
+                now = t
+            results[i] = latencies, nbytes
+        pool = [threading.Thread(target=work, args=(i,)) for i in range(threads)]
+        for t in pool:
+            t.start()
+        barrier.wait()
+        start = time.perf_counter()
+        for t in pool:
+            t.join()
+        elapsed = time.perf_counter() - start
+    finally:
+        for op, close in workers:
+            close()
+    if None in results:
+        raise RuntimeError("A benchmark thread failed")
+    latencies = sorted(l for thread_latencies, nbytes in results for l in thread_latencies)
+    nbytes = sum(nbytes for thread_latencies, nbytes in results)
+    return {
+        "ops": len(latencies),
+        "seconds": elapsed,
+        "ops_per_sec": len(latencies) / elapsed,
+        "mb_per_sec": nbytes / elapsed / (1024 * 1024),
+        "latency_us": dict((name, percentile(latencies, pct) * 1e6)
+                           for name, pct in (("p50", 50), ("p90", 90), ("p99", 99), ("max", 100))),
+    }
+
+def get_build():
+    # The pywin32 build number, if this is an installed pywin32.
+    for dir in sys.path:
+        fname = os.path.join(dir, "pywin32.version.txt")
+        if os.path.isfile(fname):
+            with open(fname) as f:
+                return f.read().strip()
+    return None
+
+def compare(results, fname, threshold):
+    with open(fname) as f:
+        baseline = json.load(f)
+    old = dict(((r["bench"], r["size"], r["threads"]), r) for r in baseline["results"] if "ops_per_sec" in r)
+    print()
+    print("Compared with %s (build %s) - ratios of new to old, * marks a regression of more than %d%%"
+          % (fname, baseline.get("build"), threshold * 100))
+    print("%-18s %8s %7s %10s %10s" % ("bench", "size", "threads", "ops/sec", "p99"))
+    for r in results:
+        o = old.get((r["bench"], r["size"], r["threads"]))
+        if o is None or "ops_per_sec" not in r:
+            continue
+        ops = r["ops_per_sec"] / o["ops_per_sec"]
+        p99 = r["latency_us"]["p99"] / o["latency_us"]["p99"]
+        print("%-18s %8d %7d %9.2f%s %9.2f%s" % (r["bench"], r["size"], r["threads"],
+                                                   ops, "*" if ops < 1 - threshold else " ",
+                                                   p99, "*" if p99 > 1 + threshold else " "))
+
+def main():
+    names = [name for name, make in BENCHMARKS]
+    parser = argparse.ArgumentParser(description="Benchmark the I/O paths through win32file, win32pipe and sockets")
+    parser.add_argument("--bench", default=",".join(names),
+                        help="Comma separated benchmarks to run, from " + ", ".join(names))
+    parser.add_argument("--sizes", default="512,4096,65536,1048576",
+                        help="Comma separated buffer sizes in bytes")
+    parser.add_argument("--threads", default="1,4",
+                        help="Comma separated numbers of threads")
+    parser.add_argument("--duration", type=float, default=2.0,
+                        help="Seconds to run each benchmark for")
+    parser.add_argument("--json", help="Write the results to this file")
+    parser.add_argument("--compare", help="Compare the results with this file written by --json")
+    parser.add_argument("--threshold", type=float, default=0.1,
+                        help="The fraction of a change reported as a regression by --compare")
+    args = parser.parse_args()
+    makers = dict(BENCHMARKS)
+    benches = args.bench.split(",")
+    for name in benches:
+        if name not in makers:
+            parser.error("Unknown benchmark '%s'" % name)
+    sizes = [int(s) for s in args.sizes.split(",")]
+    thread_counts = [int(t) for t in args.threads.split(",")]
+
+    results = []
+    workdir = tempfile.mkdtemp(prefix="bench_io")
+    print("%-18s %8s %7s %12s %10s %10s %10s %10s" % ("bench", "size", "threads", "ops/sec", "MB/sec",
+                                                      "p50 us", "p90 us", "p99 us"))
+    try:
+        for name in benches:
+            for size in sizes:
+                for threads in thread_counts:
+                    result = {"bench": name, "size": size, "threads": threads}
+                    try:
+                        result.update(run(makers[name], size, threads, args.duration, workdir))
+                    except (win32file.error, socket.error, RuntimeError) as exc:
+                        result["error"] = str(exc)
+                        print("%-18s %8d %7d failed: %s" % (name, size, threads, exc))
+                    else:
+                        lat = result["latency_us"]
+                        print("%-18s %8d %7d %12.0f %10.1f %10.1f %10.1f %10.1f" % (
+                            name, size, threads, result["ops_per_sec"], result["mb_per_sec"],
+                            lat["p50"], lat["p90"], lat["p99"]))
+                    results.append(result)
+    finally:
+        shutil.rmtree(workdir, True)
+
+    if args.json:
+        info = {
+            "build": get_build(),
+            "python": sys.version,
+            "windows": "%d.%d.%d" % sys.getwindowsversion()[:3],
+            "processors": os.cpu_count(),
+            "time": time.strftime("%Y-%m-%d %H:%M:%S"),
+            "duration": args.duration,
+            "results": results,
+        }
+        with open(args.json, "w") as f:
+            json.dump(info, f, indent=1)
+    if args.compare:
+        compare(results, args.compare, args.threshold)
+
+if __name__=='__main__':
+    main()
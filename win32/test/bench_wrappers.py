@@ -0,0 +1,103 @@
+# A micro-benchmark for the cost of calling the most frequently used wrappers.
+#
+# Each entry is a cheap call which doesn't block, so the time reported is mostly
+# the wrapper's argument parsing and result building.  A call to a trivial builtin
+# is timed first as a baseline for the interpreter's own call overhead.
+# Usage: bench_wrappers.py [iterations]
+import sys
+import timeit
+import pywintypes
+import win32api
+import win32con
+import win32event
+import win32file
+import win32gui
+import win32pipe
+import win32process
+
+def get_calls():
+    ev = win32event.CreateEvent(None, 0, 0, None)
+    mutex = win32event.CreateMutex(None, 0, None)
+    sem = win32event.CreateSemaphore(None, 1, 2, None)
+    read, write = win32pipe.CreatePipe(None, 0)
+    hwnd = win32gui.GetDesktopWindow()
+    namespace = dict(globals(), ev=ev, ev_int=int(ev), mutex=mutex, sem=sem,
+                     read=read, write=write, hwnd=hwnd, proc=win32api.GetCurrentProcess(),
+                     thread=win32api.GetCurrentThread(), path=sys.executable)
+    calls = [
+        # win32event
+        "win32event.SetEvent(ev)",
+        "win32event.ResetEvent(ev)",
+        "win32event.PulseEvent(ev)",
+        "win32event.SetEvent(ev_int)",
+        "win32event.WaitForSingleObject(ev, 0)",
+        "win32event.WaitForSingleObject(mutex, 0); win32event.ReleaseMutex(mutex)",
+        "win32event.WaitForSingleObjectEx(ev, 0, False)",
+        "win32event.WaitForMultipleObjects([ev], False, 0)",
+        "win32event.WaitForSingleObject(sem, 0); win32event.ReleaseSemaphore(sem, 1)",
+        "win32api.CloseHandle(win32event.CreateEvent(None, 0, 0, None))",
+        # win32file / win32pipe
+        "win32file.WriteFile(write, b'x'); win32file.ReadFile(read, 1)",
+        "win32pipe.PeekNamedPipe(read, 0)",
+        "win32file.GetFileType(read)",
+        "win32file.GetFileAttributes(path)",
+        "win32file.GetFileAttributesEx(path)",
+        # win32api
+        "win32api.GetTickCount()",
+        "win32api.GetCurrentThreadId()",
+        "win32api.GetCurrentProcessId()",
+        "win32api.GetCurrentProcess()",
+        "win32api.GetCurrentThread()",
+        "win32api.GetLastError()",
+        "win32api.SetLastError(0)",
+        "win32api.GetSystemMetrics(win32con.SM_CXSCREEN)",
+        "win32api.GetCursorPos()",
+        "win32api.GetAsyncKeyState(win32con.VK_SHIFT)",
+        "win32api.GetKeyState(win32con.VK_SHIFT)",
+        "win32api.GetModuleHandle(None)",
+        "win32api.GetStdHandle(win32api.STD_OUTPUT_HANDLE)",
+        "win32api.GetLocalTime()",
+        "win32api.GetSystemTime()",
+        "win32api.GetVersion()",
+        "win32api.Sleep(0)",
+        "win32api.GetFileAttributes(path)",
+        "win32api.GetUserName()",
+        # win32process
+        "win32process.GetExitCodeProcess(proc)",
+        "win32process.GetPriorityClass(proc)",
+        "win32process.GetThreadPriority(thread)",
+        "win32process.GetProcessTimes(proc)",
+        "win32process.GetWindowThreadProcessId(hwnd)",
+        # win32gui
+        "win32gui.GetDesktopWindow()",
+        "win32gui.GetForegroundWindow()",
+        "win32gui.IsWindow(hwnd)",
+        "win32gui.IsWindowVisible(hwnd)",
+        "win32gui.GetWindowText(hwnd)",
+        "win32gui.GetClassName(hwnd)",
+        "win32gui.GetWindowRect(hwnd)",
+        "win32gui.GetClientRect(hwnd)",
+        "win32gui.GetParent(hwnd)",
+        "win32gui.GetWindowLong(hwnd, win32con.GWL_STYLE)",
+        "win32gui.GetCursorPos()",
+        "win32gui.WindowFromPoint((0, 0))",
+        "win32gui.PumpWaitingMessages()",
+        # pywintypes
+        "pywintypes.HANDLE(0)",
+    ]
+    return namespace, calls
+
+def main(iterations=100000):
+    namespace, calls = get_calls()
+    baseline = min(timeit.repeat("id(None)", number=iterations, repeat=3)) / iterations
+    print("%-75s %10s" % ("call", "ns"))
+    print("%-75s %10.1f" % ("(baseline: id(None))", baseline * 1e9))
+    for stmt in calls:
+        t = min(timeit.repeat(stmt, number=iterations, repeat=3, globals=namespace)) / iterations
+        print("%-75s %10.1f" % (stmt, t * 1e9))
+
+if __name__=='__main__':
+    if len(sys.argv) > 1:
+        main(int(sys.argv[1]))
+    else:
+        main()
@@ -7,7 +7,7 @@ import win32gui, win32con
 import pywintypes
 import array
 
-from pywin32_testutil import str2bytes
+from pywin32_testutil import str2bytes, TestSkipped
 
 custom_format_name = "PythonClipboardTestFormat"
 
@@ -108,5 +108,85 @@ class TestGlobalMemory(unittest.TestCase):
         data = GetGlobalMemory(hglobal)
         self.failUnlessEqual(data, test_data)
 
+class TestDataView(unittest.TestCase):
+    def setUp(self):
+        OpenClipboard()
+    def tearDown(self):
+        CloseClipboard()
+    def test_view(self):
+        test_data = str2bytes("hello\x00\xff")
+        cf = RegisterClipboardFormat(custom_format_name)
+        SetClipboardData(cf, test_data)
+        view = GetClipboardDataView(cf)
+        self.failUnless(view.Size >= len(test_data))
+        self.failUnlessEqual(bytes(memoryview(view)[:len(test_data)]), test_data)
+        view.Release()
+        self.failUnlessRaises(ValueError, memoryview, view)
+    def test_view_exported(self):
+        SetClipboardData(win32con.CF_TEXT, str2bytes("test"))
+        with GetClipboardDataView(win32con.CF_TEXT) as view:
+            m = memoryview(view)
+            self.failUnlessEqual(m.tobytes(), str2bytes("test\0"))
+            self.failUnlessRaises(BufferError, view.Release)
+            m.release()
+        self.failUnlessRaises(ValueError, memoryview, view)
+    def test_view_bad_format(self):
+        self.failUnlessRaises(TypeError, GetClipboardDataView, win32con.CF_BITMAP)
+
+class TestDelayedRendering(unittest.TestCase):
+    def setUp(self):
+        self.hwnd = win32gui.CreateWindow("STATIC", "", 0, 0, 0, 0, 0, 0, 0, 0, None)
+        OpenClipboard(self.hwnd)
+        EmptyClipboard()
+    def tearDown(self):
+        CloseClipboard()
+        win32gui.DestroyWindow(self.hwnd)
+    def test_render(self):
+        cf = RegisterClipboardFormat(custom_format_name)
+        calls = []
+        def renderer(format):
+            calls.append(format)
+            return str2bytes("rendered")
+        SetClipboardDataDelayed(cf, renderer)
+        self.failUnless(IsClipboardFormatAvailable(cf))
+        self.failUnlessEqual(calls, [])
+        # As a window would on WM_RENDERFORMAT
+        RenderClipboardFormat(cf)
+        self.failUnlessEqual(calls, [cf])
+        self.failUnlessEqual(GetClipboardData(cf), str2bytes("rendered"))
+        # The renderer has been used up.
+        self.failUnlessRaises(ValueError, RenderClipboardFormat, cf)
+    def test_not_callable(self):
+        self.failUnlessRaises(TypeError, SetClipboardDataDelayed, win32con.CF_TEXT, 1)
+
+class TestListener(unittest.TestCase):
+    def setUp(self):
+        try:
+            self.listener = ClipboardListener()
+        except NotImplementedError:
+            raise TestSkipped("AddClipboardFormatListener isn't available")
+    def tearDown(self):
+        self.listener.Close()
+    def test_change(self):
+        self.failUnlessEqual(self.listener.GetChanges(), [])
+        OpenClipboard()
+        try:
+            EmptyClipboard()
+            SetClipboardData(win32con.CF_TEXT, str2bytes("listener"))
+        finally:
+            CloseClipboard()
+        changes = []
+        for i in range(10):
+            changes.extend(self.listener.GetChanges(1000))
+            if changes and changes[-1][1] is not None:
+                break
+        self.failUnless(changes)
+        seq, formats = changes[-1]
+        self.failUnless(seq <= GetClipboardSequenceNumber())
+        self.failUnless(win32con.CF_TEXT in formats, formats)
+    def test_closed(self):
+        self.listener.Close()
+        self.failUnlessRaises(ValueError, self.listener.GetChanges)
+
 if __name__ == '__main__':
     unittest.main()
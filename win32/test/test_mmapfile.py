@@ -0,0 +1,116 @@
+import unittest
+
+import mmapfile
+
+class MmapfileTests(unittest.TestCase):
+    def setUp(self):
+        # A mapping backed by the system pagefile.
+        self.m = mmapfile.mmapfile(None, None, 4096)
+
+    def tearDown(self):
+        self.m.close()
+
+    def testBuffer(self):
+        self.m.write(b"hello world")
+        mv = memoryview(self.m)
+        self.assertEqual(len(mv), self.m.size())
+        self.assertFalse(mv.readonly)
+        self.assertEqual(bytes(mv[:5]), b"hello")
+        # writes through the view are seen by the mapping.
+        mv[6:11] = b"there"
+        self.m.seek(0)
+        self.assertEqual(self.m.read(11), b"hello there")
+        mv.release()
+
+    def testReadinto(self):
+        self.m.write(b"0123456789")
+        self.m.seek(2)
+        buf = bytearray(4)
+        self.assertEqual(self.m.readinto(buf), 4)
+        self.assertEqual(buf, b"2345")
+        self.assertEqual(self.m.tell(), 6)
+        # a short read at the end of the view.
+        self.m.seek(self.m.size() - 2)
+        self.assertEqual(self.m.readinto(buf), 2)
+
+    def testFind(self):
+        self.m.write(b"abc\0def abc\0def")
+        self.assertEqual(self.m.find(b"abc", 0), 0)
+        # a binary needle, starting from an explicit position.
+        self.assertEqual(self.m.find(b"c\0d", 1), 2)
+        self.assertEqual(self.m.find(b"abc", 1), 8)
+        self.assertEqual(self.m.find(b"abc", 0, 10), -1)
+        self.assertEqual(self.m.find(b"xyz", 0), -1)
+        self.assertEqual(self.m.rfind(b"abc", 0), 8)
+        self.assertEqual(self.m.rfind(b"abc", 0, 10), 0)
+        self.assertEqual(self.m.count(b"abc", 0), 2)
+        self.assertEqual(self.m.count(b"\0", 0, 16), 2)
+        # the default start is the current position.
+        self.m.seek(4)
+        self.assertEqual(self.m.find(b"abc"), 8)
+
+    def testPageSize(self):
+        import win32api
+        self.assertEqual(self.m.page_size(), win32api.GetSystemInfo()[1])
+
+    def testPrefetch(self):
+        try:
+            self.m.prefetch()
+        except NotImplementedError:
+            pass  # before Windows 8
+        self.assertRaises(ValueError, self.m.prefetch, 0, self.m.size() + 1)
+
+    def testNumaNode(self):
+        try:
+            m = mmapfile.mmapfile(None, None, 4096, NumaNode=0)
+        except NotImplementedError:
+            return
+        m.write(b"numa")
+        m.seek(0)
+        self.assertEqual(m.read(4), b"numa")
+        m.close()
+
+    def testDirtyRanges(self):
+        m = mmapfile.mmapfile(None, None, 16 * 4096)
+        page = m.page_size()
+        self.assertEqual(m.dirty_ranges(), [])
+        m.write(b"x")
+        m.seek(page + 10)
+        m.write(b"y" * page)  # spans the 2nd and 3rd pages
+        m.seek(5 * page)
+        m.write_byte(b"z")
+        self.assertEqual(m.dirty_ranges(), [(0, 3 * page), (5 * page, page)])
+        self.assertEqual(m.flush_dirty(), 4 * page)
+        self.assertEqual(m.dirty_ranges(), [])
+        m.move(8 * page, 0, 10)
+        self.assertEqual(m.dirty_ranges(), [(8 * page, page)])
+        m.flush()
+        self.assertEqual(m.dirty_ranges(), [])
+        m.close()
+
+    def testReserveGrow(self):
+        m = mmapfile.mmapfile(None, None, 64 * 4096, NumberOfBytesToMap=4096, Reserve=True)
+        self.assertEqual(m.size(), 4096)
+        m.write(b"start")
+        mv = memoryview(m)
+        m.grow(8 * 4096)
+        self.assertEqual(m.size(), 8 * 4096)
+        # the existing view is still valid, and the new memory is usable.
+        self.assertEqual(bytes(mv[:5]), b"start")
+        mv.release()
+        m.seek(7 * 4096)
+        m.write(b"end")
+        self.assertRaises(ValueError, m.grow, 65 * 4096)
+        self.assertRaises(ValueError, m.resize, 0)
+        m.close()
+        self.assertRaises(ValueError, self.m.grow, 8192)
+
+    def testExportedGuard(self):
+        mv = memoryview(self.m)
+        self.assertRaises(BufferError, self.m.close)
+        self.assertRaises(BufferError, self.m.resize, 0)
+        mv.release()
+        self.m.resize(0)
+
+if __name__ == '__main__':
+    unittest.main()
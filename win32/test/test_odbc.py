@@ -45,6 +45,7 @@ class TestStuff(unittest.TestCase):
             conn_str = "Driver={Microsoft Access Driver (*.mdb)};dbq=%s;Uid=;Pwd=;" \
                        % (self.db_filename,)
         ## print 'Connection string:', conn_str
+        self.conn_str = conn_str
         self.conn = odbc.odbc(conn_str)
         # And we expect a 'users' table for these tests.
         self.cur = self.conn.cursor()
@@ -188,5 +189,158 @@ class TestStuff(unittest.TestCase):
         self.assertEqual(self.cur.execute("select * from %s" %self.tablename), 0)
         self.assertEqual(len(self.cur.fetchone()[1]),0)
 
+    def test_fetch_block(self):
+        rows = [['user%02d' % i, i] for i in range(10)]
+        self.assertEqual(self.cur.execute("insert into %s (userid, intfield) "
+            "values (?,?)" %self.tablename, rows), 10)
+        self.cur.arraysize = 4
+        self.assertEqual(self.cur.execute("select userid, intfield from %s "
+            "order by intfield" %self.tablename), 0)
+        self.assertEqual(self.cur.fetchone(), ('user00', 0))
+        self.assertEqual(len(self.cur.fetchmany()), 4)
+        got = self.cur.fetchall()
+        self.assertEqual([tuple(r) for r in rows[5:]], got)
+        self.assertEqual(self.cur.fetchone(), None)
+
+    def test_executemany(self):
+        import datetime
+        d = datetime.datetime(2001, 2, 3, 4, 5, 6)
+        rows = [['user%d' % i, i % 2 and 'name%d' % i or None, i, i / 2.0, d]
+                for i in range(2000)]
+        self.assertEqual(self.cur.execute("insert into %s (userid, username, "
+            "intfield, floatfield, datefield) values (?,?,?,?,?)" % self.tablename,
+            rows), len(rows))
+        self.cur.execute("select userid, username, intfield, floatfield, datefield "
+            "from %s order by intfield" % self.tablename)
+        self.assertEqual(self.cur.fetchall(), [tuple(r) for r in rows])
+        # A long string can't go in a parameter array, and falls back
+        # to executing each row.
+        self.assertEqual(self.cur.execute("insert into %s (userid, longtextfield) "
+            "values (?,?)" % self.tablename, [['long', 'x' * 300], ['short', 'y']]), 2)
+
+    def test_statement_cache(self):
+        rows = [['user%d' % i, i] for i in range(5)]
+        self.cur.execute("insert into %s (userid, intfield) values (?,?)"
+                         % self.tablename, rows)
+        select = "select intfield from %s where userid = ?" % self.tablename
+        for size in (10, 0):
+            self.conn.setstatementcachesize(size)
+            for userid, val in rows:
+                cur = self.conn.cursor()
+                self.assertEqual(cur.execute(select, [userid]), 0)
+                self.assertEqual(cur.fetchall(), [(val,)])
+                self.assertEqual(len(cur.description), 1)
+                # A different statement on the same cursor, then back again
+                cur.execute("select userid from %s where intfield = ?"
+                            % self.tablename, [val])
+                self.assertEqual(cur.fetchone(), (userid,))
+                cur.execute(select, [userid])
+                self.assertEqual(cur.fetchone(), (val,))
+                cur.close()
+
+    def test_connection_pool(self):
+        odbc.setpoolsize(2)
+        try:
+            conn = odbc.odbc(self.conn_str)
+            conn.setautocommit(0)
+            cur = conn.cursor()
+            cur.execute("insert into %s (userid) values (?)" % self.tablename, ['Pooled'])
+            del cur, conn
+            self.assertEqual(odbc.poolstats()['idle'], 1)
+            hits = odbc.poolstats()['hits']
+            conn = odbc.odbc(self.conn_str)
+            self.assertEqual(odbc.poolstats()['hits'], hits + 1)
+            self.assertEqual(odbc.poolstats()['idle'], 0)
+            # The pooled connection's transaction was rolled back
+            cur = conn.cursor()
+            cur.execute("select userid from %s" % self.tablename)
+            self.assertEqual(cur.fetchall(), [])
+            del cur, conn
+        finally:
+            odbc.setpoolsize(0)
+        self.assertEqual(odbc.poolstats()['idle'], 0)
+
+    def test_executeasync(self):
+        rows = [['user%d' % i, i] for i in range(5)]
+        self.cur.execute("insert into %s (userid, intfield) values (?,?)"
+                         % self.tablename, rows)
+        select = "select intfield from %s where userid = ?" % self.tablename
+        curs = [self.conn.cursor() for i in range(3)]
+        try:
+            for i, cur in enumerate(curs):
+                cur.executeasync(select, ['user%d' % i])
+        except odbc.error:
+            raise TestSkipped("The driver doesn't execute statements asynchronously")
+        self.assertRaises(odbc.error, curs[0].fetchone)
+        pending = list(curs)
+        while pending:
+            for cur in odbc.wait(pending):
+                self.assertEqual(cur.poll(), 0)
+                pending.remove(cur)
+        for i, cur in enumerate(curs):
+            self.assertEqual(cur.fetchall(), [(i,)])
+        self.assertRaises(odbc.error, curs[0].poll)
+
+    def test_fetchcolumns(self):
+        import array, datetime
+        d = datetime.datetime(2001, 2, 3, 4, 5, 6)
+        rows = [['user%d' % i, i % 3 and 'n\xe0me%d' % i or None, i, d]
+                for i in range(20)]
+        self.cur.execute("insert into %s (userid, username, intfield, datefield) "
+                         "values (?,?,?,?)" % self.tablename, rows)
+        self.cur.arraysize = 8
+        self.cur.execute("select intfield, username, datefield from %s "
+                         "order by intfield" % self.tablename)
+        self.assertEqual(self.cur.fetchone()[0], 0)
+        n, cols = self.cur.fetchcolumns()
+        self.assertEqual(n, 19)
+        fmt, data, offsets, validity = cols[0]
+        self.assertEqual(fmt, 'i')
+        self.assertEqual(offsets, None)
+        self.assertEqual(list(array.array('i', data)), list(range(1, 20)))
+        self.assertEqual(validity, b'\xff\xff\x07')
+        fmt, data, offsets, validity = cols[1]
+        self.assertEqual(fmt, 'u')
+        offsets = array.array('i', offsets)
+        self.assertEqual(len(offsets), n + 1)
+        for i, row in enumerate(rows[1:]):
+            value = data[offsets[i]:offsets[i+1]].decode('utf8')
+            self.assertEqual(bool(validity[i // 8] & (1 << (i % 8))), row[1] is not None)
+            self.assertEqual(value, row[1] or '')
+        fmt, data, offsets, validity = cols[2]
+        self.assertEqual(fmt, 'tsu:')
+        micros = (d - datetime.datetime(1970, 1, 1)) // datetime.timedelta(microseconds=1)
+        self.assertEqual(set(array.array('q', data)), set([micros]))
+        self.assertEqual(self.cur.fetchcolumns(), (0, [('i', b'', None, b''),
+            ('u', b'', b'\0\0\0\0', b''), ('tsu:', b'', None, b'')]))
+
+    def test_streamlobs(self):
+        text = 'abc' * 70000
+        data = str2bytes('\0\1\2' * 70000)
+        self.cur.execute("insert into %s (userid, longtextfield, longbinaryfield) "
+                         "values (?,?,?)" % self.tablename, ['Frank', text, data])
+        self.cur.execute("insert into %s (userid) values (?)" % self.tablename,
+                         ['Null'])
+        self.cur.streamlobs = True
+        self.cur.execute("select longtextfield, longbinaryfield from %s "
+                         "order by userid" % self.tablename)
+        textlob, binlob = self.cur.fetchone()
+        self.assertEqual(textlob.read(3), 'abc')
+        self.assertEqual(textlob.read(), text[3:])
+        self.assertEqual(textlob.read(), '')
+        buf = bytearray(100000)
+        got = bytearray()
+        while True:
+            n = binlob.readinto(buf)
+            if not n:
+                break
+            got += buf[:n]
+        self.assertEqual(bytes(got), data)
+        textlob, binlob = self.cur.fetchone()
+        self.assertEqual(textlob.read(), None)
+        self.assertEqual(binlob.read(), None)
+        self.assertEqual(self.cur.fetchone(), None)
+        self.assertRaises(odbc.error, textlob.read)
+
 if __name__ == '__main__':
     unittest.main()
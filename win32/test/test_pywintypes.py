@@ -80,6 +80,23 @@ class TestCase(unittest.TestCase):
         ts = pywintypes.TimeStamp(MAX_TIMESTAMP)
         self.failUnlessEqual(ts, datetime.datetime.max)
 
+    def testTimeStamp(self):
+        # 2024-02-29 13:45:30.123 UTC, as a FILETIME
+        ts = pywintypes.TimeStamp(133536879301230000)
+        self.failUnlessEqual(ts.utctimetuple()[:6], (2024, 2, 29, 13, 45, 30))
+        self.failUnlessEqual(ts.microsecond, 123000)
+
+    def testFileTimesToEpoch(self):
+        import array, struct
+        epoch = 116444736000000000 # 1970-01-01 as a FILETIME
+        times = array.array('Q', [epoch, epoch + 15000000, epoch - 10000000])
+        self.failUnlessEqual(list(pywintypes.FileTimesToEpoch(times)), [0.0, 1.5, -1.0])
+        # Picking the times out of an array of structures.
+        data = struct.pack("<iQiQ", 1, epoch + 20000000, 2, epoch)
+        self.failUnlessEqual(list(pywintypes.FileTimesToEpoch(data, 12, 4)), [2.0, 0.0])
+        self.failUnlessEqual(list(pywintypes.FileTimesToEpoch(b"")), [])
+        self.assertRaises(ValueError, pywintypes.FileTimesToEpoch, data, 4)
+
     def testGUID(self):
         s = "{00020400-0000-0000-C000-000000000046}"
         iid = pywintypes.IID(s)
@@ -107,6 +124,44 @@ class TestCase(unittest.TestCase):
         d = dict(item=iid)
         self.failUnlessEqual(d['item'], iid)
 
+    def testGUIDCache(self):
+        s = "{00020400-0000-0000-C000-000000000046}"
+        iid = pywintypes.IID(s)
+        # Parsing the same string again gives back the same (immutable) object.
+        self.failUnless(pywintypes.IID(s) is iid)
+        pywintypes.ClearIIDCache()
+        iid2 = pywintypes.IID(s)
+        self.failUnlessEqual(iid, iid2)
+        self.failUnlessEqual(str(iid2), s)
+        # A bad string must not be cached.
+        bad = "{not-a-guid-or-progid}"
+        self.assertRaises(pywintypes.com_error, pywintypes.IID, bad)
+        self.assertRaises(pywintypes.com_error, pywintypes.IID, bad)
+
+    def testOVERLAPPEDPool(self):
+        pool = pywintypes.OVERLAPPEDPool(2)
+        self.failUnlessEqual(pool.size, 2)
+        state = object()
+        o1 = pool.acquire(state)
+        o1.Offset = 10
+        o2 = pool.acquire()
+        self.failUnless(o1.object is state)
+        self.failUnlessEqual(pool.outstanding, 2)
+        # An empty pool still hands out objects, and counts them.
+        o3 = pool.acquire()
+        self.failUnlessEqual(pool.exhausted, 1)
+        self.failUnlessEqual(pool.outstanding, 2)
+        del o1, o3
+        self.failUnlessEqual(pool.outstanding, 1)
+        # A reused object has had all its fields reset.
+        o1 = pool.acquire()
+        self.failUnlessEqual(o1.Offset, 0)
+        self.failUnless(o1.object is None)
+        self.failUnlessEqual(pool.acquired, 4)
+        # Outstanding objects keep the pool alive.
+        del pool
+        del o1, o2
+
 if __name__ == '__main__':
     unittest.main()
 
@@ -43,6 +43,35 @@ class SecurityTests(unittest.TestCase):
         d = dict(foo=self.pwr_sid)
         self.failUnlessEqual(d['foo'], self.pwr_sid)
 
+    def testSIDHash(self):
+        sid1 = win32security.LookupAccountName('','Power Users')[0]
+        sid2 = win32security.LookupAccountName('','Power Users')[0]
+        self.failUnlessEqual(hash(sid1), hash(sid2))
+        self.failUnlessEqual(len(set([sid1, sid2, self.pwr_sid])), 1)
+        d = {sid1: "foo"}
+        self.failUnlessEqual(d[sid2], "foo")
+        self.failUnlessEqual(str(sid1), str(sid1))
+
+    def testSIDModifyResetsHash(self):
+        sid = pywintypes.SID()
+        sid.Initialize(ntsecuritycon.SECURITY_WORLD_SID_AUTHORITY, 1)
+        sid.SetSubAuthority(0, ntsecuritycon.SECURITY_WORLD_RID)
+        hash_before, str_before = hash(sid), str(sid)
+        sid.SetSubAuthority(0, ntsecuritycon.SECURITY_WORLD_RID + 1)
+        self.failIfEqual(str(sid), str_before)
+        self.failIfEqual(hash(sid), hash_before)
+
+    def testInternedSID(self):
+        sd = win32security.SECURITY_DESCRIPTOR()
+        everyone = win32security.CreateWellKnownSid(win32security.WinWorldSid, None)
+        sd.SetSecurityDescriptorOwner(everyone, 0)
+        owner1 = sd.GetSecurityDescriptorOwner()
+        owner2 = sd.GetSecurityDescriptorOwner()
+        self.failUnless(owner1 is owner2)
+        self.failUnlessEqual(owner1, everyone)
+        # Shared objects can't be changed.
+        self.assertRaises(TypeError, owner1.SetSubAuthority, 0, 1)
+
     def testBuffer(self):
         if self.admin_sid is None:
             raise TestSkipped("No 'Administrator' account is available")
@@ -71,6 +100,121 @@ class SecurityTests(unittest.TestCase):
             sd3.SetSecurityDescriptorDacl(1,dacl,0)
             sd4.SetSecurityDescriptorSacl(1,sacl,0)
 
+class AceIterTests(unittest.TestCase):
+    def setUp(self):
+        self.everyone = win32security.CreateWellKnownSid(win32security.WinWorldSid, None)
+        self.users = win32security.CreateWellKnownSid(win32security.WinBuiltinUsersSid, None)
+        self.acl = win32security.ACL()
+        self.acl.AddAccessDeniedAce(win32security.ACL_REVISION, win32con.DELETE, self.users)
+        self.acl.AddAccessAllowedAce(win32security.ACL_REVISION,
+                                     win32con.GENERIC_READ | win32con.DELETE, self.users)
+        self.acl.AddAccessAllowedAce(win32security.ACL_REVISION, win32con.WRITE_DAC, self.everyone)
+
+    def testIterAces(self):
+        aces = list(self.acl.IterAces())
+        self.failUnlessEqual(len(aces), self.acl.GetAceCount())
+        for i, ace in enumerate(aces):
+            (acetype, aceflags), mask, sid = self.acl.GetAce(i)
+            self.failUnlessEqual(ace.AceType, acetype)
+            self.failUnlessEqual(ace.AceFlags, aceflags)
+            self.failUnlessEqual(ace.Mask, mask)
+            self.failUnlessEqual(ace.Sid, sid)
+            self.failUnless(ace.IsSid(sid))
+            self.failUnlessEqual(ob2memory(ace), ob2memory(sid))
+            self.failUnless(ace.ObjectType is None)
+
+    def testIterAcesSnapshot(self):
+        it = self.acl.IterAces()
+        first = next(it)
+        self.acl.DeleteAce(0)
+        self.failUnlessEqual(first.AceType, win32security.ACCESS_DENIED_ACE_TYPE)
+        self.failUnlessEqual(len(list(it)), 2)
+
+    def testEffectiveRights(self):
+        got = self.acl.GetEffectiveRightsForSids([self.everyone, [self.users, self.everyone],
+                                                  self.acl.GetAce(0)[2]])
+        self.failUnlessEqual(got[0], win32con.WRITE_DAC)
+        # The deny ACE comes first, so DELETE isn't granted.
+        self.failUnlessEqual(got[1], win32con.GENERIC_READ | win32con.WRITE_DAC)
+        self.failUnlessEqual(got[2], win32con.GENERIC_READ)
+        self.assertRaises(TypeError, self.acl.GetEffectiveRightsForSids, [1])
+
+class LookupSidTests(unittest.TestCase):
+    def setUp(self):
+        self.pwr_sid = win32security.LookupAccountName('','Power Users')[0]
+        self.system_sid = win32security.CreateWellKnownSid(win32security.WinLocalSystemSid, None)
+        # A domain sid with a RID nobody will ever have
+        self.unknown_sid = win32security.ConvertStringSidToSid("S-1-5-21-1-2-3-424242")
+
+    def tearDown(self):
+        win32security.SetAccountSidCache(0)
+
+    def testBatchMatchesSingle(self):
+        sids = [self.pwr_sid, self.system_sid, self.pwr_sid]
+        got = win32security.LookupAccountSids(None, sids)
+        self.failUnlessEqual(len(got), 3)
+        for sid, result in zip(sids, got):
+            self.failUnlessEqual(result, win32security.LookupAccountSid(None, sid))
+
+    def testBatchUnmapped(self):
+        got = win32security.LookupAccountSids(None, [self.unknown_sid, self.pwr_sid])
+        self.failUnlessEqual(got[0], (None, None, win32security.SidTypeUnknown))
+        self.failUnlessEqual(got[1], win32security.LookupAccountSid(None, self.pwr_sid))
+
+    def testBatchEmpty(self):
+        self.failUnlessEqual(win32security.LookupAccountSids(None, []), [])
+
+    def testCache(self):
+        win32security.SetAccountSidCache(60000, NegativeTimeout=60000)
+        first = win32security.LookupAccountSid(None, self.pwr_sid)
+        self.failUnlessEqual(win32security.LookupAccountSid(None, self.pwr_sid), first)
+        self.failUnlessEqual(win32security.LookupAccountSids(None, [self.pwr_sid])[0], first)
+        for i in range(2):
+            try:
+                win32security.LookupAccountSid(None, self.unknown_sid)
+                self.fail("expected ERROR_NONE_MAPPED")
+            except win32security.error as exc:
+                self.failUnlessEqual(exc.winerror, winerror.ERROR_NONE_MAPPED)
+
+class ScanTests(unittest.TestCase):
+    def setUp(self):
+        import tempfile
+        self.root = tempfile.mkdtemp()
+        for sub in ("a", "b", os.path.join("b", "c")):
+            os.mkdir(os.path.join(self.root, sub))
+            for i in range(3):
+                open(os.path.join(self.root, sub, "file%d.txt" % i), "w").close()
+
+    def tearDown(self):
+        import shutil
+        shutil.rmtree(self.root)
+
+    def testScan(self):
+        sds, files, errors = win32security.ScanSecurityDescriptors(self.root)
+        self.failUnlessEqual(errors, [])
+        # root, 3 directories and 9 files
+        self.failUnlessEqual(len(files), 13)
+        paths = set([f[0] for f in files])
+        self.failUnless(os.path.join(self.root, "b", "c", "file2.txt") in paths, paths)
+        # Everything inherits, so there are far fewer descriptors than files.
+        self.failUnless(len(sds) < len(files), sds)
+        for path, index in files:
+            self.failUnless(sds[index].IsValid())
+            if path.endswith(".txt"):
+                expected = win32security.GetFileSecurity(path, win32security.OWNER_SECURITY_INFORMATION)
+                self.failUnlessEqual(sds[index].GetSecurityDescriptorOwner(),
+                                     expected.GetSecurityDescriptorOwner())
+
+    def testScanFile(self):
+        path = os.path.join(self.root, "a", "file0.txt")
+        sds, files, errors = win32security.ScanSecurityDescriptors(path, win32security.DACL_SECURITY_INFORMATION, 1)
+        self.failUnlessEqual(files, [(path, 0)])
+        self.failUnlessEqual(len(sds), 1)
+
+    def testScanMissing(self):
+        self.assertRaises(win32security.error, win32security.ScanSecurityDescriptors,
+                          os.path.join(self.root, "missing"))
+
 class DomainTests(unittest.TestCase):
     def setUp(self):
         self.ds_handle = None
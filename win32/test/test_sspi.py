@@ -171,6 +171,59 @@ class TestSSPI(unittest.TestCase):
     def testSequenceEncrypt(self):
         applyHandlingSkips(self._testSequenceEncrypt)
 
+    def _doTestEncryptInPlace(self, pkg_name):
+        sspiclient, sspiserver = self._doAuth(pkg_name)
+        pkg_size_info=sspiclient.ctxt.QueryContextAttributes(sspicon.SECPKG_ATTR_SIZES)
+        trailersize=pkg_size_info['SecurityTrailer']
+        msgs = [str2bytes('message number %d ......' % i) for i in range(3)]
+
+        # One bytearray holds each message followed by room for its trailer.
+        stride = max(len(m) for m in msgs) + trailersize
+        data = bytearray(stride * len(msgs))
+        descs = []
+        for i, msg in enumerate(msgs):
+            data[i * stride:i * stride + len(msg)] = msg
+            desc = win32security.PySecBufferDescType()
+            desc.append(win32security.PySecBufferType(len(msg), sspicon.SECBUFFER_DATA, data, i * stride))
+            desc.append(win32security.PySecBufferType(trailersize, sspicon.SECBUFFER_TOKEN,
+                                                      data, i * stride + len(msg)))
+            descs.append(desc)
+        self.assertEqual(descs[1][0].DataOffset, stride)
+        self.assertEqual(sspiclient.ctxt.EncryptMessages(0, descs, 1), [0, 0, 0])
+        self.assertNotEqual(bytes(data[:len(msgs[0])]), msgs[0])
+        # The encrypted data is visible through both the object and the wrapped bytearray.
+        self.assertEqual(descs[0][0].Buffer, bytes(data[:len(msgs[0])]))
+
+        results = sspiserver.ctxt.DecryptMessages(descs, 1)
+        self.assertEqual([r[0] for r in results], [0, 0, 0])
+        for i, msg in enumerate(msgs):
+            self.assertEqual(bytes(data[i * stride:i * stride + len(msg)]), msg)
+
+        # Decrypting again fails, and processing stops at the first failure.
+        results = sspiserver.ctxt.DecryptMessages(descs, 1)
+        self.assertEqual(len(results), 1)
+        self.assertNotEqual(results[0][0], 0)
+
+    def testEncryptInPlaceNTLM(self):
+        self._doTestEncryptInPlace("NTLM")
+
+    def testSecBufferWrap(self):
+        data = bytearray(str2bytes("0123456789"))
+        buf = win32security.PySecBufferType(0, sspicon.SECBUFFER_DATA, data, 2)
+        self.assertEqual((buf.BufferSize, buf.DataOffset), (8, 2))
+        self.assertEqual(buf.Buffer, str2bytes("23456789"))
+        buf.SetRegion(4, 3)
+        self.assertEqual(buf.Buffer, str2bytes("456"))
+        buf.Buffer = str2bytes("ab")
+        self.assertEqual(data, bytearray(str2bytes("0123ab6789")))
+        self.assertRaises(ValueError, buf.SetRegion, 8, 3)
+        self.assertRaises(ValueError, win32security.PySecBufferType, 20, sspicon.SECBUFFER_DATA, data)
+        self.assertRaises(TypeError, win32security.PySecBufferType, 0, sspicon.SECBUFFER_DATA, str2bytes("ro"))
+        # The bytearray can't be resized from under the SecBuffer.
+        self.assertRaises(BufferError, data.extend, str2bytes("x"))
+        del buf
+        data.extend(str2bytes("x"))
+
     def testSecBufferRepr(self):
         desc = win32security.PySecBufferDescType()
         assert re.match('PySecBufferDesc\(ulVersion: 0 \| cBuffers: 0 \| pBuffers: 0x[\da-fA-F]{8,16}\)', repr(desc))
@@ -188,5 +241,96 @@ class TestSSPI(unittest.TestCase):
 
         assert re.match('PySecBufferDesc\(ulVersion: 0 \| cBuffers: 2 \| pBuffers: 0x[\da-fA-F]{8,16}\)', repr(desc))
 
+    def testCredentialsCache(self):
+        sspi.clear_credentials_cache()
+        server1 = sspi.ServerAuth("NTLM")
+        server2 = sspi.ServerAuth("NTLM")
+        self.assertTrue(server1.credentials is server2.credentials)
+        self.assertTrue(server1.pkg_info is server2.pkg_info)
+        uncached = sspi.ServerAuth("NTLM", cache_credentials=False)
+        self.assertFalse(uncached.credentials is server1.credentials)
+        sspi.clear_credentials_cache()
+        server3 = sspi.ServerAuth("NTLM")
+        self.assertFalse(server3.credentials is server1.credentials)
+        # Both server objects authenticate using the shared credentials.
+        self._doAuth("NTLM")
+        self._doAuth("NTLM")
+
+    def testCredentialsCacheExpiry(self):
+        sspi.clear_credentials_cache()
+        server1 = sspi.ServerAuth("NTLM")
+        old_margin = sspi.credentials_expiry_margin
+        # A huge margin makes every cached handle look about to expire.
+        sspi.credentials_expiry_margin = 1e12
+        try:
+            if not sspi._expires_soon(server1.credentials_expiry):
+                raise TestSkipped("credentials expiry can't be represented")
+            server2 = sspi.ServerAuth("NTLM")
+        finally:
+            sspi.credentials_expiry_margin = old_margin
+        self.assertFalse(server1.credentials is server2.credentials)
+
+    def testTokenBufferReused(self):
+        client = sspi.ClientAuth("NTLM", targetspn=win32api.GetUserName())
+        server = sspi.ServerAuth("NTLM")
+        err, first = client.authorize(None)
+        first_len = len(first[0].Buffer)
+        err, challenge = server.authorize(first)
+        err, second = client.authorize(challenge)
+        self.assertTrue(first is second)
+        self.assertTrue(first_len > 0)
+        err, final = server.authorize(second)
+        self.assertEqual(err, 0)
+        self.assertTrue(server.authenticated)
+
+class TestSecureChannel(unittest.TestCase):
+    # Only the client side can be tested without a server certificate, so
+    # these check what the client sends and how it copes with a bad server.
+    def _getClient(self):
+        import socket
+        try:
+            cred, expiry = win32security.AcquireCredentialsHandle(
+                None, "Microsoft Unified Security Protocol Provider",
+                sspicon.SECPKG_CRED_OUTBOUND, None, None)
+        except win32security.error as exc:
+            raise TestSkipped(exc)
+        client, server = socket.socketpair()
+        self.addCleanup(client.close)
+        self.addCleanup(server.close)
+        chan = win32security.CreateSecureChannel(client, cred, TargetName="localhost")
+        return chan, server
+
+    def testNotConnected(self):
+        chan, server = self._getClient()
+        self.assertFalse(chan.Connected)
+        self.assertFalse(chan.ShutdownSent)
+        self.assertEqual(chan.Pending, 0)
+        self.assertEqual(chan.RecordsRead, 0)
+        self.assertRaises(ValueError, chan.QueryContextAttributes,
+                          sspicon.SECPKG_ATTR_STREAM_SIZES)
+        chan.Close()
+        self.assertRaises(ValueError, chan.Read)
+
+    def testBadServer(self):
+        chan, server = self._getClient()
+        # The first thing sent is a ClientHello, in a TLS handshake record.
+        import threading
+        received = []
+        def bad_server():
+            received.append(server.recv(5))
+            server.sendall(str2bytes("HTTP/1.0 400 Bad Request\r\n\r\n"))
+            server.close()
+        t = threading.Thread(target=bad_server)
+        t.start()
+        self.assertRaises(win32security.error, chan.Handshake)
+        t.join()
+        self.assertEqual(received[0][:1], str2bytes("\x16"))
+        self.assertFalse(chan.Connected)
+
+    def testBadArgs(self):
+        self.assertRaises(TypeError, win32security.CreateSecureChannel, 1)
+        self.assertRaises(TypeError, win32security.CreateSecureChannel,
+                          Socket=0, Credentials="not a handle")
+
 if __name__=='__main__':
     testmain()
@@ -0,0 +1,54 @@
+import unittest
+import threading
+import time
+import timer
+import win32event
+
+class TestCreateTimer(unittest.TestCase):
+    def testWait(self):
+        t = timer.create_timer(10)
+        try:
+            self.assertEqual(t.period, 10)
+            count = t.wait(5000)
+            self.assertTrue(count >= 1)
+            # Falling behind coalesces the missed periods into one delivery.
+            time.sleep(0.2)
+            count = t.wait(5000)
+            self.assertTrue(count > 1, count)
+            self.assertEqual(t.overruns, t.ticks - 2)
+        finally:
+            t.close()
+        self.assertRaises(ValueError, t.wait, 0)
+
+    def testOneShot(self):
+        t = timer.create_timer(0, due=10)
+        try:
+            self.assertEqual(t.wait(5000), 1)
+            self.assertEqual(t.wait(50), 0)
+            self.assertEqual(t.ticks, 1)
+        finally:
+            t.close()
+
+    def testCallback(self):
+        ticks = []
+        done = win32event.CreateEvent(None, 0, 0, None)
+        def callback(t, count):
+            ticks.append(count)
+            if len(ticks) == 3:
+                t.close()
+                win32event.SetEvent(done)
+        t = timer.create_timer(5, callback)
+        self.assertRaises(TypeError, t.wait, 0)
+        rc = win32event.WaitForSingleObject(done, 5000)
+        self.assertEqual(rc, win32event.WAIT_OBJECT_0)
+        t.close()
+        self.assertEqual(len(ticks), 3)
+        self.assertEqual(sum(ticks), t.ticks)
+
+    def testCloseWhileWaiting(self):
+        t = timer.create_timer(60000)
+        threading.Timer(0.1, t.close).start()
+        self.assertRaises(ValueError, t.wait)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -70,6 +70,10 @@ class Registry(unittest.TestCase):
             ## REG_MULTI_SZ value needs to be a list since strings are returned as a list
             ('REG_MULTI_SZ', win32con.REG_MULTI_SZ, ['string 1','string 2','string 3','string 4']),
             ('REG_MULTI_SZ_empty', win32con.REG_MULTI_SZ, []),
+            ## longer than the conversion's stack buffer, and outside the BMP
+            ('REG_SZ_long', win32con.REG_SZ, 'x' * 1000),
+            ('REG_SZ_astral', win32con.REG_SZ, 'smile \U0001F600 please'),
+            ('REG_MULTI_SZ_astral', win32con.REG_MULTI_SZ, ['\U0001F600', 'y' * 300]),
             ('REG_DWORD', win32con.REG_DWORD, 666),
             ('REG_QWORD_INT', win32con.REG_QWORD, 99),
             ('REG_QWORD', win32con.REG_QWORD, 2**33),
@@ -107,6 +111,96 @@ class Registry(unittest.TestCase):
         ret_code=win32event.WaitForSingleObject(evt,0)
         self.failUnless(ret_code==win32con.WAIT_OBJECT_0)
 
+    def testReadTree(self):
+        key_name = self.key_name + r'\Tree'
+        hkey = win32api.RegCreateKey(win32con.HKEY_CURRENT_USER, key_name)
+        try:
+            win32api.RegSetValueEx(hkey, 'top', None, win32con.REG_DWORD, 1)
+            sub = win32api.RegCreateKey(hkey, 'a')
+            win32api.RegSetValueEx(sub, 'name', None, win32con.REG_SZ, 'value')
+            win32api.RegSetValueEx(sub, '', None, win32con.REG_MULTI_SZ, ['x', 'y'])
+            subsub = win32api.RegCreateKey(sub, 'b')
+            win32api.RegSetValueEx(subsub, 'deep', None, win32con.REG_BINARY, b'\x00\x01')
+
+            tree = win32api.RegReadTree(win32con.HKEY_CURRENT_USER, key_name)
+            self.assertEqual(tree['values'], {'top': (1, win32con.REG_DWORD)})
+            a = tree['subkeys']['a']
+            self.assertEqual(a['values'], {'name': ('value', win32con.REG_SZ),
+                                           '': (['x', 'y'], win32con.REG_MULTI_SZ)})
+            self.assertEqual(a['subkeys']['b'], {'values': {'deep': (b'\x00\x01', win32con.REG_BINARY)},
+                                                 'subkeys': {}})
+
+            flat = win32api.RegReadTree(hkey, Flat=True)
+            self.assertEqual(sorted(flat), [
+                ('', 'top', win32con.REG_DWORD, 1),
+                ('a', '', win32con.REG_MULTI_SZ, ['x', 'y']),
+                ('a', 'name', win32con.REG_SZ, 'value'),
+                ('a\\b', 'deep', win32con.REG_BINARY, b'\x00\x01'),
+                ])
+            shallow = win32api.RegReadTree(hkey, None, 1, True)
+            self.assertEqual(len(shallow), 3)
+            self.assertEqual(win32api.RegReadTree(hkey, Depth=0)['subkeys'], {})
+            self.assertRaises(win32api.error, win32api.RegReadTree, hkey, 'no such key')
+        finally:
+            win32api.RegDeleteTree(win32con.HKEY_CURRENT_USER, self.key_name)
+
+    def testRegistryWatcher(self):
+        base = win32api.RegCreateKey(win32con.HKEY_CURRENT_USER, self.key_name)
+        try:
+            a = win32api.RegCreateKey(base, 'a')
+            b = win32api.RegCreateKey(base, 'b')
+            w = win32api.CreateRegistryWatcher(Window=200)
+            try:
+                id_a = w.AddKey(base, 'a', Cookie='a')
+                id_b = w.AddKey(base, 'b')
+                self.assertEqual(w.keys, 2)
+                self.assertEqual(w.GetEvents(0), [])
+                # A burst of changes to one key is delivered once.
+                for i in range(5):
+                    win32api.RegSetValueEx(a, 'v', None, win32con.REG_DWORD, i)
+                win32api.RegSetValueEx(b, 'v', None, win32con.REG_DWORD, 0)
+                events = w.GetEvents(5000)
+                cookies = [cookie for cookie, count in events]
+                self.assertEqual(len(cookies), 2)
+                self.assertTrue('a' in cookies and id_b in cookies)
+                for cookie, count in events:
+                    self.assertTrue(count >= 1)
+                self.assertTrue(w.notifications >= 2)
+                self.assertEqual(w.batches, 1)
+                # Nothing is reported for a removed key.
+                w.RemoveKey(id_a)
+                self.assertRaises(KeyError, w.RemoveKey, id_a)
+                win32api.RegSetValueEx(a, 'v', None, win32con.REG_DWORD, 9)
+                self.assertEqual(w.GetEvents(500), [])
+            finally:
+                w.Close()
+            self.assertEqual(w.keys, 0)
+            self.assertRaises(ValueError, w.GetEvents, 0)
+            self.assertEqual(list(w), [])
+        finally:
+            win32api.RegDeleteTree(win32con.HKEY_CURRENT_USER, self.key_name)
+
+    def testRegistryWatcherCallback(self):
+        base = win32api.RegCreateKey(win32con.HKEY_CURRENT_USER, self.key_name)
+        try:
+            batches = []
+            evt = win32event.CreateEvent(None, 0, 0, None)
+            def callback(batch):
+                batches.append(batch)
+                win32event.SetEvent(evt)
+            w = win32api.CreateRegistryWatcher(callback, 0)
+            try:
+                w.AddKey(base, Cookie='base')
+                self.assertRaises(TypeError, w.GetEvents, 0)
+                win32api.RegSetValueEx(base, 'v', None, win32con.REG_SZ, 'x')
+                rc = win32event.WaitForSingleObject(evt, 5000)
+                self.assertEqual(rc, win32con.WAIT_OBJECT_0)
+            finally:
+                w.Close()
+            self.assertEqual(batches[0][0][0], 'base')
+        finally:
+            win32api.RegDeleteTree(win32con.HKEY_CURRENT_USER, self.key_name)
+
 class FileNames(unittest.TestCase):
     def testShortLongPathNames(self):
         try:
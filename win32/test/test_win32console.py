@@ -0,0 +1,136 @@
+import unittest
+import struct
+import win32console
+from pywin32_testutil import TestSkipped, testmain
+
+WHITE = win32console.FOREGROUND_RED | win32console.FOREGROUND_GREEN | win32console.FOREGROUND_BLUE
+
+class TestBackBuffer(unittest.TestCase):
+    def _cell(self, bb, x, y):
+        offset = (y * bb.Width + x) * 4
+        return struct.unpack("<HH", bytes(memoryview(bb)[offset:offset + 4]))
+
+    def testCreate(self):
+        bb = win32console.CreateConsoleBackBuffer(10, 3)
+        self.assertEqual((bb.Width, bb.Height), (10, 3))
+        self.assertEqual(len(memoryview(bb)), 10 * 3 * 4)
+        self.assertEqual(self._cell(bb, 9, 2), (ord(" "), WHITE))
+        self.assertRaises(ValueError, win32console.CreateConsoleBackBuffer, 0, 3)
+
+    def testWrite(self):
+        bb = win32console.CreateConsoleBackBuffer(10, 3)
+        self.assertEqual(bb.Write(2, 1, "hello", 0x1F), 5)
+        self.assertEqual(self._cell(bb, 2, 1), (ord("h"), 0x1F))
+        self.assertEqual(self._cell(bb, 6, 1), (ord("o"), 0x1F))
+        # Clipped at the right edge, and attributes kept when not given.
+        self.assertEqual(bb.Write(8, 0, "abcd"), 2)
+        self.assertEqual(self._cell(bb, 9, 0), (ord("b"), WHITE))
+        self.assertEqual(bb.Write(-2, 2, "xyz"), 1)
+        self.assertEqual(self._cell(bb, 0, 2), (ord("z"), WHITE))
+        self.assertEqual(bb.Write(0, 3, "off"), 0)
+
+    def testFill(self):
+        bb = win32console.CreateConsoleBackBuffer(10, 3)
+        bb.Fill(win32console.PySMALL_RECTType(8, 1, 20, 20), "#", 0x20)
+        self.assertEqual(self._cell(bb, 9, 2), (ord("#"), 0x20))
+        self.assertEqual(self._cell(bb, 7, 2), (ord(" "), WHITE))
+        bb.Fill(Attributes=0x40)
+        self.assertEqual(self._cell(bb, 9, 2), (ord("#"), 0x40))
+        self.assertEqual(self._cell(bb, 0, 0), (ord(" "), 0x40))
+        self.assertRaises(TypeError, bb.Fill, (0, 0, 1, 1))
+
+    def testFlush(self):
+        try:
+            con = win32console.CreateConsoleScreenBuffer()
+        except win32console.error as exc:
+            raise TestSkipped("No console available: %s" % (exc,))
+        bb = win32console.CreateConsoleBackBuffer(20, 10)
+        self.assertEqual(bb.Flush(con), 1)
+        self.assertEqual(bb.CellsWritten, 200)
+        self.assertEqual(bb.Flush(con), 0)
+        # Rewriting identical text writes nothing.
+        bb.Write(0, 0, "    ")
+        self.assertEqual(bb.Flush(con), 0)
+        bb.Write(3, 2, "abc")
+        bb.Write(5, 3, "de")
+        bb.Write(0, 7, "x")
+        self.assertEqual(bb.Flush(con), 2)
+        self.assertEqual(bb.CellsWritten, 200 + 4 * 2 + 1)
+        self.assertEqual(con.ReadConsoleOutputCharacter(5, win32console.PyCOORDType(3, 2)), "abc  ")
+        # Edits made through the buffer interface are found by comparison.
+        m = memoryview(bb).cast("H")
+        m[(9 * 20 + 19) * 2] = ord("Z")
+        self.assertEqual(bb.Flush(con), 1)
+        del m
+        self.assertEqual(con.ReadConsoleOutputCharacter(1, win32console.PyCOORDType(19, 9)), "Z")
+        bb.MarkDirty(win32console.PySMALL_RECTType(0, 0, 1, 0))
+        self.assertEqual(bb.Flush(con), 1)
+
+        other = win32console.CreateConsoleBackBuffer(20, 10)
+        other.Load(con)
+        self.assertEqual(self._cell(other, 3, 2)[0], ord("a"))
+        self.assertEqual(other.Flush(con), 0)
+
+class TestInputBatch(unittest.TestCase):
+    def setUp(self):
+        self.con = win32console.GetStdHandle(win32console.STD_INPUT_HANDLE)
+        try:
+            self.con.FlushConsoleInputBuffer()
+        except win32console.error as exc:
+            raise TestSkipped("No console input available: %s" % (exc,))
+
+    def _key(self, char):
+        rec = win32console.PyINPUT_RECORDType(win32console.KEY_EVENT)
+        rec.Char = char
+        rec.KeyDown = True
+        rec.RepeatCount = 1
+        return rec
+
+    def _move(self, x, y, buttons=0):
+        rec = win32console.PyINPUT_RECORDType(win32console.MOUSE_EVENT)
+        rec.MousePosition = win32console.PyCOORDType(x, y)
+        rec.ButtonState = buttons
+        rec.EventFlags = 1  # MOUSE_MOVED
+        return rec
+
+    def testCreate(self):
+        batch = win32console.PyConsoleInputBatchType(16)
+        self.assertEqual((batch.Length, batch.Count, len(batch)), (16, 0, 0))
+        self.assertEqual(batch.GetText(), "")
+        self.assertRaises(ValueError, win32console.PyConsoleInputBatchType, 0)
+
+    def testRead(self):
+        self.con.WriteConsoleInput([self._key(c) for c in "hello"])
+        batch = win32console.PyConsoleInputBatchType(16)
+        self.assertTrue(self.con.ReadConsoleInputBatch(batch, Peek=True) is batch)
+        self.assertEqual(len(batch), 5)
+        self.assertEqual(self.con.GetNumberOfConsoleInputEvents(), 5)
+        self.con.ReadConsoleInputBatch(batch)
+        self.assertEqual(batch.GetText(), "hello")
+        self.assertEqual(batch[1].Char, "e")
+        self.assertEqual(batch[-1].Char, "o")
+        self.assertRaises(IndexError, batch.__getitem__, 5)
+        self.assertEqual(len(memoryview(batch)), 5 * 20)
+        self.assertEqual(self.con.GetNumberOfConsoleInputEvents(), 0)
+
+    def testCoalesce(self):
+        recs = [self._move(i, 0) for i in range(10)] + [self._key("x")]
+        recs += [self._move(i, 1, 1) for i in range(3)] + [self._move(5, 5)]
+        self.con.WriteConsoleInput(recs)
+        batch = self.con.ReadConsoleInputBatch(CoalesceMouseMoves=True)
+        self.assertEqual(len(batch), 4)
+        self.assertEqual(batch.Coalesced, 11)
+        self.assertEqual(batch[0].MousePosition.X, 9)
+        self.assertEqual(batch[2].MousePosition.X, 2)
+        self.assertEqual(batch.GetText(), "x")
+
+    def testBusy(self):
+        self.con.WriteConsoleInput([self._key("a")])
+        batch = self.con.ReadConsoleInputBatch()
+        m = memoryview(batch)
+        self.assertRaises(BufferError, self.con.ReadConsoleInputBatch, batch, Peek=True)
+        m.release()
+        self.con.ReadConsoleInputBatch(batch, Peek=True)
+
+if __name__ == "__main__":
+    testmain()
@@ -1,8 +1,12 @@
 # Test module for win32crypt
 
+import base64
+import binascii
+import os
 import unittest
 import win32crypt
-from pywin32_testutil import str2bytes # py3k-friendly helper
+import win32cryptcon
+from pywin32_testutil import str2bytes, TestSkipped # py3k-friendly helper
 
 
 class Crypt(unittest.TestCase):
@@ -28,5 +32,230 @@ class Crypt(unittest.TestCase):
         self.failUnlessEqual(data, got_data)
         self.failUnlessEqual(desc, got_desc)
 
+class StreamingMessage(unittest.TestCase):
+    def setUp(self):
+        # Needs a certificate with a private key in the user's store.
+        self.store = win32crypt.CertOpenSystemStore("MY", None)
+        for cert in self.store.CertEnumCertificatesInStore():
+            try:
+                cert.CryptAcquireCertificatePrivateKey(win32cryptcon.CRYPT_ACQUIRE_SILENT_FLAG)
+            except win32crypt.error:
+                continue
+            self.cert = cert
+            break
+        else:
+            raise TestSkipped("No certificate with a private key in the MY store")
+        self.encrypt_para = {"ContentEncryptionAlgorithm":
+                                {"ObjId": win32cryptcon.szOID_RSA_DES_EDE3_CBC}}
+        self.decrypt_para = {"CertStores": [self.store],
+                             "Flags": win32cryptcon.CRYPT_MESSAGE_SILENT_KEYSET_FLAG}
+
+    def _encode(self, chunks):
+        msg = win32crypt.CryptMsgOpenToEncode(self.encrypt_para, [self.cert])
+        out = [msg.CryptMsgUpdate(chunk) for chunk in chunks]
+        out.append(msg.CryptMsgUpdate(str2bytes(""), Final=True))
+        return str2bytes("").join(out)
+
+    def _decode(self, encoded, chunk_size):
+        msg = win32crypt.CryptMsgOpenToDecode(self.decrypt_para)
+        out = []
+        for i in range(0, len(encoded), chunk_size):
+            out.append(msg.CryptMsgUpdate(memoryview(encoded)[i:i+chunk_size]))
+        out.append(msg.CryptMsgUpdate(str2bytes(""), Final=True))
+        self.assertTrue(msg.DecryptCert is not None)
+        return str2bytes("").join(out)
+
+    def testRoundTrip(self):
+        chunks = [str2bytes("chunk %d " % i) * 1000 for i in range(20)]
+        data = str2bytes("").join(chunks)
+        encoded = self._encode(chunks)
+        for chunk_size in (17, 4096, len(encoded)):
+            self.failUnlessEqual(self._decode(encoded, chunk_size), data)
+
+    def testCompatible(self):
+        data = str2bytes("My test data") * 100
+        # Streamed output can be decrypted in one go, and vice versa.
+        encoded = self._encode([data[:500], data[500:]])
+        got, cert = win32crypt.CryptDecryptMessage(self.decrypt_para, encoded)
+        self.failUnlessEqual(got, data)
+        encoded = win32crypt.CryptEncryptMessage(self.encrypt_para, [self.cert], data)
+        self.failUnlessEqual(self._decode(encoded, 100), data)
+
+    def testNoKey(self):
+        encoded = self._encode([str2bytes("My test data")])
+        msg = win32crypt.CryptMsgOpenToDecode({"CertStores": []})
+        self.assertRaises(win32crypt.error, msg.CryptMsgUpdate, encoded, True)
+
+class BCrypt(unittest.TestCase):
+    def testHash(self):
+        import hashlib
+        data = str2bytes("My test data") * 1000
+        h = win32crypt.BCryptCreateHash()
+        self.failUnlessEqual(h.DigestSize, 32)
+        h.BCryptHashData(data)
+        h.BCryptHashData(memoryview(data)[:100])
+        self.failUnlessEqual(h.BytesHashed, len(data) + 100)
+        expected = hashlib.sha256(data + data[:100]).digest()
+        self.failUnlessEqual(h.BCryptFinishHash(), expected)
+        # The object is ready for another message.
+        self.failUnlessEqual(h.BytesHashed, 0)
+        h.BCryptHashData(data)
+        self.failUnlessEqual(h.BCryptFinishHash(), hashlib.sha256(data).digest())
+
+    def testDuplicate(self):
+        import hashlib
+        h = win32crypt.BCryptCreateHash("SHA1")
+        h.BCryptHashData(str2bytes("prefix"))
+        h2 = h.BCryptDuplicateHash()
+        h2.BCryptHashData(str2bytes("suffix"))
+        self.failUnlessEqual(h.BCryptFinishHash(), hashlib.sha1(str2bytes("prefix")).digest())
+        self.failUnlessEqual(h2.BCryptFinishHash(), hashlib.sha1(str2bytes("prefixsuffix")).digest())
+
+    def testHmac(self):
+        import hmac, hashlib
+        key = str2bytes("secret key")
+        data = str2bytes("My test data")
+        h = win32crypt.BCryptCreateHash("SHA256", key)
+        for i in range(2):
+            h.BCryptHashData(data)
+            self.failUnlessEqual(h.BCryptFinishHash(),
+                                 hmac.new(key, data, hashlib.sha256).digest())
+
+    def _checkHashFile(self, flags):
+        import hashlib, os, tempfile, win32file, win32con
+        data = os.urandom(300000)
+        fd, name = tempfile.mkstemp()
+        os.write(fd, data)
+        os.close(fd)
+        try:
+            handle = win32file.CreateFile(name, win32con.GENERIC_READ, 0, None,
+                                          win32con.OPEN_EXISTING, flags, None)
+            try:
+                h = win32crypt.BCryptCreateHash()
+                self.failUnlessEqual(h.HashFile(handle, ChunkSize=65536), len(data))
+                self.failUnlessEqual(h.BCryptFinishHash(), hashlib.sha256(data).digest())
+                self.failUnlessEqual(h.HashFile(handle, 1000, 5000, 1024), 5000)
+                self.failUnlessEqual(h.BCryptFinishHash(), hashlib.sha256(data[1000:6000]).digest())
+                # Past the end of file.
+                self.failUnlessEqual(h.HashFile(handle, len(data) - 10), 10)
+                self.failUnlessEqual(h.HashFile(handle, len(data) + 10), 0)
+            finally:
+                handle.Close()
+        finally:
+            os.unlink(name)
+
+    def testHashFile(self):
+        self._checkHashFile(0)
+
+    def testHashFileOverlapped(self):
+        import win32file
+        self._checkHashFile(win32file.FILE_FLAG_OVERLAPPED)
+
+    def testAesGcm(self):
+        key = win32crypt.BCryptGenerateSymmetricKey(str2bytes("k") * 32)
+        self.failUnlessEqual(key.ChainingMode, "ChainingModeGCM")
+        nonce = str2bytes("n") * 12
+        data = str2bytes("My test data") * 100
+        aad = str2bytes("header")
+        encrypted, tag = key.BCryptEncrypt(data, nonce, aad)
+        self.failIfEqual(encrypted, data)
+        self.failUnlessEqual(len(tag), 16)
+        self.failUnlessEqual(key.BCryptDecrypt(encrypted, nonce, tag, aad), data)
+        self.assertRaises(win32crypt.error, key.BCryptDecrypt, encrypted, nonce, tag)
+
+    def testAesGcmInPlace(self):
+        key = win32crypt.BCryptGenerateSymmetricKey(str2bytes("k") * 16)
+        nonce = str2bytes("n") * 12
+        data = str2bytes("My test data")
+        buf = bytearray(data)
+        result, tag = key.BCryptEncrypt(buf, nonce, Output=buf)
+        self.assertTrue(result is buf)
+        self.failIfEqual(bytes(buf), data)
+        key.BCryptDecrypt(buf, nonce, tag, Output=buf)
+        self.failUnlessEqual(bytes(buf), data)
+        self.assertRaises(ValueError, key.BCryptEncrypt, data, nonce, Output=bytearray(2))
+
+class StringConversion(unittest.TestCase):
+    def setUp(self):
+        self.data = os.urandom(100000)
+
+    def testBase64(self):
+        for flags, eol in ((0, "\r\n"),
+                           (win32cryptcon.CRYPT_STRING_NOCR, "\n"),
+                           (win32cryptcon.CRYPT_STRING_NOCRLF, "")):
+            for size in (1, 2, 3, 47, 48, 49, len(self.data)):
+                data = self.data[:size]
+                s = win32crypt.CryptBinaryToString(data, win32cryptcon.CRYPT_STRING_BASE64 | flags)
+                b64 = base64.b64encode(data).decode("ascii")
+                expected = "".join(b64[i:i+64] + eol for i in range(0, len(b64), 64))
+                self.failUnlessEqual(s, expected)
+                self.failUnlessEqual(win32crypt.CryptStringToBinary(s, win32cryptcon.CRYPT_STRING_BASE64),
+                                     (data, 0, win32cryptcon.CRYPT_STRING_BASE64))
+
+    def testHex(self):
+        s = win32crypt.CryptBinaryToString(self.data, win32cryptcon.CRYPT_STRING_HEXRAW)
+        self.failUnlessEqual(s, binascii.hexlify(self.data).decode("ascii") + "\r\n")
+        self.failUnlessEqual(win32crypt.CryptStringToBinary(s, win32cryptcon.CRYPT_STRING_HEXRAW)[0], self.data)
+        self.failUnlessEqual(win32crypt.CryptStringToBinary("0A ff\r\n10", win32cryptcon.CRYPT_STRING_HEX)[0],
+                             b"\x0a\xff\x10")
+
+    def testCryptoAPIFormats(self):
+        # These formats aren't converted natively, but should still round trip.
+        data = self.data[:1000]
+        for flags in (win32cryptcon.CRYPT_STRING_BASE64HEADER, win32cryptcon.CRYPT_STRING_HEX):
+            s = win32crypt.CryptBinaryToString(data, flags)
+            self.failUnlessEqual(win32crypt.CryptStringToBinary(s, flags)[0], data)
+        s = win32crypt.CryptBinaryToString(data, win32cryptcon.CRYPT_STRING_BASE64HEADER)
+        self.failUnlessEqual(win32crypt.CryptStringToBinary(s, win32cryptcon.CRYPT_STRING_ANY)[0], data)
+
+    def testBadString(self):
+        for s in ("QU!D", "\u20acQUJD"):
+            self.assertRaises(win32crypt.error, win32crypt.CryptStringToBinary,
+                              s, win32cryptcon.CRYPT_STRING_BASE64)
+
+class CertStoreIter(unittest.TestCase):
+    def setUp(self):
+        self.store = win32crypt.CertOpenSystemStore("ROOT", None)
+        self.certs = self.store.CertEnumCertificatesInStore()
+        if not self.certs:
+            raise TestSkipped("No certificates in the ROOT store")
+
+    def testFindAny(self):
+        found = list(self.store.CertFindCertificatesInStore())
+        self.failUnlessEqual(len(found), len(self.certs))
+        self.failUnlessEqual(sorted(c.Thumbprint for c in found),
+                             sorted(c.Thumbprint for c in self.certs))
+
+    def testFindHash(self):
+        cert = self.certs[0]
+        found = list(self.store.CertFindCertificatesInStore(
+                        win32cryptcon.CERT_FIND_SHA1_HASH, cert.Thumbprint))
+        self.failUnlessEqual(len(found), 1)
+        self.failUnlessEqual(found[0].CertEncoded, cert.CertEncoded)
+
+    def testExpiry(self):
+        cert = self.certs[0]
+        before = list(self.store.CertFindCertificatesInStore(ExpiresBefore=cert.NotAfter))
+        after = list(self.store.CertFindCertificatesInStore(ExpiresAfter=cert.NotAfter))
+        self.failUnless(len(before) + len(after) < len(self.certs))
+        for c in before:
+            self.failUnless(c.NotAfter < cert.NotAfter)
+        for c in after:
+            self.failUnless(c.NotAfter > cert.NotAfter)
+
+    def testCachedAttrs(self):
+        cert = self.certs[0]
+        self.failUnless(cert.Thumbprint is cert.Thumbprint)
+        self.failUnless(cert.SubjectName is cert.SubjectName)
+        self.failUnless(cert.NotAfter is cert.NotAfter)
+        self.failUnlessEqual(len(cert.Thumbprint), 20)
+        flags = win32cryptcon.CERT_X500_NAME_STR | win32cryptcon.CERT_NAME_STR_REVERSE_FLAG
+        self.failUnlessEqual(cert.SubjectName, win32crypt.CertNameToStr(cert.Subject, flags))
+        self.failUnlessEqual(cert.IssuerName, win32crypt.CertNameToStr(cert.Issuer, flags))
+
+    def testBadFindPara(self):
+        self.assertRaises(TypeError, self.store.CertFindCertificatesInStore,
+                          win32cryptcon.CERT_FIND_ANY, "foo")
+
 if __name__ == '__main__':
     unittest.main()
@@ -98,6 +98,26 @@ class TestEvent(unittest.TestCase):
         event.close()
         self.assertRaises(pywintypes.error, win32event.ResetEvent, event)
 
+    def testIntHandles(self):
+        event = win32event.CreateEvent(None, True, False, None)
+        win32event.SetEvent(int(event))
+        self.assertEqual(win32event.WaitForSingleObject(int(event), 0),
+                         win32event.WAIT_OBJECT_0)
+        win32event.ResetEvent(int(event))
+        self.assertNotSignaled(event)
+
+    def testArgErrors(self):
+        event = win32event.CreateEvent(None, True, False, None)
+        self.assertRaises(TypeError, win32event.SetEvent)
+        self.assertRaises(TypeError, win32event.SetEvent, event, event)
+        self.assertRaises(TypeError, win32event.SetEvent, "foo")
+        self.assertRaises(TypeError, win32event.WaitForSingleObject, event)
+        self.assertRaises(TypeError, win32event.WaitForSingleObject, event, "foo")
+        # INFINITE may be passed as -1, as for the 'k' format
+        win32event.SetEvent(event)
+        self.assertEqual(win32event.WaitForSingleObject(event, -1),
+                         win32event.WAIT_OBJECT_0)
+
 
 class TestMutex(unittest.TestCase):
 
@@ -111,5 +131,65 @@ class TestMutex(unittest.TestCase):
         self.assertRaises(pywintypes.error, win32event.ReleaseMutex, mutex)
 
 
+class TestMultiWait(unittest.TestCase):
+
+    def testManyHandles(self):
+        # More handles than WaitForMultipleObjects accepts.
+        events = [win32event.CreateEvent(None, 0, 0, None) for i in range(200)]
+        mw = win32event.CreateMultiWait()
+        try:
+            for i, event in enumerate(events):
+                mw.Add(event, i)
+            self.assertEqual(len(mw), 200)
+            self.assertRaises(ValueError, mw.Add, events[0])
+            self.assertEqual(mw.Wait(0), [])
+            for i in (150, 3, 77):
+                win32event.SetEvent(events[i])
+            got = []
+            while len(got) < 3:
+                batch = mw.Wait(5000)
+                self.assertTrue(batch)
+                got.extend(batch)
+            self.assertEqual(sorted(got), [3, 77, 150])
+            self.assertEqual(len(mw), 197)
+            self.assertEqual(mw.signalled, 3)
+            # A reported handle is no longer in the set.
+            self.assertEqual(mw.Remove(events[3]), False)
+            self.assertEqual(mw.Remove(events[4]), True)
+            win32event.SetEvent(events[4])
+            self.assertEqual(mw.Wait(100), [])
+            # ...until it is added again.
+            mw.Add(events[3])
+            win32event.SetEvent(events[3])
+            self.assertEqual(mw.Wait(5000), [events[3]])
+        finally:
+            mw.Close()
+        self.assertEqual(len(mw), 0)
+        self.assertRaises(ValueError, mw.Wait, 0)
+        self.assertRaises(ValueError, mw.Add, events[0])
+
+    def testSignalledBeforeAdd(self):
+        event = win32event.CreateEvent(None, 1, 1, None)
+        mw = win32event.CreateMultiWait([event])
+        self.assertEqual(mw.Wait(5000), [event])
+        mw.Close()
+
+    def testAddWhileWaiting(self):
+        import threading
+        mw = win32event.CreateMultiWait()
+        event = win32event.CreateEvent(None, 0, 0, None)
+        def add():
+            time.sleep(0.1)
+            mw.Add(event, "late")
+            win32event.SetEvent(event)
+        t = threading.Thread(target=add)
+        t.start()
+        try:
+            self.assertEqual(mw.Wait(5000), ["late"])
+        finally:
+            t.join()
+            mw.Close()
+
+
 if __name__=='__main__':
     unittest.main()
@@ -1,13 +1,15 @@
 import unittest
 from pywin32_testutil import str2bytes, TestSkipped, testmain
 import win32api, win32file, win32pipe, pywintypes, winerror, win32event
-import win32con, ntsecuritycon
+import win32con, ntsecuritycon, winioctlcon
 import sys
 import os
 import tempfile
 import threading
 import time
 import shutil
+import struct
+import collections
 import socket
 import datetime
 import random
@@ -34,6 +36,87 @@ class TestReadBuffer(unittest.TestCase):
         buffer[:2] = val
         self.failUnlessEqual(buffer[0:2], val)
 
+class TestReadBufferPool(unittest.TestCase):
+    def testSizeClass(self):
+        self.failUnlessEqual(win32file.AllocateReadBufferPool(1).bufferSize, 512)
+        self.failUnlessEqual(win32file.AllocateReadBufferPool(5000).bufferSize, 8192)
+        self.failUnlessEqual(win32file.AllocateReadBufferPool(0x10001).bufferSize, 0x20000)
+
+    def testLease(self):
+        pool = win32file.AllocateReadBufferPool(4096)
+        b1 = pool.Lease()
+        self.failUnlessEqual((pool.misses, pool.hits, pool.outstanding), (1, 0, 1))
+        self.failUnlessEqual(len(b1), 4096)
+        b1[:2] = str2bytes('ab')
+        b2 = pool.Lease()
+        self.failUnlessEqual((pool.misses, pool.hits, pool.outstanding), (1, 1, 2))
+        free = pool.free
+        b1 = b2 = None
+        self.failUnlessEqual(pool.outstanding, 0)
+        self.failUnlessEqual(pool.free, free + 2)
+
+    def testOverlappedRead(self):
+        fd, filename = tempfile.mkstemp()
+        os.write(fd, str2bytes("hello"))
+        os.close(fd)
+        try:
+            pool = win32file.AllocateReadBufferPool(1024, 1)
+            h = win32file.CreateFile(filename, win32file.GENERIC_READ, 0, None,
+                                     win32file.OPEN_EXISTING,
+                                     win32file.FILE_FLAG_OVERLAPPED, None)
+            overlapped = pywintypes.OVERLAPPED()
+            overlapped.hEvent = win32event.CreateEvent(None, 0, 0, None)
+            hr, data = win32file.ReadFile(h, pool, overlapped)
+            self.failUnless(data is overlapped.buffer)
+            n = win32file.GetOverlappedResult(h, overlapped, True)
+            self.failUnlessEqual(data[:n], str2bytes("hello"))
+            self.failUnlessEqual(pool.outstanding, 1)
+            # Without an overlapped we get a string, and the lease is returned.
+            h.Close()
+            h = win32file.CreateFile(filename, win32file.GENERIC_READ, 0, None,
+                                     win32file.OPEN_EXISTING, 0, None)
+            hr, got = win32file.ReadFile(h, pool)
+            self.failUnlessEqual(got, str2bytes("hello"))
+            self.failUnlessEqual(pool.outstanding, 1)
+            h.Close()
+            data = overlapped = None
+            self.failUnlessEqual(pool.outstanding, 0)
+        finally:
+            os.unlink(filename)
+
+class TestScatterGather(unittest.TestCase):
+    def testRoundTrip(self):
+        page = win32api.GetSystemInfo()[1]
+        pool = win32file.AllocateReadBufferPool(page)
+        fd, filename = tempfile.mkstemp()
+        os.close(fd)
+        try:
+            flags = win32file.FILE_FLAG_OVERLAPPED | win32file.FILE_FLAG_NO_BUFFERING
+            h = win32file.CreateFile(filename,
+                                     win32file.GENERIC_READ | win32file.GENERIC_WRITE,
+                                     0, None, win32file.CREATE_ALWAYS, flags, None)
+            out = [pool.Lease() for i in range(3)]
+            for i, b in enumerate(out):
+                b[:page] = str2bytes(chr(ord("a") + i)) * page
+            ol = pywintypes.OVERLAPPED()
+            ol.hEvent = win32event.CreateEvent(None, 0, 0, None)
+            win32file.WriteFileGather(h, out, ol)
+            self.failUnlessEqual(win32file.GetOverlappedResult(h, ol, True), 3 * page)
+            self.failUnlessEqual(len(ol.buffer), 3)
+
+            back = [pool.Lease() for i in range(3)]
+            ol = pywintypes.OVERLAPPED()
+            ol.hEvent = win32event.CreateEvent(None, 0, 0, None)
+            win32file.ReadFileScatter(h, back, ol)
+            self.failUnlessEqual(win32file.GetOverlappedResult(h, ol, True), 3 * page)
+            self.failUnlessEqual([bytes(b) for b in back], [bytes(b) for b in out])
+            # Unaligned buffers are rejected.
+            self.assertRaises(ValueError, win32file.ReadFileScatter, h,
+                              [bytearray(page + 1)], ol)
+            h.Close()
+        finally:
+            os.unlink(filename)
+
 class TestSimpleOps(unittest.TestCase):
     def testSimpleFiles(self):
         fd, filename = tempfile.mkstemp()
@@ -227,6 +310,38 @@ class TestGetFileInfoByHandleEx(unittest.TestCase):
         self.assertEqual(wt, basic_info['LastWriteTime'])
         self.assertEqual(attr, basic_info['FileAttributes'])
 
+    def testDirectoryInformation(self):
+        dirname = tempfile.mkdtemp()
+        try:
+            names = set("file%d.txt" % i for i in range(300))
+            for name in names:
+                open(os.path.join(dirname, name), "w").close()
+            h = win32file.CreateFile(dirname, win32file.FILE_LIST_DIRECTORY,
+                                     win32file.FILE_SHARE_READ | win32file.FILE_SHARE_WRITE, None,
+                                     win32con.OPEN_EXISTING, win32file.FILE_FLAG_BACKUP_SEMANTICS, None)
+            try:
+                # A small buffer, so several calls are needed.
+                info = win32file.GetDirectoryInformation(h, BufferSize=4096)
+                self.failUnless(info.calls > 1)
+                got = set(info.GetFileName(i) for i in range(len(info)))
+                self.assertEqual(got - set([".", ".."]), names)
+                entry = info[len(info) - 1]
+                self.failUnless("FileId" in entry)
+                self.assertEqual(entry["FileName"], info.GetFileName(len(info) - 1))
+                self.assertRaises(IndexError, info.__getitem__, len(info))
+
+                os.unlink(os.path.join(dirname, "file0.txt"))
+                info.Refresh()
+                self.failIf("file0.txt" in [e["FileName"] for e in info])
+
+                info = win32file.GetDirectoryInformation(h, win32file.FileFullDirectoryInfo)
+                self.assertEqual(len(info), len(names) + 1)
+                self.failIf("FileId" in info[0])
+            finally:
+                h.Close()
+        finally:
+            shutil.rmtree(dirname)
+
 class TestOverlapped(unittest.TestCase):
     def testSimpleOverlapped(self):
         # Create a file in the %TEMP% directory.
@@ -301,6 +416,60 @@ class TestOverlapped(unittest.TestCase):
         self.failUnlessEqual(errCode, 0)
         self.failUnless(isinstance(overlapped.object, Foo))
 
+    def testCompletionPortsQueuedEx(self):
+        class Foo: pass
+        io_req_port = win32file.CreateIoCompletionPort(-1, None, 0, 0)
+        entries = win32file.AllocateOverlappedEntries(8)
+        self.failUnlessEqual(len(entries), 0)
+        # Nothing queued - must time out.
+        self.failUnlessEqual(win32file.GetQueuedCompletionStatusEx(io_req_port, entries, 0), 0)
+        posted = []
+        for i in range(12):
+            overlapped = pywintypes.OVERLAPPED()
+            overlapped.object = Foo()
+            win32file.PostQueuedCompletionStatus(io_req_port, i, 100+i, overlapped)
+            posted.append(overlapped)
+        got = []
+        while len(got) < len(posted):
+            n = win32file.GetQueuedCompletionStatusEx(io_req_port, entries, win32event.INFINITE)
+            self.failUnless(0 < n <= 8)
+            self.failUnlessEqual(len(entries), n)
+            for i in range(n):
+                self.failUnlessEqual(entries.GetKey(i), 100 + entries.GetBytes(i))
+                self.failUnless(isinstance(entries[i].object, Foo))
+                got.append(entries[i])
+        self.failUnlessEqual(sorted(map(id, got)), sorted(map(id, posted)))
+        self.assertRaises(IndexError, entries.GetKey, 8)
+
+    def testCompletionReactor(self):
+        got = []
+        done = threading.Event()
+        def default(err, nbytes, key, overlapped):
+            got.append(("default", nbytes, key, overlapped))
+            if len(got) == 3:
+                done.set()
+        reactor = win32file.CreateCompletionReactor(default, 2, 8)
+        try:
+            def specific(err, nbytes, key, overlapped):
+                got.append(("specific", nbytes, key, overlapped))
+                if len(got) == 3:
+                    done.set()
+            ol = pywintypes.OVERLAPPED()
+            ol.object = specific
+            reactor.Post(1, 10, ol)
+            reactor.Post(2, 20)
+            ol2 = pywintypes.OVERLAPPED()
+            ol2.object = "not callable"
+            reactor.Post(3, 30, ol2)
+            done.wait(5)
+        finally:
+            reactor.Close()
+        got.sort(key=lambda item: item[1])
+        self.failUnlessEqual(got, [("specific", 1, 10, ol),
+                                   ("default", 2, 20, None),
+                                   ("default", 3, 30, ol2)])
+        self.failUnlessEqual(reactor.dispatched, 3)
+
     def _IOCPServerThread(self, handle, port, drop_overlapped_reference):
         overlapped = pywintypes.OVERLAPPED()
         win32pipe.ConnectNamedPipe(handle, overlapped)
@@ -454,6 +623,44 @@ class TestSocketExtensions(unittest.TestCase):
         if not stopped.isSet():
             self.fail("AcceptEx Worker thread failed to successfully stop")
 
+class TestRegisteredIO(unittest.TestCase):
+    def testUDPLoopback(self):
+        try:
+            cq = win32file.RIOCreateCompletionQueue(16)
+        except win32file.error as exc:
+            raise TestSkipped("Registered I/O is not available: %s" % (exc,))
+        flags = win32file.WSA_FLAG_OVERLAPPED | win32file.WSA_FLAG_REGISTERED_IO
+        receiver = socket.socket(fileno=win32file.WSASocket(
+            socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP, flags))
+        sender = socket.socket(fileno=win32file.WSASocket(
+            socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP, flags))
+        try:
+            receiver.bind(('127.0.0.1', 0))
+            sender.connect(receiver.getsockname())
+            rbuf = win32file.RIORegisterBuffer(bytearray(4096))
+            sbuf = win32file.RIORegisterBuffer(str2bytes("hello there"))
+            rq_recv = win32file.RIOCreateRequestQueue(receiver, 4, 1, 1, 1, cq, cq, 1)
+            rq_send = win32file.RIOCreateRequestQueue(sender, 1, 1, 4, 1, cq, cq, 2)
+            # Can't receive into a read-only buffer.
+            self.assertRaises(TypeError, win32file.RIOReceive, rq_recv, sbuf)
+            win32file.RIOReceive(rq_recv, rbuf, 0, 1024, 0, 10)
+            win32file.RIOSend(rq_send, sbuf, 0, 5, 0, 20)
+            results = win32file.AllocateRIOResults(8)
+            got = {}
+            for i in range(100):
+                for j in range(win32file.RIODequeueCompletion(cq, results)):
+                    status, nbytes, sock_ctx, req_ctx = results[j]
+                    self.failUnlessEqual(status, 0)
+                    got[req_ctx] = (nbytes, sock_ctx)
+                if len(got) == 2:
+                    break
+                time.sleep(0.01)
+            self.failUnlessEqual(got, {10: (5, 1), 20: (5, 2)})
+            self.failUnlessEqual(bytes(memoryview(rbuf)[:5]), str2bytes("hello"))
+        finally:
+            receiver.close()
+            sender.close()
+
 class TestFindFiles(unittest.TestCase):
     def testIter(self):
         dir = os.path.join(os.getcwd(), "*")
@@ -496,6 +703,41 @@ class TestFindFiles(unittest.TestCase):
         finally:
             os.rmdir(test_path)
 
+    def testWalkTree(self):
+        root = tempfile.mkdtemp()
+        try:
+            expected = set()
+            for d in ("a", os.path.join("a", "b"), "c"):
+                os.mkdir(os.path.join(root, d))
+                for i in range(50):
+                    fn = os.path.join(d, "file%d.txt" % i)
+                    open(os.path.join(root, fn), "w").close()
+                    expected.add(fn)
+            open(os.path.join(root, "other.dat"), "wb").write(str2bytes("x" * 10))
+
+            walker = win32file.WalkDirectoryTree(root + os.sep, NumThreads=3)
+            got = dict((name, (attrs, size)) for name, attrs, size, mtime in walker)
+            self.failUnlessEqual(len(got), len(expected) + 4)
+            self.failUnless(got["a"][0] & win32con.FILE_ATTRIBUTE_DIRECTORY)
+            self.failUnlessEqual(got["other.dat"][1], 10)
+            self.failUnlessEqual(walker.directories, 4)
+            self.failUnlessEqual(walker.errors, 0)
+
+            walker = win32file.WalkDirectoryTree(root, "*.TXT",
+                                                 AttributesExcluded=win32con.FILE_ATTRIBUTE_DIRECTORY)
+            self.failUnlessEqual(set(r[0] for r in walker), expected)
+            self.failUnlessEqual(walker.matched, len(expected))
+
+            walker = win32file.WalkDirectoryTree(root)
+            walker.Close()
+            self.failUnlessEqual(list(walker), [])
+        finally:
+            shutil.rmtree(root)
+
+    def testWalkTreeBadDir(self):
+        dir = os.path.join(os.getcwd(), "a dir that doesnt exist")
+        self.assertRaises(win32file.error, win32file.WalkDirectoryTree, dir)
+
 class TestDirectoryChanges(unittest.TestCase):
     num_test_dirs = 1
     def setUp(self):
@@ -620,6 +862,337 @@ class TestDirectoryChanges(unittest.TestCase):
         changes = self.watcher_thread_changes[0]
         self.failUnlessEqual(changes, [(1, "x")])
 
+class TestDirectoryWatcher(unittest.TestCase):
+    def setUp(self):
+        self.dir_name = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.dir_name, True)
+
+    def _collect(self, watcher, fn):
+        got = []
+        while (1, fn) not in got:
+            batch = watcher.GetEvents(5000)
+            self.failUnless(batch, "timed out waiting for the change")
+            got.extend(batch)
+        return got
+
+    def testCoalesce(self):
+        w = win32file.CreateDirectoryWatcher(self.dir_name, False, win32con.FILE_NOTIFY_CHANGE_FILE_NAME | win32con.FILE_NOTIFY_CHANGE_LAST_WRITE, 65536, 500)
+        try:
+            fn = "test_file"
+            f = open(os.path.join(self.dir_name, fn), "w")
+            for i in range(10):
+                f.write("x" * 100)
+                f.flush()
+                os.fsync(f.fileno())
+            f.close()
+            got = self._collect(w, fn)
+            # modifications following the add are folded into it.
+            self.failIf((3, fn) in got, got)
+            self.failUnlessEqual(w.overflows, 0)
+            self.failUnless(w.batches >= 1)
+            self.failUnless(w.notifications >= len(got))
+        finally:
+            w.Close()
+        self.failUnlessRaises(ValueError, w.GetEvents, 0)
+        self.failUnlessEqual(list(w), [])
+
+    def testCallback(self):
+        got = []
+        event = threading.Event()
+        def callback(batch):
+            got.extend(batch)
+            event.set()
+        w = win32file.CreateDirectoryWatcher(self.dir_name, True, win32con.FILE_NOTIFY_CHANGE_FILE_NAME, 8192, 0, callback)
+        try:
+            self.failUnlessRaises(TypeError, w.GetEvents, 0)
+            open(os.path.join(self.dir_name, "x"), "w").close()
+            event.wait(5)
+        finally:
+            w.Close()
+        self.failUnlessEqual(got, [(1, "x")])
+
+class TestTransactedOperations(unittest.TestCase):
+    def setUp(self):
+        self.dir_name = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.dir_name, True)
+
+    def _apply(self, ops, **kw):
+        try:
+            return win32file.ApplyTransactedOperations(ops, **kw)
+        except NotImplementedError:
+            raise TestSkipped("Transacted file operations are not available")
+        except win32file.error as exc:
+            if exc.winerror in (winerror.ERROR_NOT_SUPPORTED, winerror.ERROR_INVALID_FUNCTION):
+                raise TestSkipped("Transacted file operations are not supported here")
+            raise
+
+    def testCommit(self):
+        a = os.path.join(self.dir_name, "a")
+        sub = os.path.join(self.dir_name, "sub")
+        ops = [("write", a, None, str2bytes("hello")),
+               ("mkdir", sub),
+               ("copy", a, os.path.join(sub, "b")),
+               ("move", a, os.path.join(sub, "c")),
+               ("setattr", os.path.join(sub, "b"), None, win32con.FILE_ATTRIBUTE_READONLY)]
+        committed, results, trans = self._apply(ops)
+        trans.Close()
+        self.failUnless(committed)
+        self.failUnlessEqual(results, [0] * len(ops))
+        self.failIf(os.path.exists(a))
+        self.failUnlessEqual(open(os.path.join(sub, "c"), "rb").read(), str2bytes("hello"))
+        self.failUnless(win32file.GetFileAttributesW(os.path.join(sub, "b")) & win32con.FILE_ATTRIBUTE_READONLY)
+        win32file.SetFileAttributesW(os.path.join(sub, "b"), win32con.FILE_ATTRIBUTE_NORMAL)
+
+    def testRollback(self):
+        a = os.path.join(self.dir_name, "a")
+        ops = [("write", a, None, str2bytes("hello")),
+               ("delete", os.path.join(self.dir_name, "missing")),
+               ("mkdir", os.path.join(self.dir_name, "sub"))]
+        committed, results, trans = self._apply(ops)
+        trans.Close()
+        self.failIf(committed)
+        self.failUnlessEqual(results, [0, winerror.ERROR_FILE_NOT_FOUND, None])
+        self.failIf(os.path.exists(a))
+
+    def testBadOperation(self):
+        self.failUnlessRaises(ValueError, win32file.ApplyTransactedOperations, [("explode", "x")])
+        self.failUnlessRaises(TypeError, win32file.ApplyTransactedOperations, [("move", "x")])
+
+class TestBackupPump(unittest.TestCase):
+    def setUp(self):
+        self.dir_name = tempfile.mkdtemp()
+        self.fname = os.path.join(self.dir_name, "backup_src")
+        f = open(self.fname, "wb")
+        f.write(str2bytes("main data" * 1000))
+        f.close()
+        try:
+            f = open(self.fname + ":alt", "wb")
+        except (IOError, OSError):
+            shutil.rmtree(self.dir_name, True)
+            raise TestSkipped("Alternate data streams are not supported here")
+        f.write(str2bytes("alternate"))
+        f.close()
+
+    def tearDown(self):
+        shutil.rmtree(self.dir_name, True)
+
+    def _open(self, fname, access, disposition):
+        return win32file.CreateFile(fname, access, 0, None, disposition,
+                                    win32file.FILE_FLAG_BACKUP_SEMANTICS, None)
+
+    def testCallback(self):
+        got = {}
+        def sink(stream, offset, data):
+            got[stream] = got.get(stream, str2bytes("")) + data.tobytes()
+            self.failUnlessEqual(offset + len(data), len(got[stream]))
+        h = self._open(self.fname, win32file.GENERIC_READ, win32file.OPEN_EXISTING)
+        try:
+            # small buffers, so the streams span several of them
+            total, streams = win32file.BackupPump(h, sink, BufferSize=4096, ProcessSecurity=False)
+        finally:
+            h.Close()
+        ids = dict((name, (id, size)) for (id, attrs, size, name) in streams)
+        self.failUnlessEqual(ids[""], (win32con.BACKUP_DATA, 9000))
+        self.failUnlessEqual(ids[":alt:$DATA"], (win32con.BACKUP_ALTERNATE_DATA, 9))
+        for stream in streams:
+            self.failUnlessEqual(len(got[stream]), stream[2])
+        self.failUnlessEqual(got[streams[0]], str2bytes("main data" * 1000))
+        self.failUnless(total > 9009)
+
+    def testCallbackError(self):
+        def sink(stream, offset, data):
+            raise RuntimeError("stop")
+        h = self._open(self.fname, win32file.GENERIC_READ, win32file.OPEN_EXISTING)
+        try:
+            self.failUnlessRaises(RuntimeError, win32file.BackupPump, h, sink)
+        finally:
+            h.Close()
+
+    def testRestore(self):
+        copy = os.path.join(self.dir_name, "backup_dst")
+        src = self._open(self.fname, win32file.GENERIC_READ, win32file.OPEN_EXISTING)
+        dst = self._open(copy, win32file.GENERIC_WRITE, win32file.CREATE_ALWAYS)
+        try:
+            win32file.BackupPump(src, dst, ProcessSecurity=False, Restore=True)
+        finally:
+            src.Close()
+            dst.Close()
+        self.failUnlessEqual(open(copy, "rb").read(), str2bytes("main data" * 1000))
+        self.failUnlessEqual(open(copy + ":alt", "rb").read(), str2bytes("alternate"))
+
+class TestCopyJob(unittest.TestCase):
+    def setUp(self):
+        self.dir_name = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.dir_name, True)
+
+    def testCopy(self):
+        files = []
+        for i in range(20):
+            src = os.path.join(self.dir_name, "src%d" % i)
+            f = open(src, "wb")
+            f.write(str2bytes("x" * (i * 1000)))
+            f.close()
+            files.append((src, os.path.join(self.dir_name, "sub", "dir", "dst%d" % i)))
+        # a missing source fails without stopping the others
+        files.append((os.path.join(self.dir_name, "missing"), os.path.join(self.dir_name, "dst_missing")))
+        job = win32file.CreateCopyJob(files, NumThreads=3, UnbufferedThreshold=10000)
+        self.failUnless(job.Wait(30000))
+        copied, failed, skipped, total, bytes_copied, bytes_total = job.GetProgress()
+        self.failUnlessEqual((copied, failed, skipped, total), (20, 1, 0, 21))
+        self.failUnlessEqual(bytes_copied, sum(i * 1000 for i in range(20)))
+        self.failUnlessEqual(bytes_copied, job.bytesCopied)
+        self.failUnlessEqual(job.GetErrors(), [(20, winerror.ERROR_FILE_NOT_FOUND)])
+        self.failUnless(job.unbuffered > 0)
+        for src, dst in files[:-1]:
+            self.failUnlessEqual(open(src, "rb").read(), open(dst, "rb").read())
+
+    def testCancel(self):
+        job = win32file.CreateCopyJob([], NumThreads=2)
+        self.failUnless(job.Wait(5000))
+        self.failUnlessEqual(job.filesTotal, 0)
+        src = os.path.join(self.dir_name, "src")
+        open(src, "w").close()
+        files = [(src, os.path.join(self.dir_name, "dst%d" % i)) for i in range(1000)]
+        job = win32file.CreateCopyJob(files, NumThreads=1)
+        job.Cancel()
+        self.failUnless(job.Wait(30000))
+        self.failUnlessEqual(job.filesCopied + job.filesSkipped, 1000)
+        self.failUnless(job.filesSkipped > 0)
+
+class TestIoctlDescriptor(unittest.TestCase):
+    def setUp(self):
+        self.fname = tempfile.mktemp("win32file_test")
+        self.h = win32file.CreateFile(self.fname, win32file.GENERIC_READ | win32file.GENERIC_WRITE,
+                                      0, None, win32file.CREATE_ALWAYS, 0, None)
+
+    def tearDown(self):
+        self.h.Close()
+        os.unlink(self.fname)
+
+    def testDecode(self):
+        d = win32file.CreateIoctlDescriptor(winioctlcon.FSCTL_GET_COMPRESSION, OutFormat="H")
+        self.failUnlessEqual(d.OutSize, 2)
+        expected = struct.unpack("H", win32file.DeviceIoControl(self.h, winioctlcon.FSCTL_GET_COMPRESSION, None, 2))
+        self.failUnlessEqual(d(self.h), expected)
+        self.failUnlessEqual(d.Call(self.h), expected)
+        self.failUnlessEqual(d.calls, 2)
+        Compression = collections.namedtuple("Compression", "format")
+        d = win32file.CreateIoctlDescriptor(winioctlcon.FSCTL_GET_COMPRESSION, OutFormat="H", RecordType=Compression)
+        self.failUnlessEqual(d(self.h), Compression(*expected))
+        # no layout returns the raw output
+        d = win32file.CreateIoctlDescriptor(winioctlcon.FSCTL_GET_COMPRESSION, OutSize=2)
+        self.failUnlessEqual(d(self.h), struct.pack("H", *expected))
+
+    def testArgs(self):
+        d = win32file.CreateIoctlDescriptor(winioctlcon.FSCTL_SET_COMPRESSION, InFormat="H")
+        self.failUnlessEqual(d.InSize, 2)
+        self.failUnlessRaises(TypeError, d, self.h)
+        self.failUnlessRaises(TypeError, d, self.h, 1, 2)
+        self.failUnlessRaises(ValueError, win32file.CreateIoctlDescriptor, 0, OutFormat="Z")
+        self.failUnlessRaises(ValueError, win32file.CreateIoctlDescriptor, 0, OutFormat="I", ItemFormat="I")
+        self.failUnlessEqual(win32file.CreateIoctlDescriptor(0, InFormat="BI").InSize, 8)
+        self.failUnlessEqual(win32file.CreateIoctlDescriptor(0, InFormat="<BI").InSize, 5)
+        self.failUnlessEqual(win32file.CreateIoctlDescriptor(0, InFormat="IB").InSize, 8)
+        self.failUnlessEqual(win32file.CreateIoctlDescriptor(0, InFormat="8W").InSize, 16)
+
+    def testCallMany(self):
+        d = win32file.CreateIoctlDescriptor(winioctlcon.FSCTL_GET_COMPRESSION, OutFormat="H")
+        h2 = win32file.CreateFile(self.fname + "2", win32file.GENERIC_READ, 0, None,
+                                  win32file.CREATE_ALWAYS, win32file.FILE_FLAG_DELETE_ON_CLOSE, None)
+        try:
+            results = d.CallMany([self.h, h2])
+            self.failUnlessEqual(results, [d(self.h), d(h2)])
+            results = d.CallMany([self.h, win32file.INVALID_HANDLE_VALUE])
+            self.failUnless(isinstance(results[1], pywintypes.error), results)
+        finally:
+            h2.Close()
+
+class TestUsnJournalReader(unittest.TestCase):
+    def setUp(self):
+        self.dir_name = win32api.GetLongPathName(tempfile.mkdtemp())
+        drive = os.path.splitdrive(self.dir_name)[0]
+        try:
+            self.reader = win32file.CreateUsnJournalReader("\\\\.\\" + drive, resolvePaths=True)
+        except win32file.error as exc:
+            shutil.rmtree(self.dir_name, True)
+            # 1179 is ERROR_JOURNAL_NOT_ACTIVE
+            if exc.winerror in (winerror.ERROR_ACCESS_DENIED, 1179, winerror.ERROR_INVALID_FUNCTION):
+                raise TestSkipped("Can't read the change journal: %s" % (exc,))
+            raise
+
+    def tearDown(self):
+        self.reader.Close()
+        shutil.rmtree(self.dir_name, True)
+
+    def testReadBatch(self):
+        r = self.reader
+        start = r.nextUsn
+        self.failUnless(r.firstUsn <= start)
+        fn = os.path.join(self.dir_name, "usn_test_file")
+        open(fn, "w").close()
+        got = []
+        for batch in r:
+            got.extend(batch)
+        self.failUnless(r.nextUsn > start)
+        self.failUnlessEqual(r.records, len(got))
+        mine = [rec for rec in got if rec[6] == "usn_test_file"]
+        self.failUnless(mine, got)
+        usn, frn, parent, reason, timestamp, attrs, name, path = mine[0]
+        self.failUnless(usn >= start)
+        self.failUnless(reason & 0x00000100, reason) # USN_REASON_FILE_CREATE
+        self.failUnlessEqual(os.path.normcase(os.path.splitdrive(fn)[1]), os.path.normcase(path))
+        self.failUnlessEqual(os.path.normcase(r.ResolvePath(parent)),
+                             os.path.normcase(os.path.splitdrive(self.dir_name)[1]))
+        self.failUnlessEqual(r.ReadBatch(), [])
+        r.Close()
+        self.failUnlessRaises(ValueError, r.ReadBatch)
+
+class TestSequentialReader(unittest.TestCase):
+    def setUp(self):
+        fd, self.filename = tempfile.mkstemp()
+        self.data = os.urandom(300001)
+        os.write(fd, self.data)
+        os.close(fd)
+
+    def tearDown(self):
+        os.unlink(self.filename)
+
+    def testReadAll(self):
+        for unbuffered in (True, False):
+            r = win32file.CreateSequentialReader(self.filename, chunkSize=65536, unbuffered=unbuffered)
+            self.failUnlessEqual(r.chunkSize % r.sectorSize, 0)
+            got = [bytes(chunk) for chunk in r]
+            self.failUnlessEqual(str2bytes('').join(got), self.data)
+            self.failUnlessEqual(r.chunks, len(got))
+            self.failUnlessEqual(r.bytesRead, len(self.data))
+            self.failUnlessEqual(r.Read(), None)
+            r.Close()
+            self.failUnlessRaises(ValueError, r.Read)
+
+    def testOffsetAndLength(self):
+        r = win32file.CreateSequentialReader(self.filename, chunkSize=4096, numReads=2, offset=12345, length=100000)
+        got = str2bytes('').join([bytes(chunk) for chunk in r])
+        self.failUnlessEqual(got, self.data[12345:112345])
+        self.failUnlessEqual(r.position, 112345)
+        r.Close()
+
+    def testHeldBuffers(self):
+        r = win32file.CreateSequentialReader(self.filename, chunkSize=4096, numReads=1)
+        # numReads+2 buffers, all held by chunks still referenced.
+        held = [r.Read() for i in range(3)]
+        self.failUnlessRaises(BufferError, r.Read)
+        first = bytes(held[0])
+        held = None
+        self.failUnlessEqual(len(r.Read()), 4096)
+        self.failUnlessEqual(first, self.data[:len(first)])
+        r.Close()
+
 class TestEncrypt(unittest.TestCase):
     def testEncrypt(self):
         fname = tempfile.mktemp("win32file_test")
@@ -826,6 +1399,41 @@ class TestTransmit(unittest.TestCase):
         self.assertEqual(type(expected), type(buf))
         self.assert_(expected == buf)
 
+    def test_transmit_packets(self):
+        f = tempfile.TemporaryFile()
+        f.write(str2bytes("0123456789"))
+        f.flush()
+        hfile = win32file._get_osfhandle(f.fileno())
+
+        listener = socket.socket()
+        listener.bind(('localhost', 0))
+        listener.listen(1)
+        received = []
+        def runner():
+            cli, addr = listener.accept()
+            buf = 1
+            while buf:
+                buf = cli.recv(4096)
+                received.append(buf)
+            cli.close()
+        th = threading.Thread(target=runner)
+        th.start()
+        s = socket.socket()
+        s.connect(listener.getsockname())
+
+        head = bytearray(str2bytes("[head]"))
+        ol = pywintypes.OVERLAPPED()
+        rc = win32file.TransmitPackets(s, [head, (hfile, 2, 5), memoryview(str2bytes("[tail]")), (hfile, 8, 0)], ol)
+        self.failUnless(rc in (0, winerror.ERROR_IO_PENDING), rc)
+        # The elements are kept alive by the overlapped until completion.
+        self.failUnless(ol.buffer is not None)
+        nbytes = win32file.GetOverlappedResult(s.fileno(), ol, 1)
+        s.close()
+        th.join(5)
+        listener.close()
+        self.assertEqual(str2bytes('').join(received), str2bytes("[head]23456[tail]89"))
+        self.assertEqual(nbytes, 19)
+
 
 class TestWSAEnumNetworkEvents(unittest.TestCase):
 
@@ -967,5 +1575,131 @@ class TestWSAEnumNetworkEvents(unittest.TestCase):
         self.assertEquals(events, {})
 
 
+class TestSocketSelector(unittest.TestCase):
+    def _pair(self):
+        listener = socket.socket()
+        listener.bind(("127.0.0.1", 0))
+        listener.listen(1)
+        client = socket.create_connection(listener.getsockname())
+        server, addr = listener.accept()
+        listener.close()
+        return client, server
+
+    def testManySockets(self):
+        import selectors
+        sel = win32file.CreateSocketSelector()
+        # More than select() can handle.
+        pairs = [self._pair() for i in range(300)]
+        try:
+            for i, (client, server) in enumerate(pairs):
+                sel.Register(server, selectors.EVENT_READ, i)
+            self.assertEqual(len(sel), 300)
+            self.assertEqual(sel.Select(0), [])
+            for i in (7, 123, 299):
+                pairs[i][0].send(str2bytes("x"))
+            ready = []
+            while len(ready) < 3:
+                got = sel.Select(5000)
+                self.assertTrue(got, "timed out")
+                ready.extend(got)
+            self.assertEqual(sorted(cookie for cookie, events, ne in ready), [7, 123, 299])
+            for cookie, events, ne in ready:
+                self.assertEqual(events, selectors.EVENT_READ)
+                self.assertTrue(ne & win32file.FD_READ)
+            # Level-triggered - still ready until the data is read.
+            self.assertEqual(sorted(c for c, e, ne in sel.Select(0)), [7, 123, 299])
+            for i in (7, 123, 299):
+                pairs[i][1].recv(10)
+            self.assertEqual(sel.Select(0), [])
+            self.assertTrue(sel.Unregister(pairs[7][1]))
+            self.assertFalse(sel.Unregister(pairs[7][1]))
+            self.assertEqual(len(sel), 299)
+        finally:
+            sel.Close()
+            for client, server in pairs:
+                client.close()
+                server.close()
+        self.assertRaises(ValueError, sel.Select, 0)
+
+    def testWriteAndModify(self):
+        import selectors
+        client, server = self._pair()
+        sel = win32file.CreateSocketSelector()
+        try:
+            sel.Register(client, selectors.EVENT_READ)
+            self.assertEqual(sel.Select(0), [])
+            sel.Modify(client, selectors.EVENT_READ | selectors.EVENT_WRITE, "c")
+            (cookie, events, ne), = sel.Select(1000)
+            self.assertEqual((cookie, events), ("c", selectors.EVENT_WRITE))
+            # Still writable, and readable once the close arrives.
+            server.close()
+            for i in range(50):
+                (cookie, events, ne), = sel.Select(1000)
+                if events & selectors.EVENT_READ:
+                    break
+                time.sleep(0.1)
+            self.assertEqual(events, selectors.EVENT_READ | selectors.EVENT_WRITE)
+            self.assertRaises(KeyError, sel.Modify, 12345, selectors.EVENT_READ)
+            self.assertRaises(ValueError, sel.Register, client, selectors.EVENT_READ)
+        finally:
+            sel.Close()
+            client.close()
+
+    def testSelectorsInterface(self):
+        import selectors, win32selectors
+        client, server = self._pair()
+        sel = win32selectors.SocketSelector()
+        try:
+            key = sel.register(server, selectors.EVENT_READ, "data")
+            self.assertEqual(sel.get_key(server), key)
+            self.assertEqual(sel.select(0), [])
+            client.send(str2bytes("hello"))
+            self.assertEqual(sel.select(5), [(key, selectors.EVENT_READ)])
+            key = sel.modify(server, selectors.EVENT_READ, "other")
+            self.assertEqual(sel.select(5)[0][0].data, "other")
+            sel.unregister(server)
+            self.assertEqual(len(sel.get_map()), 0)
+        finally:
+            sel.close()
+            client.close()
+            server.close()
+
+class TestSerialReader(unittest.TestCase):
+    # There is no serial port to test with, so just check the object can be
+    # driven and that non-serial handles are rejected.
+    def testNotSerial(self):
+        reader = win32file.CreateSerialReader()
+        self.assertEqual(reader.GetFrames(0), [])
+        h = win32file.CreateFile(win32api.GetTempFileName(win32api.GetTempPath(), "ser")[0],
+                                 win32file.GENERIC_READ, 0, None, win32con.OPEN_EXISTING,
+                                 win32file.FILE_FLAG_OVERLAPPED | win32con.FILE_FLAG_DELETE_ON_CLOSE, None)
+        try:
+            self.assertRaises(win32file.error, reader.AddPort, h)
+            self.assertRaises(ValueError, reader.AddPort, h, delimiter=str2bytes(""))
+            self.assertRaises(ValueError, reader.AddPort, h, maxFrame=0)
+            self.assertRaises(KeyError, reader.GetStats, h)
+            self.assertRaises(KeyError, reader.RemovePort, h)
+        finally:
+            h.Close()
+        self.assertEqual(reader.frames, 0)
+        self.assertEqual(reader.overruns, 0)
+        reader.Close()
+        self.assertRaises(ValueError, reader.GetFrames, 0)
+
+    def testCloseWakesWaiter(self):
+        reader = win32file.CreateSerialReader()
+        results = []
+        def waiter():
+            try:
+                reader.GetFrames(10000)
+            except ValueError:
+                results.append("closed")
+        t = threading.Thread(target=waiter)
+        t.start()
+        time.sleep(0.1)
+        reader.Close()
+        t.join(5)
+        self.assertEqual(results, ["closed"])
+
 if __name__ == '__main__':
     testmain()
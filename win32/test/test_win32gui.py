@@ -59,5 +59,238 @@ class TestPyGetMemory(unittest.TestCase):
         self.assertRaises(TypeError, operator.setitem, got, 0, 1)
 
 
+class TestPumpMessagesEx(unittest.TestCase):
+    def test_timeout(self):
+        self.assertEqual(win32gui.PumpMessagesEx(timeout=10), None)
+
+    def test_quit(self):
+        win32gui.PostQuitMessage(3)
+        self.assertEqual(win32gui.PumpMessagesEx(timeout=5000), 3)
+
+    def test_handles_batch(self):
+        import win32event
+        a = win32event.CreateEvent(None, 0, 1, None)
+        b = win32event.CreateEvent(None, 1, 1, None)
+        calls = []
+        def on_a(h):
+            calls.append("a")
+        def on_b(h):
+            calls.append("b")
+            # b is manual reset, so stop waiting for it.
+            return False
+        def idle():
+            if calls:
+                win32gui.PostQuitMessage(0)
+        rc = win32gui.PumpMessagesEx({a: on_a, b: on_b}, 5000, idle)
+        self.assertEqual(rc, 0)
+        self.assertEqual(sorted(calls), ["a", "b"])
+
+    def test_idle_slices(self):
+        slices = []
+        def idle():
+            slices.append(1)
+            if len(slices) == 5:
+                win32gui.PostQuitMessage(0)
+            return len(slices) < 5
+        self.assertEqual(win32gui.PumpMessagesEx(timeout=5000, idle=idle), 0)
+        self.assertEqual(len(slices), 5)
+
+    def test_callback_error(self):
+        import win32event
+        a = win32event.CreateEvent(None, 0, 1, None)
+        def on_a(h):
+            raise RuntimeError("oops")
+        self.assertRaises(RuntimeError, win32gui.PumpMessagesEx, {a: on_a}, 5000)
+        self.assertRaises(TypeError, win32gui.PumpMessagesEx, {a: None})
+
+class TestPointBuffers(unittest.TestCase):
+    def setUp(self):
+        self.dc = win32gui.CreateCompatibleDC(None)
+
+    def tearDown(self):
+        win32gui.DeleteDC(self.dc)
+
+    def test_polyline_buffer(self):
+        pts = array.array("i", [0, 0, 10, 10, 20, 0])
+        win32gui.Polyline(self.dc, pts)
+        win32gui.Polyline(self.dc, [(0, 0), (10, 10), (20, 0)])
+        # odd number of ints can't be points
+        self.assertRaises(ValueError, win32gui.Polyline, self.dc, array.array("i", [1, 2, 3]))
+        self.assertRaises(TypeError, win32gui.Polyline, self.dc, array.array("d", [1.0, 2.0]))
+
+    def test_polypolyline(self):
+        pts = array.array("i", range(20))
+        win32gui.PolyPolyline(self.dc, pts, [2, 3, 5])
+        win32gui.PolyPolyline(self.dc, [(0, 0), (1, 1), (2, 2), (3, 3)], [2, 2])
+        self.assertRaises(ValueError, win32gui.PolyPolyline, self.dc, pts, [2, 2])
+
+class TestSnapshotWindows(unittest.TestCase):
+    def test_all_columns(self):
+        snap = win32gui.SnapshotWindows()
+        self.assertEqual(sorted(snap.keys()),
+                         ["class", "hwnd", "pid", "rect", "text", "visible"])
+        n = len(snap["hwnd"])
+        for col in snap.values():
+            self.assertEqual(len(col), n)
+
+    def test_matches_getclassname(self):
+        desktop = win32gui.GetDesktopWindow()
+        snap = win32gui.SnapshotWindows(desktop, ("class",))
+        self.assertEqual(sorted(snap.keys()), ["class", "hwnd"])
+        for hwnd, cls in list(zip(snap["hwnd"], snap["class"]))[:50]:
+            if win32gui.IsWindow(hwnd):
+                self.assertEqual(win32gui.GetClassName(hwnd), cls)
+
+    def test_filters(self):
+        snap = win32gui.SnapshotWindows(attributes=["class", "pid"], classFilter="*")
+        all_count = len(snap["hwnd"])
+        if not all_count:
+            return
+        pid = snap["pid"][0]
+        cls = snap["class"][0]
+        by_pid = win32gui.SnapshotWindows(attributes=["pid"], pids=[pid])
+        self.assertTrue(by_pid["pid"])
+        self.assertTrue(all(p == pid for p in by_pid["pid"]))
+        by_class = win32gui.SnapshotWindows(attributes=["class"], classFilter=cls.upper())
+        self.assertTrue(all(c.lower() == cls.lower() for c in by_class["class"]))
+        self.assertRaises(ValueError, win32gui.SnapshotWindows, attributes=["color"])
+
+class TestSendMessageStruct(unittest.TestCase):
+    def setUp(self):
+        self.hwnd = win32gui.CreateWindow("EDIT", "hello there", 0, 0, 0, 100, 20,
+                                          0, 0, 0, None)
+
+    def tearDown(self):
+        win32gui.DestroyWindow(self.hwnd)
+
+    def test_gettext(self):
+        import win32con
+        buf = bytearray(64)
+        rc, data = win32gui.SendMessageStruct(self.hwnd, win32con.WM_GETTEXT, 32, buf)
+        self.assertEqual(rc, len("hello there"))
+        self.assertEqual(bytes(buf[:rc]), data[:rc])
+        self.assertEqual(len(data), 64)
+
+    def test_batch(self):
+        import win32con
+        items = [(n, bytearray(16)) for n in (2, 4, 6)]
+        results = win32gui.SendMessageStructs(self.hwnd, win32con.WM_GETTEXT, items, extra=16)
+        self.assertEqual([rc for rc, data in results], [1, 3, 5])
+        self.assertEqual([len(data) for rc, data in results], [32, 32, 32])
+
+    def test_bad_pointer(self):
+        import win32con
+        self.assertRaises(ValueError, win32gui.SendMessageStruct,
+                          self.hwnd, win32con.WM_GETTEXT, 0, b"\0" * 4, pointers=[8])
+
+class TestControlSnapshots(unittest.TestCase):
+    def setUp(self):
+        win32gui.InitCommonControls()
+        self.hwnd = None
+
+    def tearDown(self):
+        if self.hwnd:
+            win32gui.DestroyWindow(self.hwnd)
+
+    def test_listview(self):
+        import commctrl, win32gui_struct
+        self.hwnd = win32gui.CreateWindow("SysListView32", None, commctrl.LVS_REPORT,
+                                          0, 0, 200, 200, 0, 0, 0, None)
+        for i, name in enumerate(("name", "value")):
+            buf, extra = win32gui_struct.PackLVCOLUMN(text=name, subItem=i, cx=50)
+            win32gui.SendMessage(self.hwnd, commctrl.LVM_INSERTCOLUMNW, i, buf)
+        expected = [["row%d" % i, "value %d" % i] for i in range(20)]
+        for i, (name, value) in enumerate(expected):
+            buf, extra = win32gui_struct.PackLVITEM(item=i, text=name)
+            win32gui.SendMessage(self.hwnd, commctrl.LVM_INSERTITEMW, 0, buf)
+            buf, extra = win32gui_struct.PackLVITEM(item=i, subItem=1, text=value)
+            win32gui.SendMessage(self.hwnd, commctrl.LVM_SETITEMTEXTW, i, buf)
+        self.assertEqual(win32gui.ListViewSnapshot(self.hwnd), expected)
+        self.assertEqual(win32gui.ListViewSnapshot(self.hwnd, [1], textSize=3),
+                         [[v[:3]] for n, v in expected])
+
+    def test_treeview(self):
+        import commctrl, win32gui_struct
+        self.hwnd = win32gui.CreateWindow("SysTreeView32", None, 0,
+                                          0, 0, 200, 200, 0, 0, 0, None)
+        def insert(parent, text):
+            buf, extra = win32gui_struct.PackTVINSERTSTRUCT(parent, commctrl.TVI_LAST,
+                                    (None, None, None, text, None, None, None, None))
+            return win32gui.SendMessage(self.hwnd, commctrl.TVM_INSERTITEMW, 0, buf)
+        top = insert(commctrl.TVI_ROOT, "top")
+        child = insert(top, "child")
+        insert(child, "grandchild")
+        other = insert(commctrl.TVI_ROOT, "other")
+        got = win32gui.TreeViewSnapshot(self.hwnd)
+        self.assertEqual([(depth, text) for hitem, parent, depth, text in got],
+                         [(0, "top"), (1, "child"), (2, "grandchild"), (0, "other")])
+        self.assertEqual(got[1][:2], (child, top))
+        self.assertEqual(got[3][:2], (other, 0))
+
+class TestScreenCapture(unittest.TestCase):
+    def test_gdi(self):
+        cap = win32gui.CreateScreenCapture(method="gdi")
+        self.assertFalse(cap.usesDXGI)
+        frame, rects = cap.GetFrame()
+        self.assertEqual(len(frame), cap.width * cap.height * 4)
+        self.assertEqual(rects, [(0, 0, cap.width, cap.height)])
+        # Once released, the same buffer is filled again.
+        frame_id = id(frame)
+        del frame
+        frame, rects = cap.GetFrame()
+        self.assertEqual(id(frame), frame_id)
+        # but not while it is still referenced
+        frame2, rects = cap.GetFrame()
+        self.assertIsNot(frame, frame2)
+        cap.Close()
+        self.assertRaises(RuntimeError, cap.GetFrame)
+
+    def test_into_buffer(self):
+        cap = win32gui.CreateScreenCapture(method="gdi")
+        buf = bytearray(cap.width * cap.height * 4)
+        frame, rects = cap.GetFrame(buffer=buf)
+        self.assertIs(frame, buf)
+        self.assertRaises(ValueError, cap.GetFrame, buffer=bytearray(4))
+
+    def test_default(self):
+        cap = win32gui.CreateScreenCapture()
+        got = cap.GetFrame(timeout=500)
+        if got is not None:
+            frame, rects = got
+            self.assertEqual(len(frame), cap.width * cap.height * 4)
+
+
+class TestRawInput(unittest.TestCase):
+    def test_register(self):
+        import win32con
+        win32gui.RegisterRawInputDevices([(1, 2)])
+        try:
+            got = win32gui.GetRegisteredRawInputDevices()
+            self.assertTrue([d for d in got if d[:2] == (1, 2)], got)
+        finally:
+            win32gui.RegisterRawInputDevices([(1, 2, win32con.RIDEV_REMOVE)])
+        self.assertFalse([d for d in win32gui.GetRegisteredRawInputDevices() if d[:2] == (1, 2)])
+
+    def test_batch(self):
+        batch = win32gui.PyRawInputBatchType(16)
+        self.assertEqual(batch.Length, 16)
+        got = win32gui.GetRawInputBuffer(batch)
+        self.assertIs(got, batch)
+        self.assertEqual(len(batch), batch.Count)
+        self.assertFalse(batch.More)
+        self.assertTrue(batch.Frequency > 0)
+        self.assertRaises(IndexError, operator.getitem, batch, batch.Count)
+        m = memoryview(batch)
+        self.assertEqual(m.itemsize, 56)
+        self.assertEqual(m.nbytes, batch.Count * 56)
+        self.assertTrue(m.readonly)
+        # The batch can't be refilled while its records are exported.
+        self.assertRaises(BufferError, win32gui.GetRawInputBuffer, batch)
+        m.release()
+        win32gui.GetRawInputBuffer(batch)
+        self.assertRaises(TypeError, win32gui.GetRawInputBuffer, object())
+
+
+
 if __name__=='__main__':
     unittest.main()
@@ -48,6 +48,40 @@ class TestNetwork(unittest.TestCase):
         data = str2bytes('').join(chunks)
         assert data.find(str2bytes("Python"))>0, repr(data) # This must appear somewhere on the main page!
 
+    def testReadFileInto(self):
+        hdl = InternetOpenUrl(self.hi, "http://www.python.org", None,
+                              INTERNET_FLAG_EXISTING_CONNECT)
+        buf = bytearray(1024)
+        chunks = []
+        while 1:
+            n = InternetReadFileInto(hdl, buf)
+            if not n:
+                break
+            chunks.append(bytes(buf[:n]))
+        data = str2bytes('').join(chunks)
+        assert data.find(str2bytes("Python"))>0, repr(data)
+        self.assertRaises(ValueError, InternetReadFileInto, hdl, bytearray())
+        self.assertRaises(TypeError, InternetReadFileInto, hdl, str2bytes("read only"))
+
+    def testReadFileToHandle(self):
+        import tempfile, os, win32file
+        hdl = InternetOpenUrl(self.hi, "http://www.python.org", None,
+                              INTERNET_FLAG_EXISTING_CONNECT)
+        fd, filename = tempfile.mkstemp()
+        os.close(fd)
+        try:
+            hfile = win32file.CreateFile(filename, win32file.GENERIC_WRITE, 0, None,
+                                         win32file.CREATE_ALWAYS, 0, None)
+            try:
+                total = InternetReadFileToHandle(hdl, hfile, 4096)
+            finally:
+                hfile.Close()
+            data = open(filename, "rb").read()
+            self.failUnlessEqual(total, len(data))
+            assert data.find(str2bytes("Python"))>0, repr(data)
+        finally:
+            os.unlink(filename)
+
     def testFtpCommand(self):
         # ftp.python.org doesn't exist.  ftp.gnu.org is what Python's urllib
         # test code uses.
@@ -71,5 +105,57 @@ class TestNetwork(unittest.TestCase):
         except error as e:
             raise TestSkipped(e)
 
+class TestWinHttpAsync(unittest.TestCase):
+    def setUp(self):
+        self.session = WinHttpAsyncSession("test")
+    def tearDown(self):
+        self.session.Close()
+    def _wait(self, count):
+        got = []
+        while len(got) < count:
+            batch = self.session.GetCompletions(30000)
+            if not batch:
+                raise TestSkipped("timed out waiting for www.python.org")
+            got.extend(batch)
+        return got
+
+    def testNothingPending(self):
+        self.failUnlessEqual(self.session.Pending, 0)
+        self.failUnlessEqual(self.session.GetCompletions(0), [])
+
+    def testBadUrl(self):
+        self.assertRaises(error, self.session.Request, "not a url")
+        self.failUnlessEqual(self.session.Pending, 0)
+
+    def testPythonDotOrg(self):
+        for i in range(3):
+            self.session.Request("https://www.python.org/", Context=i)
+        self.failUnlessEqual(self.session.Pending, 3)
+        got = self._wait(3)
+        self.failUnlessEqual(self.session.Pending, 0)
+        self.failUnlessEqual(sorted([c[0] for c in got]), [0, 1, 2])
+        for context, err, status, headers, body in got:
+            if err:
+                raise TestSkipped(error(err, "WinHttpAsyncSession"))
+            self.failUnlessEqual(status, 200)
+            self.failUnless(headers.startswith("HTTP/"), headers)
+            self.failUnless(body.find(str2bytes("Python"))>0, repr(body))
+
+    def testCallerBuffer(self):
+        buf = bytearray(16)
+        self.session.Request("https://www.python.org/", Buffer=buf)
+        (context, err, status, headers, nbytes), = self._wait(1)
+        if err not in (0, winerror.ERROR_INSUFFICIENT_BUFFER):
+            raise TestSkipped(error(err, "WinHttpAsyncSession"))
+        # The main page is certainly bigger than the buffer
+        self.failUnlessEqual(err, winerror.ERROR_INSUFFICIENT_BUFFER)
+        self.failUnlessEqual(nbytes, 16)
+
+    def testCloseCancels(self):
+        self.session.Request("https://www.python.org/")
+        self.session.Close()
+        self.failUnlessEqual(self.session.Pending, 0)
+        self.assertRaises(ValueError, self.session.Request, "https://www.python.org/")
+
 if __name__=='__main__':
     unittest.main()
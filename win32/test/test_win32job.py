@@ -0,0 +1,68 @@
+import unittest
+import sys
+import win32api
+import win32con
+import win32event
+import win32job
+import win32process
+
+class TestJobMonitor(unittest.TestCase):
+    def _start_child(self, job):
+        si = win32process.STARTUPINFO()
+        hp, ht, pid, tid = win32process.CreateProcess(None, '"%s" -c "pass"' % sys.executable,
+                            None, None, False, win32process.CREATE_SUSPENDED, None, None, si)
+        win32job.AssignProcessToJobObject(job, hp)
+        win32process.ResumeThread(ht)
+        return hp, pid
+
+    def testNotifications(self):
+        job = win32job.CreateJobObject(None, "")
+        mon = win32job.CreateJobMonitor()
+        self.assertEqual(len(mon), 0)
+        mon.AddJob(job, "first")
+        self.assertEqual(len(mon), 1)
+        hp, pid = self._start_child(job)
+        win32event.WaitForSingleObject(hp, 10000)
+        seen = []
+        while win32job.JOB_OBJECT_MSG_ACTIVE_PROCESS_ZERO not in [m for c, m, p in seen]:
+            events = mon.GetEvents(5000)
+            self.assertTrue(events, "timed out waiting for the job to empty")
+            seen.extend(events)
+        self.assertTrue(("first", win32job.JOB_OBJECT_MSG_NEW_PROCESS, pid) in seen)
+        self.assertTrue(("first", win32job.JOB_OBJECT_MSG_EXIT_PROCESS, pid) in seen)
+        self.assertEqual(mon.GetEvents(0), [])
+        self.assertTrue(mon.notifications >= len(seen))
+
+        acct = mon.QueryAccounting()
+        self.assertEqual(acct["Cookie"], ["first"])
+        self.assertEqual(acct["TotalProcesses"], [1])
+        self.assertEqual(acct["ActiveProcesses"], [0])
+        self.assertTrue(mon.RemoveJob(job))
+        self.assertFalse(mon.RemoveJob(job))
+        mon.Close()
+        self.assertRaises(ValueError, mon.GetEvents, 0)
+
+    def testQueryJobAccounting(self):
+        jobs = [win32job.CreateJobObject(None, "") for i in range(3)]
+        hp, pid = self._start_child(jobs[1])
+        win32event.WaitForSingleObject(hp, 10000)
+        acct = win32job.QueryJobAccounting(jobs)
+        self.assertEqual(acct["TotalProcesses"], [0, 1, 0])
+        for name, column in acct.items():
+            self.assertEqual(len(column), 3, name)
+        basic = win32job.QueryInformationJobObject(jobs[1], win32job.JobObjectBasicAccountingInformation)
+        self.assertEqual(acct["TotalUserTime"][1], basic["TotalUserTime"])
+        self.assertEqual(win32job.QueryJobAccounting([]), dict((k, []) for k in acct))
+
+    def testCpuRateLimit(self):
+        job = win32job.CreateJobObject(None, "")
+        self.assertRaises(ValueError, win32job.SetJobCpuRateLimit, job, Rate=0)
+        self.assertRaises(ValueError, win32job.SetJobCpuRateLimit, job, Rate=50, Weight=5)
+        if sys.getwindowsversion()[:2] < (6, 2):
+            return
+        win32job.SetJobCpuRateLimit(job, Rate=25.5)
+        win32job.SetJobCpuRateLimit(job, Weight=5)
+        win32job.SetJobCpuRateLimit(job)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -16,6 +16,57 @@ class TestCase(unittest.TestCase):
         res=1 # Can't pass this first time round.
         self.assertRaises(win32net.error, win32net.NetGroupEnum, server,0,res)
 
+    def _enum_all(self, func, *args):
+        # The resume handle loop the iterators replace.
+        res = 0
+        ret = []
+        while True:
+            items, total, res = func(*args + (res,))
+            ret.extend(items)
+            if not res:
+                return ret
+
+    def testGroupsIterator(self, server=None):
+        expected = self._enum_all(win32net.NetLocalGroupEnum, server, 1)
+        it = win32net.NetLocalGroupEnumIterator(server, 1)
+        self.assertEqual(list(it), expected)
+        self.assertTrue(it.Pages >= 1)
+        # Exhausted iterators stay exhausted
+        self.assertEqual(list(it), [])
+
+    def testUsersIterator(self, server=None):
+        expected = self._enum_all(win32net.NetUserEnum, server, 0, win32netcon.FILTER_NORMAL_ACCOUNT)
+        got = list(win32net.NetUserEnumIterator(server, 0, prefLen=64))
+        self.assertEqual(got, expected)
+
+    def testColumns(self, server=None):
+        expected = self._enum_all(win32net.NetLocalGroupEnum, server, 1)
+        names = []
+        for page in win32net.NetLocalGroupEnumIterator(server, 1, columns=True):
+            self.assertEqual(sorted(page.keys()), ["comment", "name"])
+            self.assertEqual(len(page["name"]), len(page["comment"]))
+            names.extend(page["name"])
+        self.assertEqual(names, [g["name"] for g in expected])
+
+    def testIteratorBadLevel(self, server=None):
+        self.assertRaises(ValueError, win32net.NetLocalGroupEnumIterator, server, 12345)
+
+    def testBatchEnum(self):
+        servers = [None] * 5
+        expected = list(win32net.NetShareEnumIterator(None, 0))
+        got = list(win32net.NetBatchEnum("NetShareEnum", servers, 0, Threads=2))
+        self.assertEqual(len(got), len(servers))
+        for server, result in got:
+            self.assertTrue(server is None)
+            self.assertEqual(result, expected)
+
+    def testBatchEnumEmpty(self):
+        self.assertEqual(list(win32net.NetBatchEnum("NetWkstaUserEnum", [], 0)), [])
+
+    def testBatchEnumBadArgs(self):
+        self.assertRaises(ValueError, win32net.NetBatchEnum, "NetUserEnum", [None], 0)
+        self.assertRaises(ValueError, win32net.NetBatchEnum, "NetSessionEnum", [None], 12345)
+        self.assertRaises(ValueError, win32net.NetBatchEnum, "NetShareEnum", [None], 0, Threads=0)
 
 if __name__ == '__main__':
     unittest.main()
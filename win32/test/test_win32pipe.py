@@ -1,4 +1,5 @@
 import unittest
+import sys
 import time
 import threading
 from pywin32_testutil import str2bytes # py3k-friendly helper
@@ -128,5 +129,98 @@ class PipeTests(unittest.TestCase):
         event.wait(5)
         self.failUnless(event.isSet(), "Pipe server thread didn't terminate")
 
+class PipeServerTests(unittest.TestCase):
+    pipename = "\\\\.\\pipe\\python_test_pipe_server"
+
+    def _client(self, data):
+        h = win32file.CreateFile(self.pipename,
+                                 win32con.GENERIC_READ | win32con.GENERIC_WRITE,
+                                 0, None, win32con.OPEN_EXISTING, 0, None)
+        win32pipe.SetNamedPipeHandleState(h, win32pipe.PIPE_READMODE_MESSAGE, None, None)
+        return win32pipe.TransactNamedPipe(h, data, 1024), h
+
+    def testMessages(self):
+        server = win32pipe.CreatePipeServer(self.pipename, 2, 16)
+        try:
+            results = []
+            # Longer than the read size, so is read in pieces.
+            big = str2bytes("x") * 100
+            def client():
+                results.append(self._client(str2bytes("hello")))
+                results.append(self._client(big))
+            t = threading.Thread(target=client)
+            t.start()
+            got = []
+            for i in range(10):
+                for instance, data in server.GetMessages(1000):
+                    if data is not None:
+                        got.append(data)
+                        server.Write(instance, data[::-1])
+                if len(got) == 2:
+                    break
+            t.join(5)
+            self.failUnlessEqual(got, [str2bytes("hello"), big])
+            self.failUnlessEqual(results[0][0][1], str2bytes("olleh"))
+            self.failUnlessEqual(results[1][0][1], big)
+            self.failUnlessEqual(server.messages, 2)
+            # Both clients still connected - close one, and its instance
+            # is reused.
+            results[0][1].Close()
+            disconnected = [instance for instance, data in server.GetMessages(1000)]
+            self.failUnlessEqual(len(disconnected), 1)
+            t = threading.Thread(target=lambda: results.append(self._client(str2bytes("again"))))
+            t.start()
+            got = server.GetMessages(5000)
+            self.failUnlessEqual([data for instance, data in got], [str2bytes("again")])
+            self.failUnlessEqual(got[0][0], disconnected[0])
+            server.Write(got[0][0], str2bytes("done"))
+            t.join(5)
+            self.failUnlessEqual(results[2][0][1], str2bytes("done"))
+            self.failUnlessEqual(server.connections, 3)
+            # Nothing else arrives.
+            self.failUnlessEqual(server.GetMessages(0), [])
+        finally:
+            server.Close()
+
+class ProcessGroupTests(unittest.TestCase):
+    def _cmd(self, code):
+        return '"%s" -c "%s"' % (sys.executable, code)
+
+    def testOutput(self):
+        group = win32pipe.CreateProcessGroup()
+        for i in range(5):
+            group.Spawn(self._cmd("import sys; sys.stdout.write('x' * 100000); sys.stderr.write('err%d'); sys.exit(%d)" % (i, i)), i)
+        self.assertEqual(len(group), 5)
+        results = group.Wait(30000, True)
+        self.assertEqual(len(group), 0)
+        self.assertEqual(sorted(r[0] for r in results), list(range(5)))
+        for cookie, exitCode, out, err in results:
+            self.assertEqual(exitCode, cookie)
+            self.assertEqual(out, str2bytes("x" * 100000))
+            self.assertEqual(err, str2bytes("err%d" % cookie))
+        self.assertEqual(group.spawned, 5)
+        self.assertEqual(group.finished, 5)
+        self.assertEqual(group.Wait(0), [])
+        group.Close()
+        self.assertRaises(ValueError, group.Wait, 0)
+
+    def testInputAndMerge(self):
+        group = win32pipe.CreateProcessGroup()
+        pid = group.Spawn(self._cmd("import sys; sys.stdout.write(sys.stdin.read().upper()); sys.stdout.flush(); sys.stderr.write('!')"),
+                          None, None, None, str2bytes("hello"), True)
+        (cookie, exitCode, out, err), = group.Wait(30000)
+        self.assertEqual(cookie, pid)
+        self.assertEqual(exitCode, 0)
+        self.assertEqual(out, str2bytes("HELLO!"))
+        self.assertEqual(err, None)
+
+    def testTimeoutAndTerminate(self):
+        group = win32pipe.CreateProcessGroup()
+        group.Spawn(self._cmd("import time; time.sleep(30)"))
+        self.assertEqual(group.Wait(100), [])
+        self.assertEqual(len(group), 1)
+        group.Close(True)
+        self.assertEqual(len(group), 0)
+
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,188 @@
+import unittest
+from pywin32_testutil import TestSkipped
+import os
+import sys
+import time
+import shutil
+import tempfile
+import threading
+import hashlib
+import winerror
+import win32cryptcon
+import pywintypes
+import win32api
+import win32con
+import win32file
+import win32pipe
+import win32process
+
+class TestProcessSnapshot(unittest.TestCase):
+    def testDefaultFields(self):
+        snap = win32process.GetProcessSnapshot()
+        self.assertTrue("ImagePath" not in snap)
+        pids = snap["ProcessId"]
+        for name, column in snap.items():
+            self.assertEqual(len(column), len(pids), name)
+        self.assertTrue(os.getpid() in pids)
+        i = pids.index(os.getpid())
+        self.assertEqual(os.path.basename(sys.executable).lower(), snap["ImageName"][i].lower())
+        self.assertEqual(snap["ParentProcessId"][i], os.getppid())
+        self.assertTrue(snap["WorkingSetSize"][i] > 0)
+        self.assertTrue(snap["NumberOfThreads"][i] >= 1)
+
+    def testMatchesPerProcessCalls(self):
+        snap = win32process.GetProcessSnapshot(["ProcessId", "HandleCount", "ImagePath", "CreateTime"])
+        self.assertEqual(sorted(snap), ["CreateTime", "HandleCount", "ImagePath", "ProcessId"])
+        i = snap["ProcessId"].index(os.getpid())
+        self.assertEqual(os.path.normcase(snap["ImagePath"][i]), os.path.normcase(sys.executable))
+        h = win32api.OpenProcess(win32con.PROCESS_QUERY_INFORMATION, False, os.getpid())
+        times = win32process.GetProcessTimes(h)
+        # CreateTime is a raw FILETIME value.
+        created = (snap["CreateTime"][i] - 116444736000000000) / 1e7
+        self.assertTrue(abs(created - times["CreationTime"].timestamp()) < 0.01)
+
+    def testBadFields(self):
+        self.assertRaises(ValueError, win32process.GetProcessSnapshot, ["NoSuchField"])
+        self.assertRaises(TypeError, win32process.GetProcessSnapshot, [1])
+
+class TestProcessLauncher(unittest.TestCase):
+    def setUp(self):
+        self.launcher = win32process.CreateProcessLauncher()
+
+    def tearDown(self):
+        self.launcher.Close()
+
+    def _wait_all(self, pids):
+        exits = {}
+        deadline = time.time() + 60
+        while len(exits) < len(pids) and time.time() < deadline:
+            for pid, code in self.launcher.GetExits(1000):
+                exits[pid] = code
+        return exits
+
+    def testLaunchBatch(self):
+        cmd = '"%s" -c "import sys; sys.exit(%%d)"' % (sys.executable,)
+        pids = self.launcher.Launch([cmd % i for i in range(5)])
+        self.assertEqual(len(pids), 5)
+        self.assertEqual(self.launcher.launched, 5)
+        exits = self._wait_all(pids)
+        self.assertEqual(exits, dict(zip(pids, range(5))))
+        self.assertEqual(self.launcher.running, 0)
+        self.assertEqual(self.launcher.exited, 5)
+        self.assertEqual(self.launcher.GetExits(0), [])
+
+    def testHandleList(self):
+        # Only the handles passed are inherited - the pipe's write end is not.
+        r, w = win32pipe.CreatePipe(None, 0)
+        win32api.SetHandleInformation(w, win32con.HANDLE_FLAG_INHERIT, win32con.HANDLE_FLAG_INHERIT)
+        nul = win32file.CreateFile("NUL", win32file.GENERIC_WRITE, 0, None, win32file.OPEN_EXISTING, 0, None)
+        win32api.SetHandleInformation(nul, win32con.HANDLE_FLAG_INHERIT, win32con.HANDLE_FLAG_INHERIT)
+        cmd = '"%s" -c "import msvcrt; msvcrt.get_osfhandle(0)"' % (sys.executable,)
+        si = win32process.STARTUPINFO()
+        si.dwFlags = win32con.STARTF_USESTDHANDLES
+        si.hStdInput = si.hStdOutput = si.hStdError = nul
+        pids = self.launcher.Launch([cmd], startupInfo=si, creationFlags=win32con.CREATE_NO_WINDOW)
+        self.assertEqual(self._wait_all(pids), {pids[0]: 0})
+        # The child didn't inherit the write end, so closing ours ends the pipe.
+        w.Close()
+        self.assertRaises(pywintypes.error, win32file.ReadFile, r, 1)
+
+    def testFailedBatch(self):
+        cmd = '"%s" -c "pass"' % (sys.executable,)
+        self.assertRaises(pywintypes.error, self.launcher.Launch,
+                          [cmd, "no_such_program_for_launcher.exe"])
+        self.assertEqual(self.launcher.launched, 0)
+        self.assertEqual(self.launcher.running, 0)
+        self.assertRaises(ValueError, self.launcher.Launch, [cmd], creationFlags=win32con.CREATE_SUSPENDED)
+
+    def testClose(self):
+        self.launcher.Close()
+        self.assertEqual(self.launcher.job, None)
+        self.assertRaises(ValueError, self.launcher.GetExits, 0)
+
+class TestThreadpool(unittest.TestCase):
+    def setUp(self):
+        self.dir_name = tempfile.mkdtemp()
+        self.data = os.urandom(100000) * 20
+        self.files = []
+        for i in range(4):
+            fn = os.path.join(self.dir_name, "src%d" % i)
+            with open(fn, "wb") as f:
+                f.write(self.data[i:])
+            self.files.append(fn)
+
+    def tearDown(self):
+        shutil.rmtree(self.dir_name, True)
+
+    def _wait(self, pool, count):
+        got = []
+        while len(got) < count:
+            batch = pool.GetCompletions(10000)
+            self.assertTrue(batch, "timed out waiting for the pool")
+            got.extend(batch)
+        return got
+
+    def testHash(self):
+        pool = win32process.CreateThreadpool(1, 4)
+        ids = [pool.SubmitHash(fn, Cookie=fn) for fn in self.files]
+        self.assertEqual(len(set(ids)), len(ids))
+        md5 = pool.SubmitHash(self.files[0], win32cryptcon.CALG_MD5)
+        got = self._wait(pool, len(self.files) + 1)
+        results = dict((cookie, (result, err)) for cookie, result, err in got)
+        for fn in self.files:
+            with open(fn, "rb") as f:
+                self.assertEqual(results[fn], (hashlib.sha256(f.read()).digest(), 0))
+        self.assertEqual(results[md5], (hashlib.md5(self.data).digest(), 0))
+        self.assertEqual((pool.submitted, pool.completed), (5, 5))
+        self.assertEqual(pool.GetCompletions(), [])
+        pool.Close()
+        self.assertRaises(ValueError, pool.SubmitHash, self.files[0])
+
+    def testErrors(self):
+        pool = win32process.CreateThreadpool()
+        missing = os.path.join(self.dir_name, "missing")
+        pool.SubmitHash(missing, Cookie="hash")
+        pool.SubmitCopy(self.files[0], self.files[1], win32file.COPY_FILE_FAIL_IF_EXISTS, Cookie="copy")
+        got = sorted(self._wait(pool, 2))
+        self.assertEqual(got, [("copy", None, winerror.ERROR_FILE_EXISTS),
+                               ("hash", None, winerror.ERROR_FILE_NOT_FOUND)])
+        pool.Close()
+
+    def testCopyAndCompress(self):
+        pool = win32process.CreateThreadpool()
+        dest = os.path.join(self.dir_name, "copy")
+        packed = os.path.join(self.dir_name, "packed")
+        pool.SubmitCopy(self.files[0], dest, Cookie="copy")
+        pool.SubmitCompress(self.files[0], packed, Cookie="compress")
+        results = dict((cookie, (result, err)) for cookie, result, err in self._wait(pool, 2))
+        pool.Close()
+        self.assertEqual(results["copy"], (None, 0))
+        with open(dest, "rb") as f:
+            self.assertEqual(f.read(), self.data)
+        result, err = results["compress"]
+        if err == winerror.ERROR_NOT_SUPPORTED:
+            raise TestSkipped("The Compression API needs Windows 8")
+        self.assertEqual(err, 0)
+        self.assertEqual(result[0], len(self.data))
+        # The data repeats, so it compresses well.
+        self.assertTrue(result[1] < len(self.data) / 4, result)
+        self.assertEqual(os.path.getsize(packed), result[1])
+
+    def testCallback(self):
+        got = []
+        done = threading.Event()
+        def callback(completions):
+            got.extend(completions)
+            if len(got) == len(self.files):
+                done.set()
+        pool = win32process.CreateThreadpool(0, 0, callback)
+        for fn in self.files:
+            pool.SubmitHash(fn, Cookie=fn)
+        self.assertTrue(done.wait(30))
+        self.assertEqual(sorted(cookie for cookie, result, err in got), sorted(self.files))
+        self.assertTrue(1 <= pool.dispatches <= len(self.files))
+        pool.Close()
+        self.assertEqual(pool.GetCompletions(0), [])
+
+if __name__ == '__main__':
+    unittest.main()
@@ -121,6 +121,80 @@ class TestModuleOps(BasicSetupTearDown):
     def testFlush(self):
         win32trace.flush()
 
+    def testStatistics(self):
+        before = win32trace.GetStatistics()
+        win32trace.write('Syver Enstad')
+        after = win32trace.GetStatistics()
+        self.assertEquals(after['Written'], before['Written'] + 1)
+        self.failUnless(after['Pending'] > 0)
+        win32trace.read()
+        self.assertEquals(win32trace.GetStatistics()['Pending'], 0)
+
+    def testDropped(self):
+        # Nothing is reading, so writing more than the buffer holds must drop
+        # records rather than block or discard what is already there.
+        stats = win32trace.GetStatistics()
+        chunk = "*" * 1024
+        for i in range(stats['BufferSize'] // len(chunk) * 2):
+            win32trace.write(chunk)
+        after = win32trace.GetStatistics()
+        self.failUnless(after['Dropped'] > stats['Dropped'])
+        data = win32trace.read()
+        self.failUnless(len(data) > stats['BufferSize'] // 2, len(data))
+        self.failUnlessEqual(data, "*" * len(data))
+
+
+class TestChannels(unittest.TestCase):
+    def setUp(self):
+        self.name = "test_win32trace-%d" % os.getpid()
+        self.writer = win32trace.OpenChannel(self.name)
+        self.reader = win32trace.OpenChannel(self.name)
+        self.other = win32trace.OpenChannel(self.name + "-other")
+        self.reader.read() # clear any old data.
+        self.other.read()
+
+    def tearDown(self):
+        for c in self.writer, self.reader, self.other:
+            c.Close()
+
+    def testRecords(self):
+        self.failUnless(self.writer.write("hello", 3))
+        self.writer.write("world")
+        records = self.reader.read()
+        self.assertEquals([(r[3], r[4]) for r in records], [(3, "hello"), (0, "world")])
+        pid, tid, timestamp = records[0][:3]
+        self.assertEquals(pid, os.getpid())
+        self.assertEquals(tid, threading.current_thread().ident)
+        self.failUnless(timestamp > 0)
+        self.assertEquals(self.reader.read(), [])
+        self.assertEquals(self.other.read(), [])
+        self.assertRaises(ValueError, self.writer.write, "x", 0x10000)
+
+    def testMaxRecords(self):
+        for i in range(5):
+            self.writer.write(str(i))
+        self.assertEquals([r[4] for r in self.reader.read(2)], ["0", "1"])
+        self.assertEquals([r[4] for r in self.reader.read()], ["2", "3", "4"])
+
+    def testReadChannels(self):
+        channels = [self.reader, self.other]
+        self.assertEquals(win32trace.ReadChannels(channels, 10), [])
+        def write():
+            time.sleep(0.1)
+            win32trace.OpenChannel(self.name + "-other").write("later")
+        t = threading.Thread(target=write)
+        t.start()
+        result = win32trace.ReadChannels(channels, 5000)
+        t.join()
+        self.assertEquals(len(result), 1)
+        channel, records = result[0]
+        self.failUnless(channel is self.other)
+        self.assertEquals([r[4] for r in records], ["later"])
+
+    def testClosed(self):
+        self.writer.Close()
+        self.assertRaises(win32trace.error, self.writer.write, "x")
+        self.assertRaises(win32trace.error, win32trace.ReadChannels, [self.writer])
 
 class TestTraceObjectOps(BasicSetupTearDown):
     def testInit(self):